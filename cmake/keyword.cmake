@@ -15,6 +15,7 @@ function(getNanairoKeywords nanairo_keyword_list)
       sceneBackupFileName "settings.nana"
       sceneBinaryFileName "settings.nanabin"
       previewDir "Preview"
+      bvhCacheDirName "bvh_cache"
 
       name "Name"
       # General
@@ -33,18 +34,29 @@ function(getNanairoKeywords nanairo_keyword_list)
       # System
       system "System"
       numOfThreads "NumOfThreads"
+      enableThreadAffinity "EnableThreadAffinity"
+      enableMemoryFirstTouch "EnableMemoryFirstTouch"
+      enableBackgroundPriority "EnableBackgroundPriority"
+      enableHugePageAllocation "EnableHugePageAllocation"
       samplerType "SamplerType"
           pcgSampler "PCG"
           xoshiroSampler "Xoshiro"
           cmjSampler "Correlated Multi-Jittered"
+          tableCmjSampler "Table Correlated Multi-Jittered"
+          owenSobolSampler "Owen Scrambled Sobol"
       samplerSeed "SamplerSeed"
+      samplesPerCycle "SamplesPerCycle"
       terminationCycle "TerminationCycle"
       terminationTime "TerminationTime"
       imageResolution "ImageResolution"
 #      enableToSaveSpectraImage "EnableToSaveSpectraImage"
       power2CycleSaving "Power2CycleSaving"
+      enableLdrImageOutput "EnableLdrImageOutput"
+      enableHdrImageOutput "EnableHdrImageOutput"
       savingIntervalTime "SavingIntervalTime"
       savingIntervalCycle "SavingIntervalCycle"
+      enableAdaptiveSampling "EnableAdaptiveSampling"
+      adaptiveSamplingThreshold "AdaptiveSamplingThreshold"
 
       # Color
       color "Color"
@@ -53,11 +65,14 @@ function(getNanairoKeywords nanairo_keyword_list)
       colorMode "ColorMode"
           rgb "RGB"
           spectra "Spectra"
+      enableXyzFilm "EnableXyzFilm"
       wavelengthSampling "WavelengthSampling"
           regularSampling "Regular sampling"
           randomSampling "Random sampling"
           stratifiedSampling "Stratified sampling"
           lightsBasedSampling "Lights based sampling"
+      wavelengthSampleSize "WavelengthSampleSize"
+      enableTileWavelengthSampling "EnableTileWavelengthSampling"
       colorSpace "ColorSpace"
           sRgbD65 "sRGB (D65)"
           sRgbD50 "sRGB (D50)"
@@ -72,32 +87,58 @@ function(getNanairoKeywords nanairo_keyword_list)
       enableDenoising "EnableDenoising"
       denoiserType "DenoiserType"
           bayesianCollaborativeDenoiser "BayesianCollaborativeDenoiser"
+          atrousWaveletDenoiser "AtrousWaveletDenoiser"
+      # A-trous wavelet denoiser
+      numberOfIterations "NumberOfIterations"
+      colorSigma "ColorSigma"
       # Bayesian collaborative denoiser
       histogramBins "HistogramBins"
       histogramDistanceThreshold "HistogramDistanceThreshold"
       patchRadius "PatchRadius"
       searchWindowRadius "SearchWindowRadius"
       numberOfScales "NumberOfScales"
+      singlePrecision "SinglePrecision"
 
       # Rendering
       renderingMethod "RenderingMethod"
           pathTracing "PathTracing"
+          wavefrontPathTracing "WavefrontPathTracing"
           lightTracing "LightTracing"
+          lightVertexCacheBpt "LightVertexCacheBPT"
           probabilisticPpm "ProbabilisticPPM"
       rayCastEpsilon "RayCastEpsilon"
       russianRoulette "RussianRoulette"
           rouletteMaxReflectance "Reflectance (Max)"
           rouletteAverageReflectance "Reflectance (Average)"
+          rouletteEfficiency "Efficiency"
           roulettePathLength "Path length"
       pathLength "PathLength"
+      minPathLength "MinPathLength"
       lightPathLightSampler "LightPathLightSampler"
       eyePathLightSampler "EyePathLightSampler"
+      raySorting "RaySorting"
+      materialSorting "MaterialSorting"
+      pathGuiding "PathGuiding"
+      guidingIterations "GuidingIterations"
+      wavelengthBatches "WavelengthBatches"
+      lightSolidAngleSampling "LightSolidAngleSampling"
           uniformLightSampler "UniformLightSampler"
           powerWeightedLightSampler "PowerWeightedLightSampler"
+          lightBvhLightSampler "LightBvhLightSampler"
+      # Light vertex cache BPT
+      numOfLightPaths "NumOfLightPaths"
+      numOfConnections "NumOfConnections"
       # Probabilistic PPM
       numOfPhotons "NumOfPhotons"
       photonSearchRadius "PhotonSearchRadius"
       kNearestNeighbor "KNearestNeighbor"
+      photonMap "PhotonMap"
+          kdTreePhotonMap "KdTree"
+          hashGridPhotonMap "HashGrid"
+      photonAutoTuning "PhotonAutoTuning"
+      targetPhotonTimeRatio "TargetPhotonTimeRatio"
+      targetCycleTime "TargetCycleTime"
+      visiblePointUpdateInterval "VisiblePointUpdateInterval"
 
       # BVH
       bvh "Bvh"
@@ -105,6 +146,21 @@ function(getNanairoKeywords nanairo_keyword_list)
           agglomerativeTreeletRestructuringBvh "AgglomerativeTreeletRestructuringBvh"
               treeletSize "TreeletSize"
               optimizationLoopCount "OptimizationLoopCount"
+          binnedSahBvh "BinnedSahBvh"
+              numOfBins "NumOfBins"
+              spatialSplit "SpatialSplit"
+              splitBudget "SplitBudget"
+              maxNumOfLeafObjects "MaxNumOfLeafObjects"
+      bvhLayout "BvhLayout"
+          binaryBvhLayout "Binary"
+          orderedBinaryBvhLayout "OrderedBinary"
+          wide4BvhLayout "Wide4"
+          wide8BvhLayout "Wide8"
+          quantized4BvhLayout "Quantized4"
+      instancing "Instancing"
+      largeObjectSeparation "LargeObjectSeparation"
+      extendedMortonCode "ExtendedMortonCode"
+      proxyGeometry "ProxyGeometry"
 
       # Texture
       textureModel "TextureModel"
@@ -113,6 +169,7 @@ function(getNanairoKeywords nanairo_keyword_list)
           checkerboardTexture "CheckerboardTexture"
           imageTexture "ImageTexture"
               imageFilePath "ImageFilePath"
+              tiledImage "TiledImage"
 
       # SurfaceModel
       surfaceModel "SurfaceModel"
@@ -141,6 +198,8 @@ function(getNanairoKeywords nanairo_keyword_list)
           nonDirectionalEmitter "NonDirectionalEmitter"
               emissiveColorIndex "EmissiveColorIndex"
               radiantExitance "RadiantExitance"
+          environmentEmitter "EnvironmentEmitter"
+              radianceScale "RadianceScale"
 
       # Object
       object "Object"
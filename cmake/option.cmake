@@ -33,6 +33,11 @@ function(validateOptions)
     message(FATAL_ERROR "Invalied wavelength resolution is specified.")
   endif()
 
+  set(film_float ${NANAIRO_FILM_FLOATING_POINT_TYPE})
+  if(NOT (film_float STREQUAL "float" OR film_float STREQUAL "double"))
+    message(FATAL_ERROR "The film floating point type isn't 'float' or 'double'.")
+  endif()
+
   math(EXPR spectra_size "${range} / ${delta_lambda}")
   set(sample_size ${NANAIRO_WAVELENGTH_SAMPLE_SIZE})
   # !(0 < sampleSize <= spectraSize)
@@ -40,6 +45,12 @@ function(validateOptions)
                                      ${sample_size} EQUAL ${spectra_size})))
     message(FATAL_ERROR "Invalid wavelength sample size is specified.")
   endif()
+  foreach(variant_size ${NANAIRO_WAVELENGTH_SAMPLE_SIZE_VARIANTS})
+    if(NOT (0 LESS ${variant_size} AND (${variant_size} LESS ${spectra_size} OR
+                                        ${variant_size} EQUAL ${spectra_size})))
+      message(FATAL_ERROR "Invalid wavelength sample size variant '${variant_size}' is specified.")
+    endif()
+  endforeach(variant_size)
 endfunction(validateOptions)
 
 
@@ -55,13 +66,25 @@ function(initCommandOptions)
   # Rendering options
   set(option_description "Set the floating point type of the computation in rendering.")
   setStringOption(NANAIRO_FLOATING_POINT_TYPE "double" ${option_description})
+
+  set(option_description "Set the floating point type of the film storage. The film values are promoted to the rendering type when they are read.")
+  setStringOption(NANAIRO_FILM_FLOATING_POINT_TYPE "double" ${option_description})
  
-  set(option_description "Set the max number of objects that a BVH node can contain.")
+  set(option_description "Set the max number of objects that a BVH node can contain. The leaf size of a BVH can be tuned up to it at runtime.")
   setStringOption(NANAIRO_MAX_NUM_OF_OBJECTS 8 ${option_description})
 
+  set(option_description "Set the max k of the k nearest neighbor photon search.")
+  setStringOption(NANAIRO_MAX_NUM_OF_KNN_PHOTONS 64 ${option_description})
+
   set(option_description "Set max FPS")
   setStringOption(NANAIRO_MAX_FPS 50 ${option_description})
 
+  set(option_description "The resolution scale of the GUI preview during camera moves. 1 disables the low resolution preview.")
+  setStringOption(NANAIRO_GUI_PREVIEW_SCALE 4 ${option_description})
+
+  set(option_description "The idle time (ms) of the camera until the GUI preview goes back to the full resolution.")
+  setStringOption(NANAIRO_GUI_PREVIEW_IDLE_TIME 300 ${option_description})
+
   set(option_description "The hash key which is used as the default random seed.")
   setStringOption(NANAIRO_RANDOM_SEED_KEY "NanairoRenderer" ${option_description})
 
@@ -71,6 +94,9 @@ function(initCommandOptions)
   set(option_description "Build unit tests.")
   setBooleanOption(NANAIRO_BUILD_TESTS OFF ${option_description})
 
+  set(option_description "Build micro benchmarks. Google Benchmark is required.")
+  setBooleanOption(NANAIRO_BUILD_BENCHMARKS OFF ${option_description})
+
   set(option_description "Suppress excessive warnings.")
   setBooleanOption(NANAIRO_SUPPRESS_EXCESSIVE_WARNING ON ${option_description})
 
@@ -93,14 +119,36 @@ function(initCommandOptions)
   set(option_description "The sample size of wavelengths in a cycle of progressive monte calro ray tracing method (It is must be 3).")
   setStringOption(NANAIRO_WAVELENGTH_SAMPLE_SIZE 3 ${option_description})
 
+  set(option_description "The additional wavelength sample sizes, such as '4;8;16'. A SimpleNanairo app is built for each size and a scene selects the app by the wavelength sample size of the system settings.")
+  setStringOption(NANAIRO_WAVELENGTH_SAMPLE_SIZE_VARIANTS "" ${option_description})
+
   set(option_description "Enable only the explicit connection of path tracing.")
   setBooleanOption(NANAIRO_PATH_TRACING_EXPLICIT_CONNECTION_ONLY OFF ${option_description})
 
   set(option_description "Enable only the implicit connection of path tracing.")
   setBooleanOption(NANAIRO_PATH_TRACING_IMPLICIT_CONNECTION_ONLY OFF ${option_description})
 
+  set(option_description "Store the spectra of image textures as three coefficients of a sigmoid polynomial.")
+  setBooleanOption(NANAIRO_COMPACT_TEXTURE_SPECTRA OFF ${option_description})
+
+  set(option_description "Store the RGB values or the sigmoid coefficients of image textures per texel in channel planes instead of the color indices, which uses more memory.")
+  setBooleanOption(NANAIRO_DIRECT_TEXTURE_LAYOUT OFF ${option_description})
+
+  set(option_description "Test the rays against the triangles by the watertight algorithm which finds no hole between adjacent triangles.")
+  setBooleanOption(NANAIRO_WATERTIGHT_TRIANGLE_TEST OFF ${option_description})
+
+  set(option_description "Accumulate the traversal steps, the intersection tests and the processor cycles of the camera paths of pixels, and output them as a heatmap.")
+  setBooleanOption(NANAIRO_PIXEL_COST_HEATMAP OFF ${option_description})
+
+  set(option_description "The max size of the tile cache which is shared by the tiled image textures.")
+  math(EXPR __cache_size__ "1024 * 1024 * 1024")
+  setStringOption(NANAIRO_TEXTURE_TILE_CACHE_SIZE ${__cache_size__} ${option_description})
+
   set(option_description "Set the heuristic parameter of the MIS weight calculation (1: balance heuristic, 2: power heuristic).")
   setStringOption(NANAIRO_MIS_HEURISTIC_BETA 2 ${option_description})
 
+  set(option_description "Set the depth of the nodes which are prefetched ahead in the k-d tree photon search. The BVH traversal prefetches the next candidate nodes and the leaf objects if it's positive. 0 disables the prefetch.")
+  setStringOption(NANAIRO_TRAVERSAL_PREFETCH_DEPTH 0 ${option_description})
+
   validateOptions()
 endfunction(initCommandOptions)
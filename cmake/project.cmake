@@ -130,11 +130,25 @@ endfunction(loadLodepng)
 
 #
 function(buildNanairoCore core_library core_definitions)
+  set(core_name NanairoCore)
+  buildNanairoCoreVariant(${core_name}
+                          ${NANAIRO_WAVELENGTH_SAMPLE_SIZE}
+                          ${PROJECT_BINARY_DIR}/include
+                          core_defs)
+
+
+  # Output variables
+  set(${core_library} ${core_name} PARENT_SCOPE)
+  set(${core_definitions} ${core_defs} PARENT_SCOPE)
+endfunction(buildNanairoCore)
+
+
+# Build a core library of the wavelength sample size
+function(buildNanairoCoreVariant core_name sample_size include_dir core_definitions)
   # Load Nanairo core
   include(${PROJECT_SOURCE_DIR}/source/NanairoCore/config.cmake)
-  getNanairoCore(core_source_files core_defs)
+  getNanairoCoreVariant(${sample_size} ${include_dir} core_source_files core_defs)
   # Build Core
-  set(core_name NanairoCore)
   add_library(${core_name} STATIC ${core_source_files})
   # Set properties
   set_target_properties(${core_name} PROPERTIES CXX_STANDARD 17
@@ -146,7 +160,7 @@ function(buildNanairoCore core_library core_definitions)
                                               ${cxx_warning_flags}
                                               ${nanairo_warning_flags})
   target_include_directories(${core_name} PRIVATE ${PROJECT_SOURCE_DIR}/source
-                                                  ${PROJECT_BINARY_DIR}/include)
+                                                  ${include_dir})
   includeZisc(${core_name})
   target_link_libraries(${core_name} ${CMAKE_THREAD_LIBS_INIT}
                                      ${cxx_linker_flags}
@@ -159,9 +173,8 @@ function(buildNanairoCore core_library core_definitions)
 
 
   # Output variables
-  set(${core_library} ${core_name} PARENT_SCOPE)
   set(${core_definitions} ${core_defs} PARENT_SCOPE)
-endfunction(buildNanairoCore)
+endfunction(buildNanairoCoreVariant)
 
 
 function(getSimpleRenderer renderer_source_files renderer_include_dir renderer_definitions)
@@ -180,13 +193,38 @@ function(buildSimpleNanairoApp)
   ## Load Nanairo modules
   include(${PROJECT_SOURCE_DIR}/cmake/keyword.cmake)
   getNanairoKeywords(nanairo_keyword_list)
-  getSimpleRenderer(renderer_source_files renderer_include_dir renderer_definitions)
   ## Build SimpleNanairo
+  addSimpleNanairoApp("SimpleNanairo"
+                      ${core_library}
+                      "${core_definitions}"
+                      ${PROJECT_BINARY_DIR}/include)
+  ## Build the variants of the wavelength sample sizes.
+  ## The variant of size n is named 'SimpleNanairo_w<n>'
+  foreach(sample_size ${NANAIRO_WAVELENGTH_SAMPLE_SIZE_VARIANTS})
+    if(NOT sample_size EQUAL NANAIRO_WAVELENGTH_SAMPLE_SIZE)
+      set(variant_include_dir
+          ${PROJECT_BINARY_DIR}/WavelengthSampleSize${sample_size}/include)
+      set(variant_core_name "NanairoCore_w${sample_size}")
+      buildNanairoCoreVariant(${variant_core_name}
+                              ${sample_size}
+                              ${variant_include_dir}
+                              variant_core_definitions)
+      addSimpleNanairoApp("SimpleNanairo_w${sample_size}"
+                          ${variant_core_name}
+                          "${variant_core_definitions}"
+                          ${variant_include_dir})
+    endif()
+  endforeach(sample_size)
+endfunction(buildSimpleNanairoApp)
+
+
+#
+function(addSimpleNanairoApp app_name app_core_library app_core_definitions
+                             core_include_dir)
+  getSimpleRenderer(renderer_source_files renderer_include_dir renderer_definitions)
   set(nanairo_source_files ${PROJECT_SOURCE_DIR}/source/simple_nanairo.cpp
                            ${renderer_source_files})
-  set(app_name "SimpleNanairo")
   add_executable(${app_name} ${nanairo_source_files}
-                             ${core_source_files}
                              ${zisc_header_files})
   ## Set SimpleNanairo properties
   set_target_properties(${app_name} PROPERTIES CXX_STANDARD 17
@@ -199,7 +237,7 @@ function(buildSimpleNanairoApp)
                                              ${nanairo_warning_flags})
   target_include_directories(${app_name} PRIVATE ${renderer_include_dir}
                                                  ${PROJECT_SOURCE_DIR}/source
-                                                 ${PROJECT_BINARY_DIR}/include)
+                                                 ${core_include_dir})
   includeZisc(${app_name})
   target_include_directories(${app_name} SYSTEM PRIVATE
       ${lodepng_include_dir}
@@ -208,15 +246,85 @@ function(buildSimpleNanairoApp)
                                     ${cxx_linker_flags}
                                     ${zisc_linker_flags}
                                     ${lodepng_library}
-                                    ${core_library})
+                                    ${app_core_library})
   target_compile_definitions(${app_name} PRIVATE ${cxx_definitions}
-                                                 ${core_definitions}
+                                                 ${app_core_definitions}
                                                  ${renderer_definitions}
                                                  ${zisc_definitions}
                                                  ${environment_definitions}
                                                  NANAIRO_HAS_LODEPNG)
   setStaticAnalyzer(${app_name})
-endfunction(buildSimpleNanairoApp)
+endfunction(addSimpleNanairoApp)
+
+
+#
+function(buildDenoiserBenchmark)
+  set(benchmark_name "DenoiserBenchmark")
+  add_executable(${benchmark_name} ${PROJECT_SOURCE_DIR}/source/denoiser_benchmark.cpp
+                                   ${core_source_files}
+                                   ${zisc_header_files})
+  ## Set DenoiserBenchmark properties
+  set_target_properties(${benchmark_name} PROPERTIES CXX_STANDARD 17
+                                                     CXX_STANDARD_REQUIRED ON)
+  getCxxWarningOption(cxx_warning_flags)
+  getNanairoWarningOption(nanairo_warning_flags)
+  target_compile_options(${benchmark_name} PRIVATE ${cxx_compiler_flags}
+                                                   ${zisc_compile_flags}
+                                                   ${cxx_warning_flags}
+                                                   ${nanairo_warning_flags})
+  target_include_directories(${benchmark_name} PRIVATE ${PROJECT_SOURCE_DIR}/source
+                                                       ${PROJECT_BINARY_DIR}/include)
+  includeZisc(${benchmark_name})
+  target_include_directories(${benchmark_name} SYSTEM PRIVATE
+      ${PROJECT_SOURCE_DIR}/source/dependencies/cxxopts/include)
+  target_link_libraries(${benchmark_name} ${CMAKE_THREAD_LIBS_INIT}
+                                          ${cxx_linker_flags}
+                                          ${zisc_linker_flags}
+                                          ${core_library})
+  target_compile_definitions(${benchmark_name} PRIVATE ${cxx_definitions}
+                                                       ${core_definitions}
+                                                       ${zisc_definitions}
+                                                       ${environment_definitions})
+  setStaticAnalyzer(${benchmark_name})
+endfunction(buildDenoiserBenchmark)
+
+
+#
+function(buildCheckpointDenoiser)
+  set(denoiser_name "CheckpointDenoiser")
+  getSimpleRenderer(renderer_source_files renderer_include_dir renderer_definitions)
+  add_executable(${denoiser_name} ${PROJECT_SOURCE_DIR}/source/checkpoint_denoiser.cpp
+                                  ${renderer_source_files}
+                                  ${zisc_header_files})
+  ## Set CheckpointDenoiser properties
+  set_target_properties(${denoiser_name} PROPERTIES CXX_STANDARD 17
+                                                    CXX_STANDARD_REQUIRED ON)
+  getCxxWarningOption(cxx_warning_flags)
+  getNanairoWarningOption(nanairo_warning_flags)
+  target_compile_options(${denoiser_name} PRIVATE ${cxx_compiler_flags}
+                                                  ${zisc_compile_flags}
+                                                  ${cxx_warning_flags}
+                                                  ${nanairo_warning_flags})
+  target_include_directories(${denoiser_name} PRIVATE ${PROJECT_SOURCE_DIR}/source
+                                                      ${renderer_include_dir}
+                                                      ${PROJECT_BINARY_DIR}/include)
+  includeZisc(${denoiser_name})
+  target_include_directories(${denoiser_name} SYSTEM PRIVATE
+      ${lodepng_include_dir}
+      ${PROJECT_SOURCE_DIR}/source/dependencies/cxxopts/include)
+  target_link_libraries(${denoiser_name} ${CMAKE_THREAD_LIBS_INIT}
+                                         ${cxx_linker_flags}
+                                         ${zisc_linker_flags}
+                                         ${lodepng_library}
+                                         ${core_library})
+  target_compile_definitions(${denoiser_name} PRIVATE ${cxx_definitions}
+                                                      ${core_definitions}
+                                                      ${renderer_definitions}
+                                                      ${zisc_definitions}
+                                                      ${environment_definitions}
+                                                      NANAIRO_HAS_LODEPNG)
+  setStaticAnalyzer(${denoiser_name})
+endfunction(buildCheckpointDenoiser)
 
 
 #
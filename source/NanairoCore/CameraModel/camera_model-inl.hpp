@@ -12,6 +12,7 @@
 
 #include "camera_model.hpp"
 // Standard C++ library
+#include <array>
 #include <utility>
 // Zisc
 #include "zisc/error.hpp"
@@ -21,6 +22,8 @@
 #include "film.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
 #include "NanairoCore/Material/Sensor/sensor.hpp"
 #include "NanairoCore/Sampling/sample_statistics.hpp"
 #include "NanairoCore/Sampling/sampled_direction.hpp"
@@ -86,6 +89,32 @@ auto CameraModel::makeSensor(
   return ptr;
 }
 
+/*!
+  \details
+  The directions are sampled by a single call of the camera,
+  so no sensor is made for the pixels.
+  The weight of a camera ray is always 1.
+  */
+template <uint kSize> inline
+void CameraModel::generateRays(const Index2d* pixel_index_list,
+                               const uint num_of_pixels,
+                               RayPacket<kSize>* packet,
+                               Float* inverse_direction_pdf_list) const noexcept
+{
+  ZISC_ASSERT(num_of_pixels <= kSize, "The number of pixels is out of range.");
+  std::array<SampledDirection, kSize> direction_list;
+  sampleDirections(pixel_index_list, num_of_pixels, direction_list.data());
+  const auto& lens_point = sampledLensPoint();
+  const Float spread_angle = pixelSpreadAngle();
+  for (uint i = 0; i < num_of_pixels; ++i) {
+    const auto& sampled_vout = direction_list[i];
+    inverse_direction_pdf_list[i] = sampled_vout.inversePdf();
+    auto ray = Ray::makeRay(lens_point, sampled_vout.direction());
+    ray.setCone(0.0, spread_angle);
+    packet->setRay(i, ray);
+  }
+}
+
 /*!
   \details
   No detailed.
@@ -18,6 +18,7 @@
 //#include "thin_lens_camera_model.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
 #include "NanairoCore/Setting/camera_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
@@ -116,6 +117,18 @@ void CameraModel::initialize(const SettingNodeBase* settings) noexcept
   }
 }
 
+/*!
+  \details
+  The directions are sampled one by one by default.
+  */
+void CameraModel::sampleDirections(const Index2d* pixel_index_list,
+                                   const uint num_of_pixels,
+                                   SampledDirection* direction_list) const noexcept
+{
+  for (uint i = 0; i < num_of_pixels; ++i)
+    direction_list[i] = sampleDirection(pixel_index_list[i]);
+}
+
 /*!
   \details
   No detailed.
@@ -26,6 +26,7 @@ namespace nanairo {
 
 // Forward decralation
 class Film;
+template <uint> class RayPacket;
 class PathState;
 class SampledSpectra;
 class Sampler;
@@ -95,6 +96,13 @@ class CameraModel
                            const WavelengthSamples& wavelengths,
                            zisc::pmr::memory_resource* mem_resource) const noexcept;
 
+  //! Generate the camera rays of the pixels into the packet
+  template <uint kSize>
+  void generateRays(const Index2d* pixel_index_list,
+                    const uint num_of_pixels,
+                    RayPacket<kSize>* packet,
+                    Float* inverse_direction_pdf_list) const noexcept;
+
   //! Return the height resolution of the film
   uint heightResolution() const noexcept;
 
@@ -112,6 +120,9 @@ class CameraModel
       System& system,
       const SettingNodeBase* settings) noexcept;
 
+  //! Return the angle which a pixel subtends from the lens
+  virtual Float pixelSpreadAngle() const noexcept = 0;
+
   //! Return the camera position
   virtual const Point3& position() const noexcept = 0;
 
@@ -127,6 +138,11 @@ class CameraModel
   //! Sample ray direction
   virtual SampledDirection sampleDirection(const Index2d& index) const noexcept = 0;
 
+  //! Sample the ray directions of the pixels
+  virtual void sampleDirections(const Index2d* pixel_index_list,
+                                const uint num_of_pixels,
+                                SampledDirection* direction_list) const noexcept;
+
   //! Return the sampled point
   virtual const Point3& sampledLensPoint() const noexcept = 0;
 
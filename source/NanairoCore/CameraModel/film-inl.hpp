@@ -24,12 +24,12 @@ namespace nanairo {
 
 /*!
   \details
-  No detailed.
+  The camera projects the full image even if the film has only a crop window.
   */
 inline
 Float Film::aspectRatio() const noexcept
 {
-  const auto r = imageResolution();
+  const auto r = fullImageResolution();
   const Float aspect_ratio = zisc::cast<Float>(r[0]) / zisc::cast<Float>(r[1]);
   return aspect_ratio;
 }
@@ -44,9 +44,10 @@ Point2 Film::coordinate(const Index2d& index,
 {
   using zisc::cast;
 
-  const auto r = imageResolution();
-  const Float s = (cast<Float>(index[0]) + jittering[0]) / cast<Float>(r[0]);
-  const Float t = (cast<Float>(index[1]) + jittering[1]) / cast<Float>(r[1]);
+  const auto r = fullImageResolution();
+  const auto& o = crop_offset_;
+  const Float s = (cast<Float>(index[0] + o[0]) + jittering[0]) / cast<Float>(r[0]);
+  const Float t = (cast<Float>(index[1] + o[1]) + jittering[1]) / cast<Float>(r[1]);
   ZISC_ASSERT(zisc::isInClosedBounds(s, 0.0, 1.0),
               "The coordinate s is out of the range [0, 1].");
   ZISC_ASSERT(zisc::isInClosedBounds(t, 0.0, 1.0),
@@ -54,6 +55,30 @@ Point2 Film::coordinate(const Index2d& index,
   return Point2{s, t};
 }
 
+/*!
+  \details
+  The coordinate outside of the crop window has no pixel.
+  */
+inline
+bool Film::calcPixelIndex(const Point2& coordinate, Index2d* index) const noexcept
+{
+  using zisc::cast;
+
+  ZISC_ASSERT(index != nullptr, "The index is null.");
+  const auto r = fullImageResolution();
+  const auto& o = crop_offset_;
+  const uint32 x = cast<uint32>(coordinate[0] * cast<Float>(r[0]));
+  const uint32 y = cast<uint32>(coordinate[1] * cast<Float>(r[1]));
+  const auto crop = imageResolution();
+  const bool is_in_crop = (o[0] <= x) && (x < o[0] + crop[0]) &&
+                          (o[1] <= y) && (y < o[1] + crop[1]);
+  if (is_in_crop) {
+    (*index)[0] = x - o[0];
+    (*index)[1] = y - o[1];
+  }
+  return is_in_crop;
+}
+
 /*!
   */
 inline
@@ -62,6 +87,22 @@ void Film::clear() noexcept
   sample_statistics_.clear();
 }
 
+/*!
+  */
+inline
+Index2d Film::cropOffset() const noexcept
+{
+  return crop_offset_;
+}
+
+/*!
+  */
+inline
+Index2d Film::fullImageResolution() const noexcept
+{
+  return full_image_resolution_;
+}
+
 /*!
   \details
   No detailed.
@@ -36,9 +36,11 @@ Film::Film(System& system, const SettingNodeBase* settings) noexcept :
   \details
   No detailed.
   */
-void Film::initialize(System& /* system */,
+void Film::initialize(System& system,
                       const SettingNodeBase* /* settings */) noexcept
 {
+  full_image_resolution_ = system.fullImageResolution();
+  crop_offset_ = system.cropOffset();
 }
 
 } // namespace nanairo
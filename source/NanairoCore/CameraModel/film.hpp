@@ -38,12 +38,21 @@ class Film
   //! Return the aspect ratio of image
   Float aspectRatio() const noexcept;
 
+  //! Calculate the pixel index of the film coordinate
+  bool calcPixelIndex(const Point2& coordinate, Index2d* index) const noexcept;
+
   //! Return a film coordinate correspond to the given index
   Point2 coordinate(const Index2d& index, const Vector2& jittering) const noexcept;
 
   //! Clear film buffers
   void clear() noexcept;
 
+  //! Return the offset of the crop window in the full image
+  Index2d cropOffset() const noexcept;
+
+  //! Return the resolution of the full image
+  Index2d fullImageResolution() const noexcept;
+
   //! Return the image height
   uint heightResolution() const noexcept;
 
@@ -65,6 +74,8 @@ class Film
 
 
   SampleStatistics sample_statistics_;
+  Index2d full_image_resolution_;
+  Index2d crop_offset_;
 };
 
 //! \} Core 
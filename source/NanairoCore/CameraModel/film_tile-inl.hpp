@@ -0,0 +1,136 @@
+/*!
+  \file film_tile-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_FILM_TILE_INL_HPP
+#define NANAIRO_FILM_TILE_INL_HPP
+
+#include "film_tile.hpp"
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/xyz_color_matching_function.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+FilmTile::FilmTile(const RenderingTile& tile) noexcept :
+    tile_{tile}
+{
+  reset(tile);
+}
+
+/*!
+  */
+inline
+void FilmTile::add(const Index2d& pixel,
+                   const SampledSpectra& contribution) noexcept
+{
+  ZISC_ASSERT(isInTile(pixel), "The pixel is out of the tile.");
+  const uint index = tile_.getIndex(pixel);
+  auto& value = value_list_[index];
+  for (uint i = 0; i < contribution.size(); ++i)
+    value.set(i, value[i] + contribution.intensity(i));
+  is_contributed_[index] = kTrue;
+}
+
+/*!
+  \details
+  The pixels which have no contributions are skipped.
+  The tile is touched in the mapped film, so it's kept resident.
+  */
+inline
+void FilmTile::commit(const WavelengthSamples& wavelengths,
+                      SampleStatistics* statistics) const noexcept
+{
+  statistics->touch(tile_);
+  const uint width = tile_.widthResolution();
+  const uint num_of_pixels = tile_.numOfPixels();
+  for (uint index = 0; index < num_of_pixels; ++index) {
+    if (is_contributed_[index] != kTrue)
+      continue;
+    const Index2d pixel{tile_.begin()[0] + index % width,
+                        tile_.begin()[1] + index / width};
+    const SampledSpectra contribution{wavelengths, value_list_[index]};
+    statistics->addSample(pixel, contribution);
+  }
+}
+
+/*!
+  \details
+  The response is the CMF of the wavelengths for the XYZ film.
+  */
+inline
+void FilmTile::commit(const WavelengthSamples& wavelengths,
+                      const XyzColorMatchingFunction::SensorResponse& response,
+                      SampleStatistics* statistics) const noexcept
+{
+  statistics->touch(tile_);
+  const uint width = tile_.widthResolution();
+  const uint num_of_pixels = tile_.numOfPixels();
+  for (uint index = 0; index < num_of_pixels; ++index) {
+    if (is_contributed_[index] != kTrue)
+      continue;
+    const Index2d pixel{tile_.begin()[0] + index % width,
+                        tile_.begin()[1] + index / width};
+    const SampledSpectra contribution{wavelengths, value_list_[index]};
+    statistics->addSample(pixel, contribution, response);
+  }
+}
+
+/*!
+  */
+inline
+bool FilmTile::isInTile(const Index2d& pixel) const noexcept
+{
+  const auto& begin = tile_.begin();
+  const auto& end = tile_.end();
+  return (begin[0] <= pixel[0]) && (pixel[0] < end[0]) &&
+         (begin[1] <= pixel[1]) && (pixel[1] < end[1]);
+}
+
+/*!
+  */
+inline
+void FilmTile::reset(const RenderingTile& tile) noexcept
+{
+  ZISC_ASSERT(tile.numOfPixels() <= tileSize(), "The tile is too large.");
+  tile_ = tile;
+  const uint num_of_pixels = tile_.numOfPixels();
+  for (uint index = 0; index < num_of_pixels; ++index) {
+    value_list_[index].fill(0.0);
+    is_contributed_[index] = kFalse;
+  }
+}
+
+/*!
+  */
+inline
+const RenderingTile& FilmTile::tile() const noexcept
+{
+  return tile_;
+}
+
+/*!
+  */
+inline
+constexpr uint FilmTile::tileSize() noexcept
+{
+  constexpr uint tile_side = CoreConfig::sizeOfRenderingTileSide();
+  return tile_side * tile_side;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_FILM_TILE_INL_HPP
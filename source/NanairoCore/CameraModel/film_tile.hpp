@@ -0,0 +1,83 @@
+/*!
+  \file film_tile.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_FILM_TILE_HPP
+#define NANAIRO_FILM_TILE_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/xyz_color_matching_function.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class SampledSpectra;
+class SampleStatistics;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The accumulator of the contributions of a rendering tile
+  \details
+  A worker accumulates the contributions of the pixels of its tile
+  into the small buffer, which stays in the cache,
+  and commits them to the film at once.
+  The contributions of the pixels outside of the tile
+  have to be added to the film by the caller.
+  */
+class FilmTile
+{
+ public:
+  //! Create a film tile
+  FilmTile(const RenderingTile& tile) noexcept;
+
+
+  //! Add a contribution of the pixel in the tile
+  void add(const Index2d& pixel, const SampledSpectra& contribution) noexcept;
+
+  //! Add the accumulated contributions to the statistics
+  void commit(const WavelengthSamples& wavelengths,
+              SampleStatistics* statistics) const noexcept;
+
+  //! Add the contributions of the wavelengths which are sampled for the tile
+  void commit(const WavelengthSamples& wavelengths,
+              const XyzColorMatchingFunction::SensorResponse& response,
+              SampleStatistics* statistics) const noexcept;
+
+  //! Check if the pixel is in the tile
+  bool isInTile(const Index2d& pixel) const noexcept;
+
+  //! Reset the accumulator for the tile
+  void reset(const RenderingTile& tile) noexcept;
+
+  //! Return the tile
+  const RenderingTile& tile() const noexcept;
+
+  //! Return the max number of pixels of a tile
+  static constexpr uint tileSize() noexcept;
+
+ private:
+  std::array<IntensitySamples, CoreConfig::sizeOfRenderingTileSide() *
+                               CoreConfig::sizeOfRenderingTileSide()> value_list_;
+  std::array<uint8, CoreConfig::sizeOfRenderingTileSide() *
+                    CoreConfig::sizeOfRenderingTileSide()> is_contributed_;
+  RenderingTile tile_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "film_tile-inl.hpp"
+
+#endif // NANAIRO_FILM_TILE_HPP
@@ -101,7 +101,7 @@ bool PinholeCamera::FilmShape::testIntersection(const Ray& ray, Point2* st)
                                               normal(),
                                               ray,
                                               max_distance,
-                                              st);
+                                              st).isSuccess();
   return result;
 }
 
@@ -98,13 +98,7 @@ bool PinholeCamera::calcPixelLocation(const Vector3& ray_direction,
   const auto ray = Ray::makeRay(sampledLensPoint(), ray_direction);
   Point2 st;
   const bool is_hit = shape.testIntersection(ray, &st);
-  if (is_hit) {
-    const auto w = zisc::cast<Float>(widthResolution());
-    const auto h = zisc::cast<Float>(heightResolution());
-    (*index)[0] = zisc::cast<uint32>(st[0] * w);
-    (*index)[1] = zisc::cast<uint32>(st[1] * h);
-  }
-  return is_hit;
+  return is_hit && film().calcPixelIndex(st, index);
 }
 
 /*!
@@ -115,6 +109,18 @@ Vector3 PinholeCamera::getNormal(const Index2d& /* index */) const noexcept
   return shape.normal();
 }
 
+/*!
+  \details
+  The film is placed at the unit distance from the pinhole,
+  so the angle is approximated by the width of a pixel.
+  */
+Float PinholeCamera::pixelSpreadAngle() const noexcept
+{
+  const auto& shape = filmShape();
+  const Float w = shape.edge()[0].norm();
+  return w / zisc::cast<Float>(film().fullImageResolution()[0]);
+}
+
 /*!
   \details
   No detailed.
@@ -146,6 +152,34 @@ SampledDirection PinholeCamera::sampleDirection(const Index2d& index) const noex
   return SampledDirection{direction, calcInversePdf(cos_theta)};
 }
 
+/*!
+  \details
+  The film shape and the pinhole are read once for all pixels.
+  */
+void PinholeCamera::sampleDirections(const Index2d* pixel_index_list,
+                                     const uint num_of_pixels,
+                                     SampledDirection* direction_list) const noexcept
+{
+  const auto& pinhole_point = sampledLensPoint();
+  const auto& shape = filmShape();
+  const auto& e = shape.edge();
+  const auto& v0 = shape.vertex0();
+  const auto& normal = shape.normal();
+  const auto& j = jittering();
+  const Float area = shape.surfaceArea();
+  const auto& f = film();
+  for (uint i = 0; i < num_of_pixels; ++i) {
+    const auto st = f.coordinate(pixel_index_list[i], j);
+    const auto film_point = v0 + (st[0] * e[0] + st[1] * e[1]);
+    const auto direction = (pinhole_point - film_point).normalized();
+    const Float cos_theta = zisc::dot(normal, direction);
+    ZISC_ASSERT(zisc::isInClosedBounds(cos_theta, 0.0, 1.0),
+                "Invalid direction is sampled.");
+    direction_list[i] = SampledDirection{direction,
+                                         area * zisc::power<3>(cos_theta)};
+  }
+}
+
 /*!
   */
 const Point3& PinholeCamera::sampledLensPoint() const noexcept
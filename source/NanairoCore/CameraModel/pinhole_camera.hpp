@@ -113,12 +113,20 @@ class PinholeCamera : public CameraModel
   //! Return the normal of the pinhole camera
   Vector3 getNormal(const Index2d& index) const noexcept override;
 
+  //! Return the angle which a pixel subtends from the pinhole
+  Float pixelSpreadAngle() const noexcept override;
+
   //! Return the camera position
   const Point3& position() const noexcept override;
 
   //! Sample ray direction
   SampledDirection sampleDirection(const Index2d& index) const noexcept override;
 
+  //! Sample the ray directions of the pixels
+  void sampleDirections(const Index2d* pixel_index_list,
+                        const uint num_of_pixels,
+                        SampledDirection* direction_list) const noexcept override;
+
   //! Return the sampled lens point
   const Point3& sampledLensPoint() const noexcept override;
 
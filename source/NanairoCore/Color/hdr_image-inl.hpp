@@ -12,14 +12,17 @@
 
 #include "hdr_image.hpp"
 // Standard C++ library
+#include <limits>
 #include <vector>
 // Zisc
+#include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/point.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "xyz_color.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 
 namespace nanairo {
 
@@ -123,6 +126,32 @@ const XyzColor& HdrImage::get(const Index2d& index) const noexcept
   return get(i);
 }
 
+/*!
+  */
+inline
+RenderingTile HdrImage::getTile(const uint tile_index) const noexcept
+{
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  const auto tiles = tileResolution();
+  const uint x = tile_index % tiles[0];
+  const uint y = tile_index / tiles[0];
+  const Index2d begin{x * s, y * s};
+  const Index2d end{zisc::min((x + 1) * s, resolution_[0]),
+                    zisc::min((y + 1) * s, resolution_[1])};
+  const RenderingTile tile{begin, end};
+  return tile;
+}
+
+/*!
+  */
+inline
+uint HdrImage::getTileIndex(const uint x, const uint y) const noexcept
+{
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  const uint index = (x / s) + tileResolution()[0] * (y / s);
+  return index;
+}
+
 /*!
   \details
   No detailed.
@@ -134,6 +163,22 @@ uint HdrImage::heightResolution() const noexcept
   return zisc::cast<uint>(r[1]);
 }
 
+/*!
+  */
+inline
+constexpr uint32 HdrImage::invalidSampleCount() noexcept
+{
+  return std::numeric_limits<uint32>::max();
+}
+
+/*!
+  */
+inline
+bool HdrImage::isDirtyTile(const uint tile_index) const noexcept
+{
+  return dirty_tile_[tile_index] == kTrue;
+}
+
 /*!
   */
 inline
@@ -150,6 +195,23 @@ uint HdrImage::numOfPixels() const noexcept
   return widthResolution() * heightResolution();
 }
 
+/*!
+  */
+inline
+uint HdrImage::numOfTiles() const noexcept
+{
+  const auto tiles = tileResolution();
+  return tiles[0] * tiles[1];
+}
+
+/*!
+  */
+inline
+constexpr const char* HdrImage::pfmFileExtension() noexcept
+{
+  return ".pfm";
+}
+
 /*!
   */
 inline
@@ -174,6 +236,10 @@ inline
 void HdrImage::set(const uint index, const XyzColor& color) noexcept
 {
   buffer_[index] = color;
+  const uint x = index % widthResolution();
+  const uint y = index / widthResolution();
+  dirty_tile_[getTileIndex(x, y)] = kTrue;
+  converted_count_[index] = invalidSampleCount();
 }
 
 /*!
@@ -209,6 +275,17 @@ uint HdrImage::widthResolution() const noexcept
   return zisc::cast<uint>(r[0]);
 }
 
+/*!
+  */
+inline
+Index2d HdrImage::tileResolution() const noexcept
+{
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  const Index2d tiles{(resolution_[0] + s - 1) / s,
+                      (resolution_[1] + s - 1) / s};
+  return tiles;
+}
+
 /*!
   */
 inline
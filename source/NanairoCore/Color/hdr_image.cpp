@@ -9,18 +9,33 @@
 
 #include "hdr_image.hpp"
 // Standard C++ library
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <string>
 #include <vector>
 // Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/error.hpp"
 #include "zisc/math.hpp"
+#include "zisc/matrix.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/point.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "color_conversion.hpp"
+#include "color_space.hpp"
+#include "rgb_color.hpp"
 #include "xyz_color.hpp"
+#include "xyz_color_matching_function.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
-#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Color/spectral_table.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
 
 namespace nanairo {
 
@@ -32,6 +47,8 @@ HdrImage::HdrImage(const uint width,
                    const uint height,
                    zisc::pmr::memory_resource* data_resource) noexcept :
     buffer_{data_resource},
+    converted_count_{data_resource},
+    dirty_tile_{data_resource},
     resolution_{Index2d{zisc::cast<uint32>(width), zisc::cast<uint32>(height)}}
 {
   initialize();
@@ -42,6 +59,8 @@ HdrImage::HdrImage(const uint width,
 HdrImage::HdrImage(const Index2d& resolution,
                    zisc::pmr::memory_resource* data_resource) noexcept :
     buffer_{data_resource},
+    converted_count_{data_resource},
+    dirty_tile_{data_resource},
     resolution_{resolution}
 {
   initialize();
@@ -49,21 +68,83 @@ HdrImage::HdrImage(const Index2d& resolution,
 
 /*!
   */
+void HdrImage::invalidate() noexcept
+{
+  std::fill(converted_count_.begin(), converted_count_.end(), invalidSampleCount());
+  std::fill(dirty_tile_.begin(), dirty_tile_.end(), kTrue);
+}
+
+/*!
+  \details
+  The normalization changes all pixels, so all tiles become dirty.
+  */
+template <bool kCompensated>
 void HdrImage::toHdr(System& system,
                      const uint64 num_of_samples,
-                     const zisc::pmr::vector<SpectralDistribution::SpectralDistributionPointer>& sample_table) noexcept
+                     const SpectralTable<kCompensated>& sample_table) noexcept
 {
   using zisc::cast;
+  TraceRecorder::Scope scope{system.traceRecorder(), "HDR conversion"};
   const Float inv_n = zisc::invert(cast<Float>(num_of_samples));
   auto to_hdr = [this, &system, inv_n, &sample_table](const uint task_id)
   {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "HDR conversion task"};
     // Set the calculation range
-    const auto range = system.calcTaskRange(numOfPixels(), task_id);
+    const auto range = system.calcTaskRange(numOfTiles(), task_id);
     // Convert to HDR
-    for (uint index = range[0]; index < range[1]; ++index) {
-      const auto& sample_p = sample_table[index];
-      buffer_[index] = sample_p->toXyzForEmitter(system) * inv_n;
-    }
+    convertTiles(system, sample_table, range[0], range[1],
+                 [inv_n](const uint) {return inv_n;},
+                 [this](const uint index, const uint)
+    {
+      converted_count_[index] = invalidSampleCount();
+      return true;
+    });
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(to_hdr, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  Each pixel is normalized by its own number of samples,
+  which differs among pixels when adaptive sampling is enabled.
+  The samples of a pixel don't change while its count stays,
+  so only the pixels whose count changed since the last conversion
+  are converted.
+  */
+template <bool kCompensated>
+void HdrImage::toHdr(System& system,
+                     const zisc::pmr::vector<uint32>& sample_count_table,
+                     const SpectralTable<kCompensated>& sample_table) noexcept
+{
+  using zisc::cast;
+  TraceRecorder::Scope scope{system.traceRecorder(), "HDR conversion"};
+  auto to_hdr = [this, &system, &sample_count_table, &sample_table](const uint task_id)
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "HDR conversion task"};
+    // Set the calculation range
+    const auto range = system.calcTaskRange(numOfTiles(), task_id);
+    // Convert to HDR
+    convertTiles(system, sample_table, range[0], range[1],
+                 [&sample_count_table](const uint index)
+    {
+      const uint32 n = zisc::max(sample_count_table[index], 1u);
+      return zisc::invert(cast<Float>(n));
+    },
+                 [this, &sample_count_table](const uint index, const uint table_index)
+    {
+      const uint32 n = sample_count_table[table_index];
+      const bool is_changed = converted_count_[index] != n;
+      converted_count_[index] = n;
+      return is_changed;
+    });
   };
 
   {
@@ -76,6 +157,179 @@ void HdrImage::toHdr(System& system,
   }
 }
 
+/*!
+  \details
+  The colors aren't exposed or clamped, so the HDR values of the film
+  are kept for compositing.
+  */
+void HdrImage::toRgb(System& system,
+                     zisc::pmr::vector<std::array<float, 3>>* rgb_buffer,
+                     zisc::pmr::memory_resource* work_resource) const noexcept
+{
+  ZISC_ASSERT(rgb_buffer != nullptr, "The rgb buffer is null.");
+  ZISC_ASSERT(rgb_buffer->size() == size(), "The size of the buffer is wrong.");
+  const auto to_rgb_matrix = getXyzToRgbMatrix(system.colorSpace());
+  auto to_rgb = [this, &system, &to_rgb_matrix, rgb_buffer](const uint task_id)
+  {
+    // Set the calculation range
+    const auto range = system.calcTaskRange(numOfPixels(), task_id);
+    for (uint index = range[0]; index < range[1]; ++index) {
+      const auto rgb = ColorConversion::toRgb(get(index), to_rgb_matrix);
+      (*rgb_buffer)[index] = std::array<float, 3>{{zisc::cast<float>(rgb.red()),
+                                                   zisc::cast<float>(rgb.green()),
+                                                   zisc::cast<float>(rgb.blue())}};
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(to_rgb, start, end, work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  Only the color PFM files are read. The floats of a positive scale
+  are big endian and they are swapped to the little endian.
+  */
+bool HdrImage::readPfm(const std::string& file_path,
+                       zisc::pmr::vector<std::array<float, 3>>* rgb_buffer,
+                       Index2d* resolution) noexcept
+{
+  ZISC_ASSERT(rgb_buffer != nullptr, "The buffer is null.");
+  ZISC_ASSERT(resolution != nullptr, "The resolution is null.");
+  std::ifstream pfm_file{file_path, std::ios::binary};
+  if (!pfm_file.is_open())
+    return false;
+
+  std::string format;
+  std::size_t width = 0,
+              height = 0;
+  double scale = 0.0;
+  pfm_file >> format >> width >> height >> scale;
+  pfm_file.get(); // The single white space after the header
+  if (!pfm_file.good() || (format != "PF") || (width == 0) || (height == 0))
+    return false;
+
+  rgb_buffer->resize(width * height);
+  const std::size_t row_size = sizeof((*rgb_buffer)[0]) * width;
+  for (std::size_t y = height; 0 < y; --y) {
+    auto row = rgb_buffer->data() + width * (y - 1);
+    zisc::read(row, &pfm_file, row_size);
+  }
+  if (0.0 < scale) {
+    for (auto& rgb : *rgb_buffer) {
+      for (auto& c : rgb) {
+        auto bytes = zisc::treatAs<uint8*>(&c);
+        std::reverse(bytes, bytes + sizeof(c));
+      }
+    }
+  }
+  (*resolution)[0] = zisc::cast<uint32>(width);
+  (*resolution)[1] = zisc::cast<uint32>(height);
+  return pfm_file.good();
+}
+
+/*!
+  \details
+  The negative scale of the header means the little endian floats.
+  The rows of a PFM file are stored from the bottom to the top.
+  */
+bool HdrImage::writePfm(const zisc::pmr::vector<std::array<float, 3>>& rgb_buffer,
+                        const Index2d& resolution,
+                        const std::string& file_path) noexcept
+{
+  const std::size_t width = zisc::cast<std::size_t>(resolution[0]);
+  const std::size_t height = zisc::cast<std::size_t>(resolution[1]);
+  ZISC_ASSERT(rgb_buffer.size() == width * height,
+              "The size of the buffer is wrong.");
+
+  std::ofstream pfm_file{file_path, std::ios::binary};
+  if (!pfm_file.is_open())
+    return false;
+
+  const std::string header = "PF\n" + std::to_string(width) + " " +
+                             std::to_string(height) + "\n-1.0\n";
+  zisc::write(header.data(), &pfm_file, header.size());
+  const std::size_t row_size = sizeof(rgb_buffer[0]) * width;
+  for (std::size_t y = height; 0 < y; --y) {
+    const auto row = rgb_buffer.data() + width * (y - 1);
+    zisc::write(row, &pfm_file, row_size);
+  }
+  return pfm_file.good();
+}
+
+/*!
+  \details
+  The bins of a row are integrated with the CMF in place.
+  The rows of a XYZ film are already XYZ colors and
+  the rows of the RGB mode are converted by the matrix only.
+  A tile is dirty if any pixel of it is converted.
+  The weight takes the index of the film tables, which are tile-major,
+  and the predicate takes the image index and the table index.
+  */
+template <bool kCompensated, typename Weight, typename Predicate>
+void HdrImage::convertTiles(const System& system,
+                            const SpectralTable<kCompensated>& sample_table,
+                            const uint begin,
+                            const uint end,
+                            const Weight& weight,
+                            const Predicate& is_changed) noexcept
+{
+  auto convert = [this, begin, end, &weight, &is_changed](const auto& to_xyz)
+  {
+    for (uint tile_index = begin; tile_index < end; ++tile_index) {
+      auto tile = getTile(tile_index);
+      bool is_dirty = false;
+      for (uint i = 0; i < tile.numOfPixels(); ++i) {
+        const auto& pixel = tile.current();
+        const uint index = toIndex(pixel[0], pixel[1]);
+        // The pixels of a tile are contiguous in the tables of the film
+        const uint table_index = RenderingTile::getTileMajorIndex(resolution_, pixel);
+        if (is_changed(index, table_index)) {
+          buffer_[index] = to_xyz(table_index) * weight(table_index);
+          is_dirty = true;
+        }
+        tile.next();
+      }
+      dirty_tile_[tile_index] = is_dirty ? kTrue : kFalse;
+    }
+  };
+
+  if (system.isXyzFilmEnabled()) {
+    convert([&sample_table](const uint index)
+    {
+      return XyzColor{sample_table.get(index, 0),
+                      sample_table.get(index, 1),
+                      sample_table.get(index, 2)};
+    });
+  }
+  else if (system.isRgbMode()) {
+    // The RGB bins are read directly with the matrix of the color space
+    const uint r = sample_table.getIndex(CoreConfig::redWavelength());
+    const uint g = sample_table.getIndex(CoreConfig::greenWavelength());
+    const uint b = sample_table.getIndex(CoreConfig::blueWavelength());
+    const auto to_xyz_matrix = getRgbToXyzMatrix(system.colorSpace());
+    convert([&sample_table, r, g, b, &to_xyz_matrix](const uint index)
+    {
+      const RgbColor rgb{sample_table.get(index, r),
+                         sample_table.get(index, g),
+                         sample_table.get(index, b)};
+      return ColorConversion::toXyz(rgb, to_xyz_matrix);
+    });
+  }
+  else {
+    const auto& cmf = system.xyzColorMatchingFunction();
+    convert([&cmf, &sample_table](const uint index)
+    {
+      return cmf.toXyzForEmitter(sample_table, index);
+    });
+  }
+}
+
 /*!
   \details
   No detailed.
@@ -84,6 +338,26 @@ void HdrImage::initialize() noexcept
 {
   const uint buffer_size = widthResolution() * heightResolution();
   buffer_.resize(buffer_size);
+  converted_count_.resize(buffer_size);
+  dirty_tile_.resize(numOfTiles());
+  invalidate();
 }
 
+template void HdrImage::toHdr<false>(
+    System&,
+    const uint64,
+    const SpectralTable<false>&) noexcept;
+template void HdrImage::toHdr<true>(
+    System&,
+    const uint64,
+    const SpectralTable<true>&) noexcept;
+template void HdrImage::toHdr<false>(
+    System&,
+    const zisc::pmr::vector<uint32>&,
+    const SpectralTable<false>&) noexcept;
+template void HdrImage::toHdr<true>(
+    System&,
+    const zisc::pmr::vector<uint32>&,
+    const SpectralTable<true>&) noexcept;
+
 } // namespace nanairo
@@ -11,7 +11,9 @@
 #define NANAIRO_HDR_IMAGE_HPP
 
 // Standard C++ library
+#include <array>
 #include <cstddef>
+#include <string>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -20,7 +22,8 @@
 // Nanairo
 #include "xyz_color.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
-#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Color/spectral_table.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 
 namespace nanairo {
 
@@ -32,7 +35,9 @@ class System;
 
 /*!
   \details
-  No detailed.
+  The image is divided into tiles of the rendering tile size.
+  A conversion records the tiles which it changed as dirty,
+  so the following tone mapping updates only the dirty tiles.
   */
 class HdrImage
 {
@@ -78,21 +83,41 @@ class HdrImage
   //! Return the pixel color
   const XyzColor& get(const Index2d& index) const noexcept;
 
+  //! Return the tile of the given index
+  RenderingTile getTile(const uint tile_index) const noexcept;
+
   //! Return the height resolution
   uint heightResolution() const noexcept;
 
+  //! Mark all pixels as changed
+  void invalidate() noexcept;
+
+  //! Check if the tile was changed by the last update
+  bool isDirtyTile(const uint tile_index) const noexcept;
+
   //! Return the buffer memory size
   std::size_t memorySize() const noexcept;
 
   //! Return the num of pixels
   uint numOfPixels() const noexcept;
 
+  //! Return the num of tiles
+  uint numOfTiles() const noexcept;
+
   //! Return the resolution
   const Index2d& resolution() const noexcept;
 
   //! Return the buffer length
   uint size() const noexcept;
 
+  //! Return the extension of the PFM files
+  static constexpr const char* pfmFileExtension() noexcept;
+
+  //! Read the linear RGB colors of a PFM file
+  static bool readPfm(const std::string& file_path,
+                      zisc::pmr::vector<std::array<float, 3>>* rgb_buffer,
+                      Index2d* resolution) noexcept;
+
   //! Set pixel color
   void set(const uint ndex, const XyzColor& color) noexcept;
 
@@ -103,22 +128,59 @@ class HdrImage
   void set(const Index2d& index, const XyzColor& color) noexcept;
 
   //! Convert a sample table to a HDR image
+  template <bool kCompensated>
   void toHdr(System& system,
              const uint64 num_of_samples,
-             const zisc::pmr::vector<SpectralDistribution::SpectralDistributionPointer>& sample_table) noexcept;
+             const SpectralTable<kCompensated>& sample_table) noexcept;
+
+  //! Convert the pixels whose sample count changed to a HDR image
+  template <bool kCompensated>
+  void toHdr(System& system,
+             const zisc::pmr::vector<uint32>& sample_count_table,
+             const SpectralTable<kCompensated>& sample_table) noexcept;
+
+  //! Convert the image to the linear RGB colors of the color space
+  void toRgb(System& system,
+             zisc::pmr::vector<std::array<float, 3>>* rgb_buffer,
+             zisc::pmr::memory_resource* work_resource) const noexcept;
 
   //! Return the height resolution
   uint widthResolution() const noexcept;
 
+  //! Write the linear RGB colors into a PFM file
+  static bool writePfm(const zisc::pmr::vector<std::array<float, 3>>& rgb_buffer,
+                       const Index2d& resolution,
+                       const std::string& file_path) noexcept;
+
  private:
+  //! Return the sample count which means the pixel isn't converted yet
+  static constexpr uint32 invalidSampleCount() noexcept;
+
+  //! Convert the changed pixels of the tiles in the range to XYZ colors
+  template <bool kCompensated, typename Weight, typename Predicate>
+  void convertTiles(const System& system,
+                    const SpectralTable<kCompensated>& sample_table,
+                    const uint begin,
+                    const uint end,
+                    const Weight& weight,
+                    const Predicate& is_changed) noexcept;
+
+  //! Return the index of the tile which contains the pixel
+  uint getTileIndex(const uint x, const uint y) const noexcept;
+
   //! Initialize
   void initialize() noexcept;
 
+  //! Return the tile resolution
+  Index2d tileResolution() const noexcept;
+
   //! Convert a XY coordinate to a index
   uint toIndex(const uint x, const uint y) const noexcept;
 
 
   zisc::pmr::vector<XyzColor> buffer_;
+  zisc::pmr::vector<uint32> converted_count_; //!< The sample counts of the last conversion
+  zisc::pmr::vector<uint8> dirty_tile_;
   Index2d resolution_;
 };
 
@@ -26,6 +26,14 @@
 
 namespace nanairo {
 
+/*!
+  */
+inline
+auto LdrImage::channelOrder() const noexcept -> ChannelOrder
+{
+  return channel_order_;
+}
+
 /*!
   */
 inline
@@ -157,6 +165,14 @@ void LdrImage::set(const Index2d& index, const Rgba32 color) noexcept
   set(i, color);
 }
 
+/*!
+  */
+inline
+void LdrImage::setChannelOrder(const ChannelOrder order) noexcept
+{
+  channel_order_ = order;
+}
+
 /*!
   */
 inline
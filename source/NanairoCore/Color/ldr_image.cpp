@@ -14,10 +14,13 @@
 #include <vector>
 // Zisc
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/point.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "color_conversion.hpp"
+#include "rgb_color.hpp"
 #include "rgba_32.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 
@@ -28,7 +31,8 @@ namespace nanairo {
 LdrImage::LdrImage(const uint width,
                    const uint height,
                    zisc::pmr::memory_resource* data_resource) noexcept :
-    buffer_{data_resource}
+    buffer_{data_resource},
+    channel_order_{ChannelOrder::kBgra}
 {
   setResolution(width, height);
 }
@@ -37,11 +41,41 @@ LdrImage::LdrImage(const uint width,
   */
 LdrImage::LdrImage(const Index2d& resolution,
                    zisc::pmr::memory_resource* data_resource) noexcept :
-    buffer_{data_resource}
+    buffer_{data_resource},
+    channel_order_{ChannelOrder::kBgra}
 {
   setResolution(resolution);
 }
 
+/*!
+  \details
+  Each pixel is the average of the 2x2 pixels in the linear color space.
+  The pixels on the edges are repeated for the odd resolution.
+  */
+void LdrImage::downsample(const Float gamma, LdrImage* image) const noexcept
+{
+  ZISC_ASSERT(image != nullptr, "The image is null.");
+  const auto& r = resolution();
+  image->setResolution(zisc::max(r[0] >> 1, 1u), zisc::max(r[1] >> 1, 1u));
+
+  const Float inverse_gamma = zisc::invert(gamma);
+  for (uint y = 0; y < image->heightResolution(); ++y) {
+    for (uint x = 0; x < image->widthResolution(); ++x) {
+      RgbColor color{0.0, 0.0, 0.0};
+      for (uint i = 0; i < 4; ++i) {
+        const uint px = zisc::min(2 * x + (i & 1), r[0] - 1);
+        const uint py = zisc::min(2 * y + (i >> 1), r[1] - 1);
+        auto rgb = ColorConversion::toFloatRgb(get(px, py));
+        rgb.correctGamma(gamma);
+        for (uint c = 0; c < 3; ++c)
+          color[c] += 0.25 * rgb[c];
+      }
+      color.correctGamma(inverse_gamma);
+      image->set(x, y, ColorConversion::toIntRgb(color));
+    }
+  }
+}
+
 /*!
   */
 void LdrImage::fill(const Rgba32 color) noexcept
@@ -86,4 +120,21 @@ void LdrImage::setResolution(const Index2d& resolution) noexcept
   }
 }
 
+/*!
+  \details
+  Only the pointers of the buffers are exchanged,
+  so the images have to be allocated from the same memory resource.
+  */
+void LdrImage::swap(LdrImage& other) noexcept
+{
+  ZISC_ASSERT((resolution_[0] == other.resolution_[0]) &&
+              (resolution_[1] == other.resolution_[1]),
+              "The images have different resolutions.");
+  ZISC_ASSERT(channel_order_ == other.channel_order_,
+              "The images have different channel orders.");
+  ZISC_ASSERT(buffer_.get_allocator() == other.buffer_.get_allocator(),
+              "The images have different memory resources.");
+  buffer_.swap(other.buffer_);
+}
+
 } // namespace nanairo
@@ -27,10 +27,23 @@ namespace nanairo {
 //! \{
 
 /*!
+  \details
+  The channel order tells the byte order of the pixels in memory,
+  so an encoder reads the buffer without converting the pixels.
+  Only the tone mapping writes the pixels in the order,
+  the other functions treat the pixels as the native order.
   */
 class LdrImage
 {
  public:
+  //! The byte order of the channels of a pixel in memory
+  enum class ChannelOrder : uint8
+  {
+    kBgra = 0, //!< The native order of Rgba32, which QImage uses
+    kRgba //!< The order of PNG encoders
+  };
+
+
   //! Initialize as black image
   LdrImage(const uint width,
            const uint height,
@@ -48,12 +61,18 @@ class LdrImage
   const Rgba32& operator[](const uint index) const noexcept;
 
 
+  //! Return the byte order of the channels
+  ChannelOrder channelOrder() const noexcept;
+
   //! Return the buffer data
   zisc::pmr::vector<Rgba32>& data() noexcept;
 
   //! Return the buffer data
   const zisc::pmr::vector<Rgba32>& data() const noexcept;
 
+  //! Make the image of the half resolution
+  void downsample(const Float gamma, LdrImage* image) const noexcept;
+
   //! Fill the image by the color
   void fill(const Rgba32 color) noexcept;
 
@@ -93,6 +112,9 @@ class LdrImage
   //! Set the color
   void set(const Index2d& index, const Rgba32 color) noexcept;
 
+  //! Set the byte order of the channels
+  void setChannelOrder(const ChannelOrder order) noexcept;
+
   //! Return the num of pixels 
   uint size() const noexcept;
 
@@ -102,6 +124,9 @@ class LdrImage
   //! Set the image resolution and initialize image as black image
   void setResolution(const Index2d& resolution) noexcept;
 
+  //! Exchange the buffers of the images of the same layout
+  void swap(LdrImage& other) noexcept;
+
   //! Return the width resolution
   uint widthResolution() const noexcept;
 
@@ -112,6 +137,7 @@ class LdrImage
 
   zisc::pmr::vector<Rgba32> buffer_;
   Index2d resolution_;
+  ChannelOrder channel_order_;
 };
 
 //! \} Core
@@ -0,0 +1,43 @@
+/*!
+  \file rgb_spectra_table-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RGB_SPECTRA_TABLE_INL_HPP
+#define NANAIRO_RGB_SPECTRA_TABLE_INL_HPP
+
+#include "rgb_spectra_table.hpp"
+// Standard C++ library
+#include <cstddef>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr uint RgbSpectraTable::gridResolution() noexcept
+{
+  return 17;
+}
+
+/*!
+  */
+inline
+constexpr std::size_t RgbSpectraTable::getIndex(const uint r,
+                                                const uint g,
+                                                const uint b) noexcept
+{
+  constexpr std::size_t n = gridResolution();
+  const std::size_t index = ((r * n + g) * n + b) * CoreConfig::spectraSize();
+  return index;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_RGB_SPECTRA_TABLE_INL_HPP
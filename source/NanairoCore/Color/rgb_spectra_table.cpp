@@ -0,0 +1,117 @@
+/*!
+  \file rgb_spectra_table.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "rgb_spectra_table.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "color_conversion.hpp"
+#include "color_space.hpp"
+#include "rgb_color.hpp"
+#include "spectral_transport.hpp"
+#include "xyz_color.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Color/SpectralDistribution/spectral_distribution_spectra.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+RgbSpectraTable::RgbSpectraTable(const System& system,
+                                 zisc::pmr::memory_resource* data_resource,
+                                 zisc::pmr::memory_resource* work_resource) noexcept :
+    table_{data_resource}
+{
+  initialize(system, work_resource);
+}
+
+/*!
+  */
+void RgbSpectraTable::toSpectra(const RgbColor& rgb,
+                                SpectralDistribution* spectra) const noexcept
+{
+  using zisc::cast;
+  ZISC_ASSERT(spectra != nullptr, "The spectra is null.");
+
+  const Float m = zisc::max(rgb.red(), zisc::max(rgb.green(), rgb.blue()));
+  if (m <= 0.0) {
+    for (uint i = 0; i < spectra->size(); ++i)
+      spectra->set(i, 0.0);
+    return;
+  }
+
+  // Find the cell of the normalized color
+  constexpr uint n = gridResolution();
+  const Float inv_m = zisc::invert(m);
+  std::array<uint, 3> p0;
+  std::array<Float, 3> t;
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float x = zisc::clamp(rgb[axis] * inv_m, 0.0, 1.0) * cast<Float>(n - 1);
+    p0[axis] = zisc::min(cast<uint>(x), n - 2);
+    t[axis] = x - cast<Float>(p0[axis]);
+  }
+
+  // Interpolate the spectra of the corners
+  for (uint i = 0; i < spectra->size(); ++i)
+    spectra->set(i, 0.0);
+  for (uint corner = 0; corner < 8; ++corner) {
+    const uint r = p0[0] + ((corner >> 2) & 1);
+    const uint g = p0[1] + ((corner >> 1) & 1);
+    const uint b = p0[2] + (corner & 1);
+    const Float w = m *
+        (((corner >> 2) & 1) ? t[0] : 1.0 - t[0]) *
+        (((corner >> 1) & 1) ? t[1] : 1.0 - t[1]) *
+        ((corner & 1) ? t[2] : 1.0 - t[2]);
+    const Float* values = &table_[getIndex(r, g, b)];
+    for (uint i = 0; i < spectra->size(); ++i)
+      spectra->set(i, (*spectra)[i] + w * values[i]);
+  }
+}
+
+/*!
+  \details
+  The table has the spectra of 17^3 colors, which are calculated once
+  and shared by all textures.
+  */
+void RgbSpectraTable::initialize(const System& system,
+                                 zisc::pmr::memory_resource* work_resource) noexcept
+{
+  using zisc::cast;
+  constexpr uint n = gridResolution();
+  table_.resize(getIndex(n, 0, 0), 0.0);
+
+  const auto to_xyz_matrix = getRgbToXyzMatrix(system.colorSpace());
+  const Float k = zisc::invert(cast<Float>(n - 1));
+  SpectraDistribution spectra;
+  for (uint r = 0; r < n; ++r) {
+    for (uint g = 0; g < n; ++g) {
+      for (uint b = 0; b < n; ++b) {
+        const RgbColor rgb{k * cast<Float>(r), k * cast<Float>(g), k * cast<Float>(b)};
+        const auto xyz = ColorConversion::toXyz(rgb, to_xyz_matrix);
+        for (uint i = 0; i < spectra.size(); ++i)
+          spectra.set(i, 0.0);
+        SpectralTransport::toSpectra(xyz, &spectra, work_resource);
+        Float* values = &table_[getIndex(r, g, b)];
+        for (uint i = 0; i < spectra.size(); ++i)
+          values[i] = spectra[i];
+      }
+    }
+  }
+}
+
+} // namespace nanairo
@@ -0,0 +1,75 @@
+/*!
+  \file rgb_spectra_table.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RGB_SPECTRA_TABLE_HPP
+#define NANAIRO_RGB_SPECTRA_TABLE_HPP
+
+// Standard C++ library
+#include <cstddef>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class RgbColor;
+class SpectralDistribution;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A lookup table from linear RGB to spectra
+  \details
+  The spectra of the RGB grid points in [0, 1]^3 are precomputed by
+  the spectral transport, and a color is converted by
+  the trilinear interpolation of the spectra of the surrounding points.
+  The spectral transport is proportional to the brightness,
+  so a color is normalized by its max component before the lookup.
+  */
+class RgbSpectraTable
+{
+ public:
+  //! Make the table of the color space of the system
+  RgbSpectraTable(const System& system,
+                  zisc::pmr::memory_resource* data_resource,
+                  zisc::pmr::memory_resource* work_resource) noexcept;
+
+
+  //! Return the number of the grid points of an axis
+  static constexpr uint gridResolution() noexcept;
+
+  //! Convert a linear RGB color to spectra
+  void toSpectra(const RgbColor& rgb, SpectralDistribution* spectra) const noexcept;
+
+ private:
+  //! Return the index of the first spectrum of the grid point
+  static constexpr std::size_t getIndex(const uint r,
+                                        const uint g,
+                                        const uint b) noexcept;
+
+  //! Initialize the table
+  void initialize(const System& system,
+                  zisc::pmr::memory_resource* work_resource) noexcept;
+
+
+  zisc::pmr::vector<Float> table_; //!< [r][g][b][wavelength]
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "rgb_spectra_table-inl.hpp"
+
+#endif // NANAIRO_RGB_SPECTRA_TABLE_HPP
@@ -0,0 +1,100 @@
+/*!
+  \file sigmoid_spectrum-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SIGMOID_SPECTRUM_INL_HPP
+#define NANAIRO_SIGMOID_SPECTRUM_INL_HPP
+
+#include "sigmoid_spectrum.hpp"
+// Standard C++ library
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The constant term is -inf, so the spectrum is zero at all wavelengths.
+  */
+inline
+SigmoidSpectrum::SigmoidSpectrum() noexcept :
+    coefficients_{{0.0, 0.0, -std::numeric_limits<Float>::infinity()}}
+{
+}
+
+/*!
+  */
+inline
+SigmoidSpectrum::SigmoidSpectrum(const Float c0,
+                                 const Float c1,
+                                 const Float c2) noexcept :
+    coefficients_{{c0, c1, c2}}
+{
+}
+
+/*!
+  */
+inline
+const std::array<Float, 3>& SigmoidSpectrum::coefficients() const noexcept
+{
+  return coefficients_;
+}
+
+/*!
+  */
+inline
+Float SigmoidSpectrum::evaluate(const uint16 wavelength) const noexcept
+{
+  const Float u = toParameter(wavelength);
+  const Float x = (coefficients_[0] * u + coefficients_[1]) * u + coefficients_[2];
+  return sigmoid(x);
+}
+
+/*!
+  */
+inline
+SampledSpectra SigmoidSpectrum::evaluate(
+    const WavelengthSamples& wavelengths) const noexcept
+{
+  IntensitySamples intensities;
+  for (uint index = 0; index < SampledSpectra::size(); ++index)
+    intensities.set(index, evaluate(wavelengths[index]));
+  return SampledSpectra{wavelengths, intensities};
+}
+
+/*!
+  */
+inline
+Float SigmoidSpectrum::sigmoid(const Float x) noexcept
+{
+  const Float s = std::isinf(x)
+      ? ((0.0 < x) ? 1.0 : 0.0)
+      : 0.5 + x / (2.0 * std::sqrt(1.0 + x * x));
+  return s;
+}
+
+/*!
+  */
+inline
+constexpr Float SigmoidSpectrum::toParameter(const uint16 wavelength) noexcept
+{
+  constexpr Float k = 1.0 / zisc::cast<Float>(CoreConfig::longestWavelength() -
+                                              CoreConfig::shortestWavelength());
+  const Float u = k * zisc::cast<Float>(wavelength - CoreConfig::shortestWavelength());
+  return u;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SIGMOID_SPECTRUM_INL_HPP
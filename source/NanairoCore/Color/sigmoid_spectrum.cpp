@@ -0,0 +1,88 @@
+/*!
+  \file sigmoid_spectrum.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "sigmoid_spectrum.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+// Zisc
+#include "zisc/compensated_summation.hpp"
+#include "zisc/math.hpp"
+#include "zisc/matrix.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Utility/value.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The intensities are clamped into (0, 1) and transformed by
+  the inverse of the sigmoid, then the polynomial is fitted to them by
+  the weighted linear least squares. The weight is the square of
+  the derivative of the sigmoid, so the residuals approximate
+  the residuals of the intensities and the saturated wavelengths have
+  less influence. The fitting is done in a single pass without iterations.
+  */
+SigmoidSpectrum SigmoidSpectrum::fit(const SpectralDistribution& spectra) noexcept
+{
+  using zisc::cast;
+  constexpr Float epsilon = 1.0e-3;
+
+  const Float max_intensity = spectra.max();
+  if (max_intensity <= 0.0)
+    return SigmoidSpectrum{};
+
+  // Calculate the max weight for the normalization
+  Float max_weight = 0.0;
+  for (uint i = 0; i < spectra.size(); ++i) {
+    const Float t = zisc::clamp(spectra[i], epsilon, 1.0 - epsilon);
+    const Float d = t * (1.0 - t);
+    max_weight = zisc::max(max_weight, d * d * d);
+  }
+  const Float inv_max_weight = zisc::invert(max_weight);
+
+  // Make the normal equation
+  std::array<Float, 5> s{{0.0, 0.0, 0.0, 0.0, 0.0}};
+  std::array<Float, 3> b{{0.0, 0.0, 0.0}};
+  for (uint i = 0; i < spectra.size(); ++i) {
+    const Float t = zisc::clamp(spectra[i], epsilon, 1.0 - epsilon);
+    const Float d = t * (1.0 - t);
+    const Float x = (2.0 * t - 1.0) / (2.0 * std::sqrt(d));
+    const Float w = zisc::max(d * d * d * inv_max_weight, epsilon);
+    const Float u = toParameter(spectra.getWavelength(i));
+    Float p = w;
+    for (uint j = 0; j < 5; ++j) {
+      s[j] += p;
+      if (j < 3)
+        b[2 - j] += p * x;
+      p *= u;
+    }
+  }
+  const zisc::Matrix<Float, 3, 3> a{s[4], s[3], s[2],
+                                    s[3], s[2], s[1],
+                                    s[2], s[1], s[0]};
+  const zisc::Matrix<Float, 3, 1> v{b[0], b[1], b[2]};
+  const auto c = a.inverseMatrix() * v;
+  return SigmoidSpectrum{c(0, 0), c(1, 0), c(2, 0)};
+}
+
+/*!
+  */
+Float SigmoidSpectrum::sum() const noexcept
+{
+  zisc::CompensatedSummation<Float> s{0.0};
+  for (uint i = 0; i < CoreConfig::spectraSize(); ++i)
+    s.add(evaluate(getWavelength(i)));
+  return s.get();
+}
+
+} // namespace nanairo
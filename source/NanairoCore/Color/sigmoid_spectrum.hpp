@@ -0,0 +1,78 @@
+/*!
+  \file sigmoid_spectrum.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SIGMOID_SPECTRUM_HPP
+#define NANAIRO_SIGMOID_SPECTRUM_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class SampledSpectra;
+class SpectralDistribution;
+class WavelengthSamples;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A spectrum which is represented by three coefficients
+  \details
+  The spectrum is a sigmoid of a quadratic polynomial of the wavelength,
+  s(x) = 1/2 + x / (2 sqrt(1 + x^2)), x = c0 u^2 + c1 u + c2,
+  where u is the wavelength normalized into [0, 1].
+  The spectrum is bounded in [0, 1], so it is suitable for reflectances.
+  */
+class SigmoidSpectrum
+{
+ public:
+  //! Create a zero spectrum
+  SigmoidSpectrum() noexcept;
+
+  //! Create a spectrum by the coefficients
+  SigmoidSpectrum(const Float c0, const Float c1, const Float c2) noexcept;
+
+
+  //! Return the coefficients of the polynomial
+  const std::array<Float, 3>& coefficients() const noexcept;
+
+  //! Evaluate the spectrum at the wavelength
+  Float evaluate(const uint16 wavelength) const noexcept;
+
+  //! Evaluate the spectrum at the wavelength samples
+  SampledSpectra evaluate(const WavelengthSamples& wavelengths) const noexcept;
+
+  //! Fit the coefficients to the spectra
+  static SigmoidSpectrum fit(const SpectralDistribution& spectra) noexcept;
+
+  //! Return the sum of the spectrum at all wavelengths
+  Float sum() const noexcept;
+
+ private:
+  //! Return the sigmoid of the value
+  static Float sigmoid(const Float x) noexcept;
+
+  //! Return the normalized wavelength
+  static constexpr Float toParameter(const uint16 wavelength) noexcept;
+
+
+  std::array<Float, 3> coefficients_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "sigmoid_spectrum-inl.hpp"
+
+#endif // NANAIRO_SIGMOID_SPECTRUM_HPP
@@ -0,0 +1,238 @@
+/*!
+  \file spectral_count_table-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPECTRAL_COUNT_TABLE_INL_HPP
+#define NANAIRO_SPECTRAL_COUNT_TABLE_INL_HPP
+
+#include "spectral_count_table.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+// Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+SpectralCountTable::SpectralCountTable(
+    zisc::pmr::memory_resource* data_resource) noexcept :
+        data_resource_{data_resource},
+        data_{nullptr},
+        num_of_values_{0},
+        color_mode_{RenderingColorMode::kRgb},
+        num_of_bins_{0}
+{
+}
+
+/*!
+  */
+inline
+SpectralCountTable::~SpectralCountTable() noexcept
+{
+  release();
+}
+
+/*!
+  */
+inline
+void SpectralCountTable::add(const std::size_t row,
+                             const uint index,
+                             const DataType count) noexcept
+{
+  data_[getDataIndex(row, index)] += count;
+}
+
+/*!
+  \details
+  A bin overflows after 2^24 samples of the full weight.
+  */
+inline
+constexpr auto SpectralCountTable::countResolution() noexcept -> DataType
+{
+  return 256;
+}
+
+/*!
+  */
+inline
+void SpectralCountTable::clear(const std::size_t begin,
+                               const std::size_t end) noexcept
+{
+  ZISC_ASSERT((begin <= end) && (end <= numOfRows()), "The rows are out of range.");
+  std::fill(data_ + begin * numOfBins(), data_ + end * numOfBins(), 0u);
+}
+
+/*!
+  */
+inline
+auto SpectralCountTable::count(const std::size_t row,
+                               const uint index) const noexcept -> DataType
+{
+  return data_[getDataIndex(row, index)];
+}
+
+/*!
+  */
+inline
+auto SpectralCountTable::data() const noexcept -> const DataType*
+{
+  return data_;
+}
+
+/*!
+  */
+inline
+Float SpectralCountTable::get(const std::size_t row,
+                              const uint index) const noexcept
+{
+  constexpr Float k = 1.0 / zisc::cast<Float>(countResolution());
+  return k * zisc::cast<Float>(count(row, index));
+}
+
+/*!
+  \details
+  The same mapping as the RGB distribution and the spectra distribution.
+  */
+inline
+uint SpectralCountTable::getIndex(const uint16 wavelength) const noexcept
+{
+  const uint index = (color_mode_ == RenderingColorMode::kSpectra)
+      ? zisc::cast<uint>(wavelength - CoreConfig::shortestWavelength()) /
+          CoreConfig::wavelengthResolution() :
+      (wavelength == CoreConfig::blueWavelength()) ? 0 :
+      (wavelength == CoreConfig::greenWavelength()) ? 1
+                                                    : 2;
+  return index;
+}
+
+/*!
+  \details
+  The values are left unwritten, so the pages aren't committed
+  until the rows are cleared. The storage is kept if the size is the same.
+  */
+inline
+void SpectralCountTable::initialize(const RenderingColorMode color_mode,
+                                    const std::size_t num_of_rows) noexcept
+{
+  color_mode_ = color_mode;
+  num_of_bins_ = (color_mode_ == RenderingColorMode::kSpectra)
+      ? CoreConfig::spectraSize()
+      : 3;
+  const std::size_t num_of_values = num_of_rows * num_of_bins_;
+  if (num_of_values != num_of_values_) {
+    release();
+    if (0 < num_of_values) {
+      void* data = data_resource_->allocate(num_of_values * sizeof(DataType),
+                                            alignof(DataType));
+      data_ = static_cast<DataType*>(data);
+      num_of_values_ = num_of_values;
+    }
+  }
+}
+
+/*!
+  */
+inline
+bool SpectralCountTable::isEmpty() const noexcept
+{
+  return num_of_values_ == 0;
+}
+
+/*!
+  */
+inline
+uint SpectralCountTable::numOfBins() const noexcept
+{
+  return num_of_bins_;
+}
+
+/*!
+  */
+inline
+std::size_t SpectralCountTable::numOfRows() const noexcept
+{
+  return (0 < num_of_bins_) ? num_of_values_ / num_of_bins_ : 0;
+}
+
+/*!
+  \details
+  The table has to be initialized with the same shape as the written table.
+  No value is changed if the shape is different.
+  */
+inline
+bool SpectralCountTable::readData(std::istream* data_stream) noexcept
+{
+  uint64 num_of_values = 0;
+  zisc::read(&num_of_values, data_stream);
+  const bool result = data_stream->good() && (num_of_values == num_of_values_);
+  if (result)
+    zisc::read(data_, data_stream, num_of_values_ * sizeof(DataType));
+  return result && data_stream->good();
+}
+
+/*!
+  */
+inline
+auto SpectralCountTable::toCount(const Float weight) noexcept -> DataType
+{
+  ZISC_ASSERT(zisc::isInClosedBounds(weight, 0.0, 1.0),
+              "The weight is out of bounds.");
+  const Float c = weight * zisc::cast<Float>(countResolution()) + 0.5;
+  return zisc::cast<DataType>(c);
+}
+
+/*!
+  */
+inline
+void SpectralCountTable::writeData(std::ostream* data_stream) const noexcept
+{
+  const uint64 num_of_values = zisc::cast<uint64>(num_of_values_);
+  zisc::write(&num_of_values, data_stream);
+  zisc::write(data_, data_stream, num_of_values_ * sizeof(DataType));
+}
+
+/*!
+  */
+inline
+std::size_t SpectralCountTable::getDataIndex(const std::size_t row,
+                                             const uint index) const noexcept
+{
+  ZISC_ASSERT(index < numOfBins(), "The index is out of range.");
+  const std::size_t i = row * numOfBins() + index;
+  ZISC_ASSERT(i < num_of_values_, "The row is out of range.");
+  return i;
+}
+
+/*!
+  */
+inline
+void SpectralCountTable::release() noexcept
+{
+  if (data_ != nullptr) {
+    data_resource_->deallocate(data_,
+                               num_of_values_ * sizeof(DataType),
+                               alignof(DataType));
+    data_ = nullptr;
+    num_of_values_ = 0;
+  }
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SPECTRAL_COUNT_TABLE_INL_HPP
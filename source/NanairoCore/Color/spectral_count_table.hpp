@@ -0,0 +1,116 @@
+/*!
+  \file spectral_count_table.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPECTRAL_COUNT_TABLE_HPP
+#define NANAIRO_SPECTRAL_COUNT_TABLE_HPP
+
+// Standard C++ library
+#include <cstddef>
+#include <istream>
+#include <ostream>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A table of spectral sample counts of pixels in a contiguous array
+  \details
+  The rows and the bins are laid out in the same way as the SpectralTable.
+  A count is a fixed-point weight of 32 bits which has the fraction bits of
+  countResolution(), so the weights of the multiples of the resolution
+  are summed up exactly. The counts are converted to Float when read.
+  The storage is allocated without writing the values,
+  so the pages are first touched by the threads which fill the rows.
+  */
+class SpectralCountTable : public zisc::NonCopyable<SpectralCountTable>
+{
+ public:
+  using DataType = uint32;
+
+
+  //! Create an empty table
+  SpectralCountTable(zisc::pmr::memory_resource* data_resource) noexcept;
+
+  //! Deallocate the storage
+  ~SpectralCountTable() noexcept;
+
+
+  //! Add a fixed-point count to the bin of the row
+  void add(const std::size_t row, const uint index, const DataType count) noexcept;
+
+  //! Return the fixed-point count of the value of one
+  static constexpr DataType countResolution() noexcept;
+
+  //! Fill the values of the rows [begin, end) by zero
+  void clear(const std::size_t begin, const std::size_t end) noexcept;
+
+  //! Return the fixed-point count of the bin of the row
+  DataType count(const std::size_t row, const uint index) const noexcept;
+
+  //! Return the pointer to the data
+  const DataType* data() const noexcept;
+
+  //! Return the weight of the bin of the row
+  Float get(const std::size_t row, const uint index) const noexcept;
+
+  //! Return the bin index correspond to the given wavelength
+  uint getIndex(const uint16 wavelength) const noexcept;
+
+  //! Allocate the rows of the table, the values have to be cleared before use
+  void initialize(const RenderingColorMode color_mode,
+                  const std::size_t num_of_rows) noexcept;
+
+  //! Check if the table has no value
+  bool isEmpty() const noexcept;
+
+  //! Return the number of bins of a row
+  uint numOfBins() const noexcept;
+
+  //! Return the number of rows
+  std::size_t numOfRows() const noexcept;
+
+  //! Read the values from the stream
+  bool readData(std::istream* data_stream) noexcept;
+
+  //! Convert a weight in [0, 1] to the nearest fixed-point count
+  static DataType toCount(const Float weight) noexcept;
+
+  //! Write the values to the stream
+  void writeData(std::ostream* data_stream) const noexcept;
+
+ private:
+  //! Return the index of the value of the bin of the row
+  std::size_t getDataIndex(const std::size_t row, const uint index) const noexcept;
+
+  //! Deallocate the storage
+  void release() noexcept;
+
+
+  zisc::pmr::memory_resource* data_resource_;
+  DataType* data_;
+  std::size_t num_of_values_;
+  RenderingColorMode color_mode_;
+  uint num_of_bins_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "spectral_count_table-inl.hpp"
+
+#endif // NANAIRO_SPECTRAL_COUNT_TABLE_HPP
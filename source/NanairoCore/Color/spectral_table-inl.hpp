@@ -0,0 +1,271 @@
+/*!
+  \file spectral_table-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPECTRAL_TABLE_INL_HPP
+#define NANAIRO_SPECTRAL_TABLE_INL_HPP
+
+#include "spectral_table.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+// Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <bool kCompensated> inline
+SpectralTable<kCompensated>::SpectralTable(
+    zisc::pmr::memory_resource* data_resource) noexcept :
+        data_resource_{data_resource},
+        data_{nullptr},
+        num_of_values_{0},
+        color_mode_{RenderingColorMode::kRgb},
+        num_of_bins_{0}
+{
+  static_assert(std::is_trivially_copyable_v<DataType>,
+                "The values of the table aren't trivially copyable.");
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+SpectralTable<kCompensated>::~SpectralTable() noexcept
+{
+  release();
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::add(const std::size_t row,
+                                      const uint index,
+                                      const Float value) noexcept
+{
+  auto& data = data_[getDataIndex(row, index)];
+  const FilmFloat v = zisc::cast<FilmFloat>(value);
+  if constexpr (kCompensated)
+    data.add(v);
+  else
+    data += v;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::copyTo(
+    const std::size_t row,
+    SpectralDistribution* distribution) const noexcept
+{
+  ZISC_ASSERT(distribution->size() == numOfBins(),
+              "The size of the distribution doesn't match the bins.");
+  for (uint index = 0; index < numOfBins(); ++index)
+    distribution->set(index, get(row, index));
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+auto SpectralTable<kCompensated>::data() noexcept -> DataType*
+{
+  return data_;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+auto SpectralTable<kCompensated>::data() const noexcept -> const DataType*
+{
+  return data_;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::fill(const Float value) noexcept
+{
+  const DataType v{zisc::cast<FilmFloat>(value)};
+  std::fill_n(data_, num_of_values_, v);
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::fill(const std::size_t begin,
+                                       const std::size_t end,
+                                       const Float value) noexcept
+{
+  ZISC_ASSERT((begin <= end) && (end <= numOfRows()), "The rows are out of range.");
+  const DataType v{zisc::cast<FilmFloat>(value)};
+  std::fill(data_ + begin * numOfBins(), data_ + end * numOfBins(), v);
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+Float SpectralTable<kCompensated>::get(const std::size_t row,
+                                       const uint index) const noexcept
+{
+  const auto& data = data_[getDataIndex(row, index)];
+  if constexpr (kCompensated)
+    return zisc::cast<Float>(data.get());
+  else
+    return zisc::cast<Float>(data);
+}
+
+/*!
+  \details
+  The same mapping as the RGB distribution and the spectra distribution.
+  */
+template <bool kCompensated> inline
+uint SpectralTable<kCompensated>::getIndex(const uint16 wavelength) const
+    noexcept
+{
+  const uint index = (color_mode_ == RenderingColorMode::kSpectra)
+      ? zisc::cast<uint>(wavelength - CoreConfig::shortestWavelength()) /
+          CoreConfig::wavelengthResolution() :
+      (wavelength == CoreConfig::blueWavelength()) ? 0 :
+      (wavelength == CoreConfig::greenWavelength()) ? 1
+                                                    : 2;
+  return index;
+}
+
+/*!
+  \details
+  The values are left unwritten, so the pages aren't committed
+  until the rows are filled. The storage is kept if the size is the same.
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::initialize(
+    const RenderingColorMode color_mode,
+    const std::size_t num_of_rows) noexcept
+{
+  color_mode_ = color_mode;
+  num_of_bins_ = (color_mode_ == RenderingColorMode::kSpectra)
+      ? CoreConfig::spectraSize()
+      : 3;
+  const std::size_t num_of_values = num_of_rows * num_of_bins_;
+  if (num_of_values != num_of_values_) {
+    release();
+    if (0 < num_of_values) {
+      void* data = data_resource_->allocate(num_of_values * sizeof(DataType),
+                                            alignof(DataType));
+      data_ = static_cast<DataType*>(data);
+      num_of_values_ = num_of_values;
+    }
+  }
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+bool SpectralTable<kCompensated>::isEmpty() const noexcept
+{
+  return num_of_values_ == 0;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+uint SpectralTable<kCompensated>::numOfBins() const noexcept
+{
+  return num_of_bins_;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+std::size_t SpectralTable<kCompensated>::numOfRows() const noexcept
+{
+  return (0 < num_of_bins_) ? num_of_values_ / num_of_bins_ : 0;
+}
+
+/*!
+  \details
+  The table has to be initialized with the same shape as the written table.
+  No value is changed if the shape is different.
+  */
+template <bool kCompensated> inline
+bool SpectralTable<kCompensated>::readData(std::istream* data_stream) noexcept
+{
+  uint64 num_of_values = 0;
+  zisc::read(&num_of_values, data_stream);
+  const bool result = data_stream->good() && (num_of_values == num_of_values_);
+  if (result)
+    zisc::read(data_, data_stream, num_of_values_ * sizeof(DataType));
+  return result && data_stream->good();
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::set(const std::size_t row,
+                                      const uint index,
+                                      const Float value) noexcept
+{
+  auto& data = data_[getDataIndex(row, index)];
+  const FilmFloat v = zisc::cast<FilmFloat>(value);
+  if constexpr (kCompensated)
+    data.set(v);
+  else
+    data = v;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::writeData(
+    std::ostream* data_stream) const noexcept
+{
+  const uint64 num_of_values = zisc::cast<uint64>(num_of_values_);
+  zisc::write(&num_of_values, data_stream);
+  zisc::write(data_, data_stream, num_of_values_ * sizeof(DataType));
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+std::size_t SpectralTable<kCompensated>::getDataIndex(
+    const std::size_t row,
+    const uint index) const noexcept
+{
+  ZISC_ASSERT(index < numOfBins(), "The index is out of range.");
+  const std::size_t i = row * numOfBins() + index;
+  ZISC_ASSERT(i < num_of_values_, "The row is out of range.");
+  return i;
+}
+
+/*!
+  */
+template <bool kCompensated> inline
+void SpectralTable<kCompensated>::release() noexcept
+{
+  if (data_ != nullptr) {
+    data_resource_->deallocate(data_,
+                               num_of_values_ * sizeof(DataType),
+                               alignof(DataType));
+    data_ = nullptr;
+    num_of_values_ = 0;
+  }
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SPECTRAL_TABLE_INL_HPP
@@ -0,0 +1,138 @@
+/*!
+  \file spectral_table.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SPECTRAL_TABLE_HPP
+#define NANAIRO_SPECTRAL_TABLE_HPP
+
+// Standard C++ library
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+// Zisc
+#include "zisc/compensated_summation.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class SpectralDistribution;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A table of spectral values of pixels in a contiguous array
+  \details
+  The values are stored in [row][bin] order, where a row is a pixel
+  (or a histogram bin of a pixel) and a bin is a RGB component or
+  a wavelength of spectra. The bins are indexed in the same way as
+  the spectral distributions of the color mode.
+  The values are stored in FilmFloat and are promoted to Float when read.
+  A compensated table keeps the rounding error of the sums,
+  so the precision of a float film holds over many cycles.
+  The storage is allocated without writing the values,
+  so the pages are first touched by the threads which fill the rows.
+  */
+template <bool kCompensated>
+class SpectralTable : public zisc::NonCopyable<SpectralTable<kCompensated>>
+{
+ public:
+  using DataType = std::conditional_t<kCompensated,
+                                      zisc::CompensatedSummation<FilmFloat>,
+                                      FilmFloat>;
+
+
+  //! Create an empty table
+  SpectralTable(zisc::pmr::memory_resource* data_resource) noexcept;
+
+  //! Deallocate the storage
+  ~SpectralTable() noexcept;
+
+
+  //! Add a value to the bin of the row
+  void add(const std::size_t row, const uint index, const Float value) noexcept;
+
+  //! Copy the values of the row into the distribution
+  void copyTo(const std::size_t row,
+              SpectralDistribution* distribution) const noexcept;
+
+  //! Return the pointer to the data
+  DataType* data() noexcept;
+
+  //! Return the pointer to the data
+  const DataType* data() const noexcept;
+
+  //! Fill all values by the value
+  void fill(const Float value) noexcept;
+
+  //! Fill the values of the rows [begin, end) by the value
+  void fill(const std::size_t begin,
+            const std::size_t end,
+            const Float value) noexcept;
+
+  //! Return the value of the bin of the row
+  Float get(const std::size_t row, const uint index) const noexcept;
+
+  //! Return the bin index correspond to the given wavelength
+  uint getIndex(const uint16 wavelength) const noexcept;
+
+  //! Allocate the rows of the table, the values have to be filled before use
+  void initialize(const RenderingColorMode color_mode,
+                  const std::size_t num_of_rows) noexcept;
+
+  //! Check if the table has no value
+  bool isEmpty() const noexcept;
+
+  //! Return the number of bins of a row
+  uint numOfBins() const noexcept;
+
+  //! Return the number of rows
+  std::size_t numOfRows() const noexcept;
+
+  //! Read the values from the stream
+  bool readData(std::istream* data_stream) noexcept;
+
+  //! Set a value of the bin of the row
+  void set(const std::size_t row, const uint index, const Float value) noexcept;
+
+  //! Write the values to the stream
+  void writeData(std::ostream* data_stream) const noexcept;
+
+ private:
+  //! Return the index of the value of the bin of the row
+  std::size_t getDataIndex(const std::size_t row, const uint index) const noexcept;
+
+  //! Deallocate the storage
+  void release() noexcept;
+
+
+  zisc::pmr::memory_resource* data_resource_;
+  DataType* data_;
+  std::size_t num_of_values_;
+  RenderingColorMode color_mode_;
+  uint num_of_bins_;
+};
+
+// Type aliases
+using SpectralValueTable = SpectralTable<false>;
+using CompensatedSpectralValueTable = SpectralTable<true>;
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "spectral_table-inl.hpp"
+
+#endif // NANAIRO_SPECTRAL_TABLE_HPP
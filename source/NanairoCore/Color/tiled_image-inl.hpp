@@ -0,0 +1,80 @@
+/*!
+  \file tiled_image-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TILED_IMAGE_INL_HPP
+#define NANAIRO_TILED_IMAGE_INL_HPP
+
+#include "tiled_image.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr const char* TiledImage::fileExtension() noexcept
+{
+  return ".ntx";
+}
+
+/*!
+  */
+inline
+uint TiledImage::numOfLevels() const noexcept
+{
+  return zisc::cast<uint>(resolution_list_.size());
+}
+
+/*!
+  */
+inline
+Index2d TiledImage::numOfTiles(const uint level) const noexcept
+{
+  const auto& r = resolution(level);
+  return Index2d{(r[0] + tileSide() - 1) / tileSide(),
+                 (r[1] + tileSide() - 1) / tileSide()};
+}
+
+/*!
+  */
+inline
+const Index2d& TiledImage::resolution(const uint level) const noexcept
+{
+  ZISC_ASSERT(level < numOfLevels(), "The level is out of range.");
+  return resolution_list_[level];
+}
+
+/*!
+  */
+inline
+uint TiledImage::tileIndex(const uint level,
+                           const uint tile_x,
+                           const uint tile_y) const noexcept
+{
+  const auto num_of_tiles = numOfTiles(level);
+  return tile_offset_list_[level] + tile_x + tile_y * num_of_tiles[0];
+}
+
+/*!
+  \details
+  A tile of 64x64 pixels is 16 KiB, which is large enough for a bulk read.
+  */
+inline
+constexpr uint TiledImage::tileSide() noexcept
+{
+  return 64;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TILED_IMAGE_INL_HPP
@@ -0,0 +1,233 @@
+/*!
+  \file tiled_image.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "tiled_image.hpp"
+// Standard C++ library
+#include <array>
+#include <fstream>
+#include <ios>
+#include <mutex>
+#include <string>
+#include <utility>
+// Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "ldr_image.hpp"
+#include "rgba_32.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr uint32 TiledImage::magicNumber() noexcept
+{
+  return zisc::Fnv1aHash32::hash("NanairoTiledImage");
+}
+
+/*!
+  \details
+  The version has to be updated when the file layout or the filter of
+  the levels changes.
+  */
+inline
+constexpr uint32 TiledImage::version() noexcept
+{
+  return 1;
+}
+
+/*!
+  */
+TiledImage::TiledImage(zisc::pmr::memory_resource* data_resource) noexcept :
+    resolution_list_{data_resource},
+    tile_offset_list_{data_resource},
+    data_offset_{0}
+{
+}
+
+/*!
+  */
+bool TiledImage::isValidFile(
+    const std::string& file_path,
+    const Float gamma,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  std::ifstream file{file_path, std::ios::binary};
+  if (!file.is_open())
+    return false;
+  zisc::pmr::vector<Index2d> resolution_list{work_resource};
+  return readHeader(&file, gamma, &resolution_list);
+}
+
+/*!
+  \details
+  The file stays open until the image is destroyed,
+  so the tiles can be read without opening the file every time.
+  */
+bool TiledImage::open(const std::string& file_path, const Float gamma) noexcept
+{
+  file_.open(file_path, std::ios::binary);
+  if (!file_.is_open())
+    return false;
+  if (!readHeader(&file_, gamma, &resolution_list_))
+    return false;
+  data_offset_ = file_.tellg();
+
+  // The offset of the first tile of each level
+  tile_offset_list_.resize(numOfLevels());
+  uint num_of_tiles = 0;
+  for (uint level = 0; level < numOfLevels(); ++level) {
+    tile_offset_list_[level] = num_of_tiles;
+    const auto n = numOfTiles(level);
+    num_of_tiles += n[0] * n[1];
+  }
+  return true;
+}
+
+/*!
+  \details
+  The tiles are read by the threads in parallel,
+  so the seek and the read are serialized by the lock.
+  */
+bool TiledImage::readTile(const uint tile_index, Rgba32* pixels) const noexcept
+{
+  ZISC_ASSERT(pixels != nullptr, "The pixels is null.");
+  constexpr std::streamoff tile_size = sizeof(Rgba32) * tileSide() * tileSide();
+  std::unique_lock<std::mutex> lock{file_mutex_};
+  file_.seekg(data_offset_ + tile_size * zisc::cast<std::streamoff>(tile_index));
+  zisc::read(pixels, &file_, tile_size);
+  return file_.good();
+}
+
+/*!
+  \details
+  Each level is made by averaging the 2x2 pixels of the previous level
+  in the same way as the in-memory image textures.
+  Only two levels are kept in memory at a time.
+  */
+bool TiledImage::write(const LdrImage& image,
+                       const Float gamma,
+                       const std::string& file_path,
+                       zisc::pmr::memory_resource* work_resource) noexcept
+{
+  std::ofstream file{file_path, std::ios::binary};
+  if (!file.is_open())
+    return false;
+
+  // Header
+  {
+    const uint32 magic = magicNumber();
+    const uint32 file_version = version();
+    const double file_gamma = zisc::cast<double>(gamma);
+    const uint32 tile_side = tileSide();
+    uint32 num_of_levels = 1;
+    for (auto r = image.resolution(); (1 < r[0]) || (1 < r[1]); ++num_of_levels)
+      r = Index2d{zisc::max(r[0] >> 1, 1u), zisc::max(r[1] >> 1, 1u)};
+    zisc::write(&magic, &file);
+    zisc::write(&file_version, &file);
+    zisc::write(&file_gamma, &file);
+    zisc::write(&tile_side, &file);
+    zisc::write(&num_of_levels, &file);
+    auto r = image.resolution();
+    for (uint32 level = 0; level < num_of_levels; ++level) {
+      const std::array<uint32, 2> resolution{{r[0], r[1]}};
+      zisc::write(&resolution[0], &file, sizeof(resolution[0]) * 2);
+      r = Index2d{zisc::max(r[0] >> 1, 1u), zisc::max(r[1] >> 1, 1u)};
+    }
+  }
+
+  // Tiles
+  zisc::pmr::vector<Rgba32> tile{work_resource};
+  tile.resize(tileSide() * tileSide());
+  writeTiles(image, &file, &tile);
+  LdrImage level_image{1, 1, work_resource};
+  LdrImage next_image{1, 1, work_resource};
+  image.downsample(gamma, &level_image);
+  for (bool has_level = (1 < image.widthResolution()) ||
+                        (1 < image.heightResolution());
+       has_level;) {
+    writeTiles(level_image, &file, &tile);
+    has_level = (1 < level_image.widthResolution()) ||
+                (1 < level_image.heightResolution());
+    if (has_level) {
+      level_image.downsample(gamma, &next_image);
+      std::swap(level_image, next_image);
+    }
+  }
+  return file.good();
+}
+
+/*!
+  \details
+  The gamma has to be the same as the gamma of the rendering,
+  since the levels are averaged in the linear space.
+  */
+bool TiledImage::readHeader(std::istream* file,
+                            const Float gamma,
+                            zisc::pmr::vector<Index2d>* resolution_list) noexcept
+{
+  uint32 magic = 0,
+         file_version = 0,
+         tile_side = 0,
+         num_of_levels = 0;
+  double file_gamma = 0.0;
+  zisc::read(&magic, file);
+  zisc::read(&file_version, file);
+  zisc::read(&file_gamma, file);
+  zisc::read(&tile_side, file);
+  zisc::read(&num_of_levels, file);
+  const bool is_matched = file->good() &&
+                          (magic == magicNumber()) &&
+                          (file_version == version()) &&
+                          (file_gamma == zisc::cast<double>(gamma)) &&
+                          (tile_side == tileSide()) &&
+                          (0 < num_of_levels) &&
+                          (num_of_levels <= 32);
+  if (!is_matched)
+    return false;
+
+  resolution_list->resize(num_of_levels);
+  for (auto& r : *resolution_list) {
+    std::array<uint32, 2> resolution;
+    zisc::read(&resolution[0], file, sizeof(resolution[0]) * 2);
+    r = Index2d{resolution[0], resolution[1]};
+  }
+  return file->good();
+}
+
+/*!
+  */
+void TiledImage::writeTiles(const LdrImage& image,
+                            std::ostream* file,
+                            zisc::pmr::vector<Rgba32>* tile) noexcept
+{
+  const auto& r = image.resolution();
+  const uint num_of_tiles_x = (r[0] + tileSide() - 1) / tileSide();
+  const uint num_of_tiles_y = (r[1] + tileSide() - 1) / tileSide();
+  for (uint tile_y = 0; tile_y < num_of_tiles_y; ++tile_y) {
+    for (uint tile_x = 0; tile_x < num_of_tiles_x; ++tile_x) {
+      for (uint y = 0; y < tileSide(); ++y) {
+        const uint py = zisc::min(tile_y * tileSide() + y, r[1] - 1);
+        for (uint x = 0; x < tileSide(); ++x) {
+          const uint px = zisc::min(tile_x * tileSide() + x, r[0] - 1);
+          (*tile)[x + y * tileSide()] = image.get(px, py);
+        }
+      }
+      zisc::write(tile->data(), file, sizeof(Rgba32) * tile->size());
+    }
+  }
+}
+
+} // namespace nanairo
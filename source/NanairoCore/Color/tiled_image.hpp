@@ -0,0 +1,118 @@
+/*!
+  \file tiled_image.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TILED_IMAGE_HPP
+#define NANAIRO_TILED_IMAGE_HPP
+
+// Standard C++ library
+#include <fstream>
+#include <ios>
+#include <mutex>
+#include <string>
+#include <string_view>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "rgba_32.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class LdrImage;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The on-disk mip pyramid of a image which is read tile by tile
+  \details
+  A tiled image file holds the header, which has the gamma and
+  the resolutions of the levels, and the square tiles of all levels
+  in the order of the levels. The tiles of a level are in row-major order and
+  the tiles at the right and bottom edges are padded by the edge pixels.
+  Only the header is kept in memory, the tiles are read on request.
+  */
+class TiledImage : public zisc::NonCopyable<TiledImage>
+{
+ public:
+  //! Create an empty tiled image
+  TiledImage(zisc::pmr::memory_resource* data_resource) noexcept;
+
+
+  //! Return the extension of the tiled image files
+  static constexpr const char* fileExtension() noexcept;
+
+  //! Check if the file is a valid tiled image of the gamma
+  static bool isValidFile(const std::string& file_path,
+                          const Float gamma,
+                          zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Return the number of the levels
+  uint numOfLevels() const noexcept;
+
+  //! Return the number of the tiles in x and y of the level
+  Index2d numOfTiles(const uint level) const noexcept;
+
+  //! Open the tiled image file and read the header
+  bool open(const std::string& file_path, const Float gamma) noexcept;
+
+  //! Read the pixels of the tile
+  bool readTile(const uint tile_index, Rgba32* pixels) const noexcept;
+
+  //! Return the resolution of the level
+  const Index2d& resolution(const uint level) const noexcept;
+
+  //! Return the index of the tile in the file
+  uint tileIndex(const uint level,
+                 const uint tile_x,
+                 const uint tile_y) const noexcept;
+
+  //! Return the number of the pixels of the tile side
+  static constexpr uint tileSide() noexcept;
+
+  //! Make the mip pyramid of the image and write it into the file
+  static bool write(const LdrImage& image,
+                    const Float gamma,
+                    const std::string& file_path,
+                    zisc::pmr::memory_resource* work_resource) noexcept;
+
+ private:
+  //! Return the magic number of the tiled image file
+  static constexpr uint32 magicNumber() noexcept;
+
+  //! Return the version of the tiled image file format
+  static constexpr uint32 version() noexcept;
+
+  //! Read the header of the file
+  static bool readHeader(std::istream* file,
+                         const Float gamma,
+                         zisc::pmr::vector<Index2d>* resolution_list) noexcept;
+
+  //! Write a level of the pyramid as tiles
+  static void writeTiles(const LdrImage& image,
+                         std::ostream* file,
+                         zisc::pmr::vector<Rgba32>* tile) noexcept;
+
+
+  zisc::pmr::vector<Index2d> resolution_list_;
+  zisc::pmr::vector<uint> tile_offset_list_; //!< The first tile of each level
+  mutable std::ifstream file_;
+  mutable std::mutex file_mutex_;
+  std::streamoff data_offset_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "tiled_image-inl.hpp"
+
+#endif // NANAIRO_TILED_IMAGE_HPP
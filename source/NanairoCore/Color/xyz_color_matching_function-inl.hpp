@@ -12,13 +12,59 @@
 
 #include "xyz_color_matching_function.hpp"
 // Standard C++ library
+#include <cstddef>
 #include <memory>
+// Zisc
+#include "zisc/compensated_summation.hpp"
 // Nanairo
+#include "xyz_color.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "SpectralDistribution/spectral_distribution.hpp"
 
 namespace nanairo {
 
+/*!
+  \details
+  The intensities of the spectra already include the inverse pdf of
+  the wavelengths, so a color is three dot products of the samples.
+  */
+inline
+XyzColor XyzColorMatchingFunction::toXyz(const SensorResponse& response,
+                                         const SampledSpectra& spectra) noexcept
+{
+  XyzColor xyz;
+  for (uint color = 0; color < 3; ++color) {
+    const auto& weight = response[color];
+    Float s = 0.0;
+    for (uint i = 0; i < spectra.size(); ++i)
+      s += weight[i] * spectra.intensity(i);
+    xyz[color] = s;
+  }
+  return xyz;
+}
+
+/*!
+  \details
+  The bins of the row are read directly, so the row isn't copied
+  into a distribution.
+  */
+template <bool kCompensated> inline
+XyzColor XyzColorMatchingFunction::toXyzForEmitter(
+    const SpectralTable<kCompensated>& table,
+    const std::size_t row) const noexcept
+{
+  XyzColor xyz;
+  for (uint color = 0; color < 3; ++color) {
+    const auto& bar = bar_[color];
+    zisc::CompensatedSummation<Float> s{0.0};
+    for (uint i = 0; i < CoreConfig::spectraSize(); ++i)
+      s.add(bar[i] * table.get(row, i));
+    xyz[color] = s.get();
+  }
+  return xyz;
+}
+
 /*!
   \details
   No detailed.
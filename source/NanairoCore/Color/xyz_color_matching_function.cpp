@@ -18,6 +18,7 @@
 // Nanairo
 #include "xyz_color.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
 #include "SpectralDistribution/spectral_distribution.hpp"
 
 namespace nanairo {
@@ -31,6 +32,24 @@ XyzColorMatchingFunction::XyzColorMatchingFunction() noexcept
   initialize();
 }
 
+/*!
+  \details
+  The response is made once per cycle when the wavelengths are sampled.
+  */
+auto XyzColorMatchingFunction::makeSensorResponse(
+    const WavelengthSamples& wavelengths) const noexcept -> SensorResponse
+{
+  SensorResponse response;
+  for (auto& weight : response)
+    weight.fill(0.0);
+  for (uint i = 0; i < wavelengths.size(); ++i) {
+    const uint16 lambda = wavelengths[i];
+    for (uint color = 0; color < 3; ++color)
+      response[color].set(i, bar_[color].getByWavelength(lambda));
+  }
+  return response;
+}
+
 /*!
   \details
   No detailed.
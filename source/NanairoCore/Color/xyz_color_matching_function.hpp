@@ -12,6 +12,7 @@
 
 // Standard C++ library
 #include <array>
+#include <cstddef>
 #include <memory>
 // Nanairo
 #include "xyz_color.hpp"
@@ -21,6 +22,11 @@
 
 namespace nanairo {
 
+// Forward declaration
+class SampledSpectra;
+template <bool kCompensated> class SpectralTable;
+class WavelengthSamples;
+
 //! \addtogroup Core
 //! \{
 
@@ -31,13 +37,30 @@ namespace nanairo {
 class XyzColorMatchingFunction
 {
  public:
+  //! The CMF values of sampled wavelengths, [xyz][wavelength]
+  using SensorResponse = std::array<IntensitySamples, 3>;
+
+
   //! Create a xyz color matching function
   XyzColorMatchingFunction() noexcept;
 
 
+  //! Return the CMF values of the sampled wavelengths
+  SensorResponse makeSensorResponse(const WavelengthSamples& wavelengths)
+      const noexcept;
+
+  //! Convert the sampled spectra to XYZ by the response of the wavelengths
+  static XyzColor toXyz(const SensorResponse& response,
+                        const SampledSpectra& spectra) noexcept;
+
   //! Convert spectrums to XYZ for emitter.
   XyzColor toXyzForEmitter(const SpectralDistribution& spectra) const noexcept;
 
+  //! Convert a row of the spectral table to XYZ for emitter
+  template <bool kCompensated>
+  XyzColor toXyzForEmitter(const SpectralTable<kCompensated>& table,
+                           const std::size_t row) const noexcept;
+
   //! Convert spectrums to XYZ for reflector.
   XyzColor toXyzForReflector(const SpectralDistribution& spectra) const noexcept;
 
@@ -30,6 +30,7 @@ inline
 IntersectionInfo::IntersectionInfo() noexcept :
     object_{nullptr},
     ray_distance_{0.0},
+    uv_footprint_{0.0},
     is_back_face_{kFalse}
 {
   // Avoid warnings
@@ -44,6 +45,7 @@ IntersectionInfo::IntersectionInfo(const Object* object,
     object_{object},
     point_{point},
     ray_distance_{0.0},
+    uv_footprint_{0.0},
     is_back_face_{kFalse}
 {
 }
@@ -215,6 +217,14 @@ void IntersectionInfo::setUv(const Point2& uv) noexcept
   point_.setUv(uv);
 }
 
+/*!
+  */
+inline
+void IntersectionInfo::setUvFootprint(const Float footprint) noexcept
+{
+  uv_footprint_ = footprint;
+}
+
 /*!
   */
 inline
@@ -249,6 +259,16 @@ const Point2& IntersectionInfo::uv() const noexcept
   return point_.uv();
 }
 
+/*!
+  \details
+  The width is zero if the ray has no cone.
+  */
+inline
+Float IntersectionInfo::uvFootprint() const noexcept
+{
+  return uv_footprint_;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_INTERSECTION_INFO_INL_HPP
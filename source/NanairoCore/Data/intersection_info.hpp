@@ -95,6 +95,9 @@ class IntersectionInfo
   //! Set texture coordinate
   void setUv(const Point2& uv) noexcept;
 
+  //! Set the width of the ray footprint in the texture coordinate
+  void setUvFootprint(const Float footprint) noexcept;
+
   //! Return the shape point
   const ShapePoint& shapePoint() const noexcept;
 
@@ -107,10 +110,14 @@ class IntersectionInfo
   //! Return the texture coordinate
   const Point2& uv() const noexcept;
 
+  //! Return the width of the ray footprint in the texture coordinate
+  Float uvFootprint() const noexcept;
+
  private:
   const Object* object_;
   ShapePoint point_;
   Float ray_distance_;
+  Float uv_footprint_;
   uint8 is_back_face_;
   std::array<uint8, 7> padding_;
 };
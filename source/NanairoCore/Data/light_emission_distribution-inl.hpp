@@ -0,0 +1,60 @@
+/*!
+  \file light_emission_distribution-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_EMISSION_DISTRIBUTION_INL_HPP
+#define NANAIRO_LIGHT_EMISSION_DISTRIBUTION_INL_HPP
+
+#include "light_emission_distribution.hpp"
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+Float LightEmissionDistribution::meanLuminance() const noexcept
+{
+  return mean_luminance_;
+}
+
+/*!
+  */
+inline
+constexpr uint LightEmissionDistribution::resolution() noexcept
+{
+  return 8;
+}
+
+/*!
+  \details
+  The cells of a triangle are indexed as the pairs of the upward and
+  the downward sub-triangles, and the last downward cell of each row is unused.
+  */
+inline
+uint LightEmissionDistribution::numOfCells() const noexcept
+{
+  constexpr uint n = resolution();
+  return (is_triangle_ == kTrue) ? 2 * n * n : n * n;
+}
+
+/*!
+  */
+inline
+uint LightEmissionDistribution::numOfValidCells() const noexcept
+{
+  constexpr uint n = resolution();
+  return n * n;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_LIGHT_EMISSION_DISTRIBUTION_INL_HPP
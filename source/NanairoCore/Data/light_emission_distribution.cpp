@@ -0,0 +1,196 @@
+/*!
+  \file light_emission_distribution.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "light_emission_distribution.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <iterator>
+// Zisc
+#include "zisc/compensated_summation.hpp"
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "path_state.hpp"
+#include "shape_point.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Material/TextureModel/texture_model.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+LightEmissionDistribution::LightEmissionDistribution(
+    zisc::pmr::memory_resource* mem_resource) noexcept :
+        cdf_list_{mem_resource},
+        mean_luminance_{1.0},
+        is_triangle_{kFalse}
+{
+}
+
+/*!
+  \details
+  The pdf of a cell is the probability of the cell divided by
+  the area of the cell, since the cells have the same area.
+  */
+Float LightEmissionDistribution::pdf(const Shape& shape,
+                                     const Point2& st) const noexcept
+{
+  const uint cell = findCell(st);
+  const Float p = (0 < cell) ? cdf_list_[cell] - cdf_list_[cell - 1]
+                             : cdf_list_[cell];
+  return p * zisc::cast<Float>(numOfValidCells()) / shape.surfaceArea();
+}
+
+/*!
+  \details
+  The first dimension selects a cell and is reused in the cell,
+  so the light points use the same sample dimensions as the uniform sampling.
+  */
+ShapePoint LightEmissionDistribution::samplePoint(
+    const Shape& shape,
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  const auto r = sampler.draw2D(path_state);
+  const auto position = std::upper_bound(cdf_list_.begin(), cdf_list_.end(), r[0]);
+  const uint cell = zisc::min(
+      zisc::cast<uint>(std::distance(cdf_list_.begin(), position)),
+      numOfCells() - 1);
+  const Float lower = (0 < cell) ? cdf_list_[cell - 1] : 0.0;
+  const Float p = cdf_list_[cell] - lower;
+  ZISC_ASSERT(0.0 < p, "The cell which has no emission is sampled.");
+  const Float r0 = zisc::clamp((r[0] - lower) / p, 0.0, 1.0);
+
+  auto point = shape.getPoint(toSt(cell, Point2{r0, r[1]}));
+  point.setPdf(p * zisc::cast<Float>(numOfValidCells()) / shape.surfaceArea());
+  return point;
+}
+
+/*!
+  \details
+  A cell which has no luminance is never sampled. If the whole shape is black,
+  the distribution is uniform and the mean luminance is zero.
+  */
+void LightEmissionDistribution::set(const Shape& shape,
+                                    const TextureModel& texture) noexcept
+{
+  is_triangle_ = (shape.type() == ShapeType::kPlane) ? kFalse : kTrue;
+  const uint num_of_cells = numOfCells();
+  cdf_list_.resize(num_of_cells);
+
+  // The luminance at the centroids of the cells
+  constexpr Float centroid = 1.0 / 3.0;
+  const Point2 center = (is_triangle_ == kTrue) ? Point2{centroid, centroid}
+                                                : Point2{0.5, 0.5};
+  zisc::CompensatedSummation<Float> sum{0.0};
+  for (uint cell = 0; cell < num_of_cells; ++cell) {
+    Float luminance = 0.0;
+    if (isValidCell(cell)) {
+      const auto point = shape.getPoint(toSt(cell, center));
+      luminance = zisc::max(texture.grayScaleValue(point.uv(), 0.0), 0.0);
+    }
+    sum.add(luminance);
+    cdf_list_[cell] = sum.get();
+  }
+
+  const Float total = sum.get();
+  mean_luminance_ = total / zisc::cast<Float>(numOfValidCells());
+  if (0.0 < total) {
+    const Float k = zisc::invert(total);
+    for (auto& c : cdf_list_)
+      c *= k;
+  }
+  else {
+    // The uniform distribution over the valid cells
+    Float c = 0.0;
+    const Float p = zisc::invert(zisc::cast<Float>(numOfValidCells()));
+    for (uint cell = 0; cell < num_of_cells; ++cell) {
+      c += isValidCell(cell) ? p : 0.0;
+      cdf_list_[cell] = c;
+    }
+  }
+  cdf_list_.back() = 1.0;
+}
+
+/*!
+  \details
+  A point on the diagonal edge of a triangle is in the upward cell.
+  */
+uint LightEmissionDistribution::findCell(const Point2& st) const noexcept
+{
+  constexpr uint n = resolution();
+  constexpr Float k = zisc::cast<Float>(n);
+  const Float x = zisc::clamp(st[0], 0.0, 1.0) * k;
+  const Float y = zisc::clamp(st[1], 0.0, 1.0) * k;
+  const uint i = zisc::min(zisc::cast<uint>(y), n - 1);
+  uint j = zisc::min(zisc::cast<uint>(x), n - 1);
+  if (is_triangle_ == kFalse)
+    return i * n + j;
+
+  if ((n - 1) < (i + j))
+    j = n - 1 - i;
+  const Float a = x - zisc::cast<Float>(j);
+  const Float b = y - zisc::cast<Float>(i);
+  const bool is_downward = (1.0 < (a + b)) && ((i + j) < (n - 1));
+  return 2 * (i * n + j) + (is_downward ? 1 : 0);
+}
+
+/*!
+  \details
+  The upward sub-triangle (i, j) covers the domain if i + j < n and
+  the downward one if i + j + 1 < n.
+  */
+bool LightEmissionDistribution::isValidCell(const uint cell) const noexcept
+{
+  if (is_triangle_ == kFalse)
+    return true;
+  constexpr uint n = resolution();
+  const uint i = (cell >> 1) / n;
+  const uint j = (cell >> 1) % n;
+  return (i + j + (cell & 1u)) < n;
+}
+
+/*!
+  \details
+  The point of the unit square is folded into the unit triangle for the
+  sub-triangles, the downward sub-triangle is the flipped upward one.
+  */
+Point2 LightEmissionDistribution::toSt(const uint cell,
+                                       const Point2& r) const noexcept
+{
+  constexpr uint n = resolution();
+  constexpr Float inverse_n = 1.0 / zisc::cast<Float>(n);
+  if (is_triangle_ == kFalse) {
+    const uint i = cell / n;
+    const uint j = cell % n;
+    return Point2{(zisc::cast<Float>(j) + r[0]) * inverse_n,
+                  (zisc::cast<Float>(i) + r[1]) * inverse_n};
+  }
+
+  const uint i = (cell >> 1) / n;
+  const uint j = (cell >> 1) % n;
+  Float a = r[0];
+  Float b = r[1];
+  if (1.0 < (a + b)) {
+    a = 1.0 - a;
+    b = 1.0 - b;
+  }
+  return ((cell & 1u) == 0)
+      ? Point2{(zisc::cast<Float>(j) + a) * inverse_n,
+               (zisc::cast<Float>(i) + b) * inverse_n}
+      : Point2{(zisc::cast<Float>(j + 1) - a) * inverse_n,
+               (zisc::cast<Float>(i + 1) - b) * inverse_n};
+}
+
+} // namespace nanairo
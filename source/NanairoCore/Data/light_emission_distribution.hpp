@@ -0,0 +1,92 @@
+/*!
+  \file light_emission_distribution.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_EMISSION_DISTRIBUTION_HPP
+#define NANAIRO_LIGHT_EMISSION_DISTRIBUTION_HPP
+
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "shape_point.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class PathState;
+class Sampler;
+class Shape;
+class TextureModel;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The distribution of the emission of a textured light source
+  \details
+  The st domain of the shape is divided into the cells of the same area,
+  the squares of a plane or the sub-triangles of a triangle, and the cells
+  are sampled by the luminance of the texture at their centroids.
+  The distribution is in the st domain, so it's kept by the transformations
+  of the shape and only the area of the shape converts the pdf.
+  */
+class LightEmissionDistribution
+{
+ public:
+  //! Create a uniform distribution
+  LightEmissionDistribution(zisc::pmr::memory_resource* mem_resource) noexcept;
+
+
+  //! Return the mean of the luminance of the texture over the shape
+  Float meanLuminance() const noexcept;
+
+  //! Return the pdf of the point of the st coordinates in the area measure
+  Float pdf(const Shape& shape, const Point2& st) const noexcept;
+
+  //! Return the number of the cells in each axis of the st domain
+  static constexpr uint resolution() noexcept;
+
+  //! Sample a point of the shape by the luminance
+  ShapePoint samplePoint(const Shape& shape,
+                         Sampler& sampler,
+                         const PathState& path_state) const noexcept;
+
+  //! Make the distribution of the shape by the luminance of the texture
+  void set(const Shape& shape, const TextureModel& texture) noexcept;
+
+ private:
+  //! Return the index of the cell which contains the st coordinates
+  uint findCell(const Point2& st) const noexcept;
+
+  //! Check if the cell is in the st domain of the shape
+  bool isValidCell(const uint cell) const noexcept;
+
+  //! Return the number of the cells including the unused cells of a triangle
+  uint numOfCells() const noexcept;
+
+  //! Return the number of the cells which cover the st domain
+  uint numOfValidCells() const noexcept;
+
+  //! Map the point of the unit square to the st coordinates in the cell
+  Point2 toSt(const uint cell, const Point2& r) const noexcept;
+
+
+  zisc::pmr::vector<Float> cdf_list_;
+  Float mean_luminance_;
+  uint8 is_triangle_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "light_emission_distribution-inl.hpp"
+
+#endif // NANAIRO_LIGHT_EMISSION_DISTRIBUTION_HPP
@@ -0,0 +1,56 @@
+/*!
+  \file light_source_bound-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_SOURCE_BOUND_INL_HPP
+#define NANAIRO_LIGHT_SOURCE_BOUND_INL_HPP
+
+#include "light_source_bound.hpp"
+// Zisc
+#include "zisc/math.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  A point behind a flat light doesn't receive the light.
+  Otherwise, the signed distances of the box corners from the tangent plane
+  of the surface point are bounded by the support of the box,
+  and the light has to be on the side which the BxDF scatters.
+  */
+inline
+bool LightSourceBound::canIlluminate(const Point3& point,
+                                     const Vector3& normal,
+                                     const bool is_reflective,
+                                     const bool is_transmissive) const noexcept
+{
+  const auto& min_point = bounding_box_.minPoint();
+  const auto& max_point = bounding_box_.maxPoint();
+  Float plane_distance = -offset_;
+  Float min_distance = 0.0;
+  Float max_distance = 0.0;
+  for (uint i = 0; i < 3; ++i) {
+    plane_distance += normal_[i] * point[i];
+    const Float d1 = normal[i] * (min_point[i] - point[i]);
+    const Float d2 = normal[i] * (max_point[i] - point[i]);
+    min_distance += zisc::min(d1, d2);
+    max_distance += zisc::max(d1, d2);
+  }
+  return (0.0 < plane_distance) &&
+         ((is_reflective && (0.0 < max_distance)) ||
+          (is_transmissive && (min_distance <= 0.0)));
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_LIGHT_SOURCE_BOUND_INL_HPP
@@ -0,0 +1,65 @@
+/*!
+  \file light_source_bound.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "light_source_bound.hpp"
+// Standard C++ library
+#include <limits>
+// Nanairo
+#include "shape_point.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The bound is infinite, so the light can illuminate any point.
+  */
+LightSourceBound::LightSourceBound() noexcept :
+    bounding_box_{Point3{std::numeric_limits<Float>::lowest(),
+                         std::numeric_limits<Float>::lowest(),
+                         std::numeric_limits<Float>::lowest()},
+                  Point3{std::numeric_limits<Float>::max(),
+                         std::numeric_limits<Float>::max(),
+                         std::numeric_limits<Float>::max()}},
+    normal_{0.0, 0.0, 0.0},
+    offset_{std::numeric_limits<Float>::lowest()}
+{
+}
+
+/*!
+  */
+LightSourceBound::LightSourceBound(const Shape& shape) noexcept
+{
+  set(shape);
+}
+
+/*!
+  \details
+  A curved light has the zero normal and the lowest offset,
+  so the test of the plane always passes.
+  */
+void LightSourceBound::set(const Shape& shape) noexcept
+{
+  bounding_box_ = shape.boundingBox();
+  normal_ = shape.flatNormal();
+  const bool is_flat = 0.0 < normal_.squareNorm();
+  if (is_flat) {
+    const auto point = shape.getPoint(Point2{0.0, 0.0}).point();
+    offset_ = normal_[0] * point[0] + normal_[1] * point[1] + normal_[2] * point[2];
+  }
+  else {
+    offset_ = std::numeric_limits<Float>::lowest();
+  }
+}
+
+} // namespace nanairo
@@ -0,0 +1,64 @@
+/*!
+  \file light_source_bound.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_SOURCE_BOUND_HPP
+#define NANAIRO_LIGHT_SOURCE_BOUND_HPP
+
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Shape;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The bound of the points and the normals of a light source
+  \details
+  The bound is used to reject the explicit connections which have
+  no contribution before a point of the light source is sampled.
+  */
+class LightSourceBound
+{
+ public:
+  //! Create an unbounded light
+  LightSourceBound() noexcept;
+
+  //! Create the bound of the shape
+  LightSourceBound(const Shape& shape) noexcept;
+
+
+  //! Check if the light can illuminate the surface point
+  bool canIlluminate(const Point3& point,
+                     const Vector3& normal,
+                     const bool is_reflective,
+                     const bool is_transmissive) const noexcept;
+
+  //! Set the bound of the shape
+  void set(const Shape& shape) noexcept;
+
+ private:
+  Aabb bounding_box_;
+  Vector3 normal_; //!< The normal of a flat light, otherwise zero
+  Float offset_; //!< The distance of the plane of a flat light from the origin
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "light_source_bound-inl.hpp"
+
+#endif // NANAIRO_LIGHT_SOURCE_BOUND_HPP
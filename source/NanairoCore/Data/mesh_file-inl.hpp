@@ -0,0 +1,100 @@
+/*!
+  \file mesh_file-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_MESH_FILE_INL_HPP
+#define NANAIRO_MESH_FILE_INL_HPP
+
+#include "mesh_file.hpp"
+// Standard C++ library
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr const char* MeshFile::fileExtension() noexcept
+{
+  return ".nmesh";
+}
+
+/*!
+  */
+inline
+bool MeshFile::hasUv(const Triangle& triangle) noexcept
+{
+  return triangle.uv_[0] != nullIndex();
+}
+
+/*!
+  */
+inline
+constexpr uint32 MeshFile::nullIndex() noexcept
+{
+  return std::numeric_limits<uint32>::max();
+}
+
+/*!
+  */
+inline
+uint32 MeshFile::numOfTriangles() const noexcept
+{
+  return (header_ != nullptr) ? header_->num_of_triangles_ : 0;
+}
+
+/*!
+  */
+inline
+uint32 MeshFile::numOfUvs() const noexcept
+{
+  return (header_ != nullptr) ? header_->num_of_uvs_ : 0;
+}
+
+/*!
+  */
+inline
+uint32 MeshFile::numOfVertices() const noexcept
+{
+  return (header_ != nullptr) ? header_->num_of_vertices_ : 0;
+}
+
+/*!
+  */
+inline
+auto MeshFile::triangle(const uint32 index) const noexcept -> const Triangle&
+{
+  ZISC_ASSERT(index < numOfTriangles(), "The index is out of range.");
+  return triangle_list_[index];
+}
+
+/*!
+  */
+inline
+auto MeshFile::uv(const uint32 index) const noexcept -> const Uv&
+{
+  ZISC_ASSERT(index < numOfUvs(), "The index is out of range.");
+  return uv_list_[index];
+}
+
+/*!
+  */
+inline
+auto MeshFile::vertex(const uint32 index) const noexcept -> const Vertex&
+{
+  ZISC_ASSERT(index < numOfVertices(), "The index is out of range.");
+  return vertex_list_[index];
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_MESH_FILE_INL_HPP
@@ -0,0 +1,156 @@
+/*!
+  \file mesh_file.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "mesh_file.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <string>
+// Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "face.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Setting/single_object_setting_node.hpp"
+#include "NanairoCore/Utility/mapped_file.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr uint32 MeshFile::magicNumber() noexcept
+{
+  return zisc::Fnv1aHash32::hash("NanairoMesh");
+}
+
+/*!
+  */
+inline
+constexpr uint32 MeshFile::version() noexcept
+{
+  return 1;
+}
+
+/*!
+  */
+MeshFile::MeshFile() noexcept :
+    header_{nullptr},
+    vertex_list_{nullptr},
+    uv_list_{nullptr},
+    triangle_list_{nullptr}
+{
+  static_assert(sizeof(Header) == 6 * sizeof(uint32), "The header is padded.");
+  static_assert(sizeof(Vertex) == 3 * sizeof(float), "The vertex is padded.");
+  static_assert(sizeof(Uv) == 2 * sizeof(float), "The uv is padded.");
+  static_assert(sizeof(Triangle) == 6 * sizeof(uint32), "The triangle is padded.");
+}
+
+/*!
+  */
+MeshFile::~MeshFile() noexcept
+{
+  close();
+}
+
+/*!
+  \details
+  The sizes of the arrays are checked against the file size,
+  so a truncated file is rejected instead of being read out of the mapping.
+  */
+bool MeshFile::open(const std::string& file_path) noexcept
+{
+  close();
+  if (!file_.open(file_path) || (file_.size() < sizeof(Header))) {
+    close();
+    return false;
+  }
+
+  const uint8* data = file_.data();
+  auto header = zisc::cast<const Header*>(zisc::cast<const void*>(data));
+  const std::size_t vertex_offset = sizeof(Header);
+  const std::size_t uv_offset = vertex_offset +
+      sizeof(Vertex) * zisc::cast<std::size_t>(header->num_of_vertices_);
+  const std::size_t triangle_offset = uv_offset +
+      sizeof(Uv) * zisc::cast<std::size_t>(header->num_of_uvs_);
+  const std::size_t end = triangle_offset +
+      sizeof(Triangle) * zisc::cast<std::size_t>(header->num_of_triangles_);
+  const bool is_matched = (header->magic_ == magicNumber()) &&
+                          (header->version_ == version()) &&
+                          (end == file_.size());
+  if (!is_matched) {
+    close();
+    return false;
+  }
+
+  header_ = header;
+  vertex_list_ = zisc::cast<const Vertex*>(
+      zisc::cast<const void*>(data + vertex_offset));
+  uv_list_ = zisc::cast<const Uv*>(zisc::cast<const void*>(data + uv_offset));
+  triangle_list_ = zisc::cast<const Triangle*>(
+      zisc::cast<const void*>(data + triangle_offset));
+  return true;
+}
+
+/*!
+  \details
+  The vertices and the UVs are stored as floats and
+  the faces are stored as triangles.
+  */
+bool MeshFile::write(const MeshParameters& parameters,
+                     const std::string& file_path) noexcept
+{
+  std::ofstream mesh_file{file_path, std::ios::binary};
+  if (!mesh_file.is_open())
+    return false;
+
+  const Header header{magicNumber(),
+                      version(),
+                      zisc::cast<uint32>(parameters.vertex_list_.size()),
+                      zisc::cast<uint32>(parameters.vuv_list_.size()),
+                      zisc::cast<uint32>(parameters.face_list_.size()),
+                      0};
+  zisc::write(&header, &mesh_file);
+  for (const auto& v : parameters.vertex_list_) {
+    const Vertex vertex{{zisc::cast<float>(v[0]),
+                         zisc::cast<float>(v[1]),
+                         zisc::cast<float>(v[2])}};
+    zisc::write(&vertex, &mesh_file);
+  }
+  for (const auto& t : parameters.vuv_list_) {
+    const Uv uv{{zisc::cast<float>(t[0]), zisc::cast<float>(t[1])}};
+    zisc::write(&uv, &mesh_file);
+  }
+  for (const auto& face : parameters.face_list_) {
+    Triangle triangle{face.triangleVertexIndices(),
+                      {{nullIndex(), nullIndex(), nullIndex()}}};
+    if (face.hasVuv())
+      triangle.uv_ = face.triangleVuvIndices();
+    zisc::write(&triangle, &mesh_file);
+  }
+  return mesh_file.good();
+}
+
+/*!
+  */
+void MeshFile::close() noexcept
+{
+  file_.close();
+  header_ = nullptr;
+  vertex_list_ = nullptr;
+  uv_list_ = nullptr;
+  triangle_list_ = nullptr;
+}
+
+} // namespace nanairo
@@ -0,0 +1,134 @@
+/*!
+  \file mesh_file.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_MESH_FILE_HPP
+#define NANAIRO_MESH_FILE_HPP
+
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <string>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Utility/mapped_file.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+struct MeshParameters;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The binary mesh file which is mapped into memory
+  \details
+  A mesh file has the fixed layout, the header, the float vertices,
+  the float UVs and the indexed triangles in this order.
+  Every element is 4 bytes aligned, so the arrays are used directly
+  from the mapped file without parsing or copying.
+  */
+class MeshFile : public zisc::NonCopyable<MeshFile>
+{
+ public:
+  using Vertex = std::array<float, 3>;
+  using Uv = std::array<float, 2>;
+
+  /*!
+    \details
+    The UV indices are the null index if the triangle has no UV.
+    */
+  struct Triangle
+  {
+    std::array<uint32, 3> vertex_;
+    std::array<uint32, 3> uv_;
+  };
+
+
+  //! Create an empty mesh file
+  MeshFile() noexcept;
+
+  //! Unmap the file
+  ~MeshFile() noexcept;
+
+
+  //! Return the extension of the mesh files
+  static constexpr const char* fileExtension() noexcept;
+
+  //! Check if the triangle has the UVs
+  static bool hasUv(const Triangle& triangle) noexcept;
+
+  //! Return the null index
+  static constexpr uint32 nullIndex() noexcept;
+
+  //! Return the number of the triangles
+  uint32 numOfTriangles() const noexcept;
+
+  //! Return the number of the UVs
+  uint32 numOfUvs() const noexcept;
+
+  //! Return the number of the vertices
+  uint32 numOfVertices() const noexcept;
+
+  //! Map the file into memory and validate the header
+  bool open(const std::string& file_path) noexcept;
+
+  //! Return the triangle by the index
+  const Triangle& triangle(const uint32 index) const noexcept;
+
+  //! Return the UV by the index
+  const Uv& uv(const uint32 index) const noexcept;
+
+  //! Return the vertex by the index
+  const Vertex& vertex(const uint32 index) const noexcept;
+
+  //! Write the triangles of the mesh parameters into the file
+  static bool write(const MeshParameters& parameters,
+                    const std::string& file_path) noexcept;
+
+ private:
+  /*!
+    */
+  struct Header
+  {
+    uint32 magic_;
+    uint32 version_;
+    uint32 num_of_vertices_;
+    uint32 num_of_uvs_;
+    uint32 num_of_triangles_;
+    uint32 reserved_;
+  };
+
+
+  //! Return the magic number of the mesh file
+  static constexpr uint32 magicNumber() noexcept;
+
+  //! Unmap the file
+  void close() noexcept;
+
+  //! Return the version of the mesh file format
+  static constexpr uint32 version() noexcept;
+
+
+  MappedFile file_;
+  const Header* header_;
+  const Vertex* vertex_list_;
+  const Uv* uv_list_;
+  const Triangle* triangle_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "mesh_file-inl.hpp"
+
+#endif // NANAIRO_MESH_FILE_HPP
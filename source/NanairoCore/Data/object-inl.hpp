@@ -11,12 +11,29 @@
 #define NANAIRO_OBJECT_INL_HPP
 
 #include "object.hpp"
+// Zisc
+#include "zisc/math.hpp"
 // Nanairo
+#include "light_emission_distribution.hpp"
+#include "shape_point.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Shape/shape.hpp"
 #include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Material/EmitterModel/emitter_model.hpp"
 
 namespace nanairo {
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+Shape& Object::shape() noexcept
+{
+  return *shape_;
+}
+
 /*!
   \details
   No detailed.
@@ -27,6 +44,82 @@ const Shape& Object::shape() const noexcept
   return *shape_;
 }
 
+/*!
+  \details
+  The distribution is set by the world for the textured light sources.
+  */
+inline
+const LightEmissionDistribution* Object::emissionDistribution() const noexcept
+{
+  return emission_distribution_;
+}
+
+/*!
+  */
+inline
+bool Object::isLightSource() const noexcept
+{
+  return material_->isLightSource();
+}
+
+/*!
+  \details
+  The st is the parametric coordinate of the point on the shape,
+  which is given by the intersection.
+  */
+inline
+Float Object::lightPointPdf(const Point2& st) const noexcept
+{
+  return (emission_distribution_ == nullptr)
+      ? zisc::invert(shape().surfaceArea())
+      : emission_distribution_->pdf(shape(), st);
+}
+
+/*!
+  \details
+  The radiant exitance of a textured light is scaled by the mean luminance of
+  the texture over the shape.
+  */
+inline
+Float Object::lightPower() const noexcept
+{
+  const Float power = shape().surfaceArea() *
+                      material().emitter().radiantExitance();
+  return (emission_distribution_ == nullptr)
+      ? power
+      : power * emission_distribution_->meanLuminance();
+}
+
+/*!
+  */
+inline
+ShapePoint Object::sampleLightPoint(Sampler& sampler,
+                                    const PathState& path_state) const noexcept
+{
+  return (emission_distribution_ == nullptr)
+      ? shape().samplePoint(sampler, path_state)
+      : emission_distribution_->samplePoint(shape(), sampler, path_state);
+}
+
+/*!
+  */
+inline
+void Object::setEmissionDistribution(
+    const LightEmissionDistribution* distribution) noexcept
+{
+  emission_distribution_ = distribution;
+}
+
+/*!
+  \details
+  The bound is set by the world after the objects are built.
+  */
+inline
+const LightSourceBound* Object::lightSourceBound() const noexcept
+{
+  return light_source_bound_;
+}
+
 /*!
   \details
   No detailed.
@@ -37,6 +130,14 @@ const Material& Object::material() const noexcept
   return *material_;
 }
 
+/*!
+  */
+inline
+void Object::setLightSourceBound(const LightSourceBound* bound) noexcept
+{
+  light_source_bound_ = bound;
+}
+
 /*!
   \details
   No detailed.
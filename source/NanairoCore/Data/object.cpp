@@ -30,7 +30,9 @@ namespace nanairo {
 Object::Object(zisc::UniqueMemoryPointer<Shape>&& shape,
                const Material* material) noexcept :
     shape_{std::move(shape)},
-    material_{material}
+    material_{material},
+    light_source_bound_{nullptr},
+    emission_distribution_{nullptr}
 {
   ZISC_ASSERT(material != nullptr, "The material is null.");
 }
@@ -40,7 +42,9 @@ Object::Object(zisc::UniqueMemoryPointer<Shape>&& shape,
   No detailed.
   */
 Object::Object(Object&& other) noexcept :
-    material_{nullptr}
+    material_{nullptr},
+    light_source_bound_{nullptr},
+    emission_distribution_{nullptr}
 {
   swap(other);
 }
@@ -90,6 +94,18 @@ void Object::swap(Object& other) noexcept
     other.material_ = material_;
     material_ = tmp;
   }
+  // Light source bound
+  {
+    auto tmp = other.light_source_bound_;
+    other.light_source_bound_ = light_source_bound_;
+    light_source_bound_ = tmp;
+  }
+  // Emission distribution
+  {
+    auto tmp = other.emission_distribution_;
+    other.emission_distribution_ = emission_distribution_;
+    emission_distribution_ = tmp;
+  }
 #ifdef Z_DEBUG_MODE
   // Name
   {
@@ -25,6 +25,13 @@
 
 namespace nanairo {
 
+// Forward declaration
+class LightEmissionDistribution;
+class LightSourceBound;
+class PathState;
+class Sampler;
+class ShapePoint;
+
 //! \addtogroup Core
 //! \{
 
@@ -50,12 +57,41 @@ class Object : public zisc::NonCopyable<Object>
   //! Return the name of the object
   std::string_view name() const noexcept;
 
+  //! Return the emission distribution, null if the emission is uniform
+  const LightEmissionDistribution* emissionDistribution() const noexcept;
+
+  //! Check if the object is a light source
+  bool isLightSource() const noexcept;
+
+  //! Return the pdf (area measure) of sampling the point of the light source
+  Float lightPointPdf(const Point2& st) const noexcept;
+
+  //! Return the flux of the light source, which is used to weight the light
+  Float lightPower() const noexcept;
+
+  //! Return the bound of the light source, null if the object isn't a light
+  const LightSourceBound* lightSourceBound() const noexcept;
+
   //! Get material
   const Material& material() const noexcept;
 
+  //! Sample a point of the light source proportional to the emission
+  ShapePoint sampleLightPoint(Sampler& sampler,
+                              const PathState& path_state) const noexcept;
+
+  //! Set the emission distribution of the light source
+  void setEmissionDistribution(
+      const LightEmissionDistribution* distribution) noexcept;
+
+  //! Set the bound of the light source
+  void setLightSourceBound(const LightSourceBound* bound) noexcept;
+
   //! Set the name of the object
   void setName(const std::string_view& object_name) noexcept;
 
+  //! Get shape
+  Shape& shape() noexcept;
+
   //! Get shape
   const Shape& shape() const noexcept;
 
@@ -65,6 +101,8 @@ class Object : public zisc::NonCopyable<Object>
  private:
   zisc::UniqueMemoryPointer<Shape> shape_;
   const Material* material_;
+  const LightSourceBound* light_source_bound_;
+  const LightEmissionDistribution* emission_distribution_;
 #ifdef Z_DEBUG_MODE
   std::string name_;
 #endif // Z_DEBUG_MODE
@@ -11,7 +11,16 @@
 #define NANAIRO_PHOTON_CACHE_INL_HPP
 
 #include "photon_cache.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
+#include "wavelength_samples.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
@@ -22,8 +31,30 @@ namespace nanairo {
 /*!
   */
 inline
-PhotonCache::PhotonCache() noexcept
+constexpr float PhotonCache::energyMantissaMax() noexcept
 {
+  return zisc::cast<float>(std::numeric_limits<uint16>::max());
+}
+
+/*!
+  */
+inline
+constexpr float PhotonCache::directionLevelMax() noexcept
+{
+  return zisc::cast<float>(std::numeric_limits<uint16>::max());
+}
+
+/*!
+  */
+inline
+PhotonCache::PhotonCache() noexcept :
+    point_{{0.0f, 0.0f, 0.0f}},
+    inverse_pdf_{0.0f},
+    vin_{{0, 0}},
+    energy_exponent_{0},
+    wavelength_is_selected_{kFalse}
+{
+  energy_.fill(0);
 }
 
 /*!
@@ -33,29 +64,45 @@ PhotonCache::PhotonCache(const SampledSpectra& energy,
                          const Point3& point,
                          const Vector3& vin,
                          const bool wavelength_is_selected) noexcept :
-    energy_{energy},
-    point_{point},
-    vin_{vin},
-    wavelength_is_selected_{wavelength_is_selected}
+    PhotonCache()
 {
+  setEnergy(energy);
+  setPoint(point);
+  setIncidentDirection(vin);
+  setWavelengthIsSelected(wavelength_is_selected);
 }
 
 /*!
   */
 inline
-const SampledSpectra& PhotonCache::energy() const noexcept
+SampledSpectra PhotonCache::energy(const WavelengthSamples& wavelengths) const noexcept
 {
-  return energy_;
+  const Float scale = std::ldexp(1.0, zisc::cast<int>(energy_exponent_));
+  SampledSpectra e{wavelengths};
+  for (uint i = 0; i < e.size(); ++i)
+    e.setIntensity(i, scale * zisc::cast<Float>(energy_[i]));
+  return e;
 }
 
 /*!
   \details
-  No detailed.
+  The direction is normalized again since the quantization moves
+  the point off the octahedron.
   */
 inline
-const Vector3& PhotonCache::incidentDirection() const noexcept
+Vector3 PhotonCache::incidentDirection() const noexcept
 {
-  return vin_;
+  constexpr float k = 2.0f / directionLevelMax();
+  float x = k * zisc::cast<float>(vin_[0]) - 1.0f;
+  float y = k * zisc::cast<float>(vin_[1]) - 1.0f;
+  const float z = 1.0f - (zisc::abs(x) + zisc::abs(y));
+  if (z < 0.0f) {
+    const auto folded = foldOctahedron(x, y);
+    x = folded[0];
+    y = folded[1];
+  }
+  const Vector3 v{zisc::cast<Float>(x), zisc::cast<Float>(y), zisc::cast<Float>(z)};
+  return v.normalized();
 }
 
 /*!
@@ -63,33 +110,65 @@ const Vector3& PhotonCache::incidentDirection() const noexcept
 inline
 Float PhotonCache::inversePdf() const noexcept
 {
-  return inverse_pdf_;
+  return zisc::cast<Float>(inverse_pdf_);
 }
 
 /*!
-  \details
-  No detailed.
   */
 inline
-const Point3& PhotonCache::point() const noexcept
+Point3 PhotonCache::point() const noexcept
 {
-  return point_;
+  return Point3{zisc::cast<Float>(point_[0]),
+                zisc::cast<Float>(point_[1]),
+                zisc::cast<Float>(point_[2])};
 }
 
 /*!
+  \details
+  The exponent is chosen so that the max intensity fits in the mantissa,
+  the mantissas are rounded to the nearest levels.
   */
 inline
 void PhotonCache::setEnergy(const SampledSpectra& e) noexcept
 {
-  energy_ = e;
+  ZISC_ASSERT(!e.hasNegative(), "The energy has negative values.");
+  constexpr Float max_q = zisc::cast<Float>(energyMantissaMax());
+  const Float m = e.max();
+  int exponent = 0;
+  if (0.0 < m) {
+    std::frexp(m / max_q, &exponent);
+    constexpr int min_exponent = std::numeric_limits<int8>::min();
+    constexpr int max_exponent = std::numeric_limits<int8>::max();
+    exponent = zisc::min(zisc::max(exponent, min_exponent), max_exponent);
+  }
+  energy_exponent_ = zisc::cast<int8>(exponent);
+  const Float inverse_scale = std::ldexp(1.0, -exponent);
+  for (uint i = 0; i < e.size(); ++i) {
+    const Float q = std::round(e.intensity(i) * inverse_scale);
+    energy_[i] = zisc::cast<uint16>(zisc::min(zisc::max(q, 0.0), max_q));
+  }
 }
 
 /*!
+  \details
+  The direction is projected onto the octahedron and
+  the lower hemisphere is folded onto the corners of the square.
   */
 inline
 void PhotonCache::setIncidentDirection(const Vector3& v) noexcept
 {
-  vin_ = v;
+  const Float l1 = zisc::abs(v[0]) + zisc::abs(v[1]) + zisc::abs(v[2]);
+  ZISC_ASSERT(0.0 < l1, "The direction is zero vector.");
+  float x = zisc::cast<float>(v[0] / l1);
+  float y = zisc::cast<float>(v[1] / l1);
+  if (v[2] < 0.0) {
+    const auto folded = foldOctahedron(x, y);
+    x = folded[0];
+    y = folded[1];
+  }
+  constexpr float k = 0.5f * directionLevelMax();
+  vin_[0] = zisc::cast<uint16>(std::round(k * (x + 1.0f)));
+  vin_[1] = zisc::cast<uint16>(std::round(k * (y + 1.0f)));
 }
 
 /*!
@@ -97,7 +176,7 @@ void PhotonCache::setIncidentDirection(const Vector3& v) noexcept
 inline
 void PhotonCache::setInversePdf(const Float inverse_pdf) noexcept
 {
-  inverse_pdf_ = inverse_pdf;
+  inverse_pdf_ = zisc::cast<float>(inverse_pdf);
 }
 
 /*!
@@ -105,7 +184,8 @@ void PhotonCache::setInversePdf(const Float inverse_pdf) noexcept
 inline
 void PhotonCache::setPoint(const Point3& p) noexcept
 {
-  point_ = p;
+  for (uint i = 0; i < 3; ++i)
+    point_[i] = zisc::cast<float>(p[i]);
 }
 
 /*!
@@ -113,7 +193,7 @@ void PhotonCache::setPoint(const Point3& p) noexcept
 inline
 void PhotonCache::setWavelengthIsSelected(const bool is_selected) noexcept
 {
-  wavelength_is_selected_ = is_selected;
+  wavelength_is_selected_ = is_selected ? kTrue : kFalse;
 }
 
 /*!
@@ -121,7 +201,21 @@ void PhotonCache::setWavelengthIsSelected(const bool is_selected) noexcept
 inline
 bool PhotonCache::wavelengthIsSelected() const noexcept
 {
-  return wavelength_is_selected_;
+  return wavelength_is_selected_ == kTrue;
+}
+
+/*!
+  \details
+  The folding is its own inverse.
+  */
+inline
+std::array<float, 2> PhotonCache::foldOctahedron(const float x,
+                                                 const float y) noexcept
+{
+  const float sx = (0.0f <= x) ? 1.0f : -1.0f;
+  const float sy = (0.0f <= y) ? 1.0f : -1.0f;
+  return std::array<float, 2>{{(1.0f - zisc::abs(y)) * sx,
+                               (1.0f - zisc::abs(x)) * sy}};
 }
 
 } // namespace nanairo
@@ -10,6 +10,8 @@
 #ifndef NANAIRO_PHOTON_CACHE_HPP
 #define NANAIRO_PHOTON_CACHE_HPP
 
+// Standard C++ library
+#include <array>
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
@@ -18,12 +20,20 @@
 
 namespace nanairo {
 
+// Forward declaration
+class WavelengthSamples;
+
 //! \addtogroup Core
 //! \{
 
 /*!
   \details
-  No detailed.
+  The photon is stored in the compact layout, since the photon map is
+  bound by the memory traffic with the large number of photons.
+  The point and the inverse pdf are in float, the incident direction is
+  in the octahedral 32bit encoding and the energy is in 16bit mantissas
+  which share an exponent. The wavelengths of the energy aren't stored,
+  they are the ones of the pass which traced the photons.
   */
 class PhotonCache
 {
@@ -38,17 +48,17 @@ class PhotonCache
               const bool wavelength_is_selected) noexcept;
 
 
-  //! Return a cached radiance
-  const SampledSpectra& energy() const noexcept;
+  //! Return a cached radiance in the wavelengths
+  SampledSpectra energy(const WavelengthSamples& wavelengths) const noexcept;
 
   //! Return an incident direction to the cached point
-  const Vector3& incidentDirection() const noexcept;
+  Vector3 incidentDirection() const noexcept;
 
   //! Return an inverse path sampling pdf
   Float inversePdf() const noexcept;
 
   //! Return a cached point
-  const Point3& point() const noexcept;
+  Point3 point() const noexcept;
 
   //! Set a radiance
   void setEnergy(const SampledSpectra& e) noexcept;
@@ -69,11 +79,23 @@ class PhotonCache
   bool wavelengthIsSelected() const noexcept;
 
  private:
-  SampledSpectra energy_;
-  Point3 point_;
-  Vector3 vin_;
-  Float inverse_pdf_;
-  bool wavelength_is_selected_;
+  //! Return the max level of the energy mantissas
+  static constexpr float energyMantissaMax() noexcept;
+
+  //! Return the max level of the direction components
+  static constexpr float directionLevelMax() noexcept;
+
+  //! Fold the lower hemisphere of the octahedron
+  static std::array<float, 2> foldOctahedron(const float x,
+                                             const float y) noexcept;
+
+
+  std::array<float, 3> point_;
+  float inverse_pdf_;
+  std::array<uint16, 2> vin_; //!< The octahedral direction
+  std::array<uint16, CoreConfig::wavelengthSampleSize()> energy_;
+  int8 energy_exponent_;
+  uint8 wavelength_is_selected_;
 };
 
 //! \} Core
@@ -16,6 +16,7 @@
 #include <limits>
 // Zisc
 #include "zisc/math.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/point.hpp"
@@ -29,7 +30,10 @@ namespace nanairo {
   */
 inline
 Ray::Ray() noexcept :
-    is_alive_{kFalse}
+    cone_width_{0.0},
+    cone_spread_{0.0},
+    is_alive_{kFalse},
+    sign_bits_{0}
 {
   initialize();
 }
@@ -42,9 +46,29 @@ inline
 Ray::Ray(const Point3& origin, const Vector3& direction) noexcept :
     origin_{origin},
     direction_{direction},
-    is_alive_{kTrue}
+    cone_width_{0.0},
+    cone_spread_{0.0},
+    is_alive_{kTrue},
+    sign_bits_{0}
 {
   initialize();
+  setInverseDirection();
+}
+
+/*!
+  */
+inline
+Float Ray::coneSpread() const noexcept
+{
+  return cone_spread_;
+}
+
+/*!
+  */
+inline
+Float Ray::coneWidth() const noexcept
+{
+  return cone_width_;
 }
 
 /*!
@@ -57,6 +81,25 @@ const Vector3& Ray::direction() const noexcept
   return direction_;
 }
 
+/*!
+  \details
+  The ray cone is approximated by the small angle,
+  so the width grows linearly with the distance.
+  */
+inline
+Float Ray::footprint(const Float distance) const noexcept
+{
+  return cone_width_ + distance * cone_spread_;
+}
+
+/*!
+  */
+inline
+const Vector3& Ray::inverseDirection() const noexcept
+{
+  return inverse_direction_;
+}
+
 /*!
   \details
   No detailed.
@@ -94,6 +137,7 @@ inline
 void Ray::setDirection(const Vector3& direction) noexcept
 {
   direction_ = direction;
+  setInverseDirection();
 }
 
 /*!
@@ -116,6 +160,28 @@ void Ray::setAlive(const bool is_alive) noexcept
   is_alive_ = is_alive ? kTrue : kFalse;
 }
 
+/*!
+  \details
+  A ray without a cone has zero width and spread,
+  so the finest level of textures is used.
+  */
+inline
+void Ray::setCone(const Float width, const Float spread) noexcept
+{
+  cone_width_ = width;
+  cone_spread_ = spread;
+}
+
+/*!
+  \details
+  The bit i is set if the i-th component of the direction is negative.
+  */
+inline
+uint Ray::signBits() const noexcept
+{
+  return zisc::cast<uint>(sign_bits_);
+}
+
 /*!
   */
 inline
@@ -125,6 +191,22 @@ void Ray::initialize() noexcept
   static_cast<void>(padding_);
 }
 
+/*!
+  \details
+  The reciprocal of a zero component is infinity.
+  */
+inline
+void Ray::setInverseDirection() noexcept
+{
+  inverse_direction_ = invert(direction_);
+  uint8 sign_bits = 0;
+  for (uint i = 0; i < 3; ++i) {
+    const uint8 is_negative = (direction_[i] < 0.0) ? 1 : 0;
+    sign_bits = sign_bits | zisc::cast<uint8>(is_negative << i);
+  }
+  sign_bits_ = sign_bits;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_RAY_INL_HPP
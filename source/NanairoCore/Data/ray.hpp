@@ -33,9 +33,21 @@ class Ray
   Ray() noexcept;
 
 
+  //! Return the spread angle of the ray cone
+  Float coneSpread() const noexcept;
+
+  //! Return the width of the ray cone at the origin
+  Float coneWidth() const noexcept;
+
   //! Return the direction
   const Vector3& direction() const noexcept;
 
+  //! Return the width of the ray cone at the distance from the origin
+  Float footprint(const Float distance) const noexcept;
+
+  //! Return the reciprocal of the direction
+  const Vector3& inverseDirection() const noexcept;
+
   //! Check if the ray is alive
   bool isAlive() const noexcept;
 
@@ -48,12 +60,18 @@ class Ray
   //! Set ray alival
   void setAlive(const bool is_alive) noexcept;
 
+  //! Set the width at the origin and the spread angle of the ray cone
+  void setCone(const Float width, const Float spread) noexcept;
+
   //! Set ray direction
   void setDirection(const Vector3& direction) noexcept;
 
   //! Set ray origin
   void setOrigin(const Point3& origin) noexcept;
 
+  //! Return the bits which are set for the negative direction components
+  uint signBits() const noexcept;
+
  private:
   //! Create ray
   Ray(const Point3& origin, const Vector3& direction) noexcept;
@@ -61,11 +79,18 @@ class Ray
   //! Initialize the ray
   void initialize() noexcept;
 
+  //! Update the reciprocal and the signs of the direction
+  void setInverseDirection() noexcept;
+
 
   Point3 origin_;
   Vector3 direction_;
+  Vector3 inverse_direction_;
+  Float cone_width_;
+  Float cone_spread_;
   uint8 is_alive_;
-  std::array<uint8, 7> padding_;
+  uint8 sign_bits_;
+  std::array<uint8, 6> padding_;
 };
 
 //! \} Core
@@ -0,0 +1,107 @@
+/*!
+  \file ray_hit-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RAY_HIT_INL_HPP
+#define NANAIRO_RAY_HIT_INL_HPP
+
+#include "ray_hit.hpp"
+// Standard C++ library
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+RayHit::RayHit() noexcept :
+    RayHit(std::numeric_limits<Float>::max())
+{
+}
+
+/*!
+  */
+inline
+RayHit::RayHit(const Float max_distance) noexcept :
+    distance_{max_distance},
+    object_index_{noHitIndex()},
+    primitive_index_{0}
+{
+}
+
+/*!
+  */
+inline
+bool RayHit::isHit() const noexcept
+{
+  return object_index_ != noHitIndex();
+}
+
+/*!
+  */
+inline
+uint32 RayHit::objectIndex() const noexcept
+{
+  return object_index_;
+}
+
+/*!
+  */
+inline
+uint32 RayHit::primitiveIndex() const noexcept
+{
+  return primitive_index_;
+}
+
+/*!
+  */
+inline
+Float RayHit::rayDistance() const noexcept
+{
+  return distance_;
+}
+
+/*!
+  */
+inline
+void RayHit::set(const Float distance,
+                 const uint32 object_index,
+                 const uint32 primitive_index,
+                 const Point2& st) noexcept
+{
+  ZISC_ASSERT(distance < distance_, "The hit isn't closer than the current.");
+  st_ = st;
+  distance_ = distance;
+  object_index_ = object_index;
+  primitive_index_ = primitive_index;
+}
+
+/*!
+  */
+inline
+const Point2& RayHit::st() const noexcept
+{
+  return st_;
+}
+
+/*!
+  */
+inline
+constexpr uint32 RayHit::noHitIndex() noexcept
+{
+  return std::numeric_limits<uint32>::max();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_RAY_HIT_INL_HPP
@@ -0,0 +1,77 @@
+/*!
+  \file ray_hit.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RAY_HIT_HPP
+#define NANAIRO_RAY_HIT_HPP
+
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The closest hit of a ray which is tracked in the BVH traversal
+  \details
+  The hit holds only the distance, the object index, the primitive index
+  in the object and the st coordinate on the primitive, so the traversal updates a few registers
+  for each closer hit and the surface attributes are computed once
+  after the closest hit is found.
+  */
+class RayHit
+{
+ public:
+  //! Create a no hit record
+  RayHit() noexcept;
+
+  //! Create a no hit record within the max distance
+  RayHit(const Float max_distance) noexcept;
+
+
+  //! Check if the ray hits an object
+  bool isHit() const noexcept;
+
+  //! Return the index of the hit object
+  uint32 objectIndex() const noexcept;
+
+  //! Return the index of the hit primitive in the object
+  uint32 primitiveIndex() const noexcept;
+
+  //! Return the distance of the hit point, or the max distance if no hit
+  Float rayDistance() const noexcept;
+
+  //! Record a closer hit
+  void set(const Float distance,
+           const uint32 object_index,
+           const uint32 primitive_index,
+           const Point2& st) noexcept;
+
+  //! Return the st coordinate of the hit point on the object
+  const Point2& st() const noexcept;
+
+  //! Return the index which represents no hit
+  static constexpr uint32 noHitIndex() noexcept;
+
+ private:
+  Point2 st_;
+  Float distance_;
+  uint32 object_index_;
+  uint32 primitive_index_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "ray_hit-inl.hpp"
+
+#endif // NANAIRO_RAY_HIT_HPP
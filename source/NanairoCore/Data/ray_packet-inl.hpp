@@ -0,0 +1,205 @@
+/*!
+  \file ray_packet-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RAY_PACKET_INL_HPP
+#define NANAIRO_RAY_PACKET_INL_HPP
+
+#include "ray_packet.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "ray.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <uint kSize> inline
+RayPacket<kSize>::RayPacket() noexcept :
+    active_mask_{0},
+    sign_bits_{0},
+    is_coherent_{kFalse}
+{
+  for (uint axis = 0; axis < 3; ++axis) {
+    origin_[axis].fill(0.0);
+    inverse_direction_[axis].fill(0.0);
+  }
+  min_origin_.fill(0.0);
+  max_origin_.fill(0.0);
+  min_inverse_direction_.fill(0.0);
+  max_inverse_direction_.fill(0.0);
+}
+
+/*!
+  */
+template <uint kSize> inline
+uint32 RayPacket<kSize>::activeMask() const noexcept
+{
+  return active_mask_;
+}
+
+/*!
+  */
+template <uint kSize> inline
+bool RayPacket<kSize>::isCoherent() const noexcept
+{
+  return is_coherent_ == kTrue;
+}
+
+/*!
+  */
+template <uint kSize> inline
+const Ray& RayPacket<kSize>::ray(const uint index) const noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  return ray_list_[index];
+}
+
+/*!
+  */
+template <uint kSize> inline
+void RayPacket<kSize>::setRay(const uint index, const Ray& ray) noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  const uint32 bit = zisc::cast<uint32>(1) << index;
+  ZISC_ASSERT((active_mask_ & bit) == 0, "The ray is already set.");
+  const bool is_first = active_mask_ == 0;
+  ray_list_[index] = ray;
+
+  const auto& origin = ray.origin();
+  const auto& inverse_direction = ray.inverseDirection();
+  bool is_finite = true;
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float o = origin[axis];
+    const Float inv = inverse_direction[axis];
+    origin_[axis][index] = o;
+    inverse_direction_[axis][index] = inv;
+    min_origin_[axis] = is_first ? o : zisc::min(min_origin_[axis], o);
+    max_origin_[axis] = is_first ? o : zisc::max(max_origin_[axis], o);
+    min_inverse_direction_[axis] = is_first
+        ? inv
+        : zisc::min(min_inverse_direction_[axis], inv);
+    max_inverse_direction_[axis] = is_first
+        ? inv
+        : zisc::max(max_inverse_direction_[axis], inv);
+    is_finite = is_finite && std::isfinite(inv);
+  }
+  const bool has_same_signs = is_first || (sign_bits_ == ray.signBits());
+  const bool is_coherent = (is_first || isCoherent()) && has_same_signs && is_finite;
+  sign_bits_ = ray.signBits();
+  is_coherent_ = is_coherent ? kTrue : kFalse;
+  active_mask_ = active_mask_ | bit;
+}
+
+/*!
+  */
+template <uint kSize> inline
+constexpr uint RayPacket<kSize>::size() noexcept
+{
+  return kSize;
+}
+
+/*!
+  \details
+  The distance of a ray to a plane is bilinear in the origin and
+  the inverse direction, so its bounds over the packet are found at
+  the corners of their intervals. If the rays have the same direction
+  signs, all rays enter the box through the same planes,
+  so the packet misses the box if the interval slab test fails.
+  */
+template <uint kSize> inline
+bool RayPacket<kSize>::testFrustum(const Aabb& bounding_box,
+                                   const Float max_distance) const noexcept
+{
+  if (!isCoherent())
+    return true;
+
+  const auto bounds = [](const Float plane,
+                         const Float min_o,
+                         const Float max_o,
+                         const Float min_inv,
+                         const Float max_inv)
+  {
+    const Float d0 = plane - min_o;
+    const Float d1 = plane - max_o;
+    const Float t00 = d0 * min_inv;
+    const Float t01 = d0 * max_inv;
+    const Float t10 = d1 * min_inv;
+    const Float t11 = d1 * max_inv;
+    const Float t_lower = zisc::min(zisc::min(t00, t01), zisc::min(t10, t11));
+    const Float t_upper = zisc::max(zisc::max(t00, t01), zisc::max(t10, t11));
+    return std::array<Float, 2>{{t_lower, t_upper}};
+  };
+
+  Float tmin = 0.0;
+  Float tmax = max_distance;
+  for (uint axis = 0; axis < 3; ++axis) {
+    const bool is_negative = ((sign_bits_ >> axis) & 1) == 1;
+    const Float near_plane = is_negative ? bounding_box.maxPoint()[axis]
+                                         : bounding_box.minPoint()[axis];
+    const Float far_plane = is_negative ? bounding_box.minPoint()[axis]
+                                        : bounding_box.maxPoint()[axis];
+    const auto near_bounds = bounds(near_plane,
+                                    min_origin_[axis], max_origin_[axis],
+                                    min_inverse_direction_[axis],
+                                    max_inverse_direction_[axis]);
+    const auto far_bounds = bounds(far_plane,
+                                   min_origin_[axis], max_origin_[axis],
+                                   min_inverse_direction_[axis],
+                                   max_inverse_direction_[axis]);
+    tmin = zisc::max(tmin, near_bounds[0]);
+    tmax = zisc::min(tmax, far_bounds[1]);
+  }
+  return tmin <= tmax;
+}
+
+/*!
+  \details
+  The loops run over the rays for each axis without any branch,
+  so they can be compiled into SIMD instructions.
+  */
+template <uint kSize> inline
+uint32 RayPacket<kSize>::testIntersection(
+    const Aabb& bounding_box,
+    const DistanceList& max_distance_list) const noexcept
+{
+  DistanceList tmin;
+  DistanceList tmax = max_distance_list;
+  tmin.fill(0.0);
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float min_p = bounding_box.minPoint()[axis];
+    const Float max_p = bounding_box.maxPoint()[axis];
+    const auto& origin = origin_[axis];
+    const auto& inverse_direction = inverse_direction_[axis];
+    for (uint i = 0; i < kSize; ++i) {
+      const Float t0 = (min_p - origin[i]) * inverse_direction[i];
+      const Float t1 = (max_p - origin[i]) * inverse_direction[i];
+      tmin[i] = zisc::max(tmin[i], zisc::min(t0, t1));
+      tmax[i] = zisc::min(tmax[i], zisc::max(t0, t1));
+    }
+  }
+  uint32 hit_mask = 0;
+  for (uint i = 0; i < kSize; ++i) {
+    const uint32 is_hit = (tmin[i] <= tmax[i]) ? 1 : 0;
+    hit_mask = hit_mask | (is_hit << i);
+  }
+  return hit_mask & active_mask_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_RAY_PACKET_INL_HPP
@@ -0,0 +1,91 @@
+/*!
+  \file ray_packet.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RAY_PACKET_HPP
+#define NANAIRO_RAY_PACKET_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "ray.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Aabb;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Coherent rays which are traversed together
+  \details
+  The origins and the inverse directions are stored as SoA,
+  so a box is tested against all rays by a loop which can be vectorized.
+  The bounds of the origins and the inverse directions are kept for
+  the interval test which culls a box for the whole packet at once.
+  */
+template <uint kSize>
+class RayPacket
+{
+  static_assert((kSize == 4) || (kSize == 8) || (kSize == 16),
+                "The packet size isn't 4, 8 or 16.");
+
+ public:
+  using DistanceList = std::array<Float, kSize>;
+
+
+  //! Create an empty packet
+  RayPacket() noexcept;
+
+
+  //! Return the bit mask of the rays in the packet
+  uint32 activeMask() const noexcept;
+
+  //! Check if the rays have the same direction signs and finite inverse directions
+  bool isCoherent() const noexcept;
+
+  //! Return the ray
+  const Ray& ray(const uint index) const noexcept;
+
+  //! Set the ray
+  void setRay(const uint index, const Ray& ray) noexcept;
+
+  //! Return the number of slots of the packet
+  static constexpr uint size() noexcept;
+
+  //! Check if any ray of the packet can hit the box
+  bool testFrustum(const Aabb& bounding_box,
+                   const Float max_distance) const noexcept;
+
+  //! Test ray-box intersection and return the bit mask of the hit rays
+  uint32 testIntersection(const Aabb& bounding_box,
+                          const DistanceList& max_distance_list) const noexcept;
+
+ private:
+  std::array<Ray, kSize> ray_list_;
+  std::array<DistanceList, 3> origin_;
+  std::array<DistanceList, 3> inverse_direction_;
+  std::array<Float, 3> min_origin_;
+  std::array<Float, 3> max_origin_;
+  std::array<Float, 3> min_inverse_direction_;
+  std::array<Float, 3> max_inverse_direction_;
+  uint32 active_mask_;
+  uint sign_bits_;
+  uint8 is_coherent_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "ray_packet-inl.hpp"
+
+#endif // NANAIRO_RAY_PACKET_HPP
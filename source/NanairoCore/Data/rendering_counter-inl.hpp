@@ -0,0 +1,205 @@
+/*!
+  \file rendering_counter-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RENDERING_COUNTER_INL_HPP
+#define NANAIRO_RENDERING_COUNTER_INL_HPP
+
+#include "rendering_counter.hpp"
+// Standard C++ library
+#include <array>
+#include <chrono>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+RenderingCounter::RenderingCounter() noexcept
+{
+  clear();
+}
+
+/*!
+  */
+inline
+void RenderingCounter::addRay(const RayCastType type) noexcept
+{
+  ++ray_count_list_[zisc::cast<uint>(type)];
+}
+
+/*!
+  */
+inline
+void RenderingCounter::addRays(const RayCastType type,
+                               const uint64 num_of_rays) noexcept
+{
+  ray_count_list_[zisc::cast<uint>(type)] += num_of_rays;
+}
+
+/*!
+  */
+inline
+void RenderingCounter::addPath(const uint length) noexcept
+{
+  ++paths_;
+  path_length_ += length;
+}
+
+/*!
+  */
+inline
+void RenderingCounter::addPhoton() noexcept
+{
+  ++photons_;
+}
+
+/*!
+  */
+inline
+void RenderingCounter::addRouletteTermination() noexcept
+{
+  ++roulette_terminations_;
+}
+
+/*!
+  */
+inline
+void RenderingCounter::addTraversal(const uint64 num_of_visits,
+                                    const uint64 num_of_tests) noexcept
+{
+  node_visits_ += num_of_visits;
+  primitive_tests_ += num_of_tests;
+}
+
+/*!
+  */
+inline
+double RenderingCounter::averagePathLength() const noexcept
+{
+  const double length = (0 < paths_)
+      ? zisc::cast<double>(path_length_) / zisc::cast<double>(paths_)
+      : 0.0;
+  return length;
+}
+
+/*!
+  */
+inline
+void RenderingCounter::clear() noexcept
+{
+  ray_count_list_.fill(0);
+  node_visits_ = 0;
+  primitive_tests_ = 0;
+  paths_ = 0;
+  path_length_ = 0;
+  roulette_terminations_ = 0;
+  photons_ = 0;
+}
+
+/*!
+  */
+inline
+void RenderingCounter::merge(const RenderingCounter& other) noexcept
+{
+  for (uint i = 0; i < ray_count_list_.size(); ++i)
+    ray_count_list_[i] += other.ray_count_list_[i];
+  node_visits_ += other.node_visits_;
+  primitive_tests_ += other.primitive_tests_;
+  paths_ += other.paths_;
+  path_length_ += other.path_length_;
+  roulette_terminations_ += other.roulette_terminations_;
+  photons_ += other.photons_;
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::numOfNodeVisits() const noexcept
+{
+  return node_visits_;
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::numOfPaths() const noexcept
+{
+  return paths_;
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::numOfPhotons() const noexcept
+{
+  return photons_;
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::numOfPrimitiveTests() const noexcept
+{
+  return primitive_tests_;
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::numOfRays(const RayCastType type) const noexcept
+{
+  return ray_count_list_[zisc::cast<uint>(type)];
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::numOfRouletteTerminations() const noexcept
+{
+  return roulette_terminations_;
+}
+
+/*!
+  \details
+  The counter is read by rdtsc on x86 processors, which isn't serializing,
+  so it is enough for the cost of a path but not of a few instructions.
+  The steady clock in nanoseconds is used on the other processors.
+  */
+inline
+uint64 RenderingCounter::readTimeStamp() noexcept
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+  return zisc::cast<uint64>(__rdtsc());
+#else
+  const auto time = std::chrono::steady_clock::now().time_since_epoch();
+  return zisc::cast<uint64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+#endif
+}
+
+/*!
+  */
+inline
+uint64 RenderingCounter::totalRays() const noexcept
+{
+  return ray_count_list_[0] + ray_count_list_[1] + ray_count_list_[2];
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_RENDERING_COUNTER_INL_HPP
@@ -0,0 +1,114 @@
+/*!
+  \file rendering_counter.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RENDERING_COUNTER_HPP
+#define NANAIRO_RENDERING_COUNTER_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! The kinds of the rays which are counted
+enum class RayCastType : uint
+{
+  kPrimary = 0,
+  kSecondary,
+  kShadow
+};
+
+/*!
+  \details
+  The counts of the ray casts and the paths of a thread.
+  Each thread has its own counter, so the counts are plain integers,
+  and the counters of the threads are merged at the end of a cycle.
+  The counter is aligned to a cache line so that
+  the counters of the threads don't share a line.
+  */
+class alignas(64) RenderingCounter
+{
+ public:
+  //! Create a zero counter
+  RenderingCounter() noexcept;
+
+
+  //! Count a ray cast
+  void addRay(const RayCastType type) noexcept;
+
+  //! Count the rays of a packet
+  void addRays(const RayCastType type, const uint64 num_of_rays) noexcept;
+
+  //! Count a terminated path and its length
+  void addPath(const uint length) noexcept;
+
+  //! Count a stored photon
+  void addPhoton() noexcept;
+
+  //! Count a path terminated by russian roulette
+  void addRouletteTermination() noexcept;
+
+  //! Count the nodes visited and the primitives tested in a traversal
+  void addTraversal(const uint64 num_of_visits,
+                    const uint64 num_of_tests) noexcept;
+
+  //! Return the average length of the paths
+  double averagePathLength() const noexcept;
+
+  //! Set all counts to zero
+  void clear() noexcept;
+
+  //! Add the counts of the other counter
+  void merge(const RenderingCounter& other) noexcept;
+
+  //! Return the number of the BVH nodes visited
+  uint64 numOfNodeVisits() const noexcept;
+
+  //! Return the number of the paths
+  uint64 numOfPaths() const noexcept;
+
+  //! Return the number of the photons stored
+  uint64 numOfPhotons() const noexcept;
+
+  //! Return the number of the primitive intersection tests
+  uint64 numOfPrimitiveTests() const noexcept;
+
+  //! Return the number of the rays of the type
+  uint64 numOfRays(const RayCastType type) const noexcept;
+
+  //! Return the number of the paths terminated by russian roulette
+  uint64 numOfRouletteTerminations() const noexcept;
+
+  //! Return the time stamp counter of the processor
+  static uint64 readTimeStamp() noexcept;
+
+  //! Return the total number of the rays
+  uint64 totalRays() const noexcept;
+
+ private:
+  std::array<uint64, 3> ray_count_list_;
+  uint64 node_visits_;
+  uint64 primitive_tests_;
+  uint64 paths_;
+  uint64 path_length_;
+  uint64 roulette_terminations_;
+  uint64 photons_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "rendering_counter-inl.hpp"
+
+#endif // NANAIRO_RENDERING_COUNTER_HPP
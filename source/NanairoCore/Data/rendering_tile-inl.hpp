@@ -65,6 +65,29 @@ uint RenderingTile::getIndex(const Index2d& pixel) const noexcept
   return index;
 }
 
+/*!
+  \details
+  The image is split into the tiles of the rendering, and the pixels of
+  a tile are contiguous in the row-major order of the tile.
+  The tiles are ordered in the row-major order of the image,
+  so the tiles of the right and the bottom edges are smaller.
+  */
+inline
+uint RenderingTile::getTileMajorIndex(const Index2d& resolution,
+                                      const Index2d& pixel) noexcept
+{
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  const uint tile_x = pixel[0] / s;
+  const uint tile_y = pixel[1] / s;
+  const uint tile_width = zisc::min(s, resolution[0] - tile_x * s);
+  const uint tile_height = zisc::min(s, resolution[1] - tile_y * s);
+  const uint tile_offset = tile_y * s * resolution[0] + tile_x * s * tile_height;
+  const uint x = pixel[0] - tile_x * s;
+  const uint y = pixel[1] - tile_y * s;
+  const uint index = tile_offset + x + tile_width * y;
+  return index;
+}
+
 /*!
   */
 inline
@@ -41,6 +41,10 @@ class RenderingTile
   //! Return the index of the given pixel
   uint getIndex(const Index2d& pixel) const noexcept;
 
+  //! Return the index of the pixel in the tile-major layout of the image
+  static uint getTileMajorIndex(const Index2d& resolution,
+                                const Index2d& pixel) noexcept;
+
   //! Return the height resolution
   uint heightResolution() const noexcept;
 
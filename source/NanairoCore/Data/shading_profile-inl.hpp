@@ -0,0 +1,130 @@
+/*!
+  \file shading_profile-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SHADING_PROFILE_INL_HPP
+#define NANAIRO_SHADING_PROFILE_INL_HPP
+
+#include "shading_profile.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "rendering_counter.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The scopes nest when a shading evaluates another surface,
+  so the texture fetches are counted to the innermost surface.
+  */
+inline
+ShadingProfile::Scope::Scope(ShadingProfile* profile,
+                             const uint surface_index,
+                             const bool is_hit) noexcept :
+    cost_{nullptr},
+    parent_cost_{nullptr},
+    start_ticks_{0}
+{
+  if (profile != nullptr) {
+    ZISC_ASSERT(surface_index < profile->numOfSurfaces(),
+                "The surface index is out of range.");
+    cost_ = &profile->cost_list_[surface_index];
+    if (is_hit)
+      ++cost_->num_of_hits_;
+    parent_cost_ = current_cost_;
+    current_cost_ = cost_;
+    start_ticks_ = RenderingCounter::readTimeStamp();
+  }
+}
+
+/*!
+  */
+inline
+ShadingProfile::Scope::~Scope() noexcept
+{
+  if (cost_ != nullptr) {
+    cost_->ticks_ += RenderingCounter::readTimeStamp() - start_ticks_;
+    current_cost_ = parent_cost_;
+  }
+}
+
+/*!
+  */
+inline
+ShadingProfile::ShadingProfile(zisc::pmr::memory_resource* mem_resource) noexcept :
+    cost_list_{mem_resource}
+{
+}
+
+/*!
+  */
+inline
+void ShadingProfile::addTextureFetch() noexcept
+{
+  if (current_cost_ != nullptr)
+    ++current_cost_->texture_fetches_;
+}
+
+/*!
+  */
+inline
+void ShadingProfile::clear() noexcept
+{
+  for (auto& cost : cost_list_)
+    cost = ShadingCost{0, 0, 0};
+}
+
+/*!
+  */
+inline
+const ShadingCost& ShadingProfile::cost(const uint surface_index) const noexcept
+{
+  ZISC_ASSERT(surface_index < numOfSurfaces(), "The surface index is out of range.");
+  return cost_list_[surface_index];
+}
+
+/*!
+  */
+inline
+void ShadingProfile::merge(const ShadingProfile& other) noexcept
+{
+  if (numOfSurfaces() < other.numOfSurfaces())
+    cost_list_.resize(other.numOfSurfaces(), ShadingCost{0, 0, 0});
+  for (uint index = 0; index < other.numOfSurfaces(); ++index) {
+    const auto& c = other.cost_list_[index];
+    auto& cost = cost_list_[index];
+    cost.num_of_hits_ += c.num_of_hits_;
+    cost.ticks_ += c.ticks_;
+    cost.texture_fetches_ += c.texture_fetches_;
+  }
+}
+
+/*!
+  */
+inline
+uint ShadingProfile::numOfSurfaces() const noexcept
+{
+  return zisc::cast<uint>(cost_list_.size());
+}
+
+/*!
+  */
+inline
+void ShadingProfile::setNumOfSurfaces(const uint num_of_surfaces) noexcept
+{
+  cost_list_.resize(num_of_surfaces);
+  clear();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SHADING_PROFILE_INL_HPP
@@ -0,0 +1,18 @@
+/*!
+  \file shading_profile.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "shading_profile.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+thread_local ShadingCost* ShadingProfile::current_cost_ = nullptr;
+
+} // namespace nanairo
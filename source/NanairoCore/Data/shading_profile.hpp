@@ -0,0 +1,101 @@
+/*!
+  \file shading_profile.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SHADING_PROFILE_HPP
+#define NANAIRO_SHADING_PROFILE_HPP
+
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! The shading cost of a surface
+struct ShadingCost
+{
+  uint64 num_of_hits_;
+  uint64 ticks_; //!< The time stamp counts of the BxDF making, sampling and evaluation
+  uint64 texture_fetches_; //!< The image texture lookups
+};
+
+/*!
+  \details
+  The shading costs of the surfaces of a thread, which are indexed by
+  the index of the surface in the world. Each thread has its own profile
+  like the rendering counter, and the profiles are merged at the report.
+  A scope measures the time stamp counts of a shading of a surface,
+  and the image textures which are fetched in the scope are counted
+  to the surface.
+  */
+class ShadingProfile
+{
+ public:
+  /*!
+    \details
+    The scope does nothing if the profile is null,
+    so the disabled profile costs only a branch.
+    */
+  class Scope : public zisc::NonCopyable<Scope>
+  {
+   public:
+    //! Start measuring the shading of the surface
+    Scope(ShadingProfile* profile,
+          const uint surface_index,
+          const bool is_hit) noexcept;
+
+    //! Add the time stamp counts of the scope to the surface
+    ~Scope() noexcept;
+
+   private:
+    ShadingCost* cost_;
+    ShadingCost* parent_cost_;
+    uint64 start_ticks_;
+  };
+
+
+  //! Create an empty profile
+  ShadingProfile(zisc::pmr::memory_resource* mem_resource) noexcept;
+
+
+  //! Count an image texture fetch to the surface of the current scope
+  static void addTextureFetch() noexcept;
+
+  //! Set all costs to zero
+  void clear() noexcept;
+
+  //! Return the cost of the surface
+  const ShadingCost& cost(const uint surface_index) const noexcept;
+
+  //! Add the costs of the other profile
+  void merge(const ShadingProfile& other) noexcept;
+
+  //! Return the number of the surfaces
+  uint numOfSurfaces() const noexcept;
+
+  //! Set the number of the surfaces and clear the costs
+  void setNumOfSurfaces(const uint num_of_surfaces) noexcept;
+
+ private:
+  static thread_local ShadingCost* current_cost_;
+
+  zisc::pmr::vector<ShadingCost> cost_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "shading_profile-inl.hpp"
+
+#endif // NANAIRO_SHADING_PROFILE_HPP
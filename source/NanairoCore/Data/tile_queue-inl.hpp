@@ -0,0 +1,91 @@
+/*!
+  \file tile_queue-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TILE_QUEUE_INL_HPP
+#define NANAIRO_TILE_QUEUE_INL_HPP
+
+#include "tile_queue.hpp"
+// Standard C++ library
+#include <atomic>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+TileQueue::TileQueue(const uint num_of_tiles,
+                     const uint num_of_threads,
+                     const uint chunk_size,
+                     zisc::pmr::memory_resource* work_resource) noexcept :
+    cursor_list_{zisc::max(num_of_threads, 1u), work_resource},
+    num_of_tiles_{num_of_tiles},
+    chunk_size_{zisc::max(chunk_size, 1u)}
+{
+  for (uint range = 0; range < cursor_list_.size(); ++range)
+    cursor_list_[range].index_.store(rangeBegin(range), std::memory_order_relaxed);
+}
+
+/*!
+  \details
+  The ranges are visited from the next of the own range when stealing,
+  so the thieves of a range are spread over the threads.
+  */
+inline
+bool TileQueue::next(const uint thread_id, uint* begin, uint* end) noexcept
+{
+  const uint num_of_ranges = zisc::cast<uint>(cursor_list_.size());
+  const uint own_range = thread_id % num_of_ranges;
+  for (uint i = 0; i < num_of_ranges; ++i) {
+    const uint range = (own_range + i) % num_of_ranges;
+    if (take(range, begin, end))
+      return true;
+  }
+  return false;
+}
+
+/*!
+  */
+inline
+uint TileQueue::rangeBegin(const uint range) const noexcept
+{
+  const uint64 n = zisc::cast<uint64>(num_of_tiles_) * range / cursor_list_.size();
+  return zisc::cast<uint>(n);
+}
+
+/*!
+  */
+inline
+bool TileQueue::take(const uint range, uint* begin, uint* end) noexcept
+{
+  ZISC_ASSERT(begin != nullptr, "The begin is null.");
+  ZISC_ASSERT(end != nullptr, "The end is null.");
+  const uint range_end = (range + 1 < cursor_list_.size())
+      ? rangeBegin(range + 1)
+      : num_of_tiles_;
+  auto& cursor = cursor_list_[range].index_;
+  // Skip the fetch when the range is exhausted, so the cursor doesn't overflow
+  if (range_end <= cursor.load(std::memory_order_relaxed))
+    return false;
+  const uint b = cursor.fetch_add(chunk_size_, std::memory_order_relaxed);
+  if (range_end <= b)
+    return false;
+  *begin = b;
+  *end = zisc::min(b + chunk_size_, range_end);
+  return true;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TILE_QUEUE_INL_HPP
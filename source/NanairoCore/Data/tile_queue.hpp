@@ -0,0 +1,74 @@
+/*!
+  \file tile_queue.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TILE_QUEUE_HPP
+#define NANAIRO_TILE_QUEUE_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The tile indices of a cycle are split into contiguous ranges,
+  one range per thread. A thread takes the chunks of its own range first and
+  steals the chunks of the other ranges after its range is exhausted.
+  The range of a thread depends only on the thread id,
+  so a thread renders the same tiles in every cycle unless they are stolen.
+  */
+class TileQueue : public zisc::NonCopyable<TileQueue>
+{
+ public:
+  //! Create a queue of the tiles
+  TileQueue(const uint num_of_tiles,
+            const uint num_of_threads,
+            const uint chunk_size,
+            zisc::pmr::memory_resource* work_resource) noexcept;
+
+
+  //! Take the next chunk of the thread, return false if no tile is left
+  bool next(const uint thread_id, uint* begin, uint* end) noexcept;
+
+ private:
+  //! The cursor of a range, which doesn't share a cache line with the others
+  struct alignas(64) Cursor
+  {
+    std::atomic<uint> index_;
+  };
+
+
+  //! Return the first tile index of the range
+  uint rangeBegin(const uint range) const noexcept;
+
+  //! Take a chunk from the range
+  bool take(const uint range, uint* begin, uint* end) noexcept;
+
+
+  zisc::pmr::vector<Cursor> cursor_list_;
+  uint num_of_tiles_;
+  uint chunk_size_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "tile_queue-inl.hpp"
+
+#endif // NANAIRO_TILE_QUEUE_HPP
@@ -40,17 +40,15 @@ Point3 Aabb::centroid() const noexcept
   http://www.scratchapixel.com/lessons/3d-basic-lessons/lesson-7-intersecting-simple-shapes/ray-box-intersection/
   */
 inline
-IntersectionTestResult Aabb::testIntersection(const Ray& ray,
-                                              const Vector3& inv_dir) const noexcept
+IntersectionTestResult Aabb::testIntersection(const Ray& ray) const noexcept
 {
-  auto t0 = (minPoint() - ray.origin()).data() * inv_dir.data();
-  auto t1 = (maxPoint() - ray.origin()).data() * inv_dir.data();
-  for (uint i = 0; i < inv_dir.size(); ++i) {
-    if (inv_dir[i] < 0.0)
-      std::swap(t0[i], t1[i]);
-  }
-  const Float tmin = zisc::max(zisc::max(t0[0], t0[1]), t0[2]);
-  const Float tmax = zisc::min(zisc::min(t1[0], t1[1]), t1[2]);
+  const auto& inv_dir = ray.inverseDirection();
+  const auto t0 = (minPoint() - ray.origin()).data() * inv_dir.data();
+  const auto t1 = (maxPoint() - ray.origin()).data() * inv_dir.data();
+  const auto t_near = zisc::minElements(t0, t1);
+  const auto t_far = zisc::maxElements(t0, t1);
+  const Float tmin = zisc::max(zisc::max(t_near[0], t_near[1]), t_near[2]);
+  const Float tmax = zisc::min(zisc::min(t_far[0], t_far[1]), t_far[2]);
 
   const auto result = (tmin <= tmax) ? IntersectionTestResult{tmin}
                                      : IntersectionTestResult{};
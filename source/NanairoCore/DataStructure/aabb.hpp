@@ -42,8 +42,7 @@ class Aabb
   Point3 centroid() const noexcept;
 
   //! Test ray-AABB intersection
-  IntersectionTestResult testIntersection(const Ray& ray,
-                                          const Vector3& inv_dir) const noexcept;
+  IntersectionTestResult testIntersection(const Ray& ray) const noexcept;
 
   //! Return the longest axis number
   uint longestAxis() const noexcept;
@@ -0,0 +1,212 @@
+/*!
+  \file aabb_n-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_AABB_N_INL_HPP
+#define NANAIRO_AABB_N_INL_HPP
+
+#include "aabb_n.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <uint kWidth> inline
+AabbN<kWidth>::AabbN() noexcept :
+    valid_mask_{0}
+{
+  for (uint axis = 0; axis < 3; ++axis) {
+    min_point_[axis].fill(0.0f);
+    max_point_[axis].fill(0.0f);
+  }
+}
+
+/*!
+  */
+template <uint kWidth> inline
+Aabb AabbN<kWidth>::get(const uint index) const noexcept
+{
+  ZISC_ASSERT(index < width(), "The lane index is out of range.");
+  const Point3 min_point{zisc::cast<Float>(min_point_[0][index]),
+                         zisc::cast<Float>(min_point_[1][index]),
+                         zisc::cast<Float>(min_point_[2][index])};
+  const Point3 max_point{zisc::cast<Float>(max_point_[0][index]),
+                         zisc::cast<Float>(max_point_[1][index]),
+                         zisc::cast<Float>(max_point_[2][index])};
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  */
+template <uint kWidth> inline
+bool AabbN<kWidth>::isValid(const uint index) const noexcept
+{
+  ZISC_ASSERT(index < width(), "The lane index is out of range.");
+  return ((valid_mask_ >> index) & 1u) == 1u;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+void AabbN<kWidth>::reset(const uint index) noexcept
+{
+  ZISC_ASSERT(index < width(), "The lane index is out of range.");
+  for (uint axis = 0; axis < 3; ++axis) {
+    min_point_[axis][index] = 0.0f;
+    max_point_[axis][index] = 0.0f;
+  }
+  valid_mask_ = valid_mask_ & ~(1u << index);
+}
+
+/*!
+  */
+template <uint kWidth> inline
+void AabbN<kWidth>::set(const uint index, const Aabb& box) noexcept
+{
+  ZISC_ASSERT(index < width(), "The lane index is out of range.");
+  for (uint axis = 0; axis < 3; ++axis) {
+    min_point_[axis][index] = toLowerFloat(box.minPoint()[axis]);
+    max_point_[axis][index] = toUpperFloat(box.maxPoint()[axis]);
+  }
+  valid_mask_ = valid_mask_ | (1u << index);
+}
+
+/*!
+  \details
+  The slab test is calculated in single precision, and the far distance is
+  enlarged by the bound of the rounding errors of the test. Please see
+  "Robust BVH Ray Traversal" for the details.
+  The entry distances are lowered so that the culling by them is conservative.
+  */
+template <uint kWidth> inline
+uint32 AabbN<kWidth>::testIntersection(
+    const Ray& ray,
+    const Float max_distance,
+    DistanceList* distance_list) const noexcept
+{
+  ZISC_ASSERT(distance_list != nullptr, "The distance list is null.");
+  // The bound of the rounding errors of three operations
+  constexpr float e = 0.5f * std::numeric_limits<float>::epsilon();
+  constexpr float gamma3 = (3.0f * e) / (1.0f - 3.0f * e);
+  constexpr float k = 1.0f + 2.0f * gamma3;
+  constexpr float lower_k = 1.0f - 2.0f * gamma3;
+
+  std::array<float, kWidth> tmin;
+  std::array<float, kWidth> tmax;
+  tmin.fill(0.0f);
+  tmax.fill(toUpperFloat(max_distance));
+  const auto& origin = ray.origin();
+  const auto& inv_dir = ray.inverseDirection();
+  for (uint axis = 0; axis < 3; ++axis) {
+    const float o = zisc::cast<float>(origin[axis]);
+    const float inv = zisc::cast<float>(inv_dir[axis]);
+    const auto& min_point = min_point_[axis];
+    const auto& max_point = max_point_[axis];
+    for (uint i = 0; i < kWidth; ++i) {
+      const float t0 = (min_point[i] - o) * inv;
+      const float t1 = (max_point[i] - o) * inv;
+      tmin[i] = zisc::max(tmin[i], zisc::min(t0, t1));
+      tmax[i] = zisc::min(tmax[i], k * zisc::max(t0, t1));
+    }
+  }
+  uint32 hit_mask = 0;
+  for (uint i = 0; i < kWidth; ++i) {
+    const uint32 is_hit = (tmin[i] <= tmax[i]) ? 1 : 0;
+    hit_mask = hit_mask | (is_hit << i);
+    (*distance_list)[i] = zisc::cast<Float>(lower_k * tmin[i]);
+  }
+  return hit_mask & valid_mask_;
+}
+
+/*!
+  \details
+  The squared distance from the center to each box is accumulated per axis.
+  The center is rounded to float in which the distance is calculated,
+  so the radius is enlarged slightly to keep the test conservative.
+  */
+template <uint kWidth> inline
+uint32 AabbN<kWidth>::testOverlap(const Point3& center,
+                                  const Float radius2) const noexcept
+{
+  constexpr float k = 1.0f + 8.0f * std::numeric_limits<float>::epsilon();
+  std::array<float, kWidth> distance2;
+  distance2.fill(0.0f);
+  for (uint axis = 0; axis < 3; ++axis) {
+    const float c = zisc::cast<float>(center[axis]);
+    const auto& min_point = min_point_[axis];
+    const auto& max_point = max_point_[axis];
+    for (uint i = 0; i < kWidth; ++i) {
+      const float d = zisc::max(zisc::max(min_point[i] - c, c - max_point[i]),
+                                0.0f);
+      distance2[i] = distance2[i] + d * d;
+    }
+  }
+  const float r2 = k * toUpperFloat(radius2);
+  uint32 overlap_mask = 0;
+  for (uint i = 0; i < kWidth; ++i) {
+    const uint32 is_overlapped = (distance2[i] <= r2) ? 1 : 0;
+    overlap_mask = overlap_mask | (is_overlapped << i);
+  }
+  return overlap_mask & valid_mask_;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+uint32 AabbN<kWidth>::validMask() const noexcept
+{
+  return valid_mask_;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+constexpr uint AabbN<kWidth>::width() noexcept
+{
+  return kWidth;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+float AabbN<kWidth>::toLowerFloat(const Float value) noexcept
+{
+  const float v = zisc::cast<float>(value);
+  return (value < zisc::cast<Float>(v))
+      ? std::nextafter(v, -std::numeric_limits<float>::infinity())
+      : v;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+float AabbN<kWidth>::toUpperFloat(const Float value) noexcept
+{
+  const float v = zisc::cast<float>(value);
+  return (zisc::cast<Float>(v) < value)
+      ? std::nextafter(v, std::numeric_limits<float>::infinity())
+      : v;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_AABB_N_INL_HPP
@@ -0,0 +1,98 @@
+/*!
+  \file aabb_n.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_AABB_N_HPP
+#define NANAIRO_AABB_N_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Ray;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief kWidth AABBs which are tested at once
+  \details
+  The boxes are stored as SoA in single precision,
+  so the tests run over the boxes for each axis without any branch
+  and can be compiled into SIMD instructions.
+  The boxes are rounded outward when they are set and
+  the tests are made conservative, so no hit is missed.
+  A lane which isn't set never hits.
+  */
+template <uint kWidth>
+class AabbN
+{
+  static_assert((kWidth == 4) || (kWidth == 8), "The width isn't 4 or 8.");
+
+ public:
+  using DistanceList = std::array<Float, kWidth>;
+
+
+  //! Create boxes which have no lane
+  AabbN() noexcept;
+
+
+  //! Return the box of the lane
+  Aabb get(const uint index) const noexcept;
+
+  //! Check if the lane is set
+  bool isValid(const uint index) const noexcept;
+
+  //! Reset the lane
+  void reset(const uint index) noexcept;
+
+  //! Set the box to the lane
+  void set(const uint index, const Aabb& box) noexcept;
+
+  //! Test ray-boxes intersection and return the bit mask of the hit lanes
+  uint32 testIntersection(const Ray& ray,
+                          const Float max_distance,
+                          DistanceList* distance_list) const noexcept;
+
+  //! Test sphere-boxes overlap and return the bit mask of the overlapped lanes
+  uint32 testOverlap(const Point3& center, const Float radius2) const noexcept;
+
+  //! Return the bit mask of the set lanes
+  uint32 validMask() const noexcept;
+
+  //! Return the number of the lanes
+  static constexpr uint width() noexcept;
+
+  //! Return the largest float which is less than or equal to the value
+  static float toLowerFloat(const Float value) noexcept;
+
+  //! Return the smallest float which is greater than or equal to the value
+  static float toUpperFloat(const Float value) noexcept;
+
+ private:
+  std::array<std::array<float, kWidth>, 3> min_point_;
+  std::array<std::array<float, kWidth>, 3> max_point_;
+  uint32 valid_mask_;
+};
+
+using Aabb4 = AabbN<4>;
+using Aabb8 = AabbN<8>;
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "aabb_n-inl.hpp"
+
+#endif // NANAIRO_AABB_N_HPP
@@ -11,6 +11,7 @@
 // Standard C++ library
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <functional>
 #include <limits>
 #include <tuple>
@@ -103,17 +104,17 @@ Float AgglomerativeTreeletRestructuringBvh::calcNodeDistance(
 void AgglomerativeTreeletRestructuringBvh::constructBvh(
     System& system,
     const zisc::pmr::vector<Object>& object_list,
-    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+    zisc::pmr::vector<BvhBuildingNode>& tree) noexcept
 {
   // Make a simple BVH tree using fast construction algorithm
-  BinaryRadixTreeBvh::constructBinaryRadixTreeBvh(system, object_list, tree);
-
-  auto work_resource = tree.get_allocator().resource();
-  RestructuringData data{treeletSize(), work_resource};;
-  for (uint i = 0; i < optimizationLoopCount(); ++i) {
-    constexpr bool threading = threadingIsEnabled();
-    restructureTreelet<threading>(system, 0, data, tree);
-  }
+  BinaryRadixTreeBvh::constructBinaryRadixTreeBvh(system, object_list, tree,
+                                                  isExtendedMortonCodeEnabled(),
+                                                  &buildPhaseList());
+
+  const auto start_time = system.stopwatch().elapsedTime();
+  for (uint i = 0; i < optimizationLoopCount(); ++i)
+    restructureTreelets(system, tree);
+  recordBuildPhase(system, "Treelet restructuring", start_time, &buildPhaseList());
 }
 
 /*!
@@ -296,58 +297,83 @@ uint AgglomerativeTreeletRestructuringBvh::optimizationLoopCount() const noexcep
   \details
   No detailed.
   */
-template <bool threading>
-uint AgglomerativeTreeletRestructuringBvh::restructureTreelet(
-    System& system,
+void AgglomerativeTreeletRestructuringBvh::restructureTreelet(
     const uint32 index,
+    const uint32 num_of_subtree_nodes,
     RestructuringData& data,
     zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
 {
   ZISC_ASSERT(index < tree.size(), "BVH tree is buffer overrun!!.");
-  auto& root = tree[index];
-  uint num_of_subtree_nodes = 1;
-  if (!root.isLeafNode()) {
-    if (threading) {
-      auto work_resource = tree.get_allocator().resource();
-      auto restructure_left_treelet = [this, &system, &root, &data, &tree]()
-      {
-        return restructureTreelet<>(system, root.leftChildIndex(), data, tree);
-      };
-      auto restructure_right_treelet = [this, &system, &root, &tree, work_resource]()
-      {
-        RestructuringData d{treeletSize(), work_resource};
-        return restructureTreelet<>(system, root.rightChildIndex(), d, tree);
-      };
-      auto& threads = system.threadManager();
-      auto left_result = threads.enqueue<uint>(restructure_left_treelet,
-                                               work_resource);
-      auto right_result = threads.enqueue<uint>(restructure_right_treelet,
-                                                work_resource);
-      num_of_subtree_nodes += left_result.get();
-      num_of_subtree_nodes += right_result.get();
-    }
-    else {
-      num_of_subtree_nodes +=
-          restructureTreelet<>(system, root.leftChildIndex(), data, tree);
-      num_of_subtree_nodes +=
-          restructureTreelet<>(system, root.rightChildIndex(), data, tree);
-    }
+  ZISC_ASSERT(3 <= num_of_subtree_nodes, "Lack of nodes.");
+  const auto& root = tree[index];
+  // Check the number of nodes in the subtree
+  if (num_of_subtree_nodes == 3) {
+    buildRelationship(index, root.leftChildIndex(), root.rightChildIndex(), tree);
+  }
+  else {
+    const uint num_of_leafs = (num_of_subtree_nodes >> 1) + 1;
+    const uint treelet_size = (num_of_leafs < treeletSize())
+        ? num_of_leafs
+        : treeletSize();
+    formTreelet(treelet_size, index, tree, data);
+    constructOptimalTreelet(data, tree);
+  }
+}
 
-    ZISC_ASSERT(3 <= num_of_subtree_nodes, "Lack of nodes.");
-    // Check the number of nodes in the subtree
-    if (num_of_subtree_nodes == 3) {
-      buildRelationship(index, root.leftChildIndex(), root.rightChildIndex(), tree);
-    }
-    else {
-      const auto num_of_leafs = (num_of_subtree_nodes >> 1) + 1;
-      const auto treelet_size = (num_of_leafs < treeletSize())
-          ? num_of_leafs
-          : treeletSize();
-      formTreelet(treelet_size, index, tree, data);
-      constructOptimalTreelet(data, tree);
+/*!
+  \details
+  The treelets are restructured bottom-up. Each thread walks up from
+  the leaves of its range and the second thread which reaches a node
+  restructures the treelet of the node, so the subtrees of the node are
+  already restructured and the threads work on disjoint treelets
+  from the bottom level to the root.
+  The leaves of the radix tree are placed after the inner nodes and
+  a restructuring only permutes the inner nodes, so the leaf range is kept.
+  */
+void AgglomerativeTreeletRestructuringBvh::restructureTreelets(
+    System& system,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  auto& threads = system.threadManager();
+  auto work_resource = tree.get_allocator().resource();
+  const uint32 num_of_nodes = zisc::cast<uint32>(tree.size());
+  const uint32 num_of_inner_nodes = num_of_nodes >> 1;
+  const uint32 num_of_leafs = num_of_nodes - num_of_inner_nodes;
+
+  zisc::pmr::vector<std::atomic<uint32>> visit_count_list{num_of_inner_nodes,
+                                                          work_resource};
+  for (auto& count : visit_count_list)
+    count.store(0, std::memory_order_relaxed);
+  zisc::pmr::vector<uint32> subtree_size_list{work_resource};
+  subtree_size_list.resize(num_of_nodes, 1);
+
+  auto restructure_treelets =
+  [this, &system, &tree, &visit_count_list, &subtree_size_list,
+   work_resource, num_of_inner_nodes, num_of_leafs](const uint task_id)
+  {
+    RestructuringData data{treeletSize(), work_resource};
+    const auto range = system.calcTaskRange(num_of_leafs, task_id);
+    for (uint32 i = range[0]; i < range[1]; ++i) {
+      uint32 index = tree[num_of_inner_nodes + i].parentIndex();
+      while (index != BvhBuildingNode::nullIndex()) {
+        ZISC_ASSERT(index < num_of_inner_nodes, "The node isn't inner node.");
+        // The first visitor leaves the node to the visitor of the other child
+        const auto count = visit_count_list[index].fetch_add(
+            1, std::memory_order_acq_rel);
+        if (count == 0)
+          break;
+        const auto& node = tree[index];
+        subtree_size_list[index] = 1 + subtree_size_list[node.leftChildIndex()] +
+                                   subtree_size_list[node.rightChildIndex()];
+        restructureTreelet(index, subtree_size_list[index], data, tree);
+        index = tree[index].parentIndex();
+      }
     }
-  }
-  return num_of_subtree_nodes;
+  };
+  constexpr uint start = 0;
+  const uint end = threads.numOfThreads();
+  auto result = threads.enqueueLoop(restructure_treelets, start, end, work_resource);
+  result.wait();
 }
 
 /*!
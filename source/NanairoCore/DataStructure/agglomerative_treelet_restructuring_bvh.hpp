@@ -71,7 +71,7 @@ class AgglomerativeTreeletRestructuringBvh : public Bvh
   void constructBvh(
       System& system,
       const zisc::pmr::vector<Object>& object_list,
-      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept override;
+      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept override;
 
   //! Construct the optimal binary treelet
   void constructOptimalTreelet(
@@ -99,13 +99,16 @@ class AgglomerativeTreeletRestructuringBvh : public Bvh
   //! Return the optimization loop count
   uint optimizationLoopCount() const noexcept;
 
-  //! Restructure a treelet
-  template <bool threading = false>
-  uint restructureTreelet(System& system,
-                          const uint32 index,
+  //! Restructure the treelet of the node
+  void restructureTreelet(const uint32 index,
+                          const uint32 num_of_subtree_nodes,
                           RestructuringData& data,
                           zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept;
 
+  //! Restructure the treelets of the tree bottom-up in parallel
+  void restructureTreelets(System& system,
+                           zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept;
+
   //! Return the treelet size
   uint treeletSize() const noexcept;
 
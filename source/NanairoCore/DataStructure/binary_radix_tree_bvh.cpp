@@ -27,6 +27,7 @@
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Data/object.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
@@ -47,7 +48,9 @@ BinaryRadixTreeBvh::BinaryRadixTreeBvh(System& system,
 void BinaryRadixTreeBvh::constructBinaryRadixTreeBvh(
     System& system,
     const zisc::pmr::vector<Object>& object_list,
-    zisc::pmr::vector<BvhBuildingNode>& tree) noexcept
+    zisc::pmr::vector<BvhBuildingNode>& tree,
+    const bool is_extended,
+    zisc::pmr::vector<BvhBuildPhase>* phase_list) noexcept
 {
   const auto num_of_nodes = 2 * object_list.size() - 1;
   tree.resize(num_of_nodes);
@@ -57,21 +60,29 @@ void BinaryRadixTreeBvh::constructBinaryRadixTreeBvh(
   zisc::pmr::vector<BvhBuildingNode> leaf_node_list{work_resource};
   zisc::pmr::vector<MortonCode> morton_code_list{work_resource};
   {
+    const auto start_time = system.stopwatch().elapsedTime();
     leaf_node_list.reserve(object_list.size());
     for (const auto& object : object_list)
       leaf_node_list.emplace_back(&object);
-    morton_code_list = MortonCode::makeList(leaf_node_list);
+    morton_code_list = MortonCode::makeList(system, leaf_node_list, is_extended);
+    recordBuildPhase(system, "Morton code", start_time, phase_list);
+  }
+  {
+    const auto start_time = system.stopwatch().elapsedTime();
+    MortonCode::sort(system, &morton_code_list);
+    recordBuildPhase(system, "Morton sort", start_time, phase_list);
   }
 
-  constexpr bool threading = threadingIsEnabled();
   {
+    const auto start_time = system.stopwatch().elapsedTime();
     auto first = morton_code_list.begin();
     auto begin = first;
     auto end = morton_code_list.end();
     constexpr uint key_bit = 8 * sizeof(MortonCode::CodeType) - 1;
-    split<threading>(system, key_bit, 0, tree, first, begin, end);
+    split(system, key_bit, 0, tree, first, begin, end);
+    setupBoundingBoxes(system, tree, 0);
+    recordBuildPhase(system, "Radix tree", start_time, phase_list);
   }
-  setupBoundingBoxes<threading>(system, tree, 0);
 }
 
 /*!
@@ -81,23 +92,24 @@ void BinaryRadixTreeBvh::constructBinaryRadixTreeBvh(
 void BinaryRadixTreeBvh::constructBvh(
     System& system,
     const zisc::pmr::vector<Object>& object_list,
-    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+    zisc::pmr::vector<BvhBuildingNode>& tree) noexcept
 {
-  constructBinaryRadixTreeBvh(system, object_list, tree);
+  constructBinaryRadixTreeBvh(system, object_list, tree,
+                              isExtendedMortonCodeEnabled(), &buildPhaseList());
 }
 
 /*!
   \details
   No detailed.
   */
-template <bool threading>
 void BinaryRadixTreeBvh::split(System& system,
                                uint bit,
                                const uint32 index,
                                zisc::pmr::vector<BvhBuildingNode>& tree,
                                MortonCode::Iterator first,
                                MortonCode::Iterator begin,
-                               MortonCode::Iterator end) noexcept
+                               MortonCode::Iterator end,
+                               const uint depth) noexcept
 {
   using zisc::cast;
 
@@ -124,31 +136,26 @@ void BinaryRadixTreeBvh::split(System& system,
     right_child_index = (std::distance(split_position, end) == 1)
         ? right_child_index + internal_node_size // Leaf node
         : right_child_index; // Internal node
-    if (threading) {
+    const auto key = (0 < bit) ? bit - 1 : bit;
+    auto& scheduler = system.taskScheduler();
+    if (threadingIsEnabled() && (depth < scheduler.forkDepth())) {
+      TaskGroup group{scheduler};
       auto split_left_range =
-      [&system, bit, left_child_index, &tree, first, begin, split_position]()
+      [&system, key, left_child_index, &tree, first, begin, split_position, depth]()
       {
-        const auto key = (0 < bit) ? bit - 1 : bit;
-        split<>(system, key, left_child_index, tree, first, begin, split_position);
+        split(system, key, left_child_index, tree, first, begin, split_position,
+              depth + 1);
       };
-      auto split_right_range =
-      [&system, bit, right_child_index, &tree, first, split_position, end]()
-      {
-        const auto key = (0 < bit) ? bit - 1 : bit;
-        split<>(system, key, right_child_index, tree, first, split_position, end);
-      };
-
-      auto work_resource = tree.get_allocator().resource();
-      auto& threads = system.threadManager();
-      auto left_result = threads.enqueue<void>(split_left_range, work_resource);
-      auto right_result = threads.enqueue<void>(split_right_range, work_resource);
-      left_result.wait();
-      right_result.wait();
+      group.run(split_left_range);
+      split(system, key, right_child_index, tree, first, split_position, end,
+            depth + 1);
+      group.wait();
     }
     else {
-      const auto key = (0 < bit) ? bit - 1 : bit;
-      split<>(system, key, left_child_index, tree, first, begin, split_position);
-      split<>(system, key, right_child_index, tree, first, split_position, end);
+      split(system, key, left_child_index, tree, first, begin, split_position,
+            depth + 1);
+      split(system, key, right_child_index, tree, first, split_position, end,
+            depth + 1);
     }
 
     ZISC_ASSERT(tree[index].parentIndex() == BvhBuildingNode::nullIndex(),
@@ -49,24 +49,26 @@ class BinaryRadixTreeBvh : public Bvh
   static void constructBinaryRadixTreeBvh(
       System& system,
       const zisc::pmr::vector<Object>& object_list,
-      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept;
+      zisc::pmr::vector<BvhBuildingNode>& tree,
+      const bool is_extended,
+      zisc::pmr::vector<BvhBuildPhase>* phase_list) noexcept;
 
  private:
   //! Build a binary radix tree BVH
   void constructBvh(
       System& system,
       const zisc::pmr::vector<Object>& object_list,
-      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept override;
+      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept override;
 
   //! Split leaf node list using the morton code
-  template <bool threading = false>
   static void split(System& system,
                     uint bit,
                     const uint32 index,
                     zisc::pmr::vector<BvhBuildingNode>& tree,
                     MortonCode::Iterator first,
                     MortonCode::Iterator begin,
-                    MortonCode::Iterator end) noexcept;
+                    MortonCode::Iterator end,
+                    const uint depth = 0) noexcept;
 };
 
 //! \} Core
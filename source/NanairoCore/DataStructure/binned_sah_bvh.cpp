@@ -0,0 +1,897 @@
+/*!
+  \file binned_sah_bvh.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "binned_sah_bvh.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+BinnedSahBvh::BinnedSahBvh(System& system,
+                           const SettingNodeBase* settings) noexcept :
+    Bvh(system, settings)
+{
+  initialize(settings);
+}
+
+/*!
+  */
+BinnedSahBvh::Workspace::Workspace(zisc::pmr::memory_resource* work_resource)
+    noexcept :
+        bin_list_{work_resource},
+        right_cost_list_{work_resource},
+        spatial_bin_list_{work_resource},
+        right_box_list_{work_resource}
+{
+}
+
+/*!
+  */
+inline
+void BinnedSahBvh::addToBin(const ObjectReference& reference, Bin* bin) noexcept
+{
+  bin->bounding_box_ = (bin->num_of_objects_ == 0)
+      ? reference.bounding_box_
+      : combine(bin->bounding_box_, reference.bounding_box_);
+  bin->cost_ += reference.cost_;
+  ++bin->num_of_objects_;
+}
+
+/*!
+  \details
+  If the system is given, the objects are binned by all threads and
+  the bins of the threads are merged.
+  */
+void BinnedSahBvh::binObjects(
+    System* system,
+    const Aabb& centroid_box,
+    const zisc::pmr::vector<ObjectReference>& reference_list,
+    const uint32 begin,
+    const uint32 end,
+    Workspace& workspace) const noexcept
+{
+  const uint num_of_bins = numOfBins();
+  auto& bin_list = workspace.bin_list_;
+  bin_list.assign(3 * num_of_bins, Bin{});
+
+  const auto bin_objects = [this, &centroid_box, &reference_list](
+      const uint32 first,
+      const uint32 last,
+      Bin* bins)
+  {
+    const uint n = numOfBins();
+    for (uint32 i = first; i < last; ++i) {
+      const auto& reference = reference_list[i];
+      for (uint axis = 0; axis < 3; ++axis) {
+        const uint bin_index = calcBinIndex(reference, centroid_box, axis);
+        addToBin(reference, &bins[axis * n + bin_index]);
+      }
+    }
+  };
+
+  // Sequence
+  if (system == nullptr) {
+    bin_objects(begin, end, bin_list.data());
+    return;
+  }
+
+  // Threading
+  auto& threads = system->threadManager();
+  const uint num_of_threads = threads.numOfThreads();
+  auto work_resource = bin_list.get_allocator().resource();
+  zisc::pmr::vector<Bin> thread_bin_list{work_resource};
+  thread_bin_list.resize(num_of_threads * bin_list.size());
+  {
+    auto bin_chunk = [system, begin, end, &bin_list, &thread_bin_list, &bin_objects]
+    (const uint task_id)
+    {
+      const auto range = system->calcTaskRange(end - begin, task_id);
+      Bin* bins = thread_bin_list.data() + task_id * bin_list.size();
+      bin_objects(begin + range[0], begin + range[1], bins);
+    };
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(bin_chunk, start, num_of_threads, work_resource);
+    result.wait();
+  }
+  for (uint task_id = 0; task_id < num_of_threads; ++task_id) {
+    const Bin* bins = thread_bin_list.data() + task_id * bin_list.size();
+    for (uint i = 0; i < bin_list.size(); ++i) {
+      const auto& src = bins[i];
+      if (src.num_of_objects_ == 0)
+        continue;
+      auto& dst = bin_list[i];
+      dst.bounding_box_ = (dst.num_of_objects_ == 0)
+          ? src.bounding_box_
+          : combine(dst.bounding_box_, src.bounding_box_);
+      dst.cost_ += src.cost_;
+      dst.num_of_objects_ += src.num_of_objects_;
+    }
+  }
+}
+
+/*!
+  */
+inline
+uint BinnedSahBvh::calcBinIndex(const ObjectReference& reference,
+                                const Aabb& centroid_box,
+                                const uint axis) const noexcept
+{
+  const Float min_c = centroid_box.minPoint()[axis];
+  const Float extent = centroid_box.maxPoint()[axis] - min_c;
+  uint bin_index = 0;
+  if (0.0 < extent) {
+    const Float k = zisc::cast<Float>(numOfBins()) / extent;
+    bin_index = zisc::cast<uint>(k * (reference.centroid_[axis] - min_c));
+    bin_index = zisc::min(bin_index, numOfBins() - 1);
+  }
+  return bin_index;
+}
+
+/*!
+  */
+Aabb BinnedSahBvh::calcCentroidBox(
+    const zisc::pmr::vector<ObjectReference>& reference_list,
+    const uint32 begin,
+    const uint32 end) noexcept
+{
+  auto min_point = reference_list[begin].centroid_.data();
+  auto max_point = min_point;
+  for (uint32 i = begin + 1; i < end; ++i) {
+    const auto& centroid = reference_list[i].centroid_.data();
+    min_point = zisc::minElements(min_point, centroid);
+    max_point = zisc::maxElements(max_point, centroid);
+  }
+  return Aabb{Point3{min_point}, Point3{max_point}};
+}
+
+/*!
+  */
+inline
+uint BinnedSahBvh::calcSpatialBinIndex(const Aabb& node_box,
+                                       const uint axis,
+                                       const Float position) const noexcept
+{
+  const Float min_p = node_box.minPoint()[axis];
+  const Float extent = node_box.maxPoint()[axis] - min_p;
+  ZISC_ASSERT(0.0 < extent, "The extent of the node isn't positive.");
+  const Float k = zisc::cast<Float>(numOfBins()) / extent;
+  const Float position_in_bins = zisc::max(k * (position - min_p),
+                                               zisc::cast<Float>(0.0));
+  const uint bin_index = zisc::cast<uint>(position_in_bins);
+  return zisc::min(bin_index, numOfBins() - 1);
+}
+
+/*!
+  \details
+  A triangle is clipped exactly, so the bounding box of the piece is tight.
+  The other shapes are clipped by their bounding boxes.
+  */
+Aabb BinnedSahBvh::clipReference(const ObjectReference& reference,
+                                 const uint axis,
+                                 const Float lower,
+                                 const Float upper) noexcept
+{
+  auto min_point = reference.bounding_box_.minPoint();
+  auto max_point = reference.bounding_box_.maxPoint();
+  min_point[axis] = zisc::max(min_point[axis], lower);
+  max_point[axis] = zisc::min(max_point[axis], upper);
+
+  const auto& shape = reference.object_->shape();
+  if (shape.type() == ShapeType::kMesh) {
+    const auto triangle = zisc::cast<const FlatTriangle*>(&shape);
+    const auto& v0 = triangle->vertex0();
+    const std::array<Point3, 3> vertices{{v0,
+                                          v0 + triangle->edge()[0],
+                                          v0 + triangle->edge()[1]}};
+    const std::array<Float, 2> planes{{lower, upper}};
+    // Collect the vertices of the triangle polygon clipped by the slab
+    Point3 piece_min;
+    Point3 piece_max;
+    uint num_of_points = 0;
+    auto add_point = [&piece_min, &piece_max, &num_of_points](const Point3& point)
+    {
+      piece_min = (num_of_points == 0)
+          ? point
+          : Point3{zisc::minElements(piece_min.data(), point.data())};
+      piece_max = (num_of_points == 0)
+          ? point
+          : Point3{zisc::maxElements(piece_max.data(), point.data())};
+      ++num_of_points;
+    };
+    for (uint i = 0; i < 3; ++i) {
+      const auto& p0 = vertices[i];
+      const auto& p1 = vertices[(i + 1) % 3];
+      if ((lower <= p0[axis]) && (p0[axis] <= upper))
+        add_point(p0);
+      for (const Float plane : planes) {
+        const Float d0 = p0[axis] - plane;
+        const Float d1 = p1[axis] - plane;
+        if ((d0 * d1) < 0.0) {
+          auto point = p0 + (p1 - p0) * (d0 / (d0 - d1));
+          point[axis] = plane;
+          add_point(point);
+        }
+      }
+    }
+    // The reference may be clipped by the ancestors already
+    if (0 < num_of_points) {
+      for (uint i = 0; i < 3; ++i) {
+        const Float lower_bound = zisc::max(min_point[i], piece_min[i]);
+        const Float upper_bound = zisc::min(max_point[i], piece_max[i]);
+        if (lower_bound <= upper_bound) {
+          min_point[i] = lower_bound;
+          max_point[i] = upper_bound;
+        }
+      }
+    }
+  }
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  \details
+  The top levels are split on the calling thread with threaded binning
+  until the subtrees are small enough, then the subtrees are built as tasks
+  of the work stealing scheduler, which balances the uneven subtrees.
+  The subtree of n objects has at most 2n - 1 nodes, so the node indices are
+  decided without any synchronization. Unused nodes are removed on sorting.
+  */
+void BinnedSahBvh::constructBvh(
+    System& system,
+    const zisc::pmr::vector<Object>& object_list,
+    zisc::pmr::vector<BvhBuildingNode>& tree) noexcept
+{
+  const auto start_time = system.stopwatch().elapsedTime();
+  const uint32 num_of_objects = zisc::cast<uint32>(object_list.size());
+
+  auto work_resource = tree.get_allocator().resource();
+  zisc::pmr::vector<ObjectReference> reference_list{work_resource};
+  reference_list.resize(num_of_objects);
+  {
+    auto set_references = [&system, &object_list, &reference_list](const uint task_id)
+    {
+      const auto range = system.calcTaskRange(object_list.size(), task_id);
+      for (auto i = range[0]; i < range[1]; ++i) {
+        const auto& object = object_list[i];
+        auto& reference = reference_list[i];
+        reference.bounding_box_ = object.shape().boundingBox();
+        reference.centroid_ = reference.bounding_box_.centroid();
+        reference.object_ = &object;
+        reference.cost_ = object.shape().getTraversalCost();
+      }
+    };
+    auto& threads = system.threadManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(set_references, start, end, work_resource);
+    result.wait();
+  }
+
+  // Split the references on the calling thread
+  if (isSpatialSplitEnabled()) {
+    Aabb root_box = reference_list[0].bounding_box_;
+    for (const auto& reference : reference_list)
+      root_box = combine(root_box, reference.bounding_box_);
+    uint32 reference_budget = zisc::cast<uint32>(
+        split_budget_ * zisc::cast<Float>(num_of_objects));
+    tree.clear();
+    tree.reserve(2 * (num_of_objects + reference_budget) - 1);
+    Workspace workspace{work_resource};
+    splitSpatially(system, reference_list, root_box.surfaceArea(),
+                   &reference_budget, workspace, tree);
+    recordBuildPhase(system, "Binned SAH (spatial split)", start_time,
+                     &buildPhaseList());
+    return;
+  }
+
+  // Split the top levels
+  tree.resize(2 * num_of_objects - 1);
+  zisc::pmr::vector<BuildTask> task_list{work_resource};
+  {
+    Workspace workspace{work_resource};
+    split(system, 0, reference_list, 0, num_of_objects, workspace, tree,
+          &task_list);
+  }
+  // Build the subtrees
+  {
+    auto& scheduler = system.taskScheduler();
+    TaskGroup group{scheduler};
+    for (const auto& task : task_list) {
+      auto build_subtree = [this, &system, &reference_list, &tree, &task, work_resource]()
+      {
+        Workspace workspace{work_resource};
+        split(system, task.index_, reference_list, task.begin_, task.end_,
+              workspace, tree, nullptr);
+      };
+      group.run(build_subtree);
+    }
+    group.wait();
+  }
+
+  setupBoundingBoxes(system, tree, 0);
+  recordBuildPhase(system, "Binned SAH", start_time, &buildPhaseList());
+}
+
+/*!
+  \details
+  The bins have to be filled by binObjects() in advance.
+  The returned cost is the sum of the surface area times the object cost
+  of the children, which isn't normalized by the area of the node.
+  */
+Float BinnedSahBvh::findObjectSplit(Workspace& workspace,
+                                    uint* split_axis,
+                                    uint* split_bin) const noexcept
+{
+  const uint num_of_bins = numOfBins();
+  const auto& bin_list = workspace.bin_list_;
+  auto& right_cost_list = workspace.right_cost_list_;
+  right_cost_list.resize(num_of_bins);
+
+  Float split_cost = std::numeric_limits<Float>::max();
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Bin* bins = bin_list.data() + axis * num_of_bins;
+    // Sweep from the right
+    Aabb right_box;
+    Float right_cost = 0.0;
+    uint32 right_num = 0;
+    for (uint b = num_of_bins - 1; 0 < b; --b) {
+      if (0 < bins[b].num_of_objects_) {
+        right_box = (right_num == 0)
+            ? bins[b].bounding_box_
+            : combine(right_box, bins[b].bounding_box_);
+        right_cost += bins[b].cost_;
+        right_num += bins[b].num_of_objects_;
+      }
+      right_cost_list[b] = (0 < right_num)
+          ? right_box.surfaceArea() * right_cost
+          : -1.0;
+    }
+    // Sweep from the left
+    Aabb left_box;
+    Float left_cost = 0.0;
+    uint32 left_num = 0;
+    for (uint b = 0; b < (num_of_bins - 1); ++b) {
+      if (0 < bins[b].num_of_objects_) {
+        left_box = (left_num == 0)
+            ? bins[b].bounding_box_
+            : combine(left_box, bins[b].bounding_box_);
+        left_cost += bins[b].cost_;
+        left_num += bins[b].num_of_objects_;
+      }
+      const bool is_valid = (0 < left_num) && (0.0 <= right_cost_list[b + 1]);
+      const Float cost = left_box.surfaceArea() * left_cost + right_cost_list[b + 1];
+      if (is_valid && (cost < split_cost)) {
+        *split_axis = axis;
+        *split_bin = b + 1;
+        split_cost = cost;
+      }
+    }
+  }
+  return split_cost;
+}
+
+/*!
+  \details
+  The references are binned by the positions of their bounding boxes,
+  and a reference which overlaps several bins is clipped into each bin.
+  A reference is counted on the left of a plane by its entry bin and
+  on the right by its exit bin.
+  */
+BinnedSahBvh::SpatialSplit BinnedSahBvh::findSpatialSplit(
+    const Aabb& node_box,
+    const zisc::pmr::vector<ObjectReference>& reference_list,
+    Workspace& workspace) const noexcept
+{
+  const uint num_of_bins = numOfBins();
+  auto& bin_list = workspace.spatial_bin_list_;
+  auto& right_box_list = workspace.right_box_list_;
+  auto& right_cost_list = workspace.right_cost_list_;
+  right_box_list.resize(num_of_bins);
+  right_cost_list.resize(num_of_bins);
+
+  SpatialSplit split;
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float min_p = node_box.minPoint()[axis];
+    const Float max_p = node_box.maxPoint()[axis];
+    if (!(min_p < max_p))
+      continue;
+    const Float bin_width = (max_p - min_p) / zisc::cast<Float>(num_of_bins);
+    // Put the pieces of the references into the bins
+    bin_list.assign(num_of_bins, SpatialBin{});
+    for (const auto& reference : reference_list) {
+      const auto& box = reference.bounding_box_;
+      const uint first = calcSpatialBinIndex(node_box, axis, box.minPoint()[axis]);
+      const uint last = calcSpatialBinIndex(node_box, axis, box.maxPoint()[axis]);
+      for (uint b = first; b <= last; ++b) {
+        const Float lower = min_p + bin_width * zisc::cast<Float>(b);
+        const Float upper = ((b + 1) == num_of_bins) ? max_p : lower + bin_width;
+        const auto piece = (first == last)
+            ? box
+            : clipReference(reference, axis, lower, upper);
+        auto& bin = bin_list[b];
+        bin.bounding_box_ = (bin.num_of_pieces_ == 0)
+            ? piece
+            : combine(bin.bounding_box_, piece);
+        ++bin.num_of_pieces_;
+      }
+      bin_list[first].entry_cost_ += reference.cost_;
+      ++bin_list[first].num_of_entries_;
+      bin_list[last].exit_cost_ += reference.cost_;
+      ++bin_list[last].num_of_exits_;
+    }
+    // Sweep from the right
+    Aabb right_box;
+    Float right_cost = 0.0;
+    uint32 right_num = 0;
+    for (uint b = num_of_bins - 1; 0 < b; --b) {
+      const auto& bin = bin_list[b];
+      if (0 < bin.num_of_pieces_) {
+        right_box = (right_num == 0)
+            ? bin.bounding_box_
+            : combine(right_box, bin.bounding_box_);
+      }
+      right_cost += bin.exit_cost_;
+      right_num += bin.num_of_exits_;
+      right_box_list[b] = right_box;
+      right_cost_list[b] = (0 < right_num) ? right_cost : -1.0;
+    }
+    // Sweep from the left
+    Aabb left_box;
+    Float left_cost = 0.0;
+    uint32 left_num = 0;
+    uint32 num_of_pieces = 0;
+    for (uint b = 0; b < (num_of_bins - 1); ++b) {
+      const auto& bin = bin_list[b];
+      if (0 < bin.num_of_pieces_) {
+        left_box = (num_of_pieces == 0)
+            ? bin.bounding_box_
+            : combine(left_box, bin.bounding_box_);
+        num_of_pieces += bin.num_of_pieces_;
+      }
+      left_cost += bin.entry_cost_;
+      left_num += bin.num_of_entries_;
+      const bool is_valid = (0 < left_num) && (0.0 <= right_cost_list[b + 1]);
+      if (!is_valid)
+        continue;
+      const auto& r_box = right_box_list[b + 1];
+      const Float r_cost = right_cost_list[b + 1];
+      const Float cost = left_box.surfaceArea() * left_cost +
+                         r_box.surfaceArea() * r_cost;
+      if (cost < split.cost_) {
+        split.left_box_ = left_box;
+        split.right_box_ = r_box;
+        split.left_cost_ = left_cost;
+        split.right_cost_ = r_cost;
+        split.cost_ = cost;
+        split.axis_ = axis;
+        split.bin_ = b + 1;
+      }
+    }
+  }
+  return split;
+}
+
+/*!
+  */
+void BinnedSahBvh::initialize(const SettingNodeBase* settings) noexcept
+{
+  const auto bvh_settings = castNode<BvhSettingNode>(settings);
+
+  const auto& parameters = bvh_settings->binnedSahParameters();
+  {
+    num_of_bins_ = parameters.num_of_bins_;
+    ZISC_ASSERT(2 <= num_of_bins_, "Invalid number of bins is specified.");
+  }
+  {
+    spatial_split_ = parameters.spatial_split_;
+    split_budget_ = zisc::cast<Float>(parameters.split_budget_);
+    ZISC_ASSERT(0.0 <= split_budget_, "The split budget is negative.");
+  }
+  {
+    max_num_of_leaf_objects_ = zisc::clamp(parameters.max_num_of_leaf_objects_,
+                                           1u,
+                                           CoreConfig::maxNumOfNodeObjects());
+  }
+}
+
+/*!
+  */
+inline
+bool BinnedSahBvh::isSpatialSplitEnabled() const noexcept
+{
+  return spatial_split_ == kTrue;
+}
+
+/*!
+  */
+inline
+uint32 BinnedSahBvh::maxNumOfLeafObjects() const noexcept
+{
+  return max_num_of_leaf_objects_;
+}
+
+/*!
+  */
+inline
+constexpr Float BinnedSahBvh::nodeTraversalCost() noexcept
+{
+  return 1.0;
+}
+
+/*!
+  */
+inline
+uint BinnedSahBvh::numOfBins() const noexcept
+{
+  return num_of_bins_;
+}
+
+/*!
+  */
+void BinnedSahBvh::setLeafNode(
+    const uint32 index,
+    const zisc::pmr::vector<ObjectReference>& reference_list,
+    const uint32 begin,
+    const uint32 end,
+    zisc::pmr::vector<BvhBuildingNode>& tree) noexcept
+{
+  ZISC_ASSERT((end - begin) <= CoreConfig::maxNumOfNodeObjects(),
+              "The number of objects exceed the limit.");
+  auto& node = tree[index];
+  // The parent of a subtree root is set before the subtree is built
+  const uint32 parent_index = node.parentIndex();
+  node = BvhBuildingNode{reference_list[begin].object_};
+  node.setParentIndex(parent_index);
+  for (uint32 i = begin + 1; i < end; ++i)
+    node.addObject(reference_list[i].object_);
+}
+
+/*!
+  */
+void BinnedSahBvh::setSpatialLeafNode(
+    const uint32 index,
+    const zisc::pmr::vector<ObjectReference>& reference_list,
+    const Aabb& node_box,
+    zisc::pmr::vector<BvhBuildingNode>& tree) noexcept
+{
+  ZISC_ASSERT(reference_list.size() <= CoreConfig::maxNumOfNodeObjects(),
+              "The number of objects exceed the limit.");
+  auto& node = tree[index];
+  node = BvhBuildingNode{reference_list[0].object_};
+  for (std::size_t i = 1; i < reference_list.size(); ++i)
+    node.addObject(reference_list[i].object_);
+  // The references may be clipped
+  node.setBoundingBox(node_box);
+}
+
+/*!
+  \details
+  A spatial split is tried only if the overlap area of the children of
+  the object split is larger than this ratio of the root area.
+  */
+inline
+constexpr Float BinnedSahBvh::spatialSplitThreshold() noexcept
+{
+  return 1.0e-5;
+}
+
+/*!
+  */
+void BinnedSahBvh::split(System& system,
+                         const uint32 index,
+                         zisc::pmr::vector<ObjectReference>& reference_list,
+                         const uint32 begin,
+                         const uint32 end,
+                         Workspace& workspace,
+                         zisc::pmr::vector<BvhBuildingNode>& tree,
+                         zisc::pmr::vector<BuildTask>* task_list) const noexcept
+{
+  const uint32 size = end - begin;
+  ZISC_ASSERT(0 < size, "The size of the range isn't positive: ", size);
+  ZISC_ASSERT(index < tree.size(), "The index exceeds the tree size: ", index);
+  if (size == 1) {
+    setLeafNode(index, reference_list, begin, end, tree);
+    return;
+  }
+  const bool is_top_level = task_list != nullptr;
+  const uint32 num_of_objects = zisc::cast<uint32>(reference_list.size());
+  if (is_top_level && (size <= subtreeSize(system, num_of_objects))) {
+    task_list->emplace_back(BuildTask{index, begin, end});
+    return;
+  }
+
+  // Find the split of the lowest SAH cost
+  const auto centroid_box = calcCentroidBox(reference_list, begin, end);
+  binObjects(is_top_level ? &system : nullptr, centroid_box, reference_list,
+             begin, end, workspace);
+  const uint num_of_bins = numOfBins();
+  const auto& bin_list = workspace.bin_list_;
+
+  // The bins of an axis have all the objects
+  Aabb node_box;
+  Float leaf_cost = 0.0;
+  {
+    uint32 num = 0;
+    for (uint b = 0; b < num_of_bins; ++b) {
+      const auto& bin = bin_list[b];
+      if (0 < bin.num_of_objects_) {
+        node_box = (num == 0)
+            ? bin.bounding_box_
+            : combine(node_box, bin.bounding_box_);
+        leaf_cost += bin.cost_;
+        num += bin.num_of_objects_;
+      }
+    }
+  }
+
+  uint split_axis = 3;
+  uint split_bin = 0;
+  Float split_cost = findObjectSplit(workspace, &split_axis, &split_bin);
+  const Float node_area = node_box.surfaceArea();
+  split_cost = (0.0 < node_area)
+      ? nodeTraversalCost() + split_cost / node_area
+      : nodeTraversalCost() + leaf_cost;
+
+  // Make a leaf if it's cheaper than splitting
+  const bool can_be_leaf = size <= maxNumOfLeafObjects();
+  if (can_be_leaf && ((split_axis == 3) || (leaf_cost <= split_cost))) {
+    setLeafNode(index, reference_list, begin, end, tree);
+    return;
+  }
+
+  // Partition the objects
+  uint32 middle = begin + (size >> 1);
+  if (split_axis != 3) {
+    auto first = reference_list.begin() + begin;
+    auto last = reference_list.begin() + end;
+    auto is_left = [this, &centroid_box, split_axis, split_bin]
+    (const ObjectReference& reference)
+    {
+      return calcBinIndex(reference, centroid_box, split_axis) < split_bin;
+    };
+    const auto position = std::partition(first, last, is_left);
+    middle = zisc::cast<uint32>(std::distance(reference_list.begin(), position));
+  }
+  ZISC_ASSERT((begin < middle) && (middle < end), "The partition is failed.");
+
+  const uint32 left_child_index = index + 1;
+  const uint32 right_child_index = index + 2 * (middle - begin);
+  split(system, left_child_index, reference_list, begin, middle, workspace,
+        tree, task_list);
+  split(system, right_child_index, reference_list, middle, end, workspace,
+        tree, task_list);
+
+  tree[index].setLeftChildIndex(left_child_index);
+  tree[index].setRightChildIndex(right_child_index);
+  tree[left_child_index].setParentIndex(index);
+  tree[right_child_index].setParentIndex(index);
+}
+
+/*!
+  \details
+  The number of the references isn't known in advance,
+  so the nodes are appended to the tree in depth first order.
+  The given reference list is consumed.
+  */
+uint32 BinnedSahBvh::splitSpatially(
+    System& system,
+    zisc::pmr::vector<ObjectReference>& reference_list,
+    const Float root_area,
+    uint32* reference_budget,
+    Workspace& workspace,
+    zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept
+{
+  const uint32 size = zisc::cast<uint32>(reference_list.size());
+  ZISC_ASSERT(0 < size, "The size of the references isn't positive: ", size);
+  const uint32 index = zisc::cast<uint32>(tree.size());
+  tree.emplace_back();
+
+  Aabb node_box = reference_list[0].bounding_box_;
+  Float leaf_cost = reference_list[0].cost_;
+  for (uint32 i = 1; i < size; ++i) {
+    node_box = combine(node_box, reference_list[i].bounding_box_);
+    leaf_cost += reference_list[i].cost_;
+  }
+  if (size == 1) {
+    setSpatialLeafNode(index, reference_list, node_box, tree);
+    return index;
+  }
+
+  // Find the object split of the lowest SAH cost
+  const auto centroid_box = calcCentroidBox(reference_list, 0, size);
+  binObjects(nullptr, centroid_box, reference_list, 0, size, workspace);
+  uint split_axis = 3;
+  uint split_bin = 0;
+  const Float object_split_cost = findObjectSplit(workspace, &split_axis, &split_bin);
+
+  // Find the spatial split if the children of the object split overlap
+  SpatialSplit spatial_split;
+  if (0 < *reference_budget) {
+    Float overlap_area = std::numeric_limits<Float>::max();
+    if (split_axis != 3) {
+      const uint num_of_bins = numOfBins();
+      const Bin* bins = workspace.bin_list_.data() + split_axis * num_of_bins;
+      Aabb left_box;
+      Aabb right_box;
+      uint32 left_num = 0;
+      uint32 right_num = 0;
+      for (uint b = 0; b < num_of_bins; ++b) {
+        if (bins[b].num_of_objects_ == 0)
+          continue;
+        auto& box = (b < split_bin) ? left_box : right_box;
+        auto& num = (b < split_bin) ? left_num : right_num;
+        box = (num == 0) ? bins[b].bounding_box_ : combine(box, bins[b].bounding_box_);
+        num += bins[b].num_of_objects_;
+      }
+      overlap_area = 0.0;
+      const Point3 lower{zisc::maxElements(left_box.minPoint().data(),
+                                           right_box.minPoint().data())};
+      const Point3 upper{zisc::minElements(left_box.maxPoint().data(),
+                                           right_box.maxPoint().data())};
+      if ((lower[0] <= upper[0]) && (lower[1] <= upper[1]) && (lower[2] <= upper[2]))
+        overlap_area = Aabb{lower, upper}.surfaceArea();
+    }
+    if ((spatialSplitThreshold() * root_area) < overlap_area)
+      spatial_split = findSpatialSplit(node_box, reference_list, workspace);
+  }
+
+  const bool is_spatial_split = spatial_split.cost_ < object_split_cost;
+  const bool has_split = is_spatial_split || (split_axis != 3);
+  const Float node_area = node_box.surfaceArea();
+  const Float split_cost = (0.0 < node_area)
+      ? nodeTraversalCost() +
+        zisc::min(object_split_cost, spatial_split.cost_) / node_area
+      : nodeTraversalCost() + leaf_cost;
+
+  // Make a leaf if it's cheaper than splitting
+  const bool can_be_leaf = size <= maxNumOfLeafObjects();
+  if (can_be_leaf && (!has_split || (leaf_cost <= split_cost))) {
+    setSpatialLeafNode(index, reference_list, node_box, tree);
+    return index;
+  }
+
+  // Partition the references
+  auto work_resource = reference_list.get_allocator().resource();
+  zisc::pmr::vector<ObjectReference> left_list{work_resource};
+  zisc::pmr::vector<ObjectReference> right_list{work_resource};
+  const uint32 budget = *reference_budget;
+  if (is_spatial_split) {
+    const uint axis = spatial_split.axis_;
+    const Float min_p = node_box.minPoint()[axis];
+    const Float max_p = node_box.maxPoint()[axis];
+    const Float plane = min_p + (max_p - min_p) *
+        (zisc::cast<Float>(spatial_split.bin_) / zisc::cast<Float>(numOfBins()));
+    Aabb left_box = spatial_split.left_box_;
+    Aabb right_box = spatial_split.right_box_;
+    Float left_cost = spatial_split.left_cost_;
+    Float right_cost = spatial_split.right_cost_;
+    for (const auto& reference : reference_list) {
+      const auto& box = reference.bounding_box_;
+      const uint first = calcSpatialBinIndex(node_box, axis, box.minPoint()[axis]);
+      const uint last = calcSpatialBinIndex(node_box, axis, box.maxPoint()[axis]);
+      if (last < spatial_split.bin_) {
+        left_list.emplace_back(reference);
+        continue;
+      }
+      if (spatial_split.bin_ <= first) {
+        right_list.emplace_back(reference);
+        continue;
+      }
+      // Put the straddling reference into one side if it's cheaper than a split
+      const auto left_union = combine(left_box, box);
+      const auto right_union = combine(right_box, box);
+      const Float left_area = left_box.surfaceArea();
+      const Float right_area = right_box.surfaceArea();
+      const Float cost = left_area * left_cost + right_area * right_cost;
+      const Float left_only_cost = left_union.surfaceArea() * left_cost +
+                                   right_area * (right_cost - reference.cost_);
+      const Float right_only_cost = left_area * (left_cost - reference.cost_) +
+                                    right_union.surfaceArea() * right_cost;
+      const bool is_split = (0 < *reference_budget) &&
+                            (cost < zisc::min(left_only_cost, right_only_cost));
+      if (is_split) {
+        left_list.emplace_back(reference);
+        right_list.emplace_back(reference);
+        auto& left_piece = left_list.back();
+        left_piece.bounding_box_ = clipReference(reference, axis, min_p, plane);
+        left_piece.centroid_ = left_piece.bounding_box_.centroid();
+        auto& right_piece = right_list.back();
+        right_piece.bounding_box_ = clipReference(reference, axis, plane, max_p);
+        right_piece.centroid_ = right_piece.bounding_box_.centroid();
+        --(*reference_budget);
+      }
+      else if (left_only_cost <= right_only_cost) {
+        left_list.emplace_back(reference);
+        left_box = left_union;
+        right_cost -= reference.cost_;
+      }
+      else {
+        right_list.emplace_back(reference);
+        right_box = right_union;
+        left_cost -= reference.cost_;
+      }
+    }
+  }
+  // Fall back to the object split unless the spatial split makes progress
+  const bool is_partitioned = !left_list.empty() && (left_list.size() < size) &&
+                              !right_list.empty() && (right_list.size() < size);
+  if (!is_partitioned) {
+    *reference_budget = budget;
+    left_list.clear();
+    right_list.clear();
+    for (uint32 i = 0; i < size; ++i) {
+      const auto& reference = reference_list[i];
+      const bool is_left = (split_axis != 3)
+          ? calcBinIndex(reference, centroid_box, split_axis) < split_bin
+          : i < (size >> 1);
+      if (is_left)
+        left_list.emplace_back(reference);
+      else
+        right_list.emplace_back(reference);
+    }
+  }
+  ZISC_ASSERT(!left_list.empty() && !right_list.empty(),
+              "The partition is failed.");
+  reference_list.clear();
+  reference_list.shrink_to_fit();
+
+  const uint32 left_child_index = splitSpatially(system, left_list, root_area,
+                                                 reference_budget, workspace, tree);
+  const uint32 right_child_index = splitSpatially(system, right_list, root_area,
+                                                  reference_budget, workspace, tree);
+
+  auto& node = tree[index];
+  node.setLeftChildIndex(left_child_index);
+  node.setRightChildIndex(right_child_index);
+  node.setBoundingBox(combine(tree[left_child_index].boundingBox(),
+                              tree[right_child_index].boundingBox()));
+  tree[left_child_index].setParentIndex(index);
+  tree[right_child_index].setParentIndex(index);
+  return index;
+}
+
+/*!
+  \details
+  Several subtrees are made per thread so that the threads are balanced
+  even if the tree is unbalanced.
+  */
+inline
+uint32 BinnedSahBvh::subtreeSize(System& system,
+                                 const uint32 num_of_objects) const noexcept
+{
+  constexpr uint32 min_subtree_size = 1024;
+  const uint32 num_of_subtrees = 4 * system.threadManager().numOfThreads();
+  return zisc::max(num_of_objects / num_of_subtrees, min_subtree_size);
+}
+
+} // namespace nanairo
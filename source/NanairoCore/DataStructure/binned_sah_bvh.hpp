@@ -0,0 +1,228 @@
+/*!
+  \file binned_sah_bvh.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_BINNED_SAH_BVH_HPP
+#define NANAIRO_BINNED_SAH_BVH_HPP
+
+// Standard C++ library
+#include <limits>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "bvh_building_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  A top-down builder which splits the objects at the plane of the lowest
+  surface area heuristic cost among the bin boundaries.
+  For the details of this algorithm,
+  please see the paper entitled
+  "On fast Construction of SAH-based Bounding Volume Hierarchies".
+  If spatial splits are enabled, a reference of an object can be split at
+  a bin boundary into two references as described in the paper entitled
+  "Spatial Splits in Bounding Volume Hierarchies".
+  */
+class BinnedSahBvh : public Bvh
+{
+ public:
+  //! Create a binned SAH BVH
+  BinnedSahBvh(System& system, const SettingNodeBase* settings) noexcept;
+
+ private:
+  //! The bounding box of an object which is sorted during the build
+  struct ObjectReference
+  {
+    Aabb bounding_box_;
+    Point3 centroid_;
+    const Object* object_;
+    Float cost_;
+  };
+
+  //! The objects which fall into a bin
+  struct Bin
+  {
+    Aabb bounding_box_;
+    Float cost_ = 0.0;
+    uint32 num_of_objects_ = 0;
+  };
+
+  //! The references which enter and exit a bin of a spatial split
+  struct SpatialBin
+  {
+    Aabb bounding_box_;
+    Float entry_cost_ = 0.0;
+    Float exit_cost_ = 0.0;
+    uint32 num_of_entries_ = 0;
+    uint32 num_of_exits_ = 0;
+    uint32 num_of_pieces_ = 0;
+  };
+
+  //! The best spatial split of a node
+  struct SpatialSplit
+  {
+    Aabb left_box_;
+    Aabb right_box_;
+    Float left_cost_ = 0.0;
+    Float right_cost_ = 0.0;
+    Float cost_ = std::numeric_limits<Float>::max();
+    uint axis_ = 3;
+    uint bin_ = 0;
+  };
+
+  //! A subtree which is built by a thread
+  struct BuildTask
+  {
+    uint32 index_;
+    uint32 begin_;
+    uint32 end_;
+  };
+
+  //! The work memory of the split
+  struct Workspace
+  {
+    Workspace(zisc::pmr::memory_resource* work_resource) noexcept;
+
+    zisc::pmr::vector<Bin> bin_list_;
+    zisc::pmr::vector<Float> right_cost_list_;
+    zisc::pmr::vector<SpatialBin> spatial_bin_list_;
+    zisc::pmr::vector<Aabb> right_box_list_;
+  };
+
+
+  //! Add the object to the bin
+  static void addToBin(const ObjectReference& reference, Bin* bin) noexcept;
+
+  //! Put the objects into the bins of each axis
+  void binObjects(System* system,
+                  const Aabb& centroid_box,
+                  const zisc::pmr::vector<ObjectReference>& reference_list,
+                  const uint32 begin,
+                  const uint32 end,
+                  Workspace& workspace) const noexcept;
+
+  //! Return the bin index of the object
+  uint calcBinIndex(const ObjectReference& reference,
+                    const Aabb& centroid_box,
+                    const uint axis) const noexcept;
+
+  //! Calculate the bounding box of the centroids
+  static Aabb calcCentroidBox(
+      const zisc::pmr::vector<ObjectReference>& reference_list,
+      const uint32 begin,
+      const uint32 end) noexcept;
+
+  //! Return the spatial bin index of the position
+  uint calcSpatialBinIndex(const Aabb& node_box,
+                           const uint axis,
+                           const Float position) const noexcept;
+
+  //! Clip the reference by the slab of the axis
+  static Aabb clipReference(const ObjectReference& reference,
+                            const uint axis,
+                            const Float lower,
+                            const Float upper) noexcept;
+
+  //! Build a binned SAH BVH
+  void constructBvh(
+      System& system,
+      const zisc::pmr::vector<Object>& object_list,
+      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept override;
+
+  //! Find the object split of the lowest SAH cost from the bins
+  Float findObjectSplit(Workspace& workspace,
+                        uint* split_axis,
+                        uint* split_bin) const noexcept;
+
+  //! Find the spatial split of the lowest SAH cost
+  SpatialSplit findSpatialSplit(
+      const Aabb& node_box,
+      const zisc::pmr::vector<ObjectReference>& reference_list,
+      Workspace& workspace) const noexcept;
+
+  //! Initialize
+  void initialize(const SettingNodeBase* settings) noexcept;
+
+  //! Check if spatial splits are enabled
+  bool isSpatialSplitEnabled() const noexcept;
+
+  //! Return the max number of the objects in a leaf
+  uint32 maxNumOfLeafObjects() const noexcept;
+
+  //! Return the cost of a node traversal relative to the object cost
+  static constexpr Float nodeTraversalCost() noexcept;
+
+  //! Return the number of bins per axis
+  uint numOfBins() const noexcept;
+
+  //! Make a leaf node of the objects
+  static void setLeafNode(
+      const uint32 index,
+      const zisc::pmr::vector<ObjectReference>& reference_list,
+      const uint32 begin,
+      const uint32 end,
+      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept;
+
+  //! Make a leaf node of the references with the clipped bounding box
+  static void setSpatialLeafNode(
+      const uint32 index,
+      const zisc::pmr::vector<ObjectReference>& reference_list,
+      const Aabb& node_box,
+      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept;
+
+  //! Return the overlap ratio of the children to try a spatial split
+  static constexpr Float spatialSplitThreshold() noexcept;
+
+  //! Split the objects recursively
+  void split(System& system,
+             const uint32 index,
+             zisc::pmr::vector<ObjectReference>& reference_list,
+             const uint32 begin,
+             const uint32 end,
+             Workspace& workspace,
+             zisc::pmr::vector<BvhBuildingNode>& tree,
+             zisc::pmr::vector<BuildTask>* task_list) const noexcept;
+
+  //! Split the references recursively with spatial splits
+  uint32 splitSpatially(System& system,
+                        zisc::pmr::vector<ObjectReference>& reference_list,
+                        const Float root_area,
+                        uint32* reference_budget,
+                        Workspace& workspace,
+                        zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept;
+
+  //! Return the size of subtrees which are built by threads
+  uint32 subtreeSize(System& system, const uint32 num_of_objects) const noexcept;
+
+
+  Float split_budget_;
+  uint num_of_bins_;
+  uint32 max_num_of_leaf_objects_;
+  uint8 spatial_split_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_BINNED_SAH_BVH_HPP
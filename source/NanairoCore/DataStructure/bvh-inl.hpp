@@ -12,6 +12,8 @@
 
 #include "bvh.hpp"
 // Standard C++ library
+#include <limits>
+#include <type_traits>
 #include <utility>
 #include <vector>
 // Zisc
@@ -20,13 +22,26 @@
 // Nanairo
 #include "bvh_building_node.hpp"
 #include "bvh_tree_node.hpp"
+#include "quantized_bvh_node.hpp"
+#include "triangle_list.hpp"
+#include "wide_bvh_node.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+inline
+const zisc::pmr::vector<BvhBuildPhase>& Bvh::buildPhaseList() const noexcept
+{
+  return build_phase_list_;
+}
+
 /*!
   \details
   No detailed.
@@ -37,6 +52,24 @@ const zisc::pmr::vector<BvhTreeNode>& Bvh::bvhTree() const noexcept
   return tree_;
 }
 
+/*!
+  */
+inline
+BvhLayoutType Bvh::layoutType() const noexcept
+{
+  return layout_type_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+zisc::pmr::vector<Object>& Bvh::objectList() noexcept
+{
+  return object_list_;
+}
+
 /*!
   \details
   No detailed.
@@ -47,6 +80,90 @@ const zisc::pmr::vector<Object>& Bvh::objectList() const noexcept
   return object_list_;
 }
 
+/*!
+  */
+inline
+Bvh::ReferenceMailbox::ReferenceMailbox() noexcept :
+    next_{0}
+{
+  object_index_list_.fill(std::numeric_limits<uint32>::max());
+}
+
+/*!
+  */
+inline
+void Bvh::ReferenceMailbox::add(const uint32 object_index) noexcept
+{
+  object_index_list_[next_] = object_index;
+  next_ = (next_ + 1) % kSize;
+}
+
+/*!
+  */
+inline
+bool Bvh::ReferenceMailbox::contains(const uint32 object_index) const noexcept
+{
+  bool result = false;
+  for (uint i = 0; i < kSize; ++i)
+    result = result || (object_index_list_[i] == object_index);
+  return result;
+}
+
+/*!
+  */
+inline
+void Bvh::TraversalCount::addTo(RenderingCounter* counter) const noexcept
+{
+  if (counter != nullptr)
+    counter->addTraversal(visits_, tests_);
+}
+
+/*!
+  */
+inline
+uint32 Bvh::referencedObjectIndex(const uint32 reference_index) const noexcept
+{
+  return (reference_list_.empty())
+      ? reference_index
+      : reference_list_[reference_index];
+}
+
+/*!
+  */
+inline
+const TriangleList& Bvh::triangleList() const noexcept
+{
+  return triangle_list_;
+}
+
+/*!
+  */
+inline
+zisc::pmr::vector<BvhBuildPhase>& Bvh::buildPhaseList() noexcept
+{
+  return build_phase_list_;
+}
+
+/*!
+  */
+inline
+void Bvh::recordBuildPhase(const System& system,
+                           const char* name,
+                           const zisc::Stopwatch::Clock::duration start_time,
+                           zisc::pmr::vector<BvhBuildPhase>* phase_list) noexcept
+{
+  const auto time = system.stopwatch().elapsedTime() - start_time;
+  phase_list->emplace_back(BvhBuildPhase{name, time});
+}
+
+/*!
+  */
+inline
+bool Bvh::isExtendedMortonCodeEnabled() const noexcept
+{
+  return extended_morton_code_ == kTrue;
+}
+
 /*!
   */
 inline
@@ -56,45 +173,112 @@ constexpr bool Bvh::threadingIsEnabled() noexcept
 }
 
 /*!
+  \details
+  The children are forked near the root and
+  a waiting thread runs the pending subtrees.
   */
-template <bool threading> inline
+inline
 void Bvh::setupBoundingBoxes(System& system,
                              zisc::pmr::vector<BvhBuildingNode>& tree,
-                             const uint32 index) noexcept
+                             const uint32 index,
+                             const uint depth) noexcept
 {
   auto& node = tree[index];
   // Inernal node
   if (!node.isLeafNode()) {
     const auto left_child_index = node.leftChildIndex();
     const auto right_child_index = node.rightChildIndex();
+    auto& scheduler = system.taskScheduler();
     // Threding
-    if (threading) {
-      auto set_left_bounding_box = [&system, &tree, left_child_index]()
+    if (threadingIsEnabled() && (depth < scheduler.forkDepth())) {
+      TaskGroup group{scheduler};
+      auto set_left_bounding_box = [&system, &tree, left_child_index, depth]()
       {
-        Bvh::setupBoundingBoxes<>(system, tree, left_child_index);
+        Bvh::setupBoundingBoxes(system, tree, left_child_index, depth + 1);
       };
-      auto set_right_bounding_box = [&system, &tree, right_child_index]()
-      {
-        Bvh::setupBoundingBoxes<>(system, tree, right_child_index);
-      };
-      auto& threads = system.threadManager();
-      auto work_resource = tree.get_allocator().resource();
-      auto left_result =
-          threads.enqueue<void>(set_left_bounding_box, work_resource);
-      auto right_result =
-          threads.enqueue<void>(set_right_bounding_box, work_resource);
-      left_result.wait();
-      right_result.wait();
+      group.run(set_left_bounding_box);
+      setupBoundingBoxes(system, tree, right_child_index, depth + 1);
+      group.wait();
     }
     // Sequence
     else {
-      setupBoundingBoxes<>(system, tree, left_child_index);
-      setupBoundingBoxes<>(system, tree, right_child_index);
+      setupBoundingBoxes(system, tree, left_child_index, depth + 1);
+      setupBoundingBoxes(system, tree, right_child_index, depth + 1);
     }
   }
   setupBoundingBox(tree, index);
 }
 
+/*!
+  \details
+  The ratio is of the surface areas of the bounding boxes.
+  */
+inline
+constexpr Float Bvh::largeObjectAreaRatio() noexcept
+{
+  constexpr Float ratio = 0.25;
+  return ratio;
+}
+
+/*!
+  \details
+  At most one child is pushed per level,
+  so the stack size bounds the depth of the tree.
+  */
+inline
+constexpr uint Bvh::orderedTraversalStackSize() noexcept
+{
+  constexpr uint stack_size = 64;
+  return stack_size;
+}
+
+/*!
+  \details
+  The depth of the binary tree is bounded by the bits of morton code and
+  a wide tree is shallower than the binary tree.
+  */
+inline
+constexpr uint Bvh::wideTreeMaxDepth() noexcept
+{
+  constexpr uint max_depth = 64;
+  return max_depth;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+constexpr uint Bvh::wideTraversalStackSize() noexcept
+{
+  constexpr uint stack_size = wideTreeMaxDepth() * (kWidth - 1) + 1;
+  return stack_size;
+}
+
+/*!
+  */
+template <typename WideNode> inline
+zisc::pmr::vector<WideNode>& Bvh::wideTree() noexcept
+{
+  if constexpr (std::is_same_v<WideNode, WideBvhNode<4>>)
+    return wide4_tree_;
+  else if constexpr (std::is_same_v<WideNode, WideBvhNode<8>>)
+    return wide8_tree_;
+  else
+    return quantized4_tree_;
+}
+
+/*!
+  */
+template <typename WideNode> inline
+const zisc::pmr::vector<WideNode>& Bvh::wideTree() const noexcept
+{
+  if constexpr (std::is_same_v<WideNode, WideBvhNode<4>>)
+    return wide4_tree_;
+  else if constexpr (std::is_same_v<WideNode, WideBvhNode<8>>)
+    return wide8_tree_;
+  else
+    return quantized4_tree_;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_BVH_INL_HPP
@@ -10,12 +10,15 @@
 #include "bvh.hpp"
 // Standard C++ library
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <iterator>
 #include <memory>
 #include <limits>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 // Zics
@@ -23,30 +26,70 @@
 #include "zisc/error.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "aabb.hpp"
 #include "agglomerative_treelet_restructuring_bvh.hpp"
 #include "binary_radix_tree_bvh.hpp"
+#include "binned_sah_bvh.hpp"
 #include "bvh_building_node.hpp"
+#include "bvh_cache.hpp"
 #include "bvh_tree_node.hpp"
+#include "quantized_bvh_node.hpp"
+#include "triangle_list.hpp"
+#include "wide_bvh_node.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/ray_hit.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Setting/bvh_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/out_of_core_memory_resource.hpp"
+#include "NanairoCore/Utility/prefetch.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+BvhStatistics::BvhStatistics(zisc::pmr::memory_resource* work_resource) noexcept :
+    depth_histogram_{work_resource},
+    occupancy_histogram_{work_resource}
+{
+}
+
 /*!
   \details
   No detailed.
   */
-Bvh::Bvh(System& system, const SettingNodeBase* /* settings */) noexcept :
-    tree_{&system.dataMemoryManager()},
-    object_list_{&system.dataMemoryManager()}
+Bvh::Bvh(System& system, const SettingNodeBase* settings) noexcept :
+    build_phase_list_{&system.dataMemoryManager()},
+    tree_{&system.trackedMemoryResource(MemoryCategory::kBvh)},
+    wide4_tree_{&system.trackedMemoryResource(MemoryCategory::kBvh)},
+    wide8_tree_{&system.trackedMemoryResource(MemoryCategory::kBvh)},
+    quantized4_tree_{&system.trackedMemoryResource(MemoryCategory::kBvh)},
+    object_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    reference_list_{&system.trackedMemoryResource(MemoryCategory::kBvh)},
+    triangle_list_{system.isOutOfCoreEnabled()
+        ? zisc::cast<zisc::pmr::memory_resource*>(&system.outOfCoreMemoryResource())
+        : zisc::cast<zisc::pmr::memory_resource*>(
+              &system.trackedMemoryResource(MemoryCategory::kBvh))},
+    out_of_core_resource_{system.isOutOfCoreEnabled()
+        ? &system.outOfCoreMemoryResource()
+        : nullptr},
+    layout_type_{castNode<BvhSettingNode>(settings)->bvhLayoutType()},
+    large_object_index_{0},
+    extended_morton_code_{
+        castNode<BvhSettingNode>(settings)->isExtendedMortonCodeEnabled()
+            ? kTrue
+            : kFalse}
 {
 }
 
@@ -56,36 +99,350 @@ Bvh::~Bvh() noexcept
 {
 }
 
+/*!
+  */
+Aabb Bvh::boundingBox() const noexcept
+{
+  auto bounding_box = bvhTree()[0].boundingBox();
+  for (uint32 index = large_object_index_; index < object_list_.size(); ++index)
+    bounding_box = combine(bounding_box, object_list_[index].shape().boundingBox());
+  return bounding_box;
+}
+
 /*!
   \details
-  No detailed.
+  The SAH cost is the sum of the node costs weighted by the ratio of
+  the box area to the root box. An inner node costs a traversal and
+  a leaf costs the traversal costs of its objects.
+  The large objects out of the tree are tested by every ray,
+  so their ratio is one. The child indices of the threaded tree are
+  greater than the parent index, so the depths are set in the node order.
+  */
+BvhStatistics Bvh::calcStatistics(
+    zisc::pmr::memory_resource* work_resource) const noexcept
+{
+  BvhStatistics statistics{work_resource};
+  auto& depth_histogram = statistics.depth_histogram_;
+  auto& occupancy_histogram = statistics.occupancy_histogram_;
+  occupancy_histogram.resize(CoreConfig::maxNumOfNodeObjects() + 1, 0);
+
+  const auto& bvh_tree = bvhTree();
+  const uint32 num_of_nodes = zisc::cast<uint32>(bvh_tree.size());
+  const Float root_area = bvh_tree[0].boundingBox().surfaceArea();
+  const Float inverse_root_area = (0.0 < root_area) ? zisc::invert(root_area) : 0.0;
+  zisc::pmr::vector<uint> depth_list{work_resource};
+  depth_list.resize(num_of_nodes, 0);
+  uint32 num_of_inner_nodes = 0;
+  Float overlap_ratio = 0.0;
+  for (uint32 index = 0; index < num_of_nodes; ++index) {
+    const auto& node = bvh_tree[index];
+    const Float area = node.boundingBox().surfaceArea();
+    const uint depth = depth_list[index];
+    if (node.isLeafNode()) {
+      Float cost = 0.0;
+      for (uint i = 0; i < node.numOfObjects(); ++i) {
+        const uint32 object_index = referencedObjectIndex(node.objectIndex() + i);
+        cost += object_list_[object_index].shape().getTraversalCost();
+      }
+      statistics.sah_cost_ += area * inverse_root_area * cost;
+      if (depth_histogram.size() <= depth)
+        depth_histogram.resize(depth + 1, 0);
+      ++depth_histogram[depth];
+      ++occupancy_histogram[node.numOfObjects()];
+      ++statistics.num_of_leafs_;
+    }
+    else {
+      statistics.sah_cost_ += area * inverse_root_area;
+      const uint32 left_index = index + 1;
+      const uint32 right_index = bvh_tree[left_index].failureNextIndex();
+      depth_list[left_index] = depth + 1;
+      depth_list[right_index] = depth + 1;
+      // The overlap of the children
+      const auto& left_box = bvh_tree[left_index].boundingBox();
+      const auto& right_box = bvh_tree[right_index].boundingBox();
+      const Point3 lower{zisc::maxElements(left_box.minPoint().data(),
+                                           right_box.minPoint().data())};
+      const Point3 upper{zisc::minElements(left_box.maxPoint().data(),
+                                           right_box.maxPoint().data())};
+      const bool is_overlapped = (lower[0] <= upper[0]) &&
+                                 (lower[1] <= upper[1]) &&
+                                 (lower[2] <= upper[2]);
+      if (is_overlapped && (0.0 < area))
+        overlap_ratio += Aabb{lower, upper}.surfaceArea() / area;
+      ++num_of_inner_nodes;
+    }
+  }
+  for (uint32 index = large_object_index_; index < object_list_.size(); ++index)
+    statistics.sah_cost_ += object_list_[index].shape().getTraversalCost();
+  statistics.overlap_ratio_ = (0 < num_of_inner_nodes)
+      ? overlap_ratio / zisc::cast<Float>(num_of_inner_nodes)
+      : 0.0;
+  statistics.num_of_nodes_ = num_of_nodes;
+
+  statistics.memory_size_ =
+      tree_.size() * sizeof(BvhTreeNode) +
+      wide4_tree_.size() * sizeof(WideBvhNode<4>) +
+      wide8_tree_.size() * sizeof(WideBvhNode<8>) +
+      quantized4_tree_.size() * sizeof(QuantizedBvhNode) +
+      reference_list_.size() * sizeof(uint32) +
+      object_list_.size() * sizeof(Object);
+  return statistics;
+}
+
+/*!
+  \details
+  The traversal tracks only the compact hit record and
+  the surface attributes of the closest hit are computed at the end.
   */
 IntersectionInfo Bvh::castRay(const Ray& ray,
                               const Float max_distance,
-                              const bool expect_no_hit) const noexcept 
+                              RenderingCounter* counter) const noexcept 
 {
-  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  const auto hit = findClosestHit(ray, max_distance, counter);
   IntersectionInfo intersection;
-  intersection.setRayDistance(max_distance);
+  makeIntersectionInfo(ray, hit, &intersection);
+  return intersection;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void Bvh::castRayBinary(const Ray& ray,
+                        RayHit* hit,
+                        TraversalCount* count) const noexcept
+{
+  ReferenceMailbox mailbox;
   uint32 index = 0;
   const auto& bvh_tree = bvhTree();
   const uint32 end_index = zisc::cast<uint32>(bvh_tree.size());
-  const auto inv_dir = invert(ray.direction());
-  while ((index != end_index) && !(intersection.isIntersected() && expect_no_hit)) {
+  while (index != end_index) {
     const auto& node = bvh_tree[index];
-    const auto result = node.boundingBox().testIntersection(ray, inv_dir);
+    if constexpr (traversalPrefetchIsEnabled())
+      prefetchCandidates(node);
+    ++count->visits_;
+    const auto result = node.boundingBox().testIntersection(ray);
     // If the ray hits the bounding box of the node, enter the node
-    if (result.isSuccess() && (result.rayDistance() < intersection.rayDistance())) {
+    if (result.isSuccess() && (result.rayDistance() < hit->rayDistance())) {
       // A case of leaf node
-      if (node.isLeafNode())
-        testRayObjectsIntersection(ray, node, &intersection);
+      if (node.isLeafNode()) {
+        testRayObjectsIntersection(ray, node.objectIndex(), node.numOfObjects(),
+                                   &mailbox, hit, count);
+      }
       ++index;
     }
     else {
       index = node.failureNextIndex();
     }
   }
-  return intersection;
+}
+
+/*!
+  \details
+  The packet traverses the threaded binary tree of any layout.
+  A node is culled for the whole packet by the interval test first,
+  and then the boxes are tested against the rays at once.
+  The node is entered if any ray hits it, and only the hit rays
+  are tested against the objects of a leaf.
+  A node is counted once for the packet.
+  */
+template <uint kSize>
+void Bvh::castRayPacket(
+    const RayPacket<kSize>& packet,
+    const Float max_distance,
+    std::array<IntersectionInfo, kSize>* intersection_list,
+    RenderingCounter* counter) const noexcept
+{
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  ZISC_ASSERT(intersection_list != nullptr, "The intersection list is null.");
+  const uint32 active_mask = packet.activeMask();
+  typename RayPacket<kSize>::DistanceList distance_list;
+  distance_list.fill(max_distance);
+  std::array<RayHit, kSize> hit_list;
+  hit_list.fill(RayHit{max_distance});
+  std::array<ReferenceMailbox, kSize> mailbox_list;
+  // The farthest closest hit of the packet bounds the frustum test
+  Float packet_distance = max_distance;
+
+  TraversalCount count;
+  if (large_object_index_ < object_list_.size()) {
+    packet_distance = 0.0;
+    for (uint i = 0; i < kSize; ++i) {
+      if ((active_mask & (zisc::cast<uint32>(1) << i)) == 0)
+        continue;
+      testLargeObjectsIntersection(packet.ray(i), &hit_list[i], &count);
+      distance_list[i] = hit_list[i].rayDistance();
+      packet_distance = zisc::max(packet_distance, distance_list[i]);
+    }
+  }
+  uint32 index = 0;
+  const auto& bvh_tree = bvhTree();
+  const uint32 end_index = zisc::cast<uint32>(bvh_tree.size());
+  while (index != end_index) {
+    const auto& node = bvh_tree[index];
+    if constexpr (traversalPrefetchIsEnabled())
+      prefetchCandidates(node);
+    ++count.visits_;
+    const auto& bounding_box = node.boundingBox();
+    const uint32 hit_mask = packet.testFrustum(bounding_box, packet_distance)
+        ? packet.testIntersection(bounding_box, distance_list)
+        : 0;
+    // If any ray hits the bounding box of the node, enter the node
+    if (hit_mask != 0) {
+      // A case of leaf node
+      if (node.isLeafNode()) {
+        for (uint i = 0; i < kSize; ++i) {
+          if ((hit_mask & (zisc::cast<uint32>(1) << i)) == 0)
+            continue;
+          testRayObjectsIntersection(packet.ray(i),
+                                     node.objectIndex(),
+                                     node.numOfObjects(),
+                                     &mailbox_list[i],
+                                     &hit_list[i],
+                                     &count);
+          distance_list[i] = hit_list[i].rayDistance();
+        }
+        packet_distance = 0.0;
+        for (uint i = 0; i < kSize; ++i) {
+          if ((active_mask & (zisc::cast<uint32>(1) << i)) != 0)
+            packet_distance = zisc::max(packet_distance, distance_list[i]);
+        }
+      }
+      ++index;
+    }
+    else {
+      index = node.failureNextIndex();
+    }
+  }
+  for (uint i = 0; i < kSize; ++i)
+    makeIntersectionInfo(packet.ray(i), hit_list[i], &(*intersection_list)[i]);
+  count.addTo(counter);
+}
+
+/*!
+  \details
+  The boxes of both children are tested at the parent and the nearer child
+  is visited first, so the closest distance shrinks early and more subtrees
+  are culled. The farther child is pushed with its entry distance and
+  skipped on pop if a closer hit has been found.
+  The threaded layout is kept, so the right child of an internal node is
+  the failure next index of the left child.
+  */
+void Bvh::castRayOrdered(const Ray& ray,
+                         RayHit* hit,
+                         TraversalCount* count) const noexcept
+{
+  ReferenceMailbox mailbox;
+  const auto& bvh_tree = bvhTree();
+  {
+    ++count->visits_;
+    const auto result = bvh_tree[0].boundingBox().testIntersection(ray);
+    if (!result.isSuccess() || (hit->rayDistance() <= result.rayDistance()))
+      return;
+  }
+
+  std::array<uint32, orderedTraversalStackSize()> index_stack;
+  std::array<Float, orderedTraversalStackSize()> distance_stack;
+  uint n = 0;
+  uint32 index = 0;
+  while (true) {
+    const auto& node = bvh_tree[index];
+    if (node.isLeafNode()) {
+      testRayObjectsIntersection(ray, node.objectIndex(), node.numOfObjects(),
+                                 &mailbox, hit, count);
+    }
+    else {
+      const uint32 left_index = index + 1;
+      const uint32 right_index = bvh_tree[left_index].failureNextIndex();
+      // The both children are tested at the parent
+      count->visits_ += 2;
+      const auto left_result =
+          bvh_tree[left_index].boundingBox().testIntersection(ray);
+      const auto right_result =
+          bvh_tree[right_index].boundingBox().testIntersection(ray);
+      const bool left_is_hit = left_result.isSuccess() &&
+          (left_result.rayDistance() < hit->rayDistance());
+      const bool right_is_hit = right_result.isSuccess() &&
+          (right_result.rayDistance() < hit->rayDistance());
+      if (left_is_hit && right_is_hit) {
+        const bool left_is_near = left_result.rayDistance() <= right_result.rayDistance();
+        index_stack[n] = left_is_near ? right_index : left_index;
+        distance_stack[n] = left_is_near ? right_result.rayDistance()
+                                         : left_result.rayDistance();
+        // The far child is popped later, so its data is fetched meanwhile
+        if constexpr (traversalPrefetchIsEnabled()) {
+          const auto& far_node = bvh_tree[index_stack[n]];
+          if (far_node.isLeafNode())
+            prefetchObjects(far_node.objectIndex());
+          else
+            prefetch(&bvh_tree[index_stack[n] + 1]);
+        }
+        ++n;
+        ZISC_ASSERT(n <= orderedTraversalStackSize(),
+                    "The traversal stack is overflowed.");
+        index = left_is_near ? left_index : right_index;
+        continue;
+      }
+      if (left_is_hit || right_is_hit) {
+        index = left_is_hit ? left_index : right_index;
+        continue;
+      }
+    }
+    // Pop the next node which can still have a closer hit
+    while ((0 < n) && (hit->rayDistance() <= distance_stack[n - 1]))
+      --n;
+    if (n == 0)
+      break;
+    --n;
+    index = index_stack[n];
+  }
+}
+
+/*!
+  */
+uint Bvh::calcTreeDepth(const uint32 index) const noexcept
+{
+  const auto& node = tree_[index];
+  uint depth = 1;
+  if (!node.isLeafNode()) {
+    const uint32 left_index = index + 1;
+    const uint32 right_index = tree_[left_index].failureNextIndex();
+    depth += zisc::max(calcTreeDepth(left_index), calcTreeDepth(right_index));
+  }
+  return depth;
+}
+
+/*!
+  */
+RayHit Bvh::findClosestHit(const Ray& ray,
+                           const Float max_distance,
+                           RenderingCounter* counter) const noexcept
+{
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  TraversalCount count;
+  RayHit hit{max_distance};
+  // The large objects clip the max distance of the traversal
+  testLargeObjectsIntersection(ray, &hit, &count);
+  switch (layoutType()) {
+   case BvhLayoutType::kWide4:
+    castRayWide<WideBvhNode<4>>(ray, &hit, &count);
+    break;
+   case BvhLayoutType::kOrderedBinary:
+    castRayOrdered(ray, &hit, &count);
+    break;
+   case BvhLayoutType::kWide8:
+    castRayWide<WideBvhNode<8>>(ray, &hit, &count);
+    break;
+   case BvhLayoutType::kQuantized4:
+    castRayWide<QuantizedBvhNode>(ray, &hit, &count);
+    break;
+   case BvhLayoutType::kBinary:
+   default:
+    castRayBinary(ray, &hit, &count);
+    break;
+  }
+  count.addTo(counter);
+  return hit;
 }
 
 /*!
@@ -100,20 +457,269 @@ void Bvh::construct(System& system,
               "The size of objects is over.");
   // Allocate memory
   object_list_.reserve(object_list.size());
+  zisc::pmr::vector<Object> large_object_list{settings->workResource()};
+  if (castNode<BvhSettingNode>(settings)->isLargeObjectSeparationEnabled())
+    separateLargeObjects(&object_list, &large_object_list);
   if (object_list.size() == 1) {
     tree_.resize(1);
     setTreeInfo(object_list);
   }
   else {
     auto work_resource = settings->workResource();
-    zisc::pmr::vector<BvhBuildingNode> tree{work_resource};
-    constructBvh(system, object_list, tree);
-    sortTreeNode(tree);
-    tree_.resize(tree.size());
-    setTreeInfo(tree, object_list, zisc::cast<uint32>(tree.size()), 0);
+    zisc::pmr::vector<uint32> object_order{work_resource};
+    object_order.reserve(object_list.size());
+    // Load the tree from the cache
+    const auto cache_directory =
+        castNode<BvhSettingNode>(settings)->cacheDirectory();
+    const bool cache_is_enabled = !cache_directory.empty();
+    uint64 cache_key = 0;
+    std::string cache_path;
+    bool is_cached = false;
+    if (cache_is_enabled) {
+      const auto start_time = system.stopwatch().elapsedTime();
+      cache_key = BvhCache::makeKey(settings, object_list);
+      cache_path = BvhCache::makeFilePath(cache_directory, cache_key);
+      is_cached = BvhCache::load(cache_path, cache_key, object_list.size(),
+                                 &tree_, &object_order);
+      if (is_cached)
+        setObjectList(object_list, object_order);
+      recordBuildPhase(system, (is_cached) ? "Cache load" : "Cache lookup",
+                       start_time, &buildPhaseList());
+    }
+    // Build the tree
+    if (!is_cached) {
+      zisc::pmr::vector<BvhBuildingNode> tree{work_resource};
+      constructBvh(system, object_list, tree);
+      const auto start_time = system.stopwatch().elapsedTime();
+      sortTreeNode(tree);
+      tree_.resize(tree.size());
+      setTreeInfo(tree, object_list, zisc::cast<uint32>(tree.size()), 0,
+                  &object_order);
+      setObjectList(object_list, object_order);
+      recordBuildPhase(system, "Tree layout", start_time, &buildPhaseList());
+      if (cache_is_enabled) {
+        const auto save_time = system.stopwatch().elapsedTime();
+        BvhCache::save(cache_path, cache_key, object_list.size(), tree_,
+                       object_order);
+        recordBuildPhase(system, "Cache save", save_time, &buildPhaseList());
+      }
+    }
   }
   ZISC_ASSERT(object_list_.size() == object_list.size(),
               "The object list is collapsed.");
+  // The large objects follow the objects of the tree
+  large_object_index_ = zisc::cast<uint32>(object_list_.size());
+  for (auto& object : large_object_list)
+    object_list_.emplace_back(std::move(object));
+  triangle_list_.setObjects(object_list_);
+  if (layoutType() == BvhLayoutType::kOrderedBinary) {
+    // The traversal stack is bounded, so fall back to the stackless traversal
+    if (orderedTraversalStackSize() < calcTreeDepth(0))
+      layout_type_ = BvhLayoutType::kBinary;
+  }
+  else if (layoutType() != BvhLayoutType::kBinary) {
+    const auto start_time = system.stopwatch().elapsedTime();
+    constructWideTree();
+    recordBuildPhase(system, "Tree collapse", start_time, &buildPhaseList());
+  }
+}
+
+/*!
+  \details
+  Leaf children are tested as soon as the node is visited and
+  internal children are pushed far to near so that the nearest one is
+  visited first and the closest distance shrinks quickly.
+  */
+template <typename WideNode>
+void Bvh::castRayWide(const Ray& ray,
+                      RayHit* hit,
+                      TraversalCount* count) const noexcept
+{
+  constexpr uint kWidth = WideNode::width();
+
+  ReferenceMailbox mailbox;
+  const auto& wide_tree = wideTree<WideNode>();
+
+  constexpr uint stack_size = wideTraversalStackSize<kWidth>();
+  std::array<uint32, stack_size> index_stack;
+  std::array<Float, stack_size> distance_stack;
+  uint n = 0;
+  index_stack[n] = 0;
+  distance_stack[n] = 0.0;
+  ++n;
+  while (0 < n) {
+    --n;
+    if (hit->rayDistance() <= distance_stack[n])
+      continue;
+    const auto& node = wide_tree[index_stack[n]];
+    ++count->visits_;
+    typename WideNode::DistanceList distance_list;
+    const uint32 hit_mask = node.testIntersection(ray,
+                                                  hit->rayDistance(),
+                                                  &distance_list);
+    // The objects of the hit leaves are fetched at once before the tests
+    if constexpr (traversalPrefetchIsEnabled()) {
+      for (uint child = 0; child < kWidth; ++child) {
+        const bool is_hit = (hit_mask & (zisc::cast<uint32>(1) << child)) != 0;
+        if (is_hit && node.isLeafChild(child))
+          prefetchObjects(node.childIndex(child));
+      }
+    }
+    // Leaf children
+    for (uint child = 0; child < kWidth; ++child) {
+      const bool is_hit = (hit_mask & (zisc::cast<uint32>(1) << child)) != 0;
+      if (is_hit && node.isLeafChild(child)) {
+        testRayObjectsIntersection(ray,
+                                   node.childIndex(child),
+                                   node.numOfObjects(child),
+                                   &mailbox,
+                                   hit,
+                                   count);
+      }
+    }
+    // Internal children
+    const uint begin = n;
+    for (uint child = 0; child < kWidth; ++child) {
+      const bool is_hit = (hit_mask & (zisc::cast<uint32>(1) << child)) != 0;
+      if (is_hit && !node.isLeafChild(child) &&
+          (distance_list[child] < hit->rayDistance())) {
+        // Insert the child keeping the far to near order
+        uint i = n;
+        for (; (begin < i) && (distance_stack[i - 1] < distance_list[child]); --i) {
+          index_stack[i] = index_stack[i - 1];
+          distance_stack[i] = distance_stack[i - 1];
+        }
+        index_stack[i] = node.childIndex(child);
+        distance_stack[i] = distance_list[child];
+        if constexpr (traversalPrefetchIsEnabled())
+          prefetch(&wide_tree[node.childIndex(child)]);
+        ++n;
+        ZISC_ASSERT(n <= stack_size, "The traversal stack is overflowed.");
+      }
+    }
+  }
+}
+
+/*!
+  */
+template <typename WideNode>
+uint32 Bvh::collapseTree(const uint32 index,
+                         const uint depth,
+                         uint* max_depth) noexcept
+{
+  constexpr uint kWidth = WideNode::width();
+  ZISC_ASSERT(!tree_[index].isLeafNode(), "The node isn't an internal node.");
+  *max_depth = zisc::max(*max_depth, depth);
+
+  // Gather the children by opening the internal child of the largest area
+  const auto get_left_child = [](const uint32 i)
+  {
+    return i + 1;
+  };
+  const auto get_right_child = [this](const uint32 i)
+  {
+    return tree_[i + 1].failureNextIndex();
+  };
+  std::array<uint32, kWidth> child_list;
+  uint num_of_children = 2;
+  child_list[0] = get_left_child(index);
+  child_list[1] = get_right_child(index);
+  while (num_of_children < kWidth) {
+    uint candidate = kWidth;
+    Float max_area = 0.0;
+    for (uint i = 0; i < num_of_children; ++i) {
+      const auto& child = tree_[child_list[i]];
+      const Float area = child.boundingBox().surfaceArea();
+      if (!child.isLeafNode() && ((candidate == kWidth) || (max_area < area))) {
+        candidate = i;
+        max_area = area;
+      }
+    }
+    if (candidate == kWidth)
+      break;
+    const uint32 opened_index = child_list[candidate];
+    child_list[candidate] = get_left_child(opened_index);
+    child_list[num_of_children] = get_right_child(opened_index);
+    ++num_of_children;
+  }
+
+  // Make a wide node
+  auto& wide_tree = wideTree<WideNode>();
+  const uint32 node_index = zisc::cast<uint32>(wide_tree.size());
+  wide_tree.emplace_back();
+  {
+    std::array<Aabb, kWidth> bounding_box_list;
+    for (uint i = 0; i < num_of_children; ++i)
+      bounding_box_list[i] = tree_[child_list[i]].boundingBox();
+    wide_tree[node_index].setChildBoundingBoxes(bounding_box_list.data(),
+                                                num_of_children);
+  }
+  for (uint i = 0; i < num_of_children; ++i) {
+    const auto& child = tree_[child_list[i]];
+    if (child.isLeafNode()) {
+      wide_tree[node_index].setLeafChild(i,
+                                         child.objectIndex(),
+                                         child.numOfObjects());
+    }
+    else {
+      const uint32 child_index = collapseTree<WideNode>(child_list[i],
+                                                        depth + 1,
+                                                        max_depth);
+      wide_tree[node_index].setInternalChild(i, child_index);
+    }
+  }
+  return node_index;
+}
+
+/*!
+  */
+void Bvh::constructWideTree() noexcept
+{
+  const auto construct = [this](auto& wide_tree)
+  {
+    using WideNode = typename std::remove_reference_t<decltype(wide_tree)>::value_type;
+    constexpr uint width = WideNode::width();
+    wide_tree.clear();
+    wide_tree.reserve(tree_.size() / (width - 1) + 1);
+    uint max_depth = 0;
+    if (tree_[0].isLeafNode()) {
+      wide_tree.emplace_back();
+      wide_tree[0].setChildBoundingBoxes(&tree_[0].boundingBox(), 1);
+      wide_tree[0].setLeafChild(0, tree_[0].objectIndex(), tree_[0].numOfObjects());
+    }
+    else {
+      collapseTree<WideNode>(0, 1, &max_depth);
+    }
+    wide_tree.shrink_to_fit();
+    return max_depth;
+  };
+
+  uint max_depth = 0;
+  switch (layoutType()) {
+   case BvhLayoutType::kWide4: {
+    max_depth = construct(wide4_tree_);
+    break;
+   }
+   case BvhLayoutType::kWide8: {
+    max_depth = construct(wide8_tree_);
+    break;
+   }
+   case BvhLayoutType::kQuantized4: {
+    max_depth = construct(quantized4_tree_);
+    break;
+   }
+   case BvhLayoutType::kBinary:
+   case BvhLayoutType::kOrderedBinary:
+   default:
+    break;
+  }
+  // The traversal stack is bounded, so fall back to the binary layout
+  if (wideTreeMaxDepth() < max_depth) {
+    wide4_tree_.clear();
+    wide8_tree_.clear();
+    quantized4_tree_.clear();
+    layout_type_ = BvhLayoutType::kBinary;
+  }
 }
 
 /*!
@@ -130,14 +736,21 @@ zisc::UniqueMemoryPointer<Bvh> Bvh::makeBvh(
   switch (bvh_setting_node->bvhType()) {
    case BvhType::kBinaryRadixTree: {
     bvh = zisc::UniqueMemoryPointer<BinaryRadixTreeBvh>::make(
-        &system.dataMemoryManager(),
+        &system.trackedMemoryResource(MemoryCategory::kBvh),
         system,
         settings);
     break;
    }
    case BvhType::kAgglomerativeTreeletRestructuring: {
     bvh = zisc::UniqueMemoryPointer<AgglomerativeTreeletRestructuringBvh>::make(
-        &system.dataMemoryManager(),
+        &system.trackedMemoryResource(MemoryCategory::kBvh),
+        system,
+        settings);
+    break;
+   }
+   case BvhType::kBinnedSah: {
+    bvh = zisc::UniqueMemoryPointer<BinnedSahBvh>::make(
+        &system.trackedMemoryResource(MemoryCategory::kBvh),
         system,
         settings);
     break;
@@ -150,6 +763,180 @@ zisc::UniqueMemoryPointer<Bvh> Bvh::makeBvh(
   return bvh;
 }
 
+/*!
+  \details
+  The topology of the tree and the order of the objects are kept,
+  so the tree quality degrades if the shapes move a lot from the build.
+  */
+void Bvh::refit(System& system) noexcept
+{
+  buildPhaseList().clear();
+  const auto start_time = system.stopwatch().elapsedTime();
+  refitBoundingBoxes(system, 0);
+  triangle_list_.setObjects(object_list_);
+  if (layoutType() != BvhLayoutType::kBinary)
+    constructWideTree();
+  recordBuildPhase(system, "Refit", start_time, &buildPhaseList());
+}
+
+/*!
+  */
+Aabb Bvh::refitBoundingBoxes(System& system,
+                             const uint32 index,
+                             const uint depth) noexcept
+{
+  auto& node = tree_[index];
+  Aabb bounding_box;
+  // Leaf node
+  if (node.isLeafNode()) {
+    const uint32 object_index = node.objectIndex();
+    const auto& first_object = object_list_[referencedObjectIndex(object_index)];
+    bounding_box = first_object.shape().boundingBox();
+    for (uint i = 1; i < node.numOfObjects(); ++i) {
+      const auto& object = object_list_[referencedObjectIndex(object_index + i)];
+      bounding_box = combine(bounding_box, object.shape().boundingBox());
+    }
+  }
+  // Internal node
+  else {
+    const uint32 left_child_index = index + 1;
+    const uint32 right_child_index = tree_[left_child_index].failureNextIndex();
+    auto& scheduler = system.taskScheduler();
+    // Threading
+    if (threadingIsEnabled() && (depth < scheduler.forkDepth())) {
+      TaskGroup group{scheduler};
+      Aabb left_box;
+      auto refit_left = [this, &system, left_child_index, depth, &left_box]()
+      {
+        left_box = refitBoundingBoxes(system, left_child_index, depth + 1);
+      };
+      group.run(refit_left);
+      const auto right_box = refitBoundingBoxes(system, right_child_index, depth + 1);
+      group.wait();
+      bounding_box = combine(left_box, right_box);
+    }
+    // Sequence
+    else {
+      const auto left_box = refitBoundingBoxes(system, left_child_index, depth + 1);
+      const auto right_box = refitBoundingBoxes(system, right_child_index, depth + 1);
+      bounding_box = combine(left_box, right_box);
+    }
+  }
+  node.setBoundingBox(bounding_box);
+  return bounding_box;
+}
+
+/*!
+  \details
+  The traversal returns as soon as a blocking object is found,
+  so the order of the hits doesn't matter unlike castRay().
+  */
+bool Bvh::testOcclusion(const Ray& ray,
+                        const Float max_distance,
+                        const Object* target_object,
+                        RenderingCounter* counter) const noexcept
+{
+  ZISC_ASSERT(0.0 < max_distance, "The max_distance is minus.");
+  TraversalCount count;
+  // The large objects are tested first
+  bool is_occluded = testLargeObjectsOcclusion(ray, max_distance,
+                                               target_object, &count);
+  if (!is_occluded) {
+    switch (layoutType()) {
+     case BvhLayoutType::kWide4:
+      is_occluded = testOcclusionWide<WideBvhNode<4>>(ray, max_distance,
+                                                      target_object, &count);
+      break;
+     case BvhLayoutType::kWide8:
+      is_occluded = testOcclusionWide<WideBvhNode<8>>(ray, max_distance,
+                                                      target_object, &count);
+      break;
+     case BvhLayoutType::kQuantized4:
+      is_occluded = testOcclusionWide<QuantizedBvhNode>(ray, max_distance,
+                                                        target_object, &count);
+      break;
+     case BvhLayoutType::kBinary:
+     case BvhLayoutType::kOrderedBinary:
+     default:
+      is_occluded = testOcclusionBinary(ray, max_distance, target_object, &count);
+      break;
+    }
+  }
+  count.addTo(counter);
+  return is_occluded;
+}
+
+/*!
+  */
+bool Bvh::testOcclusionBinary(const Ray& ray,
+                              const Float max_distance,
+                              const Object* target_object,
+                              TraversalCount* count) const noexcept
+{
+  uint32 index = 0;
+  const auto& bvh_tree = bvhTree();
+  const uint32 end_index = zisc::cast<uint32>(bvh_tree.size());
+  while (index != end_index) {
+    const auto& node = bvh_tree[index];
+    if constexpr (traversalPrefetchIsEnabled())
+      prefetchCandidates(node);
+    ++count->visits_;
+    const auto result = node.boundingBox().testIntersection(ray);
+    // If the ray hits the bounding box of the node, enter the node
+    if (result.isSuccess() && (result.rayDistance() < max_distance)) {
+      // A case of leaf node
+      if (node.isLeafNode() &&
+          testRayObjectsOcclusion(ray, max_distance, node.objectIndex(),
+                                  node.numOfObjects(), target_object, count))
+        return true;
+      ++index;
+    }
+    else {
+      index = node.failureNextIndex();
+    }
+  }
+  return false;
+}
+
+/*!
+  \details
+  An object is large if its box area is over the ratio of the scene box.
+  At least one object remains in the tree.
+  */
+void Bvh::separateLargeObjects(
+    zisc::pmr::vector<Object>* object_list,
+    zisc::pmr::vector<Object>* large_object_list) const noexcept
+{
+  ZISC_ASSERT(object_list != nullptr, "The object list is null.");
+  if (object_list->size() <= 1)
+    return;
+  auto scene_box = (*object_list)[0].shape().boundingBox();
+  for (const auto& object : *object_list)
+    scene_box = combine(scene_box, object.shape().boundingBox());
+  const Float threshold = largeObjectAreaRatio() * scene_box.surfaceArea();
+
+  uint num_of_large_objects = 0;
+  for (const auto& object : *object_list) {
+    if (threshold < object.shape().boundingBox().surfaceArea())
+      ++num_of_large_objects;
+  }
+  if ((num_of_large_objects == 0) ||
+      (num_of_large_objects == object_list->size()))
+    return;
+
+  zisc::pmr::vector<Object> small_object_list{object_list->get_allocator().resource()};
+  small_object_list.reserve(object_list->size() - num_of_large_objects);
+  large_object_list->reserve(num_of_large_objects);
+  for (auto& object : *object_list) {
+    const bool is_large = threshold < object.shape().boundingBox().surfaceArea();
+    if (is_large)
+      large_object_list->emplace_back(std::move(object));
+    else
+      small_object_list.emplace_back(std::move(object));
+  }
+  object_list->swap(small_object_list);
+}
+
 /*!
   */
 void Bvh::setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
@@ -178,6 +965,36 @@ void Bvh::setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
   }
 }
 
+/*!
+  \details
+  If an object is referenced by several leaves because of spatial splits,
+  the leaves refer to the objects through the reference list.
+  */
+void Bvh::setObjectList(zisc::pmr::vector<Object>& object_list,
+                        const zisc::pmr::vector<uint32>& reference_order) noexcept
+{
+  reference_list_.clear();
+  // Each object is referenced once
+  if (reference_order.size() == object_list.size()) {
+    for (const uint32 index : reference_order)
+      object_list_.emplace_back(std::move(object_list[index]));
+    return;
+  }
+
+  constexpr uint32 invalid_index = std::numeric_limits<uint32>::max();
+  zisc::pmr::vector<uint32> new_index_list{
+      reference_order.get_allocator().resource()};
+  new_index_list.resize(object_list.size(), invalid_index);
+  reference_list_.reserve(reference_order.size());
+  for (const uint32 index : reference_order) {
+    if (new_index_list[index] == invalid_index) {
+      new_index_list[index] = zisc::cast<uint32>(object_list_.size());
+      object_list_.emplace_back(std::move(object_list[index]));
+    }
+    reference_list_.emplace_back(new_index_list[index]);
+  }
+}
+
 /*!
   \details
   No detailed.
@@ -185,32 +1002,35 @@ void Bvh::setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
 void Bvh::setTreeInfo(const zisc::pmr::vector<BvhBuildingNode>& tree,
                       zisc::pmr::vector<Object>& object_list,
                       const uint32 failure_next_index,
-                      const uint32 index) noexcept
+                      const uint32 index,
+                      zisc::pmr::vector<uint32>* object_order) noexcept
 {
   const auto& node = tree[index];
   // Set the node
   {
     auto& new_node = tree_[index];
-    const uint32 object_index = zisc::cast<uint32>(object_list_.size());
+    const uint32 object_index = zisc::cast<uint32>(object_order->size());
     new_node.setBoundingBox(node.boundingBox());
     new_node.setObjectInfo(object_index, node.numOfObjects());
     new_node.setFailureNextIndex(failure_next_index);
   }
-  // Set the objects
+  // Set the object references
   const auto& node_object_list = node.objectList();
   for (uint i = 0; i < node.numOfObjects(); ++i) {
     ZISC_ASSERT(node_object_list[i] != nullptr, "The object is null.");
     const uint object_index = zisc::cast<uint>(node_object_list[i] -
                                                object_list.data());
     ZISC_ASSERT(object_index < object_list.size(), "invalid index is specified.");
-    object_list_.emplace_back(std::move(object_list[object_index]));
+    object_order->emplace_back(zisc::cast<uint32>(object_index));
   }
   if (!node.isLeafNode()) {
     // Child nodes
     const uint32 left_child_index = node.leftChildIndex();
     const uint32 right_child_index = node.rightChildIndex();
-    setTreeInfo(tree, object_list, right_child_index, left_child_index);
-    setTreeInfo(tree, object_list, failure_next_index, right_child_index);
+    setTreeInfo(tree, object_list, right_child_index, left_child_index,
+                object_order);
+    setTreeInfo(tree, object_list, failure_next_index, right_child_index,
+                object_order);
   }
 }
 
@@ -278,22 +1098,328 @@ void Bvh::sortTreeNode(const zisc::pmr::vector<BvhBuildingNode>& tree,
 
 /*!
   \details
-  No detailed.
+  The surface attributes are computed only once per ray.
+  A triangle is computed directly without the virtual call.
+  */
+void Bvh::makeIntersectionInfo(const Ray& ray,
+                               const RayHit& hit,
+                               IntersectionInfo* intersection) const noexcept
+{
+  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  if (!hit.isHit()) {
+    intersection->setObject(nullptr);
+    intersection->setRayDistance(hit.rayDistance());
+    return;
+  }
+  const uint32 index = hit.objectIndex();
+  const auto& triangle_list = triangleList();
+  if (out_of_core_resource_ != nullptr)
+    out_of_core_resource_->touch(&objectList()[index].shape());
+  if (triangle_list.isTriangle(index)) {
+    triangle_list.triangle(index).setIntersectionInfo(ray,
+                                                      hit.rayDistance(),
+                                                      hit.st(),
+                                                      intersection);
+    intersection->setObject(&objectList()[index]);
+  }
+  else {
+    const auto& object = objectList()[index];
+    const auto& shape = object.shape();
+    shape.computeSurfacePoint(ray, hit, intersection);
+    // An instance sets the object of the bottom-level BVH
+    if (shape.type() != ShapeType::kInstance)
+      intersection->setObject(&object);
+  }
+}
+
+/*!
+  */
+inline
+void Bvh::testLargeObjectsIntersection(const Ray& ray,
+                                       RayHit* hit,
+                                       TraversalCount* count) const noexcept
+{
+  const auto& object_list = objectList();
+  const auto& triangle_list = triangleList();
+  const uint32 end = zisc::cast<uint32>(object_list.size());
+  if (large_object_index_ == end)
+    return;
+  touchObjects(large_object_index_, end - large_object_index_);
+  const TriangleList::TestRay test_ray{ray};
+  for (uint32 index = large_object_index_; index < end; ++index) {
+    ++count->tests_;
+    Point2 st;
+    uint32 primitive_index = 0;
+    const auto result = (triangle_list.isTriangle(index))
+        ? triangle_list.testIntersection(index,
+                                         test_ray,
+                                         hit->rayDistance(),
+                                         &st)
+        : object_list[index].shape().testIntersection(ray,
+                                                      hit->rayDistance(),
+                                                      &st,
+                                                      &primitive_index);
+    if (result)
+      hit->set(result.rayDistance(), index, primitive_index, st);
+  }
+}
+
+/*!
+  */
+inline
+bool Bvh::testLargeObjectsOcclusion(const Ray& ray,
+                                    const Float max_distance,
+                                    const Object* target_object,
+                                    TraversalCount* count) const noexcept
+{
+  const auto& object_list = objectList();
+  const auto& triangle_list = triangleList();
+  const uint32 end = zisc::cast<uint32>(object_list.size());
+  if (large_object_index_ == end)
+    return false;
+  touchObjects(large_object_index_, end - large_object_index_);
+  const TriangleList::TestRay test_ray{ray};
+  for (uint32 index = large_object_index_; index < end; ++index) {
+    const auto& object = object_list[index];
+    if (isSameObject(&object, target_object))
+      continue;
+    ++count->tests_;
+    const bool is_occluded = (triangle_list.isTriangle(index))
+        ? triangle_list.testOcclusion(index, test_ray, max_distance)
+        : object.shape().testOcclusion(ray, max_distance);
+    if (is_occluded)
+      return true;
+  }
+  return false;
+}
+
+/*!
+  \details
+  The failure next node is fetched while the box of the node is tested,
+  the next node in the order is usually in the same or the next cache line.
+  */
+inline
+void Bvh::prefetchCandidates(const BvhTreeNode& node) const noexcept
+{
+  const auto& bvh_tree = bvhTree();
+  const uint32 failure_next_index = node.failureNextIndex();
+  if (failure_next_index < bvh_tree.size())
+    prefetch(&bvh_tree[failure_next_index]);
+  if (node.isLeafNode())
+    prefetchObjects(node.objectIndex());
+}
+
+/*!
+  \details
+  The references are prefetched if objects are split,
+  otherwise the triangle data of the leaf is prefetched.
+  */
+inline
+void Bvh::prefetchObjects(const uint32 object_index) const noexcept
+{
+  if (!reference_list_.empty())
+    prefetch(&reference_list_[object_index]);
+  else
+    triangleList().prefetch(object_index);
+}
+
+/*!
+  \details
+  A hit has to be strictly closer than the current closest hit,
+  so an object which is referenced by several leaves is never reported twice.
+  The mailbox only skips the redundant tests of the object.
+  The objects only update the hit record.
   */
 inline
 void Bvh::testRayObjectsIntersection(const Ray& ray,
-                                     const BvhTreeNode& leaf_node,
-                                     IntersectionInfo* intersection) const noexcept
+                                     const uint32 object_index,
+                                     const uint num_of_objects,
+                                     ReferenceMailbox* mailbox,
+                                     RayHit* hit,
+                                     TraversalCount* count) const noexcept
 {
-  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  ZISC_ASSERT(hit != nullptr, "The hit is null.");
+  touchObjects(object_index, num_of_objects);
   const auto& object_list = objectList();
-  for (uint i = 0; i < leaf_node.numOfObjects(); ++i) {
-    const auto object_index = leaf_node.objectIndex() + i;
-    const auto& object = object_list[object_index];
-    const auto result = object.shape().testIntersection(ray, intersection);
+  const auto& triangle_list = triangleList();
+  const bool has_references = !reference_list_.empty();
+  const TriangleList::TestRay test_ray{ray};
+  uint step = 1;
+  for (uint i = 0; i < num_of_objects; i += step) {
+    step = 1;
+    // Four contiguous triangles are tested at once
+    if (!has_references && (i + 4 <= num_of_objects) &&
+        triangle_list.isTriangle4(object_index + i)) {
+      step = 4;
+      const uint32 index = object_index + i;
+      count->tests_ += 4;
+      Float distance;
+      Point2 st;
+      const uint lane = triangle_list.testIntersection4(index,
+                                                        test_ray,
+                                                        hit->rayDistance(),
+                                                        &distance,
+                                                        &st);
+      if (lane < 4)
+        hit->set(distance, index + lane, 0, st);
+      continue;
+    }
+    const uint32 index = referencedObjectIndex(object_index + i);
+    if (has_references) {
+      if (mailbox->contains(index))
+        continue;
+      mailbox->add(index);
+    }
+    ++count->tests_;
+    Point2 st;
+    uint32 primitive_index = 0;
+    const auto result = (triangle_list.isTriangle(index))
+        ? triangle_list.testIntersection(index,
+                                         test_ray,
+                                         hit->rayDistance(),
+                                         &st)
+        : object_list[index].shape().testIntersection(ray,
+                                                      hit->rayDistance(),
+                                                      &st,
+                                                      &primitive_index);
     if (result)
-      intersection->setObject(&object);
+      hit->set(result.rayDistance(), index, primitive_index, st);
+  }
+}
+
+/*!
+  */
+inline
+bool Bvh::testRayObjectsOcclusion(const Ray& ray,
+                                  const Float max_distance,
+                                  const uint32 object_index,
+                                  const uint num_of_objects,
+                                  const Object* target_object,
+                                  TraversalCount* count) const noexcept
+{
+  touchObjects(object_index, num_of_objects);
+  const auto& object_list = objectList();
+  const auto& triangle_list = triangleList();
+  const bool has_references = !reference_list_.empty();
+  const TriangleList::TestRay test_ray{ray};
+  uint step = 1;
+  for (uint i = 0; i < num_of_objects; i += step) {
+    step = 1;
+    // Four contiguous triangles are tested at once
+    if (!has_references && (i + 4 <= num_of_objects) &&
+        triangle_list.isTriangle4(object_index + i)) {
+      step = 4;
+      const uint32 index = object_index + i;
+      count->tests_ += 4;
+      uint32 mask = triangle_list.testOcclusion4(index, test_ray, max_distance);
+      for (uint lane = 0; lane < 4; ++lane) {
+        if (isSameObject(&object_list[index + lane], target_object))
+          mask &= ~(zisc::cast<uint32>(1) << lane);
+      }
+      if (mask != 0)
+        return true;
+      continue;
+    }
+    const uint32 index = referencedObjectIndex(object_index + i);
+    const auto& object = object_list[index];
+    if (isSameObject(&object, target_object))
+      continue;
+    ++count->tests_;
+    const bool is_occluded = (triangle_list.isTriangle(index))
+        ? triangle_list.testOcclusion(index, test_ray, max_distance)
+        : object.shape().testOcclusion(ray, max_distance);
+    if (is_occluded)
+      return true;
+  }
+  return false;
+}
+
+/*!
+  \details
+  The coefficients of the contiguous triangles are in the same clusters,
+  so only the first and the last triangles of a leaf are touched.
+  The other shapes are touched one by one.
+  */
+inline
+void Bvh::touchObjects(const uint32 object_index,
+                       const uint num_of_objects) const noexcept
+{
+  if (out_of_core_resource_ == nullptr)
+    return;
+  const auto& triangle_list = triangleList();
+  const bool has_references = !reference_list_.empty();
+  for (uint i = 0; i < num_of_objects; ++i) {
+    const uint32 index = referencedObjectIndex(object_index + i);
+    if (triangle_list.isTriangle(index)) {
+      const bool is_end = (i == 0) || (i + 1 == num_of_objects);
+      if (has_references || is_end)
+        triangle_list.touch(index, out_of_core_resource_);
+    }
+    else {
+      out_of_core_resource_->touch(&object_list_[index].shape());
+    }
+  }
+}
+
+/*!
+  */
+template <typename WideNode>
+bool Bvh::testOcclusionWide(const Ray& ray,
+                            const Float max_distance,
+                            const Object* target_object,
+                            TraversalCount* count) const noexcept
+{
+  constexpr uint kWidth = WideNode::width();
+
+  const auto& wide_tree = wideTree<WideNode>();
+
+  std::array<uint32, wideTraversalStackSize<kWidth>()> index_stack;
+  uint n = 0;
+  index_stack[n++] = 0;
+  while (0 < n) {
+    const auto& node = wide_tree[index_stack[--n]];
+    ++count->visits_;
+    typename WideNode::DistanceList distance_list;
+    const uint32 hit_mask = node.testIntersection(ray,
+                                                  max_distance,
+                                                  &distance_list);
+    for (uint child = 0; child < kWidth; ++child) {
+      const bool is_hit = (hit_mask & (zisc::cast<uint32>(1) << child)) != 0;
+      if (!is_hit)
+        continue;
+      if (node.isLeafChild(child)) {
+        if (testRayObjectsOcclusion(ray,
+                                    max_distance,
+                                    node.childIndex(child),
+                                    node.numOfObjects(child),
+                                    target_object,
+                                    count))
+          return true;
+      }
+      else {
+        if constexpr (traversalPrefetchIsEnabled())
+          prefetch(&wide_tree[node.childIndex(child)]);
+        index_stack[n++] = node.childIndex(child);
+      }
+    }
   }
+  return false;
 }
 
+template void Bvh::castRayPacket<4>(
+    const RayPacket<4>&,
+    const Float,
+    std::array<IntersectionInfo, 4>*,
+    RenderingCounter*) const noexcept;
+template void Bvh::castRayPacket<8>(
+    const RayPacket<8>&,
+    const Float,
+    std::array<IntersectionInfo, 8>*,
+    RenderingCounter*) const noexcept;
+template void Bvh::castRayPacket<16>(
+    const RayPacket<16>&,
+    const Float,
+    std::array<IntersectionInfo, 16>*,
+    RenderingCounter*) const noexcept;
+
 } // namespace nanairo
@@ -11,6 +11,7 @@
 #define NANAIRO_BVH_HPP
 
 // Standard C++ library
+#include <array>
 #include <cstddef>
 #include <memory>
 #include <vector>
@@ -18,12 +19,19 @@
 #include "zisc/memory_resource.hpp"
 #include "zisc/non_copyable.hpp"
 #include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/stopwatch.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "aabb.hpp"
 #include "bvh_building_node.hpp"
 #include "bvh_tree_node.hpp"
+#include "quantized_bvh_node.hpp"
+#include "triangle_list.hpp"
+#include "wide_bvh_node.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/ray_hit.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
 namespace nanairo {
@@ -32,6 +40,8 @@ namespace nanairo {
 class IntersectionInfo;
 class Ray;
 class Object;
+class OutOfCoreMemoryResource;
+class RenderingCounter;
 class System;
 
 //! \addtogroup Core
@@ -40,12 +50,48 @@ class System;
 enum class BvhType : uint32
 {
   kBinaryRadixTree            = zisc::Fnv1aHash32::hash("BinaryRadixTree"),
-  kAgglomerativeTreeletRestructuring = zisc::Fnv1aHash32::hash("AgglomerativeTreeletRestructuring")
+  kAgglomerativeTreeletRestructuring = zisc::Fnv1aHash32::hash("AgglomerativeTreeletRestructuring"),
+  kBinnedSah                  = zisc::Fnv1aHash32::hash("BinnedSah")
+};
+
+//! The node layout which is used in ray traversal
+enum class BvhLayoutType : uint32
+{
+  kBinary                     = zisc::Fnv1aHash32::hash("Binary"),
+  kOrderedBinary              = zisc::Fnv1aHash32::hash("OrderedBinary"),
+  kWide4                      = zisc::Fnv1aHash32::hash("Wide4"),
+  kWide8                      = zisc::Fnv1aHash32::hash("Wide8"),
+  kQuantized4                 = zisc::Fnv1aHash32::hash("Quantized4")
+};
+
+//! The elapsed time of a phase of the BVH construction
+struct BvhBuildPhase
+{
+  const char* name_;
+  zisc::Stopwatch::Clock::duration time_;
+};
+
+//! The quality measures of the binary tree of a BVH
+struct BvhStatistics
+{
+  //! Create empty statistics
+  BvhStatistics(zisc::pmr::memory_resource* work_resource) noexcept;
+
+  zisc::pmr::vector<uint32> depth_histogram_; //!< The number of the leaves per depth
+  zisc::pmr::vector<uint32> occupancy_histogram_; //!< The number of the leaves per size
+  Float sah_cost_ = 0.0;
+  Float overlap_ratio_ = 0.0; //!< The mean ratio of the sibling overlap to the parent
+  std::size_t memory_size_ = 0; //!< The bytes of the nodes and the object references
+  uint32 num_of_nodes_ = 0;
+  uint32 num_of_leafs_ = 0;
 };
 
 /*!
   \details
-  No detailed.
+  If the large object separation is enabled, the objects whose bounding box
+  is a large part of the scene, e.g. a floor plane, are kept out of
+  the tree and tested before the traversal. They follow the objects of
+  the tree in the object list.
   */
 class Bvh : public zisc::NonCopyable<Bvh>
 {
@@ -57,13 +103,37 @@ class Bvh : public zisc::NonCopyable<Bvh>
   virtual ~Bvh() noexcept;
 
 
+  //! Return the bounding box of all objects
+  Aabb boundingBox() const noexcept;
+
+  //! Return the elapsed time of the build phases in the order of the build
+  const zisc::pmr::vector<BvhBuildPhase>& buildPhaseList() const noexcept;
+
+  //! Measure the quality of the tree
+  BvhStatistics calcStatistics(zisc::pmr::memory_resource* work_resource) const noexcept;
+
   //! Return the tree of BVH
   const zisc::pmr::vector<BvhTreeNode>& bvhTree() const noexcept;
 
+  //! Return the node layout used in ray traversal
+  BvhLayoutType layoutType() const noexcept;
+
   //! Cast the ray and find the intersection closest to the ray origin
   IntersectionInfo castRay(const Ray& ray,
                            const Float max_distance,
-                           const bool expect_no_hit = false) const noexcept;
+                           RenderingCounter* counter = nullptr) const noexcept;
+
+  //! Cast the rays of the packet and find the closest intersection of each ray
+  template <uint kSize>
+  void castRayPacket(const RayPacket<kSize>& packet,
+                     const Float max_distance,
+                     std::array<IntersectionInfo, kSize>* intersection_list,
+                     RenderingCounter* counter = nullptr) const noexcept;
+
+  //! Find the closest hit without computing the surface attributes
+  RayHit findClosestHit(const Ray& ray,
+                        const Float max_distance,
+                        RenderingCounter* counter = nullptr) const noexcept;
 
   //! Build BVH
   void construct(System& system,
@@ -75,35 +145,162 @@ class Bvh : public zisc::NonCopyable<Bvh>
       System& system,
       const SettingNodeBase* settings) noexcept;
 
+  //! Compute the surface attributes of the closest hit
+  void makeIntersectionInfo(const Ray& ray,
+                            const RayHit& hit,
+                            IntersectionInfo* intersection) const noexcept;
+
+  //! Return the object list
+  zisc::pmr::vector<Object>& objectList() noexcept;
+
   //! Return the object list
   const zisc::pmr::vector<Object>& objectList() const noexcept;
 
+  //! Update the bounding boxes of the tree after the shapes are changed
+  void refit(System& system) noexcept;
+
+  //! Check if the ray is blocked by any object except the target
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance,
+                     const Object* target_object = nullptr,
+                     RenderingCounter* counter = nullptr) const noexcept;
+
+  //! Return the intersection data of the triangles in the object list order
+  const TriangleList& triangleList() const noexcept;
+
  protected:
+  //! Return the elapsed time of the build phases
+  zisc::pmr::vector<BvhBuildPhase>& buildPhaseList() noexcept;
+
   //! Build BVH
   virtual void constructBvh(
       System& system,
       const zisc::pmr::vector<Object>& object_list,
-      zisc::pmr::vector<BvhBuildingNode>& tree) const noexcept = 0;
+      zisc::pmr::vector<BvhBuildingNode>& tree) noexcept = 0;
+
+  //! Record the elapsed time from the start time as a build phase
+  static void recordBuildPhase(
+      const System& system,
+      const char* name,
+      const zisc::Stopwatch::Clock::duration start_time,
+      zisc::pmr::vector<BvhBuildPhase>* phase_list) noexcept;
+
+  //! Check if the morton codes of the radix trees include the object size
+  bool isExtendedMortonCodeEnabled() const noexcept;
 
   //! Check if multi-threading is enabled
   static constexpr bool threadingIsEnabled() noexcept;
 
-  //! Set the bounding box of the node
-  template <bool threading = false>
+  //! Set the bounding boxes of the subtree
   static void setupBoundingBoxes(System& system,
                                  zisc::pmr::vector<BvhBuildingNode>& tree,
-                                 const uint32 index) noexcept;
+                                 const uint32 index,
+                                 const uint depth = 0) noexcept;
 
   //! Set the bounding box of the node
   static void setupBoundingBox(zisc::pmr::vector<BvhBuildingNode>& tree,
                                const uint32 index) noexcept;
 
  private:
-  //! Set the tree node and the object list
+  /*!
+    \brief The recently tested objects of a ray
+    \details
+    An object which is split by spatial splits is referenced by several leaves.
+    The mailbox skips the redundant tests of the same object.
+    */
+  class ReferenceMailbox
+  {
+   public:
+    //! Create an empty mailbox
+    ReferenceMailbox() noexcept;
+
+    //! Add the object index
+    void add(const uint32 object_index) noexcept;
+
+    //! Check if the object has been tested
+    bool contains(const uint32 object_index) const noexcept;
+
+   private:
+    static constexpr uint kSize = 8;
+
+    std::array<uint32, kSize> object_index_list_;
+    uint next_;
+  };
+
+  /*!
+    \details
+    The counts are accumulated in the local variable during a traversal
+    and added to the counter of the thread once at the end.
+    */
+  struct TraversalCount
+  {
+    //! Add the counts to the counter if the counter isn't null
+    void addTo(RenderingCounter* counter) const noexcept;
+
+    uint64 visits_ = 0; //!< The number of the nodes visited
+    uint64 tests_ = 0; //!< The number of the primitives tested
+  };
+
+
+  //! Cast the ray through the threaded binary tree
+  void castRayBinary(const Ray& ray,
+                     RayHit* hit,
+                     TraversalCount* count) const noexcept;
+
+  //! Cast the ray visiting the nearer child first with a short stack
+  void castRayOrdered(const Ray& ray,
+                      RayHit* hit,
+                      TraversalCount* count) const noexcept;
+
+  //! Return the depth of the subtree
+  uint calcTreeDepth(const uint32 index) const noexcept;
+
+  //! Cast the ray through the wide tree
+  template <typename WideNode>
+  void castRayWide(const Ray& ray,
+                   RayHit* hit,
+                   TraversalCount* count) const noexcept;
+
+  //! Collapse the binary tree into the wide tree
+  template <typename WideNode>
+  uint32 collapseTree(const uint32 index,
+                      const uint depth,
+                      uint* max_depth) noexcept;
+
+  //! Build the wide tree from the binary tree if the layout requires it
+  void constructWideTree() noexcept;
+
+  //! Update the bounding boxes of the subtree and return the box of the node
+  Aabb refitBoundingBoxes(System& system,
+                          const uint32 index,
+                          const uint depth = 0) noexcept;
+
+  //! Return the ratio of the box area of a large object to the scene
+  static constexpr Float largeObjectAreaRatio() noexcept;
+
+  //! Prefetch the failure next node and the objects of a leaf of the binary tree
+  void prefetchCandidates(const BvhTreeNode& node) const noexcept;
+
+  //! Prefetch the first objects of a leaf
+  void prefetchObjects(const uint32 object_index) const noexcept;
+
+  //! Return the object index of the reference of a leaf
+  uint32 referencedObjectIndex(const uint32 reference_index) const noexcept;
+
+  //! Move the objects in the order of their first references
+  void setObjectList(zisc::pmr::vector<Object>& object_list,
+                     const zisc::pmr::vector<uint32>& reference_order) noexcept;
+
+  //! Move the large objects out of the list
+  void separateLargeObjects(zisc::pmr::vector<Object>* object_list,
+                            zisc::pmr::vector<Object>* large_object_list) const noexcept;
+
+  //! Set the tree node and the object reference order
   void setTreeInfo(const zisc::pmr::vector<BvhBuildingNode>& tree,
                    zisc::pmr::vector<Object>& object_list,
                    const uint32 failure_next_index,
-                   const uint32 index) noexcept;
+                   const uint32 index,
+                   zisc::pmr::vector<uint32>* object_order) noexcept;
 
   //! Set the tree with a object
   void setTreeInfo(zisc::pmr::vector<Object>& object_list) noexcept;
@@ -117,14 +314,81 @@ class Bvh : public zisc::NonCopyable<Bvh>
                     const uint32 old_index,
                     uint32& index) const noexcept;
 
+  //! Test ray-large objects intersection
+  void testLargeObjectsIntersection(const Ray& ray,
+                                    RayHit* hit,
+                                    TraversalCount* count) const noexcept;
+
+  //! Test ray-large objects occlusion
+  bool testLargeObjectsOcclusion(const Ray& ray,
+                                 const Float max_distance,
+                                 const Object* target_object,
+                                 TraversalCount* count) const noexcept;
+
   //! Test ray-objects of a leaf node intersection
   void testRayObjectsIntersection(const Ray& ray,
-                                  const BvhTreeNode& leaf_node,
-                                  IntersectionInfo* intersection) const noexcept;
+                                  const uint32 object_index,
+                                  const uint num_of_objects,
+                                  ReferenceMailbox* mailbox,
+                                  RayHit* hit,
+                                  TraversalCount* count) const noexcept;
+
+  //! Test ray-objects of a leaf node occlusion
+  bool testRayObjectsOcclusion(const Ray& ray,
+                               const Float max_distance,
+                               const uint32 object_index,
+                               const uint num_of_objects,
+                               const Object* target_object,
+                               TraversalCount* count) const noexcept;
+
+  //! Check if the ray is occluded in the threaded binary tree
+  bool testOcclusionBinary(const Ray& ray,
+                           const Float max_distance,
+                           const Object* target_object,
+                           TraversalCount* count) const noexcept;
+
+  //! Check if the ray is occluded in the wide tree
+  template <typename WideNode>
+  bool testOcclusionWide(const Ray& ray,
+                         const Float max_distance,
+                         const Object* target_object,
+                         TraversalCount* count) const noexcept;
+
+  //! Record the access of the objects of a leaf node in the out-of-core memory
+  void touchObjects(const uint32 object_index,
+                    const uint num_of_objects) const noexcept;
+
+  //! Return the stack size of the ordered traversal
+  static constexpr uint orderedTraversalStackSize() noexcept;
+
+  //! Return the max depth of the wide tree
+  static constexpr uint wideTreeMaxDepth() noexcept;
+
+  //! Return the stack size of the wide tree traversal
+  template <uint kWidth>
+  static constexpr uint wideTraversalStackSize() noexcept;
+
+  //! Return the wide tree
+  template <typename WideNode>
+  zisc::pmr::vector<WideNode>& wideTree() noexcept;
+
+  //! Return the wide tree
+  template <typename WideNode>
+  const zisc::pmr::vector<WideNode>& wideTree() const noexcept;
 
 
+  zisc::pmr::vector<BvhBuildPhase> build_phase_list_;
   zisc::pmr::vector<BvhTreeNode> tree_;
+  zisc::pmr::vector<WideBvhNode<4>> wide4_tree_;
+  zisc::pmr::vector<WideBvhNode<8>> wide8_tree_;
+  zisc::pmr::vector<QuantizedBvhNode> quantized4_tree_;
   zisc::pmr::vector<Object> object_list_;
+  zisc::pmr::vector<uint32> reference_list_; //!< Empty if no object is split
+  TriangleList triangle_list_;
+  OutOfCoreMemoryResource* out_of_core_resource_; //!< Null if the geometry is in memory
+  BvhLayoutType layout_type_;
+  uint32 large_object_index_; //!< The index of the first object out of the tree
+  uint8 extended_morton_code_;
 };
 
 //! \} Core
@@ -0,0 +1,234 @@
+/*!
+  \file bvh_cache.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "bvh_cache.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <sstream>
+#include <string>
+#include <string_view>
+// Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "bvh_tree_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr uint32 BvhCache::magicNumber() noexcept
+{
+  return zisc::Fnv1aHash32::hash("NanairoBvhCache");
+}
+
+/*!
+  \details
+  The version has to be updated when the tree layout or the builders change.
+  */
+inline
+constexpr uint32 BvhCache::version() noexcept
+{
+  return 2;
+}
+
+/*!
+  \details
+  The file is read by bulk reads of the whole tree and the object order,
+  and the loaded data is validated before it's used.
+  */
+bool BvhCache::load(const std::string& file_path,
+                    const uint64 key,
+                    const std::size_t num_of_objects,
+                    zisc::pmr::vector<BvhTreeNode>* tree,
+                    zisc::pmr::vector<uint32>* object_order) noexcept
+{
+  ZISC_ASSERT(tree != nullptr, "The tree is null.");
+  ZISC_ASSERT(object_order != nullptr, "The object order is null.");
+  std::ifstream cache_file{file_path, std::ios::binary};
+  if (!cache_file.is_open())
+    return false;
+
+  // Header
+  uint32 magic = 0,
+         file_version = 0,
+         num_of_cached_objects = 0,
+         num_of_references = 0,
+         num_of_nodes = 0;
+  uint64 cached_key = 0;
+  zisc::read(&magic, &cache_file);
+  zisc::read(&file_version, &cache_file);
+  zisc::read(&cached_key, &cache_file);
+  zisc::read(&num_of_cached_objects, &cache_file);
+  zisc::read(&num_of_references, &cache_file);
+  zisc::read(&num_of_nodes, &cache_file);
+  const bool is_matched = cache_file.good() &&
+                          (magic == magicNumber()) &&
+                          (file_version == version()) &&
+                          (cached_key == key) &&
+                          (num_of_cached_objects == num_of_objects) &&
+                          (num_of_objects <= num_of_references) &&
+                          (0 < num_of_nodes) &&
+                          (num_of_nodes < 2 * num_of_references);
+  if (!is_matched)
+    return false;
+
+  // Data
+  tree->resize(num_of_nodes);
+  object_order->resize(num_of_references);
+  zisc::read(tree->data(), &cache_file, sizeof(BvhTreeNode) * num_of_nodes);
+  zisc::read(object_order->data(), &cache_file,
+             sizeof(uint32) * num_of_references);
+  const bool result = cache_file.good() &&
+                      isValid(num_of_objects, *tree, *object_order);
+  if (!result) {
+    tree->clear();
+    object_order->clear();
+  }
+  return result;
+}
+
+/*!
+  */
+std::string BvhCache::makeFilePath(const std::string_view& directory,
+                                   const uint64 key) noexcept
+{
+  std::ostringstream file_path;
+  file_path << directory << "/" << std::hex << key << ".nanabvh";
+  return file_path.str();
+}
+
+/*!
+  \details
+  The builders see only the bounding boxes and the traversal costs
+  of the objects, so these and the BVH settings determine the tree.
+  */
+uint64 BvhCache::makeKey(const SettingNodeBase* settings,
+                         const zisc::pmr::vector<Object>& object_list) noexcept
+{
+  // The size of the data depends on the build configuration
+  const std::array<uint32, 3> format{{version(),
+                                      zisc::cast<uint32>(sizeof(Float)),
+                                      zisc::cast<uint32>(sizeof(BvhTreeNode))}};
+  uint64 key = hash(format.data(), sizeof(format[0]) * format.size(),
+                    zisc::cast<uint64>(14695981039346656037ull));
+  // BVH settings
+  {
+    std::ostringstream setting_data;
+    castNode<BvhSettingNode>(settings)->writeData(&setting_data);
+    const auto data = setting_data.str();
+    key = hash(data.data(), data.size(), key);
+  }
+  // Objects
+  for (const auto& object : object_list) {
+    const auto& shape = object.shape();
+    const auto bounding_box = shape.boundingBox();
+    const ShapeType shape_type = shape.type();
+    const Float cost = shape.getTraversalCost();
+    key = hash(&shape_type, sizeof(shape_type), key);
+    key = hash(&bounding_box.minPoint(), sizeof(bounding_box.minPoint()), key);
+    key = hash(&bounding_box.maxPoint(), sizeof(bounding_box.maxPoint()), key);
+    key = hash(&cost, sizeof(cost), key);
+  }
+  return key;
+}
+
+/*!
+  */
+bool BvhCache::save(const std::string& file_path,
+                    const uint64 key,
+                    const std::size_t num_of_objects,
+                    const zisc::pmr::vector<BvhTreeNode>& tree,
+                    const zisc::pmr::vector<uint32>& object_order) noexcept
+{
+  std::ofstream cache_file{file_path, std::ios::binary};
+  if (!cache_file.is_open())
+    return false;
+
+  const uint32 magic = magicNumber();
+  const uint32 file_version = version();
+  const uint32 num_of_cached_objects = zisc::cast<uint32>(num_of_objects);
+  const uint32 num_of_references = zisc::cast<uint32>(object_order.size());
+  const uint32 num_of_nodes = zisc::cast<uint32>(tree.size());
+  zisc::write(&magic, &cache_file);
+  zisc::write(&file_version, &cache_file);
+  zisc::write(&key, &cache_file);
+  zisc::write(&num_of_cached_objects, &cache_file);
+  zisc::write(&num_of_references, &cache_file);
+  zisc::write(&num_of_nodes, &cache_file);
+  zisc::write(tree.data(), &cache_file, sizeof(BvhTreeNode) * num_of_nodes);
+  zisc::write(object_order.data(), &cache_file,
+              sizeof(uint32) * num_of_references);
+  return cache_file.good();
+}
+
+/*!
+  */
+uint64 BvhCache::hash(const void* data,
+                      const std::size_t size,
+                      const uint64 seed) noexcept
+{
+  constexpr uint64 prime = 1099511628211ull;
+  const auto bytes = zisc::cast<const uint8*>(data);
+  uint64 h = seed;
+  for (std::size_t i = 0; i < size; ++i)
+    h = (h ^ zisc::cast<uint64>(bytes[i])) * prime;
+  return h;
+}
+
+/*!
+  */
+bool BvhCache::isValid(const std::size_t num_of_objects,
+                       const zisc::pmr::vector<BvhTreeNode>& tree,
+                       const zisc::pmr::vector<uint32>& object_order) noexcept
+{
+  // Every object has to be referenced
+  {
+    zisc::pmr::vector<uint8> is_used{object_order.get_allocator().resource()};
+    is_used.resize(num_of_objects, kFalse);
+    std::size_t num_of_used_objects = 0;
+    for (const uint32 index : object_order) {
+      if (num_of_objects <= index)
+        return false;
+      if (is_used[index] == kFalse) {
+        is_used[index] = kTrue;
+        ++num_of_used_objects;
+      }
+    }
+    if (num_of_used_objects != num_of_objects)
+      return false;
+  }
+  const std::size_t num_of_references = object_order.size();
+  // The indices of the tree have to be in the range
+  for (std::size_t i = 0; i < tree.size(); ++i) {
+    const auto& node = tree[i];
+    const std::size_t failure_next_index = node.failureNextIndex();
+    if ((failure_next_index <= i) || (tree.size() < failure_next_index))
+      return false;
+    if (node.isLeafNode() &&
+        (num_of_references < (node.objectIndex() + node.numOfObjects())))
+      return false;
+  }
+  return true;
+}
+
+} // namespace nanairo
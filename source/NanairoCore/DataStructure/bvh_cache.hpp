@@ -0,0 +1,88 @@
+/*!
+  \file bvh_cache.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_BVH_CACHE_HPP
+#define NANAIRO_BVH_CACHE_HPP
+
+// Standard C++ library
+#include <cstddef>
+#include <string>
+#include <string_view>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "bvh_tree_node.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+class SettingNodeBase;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The on-disk cache of a built BVH
+  \details
+  A cache file holds the sorted tree and the object index of each reference
+  of the leaves in the tree order.
+  The key is the FNV-1a hash of the BVH settings and the inputs of the
+  builders, which are the types, the bounding boxes and
+  the traversal costs of the objects.
+  */
+class BvhCache
+{
+ public:
+  //! Load the tree and the reference order from the cache file
+  static bool load(const std::string& file_path,
+                   const uint64 key,
+                   const std::size_t num_of_objects,
+                   zisc::pmr::vector<BvhTreeNode>* tree,
+                   zisc::pmr::vector<uint32>* object_order) noexcept;
+
+  //! Make the path of the cache file
+  static std::string makeFilePath(const std::string_view& directory,
+                                  const uint64 key) noexcept;
+
+  //! Make the key of the BVH
+  static uint64 makeKey(const SettingNodeBase* settings,
+                        const zisc::pmr::vector<Object>& object_list) noexcept;
+
+  //! Save the tree and the reference order into the cache file
+  static bool save(const std::string& file_path,
+                   const uint64 key,
+                   const std::size_t num_of_objects,
+                   const zisc::pmr::vector<BvhTreeNode>& tree,
+                   const zisc::pmr::vector<uint32>& object_order) noexcept;
+
+ private:
+  //! Return the magic number of the cache file
+  static constexpr uint32 magicNumber() noexcept;
+
+  //! Return the version of the cache file format
+  static constexpr uint32 version() noexcept;
+
+  //! Hash the data by FNV-1a
+  static uint64 hash(const void* data,
+                     const std::size_t size,
+                     const uint64 seed) noexcept;
+
+  //! Check if the loaded tree and object order are consistent
+  static bool isValid(const std::size_t num_of_objects,
+                      const zisc::pmr::vector<BvhTreeNode>& tree,
+                      const zisc::pmr::vector<uint32>& object_order) noexcept;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_BVH_CACHE_HPP
@@ -12,13 +12,11 @@
 
 #include "knn_photon_list.hpp"
 // Standard C++ library
-#include <algorithm>
-#include <tuple>
-#include <utility>
-#include <vector>
+#include <array>
 // Zisc
 #include "zisc/error.hpp"
-#include "zisc/memory_resource.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/photon_cache.hpp"
@@ -30,29 +28,33 @@ namespace nanairo {
   No detailed.
   */
 inline
-KnnPhotonList::KnnPhotonList(zisc::pmr::memory_resource* data_resource) noexcept :
-    photon_list_{data_resource}
+KnnPhotonList::KnnPhotonList() noexcept :
+    k_{capacity()},
+    size_{0},
+    longest_index_{0}
 {
+  distance2_list_.fill(0.0);
+  photon_list_.fill(nullptr);
 }
 
 /*!
   */
 inline
 KnnPhotonList::KnnPhotonList(KnnPhotonList&& other) noexcept :
-    photon_list_{std::move(other.photon_list_)},
-    k_{other.k_}
+    distance2_list_(other.distance2_list_),
+    photon_list_(other.photon_list_),
+    k_{other.k_},
+    size_{other.size_},
+    longest_index_{other.longest_index_}
 {
 }
 
 /*!
-  \details
-  No detailed.
   */
 inline
-auto KnnPhotonList::operator[](const uint index) const noexcept
-    -> const PhotonPoint&
+constexpr uint KnnPhotonList::capacity() noexcept
 {
-  return photon_list_[index];
+  return CoreConfig::maxNumOfKnnPhotons();
 }
 
 /*!
@@ -62,7 +64,17 @@ auto KnnPhotonList::operator[](const uint index) const noexcept
 inline
 void KnnPhotonList::clear() noexcept
 {
-  photon_list_.clear();
+  size_ = 0;
+  longest_index_ = 0;
+}
+
+/*!
+  */
+inline
+Float KnnPhotonList::distance2(const uint index) const noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  return distance2_list_[index];
 }
 
 /*!
@@ -73,21 +85,19 @@ inline
 void KnnPhotonList::insert(const Float distance2,
                            const PhotonCache* photon) noexcept
 {
-  auto compare = [](const PhotonPoint& a, const PhotonPoint& b)
-  {
-    return std::get<0>(a) < std::get<0>(b);
-  };
-
-  if (photon_list_.size() < k()) {
-    photon_list_.emplace_back(distance2, photon);
-    std::push_heap(photon_list_.begin(), photon_list_.end(), compare);
+  if (size_ < k()) {
+    const uint index = size_++;
+    distance2_list_[index] = distance2;
+    photon_list_[index] = photon;
+    if (distance2_list_[longest_index_] < distance2)
+      longest_index_ = index;
   }
-  else if (distance2 < std::get<0>(photon_list_.front())) {
-    std::pop_heap(photon_list_.begin(), photon_list_.end(), compare);
-    photon_list_.back() = std::make_tuple(distance2, photon);
-    std::push_heap(photon_list_.begin(), photon_list_.end(), compare);
+  else if (distance2 < distance2_list_[longest_index_]) {
+    distance2_list_[longest_index_] = distance2;
+    photon_list_[longest_index_] = photon;
+    longest_index_ = findLongest();
   }
-  ZISC_ASSERT(photon_list_.size() <= k(), "The size of knn list is greater than k.");
+  ZISC_ASSERT(size_ <= k(), "The size of knn list is greater than k.");
 }
 
 /*!
@@ -97,7 +107,7 @@ void KnnPhotonList::insert(const Float distance2,
 inline
 Float KnnPhotonList::inverseLongestDistance() const noexcept
 {
-  return zisc::invert(zisc::sqrt(std::get<0>(photon_list_.front())));
+  return zisc::invert(zisc::sqrt(longestDistance2()));
 }
 
 /*!
@@ -110,17 +120,34 @@ uint KnnPhotonList::k() const noexcept
   return k_;
 }
 
+/*!
+  */
+inline
+Float KnnPhotonList::longestDistance2() const noexcept
+{
+  ZISC_ASSERT(0 < size(), "The list is empty.");
+  return distance2_list_[longest_index_];
+}
+
+/*!
+  */
+inline
+const PhotonCache* KnnPhotonList::photon(const uint index) const noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  return photon_list_[index];
+}
+
 /*!
   \details
-  No detailed.
+  The k is clamped to the capacity of the list.
   */
 inline
 void KnnPhotonList::setK(const uint k) noexcept
 {
   ZISC_ASSERT(0 < k, "The k is zero.");
   clear();
-  k_ = k;
-  photon_list_.reserve(k);
+  k_ = zisc::min(k, capacity());
 }
 
 /*!
@@ -130,7 +157,22 @@ void KnnPhotonList::setK(const uint k) noexcept
 inline
 uint KnnPhotonList::size() const noexcept
 {
-  return zisc::cast<uint>(photon_list_.size());
+  return size_;
+}
+
+/*!
+  */
+inline
+uint KnnPhotonList::findLongest() const noexcept
+{
+  uint index = 0;
+  Float longest = distance2_list_[0];
+  for (uint i = 1; i < size_; ++i) {
+    const bool is_longer = longest < distance2_list_[i];
+    longest = is_longer ? distance2_list_[i] : longest;
+    index = is_longer ? i : index;
+  }
+  return index;
 }
 
 } // namespace nanairo
@@ -11,11 +11,8 @@
 #define NANAIRO_KNN_PHOTON_LIST_HPP
 
 // Standard C++ library
-#include <tuple>
-#include <utility>
-#include <vector>
+#include <array>
 // Zisc
-#include "zisc/memory_resource.hpp"
 #include "zisc/non_copyable.hpp"
 // Nanairo
 #include "NanairoCore/Data/photon_cache.hpp"
@@ -28,28 +25,35 @@ namespace nanairo {
 
 /*!
   \details
-  No detailed.
+  The list has the fixed capacity of CoreConfig::maxNumOfKnnPhotons()
+  and is placed in the stack or in the thread data without any allocation.
+  The distances and the photons are held in the separated arrays,
+  and the index of the longest distance is kept instead of a heap.
+  A photon which is nearer than the longest replaces it, and
+  the next longest is found by a branchless loop over the distances
+  which can be vectorized by compilers.
+  The list is aligned to a cache line, so the lists of the threads
+  in the thread data don't share a line.
   */
-class KnnPhotonList : public zisc::NonCopyable<KnnPhotonList>
+class alignas(64) KnnPhotonList : public zisc::NonCopyable<KnnPhotonList>
 {
  public:
-  using PhotonPoint = std::tuple<Float, const PhotonCache*>;
-
-
   //! Create knn photon list
-  KnnPhotonList(zisc::pmr::memory_resource* data_resource) noexcept;
+  KnnPhotonList() noexcept;
 
   //! Move data from other
   KnnPhotonList(KnnPhotonList&& other) noexcept;
 
 
-  //! Return the photon cache and distance by the index
-  const PhotonPoint& operator[](const uint index) const noexcept;
-
+  //! Return the max k of the list
+  static constexpr uint capacity() noexcept;
 
   //! Clear the contents
   void clear() noexcept;
 
+  //! Return the squared distance of the photon by the index
+  Float distance2(const uint index) const noexcept;
+
   //! Insert a photon point if the distance is included in knn
   void insert(const Float distance2, const PhotonCache* photon) noexcept;
 
@@ -59,6 +63,12 @@ class KnnPhotonList : public zisc::NonCopyable<KnnPhotonList>
   //! Return the k value
   uint k() const noexcept;
 
+  //! Return the longest squared distance of contents
+  Float longestDistance2() const noexcept;
+
+  //! Return the photon cache by the index
+  const PhotonCache* photon(const uint index) const noexcept;
+
   //! Set the k value
   void setK(const uint k) noexcept;
 
@@ -66,8 +76,15 @@ class KnnPhotonList : public zisc::NonCopyable<KnnPhotonList>
   uint size() const noexcept;
 
  private:
-  zisc::pmr::vector<PhotonPoint> photon_list_;
+  //! Find the index of the longest distance
+  uint findLongest() const noexcept;
+
+
+  std::array<Float, CoreConfig::maxNumOfKnnPhotons()> distance2_list_;
+  std::array<const PhotonCache*, CoreConfig::maxNumOfKnnPhotons()> photon_list_;
   uint k_;
+  uint size_;
+  uint longest_index_;
 };
 
 //! \}
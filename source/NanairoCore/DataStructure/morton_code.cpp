@@ -10,17 +10,23 @@
 #include "morton_code.hpp"
 // Standard C++ library
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <iterator>
 #include <vector>
 #include <utility>
 // Zisc
+#include "zisc/error.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "aabb.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
 #include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
 
 namespace nanairo {
 
@@ -51,6 +57,44 @@ uint64 MortonCode::calc63bitCode(const Point3& position) noexcept
           expand_bit(position[0]);
 }
 
+/*!
+  \details
+  The size is the ratio of the box diagonal to the scene diagonal.
+  Its log2 is quantized into 6 bits, and each of them follows one of
+  the top 6 xyz triples of a 57bit code, so that the radix tree separates
+  the objects of different sizes near the root.
+  Please see the paper entitled
+  "Extended Morton Codes for High Performance Bounding Volume Hierarchy Construction"
+  for the details.
+  */
+uint64 MortonCode::calcExtended63bitCode(const Point3& position,
+                                         const Float size) noexcept
+{
+  using zisc::cast;
+  constexpr uint num_of_size_bits = 6;
+  constexpr uint num_of_low_bits = 63 - 4 * num_of_size_bits;
+  constexpr Float min_log2_size = -16.0;
+
+  // 19 bits per axis
+  const uint64 spatial_code = calc63bitCode(position) >> num_of_size_bits;
+  const Float log2_size = (0.0 < size) ? std::log2(size) : min_log2_size;
+  const Float s = zisc::clamp(1.0 - log2_size / min_log2_size, 0.0, 1.0);
+  constexpr uint64 size_mask = (cast<uint64>(1) << num_of_size_bits) - 1;
+  const uint64 size_code = zisc::min(cast<uint64>(s * cast<Float>(size_mask + 1)),
+                                     size_mask);
+
+  const uint64 high_code = spatial_code >> num_of_low_bits;
+  uint64 code = 0;
+  for (uint i = num_of_size_bits; 0 < i; --i) {
+    const uint64 triple = (high_code >> (3 * (i - 1))) & 0b111;
+    const uint64 size_bit = (size_code >> (i - 1)) & 0b1;
+    code = (code << 4) | (triple << 1) | size_bit;
+  }
+  constexpr uint64 low_mask = (cast<uint64>(1) << num_of_low_bits) - 1;
+  code = (code << num_of_low_bits) | (spatial_code & low_mask);
+  return code;
+}
+
 /*!
   \details
   No detailed.
@@ -69,37 +113,180 @@ auto MortonCode::findSplit(const uint bit,
 
 /*!
   \details
-  No detailed.
+  The codes are computed by all threads and sorted by sort().
   */
 zisc::pmr::vector<MortonCode> MortonCode::makeList(
-    const zisc::pmr::vector<BvhBuildingNode>& node_list) noexcept
+    System& system,
+    const zisc::pmr::vector<BvhBuildingNode>& node_list,
+    const bool is_extended) noexcept
 {
+  auto& threads = system.threadManager();
+  auto work_resource = node_list.get_allocator().resource();
+  const uint num_of_threads = threads.numOfThreads();
   const uint num_of_objects = zisc::cast<uint>(node_list.size());
 
   // Calc the range of scene
-  const auto scene_box = combineBoundingBoxes(node_list.cbegin(), node_list.cend());
+  Aabb scene_box;
+  {
+    zisc::pmr::vector<Aabb> box_list{work_resource};
+    box_list.resize(num_of_threads);
+    auto calc_box = [&system, &node_list, &box_list, num_of_objects](const uint task_id)
+    {
+      const auto range = system.calcTaskRange(num_of_objects, task_id);
+      if (range[0] < range[1]) {
+        auto begin = node_list.cbegin() + range[0];
+        auto end = node_list.cbegin() + range[1];
+        box_list[task_id] = combineBoundingBoxes(begin, end);
+      }
+    };
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(calc_box, start, num_of_threads, work_resource);
+    result.wait();
+
+    bool is_first = true;
+    for (uint task_id = 0; task_id < num_of_threads; ++task_id) {
+      const auto range = system.calcTaskRange(num_of_objects, task_id);
+      if (range[0] == range[1])
+        continue;
+      scene_box = is_first ? box_list[task_id] : combine(scene_box, box_list[task_id]);
+      is_first = false;
+    }
+  }
   const auto& min_point = scene_box.minPoint();
   const auto range = scene_box.maxPoint() - min_point;
   const Float inverse_x = zisc::invert(range[0]);
   const Float inverse_y = zisc::invert(range[1]);
   const Float inverse_z = zisc::invert(range[2]);
+  const Float scene_diagonal = range.norm();
+  const Float inverse_diagonal = (0.0 < scene_diagonal)
+      ? zisc::invert(scene_diagonal)
+      : 0.0;
 
-  // Sort by the morton code
-  auto work_resource = node_list.get_allocator().resource();
+  // Calc the morton codes
   zisc::pmr::vector<MortonCode> morton_code_list{work_resource};
-  morton_code_list.reserve(num_of_objects);
-  for (auto& node : node_list) {
-    const auto position = node.boundingBox().centroid() - min_point;
-    const Point3 normalized_position{position[0] * inverse_x,
-                                     position[1] * inverse_y,
-                                     position[2] * inverse_z};
-    static_assert(sizeof(CodeType) == 8, "The size of code isn't 64bit.");
-    const auto morton_code = MortonCode::calc63bitCode(normalized_position);
-    morton_code_list.emplace_back(&node, morton_code);
+  morton_code_list.resize(num_of_objects);
+  {
+    auto calc_code = [&system, &node_list, &morton_code_list, &min_point,
+                      inverse_x, inverse_y, inverse_z, inverse_diagonal,
+                      num_of_objects, is_extended]
+    (const uint task_id)
+    {
+      const auto range = system.calcTaskRange(num_of_objects, task_id);
+      for (uint i = range[0]; i < range[1]; ++i) {
+        const auto& node = node_list[i];
+        const auto position = node.boundingBox().centroid() - min_point;
+        const Point3 normalized_position{position[0] * inverse_x,
+                                         position[1] * inverse_y,
+                                         position[2] * inverse_z};
+        static_assert(sizeof(CodeType) == 8, "The size of code isn't 64bit.");
+        const auto& box = node.boundingBox();
+        const auto morton_code = (is_extended)
+            ? MortonCode::calcExtended63bitCode(
+                  normalized_position,
+                  (box.maxPoint() - box.minPoint()).norm() * inverse_diagonal)
+            : MortonCode::calc63bitCode(normalized_position);
+        morton_code_list[i].setNode(&node);
+        morton_code_list[i].setCode(morton_code);
+      }
+    };
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(calc_code, start, num_of_threads, work_resource);
+    result.wait();
   }
-  std::sort(morton_code_list.begin(), morton_code_list.end());
 
   return morton_code_list;
 }
 
+/*!
+  \details
+  Each pass counts the digits of the chunks of the threads,
+  then the threads scatter their chunks to the offsets of the digits.
+  The scatter keeps the order of the codes in a chunk, so the sort is stable.
+  A pass is skipped if all codes have the same digit.
+  */
+void MortonCode::sort(System& system,
+                      zisc::pmr::vector<MortonCode>* code_list) noexcept
+{
+  ZISC_ASSERT(code_list != nullptr, "The code list is null.");
+  const uint32 n = zisc::cast<uint32>(code_list->size());
+  if (n < 2)
+    return;
+
+  constexpr uint digit_bits = 8;
+  constexpr uint num_of_buckets = 1 << digit_bits;
+  constexpr CodeType digit_mask = num_of_buckets - 1;
+  constexpr uint num_of_passes = (8 * sizeof(CodeType)) / digit_bits;
+
+  auto& threads = system.threadManager();
+  auto work_resource = code_list->get_allocator().resource();
+  const uint num_of_threads = threads.numOfThreads();
+
+  zisc::pmr::vector<MortonCode> buffer{work_resource};
+  buffer.resize(n);
+  zisc::pmr::vector<uint32> histogram_list{work_resource};
+  histogram_list.resize(num_of_threads * num_of_buckets);
+
+  MortonCode* src = code_list->data();
+  MortonCode* dst = buffer.data();
+  for (uint pass = 0; pass < num_of_passes; ++pass) {
+    const uint shift = pass * digit_bits;
+    // Count the digits
+    {
+      auto count_digits = [&system, &histogram_list, src, n, shift](const uint task_id)
+      {
+        uint32* histogram = histogram_list.data() + task_id * num_of_buckets;
+        std::fill_n(histogram, num_of_buckets, 0);
+        const auto range = system.calcTaskRange(n, task_id);
+        for (uint32 i = range[0]; i < range[1]; ++i) {
+          const auto digit = (src[i].code() >> shift) & digit_mask;
+          ++histogram[digit];
+        }
+      };
+      constexpr uint start = 0;
+      auto result = threads.enqueueLoop(count_digits, start, num_of_threads,
+                                        work_resource);
+      result.wait();
+    }
+    // Calc the offsets
+    bool has_single_digit = false;
+    {
+      uint32 offset = 0;
+      for (uint digit = 0; digit < num_of_buckets; ++digit) {
+        uint32 count = 0;
+        for (uint task_id = 0; task_id < num_of_threads; ++task_id) {
+          auto& c = histogram_list[task_id * num_of_buckets + digit];
+          const uint32 num = c;
+          c = offset;
+          offset += num;
+          count += num;
+        }
+        has_single_digit = has_single_digit || (count == n);
+      }
+    }
+    if (has_single_digit)
+      continue;
+    // Scatter the codes
+    {
+      auto scatter = [&system, &histogram_list, src, dst, n, shift](const uint task_id)
+      {
+        uint32* offset_list = histogram_list.data() + task_id * num_of_buckets;
+        const auto range = system.calcTaskRange(n, task_id);
+        for (uint32 i = range[0]; i < range[1]; ++i) {
+          const auto digit = (src[i].code() >> shift) & digit_mask;
+          dst[offset_list[digit]++] = std::move(src[i]);
+        }
+      };
+      constexpr uint start = 0;
+      auto result = threads.enqueueLoop(scatter, start, num_of_threads,
+                                        work_resource);
+      result.wait();
+    }
+    std::swap(src, dst);
+  }
+  if (src != code_list->data())
+    code_list->swap(buffer);
+  ZISC_ASSERT(std::is_sorted(code_list->begin(), code_list->end()),
+              "The morton codes aren't sorted.");
+}
+
 } // namespace nanairo
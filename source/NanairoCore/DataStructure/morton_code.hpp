@@ -20,6 +20,9 @@
 
 namespace nanairo {
 
+// Forward declaration
+class System;
+
 //! \addtogroup Core 
 //! \{
 
@@ -50,6 +53,10 @@ class MortonCode
   //! Calculate 63bit morton code
   static uint64 calc63bitCode(const Point3& position) noexcept;
 
+  //! Calculate 63bit morton code which includes the size bits
+  static uint64 calcExtended63bitCode(const Point3& position,
+                                      const Float size) noexcept;
+
   //! Return the morton code
   CodeType code() const noexcept;
 
@@ -63,7 +70,9 @@ class MortonCode
 
   //! Make a morton code list
   static zisc::pmr::vector<MortonCode> makeList(
-      const zisc::pmr::vector<BvhBuildingNode>& node_list) noexcept;
+      System& system,
+      const zisc::pmr::vector<BvhBuildingNode>& node_list,
+      const bool is_extended = false) noexcept;
 
   //! Return the bvh node
   const BvhBuildingNode* node() const noexcept;
@@ -74,6 +83,10 @@ class MortonCode
   //! Set the node
   void setNode(const BvhBuildingNode* node) noexcept;
 
+  //! Sort the morton codes by parallel LSD radix sort
+  static void sort(System& system,
+                   zisc::pmr::vector<MortonCode>* code_list) noexcept;
+
  private:
   const BvhBuildingNode* node_;
   CodeType code_;
@@ -0,0 +1,168 @@
+/*!
+  \file path_guiding_tree-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PATH_GUIDING_TREE_INL_HPP
+#define NANAIRO_PATH_GUIDING_TREE_INL_HPP
+
+#include "path_guiding_tree.hpp"
+// Standard C++ library
+#include <atomic>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr uint PathGuidingTree::directionalResolution() noexcept
+{
+  return 16;
+}
+
+/*!
+  \details
+  The pdf is uniform in a bin since the bins have the same solid angle.
+  */
+inline
+Float PathGuidingTree::evalPdf(const uint leaf, const Vector3& direction) const noexcept
+{
+  ZISC_ASSERT(isTrained(leaf), "The leaf isn't trained.");
+  constexpr Float k = zisc::cast<Float>(numOfBins()) / (4.0 * zisc::kPi<Float>);
+  const uint bin = calcBin(direction);
+  return k * probability_list_[leaf * numOfBins() + bin];
+}
+
+/*!
+  */
+inline
+uint PathGuidingTree::findLeaf(const Point3& point) const noexcept
+{
+  auto lower = bounding_box_.minPoint();
+  auto upper = bounding_box_.maxPoint();
+  const Node* node = &node_list_[0];
+  while (node->child_ != 0) {
+    const uint axis = node->axis_;
+    const Float middle = 0.5 * (lower[axis] + upper[axis]);
+    const bool is_lower = point[axis] < middle;
+    if (is_lower)
+      upper[axis] = middle;
+    else
+      lower[axis] = middle;
+    node = &node_list_[node->child_ + (is_lower ? 0 : 1)];
+  }
+  return zisc::cast<uint>(node->leaf_);
+}
+
+/*!
+  */
+inline
+constexpr uint PathGuidingTree::invalidLeaf() noexcept
+{
+  return std::numeric_limits<uint>::max();
+}
+
+/*!
+  */
+inline
+bool PathGuidingTree::isTrained(const uint leaf) const noexcept
+{
+  return trained_list_[leaf] == kTrue;
+}
+
+/*!
+  \details
+  The memory of a tree is about 10 KB per leaf.
+  */
+inline
+constexpr uint PathGuidingTree::maxNumOfLeaves() noexcept
+{
+  return 4096;
+}
+
+/*!
+  */
+inline
+constexpr uint PathGuidingTree::numOfBins() noexcept
+{
+  return directionalResolution() * directionalResolution();
+}
+
+/*!
+  */
+inline
+uint PathGuidingTree::numOfLeaves() const noexcept
+{
+  return zisc::cast<uint>(trained_list_.size());
+}
+
+/*!
+  \details
+  The value is added with a CAS loop since the camera paths record concurrently.
+  */
+inline
+void PathGuidingTree::record(const uint leaf,
+                             const Vector3& direction,
+                             const Float value) noexcept
+{
+  ZISC_ASSERT(0.0 <= value, "The radiance is negative.");
+  const uint bin = calcBin(direction);
+  auto& radiance = radiance_list_[leaf * numOfBins() + bin];
+  Float current = radiance.load(std::memory_order_relaxed);
+  while (!radiance.compare_exchange_weak(current,
+                                         current + value,
+                                         std::memory_order_relaxed)) {
+  }
+  count_list_[leaf].fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+  \details
+  The phi is measured from the +x axis toward the +z axis as the environment.
+  */
+inline
+uint PathGuidingTree::calcBin(const Vector3& direction) noexcept
+{
+  constexpr uint n = directionalResolution();
+  constexpr Float pi = zisc::kPi<Float>;
+  const Float cos_theta = zisc::clamp(direction[1], -1.0, 1.0);
+  const Float phi = zisc::atan2(direction[2], direction[0]);
+  const Float u = 0.5 * (cos_theta + 1.0);
+  const Float v = (phi + pi) * (0.5 / pi);
+  const uint x = zisc::min(zisc::cast<uint>(u * zisc::cast<Float>(n)), n - 1);
+  const uint y = zisc::min(zisc::cast<uint>(v * zisc::cast<Float>(n)), n - 1);
+  return x + y * n;
+}
+
+/*!
+  */
+inline
+constexpr uint32 PathGuidingTree::minNumOfTrainingSamples() noexcept
+{
+  return numOfBins();
+}
+
+/*!
+  */
+inline
+constexpr uint32 PathGuidingTree::splitThreshold() noexcept
+{
+  return 16 * numOfBins();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_PATH_GUIDING_TREE_INL_HPP
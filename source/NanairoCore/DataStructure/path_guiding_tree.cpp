@@ -0,0 +1,226 @@
+/*!
+  \file path_guiding_tree.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "path_guiding_tree.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <atomic>
+#include <vector>
+// Zisc
+#include "zisc/compensated_summation.hpp"
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The bounding box is extended to a cube,
+  so the cells of the same depth are similar in any direction.
+  */
+PathGuidingTree::PathGuidingTree(const Aabb& bounding_box,
+                                 zisc::pmr::memory_resource* data_resource) noexcept :
+    node_list_{data_resource},
+    table_list_{data_resource},
+    probability_list_{data_resource},
+    trained_list_{data_resource},
+    radiance_list_{data_resource},
+    count_list_{data_resource},
+    collected_radiance_list_{data_resource},
+    collected_count_list_{data_resource}
+{
+  const auto& min_point = bounding_box.minPoint();
+  const auto& max_point = bounding_box.maxPoint();
+  const Float side = zisc::max(max_point[0] - min_point[0],
+                     zisc::max(max_point[1] - min_point[1],
+                               max_point[2] - min_point[2]));
+  auto cube_max_point = min_point;
+  for (uint axis = 0; axis < 3; ++axis)
+    cube_max_point[axis] = min_point[axis] + side;
+  bounding_box_ = Aabb{min_point, cube_max_point};
+
+  node_list_.resize(1);
+  resizeLeaves(1);
+}
+
+/*!
+  \details
+  The recorded data is exchanged with zero,
+  so the samples of the next cycle are recorded from the beginning.
+  */
+void PathGuidingTree::collectTrainingData(PathGuidingTree* source) noexcept
+{
+  ZISC_ASSERT(source != nullptr, "The source tree is null.");
+  const uint num_of_leaves = source->numOfLeaves();
+  collected_radiance_list_.resize(num_of_leaves * numOfBins());
+  for (uint i = 0; i < collected_radiance_list_.size(); ++i) {
+    auto& radiance = source->radiance_list_[i];
+    collected_radiance_list_[i] = radiance.exchange(zisc::cast<Float>(0.0),
+                                                    std::memory_order_relaxed);
+  }
+  collected_count_list_.resize(num_of_leaves);
+  for (uint i = 0; i < num_of_leaves; ++i) {
+    auto& count = source->count_list_[i];
+    collected_count_list_[i] = count.exchange(0, std::memory_order_relaxed);
+  }
+}
+
+/*!
+  \details
+  The nodes of the source are kept in place and a leaf which has more samples
+  than the threshold is split into the two children appended to the list.
+  The distribution of a leaf is made from the collected histogram of
+  its source leaf, the leaf of few samples keeps the source distribution.
+  Only the source nodes and distributions are read,
+  so the source can be sampled by the rendering meanwhile.
+  */
+void PathGuidingTree::fit(const PathGuidingTree& source,
+                          zisc::pmr::memory_resource* work_resource) noexcept
+{
+  ZISC_ASSERT(collected_count_list_.size() == source.numOfLeaves(),
+              "The training data isn't collected.");
+  bounding_box_ = source.bounding_box_;
+  node_list_.clear();
+  node_list_.insert(node_list_.end(),
+                    source.node_list_.begin(),
+                    source.node_list_.end());
+
+  // Split the leaves
+  zisc::pmr::vector<uint32> source_leaf_list{work_resource};
+  source_leaf_list.reserve(maxNumOfLeaves());
+  uint num_of_leaves = source.numOfLeaves();
+  const uint num_of_source_nodes = zisc::cast<uint>(source.node_list_.size());
+  for (uint index = 0; index < num_of_source_nodes; ++index) {
+    if (node_list_[index].child_ != 0)
+      continue;
+    const uint32 leaf = node_list_[index].leaf_;
+    const bool is_split = (splitThreshold() < collected_count_list_[leaf]) &&
+                          (num_of_leaves < maxNumOfLeaves());
+    if (is_split) {
+      // The children are split along the next axis
+      const uint8 axis = zisc::cast<uint8>((node_list_[index].axis_ + 1) % 3);
+      node_list_[index].child_ = zisc::cast<uint32>(node_list_.size());
+      for (uint i = 0; i < 2; ++i) {
+        Node child;
+        child.leaf_ = zisc::cast<uint32>(source_leaf_list.size());
+        child.axis_ = axis;
+        node_list_.emplace_back(child);
+        source_leaf_list.emplace_back(leaf);
+      }
+      ++num_of_leaves;
+    }
+    else {
+      node_list_[index].leaf_ = zisc::cast<uint32>(source_leaf_list.size());
+      source_leaf_list.emplace_back(leaf);
+    }
+  }
+  ZISC_ASSERT(source_leaf_list.size() == num_of_leaves,
+              "The number of the leaves is wrong.");
+
+  // Make the distributions of the leaves
+  resizeLeaves(num_of_leaves);
+  zisc::pmr::vector<Float> weight_list{work_resource};
+  weight_list.resize(numOfBins());
+  for (uint leaf = 0; leaf < num_of_leaves; ++leaf) {
+    const uint32 source_leaf = source_leaf_list[leaf];
+    const uint32 count = collected_count_list_[source_leaf];
+    auto table = table_list_.data() + leaf * numOfBins();
+    auto probabilities = probability_list_.data() + leaf * numOfBins();
+    const auto radiance_list = collected_radiance_list_.data() +
+                               source_leaf * numOfBins();
+    zisc::CompensatedSummation<Float> total{0.0};
+    for (uint bin = 0; bin < numOfBins(); ++bin)
+      total.add(radiance_list[bin]);
+    if ((minNumOfTrainingSamples() <= count) && (0.0 < total.get())) {
+      // A small floor keeps the bins of no sample reachable
+      const Float floor = 0.01 * total.get() / zisc::cast<Float>(numOfBins());
+      for (uint bin = 0; bin < numOfBins(); ++bin)
+        weight_list[bin] = radiance_list[bin] + floor;
+      const Float k = zisc::invert(1.01 * total.get());
+      for (uint bin = 0; bin < numOfBins(); ++bin)
+        probabilities[bin] = k * weight_list[bin];
+      AliasTable::makeEntries(weight_list.data(), numOfBins(), work_resource, table);
+      trained_list_[leaf] = kTrue;
+    }
+    else if (source.isTrained(source_leaf)) {
+      const auto source_table = source.table_list_.data() +
+                                source_leaf * numOfBins();
+      const auto source_probabilities = source.probability_list_.data() +
+                                        source_leaf * numOfBins();
+      std::copy_n(source_table, numOfBins(), table);
+      std::copy_n(source_probabilities, numOfBins(), probabilities);
+      trained_list_[leaf] = kTrue;
+    }
+  }
+}
+
+/*!
+  \details
+  A bin is selected by the alias table and a direction is sampled
+  uniformly in the bin.
+  */
+SampledDirection PathGuidingTree::sample(const uint leaf,
+                                         Sampler& sampler,
+                                         const PathState& path_state) const noexcept
+{
+  ZISC_ASSERT(isTrained(leaf), "The leaf isn't trained.");
+  constexpr uint n = directionalResolution();
+  constexpr Float pi = zisc::kPi<Float>;
+  auto u = sampler.draw2D(path_state);
+  const uint bin = AliasTable::sampleEntries(table_list_.data() + leaf * numOfBins(),
+                                             numOfBins(),
+                                             &u[0]);
+  const uint x = bin % n;
+  const uint y = bin / n;
+  const Float cos_theta = zisc::clamp(
+      2.0 * (zisc::cast<Float>(x) + u[0]) / zisc::cast<Float>(n) - 1.0,
+      -1.0, 1.0);
+  const Float phi = 2.0 * pi * (zisc::cast<Float>(y) + u[1]) /
+                    zisc::cast<Float>(n) - pi;
+  const Float sin_theta = zisc::sqrt(zisc::max(1.0 - cos_theta * cos_theta, 0.0));
+  const Vector3 direction{sin_theta * zisc::cos(phi),
+                          cos_theta,
+                          sin_theta * zisc::sin(phi)};
+
+  constexpr Float k = zisc::cast<Float>(numOfBins()) / (4.0 * pi);
+  const Float pdf = k * probability_list_[leaf * numOfBins() + bin];
+  return SampledDirection{direction, zisc::invert(pdf)};
+}
+
+/*!
+  \details
+  The lists of the atomic values can't be resized, so they are remade.
+  */
+void PathGuidingTree::resizeLeaves(const uint num_of_leaves) noexcept
+{
+  table_list_.resize(num_of_leaves * numOfBins());
+  probability_list_.resize(num_of_leaves * numOfBins());
+  trained_list_.assign(num_of_leaves, kFalse);
+  {
+    decltype(radiance_list_) radiance_list{num_of_leaves * numOfBins(),
+                                           radiance_list_.get_allocator()};
+    radiance_list_.swap(radiance_list);
+  }
+  {
+    decltype(count_list_) count_list{num_of_leaves, count_list_.get_allocator()};
+    count_list_.swap(count_list);
+  }
+}
+
+} // namespace nanairo
@@ -0,0 +1,139 @@
+/*!
+  \file path_guiding_tree.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PATH_GUIDING_TREE_HPP
+#define NANAIRO_PATH_GUIDING_TREE_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class PathState;
+class Sampler;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A spatial-directional tree which learns the incident radiance
+  \details
+  The space is subdivided by a binary tree which halves a cell along
+  the x, y and z axes in turn. Each leaf holds a histogram of the directions
+  in the cylindrical (cos(theta), phi) mapping, so the bins have the same
+  solid angle. The radiance estimates of the paths are recorded into
+  the histograms and the tree is fitted to them, which splits the leaves of
+  many samples and makes the sampling tables of the histograms.
+  Please see "Practical Path Guiding for Efficient Light-Transport Simulation"
+  for the details.
+  */
+class PathGuidingTree : public zisc::NonCopyable<PathGuidingTree>
+{
+ public:
+  //! Create a tree of a single leaf
+  PathGuidingTree(const Aabb& bounding_box,
+                  zisc::pmr::memory_resource* data_resource) noexcept;
+
+
+  //! Take the recorded data of the source tree and clear it
+  void collectTrainingData(PathGuidingTree* source) noexcept;
+
+  //! Return the resolution of a side of the directional histograms
+  static constexpr uint directionalResolution() noexcept;
+
+  //! Evaluate the pdf of the direction in the solid angle measure
+  Float evalPdf(const uint leaf, const Vector3& direction) const noexcept;
+
+  //! Find the leaf which contains the point
+  uint findLeaf(const Point3& point) const noexcept;
+
+  //! Fit this tree to the training data of the source tree
+  void fit(const PathGuidingTree& source,
+           zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Return the index which represents no leaf
+  static constexpr uint invalidLeaf() noexcept;
+
+  //! Check if the leaf has a sampling distribution
+  bool isTrained(const uint leaf) const noexcept;
+
+  //! Return the maximum number of the leaves
+  static constexpr uint maxNumOfLeaves() noexcept;
+
+  //! Return the number of the bins of a directional histogram
+  static constexpr uint numOfBins() noexcept;
+
+  //! Return the number of the leaves
+  uint numOfLeaves() const noexcept;
+
+  //! Record the radiance estimate which arrives from the direction
+  void record(const uint leaf, const Vector3& direction, const Float value) noexcept;
+
+  //! Sample a direction from the distribution of the leaf
+  SampledDirection sample(const uint leaf,
+                          Sampler& sampler,
+                          const PathState& path_state) const noexcept;
+
+ private:
+  /*!
+    \details
+    An inner node has two children which are adjacent,
+    a leaf node has no child.
+    */
+  struct Node
+  {
+    uint32 child_ = 0; //!< The index of the first child, zero for a leaf
+    uint32 leaf_ = 0;
+    uint8 axis_ = 0; //!< The axis of the split
+  };
+
+
+  //! Return the bin of the direction
+  static uint calcBin(const Vector3& direction) noexcept;
+
+  //! Return the minimum number of the samples which make a distribution
+  static constexpr uint32 minNumOfTrainingSamples() noexcept;
+
+  //! Resize the lists of the leaves
+  void resizeLeaves(const uint num_of_leaves) noexcept;
+
+  //! Return the number of the samples which splits a leaf
+  static constexpr uint32 splitThreshold() noexcept;
+
+
+  Aabb bounding_box_;
+  zisc::pmr::vector<Node> node_list_;
+  zisc::pmr::vector<AliasTable::Entry> table_list_;
+  zisc::pmr::vector<Float> probability_list_; //!< The probabilities of the bins
+  zisc::pmr::vector<uint8> trained_list_;
+  zisc::pmr::vector<std::atomic<Float>> radiance_list_;
+  zisc::pmr::vector<std::atomic<uint32>> count_list_;
+  zisc::pmr::vector<Float> collected_radiance_list_;
+  zisc::pmr::vector<uint32> collected_count_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "path_guiding_tree-inl.hpp"
+
+#endif // NANAIRO_PATH_GUIDING_TREE_HPP
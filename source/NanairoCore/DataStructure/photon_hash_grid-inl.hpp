@@ -0,0 +1,165 @@
+/*!
+  \file photon_hash_grid-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PHOTON_HASH_GRID_INL_HPP
+#define NANAIRO_PHOTON_HASH_GRID_INL_HPP
+
+#include "photon_hash_grid.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "aabb_n.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/photon_cache.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+auto PhotonHashGrid::calcCellBox(const CellIndex& index) const noexcept
+    -> Aabb
+{
+  const Float cell_size = zisc::invert(inverse_cell_size_);
+  Point3 min_point;
+  Point3 max_point;
+  for (uint axis = 0; axis < 3; ++axis) {
+    min_point[axis] = zisc::cast<Float>(index[axis]) * cell_size;
+    max_point[axis] = zisc::cast<Float>(index[axis] + 1) * cell_size;
+  }
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  */
+inline
+auto PhotonHashGrid::calcCellIndex(const Point3& point) const noexcept
+    -> CellIndex
+{
+  CellIndex index;
+  for (uint axis = 0; axis < 3; ++axis)
+    index[axis] = zisc::cast<int64>(std::floor(point[axis] * inverse_cell_size_));
+  return index;
+}
+
+/*!
+  \details
+  The cell index is hashed with the large primes of
+  "Optimized Spatial Hashing for Collision Detection of Deformable Objects".
+  */
+inline
+uint32 PhotonHashGrid::calcCellKey(const CellIndex& index) const noexcept
+{
+  const uint32 x = zisc::cast<uint32>(index[0]) * 73856093u;
+  const uint32 y = zisc::cast<uint32>(index[1]) * 19349663u;
+  const uint32 z = zisc::cast<uint32>(index[2]) * 83492791u;
+  return (x ^ y ^ z) & table_mask_;
+}
+
+/*!
+  \details
+  The candidate cells are tested against the search sphere at once,
+  the corner cells which the sphere doesn't reach are skipped.
+  Different cells can have the same key, so each key is visited once.
+  */
+template <typename Function> inline
+void PhotonHashGrid::gather(const Point3& point,
+                            const Vector3& normal,
+                            const Float radius2,
+                            const bool is_frontside_culling,
+                            const bool is_backside_culling,
+                            Function&& function) const noexcept
+{
+  if (num_of_photons_ == 0)
+    return;
+
+  const Float radius = zisc::sqrt(radius2);
+  const Vector3 extent{radius, radius, radius};
+  const auto lower = calcCellIndex(point - extent);
+  const auto upper = calcCellIndex(point + extent);
+
+  // Cull the cells by the sphere
+  std::array<CellIndex, 8> cell_list;
+  uint num_of_cells = 0;
+  Aabb8 cell_box_list;
+  for (int64 z = lower[2]; z <= upper[2]; ++z) {
+    for (int64 y = lower[1]; y <= upper[1]; ++y) {
+      for (int64 x = lower[0]; x <= upper[0]; ++x) {
+        ZISC_ASSERT(num_of_cells < cell_list.size(), "The number of cells is wrong.");
+        const CellIndex index{{x, y, z}};
+        cell_list[num_of_cells] = index;
+        cell_box_list.set(num_of_cells, calcCellBox(index));
+        ++num_of_cells;
+      }
+    }
+  }
+  const uint32 overlap_mask = cell_box_list.testOverlap(point, radius2);
+
+  std::array<uint32, 8> key_list;
+  uint num_of_keys = 0;
+  for (uint cell = 0; cell < num_of_cells; ++cell) {
+    if (((overlap_mask >> cell) & 1u) == 0)
+      continue;
+    const uint32 key = calcCellKey(cell_list[cell]);
+    bool is_visited = false;
+    for (uint i = 0; i < num_of_keys; ++i)
+      is_visited = is_visited || (key_list[i] == key);
+    if (is_visited)
+      continue;
+    key_list[num_of_keys++] = key;
+    testCell(key, point, normal, radius2,
+             is_frontside_culling, is_backside_culling, function);
+  }
+}
+
+/*!
+  \details
+  The distances of a cell are evaluated from the SoA points,
+  the caches are touched only by the photons inside the circle.
+  */
+template <typename Function> inline
+void PhotonHashGrid::testCell(const uint32 key,
+                              const Point3& point,
+                              const Vector3& normal,
+                              const Float radius2,
+                              const bool is_frontside_culling,
+                              const bool is_backside_culling,
+                              Function&& function) const noexcept
+{
+  const Float* x_list = point_list_->data();
+  const Float* y_list = x_list + num_of_photons_;
+  const Float* z_list = y_list + num_of_photons_;
+  const uint32 begin = (*cell_begin_list_)[key];
+  const uint32 end = (*cell_begin_list_)[key + 1];
+  for (uint32 i = begin; i < end; ++i) {
+    const Float dx = x_list[i] - point[0];
+    const Float dy = y_list[i] - point[1];
+    const Float dz = z_list[i] - point[2];
+    const Float distance2 = dx * dx + dy * dy + dz * dz;
+    if (distance2 < radius2) {
+      const auto cache = (*cache_list_)[i];
+      const Float cos_theta = -zisc::dot(normal, cache->incidentDirection());
+      if ((!is_frontside_culling && (0.0 < cos_theta)) ||
+          (!is_backside_culling && (cos_theta < 0.0)))
+        function(distance2, cache);
+    }
+  }
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_PHOTON_HASH_GRID_INL_HPP
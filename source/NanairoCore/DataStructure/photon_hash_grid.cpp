@@ -0,0 +1,191 @@
+/*!
+  \file photon_hash_grid.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "photon_hash_grid.hpp"
+// Standard C++ library
+#include <array>
+#include <atomic>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "aabb_n.hpp"
+#include "knn_photon_list.hpp"
+#include "photon_map_node.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/photon_cache.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+PhotonHashGrid::PhotonHashGrid() noexcept :
+    inverse_cell_size_{0.0},
+    table_mask_{0},
+    num_of_photons_{0}
+{
+}
+
+/*!
+  \details
+  The photons are counted by their cells, the counts are scanned into
+  the beginnings of the cells and the photons are scattered into the cells.
+  Each step runs over the thread pool, so the build is O(n) every pass.
+  */
+void PhotonHashGrid::construct(System& system,
+                               const PhotonMapNode* node_list,
+                               const uint32 num_of_photons,
+                               const Float search_radius) noexcept
+{
+  ZISC_ASSERT(0.0 < search_radius, "The search radius isn't positive.");
+  auto& threads = system.threadManager();
+  auto work_resource = &system.globalMemoryManager();
+  auto map_resource = &system.trackedMemoryResource(MemoryCategory::kPhotonMap);
+  const uint num_of_threads = threads.numOfThreads();
+
+  num_of_photons_ = num_of_photons;
+  inverse_cell_size_ = zisc::invert(2.0 * search_radius);
+  uint32 table_size = 1;
+  while (table_size < num_of_photons)
+    table_size = table_size << 1;
+  table_mask_ = table_size - 1;
+
+  zisc::pmr::vector<uint32> key_list(num_of_photons, work_resource);
+  zisc::pmr::vector<std::atomic<uint32>> count_list(table_size, work_resource);
+  cell_begin_list_ = decltype(cell_begin_list_)::make(
+      map_resource,
+      decltype(cell_begin_list_)::value_type{map_resource});
+  cell_begin_list_->resize(table_size + 1);
+  point_list_ = decltype(point_list_)::make(
+      map_resource,
+      decltype(point_list_)::value_type{map_resource});
+  point_list_->resize(3 * num_of_photons);
+  cache_list_ = decltype(cache_list_)::make(
+      map_resource,
+      decltype(cache_list_)::value_type{map_resource});
+  cache_list_->resize(num_of_photons);
+
+  // Count the photons of the cells
+  {
+    auto count_photons =
+    [this, &system, node_list, num_of_photons, &key_list, &count_list]
+    (const uint task_id)
+    {
+      const auto range = system.calcTaskRange(num_of_photons, task_id);
+      for (uint32 i = range[0]; i < range[1]; ++i) {
+        const uint32 key = calcCellKey(calcCellIndex(node_list[i].point()));
+        key_list[i] = key;
+        count_list[key].fetch_add(1, std::memory_order_relaxed);
+      }
+    };
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(count_photons, start, num_of_threads, work_resource);
+    result.wait();
+  }
+  // Scan the counts
+  {
+    zisc::pmr::vector<uint32> block_list(num_of_threads + 1, work_resource);
+    auto sum_counts = [&system, table_size, &count_list, &block_list]
+    (const uint task_id)
+    {
+      const auto range = system.calcTaskRange(table_size, task_id);
+      uint32 sum = 0;
+      for (uint32 key = range[0]; key < range[1]; ++key)
+        sum += count_list[key].load(std::memory_order_relaxed);
+      block_list[task_id + 1] = sum;
+    };
+    constexpr uint start = 0;
+    auto sum_result = threads.enqueueLoop(sum_counts, start, num_of_threads, work_resource);
+    sum_result.wait();
+
+    block_list[0] = 0;
+    for (uint task_id = 0; task_id < num_of_threads; ++task_id)
+      block_list[task_id + 1] += block_list[task_id];
+
+    auto scan_counts = [this, &system, table_size, &count_list, &block_list]
+    (const uint task_id)
+    {
+      const auto range = system.calcTaskRange(table_size, task_id);
+      uint32 begin = block_list[task_id];
+      for (uint32 key = range[0]; key < range[1]; ++key) {
+        (*cell_begin_list_)[key] = begin;
+        begin += count_list[key].load(std::memory_order_relaxed);
+      }
+    };
+    auto scan_result = threads.enqueueLoop(scan_counts, start, num_of_threads, work_resource);
+    scan_result.wait();
+    (*cell_begin_list_)[table_size] = num_of_photons;
+    ZISC_ASSERT(block_list[num_of_threads] == num_of_photons,
+                "The number of the sorted photons is wrong.");
+  }
+  // Scatter the photons into the cells
+  {
+    auto scatter_photons =
+    [this, &system, node_list, num_of_photons, &key_list, &count_list]
+    (const uint task_id)
+    {
+      const auto range = system.calcTaskRange(num_of_photons, task_id);
+      Float* x_list = point_list_->data();
+      Float* y_list = x_list + num_of_photons;
+      Float* z_list = y_list + num_of_photons;
+      for (uint32 i = range[0]; i < range[1]; ++i) {
+        const uint32 key = key_list[i];
+        const uint32 offset = count_list[key].fetch_sub(1, std::memory_order_relaxed) - 1;
+        const uint32 index = (*cell_begin_list_)[key] + offset;
+        const auto& node = node_list[i];
+        const auto point = node.point();
+        x_list[index] = point[0];
+        y_list[index] = point[1];
+        z_list[index] = point[2];
+        (*cache_list_)[index] = &node.cache();
+      }
+    };
+    constexpr uint start = 0;
+    auto result = threads.enqueueLoop(scatter_photons, start, num_of_threads, work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  */
+void PhotonHashGrid::reset() noexcept
+{
+  cell_begin_list_.reset();
+  point_list_.reset();
+  cache_list_.reset();
+  num_of_photons_ = 0;
+}
+
+/*!
+  */
+void PhotonHashGrid::search(const Point3& point,
+                            const Vector3& normal,
+                            const Float radius2,
+                            const bool is_frontside_culling,
+                            const bool is_backside_culling,
+                            KnnPhotonList* photon_list) const noexcept
+{
+  auto insert = [photon_list](const Float distance2, const PhotonCache* cache)
+  {
+    photon_list->insert(distance2, cache);
+  };
+  gather(point, normal, radius2, is_frontside_culling, is_backside_culling,
+         insert);
+}
+
+} // namespace nanairo
@@ -0,0 +1,116 @@
+/*!
+  \file photon_hash_grid.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PHOTON_HASH_GRID_HPP
+#define NANAIRO_PHOTON_HASH_GRID_HPP
+
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class KnnPhotonList;
+class PhotonCache;
+class PhotonMapNode;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A spatial hash grid of photons
+  \details
+  The cell size is the diameter of the search circle,
+  so a search visits at most 2x2x2 cells.
+  The photons are sorted by their cells with a parallel counting sort
+  and the points of a cell are stored contiguously as SoA.
+  */
+class PhotonHashGrid : public zisc::NonCopyable<PhotonHashGrid>
+{
+ public:
+  //! Create an empty grid
+  PhotonHashGrid() noexcept;
+
+
+  //! Construct the grid of the photons
+  void construct(System& system,
+                 const PhotonMapNode* node_list,
+                 const uint32 num_of_photons,
+                 const Float search_radius) noexcept;
+
+  //! Visit the photons inside the circle on the same face
+  template <typename Function>
+  void gather(const Point3& point,
+              const Vector3& normal,
+              const Float radius2,
+              const bool is_frontside_culling,
+              const bool is_backside_culling,
+              Function&& function) const noexcept;
+
+  //! Reset the grid
+  void reset() noexcept;
+
+  //! Search photons inside the circle on the same face
+  void search(const Point3& point,
+              const Vector3& normal,
+              const Float radius2,
+              const bool is_frontside_culling,
+              const bool is_backside_culling,
+              KnnPhotonList* photon_list) const noexcept;
+
+ private:
+  using CellIndex = std::array<int64, 3>;
+
+
+  //! Return the bounding box of the cell
+  Aabb calcCellBox(const CellIndex& index) const noexcept;
+
+  //! Return the index of the cell which contains the point
+  CellIndex calcCellIndex(const Point3& point) const noexcept;
+
+  //! Return the hash table key of the cell
+  uint32 calcCellKey(const CellIndex& index) const noexcept;
+
+  //! Test the photons of the cell
+  template <typename Function>
+  void testCell(const uint32 key,
+                const Point3& point,
+                const Vector3& normal,
+                const Float radius2,
+                const bool is_frontside_culling,
+                const bool is_backside_culling,
+                Function&& function) const noexcept;
+
+
+  zisc::UniqueMemoryPointer<zisc::pmr::vector<uint32>> cell_begin_list_;
+  zisc::UniqueMemoryPointer<zisc::pmr::vector<Float>> point_list_; //!< x, y, z
+  zisc::UniqueMemoryPointer<zisc::pmr::vector<const PhotonCache*>> cache_list_;
+  Float inverse_cell_size_;
+  uint32 table_mask_;
+  uint32 num_of_photons_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "photon_hash_grid-inl.hpp"
+
+#endif // NANAIRO_PHOTON_HASH_GRID_HPP
@@ -15,18 +15,149 @@
 #include <utility>
 // Zisc
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "photon_map_node.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/photon_cache.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Utility/prefetch.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+template <typename Function> inline
+void PhotonMap::gather(const Point3& point,
+                       const Vector3& normal,
+                       const Float radius2,
+                       const bool is_frontside_culling,
+                       const bool is_backside_culling,
+                       Function&& function) const noexcept
+{
+  if (mapType() == PhotonMapType::kHashGrid) {
+    hash_grid_.gather(point, normal, radius2,
+                      is_frontside_culling, is_backside_culling, function);
+  }
+  else {
+    searchKdTree(point, normal, radius2,
+                 is_frontside_culling, is_backside_culling, function);
+  }
+}
+
 /*!
   */
 inline
-constexpr bool PhotonMap::threadingIsEnabled() noexcept
+PhotonMapType PhotonMap::mapType() const noexcept
+{
+  return map_type_;
+}
+
+/*!
+  \details
+  The descendants of a depth are contiguous in the implicit tree,
+  so they are prefetched by a few cache lines.
+  */
+inline
+void PhotonMap::prefetchDescendants(const uint index) const noexcept
+{
+  constexpr uint depth = CoreConfig::traversalPrefetchDepth();
+  constexpr uint line_size = 64;
+  const uint num_of_nodes = zisc::cast<uint>(num_of_nodes_);
+  if ((num_of_nodes >> depth) < index)
+    return;
+  const uint first = index << depth;
+  const uint last = zisc::min(first + (1u << depth) - 1, num_of_nodes);
+  const auto begin = reinterpret_cast<const uint8*>(&(*tree_)[first - 1]);
+  const auto end = reinterpret_cast<const uint8*>(&(*tree_)[last - 1]) +
+                   sizeof(PhotonMapNode);
+  for (auto address = begin; address < end; address += line_size)
+    prefetch(address);
+}
+
+/*!
+  \details
+  The tree is left-balanced, so the children of a node exist
+  if their numbers aren't greater than the number of the nodes.
+  */
+template <typename Function> inline
+void PhotonMap::searchKdTree(const Point3& point,
+                             const Vector3& normal,
+                             const Float radius2,
+                             const bool is_frontside_culling,
+                             const bool is_backside_culling,
+                             Function&& function) const noexcept
+{
+  const uint num_of_nodes = zisc::cast<uint>(num_of_nodes_);
+  uint index = (0 < num_of_nodes) ? 1 : 0;
+  while (index != 0) {
+    const auto& node = (*tree_)[index - 1];
+    if constexpr (traversalPrefetchIsEnabled())
+      prefetchDescendants(index);
+    testInsideCircle(point, normal, radius2, &node,
+                     is_frontside_culling, is_backside_culling, function);
+    // Internal node
+    if (node.nodeType() != PhotonMapNode::NodeType::kLeaf) {
+      const uint axis = zisc::cast<uint>(node.nodeType());
+      const Float axis_diff = point[axis] - node.point()[axis];
+      const Float axis_diff2 = zisc::power<2>(axis_diff);
+      // Left child node
+      const uint left_child_index = index << 1;
+      if ((left_child_index <= num_of_nodes) &&
+          (axis_diff < 0.0 || axis_diff2 < radius2)) {
+        index = left_child_index;
+        continue;
+      }
+      // Right child node
+      const uint right_child_index = left_child_index + 1;
+      if ((right_child_index <= num_of_nodes) &&
+          (0.0 <= axis_diff || axis_diff2 < radius2)) {
+        index = right_child_index;
+        continue;
+      }
+    }
+    index = nextSearchIndex(point, radius2, index);
+  }
+}
+
+/*!
+  */
+inline
+void PhotonMap::setMapType(const PhotonMapType type) noexcept
+{
+  map_type_ = type;
+}
+
+/*!
+  */
+inline
+constexpr uint32 PhotonMap::subtreeTaskSize() noexcept
+{
+  return 4096;
+}
+
+/*!
+  */
+template <typename Function> inline
+void PhotonMap::testInsideCircle(const Point3& point,
+                                 const Vector3& normal,
+                                 const Float radius2,
+                                 const PhotonMapNode* node,
+                                 const bool is_frontside_culling,
+                                 const bool is_backside_culling,
+                                 Function&& function) const noexcept
 {
-  return true;
+  const Float distance2 = (point - node->point()).squareNorm();
+  if (distance2 < radius2) {
+    const auto& cache = node->cache();
+    const auto& vin = cache.incidentDirection();
+    const Float cos_theta = -zisc::dot(normal, vin);
+    if ((!is_frontside_culling && (0.0 < cos_theta)) ||
+        (!is_backside_culling && (cos_theta < 0.0)))
+      function(distance2, &cache);
+  }
 }
 
 } // namespace nanairo
@@ -10,11 +10,8 @@
 #include "photon_map.hpp"
 // Standard C++ library
 #include <algorithm>
-#include <atomic>
 #include <cstddef>
 #include <iterator>
-#include <mutex>
-#include <thread>
 #include <vector>
 #include <utility>
 // Zisc
@@ -32,15 +29,25 @@
 #include "NanairoCore/Data/photon_cache.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+PhotonMap::ThreadNodeList::ThreadNodeList(
+    zisc::pmr::memory_resource* mem_resource) noexcept :
+        node_list_{mem_resource}
+{
+}
+
 /*!
   \details
   No detailed.
   */
 PhotonMap::PhotonMap() noexcept :
-    num_of_nodes_{0}
+    num_of_nodes_{0},
+    map_type_{PhotonMapType::kKdTree}
 {
 }
 
@@ -48,29 +55,17 @@ PhotonMap::PhotonMap() noexcept :
   \details
   No detailed.
   */
-void PhotonMap::construct(System& system) noexcept
+void PhotonMap::construct(System& system, const Float search_radius) noexcept
 {
-  ZISC_ASSERT(0 < node_list_->size(), "The size of the tree is zero.");
-
-  auto work_resource = &system.globalMemoryManager();
-
-  // Allocate the tree memory
-  const std::size_t node_size = num_of_nodes_.load(std::memory_order_relaxed);
-  {
-    std::size_t memory = 1;
-    while (memory < node_size)
-      memory = memory << 1;
-    tree_ = decltype(tree_)::make(
-        work_resource,
-        decltype(tree_)::value_type{work_resource});
-    tree_->resize(memory, nullptr);
+  mergeThreadNodeLists(system);
+  if (mapType() == PhotonMapType::kHashGrid) {
+    const auto num_of_photons = zisc::cast<uint32>(num_of_nodes_);
+    hash_grid_.construct(system, node_list_->data(), num_of_photons,
+                         search_radius);
+  }
+  else {
+    constructKdTree(system);
   }
-
-  // Construct KD-tree
-  constexpr bool threading = threadingIsEnabled();
-  auto begin = node_list_->begin();
-  auto end = begin + node_size;
-  splitAtMedian<threading>(system, 1, begin, end);
 }
 
 /*!
@@ -78,29 +73,32 @@ void PhotonMap::construct(System& system) noexcept
 void PhotonMap::initialize(System& system,
                            const std::size_t estimated_num_of_nodes) noexcept
 {
-  auto work_resource = &system.globalMemoryManager();
-
-  std::size_t n = num_of_nodes_.exchange(0, std::memory_order_relaxed);
-  n = (n != 0) ? (n << 1) : estimated_num_of_nodes;
+  auto map_resource = &system.trackedMemoryResource(MemoryCategory::kPhotonMap);
+  const uint num_of_threads = system.threadManager().numOfThreads();
 
-  node_body_list_ = decltype(node_body_list_)::make(
-      work_resource,
-      decltype(node_body_list_)::value_type{work_resource});
-  node_body_list_->resize(n);
+  // Reserve the lists by the number of the photons of the last pass
+  std::size_t n = (num_of_nodes_ != 0) ? num_of_nodes_ : estimated_num_of_nodes;
+  n = (n + num_of_threads - 1) / num_of_threads;
+  num_of_nodes_ = 0;
 
-  node_list_ = decltype(node_list_)::make(
-      work_resource,
-      decltype(node_list_)::value_type{work_resource});
-  node_list_->resize(n, nullptr);
+  thread_node_list_ = decltype(thread_node_list_)::make(
+      map_resource,
+      decltype(thread_node_list_)::value_type{map_resource});
+  thread_node_list_->reserve(num_of_threads);
+  for (uint i = 0; i < num_of_threads; ++i) {
+    thread_node_list_->emplace_back(map_resource);
+    thread_node_list_->back().node_list_.reserve(n);
+  }
 }
 
 /*!
   */
 void PhotonMap::reset() noexcept
 {
-  node_body_list_.reset();
+  thread_node_list_.reset();
   node_list_.reset();
   tree_.reset();
+  hash_grid_.reset();
 }
 
 /*!
@@ -114,58 +112,29 @@ void PhotonMap::search(const Point3& point,
                        const bool is_backside_culling,
                        KnnPhotonList* photon_list) const noexcept
 {
-  uint index = 1;
-  while (index != 0) {
-    const auto node = (*tree_)[index - 1];
-    testInsideCircle(point, normal, radius2, node,
-                     is_frontside_culling, is_backside_culling, photon_list);
-    // Internal node
-    if (node->nodeType() != PhotonMapNode::NodeType::kLeaf) {
-      const uint axis = zisc::cast<uint>(node->nodeType());
-      const Float axis_diff = point[axis] - node->point()[axis];
-      const Float axis_diff2 = zisc::power<2>(axis_diff);
-      // Left child node
-      const uint left_child_index = index << 1;
-      const auto left_child_node = (*tree_)[left_child_index - 1];
-      if (left_child_node != nullptr &&
-          (axis_diff < 0.0 || axis_diff2 < radius2)) {
-        index = left_child_index;
-        continue;
-      }
-      // Right child node
-      const uint right_child_index = left_child_index + 1;
-      const auto right_child_node = (*tree_)[right_child_index - 1];
-      if (right_child_node != nullptr &&
-          (0.0 <= axis_diff || axis_diff2 < radius2)) {
-        index = right_child_index;
-        continue;
-      }
-    }
-    index = nextSearchIndex(point, radius2, index);
-  }
+  auto insert = [photon_list](const Float distance2, const PhotonCache* cache)
+  {
+    photon_list->insert(distance2, cache);
+  };
+  gather(point, normal, radius2, is_frontside_culling, is_backside_culling,
+         insert);
 }
 
 /*!
   \details
-  No detailed.
+  Only the thread appends to its list, so no lock is needed.
   */
-void PhotonMap::store(const Point3& point,
+void PhotonMap::store(const uint thread_id,
+                      const Point3& point,
                       const Vector3& vin,
                       const SampledSpectra& photon_energy,
                       const Float inverse_sampling_pdf,
                       const bool wavelength_is_selected) noexcept
 {
-  const std::size_t index = num_of_nodes_++;
-
-  if (node_list_->size() <= index) {
-    std::unique_lock<std::mutex> locker{lock_};
-    if (node_list_->size() <= index) {
-      node_body_list_->resize(2 * node_body_list_->size());
-      node_list_->resize(2 * node_list_->size(), nullptr);
-    }
-  }
-
-  auto& node = (*node_body_list_)[index];
+  ZISC_ASSERT(thread_id < thread_node_list_->size(), "The thread id is out of range.");
+  auto& node_list = (*thread_node_list_)[thread_id].node_list_;
+  node_list.emplace_back();
+  auto& node = node_list.back();
   {
     auto& cache = node.cache();
     cache.setEnergy(photon_energy);
@@ -174,7 +143,87 @@ void PhotonMap::store(const Point3& point,
     cache.setInversePdf(inverse_sampling_pdf);
     cache.setWavelengthIsSelected(wavelength_is_selected);
   }
-  (*node_list_)[index] = &node;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PhotonMap::buildSubtreeInParallel(TaskScheduler& scheduler,
+                                       const uint32 number,
+                                       NodeIterator begin,
+                                       NodeIterator end) noexcept
+{
+  const auto size = std::distance(begin, end);
+  // A small subtree is built at once
+  if (size < zisc::cast<std::ptrdiff_t>(subtreeTaskSize())) {
+    buildSubtree(number, begin, end);
+  }
+  else {
+    const auto median = splitAtMedian(number, begin, end);
+    const uint32 left_number = number << 1;
+    TaskGroup group{scheduler};
+    group.run([this, &scheduler, left_number, begin, median]()
+    {
+      buildSubtreeInParallel(scheduler, left_number, begin, median);
+    });
+    buildSubtreeInParallel(scheduler, left_number + 1, median + 1, end);
+    group.wait();
+  }
+}
+
+/*!
+  */
+void PhotonMap::buildSubtree(const uint32 number,
+                             NodeIterator begin,
+                             NodeIterator end) noexcept
+{
+  if (begin != end) {
+    const auto median = splitAtMedian(number, begin, end);
+    const uint32 left_number = number << 1;
+    buildSubtree(left_number, begin, median);
+    buildSubtree(left_number + 1, median + 1, end);
+  }
+}
+
+/*!
+  \details
+  The levels except the last are full and
+  the last level is filled from the left.
+  */
+uint32 PhotonMap::calcLeftSubtreeSize(const uint32 size) noexcept
+{
+  ZISC_ASSERT(1 < size, "The size is less than 2.");
+  uint32 m = 1; // The number of the nodes of the last level when it's full
+  while ((2 * m) <= size)
+    m = m << 1;
+  const uint32 half = m >> 1;
+  const uint32 last_level_size = size - (m - 1);
+  return (half - 1) + zisc::min(last_level_size, half);
+}
+
+/*!
+  \details
+  The subtrees are forked recursively on the task scheduler
+  until they become small. A waiting thread runs the pending subtrees,
+  so the uneven subtrees are balanced over the threads.
+  */
+void PhotonMap::constructKdTree(System& system) noexcept
+{
+  auto map_resource = &system.trackedMemoryResource(MemoryCategory::kPhotonMap);
+
+  tree_ = decltype(tree_)::make(
+      map_resource,
+      decltype(tree_)::value_type{map_resource});
+  tree_->resize(num_of_nodes_);
+
+  buildSubtreeInParallel(system.taskScheduler(),
+                         1,
+                         node_list_->begin(),
+                         node_list_->end());
+
+  // The nodes are copied into the tree
+  node_list_.reset();
 }
 
 /*!
@@ -184,11 +233,11 @@ void PhotonMap::store(const Point3& point,
 uint PhotonMap::getLongestAxis(NodeIterator begin,
                                NodeIterator end) const noexcept
 {
-  auto min_point = (*begin)->point().data();
+  auto min_point = begin->point().data();
   auto max_point = min_point;
   for (auto iterator = ++begin; iterator != end; ++iterator) {
-    min_point = zisc::minElements(min_point, (*iterator)->point().data());
-    max_point = zisc::maxElements(max_point, (*iterator)->point().data());
+    min_point = zisc::minElements(min_point, iterator->point().data());
+    max_point = zisc::maxElements(max_point, iterator->point().data());
   }
   const auto axis_diff = max_point - min_point;
   return (axis_diff[1] < axis_diff[0])
@@ -200,12 +249,51 @@ uint PhotonMap::getLongestAxis(NodeIterator begin,
           : zisc::cast<uint>(PhotonMapNode::NodeType::kZAxisSplit);
 }
 
+/*!
+  \details
+  The photons are sorted in place by the KD-tree construction,
+  so the tree refers to the photons of the merged list directly.
+  */
+void PhotonMap::mergeThreadNodeLists(System& system) noexcept
+{
+  auto& threads = system.threadManager();
+  auto work_resource = &system.globalMemoryManager();
+  auto map_resource = &system.trackedMemoryResource(MemoryCategory::kPhotonMap);
+  const uint num_of_threads = threads.numOfThreads();
+
+  // Calculate the offsets of the lists
+  zisc::pmr::vector<std::size_t> offset_list(num_of_threads + 1, work_resource);
+  offset_list[0] = 0;
+  for (uint i = 0; i < num_of_threads; ++i)
+    offset_list[i + 1] = offset_list[i] + (*thread_node_list_)[i].node_list_.size();
+  num_of_nodes_ = offset_list[num_of_threads];
+
+  node_list_ = decltype(node_list_)::make(
+      map_resource,
+      decltype(node_list_)::value_type{map_resource});
+  node_list_->resize(num_of_nodes_);
+
+  auto merge_lists = [this, &offset_list](const uint task_id)
+  {
+    auto& node_list = (*thread_node_list_)[task_id].node_list_;
+    std::copy(node_list.begin(), node_list.end(),
+              node_list_->begin() + offset_list[task_id]);
+    node_list.clear();
+    node_list.shrink_to_fit();
+  };
+  constexpr uint start = 0;
+  auto result = threads.enqueueLoop(merge_lists, start, num_of_threads, work_resource);
+  result.wait();
+  thread_node_list_.reset();
+}
+
 /*!
   */
 uint PhotonMap::nextSearchIndex(const Point3& point,
                                 const Float radius2,
                                 uint index) const noexcept
 {
+  const uint num_of_nodes = zisc::cast<uint>(num_of_nodes_);
   // Back to parent node until the current node is left node
   while (index != 0) {
     while ((index & 1) == 1)
@@ -213,12 +301,11 @@ uint PhotonMap::nextSearchIndex(const Point3& point,
     if (index != 0) {
       ++index;
       const uint parent_index = index >> 1;
-      const auto parent_node = (*tree_)[parent_index - 1];
-      const auto axis = zisc::cast<uint>(parent_node->nodeType());
-      const Float axis_diff = point[axis] - parent_node->point()[axis];
+      const auto& parent_node = (*tree_)[parent_index - 1];
+      const auto axis = zisc::cast<uint>(parent_node.nodeType());
+      const Float axis_diff = point[axis] - parent_node.point()[axis];
       const Float axis_diff2 = zisc::power<2>(axis_diff);
-      const auto node = (*tree_)[index - 1];
-      if (node != nullptr && (0.0 <= axis_diff || axis_diff2 < radius2))
+      if ((index <= num_of_nodes) && (0.0 <= axis_diff || axis_diff2 < radius2))
         break;
     }
   }
@@ -227,88 +314,36 @@ uint PhotonMap::nextSearchIndex(const Point3& point,
 
 /*!
   \details
-  No detailed.
+  The median is selected with nth_element instead of sorting the nodes.
+  The left subtree is as large as the one of a left-balanced tree,
+  so the tree is packed into an array without holes.
   */
-template <bool threading>
-void PhotonMap::splitAtMedian(System& system,
-                              const uint number,
+auto PhotonMap::splitAtMedian(const uint32 number,
                               NodeIterator begin,
-                              NodeIterator end) noexcept
+                              NodeIterator end) noexcept -> NodeIterator
 {
   ZISC_ASSERT((number - 1) < tree_->size(), "The index is out of range.");
-  const uint size = zisc::cast<uint>(std::distance(begin, end));
-  if (size == 0) {
-    (*tree_)[number - 1] = nullptr;
-  }
+  const uint32 size = zisc::cast<uint32>(std::distance(begin, end));
+  ZISC_ASSERT(0 < size, "The subtree is empty.");
+  auto median = begin;
   // Leaf node
-  else if (size == 1) {
-    (*begin)->setNodeType(PhotonMapNode::NodeType::kLeaf);
-    (*tree_)[number - 1] = *begin;
+  if (size == 1) {
+    median->setNodeType(PhotonMapNode::NodeType::kLeaf);
   }
   // Internal node
-  else if (1 < size) {
-    // Sort the nodes by the longest axis of the photon area
+  else {
+    // Select the median by the longest axis of the photon area
     const uint axis = getLongestAxis(begin, end);
-    const auto compare = [axis](const PhotonMapNode* a, const PhotonMapNode* b)
-    {
-      return a->point().get(axis) < b->point().get(axis);
-    };
-    std::sort(begin, end, compare);
-    // Set a median node
-    auto median = begin;
-    std::advance(median, size >> 1);
-    (*median)->setNodeType(axis);
-    (*tree_)[number - 1] = *median;
-
-    // Operate the child nodes
-    const uint left_number = number << 1;
-    auto split_left_group = [this, &system, left_number, begin, median]()
+    const auto compare = [axis](const PhotonMapNode& a, const PhotonMapNode& b)
     {
-      splitAtMedian<false>(system, left_number, begin, median);
+      return a.point().get(axis) < b.point().get(axis);
     };
-    auto right_begin = median + 1;
-    const uint right_number = left_number + 1;
-    auto split_right_group = [this, &system, right_number, right_begin, end]()
-    {
-      splitAtMedian<false>(system, right_number, right_begin, end);
-    };
-    // Threading
-    if (threading) {
-      auto& threads = system.threadManager();
-      auto work_resource = &system.globalMemoryManager();
-      auto left_result = threads.enqueue<void>(split_left_group, work_resource);
-      auto right_result = threads.enqueue<void>(split_right_group, work_resource);
-      left_result.wait();
-      right_result.wait();
-    }
-    // Sequence
-    else {
-      split_left_group();
-      split_right_group();
-    }
-  }
-}
-
-/*!
-  */
-inline
-void PhotonMap::testInsideCircle(const Point3& point,
-                                 const Vector3& normal,
-                                 const Float radius2,
-                                 const PhotonMapNode* node,
-                                 const bool is_frontside_culling,
-                                 const bool is_backside_culling,
-                                 KnnPhotonList* photon_list) const noexcept
-{
-  const Float distance2 = (point - node->point()).squareNorm();
-  if (distance2 < radius2) {
-    const auto& cache = node->cache();
-    const auto& vin = cache.incidentDirection();
-    const Float cos_theta = -zisc::dot(normal, vin);
-    if ((!is_frontside_culling && (0.0 < cos_theta)) ||
-        (!is_backside_culling && (cos_theta < 0.0)))
-      photon_list->insert(distance2, &cache);
+    std::advance(median, calcLeftSubtreeSize(size));
+    std::nth_element(begin, median, end, compare);
+    median->setNodeType(axis);
   }
+  (*tree_)[number - 1] = *median;
+  return median;
 }
 
 } // namespace nanairo
@@ -11,16 +11,16 @@
 #define NANAIRO_PHOTON_MAP_HPP
 
 // Standard C++ library
-#include <atomic>
 #include <cstddef>
-#include <mutex>
 #include <vector>
 #include <utility>
 // Zisc
+#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/non_copyable.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "photon_hash_grid.hpp"
 #include "photon_map_node.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/photon_cache.hpp"
@@ -33,13 +33,24 @@ namespace nanairo {
 class KnnPhotonList;
 class SampledSpectra;
 class System;
+class TaskScheduler;
 
 //! \addtogroup Core
 //! \{
 
+//! The spatial structure which is used in photon search
+enum class PhotonMapType : uint32
+{
+  kKdTree                     = zisc::Fnv1aHash32::hash("KdTree"),
+  kHashGrid                   = zisc::Fnv1aHash32::hash("HashGrid")
+};
+
 /*!
   \details
-  No detailed.
+  The photons are searched with a k-d tree or a hash grid
+  which is sized to the search radius of the pass.
+  Each thread appends its photons to its own list without any lock and
+  the lists are merged into a contiguous list before the construction.
   */
 class PhotonMap : public zisc::NonCopyable<PhotonMap>
 {
@@ -49,12 +60,24 @@ class PhotonMap : public zisc::NonCopyable<PhotonMap>
 
 
   //! Construct the photon map
-  void construct(System& system) noexcept;
+  void construct(System& system, const Float search_radius) noexcept;
+
+  //! Visit the photons inside the circle on the same face
+  template <typename Function>
+  void gather(const Point3& point,
+              const Vector3& normal,
+              const Float radius2,
+              const bool is_frontside_culling,
+              const bool is_backside_culling,
+              Function&& function) const noexcept;
 
   //! Initialize node lists
   void initialize(System& system,
                   const std::size_t estimated_num_of_nodes) noexcept;
 
+  //! Return the type of the photon map
+  PhotonMapType mapType() const noexcept;
+
   //! Reset node lists
   void reset() noexcept;
 
@@ -66,50 +89,96 @@ class PhotonMap : public zisc::NonCopyable<PhotonMap>
               const bool is_backside_culling,
               KnnPhotonList* photon_list) const noexcept;
 
-  //! Store a photon cache
-  void store(const Point3& point,
+  //! Set the type of the photon map
+  void setMapType(const PhotonMapType type) noexcept;
+
+  //! Store a photon cache into the list of the thread
+  void store(const uint thread_id,
+             const Point3& point,
              const Vector3& vin,
              const SampledSpectra& photon_energy,
              const Float inverse_sampling_pdf,
              const bool wavelength_is_selected) noexcept;
 
  private:
-  using NodeIterator = typename zisc::pmr::vector<PhotonMapNode*>::iterator;
+  using NodeList = zisc::pmr::vector<PhotonMapNode>;
+  using NodeIterator = typename NodeList::iterator;
+
+  //! The node list of a thread, which doesn't share a cache line with the others
+  struct alignas(64) ThreadNodeList
+  {
+    //! Create an empty list
+    ThreadNodeList(zisc::pmr::memory_resource* mem_resource) noexcept;
 
+    NodeList node_list_;
+  };
+
+
+  //! Build the subtree of the nodes
+  void buildSubtree(const uint32 number,
+                    NodeIterator begin,
+                    NodeIterator end) noexcept;
+
+  //! Build the subtree of the nodes by forking the children as tasks
+  void buildSubtreeInParallel(TaskScheduler& scheduler,
+                              const uint32 number,
+                              NodeIterator begin,
+                              NodeIterator end) noexcept;
+
+  //! Return the size of the left subtree of a left-balanced tree
+  static uint32 calcLeftSubtreeSize(const uint32 size) noexcept;
+
+  //! Construct the KD-tree
+  void constructKdTree(System& system) noexcept;
 
   //! Return the longest axis
   uint getLongestAxis(NodeIterator begin, NodeIterator end) const noexcept;
 
+  //! Merge the node lists of the threads into the node list
+  void mergeThreadNodeLists(System& system) noexcept;
+
   //!
   uint nextSearchIndex(const Point3& point,
                        const Float radius2,
                        uint index) const noexcept;
 
-  //! Split at median
-  template <bool threading>
-  void splitAtMedian(System& system,
-                     const uint number,
-                     NodeIterator begin,
-                     NodeIterator end) noexcept;
+  //! Prefetch the descendants of the node in the prefetch depth
+  void prefetchDescendants(const uint index) const noexcept;
+
+  //! Search photons in the KD-tree
+  template <typename Function>
+  void searchKdTree(const Point3& point,
+                    const Vector3& normal,
+                    const Float radius2,
+                    const bool is_frontside_culling,
+                    const bool is_backside_culling,
+                    Function&& function) const noexcept;
+
+  //! Split the nodes at the median and set the median into the tree
+  NodeIterator splitAtMedian(const uint32 number,
+                             NodeIterator begin,
+                             NodeIterator end) noexcept;
+
+  //! Return the minimum size of a subtree which is split as a task
+  static constexpr uint32 subtreeTaskSize() noexcept;
 
   //! Test if the node is in the circle
+  template <typename Function>
   void testInsideCircle(const Point3& point,
                         const Vector3& normal,
                         const Float radius2,
                         const PhotonMapNode* node,
                         const bool is_frontside_culling,
                         const bool is_backside_culling,
-                        KnnPhotonList* photon_list) const noexcept;
-
-  //! Check if the multithreading is enabled
-  static constexpr bool threadingIsEnabled() noexcept;
+                        Function&& function) const noexcept;
 
 
-  std::mutex lock_;
-  zisc::UniqueMemoryPointer<zisc::pmr::vector<PhotonMapNode*>> node_list_;
-  zisc::UniqueMemoryPointer<zisc::pmr::vector<PhotonMapNode>> node_body_list_;
-  zisc::UniqueMemoryPointer<zisc::pmr::vector<const PhotonMapNode*>> tree_;
-  std::atomic<std::size_t> num_of_nodes_;
+  zisc::UniqueMemoryPointer<zisc::pmr::vector<ThreadNodeList>> thread_node_list_;
+  zisc::UniqueMemoryPointer<NodeList> node_list_;
+  zisc::UniqueMemoryPointer<NodeList> tree_; //!< Left-balanced implicit tree
+  PhotonHashGrid hash_grid_;
+  std::size_t num_of_nodes_;
+  PhotonMapType map_type_;
 };
 
 //! \} Core
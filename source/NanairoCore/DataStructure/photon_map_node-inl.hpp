@@ -79,7 +79,7 @@ auto PhotonMapNode::nodeType() const noexcept -> NodeType
 /*!
   */
 inline
-const Point3& PhotonMapNode::point() const noexcept
+Point3 PhotonMapNode::point() const noexcept
 {
   return cache_.point();
 }
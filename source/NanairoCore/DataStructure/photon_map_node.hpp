@@ -64,7 +64,7 @@ class PhotonMapNode
   NodeType nodeType() const noexcept;
 
   //! Return a point of node
-  const Point3& point() const noexcept;
+  Point3 point() const noexcept;
 
   //! Set a type of the node
   void setNodeType(const NodeType type) noexcept;
@@ -0,0 +1,273 @@
+/*!
+  \file quantized_bvh_node-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_QUANTIZED_BVH_NODE_INL_HPP
+#define NANAIRO_QUANTIZED_BVH_NODE_INL_HPP
+
+#include "quantized_bvh_node.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+QuantizedBvhNode::QuantizedBvhNode() noexcept
+{
+  origin_.fill(0.0f);
+  child_index_.fill(0);
+  for (uint axis = 0; axis < 3; ++axis) {
+    min_point_[axis].fill(0);
+    max_point_[axis].fill(0);
+  }
+  num_of_objects_.fill(emptyChild());
+  exponent_.fill(0);
+}
+
+/*!
+  */
+inline
+Aabb QuantizedBvhNode::childBoundingBox(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  Point3 min_point;
+  Point3 max_point;
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float origin = zisc::cast<Float>(origin_[axis]);
+    const Float scale = zisc::cast<Float>(toScale(exponent_[axis]));
+    min_point[axis] = origin + zisc::cast<Float>(min_point_[axis][child]) * scale;
+    max_point[axis] = origin + zisc::cast<Float>(max_point_[axis][child]) * scale;
+  }
+  return Aabb{min_point, max_point};
+}
+
+/*!
+  */
+inline
+uint32 QuantizedBvhNode::childIndex(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  return child_index_[child];
+}
+
+/*!
+  */
+inline
+bool QuantizedBvhNode::isEmptyChild(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  return num_of_objects_[child] == emptyChild();
+}
+
+/*!
+  */
+inline
+bool QuantizedBvhNode::isLeafChild(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  const uint8 n = num_of_objects_[child];
+  return (n != 0) && (n != emptyChild());
+}
+
+/*!
+  */
+inline
+uint QuantizedBvhNode::numOfObjects(const uint child) const noexcept
+{
+  ZISC_ASSERT(isLeafChild(child), "The child isn't a leaf.");
+  return zisc::cast<uint>(num_of_objects_[child]);
+}
+
+/*!
+  \details
+  The origin is the min point of the node rounded down to float and
+  the step of an axis is the smallest power of two which covers the extent
+  of the node with 255 steps. Each plane is rounded outward and
+  corrected until it contains the child box in the precision of Float.
+  */
+inline
+void QuantizedBvhNode::setChildBoundingBoxes(const Aabb* bounding_box_list,
+                                             const uint num_of_children) noexcept
+{
+  ZISC_ASSERT((0 < num_of_children) && (num_of_children <= width()),
+              "The number of children is out of range.");
+  auto node_box = bounding_box_list[0];
+  for (uint i = 1; i < num_of_children; ++i)
+    node_box = combine(node_box, bounding_box_list[i]);
+
+  constexpr int min_exponent = std::numeric_limits<float>::min_exponent - 1;
+  constexpr int max_exponent = std::numeric_limits<float>::max_exponent - 1;
+  const Float max_q = zisc::cast<Float>(maxQuantizedValue());
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float lower = node_box.minPoint()[axis];
+    const Float upper = node_box.maxPoint()[axis];
+    // Origin
+    float origin = zisc::cast<float>(lower);
+    if (lower < zisc::cast<Float>(origin))
+      origin = std::nextafter(origin, -std::numeric_limits<float>::infinity());
+    const Float o = zisc::cast<Float>(origin);
+    // Scale
+    int exponent = min_exponent;
+    const Float extent = upper - o;
+    if (0.0 < extent) {
+      std::frexp(extent / max_q, &exponent);
+      exponent = zisc::min(zisc::max(exponent, min_exponent), max_exponent);
+    }
+    const Float step = zisc::cast<Float>(toScale(zisc::cast<int8>(exponent)));
+    if (((o + max_q * step) < upper) && (exponent < max_exponent))
+      ++exponent;
+    origin_[axis] = origin;
+    exponent_[axis] = zisc::cast<int8>(exponent);
+    const Float scale = zisc::cast<Float>(toScale(exponent_[axis]));
+    // Quantize the planes of the children
+    for (uint i = 0; i < num_of_children; ++i) {
+      const Float child_lower = bounding_box_list[i].minPoint()[axis];
+      const Float child_upper = bounding_box_list[i].maxPoint()[axis];
+      const Float l = zisc::max(std::floor((child_lower - o) / scale),
+                                zisc::cast<Float>(0.0));
+      const Float u = zisc::min(std::ceil((child_upper - o) / scale), max_q);
+      uint8 q_lower = zisc::cast<uint8>(zisc::min(l, max_q));
+      uint8 q_upper = zisc::cast<uint8>(zisc::max(u, zisc::cast<Float>(0.0)));
+      while ((0 < q_lower) &&
+             (child_lower < (o + zisc::cast<Float>(q_lower) * scale)))
+        --q_lower;
+      while ((q_upper < maxQuantizedValue()) &&
+             ((o + zisc::cast<Float>(q_upper) * scale) < child_upper))
+        ++q_upper;
+      min_point_[axis][i] = q_lower;
+      max_point_[axis][i] = q_upper;
+    }
+  }
+}
+
+/*!
+  */
+inline
+void QuantizedBvhNode::setInternalChild(const uint child,
+                                        const uint32 node_index) noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  child_index_[child] = node_index;
+  num_of_objects_[child] = 0;
+}
+
+/*!
+  */
+inline
+void QuantizedBvhNode::setLeafChild(const uint child,
+                                    const uint32 object_index,
+                                    const uint num_of_objects) noexcept
+{
+  static_assert(CoreConfig::maxNumOfNodeObjects() <
+                std::numeric_limits<uint8>::max(),
+                "The number of node objects doesn't fit in 8 bits.");
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  ZISC_ASSERT(0 < num_of_objects, "The leaf has no object.");
+  child_index_[child] = object_index;
+  num_of_objects_[child] = zisc::cast<uint8>(num_of_objects);
+}
+
+/*!
+  \details
+  The planes are dequantized in registers, so the loops are the same
+  branchless slab test as WideBvhNode and can be vectorized.
+  */
+inline
+uint32 QuantizedBvhNode::testIntersection(
+    const Ray& ray,
+    const Float max_distance,
+    DistanceList* distance_list) const noexcept
+{
+  ZISC_ASSERT(distance_list != nullptr, "The distance list is null.");
+  DistanceList tmin;
+  DistanceList tmax;
+  tmin.fill(0.0);
+  tmax.fill(max_distance);
+  const auto& origin = ray.origin();
+  const auto& inv_dir = ray.inverseDirection();
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float o = zisc::cast<Float>(origin_[axis]) - origin[axis];
+    const Float scale = zisc::cast<Float>(toScale(exponent_[axis]));
+    const Float inv = inv_dir[axis];
+    const auto& min_point = min_point_[axis];
+    const auto& max_point = max_point_[axis];
+    for (uint i = 0; i < kWidth; ++i) {
+      const Float t0 = (o + zisc::cast<Float>(min_point[i]) * scale) * inv;
+      const Float t1 = (o + zisc::cast<Float>(max_point[i]) * scale) * inv;
+      tmin[i] = zisc::max(tmin[i], zisc::min(t0, t1));
+      tmax[i] = zisc::min(tmax[i], zisc::max(t0, t1));
+    }
+  }
+  uint32 hit_mask = 0;
+  for (uint i = 0; i < kWidth; ++i) {
+    const bool is_valid = num_of_objects_[i] != emptyChild();
+    const uint32 is_hit = (is_valid && (tmin[i] <= tmax[i])) ? 1 : 0;
+    hit_mask = hit_mask | (is_hit << i);
+  }
+  *distance_list = tmin;
+  return hit_mask;
+}
+
+/*!
+  */
+inline
+constexpr uint QuantizedBvhNode::width() noexcept
+{
+  return kWidth;
+}
+
+/*!
+  */
+inline
+constexpr uint8 QuantizedBvhNode::emptyChild() noexcept
+{
+  return std::numeric_limits<uint8>::max();
+}
+
+/*!
+  */
+inline
+constexpr uint8 QuantizedBvhNode::maxQuantizedValue() noexcept
+{
+  return std::numeric_limits<uint8>::max();
+}
+
+/*!
+  \details
+  The scale is made from the bits of float directly,
+  so no ldexp call is needed in the traversal.
+  */
+inline
+float QuantizedBvhNode::toScale(const int8 exponent) noexcept
+{
+  constexpr int bias = std::numeric_limits<float>::max_exponent - 1;
+  constexpr int mantissa_bits = std::numeric_limits<float>::digits - 1;
+  const uint32 bits = zisc::cast<uint32>(exponent + bias) << mantissa_bits;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return scale;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_QUANTIZED_BVH_NODE_INL_HPP
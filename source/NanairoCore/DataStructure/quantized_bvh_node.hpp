@@ -0,0 +1,112 @@
+/*!
+  \file quantized_bvh_node.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_QUANTIZED_BVH_NODE_HPP
+#define NANAIRO_QUANTIZED_BVH_NODE_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Ray;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A node of a collapsed BVH which has up to 4 quantized children
+  \details
+  The bounding boxes of the children are quantized into 8 bits per plane
+  relative to the bounding box of the node. The quantized boxes are rounded
+  outward, so they always contain the original boxes.
+  A node fits in a cache line while a WideBvhNode<4> of double
+  takes 224 bytes.
+  */
+class alignas(64) QuantizedBvhNode
+{
+  static constexpr uint kWidth = 4;
+
+ public:
+  using DistanceList = std::array<Float, kWidth>;
+
+
+  //! Create a node which has no child
+  QuantizedBvhNode() noexcept;
+
+
+  //! Return the quantized bounding box of the child
+  Aabb childBoundingBox(const uint child) const noexcept;
+
+  //! Return the node index if the child is internal, otherwise the object index
+  uint32 childIndex(const uint child) const noexcept;
+
+  //! Check if the child slot is empty
+  bool isEmptyChild(const uint child) const noexcept;
+
+  //! Check if the child is a leaf
+  bool isLeafChild(const uint child) const noexcept;
+
+  //! Return the number of objects of the leaf child
+  uint numOfObjects(const uint child) const noexcept;
+
+  //! Quantize the bounding boxes of the children
+  void setChildBoundingBoxes(const Aabb* bounding_box_list,
+                             const uint num_of_children) noexcept;
+
+  //! Set an internal node as the child
+  void setInternalChild(const uint child, const uint32 node_index) noexcept;
+
+  //! Set a leaf as the child
+  void setLeafChild(const uint child,
+                    const uint32 object_index,
+                    const uint num_of_objects) noexcept;
+
+  //! Test ray-children intersection and return the bit mask of the hit children
+  uint32 testIntersection(const Ray& ray,
+                          const Float max_distance,
+                          DistanceList* distance_list) const noexcept;
+
+  //! Return the width of the node
+  static constexpr uint width() noexcept;
+
+ private:
+  //! Return the number of objects which is used for an empty child
+  static constexpr uint8 emptyChild() noexcept;
+
+  //! Return the max quantized value
+  static constexpr uint8 maxQuantizedValue() noexcept;
+
+  //! Return the quantization step of the exponent
+  static float toScale(const int8 exponent) noexcept;
+
+
+  std::array<float, 3> origin_;
+  std::array<uint32, kWidth> child_index_;
+  std::array<std::array<uint8, kWidth>, 3> min_point_;
+  std::array<std::array<uint8, kWidth>, 3> max_point_;
+  std::array<uint8, kWidth> num_of_objects_; //!< 0 means an internal child
+  std::array<int8, 3> exponent_;
+};
+
+static_assert(sizeof(QuantizedBvhNode) == 64,
+              "The size of QuantizedBvhNode isn't a cache line.");
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "quantized_bvh_node-inl.hpp"
+
+#endif // NANAIRO_QUANTIZED_BVH_NODE_HPP
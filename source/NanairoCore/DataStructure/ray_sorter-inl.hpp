@@ -0,0 +1,95 @@
+/*!
+  \file ray_sorter-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RAY_SORTER_INL_HPP
+#define NANAIRO_RAY_SORTER_INL_HPP
+
+#include "ray_sorter.hpp"
+// Standard C++ library
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint32 RaySorter::add(const Ray& ray) noexcept
+{
+  const uint32 slot_index = numOfRays();
+  ray_list_.emplace_back(ray);
+  return slot_index;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void RaySorter::clear() noexcept
+{
+  ray_list_.clear();
+  key_list_.clear();
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+uint32 RaySorter::numOfRays() const noexcept
+{
+  return zisc::cast<uint32>(ray_list_.size());
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+const Ray& RaySorter::ray(const uint32 index) const noexcept
+{
+  return ray_list_[slotIndex(index)];
+}
+
+/*!
+  \details
+  No detailed.
+  */
+inline
+void RaySorter::reserve(const uint32 size) noexcept
+{
+  ray_list_.reserve(size);
+  key_list_.reserve(size);
+}
+
+/*!
+  \details
+  Before sort() is called, the rays are in the order of addition.
+  */
+inline
+uint32 RaySorter::slotIndex(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(index < numOfRays(), "The index is out of range.");
+  return (key_list_.size() == ray_list_.size())
+      ? key_list_[index].second
+      : index;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_RAY_SORTER_INL_HPP
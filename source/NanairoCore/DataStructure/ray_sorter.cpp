@@ -0,0 +1,90 @@
+/*!
+  \file ray_sorter.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "ray_sorter.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "morton_code.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+RaySorter::RaySorter(zisc::pmr::memory_resource* data_resource) noexcept :
+    ray_list_{data_resource},
+    key_list_{data_resource}
+{
+}
+
+/*!
+  \details
+  No detailed.
+  */
+RaySorter::RaySorter(RaySorter&& other) noexcept :
+    ray_list_{std::move(other.ray_list_)},
+    key_list_{std::move(other.key_list_)}
+{
+}
+
+/*!
+  \details
+  The 3 sign bits of the direction are the top bits of the key,
+  so the rays which go the same way are grouped and
+  the near-to-far order of the children is the same in their traversals.
+  The lower 60 bits are the morton code of the origin.
+  */
+auto RaySorter::calcKey(const Aabb& scene_box, const Ray& ray) noexcept
+    -> KeyType
+{
+  const auto range = scene_box.maxPoint() - scene_box.minPoint();
+  const auto& origin = ray.origin();
+  Point3 normalized_origin;
+  for (uint axis = 0; axis < 3; ++axis) {
+    const Float r = range[axis];
+    normalized_origin[axis] = (0.0 < r)
+        ? (origin[axis] - scene_box.minPoint()[axis]) / r
+        : 0.0;
+  }
+  const KeyType morton_code = MortonCode::calc63bitCode(normalized_origin);
+  const KeyType octant = zisc::cast<KeyType>(ray.signBits() & 0b111);
+  return (octant << 60) | (morton_code >> 3);
+}
+
+/*!
+  \details
+  The rays of a thread are a few thousands at most,
+  so they are sorted by a single thread.
+  The rays themselves aren't moved, only the keys.
+  */
+void RaySorter::sort(const Aabb& scene_box) noexcept
+{
+  const uint32 n = numOfRays();
+  key_list_.clear();
+  key_list_.reserve(n);
+  for (uint32 i = 0; i < n; ++i)
+    key_list_.emplace_back(calcKey(scene_box, ray_list_[i]), i);
+  std::sort(key_list_.begin(), key_list_.end());
+}
+
+} // namespace nanairo
@@ -0,0 +1,87 @@
+/*!
+  \file ray_sorter.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_RAY_SORTER_HPP
+#define NANAIRO_RAY_SORTER_HPP
+
+// Standard C++ library
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Reorder the rays of a thread so that similar rays are traversed together
+  \details
+  The rays are sorted by the octant of their directions first
+  and then by the morton code of their origins in the scene box.
+  The caller keeps its per-path data at the slots returned by add()
+  and looks them up by slotIndex() in the sorted order.
+  The sorter is aligned to a cache line, so the sorters of the threads
+  don't share a line.
+  */
+class alignas(64) RaySorter : public zisc::NonCopyable<RaySorter>
+{
+ public:
+  using KeyType = uint64;
+
+
+  //! Create an empty sorter
+  RaySorter(zisc::pmr::memory_resource* data_resource) noexcept;
+
+  //! Move data from other
+  RaySorter(RaySorter&& other) noexcept;
+
+
+  //! Add the ray and return the slot index of the ray
+  uint32 add(const Ray& ray) noexcept;
+
+  //! Clear the rays
+  void clear() noexcept;
+
+  //! Calculate the sort key of the ray
+  static KeyType calcKey(const Aabb& scene_box, const Ray& ray) noexcept;
+
+  //! Return the number of the rays
+  uint32 numOfRays() const noexcept;
+
+  //! Return the i-th ray in the sorted order
+  const Ray& ray(const uint32 index) const noexcept;
+
+  //! Reserve the memory for the rays
+  void reserve(const uint32 size) noexcept;
+
+  //! Return the slot index of the i-th ray in the sorted order
+  uint32 slotIndex(const uint32 index) const noexcept;
+
+  //! Sort the rays
+  void sort(const Aabb& scene_box) noexcept;
+
+ private:
+  zisc::pmr::vector<Ray> ray_list_;
+  zisc::pmr::vector<std::pair<KeyType, uint32>> key_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "ray_sorter-inl.hpp"
+
+#endif // NANAIRO_RAY_SORTER_HPP
@@ -0,0 +1,337 @@
+/*!
+  \file triangle_list-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRIANGLE_LIST_INL_HPP
+#define NANAIRO_TRIANGLE_LIST_INL_HPP
+
+#include "triangle_list.hpp"
+// Standard C++ library
+#include <array>
+#include <utility>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Utility/out_of_core_memory_resource.hpp"
+#include "NanairoCore/Utility/prefetch.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The watertight test permutes the axes so that the largest component of
+  the direction is z, and shears the space so that the ray is the z axis.
+  Please see "Watertight Ray/Triangle Intersection" for the details.
+  */
+inline
+TriangleList::TestRay::TestRay(const Ray& ray) noexcept :
+    ray_{ray}
+{
+  if constexpr (CoreConfig::watertightTriangleTestIsEnabled()) {
+    const auto& d = ray.direction();
+    uint kz = 0;
+    for (uint axis = 1; axis < 3; ++axis)
+      kz = (zisc::abs(d[kz]) < zisc::abs(d[axis])) ? axis : kz;
+    uint kx = (kz + 1) % 3;
+    uint ky = (kx + 1) % 3;
+    // Keep the winding of the triangles
+    if (d[kz] < 0.0)
+      std::swap(kx, ky);
+    axis_ = {{kx, ky, kz}};
+    shear_ = {{d[kx] / d[kz], d[ky] / d[kz], 1.0 / d[kz]}};
+  }
+}
+
+/*!
+  */
+inline
+bool TriangleList::isTriangle(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  return triangle_list_[index] != nullptr;
+}
+
+/*!
+  */
+inline
+bool TriangleList::isTriangle4(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(index + 4 <= size(), "The index is out of range.");
+  return (triangle_list_[index] != nullptr) &&
+         (triangle_list_[index + 1] != nullptr) &&
+         (triangle_list_[index + 2] != nullptr) &&
+         (triangle_list_[index + 3] != nullptr);
+}
+
+/*!
+  \details
+  A line of each coefficient is prefetched, which holds the coefficients of
+  the contiguous triangles of a leaf in most cases.
+  */
+inline
+void TriangleList::prefetch(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  nanairo::prefetch(&triangle_list_[index]);
+  for (uint c = 0; c < numOfCoefficients(); ++c)
+    nanairo::prefetch(coefficients(c, index));
+}
+
+/*!
+  */
+inline
+uint32 TriangleList::size() const noexcept
+{
+  return zisc::cast<uint32>(triangle_list_.size());
+}
+
+/*!
+  */
+inline
+IntersectionTestResult TriangleList::testIntersection(
+    const uint32 index,
+    const TestRay& ray,
+    const Float max_distance,
+    Point2* st) const noexcept
+{
+  ZISC_ASSERT(isTriangle(index), "The object isn't a triangle.");
+  ZISC_ASSERT(st != nullptr, "The st is null.");
+  std::array<Float, 1> distance_list;
+  std::array<Point2, 1> st_list;
+  const uint32 mask = testLanes<1>(index, ray, max_distance,
+                                   &distance_list, &st_list);
+  if (mask == 0)
+    return IntersectionTestResult{};
+  *st = st_list[0];
+  return IntersectionTestResult{distance_list[0]};
+}
+
+/*!
+  \return 4 if no triangle is hit
+  */
+inline
+uint TriangleList::testIntersection4(const uint32 index,
+                                     const TestRay& ray,
+                                     const Float max_distance,
+                                     Float* distance,
+                                     Point2* st) const noexcept
+{
+  ZISC_ASSERT(isTriangle4(index), "The objects aren't triangles.");
+  ZISC_ASSERT(distance != nullptr, "The distance is null.");
+  ZISC_ASSERT(st != nullptr, "The st is null.");
+  std::array<Float, 4> distance_list;
+  std::array<Point2, 4> st_list;
+  const uint32 mask = testLanes<4>(index, ray, max_distance,
+                                   &distance_list, &st_list);
+  uint closest = 4;
+  for (uint lane = 0; lane < 4; ++lane) {
+    const bool is_hit = (mask & (zisc::cast<uint32>(1) << lane)) != 0;
+    if (is_hit && ((closest == 4) || (distance_list[lane] < distance_list[closest])))
+      closest = lane;
+  }
+  if (closest < 4) {
+    *distance = distance_list[closest];
+    *st = st_list[closest];
+  }
+  return closest;
+}
+
+/*!
+  */
+inline
+bool TriangleList::testOcclusion(const uint32 index,
+                                 const TestRay& ray,
+                                 const Float max_distance) const noexcept
+{
+  ZISC_ASSERT(isTriangle(index), "The object isn't a triangle.");
+  std::array<Float, 1> distance_list;
+  std::array<Point2, 1> st_list;
+  const uint32 mask = testLanes<1>(index, ray, max_distance,
+                                   &distance_list, &st_list);
+  return mask != 0;
+}
+
+/*!
+  */
+inline
+uint32 TriangleList::testOcclusion4(const uint32 index,
+                                    const TestRay& ray,
+                                    const Float max_distance) const noexcept
+{
+  ZISC_ASSERT(isTriangle4(index), "The objects aren't triangles.");
+  std::array<Float, 4> distance_list;
+  std::array<Point2, 4> st_list;
+  return testLanes<4>(index, ray, max_distance, &distance_list, &st_list);
+}
+
+/*!
+  \details
+  The same addresses as prefetch() are touched,
+  so the clusters which the test reads are kept resident.
+  */
+inline
+void TriangleList::touch(const uint32 index,
+                         OutOfCoreMemoryResource* resource) const noexcept
+{
+  ZISC_ASSERT(index < size(), "The index is out of range.");
+  resource->touch(&triangle_list_[index]);
+  for (uint c = 0; c < numOfCoefficients(); ++c)
+    resource->touch(coefficients(c, index));
+}
+
+/*!
+  */
+inline
+const FlatTriangle& TriangleList::triangle(const uint32 index) const noexcept
+{
+  ZISC_ASSERT(isTriangle(index), "The object isn't a triangle.");
+  return *triangle_list_[index];
+}
+
+/*!
+  */
+inline
+Float TriangleList::coefficient(const uint c, const uint32 index) const noexcept
+{
+  ZISC_ASSERT(c < numOfCoefficients(), "The coefficient index is out of range.");
+  return matrix_list_[c * triangle_list_.size() + index];
+}
+
+/*!
+  */
+inline
+const Float* TriangleList::coefficients(const uint c,
+                                        const uint32 index) const noexcept
+{
+  ZISC_ASSERT(c < numOfCoefficients(), "The coefficient index is out of range.");
+  return &matrix_list_[c * triangle_list_.size() + index];
+}
+
+/*!
+  */
+inline
+constexpr uint TriangleList::numOfCoefficients() noexcept
+{
+  return 12;
+}
+
+/*!
+  */
+inline
+void TriangleList::setCoefficient(const uint c,
+                                  const uint32 index,
+                                  const Float value) noexcept
+{
+  ZISC_ASSERT(c < numOfCoefficients(), "The coefficient index is out of range.");
+  matrix_list_[c * triangle_list_.size() + index] = value;
+}
+
+/*!
+  \details
+  The lanes are processed in each step without branches,
+  so the compiler can vectorize the loops of four lanes.
+  A division by zero makes an infinite or NaN distance which is rejected
+  by the range test.
+  The canonical test is
+  "Fast Ray-Triangle Intersections by Coordinate Transformation".
+  The watertight test accepts the hits on the edges, so no ray passes
+  between adjacent triangles.
+  */
+template <uint kWidth> inline
+uint32 TriangleList::testLanes(const uint32 index,
+                               const TestRay& ray,
+                               const Float max_distance,
+                               std::array<Float, kWidth>* distance_list,
+                               std::array<Point2, kWidth>* st_list) const noexcept
+{
+  const auto& o = ray.ray_.origin();
+  const auto& d = ray.ray_.direction();
+  std::array<bool, kWidth> is_hit;
+  if constexpr (CoreConfig::watertightTriangleTestIsEnabled()) {
+    const uint kx = ray.axis_[0],
+               ky = ray.axis_[1],
+               kz = ray.axis_[2];
+    const Float sx = ray.shear_[0],
+                sy = ray.shear_[1],
+                sz = ray.shear_[2];
+    // The vertices relative to the origin in the sheared space
+    std::array<std::array<Float, kWidth>, 3> px, py, pz;
+    for (uint v = 0; v < 3; ++v) {
+      const Float* x = coefficients(3 * v + kx, index);
+      const Float* y = coefficients(3 * v + ky, index);
+      const Float* z = coefficients(3 * v + kz, index);
+      for (uint lane = 0; lane < kWidth; ++lane) {
+        const Float az = z[lane] - o[kz];
+        px[v][lane] = (x[lane] - o[kx]) - sx * az;
+        py[v][lane] = (y[lane] - o[ky]) - sy * az;
+        pz[v][lane] = sz * az;
+      }
+    }
+    for (uint lane = 0; lane < kWidth; ++lane) {
+      // The scaled barycentric coordinates
+      const Float u = px[2][lane] * py[1][lane] - py[2][lane] * px[1][lane];
+      const Float v = px[0][lane] * py[2][lane] - py[0][lane] * px[2][lane];
+      const Float w = px[1][lane] * py[0][lane] - py[1][lane] * px[0][lane];
+      const bool is_inside = ((0.0 <= u) && (0.0 <= v) && (0.0 <= w)) ||
+                             ((u <= 0.0) && (v <= 0.0) && (w <= 0.0));
+      const Float determinant = u + v + w;
+      const Float inverse = 1.0 / determinant;
+      const Float t = (u * pz[0][lane] + v * pz[1][lane] + w * pz[2][lane]) *
+                      inverse;
+      (*distance_list)[lane] = t;
+      (*st_list)[lane] = Point2{v * inverse, w * inverse};
+      is_hit[lane] = is_inside && (determinant != 0.0) &&
+                     (0.0 < t) && (t < max_distance);
+    }
+  }
+  else {
+    const Float* c0 = coefficients(0, index);
+    const Float* c1 = coefficients(1, index);
+    const Float* c2 = coefficients(2, index);
+    const Float* c3 = coefficients(3, index);
+    const Float* c4 = coefficients(4, index);
+    const Float* c5 = coefficients(5, index);
+    const Float* c6 = coefficients(6, index);
+    const Float* c7 = coefficients(7, index);
+    const Float* c8 = coefficients(8, index);
+    const Float* c9 = coefficients(9, index);
+    const Float* c10 = coefficients(10, index);
+    const Float* c11 = coefficients(11, index);
+    for (uint lane = 0; lane < kWidth; ++lane) {
+      const Float dz = c0[lane] * d[0] + c1[lane] * d[1] + c2[lane] * d[2];
+      const Float oz = c0[lane] * o[0] + c1[lane] * o[1] + c2[lane] * o[2] +
+                       c3[lane];
+      const Float t = -oz / dz;
+      const Float x = o[0] + t * d[0],
+                  y = o[1] + t * d[1],
+                  z = o[2] + t * d[2];
+      const Float s1 = c4[lane] * x + c5[lane] * y + c6[lane] * z + c7[lane];
+      const Float s2 = c8[lane] * x + c9[lane] * y + c10[lane] * z + c11[lane];
+      const Float u = 1.0 - (s1 + s2);
+      (*distance_list)[lane] = t;
+      (*st_list)[lane] = Point2{s1, s2};
+      is_hit[lane] = (0.0 < t) && (t < max_distance) &&
+                     (0.0 < s1) && (0.0 < s2) && (0.0 < u);
+    }
+  }
+  uint32 mask = 0;
+  for (uint lane = 0; lane < kWidth; ++lane)
+    mask |= (is_hit[lane]) ? (zisc::cast<uint32>(1) << lane) : 0;
+  return mask;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TRIANGLE_LIST_INL_HPP
@@ -0,0 +1,82 @@
+/*!
+  \file triangle_list.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "triangle_list.hpp"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+TriangleList::TriangleList(zisc::pmr::memory_resource* data_resource) noexcept :
+    matrix_list_{data_resource},
+    triangle_list_{data_resource}
+{
+}
+
+/*!
+  */
+void TriangleList::clear() noexcept
+{
+  matrix_list_.clear();
+  triangle_list_.clear();
+}
+
+/*!
+  \details
+  Meshes are made of flat triangles. The other shapes are tested through
+  their objects.
+  The watertight test restores the vertices from the first vertex and
+  the edges of a triangle.
+  */
+void TriangleList::setObjects(const zisc::pmr::vector<Object>& object_list) noexcept
+{
+  clear();
+  triangle_list_.resize(object_list.size(), nullptr);
+  matrix_list_.resize(numOfCoefficients() * object_list.size(), 0.0);
+  for (uint32 index = 0; index < size(); ++index) {
+    const auto& shape = object_list[index].shape();
+    if (shape.type() != ShapeType::kMesh)
+      continue;
+    const auto triangle = zisc::cast<const FlatTriangle*>(&shape);
+    triangle_list_[index] = triangle;
+    if constexpr (CoreConfig::watertightTriangleTestIsEnabled()) {
+      const auto& v0 = triangle->vertex0();
+      const auto& edge = triangle->edge();
+      const Point3 v1 = v0 + edge[0];
+      const Point3 v2 = v0 + edge[1];
+      for (uint i = 0; i < 3; ++i) {
+        setCoefficient(i, index, v0[i]);
+        setCoefficient(i + 3, index, v1[i]);
+        setCoefficient(i + 6, index, v2[i]);
+      }
+      continue;
+    }
+    const auto& matrix = triangle->toCanonicalMatrix();
+    for (uint i = 0; i < 3; ++i) {
+      setCoefficient(i, index, matrix.row1_xyz_[i]);
+      setCoefficient(i + 4, index, matrix.row2_xyz_[i]);
+      setCoefficient(i + 8, index, matrix.row3_xyz_[i]);
+    }
+    setCoefficient(3, index, matrix.row1_w_);
+    setCoefficient(7, index, matrix.row2_w_);
+    setCoefficient(11, index, matrix.row3_w_);
+  }
+}
+
+} // namespace nanairo
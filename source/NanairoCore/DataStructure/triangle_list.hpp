@@ -0,0 +1,145 @@
+/*!
+  \file triangle_list.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRIANGLE_LIST_HPP
+#define NANAIRO_TRIANGLE_LIST_HPP
+
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class FlatTriangle;
+class Object;
+class OutOfCoreMemoryResource;
+class Ray;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Contiguous intersection data of the flat triangles in a BVH
+  \details
+  The canonical matrices of the triangles are stored as SoA in the order of
+  the BVH object list, so leaves test their triangles by index without
+  dereferencing the objects or calling virtual functions.
+  The triangle itself is referred only when a hit is found.
+  If the watertight test is enabled, the vertices are stored instead of
+  the canonical matrices. The contiguous triangles of a leaf can be tested
+  four at once by the same kernel as a single triangle.
+  */
+class TriangleList
+{
+ public:
+  /*!
+    \brief The ray and its precomputed data which are shared by the tests
+    */
+  struct TestRay
+  {
+    //! Precompute the data of the ray
+    TestRay(const Ray& ray) noexcept;
+
+    const Ray& ray_;
+    std::array<Float, 3> shear_; //!< The shear of the watertight test
+    std::array<uint, 3> axis_; //!< The permutation of the watertight test
+  };
+
+
+  //! Create an empty list
+  TriangleList(zisc::pmr::memory_resource* data_resource) noexcept;
+
+
+  //! Clear the list
+  void clear() noexcept;
+
+  //! Check if the object of the index is a flat triangle
+  bool isTriangle(const uint32 index) const noexcept;
+
+  //! Check if the four objects from the index are flat triangles
+  bool isTriangle4(const uint32 index) const noexcept;
+
+  //! Prefetch the intersection data of the triangles from the index
+  void prefetch(const uint32 index) const noexcept;
+
+  //! Initialize the list with the objects
+  void setObjects(const zisc::pmr::vector<Object>& object_list) noexcept;
+
+  //! Return the number of objects
+  uint32 size() const noexcept;
+
+  //! Test ray-triangle intersection
+  IntersectionTestResult testIntersection(const uint32 index,
+                                          const TestRay& ray,
+                                          const Float max_distance,
+                                          Point2* st) const noexcept;
+
+  //! Test the four triangles from the index and return the lane of the closest
+  uint testIntersection4(const uint32 index,
+                         const TestRay& ray,
+                         const Float max_distance,
+                         Float* distance,
+                         Point2* st) const noexcept;
+
+  //! Test if the ray is occluded by the triangle
+  bool testOcclusion(const uint32 index,
+                     const TestRay& ray,
+                     const Float max_distance) const noexcept;
+
+  //! Return the mask of the four triangles from the index which occlude the ray
+  uint32 testOcclusion4(const uint32 index,
+                        const TestRay& ray,
+                        const Float max_distance) const noexcept;
+
+  //! Record the access of the intersection data of the triangles from the index
+  void touch(const uint32 index, OutOfCoreMemoryResource* resource) const noexcept;
+
+  //! Return the triangle of the index
+  const FlatTriangle& triangle(const uint32 index) const noexcept;
+
+ private:
+  //! Return the coefficient of the canonical matrix
+  Float coefficient(const uint c, const uint32 index) const noexcept;
+
+  //! Return the coefficients of the contiguous triangles from the index
+  const Float* coefficients(const uint c, const uint32 index) const noexcept;
+
+  //! Return the number of coefficients of a canonical matrix
+  static constexpr uint numOfCoefficients() noexcept;
+
+  //! Set the coefficient of the canonical matrix
+  void setCoefficient(const uint c, const uint32 index, const Float value) noexcept;
+
+  //! Test the contiguous triangles of the lanes and return the mask of the hits
+  template <uint kWidth>
+  uint32 testLanes(const uint32 index,
+                   const TestRay& ray,
+                   const Float max_distance,
+                   std::array<Float, kWidth>* distance_list,
+                   std::array<Point2, kWidth>* st_list) const noexcept;
+
+
+  zisc::pmr::vector<Float> matrix_list_; //!< coefficient major, or the vertices
+  zisc::pmr::vector<const FlatTriangle*> triangle_list_; //!< null if the object isn't a triangle
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "triangle_list-inl.hpp"
+
+#endif // NANAIRO_TRIANGLE_LIST_HPP
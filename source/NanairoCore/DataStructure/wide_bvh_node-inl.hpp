@@ -0,0 +1,163 @@
+/*!
+  \file wide_bvh_node-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WIDE_BVH_NODE_INL_HPP
+#define NANAIRO_WIDE_BVH_NODE_INL_HPP
+
+#include "wide_bvh_node.hpp"
+// Standard C++ library
+#include <array>
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "aabb.hpp"
+#include "aabb_n.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <uint kWidth> inline
+WideBvhNode<kWidth>::WideBvhNode() noexcept
+{
+  child_index_.fill(0);
+  num_of_objects_.fill(emptyChild());
+}
+
+/*!
+  */
+template <uint kWidth> inline
+Aabb WideBvhNode<kWidth>::childBoundingBox(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  return bounding_box_list_.get(child);
+}
+
+/*!
+  */
+template <uint kWidth> inline
+uint32 WideBvhNode<kWidth>::childIndex(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  return child_index_[child];
+}
+
+/*!
+  */
+template <uint kWidth> inline
+bool WideBvhNode<kWidth>::isEmptyChild(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  return num_of_objects_[child] == emptyChild();
+}
+
+/*!
+  */
+template <uint kWidth> inline
+bool WideBvhNode<kWidth>::isLeafChild(const uint child) const noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  const uint32 n = num_of_objects_[child];
+  return (n != 0) && (n != emptyChild());
+}
+
+/*!
+  */
+template <uint kWidth> inline
+uint WideBvhNode<kWidth>::numOfObjects(const uint child) const noexcept
+{
+  ZISC_ASSERT(isLeafChild(child), "The child isn't a leaf.");
+  return zisc::cast<uint>(num_of_objects_[child]);
+}
+
+/*!
+  */
+template <uint kWidth> inline
+void WideBvhNode<kWidth>::setChildBoundingBox(const uint child,
+                                              const Aabb& bounding_box) noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  bounding_box_list_.set(child, bounding_box);
+}
+
+/*!
+  */
+template <uint kWidth> inline
+void WideBvhNode<kWidth>::setChildBoundingBoxes(
+    const Aabb* bounding_box_list,
+    const uint num_of_children) noexcept
+{
+  ZISC_ASSERT(num_of_children <= width(), "The number of children is out of range.");
+  for (uint child = 0; child < num_of_children; ++child)
+    setChildBoundingBox(child, bounding_box_list[child]);
+}
+
+/*!
+  */
+template <uint kWidth> inline
+void WideBvhNode<kWidth>::setInternalChild(const uint child,
+                                           const uint32 node_index) noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  child_index_[child] = node_index;
+  num_of_objects_[child] = 0;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+void WideBvhNode<kWidth>::setLeafChild(const uint child,
+                                       const uint32 object_index,
+                                       const uint num_of_objects) noexcept
+{
+  ZISC_ASSERT(child < width(), "The child index is out of range.");
+  ZISC_ASSERT(0 < num_of_objects, "The leaf has no object.");
+  child_index_[child] = object_index;
+  num_of_objects_[child] = zisc::cast<uint32>(num_of_objects);
+}
+
+/*!
+  \details
+  Only the children which have bounding boxes can be hit.
+  */
+template <uint kWidth> inline
+uint32 WideBvhNode<kWidth>::testIntersection(
+    const Ray& ray,
+    const Float max_distance,
+    DistanceList* distance_list) const noexcept
+{
+  return bounding_box_list_.testIntersection(ray, max_distance, distance_list);
+}
+
+/*!
+  */
+template <uint kWidth> inline
+constexpr uint WideBvhNode<kWidth>::width() noexcept
+{
+  return kWidth;
+}
+
+/*!
+  */
+template <uint kWidth> inline
+constexpr uint32 WideBvhNode<kWidth>::emptyChild() noexcept
+{
+  return std::numeric_limits<uint32>::max();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_WIDE_BVH_NODE_INL_HPP
@@ -0,0 +1,105 @@
+/*!
+  \file wide_bvh_node.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WIDE_BVH_NODE_HPP
+#define NANAIRO_WIDE_BVH_NODE_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "aabb.hpp"
+#include "aabb_n.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Ray;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A node of a collapsed BVH which has up to kWidth children
+  \details
+  The bounding boxes of the children are stored in an AabbN,
+  so a ray is tested against all children at once by its batched slab test.
+  The boxes are stored in single precision regardless of the Float type,
+  a float box is half the memory of a double box,
+  and a SIMD register holds twice as many children.
+  */
+template <uint kWidth>
+class WideBvhNode
+{
+  static_assert((kWidth == 4) || (kWidth == 8), "The width isn't 4 or 8.");
+
+ public:
+  using DistanceList = typename AabbN<kWidth>::DistanceList;
+
+
+  //! Create a node which has no child
+  WideBvhNode() noexcept;
+
+
+  //! Return the bounding box of the child
+  Aabb childBoundingBox(const uint child) const noexcept;
+
+  //! Return the node index if the child is internal, otherwise the object index
+  uint32 childIndex(const uint child) const noexcept;
+
+  //! Check if the child slot is empty
+  bool isEmptyChild(const uint child) const noexcept;
+
+  //! Check if the child is a leaf
+  bool isLeafChild(const uint child) const noexcept;
+
+  //! Return the number of objects of the leaf child
+  uint numOfObjects(const uint child) const noexcept;
+
+  //! Set the bounding box of the child
+  void setChildBoundingBox(const uint child, const Aabb& bounding_box) noexcept;
+
+  //! Set the bounding boxes of the children
+  void setChildBoundingBoxes(const Aabb* bounding_box_list,
+                             const uint num_of_children) noexcept;
+
+  //! Set an internal node as the child
+  void setInternalChild(const uint child, const uint32 node_index) noexcept;
+
+  //! Set a leaf as the child
+  void setLeafChild(const uint child,
+                    const uint32 object_index,
+                    const uint num_of_objects) noexcept;
+
+  //! Test ray-children intersection and return the bit mask of the hit children
+  uint32 testIntersection(const Ray& ray,
+                          const Float max_distance,
+                          DistanceList* distance_list) const noexcept;
+
+  //! Return the width of the node
+  static constexpr uint width() noexcept;
+
+ private:
+  //! Return the number of objects which is used for an empty child
+  static constexpr uint32 emptyChild() noexcept;
+
+
+  AabbN<kWidth> bounding_box_list_;
+  std::array<uint32, kWidth> child_index_;
+  std::array<uint32, kWidth> num_of_objects_; //!< 0 means an internal child
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "wide_bvh_node-inl.hpp"
+
+#endif // NANAIRO_WIDE_BVH_NODE_HPP
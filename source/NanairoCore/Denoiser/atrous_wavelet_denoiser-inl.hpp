@@ -0,0 +1,68 @@
+/*!
+  \file atrous_wavelet_denoiser-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_ATROUS_WAVELET_DENOISER_INL_HPP
+#define NANAIRO_ATROUS_WAVELET_DENOISER_INL_HPP
+
+#include "atrous_wavelet_denoiser.hpp"
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+uint AtrousWaveletDenoiser::numOfIterations() const noexcept
+{
+  return num_of_iterations_;
+}
+
+/*!
+  */
+inline
+bool AtrousWaveletDenoiser::Buffer::hasFeatures() const noexcept
+{
+  return !normal_table_.empty();
+}
+
+/*!
+  */
+inline
+constexpr float AtrousWaveletDenoiser::albedoSigma() noexcept
+{
+  return 0.1f;
+}
+
+/*!
+  */
+inline
+constexpr std::array<float, 5> AtrousWaveletDenoiser::getKernel() noexcept
+{
+  const std::array<float, 5> kernel{{1.0f / 16.0f,
+                                     1.0f / 4.0f,
+                                     3.0f / 8.0f,
+                                     1.0f / 4.0f,
+                                     1.0f / 16.0f}};
+  return kernel;
+}
+
+/*!
+  */
+inline
+constexpr uint AtrousWaveletDenoiser::normalPower() noexcept
+{
+  return 64;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_ATROUS_WAVELET_DENOISER_INL_HPP
@@ -0,0 +1,328 @@
+/*!
+  \file atrous_wavelet_denoiser.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "atrous_wavelet_denoiser.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <utility>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "denoiser.hpp"
+#include "denoising_context.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+AtrousWaveletDenoiser::AtrousWaveletDenoiser(
+    System& /* system */,
+    const SettingNodeBase* settings) noexcept :
+        Denoiser(settings)
+{
+  initialize(settings);
+}
+
+/*!
+  \details
+  The buffers are swapped at each iteration,
+  so the work memory is two buffers of the image.
+  */
+void AtrousWaveletDenoiser::denoise(
+    DenoisingContext& context,
+    const uint32 cycle,
+    SampleStatistics* statistics) const noexcept
+{
+  const auto& progress_callback = progressCallback();
+  if (progress_callback)
+    progress_callback(0.0);
+
+  auto* work_resource = &context.workResource();
+  const uint num_of_bins = statistics->denoisedSampleTable().numOfBins();
+  Buffer buffer1{work_resource},
+         buffer2{work_resource};
+  initBuffer(context, cycle, *statistics, &buffer1);
+  buffer2.color_table_.resize(buffer1.color_table_.size());
+  buffer2.variance_table_.resize(buffer1.variance_table_.size());
+  // The features aren't changed by the filter
+  buffer2.normal_table_ = buffer1.normal_table_;
+  buffer2.albedo_table_ = buffer1.albedo_table_;
+
+  Buffer* src = &buffer1;
+  Buffer* dst = &buffer2;
+  for (uint iteration = 0; iteration < numOfIterations(); ++iteration) {
+    const uint step = 0b1u << iteration;
+    filter(context, num_of_bins, step, *src, dst);
+    std::swap(src, dst);
+    if (progress_callback) {
+      const double progress = zisc::cast<double>(iteration + 1) /
+                              zisc::cast<double>(numOfIterations() + 1);
+      progress_callback(progress);
+    }
+  }
+  writeBuffer(context, *src, statistics);
+
+  if (progress_callback)
+    progress_callback(1.0);
+}
+
+/*!
+  */
+AtrousWaveletDenoiser::Buffer::Buffer(zisc::pmr::memory_resource* resource)
+    noexcept :
+        color_table_{resource},
+        variance_table_{resource},
+        normal_table_{resource},
+        albedo_table_{resource}
+{
+}
+
+/*!
+  \details
+  The weight of a tap is the kernel weight times
+  exp(-|c_p - c_q|^2 / (sigma^2 * (var_p + var_q))).
+  The variance is filtered by the squared weights,
+  since the taps are assumed to be independent.
+  The taps out of the image are skipped.
+  With the first hit features, the weight is multiplied by
+  max(0, n_p . n_q)^power * exp(-|a_p - a_q|^2 / sigma_a^2),
+  and the background and the surfaces don't mix.
+  */
+void AtrousWaveletDenoiser::filter(
+    DenoisingContext& context,
+    const uint num_of_bins,
+    const uint step,
+    const Buffer& src,
+    Buffer* dst) const noexcept
+{
+  using zisc::cast;
+
+  ZISC_ASSERT(num_of_bins <= CoreConfig::spectraSize(),
+              "The number of bins exceeds the spectra size.");
+  const auto& resolution = context.imageResolution();
+  const int width = cast<int>(resolution[0]);
+  const int height = cast<int>(resolution[1]);
+  const float inv_bins = zisc::invert(cast<float>(num_of_bins));
+  const float k = zisc::power<2>(color_sigma_);
+
+  auto filter_rows = [&context, &src, dst, num_of_bins, step, width, height,
+                      inv_bins, k](const uint task_id)
+  {
+    constexpr auto kernel = getKernel();
+    constexpr float min_variance = 1.0e-10f;
+    const auto range = context.calcTaskRange(cast<uint>(height), task_id);
+    for (int y = cast<int>(range[0]); y < cast<int>(range[1]); ++y) {
+      for (int x = 0; x < width; ++x) {
+        const std::size_t p = cast<std::size_t>(x + width * y);
+        const float* c_p = &src.color_table_[num_of_bins * p];
+        const float v_p = src.variance_table_[p];
+
+        std::array<float, CoreConfig::spectraSize()> color_sum{};
+        float variance_sum = 0.0f;
+        float weight_sum = 0.0f;
+        for (int j = 0; j < 5; ++j) {
+          const int qy = y + (j - 2) * cast<int>(step);
+          if ((qy < 0) || (height <= qy))
+            continue;
+          for (int i = 0; i < 5; ++i) {
+            const int qx = x + (i - 2) * cast<int>(step);
+            if ((qx < 0) || (width <= qx))
+              continue;
+            const std::size_t q = cast<std::size_t>(qx + width * qy);
+            const float* c_q = &src.color_table_[num_of_bins * q];
+            const float v_q = src.variance_table_[q];
+            float distance2 = 0.0f;
+            for (uint b = 0; b < num_of_bins; ++b)
+              distance2 += zisc::power<2>(c_p[b] - c_q[b]);
+            distance2 *= inv_bins;
+            const float color_weight =
+                zisc::exp(-distance2 / (k * (v_p + v_q) + min_variance));
+            float w = kernel[j] * kernel[i] * color_weight;
+            if (src.hasFeatures()) {
+              const float* n_p = &src.normal_table_[3 * p];
+              const float* n_q = &src.normal_table_[3 * q];
+              const float cos_pq = n_p[0] * n_q[0] + n_p[1] * n_q[1] +
+                                   n_p[2] * n_q[2];
+              const bool is_background_p = n_p[0] * n_p[0] + n_p[1] * n_p[1] +
+                                           n_p[2] * n_p[2] < 0.5f;
+              const bool is_background_q = n_q[0] * n_q[0] + n_q[1] * n_q[1] +
+                                           n_q[2] * n_q[2] < 0.5f;
+              const float normal_weight =
+                  (is_background_p != is_background_q) ? 0.0f :
+                  is_background_p ? 1.0f
+                                  : zisc::power<normalPower()>(zisc::max(0.0f, cos_pq));
+              const float albedo_distance2 =
+                  zisc::power<2>(src.albedo_table_[p] - src.albedo_table_[q]);
+              constexpr float k_a = zisc::power<2>(albedoSigma());
+              w *= normal_weight * zisc::exp(-albedo_distance2 / k_a);
+            }
+            for (uint b = 0; b < num_of_bins; ++b)
+              color_sum[b] += w * c_q[b];
+            variance_sum += w * w * v_q;
+            weight_sum += w;
+          }
+        }
+        // The weight of the center tap is always positive
+        const float inv_weight = zisc::invert(weight_sum);
+        float* c_dst = &dst->color_table_[num_of_bins * p];
+        for (uint b = 0; b < num_of_bins; ++b)
+          c_dst[b] = color_sum[b] * inv_weight;
+        dst->variance_table_[p] = variance_sum * zisc::power<2>(inv_weight);
+      }
+    }
+  };
+
+  {
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(filter_rows, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  */
+void AtrousWaveletDenoiser::initialize(const SettingNodeBase* settings) noexcept
+{
+  const auto system_settings = castNode<SystemSettingNode>(settings);
+  const auto& parameters = system_settings->atrousWaveletDenoiserParameters();
+  num_of_iterations_ = zisc::cast<uint>(parameters.number_of_iterations_);
+  color_sigma_ = zisc::cast<float>(parameters.color_sigma_);
+}
+
+/*!
+  \details
+  The color is the mean of the cycle values and the variance is the variance
+  of the mean, which is averaged over the bins.
+  The variance is zero until the second cycle, so the filter keeps the values.
+  */
+void AtrousWaveletDenoiser::initBuffer(
+    DenoisingContext& context,
+    const uint32 cycle,
+    const SampleStatistics& statistics,
+    Buffer* buffer) const noexcept
+{
+  using zisc::cast;
+
+  const auto& resolution = context.imageResolution();
+  const uint num_of_pixels = resolution[0] * resolution[1];
+  const auto& mean_table = statistics.meanTable();
+  const uint num_of_bins = mean_table.numOfBins();
+  buffer->color_table_.resize(num_of_bins * num_of_pixels);
+  buffer->variance_table_.resize(num_of_pixels);
+
+  const Float k = (1 < cycle)
+      ? zisc::invert(cast<Float>(cycle) * cast<Float>(cycle - 1) *
+                     cast<Float>(num_of_bins))
+      : 0.0;
+  const bool has_features =
+      statistics.isEnabled(SampleStatistics::Type::kFirstHitFeatures);
+  if (has_features) {
+    buffer->normal_table_.resize(3 * num_of_pixels);
+    buffer->albedo_table_.resize(num_of_pixels);
+  }
+
+  auto init_pixels = [&context, &statistics, buffer, num_of_pixels, num_of_bins,
+                      k, has_features](const uint task_id)
+  {
+    const auto& mean_table = statistics.meanTable();
+    const auto& squared_deviation_table = statistics.squaredDeviationTable();
+    const uint width = statistics.resolution()[0];
+    const auto range = context.calcTaskRange(num_of_pixels, task_id);
+    for (uint p = range[0]; p < range[1]; ++p) {
+      // The buffer is row-major for the filter, the tables are tile-major
+      const uint t = statistics.getIndex(Index2d{p % width, p / width});
+      float* color = &buffer->color_table_[num_of_bins * p];
+      Float squared_deviation = 0.0;
+      for (uint b = 0; b < num_of_bins; ++b) {
+        color[b] = cast<float>(mean_table.get(t, b));
+        squared_deviation += squared_deviation_table.get(t, b);
+      }
+      buffer->variance_table_[p] = cast<float>(k * squared_deviation);
+      // The mean of the normals is normalized
+      if (has_features) {
+        const auto& count_table = statistics.firstHitCountTable();
+        const auto& normal_table = statistics.firstHitNormalTable();
+        const auto& albedo_table = statistics.firstHitAlbedoTable();
+        const float inv_count = (0 < count_table[t])
+            ? zisc::invert(cast<float>(count_table[t]))
+            : 0.0f;
+        float* normal = &buffer->normal_table_[3 * p];
+        float length2 = 0.0f;
+        for (uint i = 0; i < 3; ++i) {
+          normal[i] = cast<float>(normal_table[3 * t + i]) * inv_count;
+          length2 += normal[i] * normal[i];
+        }
+        const float inv_length = (0.0f < length2)
+            ? zisc::invert(zisc::sqrt(length2))
+            : 0.0f;
+        for (uint i = 0; i < 3; ++i)
+          normal[i] *= inv_length;
+        buffer->albedo_table_[p] = cast<float>(albedo_table[t]) * inv_count;
+      }
+    }
+  };
+
+  {
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(init_pixels, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  */
+void AtrousWaveletDenoiser::writeBuffer(
+    DenoisingContext& context,
+    const Buffer& buffer,
+    SampleStatistics* statistics) const noexcept
+{
+  const auto& resolution = context.imageResolution();
+  const uint num_of_pixels = resolution[0] * resolution[1];
+  auto write_pixels = [&context, &buffer, statistics, num_of_pixels]
+  (const uint task_id)
+  {
+    auto& dst = statistics->denoisedSampleTable();
+    const uint num_of_bins = dst.numOfBins();
+    const uint width = statistics->resolution()[0];
+    const auto range = context.calcTaskRange(num_of_pixels, task_id);
+    for (uint p = range[0]; p < range[1]; ++p) {
+      const uint t = statistics->getIndex(Index2d{p % width, p / width});
+      const float* color = &buffer.color_table_[num_of_bins * p];
+      for (uint b = 0; b < num_of_bins; ++b)
+        dst.set(t, b, zisc::max(0.0, zisc::cast<Float>(color[b])));
+    }
+  };
+
+  {
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(write_pixels, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+} // namespace nanairo
@@ -0,0 +1,121 @@
+/*!
+  \file atrous_wavelet_denoiser.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_ATROUS_WAVELET_DENOISER_HPP
+#define NANAIRO_ATROUS_WAVELET_DENOISER_HPP
+
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "denoiser.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class DenoisingContext;
+class SampleStatistics;
+class System;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A fast edge avoiding a-trous wavelet denoiser for the preview
+  \details
+  The image is filtered by the 5x5 B3 spline kernel iteratively,
+  and the distance of the taps is doubled at each iteration.
+  The weight of a tap is stopped by the color distance
+  which is normalized by the variance of the expected values,
+  and the variance is filtered together with the color.
+  If the film has the first hit features, the weight is also stopped
+  by the normals and the albedos.
+  The values are calculated in float, since the quality isn't the priority.
+  */
+class AtrousWaveletDenoiser : public Denoiser
+{
+ public:
+  //! Initialize a denoiser
+  AtrousWaveletDenoiser(System& system,
+                        const SettingNodeBase* settings) noexcept;
+
+
+  //! Denoise input value
+  void denoise(DenoisingContext& context,
+               const uint32 cycle,
+               SampleStatistics* statistics) const noexcept override;
+
+  //! Return the number of the iterations
+  uint numOfIterations() const noexcept;
+
+ private:
+  /*!
+    \details
+    The colors are stored in [pixel][bin] order.
+    */
+  struct Buffer
+  {
+    //! Set resource
+    Buffer(zisc::pmr::memory_resource* resource) noexcept;
+
+    //! Check if the buffer has the first hit features
+    bool hasFeatures() const noexcept;
+
+    zisc::pmr::vector<float> color_table_;
+    zisc::pmr::vector<float> variance_table_;
+    zisc::pmr::vector<float> normal_table_; //!< [pixel][xyz], zero if no hit
+    zisc::pmr::vector<float> albedo_table_;
+  };
+
+
+  //! Filter the buffer by the step
+  void filter(DenoisingContext& context,
+              const uint num_of_bins,
+              const uint step,
+              const Buffer& src,
+              Buffer* dst) const noexcept;
+
+  //! Return the standard deviation of the albedo edge stopping function
+  static constexpr float albedoSigma() noexcept;
+
+  //! Return the weights of the B3 spline kernel
+  static constexpr std::array<float, 5> getKernel() noexcept;
+
+  //! Initialize the denoiser
+  void initialize(const SettingNodeBase* settings) noexcept;
+
+  //! Initialize the buffer by the statistics
+  void initBuffer(DenoisingContext& context,
+                  const uint32 cycle,
+                  const SampleStatistics& statistics,
+                  Buffer* buffer) const noexcept;
+
+  //! Return the exponent of the normal edge stopping function
+  static constexpr uint normalPower() noexcept;
+
+  //! Write the filtered colors to the statistics
+  void writeBuffer(DenoisingContext& context,
+                   const Buffer& buffer,
+                   SampleStatistics* statistics) const noexcept;
+
+
+  float color_sigma_ = 4.0f;
+  uint num_of_iterations_ = 5;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "atrous_wavelet_denoiser-inl.hpp"
+
+#endif // NANAIRO_ATROUS_WAVELET_DENOISER_HPP
@@ -22,24 +22,24 @@ namespace nanairo {
 
 /*!
   */
-template <uint kDimension> inline
-constexpr uint BayesianCollaborativeDenoiser<kDimension>::dimension() noexcept
+template <uint kDimension, typename FloatType> inline
+constexpr uint BayesianCollaborativeDenoiser<kDimension, FloatType>::dimension() noexcept
 {
   return kDimension;
 }
 
 /*!
   */
-template <uint kDimension> inline
-uint BayesianCollaborativeDenoiser<kDimension>::histogramBins() const noexcept
+template <uint kDimension, typename FloatType> inline
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::histogramBins() const noexcept
 {
   return histogram_bins_;
 }
 
 /*!
   */
-template <uint kDimension> inline
-constexpr std::array<Index2d, 9> BayesianCollaborativeDenoiser<kDimension>::
+template <uint kDimension, typename FloatType> inline
+constexpr std::array<Index2d, 9> BayesianCollaborativeDenoiser<kDimension, FloatType>::
     getChunkTileOrder() noexcept
 {
   const std::array<Index2d, 9> order{{
@@ -57,14 +57,26 @@ constexpr std::array<Index2d, 9> BayesianCollaborativeDenoiser<kDimension>::
 
 /*!
   */
-template <uint kDimension> inline
-constexpr uint BayesianCollaborativeDenoiser<kDimension>::getCovarianceMatrixSize(
+template <uint kDimension, typename FloatType> inline
+constexpr uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getCovarianceMatrixSize(
     const uint dimension) noexcept
 {
   const uint size = ((dimension + 1) * dimension) >> 1;
   return size;
 }
 
+/*!
+  \details
+  A mask is selected again if 5 % of the normalized histogram of a pixel
+  in the patches which the mask compares moves between the bins.
+  */
+template <uint kDimension, typename FloatType> inline
+constexpr FloatType BayesianCollaborativeDenoiser<kDimension, FloatType>::warmStartTolerance()
+    noexcept
+{
+  return 0.05;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_BAYESIAN_COLLABORATIVE_DENOISER_INL_HPP
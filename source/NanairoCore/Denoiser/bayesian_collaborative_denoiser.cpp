@@ -12,7 +12,11 @@
 #include <array>
 #include <atomic>
 #include <bitset>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
 #include <limits>
+#include <mutex>
 #include <vector>
 // Zisc
 #include "zisc/arith_array.hpp"
@@ -20,10 +24,12 @@
 #include "zisc/function_reference.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "bayesian_collaborative_denoiser.hpp"
 #include "denoiser.hpp"
+#include "denoising_context.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
@@ -31,51 +37,101 @@
 #include "NanairoCore/Sampling/sample_statistics.hpp"
 #include "NanairoCore/Setting/system_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
 /*!
   */
-template <uint kDimension>
-BayesianCollaborativeDenoiser<kDimension>::BayesianCollaborativeDenoiser(
+template <uint kDimension, typename FloatType>
+BayesianCollaborativeDenoiser<kDimension, FloatType>::BayesianCollaborativeDenoiser(
+    System& system,
     const SettingNodeBase* settings) noexcept :
-        Denoiser(settings)
+        Denoiser(settings),
+        cache_list_{&system.trackedMemoryResource(MemoryCategory::kDenoiser)}
 {
   initialize(settings);
+  // The caches are kept until the denoiser is destroyed
+  auto* cache_resource = cache_list_.get_allocator().resource();
+  cache_list_.reserve(num_of_scales_);
+  for (uint scale = 0; scale < num_of_scales_; ++scale)
+    cache_list_.emplace_back(cache_resource);
 }
 
 /*!
+  \details
+  If the work memory of the image exceeds the memory budget,
+  the image is denoised region by region. Each region has the halo
+  which the patches of the interior pixels refer at all scales,
+  and only the interior pixels are written into the statistics.
+  The similar patch masks aren't cached in the tiled mode,
+  since the cache is as large as the image.
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::denoise(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::denoise(
+    DenoisingContext& context,
     const uint32 cycle,
     SampleStatistics* statistics) const noexcept
 {
   notifyProgress(0.0);
-  denoiseMultiscale(system, cycle, statistics);
+  const auto& resolution = context.imageResolution();
+  const uint interior_size = getRegionInteriorSize(resolution);
+  if (interior_size == 0) {
+    const ImageRegion region{Index2d{0, 0}, resolution,
+                             Index2d{0, 0}, resolution};
+    denoiseMultiscale(context, cycle, region, cache_list_.data(),
+                      std::array<double, 2>{{0.0, 1.0}}, statistics);
+  }
+  else {
+    const uint halo = getRegionHaloSize();
+    const Index2d num_of_regions{
+        (resolution[0] + interior_size - 1) / interior_size,
+        (resolution[1] + interior_size - 1) / interior_size};
+    const uint total = num_of_regions[0] * num_of_regions[1];
+    for (uint number = 0; number < total; ++number) {
+      const Index2d position{number % num_of_regions[0],
+                             number / num_of_regions[0]};
+      ImageRegion region;
+      for (uint i = 0; i < 2; ++i) {
+        const uint begin = position[i] * interior_size;
+        const uint end = zisc::min(resolution[i], begin + interior_size);
+        region.offset_[i] = zisc::max(halo, begin) - halo;
+        region.resolution_[i] = zisc::min(resolution[i], end + halo) -
+                                region.offset_[i];
+        region.interior_begin_[i] = begin - region.offset_[i];
+        region.interior_end_[i] = end - region.offset_[i];
+      }
+      const std::array<double, 2> progress_range{{
+          zisc::cast<double>(number) / zisc::cast<double>(total),
+          zisc::cast<double>(number + 1) / zisc::cast<double>(total)}};
+      denoiseMultiscale(context, cycle, region, nullptr, progress_range,
+                        statistics);
+    }
+  }
+  notifyProgress(1.0);
 }
 
 /*!
   */
-template <uint kDimension>
-BayesianCollaborativeDenoiser<kDimension>::Parameters::Parameters(System& system)
-    noexcept :
-        sample_value_table_{&system.globalMemoryManager()},
-        histogram_table_{&system.globalMemoryManager()},
-        covariance_factor_table_{&system.globalMemoryManager()},
-        denoised_value_table_{&system.globalMemoryManager()}
+template <uint kDimension, typename FloatType>
+BayesianCollaborativeDenoiser<kDimension, FloatType>::Parameters::Parameters(
+    DenoisingContext& context) noexcept :
+        sample_value_table_{&context.workResource()},
+        histogram_table_{&context.workResource()},
+        histogram_plane_table_{&context.workResource()},
+        covariance_factor_table_{&context.workResource()},
+        denoised_value_table_{&context.workResource()}
 {
 }
 
 /*!
   */
-template <uint kDimension> template <uint kN>
-void BayesianCollaborativeDenoiser<kDimension>::Parameters::upscaleAdd(
+template <uint kDimension, typename FloatType> template <uint kN>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::Parameters::upscaleAdd(
     const Index2d& low_res,
-    const zisc::pmr::vector<zisc::ArithArray<Float, kN>>& low_res_table,
+    const zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>& low_res_table,
     const Index2d& high_res,
-    zisc::pmr::vector<zisc::ArithArray<Float, kN>>* high_res_table,
+    zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>* high_res_table,
     const Index2d& range) noexcept
 {
   for (uint high_index = range[0]; high_index < range[1]; ++high_index) {
@@ -90,9 +146,9 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::upscaleAdd(
       low_p2[i] = zisc::min(low_p2[i], low_res[i] - 1);
     }
 
-    constexpr Float main_weight = 9.0 / 16.0;
-    constexpr Float adjacent_weight = 3.0 / 16.0;
-    constexpr Float diagonal_weight = 1.0 / 16.0;
+    constexpr FloatType main_weight = 9.0 / 16.0;
+    constexpr FloatType adjacent_weight = 3.0 / 16.0;
+    constexpr FloatType diagonal_weight = 1.0 / 16.0;
     auto interp = main_weight * low_res_table[low_p1[0] + low_res[0] * low_p1[1]];
     interp += adjacent_weight * low_res_table[low_p1[0] + low_res[0] * low_p2[1]];
     interp += adjacent_weight * low_res_table[low_p2[0] + low_res[0] * low_p1[1]];
@@ -103,12 +159,12 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::upscaleAdd(
 
 /*!
   */
-template <uint kDimension> template <uint kN>
-void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleSum(
+template <uint kDimension, typename FloatType> template <uint kN>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::Parameters::downscaleSum(
     const Index2d& high_res,
-    const zisc::pmr::vector<zisc::ArithArray<Float, kN>>& high_res_table,
+    const zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>& high_res_table,
     const Index2d& low_res,
-    zisc::pmr::vector<zisc::ArithArray<Float, kN>>* low_res_table,
+    zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>* low_res_table,
     const Index2d& range,
     const uint table_offset) noexcept
 {
@@ -116,7 +172,7 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleSum(
   const uint low_offset = table_offset * low_res[0] * low_res[1];
   for (uint low_index = range[0]; low_index < range[1]; ++low_index) {
     const Index2d low_pixel{low_index % low_res[0], low_index / low_res[0]};
-    zisc::ArithArray<Float, kN> sum;
+    zisc::ArithArray<FloatType, kN> sum;
     for (uint offset_y = 0; offset_y < 2; ++offset_y) {
       for (uint offset_x = 0; offset_x < 2; ++offset_x) {
         const Index2d high_pixel{
@@ -132,9 +188,9 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleSum(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleOf(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::Parameters::downscaleOf(
+    DenoisingContext& context,
     const Parameters& high_res_p) noexcept
 {
   for (uint i = 0; i < resolution_.size(); ++i)
@@ -144,14 +200,15 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleOf(
 
   sample_value_table_.resize(resolution_[0] * resolution_[1]);
   histogram_table_.resize(histogram_bins_ * resolution_[0] * resolution_[1]);
+  histogram_plane_table_.resize(histogram_table_.size() * dimension());
   covariance_factor_table_.resize(resolution_[0] * resolution_[1]);
   denoised_value_table_.resize(resolution_[0] * resolution_[1]);
 
-  auto downscale_params = [this, &system, &high_res_p](const uint task_id)
+  auto downscale_params = [this, &context, &high_res_p](const uint task_id)
   {
     // Set the calculation range
-    const auto range = system.calcTaskRange(resolution_[0] * resolution_[1],
-                                            task_id);
+    const auto range = context.calcTaskRange(resolution_[0] * resolution_[1],
+                                             task_id);
     downscaleSum(high_res_p.resolution_, high_res_p.sample_value_table_,
                  resolution_, &sample_value_table_,
                  Index2d{range[0], range[1]});
@@ -160,14 +217,15 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleOf(
                    resolution_, &histogram_table_,
                    Index2d{range[0], range[1]}, b);
     }
+    makeHistogramPlanes(Index2d{range[0], range[1]});
     downscaleSum(high_res_p.resolution_, high_res_p.covariance_factor_table_,
                  resolution_, &covariance_factor_table_,
                  Index2d{range[0], range[1]});
   };
 
   {
-    auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
     constexpr uint start = 0;
     const uint end = threads.numOfThreads();
     auto result = threads.enqueueLoop(downscale_params, start, end, &work_resource);
@@ -177,50 +235,66 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::downscaleOf(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::Parameters::init(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::Parameters::init(
+    DenoisingContext& context,
     const uint32 cycle,
     const uint histogram_bins,
+    const ImageRegion& region,
     const SampleStatistics& statistics) noexcept
 {
-//  using zisc::cast;
+  using zisc::cast;
 
-  resolution_ = system.imageResolution();
+  resolution_ = region.resolution_;
   num_of_samples_ = cycle;
   histogram_bins_ = histogram_bins;
 
   sample_value_table_.resize(resolution_[0] * resolution_[1]);
   histogram_table_.resize(histogram_bins_ * resolution_[0] * resolution_[1]);
+  histogram_plane_table_.resize(histogram_table_.size() * dimension());
   covariance_factor_table_.resize(resolution_[0] * resolution_[1]);
   denoised_value_table_.resize(resolution_[0] * resolution_[1]);
 
-  auto init_params = [this, &system, &statistics](const uint task_id)
+  auto init_params = [this, &context, &region, &statistics](const uint task_id)
   {
+    const auto& sample_table = statistics.sampleTable();
+    const auto& mean_table = statistics.meanTable();
+    const auto& squared_deviation_table = statistics.squaredDeviationTable();
+    const auto& histogram_table = statistics.histogramTable();
     // Set the calculation range
-    const auto range = system.calcTaskRange(resolution_[0] * resolution_[1],
-                                            task_id);
+    const auto range = context.calcTaskRange(resolution_[0] * resolution_[1],
+                                             task_id);
+
+    auto to_image_index = [this, &region, &statistics](const uint pixel_index)
+    {
+      const uint x = region.offset_[0] + (pixel_index % resolution_[0]);
+      const uint y = region.offset_[1] + (pixel_index / resolution_[0]);
+      return statistics.getIndex(Index2d{x, y});
+    };
 
     for (auto pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
+      const uint image_index = to_image_index(pixel_index);
       // Init sample value table
       {
-        const auto& sample_p = statistics.sampleTable()[pixel_index];
         auto& sample_value = sample_value_table_[pixel_index];
         for (uint si = 0; si < dimension(); ++si)
-          sample_value[si] = sample_p->get(si);
+          sample_value[si] = cast<FloatType>(sample_table.get(image_index, si));
       }
 
       // Init covariance factors
+      // The sum of squares is sum (x - mean)^2 + mean * sum x
       {
-        const auto& sample_squared_p = statistics.sampleSquaredTable()[pixel_index];
-        const uint factor_index = statistics.numOfCovarianceFactors() * pixel_index;
+        const uint factor_index = statistics.numOfCovarianceFactors() * image_index;
         const auto factor_p = &statistics.covarianceFactorTable()[factor_index];
         auto& covariance_factors = covariance_factor_table_[pixel_index];
         for (uint offset = 0, si_a = 0; si_a < dimension(); ++si_a) {
           for (uint si_b = si_a; si_b < dimension(); ++offset, ++si_b) {
-            covariance_factors[offset] = (si_a == si_b)
-                ? sample_squared_p->get(si_a)
-                : factor_p[statistics.getFactorIndex(si_a) + ((si_b - si_a) - 1)].get();
+            const Float factor = (si_a == si_b)
+                ? squared_deviation_table.get(image_index, si_a) +
+                  mean_table.get(image_index, si_a) *
+                  sample_table.get(image_index, si_a)
+                : cast<Float>(factor_p[statistics.getFactorIndex(si_a) + ((si_b - si_a) - 1)]);
+            covariance_factors[offset] = cast<FloatType>(factor);
           }
         }
       }
@@ -230,19 +304,19 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::init(
     for (uint b = 0; b < histogram_bins_; ++b) {
       const uint histogram_offset = b * (resolution_[0] * resolution_[1]);
       for (uint pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
-        const uint src_index = histogram_bins_ * pixel_index + b;
-        const auto& src = statistics.histogramTable()[src_index];
+        const uint src_index = histogram_bins_ * to_image_index(pixel_index) + b;
         const uint dst_index = histogram_offset + pixel_index;
         auto& dst = histogram_table_[dst_index];
         for (uint si = 0; si < dimension(); ++si)
-          dst[si] = src->get(si);
+          dst[si] = cast<FloatType>(histogram_table.get(src_index, si));
       }
     }
+    makeHistogramPlanes(Index2d{range[0], range[1]});
   };
 
   {
-    auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
     constexpr uint start = 0;
     const uint end = threads.numOfThreads();
     auto result = threads.enqueueLoop(init_params, start, end, &work_resource);
@@ -250,24 +324,46 @@ void BayesianCollaborativeDenoiser<kDimension>::Parameters::init(
   }
 }
 
+/*!
+  \details
+  The plane of the bin b and the dimension si is the plane (b * dimension + si),
+  so the pixels of a patch row are contiguous in a plane.
+  */
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::Parameters::makeHistogramPlanes(
+    const Index2d& range) noexcept
+{
+  const uint plane_size = resolution_[0] * resolution_[1];
+  for (uint b = 0; b < histogram_bins_; ++b) {
+    const uint histogram_offset = b * plane_size;
+    for (uint si = 0; si < dimension(); ++si) {
+      FloatType* plane = &histogram_plane_table_[(b * dimension() + si) * plane_size];
+      for (uint pixel_index = range[0]; pixel_index < range[1]; ++pixel_index)
+        plane[pixel_index] = histogram_table_[histogram_offset + pixel_index][si];
+    }
+  }
+}
+
 /*!
   */
-template <uint kDimension>
-BayesianCollaborativeDenoiser<kDimension>::PixelMarker::PixelMarker(
-    System& system) noexcept :
-        marker_table_{&system.globalMemoryManager()}
+template <uint kDimension, typename FloatType>
+BayesianCollaborativeDenoiser<kDimension, FloatType>::PixelMarker::PixelMarker(
+    DenoisingContext& context,
+    const Index2d& resolution) noexcept :
+        marker_table_{&context.workResource()}
 {
   constexpr uint marker_bytes = zisc::power<kMarkerRepBits>(2) / 8;
   static_assert(sizeof(Marker) == marker_bytes, "The size of marker is wrong.");
-  const auto& resolution = system.imageResolution();
-  const uint num_of_marks = (resolution[0] * resolution[1]) >> kMarkerRepBits;
+  constexpr uint marker_bits = 0b1u << kMarkerRepBits;
+  const uint num_of_marks = (resolution[0] * resolution[1] + (marker_bits - 1)) >>
+                            kMarkerRepBits;
   marker_table_.resize(num_of_marks);
 }
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::PixelMarker::clear() noexcept
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::PixelMarker::clear() noexcept
 {
   for (auto& marker : marker_table_)
     marker.reset();
@@ -275,8 +371,8 @@ void BayesianCollaborativeDenoiser<kDimension>::PixelMarker::clear() noexcept
 
 /*!
   */
-template <uint kDimension>
-bool BayesianCollaborativeDenoiser<kDimension>::PixelMarker::isMarked(
+template <uint kDimension, typename FloatType>
+bool BayesianCollaborativeDenoiser<kDimension, FloatType>::PixelMarker::isMarked(
     const uint index) const noexcept
 {
   constexpr uint mask = sizeof(Marker) * 8 - 1;
@@ -287,8 +383,8 @@ bool BayesianCollaborativeDenoiser<kDimension>::PixelMarker::isMarked(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::PixelMarker::mark(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::PixelMarker::mark(
     const uint index) noexcept
 {
   constexpr uint mask = sizeof(Marker) * 8 - 1;
@@ -299,30 +395,82 @@ void BayesianCollaborativeDenoiser<kDimension>::PixelMarker::mark(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::aggregate(
-    System& system,
+template <uint kDimension, typename FloatType>
+BayesianCollaborativeDenoiser<kDimension, FloatType>::WarmStartCache::WarmStartCache(
+    zisc::pmr::memory_resource* resource) noexcept :
+        signature_table_{resource},
+        mask_table_{resource},
+        mask_state_table_{resource},
+        resolution_{0, 0},
+        cycle_{0}
+{
+}
+
+/*!
+  */
+template <uint kDimension, typename FloatType>
+auto BayesianCollaborativeDenoiser<kDimension, FloatType>::WarmStartCache::mask(
+    const uint index,
+    const uint num_of_words) const noexcept -> SimilarPatchMask
+{
+  SimilarPatchMask similar_mask;
+  const uint64* words = &mask_table_[num_of_words * index];
+  for (uint w = 0; w < num_of_words; ++w) {
+    const uint64 word = words[w];
+    for (uint bit = 0; bit < 64; ++bit) {
+      if ((word >> bit) & 1u)
+        similar_mask.set(64 * w + bit);
+    }
+  }
+  return similar_mask;
+}
+
+/*!
+  */
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::WarmStartCache::setMask(
+    const uint index,
+    const uint num_of_words,
+    const SimilarPatchMask& similar_mask) noexcept
+{
+  uint64* words = &mask_table_[num_of_words * index];
+  for (uint w = 0; w < num_of_words; ++w) {
+    uint64 word = 0;
+    for (uint bit = 0; bit < 64; ++bit) {
+      if (similar_mask[64 * w + bit])
+        word |= zisc::cast<uint64>(1) << bit;
+    }
+    words[w] = word;
+  }
+  mask_state_table_[index] = kTrue;
+}
+
+/*!
+  */
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::aggregate(
+    DenoisingContext& context,
     const zisc::pmr::vector<int>& estimates_counter,
     Parameters* parameter) const noexcept
 {
-  auto aggregate_values = [&system, &estimates_counter, parameter]
+  auto aggregate_values = [&context, &estimates_counter, parameter]
   (const uint task_id)
   {
     // Set the calculation range
     const auto& resolution = parameter->resolution_;
-    const auto range = system.calcTaskRange(resolution[0] * resolution[1],
-                                            task_id);
+    const auto range = context.calcTaskRange(resolution[0] * resolution[1],
+                                             task_id);
 
     for (uint pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
       ZISC_ASSERT(0 < estimates_counter[pixel_index], "The estimate count is zero.");
       auto& target = parameter->denoised_value_table_[pixel_index];
-      target *= zisc::invert(zisc::cast<Float>(estimates_counter[pixel_index]));
+      target *= zisc::invert(zisc::cast<FloatType>(estimates_counter[pixel_index]));
     }
   };
 
   {
-    auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
     constexpr uint start = 0;
     const uint end = threads.numOfThreads();
     auto result = threads.enqueueLoop(aggregate_values, start, end, &work_resource);
@@ -332,33 +480,40 @@ void BayesianCollaborativeDenoiser<kDimension>::aggregate(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::aggregateFinal(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::aggregateFinal(
+    DenoisingContext& context,
     const Parameters& parameter,
+    const ImageRegion& region,
     SampleStatistics* statistics) const noexcept
 {
-  auto aggregate_values = [&system, &parameter, statistics](const uint task_id)
+  auto aggregate_values = [&context, &parameter, &region, statistics]
+  (const uint task_id)
   {
     // Set the calculation range
     const auto& resolution = parameter.resolution_;
-    const auto range = system.calcTaskRange(resolution[0] * resolution[1],
-                                            task_id);
+    const auto range = context.calcTaskRange(resolution[0] * resolution[1],
+                                             task_id);
 
     for (uint pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
       const Index2d p{pixel_index % resolution[0],
                       pixel_index / resolution[0]};
+      // The halo is written by the adjacent regions
+      if ((p[0] < region.interior_begin_[0]) || (region.interior_end_[0] <= p[0]) ||
+          (p[1] < region.interior_begin_[1]) || (region.interior_end_[1] <= p[1]))
+        continue;
       const auto& src = parameter.denoised_value_table_[pixel_index];
-      const uint dst_index = p[0] + statistics->resolution()[0] * p[1];
-      auto& dst = statistics->denoisedSampleTable()[dst_index];
+      const uint dst_index = statistics->getIndex(
+          Index2d{region.offset_[0] + p[0], region.offset_[1] + p[1]});
+      auto& dst = statistics->denoisedSampleTable();
       for (uint si = 0; si < dimension(); ++si)
-        dst->set(si, zisc::max(0.0, src[si]));
+        dst.set(dst_index, si, zisc::max(0.0, zisc::cast<Float>(src[si])));
     }
   };
 
   {
-    auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
     constexpr uint start = 0;
     const uint end = threads.numOfThreads();
     auto result = threads.enqueueLoop(aggregate_values, start, end, &work_resource);
@@ -368,17 +523,17 @@ void BayesianCollaborativeDenoiser<kDimension>::aggregateFinal(
 
 /*!
   */
-template <uint kDimension> template <uint kN>
-zisc::ArithArray<Float, kN> BayesianCollaborativeDenoiser<kDimension>::
+template <uint kDimension, typename FloatType> template <uint kN>
+zisc::ArithArray<FloatType, kN> BayesianCollaborativeDenoiser<kDimension, FloatType>::
     calcEmpiricalMean(
         const Index2d& resolution,
         RenderingTile& search_window,
         const Index2d& patch_offset,
         const SimilarPatchMask& similar_mask,
-        const zisc::ArithArray<Float, kN>* table) const noexcept
+        const zisc::ArithArray<FloatType, kN>* table) const noexcept
 {
   search_window.reset();
-  zisc::ArithArray<Float, kN> mean;
+  zisc::ArithArray<FloatType, kN> mean;
   for (uint p = 0; p < search_window.numOfPixels(); ++p) {
     const auto& neighbor_pixel = search_window.current();
     if (similar_mask[search_window.getIndex(neighbor_pixel)]) {
@@ -389,14 +544,14 @@ zisc::ArithArray<Float, kN> BayesianCollaborativeDenoiser<kDimension>::
     }
     search_window.next();
   }
-  mean *= zisc::invert(zisc::cast<Float>(similar_mask.count()));
+  mean *= zisc::invert(zisc::cast<FloatType>(similar_mask.count()));
   return mean;
 }
 
 /*!
   */
-template <uint kDimension>
-auto BayesianCollaborativeDenoiser<kDimension>::calcEmpiricalCovarianceMatrix(
+template <uint kDimension, typename FloatType>
+auto BayesianCollaborativeDenoiser<kDimension, FloatType>::calcEmpiricalCovarianceMatrix(
     const Index2d& resolution,
     RenderingTile& search_window,
     const Index2d& patch_offset,
@@ -422,14 +577,72 @@ auto BayesianCollaborativeDenoiser<kDimension>::calcEmpiricalCovarianceMatrix(
     }
     search_window.next();
   }
-  mean *= zisc::invert(zisc::cast<Float>(similar_mask.count() - 1));
+  mean *= zisc::invert(zisc::cast<FloatType>(similar_mask.count() - 1));
   return mean;
 }
 
 /*!
+  \details
+  The matrix is (covariance_mean * expected_covariance^-1), which is shared
+  by all values of a patch group. Since both covariances are symmetric,
+  the transpose is solved from (expected_covariance * X = covariance_mean)
+  by the Cholesky decomposition of the expected covariance.
+  The loops have the fixed size, so they are unrolled.
+  If the expected covariance isn't positive definite,
+  the matrix is calculated by the inverse matrix.
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::calcStagingDenoisedValue(
+template <uint kDimension, typename FloatType>
+auto BayesianCollaborativeDenoiser<kDimension, FloatType>::calcDenoisingMatrix(
+    const CovarianceMatrix& covariance_mean,
+    const CovarianceMatrix& expected_covariance) noexcept -> CovarianceMatrix
+{
+  constexpr uint n = dimension();
+  // Cholesky decomposition, expected_covariance = L * L^T
+  std::array<FloatType, n * n> l{};
+  for (uint j = 0; j < n; ++j) {
+    FloatType d = expected_covariance(j, j);
+    for (uint k = 0; k < j; ++k)
+      d -= l[j * n + k] * l[j * n + k];
+    if (!(0.0 < d))
+      return covariance_mean * expected_covariance.inverseMatrix();
+    const FloatType l_jj = zisc::sqrt(d);
+    l[j * n + j] = l_jj;
+    const FloatType inv_l_jj = zisc::invert(l_jj);
+    for (uint i = j + 1; i < n; ++i) {
+      FloatType s = expected_covariance(i, j);
+      for (uint k = 0; k < j; ++k)
+        s -= l[i * n + k] * l[j * n + k];
+      l[i * n + j] = s * inv_l_jj;
+    }
+  }
+  // Solve L * L^T * x = b for each column b of the covariance mean
+  CovarianceMatrix matrix;
+  for (uint c = 0; c < n; ++c) {
+    std::array<FloatType, n> y{};
+    for (uint i = 0; i < n; ++i) {
+      FloatType s = covariance_mean(i, c);
+      for (uint k = 0; k < i; ++k)
+        s -= l[i * n + k] * y[k];
+      y[i] = s / l[i * n + i];
+    }
+    for (uint r = n; 0 < r; --r) {
+      const uint i = r - 1;
+      FloatType s = y[i];
+      for (uint k = i + 1; k < n; ++k)
+        s -= l[k * n + i] * y[k];
+      y[i] = s / l[i * n + i];
+    }
+    // The solution is the row of the matrix
+    for (uint i = 0; i < n; ++i)
+      matrix(c, i) = y[i];
+  }
+  return matrix;
+}
+
+/*!
+  */
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::calcStagingDenoisedValue(
     const Index2d& resolution,
     RenderingTile& search_window,
     const Index2d& patch_offset,
@@ -440,7 +653,8 @@ void BayesianCollaborativeDenoiser<kDimension>::calcStagingDenoisedValue(
     const zisc::pmr::vector<SpectraArray>& value_table,
     zisc::pmr::vector<SpectraArray>* staging_value_table) const noexcept
 {
-  const auto inv_expected_covariance = expected_covariance.inverseMatrix();
+  const auto denoising_matrix = calcDenoisingMatrix(covariance_mean,
+                                                    expected_covariance);
   search_window.reset();
   for (uint p = 0; p < search_window.numOfPixels(); ++p) {
     const auto& neighbor_pixel = search_window.current();
@@ -452,146 +666,253 @@ void BayesianCollaborativeDenoiser<kDimension>::calcStagingDenoisedValue(
       const uint index = target_pixel[0] + resolution[0] * target_pixel[1];
 
       const auto& x = value_table[index];
-      const auto tmp = inv_expected_covariance * (x - expected_mean);
-      (*staging_value_table)[index] = x - (covariance_mean * tmp);
+      (*staging_value_table)[index] = x - (denoising_matrix * (x - expected_mean));
     }
     search_window.next();
   }
 }
 
 /*!
+  \details
+  The loop has no branch, so the compiler vectorizes it over the row.
+  The sum is divided by at least 1 so that the masked out lanes are finite.
   */
-template <uint kDimension>
-Float BayesianCollaborativeDenoiser<kDimension>::calcHistogramDistance(
-    const SpectraArray& histogram_lhs,
-    const SpectraArray& histogram_rhs,
-    uint* num_of_non_both0) const noexcept
+template <uint kDimension, typename FloatType>
+FloatType BayesianCollaborativeDenoiser<kDimension, FloatType>::calcHistogramDistance(
+    const FloatType* histogram_lhs,
+    const FloatType* histogram_rhs,
+    const uint size,
+    uint* num_of_non_both0) noexcept
 {
+  using zisc::cast;
+
   ZISC_ASSERT(num_of_non_both0 != nullptr, "The num_of_non_both0 is null.");
-  Float distance_sum = 0.0;
-  for (uint si = 0; si < dimension(); ++si) {
-    const Float lhs = histogram_lhs[si];
-    const Float rhs = histogram_rhs[si];
-    if (1.0 < (lhs + rhs)) {
-      ++(*num_of_non_both0);
-      const Float d = zisc::power<2>(lhs - rhs) / (lhs + rhs);
-      distance_sum += d;
-    }
+  FloatType distance_sum = 0.0;
+  uint num_of_elements = 0;
+  for (uint i = 0; i < size; ++i) {
+    const FloatType lhs = histogram_lhs[i];
+    const FloatType rhs = histogram_rhs[i];
+    const FloatType sum = lhs + rhs;
+    const bool is_non_both0 = 1.0 < sum;
+    const FloatType d = zisc::power<2>(lhs - rhs) / zisc::max(sum, cast<FloatType>(1.0));
+    distance_sum += is_non_both0 ? d : cast<FloatType>(0.0);
+    num_of_elements += is_non_both0 ? 1u : 0u;
   }
+  *num_of_non_both0 += num_of_elements;
   return distance_sum;
 }
 
 /*!
+  \details
+  The distance is normalized by the number of the non-zero elements,
+  which is unknown until all planes are visited. The distance is
+  at least the sum divided by the count which assumes all remaining elements
+  are non-zero, so the calculation is terminated once the bound exceeds
+  the threshold. Then the bound is returned, which is also over the threshold.
   */
-template <uint kDimension>
-Float BayesianCollaborativeDenoiser<kDimension>::calcHistogramPatchDistance(
+template <uint kDimension, typename FloatType>
+FloatType BayesianCollaborativeDenoiser<kDimension, FloatType>::calcHistogramPatchDistance(
     const Parameters& parameter,
     const Index2d& center_pixel_lhs,
     const Index2d& center_pixel_rhs) const noexcept
 {
+  using zisc::cast;
+
   const auto& resolution = parameter.resolution_;
-  Float histogram_distance = 0.0;
+  const uint plane_size = resolution[0] * resolution[1];
+  const uint patch_width = 2 * patch_radius_ + 1;
+  const uint begin_lhs = (center_pixel_lhs[0] - patch_radius_) +
+                         resolution[0] * (center_pixel_lhs[1] - patch_radius_);
+  const uint begin_rhs = (center_pixel_rhs[0] - patch_radius_) +
+                         resolution[0] * (center_pixel_rhs[1] - patch_radius_);
+
+  const uint num_of_planes = parameter.histogram_bins_ * dimension();
+  uint num_of_remaining_elements = num_of_planes * getNumOfPatchPixels();
+  FloatType histogram_distance = 0.0;
   uint num_of_non_both0 = 0;
-
-  auto patch_lhs = makePatch(center_pixel_lhs);
-  auto patch_rhs = makePatch(center_pixel_rhs);
-
-  for (uint b = 0; b < parameter.histogram_bins_; ++b) {
-    const uint histogram_offset = b * resolution[0] * resolution[1];
-
-    patch_lhs.reset();
-    patch_rhs.reset();
-    for (uint p = 0; p < getNumOfPatchPixels(); ++p) {
-      const auto& p_lhs = patch_lhs.current();
-      const auto& p_rhs = patch_rhs.current();
-
-      const uint index_lhs = p_lhs[0] + resolution[0] * p_lhs[1];
-      const uint index_rhs = p_rhs[0] + resolution[0] * p_rhs[1];
-
-      const auto& histogram_table = parameter.histogram_table_;
-      const auto& histogram_lhs = histogram_table[histogram_offset + index_lhs];
-      const auto& histogram_rhs = histogram_table[histogram_offset + index_rhs];
-      histogram_distance += calcHistogramDistance(histogram_lhs,  
-                                                  histogram_rhs,
+  for (uint plane = 0; plane < num_of_planes; ++plane) {
+    const FloatType* plane_p = &parameter.histogram_plane_table_[plane * plane_size];
+    for (uint y = 0; y < patch_width; ++y) {
+      const uint row_offset = y * resolution[0];
+      histogram_distance += calcHistogramDistance(plane_p + begin_lhs + row_offset,
+                                                  plane_p + begin_rhs + row_offset,
+                                                  patch_width,
                                                   &num_of_non_both0);
-
-      patch_lhs.next();
-      patch_rhs.next();
     }
+    num_of_remaining_elements -= getNumOfPatchPixels();
+    // Early termination
+    const uint max_num_of_elements = num_of_non_both0 + num_of_remaining_elements;
+    if (histogram_distance_threshold_ * cast<FloatType>(max_num_of_elements) <
+        histogram_distance)
+      return histogram_distance / cast<FloatType>(max_num_of_elements);
   }
   ZISC_ASSERT(0 < num_of_non_both0, "The num of elements is zero.");
-  histogram_distance = histogram_distance / zisc::cast<Float>(num_of_non_both0);
+  histogram_distance = histogram_distance / cast<FloatType>(num_of_non_both0);
   return histogram_distance;
 }
 
 /*!
+  \details
+  A job denoises a tile of a chunk. The tiles of a group are separated by
+  the other tiles, so the patches of them don't overlap. Instead of a barrier
+  per tile group, the job of a tile starts as soon as the adjacent chunks
+  finish the previous tiles, since only the tiles of the adjacent chunks
+  reach the pixels of the tile. So the threads don't idle at the end of
+  every tile group. The job which finishes a chunk tile starts the ready
+  jobs of the adjacent chunks.
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::denoiseChunks(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::denoiseChunks(
+    DenoisingContext& context,
     const Index2d& chunk_resolution,
-    const Index2d& tile_position,
+    const uint iteration,
+    const std::array<double, 2>& progress_range,
     Parameters* parameter,
+    WarmStartCache* cache,
     zisc::pmr::vector<SpectraArray>* staging_value_table,
     zisc::pmr::vector<int>* estimates_counter,
     PixelMarker* pixel_marker) const noexcept
 {
-  std::atomic<uint> chunk_count{0};
+  constexpr auto tile_order = getChunkTileOrder();
+  constexpr uint num_of_tiles = tile_order.size();
+  const uint num_of_chunks = chunk_resolution[0] * chunk_resolution[1];
+  auto* work_resource = &context.workResource();
+
+  // The number of the finished and the started tiles of each chunk
+  zisc::pmr::vector<std::atomic<uint>> finished_table(num_of_chunks, work_resource);
+  zisc::pmr::vector<std::atomic<uint>> started_table(num_of_chunks, work_resource);
+  // The number of the chunks which finished each tile
+  zisc::pmr::vector<std::atomic<uint>> tile_count_table(num_of_tiles, work_resource);
+  for (uint chunk = 0; chunk < num_of_chunks; ++chunk) {
+    finished_table[chunk].store(0);
+    started_table[chunk].store(1);
+  }
+  for (uint tile_number = 0; tile_number < num_of_tiles; ++tile_number)
+    tile_count_table[tile_number].store(0);
+  std::mutex progress_mutex;
+  uint num_of_notified_tiles = 0;
+
+  auto denoise_tile =
+  [this, parameter, cache, staging_value_table, estimates_counter, pixel_marker,
+   chunk_resolution, &tile_order]
+  (const uint chunk, const uint tile_number)
+  {
+    const auto& resolution = parameter->resolution_;
+    const Index2d chunk_position{chunk % chunk_resolution[0],
+                                 chunk / chunk_resolution[0]};
+    const auto tile_position = tile_order[tile_number];
+    auto chunk_tile = makeChunkTile(resolution, chunk_position, tile_position);
+    for (uint p = 0; p < chunk_tile.numOfPixels(); ++p) {
+      const auto& current_pixel = chunk_tile.current();
+      const uint pixel_index = current_pixel[0] +
+                               resolution[0] * current_pixel[1];
+      if (!pixel_marker->isMarked(pixel_index)) {
+        denoisePixels(current_pixel, parameter, cache,
+                      staging_value_table, estimates_counter, pixel_marker);
+      }
+      chunk_tile.next();
+    }
+  };
 
-  auto denoise_chunk =
-  [this, parameter, staging_value_table, estimates_counter, pixel_marker,
-   chunk_resolution, tile_position, &chunk_count]
-  (const uint /* task_id */)
+  // Return the range of the adjacent chunks including the chunk itself
+  auto get_adjacent_range = [&chunk_resolution](const uint chunk)
   {
-    const uint num_of_chunks = chunk_resolution[0] * chunk_resolution[1];
-    for (uint chunk = chunk_count++; chunk < num_of_chunks; chunk = chunk_count++) {
-      const auto& resolution = parameter->resolution_;
-      const Index2d chunk_position{chunk % chunk_resolution[0],
-                                   chunk / chunk_resolution[0]};
-      auto chunk_tile = makeChunkTile(resolution, chunk_position, tile_position);
-      for (uint p = 0; p < chunk_tile.numOfPixels(); ++p) {
-        const auto& current_pixel = chunk_tile.current();
-        const uint pixel_index = current_pixel[0] +
-                                 resolution[0] * current_pixel[1];
-        if (!pixel_marker->isMarked(pixel_index)) {
-          denoisePixels(current_pixel, parameter,
-                        staging_value_table, estimates_counter, pixel_marker);
-        }
-        chunk_tile.next();
+    const Index2d p{chunk % chunk_resolution[0], chunk / chunk_resolution[0]};
+    const std::array<Index2d, 2> range{{
+        Index2d{(0 < p[0]) ? p[0] - 1 : 0,
+                (0 < p[1]) ? p[1] - 1 : 0},
+        Index2d{zisc::min(p[0] + 2, chunk_resolution[0]),
+                zisc::min(p[1] + 2, chunk_resolution[1])}}};
+    return range;
+  };
+
+  auto is_ready = [&finished_table, &chunk_resolution, &get_adjacent_range]
+  (const uint chunk, const uint tile_number)
+  {
+    const auto range = get_adjacent_range(chunk);
+    for (uint y = range[0][1]; y < range[1][1]; ++y) {
+      for (uint x = range[0][0]; x < range[1][0]; ++x) {
+        if (finished_table[x + chunk_resolution[0] * y].load() < tile_number)
+          return false;
       }
     }
+    return true;
   };
 
+  TaskGroup group{context.taskScheduler()};
+  std::function<void (uint, uint)> run_job;
+  run_job =
+  [this, &group, &run_job, &denoise_tile, &is_ready, &get_adjacent_range,
+   &finished_table, &started_table, &tile_count_table, &progress_mutex,
+   &num_of_notified_tiles, &chunk_resolution, &progress_range,
+   iteration, num_of_chunks]
+  (const uint chunk, const uint tile_number)
   {
-    auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
-    constexpr uint start = 0;
-    const uint end = threads.numOfThreads();
-    auto result = threads.enqueueLoop(denoise_chunk, start, end, &work_resource);
-    result.wait();
-  }
+    denoise_tile(chunk, tile_number);
+    finished_table[chunk].store(tile_number + 1);
+    // Notify the progress when all chunks finish the tile
+    if (tile_count_table[tile_number].fetch_add(1) + 1 == num_of_chunks) {
+      std::unique_lock<std::mutex> lock{progress_mutex};
+      if (num_of_notified_tiles < tile_number + 1) {
+        num_of_notified_tiles = tile_number + 1;
+        notifyProgress(progress_range, iteration, tile_number);
+      }
+    }
+    // Start the next tiles of the adjacent chunks which are ready.
+    // The job which starts a tile is decided by the started count
+    const auto range = get_adjacent_range(chunk);
+    for (uint y = range[0][1]; y < range[1][1]; ++y) {
+      for (uint x = range[0][0]; x < range[1][0]; ++x) {
+        const uint adjacent = x + chunk_resolution[0] * y;
+        uint next = finished_table[adjacent].load();
+        if ((next < num_of_tiles) && is_ready(adjacent, next) &&
+            started_table[adjacent].compare_exchange_strong(next, next + 1)) {
+          group.run([&run_job, adjacent, next]() {run_job(adjacent, next);});
+        }
+      }
+    }
+  };
+
+  // The first tiles don't depend on any tile
+  for (uint chunk = 0; chunk < num_of_chunks; ++chunk)
+    group.run([&run_job, chunk]() {run_job(chunk, 0);});
+  group.wait();
 }
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::denoiseMultiscale(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::denoiseMultiscale(
+    DenoisingContext& context,
     const uint32 cycle,
+    const ImageRegion& region,
+    WarmStartCache* cache_list,
+    const std::array<double, 2>& progress_range,
     SampleStatistics* statistics) const noexcept
 {
-  auto* memory_manager = &system.globalMemoryManager();
+  using Clock = zisc::Stopwatch::Clock;
+  auto* memory_manager = &context.workResource();
   // Initialize parameters
+  auto start_time = Clock::now();
   zisc::pmr::vector<Parameters> parameters{memory_manager};
   parameters.reserve(num_of_scales_);
   for (uint scale = 0; scale < num_of_scales_; ++scale) {
-    parameters.emplace_back(system);
+    parameters.emplace_back(context);
     if (scale == 0)
-      parameters[scale].init(system, cycle, histogramBins(), *statistics);
+      parameters[scale].init(context, cycle, histogramBins(), region, *statistics);
     else
-      parameters[scale].downscaleOf(system, parameters[scale - 1]);
+      parameters[scale].downscaleOf(context, parameters[scale - 1]);
+  }
+  auto end_time = Clock::now();
+  context.addPhaseTime("Parameter initialization", end_time - start_time);
+  start_time = end_time;
+  prepare(context, &parameters);
+  if (cache_list != nullptr) {
+    for (uint scale = 0; scale < num_of_scales_; ++scale)
+      updateWarmStartCache(context, parameters[scale], cycle, &cache_list[scale]);
   }
-  prepare(system, &parameters);
+  end_time = Clock::now();
+  context.addPhaseTime("Parameter preparation", end_time - start_time);
 
   // Create staging variables
   zisc::pmr::vector<SpectraArray> staging_value_table{memory_manager};
@@ -600,7 +921,7 @@ void BayesianCollaborativeDenoiser<kDimension>::denoiseMultiscale(
   zisc::pmr::vector<int> estimates_counter{memory_manager};
   estimates_counter.resize(parameters[0].sample_value_table_.size());
 
-  PixelMarker pixel_marker{system};
+  PixelMarker pixel_marker{context, region.resolution_};
 
   // Denoise iteratively
   Parameters* parameter = nullptr;
@@ -612,33 +933,54 @@ void BayesianCollaborativeDenoiser<kDimension>::denoiseMultiscale(
     const uint scale = num_of_scales_ - (iteration + 1);
     parameter = &parameters[scale];
 
-    constexpr auto tile_order = getChunkTileOrder();
+    start_time = Clock::now();
     const Index2d chunk_resolution = getChunkResolution(parameter->resolution_);
-    for (uint tile_number = 0; tile_number < tile_order.size(); ++tile_number) {
-      const auto tile_position = tile_order[tile_number];
-      denoiseChunks(system, chunk_resolution, tile_position, parameter,
-                    &staging_value_table, &estimates_counter, &pixel_marker);
-      notifyProgress(iteration, tile_number);
+    auto* cache = (cache_list != nullptr) ? &cache_list[scale] : nullptr;
+    denoiseChunks(context, chunk_resolution, iteration, progress_range,
+                  parameter, cache,
+                  &staging_value_table, &estimates_counter, &pixel_marker);
+    end_time = Clock::now();
+    context.addPhaseTime("Patch denoising", end_time - start_time);
+    start_time = end_time;
+    aggregate(context, estimates_counter, parameter);
+    end_time = Clock::now();
+    context.addPhaseTime("Aggregation", end_time - start_time);
+    if (0 < iteration) {
+      start_time = end_time;
+      merge(context, &parameters[scale + 1], parameter, &staging_value_table);
+      end_time = Clock::now();
+      context.addPhaseTime("Scale merging", end_time - start_time);
     }
-    aggregate(system, estimates_counter, parameter);
-    if (0 < iteration)
-      merge(system, &parameters[scale + 1], parameter, &staging_value_table);
   }
-  aggregateFinal(system, *parameter, statistics);
-  notifyProgress(1.0);
+  start_time = Clock::now();
+  aggregateFinal(context, *parameter, region, statistics);
+  end_time = Clock::now();
+  context.addPhaseTime("Final aggregation", end_time - start_time);
 }
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::denoisePixels(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::denoisePixels(
     const Index2d& main_pixel,
     Parameters* parameter,
+    WarmStartCache* cache,
     zisc::pmr::vector<SpectraArray>* staging_value_table,
     zisc::pmr::vector<int>* estimates_counter,
     PixelMarker* pixel_marker) const noexcept
 {
-  const auto similar_mask = selectSimilarPatches(*parameter, main_pixel);
+  // Each main pixel is denoised by one thread, so the cache entry isn't shared
+  const uint pixel_index = main_pixel[0] + parameter->resolution_[0] * main_pixel[1];
+  const uint num_of_words = getNumOfMaskWords();
+  SimilarPatchMask similar_mask;
+  if ((cache != nullptr) && (cache->mask_state_table_[pixel_index] == kTrue)) {
+    similar_mask = cache->mask(pixel_index, num_of_words);
+  }
+  else {
+    similar_mask = selectSimilarPatches(*parameter, main_pixel);
+    if (cache != nullptr)
+      cache->setMask(pixel_index, num_of_words, similar_mask);
+  }
   const uint num_of_similar_patches = zisc::cast<uint>(similar_mask.count());
   if (getPatchDimension() < num_of_similar_patches) {
     denoiseSelectedPatches(main_pixel, similar_mask, parameter,
@@ -651,8 +993,8 @@ void BayesianCollaborativeDenoiser<kDimension>::denoisePixels(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::denoiseOnlyMainPatch(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::denoiseOnlyMainPatch(
     const Index2d& main_pixel,
     const SimilarPatchMask& similar_mask,
     Parameters* parameter,
@@ -679,7 +1021,7 @@ void BayesianCollaborativeDenoiser<kDimension>::denoiseOnlyMainPatch(
       }
       search_window.next();
     }
-    estimated_value *= zisc::invert(zisc::cast<Float>(similar_mask.count()));
+    estimated_value *= zisc::invert(zisc::cast<FloatType>(similar_mask.count()));
     // Calc estimated value
     {
       const Index2d dst_pixel{(main_pixel[0] + patch_offset[0]) - patch_radius_,
@@ -693,8 +1035,8 @@ void BayesianCollaborativeDenoiser<kDimension>::denoiseOnlyMainPatch(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::denoiseSelectedPatches(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::denoiseSelectedPatches(
     const Index2d& main_pixel,
     const SimilarPatchMask& similar_mask,
     Parameters* parameter,
@@ -760,8 +1102,8 @@ void BayesianCollaborativeDenoiser<kDimension>::denoiseSelectedPatches(
 
 /*!
   */
-template <uint kDimension>
-Index2d BayesianCollaborativeDenoiser<kDimension>::getChunkResolution(
+template <uint kDimension, typename FloatType>
+Index2d BayesianCollaborativeDenoiser<kDimension, FloatType>::getChunkResolution(
     Index2d resolution) const noexcept
 {
   resolution[0] = resolution[0] - 2 * patch_radius_;
@@ -778,8 +1120,8 @@ Index2d BayesianCollaborativeDenoiser<kDimension>::getChunkResolution(
 
 /*!
   */
-template <uint kDimension>
-uint BayesianCollaborativeDenoiser<kDimension>::getChunkSize() const noexcept
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getChunkSize() const noexcept
 {
   const uint size = 3 * search_radius_;
   return size;
@@ -787,8 +1129,8 @@ uint BayesianCollaborativeDenoiser<kDimension>::getChunkSize() const noexcept
 
 /*!
   */
-template <uint kDimension>
-uint BayesianCollaborativeDenoiser<kDimension>::getNumOfPatchPixels() const noexcept
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getNumOfPatchPixels() const noexcept
 {
   const uint size = zisc::power<2>(2 * patch_radius_ + 1);
   return size;
@@ -796,17 +1138,74 @@ uint BayesianCollaborativeDenoiser<kDimension>::getNumOfPatchPixels() const noex
 
 /*!
   */
-template <uint kDimension>
-uint BayesianCollaborativeDenoiser<kDimension>::getNumOfSearchWindowPixels() const noexcept
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getNumOfSearchWindowPixels() const noexcept
 {
   const uint max_num_of_patches = zisc::power<2>(2 * search_radius_ + 1);
   return max_num_of_patches;
 }
 
 /*!
+  \details
+  The patches of a pixel refer the pixels within the search radius and
+  twice the patch radius, and the merge interpolates the adjacent pixel
+  of the lower scale. The distance is doubled at each scale, so the halo is
+  aligned to the pixels of the lowest scale.
   */
-template <uint kDimension>
-uint BayesianCollaborativeDenoiser<kDimension>::getPatchDimension() const noexcept
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getRegionHaloSize() const noexcept
+{
+  const uint halo = (search_radius_ + 2 * patch_radius_ + 1) <<
+                    (num_of_scales_ - 1);
+  return halo;
+}
+
+/*!
+  \details
+  Zero is returned if the whole image is under the memory budget.
+  The size is aligned to the pixels of the lowest scale so that the regions
+  are downscaled on the same grid as the image.
+  If the budget is too small, the interior is at least as large as the halo.
+  */
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getRegionInteriorSize(
+    const Index2d& resolution) const noexcept
+{
+  using zisc::cast;
+
+  const std::size_t budget = memoryBudget();
+  if (budget == 0)
+    return 0;
+  // The tables of all scales are 4/3 of the tables of the first scale
+  const std::size_t scale_bytes = sizeof(SpectraArray) * (2 + 2 * histogram_bins_) +
+                                  sizeof(CovarianceFactors);
+  const std::size_t pixel_bytes = (4 * scale_bytes) / 3 +
+                                  sizeof(SpectraArray) + sizeof(int);
+  const std::size_t num_of_pixels = cast<std::size_t>(resolution[0]) * resolution[1];
+  if (num_of_pixels * pixel_bytes <= budget)
+    return 0;
+
+  const uint halo = getRegionHaloSize();
+  const uint region_size = cast<uint>(zisc::sqrt(cast<double>(budget / pixel_bytes)));
+  const uint alignment = 0b1u << (num_of_scales_ - 1);
+  uint interior_size = (region_size < 3 * halo) ? halo : region_size - 2 * halo;
+  interior_size = zisc::max(alignment, interior_size - (interior_size % alignment));
+  return interior_size;
+}
+
+/*!
+  */
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getNumOfMaskWords() const noexcept
+{
+  const uint num_of_words = (getNumOfSearchWindowPixels() + 63) / 64;
+  return num_of_words;
+}
+
+/*!
+  */
+template <uint kDimension, typename FloatType>
+uint BayesianCollaborativeDenoiser<kDimension, FloatType>::getPatchDimension() const noexcept
 {
   const uint d = dimension() * getNumOfPatchPixels();
   return d;
@@ -814,8 +1213,8 @@ uint BayesianCollaborativeDenoiser<kDimension>::getPatchDimension() const noexce
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::initialize(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::initialize(
     const SettingNodeBase* settings) noexcept
 {
   const auto system_settings = castNode<SystemSettingNode>(settings);
@@ -823,7 +1222,7 @@ void BayesianCollaborativeDenoiser<kDimension>::initialize(
   histogram_bins_ =
       zisc::cast<uint>(parameters.histogram_bins_);
   histogram_distance_threshold_ = 
-      zisc::cast<Float>(parameters.histogram_distance_threshold_);
+      zisc::cast<FloatType>(parameters.histogram_distance_threshold_);
   patch_radius_ =
       zisc::cast<uint>(parameters.patch_radius_);
   search_radius_ =
@@ -834,8 +1233,8 @@ void BayesianCollaborativeDenoiser<kDimension>::initialize(
 
 /*!
   */
-template <uint kDimension>
-RenderingTile BayesianCollaborativeDenoiser<kDimension>::makePatch(
+template <uint kDimension, typename FloatType>
+RenderingTile BayesianCollaborativeDenoiser<kDimension, FloatType>::makePatch(
     const Index2d& center_pixel) const noexcept
 {
   Index2d begin{center_pixel[0] - patch_radius_,
@@ -847,8 +1246,8 @@ RenderingTile BayesianCollaborativeDenoiser<kDimension>::makePatch(
 
 /*!
   */
-template <uint kDimension>
-RenderingTile BayesianCollaborativeDenoiser<kDimension>::makeSearchWindow(
+template <uint kDimension, typename FloatType>
+RenderingTile BayesianCollaborativeDenoiser<kDimension, FloatType>::makeSearchWindow(
     const Index2d& resolution,
     const Index2d& center_pixel) const noexcept
 {
@@ -863,8 +1262,8 @@ RenderingTile BayesianCollaborativeDenoiser<kDimension>::makeSearchWindow(
 
 /*!
   */
-template <uint kDimension>
-RenderingTile BayesianCollaborativeDenoiser<kDimension>::makeChunkTile(
+template <uint kDimension, typename FloatType>
+RenderingTile BayesianCollaborativeDenoiser<kDimension, FloatType>::makeChunkTile(
     const Index2d& resolution,
     const Index2d& chunk_position,
     const Index2d& tile_position) const noexcept
@@ -887,15 +1286,15 @@ RenderingTile BayesianCollaborativeDenoiser<kDimension>::makeChunkTile(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::merge(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::merge(
+    DenoisingContext& context,
     Parameters* low_res_p,
     Parameters* high_res_p,
     zisc::pmr::vector<SpectraArray>* staging_value_table) const noexcept
 {
-  auto& threads = system.threadManager();
-  auto& work_resource = system.globalMemoryManager();
+  auto& threads = context.threadManager();
+  auto& work_resource = context.workResource();
   constexpr uint start = 0;
   const uint end = threads.numOfThreads();
 
@@ -904,11 +1303,11 @@ void BayesianCollaborativeDenoiser<kDimension>::merge(
     (*staging_value_table)[i] = -(high_res_p->denoised_value_table_[i]);
 
   {
-    auto merge1 = [&system, low_res_p, high_res_p, staging_value_table]
+    auto merge1 = [&context, low_res_p, high_res_p, staging_value_table]
     (const uint task_id)
     {
       // Set the calculation range
-      auto range = system.calcTaskRange(
+      auto range = context.calcTaskRange(
           low_res_p->resolution_[0] * low_res_p->resolution_[1], task_id);
       Parameters::downscaleSum(
           high_res_p->resolution_, *staging_value_table,
@@ -919,7 +1318,7 @@ void BayesianCollaborativeDenoiser<kDimension>::merge(
         low_res_p->sample_value_table_[pixel_index] *= 0.25;
 
       // Set the calculation range
-      range = system.calcTaskRange(
+      range = context.calcTaskRange(
           high_res_p->resolution_[0] * high_res_p->resolution_[1], task_id);
       Parameters::upscaleAdd(
           low_res_p->resolution_, low_res_p->denoised_value_table_,
@@ -931,11 +1330,11 @@ void BayesianCollaborativeDenoiser<kDimension>::merge(
   }
 
   {
-    auto merge2 = [&system, low_res_p, high_res_p]
+    auto merge2 = [&context, low_res_p, high_res_p]
     (const uint task_id)
     {
       // Set the calculation range
-      const auto range = system.calcTaskRange(
+      const auto range = context.calcTaskRange(
           high_res_p->resolution_[0] * high_res_p->resolution_[1], task_id);
       Parameters::upscaleAdd(
           low_res_p->resolution_, low_res_p->sample_value_table_,
@@ -949,8 +1348,8 @@ void BayesianCollaborativeDenoiser<kDimension>::merge(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::notifyProgress(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::notifyProgress(
     const double progress) const noexcept
 {
   const auto& progress_callback = progressCallback();
@@ -960,8 +1359,9 @@ void BayesianCollaborativeDenoiser<kDimension>::notifyProgress(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::notifyProgress(
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::notifyProgress(
+    const std::array<double, 2>& progress_range,
     const uint iteration,
     const uint tile_number) const noexcept
 {
@@ -973,6 +1373,7 @@ void BayesianCollaborativeDenoiser<kDimension>::notifyProgress(
     const uint current = (0b1u << (2u * iteration)) * (t_max + 3 * t) - t_max;
     const uint total = t_max * ((0b1u << (2u * num_of_scales_)) - 1u);
     double progress = zisc::cast<double>(current) / zisc::cast<double>(total);
+    progress = progress_range[0] + (progress_range[1] - progress_range[0]) * progress;
     progress = zisc::clamp(progress, 0.0, 0.99);
 
     progress_callback(progress);
@@ -981,22 +1382,22 @@ void BayesianCollaborativeDenoiser<kDimension>::notifyProgress(
 
 /*!
   */
-template <uint kDimension>
-void BayesianCollaborativeDenoiser<kDimension>::prepare(
-    System& system,
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::prepare(
+    DenoisingContext& context,
     zisc::pmr::vector<Parameters>* parameters) const noexcept
 {
   using zisc::cast;
 
-  auto prepare_params = [&system, parameters](const uint task_id)
+  auto prepare_params = [&context, parameters](const uint task_id)
   {
     for (uint scale = 0; scale < parameters->size(); ++scale) {
       auto parameter = &(*parameters)[scale];
-      const auto range = system.calcTaskRange(
+      const auto range = context.calcTaskRange(
           parameter->resolution_[0] * parameter->resolution_[1], task_id);
 
-      const Float k = zisc::invert(cast<Float>(parameter->num_of_samples_));
-      const Float k1 = zisc::invert(cast<Float>(parameter->num_of_samples_ - 1));
+      const FloatType k = zisc::invert(cast<FloatType>(parameter->num_of_samples_));
+      const FloatType k1 = zisc::invert(cast<FloatType>(parameter->num_of_samples_ - 1));
       for (uint pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
         auto& sample_value = parameter->sample_value_table_[pixel_index];
         // Calculate covariance factors
@@ -1019,8 +1420,8 @@ void BayesianCollaborativeDenoiser<kDimension>::prepare(
   };
 
   {
-    auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
+    auto& threads = context.threadManager();
+    auto& work_resource = context.workResource();
     constexpr uint start = 0;
     const uint end = threads.numOfThreads();
     auto result = threads.enqueueLoop(prepare_params, start, end, &work_resource);
@@ -1030,8 +1431,8 @@ void BayesianCollaborativeDenoiser<kDimension>::prepare(
 
 /*!
   */
-template <uint kDimension>
-auto BayesianCollaborativeDenoiser<kDimension>::selectSimilarPatches(
+template <uint kDimension, typename FloatType>
+auto BayesianCollaborativeDenoiser<kDimension, FloatType>::selectSimilarPatches(
     const Parameters& parameter,
     const Index2d& main_pixel) const noexcept -> SimilarPatchMask
 {
@@ -1041,7 +1442,7 @@ auto BayesianCollaborativeDenoiser<kDimension>::selectSimilarPatches(
               "The search window size is greater than the mask size.");
   for (uint p = 0; p < search_window.numOfPixels(); ++p) {
     const auto& neighbor_pixel = search_window.current();
-    const Float d = (neighbor_pixel.data() != main_pixel.data())
+    const FloatType d = (neighbor_pixel.data() != main_pixel.data())
         ? calcHistogramPatchDistance(parameter, main_pixel, neighbor_pixel)
         : 0.0;
     if (d <= histogram_distance_threshold_) {
@@ -1054,8 +1455,8 @@ auto BayesianCollaborativeDenoiser<kDimension>::selectSimilarPatches(
 }
 /*!
   */
-template <uint kDimension>
-auto BayesianCollaborativeDenoiser<kDimension>::toMatrix(
+template <uint kDimension, typename FloatType>
+auto BayesianCollaborativeDenoiser<kDimension, FloatType>::toMatrix(
     const CovarianceFactors& factors) const noexcept -> CovarianceMatrix
 {
   CovarianceMatrix matrix;
@@ -1068,8 +1469,144 @@ auto BayesianCollaborativeDenoiser<kDimension>::toMatrix(
   return matrix;
 }
 
+/*!
+  \details
+  The signature of a pixel is the histogram which is summed over the dimensions
+  and normalized, quantized into 16 bits. A pixel is changed if the half of
+  the L1 distance from its signature exceeds the tolerance, then
+  the signature is updated. The mask of a pixel compares the patches of
+  the pixels in the search window, so the masks within the search radius
+  and the patch radius of a changed pixel are invalidated.
+  All masks are invalidated if the resolution changes or
+  the rendering is restarted.
+  */
+template <uint kDimension, typename FloatType>
+void BayesianCollaborativeDenoiser<kDimension, FloatType>::updateWarmStartCache(
+    DenoisingContext& context,
+    const Parameters& parameter,
+    const uint32 cycle,
+    WarmStartCache* cache) const noexcept
+{
+  using zisc::cast;
+
+  const auto& resolution = parameter.resolution_;
+  const uint num_of_pixels = resolution[0] * resolution[1];
+  const uint bins = parameter.histogram_bins_;
+  const bool is_reset = (cache->resolution_.data() != resolution.data()) ||
+                        (cycle < cache->cycle_) ||
+                        (cache->signature_table_.size() != bins * num_of_pixels);
+  if (is_reset) {
+    cache->resolution_ = resolution;
+    cache->signature_table_.resize(bins * num_of_pixels);
+    cache->mask_table_.resize(getNumOfMaskWords() * num_of_pixels);
+    cache->mask_state_table_.resize(num_of_pixels);
+  }
+  cache->cycle_ = cycle;
+
+  auto* work_resource = &context.workResource();
+  zisc::pmr::vector<uint8> changed_table{work_resource};
+  changed_table.resize(num_of_pixels);
+  zisc::pmr::vector<uint8> dilated_table{work_resource};
+  dilated_table.resize(num_of_pixels);
+
+  const FloatType max_signature = cast<FloatType>(std::numeric_limits<uint16>::max());
+  const int tolerance = cast<int>(2.0 * warmStartTolerance() * max_signature);
+  auto update_signatures = [&context, &parameter, cache, &changed_table,
+                            num_of_pixels, bins, is_reset, max_signature,
+                            tolerance](const uint task_id)
+  {
+    const auto range = context.calcTaskRange(num_of_pixels, task_id);
+    for (auto pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
+      FloatType total = 0.0;
+      for (uint b = 0; b < bins; ++b) {
+        const auto& h = parameter.histogram_table_[b * num_of_pixels + pixel_index];
+        for (uint si = 0; si < dimension(); ++si)
+          total += h[si];
+      }
+      const FloatType k = (0.0 < total) ? max_signature / total : 0.0;
+      uint16* signature = &cache->signature_table_[bins * pixel_index];
+      int change = 0;
+      for (uint b = 0; b < bins; ++b) {
+        const auto& h = parameter.histogram_table_[b * num_of_pixels + pixel_index];
+        FloatType sum = 0.0;
+        for (uint si = 0; si < dimension(); ++si)
+          sum += h[si];
+        const int value = cast<int>(k * sum + 0.5);
+        change += std::abs(value - cast<int>(signature[b]));
+      }
+      const bool is_changed = is_reset || (tolerance < change);
+      if (is_changed) {
+        for (uint b = 0; b < bins; ++b) {
+          const auto& h = parameter.histogram_table_[b * num_of_pixels + pixel_index];
+          FloatType sum = 0.0;
+          for (uint si = 0; si < dimension(); ++si)
+            sum += h[si];
+          signature[b] = cast<uint16>(k * sum + 0.5);
+        }
+      }
+      changed_table[pixel_index] = is_changed ? kTrue : kFalse;
+    }
+  };
+
+  const int radius = cast<int>(search_radius_ + patch_radius_);
+  auto dilate_rows = [&context, &changed_table, &dilated_table, &resolution,
+                      radius](const uint task_id)
+  {
+    const auto range = context.calcTaskRange(resolution[1], task_id);
+    const int width = cast<int>(resolution[0]);
+    for (auto y = range[0]; y < range[1]; ++y) {
+      const uint8* changed = &changed_table[resolution[0] * y];
+      uint8* dilated = &dilated_table[resolution[0] * y];
+      for (int x = 0; x < width; ++x) {
+        uint8 flag = kFalse;
+        const int end = zisc::min(width, x + radius + 1);
+        for (int i = zisc::max(0, x - radius); i < end; ++i) {
+          if (changed[i] == kTrue)
+            flag = kTrue;
+        }
+        dilated[x] = flag;
+      }
+    }
+  };
+
+  auto invalidate_masks = [&context, cache, &dilated_table, &resolution,
+                           num_of_pixels, radius](const uint task_id)
+  {
+    const auto range = context.calcTaskRange(num_of_pixels, task_id);
+    const int width = cast<int>(resolution[0]);
+    const int height = cast<int>(resolution[1]);
+    for (auto pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
+      const int x = cast<int>(pixel_index % resolution[0]);
+      const int y = cast<int>(pixel_index / resolution[0]);
+      const int end = zisc::min(height, y + radius + 1);
+      for (int i = zisc::max(0, y - radius); i < end; ++i) {
+        if (dilated_table[x + width * i] == kTrue)
+          cache->mask_state_table_[pixel_index] = kFalse;
+      }
+    }
+  };
+
+  auto& threads = context.threadManager();
+  constexpr uint start = 0;
+  const uint end = threads.numOfThreads();
+  {
+    auto result = threads.enqueueLoop(update_signatures, start, end, work_resource);
+    result.wait();
+  }
+  {
+    auto result = threads.enqueueLoop(dilate_rows, start, end, work_resource);
+    result.wait();
+  }
+  {
+    auto result = threads.enqueueLoop(invalidate_masks, start, end, work_resource);
+    result.wait();
+  }
+}
+
 // Instantiation
-template class BayesianCollaborativeDenoiser<3>;
-template class BayesianCollaborativeDenoiser<CoreConfig::spectraSize()>;
+template class BayesianCollaborativeDenoiser<3, Float>;
+template class BayesianCollaborativeDenoiser<CoreConfig::spectraSize(), Float>;
+template class BayesianCollaborativeDenoiser<3, float>;
+template class BayesianCollaborativeDenoiser<CoreConfig::spectraSize(), float>;
 
 } // namespace nanairo
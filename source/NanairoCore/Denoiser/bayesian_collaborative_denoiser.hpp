@@ -31,22 +31,27 @@ namespace nanairo {
 class SampleStatistics;
 class SpectralDistribution;
 class System;
+class DenoisingContext;
 
 /*!
+  \details
+  The denoising is calculated in FloatType.
+  The statistics are converted at the boundaries with SampleStatistics.
   */
-template <uint kDimension>
+template <uint kDimension, typename FloatType>
 class BayesianCollaborativeDenoiser : public Denoiser
 {
  public:
   //! Initialize a denoiser
-  BayesianCollaborativeDenoiser(const SettingNodeBase* settings) noexcept;
+  BayesianCollaborativeDenoiser(System& system,
+                                const SettingNodeBase* settings) noexcept;
 
 
   //! Return the dimension of denoised color
   static constexpr uint dimension() noexcept;
 
   //! Denoise input value
-  void denoise(System& system,
+  void denoise(DenoisingContext& context,
                const uint32 cycle,
                SampleStatistics* statistics) const noexcept override;
 
@@ -59,47 +64,65 @@ class BayesianCollaborativeDenoiser : public Denoiser
 
 
   using SimilarPatchMask = std::bitset<2048>;
-  using SpectraArray = zisc::ArithArray<Float, kDimension>;
-  using CovarianceFactors = zisc::ArithArray<Float,
+  using SpectraArray = zisc::ArithArray<FloatType, kDimension>;
+  using CovarianceFactors = zisc::ArithArray<FloatType,
                                              getCovarianceMatrixSize(kDimension)>;
-  using CovarianceMatrix = zisc::Matrix<Float, kDimension, kDimension>;
+  using CovarianceMatrix = zisc::Matrix<FloatType, kDimension, kDimension>;
+
+  /*!
+    \details
+    The interior is in the coordinates of the region.
+    */
+  struct ImageRegion
+  {
+    Index2d offset_; //!< The position of the region in the image
+    Index2d resolution_;
+    Index2d interior_begin_; //!< The beginning of the pixels which are output
+    Index2d interior_end_;
+  };
 
   struct Parameters
   {
     //! Set resource
-    Parameters(System& system) noexcept;
+    Parameters(DenoisingContext& context) noexcept;
 
     //! Calculate a upscaed parameter
     template <uint kN>
     static void upscaleAdd(
         const Index2d& low_res,
-        const zisc::pmr::vector<zisc::ArithArray<Float, kN>>& low_res_table,
+        const zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>& low_res_table,
         const Index2d& high_res,
-        zisc::pmr::vector<zisc::ArithArray<Float, kN>>* high_res_table,
+        zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>* high_res_table,
         const Index2d& range) noexcept;
 
     //! Calculate a downscaled parameter
     template <uint kN>
     static void downscaleSum(
         const Index2d& high_res,
-        const zisc::pmr::vector<zisc::ArithArray<Float, kN>>& high_res_table,
+        const zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>& high_res_table,
         const Index2d& low_res,
-        zisc::pmr::vector<zisc::ArithArray<Float, kN>>* low_res_table,
+        zisc::pmr::vector<zisc::ArithArray<FloatType, kN>>* low_res_table,
         const Index2d& range,
         const uint table_offset = 0) noexcept;
 
     //! Downscale the resolutions of parameters
-    void downscaleOf(System& system,
+    void downscaleOf(DenoisingContext& context,
                      const Parameters& high_res_p) noexcept;
 
     //! Initialize parameters
-    void init(System& system,
+    void init(DenoisingContext& context,
               const uint32 cycle,
               const uint histogram_bins,
+              const ImageRegion& region,
               const SampleStatistics& statistics) noexcept;
 
+    //! Copy the histograms of the pixel range into the histogram planes
+    void makeHistogramPlanes(const Index2d& range) noexcept;
+
     zisc::pmr::vector<SpectraArray> sample_value_table_;
     zisc::pmr::vector<SpectraArray> histogram_table_;
+    //! The histograms in SoA, a plane per bin and dimension
+    zisc::pmr::vector<FloatType> histogram_plane_table_;
     zisc::pmr::vector<CovarianceFactors> covariance_factor_table_;
     zisc::pmr::vector<SpectraArray> denoised_value_table_;
     Index2d resolution_;
@@ -113,7 +136,7 @@ class BayesianCollaborativeDenoiser : public Denoiser
     using Marker = std::bitset<(1 << kMarkerRepBits)>;
 
     //! Initialize a marker
-    PixelMarker(System& system) noexcept;
+    PixelMarker(DenoisingContext& context, const Index2d& resolution) noexcept;
     //! Clear mark flags
     void clear() noexcept;
     //! Check if a pixel is marked
@@ -124,25 +147,51 @@ class BayesianCollaborativeDenoiser : public Denoiser
     zisc::pmr::vector<Marker> marker_table_;
   };
 
+  /*!
+    \details
+    The similar patch masks of a scale are kept for the next denoising.
+    A mask is reused while the histograms which it depends on don't change
+    over the tolerance.
+    */
+  struct WarmStartCache
+  {
+    //! Set resource
+    WarmStartCache(zisc::pmr::memory_resource* resource) noexcept;
+    //! Return the cached mask of a pixel
+    SimilarPatchMask mask(const uint index, const uint num_of_words) const noexcept;
+    //! Cache the mask of a pixel
+    void setMask(const uint index,
+                 const uint num_of_words,
+                 const SimilarPatchMask& mask) noexcept;
+
+    //! The normalized histograms when the masks were selected, [pixel][bin]
+    zisc::pmr::vector<uint16> signature_table_;
+    zisc::pmr::vector<uint64> mask_table_; //!< [pixel][word]
+    zisc::pmr::vector<uint8> mask_state_table_; //!< The mask is valid if kTrue
+    Index2d resolution_;
+    uint32 cycle_;
+  };
+
 
   //! Aggregate denoised values
-  void aggregate(System& system,
+  void aggregate(DenoisingContext& context,
                  const zisc::pmr::vector<int>& estimates_counter,
                  Parameters* parameter) const noexcept;
 
   //! Aggregate denoised values
-  void aggregateFinal(System& system,
+  void aggregateFinal(DenoisingContext& context,
                       const Parameters& parameter,
+                      const ImageRegion& region,
                       SampleStatistics* statistics) const noexcept;
 
   //! Calculate an enpirical mean
   template <uint kN>
-  zisc::ArithArray<Float, kN> calcEmpiricalMean(
+  zisc::ArithArray<FloatType, kN> calcEmpiricalMean(
       const Index2d& resolution,
       RenderingTile& search_window,
       const Index2d& patch_offset,
       const SimilarPatchMask& similar_mask,
-      const zisc::ArithArray<Float, kN>* table) const noexcept;
+      const zisc::ArithArray<FloatType, kN>* table) const noexcept;
 
   //! Calculate an enpirical covariance matrix
   CovarianceFactors calcEmpiricalCovarianceMatrix(
@@ -153,6 +202,11 @@ class BayesianCollaborativeDenoiser : public Denoiser
       const zisc::pmr::vector<SpectraArray>& value_table,
       const SpectraArray& value_mean) const noexcept;
 
+  //! Calculate the matrix which maps the deviation of a value to its noise
+  static CovarianceMatrix calcDenoisingMatrix(
+      const CovarianceMatrix& covariance_mean,
+      const CovarianceMatrix& expected_covariance) noexcept;
+
   //! Calculate staging denoised values
   void calcStagingDenoisedValue(
       const Index2d& resolution,
@@ -165,35 +219,41 @@ class BayesianCollaborativeDenoiser : public Denoiser
       const zisc::pmr::vector<SpectraArray>& value_table,
       zisc::pmr::vector<SpectraArray>* staging_value_table) const noexcept;
 
-  //! Calculate a distance of 2 histograms
-  Float calcHistogramDistance(
-      const SpectraArray& histogram_lhs,
-      const SpectraArray& histogram_rhs,
-      uint* num_of_non_both0) const noexcept;
+  //! Calculate a distance of 2 rows of histogram planes
+  static FloatType calcHistogramDistance(const FloatType* histogram_lhs,
+                                         const FloatType* histogram_rhs,
+                                         const uint size,
+                                         uint* num_of_non_both0) noexcept;
 
   //! Calculate a histogram patch distance of 2 patches
-  Float calcHistogramPatchDistance(
+  FloatType calcHistogramPatchDistance(
       const Parameters& parameter,
       const Index2d& center_pixel_lhs,
       const Index2d& center_pixel_rhs) const noexcept;
 
-  //! Denoise a chunk
-  void denoiseChunks(System& system,
+  //! Denoise the tiles of all chunks in the order of the dependencies
+  void denoiseChunks(DenoisingContext& context,
                      const Index2d& chunk_resolution,
-                     const Index2d& tile_position,
+                     const uint iteration,
+                     const std::array<double, 2>& progress_range,
                      Parameters* parameter,
+                     WarmStartCache* cache,
                      zisc::pmr::vector<SpectraArray>* staging_value_table,
                      zisc::pmr::vector<int>* estimates_counter,
                      PixelMarker* pixel_marker) const noexcept;
 
   //! Denoise input value
-  void denoiseMultiscale(System& system,
+  void denoiseMultiscale(DenoisingContext& context,
                          const uint32 cycle,
+                         const ImageRegion& region,
+                         WarmStartCache* cache_list,
+                         const std::array<double, 2>& progress_range,
                          SampleStatistics* statistics) const noexcept;
 
   //! Denoise input value
   void denoisePixels(const Index2d& main_pixel,
                      Parameters* parameter,
+                     WarmStartCache* cache,
                      zisc::pmr::vector<SpectraArray>* staging_value_table,
                      zisc::pmr::vector<int>* estimates_counter,
                      PixelMarker* pixel_marker) const noexcept;
@@ -225,9 +285,18 @@ class BayesianCollaborativeDenoiser : public Denoiser
   //! Return the number of pixels in a search window
   uint getNumOfSearchWindowPixels() const noexcept;
 
+  //! Return the number of words of a cached mask
+  uint getNumOfMaskWords() const noexcept;
+
   //! Return the color patch dimension
   uint getPatchDimension() const noexcept;
 
+  //! Return the size of the halo of a region
+  uint getRegionHaloSize() const noexcept;
+
+  //! Return the size of the interior of a region under the memory budget
+  uint getRegionInteriorSize(const Index2d& resolution) const noexcept;
+
   //! Return the order of chunk tiles
   static constexpr std::array<Index2d, 9> getChunkTileOrder() noexcept;
 
@@ -248,7 +317,7 @@ class BayesianCollaborativeDenoiser : public Denoiser
 
   //! Merge a low and a high resolution buffers
   void merge(
-      System& system,
+      DenoisingContext& context,
       Parameters* low_res_p,
       Parameters* high_res_p,
       zisc::pmr::vector<SpectraArray>* staging_value_table) const noexcept;
@@ -256,11 +325,13 @@ class BayesianCollaborativeDenoiser : public Denoiser
   //! Notify the denoising progress
   void notifyProgress(const double progress) const noexcept;
 
-  //! Notify the denoising progress
-  void notifyProgress(const uint iteration, const uint tile_number) const noexcept;
+  //! Notify the denoising progress of the region in the progress range
+  void notifyProgress(const std::array<double, 2>& progress_range,
+                      const uint iteration,
+                      const uint tile_number) const noexcept;
 
   //! Compute parameters for denoising
-  void prepare(System& system,
+  void prepare(DenoisingContext& context,
                zisc::pmr::vector<Parameters>* parameters) const noexcept;
 
   //! Select similar patches
@@ -271,17 +342,31 @@ class BayesianCollaborativeDenoiser : public Denoiser
   //! Convert to a matrix
   CovarianceMatrix toMatrix(const CovarianceFactors& factors)const noexcept;
 
+  //! Invalidate the cached masks which depend on the changed histograms
+  void updateWarmStartCache(DenoisingContext& context,
+                            const Parameters& parameter,
+                            const uint32 cycle,
+                            WarmStartCache* cache) const noexcept;
+
+  //! Return the moved mass of a normalized histogram which invalidates masks
+  static constexpr FloatType warmStartTolerance() noexcept;
+
 
-  Float histogram_distance_threshold_ = 0.75;
+  FloatType histogram_distance_threshold_ = 0.75;
   uint histogram_bins_ = 16;
   uint patch_radius_ = 1;
   uint search_radius_ = 3;
   uint num_of_scales_ = 2;
+  mutable zisc::pmr::vector<WarmStartCache> cache_list_; //!< Per scale
 };
 
 // Type aliases
-using RgbBcDenoiser = BayesianCollaborativeDenoiser<3>;
-using SpectraBcDenoiser = BayesianCollaborativeDenoiser<CoreConfig::spectraSize()>;
+using RgbBcDenoiser = BayesianCollaborativeDenoiser<3, Float>;
+using SpectraBcDenoiser = BayesianCollaborativeDenoiser<CoreConfig::spectraSize(),
+                                                        Float>;
+using RgbFloatBcDenoiser = BayesianCollaborativeDenoiser<3, float>;
+using SpectraFloatBcDenoiser =
+    BayesianCollaborativeDenoiser<CoreConfig::spectraSize(), float>;
 
 } // namespace nanairo
 
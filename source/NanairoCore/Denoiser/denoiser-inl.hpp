@@ -11,6 +11,8 @@
 #define NANAIRO_DENOISER_INL_HPP
 
 #include "denoiser.hpp"
+// Standard C++ library
+#include <cstddef>
 // Zisc
 #include "zisc/function_reference.hpp"
 // Nanairo
@@ -18,6 +20,14 @@
 
 namespace nanairo {
 
+/*!
+  */
+inline
+std::size_t Denoiser::memoryBudget() const noexcept
+{
+  return memory_budget_;
+}
+
 /*!
   */
 inline
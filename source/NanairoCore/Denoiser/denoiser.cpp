@@ -8,6 +8,8 @@
   */
 
 #include "denoiser.hpp"
+// Standard C++ library
+#include <cstddef>
 // Zisc
 #include "zisc/error.hpp"
 #include "zisc/function_reference.hpp"
@@ -15,6 +17,7 @@
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "atrous_wavelet_denoiser.hpp"
 #include "bayesian_collaborative_denoiser.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Sampling/sample_statistics.hpp"
@@ -25,7 +28,8 @@ namespace nanairo {
 
 /*!
   */
-Denoiser::Denoiser(const SettingNodeBase* settings) noexcept
+Denoiser::Denoiser(const SettingNodeBase* settings) noexcept :
+    memory_budget_{0}
 {
   initialize(settings);
 }
@@ -57,14 +61,38 @@ zisc::UniqueMemoryPointer<Denoiser> Denoiser::makeDenoiser(
   zisc::UniqueMemoryPointer<Denoiser> denoiser;
   auto data_resource = &system.dataMemoryManager();
   switch (system_settings->denoiserType()) {
+   case DenoiserType::kAtrousWavelet: {
+    denoiser = zisc::UniqueMemoryPointer<AtrousWaveletDenoiser>::make(data_resource,
+                                                                      system,
+                                                                      settings);
+    pos = zisc::cast<std::size_t>(SampleStatistics::Type::kVariance);
+    statistics_flag.set(pos, true);
+    pos = zisc::cast<std::size_t>(SampleStatistics::Type::kFirstHitFeatures);
+    statistics_flag.set(pos, true);
+    break;
+   }
    case DenoiserType::kBayesianCollaborative: {
+    const auto& parameters = system_settings->bayesianCollaborativeDenoiserParameters();
+    const bool is_single_precision = parameters.single_precision_ == kTrue;
     if (system.colorMode() == RenderingColorMode::kRgb) {
-      denoiser = zisc::UniqueMemoryPointer<RgbBcDenoiser>::make(data_resource,
-                                                                settings);
+      if (is_single_precision)
+        denoiser = zisc::UniqueMemoryPointer<RgbFloatBcDenoiser>::make(data_resource,
+                                                                       system,
+                                                                       settings);
+      else
+        denoiser = zisc::UniqueMemoryPointer<RgbBcDenoiser>::make(data_resource,
+                                                                  system,
+                                                                  settings);
     }
     else {
-      denoiser = zisc::UniqueMemoryPointer<SpectraBcDenoiser>::make(data_resource,
-                                                                    settings);
+      if (is_single_precision)
+        denoiser = zisc::UniqueMemoryPointer<SpectraFloatBcDenoiser>::make(data_resource,
+                                                                           system,
+                                                                           settings);
+      else
+        denoiser = zisc::UniqueMemoryPointer<SpectraBcDenoiser>::make(data_resource,
+                                                                      system,
+                                                                      settings);
     }
     pos = zisc::cast<std::size_t>(SampleStatistics::Type::kVariance);
     statistics_flag.set(pos, true);
@@ -79,6 +107,16 @@ zisc::UniqueMemoryPointer<Denoiser> Denoiser::makeDenoiser(
   return denoiser;
 }
 
+/*!
+  \details
+  A denoiser which supports the budget splits a large image into tiles
+  so that the work memory of a tile is under the budget.
+  */
+void Denoiser::setMemoryBudget(const std::size_t budget) noexcept
+{
+  memory_budget_ = budget;
+}
+
 /*!
   */
 void Denoiser::setProgressCallback(
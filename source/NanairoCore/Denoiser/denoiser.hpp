@@ -10,6 +10,8 @@
 #ifndef NANAIRO_DENOISER_HPP
 #define NANAIRO_DENOISER_HPP
 
+// Standard C++ library
+#include <cstddef>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/fnv_1a_hash_engine.hpp"
@@ -22,6 +24,7 @@
 namespace nanairo {
 
 // Forward declaration
+class DenoisingContext;
 class SampleStatistics;
 class System;
 
@@ -32,6 +35,7 @@ class System;
   */
 enum class DenoiserType : uint32
 {
+  kAtrousWavelet              = zisc::Fnv1aHash32::hash("AtrousWavelet"),
   kBayesianCollaborative      = zisc::Fnv1aHash32::hash("BayesianCollaborative"),
 };
 
@@ -47,8 +51,8 @@ class Denoiser
   virtual ~Denoiser() noexcept;
 
 
-  //! Denoise input value
-  virtual void denoise(System& system,
+  //! Denoise input value on the threads of the context
+  virtual void denoise(DenoisingContext& context,
                        const uint32 cycle,
                        SampleStatistics* statistics) const noexcept = 0;
 
@@ -57,11 +61,17 @@ class Denoiser
       System& system,
       const SettingNodeBase* settings) noexcept;
 
+  //! Set the bytes of the work memory which a denoising can use, 0 is unbounded
+  void setMemoryBudget(const std::size_t budget) noexcept;
+
   //! Set a progress callback
   void setProgressCallback(const zisc::FunctionReference<void (double)>& callback)
       noexcept;
 
  protected:
+  //! Return the bytes of the work memory which a denoising can use
+  std::size_t memoryBudget() const noexcept;
+
   //! Return a progress callback
   const zisc::FunctionReference<void (double)>& progressCallback() const noexcept;
 
@@ -71,6 +81,7 @@ class Denoiser
 
 
   zisc::FunctionReference<void (double)> progress_callback_;
+  std::size_t memory_budget_;
 };
 
 //! \}
@@ -0,0 +1,96 @@
+/*!
+  \file denoising_context-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_DENOISING_CONTEXT_INL_HPP
+#define NANAIRO_DENOISING_CONTEXT_INL_HPP
+
+#include "denoising_context.hpp"
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <typename Integer> inline
+std::array<Integer, 2> DenoisingContext::calcTaskRange(
+    const Integer range,
+    const uint task_id) const noexcept
+{
+  return System::calcTaskRange(range, threadManager().numOfThreads(), task_id);
+}
+
+/*!
+  */
+inline
+const Index2d& DenoisingContext::imageResolution() const noexcept
+{
+  return system_->imageResolution();
+}
+
+/*!
+  */
+inline
+const zisc::pmr::vector<DenoisingPhase>& DenoisingContext::phaseList()
+    const noexcept
+{
+  return phase_list_;
+}
+
+/*!
+  */
+inline
+System& DenoisingContext::system() noexcept
+{
+  return *system_;
+}
+
+/*!
+  */
+inline
+TaskScheduler& DenoisingContext::taskScheduler() noexcept
+{
+  return *task_scheduler_;
+}
+
+/*!
+  */
+inline
+zisc::ThreadManager& DenoisingContext::threadManager() noexcept
+{
+  return *thread_manager_;
+}
+
+/*!
+  */
+inline
+const zisc::ThreadManager& DenoisingContext::threadManager() const noexcept
+{
+  return *thread_manager_;
+}
+
+/*!
+  */
+inline
+zisc::pmr::memory_resource& DenoisingContext::workResource() noexcept
+{
+  return *work_resource_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_DENOISING_CONTEXT_INL_HPP
@@ -0,0 +1,81 @@
+/*!
+  \file denoising_context.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "denoising_context.hpp"
+// Standard C++ library
+#include <string_view>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
+#include "zisc/thread_manager.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The work memory is the global memory of the system,
+  so the denoising has to finish before the work memory is cleared.
+  */
+DenoisingContext::DenoisingContext(System& system) noexcept :
+    system_{&system},
+    thread_manager_{&system.threadManager()},
+    task_scheduler_{&system.taskScheduler()},
+    work_resource_{&system.globalMemoryManager()},
+    phase_list_{work_resource_}
+{
+}
+
+/*!
+  */
+DenoisingContext::DenoisingContext(
+    System& system,
+    zisc::ThreadManager* thread_manager,
+    TaskScheduler* task_scheduler,
+    zisc::pmr::memory_resource* work_resource) noexcept :
+        system_{&system},
+        thread_manager_{thread_manager},
+        task_scheduler_{task_scheduler},
+        work_resource_{work_resource},
+        phase_list_{work_resource_}
+{
+  ZISC_ASSERT(thread_manager_ != nullptr, "The thread manager is null.");
+  ZISC_ASSERT(task_scheduler_ != nullptr, "The task scheduler is null.");
+  ZISC_ASSERT(work_resource_ != nullptr, "The work resource is null.");
+}
+
+/*!
+  \details
+  The phases are added as soon as they finish, so the phase is also traced
+  as the event which ends now.
+  */
+void DenoisingContext::addPhaseTime(
+    const char* name,
+    const zisc::Stopwatch::Clock::duration time) noexcept
+{
+  auto& recorder = system().traceRecorder();
+  if (recorder.isEnabled()) {
+    const auto end_time = zisc::Stopwatch::Clock::now();
+    recorder.addEvent(name, end_time - time, end_time);
+  }
+  for (auto& phase : phase_list_) {
+    if (std::string_view{phase.name_} == name) {
+      phase.time_ += time;
+      return;
+    }
+  }
+  phase_list_.emplace_back(DenoisingPhase{name, time});
+}
+
+} // namespace nanairo
@@ -0,0 +1,104 @@
+/*!
+  \file denoising_context.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_DENOISING_CONTEXT_HPP
+#define NANAIRO_DENOISING_CONTEXT_HPP
+
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
+#include "zisc/thread_manager.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class System;
+class TaskScheduler;
+
+//! \addtogroup Core
+//! \{
+
+//! The elapsed time of a phase of a denoising
+struct DenoisingPhase
+{
+  const char* name_;
+  zisc::Stopwatch::Clock::duration time_;
+};
+
+/*!
+  \brief The threads and the work memory which a denoising runs on
+  \details
+  A denoising runs on the system threads by default. A context which has
+  its own threads and memory runs a denoising while the system threads
+  continue the rendering.
+  The denoisers record the time of their phases into the context,
+  so the callers can measure a denoising without knowing its stages.
+  */
+class DenoisingContext
+{
+ public:
+  //! Create a context which runs on the system threads
+  DenoisingContext(System& system) noexcept;
+
+  //! Create a context which runs on the specified threads
+  DenoisingContext(System& system,
+                   zisc::ThreadManager* thread_manager,
+                   TaskScheduler* task_scheduler,
+                   zisc::pmr::memory_resource* work_resource) noexcept;
+
+
+  //! Add the time to the phase, the phase is appended if it isn't recorded
+  void addPhaseTime(const char* name,
+                    const zisc::Stopwatch::Clock::duration time) noexcept;
+
+  //! Calculate the range of indices of the task
+  template <typename Integer>
+  std::array<Integer, 2> calcTaskRange(const Integer range,
+                                       const uint task_id) const noexcept;
+
+  //! Return the image resolution
+  const Index2d& imageResolution() const noexcept;
+
+  //! Return the phases of the denoising in the order they are recorded
+  const zisc::pmr::vector<DenoisingPhase>& phaseList() const noexcept;
+
+  //! Return the system
+  System& system() noexcept;
+
+  //! Return the task scheduler
+  TaskScheduler& taskScheduler() noexcept;
+
+  //! Return the thread manager
+  zisc::ThreadManager& threadManager() noexcept;
+
+  //! Return the thread manager
+  const zisc::ThreadManager& threadManager() const noexcept;
+
+  //! Return the work memory resource
+  zisc::pmr::memory_resource& workResource() noexcept;
+
+ private:
+  System* system_;
+  zisc::ThreadManager* thread_manager_;
+  TaskScheduler* task_scheduler_;
+  zisc::pmr::memory_resource* work_resource_;
+  zisc::pmr::vector<DenoisingPhase> phase_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "denoising_context-inl.hpp"
+
+#endif // NANAIRO_DENOISING_CONTEXT_HPP
@@ -10,19 +10,23 @@
 #include "transformation.hpp"
 // Standard C++ library
 #include <cmath>
+#include <cstddef>
 #include <utility>
 #include <vector>
 // Zisc
 #include "zisc/algorithm.hpp"
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/matrix.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/unit.hpp"
 // Nanairo
 #include "point.hpp"
 #include "vector.hpp"
+#include "NanairoCore/system.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Setting/transformation_setting_node.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
@@ -139,6 +143,55 @@ void Transformation::affineTransform(const Matrix4x4& matrix,
   *point = takePoint3(new_point);
 }
 
+/*!
+  \details
+  The buffer is split into chunks which are the tasks of the fork-join
+  scheduler, so it can be called from a task without blocking a thread.
+  The rows of the matrix are loaded once per chunk and the loop of a chunk
+  has no branches, so the compiler can vectorize it.
+  The last row of an affine transformation is (0, 0, 0, 1),
+  so w isn't calculated.
+  */
+void Transformation::affineTransform(System& system,
+                                     const Matrix4x4& matrix,
+                                     zisc::pmr::vector<Point3>* point_list) noexcept
+{
+  ZISC_ASSERT(point_list != nullptr, "The point list is null.");
+  const Float m00 = matrix(0, 0), m01 = matrix(0, 1), m02 = matrix(0, 2),
+              m03 = matrix(0, 3);
+  const Float m10 = matrix(1, 0), m11 = matrix(1, 1), m12 = matrix(1, 2),
+              m13 = matrix(1, 3);
+  const Float m20 = matrix(2, 0), m21 = matrix(2, 1), m22 = matrix(2, 2),
+              m23 = matrix(2, 3);
+  auto transform_points =
+  [point_list, m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23]
+  (const std::size_t begin, const std::size_t end)
+  {
+    auto points = point_list->data();
+    for (std::size_t i = begin; i < end; ++i) {
+      const Float x = points[i][0],
+                  y = points[i][1],
+                  z = points[i][2];
+      points[i][0] = m00 * x + m01 * y + m02 * z + m03;
+      points[i][1] = m10 * x + m11 * y + m12 * z + m13;
+      points[i][2] = m20 * x + m21 * y + m22 * z + m23;
+    }
+  };
+
+  constexpr std::size_t chunk_size = 1u << 14;
+  const std::size_t size = point_list->size();
+  if (size <= chunk_size) {
+    transform_points(0, size);
+    return;
+  }
+  TaskGroup group{system.taskScheduler()};
+  for (std::size_t begin = 0; begin < size; begin += chunk_size) {
+    const std::size_t end = zisc::min(begin + chunk_size, size);
+    group.run([&transform_points, begin, end]() {transform_points(begin, end);});
+  }
+  group.wait();
+}
+
 /*!
   \details
   Please see the details of this algoriths below URL.
@@ -153,4 +206,34 @@ void Transformation::affineTransform(const Matrix4x4& matrix,
   *vector = normal_matrix * (*vector);
 }
 
+/*!
+  \details
+  The upper left 3x3 matrix is inverted by the cofactors,
+  then the translation is inverted by the 3x3 inverse matrix.
+  */
+Matrix4x4 Transformation::invertAffine(const Matrix4x4& matrix) noexcept
+{
+  const auto& m = matrix;
+  const Float c00 = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1);
+  const Float c01 = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2);
+  const Float c02 = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+  const Float determinant = m(0, 0) * c00 + m(0, 1) * c01 + m(0, 2) * c02;
+  ZISC_ASSERT(determinant != 0.0, "The matrix isn't invertible.");
+  const Float k = zisc::invert(determinant);
+
+  const Matrix3x3 inv{
+      k * c00, k * (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)),
+               k * (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)),
+      k * c01, k * (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)),
+               k * (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)),
+      k * c02, k * (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)),
+               k * (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0))};
+  const Vector3 translation{m(0, 3), m(1, 3), m(2, 3)};
+  const Vector3 t = -(inv * translation);
+  return Matrix4x4{inv(0, 0), inv(0, 1), inv(0, 2), t[0],
+                   inv(1, 0), inv(1, 1), inv(1, 2), t[1],
+                   inv(2, 0), inv(2, 1), inv(2, 2), t[2],
+                         0.0,       0.0,       0.0,  1.0};
+}
+
 } // namespace nanairo
@@ -23,6 +23,9 @@
 
 namespace nanairo {
 
+// Forward declaration
+class System;
+
 //! \addtogroup Core
 //! \{
 
@@ -98,9 +101,17 @@ class Transformation
   //! Make z axis rotation matrix
   static Matrix4x4 makeZAxisRotation(const Float theta) noexcept;
 
+  //! Calculate the inverse matrix of an affine transformation
+  static Matrix4x4 invertAffine(const Matrix4x4& matrix) noexcept;
+
   //! Apply affine transformation to a point
   static void affineTransform(const Matrix4x4& matrix, Point3* point) noexcept;
 
+  //! Apply affine transformation to the points of a buffer in parallel
+  static void affineTransform(System& system,
+                              const Matrix4x4& matrix,
+                              zisc::pmr::vector<Point3>* point_list) noexcept;
+
   //! Apply affine transformation to a vector
   static void affineTransform(const Matrix4x4& matrix, Vector3* vector) noexcept;
 };
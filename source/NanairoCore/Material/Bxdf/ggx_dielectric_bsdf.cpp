@@ -35,10 +35,12 @@ namespace nanairo {
 GgxDielectricBsdf::GgxDielectricBsdf(
     const Float roughness_x,
     const Float roughness_y,
-    const Float n) noexcept :
+    const Float n,
+    const bool is_dispersive) noexcept :
         roughness_x_{roughness_x},
         roughness_y_{roughness_y},
-        n_{n}
+        n_{n},
+        is_dispersive_{is_dispersive ? kTrue : kFalse}
 {
 }
 
@@ -143,7 +145,7 @@ SampledSpectra GgxDielectricBsdf::evalRadiance(
     const Float f = (is_reflection)
         ? MicrofacetGgx::evalReflectance(roughness_x_, roughness_y_, vin_d, vout_d, m_normal, fresnel)
         : MicrofacetGgx::evalTransmittance(roughness_x_, roughness_y_, vin_d, vout_d, m_normal, n_, fresnel);
-    radiance.setIntensity(wavelengths.primaryWavelengthIndex(), f);
+    radiance = makeSpectra(wavelengths, f);
   }
 
   return radiance;
@@ -199,7 +201,7 @@ std::tuple<SampledSpectra, Float> GgxDielectricBsdf::evalRadianceAndPdf(
     const Float f = (is_reflection)
         ? MicrofacetGgx::evalReflectance(roughness_x_, roughness_y_, vin_d, vout_d, m_normal, fresnel, &pdf)
         : MicrofacetGgx::evalTransmittance(roughness_x_, roughness_y_, vin_d, vout_d, m_normal, n_, fresnel, &pdf);
-    radiance.setIntensity(wavelengths.primaryWavelengthIndex(), f);
+    radiance = makeSpectra(wavelengths, f);
 
     // Evaluate the pdf
     pdf = (is_reflection) ? fresnel * pdf : (1.0 - fresnel) * pdf;
@@ -273,7 +275,7 @@ std::tuple<SampledDirection, SampledSpectra> GgxDielectricBsdf::sample(
                                               vout.direction(),
                                               m_normal.direction());
     ZISC_ASSERT(0.0 <= w, "The weight is negative.");
-    weight.setIntensity(wavelengths.primaryWavelengthIndex(), w);
+    weight = makeSpectra(wavelengths, w);
 
     // Update the pdf of the outgoing direction
     vout.setInversePdf((is_reflection)
@@ -301,7 +303,23 @@ std::tuple<SampledDirection, SampledSpectra> GgxDielectricBsdf::sample(
   */
 bool GgxDielectricBsdf::wavelengthIsSelected() const noexcept
 {
-  return true;
+  return is_dispersive_ == kTrue;
+}
+
+/*!
+  \details
+  A dispersive BSDF scatters only the primary wavelength,
+  and a non-dispersive BSDF scatters all wavelengths by the same value.
+  */
+inline
+SampledSpectra GgxDielectricBsdf::makeSpectra(
+    const WavelengthSamples& wavelengths,
+    const Float value) const noexcept
+{
+  SampledSpectra spectra{wavelengths, (is_dispersive_ == kTrue) ? 0.0 : value};
+  if (is_dispersive_ == kTrue)
+    spectra.setIntensity(wavelengths.primaryWavelengthIndex(), value);
+  return spectra;
 }
 
 } // namespace nanairo
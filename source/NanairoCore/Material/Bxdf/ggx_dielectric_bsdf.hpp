@@ -40,7 +40,8 @@ class GgxDielectricBsdf : public GlossyShaderModel
   //! Create a GGX dielectric BSDF
   GgxDielectricBsdf(const Float roughness_x,
                     const Float roughness_y,
-                    const Float n) noexcept;
+                    const Float n,
+                    const bool is_dispersive) noexcept;
 
 
   //! Evaluate the pdf
@@ -81,9 +82,15 @@ class GgxDielectricBsdf : public GlossyShaderModel
   bool wavelengthIsSelected() const noexcept override;
 
  private:
+  //! Make spectra of the value of the wavelengths which the BSDF scatters
+  SampledSpectra makeSpectra(const WavelengthSamples& wavelengths,
+                             const Float value) const noexcept;
+
+
   const Float roughness_x_,
               roughness_y_;
   const Float n_;
+  const uint8 is_dispersive_;
 };
 
 //! \} Core
@@ -37,6 +37,7 @@ InterfacedLambertianBrdf::InterfacedLambertianBrdf(
     const Float roughness_x,
     const Float roughness_y,
     const Float n,
+    const Float re,
     Sampler& sampler,
     const PathState& path_state) noexcept :
         sampler_{&sampler},
@@ -45,7 +46,7 @@ InterfacedLambertianBrdf::InterfacedLambertianBrdf(
         roughness_x_{roughness_x},
         roughness_y_{roughness_y},
         n_{n},
-        re_{LayeredDiffuse::calcRe(n)}
+        re_{re}
 {
 }
 
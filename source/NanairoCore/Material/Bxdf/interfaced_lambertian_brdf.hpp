@@ -43,6 +43,7 @@ class InterfacedLambertianBrdf : public GlossyShaderModel
                            const Float roughness_x,
                            const Float roughness_y,
                            const Float n,
+                           const Float re,
                            Sampler& sampler,
                            const PathState& path_state) noexcept;
 
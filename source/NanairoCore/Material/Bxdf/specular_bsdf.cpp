@@ -32,8 +32,9 @@ namespace nanairo {
   \details
   No detailed.
   */
-SpecularBsdf::SpecularBsdf(const Float n) noexcept :
-  n_{n}
+SpecularBsdf::SpecularBsdf(const Float n, const bool is_dispersive) noexcept :
+  n_{n},
+  is_dispersive_{is_dispersive ? kTrue : kFalse}
 {
 }
 
@@ -83,7 +84,8 @@ std::tuple<SampledDirection, SampledSpectra> SpecularBsdf::sample(
       ? Fresnel::calcReflectionDirection(vin_d, info->normal())
       : Fresnel::calcRefractionDirection(vin_d, info->normal(), n_, g);
 
-  SampledSpectra weight{wavelengths};
+  // A non-dispersive BSDF scatters all wavelengths in the same direction
+  SampledSpectra weight{wavelengths, (is_dispersive_ == kTrue) ? 0.0 : 1.0};
   weight.setIntensity(wavelengths.primaryWavelengthIndex(), 1.0);
 
   return std::make_tuple(SampledDirection{vout, 1.0}, weight);
@@ -95,7 +97,7 @@ std::tuple<SampledDirection, SampledSpectra> SpecularBsdf::sample(
   */
 bool SpecularBsdf::wavelengthIsSelected() const noexcept
 {
-  return true;
+  return is_dispersive_ == kTrue;
 }
 
 } // namespace nanairo
@@ -36,7 +36,7 @@ class SpecularBsdf : public SpecularShaderModel
 {
  public:
   //! Create a specular BSDF
-  SpecularBsdf(const Float n) noexcept;
+  SpecularBsdf(const Float n, const bool is_dispersive) noexcept;
 
 
   //! Check if the BSDF is reflective
@@ -58,6 +58,7 @@ class SpecularBsdf : public SpecularShaderModel
 
  private:
   Float n_;
+  uint8 is_dispersive_;
 };
 
 //! \} Core
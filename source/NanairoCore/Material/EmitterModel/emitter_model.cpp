@@ -19,6 +19,7 @@
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "environment_emitter.hpp"
 #include "non_directional_emitter.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
@@ -45,6 +46,13 @@ EmitterModel::EmitterModel(const SettingNodeBase* settings) noexcept
   initialize(settings);
 }
 
+/*!
+  */
+const TextureModel* EmitterModel::colorTexture() const noexcept
+{
+  return nullptr;
+}
+
 /*!
   \details
   No detailed.
@@ -57,7 +65,7 @@ zisc::UniqueMemoryPointer<EmitterModel> EmitterModel::makeEmitter(
   const auto emitter_settings = castNode<EmitterSettingNode>(settings);
 
   zisc::UniqueMemoryPointer<EmitterModel> emitter;
-  auto& data_resource = system.dataMemoryManager();
+  auto& data_resource = system.trackedMemoryResource(MemoryCategory::kObject);
   switch (emitter_settings->emitterType()) {
    case EmitterType::kNonDirectional: {
     emitter = zisc::UniqueMemoryPointer<NonDirectionalEmitter>::make(&data_resource,
@@ -65,6 +73,13 @@ zisc::UniqueMemoryPointer<EmitterModel> EmitterModel::makeEmitter(
                                                                      texture_list);
     break;
    }
+   case EmitterType::kEnvironment: {
+    emitter = zisc::UniqueMemoryPointer<EnvironmentEmitter>::make(&data_resource,
+                                                                  system,
+                                                                  settings,
+                                                                  texture_list);
+    break;
+   }
    default: {
     zisc::raiseError("EmitterError: Unsupported type is specified.");
     break;
@@ -49,7 +49,8 @@ class WavelengthSamples;
   */
 enum class EmitterType : uint32
 {
-  kNonDirectional              = zisc::Fnv1aHash32::hash("NonDirectional")
+  kNonDirectional              = zisc::Fnv1aHash32::hash("NonDirectional"),
+  kEnvironment                 = zisc::Fnv1aHash32::hash("Environment")
 };
 
 /*!
@@ -69,6 +70,9 @@ class EmitterModel
   virtual ~EmitterModel() noexcept;
 
 
+  //! Return the texture which modulates the emission, or null
+  virtual const TextureModel* colorTexture() const noexcept;
+
   //! Make a emitter model
   static zisc::UniqueMemoryPointer<EmitterModel> makeEmitter(
       System& system,
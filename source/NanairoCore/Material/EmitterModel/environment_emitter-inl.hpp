@@ -0,0 +1,73 @@
+/*!
+  \file environment_emitter-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_ENVIRONMENT_EMITTER_INL_HPP
+#define NANAIRO_ENVIRONMENT_EMITTER_INL_HPP
+
+#include "environment_emitter.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The phi is measured from the +x axis toward the +z axis.
+  */
+inline
+Point2 EnvironmentEmitter::calcUv(const Vector3& direction) noexcept
+{
+  constexpr Float pi = zisc::kPi<Float>;
+  const Float cos_theta = zisc::clamp(direction[1], -1.0, 1.0);
+  const Float theta = zisc::acos(cos_theta);
+  const Float phi = zisc::atan2(direction[2], direction[0]);
+  const Float u = zisc::clamp((phi + pi) * (0.5 / pi), 0.0, 1.0);
+  const Float v = zisc::clamp(1.0 - theta / pi, 0.0, 1.0);
+  return Point2{u, v};
+}
+
+/*!
+  */
+inline
+Vector3 EnvironmentEmitter::calcDirection(const Point2& uv) noexcept
+{
+  constexpr Float pi = zisc::kPi<Float>;
+  const Float phi = 2.0 * pi * uv[0] - pi;
+  const Float theta = pi * (1.0 - uv[1]);
+  const Float sin_theta = zisc::sin(theta);
+  return Vector3{sin_theta * zisc::cos(phi),
+                 zisc::cos(theta),
+                 sin_theta * zisc::sin(phi)};
+}
+
+/*!
+  */
+inline
+constexpr uint EnvironmentEmitter::tableHeight() noexcept
+{
+  return 256;
+}
+
+/*!
+  */
+inline
+constexpr uint EnvironmentEmitter::tableWidth() noexcept
+{
+  return 2 * tableHeight();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_ENVIRONMENT_EMITTER_INL_HPP
@@ -0,0 +1,205 @@
+/*!
+  \file environment_emitter.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "environment_emitter.hpp"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "emitter_model.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/Light/non_directional_light.hpp"
+#include "NanairoCore/Material/TextureModel/texture_model.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Setting/emitter_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+EnvironmentEmitter::EnvironmentEmitter(
+    System& system,
+    const SettingNodeBase* settings,
+    const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept :
+        EmitterModel(settings),
+        row_table_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+        column_table_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+        pdf_table_{&system.trackedMemoryResource(MemoryCategory::kObject)}
+{
+  initialize(settings, texture_list);
+}
+
+/*!
+  \details
+  The pdf of the uv is converted to the solid angle by the jacobian
+  2 pi^2 sin(theta) of the equirectangular mapping.
+  */
+Float EnvironmentEmitter::evalPdf(const Vector3& direction) const noexcept
+{
+  constexpr Float pi = zisc::kPi<Float>;
+  const auto uv = calcUv(direction);
+  const uint x = zisc::min(zisc::cast<uint>(uv[0] * zisc::cast<Float>(tableWidth())),
+                           tableWidth() - 1);
+  const uint y = zisc::min(zisc::cast<uint>(uv[1] * zisc::cast<Float>(tableHeight())),
+                           tableHeight() - 1);
+  const Float sin_theta = zisc::sqrt(zisc::max(
+      1.0 - direction[1] * direction[1], 0.0));
+  const Float pdf = (0.0 < sin_theta)
+      ? pdf_table_[x + y * tableWidth()] / (2.0 * pi * pi * sin_theta)
+      : 0.0;
+  return pdf;
+}
+
+/*!
+  */
+SampledSpectra EnvironmentEmitter::evalRadiance(
+    const Vector3& direction,
+    const WavelengthSamples& wavelengths) const noexcept
+{
+  const auto uv = calcUv(direction);
+  const auto color = color_->emissiveValue(uv, wavelengths);
+  return color * radiance_scale_;
+}
+
+/*!
+  \details
+  An object which has the environment emitter is lit uniformly
+  by the radiance of the uv.
+  */
+auto EnvironmentEmitter::makeLight(
+    const Point2& uv,
+    const WavelengthSamples& wavelengths,
+    zisc::pmr::memory_resource* mem_resource) const noexcept -> ShaderPointer
+{
+  const auto color = color_->emissiveValue(uv, wavelengths);
+  const auto radiant_exitance = color * radiantExitance();
+
+  using LightPointer = zisc::UniqueMemoryPointer<NonDirectionalLight>;
+  auto ptr = LightPointer::make(mem_resource, radiant_exitance);
+  return ptr;
+}
+
+/*!
+  \details
+  The first sample selects a row and the second selects a column of the row.
+  The residuals of the samples are used as the position in the cell.
+  */
+SampledDirection EnvironmentEmitter::sample(
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  auto r = sampler.draw2D(path_state);
+  const uint y = row_table_.sample(&r[0]);
+  const auto row = column_table_.data() + y * tableWidth();
+  const uint x = AliasTable::sampleEntries(row, tableWidth(), &r[1]);
+
+  const Point2 uv{(zisc::cast<Float>(x) + r[1]) / zisc::cast<Float>(tableWidth()),
+                  (zisc::cast<Float>(y) + r[0]) / zisc::cast<Float>(tableHeight())};
+  const auto direction = calcDirection(uv);
+  const Float pdf = evalPdf(direction);
+  const Float inverse_pdf = (0.0 < pdf) ? zisc::invert(pdf) : 0.0;
+  return SampledDirection{direction, inverse_pdf};
+}
+
+/*!
+  */
+EmitterType EnvironmentEmitter::type() const noexcept
+{
+  return EmitterType::kEnvironment;
+}
+
+/*!
+  */
+void EnvironmentEmitter::initialize(
+    const SettingNodeBase* settings,
+    const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept
+{
+  const auto emitter_settings = castNode<EmitterSettingNode>(settings);
+
+  const auto& parameters = emitter_settings->environmentEmitterParameters();
+  {
+    radiance_scale_ = zisc::cast<Float>(parameters.radiance_scale_);
+    ZISC_ASSERT(0.0 < radiance_scale_, "The radiance scale isn't positive.");
+    // The radiant exitance of the uniform radiance
+    setRadiantExitance(zisc::kPi<Float> * radiance_scale_);
+  }
+  {
+    const uint color_index = parameters.color_index_;
+    color_ = texture_list[color_index];
+  }
+  initDistribution(settings->workResource());
+}
+
+/*!
+  \details
+  The weight of a cell is the gray scale value of the texture at the center
+  times the sin(theta) of the mapping. A small floor is added to the values,
+  so the directions whose gray scale is zero still have nonzero pdf.
+  The rows are evaluated serially, since the emitters are initialized
+  in the tasks of the thread manager and a nested wait can deadlock.
+  */
+void EnvironmentEmitter::initDistribution(
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  constexpr uint width = tableWidth();
+  constexpr uint height = tableHeight();
+  constexpr Float floor_value = 1.0e-3;
+
+  zisc::pmr::vector<Float> weight_list{work_resource};
+  weight_list.resize(width * height);
+  zisc::pmr::vector<Float> row_weight_list{work_resource};
+  row_weight_list.resize(height);
+  column_table_.resize(width * height);
+  pdf_table_.resize(width * height);
+
+  // Evaluate the weights of the cells and make the tables of the rows
+  {
+    constexpr Float pi = zisc::kPi<Float>;
+    for (uint y = 0; y < height; ++y) {
+      const Float v = (zisc::cast<Float>(y) + 0.5) / zisc::cast<Float>(height);
+      const Float sin_theta = zisc::sin(pi * (1.0 - v));
+      auto weights = weight_list.data() + y * width;
+      Float row_weight = 0.0;
+      for (uint x = 0; x < width; ++x) {
+        const Float u = (zisc::cast<Float>(x) + 0.5) / zisc::cast<Float>(width);
+        const Float gray = zisc::max(color_->grayScaleValue(Point2{u, v}, 0.0),
+                                     0.0);
+        weights[x] = (gray + floor_value) * sin_theta;
+        row_weight += weights[x];
+      }
+      row_weight_list[y] = row_weight;
+      AliasTable::makeEntries(weights, width, work_resource,
+                              column_table_.data() + y * width);
+    }
+  }
+  row_table_.setWeights(row_weight_list.data(), height, work_resource);
+
+  // The pdf of the uv of a cell
+  Float total_weight = 0.0;
+  for (const Float row_weight : row_weight_list)
+    total_weight += row_weight;
+  ZISC_ASSERT(0.0 < total_weight, "The total weight isn't positive.");
+  const Float k = zisc::cast<Float>(width * height) / total_weight;
+  for (uint i = 0; i < width * height; ++i)
+    pdf_table_[i] = weight_list[i] * k;
+}
+
+} // namespace nanairo
@@ -0,0 +1,113 @@
+/*!
+  \file environment_emitter.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_ENVIRONMENT_EMITTER_HPP
+#define NANAIRO_ENVIRONMENT_EMITTER_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "emitter_model.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class PathState;
+class Sampler;
+class System;
+class TextureModel;
+class WavelengthSamples;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The distant light which surrounds the scene
+  \details
+  The radiance of a direction is read from an equirectangular texture,
+  the top of the texture is the +y direction.
+  The directions are sampled in proportion to the luminance of the texture
+  by the alias tables of the rows and the columns of
+  the piecewise constant distribution, so a sample costs O(1).
+  The tables are made when the emitter is made.
+  */
+class EnvironmentEmitter : public EmitterModel
+{
+ public:
+  //! Create an environment emitter
+  EnvironmentEmitter(
+      System& system,
+      const SettingNodeBase* settings,
+      const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept;
+
+
+  //! Evaluate the pdf of sampling the direction in the solid angle measure
+  Float evalPdf(const Vector3& direction) const noexcept;
+
+  //! Evaluate the radiance which comes from the direction
+  SampledSpectra evalRadiance(const Vector3& direction,
+                              const WavelengthSamples& wavelengths) const noexcept;
+
+  //! Make a non-directional light of the radiance at the uv
+  ShaderPointer makeLight(const Point2& uv,
+                          const WavelengthSamples& wavelengths,
+                          zisc::pmr::memory_resource* mem_resource) const noexcept override;
+
+  //! Sample a direction toward the environment
+  SampledDirection sample(Sampler& sampler,
+                          const PathState& path_state) const noexcept;
+
+  //! Return the environment emitter type
+  EmitterType type() const noexcept override;
+
+ private:
+  //! Return the texture coordinate of the direction
+  static Point2 calcUv(const Vector3& direction) noexcept;
+
+  //! Return the direction of the texture coordinate
+  static Vector3 calcDirection(const Point2& uv) noexcept;
+
+  //! Initialize the emitter
+  void initialize(
+      const SettingNodeBase* settings,
+      const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept;
+
+  //! Make the distribution of the directions by the luminance of the texture
+  void initDistribution(zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Return the height of the distribution
+  static constexpr uint tableHeight() noexcept;
+
+  //! Return the width of the distribution
+  static constexpr uint tableWidth() noexcept;
+
+
+  AliasTable row_table_;
+  zisc::pmr::vector<AliasTable::Entry> column_table_; //!< [row][column]
+  zisc::pmr::vector<Float> pdf_table_; //!< The pdf of the uv of the cells
+  const TextureModel* color_;
+  Float radiance_scale_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "environment_emitter-inl.hpp"
+
+#endif // NANAIRO_ENVIRONMENT_EMITTER_HPP
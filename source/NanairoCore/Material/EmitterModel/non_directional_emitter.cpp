@@ -38,6 +38,13 @@ NonDirectionalEmitter::NonDirectionalEmitter(
   initialize(settings, texture_list);
 }
 
+/*!
+  */
+const TextureModel* NonDirectionalEmitter::colorTexture() const noexcept
+{
+  return color_;
+}
+
 /*!
   \details
   No detailed.
@@ -42,6 +42,9 @@ class NonDirectionalEmitter : public EmitterModel
       const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept;
 
 
+  //! Return the color texture of the emission
+  const TextureModel* colorTexture() const noexcept override;
+
   //! Make non-directional light
   ShaderPointer makeLight(const Point2& uv,
                           const WavelengthSamples& wavelengths,
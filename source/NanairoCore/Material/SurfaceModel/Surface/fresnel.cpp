@@ -11,6 +11,7 @@
 // Standard C++ library
 #include <utility>
 // Zisc
+#include "zisc/error.hpp"
 #include "zisc/math.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
@@ -21,34 +22,34 @@ namespace nanairo {
 /*!
   \details
   n = (n_transmnittance_side / n_incident_side)
+  The terms of the angle are computed once and the wavelengths are evaluated
+  in a loop of independent lanes, which the compiler can vectorize.
   */
 SampledSpectra Fresnel::evalFresnel(const SampledSpectra& n,
                                     const SampledSpectra& eta,
                                     const Float cos_theta) noexcept
 {
-  SampledSpectra reflectance;
   const Float cos_theta2 = zisc::power<2>(cos_theta);
   const Float sin_theta2 = 1.0 - cos_theta2;
+  const Float sin_theta4 = zisc::power<2>(sin_theta2);
+  IntensitySamples reflectance;
   for (uint i = 0; i < SampledSpectra::size(); ++i) {
     const Float e = n.intensity(i);
     const Float ek = eta.intensity(i);
 
     const Float t1 = zisc::power<2>(e) - zisc::power<2>(ek) - sin_theta2;
     const Float ab2 = zisc::sqrt(zisc::power<2>(t1) + zisc::power<2>(2.0 * e * ek));
-    const Float a = zisc::sqrt(0.5 * (ab2 + t1));
+    const Float a2_cos = 2.0 * cos_theta * zisc::sqrt(0.5 * (ab2 + t1));
 
-    const Float r_s = (ab2 + cos_theta2 - (2.0 * a * cos_theta)) /
-                      (ab2 + cos_theta2 + (2.0 * a * cos_theta));
-    const Float t2 = (2.0 * a * cos_theta) * sin_theta2;
-    const Float t3 = (cos_theta2 * ab2 + zisc::power<2>(sin_theta2)) /
-                     (cos_theta2 * ab2 + zisc::power<2>(sin_theta2) + t2);
-
-    const Float r = r_s * t3;
+    const Float r_s = (ab2 + cos_theta2 - a2_cos) / (ab2 + cos_theta2 + a2_cos);
+    const Float t2 = a2_cos * sin_theta2;
+    const Float t3 = cos_theta2 * ab2 + sin_theta4;
+    const Float r = r_s * t3 / (t3 + t2);
     ZISC_ASSERT(zisc::isInClosedBounds(r, 0.0, 1.0),
                 "The reflectance is out of range [0, 1].");
-    reflectance.setIntensity(i, r);
+    reflectance[i] = r;
   }
-  return reflectance;
+  return SampledSpectra{n.wavelengths(), reflectance};
 }
 
 } // namespace nanairo
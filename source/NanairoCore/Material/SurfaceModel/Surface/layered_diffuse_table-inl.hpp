@@ -0,0 +1,74 @@
+/*!
+  \file layered_diffuse_table-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LAYERED_DIFFUSE_TABLE_INL_HPP
+#define NANAIRO_LAYERED_DIFFUSE_TABLE_INL_HPP
+
+#include "layered_diffuse_table.hpp"
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "layered_diffuse.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The reflectance is linearly interpolated in the table.
+  The index out of the table is calculated directly.
+  */
+inline
+Float LayeredDiffuseTable::externalReflectance(const Float n) const noexcept
+{
+  using zisc::cast;
+  constexpr Float n_min = minRefractiveIndex();
+  constexpr Float n_max = maxRefractiveIndex();
+  Float re = 0.0;
+  if (zisc::isInBounds(n, n_min, n_max)) {
+    constexpr Float k = cast<Float>(resolution() - 1) / (n_max - n_min);
+    const Float x = k * (n - n_min);
+    const uint i = zisc::min(cast<uint>(x), resolution() - 2);
+    const Float t = x - cast<Float>(i);
+    re = (1.0 - t) * re_table_[i] + t * re_table_[i + 1];
+  }
+  else {
+    re = LayeredDiffuse::calcRe(n);
+  }
+  return re;
+}
+
+/*!
+  */
+inline
+constexpr Float LayeredDiffuseTable::maxRefractiveIndex() noexcept
+{
+  return 4.0;
+}
+
+/*!
+  */
+inline
+constexpr Float LayeredDiffuseTable::minRefractiveIndex() noexcept
+{
+  return 1.0;
+}
+
+/*!
+  */
+inline
+constexpr uint LayeredDiffuseTable::resolution() noexcept
+{
+  return 1024;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_LAYERED_DIFFUSE_TABLE_INL_HPP
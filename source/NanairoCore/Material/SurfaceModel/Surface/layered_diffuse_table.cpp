@@ -0,0 +1,50 @@
+/*!
+  \file layered_diffuse_table.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "layered_diffuse_table.hpp"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "layered_diffuse.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+LayeredDiffuseTable::LayeredDiffuseTable(
+    zisc::pmr::memory_resource* data_resource) noexcept :
+        re_table_{data_resource}
+{
+  initialize();
+}
+
+/*!
+  \details
+  The reflectance at n = 1 is zero since the interface doesn't reflect,
+  and the closed form can't be evaluated there.
+  */
+void LayeredDiffuseTable::initialize() noexcept
+{
+  using zisc::cast;
+  constexpr Float n_min = minRefractiveIndex();
+  constexpr Float n_max = maxRefractiveIndex();
+  constexpr Float delta = (n_max - n_min) / cast<Float>(resolution() - 1);
+
+  re_table_.resize(resolution(), 0.0);
+  for (uint i = 1; i < resolution(); ++i) {
+    const Float n = n_min + delta * cast<Float>(i);
+    re_table_[i] = LayeredDiffuse::calcRe(n);
+  }
+}
+
+} // namespace nanairo
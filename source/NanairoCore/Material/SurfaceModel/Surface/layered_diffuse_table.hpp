@@ -0,0 +1,66 @@
+/*!
+  \file layered_diffuse_table.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LAYERED_DIFFUSE_TABLE_HPP
+#define NANAIRO_LAYERED_DIFFUSE_TABLE_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A precomputed table of the external reflectance of a layered diffuse
+  \details
+  The external reflectance is the hemispherical average of the Fresnel
+  reflectance, which depends only on the relative refractive index.
+  The table samples it at uniform intervals of the index and
+  is shared by all layered diffuse surfaces.
+  */
+class LayeredDiffuseTable
+{
+ public:
+  //! Make the table
+  LayeredDiffuseTable(zisc::pmr::memory_resource* data_resource) noexcept;
+
+
+  //! Return the external reflectance of the relative refractive index
+  Float externalReflectance(const Float n) const noexcept;
+
+  //! Return the max refractive index of the table
+  static constexpr Float maxRefractiveIndex() noexcept;
+
+  //! Return the min refractive index of the table
+  static constexpr Float minRefractiveIndex() noexcept;
+
+  //! Return the resolution of the table
+  static constexpr uint resolution() noexcept;
+
+ private:
+  //! Initialize the table
+  void initialize() noexcept;
+
+
+  zisc::pmr::vector<Float> re_table_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "layered_diffuse_table-inl.hpp"
+
+#endif // NANAIRO_LAYERED_DIFFUSE_TABLE_HPP
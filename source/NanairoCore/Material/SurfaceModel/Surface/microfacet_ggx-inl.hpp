@@ -77,7 +77,8 @@ Float MicrofacetGgx::evalReflectionPdf(const Float roughness_x,
 {
   const Float d = evalD(roughness_x, roughness_y, m_normal);
   return (d != 0.0)
-      ? calcReflectionPdf(roughness_x, roughness_y, vin, m_normal, d)
+      ? calcReflectionPdf(vin, m_normal, d,
+                          evalG1(roughness_x, roughness_y, vin, m_normal))
       : 0.0;
 }
 
@@ -95,7 +96,8 @@ Float MicrofacetGgx::evalRefractionPdf(const Float roughness_x,
 {
   const Float d = evalD(roughness_x, roughness_y, m_normal);
   return (d != 0.0)
-      ? calcRefractionPdf(roughness_x, roughness_y, vin, vout, m_normal, n, d)
+      ? calcRefractionPdf(vin, vout, m_normal, n, d,
+                          evalG1(roughness_x, roughness_y, vin, m_normal))
       : 0.0;
 }
 
@@ -130,14 +132,12 @@ Float MicrofacetGgx::evalWeight(const Float roughness_x,
 /*!
   */
 inline
-Float MicrofacetGgx::calcReflectionPdf(const Float roughness_x,
-                                       const Float roughness_y,
-                                       const Vector3& vin,
+Float MicrofacetGgx::calcReflectionPdf(const Vector3& vin,
                                        const Vector3& m_normal,
-                                       const Float d) noexcept
+                                       const Float d,
+                                       const Float g1) noexcept
 {
   Float pdf = 0.0;
-  const Float g1 = evalG1(roughness_x, roughness_y, vin, m_normal);
   if (0.0 < g1) {
     const Float cos_ni = vin[2];
     const Float cos_mi = zisc::dot(m_normal, vin);
@@ -153,16 +153,14 @@ Float MicrofacetGgx::calcReflectionPdf(const Float roughness_x,
   n = n_transmission_side / n_incident_side
   */
 inline
-Float MicrofacetGgx::calcRefractionPdf(const Float roughness_x,
-                                       const Float roughness_y,
-                                       const Vector3& vin,
+Float MicrofacetGgx::calcRefractionPdf(const Vector3& vin,
                                        const Vector3& vout,
                                        const Vector3& m_normal,
                                        const Float n,
-                                       const Float d) noexcept
+                                       const Float d,
+                                       const Float g1) noexcept
 {
   Float pdf = 0.0;
-  const Float g1 = evalG1(roughness_x, roughness_y, vin, m_normal);
   if (0.0 < g1) {
     const Float cos_ni = vin[2];
     const Float cos_mi = zisc::dot(m_normal, vin);
@@ -174,6 +172,36 @@ Float MicrofacetGgx::calcRefractionPdf(const Float roughness_x,
   return pdf;
 }
 
+/*!
+  \details
+  The Smith G2 is the product of the G1 terms,
+  so the G1 of the vin is shared with the pdf instead of evaluated twice.
+  */
+inline
+Float MicrofacetGgx::evalG2(const Float roughness_x,
+                            const Float roughness_y,
+                            const Vector3& vin,
+                            const Vector3& vout,
+                            const Vector3& m_normal,
+                            Float* g1) noexcept
+{
+  if constexpr (kMicrosurface == MicrosurfaceProfile::kSmith) {
+    const Float g1_in = evalG1(roughness_x, roughness_y, vin, m_normal);
+    if (g1 != nullptr)
+      *g1 = g1_in;
+    const Float g2 = (g1_in != 0.0)
+        ? g1_in * evalG1(roughness_x, roughness_y, vout, m_normal)
+        : 0.0;
+    ZISC_ASSERT(zisc::isInClosedBounds(g2, 0.0, 1.0), "GGX G2 isn't [0, 1].");
+    return g2;
+  }
+  else {
+    if (g1 != nullptr)
+      *g1 = evalG1(roughness_x, roughness_y, vin, m_normal);
+    return evalG2(roughness_x, roughness_y, vin, vout, m_normal);
+  }
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_MICROFACET_GGX_INL_HPP
@@ -44,8 +44,10 @@ Float MicrofacetGgx::evalReflectance(const Float roughness_x,
   if (d == 0.0)
     return 0.0;
 
-  // Evaluate G2
-  const Float g2 = evalG2(roughness_x, roughness_y, vin, vout, m_normal);
+  // Evaluate G2, the G1 of the vin is kept for the pdf
+  Float g1 = 0.0;
+  const Float g2 = evalG2(roughness_x, roughness_y, vin, vout, m_normal,
+                          (pdf != nullptr) ? &g1 : nullptr);
   if (g2 == 0.0)
     return 0.0;
 
@@ -57,7 +59,7 @@ Float MicrofacetGgx::evalReflectance(const Float roughness_x,
 
   // Calculate the reflection pdf
   if (pdf != nullptr)
-    *pdf = calcReflectionPdf(roughness_x, roughness_y, vin, m_normal, d);
+    *pdf = calcReflectionPdf(vin, m_normal, d, g1);
 
   return f;
 }
@@ -81,8 +83,10 @@ SampledSpectra MicrofacetGgx::evalReflectance(
   if (d == 0.0)
     return SampledSpectra{wavelengths};
 
-  // Evaluate G2
-  const Float g2 = evalG2(roughness_x, roughness_y, vin, vout, m_normal);
+  // Evaluate G2, the G1 of the vin is kept for the pdf
+  Float g1 = 0.0;
+  const Float g2 = evalG2(roughness_x, roughness_y, vin, vout, m_normal,
+                          (pdf != nullptr) ? &g1 : nullptr);
   if (g2 == 0.0)
     return SampledSpectra{wavelengths};
 
@@ -98,7 +102,7 @@ SampledSpectra MicrofacetGgx::evalReflectance(
 
   // Calculate the reflection pdf
   if (pdf != nullptr)
-    *pdf = calcReflectionPdf(roughness_x, roughness_y, vin, m_normal, d);
+    *pdf = calcReflectionPdf(vin, m_normal, d, g1);
 
   return f;
 }
@@ -122,8 +126,10 @@ Float MicrofacetGgx::evalTransmittance(const Float roughness_x,
   if (d == 0.0)
     return 0.0;
 
-  // Evaluate G2
-  const Float g2 = evalG2(roughness_x, roughness_y, vin, vout, m_normal);
+  // Evaluate G2, the G1 of the vin is kept for the pdf
+  Float g1 = 0.0;
+  const Float g2 = evalG2(roughness_x, roughness_y, vin, vout, m_normal,
+                          (pdf != nullptr) ? &g1 : nullptr);
   if (g2 == 0.0)
     return 0.0;
 
@@ -139,7 +145,7 @@ Float MicrofacetGgx::evalTransmittance(const Float roughness_x,
 
   // Calculate the refraction pdf
   if (pdf != nullptr)
-    *pdf = calcRefractionPdf(roughness_x, roughness_y, vin, vout, m_normal, n, d);
+    *pdf = calcRefractionPdf(vin, vout, m_normal, n, d, g1);
 
   return f;
 }
@@ -129,21 +129,27 @@ class MicrofacetGgx : public Microfacet
                                           const PathState& path_state) noexcept;
   };
 
-  //! Calculate the pdf of the GGX reflection
-  static Float calcReflectionPdf(const Float roughness_x,
-                                 const Float roughness_y,
-                                 const Vector3& vin,
+  //! Calculate the pdf of the GGX reflection from the D and the G1 of the vin
+  static Float calcReflectionPdf(const Vector3& vin,
                                  const Vector3& m_normal,
-                                 const Float d) noexcept;
+                                 const Float d,
+                                 const Float g1) noexcept;
 
-  //! Calculate the pdf of the GGX refraction
-  static Float calcRefractionPdf(const Float roughness_x,
-                                 const Float roughness_y,
-                                 const Vector3& vin,
+  //! Calculate the pdf of the GGX refraction from the D and the G1 of the vin
+  static Float calcRefractionPdf(const Vector3& vin,
                                  const Vector3& vout,
                                  const Vector3& m_normal,
                                  const Float n,
-                                 const Float d) noexcept;
+                                 const Float d,
+                                 const Float g1) noexcept;
+
+  //! Evaluate the G2 term and the G1 term of the vin if the g1 isn't null
+  static Float evalG2(const Float roughness_x,
+                      const Float roughness_y,
+                      const Vector3& vin,
+                      const Vector3& vout,
+                      const Vector3& m_normal,
+                      Float* g1) noexcept;
 
   //! Sample the microfacet normal
   static Vector3 sampleMicrofacetNormal(const Float roughness_x,
@@ -51,7 +51,9 @@ auto ClothSurface::makeBxdf(
     zisc::pmr::memory_resource* mem_resourcce) const noexcept -> ShaderPointer
 {
   // Get the roughness
-  const auto k_d = reflectance_->reflectiveValue(info.uv(), wavelengths);
+  const auto k_d = reflectance_->reflectiveValue(info.uv(),
+                                                 info.uvFootprint(),
+                                                 wavelengths);
 
   // Make a microcylinder cloth BRDF
   using BxdfPointer = zisc::UniqueMemoryPointer<MicrocylinderClothBrdf>;
@@ -21,10 +21,13 @@
 // Nanairo
 #include "surface_model.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Material/TextureModel/texture_lookup_cache.hpp"
 #include "NanairoCore/Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/Material/Bxdf/interfaced_lambertian_brdf.hpp"
+#include "NanairoCore/Material/SurfaceModel/Surface/layered_diffuse_table.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Setting/surface_setting_node.hpp"
 #include "NanairoCore/Utility/value.hpp"
@@ -36,10 +39,11 @@ namespace nanairo {
   No detailed.
   */
 LayeredDiffuseSurface::LayeredDiffuseSurface(
+    System& system,
     const SettingNodeBase* settings,
     const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept
 {
-  initialize(settings, texture_list);
+  initialize(system, settings, texture_list);
 }
 
 /*!
@@ -54,26 +58,28 @@ auto LayeredDiffuseSurface::makeBxdf(
     zisc::pmr::memory_resource* mem_resource) const noexcept -> ShaderPointer
 {
   const auto wavelength = wavelengths[wavelengths.primaryWavelengthIndex()];
+  TextureLookupCache cache{info.uv(), info.uvFootprint(), wavelengths};
 
   // Evaluate the reflectance
-  const Float k_d = reflectance_->reflectiveValue(info.uv(), wavelength);
+  const Float k_d = cache.reflectiveValue(reflectance_, wavelength);
 
   // Evaluate the roughness
-  const Float roughness_x = evalRoughness(roughness_x_, info.uv());
-  const Float roughness_y = evalRoughness(roughness_y_, info.uv());
+  const Float roughness_x = evalRoughness(roughness_x_, cache);
+  const Float roughness_y = evalRoughness(roughness_y_, cache);
 
   // Evaluate the refractive index
   const Float n = evalRefractiveIndex(outer_refractive_index_,
                                       inner_refractive_index_,
-                                      info.uv(),
                                       wavelength,
-                                      info.isBackFace());
+                                      info.isBackFace(),
+                                      cache);
+  const Float re = table_->externalReflectance(n);
 
 
   // Make a interfaced lambertian BRDF
   using BxdfPointer = zisc::UniqueMemoryPointer<InterfacedLambertianBrdf>;
   auto ptr = BxdfPointer::make(mem_resource, k_d, roughness_x, roughness_y,
-                               n, sampler, path_state);
+                               n, re, sampler, path_state);
   return ptr;
 }
 
@@ -91,11 +97,14 @@ SurfaceType LayeredDiffuseSurface::type() const noexcept
   No detailed.
   */
 void LayeredDiffuseSurface::initialize(
+    System& system,
     const SettingNodeBase* settings,
     const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept
 {
   const auto surface_settings = castNode<SurfaceSettingNode>(settings);
 
+  table_ = &system.layeredDiffuseTable();
+
   const auto& parameters = surface_settings->layeredDiffuseParameters();
   {
     const auto index = parameters.reflectance_index_;
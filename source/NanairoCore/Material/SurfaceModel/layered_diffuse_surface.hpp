@@ -25,8 +25,10 @@ namespace nanairo {
 
 // Forward declaration
 class IntersectionInfo;
+class LayeredDiffuseTable;
 class PathState;
 class Sampler;
+class System;
 class TextureModel;
 class WavelengthSamples;
 
@@ -45,6 +47,7 @@ class LayeredDiffuseSurface : public SurfaceModel
 
   //! Create a rough dielectric surface
   LayeredDiffuseSurface(
+      System& system,
       const SettingNodeBase* settings,
       const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept;
 
@@ -63,6 +66,7 @@ class LayeredDiffuseSurface : public SurfaceModel
  private:
   //! Initialize
   void initialize(
+      System& system,
       const SettingNodeBase* settings,
       const zisc::pmr::vector<const TextureModel*>& texture_list) noexcept;
 
@@ -72,6 +76,7 @@ class LayeredDiffuseSurface : public SurfaceModel
   const TextureModel* inner_refractive_index_;
   const TextureModel* roughness_x_;
   const TextureModel* roughness_y_;
+  const LayeredDiffuseTable* table_;
 };
 
 //! \} Core
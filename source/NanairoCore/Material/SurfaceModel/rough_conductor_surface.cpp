@@ -23,6 +23,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Material/Bxdf/ggx_conductor_brdf.hpp"
+#include "NanairoCore/Material/TextureModel/texture_lookup_cache.hpp"
 #include "NanairoCore/Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Setting/surface_setting_node.hpp"
@@ -51,19 +52,19 @@ auto RoughConductorSurface::makeBxdf(
     const PathState& /* path_state */,
     zisc::pmr::memory_resource* mem_resource) const noexcept -> ShaderPointer
 {
+  TextureLookupCache cache{info.uv(), info.uvFootprint(), wavelengths};
+
   // Evaluate the roughness
-  const Float roughness_x = evalRoughness(roughness_x_, info.uv());
-  const Float roughness_y = evalRoughness(roughness_y_, info.uv());
+  const Float roughness_x = evalRoughness(roughness_x_, cache);
+  const Float roughness_y = evalRoughness(roughness_y_, cache);
 
   // Evaluate the refractive index
   const auto n = evalRefractiveIndex(outer_refractive_index_,
                                      inner_refractive_index_,
-                                     info.uv(),
-                                     wavelengths);
+                                     cache);
   const auto eta = evalRefractiveIndex(outer_refractive_index_,
                                        inner_extinction_,
-                                       info.uv(),
-                                       wavelengths);
+                                       cache);
 
 
   // Make GGX BRDF
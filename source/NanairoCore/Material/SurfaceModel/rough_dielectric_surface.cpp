@@ -22,6 +22,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Material/Bxdf/ggx_dielectric_bsdf.hpp"
+#include "NanairoCore/Material/TextureModel/texture_lookup_cache.hpp"
 #include "NanairoCore/Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Setting/surface_setting_node.hpp"
@@ -51,22 +52,27 @@ auto RoughDielectricSurface::makeBxdf(
     zisc::pmr::memory_resource* mem_resource) const noexcept -> ShaderPointer
 {
   const auto wavelength = wavelengths[wavelengths.primaryWavelengthIndex()];
+  TextureLookupCache cache{info.uv(), info.uvFootprint(), wavelengths};
 
   // Evaluate the roughness
-  const Float roughness_x = evalRoughness(roughness_x_, info.uv());
-  const Float roughness_y = evalRoughness(roughness_y_, info.uv());
+  const Float roughness_x = evalRoughness(roughness_x_, cache);
+  const Float roughness_y = evalRoughness(roughness_y_, cache);
 
   // Evaluate the refractive index
   const Float n = evalRefractiveIndex(outer_refractive_index_,
                                       inner_refractive_index_,
-                                      info.uv(),
                                       wavelength,
-                                      info.isBackFace());
+                                      info.isBackFace(),
+                                      cache);
+  const bool is_dispersive = isDispersive(outer_refractive_index_,
+                                          inner_refractive_index_,
+                                          cache);
 
 
   // Make GGX BSDF
   using BxdfPointer = zisc::UniqueMemoryPointer<GgxDielectricBsdf>;
-  auto ptr = BxdfPointer::make(mem_resource, roughness_x, roughness_y, n);
+  auto ptr = BxdfPointer::make(mem_resource, roughness_x, roughness_y, n,
+                               is_dispersive);
   return ptr;
 }
 
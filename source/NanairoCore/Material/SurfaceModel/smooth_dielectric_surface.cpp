@@ -20,6 +20,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Material/Bxdf/specular_bsdf.hpp"
+#include "NanairoCore/Material/TextureModel/texture_lookup_cache.hpp"
 #include "NanairoCore/Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/Sampling/sampled_wavelengths.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
@@ -50,17 +51,21 @@ auto SmoothDielectricSurface::makeBxdf(
     zisc::pmr::memory_resource* mem_resource) const noexcept -> ShaderPointer
 {
   const auto wavelength = wavelengths[wavelengths.primaryWavelengthIndex()];
+  TextureLookupCache cache{info.uv(), info.uvFootprint(), wavelengths};
 
   // Evaluate the refractive index
   const Float n = evalRefractiveIndex(outer_refractive_index_,
                                       inner_refractive_index_,
-                                      info.uv(),
                                       wavelength,
-                                      info.isBackFace());
+                                      info.isBackFace(),
+                                      cache);
+  const bool is_dispersive = isDispersive(outer_refractive_index_,
+                                          inner_refractive_index_,
+                                          cache);
 
 
   using BxdfPointer = zisc::UniqueMemoryPointer<SpecularBsdf>;
-  auto ptr = BxdfPointer::make(mem_resource, n);
+  auto ptr = BxdfPointer::make(mem_resource, n, is_dispersive);
   return ptr;
 }
 
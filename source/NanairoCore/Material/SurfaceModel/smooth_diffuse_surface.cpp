@@ -50,7 +50,9 @@ auto SmoothDiffuseSurface::makeBxdf(
     zisc::pmr::memory_resource* mem_resource) const noexcept -> ShaderPointer
 {
   // Evaluate the reflectance
-  const auto k_d = reflectance_->reflectiveValue(info.uv(), wavelengths);
+  const auto k_d = reflectance_->reflectiveValue(info.uv(),
+                                                 info.uvFootprint(),
+                                                 wavelengths);
 
 
   using BxdfPointer = zisc::UniqueMemoryPointer<LambertBrdf>;
@@ -19,23 +19,40 @@
 #include "zisc/utility.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Material/TextureModel/texture_lookup_cache.hpp"
 #include "NanairoCore/Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/Sampling/sampled_spectra.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+inline
+uint SurfaceModel::index() const noexcept
+{
+  return index_;
+}
+
+/*!
+  */
+inline
+void SurfaceModel::setIndex(const uint index) noexcept
+{
+  index_ = index;
+}
+
 /*!
   */
 inline
 Float SurfaceModel::evalRefractiveIndex(
     const TextureModel* outer_refractive_index_texture,
     const TextureModel* inner_refractive_index_texture,
-    const Point2& uv,
     const uint16 wavelength,
-    const bool is_back_face) noexcept
+    const bool is_back_face,
+    TextureLookupCache& cache) noexcept
 {
-  const Float n1 = outer_refractive_index_texture->spectraValue(uv, wavelength);
-  const Float n2 = inner_refractive_index_texture->spectraValue(uv, wavelength);
+  const Float n1 = cache.spectraValue(outer_refractive_index_texture, wavelength);
+  const Float n2 = cache.spectraValue(inner_refractive_index_texture, wavelength);
   Float n = (is_back_face) ? (n1 / n2) : (n2 / n1);
   n = (n != 1.0) ? n : (1.0 + std::numeric_limits<Float>::epsilon());
   return n;
@@ -47,11 +64,10 @@ inline
 SampledSpectra SurfaceModel::evalRefractiveIndex(
     const TextureModel* outer_refractive_index_texture,
     const TextureModel* inner_refractive_index_texture,
-    const Point2& uv,
-    const WavelengthSamples& wavelengths) noexcept
+    TextureLookupCache& cache) noexcept
 {
-  const auto n1 = outer_refractive_index_texture->spectraValue(uv, wavelengths);
-  const auto n2 = inner_refractive_index_texture->spectraValue(uv, wavelengths);
+  const auto n1 = cache.spectraValue(outer_refractive_index_texture);
+  const auto& n2 = cache.spectraValue(inner_refractive_index_texture);
   const auto n = n2 / n1;
   return n;
 }
@@ -61,10 +77,10 @@ SampledSpectra SurfaceModel::evalRefractiveIndex(
 inline
 Float SurfaceModel::evalRoughness(
     const TextureModel* roughness_texture,
-    const Point2& uv) noexcept
+    TextureLookupCache& cache) noexcept
 {
   constexpr Float min_roughness = 0.001;
-  Float roughness = roughness_texture->grayScaleValue(uv);
+  Float roughness = cache.grayScaleValue(roughness_texture);
   roughness = (min_roughness < roughness)
       ? zisc::power<2>(roughness)
       : zisc::power<2>(min_roughness);
@@ -73,6 +89,26 @@ Float SurfaceModel::evalRoughness(
   return roughness;
 }
 
+/*!
+  \details
+  A BxDF of a non-dispersive interface scatters all wavelengths
+  in the same direction, so the wavelengths don't need to be selected.
+  */
+inline
+bool SurfaceModel::isDispersive(
+    const TextureModel* outer_refractive_index_texture,
+    const TextureModel* inner_refractive_index_texture,
+    TextureLookupCache& cache) noexcept
+{
+  const auto n = evalRefractiveIndex(outer_refractive_index_texture,
+                                     inner_refractive_index_texture,
+                                     cache);
+  bool is_dispersive = false;
+  for (uint i = 1; i < SampledSpectra::size(); ++i)
+    is_dispersive = is_dispersive || (n.intensity(i) != n.intensity(0));
+  return is_dispersive;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_SURFACE_MODEL_INL_HPP
@@ -38,6 +38,13 @@ namespace nanairo {
 // Forward declaration
 class TextureModel;
 
+/*!
+  */
+SurfaceModel::SurfaceModel() noexcept :
+    index_{0}
+{
+}
+
 /*!
   */
 SurfaceModel::~SurfaceModel() noexcept
@@ -56,7 +63,7 @@ zisc::UniqueMemoryPointer<SurfaceModel> SurfaceModel::makeSurface(
   const auto surface_settings = castNode<SurfaceSettingNode>(settings);
 
   zisc::UniqueMemoryPointer<SurfaceModel> surface;
-  auto& data_resource = system.dataMemoryManager();
+  auto& data_resource = system.trackedMemoryResource(MemoryCategory::kObject);
   switch (surface_settings->surfaceType()) {
    case SurfaceType::kSmoothDiffuse: {
     surface =
@@ -96,6 +103,7 @@ zisc::UniqueMemoryPointer<SurfaceModel> SurfaceModel::makeSurface(
    case SurfaceType::kLayeredDiffuse: {
     surface =
         zisc::UniqueMemoryPointer<LayeredDiffuseSurface>::make(&data_resource,
+                                                               system,
                                                                settings,
                                                                texture_list);
     break;
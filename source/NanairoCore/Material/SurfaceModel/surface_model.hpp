@@ -33,6 +33,7 @@ class PathState;
 class Sampler;
 class ShaderModel;
 class System;
+class TextureLookupCache;
 class TextureModel;
 class WavelengthSamples;
 
@@ -64,10 +65,17 @@ class SurfaceModel
   using ShaderPointer = zisc::UniqueMemoryPointer<ShaderModel>;
 
 
+  //! Create a surface model of the index 0
+  SurfaceModel() noexcept;
+
   //! Finalize the surface model
   virtual ~SurfaceModel() noexcept;
 
 
+  //! Return the index of the surface in the world
+  uint index() const noexcept;
+
+
   //! Make BxDF
   virtual ShaderPointer makeBxdf(
       const IntersectionInfo& info,
@@ -85,6 +93,9 @@ class SurfaceModel
   //! Return the surface name
   std::string_view name() const noexcept;
 
+  //! Set the index of the surface in the world
+  void setIndex(const uint index) noexcept;
+
   //! Set the surface name
   void setName(const std::string_view& name) noexcept;
 
@@ -96,26 +107,32 @@ class SurfaceModel
   static Float evalRefractiveIndex(
       const TextureModel* outer_refractive_index_texture,
       const TextureModel* inner_refractive_index_texture,
-      const Point2& uv,
       const uint16 wavelength,
-      const bool is_back_face) noexcept;
+      const bool is_back_face,
+      TextureLookupCache& cache) noexcept;
 
   // Evaluate the refractive index
   static SampledSpectra evalRefractiveIndex(
       const TextureModel* outer_refractive_index_texture,
       const TextureModel* inner_refractive_index_texture,
-      const Point2& uv,
-      const WavelengthSamples& wavelengths) noexcept;
+      TextureLookupCache& cache) noexcept;
+
+  //! Check if the refractive index varies over the wavelengths
+  static bool isDispersive(
+      const TextureModel* outer_refractive_index_texture,
+      const TextureModel* inner_refractive_index_texture,
+      TextureLookupCache& cache) noexcept;
 
   //! Evaluate the roughness
   static Float evalRoughness(
       const TextureModel* roughness_texture,
-      const Point2& uv) noexcept;
+      TextureLookupCache& cache) noexcept;
 
  private:
 #ifdef Z_DEBUG_MODE
   std::string name_;
 #endif // Z_DEBUG_MODE
+  uint index_;
 };
 
 //! \} Core
@@ -60,7 +60,8 @@ SampledSpectra CheckerboardTexture::emissiveValue(
   \details
   No detailed.
   */
-Float CheckerboardTexture::grayScaleValue(const Point2& uv) const noexcept
+Float CheckerboardTexture::grayScaleValue(const Point2& uv,
+                                          const Float /* footprint */) const noexcept
 {
   const uint index = getIndex(uv);
   return gray_scale_value_[index];
@@ -72,6 +73,7 @@ Float CheckerboardTexture::grayScaleValue(const Point2& uv) const noexcept
   */
 Float CheckerboardTexture::reflectiveValue(
     const Point2& uv,
+    const Float /* footprint */,
     const uint16 wavelength) const noexcept
 {
   const uint index = getIndex(uv);
@@ -86,6 +88,7 @@ Float CheckerboardTexture::reflectiveValue(
   */
 SampledSpectra CheckerboardTexture::reflectiveValue(
     const Point2& uv,
+    const Float /* footprint */,
     const WavelengthSamples& wavelengths) const noexcept
 {
   const uint index = getIndex(uv);
@@ -100,6 +103,7 @@ SampledSpectra CheckerboardTexture::reflectiveValue(
   */
 Float CheckerboardTexture::spectraValue(
     const Point2& uv,
+    const Float /* footprint */,
     const uint16 wavelength) const noexcept
 {
   const uint index = getIndex(uv);
@@ -112,6 +116,7 @@ Float CheckerboardTexture::spectraValue(
   */
 SampledSpectra CheckerboardTexture::spectraValue(
     const Point2& uv,
+    const Float /* footprint */,
     const WavelengthSamples& wavelengths) const noexcept
 {
   const uint index = getIndex(uv);
@@ -155,7 +160,7 @@ void CheckerboardTexture::initialize(System& system,
   for (std::size_t i = 0; i < 2; ++i) {
     {
       const auto color_settings = parameters.color_[i].get();
-      auto data_resource = &system.dataMemoryManager();
+      auto data_resource = &system.trackedMemoryResource(MemoryCategory::kTexture);
       auto work_resource = settings->workResource();
       const auto d = SpectralDistribution::makeDistribution(system,
                                                             color_settings,
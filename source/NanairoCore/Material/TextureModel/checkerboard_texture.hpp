@@ -52,26 +52,31 @@ class CheckerboardTexture : public TextureModel
       const WavelengthSamples& wavelengths) const noexcept override;
 
   //! Evaluate a gray scale value at the uv coordinate
-  Float grayScaleValue(const Point2& uv) const noexcept override;
+  Float grayScaleValue(const Point2& uv,
+                       const Float footprint) const noexcept override;
 
   //! Evaluate the reflective value by the wavelength at the uv coordinate
   Float reflectiveValue(
-      const Point2& uv, 
+      const Point2& uv,
+      const Float footprint,
       const uint16 wavelength) const noexcept override;
 
   //! Evaluate the reflective spectra at the uv coordinate
   SampledSpectra reflectiveValue(
       const Point2& uv,
+      const Float footprint,
       const WavelengthSamples& wavelengths) const noexcept override;
 
   //! Evaluate the spectra value by the wavelength at the uv coordinate
   Float spectraValue(
-      const Point2& uv, 
+      const Point2& uv,
+      const Float footprint,
       const uint16 wavelength) const noexcept override;
 
   //! Evaluate the spectra at the uv coordinate
   SampledSpectra spectraValue(
       const Point2& uv,
+      const Float footprint,
       const WavelengthSamples& wavelengths) const noexcept override;
 
   //! Return the checkerboard texture type
@@ -9,10 +9,13 @@
 
 #include "image_texture.hpp"
 // Standard C++ library
+#include <array>
 #include <cmath>
 #include <cstddef>
 #include <iterator>
 #include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 // Zisc
 #include "zisc/algorithm.hpp"
@@ -23,19 +26,26 @@
 #include "zisc/utility.hpp"
 // Nanairo
 #include "texture_model.hpp"
+#include "texture_tile_cache.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Color/color_conversion.hpp"
 #include "NanairoCore/Color/color_space.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
 #include "NanairoCore/Color/rgb_color.hpp"
+#include "NanairoCore/Color/rgb_spectra_table.hpp"
 #include "NanairoCore/Color/rgba_32.hpp"
+#include "NanairoCore/Color/sigmoid_spectrum.hpp"
+#include "NanairoCore/Color/tiled_image.hpp"
 #include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Color/SpectralDistribution/spectral_distribution_spectra.hpp"
+#include "NanairoCore/Data/shading_profile.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Setting/texture_setting_node.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
@@ -45,25 +55,40 @@ namespace nanairo {
   */
 ImageTexture::ImageTexture(System& system,
                            const SettingNodeBase* settings) noexcept :
-    spectra_value_table_{&system.dataMemoryManager()},
-    emissive_scale_table_{&system.dataMemoryManager()},
-    gray_scale_table_{&system.dataMemoryManager()},
-    color_index_table_{&system.dataMemoryManager()}
+    spectra_value_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    coefficient_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    rgb_value_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    emissive_scale_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    gray_scale_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    color_index_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    texel_plane_table_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    level_list_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    tile_cache_{nullptr},
+    rgb_spectra_table_{nullptr},
+    gamma_{1.0},
+    texel_plane_size_{0},
+    texture_id_{0}
 {
   initialize(system, settings);
 }
 
 /*!
   \details
-  No detailed.
+  Emitters are evaluated at the sampled points of the lights which have
+  no footprint, so the base level is used.
   */
 SampledSpectra ImageTexture::emissiveValue(
     const Point2& uv,
     const WavelengthSamples& wavelengths) const noexcept
 {
-  const uint index = getColorIndex(uv);
+  if (isTiled()) {
+    const auto texel = getTexel(uv, 0.0);
+    auto e = getSpectra(texel, wavelengths) * texel.emissive_scale_;
+    return e;
+  }
+  const uint index = getColorIndex(uv, 0.0);
   const Float scale = emissive_scale_table_[index];
-  auto e = sample(*spectra_value_table_[index], wavelengths) * scale;
+  auto e = getSpectra(index, wavelengths) * scale;
   return e;
 }
 
@@ -71,9 +96,12 @@ SampledSpectra ImageTexture::emissiveValue(
   \details
   No detailed.
   */
-Float ImageTexture::grayScaleValue(const Point2& uv) const noexcept
+Float ImageTexture::grayScaleValue(const Point2& uv,
+                                   const Float footprint) const noexcept
 {
-  const uint index = getColorIndex(uv);
+  if (isTiled())
+    return getTexel(uv, footprint).gray_scale_;
+  const uint index = getColorIndex(uv, footprint);
   return gray_scale_table_[index];
 }
 
@@ -82,10 +110,12 @@ Float ImageTexture::grayScaleValue(const Point2& uv) const noexcept
   No detailed.
   */
 Float ImageTexture::reflectiveValue(const Point2& uv,
+                                    const Float footprint,
                                     const uint16 wavelength) const noexcept
 {
-  const uint index = getColorIndex(uv);
-  auto r = spectra_value_table_[index]->getByWavelength(wavelength);
+  auto r = isTiled()  ? getSpectrum(getTexel(uv, footprint), wavelength) :
+           isDirect() ? getPlaneSpectrum(getTexelIndex(uv, footprint), wavelength)
+                      : getSpectrum(getColorIndex(uv, footprint), wavelength);
   r = zisc::clamp(r, 0.0, 1.0);
   return r;
 }
@@ -96,10 +126,12 @@ Float ImageTexture::reflectiveValue(const Point2& uv,
   */
 SampledSpectra ImageTexture::reflectiveValue(
     const Point2& uv,
+    const Float footprint,
     const WavelengthSamples& wavelengths) const noexcept
 {
-  const uint index = getColorIndex(uv);
-  auto r = sample(*spectra_value_table_[index], wavelengths);
+  auto r = isTiled()  ? getSpectra(getTexel(uv, footprint), wavelengths) :
+           isDirect() ? getPlaneSpectra(getTexelIndex(uv, footprint), wavelengths)
+                      : getSpectra(getColorIndex(uv, footprint), wavelengths);
   r.clampAll(0.0, 1.0);
   return r;
 }
@@ -109,10 +141,12 @@ SampledSpectra ImageTexture::reflectiveValue(
   No detailed.
   */
 Float ImageTexture::spectraValue(const Point2& uv,
+                                 const Float footprint,
                                  const uint16 wavelength) const noexcept
 {
-  const uint index = getColorIndex(uv);
-  return spectra_value_table_[index]->getByWavelength(wavelength);
+  return isTiled()  ? getSpectrum(getTexel(uv, footprint), wavelength) :
+         isDirect() ? getPlaneSpectrum(getTexelIndex(uv, footprint), wavelength)
+                    : getSpectrum(getColorIndex(uv, footprint), wavelength);
 }
 
 /*!
@@ -121,10 +155,12 @@ Float ImageTexture::spectraValue(const Point2& uv,
   */
 SampledSpectra ImageTexture::spectraValue(
     const Point2& uv,
+    const Float footprint,
     const WavelengthSamples& wavelengths) const noexcept
 {
-  const uint index = getColorIndex(uv);
-  return sample(*spectra_value_table_[index], wavelengths);
+  return isTiled()  ? getSpectra(getTexel(uv, footprint), wavelengths) :
+         isDirect() ? getPlaneSpectra(getTexelIndex(uv, footprint), wavelengths)
+                    : getSpectra(getColorIndex(uv, footprint), wavelengths);
 }
 
 /*!
@@ -139,21 +175,182 @@ TextureType ImageTexture::type() const noexcept
 /*!
   */
 inline
-uint ImageTexture::getColorIndex(const Point2& uv) const noexcept
+uint ImageTexture::getColorIndex(const Point2& uv,
+                                 const Float footprint) const noexcept
+{
+  const uint index = color_index_table_[getTexelIndex(uv, footprint)];
+  return index;
+}
+
+/*!
+  \details
+  The pixel is clamped to the image since the uv can be exactly one.
+  A lookup is counted as a fetch to the surface which is being profiled.
+  */
+inline
+Index2d ImageTexture::getPixel(const Point2& uv,
+                               const Index2d& resolution) noexcept
+{
+  ShadingProfile::addTextureFetch();
+  auto x = zisc::cast<uint>(uv[0] * zisc::cast<Float>(resolution[0]));
+  auto y = zisc::cast<uint>((1.0 - uv[1]) * zisc::cast<Float>(resolution[1]));
+  x = zisc::min(x, resolution[0] - 1);
+  y = zisc::min(y, resolution[1] - 1);
+  return Index2d{x, y};
+}
+
+/*!
+  */
+inline
+uint ImageTexture::getPixelIndex(const Point2& uv,
+                                 const MipLevel& level) const noexcept
+{
+  const auto& resolution = level.resolution_;
+  const auto pixel = getPixel(uv, resolution);
+  return pixel[0] + pixel[1] * resolution[0];
+}
+
+/*!
+  \details
+  The channels of a texel are read from the planes directly.
+  */
+inline
+SampledSpectra ImageTexture::getPlaneSpectra(
+    const uint texel_index,
+    const WavelengthSamples& wavelengths) const noexcept
+{
+  const Float* c = texel_plane_table_.data() + texel_index;
+  const uint n = texel_plane_size_;
+  if (isRgb()) {
+    IntensitySamples intensities;
+    for (uint i = 0; i < SampledSpectra::size(); ++i)
+      intensities.set(i, c[getRgbIndex(wavelengths[i]) * n]);
+    return SampledSpectra{wavelengths, intensities};
+  }
+  return SigmoidSpectrum{c[0], c[n], c[2 * n]}.evaluate(wavelengths);
+}
+
+/*!
+  */
+inline
+Float ImageTexture::getPlaneSpectrum(const uint texel_index,
+                                     const uint16 wavelength) const noexcept
+{
+  const Float* c = texel_plane_table_.data() + texel_index;
+  const uint n = texel_plane_size_;
+  return isRgb()
+      ? c[getRgbIndex(wavelength) * n]
+      : SigmoidSpectrum{c[0], c[n], c[2 * n]}.evaluate(wavelength);
+}
+
+/*!
+  \details
+  The RGB of a color is indexed in the same way as the RGB distributions.
+  */
+inline
+uint ImageTexture::getRgbIndex(const uint16 wavelength) noexcept
 {
-  const uint pixel_index = getPixelIndex(uv);
-  const uint index = color_index_table_[pixel_index];
+  const uint index = (wavelength == CoreConfig::blueWavelength()) ? 0 :
+                     (wavelength == CoreConfig::greenWavelength()) ? 1
+                                                                   : 2;
   return index;
 }
 
 /*!
+  \details
+  The RGB values of a color are read without a distribution in RGB mode.
+  */
+inline
+SampledSpectra ImageTexture::getSpectra(
+    const uint index,
+    const WavelengthSamples& wavelengths) const noexcept
+{
+  if (isRgb()) {
+    const auto& c = rgb_value_table_[index];
+    IntensitySamples intensities;
+    for (uint i = 0; i < SampledSpectra::size(); ++i)
+      intensities.set(i, c[getRgbIndex(wavelengths[i])]);
+    return SampledSpectra{wavelengths, intensities};
+  }
+  return isCompact()
+      ? coefficient_table_[index].evaluate(wavelengths)
+      : sample(*spectra_value_table_[index], wavelengths);
+}
+
+/*!
+  */
+inline
+SampledSpectra ImageTexture::getSpectra(
+    const Texel& texel,
+    const WavelengthSamples& wavelengths) const noexcept
+{
+  if (rgb_spectra_table_ != nullptr) {
+    const auto& c = texel.value_;
+    return SigmoidSpectrum{c[0], c[1], c[2]}.evaluate(wavelengths);
+  }
+  IntensitySamples intensities;
+  for (uint index = 0; index < SampledSpectra::size(); ++index)
+    intensities.set(index, getSpectrum(texel, wavelengths[index]));
+  return SampledSpectra{wavelengths, intensities};
+}
+
+/*!
+  */
+inline
+Float ImageTexture::getSpectrum(const uint index,
+                                const uint16 wavelength) const noexcept
+{
+  return isRgb()     ? rgb_value_table_[index][getRgbIndex(wavelength)] :
+         isCompact() ? coefficient_table_[index].evaluate(wavelength)
+                     : spectra_value_table_[index]->getByWavelength(wavelength);
+}
+
+/*!
+  */
+inline
+Float ImageTexture::getSpectrum(const Texel& texel,
+                                const uint16 wavelength) const noexcept
+{
+  const auto& c = texel.value_;
+  if (rgb_spectra_table_ != nullptr)
+    return SigmoidSpectrum{c[0], c[1], c[2]}.evaluate(wavelength);
+  return c[getRgbIndex(wavelength)];
+}
+
+/*!
+  \details
+  The tile which has the pixel is paged in from the file
+  if it isn't in the cache.
+  */
+inline
+auto ImageTexture::getTexel(const Point2& uv,
+                            const Float footprint) const noexcept -> Texel
+{
+  const uint level = selectLevel(footprint);
+  const auto pixel = getPixel(uv, tiled_image_->resolution(level));
+  constexpr uint side = TiledImage::tileSide();
+  const uint tile_index = tiled_image_->tileIndex(level,
+                                                  pixel[0] / side,
+                                                  pixel[1] / side);
+  const uint texel_index = (pixel[0] % side) + (pixel[1] % side) * side;
+  const uint64 key = TextureTileCache::makeKey(texture_id_, tile_index);
+  return tile_cache_->getTexel(key, texel_index, [this, tile_index](auto tile)
+  {
+    loadTile(tile_index, tile);
+  });
+}
+
+/*!
+  \details
+  The texels of all levels are indexed from the base level.
   */
 inline
-uint ImageTexture::getPixelIndex(const Point2& uv) const noexcept
+uint ImageTexture::getTexelIndex(const Point2& uv,
+                                 const Float footprint) const noexcept
 {
-  const auto x = zisc::cast<uint>(uv[0] * zisc::cast<Float>(resolution_[0]));
-  const auto y = zisc::cast<uint>((1.0 - uv[1]) * zisc::cast<Float>(resolution_[1]));
-  return x + y * resolution_[0];
+  const auto& level = level_list_[selectLevel(footprint)];
+  const uint pixel_index = getPixelIndex(uv, level);
+  return level.offset_ + pixel_index;
 }
 
 /*!
@@ -167,10 +364,43 @@ void ImageTexture::initialize(System& system,
   const auto texture_settings = castNode<TextureSettingNode>(settings);
 
   const auto& parameters = texture_settings->imageTextureParameters();
-  {
-    resolution_ = parameters.image_.resolution();
+  if (parameters.tiled_image_path_.empty()) {
+    initializeTables(system, parameters.image_, work_resource);
+  }
+  else {
+    const std::string file_path{parameters.tiled_image_path_};
+    initializeTiledImage(system, file_path, work_resource);
+  }
+}
+
+/*!
+  \details
+  Each level is made by averaging the 2x2 pixels of the previous level.
+  The last level has a single pixel.
+  The pixels of all levels are stored in the list from the base level.
+  */
+void ImageTexture::initializeLevels(
+    System& system,
+    const LdrImage& image,
+    zisc::pmr::memory_resource* work_resource,
+    zisc::pmr::vector<Rgba32>* pixel_list) noexcept
+{
+  pixel_list->assign(image.data().begin(), image.data().end());
+  level_list_.emplace_back(MipLevel{image.resolution(), 0});
+
+  LdrImage level_image{image.resolution(), work_resource};
+  LdrImage next_image{1, 1, work_resource};
+  level_image.data().assign(image.data().begin(), image.data().end());
+  while ((1 < level_image.widthResolution()) ||
+         (1 < level_image.heightResolution())) {
+    level_image.downsample(system.gamma(), &next_image);
+    const uint offset = zisc::cast<uint>(pixel_list->size());
+    pixel_list->insert(pixel_list->end(),
+                       next_image.data().begin(),
+                       next_image.data().end());
+    level_list_.emplace_back(MipLevel{next_image.resolution(), offset});
+    std::swap(level_image, next_image);
   }
-  initializeTables(system, parameters.image_, work_resource);
 }
 
 /*!
@@ -182,10 +412,13 @@ void ImageTexture::initializeTables(
     const LdrImage& image,
     zisc::pmr::memory_resource* work_resource) noexcept
 {
-  uint table_size = resolution_[0] * resolution_[1];
+  // Make the mip pyramid
+  zisc::pmr::vector<Rgba32> pixel_list{work_resource};
+  initializeLevels(system, image, work_resource, &pixel_list);
+  uint table_size = zisc::cast<uint>(pixel_list.size());
 
   // Make a color table
-  zisc::pmr::vector<Rgba32> color_table{image.data(), work_resource};
+  zisc::pmr::vector<Rgba32> color_table{pixel_list, work_resource};
   std::sort(color_table.begin(), color_table.end());
   auto table_end = std::unique(color_table.begin(), color_table.end());
   zisc::toBinaryTree(color_table.begin(), table_end, work_resource);
@@ -194,49 +427,259 @@ void ImageTexture::initializeTables(
   {
     color_index_table_.resize(table_size);
     auto table_begin = color_table.begin();
-    for (uint index = 0; index < table_size; ++index) {
-      auto position = zisc::searchBinaryTree(table_begin, table_end, image[index]);
-      const auto color_index = std::distance(table_begin, position);
-      color_index_table_[index] = zisc::cast<uint>(color_index);
-    }
+    auto find_colors = [this, &pixel_list, table_begin, table_end]
+    (const uint begin, const uint end)
+    {
+      for (uint index = begin; index < end; ++index) {
+        auto position = zisc::searchBinaryTree(table_begin, table_end,
+                                               pixel_list[index]);
+        const auto color_index = std::distance(table_begin, position);
+        color_index_table_[index] = zisc::cast<uint>(color_index);
+      }
+    };
+    runInChunks(system, table_size, find_colors);
   }
 
   // Make a value tables
   table_size = zisc::cast<uint>(std::distance(color_table.begin(), table_end));
-  spectra_value_table_.resize(table_size);
+  const bool is_compact = CoreConfig::compactTextureSpectraIsEnabled() &&
+                          system.isSpectraMode();
+  const bool is_rgb = system.isRgbMode();
+  if (is_compact)
+    coefficient_table_.resize(table_size);
+  else if (is_rgb)
+    rgb_value_table_.resize(table_size);
+  else
+    spectra_value_table_.resize(table_size);
   emissive_scale_table_.resize(table_size);
   gray_scale_table_.resize(table_size);
 
-  auto rgb_distribution = SpectralDistribution::makeDistribution(
-      SpectralDistribution::RepresentationType::kRgb,
-      work_resource);
+  // The spectra of the colors are interpolated from the shared table
+  const RgbSpectraTable* rgb_spectra_table = system.isSpectraMode()
+      ? &system.rgbSpectraTable(work_resource)
+      : nullptr;
+  const auto to_xyz_matrix = getRgbToXyzMatrix(system.colorSpace());
 
-  for (uint index = 0; index < table_size; ++index) {
-    auto rgb = ColorConversion::toFloatRgb(color_table[index]);
-    rgb.correctGamma(system.gamma());
-    // Float value
-    {
-      const auto to_xyz_matrix = getRgbToXyzMatrix(system.colorSpace());
-      const Float y = ColorConversion::toXyz(rgb, to_xyz_matrix).y();
-      gray_scale_table_[index] = zisc::clamp(y, 0.0, 1.0);
+  auto make_values =
+  [this, &system, &color_table, is_compact, is_rgb, rgb_spectra_table,
+   &to_xyz_matrix, work_resource](const uint begin, const uint end)
+  {
+    auto rgb_distribution = SpectralDistribution::makeDistribution(
+        SpectralDistribution::RepresentationType::kRgb,
+        work_resource);
+    for (uint index = begin; index < end; ++index) {
+      auto rgb = ColorConversion::toFloatRgb(color_table[index]);
+      rgb.correctGamma(system.gamma());
+      // Float value
+      {
+        const Float y = ColorConversion::toXyz(rgb, to_xyz_matrix).y();
+        gray_scale_table_[index] = zisc::clamp(y, 0.0, 1.0);
+      }
+      // RGB values
+      if (is_rgb) {
+        rgb_value_table_[index] = {{rgb.blue(), rgb.green(), rgb.red()}};
+        emissive_scale_table_[index] =
+            zisc::invert(rgb.blue() + rgb.green() + rgb.red());
+        continue;
+      }
+      // Spectra values
+      {
+        rgb_distribution->setByWavelength(CoreConfig::blueWavelength(), rgb.blue());
+        rgb_distribution->setByWavelength(CoreConfig::greenWavelength(), rgb.green());
+        rgb_distribution->setByWavelength(CoreConfig::redWavelength(), rgb.red());
+
+        if (is_compact) {
+          SpectraDistribution spectra;
+          rgb_spectra_table->toSpectra(rgb, &spectra);
+          coefficient_table_[index] = SigmoidSpectrum::fit(spectra);
+          emissive_scale_table_[index] =
+              zisc::invert(coefficient_table_[index].sum());
+          continue;
+        }
+
+        auto data_resource = &system.trackedMemoryResource(MemoryCategory::kTexture);
+        spectra_value_table_[index] = SpectralDistribution::makeDistribution(
+            system.colorMode(),
+            data_resource);
+        if (rgb_spectra_table != nullptr) {
+          rgb_spectra_table->toSpectra(rgb, spectra_value_table_[index].get());
+        }
+        else {
+          spectra_value_table_[index]->setColor(system,
+                                                *rgb_distribution,
+                                                work_resource);
+        }
+        emissive_scale_table_[index] =
+            zisc::invert(spectra_value_table_[index]->compensatedSum());
+      }
+    }
+  };
+  runInChunks(system, table_size, make_values);
+
+  if (CoreConfig::directTextureLayoutIsEnabled() && (is_compact || is_rgb))
+    initializeTexelPlanes(system);
+}
+
+/*!
+  \details
+  The planes hold the blue, green and red values in RGB mode,
+  otherwise the three sigmoid coefficients.
+  The color index table is kept for the gray scale and emissive values.
+  */
+void ImageTexture::initializeTexelPlanes(System& system) noexcept
+{
+  const uint n = zisc::cast<uint>(color_index_table_.size());
+  texel_plane_size_ = n;
+  texel_plane_table_.resize(3 * n);
+  auto fill_planes = [this, n](const uint begin, const uint end)
+  {
+    for (uint texel = begin; texel < end; ++texel) {
+      const uint index = color_index_table_[texel];
+      const auto& c = isRgb() ? rgb_value_table_[index]
+                              : coefficient_table_[index].coefficients();
+      for (uint channel = 0; channel < 3; ++channel)
+        texel_plane_table_[channel * n + texel] = c[channel];
     }
-    // Spectra values
+  };
+  runInChunks(system, n, fill_planes);
+}
+
+/*!
+  \details
+  The texels of a tiled texture are always stored as the sigmoid coefficients
+  in spectra mode, since a full distribution per texel is too large
+  to cache many tiles.
+  */
+void ImageTexture::initializeTiledImage(
+    System& system,
+    const std::string& file_path,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  auto data_resource = &system.trackedMemoryResource(MemoryCategory::kTexture);
+  tiled_image_ = zisc::UniqueMemoryPointer<TiledImage>::make(data_resource,
+                                                             data_resource);
+  gamma_ = system.gamma();
+  if (!tiled_image_->open(file_path, gamma_)) {
+    zisc::raiseError("ImageTextureError: The tiled image '", file_path,
+                     "' open failed.");
+  }
+  tile_cache_ = &system.textureTileCache();
+  texture_id_ = tile_cache_->issueTextureId();
+  to_xyz_matrix_ = getRgbToXyzMatrix(system.colorSpace());
+  rgb_spectra_table_ = system.isSpectraMode()
+      ? &system.rgbSpectraTable(work_resource)
+      : nullptr;
+}
+
+/*!
+  */
+inline
+bool ImageTexture::isCompact() const noexcept
+{
+  return !coefficient_table_.empty();
+}
+
+/*!
+  */
+inline
+bool ImageTexture::isRgb() const noexcept
+{
+  return !rgb_value_table_.empty();
+}
+
+/*!
+  */
+inline
+bool ImageTexture::isDirect() const noexcept
+{
+  return !texel_plane_table_.empty();
+}
+
+/*!
+  */
+inline
+bool ImageTexture::isTiled() const noexcept
+{
+  return tile_cache_ != nullptr;
+}
+
+/*!
+  \details
+  The texels are decoded in the same way as the color tables of
+  the in-memory textures.
+  */
+void ImageTexture::loadTile(const uint tile_index,
+                            TextureTileCache::Tile* tile) const noexcept
+{
+  constexpr uint side = TiledImage::tileSide();
+  std::array<Rgba32, side * side> pixels;
+  if (!tiled_image_->readTile(tile_index, pixels.data()))
+    zisc::raiseError("ImageTextureError: Reading a tile failed.");
+
+  tile->resize(pixels.size());
+  for (std::size_t index = 0; index < pixels.size(); ++index) {
+    auto rgb = ColorConversion::toFloatRgb(pixels[index]);
+    rgb.correctGamma(gamma_);
+    auto& texel = (*tile)[index];
     {
-      rgb_distribution->setByWavelength(CoreConfig::blueWavelength(), rgb.blue());
-      rgb_distribution->setByWavelength(CoreConfig::greenWavelength(), rgb.green());
-      rgb_distribution->setByWavelength(CoreConfig::redWavelength(), rgb.red());
-
-      auto data_resource = &system.dataMemoryManager();
-      spectra_value_table_[index] = SpectralDistribution::makeDistribution(
-          system.colorMode(),
-          data_resource);
-      spectra_value_table_[index]->setColor(system,
-                                            *rgb_distribution,
-                                            work_resource);
-      emissive_scale_table_[index] =
-          zisc::invert(spectra_value_table_[index]->compensatedSum());
+      const Float y = ColorConversion::toXyz(rgb, to_xyz_matrix_).y();
+      texel.gray_scale_ = zisc::clamp(y, 0.0, 1.0);
+    }
+    if (rgb_spectra_table_ != nullptr) {
+      SpectraDistribution spectra;
+      rgb_spectra_table_->toSpectra(rgb, &spectra);
+      const auto coefficients = SigmoidSpectrum::fit(spectra);
+      texel.value_ = coefficients.coefficients();
+      texel.emissive_scale_ = zisc::invert(coefficients.sum());
+    }
+    else {
+      texel.value_ = {{rgb.blue(), rgb.green(), rgb.red()}};
+      texel.emissive_scale_ = zisc::invert(rgb.blue() + rgb.green() + rgb.red());
     }
   }
 }
 
+/*!
+  \details
+  The range is split into the chunks which are the tasks of
+  the fork-join scheduler. The texture itself is a task of the scheduler,
+  so the waiting thread runs the chunks instead of blocking.
+  */
+template <typename Function> inline
+void ImageTexture::runInChunks(System& system,
+                               const uint size,
+                               Function&& function) noexcept
+{
+  constexpr uint chunk_size = 1u << 14;
+  if (size <= chunk_size) {
+    function(0u, size);
+    return;
+  }
+  TaskGroup group{system.taskScheduler()};
+  for (uint begin = 0; begin < size; begin += chunk_size) {
+    const uint end = zisc::min(begin + chunk_size, size);
+    group.run([&function, begin, end]() {function(begin, end);});
+  }
+  group.wait();
+}
+
+/*!
+  \details
+  The level whose pixel is about the size of the footprint is selected.
+  */
+inline
+uint ImageTexture::selectLevel(const Float footprint) const noexcept
+{
+  const auto& resolution = isTiled() ? tiled_image_->resolution(0)
+                                     : level_list_[0].resolution_;
+  const uint num_of_levels = isTiled() ? tiled_image_->numOfLevels()
+                                       : zisc::cast<uint>(level_list_.size());
+  const Float width = footprint *
+      zisc::cast<Float>(zisc::max(resolution[0], resolution[1]));
+  uint level = 0;
+  if (1.0 < width)
+    level = zisc::min(zisc::cast<uint>(std::log2(width)), num_of_levels - 1);
+  return level;
+}
+
 } // namespace nanairo
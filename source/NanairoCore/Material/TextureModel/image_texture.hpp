@@ -13,12 +13,18 @@
 // Standard C++ library
 #include <array>
 #include <cstddef>
+#include <string>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "texture_model.hpp"
+#include "texture_tile_cache.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+#include "NanairoCore/Color/sigmoid_spectrum.hpp"
+#include "NanairoCore/Color/tiled_image.hpp"
 #include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
@@ -26,6 +32,7 @@ namespace nanairo {
 
 // Forward declaration
 class LdrImage;
+class RgbSpectraTable;
 class SampledSpectra;
 class System;
 class WavelengthSamples;
@@ -35,7 +42,17 @@ class WavelengthSamples;
 
 /*!
   \details
-  No detailed.
+  The image is stored as a mip pyramid of the indices of the colors.
+  A level is selected by the width of the ray footprint,
+  so distant surfaces read the small levels instead of
+  random pixels across the whole image.
+  If the direct layout is enabled, the RGB values or the sigmoid coefficients
+  are also stored per texel in three planes, so a fetch doesn't
+  go through the color index.
+  A tiled texture reads the pyramid from a tiled image file instead.
+  The tiles are decoded on the first access and
+  are kept in the tile cache which is shared by all tiled textures,
+  so the memory usage is bounded regardless of the size of the images.
   */
 class ImageTexture : public TextureModel
 {
@@ -54,52 +71,151 @@ class ImageTexture : public TextureModel
       const WavelengthSamples& wavelength) const noexcept override;
 
   //! Evaluate a float value at the uv coordinate
-  Float grayScaleValue(const Point2& uv) const noexcept override;
+  Float grayScaleValue(const Point2& uv,
+                       const Float footprint) const noexcept override;
 
   //! Evaluate the reflective value by the wavelength at the uv coordinate
   Float reflectiveValue(
-      const Point2& uv, 
+      const Point2& uv,
+      const Float footprint,
       const uint16 wavelength) const noexcept override;
 
   //! Evaluate the reflective spectra at the uv coordinate
   SampledSpectra reflectiveValue(
       const Point2& uv,
+      const Float footprint,
       const WavelengthSamples& wavelength) const noexcept override;
 
   //! Evaluate the spectra value by the wavelength at the uv coordinate
   Float spectraValue(
-      const Point2& uv, 
+      const Point2& uv,
+      const Float footprint,
       const uint16 wavelength) const noexcept override;
 
   //! Evaluate the spectra at the uv coordinate
   SampledSpectra spectraValue(
       const Point2& uv,
+      const Float footprint,
       const WavelengthSamples& wavelength) const noexcept override;
 
   //! Return the image texture type
   TextureType type() const noexcept override;
 
  private:
+  /*!
+    */
+  struct MipLevel
+  {
+    Index2d resolution_;
+    uint offset_; //!< The offset of the level in the color index table
+  };
+
+  using Texel = TextureTileCache::Texel;
+
+
   //! Return the color index by the texture coordinate
-  uint getColorIndex(const Point2& uv) const noexcept;
+  uint getColorIndex(const Point2& uv, const Float footprint) const noexcept;
+
+  //! Return the pixel of the resolution by the texture coordinate
+  static Index2d getPixel(const Point2& uv, const Index2d& resolution) noexcept;
+
+  //! Return the pixel index of the level by the texture coordinate
+  uint getPixelIndex(const Point2& uv, const MipLevel& level) const noexcept;
+
+  //! Evaluate the spectra of the texel of the planes
+  SampledSpectra getPlaneSpectra(const uint texel_index,
+                                 const WavelengthSamples& wavelengths) const noexcept;
+
+  //! Evaluate the spectrum of the texel of the planes by the wavelength
+  Float getPlaneSpectrum(const uint texel_index,
+                         const uint16 wavelength) const noexcept;
+
+  //! Return the index of the wavelength in the RGB of a color
+  static uint getRgbIndex(const uint16 wavelength) noexcept;
+
+  //! Evaluate the spectra of the color
+  SampledSpectra getSpectra(const uint index,
+                            const WavelengthSamples& wavelengths) const noexcept;
+
+  //! Evaluate the spectra of the texel
+  SampledSpectra getSpectra(const Texel& texel,
+                            const WavelengthSamples& wavelengths) const noexcept;
+
+  //! Evaluate the spectrum of the color by the wavelength
+  Float getSpectrum(const uint index, const uint16 wavelength) const noexcept;
 
-  //! Return the image pixel index by the texture coordinate
-  uint getPixelIndex(const Point2& uv) const noexcept;
+  //! Evaluate the spectrum of the texel by the wavelength
+  Float getSpectrum(const Texel& texel, const uint16 wavelength) const noexcept;
+
+  //! Return the texel of the tiled image by the texture coordinate
+  Texel getTexel(const Point2& uv, const Float footprint) const noexcept;
+
+  //! Return the index of the texel of the mip pyramid by the texture coordinate
+  uint getTexelIndex(const Point2& uv, const Float footprint) const noexcept;
 
   //! Initialize
   void initialize(System& system, const SettingNodeBase* settings) noexcept;
 
+  //! Make the mip pyramid of the image
+  void initializeLevels(System& system,
+                        const LdrImage& image,
+                        zisc::pmr::memory_resource* work_resource,
+                        zisc::pmr::vector<Rgba32>* pixel_list) noexcept;
+
   //! Set color
   void initializeTables(System& system,
                         const LdrImage& image,
                         zisc::pmr::memory_resource* work_resource) noexcept;
 
+  //! Store the values of the colors per texel in the planes
+  void initializeTexelPlanes(System& system) noexcept;
+
+  //! Open the tiled image and prepare the decoding of the tiles
+  void initializeTiledImage(System& system,
+                            const std::string& file_path,
+                            zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Check if the spectra are stored as the coefficients
+  bool isCompact() const noexcept;
+
+  //! Check if the colors are stored as the RGB values
+  bool isRgb() const noexcept;
+
+  //! Check if the values are read from the texel planes
+  bool isDirect() const noexcept;
+
+  //! Check if the texture reads the tiled image
+  bool isTiled() const noexcept;
+
+  //! Read the tile from the tiled image and decode the texels
+  void loadTile(const uint tile_index,
+                TextureTileCache::Tile* tile) const noexcept;
+
+  //! Run the function over the range split into chunks in parallel
+  template <typename Function>
+  static void runInChunks(System& system,
+                          const uint size,
+                          Function&& function) noexcept;
+
+  //! Select the mip level by the width of the ray footprint
+  uint selectLevel(const Float footprint) const noexcept;
+
 
   zisc::pmr::vector<SpectralDistributionPointer> spectra_value_table_;
+  zisc::pmr::vector<SigmoidSpectrum> coefficient_table_;
+  zisc::pmr::vector<std::array<Float, 3>> rgb_value_table_; //!< b, g, r
   zisc::pmr::vector<Float> emissive_scale_table_;
   zisc::pmr::vector<Float> gray_scale_table_;
   zisc::pmr::vector<uint> color_index_table_;
-  Index2d resolution_;
+  zisc::pmr::vector<Float> texel_plane_table_; //!< [channel][texel]
+  zisc::pmr::vector<MipLevel> level_list_;
+  zisc::UniqueMemoryPointer<TiledImage> tiled_image_;
+  TextureTileCache* tile_cache_;
+  const RgbSpectraTable* rgb_spectra_table_;
+  Matrix3x3 to_xyz_matrix_;
+  Float gamma_;
+  uint texel_plane_size_;
+  uint32 texture_id_;
 };
 
 //! \} Core
@@ -0,0 +1,209 @@
+/*!
+  \file texture_lookup_cache-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TEXTURE_LOOKUP_CACHE_INL_HPP
+#define NANAIRO_TEXTURE_LOOKUP_CACHE_INL_HPP
+
+#include "texture_lookup_cache.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "texture_model.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+TextureLookupCache::TextureLookupCache(
+    const Point2& uv,
+    const Float footprint,
+    const WavelengthSamples& wavelengths) noexcept :
+        uv_{uv},
+        wavelengths_{wavelengths},
+        footprint_{footprint},
+        num_of_values_{0},
+        num_of_spectra_{0}
+{
+}
+
+/*!
+  */
+inline
+Float TextureLookupCache::footprint() const noexcept
+{
+  return footprint_;
+}
+
+/*!
+  */
+inline
+Float TextureLookupCache::grayScaleValue(const TextureModel* texture) noexcept
+{
+  return getValue(texture, LookupType::kGrayScale, 0);
+}
+
+/*!
+  */
+inline
+Float TextureLookupCache::reflectiveValue(const TextureModel* texture,
+                                          const uint16 wavelength) noexcept
+{
+  return getValue(texture, LookupType::kReflective, wavelength);
+}
+
+/*!
+  */
+inline
+const SampledSpectra& TextureLookupCache::reflectiveValue(
+    const TextureModel* texture) noexcept
+{
+  return getSpectra(texture, LookupType::kReflective);
+}
+
+/*!
+  */
+inline
+Float TextureLookupCache::spectraValue(const TextureModel* texture,
+                                       const uint16 wavelength) noexcept
+{
+  return getValue(texture, LookupType::kSpectra, wavelength);
+}
+
+/*!
+  */
+inline
+const SampledSpectra& TextureLookupCache::spectraValue(
+    const TextureModel* texture) noexcept
+{
+  return getSpectra(texture, LookupType::kSpectra);
+}
+
+/*!
+  */
+inline
+const Point2& TextureLookupCache::uv() const noexcept
+{
+  return uv_;
+}
+
+/*!
+  */
+inline
+const WavelengthSamples& TextureLookupCache::wavelengths() const noexcept
+{
+  return wavelengths_;
+}
+
+/*!
+  */
+inline
+Float TextureLookupCache::evalValue(const TextureModel* texture,
+                                    const LookupType type,
+                                    const uint16 wavelength) const noexcept
+{
+  Float value = 0.0;
+  switch (type) {
+   case LookupType::kGrayScale:
+    value = texture->grayScaleValue(uv_, footprint_);
+    break;
+   case LookupType::kReflective:
+    value = texture->reflectiveValue(uv_, footprint_, wavelength);
+    break;
+   case LookupType::kSpectra:
+    value = texture->spectraValue(uv_, footprint_, wavelength);
+    break;
+  }
+  return value;
+}
+
+/*!
+  */
+inline
+SampledSpectra TextureLookupCache::evalSpectra(
+    const TextureModel* texture,
+    const LookupType type) const noexcept
+{
+  return (type == LookupType::kReflective)
+      ? texture->reflectiveValue(uv_, footprint_, wavelengths_)
+      : texture->spectraValue(uv_, footprint_, wavelengths_);
+}
+
+/*!
+  */
+inline
+Float TextureLookupCache::getValue(const TextureModel* texture,
+                                   const LookupType type,
+                                   const uint16 wavelength) noexcept
+{
+  ZISC_ASSERT(texture != nullptr, "The texture is null.");
+  for (uint i = 0; i < num_of_values_; ++i) {
+    const auto& entry = value_list_[i];
+    if ((entry.texture_ == texture) && (entry.type_ == type) &&
+        (entry.wavelength_ == wavelength))
+      return entry.value_;
+  }
+  const Float value = evalValue(texture, type, wavelength);
+  if (num_of_values_ < valueCapacity()) {
+    value_list_[num_of_values_] = ValueEntry{texture, type, wavelength, value};
+    ++num_of_values_;
+  }
+  return value;
+}
+
+/*!
+  \details
+  The spectra which doesn't fit the cache is valid until the next lookup.
+  */
+inline
+const SampledSpectra& TextureLookupCache::getSpectra(
+    const TextureModel* texture,
+    const LookupType type) noexcept
+{
+  ZISC_ASSERT(texture != nullptr, "The texture is null.");
+  for (uint i = 0; i < num_of_spectra_; ++i) {
+    const auto& entry = spectra_entry_list_[i];
+    if ((entry.texture_ == texture) && (entry.type_ == type))
+      return spectra_list_[i];
+  }
+  if (num_of_spectra_ < spectraCapacity()) {
+    const uint index = num_of_spectra_;
+    spectra_entry_list_[index] = SpectraEntry{texture, type};
+    spectra_list_[index] = evalSpectra(texture, type);
+    ++num_of_spectra_;
+    return spectra_list_[index];
+  }
+  temp_spectra_ = evalSpectra(texture, type);
+  return temp_spectra_;
+}
+
+/*!
+  */
+inline
+constexpr uint TextureLookupCache::spectraCapacity() noexcept
+{
+  return zisc::cast<uint>(std::tuple_size<decltype(spectra_list_)>::value);
+}
+
+/*!
+  */
+inline
+constexpr uint TextureLookupCache::valueCapacity() noexcept
+{
+  return zisc::cast<uint>(std::tuple_size<decltype(value_list_)>::value);
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TEXTURE_LOOKUP_CACHE_INL_HPP
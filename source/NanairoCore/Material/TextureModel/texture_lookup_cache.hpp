@@ -0,0 +1,149 @@
+/*!
+  \file texture_lookup_cache.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TEXTURE_LOOKUP_CACHE_HPP
+#define NANAIRO_TEXTURE_LOOKUP_CACHE_HPP
+
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class TextureModel;
+class WavelengthSamples;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The cache of the texture lookups of a shading point
+  \details
+  A cache is made on the stack for a shading point, so all lookups share
+  the uv and the footprint of the point and the cache is keyed by
+  the texture and the wavelength only.
+  The same texture is often read several times in one shading event,
+  e.g. an isotropic roughness or the outer refractive index of a conductor,
+  and the second lookup returns the cached value.
+  The capacity is small since a surface reads a few textures,
+  a lookup which doesn't fit the cache is evaluated every time.
+  */
+class TextureLookupCache : public zisc::NonCopyable<TextureLookupCache>
+{
+ public:
+  //! Create a cache of the shading point
+  TextureLookupCache(const Point2& uv,
+                     const Float footprint,
+                     const WavelengthSamples& wavelengths) noexcept;
+
+
+  //! Return the footprint of the shading point
+  Float footprint() const noexcept;
+
+  //! Evaluate the gray scale value of the texture
+  Float grayScaleValue(const TextureModel* texture) noexcept;
+
+  //! Evaluate the reflective value of the texture by the wavelength
+  Float reflectiveValue(const TextureModel* texture,
+                        const uint16 wavelength) noexcept;
+
+  //! Evaluate the reflective spectra of the texture
+  const SampledSpectra& reflectiveValue(const TextureModel* texture) noexcept;
+
+  //! Evaluate the spectra value of the texture by the wavelength
+  Float spectraValue(const TextureModel* texture,
+                     const uint16 wavelength) noexcept;
+
+  //! Evaluate the spectra of the texture
+  const SampledSpectra& spectraValue(const TextureModel* texture) noexcept;
+
+  //! Return the uv coordinate of the shading point
+  const Point2& uv() const noexcept;
+
+  //! Return the sampled wavelengths
+  const WavelengthSamples& wavelengths() const noexcept;
+
+ private:
+  /*!
+    */
+  enum class LookupType : uint8
+  {
+    kGrayScale,
+    kReflective,
+    kSpectra
+  };
+
+  /*!
+    */
+  struct ValueEntry
+  {
+    const TextureModel* texture_ = nullptr;
+    LookupType type_ = LookupType::kGrayScale;
+    uint16 wavelength_ = 0;
+    Float value_ = 0.0;
+  };
+
+  /*!
+    */
+  struct SpectraEntry
+  {
+    const TextureModel* texture_ = nullptr;
+    LookupType type_ = LookupType::kReflective;
+  };
+
+
+  //! Evaluate the value of the texture
+  Float evalValue(const TextureModel* texture,
+                  const LookupType type,
+                  const uint16 wavelength) const noexcept;
+
+  //! Evaluate the spectra of the texture
+  SampledSpectra evalSpectra(const TextureModel* texture,
+                             const LookupType type) const noexcept;
+
+  //! Find or evaluate the value of the texture
+  Float getValue(const TextureModel* texture,
+                 const LookupType type,
+                 const uint16 wavelength) noexcept;
+
+  //! Find or evaluate the spectra of the texture
+  const SampledSpectra& getSpectra(const TextureModel* texture,
+                                   const LookupType type) noexcept;
+
+  //! Return the capacity of the spectra entries
+  static constexpr uint spectraCapacity() noexcept;
+
+  //! Return the capacity of the value entries
+  static constexpr uint valueCapacity() noexcept;
+
+
+  Point2 uv_;
+  const WavelengthSamples& wavelengths_;
+  Float footprint_;
+  std::array<ValueEntry, 4> value_list_;
+  std::array<SpectraEntry, 3> spectra_entry_list_;
+  std::array<SampledSpectra, 3> spectra_list_;
+  SampledSpectra temp_spectra_; //!< The spectra which doesn't fit the cache
+  uint8 num_of_values_;
+  uint8 num_of_spectra_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "texture_lookup_cache-inl.hpp"
+
+#endif // NANAIRO_TEXTURE_LOOKUP_CACHE_HPP
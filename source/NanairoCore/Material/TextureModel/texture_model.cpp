@@ -46,7 +46,7 @@ zisc::UniqueMemoryPointer<TextureModel> TextureModel::makeTexture(
   const auto texture_settings = castNode<TextureSettingNode>(settings);
 
   zisc::UniqueMemoryPointer<TextureModel> texture;
-  auto& data_resource = system.dataMemoryManager();
+  auto& data_resource = system.trackedMemoryResource(MemoryCategory::kTexture);
   switch (texture_settings->textureType()) {
     case TextureType::kValue: {
       texture = zisc::UniqueMemoryPointer<ValueTexture>::make(&data_resource,
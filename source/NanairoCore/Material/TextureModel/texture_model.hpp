@@ -48,7 +48,8 @@ enum class TextureType : uint32
 
 /*!
   \details
-  No detailed.
+  The footprint is the width of the ray footprint in the uv coordinate,
+  by which a texture can select the level of detail.
   */
 class TextureModel
 {
@@ -63,7 +64,8 @@ class TextureModel
       const WavelengthSamples& wavelengths) const noexcept = 0;
 
   //! Evaluate the gray scale value at the uv coordinate
-  virtual Float grayScaleValue(const Point2& uv) const noexcept = 0;
+  virtual Float grayScaleValue(const Point2& uv,
+                               const Float footprint) const noexcept = 0;
 
   //! Make a texture
   static zisc::UniqueMemoryPointer<TextureModel> makeTexture(
@@ -76,11 +78,13 @@ class TextureModel
   //! Evaluate the reflective value by the wavelength at the uv coordinate
   virtual Float reflectiveValue(
       const Point2& uv,
+      const Float footprint,
       const uint16 wavelength) const noexcept = 0;
 
   //! Evaluate the reflective spectra at the uv coordinate
   virtual SampledSpectra reflectiveValue(
       const Point2& uv,
+      const Float footprint,
       const WavelengthSamples& wavelengths) const noexcept = 0;
 
   //! Set the name of the texture
@@ -89,11 +93,13 @@ class TextureModel
   //! Evaluate the spectra value by the wavelength at the uv coordinate
   virtual Float spectraValue(
       const Point2& uv,
+      const Float footprint,
       const uint16 wavelength) const noexcept = 0;
 
   //! Evaluate the spectra at the uv coordinate
   virtual SampledSpectra spectraValue(
       const Point2& uv,
+      const Float footprint,
       const WavelengthSamples& wavelength) const noexcept = 0;
 
   //! Return the texture type
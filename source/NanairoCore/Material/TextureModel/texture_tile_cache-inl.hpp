@@ -0,0 +1,106 @@
+/*!
+  \file texture_tile_cache-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TEXTURE_TILE_CACHE_INL_HPP
+#define NANAIRO_TEXTURE_TILE_CACHE_INL_HPP
+
+#include "texture_tile_cache.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <mutex>
+#include <utility>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+std::size_t TextureTileCache::capacity() const noexcept
+{
+  return capacity_;
+}
+
+/*!
+  \details
+  The texel is copied under the lock,
+  so the tile can be evicted by the other threads after the return.
+  */
+template <typename Loader> inline
+auto TextureTileCache::getTexel(const uint64 key,
+                                const uint texel_index,
+                                Loader&& loader) noexcept -> Texel
+{
+  auto& s = shard(key);
+  std::unique_lock<std::mutex> lock{s.mutex_};
+  auto entry = s.entry_list_.find(key);
+  if (entry != s.entry_list_.end()) {
+    s.lru_list_.splice(s.lru_list_.begin(), s.lru_list_,
+                       entry->second.position_);
+  }
+  else {
+    Tile tile;
+    loader(&tile);
+    const std::size_t tile_size = sizeof(Texel) * tile.size();
+    evict(s, tile_size);
+    s.lru_list_.emplace_front(key);
+    entry = s.entry_list_.emplace(key,
+                                  Entry{std::move(tile), s.lru_list_.begin()}).first;
+    s.size_ += tile_size;
+  }
+  ZISC_ASSERT(texel_index < entry->second.tile_.size(),
+              "The texel index is out of range.");
+  return entry->second.tile_[texel_index];
+}
+
+/*!
+  */
+inline
+uint32 TextureTileCache::issueTextureId() noexcept
+{
+  return texture_id_count_.fetch_add(1);
+}
+
+/*!
+  */
+inline
+constexpr uint64 TextureTileCache::makeKey(const uint32 texture_id,
+                                           const uint32 tile_index) noexcept
+{
+  return (zisc::cast<uint64>(texture_id) << 32) | zisc::cast<uint64>(tile_index);
+}
+
+/*!
+  */
+inline
+constexpr uint TextureTileCache::numOfShards() noexcept
+{
+  return 16;
+}
+
+/*!
+  \details
+  The bits of the key are mixed since the neighbor tiles have
+  the consecutive keys.
+  */
+inline
+auto TextureTileCache::shard(const uint64 key) noexcept -> Shard&
+{
+  const uint64 h = (key ^ (key >> 32)) * 0x9e3779b97f4a7c15ull;
+  const uint index = zisc::cast<uint>(h >> 60) % numOfShards();
+  return shard_list_[index];
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TEXTURE_TILE_CACHE_INL_HPP
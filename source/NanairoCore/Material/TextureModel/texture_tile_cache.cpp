@@ -0,0 +1,49 @@
+/*!
+  \file texture_tile_cache.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "texture_tile_cache.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+TextureTileCache::TextureTileCache(const std::size_t capacity) noexcept :
+    capacity_{capacity},
+    texture_id_count_{0}
+{
+  static_assert(numOfShards() == std::tuple_size<decltype(shard_list_)>::value,
+                "The number of the shards is wrong.");
+}
+
+/*!
+  \details
+  Each shard has the same share of the capacity.
+  The recently used tile is kept even if it alone exceeds the share.
+  */
+void TextureTileCache::evict(Shard& shard, const std::size_t tile_size) noexcept
+{
+  const std::size_t shard_capacity = capacity() / numOfShards();
+  while (!shard.lru_list_.empty() &&
+         (shard_capacity < shard.size_ + tile_size)) {
+    const uint64 key = shard.lru_list_.back();
+    auto entry = shard.entry_list_.find(key);
+    shard.size_ -= sizeof(Texel) * entry->second.tile_.size();
+    shard.entry_list_.erase(entry);
+    shard.lru_list_.pop_back();
+  }
+}
+
+} // namespace nanairo
@@ -0,0 +1,120 @@
+/*!
+  \file texture_tile_cache.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TEXTURE_TILE_CACHE_HPP
+#define NANAIRO_TEXTURE_TILE_CACHE_HPP
+
+// Standard C++ library
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief The LRU cache of the decoded tiles of the tiled image textures
+  \details
+  The cache is shared by all tiled image textures and its size is bounded
+  by the build option. The tiles are split into the shards by the key,
+  and each shard has its own lock and LRU list, so the threads which read
+  different tiles rarely wait for each other.
+  A missing tile is loaded under the lock of its shard,
+  so a tile is loaded only once even if many threads request it.
+  */
+class TextureTileCache : public zisc::NonCopyable<TextureTileCache>
+{
+ public:
+  /*!
+    \details
+    The value is the coefficients of the sigmoid spectrum in spectra mode
+    and the linear RGB in RGB mode.
+    */
+  struct Texel
+  {
+    std::array<Float, 3> value_;
+    Float gray_scale_;
+    Float emissive_scale_;
+  };
+
+  using Tile = std::vector<Texel>;
+
+
+  //! Create a tile cache of the capacity in bytes
+  TextureTileCache(const std::size_t capacity) noexcept;
+
+
+  //! Return the capacity of the cache in bytes
+  std::size_t capacity() const noexcept;
+
+  //! Return the texel of the tile. The loader is called if the tile isn't cached
+  template <typename Loader>
+  Texel getTexel(const uint64 key,
+                 const uint texel_index,
+                 Loader&& loader) noexcept;
+
+  //! Issue the unique ID of a texture
+  uint32 issueTextureId() noexcept;
+
+  //! Make the key of the tile
+  static constexpr uint64 makeKey(const uint32 texture_id,
+                                  const uint32 tile_index) noexcept;
+
+ private:
+  /*!
+    */
+  struct Entry
+  {
+    Tile tile_;
+    std::list<uint64>::iterator position_; //!< The position in the LRU list
+  };
+
+  /*!
+    */
+  struct Shard
+  {
+    std::mutex mutex_;
+    std::unordered_map<uint64, Entry> entry_list_;
+    std::list<uint64> lru_list_; //!< The front is the most recently used
+    std::size_t size_ = 0;
+  };
+
+
+  //! Evict the least recently used tiles until the size is in the capacity
+  void evict(Shard& shard, const std::size_t tile_size) noexcept;
+
+  //! Return the number of the shards
+  static constexpr uint numOfShards() noexcept;
+
+  //! Return the shard of the key
+  Shard& shard(const uint64 key) noexcept;
+
+
+  std::array<Shard, 16> shard_list_;
+  std::size_t capacity_;
+  std::atomic<uint32> texture_id_count_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "texture_tile_cache-inl.hpp"
+
+#endif // NANAIRO_TEXTURE_TILE_CACHE_HPP
@@ -52,7 +52,8 @@ SampledSpectra UnicolorTexture::emissiveValue(
   \details
   No detailed.
   */
-Float UnicolorTexture::grayScaleValue(const Point2& /* uv */) const noexcept
+Float UnicolorTexture::grayScaleValue(const Point2& /* uv */,
+                                      const Float /* footprint */) const noexcept
 {
   return gray_scale_value_;
 }
@@ -63,6 +64,7 @@ Float UnicolorTexture::grayScaleValue(const Point2& /* uv */) const noexcept
   */
 Float UnicolorTexture::reflectiveValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const uint16 wavelength) const noexcept
 {
   Float r = color_value_->getByWavelength(wavelength);
@@ -76,6 +78,7 @@ Float UnicolorTexture::reflectiveValue(
   */
 SampledSpectra UnicolorTexture::reflectiveValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const WavelengthSamples& wavelengths) const noexcept
 {
   auto r = sample(*color_value_, wavelengths);
@@ -89,6 +92,7 @@ SampledSpectra UnicolorTexture::reflectiveValue(
   */
 Float UnicolorTexture::spectraValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const uint16 wavelength) const noexcept
 {
   return data_value_->getByWavelength(wavelength);
@@ -100,6 +104,7 @@ Float UnicolorTexture::spectraValue(
   */
 SampledSpectra UnicolorTexture::spectraValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const WavelengthSamples& wavelengths) const noexcept
 {
   return sample(*data_value_, wavelengths);
@@ -126,7 +131,7 @@ void UnicolorTexture::initialize(System& system,
 
   {
     const auto color_setttings = parameters.color_.get();
-    auto data_resource = &system.dataMemoryManager();
+    auto data_resource = &system.trackedMemoryResource(MemoryCategory::kTexture);
     auto work_resource = settings->workResource();
 
     const auto d = SpectralDistribution::makeDistribution(system,
@@ -50,7 +50,8 @@ SampledSpectra ValueTexture::emissiveValue(
   \details
   No detailed.
   */
-Float ValueTexture::grayScaleValue(const Point2& /* uv */) const noexcept
+Float ValueTexture::grayScaleValue(const Point2& /* uv */,
+                                   const Float /* footprint */) const noexcept
 {
   return reflective_value_;
 }
@@ -61,6 +62,7 @@ Float ValueTexture::grayScaleValue(const Point2& /* uv */) const noexcept
   */
 Float ValueTexture::reflectiveValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const uint16 /* wavelength */) const noexcept
 {
   return reflective_value_;
@@ -72,6 +74,7 @@ Float ValueTexture::reflectiveValue(
   */
 SampledSpectra ValueTexture::reflectiveValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const WavelengthSamples& wavelengths) const noexcept
 {
   return SampledSpectra{wavelengths, reflective_value_};
@@ -81,6 +84,7 @@ SampledSpectra ValueTexture::reflectiveValue(
   */
 Float ValueTexture::spectraValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const uint16 /* wavelength */) const noexcept
 {
   return spectra_value_;
@@ -92,6 +96,7 @@ Float ValueTexture::spectraValue(
   */
 SampledSpectra ValueTexture::spectraValue(
     const Point2& /* uv */,
+    const Float /* footprint */,
     const WavelengthSamples& wavelengths) const noexcept
 {
   return SampledSpectra{wavelengths, spectra_value_};
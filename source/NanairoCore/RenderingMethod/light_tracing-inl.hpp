@@ -0,0 +1,32 @@
+/*!
+  \file light_tracing-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_TRACING_INL_HPP
+#define NANAIRO_LIGHT_TRACING_INL_HPP
+
+#include "light_tracing.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  A batch covers the connections of tens of path sets,
+  so the sorted rays of a tile are contiguous enough to share the traversal.
+  */
+inline
+constexpr uint LightTracing::cameraConnectionBatchSize() noexcept
+{
+  return 1024;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_LIGHT_TRACING_INL_HPP
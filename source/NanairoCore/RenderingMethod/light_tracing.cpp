@@ -9,6 +9,7 @@
 
 #include "light_tracing.hpp"
 // Standard C++ library
+#include <algorithm>
 #include <atomic>
 #include <future>
 #include <memory>
@@ -34,6 +35,7 @@
 #include "NanairoCore/Data/light_source_info.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
 #include "NanairoCore/Data/shape_point.hpp"
 #include "NanairoCore/Data/wavelength_samples.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
@@ -52,9 +54,33 @@
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
 #include "NanairoCore/Setting/rendering_method_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
+#include "NanairoCore/Utility/work_memory_arena.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+LightTracing::CameraConnection::CameraConnection(
+    const Ray& shadow_ray,
+    const Spectra& contribution,
+    const Float max_distance,
+    const uint32 pixel_index) noexcept :
+        shadow_ray_{shadow_ray},
+        contribution_{contribution},
+        max_distance_{max_distance},
+        pixel_index_{pixel_index}
+{
+}
+
+/*!
+  */
+LightTracing::ThreadConnectionList::ThreadConnectionList(
+    zisc::pmr::memory_resource* mem_resource) noexcept :
+        connection_list_{mem_resource}
+{
+}
+
 /*!
   \details
   No detailed.
@@ -62,7 +88,14 @@ namespace nanairo {
 LightTracing::LightTracing(System& system,
                            const SettingNodeBase* settings,
                            const Scene& scene) noexcept :
-    RenderingMethod(system, settings)
+    RenderingMethod(system, settings),
+    light_contribution_buffer_{
+        system.imageWidthResolution() * system.imageHeightResolution() *
+            Spectra::size(),
+        decltype(light_contribution_buffer_)::allocator_type{
+            &system.dataMemoryManager()}},
+    thread_connection_list_{
+        decltype(thread_connection_list_)::allocator_type{&system.dataMemoryManager()}}
 {
   initialize(system, settings, scene);
 }
@@ -76,22 +109,26 @@ void LightTracing::render(System& system,
                           const Wavelengths& sampled_wavelengths,
                           const uint32 cycle) noexcept
 {
-  traceLightPath(system, scene, sampled_wavelengths, cycle);
+  for (uint32 s = 0; s < system.samplesPerCycle(); ++s) {
+    const uint32 sample_index = Method::calcSampleIndex(system, cycle, s);
+    traceLightPath(system, scene, sampled_wavelengths, sample_index);
+  }
 }
 
 /*!
   \details
-  No detailed.
+  The contribution is evaluated while the BxDF of the vertex is alive,
+  and only the visibility test is deferred to the batch of the thread.
   */
 void LightTracing::evalExplicitConnection(
-    const World& world,
     const Vector3* vin,
     const ShaderPointer& bxdf,
     const IntersectionInfo& intersection,
     const Spectra& light_contribution,
     const Spectra& ray_weight,
     CameraModel& camera,
-    zisc::pmr::memory_resource* mem_resource) noexcept
+    zisc::pmr::memory_resource* mem_resource,
+    zisc::pmr::vector<CameraConnection>* connection_list) noexcept
 {
   if (bxdf->type() == ShaderType::Specular)
     return;
@@ -113,17 +150,8 @@ void LightTracing::evalExplicitConnection(
   if (cos_no <= 0.0)
     return;
 
-  // Check the visibility of the camera
   const auto diff2 = (camera.sampledLensPoint() - shadow_ray.origin()).squareNorm();
   ZISC_ASSERT(0.0 < diff2, "Diff^2 isn't greater than 0.");
-  const Float max_shadow_ray_distance = zisc::sqrt(diff2);
-  const bool expect_no_hit = true;
-  const auto shadow_intersection = Method::castRay(world,
-                                                   shadow_ray,
-                                                   max_shadow_ray_distance,
-                                                   expect_no_hit);
-  if (shadow_intersection.isIntersected())
-    return;
 
   // Get the pixel location
   Index2d pixel_index;
@@ -142,7 +170,8 @@ void LightTracing::evalExplicitConnection(
   ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
 
   // Evaluate the camera importance
-  const auto sensor = camera.makeSensor(pixel_index, wavelengths, mem_resource);
+  Method::ShaderMemory sensor_memory{mem_resource};
+  const auto sensor = camera.makeSensor(pixel_index, wavelengths, &sensor_memory);
   const auto camera_dir = -shadow_ray.direction();
   const auto importance = sensor->evalRadiance(nullptr, &camera_dir, wavelengths);
   ZISC_ASSERT(!importance.hasNegative(), "The importance has negative values.");
@@ -157,20 +186,28 @@ void LightTracing::evalExplicitConnection(
   const auto contribution = (light_contribution * ray_weight * f * importance) *
                             geometry_term;
   ZISC_ASSERT(!contribution.hasNegative(), "The contribution has negative values.");
-  addLightContribution(camera, pixel_index, contribution);
+  if (contribution.isAllZero())
+    return;
+
+  // Queue the visibility test of the camera
+  const Float max_shadow_ray_distance = zisc::sqrt(diff2);
+  const uint32 index = pixel_index[0] + pixel_index[1] * camera.widthResolution();
+  connection_list->emplace_back(shadow_ray, contribution,
+                                max_shadow_ray_distance, index);
 }
 
 /*!
   \details
   No detailed.
   */
-Ray LightTracing::generateRay(const World& world,
-                              Spectra* light_contribution,
-                              const Spectra& ray_weight,
-                              CameraModel& camera,
-                              Sampler& sampler,
-                              PathState& path_state,
-                              zisc::pmr::memory_resource* mem_resource) noexcept
+Ray LightTracing::generateRay(
+    Spectra* light_contribution,
+    const Spectra& ray_weight,
+    CameraModel& camera,
+    Sampler& sampler,
+    PathState& path_state,
+    zisc::pmr::memory_resource* mem_resource,
+    zisc::pmr::vector<CameraConnection>* connection_list) noexcept
 {
   const auto& wavelengths = light_contribution->wavelengths();
   // Sample a light point
@@ -179,22 +216,23 @@ Ray LightTracing::generateRay(const World& world,
   const auto light_source_info = light_sampler.sample(sampler, path_state);
   const auto light_source = light_source_info.object();
   path_state.setDimension(SampleDimension::kLightPointSample);
-  const auto light_point_info = light_source->shape().samplePoint(sampler,
-                                                                  path_state);
+  const auto light_point_info = light_source->sampleLightPoint(sampler,
+                                                            path_state);
   ZISC_ASSERT(0.0 < light_point_info.pdf(), "The point pdf is negative.");
 
   // Sample a direction
   const auto& emitter = light_source->material().emitter();
   const IntersectionInfo intersection{light_source, light_point_info};
-  const auto light = emitter.makeLight(intersection.uv(), wavelengths, mem_resource);
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(intersection.uv(), wavelengths, &light_memory);
 
   // Evaluate the explicit connection
   const auto light_pdf = light_source_info.inverseWeight() *
                          light_point_info.inversePdf();
   ZISC_ASSERT(0.0 < light_pdf, "The light ray coefficient is negative.");
   *light_contribution = light_pdf * (*light_contribution);
-  evalExplicitConnection(world, nullptr, light, intersection,
-                         *light_contribution, ray_weight, camera, mem_resource);
+  evalExplicitConnection(nullptr, light, intersection, *light_contribution,
+                         ray_weight, camera, mem_resource, connection_list);
   // Sample a ray direction
   path_state.setDimension(SampleDimension::kLightSample1);
   const auto result = light->sample(nullptr, wavelengths,
@@ -215,15 +253,72 @@ Ray LightTracing::generateRay(const World& world,
 
 /*!
   \details
-  No detailed.
+  A light path can splat to any pixel, so the threads add the intensities
+  to the shared buffer with compare-and-swap instead of taking a lock.
+  The buffer is flushed to the film once at the end of a cycle.
   */
-void LightTracing::addLightContribution(CameraModel& camera,
-                                        const Index2d& index,
+void LightTracing::addLightContribution(const uint32 pixel_index,
                                         const Spectra& contribution) noexcept
 {
+  auto buffer = light_contribution_buffer_.data() + pixel_index * Spectra::size();
+  for (uint i = 0; i < Spectra::size(); ++i) {
+    const Float intensity = contribution.intensity(i);
+    if (intensity == 0.0)
+      continue;
+    auto& value = buffer[i];
+    Float current = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(current,
+                                        current + intensity,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightTracing::flushLightContributions(
+    System& system,
+    Scene& scene,
+    const Wavelengths& sampled_wavelengths) noexcept
+{
+  auto flush_light_contributions =
+  [this, &system, &scene, &sampled_wavelengths](const uint, const uint task_id)
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(),
+                                    "Light contribution flush task"};
+    auto& camera = scene.camera();
+    const uint width = camera.widthResolution();
+    const uint num_of_pixels = width * camera.heightResolution();
+    const auto& wavelengths = sampled_wavelengths.wavelengths();
+    const auto range = system.calcTaskRange(num_of_pixels, task_id);
+    for (uint pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
+      auto buffer = light_contribution_buffer_.data() +
+                    pixel_index * Spectra::size();
+      Spectra contribution{wavelengths};
+      bool has_contribution = false;
+      for (uint i = 0; i < Spectra::size(); ++i) {
+        const Float intensity = buffer[i].exchange(zisc::cast<Float>(0.0),
+                                                    std::memory_order_relaxed);
+        contribution.setIntensity(i, intensity);
+        has_contribution = has_contribution || (intensity != 0.0);
+      }
+      if (has_contribution) {
+        const Index2d index{pixel_index % width, pixel_index / width};
+        camera.addContribution(index, contribution);
+      }
+    }
+  };
+
   {
-    std::unique_lock<std::mutex> locker{lock_};
-    camera.addContribution(index, contribution);
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(flush_light_contributions, start, end,
+                                      &work_resource);
+    result.wait();
   }
 }
 
@@ -246,6 +341,15 @@ void LightTracing::initialize(System& system,
         scene.world(),
         settings->workResource());
   }
+  {
+    const uint num_of_threads = system.threadManager().numOfThreads();
+    thread_connection_list_.reserve(num_of_threads);
+    for (uint i = 0; i < num_of_threads; ++i) {
+      thread_connection_list_.emplace_back(&system.dataMemoryManager());
+      auto& connection_list = thread_connection_list_.back().connection_list_;
+      connection_list.reserve(2 * cameraConnectionBatchSize());
+    }
+  }
 }
 
 /*!
@@ -281,8 +385,11 @@ void LightTracing::traceLightPath(
   [this, &system, &scene, &sampled_wavelengths, cycle, &path_set_index]
   (const uint thread_id, const uint)
   {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Light path task"};
+    const auto& world = scene.world();
     const auto& camera = scene.camera();
     const uint num_of_pixels = camera.widthResolution() * camera.heightResolution();
+    const auto& connection_list = thread_connection_list_[thread_id].connection_list_;
 
     bool flag = true;
     for (uint index = path_set_index++; flag; index = path_set_index++) {
@@ -297,17 +404,21 @@ void LightTracing::traceLightPath(
         traceLightPath(system, scene, sampled_wavelengths, 
                        cycle, thread_id, path_index);
       }
+      if (cameraConnectionBatchSize() <= connection_list.size())
+        traceCameraConnections(world, camera, thread_id);
     }
+    traceCameraConnections(world, camera, thread_id);
   };
 
   {
     auto& threads = system.threadManager();
     auto& work_resource = system.globalMemoryManager();
     constexpr uint start = 0;
-    const uint end = threads.numOfThreads();
+    const uint end = system.numOfActiveThreads();
     auto result = threads.enqueueLoop(trace_light_path, start, end, &work_resource);
     result.wait();
   }
+  flushLightContributions(system, scene, sampled_wavelengths);
 }
 
 /*!
@@ -323,7 +434,11 @@ void LightTracing::traceLightPath(System& system,
 {
   // System
   auto& memory_manager = system.threadMemoryManager(thread_id);
-  auto& sampler = system.localSampler(path_index);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
+  auto& sampler = system.localSampler(thread_id, path_index);
+  auto& counter = Method::threadCounter(thread_id);
+  auto& connection_list = thread_connection_list_[thread_id].connection_list_;
   // Scene
   const auto& world = scene.world();
   auto& camera = scene.camera();
@@ -338,14 +453,16 @@ void LightTracing::traceLightPath(System& system,
 
   // Generate a light ray
   Spectra ray_weight{wavelengths, 1.0};
-  auto ray = generateRay(world, &light_contribution, ray_weight, camera,
-                         sampler, path_state, &memory_manager);
+  auto ray = generateRay(&light_contribution, ray_weight, camera,
+                         sampler, path_state, &memory_manager, &connection_list);
 
   while (true) {
-    // Reset memory
-    memory_manager.reset();
-    // Cast the ray
-    intersection = Method::castRay(world, ray);
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
+    // Cast the ray. The light ray is the primary ray of the path
+    const auto ray_type = (path_state.length() == 1) ? RayCastType::kPrimary
+                                                     : RayCastType::kSecondary;
+    intersection = Method::castRay(world, ray, ray_type, &counter);
     if (!intersection.isIntersected())
       break;
 
@@ -353,8 +470,9 @@ void LightTracing::traceLightPath(System& system,
     const auto& material = intersection.object()->material();
     const auto& surface = material.surface();
     path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
     const auto bxdf = surface.makeBxdf(intersection, wavelengths,
-                                       sampler, path_state, &memory_manager);
+                                       sampler, path_state, &bxdf_memory);
     Method::updateSelectedWavelengthInfo(bxdf,
                                          &light_contribution,
                                          &wavelength_is_selected);
@@ -364,19 +482,66 @@ void LightTracing::traceLightPath(System& system,
     const auto next_ray = Method::sampleNextRay(ray, bxdf, intersection,
                                                 &ray_weight, &next_ray_weight,
                                                 sampler, path_state);
-    if (!next_ray.isAlive())
+    // The next ray is killed only by russian roulette
+    if (!next_ray.isAlive()) {
+      counter.addRouletteTermination();
       break;
+    }
     path_state.incrementLength();
 
-    evalExplicitConnection(world, &ray.direction(), bxdf, intersection,
-                           light_contribution, ray_weight, camera, &memory_manager);
+    evalExplicitConnection(&ray.direction(), bxdf, intersection,
+                           light_contribution, ray_weight, camera, &memory_manager,
+                           &connection_list);
 
     // Update the ray
     ray = next_ray;
     ray_weight = next_ray_weight;
   }
-  // Reset memory
-  memory_manager.reset();
+  counter.addPath(path_state.length());
+}
+
+/*!
+  \details
+  The connections are sorted by the film tiles of the pixels and by the pixels
+  in a tile. The visibility rays of a tile go to the lens in the similar
+  directions, so they traverse the same nodes one after another,
+  and the visible splats are added to the buffer of a tile at once.
+  */
+void LightTracing::traceCameraConnections(const World& world,
+                                          const CameraModel& camera,
+                                          const uint thread_id) noexcept
+{
+  auto& connection_list = thread_connection_list_[thread_id].connection_list_;
+  if (connection_list.empty())
+    return;
+
+  constexpr uint tile_side = CoreConfig::sizeOfRenderingTileSide();
+  const uint width = camera.widthResolution();
+  const uint num_of_tiles_x = (width + tile_side - 1) / tile_side;
+  auto film_order = [width, num_of_tiles_x](const uint32 pixel_index)
+  {
+    const uint x = pixel_index % width;
+    const uint y = pixel_index / width;
+    const uint tile_index = (y / tile_side) * num_of_tiles_x + (x / tile_side);
+    return tile_index * (tile_side * tile_side) +
+           (y % tile_side) * tile_side + (x % tile_side);
+  };
+  std::sort(connection_list.begin(), connection_list.end(),
+  [&film_order](const CameraConnection& lhs, const CameraConnection& rhs)
+  {
+    return film_order(lhs.pixel_index_) < film_order(rhs.pixel_index_);
+  });
+
+  auto& counter = Method::threadCounter(thread_id);
+  for (const auto& connection : connection_list) {
+    const bool is_occluded = Method::testOcclusion(world,
+                                                   connection.shadow_ray_,
+                                                   connection.max_distance_,
+                                                   &counter);
+    if (!is_occluded)
+      addLightContribution(connection.pixel_index_, connection.contribution_);
+  }
+  connection_list.clear();
 }
 
 } // namespace nanairo
@@ -11,14 +11,17 @@
 #define NANAIRO_LIGHT_TRACING_HPP
 
 // Standard C++ library
+#include <atomic>
 #include <memory>
-#include <thread>
+#include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "rendering_method.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
@@ -29,7 +32,7 @@ class CameraModel;
 class IntersectionInfo;
 class Material;
 class PathState;
-class Ray;
+class RenderingCounter;
 class Sampler;
 class Scene;
 class ShaderModel;
@@ -40,7 +43,10 @@ class System;
 
 /*!
   \details
-  No detailed.
+  The camera connections of the light vertices are queued per thread,
+  and their visibility rays are traced as a batch which is sorted by
+  the film tiles of the pixels. So the rays toward the lens are coherent and
+  the splats of the visible connections are added tile by tile.
   */
 class LightTracing : public RenderingMethod
 {
@@ -65,29 +71,61 @@ class LightTracing : public RenderingMethod
               const uint32 cycle) noexcept override;
 
  private:
+  //! A camera connection whose visibility isn't tested yet
+  struct CameraConnection
+  {
+    //! Create a camera connection
+    CameraConnection(const Ray& shadow_ray,
+                     const Spectra& contribution,
+                     const Float max_distance,
+                     const uint32 pixel_index) noexcept;
+
+    Ray shadow_ray_;
+    Spectra contribution_;
+    Float max_distance_;
+    uint32 pixel_index_;
+  };
+
+  //! The connections of a thread, which don't share a cache line with the others
+  struct alignas(64) ThreadConnectionList
+  {
+    //! Create an empty list
+    ThreadConnectionList(zisc::pmr::memory_resource* mem_resource) noexcept;
+
+    zisc::pmr::vector<CameraConnection> connection_list_;
+  };
+
+
   //! Add a light contribution to buffer
-  void addLightContribution(CameraModel& camera,
-                            const Index2d& index,
+  void addLightContribution(const uint32 pixel_index,
                             const Spectra& contribution) noexcept;
 
-  //! Evaluate the explicit connection
-  void evalExplicitConnection(const World& world,
-                              const Vector3* vin,
+  //! Return the number of the connections which a thread traces at once
+  static constexpr uint cameraConnectionBatchSize() noexcept;
+
+  //! Add the buffered light contributions to the film and clear the buffer
+  void flushLightContributions(System& system,
+                               Scene& scene,
+                               const Wavelengths& sampled_wavelengths) noexcept;
+
+  //! Evaluate the explicit connection and queue its visibility ray
+  void evalExplicitConnection(const Vector3* vin,
                               const ShaderPointer& bxdf,
                               const IntersectionInfo& intersection,
                               const Spectra& light_contribution,
                               const Spectra& ray_weight,
                               CameraModel& camera,
-                              zisc::pmr::memory_resource* mem_resource) noexcept;
+                              zisc::pmr::memory_resource* mem_resource,
+                              zisc::pmr::vector<CameraConnection>* connection_list) noexcept;
 
   //! Generate a light ray
-  Ray generateRay(const World& world,
-                  Spectra* light_contribution,
+  Ray generateRay(Spectra* light_contribution,
                   const Spectra& ray_weight,
                   CameraModel& camera,
                   Sampler& sampler,
                   PathState& path_state,
-                  zisc::pmr::memory_resource* mem_resource) noexcept;
+                  zisc::pmr::memory_resource* mem_resource,
+                  zisc::pmr::vector<CameraConnection>* connection_list) noexcept;
 
   //! Initialize
   void initialize(System& system,
@@ -111,8 +149,15 @@ class LightTracing : public RenderingMethod
                       const uint thread_id,
                       const uint path_index) noexcept;
 
+  //! Test the visibility of the queued connections and splat the visible ones
+  void traceCameraConnections(const World& world,
+                              const CameraModel& camera,
+                              const uint thread_id) noexcept;
+
 
-  std::mutex lock_;
+  //! The intensities of the contributions of the pixels are added atomically
+  zisc::pmr::vector<std::atomic<Float>> light_contribution_buffer_;
+  zisc::pmr::vector<ThreadConnectionList> thread_connection_list_;
   zisc::UniqueMemoryPointer<LightSourceSampler> light_path_light_sampler_;
 };
 
@@ -120,4 +165,6 @@ class LightTracing : public RenderingMethod
 
 } // namespace nanairo
 
+#include "light_tracing-inl.hpp"
+
 #endif // NANAIRO_LIGHT_TRACING_HPP
@@ -0,0 +1,49 @@
+/*!
+  \file light_vertex_cache_bpt-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_VERTEX_CACHE_BPT_INL_HPP
+#define NANAIRO_LIGHT_VERTEX_CACHE_BPT_INL_HPP
+
+#include "light_vertex_cache_bpt.hpp"
+// Zisc
+#include "zisc/math.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The power heuristic of the path tracing is used.
+  */
+inline
+Float LightVertexCacheBpt::mis(const Float value) noexcept
+{
+  return zisc::power<CoreConfig::misHeuristicBeta()>(value);
+}
+
+/*!
+  */
+inline
+uint LightVertexCacheBpt::numOfConnections() const noexcept
+{
+  return num_of_connections_;
+}
+
+/*!
+  */
+inline
+uint LightVertexCacheBpt::numOfLightPaths() const noexcept
+{
+  return num_of_light_paths_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_LIGHT_VERTEX_CACHE_BPT_INL_HPP
@@ -0,0 +1,1060 @@
+/*!
+  \file light_vertex_cache_bpt.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "light_vertex_cache_bpt.hpp"
+// Standard C++ library
+#include <atomic>
+#include <future>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/arith_array.hpp"
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_manager.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "path_tracing.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/scene.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/world.hpp"
+#include "NanairoCore/CameraModel/camera_model.hpp"
+#include "NanairoCore/CameraModel/film.hpp"
+#include "NanairoCore/CameraModel/film_tile.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/light_source_bound.hpp"
+#include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/Data/tile_queue.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Material/shader_model.hpp"
+#include "NanairoCore/Material/EmitterModel/emitter_model.hpp"
+#include "NanairoCore/Material/EmitterModel/environment_emitter.hpp"
+#include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
+#include "NanairoCore/Sampling/russian_roulette.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Setting/rendering_method_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
+#include "NanairoCore/Utility/work_memory_arena.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+LightVertexCacheBpt::LightVertex::LightVertex(
+    const IntersectionInfo& intersection,
+    const Vector3& vin,
+    const Spectra& throughput,
+    const Float dvcm,
+    const Float dvc,
+    const bool wavelength_is_selected) noexcept :
+        intersection_{intersection},
+        vin_{vin},
+        throughput_{throughput},
+        dvcm_{dvcm},
+        dvc_{dvc},
+        wavelength_is_selected_{wavelength_is_selected ? kTrue : kFalse}
+{
+}
+
+/*!
+  */
+LightVertexCacheBpt::TaskVertexList::TaskVertexList(
+    zisc::pmr::memory_resource* mem_resource) noexcept :
+        vertex_list_{mem_resource}
+{
+}
+
+/*!
+  \details
+  No detailed.
+  */
+LightVertexCacheBpt::LightVertexCacheBpt(System& system,
+                                         const SettingNodeBase* settings,
+                                         const Scene& scene) noexcept :
+    RenderingMethod(system, settings),
+    light_vertex_list_{
+        decltype(light_vertex_list_)::allocator_type{&system.dataMemoryManager()}},
+    task_vertex_list_{
+        decltype(task_vertex_list_)::allocator_type{&system.dataMemoryManager()}}
+{
+  initialize(system, settings, scene);
+}
+
+/*!
+  */
+bool LightVertexCacheBpt::isAdaptiveSamplingSupported() const noexcept
+{
+  return true;
+}
+
+/*!
+  \details
+  Each sample of the cycle traces its own pool of light paths,
+  so the samples of the cycle don't share the light vertices.
+  */
+void LightVertexCacheBpt::render(System& system,
+                                 Scene& scene,
+                                 const Wavelengths& sampled_wavelengths,
+                                 const uint32 cycle) noexcept
+{
+  using Clock = zisc::Stopwatch::Clock;
+  const auto& stopwatch = system.stopwatch();
+  auto light_time = Clock::duration::zero();
+  auto camera_time = Clock::duration::zero();
+  HardwareCounts light_counts;
+  HardwareCounts camera_counts;
+  for (uint32 s = 0; s < system.samplesPerCycle(); ++s) {
+    const uint32 sample_index = Method::calcSampleIndex(system, cycle, s);
+    const auto start_time = stopwatch.elapsedTime();
+    const auto start_counts = system.readHardwareCounters();
+    traceLightPath(system, scene, sampled_wavelengths, sample_index);
+    const auto light_end_time = stopwatch.elapsedTime();
+    const auto light_end_counts = system.readHardwareCounters();
+    traceCameraPath(system, scene, sampled_wavelengths, sample_index);
+    const auto camera_end_time = stopwatch.elapsedTime();
+    const auto camera_end_counts = system.readHardwareCounters();
+
+    light_time += light_end_time - start_time;
+    camera_time += camera_end_time - light_end_time;
+    light_counts.merge(light_end_counts.since(start_counts));
+    camera_counts.merge(camera_end_counts.since(light_end_counts));
+  }
+
+  Method::clearCyclePhases();
+  Method::recordCyclePhase("Light path tracing", light_time, light_counts);
+  Method::recordCyclePhase("Camera pass", camera_time, camera_counts);
+}
+
+/*!
+  \details
+  The vertices are chosen by a stratified sample over the whole cache,
+  so the estimator of the connections is scaled by
+  the number of the vertices per light path and connection.
+  */
+void LightVertexCacheBpt::connectLightVertices(
+    const World& world,
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const MisState& mis_state,
+    const bool wavelength_is_selected,
+    Sampler& sampler,
+    PathState& path_state,
+    zisc::pmr::memory_resource* mem_resource,
+    RenderingCounter* counter,
+    Spectra* contribution) const noexcept
+{
+  const uint num_of_vertices = zisc::cast<uint>(light_vertex_list_.size());
+  const uint num_of_connections = numOfConnections();
+  if ((num_of_vertices == 0) || (num_of_connections == 0))
+    return;
+
+  const auto& wavelengths = ray_weight.wavelengths();
+  const Float scale = zisc::cast<Float>(num_of_vertices) /
+      zisc::cast<Float>(numOfLightPaths() * num_of_connections);
+
+  path_state.setDimension(SampleDimension::kLightSample3);
+  const Float u = sampler.draw1D(path_state);
+  for (uint j = 0; j < num_of_connections; ++j) {
+    const Float t = (u + zisc::cast<Float>(j)) / zisc::cast<Float>(num_of_connections);
+    const uint index = zisc::min(
+        zisc::cast<uint>(t * zisc::cast<Float>(num_of_vertices)),
+        num_of_vertices - 1);
+    const auto& vertex = light_vertex_list_[index];
+    const auto& light_intersection = vertex.intersection_;
+
+    // Check if the vertices face each other
+    const auto diff = light_intersection.point() - intersection.point();
+    const Float diff2 = diff.squareNorm();
+    if (diff2 <= 0.0)
+      continue;
+    const bool is_in_front = 0.0 < zisc::dot(intersection.normal(), diff);
+    if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()))
+      continue;
+
+    // Make a shadow ray
+    const auto shadow_ray = Method::makeShadowRay(intersection.point(),
+                                                  light_intersection.point(),
+                                                  intersection.normal(),
+                                                  is_in_front);
+    const auto& direction = shadow_ray.direction();
+    const Float cos_no = zisc::abs(zisc::dot(intersection.normal(), direction));
+    const Float cos_ni = zisc::abs(zisc::dot(light_intersection.normal(), direction));
+    if ((cos_no <= 0.0) || (cos_ni <= 0.0))
+      continue;
+
+    // Rebuild the BxDF of the light vertex
+    Method::BxdfMemory bxdf_memory{mem_resource};
+    const auto& surface = light_intersection.object()->material().surface();
+    path_state.setDimension(SampleDimension::kBxdfSample2);
+    const auto light_bxdf = surface.makeBxdf(light_intersection, wavelengths,
+                                             sampler, path_state, &bxdf_memory);
+    const auto light_vout = -direction;
+    const bool light_is_in_front =
+        0.0 < zisc::dot(light_intersection.normal(), light_vout);
+    if (!(light_is_in_front ? light_bxdf->isReflective()
+                            : light_bxdf->isTransmissive()))
+      continue;
+
+    // Check the visibility of the light vertex
+    const Float max_shadow_ray_distance = zisc::sqrt(diff2);
+    if (Method::testOcclusion(world, shadow_ray, max_shadow_ray_distance,
+                              counter, light_intersection.object()))
+      continue;
+
+    // Evaluate the reflectances and the pdfs of the both vertices
+    const auto camera_result = bxdf->evalRadianceAndPdf(&ray.direction(),
+                                                        &direction,
+                                                        wavelengths,
+                                                        &intersection);
+    const auto& camera_f = std::get<0>(camera_result);
+    const Float camera_pdf = std::get<1>(camera_result);
+    const auto camera_vin = -direction;
+    const auto camera_vout = -ray.direction();
+    const Float camera_reverse_pdf = bxdf->evalPdf(&camera_vin,
+                                                   &camera_vout,
+                                                   wavelengths,
+                                                   &intersection);
+    const auto light_result = light_bxdf->evalRadianceAndPdf(&vertex.vin_,
+                                                             &light_vout,
+                                                             wavelengths,
+                                                             &light_intersection);
+    const auto& light_f = std::get<0>(light_result);
+    const Float light_pdf = std::get<1>(light_result);
+    const auto light_reverse_vout = -vertex.vin_;
+    const Float light_reverse_pdf = light_bxdf->evalPdf(&direction,
+                                                        &light_reverse_vout,
+                                                        wavelengths,
+                                                        &light_intersection);
+    ZISC_ASSERT(!camera_f.hasNegative(), "The f of BxDF has negative values.");
+    ZISC_ASSERT(!light_f.hasNegative(), "The f of BxDF has negative values.");
+
+    // Calculate the MIS weight, the pdfs are converted to the area measure
+    const Float w_light = mis(camera_pdf * cos_ni / diff2) *
+        (vertex.dvcm_ + vertex.dvc_ * mis(light_reverse_pdf));
+    const Float w_camera = mis(light_pdf * cos_no / diff2) *
+        (mis_state.dvcm_ + mis_state.dvc_ * mis(camera_reverse_pdf));
+    const Float mis_weight = zisc::invert(w_light + 1.0 + w_camera);
+
+    // The primary wavelength is weighted only once
+    const Float k =
+        (wavelength_is_selected && (vertex.wavelength_is_selected_ == kTrue))
+            ? zisc::invert(wavelengths.primaryInverseProbability())
+            : 1.0;
+
+    // Calculate the contribution
+    const Float geometry_term = cos_no * cos_ni / diff2;
+    auto c = camera_contribution * ray_weight;
+    c *= camera_f;
+    c *= light_f;
+    c *= vertex.throughput_;
+    c *= geometry_term * mis_weight * scale * k;
+    ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+    *contribution += c;
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightVertexCacheBpt::evalExplicitConnection(
+    const World& world,
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const MisState& mis_state,
+    Sampler& sampler,
+    PathState& path_state,
+    zisc::pmr::memory_resource* mem_resource,
+    RenderingCounter* counter,
+    Spectra* contribution) const noexcept
+{
+  // Select the environment light or a light source object
+  const auto& light_sampler = eyePathLightSampler();
+  const Float environment_probability = light_sampler.environmentProbability();
+  if (0.0 < environment_probability) {
+    path_state.setDimension(SampleDimension::kLightSample1);
+    if (sampler.draw1D(path_state) < environment_probability) {
+      evalExplicitEnvironmentConnection(world, ray, bxdf, intersection,
+                                        camera_contribution, ray_weight,
+                                        environment_probability,
+                                        sampler, path_state, counter,
+                                        contribution);
+      return;
+    }
+  }
+
+  // Select a light source and sample a point on the light source
+  path_state.setDimension(SampleDimension::kLightSourceSelection);
+  const auto light_source_info = light_sampler.sample(intersection,
+                                                      sampler,
+                                                      path_state);
+  const auto light_source = light_source_info.object();
+
+  // Reject the light source which can't illuminate the surface point
+  const auto light_bound = light_source->lightSourceBound();
+  if ((light_bound != nullptr) &&
+      !light_bound->canIlluminate(intersection.point(),
+                                  intersection.normal(),
+                                  bxdf->isReflective(),
+                                  bxdf->isTransmissive()))
+    return;
+
+  path_state.setDimension(SampleDimension::kLightPointSample);
+  const auto light_point_info = light_source->sampleLightPoint(sampler,
+                                                            path_state);
+
+  // Check if the light is in front or back of the surface
+  const bool is_in_front = 0.0 < zisc::dot(intersection.normal(),
+                                           light_point_info.point() - intersection.point());
+  if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()))
+    return;
+
+  // Make a shadow ray
+  const auto shadow_ray = Method::makeShadowRay(intersection.point(),
+                                                light_point_info.point(),
+                                                intersection.normal(),
+                                                is_in_front);
+  const Float cos_no = (is_in_front)
+      ? zisc::dot(intersection.normal(), shadow_ray.direction())
+      : -zisc::dot(intersection.normal(), shadow_ray.direction());
+  if (cos_no <= 0.0)
+    return;
+
+  // Check the visibility of the light source
+  const Float diff2 = (light_point_info.point() - shadow_ray.origin()).squareNorm();
+  ZISC_ASSERT(0.0 < diff2, "The diff2 isn't greater than 0.");
+  const Float max_shadow_ray_distance = zisc::sqrt(diff2);
+  if (Method::testOcclusion(world, shadow_ray, max_shadow_ray_distance,
+                            counter, light_source))
+    return;
+  // Check if the ray reaches the front side of the light source
+  const auto light_dir = -shadow_ray.direction();
+  const Float cos_sni = zisc::dot(light_point_info.normal(), light_dir);
+  if (cos_sni <= 0.0)
+    return;
+  const IntersectionInfo shadow_intersection{light_source, light_point_info};
+
+  // Evaluate the surface reflectance
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto result = bxdf->evalRadianceAndPdf(&ray.direction(),
+                                               &shadow_ray.direction(),
+                                               wavelengths,
+                                               &intersection);
+  const auto& f = std::get<0>(result);
+  const Float direction_pdf = std::get<1>(result);
+  ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
+  ZISC_ASSERT(0.0 <= direction_pdf, "Pdf isn't positive.");
+  const auto reverse_vout = -ray.direction();
+  const Float reverse_pdf = bxdf->evalPdf(&light_dir,
+                                          &reverse_vout,
+                                          wavelengths,
+                                          &intersection);
+
+  // Evaluate the light radiance and the pdf of the emission
+  const auto& emitter = light_source->material().emitter();
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(shadow_intersection.uv(),
+                                       wavelengths,
+                                       &light_memory);
+  const auto light_result = light->evalRadianceAndPdf(nullptr,
+                                                      &light_dir,
+                                                      wavelengths,
+                                                      &shadow_intersection);
+  const auto& radiance = std::get<0>(light_result);
+  const auto emission_info = lightPathLightSampler().getInfo(nullptr, light_source);
+  const Float emission_pdf = std::get<1>(light_result) *
+      zisc::invert(emission_info.inverseWeight() * light_point_info.inversePdf());
+
+  // Calculate the geometry term
+  const Float geometry_term = cos_sni * cos_no / diff2;
+  ZISC_ASSERT(0.0 <= geometry_term, "Geometry term is negative.");
+
+  // Calculate the MIS weight, the pdfs are compared in the area measure
+  const Float inverse_selection_pdf = light_source_info.inverseWeight() *
+                                      light_point_info.inversePdf() /
+                                      (1.0 - environment_probability);
+  const Float w_light = mis(direction_pdf * cos_sni * inverse_selection_pdf / diff2);
+  const Float w_camera = mis(emission_pdf * cos_no * inverse_selection_pdf / diff2) *
+      (mis_state.dvcm_ + mis_state.dvc_ * mis(reverse_pdf));
+  const Float mis_weight = zisc::invert(w_light + 1.0 + w_camera);
+
+  auto c = camera_contribution * ray_weight;
+  c *= f;
+  c *= radiance;
+  c *= geometry_term * inverse_selection_pdf * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  *contribution += c;
+}
+
+/*!
+  \details
+  The light paths don't start from the environment,
+  so the explicit and implicit connections are the only strategies
+  of the paths which are lit by the environment.
+  */
+void LightVertexCacheBpt::evalExplicitEnvironmentConnection(
+    const World& world,
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const Float selection_probability,
+    Sampler& sampler,
+    PathState& path_state,
+    RenderingCounter* counter,
+    Spectra* contribution) const noexcept
+{
+  const auto& environment = *eyePathLightSampler().environmentLight();
+  path_state.setDimension(SampleDimension::kLightSample2);
+  const auto sampled_direction = environment.sample(sampler, path_state);
+  if (sampled_direction.inversePdf() <= 0.0)
+    return;
+  const auto& light_dir = sampled_direction.direction();
+
+  // Check if the light is in front or back of the surface
+  const Float cos_no = zisc::dot(intersection.normal(), light_dir);
+  const bool is_in_front = 0.0 < cos_no;
+  if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()) ||
+      (cos_no == 0.0))
+    return;
+
+  // Check the visibility of the environment
+  const Float e = is_in_front ? Method::rayCastEpsilon() : -Method::rayCastEpsilon();
+  const auto shadow_ray = Ray::makeRay(intersection.point() + e * intersection.normal(),
+                                       light_dir);
+  if (Method::testOcclusion(world, shadow_ray, std::numeric_limits<Float>::max(),
+                            counter))
+    return;
+
+  // Evaluate the surface reflectance
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto result = bxdf->evalRadianceAndPdf(&ray.direction(),
+                                               &light_dir,
+                                               wavelengths,
+                                               &intersection);
+  const auto& f = std::get<0>(result);
+  const Float direction_pdf = std::get<1>(result);
+  ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
+
+  // Evaluate the light radiance
+  const auto radiance = environment.evalRadiance(light_dir, wavelengths);
+
+  // Calculate the MIS weight, the pdfs are in the solid angle measure
+  const Float inverse_selection_pdf = sampled_direction.inversePdf() /
+                                      selection_probability;
+  const Float mis_weight = PathTracing::calcMisWeight(direction_pdf,
+                                                      inverse_selection_pdf);
+
+  auto c = camera_contribution * ray_weight;
+  c *= f;
+  c *= radiance;
+  c *= zisc::abs(cos_no) * inverse_selection_pdf * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  *contribution += c;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightVertexCacheBpt::evalImplicitConnection(
+    const Ray& ray,
+    const IntersectionInfo& intersection,
+    const IntersectionInfo& previous_intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const MisState& mis_state,
+    zisc::pmr::memory_resource* mem_resource,
+    Spectra* contribution) const noexcept
+{
+  const auto object = intersection.object();
+  if (!object->isLightSource() || intersection.isBackFace())
+    return;
+
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto vout = -ray.direction();
+
+  // Evaluate the radiance and the pdf of the emission
+  const auto& emitter = object->material().emitter();
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(intersection.uv(), wavelengths, &light_memory);
+  const auto result = light->evalRadianceAndPdf(nullptr,
+                                                &vout,
+                                                wavelengths,
+                                                &intersection);
+  const auto& radiance = std::get<0>(result);
+
+  // Calculate the MIS weight. The quantities are zero for the camera ray
+  Float mis_weight = 1.0;
+  if ((0.0 < mis_state.dvcm_) || (0.0 < mis_state.dvc_)) {
+    const Float direct_pdf = (0.0 < mis_state.dvcm_)
+        ? evalExplicitConnectionPdf(previous_intersection, object,
+                                    intersection.st())
+        : 0.0;
+    const auto emission_info = lightPathLightSampler().getInfo(nullptr, object);
+    const Float emission_pdf = std::get<1>(result) *
+        object->lightPointPdf(intersection.st()) *
+        zisc::invert(emission_info.inverseWeight());
+    const Float w_camera = mis(direct_pdf) * mis_state.dvcm_ +
+                           mis(emission_pdf) * mis_state.dvc_;
+    mis_weight = zisc::invert(1.0 + w_camera);
+  }
+
+  const auto c = (camera_contribution * ray_weight * radiance) * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  *contribution += c;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightVertexCacheBpt::evalImplicitEnvironmentConnection(
+    const Ray& ray,
+    const Float inverse_direction_pdf,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const bool explicit_connection_is_enabled,
+    Spectra* contribution) const noexcept
+{
+  const auto& light_sampler = eyePathLightSampler();
+  const auto environment = light_sampler.environmentLight();
+  if (environment == nullptr)
+    return;
+
+  // Evaluate the radiance
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto radiance = environment->evalRadiance(ray.direction(), wavelengths);
+
+  // Calculate the MIS weight
+  Float mis_weight = 1.0;
+  if (explicit_connection_is_enabled) {
+    const Float selection_pdf = light_sampler.environmentProbability() *
+                                environment->evalPdf(ray.direction());
+    mis_weight = PathTracing::calcMisWeight(selection_pdf, inverse_direction_pdf);
+  }
+
+  const auto c = (camera_contribution * ray_weight * radiance) * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  *contribution += c;
+}
+
+/*!
+  \details
+  The pdf of selecting the light source at the surface point
+  and sampling the light point of the st coordinates on the light source.
+  */
+Float LightVertexCacheBpt::evalExplicitConnectionPdf(
+    const IntersectionInfo& intersection,
+    const Object* light_source,
+    const Point2& light_point_st) const noexcept
+{
+  const auto& light_sampler = eyePathLightSampler();
+  const auto light_source_info = light_sampler.getInfo(&intersection, light_source);
+  const Float inverse_weight = light_source_info.inverseWeight();
+  const Float pdf = (0.0 < inverse_weight)
+      ? (1.0 - light_sampler.environmentProbability()) *
+        light_source->lightPointPdf(light_point_st) * zisc::invert(inverse_weight)
+      : 0.0;
+  return pdf;
+}
+
+/*!
+  */
+const LightSourceSampler& LightVertexCacheBpt::eyePathLightSampler() const noexcept
+{
+  return *eye_path_light_sampler_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightVertexCacheBpt::initialize(System& system,
+                                     const SettingNodeBase* settings,
+                                     const Scene& scene) noexcept
+{
+  const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
+  const auto& parameters = method_settings->lightVertexCacheBptParameters();
+
+  {
+    const auto sampler_type = parameters.eye_path_light_sampler_type_;
+    eye_path_light_sampler_ = LightSourceSampler::makeSampler(
+        system,
+        sampler_type,
+        scene.world(),
+        settings->workResource());
+  }
+  {
+    const auto sampler_type = parameters.light_path_light_sampler_type_;
+    light_path_light_sampler_ = LightSourceSampler::makeSampler(
+        system,
+        sampler_type,
+        scene.world(),
+        settings->workResource());
+  }
+  {
+    num_of_light_paths_ = zisc::max(zisc::cast<uint>(parameters.num_of_light_paths_),
+                                    1u);
+    num_of_connections_ = zisc::cast<uint>(parameters.num_of_connections_);
+  }
+  {
+    const uint num_of_threads = system.threadManager().numOfThreads();
+    task_vertex_list_.reserve(num_of_threads);
+    for (uint i = 0; i < num_of_threads; ++i)
+      task_vertex_list_.emplace_back(&system.dataMemoryManager());
+  }
+}
+
+/*!
+  */
+const LightSourceSampler& LightVertexCacheBpt::lightPathLightSampler() const noexcept
+{
+  return *light_path_light_sampler_;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightVertexCacheBpt::traceCameraPath(System& system,
+                                          Scene& scene,
+                                          const Wavelengths& sampled_wavelengths,
+                                          const uint32 cycle) noexcept
+{
+  auto& sampler = system.globalSampler();
+
+  // Init camera
+  {
+    PathState path_state{cycle};
+    auto& camera = scene.camera();
+    path_state.setDimension(SampleDimension::kCameraJittering);
+    camera.jitter(sampler, path_state);
+    path_state.setDimension(SampleDimension::kCameraLensSample);
+    camera.sampleLensPoint(sampler, path_state);
+  }
+
+  const uint num_of_tiles = calcNumOfTiles(scene.camera().imageResolution());
+  TileQueue tile_queue{num_of_tiles,
+                       system.threadManager().numOfThreads(),
+                       calcTileChunkSize(system, num_of_tiles),
+                       &system.globalMemoryManager()};
+
+  auto trace_camera_path =
+  [this, &system, &scene, &sampled_wavelengths, cycle, &tile_queue]
+  (const uint thread_id, const uint)
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Camera path task"};
+    auto& camera = scene.camera();
+    auto& statistics = camera.film().sampleStatistics();
+    const auto& resolution = camera.imageResolution();
+
+    auto trace_tile = [this, &system, &scene, &sampled_wavelengths, cycle,
+                       thread_id, &statistics](RenderingTile& tile)
+    {
+      // Skip the tile which has converged
+      if (!statistics.isActive(tile.current()))
+        return;
+      FilmTile film_tile{tile};
+      for (uint i = 0; i < tile.numOfPixels(); ++i) {
+        const auto& pixel_index = tile.current();
+        traceCameraPath(system, scene, sampled_wavelengths,
+                        cycle, thread_id, pixel_index, &film_tile);
+        tile.next();
+      }
+      film_tile.commit(sampled_wavelengths.wavelengths(), &statistics);
+    };
+    forEachTile(tile_queue, thread_id, resolution, trace_tile);
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = system.numOfActiveThreads();
+    auto result = threads.enqueueLoop(trace_camera_path, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  The camera path starts with the zero MIS quantities,
+  since the light paths aren't connected to the camera.
+  */
+void LightVertexCacheBpt::traceCameraPath(System& system,
+                                          Scene& scene,
+                                          const Wavelengths& sampled_wavelengths,
+                                          const uint32 cycle,
+                                          const uint thread_id,
+                                          const Index2d& pixel_index,
+                                          FilmTile* film_tile) noexcept
+{
+  // System
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
+  const uint path_index = pixel_index[0] +
+                          pixel_index[1] * system.imageWidthResolution();
+  auto& sampler = system.localSampler(thread_id, path_index);
+  auto& counter = Method::threadCounter(thread_id);
+  // Scene
+  const auto& world = scene.world();
+  const auto& camera = scene.camera();
+  // Trace info
+  PathState path_state{cycle};
+  path_state.setLength(1);
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+  auto camera_contribution = makeSampledSpectra(sampled_wavelengths);
+  Spectra contribution{wavelengths};
+  IntersectionInfo previous_intersection;
+  MisState mis_state;
+  bool wavelength_is_selected = false;
+  bool explicit_connection_is_enabled = false;
+
+  // Generate a camera ray
+  Float inverse_direction_pdf;
+  Spectra ray_weight{wavelengths, 1.0};
+  auto ray = PathTracing::generateRay(camera, pixel_index, sampler, path_state,
+                                      &memory_manager,
+                                      &camera_contribution, &inverse_direction_pdf);
+
+  while (true) {
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
+    // Cast the ray
+    const auto ray_type = (path_state.length() == 1) ? RayCastType::kPrimary
+                                                     : RayCastType::kSecondary;
+    const auto intersection = Method::castRay(world, ray, ray_type, &counter);
+    if (!intersection.isIntersected()) {
+      evalImplicitEnvironmentConnection(ray, inverse_direction_pdf,
+                                        camera_contribution, ray_weight,
+                                        explicit_connection_is_enabled,
+                                        &contribution);
+      break;
+    }
+
+    // Update the MIS quantities at the hit point
+    {
+      const Float cos_theta = zisc::abs(zisc::dot(intersection.normal(),
+                                                  ray.direction()));
+      if (cos_theta <= 0.0)
+        break;
+      const Float distance2 = zisc::power<2>(intersection.rayDistance());
+      mis_state.dvcm_ = mis_state.dvcm_ * mis(distance2) / mis(cos_theta);
+      mis_state.dvc_ = mis_state.dvc_ / mis(cos_theta);
+    }
+
+    evalImplicitConnection(ray, intersection, previous_intersection,
+                           camera_contribution, ray_weight, mis_state,
+                           &memory_manager, &contribution);
+
+    // Get a BxDF of the surface
+    const auto& material = intersection.object()->material();
+    const auto& surface = material.surface();
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
+    const auto bxdf = surface.makeBxdf(intersection, wavelengths,
+                                       sampler, path_state, &bxdf_memory);
+    Method::updateSelectedWavelengthInfo(bxdf,
+                                         &camera_contribution,
+                                         &wavelength_is_selected);
+
+    // Sample next ray
+    auto next_ray_weight = ray_weight;
+    const auto next_ray = Method::sampleNextRay(ray, bxdf, intersection,
+                                                &ray_weight, &next_ray_weight,
+                                                sampler, path_state,
+                                                &inverse_direction_pdf);
+    // The next ray is killed only by russian roulette
+    if (!next_ray.isAlive()) {
+      counter.addRouletteTermination();
+      break;
+    }
+    path_state.incrementLength();
+
+    explicit_connection_is_enabled = bxdf->type() != ShaderType::Specular;
+    if (explicit_connection_is_enabled) {
+      evalExplicitConnection(world, ray, bxdf, intersection,
+                             camera_contribution, ray_weight, mis_state,
+                             sampler, path_state, &memory_manager, &counter,
+                             &contribution);
+      connectLightVertices(world, ray, bxdf, intersection,
+                           camera_contribution, ray_weight, mis_state,
+                           wavelength_is_selected,
+                           sampler, path_state, &memory_manager, &counter,
+                           &contribution);
+    }
+
+    // Update the MIS quantities of the sampled direction
+    updateMisState(ray, next_ray, bxdf, intersection, inverse_direction_pdf,
+                   wavelengths, &mis_state);
+
+    // Update ray
+    ray = next_ray;
+    ray_weight = next_ray_weight;
+    previous_intersection = intersection;
+  }
+  counter.addPath(path_state.length());
+  film_tile->add(pixel_index, contribution);
+}
+
+/*!
+  \details
+  The light paths are split into the static ranges of the tasks and
+  the vertices of the tasks are merged in the task order,
+  so the cache is the same regardless of the scheduling of the threads.
+  */
+void LightVertexCacheBpt::traceLightPath(System& system,
+                                         Scene& scene,
+                                         const Wavelengths& sampled_wavelengths,
+                                         const uint32 cycle) noexcept
+{
+  auto trace_light_path =
+  [this, &system, &scene, &sampled_wavelengths, cycle]
+  (const uint thread_id, const uint task_id)
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Light path task"};
+    auto& vertex_list = task_vertex_list_[task_id].vertex_list_;
+    vertex_list.clear();
+    const auto range = system.calcTaskRange(numOfLightPaths(), task_id);
+    for (uint path_index = range[0]; path_index < range[1]; ++path_index) {
+      traceLightPath(system, scene, sampled_wavelengths,
+                     cycle, thread_id, path_index, &vertex_list);
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(trace_light_path, start, end, &work_resource);
+    result.wait();
+  }
+
+  // Merge the vertices of the tasks into the cache
+  light_vertex_list_.clear();
+  for (const auto& task_vertices : task_vertex_list_) {
+    const auto& vertex_list = task_vertices.vertex_list_;
+    light_vertex_list_.insert(light_vertex_list_.end(),
+                              vertex_list.begin(),
+                              vertex_list.end());
+  }
+}
+
+/*!
+  \details
+  The streams of the light paths follow the streams of the pixels,
+  so the light paths aren't correlated with the camera paths.
+  */
+void LightVertexCacheBpt::traceLightPath(
+    System& system,
+    Scene& scene,
+    const Wavelengths& sampled_wavelengths,
+    const uint32 cycle,
+    const uint thread_id,
+    const uint path_index,
+    zisc::pmr::vector<LightVertex>* vertex_list) noexcept
+{
+  // System
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
+  const uint num_of_pixels = system.imageWidthResolution() *
+                             system.imageHeightResolution();
+  auto& sampler = system.localSampler(thread_id, num_of_pixels + path_index);
+  auto& counter = Method::threadCounter(thread_id);
+  // Scene
+  const auto& world = scene.world();
+  // Trace info
+  PathState path_state{cycle};
+  path_state.setLength(1);
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+  Spectra light_contribution{wavelengths, 1.0};
+  MisState mis_state;
+  bool wavelength_is_selected = false;
+
+  // Sample a light point
+  const auto& light_sampler = lightPathLightSampler();
+  path_state.setDimension(SampleDimension::kLightSourceSelection);
+  const auto light_source_info = light_sampler.sample(sampler, path_state);
+  const auto light_source = light_source_info.object();
+  path_state.setDimension(SampleDimension::kLightPointSample);
+  const auto light_point_info = light_source->sampleLightPoint(sampler,
+                                                            path_state);
+  ZISC_ASSERT(0.0 < light_point_info.pdf(), "The point pdf is negative.");
+
+  // Sample a ray direction
+  const auto& emitter = light_source->material().emitter();
+  const IntersectionInfo light_intersection{light_source, light_point_info};
+  Method::ShaderMemory light_memory{&memory_manager};
+  const auto light = emitter.makeLight(light_intersection.uv(), wavelengths,
+                                       &light_memory);
+  path_state.setDimension(SampleDimension::kLightSample1);
+  const auto result = light->sample(nullptr, wavelengths,
+                                    sampler, path_state, &light_intersection);
+  const auto& sampled_vout = std::get<0>(result);
+  if (sampled_vout.inversePdf() <= 0.0)
+    return;
+  const Float inverse_light_pdf = light_source_info.inverseWeight() *
+                                  light_point_info.inversePdf();
+  light_contribution = (inverse_light_pdf * light_contribution) * std::get<1>(result);
+
+  // Initialize the MIS quantities of the emission.
+  // The pdf of the explicit connection is multiplied at the first hit
+  {
+    const Float inverse_emission_pdf = inverse_light_pdf * sampled_vout.inversePdf();
+    const Float cos_theta = zisc::dot(light_point_info.normal(),
+                                      sampled_vout.direction());
+    mis_state.dvcm_ = mis(inverse_emission_pdf);
+    mis_state.dvc_ = mis(cos_theta * inverse_emission_pdf);
+  }
+
+  // Generate a light ray
+  const auto& normal = light_point_info.normal();
+  const auto ray_epsilon = Method::rayCastEpsilon() * normal;
+  ZISC_ASSERT(!isZeroVector(ray_epsilon), "Ray epsilon is zero vector.");
+  auto ray = Ray::makeRay(light_point_info.point() + ray_epsilon,
+                          sampled_vout.direction());
+  Spectra ray_weight{wavelengths, 1.0};
+
+  while (true) {
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
+    // Cast the ray. The light ray is the primary ray of the path
+    const auto ray_type = (path_state.length() == 1) ? RayCastType::kPrimary
+                                                     : RayCastType::kSecondary;
+    const auto intersection = Method::castRay(world, ray, ray_type, &counter);
+    if (!intersection.isIntersected())
+      break;
+
+    // Update the MIS quantities at the hit point
+    {
+      const Float cos_theta = zisc::abs(zisc::dot(intersection.normal(),
+                                                  ray.direction()));
+      if (cos_theta <= 0.0)
+        break;
+      const Float distance2 = zisc::power<2>(intersection.rayDistance());
+      if (path_state.length() == 1)
+        mis_state.dvcm_ *= mis(evalExplicitConnectionPdf(intersection,
+                                                         light_source,
+                                                         light_point_info.st()));
+      mis_state.dvcm_ = mis_state.dvcm_ * mis(distance2) / mis(cos_theta);
+      mis_state.dvc_ = mis_state.dvc_ / mis(cos_theta);
+    }
+
+    // Get a BxDF of the surface
+    const auto& material = intersection.object()->material();
+    const auto& surface = material.surface();
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
+    const auto bxdf = surface.makeBxdf(intersection, wavelengths,
+                                       sampler, path_state, &bxdf_memory);
+    Method::updateSelectedWavelengthInfo(bxdf,
+                                         &light_contribution,
+                                         &wavelength_is_selected);
+
+    // Store the vertex which can be connected
+    if (bxdf->type() != ShaderType::Specular) {
+      vertex_list->emplace_back(intersection, ray.direction(),
+                                light_contribution * ray_weight,
+                                mis_state.dvcm_, mis_state.dvc_,
+                                wavelength_is_selected);
+    }
+
+    // Sample next ray
+    Float inverse_direction_pdf;
+    auto next_ray_weight = ray_weight;
+    const auto next_ray = Method::sampleNextRay(ray, bxdf, intersection,
+                                                &ray_weight, &next_ray_weight,
+                                                sampler, path_state,
+                                                &inverse_direction_pdf);
+    // The next ray is killed only by russian roulette
+    if (!next_ray.isAlive()) {
+      counter.addRouletteTermination();
+      break;
+    }
+    path_state.incrementLength();
+
+    // Update the MIS quantities of the sampled direction
+    updateMisState(ray, next_ray, bxdf, intersection, inverse_direction_pdf,
+                   wavelengths, &mis_state);
+
+    // Update the ray
+    ray = next_ray;
+    ray_weight = next_ray_weight;
+  }
+  counter.addPath(path_state.length());
+}
+
+/*!
+  \details
+  The specular direction is assumed to have the same pdf in the both directions.
+  */
+void LightVertexCacheBpt::updateMisState(const Ray& ray,
+                                         const Ray& next_ray,
+                                         const ShaderPointer& bxdf,
+                                         const IntersectionInfo& intersection,
+                                         const Float inverse_direction_pdf,
+                                         const WavelengthSamples& wavelengths,
+                                         MisState* mis_state) noexcept
+{
+  const Float cos_theta = zisc::abs(zisc::dot(intersection.normal(),
+                                              next_ray.direction()));
+  if (bxdf->type() == ShaderType::Specular) {
+    mis_state->dvcm_ = 0.0;
+    mis_state->dvc_ = mis_state->dvc_ * mis(cos_theta);
+  }
+  else {
+    const auto reverse_vin = -next_ray.direction();
+    const auto reverse_vout = -ray.direction();
+    const Float reverse_pdf = bxdf->evalPdf(&reverse_vin,
+                                            &reverse_vout,
+                                            wavelengths,
+                                            &intersection);
+    mis_state->dvc_ = mis(cos_theta * inverse_direction_pdf) *
+        (mis_state->dvc_ * mis(reverse_pdf) + mis_state->dvcm_);
+    mis_state->dvcm_ = mis(inverse_direction_pdf);
+  }
+}
+
+} // namespace nanairo
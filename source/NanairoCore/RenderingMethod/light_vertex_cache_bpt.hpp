@@ -0,0 +1,264 @@
+/*!
+  \file light_vertex_cache_bpt.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_VERTEX_CACHE_BPT_HPP
+#define NANAIRO_LIGHT_VERTEX_CACHE_BPT_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "rendering_method.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class CameraModel;
+class FilmTile;
+class Object;
+class PathState;
+class Ray;
+class RenderingCounter;
+class Sampler;
+class Scene;
+class ShaderModel;
+class System;
+class WavelengthSamples;
+class World;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Bidirectional path tracing with a light vertex cache
+  \details
+  A pool of light subpaths is traced in parallel before the camera pass and
+  the non-specular vertices of the subpaths are stored in a contiguous cache.
+  Each non-specular camera vertex is connected to a few vertices which are
+  chosen from the whole cache, in addition to the explicit connection to
+  a light source and the implicit connection of the emitter hits.
+  The strategies are weighted by the MIS of the recursive form,
+  the connection of a light vertex to the camera isn't performed.
+  */
+class LightVertexCacheBpt : public RenderingMethod
+{
+ public:
+  using Method = RenderingMethod;
+  using Spectra = typename Method::Spectra;
+  using Shader = ShaderModel;
+  using ShaderPointer = RenderingMethod::ShaderPointer;
+  using Wavelengths = typename Method::Wavelengths;
+
+
+  //! Initialize the light vertex cache BPT method
+  LightVertexCacheBpt(System& system,
+                      const SettingNodeBase* settings,
+                      const Scene& scene) noexcept;
+
+
+  //! Check if the method can skip the converged tiles of adaptive sampling
+  bool isAdaptiveSamplingSupported() const noexcept override;
+
+  //! Render scene using the light vertex cache BPT method
+  void render(System& system,
+              Scene& scene,
+              const Wavelengths& sampled_wavelengths,
+              const uint32 cycle) noexcept override;
+
+ private:
+  //! A non-specular vertex of a light subpath
+  struct LightVertex
+  {
+    //! Create a light vertex
+    LightVertex(const IntersectionInfo& intersection,
+                const Vector3& vin,
+                const Spectra& throughput,
+                const Float dvcm,
+                const Float dvc,
+                const bool wavelength_is_selected) noexcept;
+
+    IntersectionInfo intersection_;
+    Vector3 vin_;
+    Spectra throughput_; //!< The light contribution of the subpath to the vertex
+    Float dvcm_; //!< The MIS quantities of the recursive form
+    Float dvc_;
+    uint8 wavelength_is_selected_;
+  };
+
+  //! The vertices of a task, which don't share a cache line with the others
+  struct alignas(64) TaskVertexList
+  {
+    //! Create an empty list
+    TaskVertexList(zisc::pmr::memory_resource* mem_resource) noexcept;
+
+    zisc::pmr::vector<LightVertex> vertex_list_;
+  };
+
+  //! The MIS quantities of a subpath
+  struct MisState
+  {
+    Float dvcm_ = 0.0;
+    Float dvc_ = 0.0;
+  };
+
+
+  //! Connect the camera vertex to the cached light vertices
+  void connectLightVertices(
+      const World& world,
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const MisState& mis_state,
+      const bool wavelength_is_selected,
+      Sampler& sampler,
+      PathState& path_state,
+      zisc::pmr::memory_resource* mem_resource,
+      RenderingCounter* counter,
+      Spectra* contribution) const noexcept;
+
+  //! Evaluate the explicit connection to a light source
+  void evalExplicitConnection(
+      const World& world,
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const MisState& mis_state,
+      Sampler& sampler,
+      PathState& path_state,
+      zisc::pmr::memory_resource* mem_resource,
+      RenderingCounter* counter,
+      Spectra* contribution) const noexcept;
+
+  //! Evaluate the explicit connection to the environment light
+  void evalExplicitEnvironmentConnection(
+      const World& world,
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const Float selection_probability,
+      Sampler& sampler,
+      PathState& path_state,
+      RenderingCounter* counter,
+      Spectra* contribution) const noexcept;
+
+  //! Evaluate the implicit connection
+  void evalImplicitConnection(
+      const Ray& ray,
+      const IntersectionInfo& intersection,
+      const IntersectionInfo& previous_intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const MisState& mis_state,
+      zisc::pmr::memory_resource* mem_resource,
+      Spectra* contribution) const noexcept;
+
+  //! Evaluate the implicit connection of the ray which escapes to the environment
+  void evalImplicitEnvironmentConnection(
+      const Ray& ray,
+      const Float inverse_direction_pdf,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const bool explicit_connection_is_enabled,
+      Spectra* contribution) const noexcept;
+
+  //! Evaluate the pdf of the explicit connection to the light point in the area measure
+  Float evalExplicitConnectionPdf(const IntersectionInfo& intersection,
+                                  const Object* light_source,
+                                  const Point2& light_point_st) const noexcept;
+
+  //! Return the light source sampler for eye path
+  const LightSourceSampler& eyePathLightSampler() const noexcept;
+
+  //! Initialize
+  void initialize(System& system,
+                  const SettingNodeBase* settings,
+                  const Scene& scene) noexcept;
+
+  //! Return the light source sampler for light path
+  const LightSourceSampler& lightPathLightSampler() const noexcept;
+
+  //! Apply the MIS heuristic to the ratio of the pdfs
+  static Float mis(const Float value) noexcept;
+
+  //! Return the number of the connections of a camera vertex
+  uint numOfConnections() const noexcept;
+
+  //! Return the number of the light paths of a sample
+  uint numOfLightPaths() const noexcept;
+
+  //! Parallelize the camera paths
+  void traceCameraPath(System& system,
+                       Scene& scene,
+                       const Wavelengths& sampled_wavelengths,
+                       const uint32 cycle) noexcept;
+
+  //! Trace the camera path
+  void traceCameraPath(System& system,
+                       Scene& scene,
+                       const Wavelengths& sampled_wavelengths,
+                       const uint32 cycle,
+                       const uint thread_id,
+                       const Index2d& pixel_index,
+                       FilmTile* film_tile) noexcept;
+
+  //! Parallelize the light paths and fill the light vertex cache
+  void traceLightPath(System& system,
+                      Scene& scene,
+                      const Wavelengths& sampled_wavelengths,
+                      const uint32 cycle) noexcept;
+
+  //! Trace the light path
+  void traceLightPath(System& system,
+                      Scene& scene,
+                      const Wavelengths& sampled_wavelengths,
+                      const uint32 cycle,
+                      const uint thread_id,
+                      const uint path_index,
+                      zisc::pmr::vector<LightVertex>* vertex_list) noexcept;
+
+  //! Update the MIS quantities of the sampled direction
+  static void updateMisState(const Ray& ray,
+                             const Ray& next_ray,
+                             const ShaderPointer& bxdf,
+                             const IntersectionInfo& intersection,
+                             const Float inverse_direction_pdf,
+                             const WavelengthSamples& wavelengths,
+                             MisState* mis_state) noexcept;
+
+
+  zisc::pmr::vector<LightVertex> light_vertex_list_;
+  zisc::pmr::vector<TaskVertexList> task_vertex_list_;
+  zisc::UniqueMemoryPointer<LightSourceSampler> eye_path_light_sampler_;
+  zisc::UniqueMemoryPointer<LightSourceSampler> light_path_light_sampler_;
+  uint num_of_light_paths_;
+  uint num_of_connections_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "light_vertex_cache_bpt-inl.hpp"
+
+#endif // NANAIRO_LIGHT_VERTEX_CACHE_BPT_HPP
@@ -0,0 +1,51 @@
+/*!
+  \file path_tracing-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PATH_TRACING_INL_HPP
+#define NANAIRO_PATH_TRACING_INL_HPP
+
+#include "path_tracing.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The BxDF keeps the half of the samples,
+  so the surface of a poorly learned cell is still sampled well.
+  */
+inline
+constexpr Float PathTracing::guidingProbability() noexcept
+{
+  return 0.5;
+}
+
+/*!
+  \details
+  The vertices beyond the limit don't train the tree,
+  most of the radiance arrives at the first vertices.
+  */
+inline
+constexpr uint PathTracing::maxNumOfGuidingVertices() noexcept
+{
+  return 16;
+}
+
+/*!
+  */
+inline
+uint PathTracing::numOfWavelengthBatches() const noexcept
+{
+  return num_of_wavelength_batches_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_PATH_TRACING_INL_HPP
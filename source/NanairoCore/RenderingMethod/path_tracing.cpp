@@ -9,10 +9,15 @@
 
 #include "path_tracing.hpp"
 // Standard C++ library
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <future>
+#include <limits>
 #include <thread>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 // Zisc
 #include "zisc/arith_array.hpp"
@@ -29,20 +34,33 @@
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/world.hpp"
 #include "NanairoCore/CameraModel/camera_model.hpp"
+#include "NanairoCore/CameraModel/film.hpp"
+#include "NanairoCore/CameraModel/film_tile.hpp"
+#include "NanairoCore/Color/xyz_color_matching_function.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/light_source_bound.hpp"
 #include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/Data/object.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
+#include "NanairoCore/Data/shading_profile.hpp"
+#include "NanairoCore/Data/tile_queue.hpp"
 #include "NanairoCore/Data/wavelength_samples.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/path_guiding_tree.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Material/material.hpp"
 #include "NanairoCore/Material/shader_model.hpp"
 #include "NanairoCore/Material/EmitterModel/emitter_model.hpp"
+#include "NanairoCore/Material/EmitterModel/environment_emitter.hpp"
 #include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
 #include "NanairoCore/Sampling/russian_roulette.hpp"
 #include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
 #include "NanairoCore/Sampling/sampled_point.hpp"
 #include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "NanairoCore/Sampling/sampled_wavelengths.hpp"
@@ -50,6 +68,9 @@
 #include "NanairoCore/Sampling/Sampler/sampler.hpp"
 #include "NanairoCore/Setting/rendering_method_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
+#include "NanairoCore/Utility/work_memory_arena.hpp"
 
 namespace nanairo {
 
@@ -60,21 +81,96 @@ namespace nanairo {
 PathTracing::PathTracing(System& system,
                          const SettingNodeBase* settings,
                          const Scene& scene) noexcept :
-    RenderingMethod(system, settings)
+    RenderingMethod(system, settings),
+    guiding_tree_index_{0},
+    guiding_iterations_{0},
+    num_of_guiding_fittings_{0},
+    num_of_wavelength_batches_{1},
+    light_solid_angle_sampling_{kFalse},
+    material_sorting_{kFalse},
+    path_guiding_{kFalse}
 {
   initialize(system, settings, scene);
 }
 
+/*!
+  */
+bool PathTracing::isAdaptiveSamplingSupported() const noexcept
+{
+  return true;
+}
+
 /*!
   \details
-  No detailed.
+  The preview traces the first pixel of each block of the scale
+  with the direct lighting of the first hit.
+  */
+bool PathTracing::isPreviewSupported() const noexcept
+{
+  return true;
+}
+
+/*!
+  \details
+  A camera path depends only on the wavelengths of its own tile.
+  */
+bool PathTracing::isTileWavelengthSamplingSupported() const noexcept
+{
+  return true;
+}
+
+/*!
+  \details
+  The guiding tree which was fitted during the previous cycle is installed
+  before the cycle, the rendering doesn't wait for the fitting.
   */
 void PathTracing::render(System& system,
                          Scene& scene,
                          const Wavelengths& sampled_wavelengths,
                          const uint32 cycle) noexcept
 {
+  if (isPathGuidingEnabled())
+    updateGuidingTree();
   traceCameraPath(system, scene, sampled_wavelengths, cycle);
+  if (isPathGuidingEnabled())
+    fitGuidingTree();
+}
+
+/*!
+  \details
+  The pdf of the BxDF is used if the surface isn't guided.
+  */
+Float PathTracing::evalGuidedPdf(const PathGuidingTree* guiding_tree,
+                                 const uint guiding_leaf,
+                                 const Vector3& direction,
+                                 const Float bxdf_pdf) noexcept
+{
+  Float pdf = bxdf_pdf;
+  if ((guiding_tree != nullptr) &&
+      (guiding_leaf != PathGuidingTree::invalidLeaf()) &&
+      guiding_tree->isTrained(guiding_leaf)) {
+    constexpr Float a = guidingProbability();
+    pdf = a * guiding_tree->evalPdf(guiding_leaf, direction) + (1.0 - a) * pdf;
+  }
+  return pdf;
+}
+
+/*!
+  \details
+  The pdf is the same as the light point which is sampled from the reference.
+  */
+Float PathTracing::evalLightPointPdf(
+    const LightConnection& connection,
+    const Point3& reference,
+    const IntersectionInfo& light_intersection) noexcept
+{
+  const auto light_source = light_intersection.object();
+  const bool solid_angle_sampling = (connection.solid_angle_sampling_ == kTrue) &&
+                                    (light_source->emissionDistribution() == nullptr);
+  return solid_angle_sampling
+      ? light_source->shape().solidAnglePointPdf(reference,
+                                                  light_intersection.point())
+      : light_source->lightPointPdf(light_intersection.st());
 }
 
 /*!
@@ -88,94 +184,36 @@ void PathTracing::evalExplicitConnection(
     const IntersectionInfo& intersection,
     const Spectra& camera_contribution,
     const Spectra& ray_weight,
+    const uint guiding_leaf,
     const bool explicit_connection_is_enabled,
     const bool implicit_connection_is_enabled,
     Sampler& sampler,
     PathState& path_state,
     zisc::pmr::memory_resource* mem_resource,
+    RenderingCounter* counter,
+    ShadingProfile* profile,
     Spectra* contribution) const noexcept
 {
   if (!explicit_connection_is_enabled)
     return;
 
-  // Select a light source and sample a point on the light source
-  const auto& light_sampler = eyePathLightSampler();
-  path_state.setDimension(SampleDimension::kLightSourceSelection);
-  const auto light_source_info = light_sampler.sample(intersection,
-                                                      sampler,
-                                                      path_state);
-  const auto light_source = light_source_info.object();
-  path_state.setDimension(SampleDimension::kLightPointSample);
-  const auto light_point_info = light_source->shape().samplePoint(sampler,
-                                                                  path_state);
-
-  // Check if the light is in front or back of the surface
-  const bool is_in_front = 0.0 < zisc::dot(intersection.normal(),
-                                           light_point_info.point() - intersection.point());
-  if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()))
-    return;
-
-  // Make a shadow ray
-  const auto shadow_ray = Method::makeShadowRay(intersection.point(),
-                                                light_point_info.point(),
-                                                intersection.normal(),
-                                                is_in_front);
-  const Float cos_no = (is_in_front)
-      ? zisc::dot(intersection.normal(), shadow_ray.direction())
-      : -zisc::dot(intersection.normal(), shadow_ray.direction());
-  if (cos_no <= 0.0)
+  ShadowConnection shadow_connection;
+  const bool is_sampled = sampleExplicitConnection(lightConnection(), ray, bxdf,
+                                                   intersection,
+                                                   camera_contribution, ray_weight,
+                                                   guiding_leaf,
+                                                   implicit_connection_is_enabled,
+                                                   sampler, path_state,
+                                                   mem_resource, profile,
+                                                   &shadow_connection);
+  if (!is_sampled)
     return;
 
   // Check the visibility of the light source
-  const Float diff2 = (light_point_info.point() - shadow_ray.origin()).squareNorm();
-  ZISC_ASSERT(0.0 < diff2, "The diff2 isn't greater than 0.");
-  const Float max_shadow_ray_distance = Method::calcShadowRayDistance(diff2);
-  const auto shadow_intersection = Method::castRay(world,
-                                                   shadow_ray,
-                                                   max_shadow_ray_distance);
-  if (shadow_intersection.object() != light_source ||
-      shadow_intersection.isBackFace())
-    return;
-
-  // Evaluate the surface reflectance
-  const auto& wavelengths = ray_weight.wavelengths();
-  const auto result = bxdf->evalRadianceAndPdf(&ray.direction(),
-                                               &shadow_ray.direction(),
-                                               wavelengths,
-                                               &intersection);
-  const auto& f = std::get<0>(result);
-  const auto& direction_pdf = std::get<1>(result);
-  ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
-  ZISC_ASSERT(0.0 <= direction_pdf, "Pdf isn't positive.");
-
-  // Evaluate the light radiance
-  const auto& emitter = light_source->material().emitter();
-  const auto light = emitter.makeLight(shadow_intersection.uv(),
-                                       wavelengths,
-                                       mem_resource);
-  const auto light_dir = -shadow_ray.direction();
-  const auto radiance = light->evalRadiance(nullptr,
-                                            &light_dir,
-                                            wavelengths,
-                                            &shadow_intersection);
-
-  // Calculate the geometry term
-  const Float cos_sni = zisc::dot(shadow_intersection.normal(), light_dir);
-  const Float geometry_term = cos_sni * cos_no / diff2;
-  ZISC_ASSERT(0.0 <= geometry_term, "Geometry term is negative.");
-
-  // Calculate the MIS weight
-  const Float inverse_selection_pdf = light_source_info.inverseWeight() *
-                                      light_point_info.inversePdf();
-  const Float mis_weight = implicit_connection_is_enabled
-      ? calcMisWeight(direction_pdf, inverse_selection_pdf)
-      : 1.0;
-
-  // Calculate the contribution
-  const auto c = (camera_contribution * ray_weight * f * radiance) *
-                 (geometry_term * inverse_selection_pdf * mis_weight);
-  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
-  *contribution += c;
+  if (!Method::testOcclusion(world, shadow_connection.shadow_ray_,
+                             shadow_connection.max_distance_, counter,
+                             shadow_connection.light_source_))
+    *contribution += shadow_connection.contribution_;
 }
 
 /*!
@@ -183,31 +221,34 @@ void PathTracing::evalExplicitConnection(
   No detailed.
   */
 void PathTracing::evalImplicitConnection(
-    const World& /* world */,
+    const LightConnection& connection,
     const Ray& ray,
     const Float inverse_direction_pdf,
     const IntersectionInfo& intersection,
+    const IntersectionInfo& previous_intersection,
     const Spectra& camera_contribution,
     const Spectra& ray_weight,
     const bool implicit_connection_is_enabled,
     const bool explicit_connection_is_enabled,
     zisc::pmr::memory_resource* mem_resource,
-    Spectra* contribution) const noexcept
+    Spectra* contribution) noexcept
 {
   if (!implicit_connection_is_enabled)
     return;
 
   const auto object = intersection.object();
-  const auto& material = object->material();
-  if (!material.isLightSource() || intersection.isBackFace())
+  if (!object->isLightSource() || intersection.isBackFace())
     return;
 
+  const auto& material = object->material();
+
   const auto& wavelengths = ray_weight.wavelengths();
   const auto vout = -ray.direction();
 
   // Get the light
   const auto& emitter = material.emitter();
-  const auto light = emitter.makeLight(intersection.uv(), wavelengths, mem_resource);
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(intersection.uv(), wavelengths, &light_memory);
 
   // Evaluate the radiance
   const auto radiance = light->evalRadiance(nullptr,
@@ -218,10 +259,49 @@ void PathTracing::evalImplicitConnection(
   // Calculate the MIS weight
   Float mis_weight = 1.0;
   if (explicit_connection_is_enabled) {
-    const auto& light_sampler = eyePathLightSampler();
-    const auto light_source_info = light_sampler.getInfo(intersection, object);
-    const Float selection_pdf = zisc::invert(light_source_info.inverseWeight() *
-                                             object->shape().surfaceArea());
+    const auto& light_sampler = *connection.light_sampler_;
+    const auto light_source_info = light_sampler.getInfo(&previous_intersection,
+                                                         object);
+    const Float selection_pdf = (1.0 - light_sampler.environmentProbability()) *
+        evalLightPointPdf(connection, previous_intersection.point(), intersection) *
+        zisc::invert(light_source_info.inverseWeight());
+    mis_weight = calcMisWeight(selection_pdf, inverse_direction_pdf);
+  }
+
+  // Calculate the contribution
+  const auto c = (camera_contribution * ray_weight * radiance) * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  *contribution += c;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void PathTracing::evalImplicitEnvironmentConnection(
+    const LightConnection& connection,
+    const Ray& ray,
+    const Float inverse_direction_pdf,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const bool implicit_connection_is_enabled,
+    const bool explicit_connection_is_enabled,
+    Spectra* contribution) noexcept
+{
+  const auto& light_sampler = *connection.light_sampler_;
+  const auto environment = light_sampler.environmentLight();
+  if (!implicit_connection_is_enabled || (environment == nullptr))
+    return;
+
+  // Evaluate the radiance
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto radiance = environment->evalRadiance(ray.direction(), wavelengths);
+
+  // Calculate the MIS weight
+  Float mis_weight = 1.0;
+  if (explicit_connection_is_enabled) {
+    const Float selection_pdf = light_sampler.environmentProbability() *
+                                environment->evalPdf(ray.direction());
     mis_weight = calcMisWeight(selection_pdf, inverse_direction_pdf);
   }
 
@@ -238,6 +318,89 @@ const LightSourceSampler& PathTracing::eyePathLightSampler() const noexcept
   return *eye_path_light_sampler_;
 }
 
+/*!
+  \details
+  The training data of the cycle is taken before the next cycle records,
+  then the spare tree is fitted to it on another thread.
+  The fitting is skipped if the previous one hasn't been installed yet.
+  */
+void PathTracing::fitGuidingTree() noexcept
+{
+  if (!isGuidingTrainingEnabled() || guiding_fitting_task_.valid())
+    return;
+
+  auto& source = guidingTree();
+  auto& tree = *guiding_tree_list_[1 - guiding_tree_index_];
+  tree.collectTrainingData(&source);
+  ++num_of_guiding_fittings_;
+
+  auto fit = [this, &source, &tree]()
+  {
+    tree.fit(source, guiding_memory_.get());
+  };
+  guiding_fitting_task_ = std::async(std::launch::async, fit);
+}
+
+/*!
+  \details
+  A specular surface isn't guided since its direction is a delta function.
+  */
+uint PathTracing::findGuidingLeaf(const ShaderPointer& bxdf,
+                                  const IntersectionInfo& intersection) const noexcept
+{
+  const bool is_guided = isPathGuidingEnabled() &&
+                         (bxdf->type() != ShaderType::Specular);
+  return is_guided
+      ? guidingTree().findLeaf(intersection.point())
+      : PathGuidingTree::invalidLeaf();
+}
+
+/*!
+  \details
+  The rays of the pixels of the tile are emitted into the packet at once
+  by the camera, which is the front end of the packet traversal.
+  The preview traces only the first pixel of each block.
+  */
+uint PathTracing::generateRays(const CameraModel& camera,
+                               const Wavelengths& sampled_wavelengths,
+                               RenderingTile& tile,
+                               CameraRayPacket* packet,
+                               Index2d* pixel_index_list,
+                               Spectra* camera_contribution_list,
+                               Float* inverse_direction_pdf_list) const noexcept
+{
+  ZISC_ASSERT(tile.numOfPixels() <= CameraRayPacket::size(),
+              "The tile is too large.");
+  const uint preview_scale = Method::previewScale();
+  uint num_of_pixels = 0;
+  for (uint p = 0; p < tile.numOfPixels(); ++p, tile.next()) {
+    const auto& pixel_index = tile.current();
+    if ((1 < preview_scale) && (((pixel_index[0] % preview_scale) != 0) ||
+                                ((pixel_index[1] % preview_scale) != 0)))
+      continue;
+    const uint i = num_of_pixels++;
+    pixel_index_list[i] = pixel_index;
+    camera_contribution_list[i] = makeSampledSpectra(sampled_wavelengths);
+  }
+  camera.generateRays(pixel_index_list, num_of_pixels, packet,
+                      inverse_direction_pdf_list);
+  return num_of_pixels;
+}
+
+/*!
+  */
+PathGuidingTree& PathTracing::guidingTree() noexcept
+{
+  return *guiding_tree_list_[guiding_tree_index_];
+}
+
+/*!
+  */
+const PathGuidingTree& PathTracing::guidingTree() const noexcept
+{
+  return *guiding_tree_list_[guiding_tree_index_];
+}
+
 /*!
   \details
   No detailed.
@@ -254,7 +417,8 @@ Ray PathTracing::generateRay(const CameraModel& camera,
   // Sample a ray origin
   const auto& lens_point = camera.sampledLensPoint();
   // Sample a ray direction
-  const auto sensor = camera.makeSensor(pixel_index, wavelengths, mem_resource);
+  Method::ShaderMemory sensor_memory{mem_resource};
+  const auto sensor = camera.makeSensor(pixel_index, wavelengths, &sensor_memory);
   path_state.setDimension(SampleDimension::kSensorSample1);
   const auto result = sensor->sample(nullptr, wavelengths, sampler, path_state);
   const auto& sampled_vout = std::get<0>(result);
@@ -263,7 +427,9 @@ Ray PathTracing::generateRay(const CameraModel& camera,
 
   ZISC_ASSERT(inverse_direction_pdf != nullptr, "The pdf is null.");
   *inverse_direction_pdf = sampled_vout.inversePdf();
-  return Ray::makeRay(lens_point, sampled_vout.direction());
+  auto ray = Ray::makeRay(lens_point, sampled_vout.direction());
+  ray.setCone(0.0, camera.pixelSpreadAngle());
+  return ray;
 }
 
 /*!
@@ -285,6 +451,413 @@ void PathTracing::initialize(System& system,
         scene.world(),
         settings->workResource());
   }
+  {
+    material_sorting_ = parameters.material_sorting_;
+  }
+  {
+    light_solid_angle_sampling_ = parameters.light_solid_angle_sampling_;
+  }
+  {
+    // A batch has the different primary wavelength from the others
+    const uint batches = zisc::cast<uint>(parameters.wavelength_batches_);
+    num_of_wavelength_batches_ = system.isSpectraMode()
+        ? zisc::clamp(batches, 1u, CoreConfig::wavelengthSampleSize())
+        : 1u;
+  }
+  {
+    path_guiding_ = parameters.path_guiding_;
+    guiding_iterations_ = parameters.guiding_iterations_;
+  }
+  if (isPathGuidingEnabled()) {
+    auto data_resource = settings->workResource();
+    guiding_memory_ = zisc::UniqueMemoryPointer<System::MemoryManager>::make(
+        data_resource);
+    const auto bounding_box = scene.world().bvh().boundingBox();
+    for (auto& tree : guiding_tree_list_) {
+      tree = zisc::UniqueMemoryPointer<PathGuidingTree>::make(
+          data_resource,
+          bounding_box,
+          guiding_memory_.get());
+    }
+  }
+}
+
+/*!
+  */
+bool PathTracing::isGuidingTrainingEnabled() const noexcept
+{
+  return isPathGuidingEnabled() &&
+         (num_of_guiding_fittings_ < guiding_iterations_);
+}
+
+/*!
+  */
+bool PathTracing::isLightSolidAngleSamplingEnabled() const noexcept
+{
+  return light_solid_angle_sampling_ == kTrue;
+}
+
+/*!
+  \details
+  The directions are guided only while path guiding is enabled.
+  */
+auto PathTracing::lightConnection() const noexcept -> LightConnection
+{
+  LightConnection connection;
+  connection.light_sampler_ = &eyePathLightSampler();
+  connection.guiding_tree_ = isPathGuidingEnabled() ? &guidingTree() : nullptr;
+  connection.ray_cast_epsilon_ = Method::rayCastEpsilon();
+  connection.solid_angle_sampling_ = isLightSolidAngleSamplingEnabled() ? kTrue : kFalse;
+  return connection;
+}
+
+/*!
+  */
+bool PathTracing::isMaterialSortingEnabled() const noexcept
+{
+  return material_sorting_ == kTrue;
+}
+
+/*!
+  */
+bool PathTracing::isPathGuidingEnabled() const noexcept
+{
+  return path_guiding_ == kTrue;
+}
+
+/*!
+  \details
+  The incident radiance of a vertex is the contribution which is added after
+  the vertex divided by the throughput of the next ray,
+  the radiance divided by the pdf is recorded into the bin of the direction.
+  */
+void PathTracing::recordGuidingVertices(const GuidingVertex* vertex_list,
+                                        const uint num_of_vertices,
+                                        const Spectra& contribution) noexcept
+{
+  auto& tree = guidingTree();
+  const Float total_contribution = contribution.average();
+  for (uint i = 0; i < num_of_vertices; ++i) {
+    const auto& vertex = vertex_list[i];
+    const Float radiance = (total_contribution - vertex.contribution_) /
+                           vertex.throughput_;
+    if (0.0 < radiance)
+      tree.record(vertex.leaf_, vertex.direction_, radiance * vertex.inverse_pdf_);
+  }
+}
+
+/*!
+  \details
+  The light sampler selects the environment light or a light source object.
+  The light point and the contribution are evaluated while the bxdf is alive,
+  so the caller can defer the visibility test of the shadow ray.
+  */
+bool PathTracing::sampleExplicitConnection(
+    const LightConnection& connection,
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const uint guiding_leaf,
+    const bool implicit_connection_is_enabled,
+    Sampler& sampler,
+    PathState& path_state,
+    zisc::pmr::memory_resource* mem_resource,
+    ShadingProfile* profile,
+    ShadowConnection* shadow_connection) noexcept
+{
+  ZISC_ASSERT(shadow_connection != nullptr, "The shadow connection is null.");
+  // Select the environment light or a light source object
+  const auto& light_sampler = *connection.light_sampler_;
+  const Float environment_probability = light_sampler.environmentProbability();
+  if (0.0 < environment_probability) {
+    path_state.setDimension(SampleDimension::kLightSample1);
+    if (sampler.draw1D(path_state) < environment_probability) {
+      return sampleExplicitEnvironmentConnection(connection, ray, bxdf,
+                                                 intersection,
+                                                 camera_contribution, ray_weight,
+                                                 guiding_leaf,
+                                                 implicit_connection_is_enabled,
+                                                 environment_probability,
+                                                 sampler, path_state, profile,
+                                                 shadow_connection);
+    }
+  }
+
+  // Select a light source and sample a point on the light source
+  path_state.setDimension(SampleDimension::kLightSourceSelection);
+  const auto light_source_info = light_sampler.sample(intersection,
+                                                      sampler,
+                                                      path_state);
+  const auto light_source = light_source_info.object();
+
+  // Reject the light source which can't illuminate the surface point
+  const auto light_bound = light_source->lightSourceBound();
+  if ((light_bound != nullptr) &&
+      !light_bound->canIlluminate(intersection.point(),
+                                  intersection.normal(),
+                                  bxdf->isReflective(),
+                                  bxdf->isTransmissive()))
+    return false;
+
+  path_state.setDimension(SampleDimension::kLightPointSample);
+  const auto light_point_info = sampleLightPoint(connection,
+                                                 intersection.point(),
+                                                 *light_source,
+                                                 sampler,
+                                                 path_state);
+
+  // Check if the light is in front or back of the surface
+  const bool is_in_front = 0.0 < zisc::dot(intersection.normal(),
+                                           light_point_info.point() - intersection.point());
+  if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()))
+    return false;
+
+  // Make a shadow ray
+  const auto shadow_ray = Method::makeShadowRay(intersection.point(),
+                                                light_point_info.point(),
+                                                intersection.normal(),
+                                                connection.ray_cast_epsilon_,
+                                                is_in_front);
+  const Float cos_no = (is_in_front)
+      ? zisc::dot(intersection.normal(), shadow_ray.direction())
+      : -zisc::dot(intersection.normal(), shadow_ray.direction());
+  if (cos_no <= 0.0)
+    return false;
+
+  const Float diff2 = (light_point_info.point() - shadow_ray.origin()).squareNorm();
+  ZISC_ASSERT(0.0 < diff2, "The diff2 isn't greater than 0.");
+  // Check if the ray reaches the front side of the light source
+  const auto light_dir = -shadow_ray.direction();
+  const Float cos_sni = zisc::dot(light_point_info.normal(), light_dir);
+  if (cos_sni <= 0.0)
+    return false;
+  const IntersectionInfo shadow_intersection{light_source, light_point_info};
+
+  // Evaluate the surface reflectance
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto result = [&]() noexcept
+  {
+    const uint surface_index = intersection.object()->material().surface().index();
+    ShadingProfile::Scope profile_scope{profile, surface_index, false};
+    return bxdf->evalRadianceAndPdf(&ray.direction(),
+                                    &shadow_ray.direction(),
+                                    wavelengths,
+                                    &intersection);
+  }();
+  const auto& f = std::get<0>(result);
+  const Float direction_pdf = evalGuidedPdf(connection.guiding_tree_,
+                                            guiding_leaf,
+                                            shadow_ray.direction(),
+                                            std::get<1>(result));
+  ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
+  ZISC_ASSERT(0.0 <= direction_pdf, "Pdf isn't positive.");
+
+  // Evaluate the light radiance
+  const auto& emitter = light_source->material().emitter();
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(shadow_intersection.uv(),
+                                       wavelengths,
+                                       &light_memory);
+  const auto radiance = light->evalRadiance(nullptr,
+                                            &light_dir,
+                                            wavelengths,
+                                            &shadow_intersection);
+
+  // Calculate the geometry term
+  const Float geometry_term = cos_sni * cos_no / diff2;
+  ZISC_ASSERT(0.0 <= geometry_term, "Geometry term is negative.");
+
+  // Calculate the MIS weight
+  const Float inverse_selection_pdf = light_source_info.inverseWeight() *
+                                      light_point_info.inversePdf() /
+                                      (1.0 - environment_probability);
+  const Float mis_weight = implicit_connection_is_enabled
+      ? calcMisWeight(direction_pdf, inverse_selection_pdf)
+      : 1.0;
+
+  // Calculate the contribution in place to avoid the temporary spectra
+  auto& c = shadow_connection->contribution_;
+  c = camera_contribution * ray_weight;
+  c *= f;
+  c *= radiance;
+  c *= geometry_term * inverse_selection_pdf * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  // The light source itself is excluded from the test,
+  // so the ray doesn't need to be extended beyond the light point
+  shadow_connection->shadow_ray_ = shadow_ray;
+  shadow_connection->max_distance_ = zisc::sqrt(diff2);
+  shadow_connection->light_source_ = light_source;
+  return true;
+}
+
+/*!
+  \details
+  A direction is sampled by the luminance of the environment
+  and the shadow ray is tested to the infinity.
+  */
+bool PathTracing::sampleExplicitEnvironmentConnection(
+    const LightConnection& connection,
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const uint guiding_leaf,
+    const bool implicit_connection_is_enabled,
+    const Float selection_probability,
+    Sampler& sampler,
+    PathState& path_state,
+    ShadingProfile* profile,
+    ShadowConnection* shadow_connection) noexcept
+{
+  const auto& environment = *connection.light_sampler_->environmentLight();
+  path_state.setDimension(SampleDimension::kLightSample2);
+  const auto sampled_direction = environment.sample(sampler, path_state);
+  if (sampled_direction.inversePdf() <= 0.0)
+    return false;
+  const auto& light_dir = sampled_direction.direction();
+
+  // Check if the light is in front or back of the surface
+  const Float cos_no = zisc::dot(intersection.normal(), light_dir);
+  const bool is_in_front = 0.0 < cos_no;
+  if (!(is_in_front ? bxdf->isReflective() : bxdf->isTransmissive()) ||
+      (cos_no == 0.0))
+    return false;
+
+  // Make a shadow ray to the environment
+  const Float e = is_in_front ? connection.ray_cast_epsilon_
+                              : -connection.ray_cast_epsilon_;
+  const auto shadow_ray = Ray::makeRay(intersection.point() + e * intersection.normal(),
+                                       light_dir);
+
+  // Evaluate the surface reflectance
+  const auto& wavelengths = ray_weight.wavelengths();
+  const auto result = [&]() noexcept
+  {
+    const uint surface_index = intersection.object()->material().surface().index();
+    ShadingProfile::Scope profile_scope{profile, surface_index, false};
+    return bxdf->evalRadianceAndPdf(&ray.direction(),
+                                    &light_dir,
+                                    wavelengths,
+                                    &intersection);
+  }();
+  const auto& f = std::get<0>(result);
+  const Float direction_pdf = evalGuidedPdf(connection.guiding_tree_,
+                                            guiding_leaf,
+                                            light_dir,
+                                            std::get<1>(result));
+  ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
+  ZISC_ASSERT(0.0 <= direction_pdf, "Pdf isn't positive.");
+
+  // Evaluate the light radiance
+  const auto radiance = environment.evalRadiance(light_dir, wavelengths);
+
+  // Calculate the MIS weight, the pdfs are in the solid angle measure
+  const Float inverse_selection_pdf = sampled_direction.inversePdf() /
+                                      selection_probability;
+  const Float mis_weight = implicit_connection_is_enabled
+      ? calcMisWeight(direction_pdf, inverse_selection_pdf)
+      : 1.0;
+
+  auto& c = shadow_connection->contribution_;
+  c = camera_contribution * ray_weight;
+  c *= f;
+  c *= radiance;
+  c *= zisc::abs(cos_no) * inverse_selection_pdf * mis_weight;
+  ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
+  shadow_connection->shadow_ray_ = shadow_ray;
+  shadow_connection->max_distance_ = std::numeric_limits<Float>::max();
+  shadow_connection->light_source_ = nullptr;
+  return true;
+}
+
+/*!
+  \details
+  A direction is sampled from the guiding tree with the guiding probability,
+  otherwise from the BxDF. The weight and the pdf are of the mixture,
+  so the MIS of the connections uses the same pdf.
+  */
+template <RouletteType kRouletteType>
+Ray PathTracing::sampleGuidedRay(const Ray& ray,
+                                 const ShaderPointer& bxdf,
+                                 const IntersectionInfo& intersection,
+                                 const uint guiding_leaf,
+                                 Spectra* ray_weight,
+                                 Spectra* next_ray_weight,
+                                 Sampler& sampler,
+                                 PathState& path_state,
+                                 Float* inverse_direction_pdf) const noexcept
+{
+  if ((guiding_leaf == PathGuidingTree::invalidLeaf()) ||
+      !guidingTree().isTrained(guiding_leaf)) {
+    return Method::sampleNextRay<kRouletteType>(ray, bxdf, intersection,
+                                                ray_weight, next_ray_weight,
+                                                sampler, path_state,
+                                                inverse_direction_pdf);
+  }
+
+  const auto& wavelengths = ray_weight->wavelengths();
+  const auto& vin = ray.direction();
+  constexpr Float a = guidingProbability();
+
+  path_state.setDimension(SampleDimension::kBxdfSample3);
+  const bool is_guided = sampler.draw1D(path_state) < a;
+  Vector3 vout;
+  Spectra weight{wavelengths};
+  Float pdf = 0.0;
+  if (is_guided) {
+    // Sample a direction from the guiding tree
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    const auto sampled_vout = guidingTree().sample(guiding_leaf, sampler, path_state);
+    vout = sampled_vout.direction();
+    const auto result = bxdf->evalRadianceAndPdf(&vin, &vout, wavelengths,
+                                                 &intersection);
+    const auto& f = std::get<0>(result);
+    pdf = a * sampled_vout.pdf() + (1.0 - a) * std::get<1>(result);
+    const Float cos_no = zisc::abs(zisc::dot(intersection.normal(), vout));
+    if (0.0 < pdf)
+      weight = f * (cos_no / pdf);
+  }
+  else {
+    // Sample a direction from the BxDF
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    const auto result = bxdf->sample(&vin, wavelengths,
+                                     sampler, path_state, &intersection);
+    const auto& sampled_vout = std::get<0>(result);
+    vout = sampled_vout.direction();
+    const Float bxdf_pdf = sampled_vout.pdf();
+    pdf = a * guidingTree().evalPdf(guiding_leaf, vout) + (1.0 - a) * bxdf_pdf;
+    if (0.0 < pdf)
+      weight = std::get<1>(result) * (bxdf_pdf / pdf);
+  }
+  ZISC_ASSERT(!weight.hasNegative(), "The weight has negative values.");
+
+  if (inverse_direction_pdf != nullptr)
+    *inverse_direction_pdf = (0.0 < pdf) ? zisc::invert(pdf) : 0.0;
+
+  return Method::makeNextRay<kRouletteType>(ray, intersection, vout, weight,
+                                            ray_weight, next_ray_weight,
+                                            sampler, path_state);
+}
+
+/*!
+  \details
+  The textured light sources keep their emission distributions,
+  since the solid angle sampling doesn't know the emission.
+  */
+ShapePoint PathTracing::sampleLightPoint(const LightConnection& connection,
+                                         const Point3& reference,
+                                         const Object& light_source,
+                                         Sampler& sampler,
+                                         const PathState& path_state) noexcept
+{
+  const bool solid_angle_sampling = (connection.solid_angle_sampling_ == kTrue) &&
+                                    (light_source.emissionDistribution() == nullptr);
+  return solid_angle_sampling
+      ? light_source.shape().sampleSolidAnglePoint(reference, sampler, path_state)
+      : light_source.sampleLightPoint(sampler, path_state);
 }
 
 /*!
@@ -299,7 +872,9 @@ Float PathTracing::calcMisWeight(const Float pdf1, const Float inverse_pdf2) noe
 
 /*!
   \details
-  No detailed.
+  The path tracer is specialized for the russian roulette type
+  which is dispatched once per cycle,
+  so the vertices of the paths don't branch on the type.
   */
 void PathTracing::traceCameraPath(System& system,
                                   Scene& scene,
@@ -318,107 +893,443 @@ void PathTracing::traceCameraPath(System& system,
     camera.sampleLensPoint(sampler, path_state);
   }
 
-  std::atomic<uint> tile_count{0};
+  const uint num_of_tiles = calcNumOfTiles(scene.camera().imageResolution());
+  TileQueue tile_queue{num_of_tiles,
+                       system.threadManager().numOfThreads(),
+                       calcTileChunkSize(system, num_of_tiles),
+                       &system.globalMemoryManager()};
 
   auto trace_camera_path =
-  [this, &system, &scene, &sampled_wavelengths, cycle, &tile_count]
-  (const uint thread_id, const uint) noexcept
+  [this, &system, &scene, &sampled_wavelengths, cycle, &tile_queue]
+  (const uint thread_id, auto roulette_type) noexcept
   {
-    const auto& camera = scene.camera();
-    const uint num_of_tiles =
-        RenderingMethod::calcNumOfTiles(camera.imageResolution());
-
-    for (uint index = tile_count++; index < num_of_tiles; index = tile_count++) {
-      auto tile = RenderingMethod::getRenderingTile(camera.imageResolution(), index);
-      for (uint i = 0; i < tile.numOfPixels(); ++i) {
-        const auto& pixel_index = tile.current();
-        traceCameraPath(system, scene, sampled_wavelengths,
-                        cycle, thread_id, pixel_index);
-        tile.next();
+    constexpr RouletteType kRouletteType = decltype(roulette_type)::value;
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Camera path task"};
+    auto& camera = scene.camera();
+    auto& statistics = camera.film().sampleStatistics();
+    const auto& resolution = camera.imageResolution();
+
+    auto trace_tile = [this, &system, &scene, &sampled_wavelengths, cycle,
+                       thread_id, &statistics](RenderingTile& tile)
+    {
+      // Skip the tile which has converged
+      if (!statistics.isActive(tile.current()))
+        return;
+      // Trace all samples of the cycle before the next tile
+      FilmTile film_tile{tile};
+      auto trace_samples = [this, &system, &scene, cycle, thread_id,
+                            &tile, &film_tile](const Wavelengths& wavelengths)
+      {
+        for (uint32 s = 0; s < system.samplesPerCycle(); ++s) {
+          const uint32 sample_index = Method::calcSampleIndex(system, cycle, s);
+          tile.reset();
+          traceCameraPaths<kRouletteType>(system, scene, wavelengths,
+                                          sample_index, thread_id, tile,
+                                          &film_tile);
+        }
+      };
+      if (Method::tileWavelengthSamplingIsEnabled()) {
+        const auto tile_wavelengths =
+            Method::sampleTileWavelengths(system, tile, cycle, thread_id);
+        trace_samples(tile_wavelengths);
+        const auto& wavelengths = tile_wavelengths.wavelengths();
+        XyzColorMatchingFunction::SensorResponse response{};
+        if (statistics.isXyzTable())
+          response = system.xyzColorMatchingFunction().makeSensorResponse(wavelengths);
+        film_tile.commit(wavelengths, response, &statistics);
       }
-    }
+      else {
+        trace_samples(sampled_wavelengths);
+        film_tile.commit(sampled_wavelengths.wavelengths(), &statistics);
+      }
+    };
+    Method::forEachTile(tile_queue, thread_id, resolution, trace_tile);
   };
 
+  auto trace_camera_paths = [&system, &trace_camera_path](auto roulette_type)
   {
+    auto trace = [&trace_camera_path, roulette_type]
+    (const uint thread_id, const uint) noexcept
+    {
+      trace_camera_path(thread_id, roulette_type);
+    };
     auto& threads = system.threadManager();
     auto& work_resource = system.globalMemoryManager();
     constexpr uint start = 0;
-    const uint end = threads.numOfThreads();
-    auto result = threads.enqueueLoop(trace_camera_path, start, end, &work_resource);
+    const uint end = system.numOfActiveThreads();
+    auto result = threads.enqueueLoop(trace, start, end, &work_resource);
     result.wait();
+  };
+
+  switch (Method::rouletteType()) {
+   case RouletteType::kMaxWeight: {
+    trace_camera_paths(std::integral_constant<RouletteType,
+                                              RouletteType::kMaxWeight>{});
+    break;
+   }
+   case RouletteType::kAverageWeight: {
+    trace_camera_paths(std::integral_constant<RouletteType,
+                                              RouletteType::kAverageWeight>{});
+    break;
+   }
+   case RouletteType::kEfficiency: {
+    trace_camera_paths(std::integral_constant<RouletteType,
+                                              RouletteType::kEfficiency>{});
+    break;
+   }
+   case RouletteType::kPathLength:
+   default: {
+    trace_camera_paths(std::integral_constant<RouletteType,
+                                              RouletteType::kPathLength>{});
+    break;
+   }
   }
 }
 
 /*!
   \details
-  No detailed.
+  The camera rays of the pixels of a tile are coherent,
+  so they are generated first and traversed as a packet.
+  The rest of each path is traced with single rays.
+  If material sorting is enabled, the pixels are traced in the order of
+  the materials of the camera hits, so the same surface and emitter models
+  are evaluated in a row. The missed rays are traced last.
+  If the pixel cost heatmap is enabled, the cost of a pixel is
+  the cost of its path plus the share of the packet traversal.
+  */
+template <RouletteType kRouletteType>
+void PathTracing::traceCameraPaths(System& system,
+                                   Scene& scene,
+                                   const Wavelengths& sampled_wavelengths,
+                                   const uint32 cycle,
+                                   const uint thread_id,
+                                   RenderingTile& tile,
+                                   FilmTile* film_tile) noexcept
+{
+  constexpr uint packet_size = CameraRayPacket::size();
+
+  // Scene
+  const auto& world = scene.world();
+  const auto& camera = scene.camera();
+
+  // Generate the camera rays of the tile
+  CameraRayPacket packet;
+  std::array<Index2d, packet_size> pixel_index_list;
+  std::array<Spectra, packet_size> camera_contribution_list;
+  std::array<Float, packet_size> inverse_direction_pdf_list;
+  const uint num_of_pixels = generateRays(camera, sampled_wavelengths, tile,
+                                          &packet,
+                                          pixel_index_list.data(),
+                                          camera_contribution_list.data(),
+                                          inverse_direction_pdf_list.data());
+  if (num_of_pixels == 0)
+    return;
+
+  // Cast the camera rays
+  auto& counter = Method::threadCounter(thread_id);
+  constexpr bool cost_is_enabled = CoreConfig::pixelCostHeatmapIsEnabled();
+  // The cost of the packet is shared by the pixels equally
+  std::array<uint64, 3> packet_cost{{0, 0, 0}};
+  if constexpr (cost_is_enabled) {
+    packet_cost = {{counter.numOfNodeVisits(),
+                    counter.numOfPrimitiveTests(),
+                    RenderingCounter::readTimeStamp()}};
+  }
+  std::array<IntersectionInfo, packet_size> intersection_list;
+  Method::castRayPacket(world, packet, &intersection_list, &counter);
+  if constexpr (cost_is_enabled) {
+    const uint64 n = zisc::cast<uint64>(zisc::max(num_of_pixels, 1u));
+    packet_cost = {{(counter.numOfNodeVisits() - packet_cost[0]) / n,
+                    (counter.numOfPrimitiveTests() - packet_cost[1]) / n,
+                    (RenderingCounter::readTimeStamp() - packet_cost[2]) / n}};
+  }
+
+  // Sort the pixels by the materials of the camera hits
+  std::array<uint, packet_size> order_list;
+  for (uint i = 0; i < num_of_pixels; ++i)
+    order_list[i] = i;
+  if (isMaterialSortingEnabled()) {
+    auto get_material = [&intersection_list](const uint index) noexcept
+    {
+      const auto& intersection = intersection_list[index];
+      const Material* material = (intersection.isIntersected())
+          ? &intersection.object()->material()
+          : nullptr;
+      return material;
+    };
+    auto has_less_material =
+    [&get_material](const uint lhs, const uint rhs) noexcept
+    {
+      const auto lhs_material = get_material(lhs);
+      const auto rhs_material = get_material(rhs);
+      // The missed rays are placed last
+      return ((lhs_material != nullptr) && (rhs_material == nullptr)) ||
+             (((lhs_material == nullptr) == (rhs_material == nullptr)) &&
+              ((lhs_material < rhs_material) ||
+               ((lhs_material == rhs_material) && (lhs < rhs))));
+    };
+    std::sort(order_list.begin(), order_list.begin() + num_of_pixels,
+              has_less_material);
+  }
+
+  auto& statistics = scene.camera().film().sampleStatistics();
+  for (uint i = 0; i < num_of_pixels; ++i) {
+    const uint index = order_list[i];
+    std::array<uint64, 3> path_cost{{0, 0, 0}};
+    if constexpr (cost_is_enabled) {
+      path_cost = {{counter.numOfNodeVisits(),
+                    counter.numOfPrimitiveTests(),
+                    RenderingCounter::readTimeStamp()}};
+    }
+    traceCameraPath<kRouletteType>(system, scene, sampled_wavelengths, cycle,
+                                   thread_id,
+                                   pixel_index_list[index],
+                                   packet.ray(index),
+                                   camera_contribution_list[index],
+                                   inverse_direction_pdf_list[index],
+                                   intersection_list[index],
+                                   film_tile);
+    if constexpr (cost_is_enabled) {
+      const uint64 cycles = RenderingCounter::readTimeStamp() - path_cost[2];
+      statistics.addPixelCost(
+          pixel_index_list[index],
+          packet_cost[0] + (counter.numOfNodeVisits() - path_cost[0]),
+          packet_cost[1] + (counter.numOfPrimitiveTests() - path_cost[1]),
+          packet_cost[2] + cycles);
+    }
+  }
+}
+
+/*!
+  \details
+  If the wavelength batches are enabled, the path is split into the batches
+  at the first wavelength selective vertex instead of dropping
+  all wavelengths except the primary one. The primary wavelengths of
+  the batches are stratified over the wavelengths and each batch continues
+  the path independently, so the vertices before the split,
+  which are the most of the traversal, are shared by the batches.
+  The guiding tree is trained by the vertices before the split.
   */
+template <RouletteType kRouletteType>
 void PathTracing::traceCameraPath(System& system,
                                   Scene& scene,
                                   const Wavelengths& sampled_wavelengths,
                                   const uint32 cycle,
                                   const uint thread_id,
-                                  const Index2d& pixel_index) noexcept
+                                  const Index2d& pixel_index,
+                                  const Ray& camera_ray,
+                                  const Spectra& camera_ray_contribution,
+                                  const Float camera_inverse_direction_pdf,
+                                  const IntersectionInfo& camera_intersection,
+                                  FilmTile* film_tile) noexcept
 {
   // System
   auto& memory_manager = system.threadMemoryManager(thread_id);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
+  auto& counter = Method::threadCounter(thread_id);
+  // Trace info
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+  Spectra contribution{wavelengths};
+
+  // The camera ray has been cast with the packet of the tile
+  CameraPathVertex vertex;
+  vertex.ray_ = camera_ray;
+  vertex.intersection_ = camera_intersection;
+  vertex.camera_contribution_ = camera_ray_contribution;
+  vertex.ray_weight_ = Spectra{wavelengths, 1.0};
+  vertex.path_state_ = PathState{cycle};
+  vertex.path_state_.setLength(1);
+  vertex.inverse_direction_pdf_ = camera_inverse_direction_pdf;
+  vertex.explicit_connection_is_enabled_ = kFalse; // Explicit camera-light connection isn't performed
+  vertex.is_first_hit_ = kTrue;
+
+  // The vertices which train the guiding tree
+  std::array<GuidingVertex, maxNumOfGuidingVertices()> guiding_vertex_list;
+  uint num_of_guiding_vertices = 0;
+
+  const bool is_split = traceCameraPathVertices<kRouletteType>(
+      system, scene, thread_id, pixel_index, 0,
+      guiding_vertex_list.data(), &num_of_guiding_vertices,
+      &vertex, &contribution);
+  uint path_length = vertex.path_state_.length();
+  if (is_split) {
+    const uint n = WavelengthSamples::size();
+    const uint num_of_batches = numOfWavelengthBatches();
+    const Float k = zisc::invert(zisc::cast<Float>(num_of_batches));
+    for (uint batch = 0; batch < num_of_batches; ++batch) {
+      auto batch_wavelengths = wavelengths;
+      const uint primary = (wavelengths.primaryWavelengthIndex() +
+                            (batch * n) / num_of_batches) % n;
+      batch_wavelengths.setPrimaryWavelength(primary);
+      // The spectra of the batch refer to the wavelengths of the batch
+      auto batch_vertex = vertex;
+      batch_vertex.camera_contribution_ = Spectra{batch_wavelengths};
+      batch_vertex.ray_weight_ = Spectra{batch_wavelengths};
+      for (uint i = 0; i < n; ++i) {
+        batch_vertex.camera_contribution_.setIntensity(
+            i, k * vertex.camera_contribution_.intensity(i));
+        batch_vertex.ray_weight_.setIntensity(i, vertex.ray_weight_.intensity(i));
+      }
+      traceCameraPathVertices<kRouletteType>(system, scene, thread_id,
+                                             pixel_index, batch + 1,
+                                             nullptr, nullptr,
+                                             &batch_vertex, &contribution);
+      if (batch == 0)
+        path_length = batch_vertex.path_state_.length();
+    }
+  }
+  if (0 < num_of_guiding_vertices) {
+    recordGuidingVertices(guiding_vertex_list.data(), num_of_guiding_vertices,
+                          contribution);
+  }
+  counter.addPath(path_length);
+  film_tile->add(pixel_index, contribution);
+}
+
+/*!
+  \details
+  The batch 0 is the path from the camera, which stops at
+  the first wavelength selective vertex if the path is split into batches.
+  The batch b (b > 0) resumes the path from the vertex,
+  the implicit connection at the vertex has been evaluated by the batch 0.
+  The batches except the first use the sampler streams after the pixels,
+  so the batches are independent of each other.
+  */
+template <RouletteType kRouletteType>
+bool PathTracing::traceCameraPathVertices(System& system,
+                                          Scene& scene,
+                                          const uint thread_id,
+                                          const Index2d& pixel_index,
+                                          const uint batch,
+                                          GuidingVertex* guiding_vertex_list,
+                                          uint* num_of_guiding_vertices,
+                                          CameraPathVertex* vertex,
+                                          Spectra* contribution) noexcept
+{
+  // System
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  const uint num_of_pixels = system.imageWidthResolution() *
+                             system.imageHeightResolution();
   const uint path_index = pixel_index[0] +
-                          pixel_index[1] * system.imageWidthResolution();
-  auto& sampler = system.localSampler(path_index);
+                          pixel_index[1] * system.imageWidthResolution() +
+                          ((1 < batch) ? (batch - 1) * num_of_pixels : 0);
+  auto& sampler = system.localSampler(thread_id, path_index);
+  auto& counter = Method::threadCounter(thread_id);
+  auto profile = Method::threadShadingProfile(thread_id);
   // Scene
   const auto& world = scene.world();
-  auto& camera = scene.camera();
+  auto& statistics = scene.camera().film().sampleStatistics();
+  const bool is_resumed = 0 < batch;
+  const bool feature_is_enabled = (batch <= 1) &&
+      statistics.isEnabled(SampleStatistics::Type::kFirstHitFeatures);
+  const bool split_is_enabled = !is_resumed && (1 < numOfWavelengthBatches());
   // Trace info
-  PathState path_state{cycle};
-  path_state.setLength(1);
-  const auto& wavelengths = sampled_wavelengths.wavelengths();
-  auto camera_contribution = makeSampledSpectra(sampled_wavelengths);
-  Spectra contribution{wavelengths};
-  IntersectionInfo intersection;
+  auto& path_state = vertex->path_state_;
+  auto& ray = vertex->ray_;
+  auto& intersection = vertex->intersection_;
+  auto& previous_intersection = vertex->previous_intersection_;
+  auto& camera_contribution = vertex->camera_contribution_;
+  auto& ray_weight = vertex->ray_weight_;
+  auto& inverse_direction_pdf = vertex->inverse_direction_pdf_;
+  const auto& wavelengths = camera_contribution.wavelengths();
   bool wavelength_is_selected = false;
 
   constexpr bool implicit_connection_is_enabled =
       CoreConfig::pathTracingImplicitConnectionIsEnabled();
-  bool explicit_connection_is_enabled = false; // Explicit camera-light connection isn't performed
+  bool explicit_connection_is_enabled =
+      vertex->explicit_connection_is_enabled_ == kTrue;
 
-  // Generate a camera ray
-  Float inverse_direction_pdf;
-  Spectra ray_weight{wavelengths, 1.0};
-  auto ray = generateRay(camera, pixel_index, sampler, path_state, &memory_manager,
-                         &camera_contribution, &inverse_direction_pdf);
+  const auto connection = lightConnection();
 
+  // The trained vertices are recorded only by the path from the camera
+  const bool guiding_training_is_enabled = isGuidingTrainingEnabled() &&
+                                           (guiding_vertex_list != nullptr);
+
+  // The intersection of the first ray is given
+  bool is_intersected = true;
   while (true) {
-    // Reset memory
-    memory_manager.reset();
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
+    const bool is_first_hit = vertex->is_first_hit_ == kTrue;
+    const bool is_split_vertex = is_resumed && is_intersected;
+    vertex->is_first_hit_ = kFalse;
     // Cast the ray
-    intersection = Method::castRay(world, ray);
-    if (!intersection.isIntersected())
-      break;
+    if (!is_intersected)
+      intersection = Method::castRay(world, ray, RayCastType::kSecondary, &counter);
+    is_intersected = false;
+    if (!is_split_vertex) {
+      if (!intersection.isIntersected()) {
+        evalImplicitEnvironmentConnection(connection, ray, inverse_direction_pdf,
+                                          camera_contribution, ray_weight,
+                                          implicit_connection_is_enabled,
+                                          explicit_connection_is_enabled,
+                                          contribution);
+        // The features of the background are zero
+        if (is_first_hit && feature_is_enabled) {
+          statistics.addFirstHitFeature(pixel_index, Vector3{0.0, 0.0, 0.0},
+                                        Spectra{wavelengths}, 0.0);
+        }
+        break;
+      }
 
-    evalImplicitConnection(world, ray, inverse_direction_pdf, intersection,
-                           camera_contribution, ray_weight,
-                           implicit_connection_is_enabled,
-                           explicit_connection_is_enabled,
-                           &memory_manager, &contribution);
+      evalImplicitConnection(connection, ray, inverse_direction_pdf, intersection,
+                             previous_intersection,
+                             camera_contribution, ray_weight,
+                             implicit_connection_is_enabled,
+                             explicit_connection_is_enabled,
+                             &memory_manager, contribution);
+      // The preview is lit by the direct lighting of the first hit only
+      if ((1 < Method::previewScale()) && (2 <= path_state.length()))
+        break;
+    }
 
     // Get a BxDF of the surface
     const auto& material = intersection.object()->material();
     const auto& surface = material.surface();
     path_state.setDimension(SampleDimension::kBxdfSample1);
-    const auto bxdf = surface.makeBxdf(intersection, wavelengths,
-                                       sampler, path_state, &memory_manager);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
+    // The hit is counted with the making of the BxDF
+    const auto bxdf = [&]() noexcept
+    {
+      ShadingProfile::Scope profile_scope{profile, surface.index(), true};
+      return surface.makeBxdf(intersection, wavelengths,
+                              sampler, path_state, &bxdf_memory);
+    }();
+    if (split_is_enabled && bxdf->wavelengthIsSelected()) {
+      // The batches continue the path from this vertex
+      vertex->explicit_connection_is_enabled_ = explicit_connection_is_enabled
+          ? kTrue
+          : kFalse;
+      vertex->is_first_hit_ = is_first_hit ? kTrue : kFalse;
+      return true;
+    }
     Method::updateSelectedWavelengthInfo(bxdf,
                                          &camera_contribution,
                                          &wavelength_is_selected);
 
     // Sample next ray
+    const uint guiding_leaf = findGuidingLeaf(bxdf, intersection);
     auto next_ray_weight = ray_weight;
-    const auto next_ray = Method::sampleNextRay(ray, bxdf, intersection,
-                                                &ray_weight, &next_ray_weight,
-                                                sampler, path_state,
-                                                &inverse_direction_pdf);
-    if (!next_ray.isAlive())
+    const auto next_ray = [&]() noexcept
+    {
+      ShadingProfile::Scope profile_scope{profile, surface.index(), false};
+      return sampleGuidedRay<kRouletteType>(
+          ray, bxdf, intersection, guiding_leaf, &ray_weight, &next_ray_weight,
+          sampler, path_state, &inverse_direction_pdf);
+    }();
+    // The albedo is the weight of the sampled direction of the first hit
+    if (is_first_hit && feature_is_enabled) {
+      const auto albedo = next_ray.isAlive() ? next_ray_weight
+                                             : Spectra{wavelengths};
+      statistics.addFirstHitFeature(pixel_index, intersection.normal(), albedo,
+                                    intersection.rayDistance());
+    }
+    // The next ray is killed only by russian roulette
+    if (!next_ray.isAlive()) {
+      counter.addRouletteTermination();
       break;
+    }
     path_state.incrementLength();
 
     explicit_connection_is_enabled = (bxdf->type() != ShaderType::Specular) &&
@@ -426,17 +1337,48 @@ void PathTracing::traceCameraPath(System& system,
 
     evalExplicitConnection(world, ray, bxdf, intersection,
                            camera_contribution, ray_weight,
+                           guiding_leaf,
                            explicit_connection_is_enabled,
                            implicit_connection_is_enabled,
-                           sampler, path_state, &memory_manager, &contribution);
+                           sampler, path_state, &memory_manager, &counter,
+                           profile, contribution);
+
+    // The radiance of the next ray is added to the contribution from now on
+    if (guiding_training_is_enabled &&
+        (guiding_leaf != PathGuidingTree::invalidLeaf()) &&
+        (*num_of_guiding_vertices < maxNumOfGuidingVertices())) {
+      const Float throughput = (camera_contribution * next_ray_weight).average();
+      if ((0.0 < throughput) && (0.0 < inverse_direction_pdf)) {
+        auto& guiding_vertex = guiding_vertex_list[(*num_of_guiding_vertices)++];
+        guiding_vertex.direction_ = next_ray.direction();
+        guiding_vertex.inverse_pdf_ = inverse_direction_pdf;
+        guiding_vertex.throughput_ = throughput;
+        guiding_vertex.contribution_ = contribution->average();
+        guiding_vertex.leaf_ = guiding_leaf;
+      }
+    }
 
     // Update ray
     ray = next_ray;
     ray_weight = next_ray_weight;
+    previous_intersection = intersection;
+  }
+  return false;
+}
+
+/*!
+  \details
+  The records of the old tree since the fitting began are discarded
+  with the tree, the new tree records from the next cycle.
+  */
+void PathTracing::updateGuidingTree() noexcept
+{
+  if (guiding_fitting_task_.valid() &&
+      (guiding_fitting_task_.wait_for(std::chrono::seconds::zero()) ==
+       std::future_status::ready)) {
+    guiding_fitting_task_.get();
+    guiding_tree_index_ = 1 - guiding_tree_index_;
   }
-  camera.addContribution(pixel_index, contribution);
-  // Reset memory
-  memory_manager.reset();
 }
 
 } // namespace nanairo
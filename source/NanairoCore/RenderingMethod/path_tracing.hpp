@@ -11,6 +11,8 @@
 #define NANAIRO_PATH_TRACING_HPP
 
 // Standard C++ library
+#include <array>
+#include <future>
 #include <memory>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -18,6 +20,16 @@
 // Nanairo
 #include "rendering_method.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/path_guiding_tree.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
 
@@ -25,13 +37,16 @@ namespace nanairo {
 
 // Forward declaration
 class CameraModel;
-class IntersectionInfo;
+class EnvironmentEmitter;
+class FilmTile;
 class Material;
-class PathState;
-class Ray;
+class Object;
+class RenderingCounter;
+class RenderingTile;
 class Sampler;
 class Scene;
 class ShaderModel;
+class ShadingProfile;
 class System;
 
 //! \addtogroup Core
@@ -39,7 +54,10 @@ class System;
 
 /*!
   \details
-  No detailed.
+  If path guiding is enabled, the incident radiance is learned by
+  a spatial-directional tree during the first cycles and the directions of
+  the non-specular surfaces are sampled from the mixture of
+  the tree and the BxDF. The tree is fitted asynchronously between cycles.
   */
 class PathTracing : public RenderingMethod
 {
@@ -49,6 +67,31 @@ class PathTracing : public RenderingMethod
   using Shader = ShaderModel;
   using ShaderPointer = RenderingMethod::ShaderPointer;
   using Wavelengths = typename Method::Wavelengths;
+  using CameraRayPacket = RayPacket<CoreConfig::sizeOfRenderingTileSide() *
+                                    CoreConfig::sizeOfRenderingTileSide()>;
+
+  /*!
+    \details
+    The light sampling which the connections of a camera path are made with.
+    The implicit connections weight the hits by the same pdfs as
+    the explicit connections sample the lights with.
+    */
+  struct LightConnection
+  {
+    const LightSourceSampler* light_sampler_;
+    const PathGuidingTree* guiding_tree_; //!< Null if no direction is guided
+    Float ray_cast_epsilon_; //!< The epsilon which the shadow rays are offset by
+    uint8 solid_angle_sampling_;
+  };
+
+  //! An explicit connection whose visibility isn't tested yet
+  struct ShadowConnection
+  {
+    Ray shadow_ray_;
+    Spectra contribution_; //!< The contribution if the light is visible
+    Float max_distance_;
+    const Object* light_source_; //!< Null if it's the environment light
+  };
 
 
   //! Initialize path tracing method
@@ -60,6 +103,31 @@ class PathTracing : public RenderingMethod
   //! Calculate the MIS weight
   static Float calcMisWeight(const Float pdf1, const Float inverse_pdf2) noexcept;
 
+  //! Evaluate the implicit connection
+  static void evalImplicitConnection(
+      const LightConnection& connection,
+      const Ray& ray,
+      const Float inverse_direction_pdf,
+      const IntersectionInfo& intersection,
+      const IntersectionInfo& previous_intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const bool implicit_connection_is_enabled,
+      const bool explicit_connection_is_enabled,
+      zisc::pmr::memory_resource* mem_resource,
+      Spectra* contribution) noexcept;
+
+  //! Evaluate the implicit connection of the ray which escapes to the environment
+  static void evalImplicitEnvironmentConnection(
+      const LightConnection& connection,
+      const Ray& ray,
+      const Float inverse_direction_pdf,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const bool implicit_connection_is_enabled,
+      const bool explicit_connection_is_enabled,
+      Spectra* contribution) noexcept;
+
   //! Generate a camera ray
   static Ray generateRay(const CameraModel& camera,
                          const Index2d& pixel_index,
@@ -69,6 +137,31 @@ class PathTracing : public RenderingMethod
                          Spectra* ray_weight,
                          Float* inverse_direction_pdf) noexcept;
 
+  //! Check if the method can skip the converged tiles of adaptive sampling
+  bool isAdaptiveSamplingSupported() const noexcept override;
+
+  //! Sample the explicit connection, the visibility is tested by the caller
+  static bool sampleExplicitConnection(
+      const LightConnection& connection,
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const uint guiding_leaf,
+      const bool implicit_connection_is_enabled,
+      Sampler& sampler,
+      PathState& path_state,
+      zisc::pmr::memory_resource* mem_resource,
+      ShadingProfile* profile,
+      ShadowConnection* shadow_connection) noexcept;
+
+  //! Check if the method can render the low resolution preview
+  bool isPreviewSupported() const noexcept override;
+
+  //! Check if the method can sample the wavelengths per rendering tile
+  bool isTileWavelengthSamplingSupported() const noexcept override;
+
   //! Render scene using path tracing method
   void render(System& system,
               Scene& scene,
@@ -76,6 +169,42 @@ class PathTracing : public RenderingMethod
               const uint32 cycle) noexcept override;
 
  private:
+  //! The state of a camera path at the intersection of its ray
+  struct CameraPathVertex
+  {
+    Ray ray_;
+    IntersectionInfo intersection_; //!< The intersection of the ray
+    IntersectionInfo previous_intersection_;
+    Spectra camera_contribution_;
+    Spectra ray_weight_;
+    PathState path_state_;
+    Float inverse_direction_pdf_;
+    uint8 explicit_connection_is_enabled_;
+    uint8 is_first_hit_;
+  };
+
+  //! A camera vertex which trains the guiding tree
+  struct GuidingVertex
+  {
+    Vector3 direction_;
+    Float inverse_pdf_; //!< The inverse pdf of the sampled direction
+    Float throughput_; //!< The average throughput of the next ray
+    Float contribution_; //!< The average contribution of the path at the vertex
+    uint leaf_;
+  };
+
+
+  //! Evaluate the pdf of the direction which is sampled by the mixture
+  static Float evalGuidedPdf(const PathGuidingTree* guiding_tree,
+                             const uint guiding_leaf,
+                             const Vector3& direction,
+                             const Float bxdf_pdf) noexcept;
+
+  //! Evaluate the pdf (area measure) of the light point seen from the reference
+  static Float evalLightPointPdf(const LightConnection& connection,
+                                 const Point3& reference,
+                                 const IntersectionInfo& light_intersection) noexcept;
+
   //! Evaluate the explicit connection
   void evalExplicitConnection(
       const World& world,
@@ -84,34 +213,110 @@ class PathTracing : public RenderingMethod
       const IntersectionInfo& intersection,
       const Spectra& camera_contribution,
       const Spectra& ray_weight,
+      const uint guiding_leaf,
       const bool emplicit_connection_is_enabled,
       const bool implicit_connection_is_enabled,
       Sampler& sampler,
       PathState& path_state,
       zisc::pmr::memory_resource* mem_resource,
+      RenderingCounter* counter,
+      ShadingProfile* profile,
       Spectra* contribution) const noexcept;
 
-  //! Evaluate the implicit connection
-  void evalImplicitConnection(
-      const World& world,
-      const Ray& ray,
-      const Float inverse_direction_pdf,
-      const IntersectionInfo& intersection,
-      const Spectra& camera_contribution,
-      const Spectra& ray_weight,
-      const bool implicit_connection_is_enabled,
-      const bool emplicit_connection_is_enabled,
-      zisc::pmr::memory_resource* mem_resource,
-      Spectra* contribution) const noexcept;
+  //! Find the guiding leaf of the surface, invalid if the surface isn't guided
+  uint findGuidingLeaf(const ShaderPointer& bxdf,
+                       const IntersectionInfo& intersection) const noexcept;
+
+  //! Fit the guiding tree to the training data of the cycle asynchronously
+  void fitGuidingTree() noexcept;
+
+  //! Generate the camera rays of the pixels of the tile at once
+  uint generateRays(const CameraModel& camera,
+                    const Wavelengths& sampled_wavelengths,
+                    RenderingTile& tile,
+                    CameraRayPacket* packet,
+                    Index2d* pixel_index_list,
+                    Spectra* camera_contribution_list,
+                    Float* inverse_direction_pdf_list) const noexcept;
 
   //! Return the light source sampler for eye path
   const LightSourceSampler& eyePathLightSampler() const noexcept;
 
+  //! Return the probability which samples a direction from the guiding tree
+  static constexpr Float guidingProbability() noexcept;
+
+  //! Return the guiding tree which is used by the rendering
+  PathGuidingTree& guidingTree() noexcept;
+
+  //! Return the guiding tree which is used by the rendering
+  const PathGuidingTree& guidingTree() const noexcept;
+
   //! Initialize
   void initialize(System& system,
                   const SettingNodeBase* settings,
                   const Scene& scene) noexcept;
 
+  //! Check if the guiding tree is trained in the current cycle
+  bool isGuidingTrainingEnabled() const noexcept;
+
+  //! Check if the light points are sampled by the solid angle
+  bool isLightSolidAngleSamplingEnabled() const noexcept;
+
+  //! Return the light sampling of the connections of the camera paths
+  LightConnection lightConnection() const noexcept;
+
+  //! Check if the camera hits of a tile are shaded in the order of materials
+  bool isMaterialSortingEnabled() const noexcept;
+
+  //! Check if path guiding is enabled
+  bool isPathGuidingEnabled() const noexcept;
+
+  //! Return the maximum number of the vertices of a path which train the tree
+  static constexpr uint maxNumOfGuidingVertices() noexcept;
+
+  //! Return the number of the wavelength batches which a path is split into
+  uint numOfWavelengthBatches() const noexcept;
+
+  //! Record the radiance estimates of the vertices into the guiding tree
+  void recordGuidingVertices(const GuidingVertex* vertex_list,
+                             const uint num_of_vertices,
+                             const Spectra& contribution) noexcept;
+
+  //! Sample the explicit connection to the environment light
+  static bool sampleExplicitEnvironmentConnection(
+      const LightConnection& connection,
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const uint guiding_leaf,
+      const bool implicit_connection_is_enabled,
+      const Float selection_probability,
+      Sampler& sampler,
+      PathState& path_state,
+      ShadingProfile* profile,
+      ShadowConnection* shadow_connection) noexcept;
+
+  //! Sample a light point for the explicit connection at the reference
+  static ShapePoint sampleLightPoint(const LightConnection& connection,
+                                     const Point3& reference,
+                                     const Object& light_source,
+                                     Sampler& sampler,
+                                     const PathState& path_state) noexcept;
+
+  //! Sample next ray from the mixture of the guiding tree and the BxDF
+  template <RouletteType kRouletteType>
+  Ray sampleGuidedRay(const Ray& ray,
+                      const ShaderPointer& bxdf,
+                      const IntersectionInfo& intersection,
+                      const uint guiding_leaf,
+                      Spectra* ray_weight,
+                      Spectra* next_ray_weight,
+                      Sampler& sampler,
+                      PathState& path_state,
+                      Float* inverse_direction_pdf) const noexcept;
+
   //! Parallelize path tracing
   void traceCameraPath(System& system,
                        Scene& scene,
@@ -119,19 +324,62 @@ class PathTracing : public RenderingMethod
                        const uint32 cycle) noexcept;
 
   //! Trace the camera path
+  template <RouletteType kRouletteType>
   void traceCameraPath(System& system,
                        Scene& scene,
                        const Wavelengths& sampled_wavelengths,
                        const uint32 cycle,
                        const uint thread_id,
-                       const Index2d& pixel_index) noexcept;
+                       const Index2d& pixel_index,
+                       const Ray& camera_ray,
+                       const Spectra& camera_ray_contribution,
+                       const Float camera_inverse_direction_pdf,
+                       const IntersectionInfo& camera_intersection,
+                       FilmTile* film_tile) noexcept;
+
+  //! Trace the vertices of the camera path from the intersection of the vertex
+  template <RouletteType kRouletteType>
+  bool traceCameraPathVertices(System& system,
+                               Scene& scene,
+                               const uint thread_id,
+                               const Index2d& pixel_index,
+                               const uint batch,
+                               GuidingVertex* guiding_vertex_list,
+                               uint* num_of_guiding_vertices,
+                               CameraPathVertex* vertex,
+                               Spectra* contribution) noexcept;
+
+  //! Trace the camera paths of the pixels of the tile
+  template <RouletteType kRouletteType>
+  void traceCameraPaths(System& system,
+                        Scene& scene,
+                        const Wavelengths& sampled_wavelengths,
+                        const uint32 cycle,
+                        const uint thread_id,
+                        RenderingTile& tile,
+                        FilmTile* film_tile) noexcept;
+
+  //! Install the guiding tree if the fitting has finished
+  void updateGuidingTree() noexcept;
 
 
   zisc::UniqueMemoryPointer<LightSourceSampler> eye_path_light_sampler_;
+  zisc::UniqueMemoryPointer<System::MemoryManager> guiding_memory_;
+  std::array<zisc::UniqueMemoryPointer<PathGuidingTree>, 2> guiding_tree_list_;
+  uint guiding_tree_index_;
+  uint32 guiding_iterations_;
+  uint32 num_of_guiding_fittings_;
+  uint32 num_of_wavelength_batches_;
+  uint8 light_solid_angle_sampling_;
+  uint8 material_sorting_;
+  uint8 path_guiding_;
+  std::future<void> guiding_fitting_task_; //!< Destroyed first to join the fitting
 };
 
 //! \} Core
 
 } // namespace nanairo
 
+#include "path_tracing-inl.hpp"
+
 #endif // NANAIRO_PATH_TRACING_HPP
@@ -9,8 +9,11 @@
 
 #include "probabilistic_ppm.hpp"
 // Standard C++ library
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <future>
 #include <limits>
 #include <memory>
@@ -34,10 +37,15 @@
 #include "NanairoCore/scene.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/CameraModel/camera_model.hpp"
+#include "NanairoCore/CameraModel/film.hpp"
+#include "NanairoCore/CameraModel/film_tile.hpp"
 #include "NanairoCore/Data/light_source_info.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/photon_cache.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Data/tile_queue.hpp"
 #include "NanairoCore/Data/wavelength_samples.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
 #include "NanairoCore/DataStructure/photon_map.hpp"
@@ -53,6 +61,9 @@
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
 #include "NanairoCore/Setting/rendering_method_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
+#include "NanairoCore/Utility/work_memory_arena.hpp"
 
 namespace nanairo {
 
@@ -65,27 +76,132 @@ ProbabilisticPpm::ProbabilisticPpm(System& system,
                                    const Scene& scene) noexcept :
     RenderingMethod(system, settings),
     thread_photon_list_{
-        decltype(thread_photon_list_)::allocator_type{&system.dataMemoryManager()}}
+        decltype(thread_photon_list_)::allocator_type{&system.dataMemoryManager()}},
+    visible_point_list_{
+        decltype(visible_point_list_)::allocator_type{&system.dataMemoryManager()}},
+    photon_map_index_{0},
+    visible_point_update_interval_{0},
+    visible_point_age_{0}
 {
   initialize(system, settings, scene);
 }
 
 /*!
   \details
-  No detailed.
+  Each sample is a pass of PPM with its own photon map and radius.
+  The photons of the first pass are traced alone, after that the photons of
+  the next pass are traced into the other map during the camera pass and
+  its map is constructed after the camera pass.
+  The passes of the next cycle aren't overlapped
+  since the wavelengths of the cycle aren't sampled yet.
   */
 void ProbabilisticPpm::render(System& system,
                               Scene& scene,
                               const Wavelengths& sampled_wavelengths,
                               const uint32 cycle) noexcept
 {
-  photon_map_.initialize(system, num_of_photons_);
-  tracePhoton(system, scene, sampled_wavelengths, cycle);
-  photon_map_.construct(system);
-  traceCameraPath(system, scene, sampled_wavelengths, cycle);
-  photon_map_.reset();
+  const auto& stopwatch = system.stopwatch();
+  auto photon_time = Clock::duration::zero();
+  auto construction_time = Clock::duration::zero();
+  auto camera_time = Clock::duration::zero();
+  // The photon tracing overlaps the camera pass, so only the construction is counted
+  HardwareCounts construction_counts;
+  const uint32 num_of_passes = system.samplesPerCycle();
+  if (isVisiblePointReuseEnabled()) {
+    const auto& resolution = scene.camera().imageResolution();
+    const std::size_t num_of_pixels = zisc::cast<std::size_t>(resolution[0]) *
+                                      zisc::cast<std::size_t>(resolution[1]);
+    if (visible_point_list_.size() != num_of_pixels) {
+      visible_point_list_.resize(num_of_pixels);
+      initMethod();
+    }
+  }
+  {
+    const uint32 sample_index = Method::calcSampleIndex(system, cycle, 0);
+    const auto start_time = stopwatch.elapsedTime();
+    auto& photon_map = photon_map_list_[photon_map_index_];
+    photon_map.initialize(system, num_of_photons_);
+    tracePhoton(system, scene, sampled_wavelengths, sample_index, &photon_map);
+    const auto photon_end_time = stopwatch.elapsedTime();
+    const auto construction_start_counts = system.readHardwareCounters();
+    photon_map.construct(system, calcPhotonSearchRadius(sample_index));
+    const auto construction_end_time = stopwatch.elapsedTime();
+    construction_counts.merge(
+        system.readHardwareCounters().since(construction_start_counts));
+
+    photon_time += photon_end_time - start_time;
+    construction_time += construction_end_time - photon_end_time;
+  }
+  for (uint32 s = 0; s < num_of_passes; ++s) {
+    const uint32 sample_index = Method::calcSampleIndex(system, cycle, s);
+    const bool has_next_pass = (s + 1) < num_of_passes;
+    const uint32 next_sample_index = has_next_pass
+        ? Method::calcSampleIndex(system, cycle, s + 1)
+        : sample_index;
+    auto& next_photon_map = photon_map_list_[1 - photon_map_index_];
+    const auto start_time = stopwatch.elapsedTime();
+    if (has_next_pass)
+      next_photon_map.initialize(system, num_of_photons_);
+    const auto overlapped_photon_time = traceCameraPath(
+        system, scene, sampled_wavelengths, sample_index, next_sample_index,
+        has_next_pass ? &next_photon_map : nullptr);
+    photon_map_list_[photon_map_index_].reset();
+    const auto camera_end_time = stopwatch.elapsedTime();
+    if (has_next_pass) {
+      const auto construction_start_counts = system.readHardwareCounters();
+      next_photon_map.construct(system, calcPhotonSearchRadius(next_sample_index));
+      photon_map_index_ = 1 - photon_map_index_;
+      construction_counts.merge(
+          system.readHardwareCounters().since(construction_start_counts));
+    }
+    const auto construction_end_time = stopwatch.elapsedTime();
+
+    photon_time += overlapped_photon_time;
+    camera_time += (camera_end_time - start_time) - overlapped_photon_time;
+    construction_time += construction_end_time - camera_end_time;
+  }
+
+  Method::clearCyclePhases();
+  Method::recordCyclePhase("Photon tracing", photon_time, HardwareCounts{});
+  Method::recordCyclePhase("Photon map construction", construction_time,
+                           construction_counts);
+  Method::recordCyclePhase("Camera pass", camera_time, HardwareCounts{});
+  if (isPhotonAutoTuningEnabled())
+    tuneNumOfPhotons(photon_time + construction_time, camera_time);
+}
+
+/*!
+  */
+bool ProbabilisticPpm::isFixedRadiusGathering() const noexcept
+{
+  return fixed_radius_gathering_ == kTrue;
+}
+
+/*!
+  \details
+  The camera or the scene is changed,
+  so the visible points are traced again at the next pass.
+  */
+void ProbabilisticPpm::initMethod() noexcept
+{
+  visible_point_age_ = visible_point_update_interval_;
 }
 
+/*!
+  */
+bool ProbabilisticPpm::isPhotonAutoTuningEnabled() const noexcept
+{
+  return photon_auto_tuning_ == kTrue;
+}
+
+/*!
+  */
+bool ProbabilisticPpm::isVisiblePointReuseEnabled() const noexcept
+{
+  return 0 < visible_point_update_interval_;
+}
+
+
 /*!
   */
 Float ProbabilisticPpm::calcPhotonSearchRadius(const uint64 cycle) const noexcept
@@ -106,7 +222,11 @@ Float ProbabilisticPpm::evalKernel(const Float t) const noexcept
 }
 
 /*!
- */
+  \details
+  If k is zero, the contributions of the photons are summed up
+  during the traversal of the photon map without a k-NN list
+  and the acceptance probability is the one of the search radius.
+  */
 void ProbabilisticPpm::estimateExplicitConnection(
     const Ray& ray,
     const ShaderPointer& bxdf,
@@ -123,30 +243,19 @@ void ProbabilisticPpm::estimateExplicitConnection(
   if (!explicit_connection_is_enabled)
     return;
 
-  // Search photon caches
-  {
-    const Float radius2 = zisc::power<2>(search_radius);
-    photon_list.clear();
-    const bool is_frontside_culling = !bxdf->isReflective();
-    const bool is_backside_culling = !bxdf->isTransmissive();
-    photon_map_.search(intersection.point(), intersection.normal(), radius2,
-                       is_frontside_culling, is_backside_culling, &photon_list);
-    if (photon_list.size() == 0)
-      return;
-  }
-
-  // Estimate radiance
   const auto& wavelengths = ray_weight.wavelengths();
   const Float inv_radius = zisc::invert(search_radius);
+  const Float radius2 = zisc::power<2>(search_radius);
   constexpr Float inv_pi = zisc::invert(zisc::kPi<Float>);
-  const Float inv_acceptance_probability = (photon_list.size() == photon_list.k())
-      ? inv_pi * zisc::invert(std::get<0>(photon_list[0]))
-      : inv_pi * zisc::power<2>(inv_radius);
+  const bool is_frontside_culling = !bxdf->isReflective();
+  const bool is_backside_culling = !bxdf->isTransmissive();
+
   Spectra radiance{wavelengths, 0.0};
-  for (uint i = 0; i < photon_list.size(); ++i) {
-    const auto& photon_point = photon_list[i];
+  auto add_photon = [&](const Float distance2,
+                        const PhotonCache* photon_cache,
+                        const Float inv_acceptance_probability)
+  {
     // Evaluate reflectance
-    const auto photon_cache = std::get<1>(photon_point);
     const auto vout = -photon_cache->incidentDirection();
     const auto result = bxdf->evalRadianceAndPdf(&ray.direction(),
                                                  &vout,
@@ -156,7 +265,7 @@ void ProbabilisticPpm::estimateExplicitConnection(
     ZISC_ASSERT(!f.hasNegative(), "The f of BxDF has negative values.");
 
     // Evaluate the photon weight
-    const Float distance = zisc::sqrt(std::get<0>(photon_point));
+    const Float distance = zisc::sqrt(distance2);
     const Float t = distance * inv_radius;
     ZISC_ASSERT(zisc::isInBounds(t, 0.0, 1.0), "The t is out of range [0, 1).");
     const Float kernel_weight = evalKernel(t);
@@ -177,13 +286,96 @@ void ProbabilisticPpm::estimateExplicitConnection(
             : 1.0;
 
     // Calc a contribution of a photon
-    const auto c = (camera_contribution * ray_weight * f * photon_cache->energy()) *
+    const auto c = (camera_contribution * ray_weight * f *
+                    photon_cache->energy(wavelengths)) *
                    (kernel_weight * inv_acceptance_probability *  mis_weight * wavelength_weight);
     ZISC_ASSERT(!c.hasNegative(), "The contribution has negative values.");
     radiance += c;
+  };
+
+  if (isFixedRadiusGathering()) {
+    // Accumulate the photons in the traversal
+    const Float inv_acceptance_probability = inv_pi * zisc::power<2>(inv_radius);
+    auto accumulate = [&add_photon, inv_acceptance_probability]
+    (const Float distance2, const PhotonCache* photon_cache)
+    {
+      add_photon(distance2, photon_cache, inv_acceptance_probability);
+    };
+    photonMap().gather(intersection.point(), intersection.normal(), radius2,
+                       is_frontside_culling, is_backside_culling, accumulate);
   }
-  if (0 < photon_list.size())
-    *contribution += radiance;
+  else {
+    // Search photon caches
+    photon_list.clear();
+    photonMap().search(intersection.point(), intersection.normal(), radius2,
+                       is_frontside_culling, is_backside_culling, &photon_list);
+    if (photon_list.size() == 0)
+      return;
+
+    // Estimate radiance
+    const Float inv_acceptance_probability = (photon_list.size() == photon_list.k())
+        ? inv_pi * zisc::invert(photon_list.longestDistance2())
+        : inv_pi * zisc::power<2>(inv_radius);
+    for (uint i = 0; i < photon_list.size(); ++i) {
+      add_photon(photon_list.distance2(i), photon_list.photon(i),
+                 inv_acceptance_probability);
+    }
+  }
+  *contribution += radiance;
+}
+
+/*!
+  \details
+  The BxDF is made again in the wavelengths of the pass,
+  so no ray is cast. The photons are the only estimate at the point
+  since the path ends there.
+  */
+void ProbabilisticPpm::estimateVisiblePoint(
+    System& system,
+    const Wavelengths& sampled_wavelengths,
+    const uint32 cycle,
+    const uint thread_id,
+    const Index2d& pixel_index,
+    const VisiblePoint& visible_point,
+    FilmTile* film_tile) noexcept
+{
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+  auto contribution = rebindWavelengths(visible_point.contribution_, wavelengths);
+  const bool explicit_connection_is_enabled =
+      (visible_point.is_valid_ == kTrue) &&
+      CoreConfig::pathTracingExplicitConnectionIsEnabled();
+  if (explicit_connection_is_enabled) {
+    // System
+    auto& memory_manager = system.threadMemoryManager(thread_id);
+    // Release the work memory of the path at the end of the path
+    WorkMemoryArena::Scope path_scope{&memory_manager};
+    const uint path_index = pixel_index[0] +
+                            pixel_index[1] * system.imageWidthResolution();
+    auto& sampler = system.localSampler(thread_id, path_index);
+    // Trace info
+    PathState path_state{cycle};
+    path_state.setLength(visible_point.path_length_);
+
+    // Evaluate material
+    const auto& intersection = visible_point.intersection_;
+    const auto& surface = intersection.object()->material().surface();
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
+    const auto bxdf = surface.makeBxdf(intersection, wavelengths,
+                                       sampler, path_state, &bxdf_memory);
+
+    const auto weight = rebindWavelengths(visible_point.weight_, wavelengths);
+    const Spectra ray_weight{wavelengths, 1.0};
+    auto& photon_list = thread_photon_list_[thread_id];
+    constexpr bool implicit_connection_is_enabled = false;
+    estimateExplicitConnection(visible_point.ray_, bxdf, intersection,
+                               weight, ray_weight, calcPhotonSearchRadius(cycle),
+                               visible_point.wavelength_is_selected_ == kTrue,
+                               explicit_connection_is_enabled,
+                               implicit_connection_is_enabled,
+                               photon_list, &contribution);
+  }
+  film_tile->add(pixel_index, contribution);
 }
 
 void ProbabilisticPpm::evalImplicitConnection(
@@ -203,16 +395,18 @@ void ProbabilisticPpm::evalImplicitConnection(
     return;
 
   const auto object = intersection.object();
-  const auto& material = object->material();
-  if (!material.isLightSource() || intersection.isBackFace())
+  if (!object->isLightSource() || intersection.isBackFace())
     return;
 
+  const auto& material = object->material();
+
   const auto& wavelengths = ray_weight.wavelengths();
   const auto vout = -ray.direction();
 
   // Get the light
   const auto& emitter = material.emitter();
-  const auto light = emitter.makeLight(intersection.uv(), wavelengths, mem_resource);
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(intersection.uv(), wavelengths, &light_memory);
 
   // Evaluate the radiance
   const auto result = light->evalRadianceAndPdf(nullptr,
@@ -226,12 +420,12 @@ void ProbabilisticPpm::evalImplicitConnection(
   Float mis_weight = 1.0;
   if (explicit_connection_is_enabled) {
     const auto& light_sampler = lightPathLightSampler();
-    const auto light_source_info = light_sampler.getInfo(intersection, object);
+    const auto light_source_info = light_sampler.getInfo(nullptr, object);
     const Float acceptance_probability = zisc::kPi<Float> * zisc::power<2>(search_radius);
     const Float margin_pdf = light_dir_pdf * zisc::cast<Float>(num_of_photons_) *
                              acceptance_probability *
-                             zisc::invert(light_source_info.inverseWeight() *
-                                          object->shape().surfaceArea());
+                             object->lightPointPdf(intersection.st()) *
+                             zisc::invert(light_source_info.inverseWeight());
     mis_weight = PathTracing::calcMisWeight(margin_pdf, inverse_direction_pdf);
   }
 
@@ -259,14 +453,15 @@ auto ProbabilisticPpm::generatePhoton(
   const auto light_source_info = light_sampler.sample(sampler, path_state);
   const auto light_source = light_source_info.object();
   path_state.setDimension(SampleDimension::kLightPointSample);
-  const auto light_point_info = light_source->shape().samplePoint(sampler,
-                                                                  path_state);
+  const auto light_point_info = light_source->sampleLightPoint(sampler,
+                                                            path_state);
   ZISC_ASSERT(0.0 < light_point_info.pdf(), "The point pdf is negative.");
 
   // Sample a direction
   const auto& emitter = light_source->material().emitter();
   const IntersectionInfo intersection{light_source, light_point_info};
-  const auto light = emitter.makeLight(intersection.uv(), wavelengths, mem_resource);
+  Method::ShaderMemory light_memory{mem_resource};
+  const auto light = emitter.makeLight(intersection.uv(), wavelengths, &light_memory);
   path_state.setDimension(SampleDimension::kLightSample1);
   const auto result = light->sample(nullptr, wavelengths,
                                     sampler, path_state, &intersection);
@@ -314,11 +509,35 @@ void ProbabilisticPpm::initialize(System& system,
   }
 
   {
+    photon_auto_tuning_ = parameters.photon_auto_tuning_;
+    target_photon_time_ratio_ = cast<Float>(parameters.target_photon_time_ratio_);
+    target_cycle_time_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::milliseconds{parameters.target_cycle_time_});
+  }
+
+  {
+    for (auto& photon_map : photon_map_list_)
+      photon_map.setMapType(parameters.photon_map_type_);
+  }
+
+  {
+    // The wavelengths are sampled at each cycle in the spectra mode,
+    // so the visible points can be used only by the pass which traced them
+    const uint32 interval = parameters.visible_point_update_interval_;
+    visible_point_update_interval_ = system.isRgbMode()
+        ? interval
+        : zisc::min(interval, 1u);
+    visible_point_age_ = visible_point_update_interval_;
+  }
+
+  {
+    // The k of zero means that the photons are gathered in the radius
+    const uint k = parameters.k_nearest_neighbor_;
+    fixed_radius_gathering_ = (k == 0) ? kTrue : kFalse;
     thread_photon_list_.reserve(threads.numOfThreads());
     for (uint i = 0; i < threads.numOfThreads(); ++i) {
-      const uint k = parameters.k_nearest_neighbor_;
-      thread_photon_list_.emplace_back(&system.dataMemoryManager());
-      thread_photon_list_.back().setK(k);
+      thread_photon_list_.emplace_back();
+      thread_photon_list_.back().setK(zisc::max(k, 1u));
     }
   }
 
@@ -339,6 +558,25 @@ const LightSourceSampler& ProbabilisticPpm::lightPathLightSampler() const noexce
   return *light_path_light_sampler_;
 }
 
+/*!
+  */
+const PhotonMap& ProbabilisticPpm::photonMap() const noexcept
+{
+  return photon_map_list_[photon_map_index_];
+}
+
+/*!
+  */
+auto ProbabilisticPpm::rebindWavelengths(
+    const Spectra& spectra,
+    const WavelengthSamples& wavelengths) noexcept -> Spectra
+{
+  Spectra result{wavelengths};
+  for (uint i = 0; i < Spectra::size(); ++i)
+    result.setIntensity(i, spectra.intensity(i));
+  return result;
+}
+
 /*!
   \details
   No detailed.
@@ -352,18 +590,32 @@ bool ProbabilisticPpm::surfaceHasPhotonMap(
 
 /*!
   \details
-  No detailed.
+  A thread which runs out of the tiles traces the photons of the next pass,
+  so the threads don't wait at the end of the camera pass.
+  The returned photon time is the one of the threads averaged.
+  The pass which reuses the visible points only gathers the photons.
   */
-void ProbabilisticPpm::traceCameraPath(
+auto ProbabilisticPpm::traceCameraPath(
     System& system,
     Scene& scene,
     const Wavelengths& sampled_wavelengths,
-    const uint32 cycle) noexcept
+    const uint32 cycle,
+    const uint32 next_cycle,
+    PhotonMap* next_photon_map) noexcept -> Clock::duration
 {
   auto& sampler = system.globalSampler();
 
+  // The visible points are traced again at each interval of the passes
+  const bool reuses_visible_points = isVisiblePointReuseEnabled();
+  bool visible_points_are_traced = true;
+  if (reuses_visible_points) {
+    visible_points_are_traced =
+        visible_point_update_interval_ <= visible_point_age_;
+    visible_point_age_ = visible_points_are_traced ? 1 : visible_point_age_ + 1;
+  }
+
   // Init camera
-  {
+  if (visible_points_are_traced) {
     PathState path_state{cycle};
     auto& camera = scene.camera();
     path_state.setDimension(SampleDimension::kCameraJittering);
@@ -372,35 +624,71 @@ void ProbabilisticPpm::traceCameraPath(
     camera.sampleLensPoint(sampler, path_state);
   }
 
-  std::atomic<uint> tile_count{0};
+  const uint num_of_tiles = calcNumOfTiles(scene.camera().imageResolution());
+  TileQueue tile_queue{num_of_tiles,
+                       system.threadManager().numOfThreads(),
+                       calcTileChunkSize(system, num_of_tiles),
+                       &system.globalMemoryManager()};
+  std::atomic<uint> photon_set_index{0};
+  std::atomic<Clock::rep> photon_time{0};
 
   auto trace_camera_path =
-  [this, &system, &scene, &sampled_wavelengths, cycle, &tile_count]
+  [this, &system, &scene, &sampled_wavelengths, cycle, next_cycle,
+   next_photon_map, reuses_visible_points, visible_points_are_traced,
+   &tile_queue, &photon_set_index, &photon_time]
   (const uint thread_id, const uint)
   {
-    const auto& camera = scene.camera();
-    const uint num_of_tiles = 
-        RenderingMethod::calcNumOfTiles(camera.imageResolution());
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Camera path task"};
+    auto& camera = scene.camera();
+    auto& statistics = camera.film().sampleStatistics();
+    const auto& resolution = camera.imageResolution();
 
-    for (uint index = tile_count++; index < num_of_tiles; index = tile_count++) {
-      auto tile = RenderingMethod::getRenderingTile(camera.imageResolution(), index);
+    auto trace_tile = [this, &system, &scene, &sampled_wavelengths, cycle,
+                       reuses_visible_points, visible_points_are_traced,
+                       thread_id, &statistics, &resolution](RenderingTile& tile)
+    {
+      FilmTile film_tile{tile};
       for (uint i = 0; i < tile.numOfPixels(); ++i) {
         const auto& pixel_index = tile.current();
-        traceCameraPath(system, scene, sampled_wavelengths,
-                        cycle, thread_id, pixel_index);
+        if (reuses_visible_points) {
+          const uint pixel = pixel_index[0] + pixel_index[1] * resolution[0];
+          auto& visible_point = visible_point_list_[pixel];
+          if (visible_points_are_traced) {
+            traceVisiblePoint(system, scene, sampled_wavelengths,
+                              cycle, thread_id, pixel_index, &visible_point);
+          }
+          estimateVisiblePoint(system, sampled_wavelengths, cycle, thread_id,
+                               pixel_index, visible_point, &film_tile);
+        }
+        else {
+          traceCameraPath(system, scene, sampled_wavelengths,
+                          cycle, thread_id, pixel_index, &film_tile);
+        }
         tile.next();
       }
+      film_tile.commit(sampled_wavelengths.wavelengths(), &statistics);
+    };
+    forEachTile(tile_queue, thread_id, resolution, trace_tile);
+
+    if (next_photon_map != nullptr) {
+      const auto start_time = Clock::now();
+      tracePhotonSets(system, scene, sampled_wavelengths, next_cycle,
+                      thread_id, &photon_set_index, next_photon_map);
+      photon_time.fetch_add((Clock::now() - start_time).count(),
+                            std::memory_order_relaxed);
     }
   };
 
+  auto& threads = system.threadManager();
   {
-    auto& threads = system.threadManager();
     auto& work_resource = system.globalMemoryManager();
     constexpr uint start = 0;
-    const uint end = threads.numOfThreads();
+    const uint end = system.numOfActiveThreads();
     auto result = threads.enqueueLoop(trace_camera_path, start, end, &work_resource);
     result.wait();
   }
+  const Clock::rep n = zisc::cast<Clock::rep>(system.numOfActiveThreads());
+  return Clock::duration{photon_time.load(std::memory_order_relaxed) / n};
 }
 
 /*!
@@ -413,13 +701,17 @@ void ProbabilisticPpm::traceCameraPath(
     const Wavelengths& sampled_wavelengths,
     const uint32 cycle,
     const uint thread_id,
-    const Index2d& pixel_index) noexcept
+    const Index2d& pixel_index,
+    FilmTile* film_tile) noexcept
 {
   // System
   auto& memory_manager = system.threadMemoryManager(thread_id);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
   const uint path_index = pixel_index[0] +
                           pixel_index[1] * system.imageWidthResolution();
-  auto& sampler = system.localSampler(path_index);
+  auto& sampler = system.localSampler(thread_id, path_index);
+  auto& counter = Method::threadCounter(thread_id);
   // Scene
   const auto& world = scene.world();
   auto& camera = scene.camera();
@@ -445,10 +737,12 @@ void ProbabilisticPpm::traceCameraPath(
   const Float photon_search_radius = calcPhotonSearchRadius(cycle);
 
   while (ray.isAlive()) {
-    // Reset memory
-    memory_manager.reset();
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
     // Cast the ray
-    const auto intersection = Method::castRay(world, ray);
+    const auto ray_type = (path_state.length() == 1) ? RayCastType::kPrimary
+                                                     : RayCastType::kSecondary;
+    const auto intersection = Method::castRay(world, ray, ray_type, &counter);
     if (!intersection.isIntersected())
       break;
 
@@ -462,8 +756,9 @@ void ProbabilisticPpm::traceCameraPath(
     const auto& material = intersection.object()->material();
     const auto& surface = material.surface();
     path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
     const auto bxdf = surface.makeBxdf(intersection, wavelengths,
-                                       sampler, path_state, &memory_manager);
+                                       sampler, path_state, &bxdf_memory);
     RenderingMethod::updateSelectedWavelengthInfo(bxdf,
                                                   &ray_weight,
                                                   &wavelength_is_selected);
@@ -474,8 +769,11 @@ void ProbabilisticPpm::traceCameraPath(
                                                 &ray_weight, &next_ray_weight,
                                                 sampler, path_state,
                                                 &inverse_direction_pdf);
-    if (!next_ray.isAlive())
+    // The next ray is killed only by russian roulette
+    if (!next_ray.isAlive()) {
+      counter.addRouletteTermination();
       break;
+    }
     path_state.incrementLength();
 
     explicit_connection_is_enabled = surfaceHasPhotonMap(bxdf) &&
@@ -493,9 +791,116 @@ void ProbabilisticPpm::traceCameraPath(
     ray = next_ray;
     ray_weight = next_ray_weight;
   }
-  camera.addContribution(pixel_index, contribution);
-  // Reset memory
-  memory_manager.reset();
+  counter.addPath(path_state.length());
+  film_tile->add(pixel_index, contribution);
+}
+
+/*!
+  \details
+  The emissions which the path hits before the visible point
+  aren't weighted by MIS since no photon estimates them.
+  */
+void ProbabilisticPpm::traceVisiblePoint(
+    System& system,
+    Scene& scene,
+    const Wavelengths& sampled_wavelengths,
+    const uint32 cycle,
+    const uint thread_id,
+    const Index2d& pixel_index,
+    VisiblePoint* visible_point) noexcept
+{
+  ZISC_ASSERT(visible_point != nullptr, "The visible point is null.");
+  // System
+  auto& memory_manager = system.threadMemoryManager(thread_id);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
+  const uint path_index = pixel_index[0] +
+                          pixel_index[1] * system.imageWidthResolution();
+  auto& sampler = system.localSampler(thread_id, path_index);
+  auto& counter = Method::threadCounter(thread_id);
+  // Scene
+  const auto& world = scene.world();
+  auto& camera = scene.camera();
+  // Trace info
+  PathState path_state{cycle};
+  path_state.setLength(1);
+  const auto& wavelengths = sampled_wavelengths.wavelengths();
+  auto camera_contribution = makeSampledSpectra(sampled_wavelengths);
+  Spectra contribution{wavelengths};
+  bool wavelength_is_selected = false;
+
+  const bool implicit_connection_is_enabled =
+      CoreConfig::pathTracingImplicitConnectionIsEnabled();
+  constexpr bool explicit_connection_is_enabled = false;
+
+  // Generate a camera ray
+  Float inverse_direction_pdf;
+  Spectra ray_weight{wavelengths, 1.0};
+  auto ray = PathTracing::generateRay(camera, pixel_index, sampler, path_state,
+                                      &memory_manager,
+                                      &camera_contribution, &inverse_direction_pdf);
+
+  const Float photon_search_radius = calcPhotonSearchRadius(cycle);
+
+  visible_point->is_valid_ = kFalse;
+  while (ray.isAlive()) {
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
+    // Cast the ray
+    const auto ray_type = (path_state.length() == 1) ? RayCastType::kPrimary
+                                                     : RayCastType::kSecondary;
+    const auto intersection = Method::castRay(world, ray, ray_type, &counter);
+    if (!intersection.isIntersected())
+      break;
+
+    evalImplicitConnection(world, ray, inverse_direction_pdf, intersection,
+                           camera_contribution, ray_weight, photon_search_radius,
+                           implicit_connection_is_enabled,
+                           explicit_connection_is_enabled,
+                           &memory_manager, &contribution);
+
+    // Evaluate material
+    const auto& material = intersection.object()->material();
+    const auto& surface = material.surface();
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
+    const auto bxdf = surface.makeBxdf(intersection, wavelengths,
+                                       sampler, path_state, &bxdf_memory);
+    RenderingMethod::updateSelectedWavelengthInfo(bxdf,
+                                                  &ray_weight,
+                                                  &wavelength_is_selected);
+
+    // The path ends at the visible point
+    if (surfaceHasPhotonMap(bxdf)) {
+      visible_point->intersection_ = intersection;
+      visible_point->ray_ = ray;
+      visible_point->weight_ = camera_contribution * ray_weight;
+      visible_point->path_length_ = path_state.length();
+      visible_point->is_valid_ = kTrue;
+      visible_point->wavelength_is_selected_ = wavelength_is_selected ? kTrue
+                                                                      : kFalse;
+      break;
+    }
+
+    // Sample next ray
+    auto next_ray_weight = ray_weight;
+    const auto next_ray = Method::sampleNextRay(ray, bxdf, intersection,
+                                                &ray_weight, &next_ray_weight,
+                                                sampler, path_state,
+                                                &inverse_direction_pdf);
+    // The next ray is killed only by russian roulette
+    if (!next_ray.isAlive()) {
+      counter.addRouletteTermination();
+      break;
+    }
+    path_state.incrementLength();
+
+    // Update ray
+    ray = next_ray;
+    ray_weight = next_ray_weight;
+  }
+  counter.addPath(path_state.length());
+  visible_point->contribution_ = contribution;
 }
 
 /*!
@@ -506,35 +911,25 @@ void ProbabilisticPpm::tracePhoton(
     System& system,
     Scene& scene,
     const Wavelengths& sampled_wavelengths,
-    const uint32 cycle) noexcept
+    const uint32 cycle,
+    PhotonMap* photon_map) noexcept
 {
   std::atomic<uint> photon_set_index{0};
 
   auto trace_photon =
-  [this, &system, &scene, &sampled_wavelengths, cycle, &photon_set_index]
+  [this, &system, &scene, &sampled_wavelengths, cycle, &photon_set_index,
+   photon_map]
   (const uint thread_id, const uint)
   {
-    bool flag = true;
-    for (uint index = photon_set_index++; flag; index = photon_set_index++) {
-      constexpr uint photon_set_size =
-          zisc::power<2>(CoreConfig::sizeOfRenderingTileSide());
-      for (uint i = 0; i < photon_set_size; ++i) {
-        const uint photon_index = index * photon_set_size + i;
-        if (num_of_photons_ <= photon_index) {
-          flag = false;
-          break;
-        }
-        tracePhoton(system, scene, sampled_wavelengths,
-                    cycle, thread_id, photon_index);
-      }
-    }
+    tracePhotonSets(system, scene, sampled_wavelengths, cycle,
+                    thread_id, &photon_set_index, photon_map);
   };
 
   {
     auto& threads = system.threadManager();
     auto& work_resource = system.globalMemoryManager();
     constexpr uint start = 0;
-    const uint end = threads.numOfThreads();
+    const uint end = system.numOfActiveThreads();
     auto result = threads.enqueueLoop(trace_photon, start, end, &work_resource);
     result.get();
   }
@@ -550,11 +945,15 @@ void ProbabilisticPpm::tracePhoton(
     const Wavelengths& sampled_wavelengths,
     const uint32 cycle,
     const uint thread_id,
-    const uint photon_index) noexcept
+    const uint photon_index,
+    PhotonMap* photon_map) noexcept
 {
   // System
   auto& memory_manager = system.threadMemoryManager(thread_id);
-  auto& sampler = system.localSampler(photon_index);
+  // Release the work memory of the path at the end of the path
+  WorkMemoryArena::Scope path_scope{&memory_manager};
+  auto& sampler = system.localSampler(thread_id, photon_index);
+  auto& counter = Method::threadCounter(thread_id);
   // Scene
   const auto& world = scene.world();
   // Trace info
@@ -570,24 +969,30 @@ void ProbabilisticPpm::tracePhoton(
   auto photon = generatePhoton(sampler, path_state, &memory_manager,
                                &light_contribution, &inverse_sampling_pdf);
 
+  // The photon paths are counted by the rays and the stored photons
+  auto ray_type = RayCastType::kPrimary;
   while(true) {
-    // Reset memory
-    memory_manager.reset();
+    // Release the work memory of the bounce at the end of the bounce
+    WorkMemoryArena::Scope bounce_scope{&memory_manager};
     // Phton object intersection test
-    const auto intersection = Method::castRay(world, photon);
+    const auto intersection = Method::castRay(world, photon, ray_type, &counter);
+    ray_type = RayCastType::kSecondary;
     if (!intersection.isIntersected())
       break;
 
     // Evaluate the surface
     const auto& surface = intersection.object()->material().surface();
     path_state.setDimension(SampleDimension::kBxdfSample1);
+    Method::BxdfMemory bxdf_memory{&memory_manager};
     const auto bxdf = surface.makeBxdf(intersection, wavelengths,
-                                       sampler, path_state, &memory_manager);
+                                       sampler, path_state, &bxdf_memory);
 
     if (surfaceHasPhotonMap(bxdf)) {
       const auto photon_energy = light_contribution * photon_weight;
-      photon_map_.store(intersection.point(), photon.direction(), photon_energy,
-                        inverse_sampling_pdf, wavelength_is_selected);
+      photon_map->store(thread_id, intersection.point(), photon.direction(),
+                        photon_energy, inverse_sampling_pdf,
+                        wavelength_is_selected);
+      counter.addPhoton();
       break;
     }
 
@@ -600,8 +1005,10 @@ void ProbabilisticPpm::tracePhoton(
     photon = Method::sampleNextRay(photon, bxdf, intersection,
                                    &photon_weight, &next_photon_weight,
                                    sampler, path_state, &inverse_direction_pdf);
-    if (!photon.isAlive())
+    if (!photon.isAlive()) {
+      counter.addRouletteTermination();
       break;
+    }
     path_state.incrementLength();
 
     // Update the photon
@@ -609,8 +1016,68 @@ void ProbabilisticPpm::tracePhoton(
     ZISC_ASSERT(inverse_direction_pdf == 1.0,
                 "The direction pdf isn't 1: ", inverse_direction_pdf);
   }
-  // Reset memory
-  memory_manager.reset();
+}
+
+/*!
+  \details
+  The photons are taken by the sets of the tile size from the shared index.
+  */
+void ProbabilisticPpm::tracePhotonSets(
+    System& system,
+    Scene& scene,
+    const Wavelengths& sampled_wavelengths,
+    const uint32 cycle,
+    const uint thread_id,
+    std::atomic<uint>* photon_set_index,
+    PhotonMap* photon_map) noexcept
+{
+  TraceRecorder::Scope task_scope{system.traceRecorder(), "Photon task"};
+  bool flag = true;
+  for (uint index = (*photon_set_index)++; flag; index = (*photon_set_index)++) {
+    constexpr uint photon_set_size =
+        zisc::power<2>(CoreConfig::sizeOfRenderingTileSide());
+    for (uint i = 0; i < photon_set_size; ++i) {
+      const uint photon_index = index * photon_set_size + i;
+      if (num_of_photons_ <= photon_index) {
+        flag = false;
+        break;
+      }
+      tracePhoton(system, scene, sampled_wavelengths,
+                  cycle, thread_id, photon_index, photon_map);
+    }
+  }
+}
+
+/*!
+  \details
+  The photon time is assumed to be proportional to the number of photons.
+  The target of the photon time is the rest of the target cycle time
+  if it's specified, otherwise the camera time multiplied by the ratio.
+  The scale of an update is clamped, so the count converges smoothly.
+  */
+void ProbabilisticPpm::tuneNumOfPhotons(const Clock::duration photon_time,
+                                        const Clock::duration camera_time) noexcept
+{
+  using zisc::cast;
+  if (photon_time <= Clock::duration::zero())
+    return;
+
+  const double photon = cast<double>(photon_time.count());
+  const double camera = cast<double>(camera_time.count());
+  const double target = (target_cycle_time_ != Clock::duration::zero())
+      ? cast<double>(target_cycle_time_.count()) - camera
+      : cast<double>(target_photon_time_ratio_) * camera;
+
+  constexpr double min_scale = 0.5;
+  constexpr double max_scale = 2.0;
+  const double scale = zisc::clamp(target / photon, min_scale, max_scale);
+
+  constexpr double min_photons = 1024.0;
+  constexpr double max_photons = cast<double>(1u << 26);
+  const double n = zisc::clamp(scale * cast<double>(num_of_photons_),
+                               min_photons,
+                               max_photons);
+  num_of_photons_ = cast<uint>(n);
 }
 
 } // namespace nanairo
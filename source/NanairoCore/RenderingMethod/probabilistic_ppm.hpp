@@ -11,14 +11,19 @@
 #define NANAIRO_PROBABILISTIC_PPM_HPP
 
 // Standard C++ library
+#include <array>
+#include <atomic>
 #include <memory>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "rendering_method.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/ray.hpp"
 #include "NanairoCore/DataStructure/knn_photon_list.hpp"
 #include "NanairoCore/DataStructure/photon_map.hpp"
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
@@ -28,6 +33,7 @@ namespace nanairo {
 
 // Forward declaration
 class CameraModel;
+class FilmTile;
 class IntersectionInfo;
 class Material;
 class PathState;
@@ -36,6 +42,7 @@ class Sampler;
 class Scene;
 class ShaderModel;
 class System;
+class WavelengthSamples;
 class World;
 
 //! \addtogroup Core
@@ -43,11 +50,17 @@ class World;
 
 /*!
   \details
-  No detailed.
+  The passes of a cycle are pipelined with two photon maps,
+  the photons of the next pass are traced by the threads which have finished
+  the camera paths of the current pass.
+  If the visible point update interval is given, the camera paths end at
+  the first surfaces which have the photon map like SPPM, and the visible
+  points are cached per pixel and reused by the passes of the interval.
   */
 class ProbabilisticPpm : public RenderingMethod
 {
  public:
+  using Clock = zisc::Stopwatch::Clock;
   using Method = RenderingMethod;
   using Photon = Ray;
   using Spectra = typename Method::Spectra;
@@ -62,6 +75,18 @@ class ProbabilisticPpm : public RenderingMethod
                    const Scene& scene) noexcept;
 
 
+  //! Check if the photons are gathered in the radius without k-NN
+  bool isFixedRadiusGathering() const noexcept;
+
+  //! Initialize the method for rendering
+  void initMethod() noexcept override;
+
+  //! Check if the number of photons is tuned by the elapsed times
+  bool isPhotonAutoTuningEnabled() const noexcept;
+
+  //! Check if the camera paths end at the visible points
+  bool isVisiblePointReuseEnabled() const noexcept;
+
   //! Render scene using probabilistic ppm method
   void render(System& system,
               Scene& scene,
@@ -69,12 +94,38 @@ class ProbabilisticPpm : public RenderingMethod
               const uint32 cycle) noexcept override;
 
  private:
+  /*!
+    \details
+    The first surface which has the photon map on the camera path of a pixel.
+    The spectra are in the wavelengths of the pass which traced the point.
+    */
+  struct VisiblePoint
+  {
+    IntersectionInfo intersection_;
+    Ray ray_; //!< The ray which hits the point
+    Spectra weight_; //!< The camera contribution multiplied by the ray weight
+    Spectra contribution_; //!< The emission which the path hits before gathering
+    uint32 path_length_ = 0;
+    uint8 is_valid_ = kFalse; //!< The path hits a surface which has the photon map
+    uint8 wavelength_is_selected_ = kFalse;
+  };
+
+
   //! Calculate a photon search radius
   Float calcPhotonSearchRadius(const uint64 cycle) const noexcept;
 
   //! Evaluate the perlin kernel
   Float evalKernel(const Float t) const noexcept;
 
+  //! Gather the photons at the visible point and add the contribution
+  void estimateVisiblePoint(System& system,
+                            const Wavelengths& sampled_wavelengths,
+                            const uint32 cycle,
+                            const uint thread_id,
+                            const Index2d& pixel_index,
+                            const VisiblePoint& visible_point,
+                            FilmTile* film_tile) noexcept;
+
   //!
   void estimateExplicitConnection(
       const Ray& ray,
@@ -118,14 +169,23 @@ class ProbabilisticPpm : public RenderingMethod
   //! Return the light sampler for light path
   const LightSourceSampler& lightPathLightSampler() const noexcept;
 
+  //! Return the photon map which is gathered by the camera paths
+  const PhotonMap& photonMap() const noexcept;
+
+  //! Return the spectra which has the intensities in the wavelengths
+  static Spectra rebindWavelengths(const Spectra& spectra,
+                                   const WavelengthSamples& wavelengths) noexcept;
+
   //! Check if the surface has the photon map
   bool surfaceHasPhotonMap(const ShaderPointer& bxdf) const noexcept;
 
-  //! Trace camera path
-  void traceCameraPath(System& system,
-                       Scene& scene,
-                       const Wavelengths& wavelengths,
-                       const uint32 cycle) noexcept;
+  //! Trace camera path and the photons of the next pass if the map is given
+  Clock::duration traceCameraPath(System& system,
+                                  Scene& scene,
+                                  const Wavelengths& wavelengths,
+                                  const uint32 cycle,
+                                  const uint32 next_cycle,
+                                  PhotonMap* next_photon_map) noexcept;
 
   //! Trace camera path
   void traceCameraPath(System& system,
@@ -133,13 +193,24 @@ class ProbabilisticPpm : public RenderingMethod
                        const Wavelengths& wavelengths,
                        const uint32 cycle,
                        const uint thread_id,
-                       const Index2d& pixel_index) noexcept;
+                       const Index2d& pixel_index,
+                       FilmTile* film_tile) noexcept;
+
+  //! Trace the camera path of a pixel to the visible point
+  void traceVisiblePoint(System& system,
+                         Scene& scene,
+                         const Wavelengths& sampled_wavelengths,
+                         const uint32 cycle,
+                         const uint thread_id,
+                         const Index2d& pixel_index,
+                         VisiblePoint* visible_point) noexcept;
 
   //! Trace photons
   void tracePhoton(System& system,
                    Scene& scene,
                    const Wavelengths& sampled_wavelengths,
-                   const uint32 cycle) noexcept;
+                   const uint32 cycle,
+                   PhotonMap* photon_map) noexcept;
 
   //! Trace photons
   void tracePhoton(System& system,
@@ -147,13 +218,35 @@ class ProbabilisticPpm : public RenderingMethod
                    const Wavelengths& sampled_wavelengths,
                    const uint32 cycle,
                    const uint thread_id,
-                   const uint photon_index) noexcept;
+                   const uint photon_index,
+                   PhotonMap* photon_map) noexcept;
+
+  //! Trace the sets of photons until all photons are traced
+  void tracePhotonSets(System& system,
+                       Scene& scene,
+                       const Wavelengths& sampled_wavelengths,
+                       const uint32 cycle,
+                       const uint thread_id,
+                       std::atomic<uint>* photon_set_index,
+                       PhotonMap* photon_map) noexcept;
+
+  //! Tune the number of photons by the elapsed times of the cycle
+  void tuneNumOfPhotons(const Clock::duration photon_time,
+                        const Clock::duration camera_time) noexcept;
 
 
-  PhotonMap photon_map_;
+  std::array<PhotonMap, 2> photon_map_list_;
   zisc::pmr::vector<KnnPhotonList> thread_photon_list_;
+  zisc::pmr::vector<VisiblePoint> visible_point_list_;
   zisc::UniqueMemoryPointer<LightSourceSampler> light_path_light_sampler_;
+  Clock::duration target_cycle_time_;
+  Float target_photon_time_ratio_;
   uint num_of_photons_;
+  uint photon_map_index_;
+  uint32 visible_point_update_interval_;
+  uint32 visible_point_age_; //!< The passes which used the visible points
+  uint8 photon_auto_tuning_;
+  uint8 fixed_radius_gathering_;
 };
 
 //! \} Core
@@ -12,6 +12,8 @@
 
 #include "rendering_method.hpp"
 // Standard C++ library
+#include <array>
+#include <bitset>
 #include <functional>
 #include <limits>
 #include <tuple>
@@ -24,17 +26,22 @@
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
 #include "NanairoCore/world.hpp"
 #include "NanairoCore/Material/shader_model.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
 #include "NanairoCore/Data/rendering_tile.hpp"
+#include "NanairoCore/Data/tile_queue.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
 #include "NanairoCore/Sampling/russian_roulette.hpp"
 #include "NanairoCore/Sampling/sampled_direction.hpp"
 #include "NanairoCore/Sampling/sampled_spectra.hpp"
 #include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
 
 namespace nanairo {
 
@@ -44,7 +51,8 @@ class System;
 
 /*!
   \details
-  No detailed.
+  The threads count into their own counters during the cycle,
+  and the counters are merged after all threads finish the cycle.
   */
 inline
 void RenderingMethod::operator()(System& system,
@@ -52,7 +60,50 @@ void RenderingMethod::operator()(System& system,
                                  const Wavelengths& sampled_wavelengths,
                                  const uint32 cycle) noexcept
 {
-  render(system, scene, sampled_wavelengths, cycle);
+  for (auto& counter : thread_counter_list_)
+    counter.clear();
+  {
+    TraceRecorder::Scope scope{system.traceRecorder(), "Rendering method"};
+    render(system, scene, sampled_wavelengths, cycle);
+  }
+  cycle_counter_.clear();
+  for (const auto& counter : thread_counter_list_)
+    cycle_counter_.merge(counter);
+}
+
+/*!
+  */
+inline
+const RenderingCounter& RenderingMethod::cycleCounter() const noexcept
+{
+  return cycle_counter_;
+}
+
+/*!
+  \details
+  The phases are recorded by the methods which measure their cycles.
+  */
+inline
+const zisc::pmr::vector<RenderingPhase>& RenderingMethod::cyclePhaseList()
+    const noexcept
+{
+  return cycle_phase_list_;
+}
+
+/*!
+  */
+inline
+bool RenderingMethod::isShadingProfileEnabled() const noexcept
+{
+  return is_shading_profile_enabled_ == kTrue;
+}
+
+/*!
+  */
+inline
+uint RenderingMethod::previewScale() const noexcept
+{
+  return preview_scale_;
 }
 
 /*!
@@ -68,15 +119,57 @@ Float RenderingMethod::rayCastEpsilon() const noexcept
 /*!
   */
 inline
+void RenderingMethod::setPreviewScale(const uint scale) noexcept
+{
+  ZISC_ASSERT(0 < scale, "The preview scale is zero.");
+  ZISC_ASSERT(isPreviewSupported() || (scale == 1),
+              "The method doesn't support the preview.");
+  preview_scale_ = scale;
+}
+
+/*!
+  */
+inline
+void RenderingMethod::setTileWavelengthSampler(
+    const WavelengthSampler* sampler) noexcept
+{
+  ZISC_ASSERT(isTileWavelengthSamplingSupported() || (sampler == nullptr),
+              "The method doesn't support the tile wavelength sampling.");
+  tile_wavelength_sampler_ = sampler;
+}
+
+/*!
+  \details
+  The tiles are ordered by the Morton code of their positions,
+  so the number is rounded up to a power of 2 in each axis.
+  The indices which aren't in the image are checked by isTileInImage().
+  */
+inline
 uint RenderingMethod::calcNumOfTiles(const Index2d& resolution) const noexcept
 {
-  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
-  const uint dx = (resolution[0] / s) + ((resolution[0] % s != 0) ? 1 : 0);
-  const uint dy = (resolution[1] / s) + ((resolution[1] % s != 0) ? 1 : 0);
-  const uint n = dx * dy;
+  const auto tiles = calcTileResolution(resolution);
+  const uint n = (1u << calcTileBitLength(tiles[0])) *
+                 (1u << calcTileBitLength(tiles[1]));
   return n;
 }
 
+/*!
+  \details
+  A cycle traces the samples per cycle of each pixel,
+  so the sample indices of the cycles don't overlap.
+  The index is equal to the cycle if a cycle has only one sample.
+  */
+inline
+uint32 RenderingMethod::calcSampleIndex(const System& system,
+                                        const uint32 cycle,
+                                        const uint32 sample) noexcept
+{
+  ZISC_ASSERT(0 < cycle, "The cycle is zero.");
+  ZISC_ASSERT(sample < system.samplesPerCycle(), "The sample is out of range.");
+  const uint32 index = (cycle - 1) * system.samplesPerCycle() + sample + 1;
+  return index;
+}
+
 /*!
   */
 inline
@@ -94,11 +187,96 @@ Float RenderingMethod::calcShadowRayDistance(const Float diff2) const noexcept
 inline
 IntersectionInfo RenderingMethod::castRay(const World& world,
                                           const Ray& ray,
-                                          const Float max_distance,
-                                          const bool expect_no_hit) const noexcept
+                                          const RayCastType type,
+                                          RenderingCounter* counter,
+                                          const Float max_distance) const noexcept
 {
-  const auto& bvh = world.bvh();
-  return bvh.castRay(ray, max_distance, expect_no_hit);
+  ZISC_ASSERT(counter != nullptr, "The counter is null.");
+  counter->addRay(type);
+  const auto& bvh = traversalBvh(world);
+  return bvh.castRay(ray, max_distance, counter);
+}
+
+/*!
+  \details
+  The rays of a packet are the primary rays.
+  */
+template <uint kSize> inline
+void RenderingMethod::castRayPacket(
+    const World& world,
+    const RayPacket<kSize>& packet,
+    std::array<IntersectionInfo, kSize>* intersection_list,
+    RenderingCounter* counter,
+    const Float max_distance) const noexcept
+{
+  ZISC_ASSERT(counter != nullptr, "The counter is null.");
+  const std::bitset<32> active_mask{packet.activeMask()};
+  counter->addRays(RayCastType::kPrimary, active_mask.count());
+  const auto& bvh = traversalBvh(world);
+  bvh.castRayPacket(packet, max_distance, intersection_list, counter);
+}
+
+/*!
+  \details
+  Consecutive tiles in the Morton order make a square block of the image.
+  A chunk is the largest power of 4 tiles which leaves
+  enough chunks per thread to balance the load at the end of a cycle.
+  */
+inline
+uint RenderingMethod::calcTileChunkSize(const System& system,
+                                        const uint num_of_tiles) const noexcept
+{
+  constexpr uint chunks_per_thread = 16;
+  constexpr uint max_chunk_size = 64;
+  const uint num_of_chunks = chunks_per_thread * system.threadManager().numOfThreads();
+  uint chunk_size = 1;
+  while ((4 * chunk_size <= max_chunk_size) &&
+         (num_of_chunks <= num_of_tiles / (4 * chunk_size)))
+    chunk_size = 4 * chunk_size;
+  return chunk_size;
+}
+
+/*!
+  */
+inline
+void RenderingMethod::clearCyclePhases() noexcept
+{
+  cycle_phase_list_.clear();
+}
+
+/*!
+  \details
+  The thread takes its own tiles first, the same tiles as the last cycle,
+  then steals the tiles of the other threads.
+  The indices which aren't in the image are skipped.
+  */
+template <typename Function> inline
+void RenderingMethod::forEachTile(TileQueue& tile_queue,
+                                  const uint thread_id,
+                                  const Index2d& resolution,
+                                  Function&& func) const noexcept
+{
+  uint begin = 0,
+       end = 0;
+  while (tile_queue.next(thread_id, &begin, &end)) {
+    for (uint index = begin; index < end; ++index) {
+      if (isTileInImage(resolution, index)) {
+        auto tile = getRenderingTile(resolution, index);
+        func(tile);
+      }
+    }
+  }
+}
+
+/*!
+  */
+inline
+bool RenderingMethod::isTileInImage(const Index2d& resolution,
+                                    const uint index) const noexcept
+{
+  const auto tiles = calcTileResolution(resolution);
+  const auto position = calcTilePosition(resolution, index);
+  return (position[0] < tiles[0]) && (position[1] < tiles[1]);
 }
 
 /*!
@@ -107,11 +285,11 @@ inline
 RenderingTile RenderingMethod::getRenderingTile(const Index2d& resolution,
                                                 const uint index) const noexcept
 {
+  ZISC_ASSERT(isTileInImage(resolution, index), "The tile isn't in the image.");
   constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
-  const uint dx = (resolution[0] / s) + ((resolution[0] % s != 0) ? 1 : 0);
-
-  const uint x = index % dx;
-  const uint y = index / dx;
+  const auto position = calcTilePosition(resolution, index);
+  const uint x = position[0];
+  const uint y = position[1];
 
   const Index2d begin{x * s, y * s};
   const Index2d end{zisc::min((x + 1) * s, resolution[0]),
@@ -129,7 +307,19 @@ Ray RenderingMethod::makeShadowRay(const Point3& source,
                                    const Vector3& normal,
                                    const bool is_in_front) const noexcept
 {
-  const Float e = (is_in_front) ? rayCastEpsilon() : -rayCastEpsilon();
+  return makeShadowRay(source, dest, normal, rayCastEpsilon(), is_in_front);
+}
+
+/*!
+  */
+inline
+Ray RenderingMethod::makeShadowRay(const Point3& source,
+                                   const Point3& dest,
+                                   const Vector3& normal,
+                                   const Float ray_cast_epsilon,
+                                   const bool is_in_front) noexcept
+{
+  const Float e = (is_in_front) ? ray_cast_epsilon : -ray_cast_epsilon;
   const auto ray_epsilon = e * normal;
   ZISC_ASSERT(!isZeroVector(ray_epsilon), "Ray epsilon is zero vector.");
   const auto origin = source + ray_epsilon;
@@ -151,11 +341,81 @@ RouletteResult RenderingMethod::playRussianRoulette(
   return russian_roulette_(weight, sampler, path_state);
 }
 
+/*!
+  */
+template <RouletteType kRouletteType> inline
+RouletteResult RenderingMethod::playRussianRoulette(
+    const Spectra& weight,
+    Sampler& sampler,
+    PathState& path_state) const noexcept
+{
+  path_state.setDimension(SampleDimension::kRussianRoulette);
+  return russian_roulette_.play<kRouletteType>(weight, sampler, path_state);
+}
+
+/*!
+  */
+inline
+void RenderingMethod::recordCyclePhase(
+    const char* name,
+    const zisc::Stopwatch::Clock::duration time,
+    const HardwareCounts& counts) noexcept
+{
+  cycle_phase_list_.emplace_back(RenderingPhase{name, time, counts});
+}
+
+/*!
+  */
+inline
+RouletteType RenderingMethod::rouletteType() const noexcept
+{
+  return russian_roulette_.type();
+}
+
 /*!
   \details
   No detailed.
   */
 inline
+Ray RenderingMethod::sampleNextRay(const Ray& ray,
+                                   const ShaderPointer& bxdf,
+                                   const IntersectionInfo& intersection,
+                                   Spectra* ray_weight,
+                                   Spectra* next_ray_weight,
+                                   Sampler& sampler,
+                                   PathState& path_state,
+                                   Float* inverse_direction_pdf) const noexcept
+{
+  switch (rouletteType()) {
+   case RouletteType::kMaxWeight: {
+    return sampleNextRay<RouletteType::kMaxWeight>(
+        ray, bxdf, intersection, ray_weight, next_ray_weight,
+        sampler, path_state, inverse_direction_pdf);
+   }
+   case RouletteType::kAverageWeight: {
+    return sampleNextRay<RouletteType::kAverageWeight>(
+        ray, bxdf, intersection, ray_weight, next_ray_weight,
+        sampler, path_state, inverse_direction_pdf);
+   }
+   case RouletteType::kEfficiency: {
+    return sampleNextRay<RouletteType::kEfficiency>(
+        ray, bxdf, intersection, ray_weight, next_ray_weight,
+        sampler, path_state, inverse_direction_pdf);
+   }
+   case RouletteType::kPathLength:
+   default: {
+    return sampleNextRay<RouletteType::kPathLength>(
+        ray, bxdf, intersection, ray_weight, next_ray_weight,
+        sampler, path_state, inverse_direction_pdf);
+   }
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+template <RouletteType kRouletteType> inline
 Ray RenderingMethod::sampleNextRay(const Ray& ray,
                                    const ShaderPointer& bxdf,
                                    const IntersectionInfo& intersection,
@@ -181,13 +441,36 @@ Ray RenderingMethod::sampleNextRay(const Ray& ray,
   if (inverse_direction_pdf != nullptr)
     *inverse_direction_pdf = sampled_vout.inversePdf();
 
+  return makeNextRay<kRouletteType>(ray, intersection, sampled_vout.direction(),
+                                    weight, ray_weight, next_ray_weight,
+                                    sampler, path_state);
+}
+
+/*!
+  \details
+  The weight is the BxDF weight of the sampled direction,
+  the ray is killed if russian roulette terminates the path.
+  */
+template <RouletteType kRouletteType> inline
+Ray RenderingMethod::makeNextRay(const Ray& ray,
+                                 const IntersectionInfo& intersection,
+                                 const Vector3& vout,
+                                 const Spectra& weight,
+                                 Spectra* ray_weight,
+                                 Spectra* next_ray_weight,
+                                 Sampler& sampler,
+                                 PathState& path_state) const noexcept
+{
+  ZISC_ASSERT(ray_weight != nullptr, "The ray_weight is null.");
+  ZISC_ASSERT(next_ray_weight != nullptr, "The next_ray_weight is null.");
+
   Ray next_ray;
 
   // Play russian roulette
   const auto next_weight = *ray_weight * weight;
-  const auto roulette_result = playRussianRoulette(next_weight,
-                                                   sampler,
-                                                   path_state);
+  const auto roulette_result = playRussianRoulette<kRouletteType>(next_weight,
+                                                                  sampler,
+                                                                  path_state);
   if (roulette_result) {
     // Update ray weight
     const Float inverse_probability = zisc::invert(roulette_result.probability());
@@ -196,17 +479,78 @@ Ray RenderingMethod::sampleNextRay(const Ray& ray,
 
     // Create a next ray
     const auto& normal = intersection.normal();
-    const Float cos_theta_no = zisc::dot(normal, sampled_vout.direction());
+    const Float cos_theta_no = zisc::dot(normal, vout);
     const auto ray_epsilon = (0.0 < cos_theta_no)
         ? rayCastEpsilon() * normal
         : -rayCastEpsilon() * normal;
     ZISC_ASSERT(!isZeroVector(ray_epsilon), "The ray epsilon is zero vector.");
-    next_ray = Ray::makeRay(intersection.point() + ray_epsilon,
-                            sampled_vout.direction());
+    next_ray = Ray::makeRay(intersection.point() + ray_epsilon, vout);
+    // The cone keeps spreading as a specular reflection
+    next_ray.setCone(ray.footprint(intersection.rayDistance()), ray.coneSpread());
   }
   return next_ray;
 }
 
+/*!
+  */
+inline
+bool RenderingMethod::testOcclusion(const World& world,
+                                    const Ray& ray,
+                                    const Float max_distance,
+                                    RenderingCounter* counter,
+                                    const Object* target_object) const noexcept
+{
+  ZISC_ASSERT(counter != nullptr, "The counter is null.");
+  counter->addRay(RayCastType::kShadow);
+  const auto& bvh = traversalBvh(world);
+  return bvh.testOcclusion(ray, max_distance, target_object, counter);
+}
+
+/*!
+  */
+inline
+RenderingCounter& RenderingMethod::threadCounter(const uint thread_id) noexcept
+{
+  ZISC_ASSERT(thread_id < thread_counter_list_.size(),
+              "The thread id is out of range.");
+  return thread_counter_list_[thread_id];
+}
+
+/*!
+  \details
+  The preview traces the simplified geometry of the world if it has one,
+  and the converged rendering always traces the full geometry.
+  */
+inline
+const Bvh& RenderingMethod::traversalBvh(const World& world) const noexcept
+{
+  const Bvh* proxy_bvh = world.proxyBvh();
+  return ((1 < previewScale()) && (proxy_bvh != nullptr)) ? *proxy_bvh
+                                                          : world.bvh();
+}
+
+/*!
+  */
+inline
+ShadingProfile* RenderingMethod::threadShadingProfile(const uint thread_id) noexcept
+{
+  ShadingProfile* profile = nullptr;
+  if (isShadingProfileEnabled()) {
+    ZISC_ASSERT(thread_id < thread_profile_list_.size(),
+                "The thread id is out of range.");
+    profile = &thread_profile_list_[thread_id];
+  }
+  return profile;
+}
+
+/*!
+  */
+inline
+bool RenderingMethod::tileWavelengthSamplingIsEnabled() const noexcept
+{
+  return tile_wavelength_sampler_ != nullptr;
+}
+
 /*!
   \details
   No detailed.
@@ -229,6 +573,56 @@ void RenderingMethod::updateSelectedWavelengthInfo(
   }
 }
 
+/*!
+  */
+inline
+uint RenderingMethod::calcTileBitLength(const uint num_of_tiles) noexcept
+{
+  uint bits = 0;
+  while ((1u << bits) < num_of_tiles)
+    ++bits;
+  return bits;
+}
+
+/*!
+  \details
+  The low bits of the index are interleaved into x and y.
+  The remaining high bits belong to the longer axis,
+  so an image which isn't square doesn't waste many indices.
+  */
+inline
+Index2d RenderingMethod::calcTilePosition(const Index2d& resolution,
+                                          const uint index) noexcept
+{
+  const auto tiles = calcTileResolution(resolution);
+  const uint bx = calcTileBitLength(tiles[0]);
+  const uint by = calcTileBitLength(tiles[1]);
+  const uint m = zisc::min(bx, by);
+  uint x = 0;
+  uint y = 0;
+  for (uint bit = 0; bit < m; ++bit) {
+    x = x | (((index >> (2 * bit)) & 1u) << bit);
+    y = y | (((index >> (2 * bit + 1)) & 1u) << bit);
+  }
+  const uint high = index >> (2 * m);
+  if (by < bx)
+    x = x | (high << m);
+  else
+    y = y | (high << m);
+  return Index2d{x, y};
+}
+
+/*!
+  */
+inline
+Index2d RenderingMethod::calcTileResolution(const Index2d& resolution) noexcept
+{
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  const uint dx = (resolution[0] / s) + ((resolution[0] % s != 0) ? 1 : 0);
+  const uint dy = (resolution[1] / s) + ((resolution[1] % s != 0) ? 1 : 0);
+  return Index2d{dx, dy};
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_RENDERING_METHOD_INL_HPP
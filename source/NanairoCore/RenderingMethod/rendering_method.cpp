@@ -19,19 +19,28 @@
 #include "zisc/error.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
+#include "zisc/thread_manager.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "path_tracing.hpp"
 #include "light_tracing.hpp"
+#include "light_vertex_cache_bpt.hpp"
 #include "probabilistic_ppm.hpp"
+#include "wavefront_path_tracing.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
 #include "NanairoCore/world.hpp"
 #include "NanairoCore/Material/shader_model.hpp"
 #include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
 #include "NanairoCore/Sampling/russian_roulette.hpp"
 #include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
 #include "NanairoCore/Setting/rendering_method_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
@@ -45,20 +54,75 @@ class System;
   \details
   No detailed.
   */
-RenderingMethod::RenderingMethod(const System& /* system */,
+RenderingMethod::RenderingMethod(System& system,
                                  const SettingNodeBase* settings) noexcept :
+    cycle_phase_list_{&system.dataMemoryManager()},
+    thread_counter_list_{system.threadManager().numOfThreads(),
+                         &system.dataMemoryManager()},
+    thread_profile_list_{&system.dataMemoryManager()},
     russian_roulette_{settings},
-    ray_cast_epsilon_{0.0}
+    tile_wavelength_sampler_{nullptr},
+    ray_cast_epsilon_{0.0},
+    preview_scale_{1},
+    is_shading_profile_enabled_{kFalse}
 {
   initialize(settings);
 }
 
+/*!
+  \details
+  The profiles are allocated per thread like the counters,
+  so the threads count the costs without synchronization.
+  */
+void RenderingMethod::enableShadingProfile(const uint num_of_surfaces) noexcept
+{
+  auto mem_resource = thread_profile_list_.get_allocator().resource();
+  const std::size_t num_of_threads = thread_counter_list_.size();
+  thread_profile_list_.clear();
+  thread_profile_list_.reserve(num_of_threads);
+  for (std::size_t i = 0; i < num_of_threads; ++i) {
+    thread_profile_list_.emplace_back(mem_resource);
+    thread_profile_list_.back().setNumOfSurfaces(num_of_surfaces);
+  }
+  is_shading_profile_enabled_ = kTrue;
+}
+
 /*!
   */
 void RenderingMethod::initMethod() noexcept
 {
 }
 
+/*!
+  \details
+  A method which splats contributions to arbitrary pixels
+  can't stop sampling a pixel, so adaptive sampling is disabled by default.
+  */
+bool RenderingMethod::isAdaptiveSamplingSupported() const noexcept
+{
+  return false;
+}
+
+/*!
+  \details
+  The preview is disabled by default,
+  since the method has to trace only the first pixel of each block.
+  */
+bool RenderingMethod::isPreviewSupported() const noexcept
+{
+  return false;
+}
+
+/*!
+  \details
+  The wavelengths are shared by the whole frame by default,
+  since the photons and the light vertices are traced for all pixels.
+  */
+bool RenderingMethod::isTileWavelengthSamplingSupported() const noexcept
+{
+  return false;
+}
+
 /*!
   \details
   No detailed.
@@ -80,6 +144,13 @@ zisc::UniqueMemoryPointer<RenderingMethod> RenderingMethod::makeMethod(
                                                           scene);
     break;
    }
+   case RenderingMethodType::kWavefrontPathTracing: {
+    method = zisc::UniqueMemoryPointer<WavefrontPathTracing>::make(data_resource,
+                                                                   system,
+                                                                   settings,
+                                                                   scene);
+    break;
+   }
    case RenderingMethodType::kLightTracing: {
     method = zisc::UniqueMemoryPointer<LightTracing>::make(data_resource,
                                                            system,
@@ -87,6 +158,13 @@ zisc::UniqueMemoryPointer<RenderingMethod> RenderingMethod::makeMethod(
                                                            scene);
     break;
    }
+   case RenderingMethodType::kLightVertexCacheBpt: {
+    method = zisc::UniqueMemoryPointer<LightVertexCacheBpt>::make(data_resource,
+                                                                  system,
+                                                                  settings,
+                                                                  scene);
+    break;
+   }
    case RenderingMethodType::kProbabilisticPpm:
     method = zisc::UniqueMemoryPointer<ProbabilisticPpm>::make(data_resource,
                                                                system,
@@ -100,6 +178,39 @@ zisc::UniqueMemoryPointer<RenderingMethod> RenderingMethod::makeMethod(
   return method;
 }
 
+/*!
+  */
+void RenderingMethod::mergeShadingProfile(ShadingProfile* profile) const noexcept
+{
+  ZISC_ASSERT(profile != nullptr, "The profile is null.");
+  for (const auto& thread_profile : thread_profile_list_)
+    profile->merge(thread_profile);
+}
+
+/*!
+  \details
+  The wavelengths are sampled from the stream of the first pixel of the tile,
+  so the tiles of a cycle have the independent wavelengths
+  and the wavelength noise isn't correlated in the whole frame.
+  The camera paths don't use the wavelength dimensions.
+  */
+auto RenderingMethod::sampleTileWavelengths(System& system,
+                                            const RenderingTile& tile,
+                                            const uint32 cycle,
+                                            const uint thread_id) const noexcept
+    -> Wavelengths
+{
+  ZISC_ASSERT(tileWavelengthSamplingIsEnabled(),
+              "The tile wavelength sampling isn't enabled.");
+  const auto& begin = tile.begin();
+  const uint stream = begin[0] + begin[1] * system.imageWidthResolution();
+  auto& sampler = system.localSampler(thread_id, stream);
+  PathState path_state{cycle};
+  path_state.setDimension(SampleDimension::kWavelengthSample1);
+  const auto& wavelength_sampler = *tile_wavelength_sampler_;
+  return wavelength_sampler(sampler, path_state);
+}
+
 /*!
   \details
   No detailed.
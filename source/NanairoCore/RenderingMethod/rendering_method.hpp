@@ -11,31 +11,43 @@
 #define NANAIRO_RENDERING_METHOD_HPP
 
 // Standard C++ library
+#include <array>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/stopwatch.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
 #include "NanairoCore/Data/rendering_tile.hpp"
+#include "NanairoCore/Data/shading_profile.hpp"
 #include "NanairoCore/Sampling/russian_roulette.hpp"
 #include "NanairoCore/Sampling/sampled_wavelengths.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/inline_memory_resource.hpp"
 
 namespace nanairo {
 
 // Forward declaration
+class Bvh;
 class IntersectionInfo;
+class Object;
 class PathState;
 class SampledSpectra;
 class Sampler;
 class Scene;
 class System;
 class ShaderModel;
+class TileQueue;
+class WavelengthSampler;
 class World;
 
 //! \addtogroup Core
@@ -44,10 +56,20 @@ class World;
 enum class RenderingMethodType : uint32
 {
   kPathTracing                = zisc::Fnv1aHash32::hash("PathTracing"),
+  kWavefrontPathTracing       = zisc::Fnv1aHash32::hash("WavefrontPathTracing"),
   kLightTracing               = zisc::Fnv1aHash32::hash("LightTracing"),
+  kLightVertexCacheBpt        = zisc::Fnv1aHash32::hash("LightVertexCacheBPT"),
   kProbabilisticPpm           = zisc::Fnv1aHash32::hash("ProbabilisticPPM")
 };
 
+//! The elapsed time and the hardware counts of a phase of a rendering cycle
+struct RenderingPhase
+{
+  const char* name_;
+  zisc::Stopwatch::Clock::duration time_;
+  HardwareCounts counts_;
+};
+
 /*!
   \details
   No detailed.
@@ -59,31 +81,60 @@ class RenderingMethod
   using Wavelengths = SampledWavelengths;
   using Shader = ShaderModel;
   using ShaderPointer = zisc::UniqueMemoryPointer<Shader>;
+  using BxdfMemory = InlineMemoryResource<512>;
+  using ShaderMemory = InlineMemoryResource<256>; //!< For a light or a sensor
 
 
   //! Initialize the rendering method
-  RenderingMethod(const System& system, const SettingNodeBase* settings) noexcept;
+  RenderingMethod(System& system, const SettingNodeBase* settings) noexcept;
 
   //! Finalize the rendering method
   virtual ~RenderingMethod() noexcept {}
 
 
-  //! Render the scene
+  //! Render the scene and merge the counters of the threads
   void operator()(System& system,
                   Scene& scene,
                   const Wavelengths& sampled_wavelengths,
                   const uint32 cycle) noexcept;
 
 
+  //! Return the counts of the last cycle
+  const RenderingCounter& cycleCounter() const noexcept;
+
+  //! Return the phases of the last cycle
+  const zisc::pmr::vector<RenderingPhase>& cyclePhaseList() const noexcept;
+
+  //! Profile the shading costs of the surfaces per thread
+  void enableShadingProfile(const uint num_of_surfaces) noexcept;
+
   //! Initialize the method for rendering
   virtual void initMethod() noexcept;
 
+  //! Check if the method can skip the converged tiles of adaptive sampling
+  virtual bool isAdaptiveSamplingSupported() const noexcept;
+
+  //! Check if the method can render the low resolution preview
+  virtual bool isPreviewSupported() const noexcept;
+
+  //! Check if the shading costs of the surfaces are profiled
+  bool isShadingProfileEnabled() const noexcept;
+
+  //! Check if the method can sample the wavelengths per rendering tile
+  virtual bool isTileWavelengthSamplingSupported() const noexcept;
+
   //! Make rendering method
   static zisc::UniqueMemoryPointer<RenderingMethod> makeMethod(
       System& system,
       const SettingNodeBase* settings,
       const Scene& scene) noexcept;
 
+  //! Return the resolution scale of the preview, 1 means the full resolution
+  uint previewScale() const noexcept;
+
+  //! Add the shading costs of the threads to the profile
+  void mergeShadingProfile(ShadingProfile* profile) const noexcept;
+
   //! Return the ray cast epsilon
   Float rayCastEpsilon() const noexcept;
 
@@ -93,38 +144,108 @@ class RenderingMethod
                       const Wavelengths& sampled_wavelengths,
                       const uint32 cycle) noexcept = 0;
 
+  //! Set the resolution scale of the preview
+  void setPreviewScale(const uint scale) noexcept;
+
+  //! Set the sampler of the wavelengths of the tiles, null samples them per cycle
+  void setTileWavelengthSampler(const WavelengthSampler* sampler) noexcept;
+
  protected:
-  //! Calculate the number of rendering tiles
+  //! Calculate the number of rendering tile indices in the Morton order
   uint calcNumOfTiles(const Index2d& resolution) const noexcept;
 
   //! Calculate the number of pixel blocks
   uint calcPixelBlockSize(const uint width, const uint height) const noexcept;
 
+  //! Calculate the sampler index of the sample of the cycle
+  static uint32 calcSampleIndex(const System& system,
+                                const uint32 cycle,
+                                const uint32 sample) noexcept;
+
   //! Calculate the max distance of the shadow ray
   Float calcShadowRayDistance(const Float diff2) const noexcept;
 
+  //! Calculate the number of consecutive tiles which a thread takes at once
+  uint calcTileChunkSize(const System& system,
+                         const uint num_of_tiles) const noexcept;
+
   //! Find and return the closest intersection of the ray
   IntersectionInfo castRay(
       const World& world,
       const Ray& ray,
-      const Float max_distance = std::numeric_limits<Float>::max(),
-      const bool expect_no_hit = false) const noexcept;
+      const RayCastType type,
+      RenderingCounter* counter,
+      const Float max_distance = std::numeric_limits<Float>::max()) const noexcept;
+
+  //! Find the closest intersection of each ray of the packet
+  template <uint kSize>
+  void castRayPacket(
+      const World& world,
+      const RayPacket<kSize>& packet,
+      std::array<IntersectionInfo, kSize>* intersection_list,
+      RenderingCounter* counter,
+      const Float max_distance = std::numeric_limits<Float>::max()) const noexcept;
+
+  //! Clear the phases of the cycle
+  void clearCyclePhases() noexcept;
+
+  //! Apply the function to each tile in the image which the thread takes
+  template <typename Function>
+  void forEachTile(TileQueue& tile_queue,
+                   const uint thread_id,
+                   const Index2d& resolution,
+                   Function&& func) const noexcept;
+
+  //! Check if the tile of the index is in the image
+  bool isTileInImage(const Index2d& resolution, const uint index) const noexcept;
 
   //! Get the rendering tile
   RenderingTile getRenderingTile(const Index2d& resolution,
                                  const uint index) const noexcept;
 
+  //! Make the next ray of the sampled direction with russian roulette
+  template <RouletteType kRouletteType>
+  Ray makeNextRay(const Ray& ray,
+                  const IntersectionInfo& intersection,
+                  const Vector3& vout,
+                  const Spectra& weight,
+                  Spectra* ray_weight,
+                  Spectra* next_ray_weight,
+                  Sampler& sampler,
+                  PathState& path_state) const noexcept;
+
   //! Make a shadow ray
   Ray makeShadowRay(const Point3& source,
                     const Point3& dest,
                     const Vector3& normal,
                     const bool is_in_front) const noexcept;
 
+  //! Make a shadow ray which is offset by the given ray cast epsilon
+  static Ray makeShadowRay(const Point3& source,
+                           const Point3& dest,
+                           const Vector3& normal,
+                           const Float ray_cast_epsilon,
+                           const bool is_in_front) noexcept;
+
   //! Play russian roulette
   RouletteResult playRussianRoulette(const Spectra& weight,
                                      Sampler& sampler,
                                      PathState& path_state) const noexcept;
 
+  //! Play russian roulette of the type which is fixed at compile time
+  template <RouletteType kRouletteType>
+  RouletteResult playRussianRoulette(const Spectra& weight,
+                                     Sampler& sampler,
+                                     PathState& path_state) const noexcept;
+
+  //! Record the elapsed time and the hardware counts of a phase of the cycle
+  void recordCyclePhase(const char* name,
+                        const zisc::Stopwatch::Clock::duration time,
+                        const HardwareCounts& counts) noexcept;
+
+  //! Return the type of the russian roulette
+  RouletteType rouletteType() const noexcept;
+
   //! Sample next ray
   Ray sampleNextRay(const Ray& ray,
                     const ShaderPointer& bxdf,
@@ -135,6 +256,42 @@ class RenderingMethod
                     PathState& path_state,
                     Float* inverse_direction_pdf = nullptr) const noexcept;
 
+  //! Sample next ray with the roulette which is fixed at compile time
+  template <RouletteType kRouletteType>
+  Ray sampleNextRay(const Ray& ray,
+                    const ShaderPointer& bxdf,
+                    const IntersectionInfo& intersection,
+                    Spectra* ray_weight,
+                    Spectra* next_ray_weight,
+                    Sampler& sampler,
+                    PathState& path_state,
+                    Float* inverse_direction_pdf = nullptr) const noexcept;
+
+  //! Check if the shadow ray is blocked by any object except the target
+  bool testOcclusion(const World& world,
+                     const Ray& ray,
+                     const Float max_distance,
+                     RenderingCounter* counter,
+                     const Object* target_object = nullptr) const noexcept;
+
+  //! Sample the wavelengths of the tile of the cycle
+  Wavelengths sampleTileWavelengths(System& system,
+                                    const RenderingTile& tile,
+                                    const uint32 cycle,
+                                    const uint thread_id) const noexcept;
+
+  //! Return the counter of the thread
+  RenderingCounter& threadCounter(const uint thread_id) noexcept;
+
+  //! Return the BVH which the rays traverse
+  const Bvh& traversalBvh(const World& world) const noexcept;
+
+  //! Return the shading profile of the thread, or null if the profile is disabled
+  ShadingProfile* threadShadingProfile(const uint thread_id) noexcept;
+
+  //! Check if the wavelengths are sampled per rendering tile
+  bool tileWavelengthSamplingIsEnabled() const noexcept;
+
   //! Update the wavelength selection info and the weight of the selected wavelength
   void updateSelectedWavelengthInfo(const ShaderPointer& bxdf,
                                     Spectra* weight,
@@ -142,12 +299,29 @@ class RenderingMethod
 
 
  private:
+  //! Return the bit length of the tile position in the Morton order
+  static uint calcTileBitLength(const uint num_of_tiles) noexcept;
+
+  //! Calculate the tile position of the index in the Morton order
+  static Index2d calcTilePosition(const Index2d& resolution,
+                                  const uint index) noexcept;
+
+  //! Return the number of tiles in each axis
+  static Index2d calcTileResolution(const Index2d& resolution) noexcept;
+
   //! Initialize the rendering method
   void initialize(const SettingNodeBase* settings) noexcept;
 
 
+  zisc::pmr::vector<RenderingPhase> cycle_phase_list_;
+  zisc::pmr::vector<RenderingCounter> thread_counter_list_;
+  zisc::pmr::vector<ShadingProfile> thread_profile_list_;
+  RenderingCounter cycle_counter_;
   RussianRoulette russian_roulette_;
+  const WavelengthSampler* tile_wavelength_sampler_;
   Float ray_cast_epsilon_;
+  uint preview_scale_;
+  uint8 is_shading_profile_enabled_;
 };
 
 //! \} Core
@@ -0,0 +1,32 @@
+/*!
+  \file wavefront_path_tracing-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WAVEFRONT_PATH_TRACING_INL_HPP
+#define NANAIRO_WAVEFRONT_PATH_TRACING_INL_HPP
+
+#include "wavefront_path_tracing.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The queues of a wave take about 40 MB,
+  which is small enough not to depend on the image resolution.
+  */
+inline
+constexpr uint32 WavefrontPathTracing::waveSize() noexcept
+{
+  return 1u << 16;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_WAVEFRONT_PATH_TRACING_INL_HPP
@@ -0,0 +1,699 @@
+/*!
+  \file wavefront_path_tracing.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "wavefront_path_tracing.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
+#include "zisc/thread_manager.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "path_tracing.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/scene.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/world.hpp"
+#include "NanairoCore/CameraModel/camera_model.hpp"
+#include "NanairoCore/CameraModel/film.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/light_source_bound.hpp"
+#include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Data/shading_profile.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/ray_sorter.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Material/shader_model.hpp"
+#include "NanairoCore/Material/EmitterModel/emitter_model.hpp"
+#include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_point.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Setting/rendering_method_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
+#include "NanairoCore/Utility/work_memory_arena.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+WavefrontPathTracing::WavefrontPathTracing(System& system,
+                                           const SettingNodeBase* settings,
+                                           const Scene& scene) noexcept :
+    RenderingMethod(system, settings),
+    ray_list_{decltype(ray_list_)::allocator_type{&system.dataMemoryManager()}},
+    intersection_list_{
+        decltype(intersection_list_)::allocator_type{&system.dataMemoryManager()}},
+    previous_intersection_list_{
+        decltype(previous_intersection_list_)::allocator_type{&system.dataMemoryManager()}},
+    path_state_list_{
+        decltype(path_state_list_)::allocator_type{&system.dataMemoryManager()}},
+    camera_contribution_list_{
+        decltype(camera_contribution_list_)::allocator_type{&system.dataMemoryManager()}},
+    ray_weight_list_{
+        decltype(ray_weight_list_)::allocator_type{&system.dataMemoryManager()}},
+    contribution_list_{
+        decltype(contribution_list_)::allocator_type{&system.dataMemoryManager()}},
+    inverse_direction_pdf_list_{
+        decltype(inverse_direction_pdf_list_)::allocator_type{&system.dataMemoryManager()}},
+    wavelength_is_selected_list_{
+        decltype(wavelength_is_selected_list_)::allocator_type{&system.dataMemoryManager()}},
+    explicit_connection_list_{
+        decltype(explicit_connection_list_)::allocator_type{&system.dataMemoryManager()}},
+    active_path_list_{
+        decltype(active_path_list_)::allocator_type{&system.dataMemoryManager()}},
+    shadow_ray_list_{
+        decltype(shadow_ray_list_)::allocator_type{&system.dataMemoryManager()}},
+    shadow_distance_list_{
+        decltype(shadow_distance_list_)::allocator_type{&system.dataMemoryManager()}},
+    shadow_light_list_{
+        decltype(shadow_light_list_)::allocator_type{&system.dataMemoryManager()}},
+    shadow_contribution_list_{
+        decltype(shadow_contribution_list_)::allocator_type{&system.dataMemoryManager()}},
+    shadow_ray_is_queued_list_{
+        decltype(shadow_ray_is_queued_list_)::allocator_type{&system.dataMemoryManager()}},
+    thread_ray_sorter_list_{
+        decltype(thread_ray_sorter_list_)::allocator_type{&system.dataMemoryManager()}},
+    wave_begin_{0},
+    ray_sorting_{kFalse}
+{
+  initialize(system, settings, scene);
+}
+
+/*!
+  \details
+  The image is traced by waves of paths. All paths of a wave advance
+  one bounce per iteration and the terminated paths are removed
+  from the active path list, so the later stages run over fewer paths.
+  */
+void WavefrontPathTracing::render(System& system,
+                                  Scene& scene,
+                                  const Wavelengths& sampled_wavelengths,
+                                  const uint32 cycle) noexcept
+{
+  auto& sampler = system.globalSampler();
+
+  // Init camera
+  {
+    PathState path_state{cycle};
+    auto& camera = scene.camera();
+    path_state.setDimension(SampleDimension::kCameraJittering);
+    camera.jitter(sampler, path_state);
+    path_state.setDimension(SampleDimension::kCameraLensSample);
+    camera.sampleLensPoint(sampler, path_state);
+  }
+
+  // The stages are measured separately, since each runs over all paths of a wave
+  using Clock = zisc::Stopwatch::Clock;
+  constexpr std::array<const char*, 4> phase_name_list{{
+      "Path generation", "BVH traversal", "Shading", "Film accumulation"}};
+  std::array<Clock::duration, 4> phase_time_list;
+  phase_time_list.fill(Clock::duration::zero());
+  std::array<HardwareCounts, 4> phase_counts_list;
+  const auto& stopwatch = system.stopwatch();
+  auto measure = [&system, &stopwatch, &phase_time_list, &phase_counts_list]
+  (const uint phase, auto&& stage) noexcept
+  {
+    const auto start_time = stopwatch.elapsedTime();
+    const auto start_counts = system.readHardwareCounters();
+    stage();
+    phase_time_list[phase] += stopwatch.elapsedTime() - start_time;
+    phase_counts_list[phase].merge(system.readHardwareCounters().since(start_counts));
+  };
+
+  const auto& world = scene.world();
+  const uint32 num_of_pixels = system.imageWidthResolution() *
+                               system.imageHeightResolution();
+  for (wave_begin_ = 0; wave_begin_ < num_of_pixels; wave_begin_ += waveSize()) {
+    const uint32 num_of_paths = zisc::min(waveSize(), num_of_pixels - wave_begin_);
+    for (uint32 s = 0; s < system.samplesPerCycle(); ++s) {
+      const uint32 sample_index = Method::calcSampleIndex(system, cycle, s);
+      measure(0, [&]()
+      {
+        generatePaths(system, scene, sampled_wavelengths, sample_index, num_of_paths);
+      });
+      while (!active_path_list_.empty()) {
+        measure(1, [&]()
+        {
+          extendPaths(system, world);
+          compactActivePaths();
+        });
+        measure(2, [&]()
+        {
+          shadePaths(system);
+        });
+        measure(1, [&]()
+        {
+          traceShadowRays(system, world);
+          compactActivePaths();
+        });
+      }
+      measure(3, [&]()
+      {
+        accumulateContributions(system, scene, num_of_paths);
+      });
+    }
+  }
+
+  Method::clearCyclePhases();
+  for (uint phase = 0; phase < phase_name_list.size(); ++phase) {
+    Method::recordCyclePhase(phase_name_list[phase],
+                             phase_time_list[phase],
+                             phase_counts_list[phase]);
+  }
+}
+
+/*!
+  */
+bool WavefrontPathTracing::isAdaptiveSamplingSupported() const noexcept
+{
+  return true;
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void WavefrontPathTracing::accumulateContributions(System& system,
+                                                   Scene& scene,
+                                                   const uint32 num_of_paths) noexcept
+{
+  auto accumulate_contributions =
+  [this, &system, &scene, num_of_paths](const uint thread_id,
+                                        const uint task_id) noexcept
+  {
+    auto& camera = scene.camera();
+    const auto& statistics = scene.film().sampleStatistics();
+    auto& counter = Method::threadCounter(thread_id);
+    const auto range = system.calcTaskRange(num_of_paths, task_id);
+    for (uint32 index = range[0]; index < range[1]; ++index) {
+      // All paths of the wave have been terminated
+      counter.addPath(path_state_list_[index].length());
+      const auto pixel_index = pixelIndex(system, index);
+      if (statistics.isActive(pixel_index))
+        camera.addContribution(pixel_index, contribution_list_[index]);
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(accumulate_contributions, start, end,
+                                      &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  The relative order of the remaining paths is kept. But the shading sorts
+  the paths of each thread by their materials,
+  so the list isn't in the image order after the first shading.
+  */
+void WavefrontPathTracing::compactActivePaths() noexcept
+{
+  auto is_terminated = [this](const uint32 index) noexcept
+  {
+    return !ray_list_[index].isAlive();
+  };
+  const auto end = std::remove_if(active_path_list_.begin(),
+                                  active_path_list_.end(),
+                                  is_terminated);
+  active_path_list_.erase(end, active_path_list_.end());
+}
+
+/*!
+  */
+const LightSourceSampler& WavefrontPathTracing::eyePathLightSampler() const noexcept
+{
+  return *eye_path_light_sampler_;
+}
+
+/*!
+  \details
+  Each thread takes a contiguous range of the active paths.
+  If ray sorting is enabled, the rays of the range are reordered
+  by RaySorter and traversed in that order.
+  The camera rays are already coherent, so they aren't sorted.
+  */
+void WavefrontPathTracing::extendPaths(System& system, const World& world) noexcept
+{
+  const uint32 num_of_paths = zisc::cast<uint32>(active_path_list_.size());
+  if (num_of_paths == 0)
+    return;
+  // The paths of a wave advance one bounce at a time
+  const bool is_camera_ray = path_state_list_[active_path_list_[0]].length() == 1;
+  const auto& bvh_tree = world.bvh().bvhTree();
+  const bool ray_sorting_is_enabled = isRaySortingEnabled() && !is_camera_ray &&
+                                      !bvh_tree.empty();
+
+  const auto ray_type = is_camera_ray ? RayCastType::kPrimary
+                                      : RayCastType::kSecondary;
+  const auto connection = lightConnection();
+
+  auto extend_paths =
+  [this, &system, &world, &bvh_tree, &connection, num_of_paths,
+   ray_sorting_is_enabled, ray_type]
+  (const uint thread_id, const uint task_id) noexcept
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Path extension task"};
+    auto& counter = Method::threadCounter(thread_id);
+    const auto range = system.calcTaskRange(num_of_paths, task_id);
+    if (ray_sorting_is_enabled) {
+      auto& sorter = thread_ray_sorter_list_[task_id];
+      sorter.clear();
+      for (uint32 i = range[0]; i < range[1]; ++i)
+        sorter.add(ray_list_[active_path_list_[i]]);
+      sorter.sort(bvh_tree[0].boundingBox());
+      for (uint32 i = 0; i < sorter.numOfRays(); ++i) {
+        const uint32 index = active_path_list_[range[0] + sorter.slotIndex(i)];
+        intersection_list_[index] = Method::castRay(world, sorter.ray(i),
+                                                    ray_type, &counter);
+      }
+    }
+    else {
+      for (uint32 i = range[0]; i < range[1]; ++i) {
+        const uint32 index = active_path_list_[i];
+        intersection_list_[index] = Method::castRay(world, ray_list_[index],
+                                                    ray_type, &counter);
+      }
+    }
+    // Terminate the paths which escape from the scene
+    constexpr bool implicit_connection_is_enabled =
+        CoreConfig::pathTracingImplicitConnectionIsEnabled();
+    for (uint32 i = range[0]; i < range[1]; ++i) {
+      const uint32 index = active_path_list_[i];
+      if (!intersection_list_[index].isIntersected()) {
+        PathTracing::evalImplicitEnvironmentConnection(
+            connection, ray_list_[index], inverse_direction_pdf_list_[index],
+            camera_contribution_list_[index], ray_weight_list_[index],
+            implicit_connection_is_enabled,
+            explicit_connection_list_[index] == kTrue,
+            &contribution_list_[index]);
+        ray_list_[index].setAlive(false);
+      }
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(extend_paths, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void WavefrontPathTracing::generatePaths(System& system,
+                                         Scene& scene,
+                                         const Wavelengths& sampled_wavelengths,
+                                         const uint32 cycle,
+                                         const uint32 num_of_paths) noexcept
+{
+  // The converged pixels of adaptive sampling aren't traced
+  const auto& statistics = scene.film().sampleStatistics();
+  active_path_list_.clear();
+  for (uint32 index = 0; index < num_of_paths; ++index) {
+    if (statistics.isActive(pixelIndex(system, index)))
+      active_path_list_.emplace_back(index);
+  }
+
+  auto generate_paths =
+  [this, &system, &scene, &sampled_wavelengths, cycle]
+  (const uint thread_id, const uint task_id) noexcept
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Path generation task"};
+    auto& memory_manager = system.threadMemoryManager(thread_id);
+    const auto& camera = scene.camera();
+    const auto& wavelengths = sampled_wavelengths.wavelengths();
+    const auto range = system.calcTaskRange(active_path_list_.size(), task_id);
+    for (auto i = range[0]; i < range[1]; ++i) {
+      // Release the work memory of the ray generation at the end of the path
+      WorkMemoryArena::Scope path_scope{&memory_manager};
+      const uint32 index = active_path_list_[i];
+      auto& sampler = pathSampler(system, thread_id, index);
+      auto& path_state = path_state_list_[index];
+      path_state = PathState{cycle};
+      path_state.setLength(1);
+      camera_contribution_list_[index] = makeSampledSpectra(sampled_wavelengths);
+      ray_weight_list_[index] = Spectra{wavelengths, 1.0};
+      contribution_list_[index] = Spectra{wavelengths};
+      wavelength_is_selected_list_[index] = kFalse;
+      // Explicit camera-light connection isn't performed
+      explicit_connection_list_[index] = kFalse;
+      shadow_ray_is_queued_list_[index] = kFalse;
+      ray_list_[index] = PathTracing::generateRay(camera,
+                                                  pixelIndex(system, index),
+                                                  sampler,
+                                                  path_state,
+                                                  &memory_manager,
+                                                  &camera_contribution_list_[index],
+                                                  &inverse_direction_pdf_list_[index]);
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(generate_paths, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void WavefrontPathTracing::initialize(System& system,
+                                      const SettingNodeBase* settings,
+                                      const Scene& scene) noexcept
+{
+  const auto method_settings = castNode<RenderingMethodSettingNode>(settings);
+  const auto& parameters = method_settings->wavefrontPathTracingParameters();
+
+  {
+    const auto sampler_type = parameters.eye_path_light_sampler_type_;
+    eye_path_light_sampler_ = LightSourceSampler::makeSampler(
+        system,
+        sampler_type,
+        scene.world(),
+        settings->workResource());
+  }
+  {
+    ray_sorting_ = parameters.ray_sorting_;
+  }
+  {
+    constexpr uint32 n = waveSize();
+    ray_list_.resize(n);
+    intersection_list_.resize(n);
+    previous_intersection_list_.resize(n);
+    path_state_list_.resize(n);
+    camera_contribution_list_.resize(n);
+    ray_weight_list_.resize(n);
+    contribution_list_.resize(n);
+    inverse_direction_pdf_list_.resize(n);
+    wavelength_is_selected_list_.resize(n);
+    explicit_connection_list_.resize(n);
+    active_path_list_.reserve(n);
+    shadow_ray_list_.resize(n);
+    shadow_distance_list_.resize(n);
+    shadow_light_list_.resize(n);
+    shadow_contribution_list_.resize(n);
+    shadow_ray_is_queued_list_.resize(n);
+  }
+  if (isRaySortingEnabled()) {
+    auto& threads = system.threadManager();
+    const uint32 n = (waveSize() / threads.numOfThreads()) + 1;
+    thread_ray_sorter_list_.reserve(threads.numOfThreads());
+    for (uint i = 0; i < threads.numOfThreads(); ++i) {
+      thread_ray_sorter_list_.emplace_back(&system.dataMemoryManager());
+      thread_ray_sorter_list_.back().reserve(n);
+    }
+  }
+}
+
+/*!
+  */
+bool WavefrontPathTracing::isRaySortingEnabled() const noexcept
+{
+  return ray_sorting_ == kTrue;
+}
+
+/*!
+  \details
+  The lights are sampled by the area and no direction is guided,
+  which are the defaults of path tracing.
+  */
+PathTracing::LightConnection WavefrontPathTracing::lightConnection() const noexcept
+{
+  PathTracing::LightConnection connection;
+  connection.light_sampler_ = &eyePathLightSampler();
+  connection.guiding_tree_ = nullptr;
+  connection.ray_cast_epsilon_ = Method::rayCastEpsilon();
+  connection.solid_angle_sampling_ = kFalse;
+  return connection;
+}
+
+/*!
+  */
+Index2d WavefrontPathTracing::pixelIndex(const System& system,
+                                         const uint32 index) const noexcept
+{
+  const uint32 path_index = wave_begin_ + index;
+  const uint width = system.imageWidthResolution();
+  return Index2d{path_index % width, path_index / width};
+}
+
+/*!
+  */
+Sampler& WavefrontPathTracing::pathSampler(System& system,
+                                           const uint thread_id,
+                                           const uint32 index) const noexcept
+{
+  return system.localSampler(thread_id, wave_begin_ + index);
+}
+
+/*!
+  \details
+  The connection is sampled and evaluated by path tracing while the bxdf is alive.
+  Only the visibility test is deferred to the shadow stage,
+  where the shadow rays of all paths are traced together.
+  */
+void WavefrontPathTracing::sampleExplicitConnection(
+    const PathTracing::LightConnection& connection,
+    const Ray& ray,
+    const ShaderPointer& bxdf,
+    const IntersectionInfo& intersection,
+    const Spectra& camera_contribution,
+    const Spectra& ray_weight,
+    const bool implicit_connection_is_enabled,
+    const uint32 index,
+    Sampler& sampler,
+    PathState& path_state,
+    zisc::pmr::memory_resource* mem_resource,
+    ShadingProfile* profile) noexcept
+{
+  PathTracing::ShadowConnection shadow_connection;
+  const bool is_sampled = PathTracing::sampleExplicitConnection(
+      connection, ray, bxdf, intersection,
+      camera_contribution, ray_weight,
+      PathGuidingTree::invalidLeaf(),
+      implicit_connection_is_enabled,
+      sampler, path_state, mem_resource, profile,
+      &shadow_connection);
+  if (!is_sampled)
+    return;
+
+  // Queue the shadow ray
+  shadow_ray_list_[index] = shadow_connection.shadow_ray_;
+  shadow_distance_list_[index] = shadow_connection.max_distance_;
+  shadow_light_list_[index] = shadow_connection.light_source_;
+  shadow_contribution_list_[index] = shadow_connection.contribution_;
+  shadow_ray_is_queued_list_[index] = kTrue;
+}
+
+/*!
+  \details
+  The paths of a thread are sorted by their materials first,
+  so the same surface and emitter models are evaluated in a row.
+  */
+void WavefrontPathTracing::shadePaths(System& system) noexcept
+{
+  const uint32 num_of_paths = zisc::cast<uint32>(active_path_list_.size());
+  const auto connection = lightConnection();
+
+  auto shade_paths =
+  [this, &system, &connection, num_of_paths](const uint thread_id,
+                                             const uint task_id) noexcept
+  {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Path shading task"};
+    auto& memory_manager = system.threadMemoryManager(thread_id);
+    auto& counter = Method::threadCounter(thread_id);
+    auto profile = Method::threadShadingProfile(thread_id);
+    const auto range = system.calcTaskRange(num_of_paths, task_id);
+
+    // Sort the paths by their materials
+    {
+      auto has_less_material = [this](const uint32 lhs, const uint32 rhs) noexcept
+      {
+        const auto lhs_material = &intersection_list_[lhs].object()->material();
+        const auto rhs_material = &intersection_list_[rhs].object()->material();
+        return (lhs_material < rhs_material) ||
+               ((lhs_material == rhs_material) && (lhs < rhs));
+      };
+      std::sort(active_path_list_.begin() + range[0],
+                active_path_list_.begin() + range[1],
+                has_less_material);
+    }
+
+    constexpr bool implicit_connection_is_enabled =
+        CoreConfig::pathTracingImplicitConnectionIsEnabled();
+    for (uint32 i = range[0]; i < range[1]; ++i) {
+      const uint32 index = active_path_list_[i];
+      auto& sampler = pathSampler(system, thread_id, index);
+      auto& path_state = path_state_list_[index];
+      auto& ray = ray_list_[index];
+      auto& ray_weight = ray_weight_list_[index];
+      auto& camera_contribution = camera_contribution_list_[index];
+      const auto& intersection = intersection_list_[index];
+      const auto& wavelengths = ray_weight.wavelengths();
+
+      // Release the work memory of the bounce at the end of the bounce
+      WorkMemoryArena::Scope bounce_scope{&memory_manager};
+
+      PathTracing::evalImplicitConnection(connection, ray,
+                                          inverse_direction_pdf_list_[index],
+                                          intersection,
+                                          previous_intersection_list_[index],
+                                          camera_contribution, ray_weight,
+                                          implicit_connection_is_enabled,
+                                          explicit_connection_list_[index] == kTrue,
+                                          &memory_manager,
+                                          &contribution_list_[index]);
+
+      // Get a BxDF of the surface
+      const auto& material = intersection.object()->material();
+      const auto& surface = material.surface();
+      path_state.setDimension(SampleDimension::kBxdfSample1);
+      Method::BxdfMemory bxdf_memory{&memory_manager};
+      // The hit is counted with the making of the BxDF
+      const auto bxdf = [&]() noexcept
+      {
+        ShadingProfile::Scope profile_scope{profile, surface.index(), true};
+        return surface.makeBxdf(intersection, wavelengths,
+                                sampler, path_state, &bxdf_memory);
+      }();
+      {
+        bool wavelength_is_selected = wavelength_is_selected_list_[index] == kTrue;
+        Method::updateSelectedWavelengthInfo(bxdf,
+                                             &camera_contribution,
+                                             &wavelength_is_selected);
+        wavelength_is_selected_list_[index] = wavelength_is_selected ? kTrue : kFalse;
+      }
+
+      // Sample next ray
+      auto next_ray_weight = ray_weight;
+      const auto next_ray = [&]() noexcept
+      {
+        ShadingProfile::Scope profile_scope{profile, surface.index(), false};
+        return Method::sampleNextRay(ray, bxdf, intersection,
+                                     &ray_weight, &next_ray_weight,
+                                     sampler, path_state,
+                                     &inverse_direction_pdf_list_[index]);
+      }();
+      // The next ray is killed only by russian roulette
+      if (!next_ray.isAlive()) {
+        counter.addRouletteTermination();
+        ray.setAlive(false);
+        continue;
+      }
+      path_state.incrementLength();
+
+      const bool explicit_connection_is_enabled =
+          (bxdf->type() != ShaderType::Specular) &&
+          CoreConfig::pathTracingExplicitConnectionIsEnabled();
+      explicit_connection_list_[index] = explicit_connection_is_enabled
+          ? kTrue
+          : kFalse;
+      if (explicit_connection_is_enabled) {
+        sampleExplicitConnection(connection, ray, bxdf, intersection,
+                                 camera_contribution, ray_weight,
+                                 implicit_connection_is_enabled, index,
+                                 sampler, path_state, &memory_manager,
+                                 profile);
+      }
+
+      // Update ray
+      ray = next_ray;
+      ray_weight = next_ray_weight;
+      previous_intersection_list_[index] = intersection;
+    }
+  };
+
+  if (num_of_paths == 0)
+    return;
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(shade_paths, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void WavefrontPathTracing::traceShadowRays(System& system, const World& world) noexcept
+{
+  const uint32 num_of_paths = zisc::cast<uint32>(active_path_list_.size());
+
+  auto trace_shadow_rays =
+  [this, &system, &world, num_of_paths](const uint thread_id,
+                                        const uint task_id) noexcept
+  {
+    auto& counter = Method::threadCounter(thread_id);
+    const auto range = system.calcTaskRange(num_of_paths, task_id);
+    for (uint32 i = range[0]; i < range[1]; ++i) {
+      const uint32 index = active_path_list_[i];
+      if (shadow_ray_is_queued_list_[index] != kTrue)
+        continue;
+      shadow_ray_is_queued_list_[index] = kFalse;
+      if (!Method::testOcclusion(world, shadow_ray_list_[index],
+                                 shadow_distance_list_[index], &counter,
+                                 shadow_light_list_[index]))
+        contribution_list_[index] += shadow_contribution_list_[index];
+    }
+  };
+
+  if (num_of_paths == 0)
+    return;
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(trace_shadow_rays, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+} // namespace nanairo
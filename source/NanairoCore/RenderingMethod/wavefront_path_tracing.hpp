@@ -0,0 +1,175 @@
+/*!
+  \file wavefront_path_tracing.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WAVEFRONT_PATH_TRACING_HPP
+#define NANAIRO_WAVEFRONT_PATH_TRACING_HPP
+
+// Standard C++ library
+#include <memory>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "path_tracing.hpp"
+#include "rendering_method.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/DataStructure/ray_sorter.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Object;
+class Sampler;
+class Scene;
+class ShadingProfile;
+class System;
+class World;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Path tracing which traces a wave of paths stage by stage
+  \details
+  The states of the paths of a wave are stored as SoA queues.
+  Each bounce runs the extend, shade and shadow stages over the thread pool,
+  so a stage touches only its own data and the same kind of work is batched.
+  The paths are sorted by their materials before shading, and
+  the secondary rays can be sorted before traversal.
+  */
+class WavefrontPathTracing : public RenderingMethod
+{
+ public:
+  using Method = RenderingMethod;
+  using Spectra = typename Method::Spectra;
+  using Shader = ShaderModel;
+  using ShaderPointer = RenderingMethod::ShaderPointer;
+  using Wavelengths = typename Method::Wavelengths;
+
+
+  //! Initialize wavefront path tracing method
+  WavefrontPathTracing(System& system,
+                       const SettingNodeBase* settings,
+                       const Scene& scene) noexcept;
+
+
+  //! Check if the method can skip the converged tiles of adaptive sampling
+  bool isAdaptiveSamplingSupported() const noexcept override;
+
+  //! Render scene using wavefront path tracing method
+  void render(System& system,
+              Scene& scene,
+              const Wavelengths& sampled_wavelengths,
+              const uint32 cycle) noexcept override;
+
+  //! Return the number of paths which are traced at once
+  static constexpr uint32 waveSize() noexcept;
+
+ private:
+  //! Add the contributions of the paths to the film
+  void accumulateContributions(System& system,
+                               Scene& scene,
+                               const uint32 num_of_paths) noexcept;
+
+  //! Remove the terminated paths from the active path list
+  void compactActivePaths() noexcept;
+
+  //! Return the light source sampler for eye path
+  const LightSourceSampler& eyePathLightSampler() const noexcept;
+
+  //! Find the closest intersections of the active paths
+  void extendPaths(System& system, const World& world) noexcept;
+
+  //! Generate the camera rays of the paths
+  void generatePaths(System& system,
+                     Scene& scene,
+                     const Wavelengths& sampled_wavelengths,
+                     const uint32 cycle,
+                     const uint32 num_of_paths) noexcept;
+
+  //! Initialize
+  void initialize(System& system,
+                  const SettingNodeBase* settings,
+                  const Scene& scene) noexcept;
+
+  //! Check if the secondary rays are sorted before traversal
+  bool isRaySortingEnabled() const noexcept;
+
+  //! Return the light sampling of the connections of the paths
+  PathTracing::LightConnection lightConnection() const noexcept;
+
+  //! Return the pixel index of the path in the wave
+  Index2d pixelIndex(const System& system, const uint32 index) const noexcept;
+
+  //! Return the sampler of the path in the wave
+  Sampler& pathSampler(System& system,
+                       const uint thread_id,
+                       const uint32 index) const noexcept;
+
+  //! Sample the explicit connection and queue its shadow ray
+  void sampleExplicitConnection(
+      const PathTracing::LightConnection& connection,
+      const Ray& ray,
+      const ShaderPointer& bxdf,
+      const IntersectionInfo& intersection,
+      const Spectra& camera_contribution,
+      const Spectra& ray_weight,
+      const bool implicit_connection_is_enabled,
+      const uint32 index,
+      Sampler& sampler,
+      PathState& path_state,
+      zisc::pmr::memory_resource* mem_resource,
+      ShadingProfile* profile) noexcept;
+
+  //! Shade the active paths and sample the next rays
+  void shadePaths(System& system) noexcept;
+
+  //! Test the visibility of the queued shadow rays
+  void traceShadowRays(System& system, const World& world) noexcept;
+
+
+  // Path states
+  zisc::pmr::vector<Ray> ray_list_;
+  zisc::pmr::vector<IntersectionInfo> intersection_list_;
+  zisc::pmr::vector<IntersectionInfo> previous_intersection_list_;
+  zisc::pmr::vector<PathState> path_state_list_;
+  zisc::pmr::vector<Spectra> camera_contribution_list_;
+  zisc::pmr::vector<Spectra> ray_weight_list_;
+  zisc::pmr::vector<Spectra> contribution_list_;
+  zisc::pmr::vector<Float> inverse_direction_pdf_list_;
+  zisc::pmr::vector<uint8> wavelength_is_selected_list_;
+  zisc::pmr::vector<uint8> explicit_connection_list_;
+  zisc::pmr::vector<uint32> active_path_list_;
+  // Shadow ray queue
+  zisc::pmr::vector<Ray> shadow_ray_list_;
+  zisc::pmr::vector<Float> shadow_distance_list_;
+  zisc::pmr::vector<const Object*> shadow_light_list_;
+  zisc::pmr::vector<Spectra> shadow_contribution_list_;
+  zisc::pmr::vector<uint8> shadow_ray_is_queued_list_;
+  // Ray sorting
+  zisc::pmr::vector<RaySorter> thread_ray_sorter_list_;
+  zisc::UniqueMemoryPointer<LightSourceSampler> eye_path_light_sampler_;
+  uint32 wave_begin_; //!< The image index of the first path of the wave
+  uint8 ray_sorting_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "wavefront_path_tracing-inl.hpp"
+
+#endif // NANAIRO_WAVEFRONT_PATH_TRACING_HPP
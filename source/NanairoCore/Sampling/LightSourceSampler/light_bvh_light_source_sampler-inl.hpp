@@ -0,0 +1,31 @@
+/*!
+  \file light_bvh_light_source_sampler-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_BVH_LIGHT_SOURCE_SAMPLER_INL_HPP
+#define NANAIRO_LIGHT_BVH_LIGHT_SOURCE_SAMPLER_INL_HPP
+
+#include "light_bvh_light_source_sampler.hpp"
+// Standard C++ library
+#include <cstddef>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+std::size_t LightBvhLightSourceSampler::numOfNodes() const noexcept
+{
+  return node_list_.size();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_LIGHT_BVH_LIGHT_SOURCE_SAMPLER_INL_HPP
@@ -0,0 +1,460 @@
+/*!
+  \file light_bvh_light_source_sampler.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "light_bvh_light_source_sampler.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/compensated_summation.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "light_source_sampler.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/world.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Shape/shape.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  No detailed.
+  */
+LightBvhLightSourceSampler::LightBvhLightSourceSampler(
+    System& system,
+    const World& world,
+    zisc::pmr::memory_resource* work_resource) noexcept :
+        node_list_{&system.trackedMemoryResource(MemoryCategory::kSampler)},
+        info_list_{&system.trackedMemoryResource(MemoryCategory::kSampler)},
+        leaf_index_list_{&system.trackedMemoryResource(MemoryCategory::kSampler)}
+{
+  initialize(system, world, work_resource);
+}
+
+/*!
+  \details
+  The pdf is evaluated by walking from the leaf of the light to the root
+  with the same child probabilities as the sampling uses.
+  */
+LightSourceInfo LightBvhLightSourceSampler::getInfo(
+    const IntersectionInfo* info,
+    const Object* light_source) const noexcept
+{
+  const uint32 light_index = findLight(light_source);
+  const Float pdf = calcPdf(info, light_index);
+  return LightSourceInfo{light_source, pdf};
+}
+
+/*!
+  \details
+  No detailed.
+  */
+LightSourceInfo LightBvhLightSourceSampler::sample(
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  return sampleInfo(nullptr, sampler, path_state);
+}
+
+/*!
+  \details
+  No detailed.
+  */
+LightSourceInfo LightBvhLightSourceSampler::sample(
+    const IntersectionInfo& info,
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  return sampleInfo(&info, sampler, path_state);
+}
+
+/*!
+  \details
+  The lights are split at the median of the centroids along the longest axis
+  of the centroid bounds. The nodes are stored in the depth-first order
+  so that the left child of a node is the next one.
+  */
+uint32 LightBvhLightSourceSampler::buildSubtree(
+    const zisc::pmr::vector<Node>& leaf_list,
+    zisc::pmr::vector<uint32>::iterator begin,
+    zisc::pmr::vector<uint32>::iterator end,
+    const uint32 parent) noexcept
+{
+  const uint32 index = zisc::cast<uint32>(node_list_.size());
+  node_list_.emplace_back();
+  if (std::distance(begin, end) == 1) {
+    const uint32 light_index = *begin;
+    node_list_[index] = leaf_list[light_index];
+    node_list_[index].parent_ = parent;
+    leaf_index_list_[light_index] = index;
+    return index;
+  }
+
+  // Find the longest axis of the centroid bounds
+  uint axis = 0;
+  {
+    auto min_point = leaf_list[*begin].bounds_.centroid().data();
+    auto max_point = min_point;
+    for (auto i = begin + 1; i != end; ++i) {
+      const auto centroid = leaf_list[*i].bounds_.centroid().data();
+      min_point = zisc::minElements(min_point, centroid);
+      max_point = zisc::maxElements(max_point, centroid);
+    }
+    axis = Aabb{Point3{min_point}, Point3{max_point}}.longestAxis();
+  }
+
+  // Split the lights at the median
+  const auto middle = begin + std::distance(begin, end) / 2;
+  {
+    const auto has_less_centroid = [&leaf_list, axis](const uint32 lhs,
+                                                      const uint32 rhs) noexcept
+    {
+      return leaf_list[lhs].bounds_.centroid()[axis] <
+             leaf_list[rhs].bounds_.centroid()[axis];
+    };
+    std::nth_element(begin, middle, end, has_less_centroid);
+  }
+
+  const uint32 left = buildSubtree(leaf_list, begin, middle, index);
+  const uint32 right = buildSubtree(leaf_list, middle, end, index);
+  ZISC_ASSERT(left == (index + 1), "The left child isn't the next node.");
+
+  // The node list was reserved for all nodes, so the references are valid
+  auto& node = node_list_[index];
+  makeInternalNode(node_list_[left], node_list_[right], &node);
+  node.parent_ = parent;
+  node.child_or_light_ = right;
+  return index;
+}
+
+/*!
+  */
+inline
+Float LightBvhLightSourceSampler::calcAngle(const Float cos_theta) noexcept
+{
+  const Float c = zisc::clamp(cos_theta, -1.0, 1.0);
+  return 0.5 * zisc::kPi<Float> - zisc::asin(c);
+}
+
+/*!
+  \details
+  The importance is the power divided by the squared distance,
+  which is weighted by the conservative bounds of the emission cosine and
+  the cosine at the shading point.
+  The bounds of the node are bounded by a sphere,
+  and the angles are reduced by the half angle that the sphere subtends.
+  */
+inline
+Float LightBvhLightSourceSampler::calcImportance(
+    const Node& node,
+    const IntersectionInfo& info) const noexcept
+{
+  const auto& bounds = node.bounds_;
+  const auto to_center = bounds.centroid() - info.point();
+  const Float radius2 = 0.25 * (bounds.maxPoint() - bounds.minPoint()).squareNorm();
+  const Float distance2 = to_center.squareNorm();
+  // The shading point is in the bounding sphere
+  if (distance2 <= radius2) {
+    const Float r2 = zisc::max(radius2, std::numeric_limits<Float>::min());
+    return node.power_ / r2;
+  }
+
+  const Float distance = zisc::sqrt(distance2);
+  const auto direction = to_center * zisc::invert(distance);
+  const Float sin_u = zisc::sqrt(radius2 / distance2);
+  const Float cos_u = zisc::sqrt(zisc::max(1.0 - radius2 / distance2, 0.0));
+
+  // The emission angle is bounded by the normal cone
+  Float cos_emission = 0.0;
+  {
+    const Float cos_theta = -zisc::dot(node.axis_, direction);
+    const Float sin_theta = zisc::sqrt(zisc::max(1.0 - zisc::power<2>(cos_theta), 0.0));
+    const auto theta1 = subtractAngle(cos_theta, sin_theta,
+                                      node.cos_theta_o_, node.sin_theta_o_);
+    const auto theta2 = subtractAngle(std::get<0>(theta1), std::get<1>(theta1),
+                                      cos_u, sin_u);
+    cos_emission = std::get<0>(theta2);
+  }
+  // Non directional emitters don't emit light to the back side
+  if (cos_emission <= 0.0)
+    return 0.0;
+
+  // The incident angle at the shading point
+  Float cos_incident = 0.0;
+  {
+    const Float cos_theta = zisc::abs(zisc::dot(info.normal(), direction));
+    const Float sin_theta = zisc::sqrt(zisc::max(1.0 - zisc::power<2>(cos_theta), 0.0));
+    const auto theta = subtractAngle(cos_theta, sin_theta, cos_u, sin_u);
+    cos_incident = std::get<0>(theta);
+  }
+
+  return node.power_ * cos_emission * cos_incident / distance2;
+}
+
+/*!
+  \details
+  The power of the children is used if the both importances are zero
+  so that every light can be selected.
+  */
+inline
+Float LightBvhLightSourceSampler::calcLeftProbability(
+    const uint32 index,
+    const IntersectionInfo* info) const noexcept
+{
+  const auto& node = node_list_[index];
+  ZISC_ASSERT(node.is_leaf_ == kFalse, "The node is a leaf.");
+  const auto& left = node_list_[index + 1];
+  const auto& right = node_list_[node.child_or_light_];
+  Float left_importance = 0.0,
+        right_importance = 0.0;
+  if (info != nullptr) {
+    left_importance = calcImportance(left, *info);
+    right_importance = calcImportance(right, *info);
+  }
+  if ((left_importance + right_importance) <= 0.0) {
+    left_importance = left.power_;
+    right_importance = right.power_;
+  }
+  const Float total = left_importance + right_importance;
+  return (0.0 < total) ? left_importance / total : 0.5;
+}
+
+/*!
+  */
+inline
+Float LightBvhLightSourceSampler::calcPdf(
+    const IntersectionInfo* info,
+    const uint32 light_index) const noexcept
+{
+  Float pdf = 1.0;
+  for (uint32 child = leaf_index_list_[light_index]; child != 0;) {
+    const uint32 parent = node_list_[child].parent_;
+    const Float p = calcLeftProbability(parent, info);
+    pdf *= (child == (parent + 1)) ? p : 1.0 - p;
+    child = parent;
+  }
+  return pdf;
+}
+
+/*!
+  */
+inline
+uint32 LightBvhLightSourceSampler::findLight(const Object* light_source)
+    const noexcept
+{
+  ZISC_ASSERT(light_source != nullptr, "The light source is null.");
+  ZISC_ASSERT(light_source->material().isLightSource(),
+              "The object isn't light source.");
+  const auto comp = [](const LightSourceInfo& lhs, const Object* rhs)
+  {
+    return lhs.object() < rhs;
+  };
+  auto info = std::lower_bound(info_list_.begin(),
+                               info_list_.end(),
+                               light_source,
+                               comp);
+  ZISC_ASSERT((info != info_list_.end()) && (info->object() == light_source),
+              "The light source isn't in the light source list.");
+  return zisc::cast<uint32>(std::distance(info_list_.begin(), info));
+}
+
+/*!
+  \details
+  No detailed.
+  */
+void LightBvhLightSourceSampler::initialize(
+    System& /* system */,
+    const World& world,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  const auto& light_source_list = world.lightSourceList();
+  const std::size_t n = light_source_list.size();
+  // The scene can be lit only by the environment
+  if (n == 0)
+    return;
+
+  // Initialize info list
+  {
+    zisc::CompensatedSummation<Float> total_flux{0.0};
+    for (const auto light_source : light_source_list) {
+      const auto flux = light_source->lightPower();
+      total_flux.add(flux);
+    }
+    info_list_.reserve(n);
+    for (const auto light_source : light_source_list) {
+      const auto flux = light_source->lightPower();
+      info_list_.emplace_back(light_source, flux / total_flux.get());
+    }
+    const auto comp = [](const LightSourceInfo& lhs, const LightSourceInfo& rhs)
+    {
+      return lhs.object() < rhs.object();
+    };
+    std::sort(info_list_.begin(), info_list_.end(), comp);
+  }
+
+  // Make the leaf nodes
+  zisc::pmr::vector<Node> leaf_list{work_resource};
+  leaf_list.resize(n);
+  for (uint32 i = 0; i < n; ++i) {
+    const auto light_source = info_list_[i].object();
+    const auto& shape = light_source->shape();
+    auto& leaf = leaf_list[i];
+    leaf.bounds_ = shape.boundingBox();
+    leaf.power_ = shape.surfaceArea() *
+                  light_source->material().emitter().radiantExitance();
+    leaf.child_or_light_ = i;
+    leaf.is_leaf_ = kTrue;
+    // Bound the normals at the corners and the center of the shape
+    const std::array<Point2, 4> st_list{{Point2{0.0, 0.0},
+                                             Point2{1.0, 0.0},
+                                             Point2{0.0, 1.0},
+                                             Point2{1.0 / 3.0, 1.0 / 3.0}}};
+    std::array<Vector3, 4> normal_list;
+    Vector3 axis{0.0, 0.0, 0.0};
+    for (std::size_t j = 0; j < st_list.size(); ++j) {
+      normal_list[j] = shape.getPoint(st_list[j]).normal();
+      axis = axis + normal_list[j];
+    }
+    leaf.theta_o_ = zisc::kPi<Float>;
+    leaf.axis_ = normal_list[0];
+    if (0.0 < axis.squareNorm()) {
+      leaf.axis_ = axis.normalized();
+      Float cos_theta_o = 1.0;
+      for (const auto& normal : normal_list)
+        cos_theta_o = zisc::min(cos_theta_o, zisc::dot(leaf.axis_, normal));
+      leaf.theta_o_ = calcAngle(cos_theta_o);
+    }
+    leaf.cos_theta_o_ = zisc::cos(leaf.theta_o_);
+    leaf.sin_theta_o_ = zisc::sin(leaf.theta_o_);
+  }
+
+  // Build the tree
+  {
+    zisc::pmr::vector<uint32> light_index_list{work_resource};
+    light_index_list.resize(n);
+    std::iota(light_index_list.begin(), light_index_list.end(), 0u);
+    node_list_.reserve(2 * n - 1);
+    leaf_index_list_.resize(n);
+    buildSubtree(leaf_list, light_index_list.begin(), light_index_list.end(), 0);
+    ZISC_ASSERT(node_list_.size() == (2 * n - 1),
+                "The number of the nodes is wrong.");
+  }
+}
+
+/*!
+  \details
+  Please see "Importance Sampling of Many Lights with Adaptive Tree Splitting"
+  for the details of the normal cone union.
+  */
+void LightBvhLightSourceSampler::makeInternalNode(const Node& left,
+                                                  const Node& right,
+                                                  Node* node) noexcept
+{
+  node->bounds_ = combine(left.bounds_, right.bounds_);
+  node->power_ = left.power_ + right.power_;
+  node->is_leaf_ = kFalse;
+
+  // Make the normal cone which bounds the two cones
+  const bool left_is_wider = right.theta_o_ <= left.theta_o_;
+  const Node& a = left_is_wider ? left : right;
+  const Node& b = left_is_wider ? right : left;
+  const Float cos_theta_d = zisc::clamp(zisc::dot(a.axis_, b.axis_), -1.0, 1.0);
+  const Float theta_d = calcAngle(cos_theta_d);
+  node->axis_ = a.axis_;
+  node->theta_o_ = a.theta_o_;
+  if (a.theta_o_ < zisc::min(theta_d + b.theta_o_, zisc::kPi<Float>)) {
+    const Float theta_o = 0.5 * (a.theta_o_ + theta_d + b.theta_o_);
+    const auto ortho = b.axis_ - cos_theta_d * a.axis_;
+    if ((theta_o < zisc::kPi<Float>) && (0.0 < ortho.squareNorm())) {
+      // Rotate the axis of the wider cone toward the other
+      const Float theta_r = theta_o - a.theta_o_;
+      const auto axis = zisc::cos(theta_r) * a.axis_ +
+                        zisc::sin(theta_r) * ortho.normalized();
+      node->axis_ = axis.normalized();
+      node->theta_o_ = theta_o;
+    }
+    else {
+      node->theta_o_ = zisc::kPi<Float>;
+    }
+  }
+  node->cos_theta_o_ = zisc::cos(node->theta_o_);
+  node->sin_theta_o_ = zisc::sin(node->theta_o_);
+}
+
+/*!
+  \details
+  The random number is rescaled at each node so that
+  a single number selects the path from the root to a leaf.
+  */
+inline
+LightSourceInfo LightBvhLightSourceSampler::sampleInfo(
+    const IntersectionInfo* info,
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  constexpr Float max_u = 1.0 - std::numeric_limits<Float>::epsilon();
+  Float u = sampler.draw1D(path_state);
+  Float pdf = 1.0;
+  uint32 index = 0;
+  while (node_list_[index].is_leaf_ == kFalse) {
+    const Float p = calcLeftProbability(index, info);
+    if (u < p) {
+      u = u / p;
+      pdf *= p;
+      ++index;
+    }
+    else {
+      u = (u - p) / (1.0 - p);
+      pdf *= 1.0 - p;
+      index = node_list_[index].child_or_light_;
+    }
+    u = zisc::min(u, max_u);
+  }
+  const uint32 light_index = node_list_[index].child_or_light_;
+  return LightSourceInfo{info_list_[light_index].object(), pdf};
+}
+
+/*!
+  */
+inline
+std::tuple<Float, Float> LightBvhLightSourceSampler::subtractAngle(
+    const Float cos_a,
+    const Float sin_a,
+    const Float cos_b,
+    const Float sin_b) noexcept
+{
+  // The angles are in [0, pi]
+  Float cos_theta = 1.0,
+        sin_theta = 0.0;
+  if (cos_a < cos_b) {
+    cos_theta = cos_a * cos_b + sin_a * sin_b;
+    sin_theta = sin_a * cos_b - cos_a * sin_b;
+  }
+  return std::make_tuple(cos_theta, sin_theta);
+}
+
+} // namespace nanairo
@@ -0,0 +1,154 @@
+/*!
+  \file light_bvh_light_source_sampler.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LIGHT_BVH_LIGHT_SOURCE_SAMPLER_HPP
+#define NANAIRO_LIGHT_BVH_LIGHT_SOURCE_SAMPLER_HPP
+
+// Standard C++ library
+#include <tuple>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "light_source_sampler.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class IntersectionInfo;
+class Object;
+class PathState;
+class Sampler;
+class System;
+class World;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Light source sampler which selects a light by a light BVH
+  \details
+  Each node of the BVH has the bounds, the total power and
+  the normal cone of the lights in the subtree.
+  A light is selected by descending the tree from the root and
+  choosing a child by the importance of the child seen from the shading point,
+  which is estimated from the power, the distance to the bounds and
+  the orientations of the lights and the shading point.
+  The light path sampler selects a light by the power only.
+  */
+class LightBvhLightSourceSampler : public LightSourceSampler
+{
+ public:
+  //! Create a light source sampler
+  LightBvhLightSourceSampler(
+      System& system,
+      const World& world,
+      zisc::pmr::memory_resource* work_resource) noexcept;
+
+
+  //! Return the light source info by the light source
+  LightSourceInfo getInfo(const IntersectionInfo* info,
+                          const Object* light_source) const noexcept override;
+
+  //! Return the number of nodes of the light BVH
+  std::size_t numOfNodes() const noexcept;
+
+  //! Sample a light source for a light path tracer
+  LightSourceInfo sample(Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+  //! Sample a light source for a eye path tracer
+  LightSourceInfo sample(const IntersectionInfo& info,
+                         Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+ private:
+  /*!
+    \details
+    The left child of a internal node is the next node and
+    the index of the right child is stored in the node.
+    A leaf node stores the index of the light instead of the right child
+    */
+  struct Node
+  {
+    Aabb bounds_;
+    Vector3 axis_; //!< The axis of the normal cone
+    Float theta_o_; //!< The spread angle of the normal cone
+    Float cos_theta_o_;
+    Float sin_theta_o_;
+    Float power_;
+    uint32 parent_;
+    uint32 child_or_light_;
+    uint8 is_leaf_;
+  };
+
+
+  //! Build the subtree of the lights in the range
+  uint32 buildSubtree(const zisc::pmr::vector<Node>& leaf_list,
+                      zisc::pmr::vector<uint32>::iterator begin,
+                      zisc::pmr::vector<uint32>::iterator end,
+                      const uint32 parent) noexcept;
+
+  //! Calculate the angle by the cosine
+  static Float calcAngle(const Float cos_theta) noexcept;
+
+  //! Calculate the probability of selecting the left child of the node
+  Float calcLeftProbability(const uint32 index,
+                            const IntersectionInfo* info) const noexcept;
+
+  //! Calculate the importance of the node seen from the shading point
+  Float calcImportance(const Node& node,
+                       const IntersectionInfo& info) const noexcept;
+
+  //! Calculate the pdf of selecting the light source at the shading point
+  Float calcPdf(const IntersectionInfo* info,
+                const uint32 light_index) const noexcept;
+
+  //! Return cos and sin of max(0, a - b)
+  static std::tuple<Float, Float> subtractAngle(const Float cos_a,
+                                                const Float sin_a,
+                                                const Float cos_b,
+                                                const Float sin_b) noexcept;
+
+  //! Find the index of the light source
+  uint32 findLight(const Object* light_source) const noexcept;
+
+  //! Initialize
+  void initialize(System& system,
+                  const World& world,
+                  zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Make a internal node which bounds the two children
+  static void makeInternalNode(const Node& left,
+                               const Node& right,
+                               Node* node) noexcept;
+
+  //! Sample a light source by descending the tree
+  LightSourceInfo sampleInfo(const IntersectionInfo* info,
+                             Sampler& sampler,
+                             const PathState& path_state) const noexcept;
+
+
+  zisc::pmr::vector<Node> node_list_;
+  zisc::pmr::vector<LightSourceInfo> info_list_; //!< Sorted by the object address
+  zisc::pmr::vector<uint32> leaf_index_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "light_bvh_light_source_sampler-inl.hpp"
+
+#endif // NANAIRO_LIGHT_BVH_LIGHT_SOURCE_SAMPLER_HPP
@@ -16,10 +16,12 @@
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "light_bvh_light_source_sampler.hpp"
 #include "power_weighted_light_source_sampler.hpp"
 #include "uniform_light_source_sampler.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
+#include "NanairoCore/world.hpp"
 #include "NanairoCore/Data/object.hpp"
 #include "NanairoCore/Setting/rendering_method_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
@@ -30,7 +32,9 @@ namespace nanairo {
   \details
   No detailed.
   */
-LightSourceSampler::LightSourceSampler() noexcept
+LightSourceSampler::LightSourceSampler() noexcept :
+    environment_light_{nullptr},
+    environment_probability_{0.0}
 {
   initialize();
 }
@@ -43,6 +47,20 @@ LightSourceSampler::~LightSourceSampler() noexcept
 {
 }
 
+/*!
+  */
+const EnvironmentEmitter* LightSourceSampler::environmentLight() const noexcept
+{
+  return environment_light_;
+}
+
+/*!
+  */
+Float LightSourceSampler::environmentProbability() const noexcept
+{
+  return environment_probability_;
+}
+
 /*!
   */
 zisc::UniqueMemoryPointer<LightSourceSampler> LightSourceSampler::makeSampler(
@@ -52,7 +70,7 @@ zisc::UniqueMemoryPointer<LightSourceSampler> LightSourceSampler::makeSampler(
     zisc::pmr::memory_resource* work_resource) noexcept
 {
   zisc::UniqueMemoryPointer<LightSourceSampler> sampler;
-  auto data_resource = &system.dataMemoryManager();
+  auto data_resource = &system.trackedMemoryResource(MemoryCategory::kSampler);
   switch (sampler_type) {
    case LightSourceSamplerType::kUniform: {
     sampler = zisc::UniqueMemoryPointer<UniformLightSourceSampler>::make(
@@ -68,9 +86,19 @@ zisc::UniqueMemoryPointer<LightSourceSampler> LightSourceSampler::makeSampler(
         work_resource);
     break;
    }
+   case LightSourceSamplerType::kLightBvh: {
+    sampler = zisc::UniqueMemoryPointer<LightBvhLightSourceSampler>::make(
+        data_resource,
+        system,
+        world,
+        work_resource);
+    break;
+   }
    default:
     break;
   }
+  if (sampler)
+    sampler->setEnvironmentLight(world);
   return sampler;
 }
 
@@ -82,4 +110,18 @@ void LightSourceSampler::initialize() noexcept
 {
 }
 
+/*!
+  \details
+  The environment and the objects are selected equally,
+  since the power of the environment depends on the size of the scene.
+  */
+void LightSourceSampler::setEnvironmentLight(const World& world) noexcept
+{
+  environment_light_ = world.environmentLight();
+  environment_probability_ =
+      (environment_light_ == nullptr)     ? 0.0 :
+      world.lightSourceList().empty()     ? 1.0
+                                          : 0.5;
+}
+
 } // namespace nanairo
@@ -18,12 +18,14 @@
 #include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/light_source_info.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
 namespace nanairo {
 
 // Forward declaration
+class EnvironmentEmitter;
 class IntersectionInfo;
 class PathState;
 class Sampler;
@@ -37,11 +39,14 @@ enum class LightSourceSamplerType : uint32
 {
   kUniform                    = zisc::Fnv1aHash32::hash("UniformLightSampler"),
   kPowerWeighted              = zisc::Fnv1aHash32::hash("PowerWeightedLightSampler"),
+  kLightBvh                   = zisc::Fnv1aHash32::hash("LightBvhLightSampler"),
 };
 
 /*!
   \details
-  No detailed.
+  The environment light of the world is selected with the environment
+  probability before a light source object is sampled,
+  so the weights of the objects are conditional on the objects.
   */
 class LightSourceSampler
 {
@@ -53,8 +58,14 @@ class LightSourceSampler
   virtual ~LightSourceSampler() noexcept;
 
 
-  //! Return the light source info by the light source
-  virtual LightSourceInfo getInfo(const IntersectionInfo& info,
+  //! Return the environment light, null if the world has no environment
+  const EnvironmentEmitter* environmentLight() const noexcept;
+
+  //! Return the probability of selecting the environment light
+  Float environmentProbability() const noexcept;
+
+  //! Return the light source info of the light sampled at the info (null info means a light path)
+  virtual LightSourceInfo getInfo(const IntersectionInfo* info,
                                   const Object* light_source) const noexcept = 0;
 
   //! Make a light source sampler
@@ -76,6 +87,13 @@ class LightSourceSampler
  private:
   //! Initialize
   void initialize() noexcept;
+
+  //! Set the environment light of the world
+  void setEnvironmentLight(const World& world) noexcept;
+
+
+  const EnvironmentEmitter* environment_light_;
+  Float environment_probability_;
 };
 
 //! \} Core
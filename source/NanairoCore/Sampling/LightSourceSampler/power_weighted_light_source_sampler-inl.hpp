@@ -11,11 +11,11 @@
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
-#include "zisc/cumulative_distribution_function.hpp"
 // Nanairo
 #include "light_source_sampler.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
 
 namespace nanairo {
 
@@ -40,19 +40,9 @@ PowerWeightedLightSourceSampler::infoList() const noexcept
 /*!
   */
 inline
-auto PowerWeightedLightSourceSampler::lightSourceCdf() noexcept ->
-    LightSourceCdf&
+const AliasTable& PowerWeightedLightSourceSampler::lightSourceTable() const noexcept
 {
-  return *light_source_cdf_;
-}
-
-/*!
-  */
-inline
-auto PowerWeightedLightSourceSampler::lightSourceCdf() const noexcept
-    -> const LightSourceCdf&
-{
-  return *light_source_cdf_;
+  return light_source_table_;
 }
 
 } // namespace nanairo
@@ -15,7 +15,6 @@
 // Zisc
 #include "zisc/error.hpp"
 #include "zisc/compensated_summation.hpp"
-#include "zisc/cumulative_distribution_function.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
@@ -28,6 +27,7 @@
 #include "NanairoCore/Data/object.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
 #include "NanairoCore/Sampling/Sampler/sampler.hpp"
 #include "NanairoCore/Shape/shape.hpp"
 
@@ -41,7 +41,8 @@ PowerWeightedLightSourceSampler::PowerWeightedLightSourceSampler(
     System& system,
     const World& world,
     zisc::pmr::memory_resource* work_resource) noexcept :
-        info_list_{&system.dataMemoryManager()}
+        info_list_{&system.trackedMemoryResource(MemoryCategory::kSampler)},
+        light_source_table_{&system.trackedMemoryResource(MemoryCategory::kSampler)}
 {
   initialize(system, world, work_resource);
 }
@@ -49,7 +50,7 @@ PowerWeightedLightSourceSampler::PowerWeightedLightSourceSampler(
 /*!
   */
 LightSourceInfo PowerWeightedLightSourceSampler::getInfo(
-    const IntersectionInfo& /* info */,
+    const IntersectionInfo* /* info */,
     const Object* light_source) const noexcept
 {
   return getInfo(light_source);
@@ -106,7 +107,7 @@ LightSourceInfo PowerWeightedLightSourceSampler::getInfo(
   No detailed.
   */
 void PowerWeightedLightSourceSampler::initialize(
-    System& system,
+    System& /* system */,
     const World& world,
     zisc::pmr::memory_resource* work_resource) noexcept
 {
@@ -115,15 +116,13 @@ void PowerWeightedLightSourceSampler::initialize(
     // Calculate the total flux of the light sources
     zisc::CompensatedSummation<Float> total_flux{0.0};
     for (const auto light_source : light_source_list) {
-      const auto flux = light_source->shape().surfaceArea() *
-                        light_source->material().emitter().radiantExitance();
+      const auto flux = light_source->lightPower();
       total_flux.add(flux);
     }
     // Initialize info list
     info_list_.reserve(light_source_list.size());
     for (const auto light_source : light_source_list) {
-      const auto flux = light_source->shape().surfaceArea() *
-                        light_source->material().emitter().radiantExitance();
+      const auto flux = light_source->lightPower();
       info_list_.emplace_back(light_source, flux / total_flux.get());
     }
     // Sort the info list
@@ -133,22 +132,15 @@ void PowerWeightedLightSourceSampler::initialize(
     };
     std::sort(info_list_.begin(), info_list_.end(), comp);
   }
+  // Make the alias table of the weights
   {
-    auto data_resource = &system.dataMemoryManager();
-    zisc::pmr::vector<const LightSourceInfo*> info_list{data_resource};
-    zisc::pmr::vector<Float> pdf_list{data_resource};
-    info_list.reserve(info_list_.size());
-    pdf_list.reserve(info_list_.size());
-    for (const auto& info : info_list_) {
-      info_list.emplace_back(&info);
-      pdf_list.emplace_back(info.weight());
-    }
-
-    light_source_cdf_ = zisc::UniqueMemoryPointer<LightSourceCdf>::make(
-        data_resource,
-        std::move(info_list),
-        std::move(pdf_list),
-        work_resource);
+    zisc::pmr::vector<Float> weight_list{work_resource};
+    weight_list.reserve(info_list_.size());
+    for (const auto& info : info_list_)
+      weight_list.emplace_back(info.weight());
+    light_source_table_.setWeights(weight_list.data(),
+                                   zisc::cast<uint>(weight_list.size()),
+                                   work_resource);
   }
 }
 
@@ -159,10 +151,9 @@ const LightSourceInfo& PowerWeightedLightSourceSampler::sampleInfo(
     Sampler& sampler,
     const PathState& path_state) const noexcept
 {
-  const auto& light_source_cdf = lightSourceCdf();
-  const Float y = sampler.draw1D(path_state);
-  const auto sampled_lihgt_source = light_source_cdf.invert(y);
-  return *sampled_lihgt_source;
+  Float y = sampler.draw1D(path_state);
+  const uint index = lightSourceTable().sample(&y);
+  return info_list_[index];
 }
 
 
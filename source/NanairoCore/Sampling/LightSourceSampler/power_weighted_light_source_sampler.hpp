@@ -14,11 +14,11 @@
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
-#include "zisc/cumulative_distribution_function.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "light_source_sampler.hpp"
 #include "NanairoCore/Data/light_source_info.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
 #include "NanairoCore/Sampling/Sampler/sampler.hpp"
 
 namespace nanairo {
@@ -35,15 +35,13 @@ class World;
 
 /*!
   \details
-  No detailed.
+  A light source is selected in proportion to its power by an alias table,
+  so the selection costs O(1) regardless of the number of the light sources.
+  The inverse weight of a light source is stored in its info.
   */
 class PowerWeightedLightSourceSampler : public LightSourceSampler
 {
  public:
-  using LightSourceCdf = zisc::CumulativeDistributionFunction<const LightSourceInfo*,
-                                                              Float>;
-
-
   //! Create a light source sampler
   PowerWeightedLightSourceSampler(
       System& system,
@@ -52,7 +50,7 @@ class PowerWeightedLightSourceSampler : public LightSourceSampler
 
 
   //! Return the light source info by the light source
-  LightSourceInfo getInfo(const IntersectionInfo& info,
+  LightSourceInfo getInfo(const IntersectionInfo* info,
                           const Object* light_source) const noexcept override;
 
   //! Return the info list of light source
@@ -61,11 +59,8 @@ class PowerWeightedLightSourceSampler : public LightSourceSampler
   //! Return the info list of light source
   const zisc::pmr::vector<LightSourceInfo>& infoList() const noexcept;
 
-  //! Return the light source CDF
-  LightSourceCdf& lightSourceCdf() noexcept;
-
-  //! Return the light source CDF
-  const LightSourceCdf& lightSourceCdf() const noexcept;
+  //! Return the alias table of the light sources
+  const AliasTable& lightSourceTable() const noexcept;
 
   //! Sample a light source for a light path tracer
   LightSourceInfo sample(Sampler& sampler,
@@ -91,7 +86,7 @@ class PowerWeightedLightSourceSampler : public LightSourceSampler
 
 
   zisc::pmr::vector<LightSourceInfo> info_list_;
-  zisc::UniqueMemoryPointer<LightSourceCdf> light_source_cdf_;
+  AliasTable light_source_table_; //!< The indices of the info list
 };
 
 //! \} Core
@@ -38,7 +38,7 @@ UniformLightSourceSampler::UniformLightSourceSampler(const World& world) noexcep
 /*!
   */
 LightSourceInfo UniformLightSourceSampler::getInfo(
-    const IntersectionInfo& /* info */,
+    const IntersectionInfo* /* info */,
     const Object* light_source) const noexcept
 {
   return getInfo(light_source);
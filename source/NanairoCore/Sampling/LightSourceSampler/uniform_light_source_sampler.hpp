@@ -44,7 +44,7 @@ class UniformLightSourceSampler : public LightSourceSampler
 
   //! Return the light source info by the light source
   LightSourceInfo getInfo(
-      const IntersectionInfo& info,
+      const IntersectionInfo* info,
       const Object* light_source) const noexcept override;
 
   //! Sample a light source
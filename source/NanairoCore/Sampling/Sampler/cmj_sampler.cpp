@@ -24,8 +24,7 @@ namespace nanairo {
 
 /*!
   */
-CmjSampler::CmjSampler(const uint32 seed) noexcept :
-    seed_{seed}
+CmjSampler::CmjSampler(const uint32 seed) noexcept : SamplerBatch(seed)
 {
 }
 
@@ -46,18 +45,21 @@ std::array<Float, 2> CmjSampler::draw2D(const PathState& state) noexcept
 }
 
 /*!
+  \details
+  The pattern of a stream is the same as
+  the one of the sampler whose seed is 'seed + hash(stream)'.
   */
 std::tuple<uint32, uint32> CmjSampler::calcParameters(const PathState& state)
     const noexcept
 {
   constexpr uint32 n = Engine::getPeriod();
-  constexpr uint32 bounce = zisc::cast<uint32>(SampleDimension::kBounce);
 
   const uint32 offset = state.sample() / n;
-  const uint32 d = (state.length() * bounce) + state.dimension();
+  const uint32 d = calcTotalDimension(state);
   const uint32 s = state.sample() - (offset * n);
   ZISC_ASSERT(zisc::isInBounds(s, 0u, n), "The s is wrong: ", s);
-  const uint32 p = seed_ + offset + zisc::Fnv1aHash32::hash(d);
+  const uint32 stream_seed = seed() + zisc::Fnv1aHash32::hash(stream());
+  const uint32 p = stream_seed + offset + zisc::Fnv1aHash32::hash(d);
   return std::make_tuple(s, p);
 }
 
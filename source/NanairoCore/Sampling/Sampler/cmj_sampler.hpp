@@ -16,7 +16,7 @@
 // Zisc
 #include "zisc/correlated_multi_jittered_engine.hpp"
 // Nanairo
-#include "sampler.hpp"
+#include "sampler_batch.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 
 namespace nanairo {
@@ -27,7 +27,7 @@ class PathState;
 //! \addtogroup Core
 //! \{
 
-class CmjSampler : public Sampler
+class CmjSampler final : public SamplerBatch<CmjSampler>
 {
  public:
   //! Initialize a sampler
@@ -46,9 +46,6 @@ class CmjSampler : public Sampler
 
   //! Calculate CMJ parameters
   std::tuple<uint32, uint32> calcParameters(const PathState& state) const noexcept;
-
-
-  uint32 seed_;
 };
 
 //! \}
@@ -0,0 +1,73 @@
+/*!
+  \file cmj_table-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_CMJ_TABLE_INL_HPP
+#define NANAIRO_CMJ_TABLE_INL_HPP
+
+#include "cmj_table.hpp"
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "sampler.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The dimensions of the first 8 vertices of a path are tabled.
+  */
+inline
+constexpr uint32 CmjTable::numOfDimensions() noexcept
+{
+  constexpr uint32 bounce = zisc::cast<uint32>(SampleDimension::kBounce);
+  return 8 * bounce;
+}
+
+/*!
+  */
+inline
+constexpr uint32 CmjTable::numOfSamples() noexcept
+{
+  return Engine::getPeriod();
+}
+
+/*!
+  */
+inline
+Float CmjTable::sample1D(const uint32 dimension, const uint32 s) const noexcept
+{
+  return sample_1d_list_[getIndex(dimension, s)];
+}
+
+/*!
+  */
+inline
+const std::array<Float, 2>& CmjTable::sample2D(const uint32 dimension,
+                                               const uint32 s) const noexcept
+{
+  return sample_2d_list_[getIndex(dimension, s)];
+}
+
+/*!
+  */
+inline
+uint32 CmjTable::getIndex(const uint32 dimension, const uint32 s) noexcept
+{
+  ZISC_ASSERT(dimension < numOfDimensions(), "The dimension is out of range.");
+  ZISC_ASSERT(s < numOfSamples(), "The sample is out of range.");
+  return dimension * numOfSamples() + s;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_CMJ_TABLE_INL_HPP
@@ -0,0 +1,53 @@
+/*!
+  \file cmj_table.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "cmj_table.hpp"
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/correlated_multi_jittered_engine.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+CmjTable::CmjTable(const uint32 seed,
+                   zisc::pmr::memory_resource* mem_resource) noexcept :
+    sample_1d_list_{mem_resource},
+    sample_2d_list_{mem_resource}
+{
+  initialize(seed);
+}
+
+/*!
+  \details
+  The pattern of a dimension is the same as
+  the one of CmjSampler for the seed.
+  */
+void CmjTable::initialize(const uint32 seed) noexcept
+{
+  constexpr uint32 size = numOfDimensions() * numOfSamples();
+  sample_1d_list_.resize(size);
+  sample_2d_list_.resize(size);
+  for (uint32 d = 0; d < numOfDimensions(); ++d) {
+    const uint32 p = seed + zisc::Fnv1aHash32::hash(d);
+    for (uint32 s = 0; s < numOfSamples(); ++s) {
+      const uint32 index = getIndex(d, s);
+      sample_1d_list_[index] = Engine::generate1D<Float>(s, p);
+      sample_2d_list_[index] = Engine::generate2D<Float>(s, p);
+    }
+  }
+}
+
+} // namespace nanairo
@@ -0,0 +1,75 @@
+/*!
+  \file cmj_table.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_CMJ_TABLE_HPP
+#define NANAIRO_CMJ_TABLE_HPP
+
+// Standard C++ library
+#include <array>
+#include <vector>
+// Zisc
+#include "zisc/correlated_multi_jittered_engine.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The CMJ samples of the first dimensions of paths for a seed.
+  The permutations and the jitters are evaluated once when the table is made,
+  so a draw is a lookup.
+  */
+class CmjTable : public zisc::NonCopyable<CmjTable>
+{
+ public:
+  using Engine = zisc::CmjN256;
+
+
+  //! Make the table of the seed
+  CmjTable(const uint32 seed, zisc::pmr::memory_resource* mem_resource) noexcept;
+
+
+  //! Return the number of dimensions in the table
+  static constexpr uint32 numOfDimensions() noexcept;
+
+  //! Return the number of samples of a dimension
+  static constexpr uint32 numOfSamples() noexcept;
+
+  //! Return the 1D sample
+  Float sample1D(const uint32 dimension, const uint32 s) const noexcept;
+
+  //! Return the 2D sample
+  const std::array<Float, 2>& sample2D(const uint32 dimension,
+                                       const uint32 s) const noexcept;
+
+ private:
+  //! Return the index of the sample
+  static uint32 getIndex(const uint32 dimension, const uint32 s) noexcept;
+
+  //! Initialize the table
+  void initialize(const uint32 seed) noexcept;
+
+
+  zisc::pmr::vector<Float> sample_1d_list_;
+  zisc::pmr::vector<std::array<Float, 2>> sample_2d_list_;
+};
+
+//! \}
+
+} // namespace nanairo
+
+#include "cmj_table-inl.hpp"
+
+#endif // NANAIRO_CMJ_TABLE_HPP
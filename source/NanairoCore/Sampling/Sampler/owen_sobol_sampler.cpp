@@ -0,0 +1,200 @@
+/*!
+  \file owen_sobol_sampler.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "owen_sobol_sampler.hpp"
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+
+namespace nanairo {
+
+namespace {
+
+//! Make the direction numbers of the second dimension of Sobol
+constexpr std::array<uint32, 32> makeSobol1Directions() noexcept
+{
+  std::array<uint32, 32> direction_list{};
+  uint32 v = 1u << 31;
+  for (uint bit = 0; bit < 32; ++bit) {
+    direction_list[bit] = v;
+    v ^= v >> 1;
+  }
+  return direction_list;
+}
+
+constexpr std::array<uint32, 32> kSobol1Directions = makeSobol1Directions();
+
+//! Mix the bits of the key
+constexpr uint32 mix(uint32 x) noexcept
+{
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+//! Reverse the bits
+constexpr uint32 reverseBits(uint32 x) noexcept
+{
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+  x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+/*!
+  \details
+  A bit of the product only depends on the lower bits,
+  so the hash of the reversed bits flips each bit of the value
+  by the bits above it, which is an Owen scrambling.
+  */
+constexpr uint32 scrambleReversed(uint32 x, const uint32 seed) noexcept
+{
+  x ^= x * 0x3d20adeau;
+  x += seed;
+  x *= (seed >> 16) | 1u;
+  x ^= x * 0x05526c56u;
+  x ^= x * 0x53a22864u;
+  return x;
+}
+
+//! Return the second dimension of Sobol
+constexpr uint32 sobol1(const uint32 index) noexcept
+{
+  uint32 y = 0;
+  for (uint bit = 0; bit < 32; ++bit)
+    y ^= (0u - ((index >> bit) & 1u)) & kSobol1Directions[bit];
+  return y;
+}
+
+//! Map the upper 24 bits to [0, 1), which are exact in single precision
+constexpr Float toFloat(const uint32 x) noexcept
+{
+  constexpr Float k = 1.0 / zisc::cast<Float>(1u << 24);
+  return zisc::cast<Float>(x >> 8) * k;
+}
+
+} // namespace
+
+/*!
+  */
+OwenSobolSampler::OwenSobolSampler(const uint32 seed) noexcept :
+    SamplerBatch(seed)
+{
+}
+
+/*!
+  */
+Float OwenSobolSampler::draw1D(const PathState& state) noexcept
+{
+  LaneArray<1> x_list;
+  drawLanes<1, false>(state, &x_list, nullptr);
+  return toFloat(x_list[0]);
+}
+
+/*!
+  */
+std::array<Float, 2> OwenSobolSampler::draw2D(const PathState& state) noexcept
+{
+  LaneArray<1> x_list,
+               y_list;
+  drawLanes<1, true>(state, &x_list, &y_list);
+  return std::array<Float, 2>{{toFloat(x_list[0]), toFloat(y_list[0])}};
+}
+
+/*!
+  \details
+  The batch is drawn by the lanes, the last lanes are discarded.
+  */
+void OwenSobolSampler::drawBatch1D(const PathState& state,
+                                   const uint n,
+                                   Float* samples) noexcept
+{
+  ZISC_ASSERT(n <= kBatchSize, "The batch is out of the lanes: ", n);
+  LaneArray<kBatchSize> x_list;
+  drawLanes<kBatchSize, false>(state, &x_list, nullptr);
+  for (uint lane = 0; lane < n; ++lane)
+    samples[lane] = toFloat(x_list[lane]);
+}
+
+/*!
+  \details
+  The batch is drawn by the lanes, the last lanes are discarded.
+  */
+void OwenSobolSampler::drawBatch2D(const PathState& state,
+                                   const uint n,
+                                   std::array<Float, 2>* samples) noexcept
+{
+  ZISC_ASSERT(n <= kBatchSize, "The batch is out of the lanes: ", n);
+  LaneArray<kBatchSize> x_list,
+                        y_list;
+  drawLanes<kBatchSize, true>(state, &x_list, &y_list);
+  for (uint lane = 0; lane < n; ++lane)
+    samples[lane] = {{toFloat(x_list[lane]), toFloat(y_list[lane])}};
+}
+
+/*!
+  */
+uint32 OwenSobolSampler::calcStreamKey() const noexcept
+{
+  return seed() + zisc::Fnv1aHash32::hash(stream());
+}
+
+/*!
+  \details
+  The sample index is shuffled by the Owen scrambling of the key of
+  each dimension, then the Sobol point of the shuffled index is scrambled.
+  The first dimension of Sobol is the reversed index,
+  so its scrambling is a hash of the index and the reversal.
+  Each step is a loop over the lanes without branches,
+  so the compiler vectorizes the steps.
+  */
+template <uint kWidth, bool k2d> inline
+void OwenSobolSampler::drawLanes(const PathState& state,
+                                 LaneArray<kWidth>* x_list,
+                                 LaneArray<kWidth>* y_list) const noexcept
+{
+  ZISC_ASSERT(x_list != nullptr, "The x list is null.");
+  const uint32 d = calcTotalDimension(state);
+  const uint32 stream_key = calcStreamKey();
+  const uint32 reversed_index = reverseBits(state.sample());
+
+  LaneArray<kWidth> key_list;
+  for (uint lane = 0; lane < kWidth; ++lane)
+    key_list[lane] = mix(stream_key ^ mix(d + lane));
+  LaneArray<kWidth> index_list;
+  for (uint lane = 0; lane < kWidth; ++lane)
+    index_list[lane] = reverseBits(scrambleReversed(reversed_index, key_list[lane]));
+  for (uint lane = 0; lane < kWidth; ++lane) {
+    const uint32 scramble_seed = mix(key_list[lane] + 0x9e3779b9u);
+    (*x_list)[lane] = reverseBits(scrambleReversed(index_list[lane], scramble_seed));
+  }
+  if constexpr (k2d) {
+    ZISC_ASSERT(y_list != nullptr, "The y list is null.");
+    for (uint lane = 0; lane < kWidth; ++lane) {
+      const uint32 scramble_seed = mix(key_list[lane] + 0x3c6ef372u);
+      const uint32 y = reverseBits(sobol1(index_list[lane]));
+      (*y_list)[lane] = reverseBits(scrambleReversed(y, scramble_seed));
+    }
+  }
+  else {
+    static_cast<void>(y_list);
+  }
+}
+
+} // namespace nanairo
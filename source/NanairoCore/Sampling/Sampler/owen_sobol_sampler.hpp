@@ -0,0 +1,85 @@
+/*!
+  \file owen_sobol_sampler.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_OWEN_SOBOL_SAMPLER_HPP
+#define NANAIRO_OWEN_SOBOL_SAMPLER_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "sampler_batch.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class PathState;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  A sampler of the Sobol sequence which is Owen scrambled by hashing.
+  Each dimension of a path state is a 2D Sobol pattern whose index is
+  shuffled and whose components are scrambled by the keys of the dimension,
+  so the dimensions are uncorrelated and keep the stratification of Sobol.
+  Please see "Practical Hash-based Owen Scrambling" for the details.
+  The consecutive dimensions are generated in lanes,
+  so the bit operations of the lanes are vectorized.
+  */
+class OwenSobolSampler final : public SamplerBatch<OwenSobolSampler>
+{
+ public:
+  //! Initialize a sampler
+  OwenSobolSampler(const uint32 seed) noexcept;
+
+
+  //! Sample a [0, 1) float random number
+  Float draw1D(const PathState& state) noexcept override;
+
+  //! Sample a [0, 1) float random number
+  std::array<Float, 2> draw2D(const PathState& state) noexcept override;
+
+ private:
+  friend SamplerBatch<OwenSobolSampler>;
+
+
+  template <uint kWidth>
+  using LaneArray = std::array<uint32, kWidth>;
+
+
+  static constexpr uint kBatchSize = 8; //!< The dimensions generated at once
+
+
+  //! Return the key of the stream
+  uint32 calcStreamKey() const noexcept;
+
+  //! Draw the samples of the n (<= kBatchSize) dimensions from the state
+  void drawBatch1D(const PathState& state,
+                   const uint n,
+                   Float* samples) noexcept;
+
+  //! Draw the sample pairs of the n (<= kBatchSize) dimensions from the state
+  void drawBatch2D(const PathState& state,
+                   const uint n,
+                   std::array<Float, 2>* samples) noexcept;
+
+  //! Draw the samples of the consecutive dimensions from the state in the lanes
+  template <uint kWidth, bool k2d>
+  void drawLanes(const PathState& state,
+                 LaneArray<kWidth>* x_list,
+                 LaneArray<kWidth>* y_list) const noexcept;
+};
+
+//! \}
+
+} // namespace nanairo
+
+#endif // NANAIRO_OWEN_SOBOL_SAMPLER_HPP
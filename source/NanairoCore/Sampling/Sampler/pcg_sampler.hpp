@@ -15,7 +15,7 @@
 // Zisc
 #include "zisc/pcg_engine.hpp"
 // Nanairo
-#include "sampler.hpp"
+#include "sampler_batch.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 
 namespace nanairo {
@@ -28,7 +28,7 @@ class PathState;
 
 /*!
   */
-class PcgSampler : public Sampler
+class PcgSampler final : public SamplerBatch<PcgSampler>
 {
  public:
   //! Initialize a sampler
@@ -42,7 +42,7 @@ class PcgSampler : public Sampler
   std::array<Float, 2> draw2D(const PathState& state) noexcept override;
 
  private:
-  zisc::PcgLcgRxsMXs32 engine_;
+  using Engine = zisc::PcgLcgRxsMXs32;
 };
 
 //! \}
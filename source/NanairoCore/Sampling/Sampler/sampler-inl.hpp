@@ -13,31 +13,38 @@
 #include "sampler.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
-#include "NanairoCore/Data/path_state.hpp"
 
 namespace nanairo {
 
 /*!
   */
 inline
-Sampler::Sampler(const uint32 sample) noexcept : path_state_{sample}
+Sampler::Sampler(const uint32 seed) noexcept : seed_{seed}, stream_{0}
 {
 }
 
 /*!
   */
 inline
-PathState& Sampler::pathState() noexcept
+uint32 Sampler::seed() const noexcept
 {
-  return path_state_;
+  return seed_;
 }
 
 /*!
   */
 inline
-const PathState& Sampler::pathState() const noexcept
+void Sampler::setStream(const uint32 stream) noexcept
 {
-  return path_state_;
+  stream_ = stream;
+}
+
+/*!
+  */
+inline
+uint32 Sampler::stream() const noexcept
+{
+  return stream_;
 }
 
 } // namespace nanairo
@@ -11,13 +11,19 @@
 // Standard C++ library
 #include <array>
 // Zisc
+#include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "cmj_sampler.hpp"
+#include "owen_sobol_sampler.hpp"
 #include "pcg_sampler.hpp"
+#include "table_cmj_sampler.hpp"
 #include "xoshiro_sampler.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
 
 namespace nanairo {
 
@@ -28,11 +34,14 @@ Sampler::~Sampler() noexcept
 }
 
 /*!
+  \details
+  The table is required by the table CMJ sampler only.
   */
 zisc::UniqueMemoryPointer<Sampler> Sampler::make(
     const SamplerType type,
     const uint32 seed,
-    zisc::pmr::memory_resource* mem_resource) noexcept
+    zisc::pmr::memory_resource* mem_resource,
+    const CmjTable* table) noexcept
 {
   zisc::UniqueMemoryPointer<Sampler> sampler;
   switch (type) {
@@ -48,10 +57,43 @@ zisc::UniqueMemoryPointer<Sampler> Sampler::make(
     sampler = zisc::UniqueMemoryPointer<CmjSampler>::make(mem_resource, seed);
     break;
    }
+   case SamplerType::kTableCmj: {
+    ZISC_ASSERT(table != nullptr, "The CMJ table is null.");
+    sampler = zisc::UniqueMemoryPointer<TableCmjSampler>::make(mem_resource,
+                                                               seed,
+                                                               table);
+    break;
+   }
+   case SamplerType::kOwenSobol: {
+    sampler = zisc::UniqueMemoryPointer<OwenSobolSampler>::make(mem_resource, seed);
+    break;
+   }
    default:
     break;
   }
   return sampler;
 }
 
+/*!
+  \details
+  The stream, the sample and the dimension are hashed in turn,
+  so neighboring pixels and dimensions get uncorrelated keys.
+  */
+uint32 Sampler::calcSampleKey(const PathState& state) const noexcept
+{
+  uint32 key = seed() + zisc::Fnv1aHash32::hash(stream());
+  key = zisc::Fnv1aHash32::hash(key ^ state.sample());
+  key = zisc::Fnv1aHash32::hash(key ^ calcTotalDimension(state));
+  return key;
+}
+
+/*!
+  */
+uint32 Sampler::calcTotalDimension(const PathState& state) noexcept
+{
+  constexpr uint32 bounce = zisc::cast<uint32>(SampleDimension::kBounce);
+  const uint32 d = (state.length() * bounce) + state.dimension();
+  return d;
+}
+
 } // namespace nanairo
@@ -22,6 +22,7 @@
 namespace nanairo {
 
 // Forward declaration
+class CmjTable;
 class PathState;
 
 //! \addtogroup Core
@@ -34,6 +35,8 @@ enum class SamplerType : uint32
   kPcg                        = zisc::Fnv1aHash32::hash("PCG"),
   kXoshiro                    = zisc::Fnv1aHash32::hash("Xoshiro"),
   kCmj                        = zisc::Fnv1aHash32::hash("Correlated Multi-Jittered"),
+  kTableCmj                   = zisc::Fnv1aHash32::hash("Table Correlated Multi-Jittered"),
+  kOwenSobol                  = zisc::Fnv1aHash32::hash("Owen Scrambled Sobol"),
 };
 
 /*!
@@ -64,9 +67,14 @@ enum class SampleDimension : uint32
 
 /*!
   \details
-  No detailed.
+  Samplers are counter based. A sample is a function of the seed,
+  the stream (a pixel or a light path) and the dimension of the path state,
+  so a sampler isn't bound to a pixel and
+  a thread reuses one sampler for all streams deterministically.
+  The stream is rewritten at each pixel, so a sampler is aligned to
+  a cache line and the samplers of the threads don't share a line.
   */
-class Sampler
+class alignas(64) Sampler
 {
  public:
   //! Destroy a sampler
@@ -76,19 +84,55 @@ class Sampler
   //! Sample a [0, 1) float random number
   virtual Float draw1D(const PathState& state) noexcept = 0;
 
+  //! Sample n [0, 1) float random numbers of the consecutive dimensions
+  virtual void draw1DN(const PathState& state,
+                       const uint n,
+                       Float* samples) noexcept = 0;
+
   //! Sample two [0, 1) float random numbers
   virtual std::array<Float, 2> draw2D(const PathState& state) noexcept = 0;
 
+  //! Sample n pairs of [0, 1) float random numbers of the consecutive dimensions
+  virtual void draw2DN(const PathState& state,
+                       const uint n,
+                       std::array<Float, 2>* samples) noexcept = 0;
+
   //! Make a sampler
   static zisc::UniqueMemoryPointer<Sampler> make(
       const SamplerType type,
       const uint32 seed,
-      zisc::pmr::memory_resource* mem_resource) noexcept;
+      zisc::pmr::memory_resource* mem_resource,
+      const CmjTable* table = nullptr) noexcept;
+
+  //! Return the seed of the sampler
+  uint32 seed() const noexcept;
+
+  //! Set the stream of the samples
+  void setStream(const uint32 stream) noexcept;
+
+  //! Return the stream of the samples
+  uint32 stream() const noexcept;
+
+ protected:
+  //! Initialize a sampler
+  Sampler(const uint32 seed) noexcept;
+
+
+  //! Calculate the key which is unique to the stream and the path state
+  uint32 calcSampleKey(const PathState& state) const noexcept;
+
+  //! Return the dimension of the path state over all bounces
+  static uint32 calcTotalDimension(const PathState& state) noexcept;
+
+ private:
+  uint32 seed_;
+  uint32 stream_;
 };
 
 //! \} Core
 
 } // namespace nanairo
 
+#include "sampler-inl.hpp"
 
 #endif // NANAIRO_SAMPLER_HPP
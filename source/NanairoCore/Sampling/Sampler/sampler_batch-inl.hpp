@@ -0,0 +1,108 @@
+/*!
+  \file sampler_batch-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SAMPLER_BATCH_INL_HPP
+#define NANAIRO_SAMPLER_BATCH_INL_HPP
+
+#include "sampler_batch.hpp"
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+// Nanairo
+#include "sampler.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <typename DerivedSampler> inline
+SamplerBatch<DerivedSampler>::SamplerBatch(const uint32 seed) noexcept :
+    Sampler(seed)
+{
+}
+
+/*!
+  \details
+  The batches are drawn by the qualified calls, which aren't virtual.
+  */
+template <typename DerivedSampler> inline
+void SamplerBatch<DerivedSampler>::draw1DN(const PathState& state,
+                                           const uint n,
+                                           Float* samples) noexcept
+{
+  ZISC_ASSERT(samples != nullptr, "The samples is null.");
+  constexpr uint batch_size = DerivedSampler::kBatchSize;
+  PathState s = state;
+  for (uint i = 0; i < n; i += batch_size) {
+    s.setDimension(state.dimension() + i);
+    derived().DerivedSampler::drawBatch1D(s,
+                                          zisc::min(n - i, batch_size),
+                                          samples + i);
+  }
+}
+
+/*!
+  \details
+  The batches are drawn by the qualified calls, which aren't virtual.
+  */
+template <typename DerivedSampler> inline
+void SamplerBatch<DerivedSampler>::draw2DN(const PathState& state,
+                                           const uint n,
+                                           std::array<Float, 2>* samples) noexcept
+{
+  ZISC_ASSERT(samples != nullptr, "The samples is null.");
+  constexpr uint batch_size = DerivedSampler::kBatchSize;
+  PathState s = state;
+  for (uint i = 0; i < n; i += batch_size) {
+    s.setDimension(state.dimension() + i);
+    derived().DerivedSampler::drawBatch2D(s,
+                                          zisc::min(n - i, batch_size),
+                                          samples + i);
+  }
+}
+
+/*!
+  */
+template <typename DerivedSampler> inline
+void SamplerBatch<DerivedSampler>::drawBatch1D(const PathState& state,
+                                               const uint n,
+                                               Float* samples) noexcept
+{
+  ZISC_ASSERT(n == 1, "The batch isn't a dimension: ", n);
+  static_cast<void>(n);
+  samples[0] = derived().DerivedSampler::draw1D(state);
+}
+
+/*!
+  */
+template <typename DerivedSampler> inline
+void SamplerBatch<DerivedSampler>::drawBatch2D(const PathState& state,
+                                               const uint n,
+                                               std::array<Float, 2>* samples) noexcept
+{
+  ZISC_ASSERT(n == 1, "The batch isn't a dimension: ", n);
+  static_cast<void>(n);
+  samples[0] = derived().DerivedSampler::draw2D(state);
+}
+
+/*!
+  */
+template <typename DerivedSampler> inline
+DerivedSampler& SamplerBatch<DerivedSampler>::derived() noexcept
+{
+  return *static_cast<DerivedSampler*>(this);
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_SAMPLER_BATCH_INL_HPP
@@ -0,0 +1,79 @@
+/*!
+  \file sampler_batch.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SAMPLER_BATCH_HPP
+#define NANAIRO_SAMPLER_BATCH_HPP
+
+// Standard C++ library
+#include <array>
+// Nanairo
+#include "sampler.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class PathState;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  The base of the samplers which draws the samples of the consecutive
+  dimensions through the derived sampler (CRTP).
+  The derived sampler is called without the virtual dispatch,
+  so the loops over the dimensions are inlined.
+  A derived sampler draws a batch of kBatchSize dimensions at once
+  by hiding kBatchSize and drawBatch1D/2D(), the default batch is
+  a dimension of draw1D/2D().
+  */
+template <typename DerivedSampler>
+class SamplerBatch : public Sampler
+{
+ public:
+  //! Sample n [0, 1) float random numbers of the consecutive dimensions
+  void draw1DN(const PathState& state,
+               const uint n,
+               Float* samples) noexcept override;
+
+  //! Sample n pairs of [0, 1) float random numbers of the consecutive dimensions
+  void draw2DN(const PathState& state,
+               const uint n,
+               std::array<Float, 2>* samples) noexcept override;
+
+ protected:
+  //! Initialize a sampler
+  SamplerBatch(const uint32 seed) noexcept;
+
+
+  static constexpr uint kBatchSize = 1; //!< The dimensions drawn at once
+
+  //! Draw the samples of the n (<= kBatchSize) dimensions from the state
+  void drawBatch1D(const PathState& state,
+                   const uint n,
+                   Float* samples) noexcept;
+
+  //! Draw the sample pairs of the n (<= kBatchSize) dimensions from the state
+  void drawBatch2D(const PathState& state,
+                   const uint n,
+                   std::array<Float, 2>* samples) noexcept;
+
+ private:
+  //! Return the derived sampler
+  DerivedSampler& derived() noexcept;
+};
+
+//! \}
+
+} // namespace nanairo
+
+#include "sampler_batch-inl.hpp"
+
+#endif // NANAIRO_SAMPLER_BATCH_HPP
@@ -0,0 +1,111 @@
+/*!
+  \file table_cmj_sampler.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "table_cmj_sampler.hpp"
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/correlated_multi_jittered_engine.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "cmj_table.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+TableCmjSampler::TableCmjSampler(const uint32 seed,
+                                 const CmjTable* table) noexcept :
+    SamplerBatch(seed),
+    table_{table}
+{
+  ZISC_ASSERT(table_ != nullptr, "The CMJ table is null.");
+}
+
+/*!
+  */
+Float TableCmjSampler::draw1D(const PathState& state) noexcept
+{
+  constexpr uint32 n = Engine::getPeriod();
+
+  const uint32 offset = state.sample() / n;
+  const uint32 d = calcTotalDimension(state);
+  const uint32 s = state.sample() - (offset * n);
+  Float sample = 0.0;
+  if (d < CmjTable::numOfDimensions()) {
+    const uint32 key = calcRotationKey(offset, d);
+    sample = rotate(table_->sample1D(d, s), key);
+  }
+  else {
+    const uint32 stream_seed = seed() + zisc::Fnv1aHash32::hash(stream());
+    const uint32 p = stream_seed + offset + zisc::Fnv1aHash32::hash(d);
+    sample = Engine::generate1D<Float>(s, p);
+  }
+  return sample;
+}
+
+/*!
+  */
+std::array<Float, 2> TableCmjSampler::draw2D(const PathState& state) noexcept
+{
+  constexpr uint32 n = Engine::getPeriod();
+
+  const uint32 offset = state.sample() / n;
+  const uint32 d = calcTotalDimension(state);
+  const uint32 s = state.sample() - (offset * n);
+  std::array<Float, 2> sample;
+  if (d < CmjTable::numOfDimensions()) {
+    const uint32 key = calcRotationKey(offset, d);
+    const auto& tabled_sample = table_->sample2D(d, s);
+    sample[0] = rotate(tabled_sample[0], key);
+    sample[1] = rotate(tabled_sample[1], zisc::Fnv1aHash32::hash(key));
+  }
+  else {
+    const uint32 stream_seed = seed() + zisc::Fnv1aHash32::hash(stream());
+    const uint32 p = stream_seed + offset + zisc::Fnv1aHash32::hash(d);
+    sample = Engine::generate2D<Float>(s, p);
+  }
+  return sample;
+}
+
+/*!
+  \details
+  The key changes every period of the pattern,
+  so the samples after the period aren't repeated.
+  */
+uint32 TableCmjSampler::calcRotationKey(const uint32 offset,
+                                        const uint32 d) const noexcept
+{
+  uint32 key = seed() + zisc::Fnv1aHash32::hash(stream()) + offset;
+  key = zisc::Fnv1aHash32::hash(key);
+  key = zisc::Fnv1aHash32::hash(key ^ d);
+  return key;
+}
+
+/*!
+  \details
+  The upper 24 bits of the key are used as the offset,
+  which are exact in single precision.
+  */
+Float TableCmjSampler::rotate(const Float sample, const uint32 key) noexcept
+{
+  constexpr Float k = 1.0 / zisc::cast<Float>(1u << 24);
+  const Float offset = zisc::cast<Float>(key >> 8) * k;
+  Float result = sample + offset;
+  result = (result < 1.0) ? result : result - 1.0;
+  ZISC_ASSERT(zisc::isInBounds(result, 0.0, 1.0),
+              "The sample is out of range: ", result);
+  return result;
+}
+
+} // namespace nanairo
@@ -0,0 +1,68 @@
+/*!
+  \file table_cmj_sampler.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TABLE_CMJ_SAMPLER_HPP
+#define NANAIRO_TABLE_CMJ_SAMPLER_HPP
+
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/correlated_multi_jittered_engine.hpp"
+// Nanairo
+#include "sampler_batch.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class CmjTable;
+class PathState;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \details
+  A CMJ sampler which looks up the samples of the first dimensions in a table.
+  The streams share the patterns of the table and
+  each stream rotates them by its own offsets (Cranley-Patterson rotation).
+  The dimensions which aren't in the table are evaluated as CmjSampler.
+  */
+class TableCmjSampler final : public SamplerBatch<TableCmjSampler>
+{
+ public:
+  //! Initialize a sampler
+  TableCmjSampler(const uint32 seed, const CmjTable* table) noexcept;
+
+
+  //! Sample a [0, 1) float random number
+  Float draw1D(const PathState& state) noexcept override;
+
+  //! Sample a [0, 1) float random number
+  std::array<Float, 2> draw2D(const PathState& state) noexcept override;
+
+ private:
+  using Engine = zisc::CmjN256;
+
+
+  //! Return the rotation key of the stream and the dimension
+  uint32 calcRotationKey(const uint32 offset, const uint32 d) const noexcept;
+
+  //! Rotate the sample by the key
+  static Float rotate(const Float sample, const uint32 key) noexcept;
+
+
+  const CmjTable* table_;
+};
+
+//! \}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TABLE_CMJ_SAMPLER_HPP
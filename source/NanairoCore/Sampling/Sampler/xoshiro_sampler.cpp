@@ -14,29 +14,32 @@
 #include "zisc/xoshiro_2star_engine.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
 
 namespace nanairo {
 
 /*!
   */
-XoshiroSampler::XoshiroSampler(const uint32 seed) noexcept : engine_{seed}
+XoshiroSampler::XoshiroSampler(const uint32 seed) noexcept : SamplerBatch(seed)
 {
 }
 
 /*!
   */
-Float XoshiroSampler::draw1D(const PathState& /* state */) noexcept
+Float XoshiroSampler::draw1D(const PathState& state) noexcept
 {
-  const Float r = engine_.generate01Float<Float>();
+  Engine engine{calcSampleKey(state)};
+  const Float r = engine.generate01Float<Float>();
   return r;
 }
 
 /*!
   */
-std::array<Float, 2> XoshiroSampler::draw2D(const PathState& /* state */) noexcept
+std::array<Float, 2> XoshiroSampler::draw2D(const PathState& state) noexcept
 {
-  const Float r1 = engine_.generate01Float<Float>();
-  const Float r2 = engine_.generate01Float<Float>();
+  Engine engine{calcSampleKey(state)};
+  const Float r1 = engine.generate01Float<Float>();
+  const Float r2 = engine.generate01Float<Float>();
   return {{r1, r2}};
 }
 
@@ -15,7 +15,7 @@
 // Zisc
 #include "zisc/xoshiro_2star_engine.hpp"
 // Nanairo
-#include "sampler.hpp"
+#include "sampler_batch.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 
 namespace nanairo {
@@ -28,7 +28,7 @@ class PathState;
 
 /*!
   */
-class XoshiroSampler : public Sampler
+class XoshiroSampler final : public SamplerBatch<XoshiroSampler>
 {
  public:
   //! Initialize a sampler
@@ -42,7 +42,7 @@ class XoshiroSampler : public Sampler
   std::array<Float, 2> draw2D(const PathState& state) noexcept override;
 
  private:
-  zisc::Xoshiro2Star32 engine_;
+  using Engine = zisc::Xoshiro2Star32;
 };
 
 //! \}
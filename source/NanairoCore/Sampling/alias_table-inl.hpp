@@ -0,0 +1,75 @@
+/*!
+  \file alias_table-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_ALIAS_TABLE_INL_HPP
+#define NANAIRO_ALIAS_TABLE_INL_HPP
+
+#include "alias_table.hpp"
+// Standard C++ library
+#include <limits>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+bool AliasTable::isEmpty() const noexcept
+{
+  return entry_list_.empty();
+}
+
+/*!
+  */
+inline
+uint AliasTable::sample(Float* sample) const noexcept
+{
+  ZISC_ASSERT(!isEmpty(), "The table is empty.");
+  return sampleEntries(entry_list_.data(), size(), sample);
+}
+
+/*!
+  \details
+  The residual of the sample in the cell is uniform in
+  the selected part of the cell, so it is rescaled to [0, 1).
+  */
+inline
+uint AliasTable::sampleEntries(const Entry* entry_list,
+                               const uint n,
+                               Float* sample) noexcept
+{
+  ZISC_ASSERT(sample != nullptr, "The sample is null.");
+  const Float x = *sample * zisc::cast<Float>(n);
+  const uint cell = zisc::min(zisc::cast<uint>(x), n - 1);
+  const Float residual = zisc::clamp(x - zisc::cast<Float>(cell), 0.0, 1.0);
+  const auto& entry = entry_list[cell];
+  const bool is_cell = residual < entry.threshold_;
+  const Float s = is_cell
+      ? residual / entry.threshold_
+      : (residual - entry.threshold_) / (1.0 - entry.threshold_);
+  *sample = zisc::clamp(s, 0.0, 1.0 - std::numeric_limits<Float>::epsilon());
+  return is_cell ? cell : zisc::cast<uint>(entry.alias_);
+}
+
+/*!
+  */
+inline
+uint AliasTable::size() const noexcept
+{
+  return zisc::cast<uint>(entry_list_.size());
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_ALIAS_TABLE_INL_HPP
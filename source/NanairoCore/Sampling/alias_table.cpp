@@ -0,0 +1,94 @@
+/*!
+  \file alias_table.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "alias_table.hpp"
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/compensated_summation.hpp"
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+AliasTable::AliasTable(zisc::pmr::memory_resource* data_resource) noexcept :
+    entry_list_{data_resource}
+{
+}
+
+/*!
+  \details
+  The cells are split into the ones which are less than the average and
+  the others, and a small cell is filled up by a large cell
+  until a small cell doesn't remain.
+  If the total weight is zero, the indices are uniform.
+  */
+void AliasTable::makeEntries(const Float* weight_list,
+                             const uint n,
+                             zisc::pmr::memory_resource* work_resource,
+                             Entry* entry_list) noexcept
+{
+  ZISC_ASSERT(0 < n, "The number of the weights is zero.");
+  zisc::CompensatedSummation<Float> total_weight{0.0};
+  for (uint i = 0; i < n; ++i) {
+    ZISC_ASSERT(0.0 <= weight_list[i], "The weight is negative.");
+    total_weight.add(weight_list[i]);
+  }
+
+  zisc::pmr::vector<Float> scaled_list{work_resource};
+  scaled_list.resize(n);
+  zisc::pmr::vector<uint> small_list{work_resource};
+  small_list.reserve(n);
+  zisc::pmr::vector<uint> large_list{work_resource};
+  large_list.reserve(n);
+  const bool is_valid = 0.0 < total_weight.get();
+  const Float k = is_valid ? zisc::cast<Float>(n) / total_weight.get() : 0.0;
+  for (uint i = 0; i < n; ++i) {
+    scaled_list[i] = is_valid ? weight_list[i] * k : 1.0;
+    if (scaled_list[i] < 1.0)
+      small_list.emplace_back(i);
+    else
+      large_list.emplace_back(i);
+  }
+
+  while (!small_list.empty() && !large_list.empty()) {
+    const uint s = small_list.back();
+    small_list.pop_back();
+    const uint l = large_list.back();
+    entry_list[s] = Entry{scaled_list[s], zisc::cast<uint32>(l)};
+    scaled_list[l] = (scaled_list[l] + scaled_list[s]) - 1.0;
+    if (scaled_list[l] < 1.0) {
+      large_list.pop_back();
+      small_list.emplace_back(l);
+    }
+  }
+  // The rest cells are full except the rounding errors
+  for (const uint i : large_list)
+    entry_list[i] = Entry{1.0, zisc::cast<uint32>(i)};
+  for (const uint i : small_list)
+    entry_list[i] = Entry{1.0, zisc::cast<uint32>(i)};
+}
+
+/*!
+  */
+void AliasTable::setWeights(const Float* weight_list,
+                            const uint n,
+                            zisc::pmr::memory_resource* work_resource) noexcept
+{
+  entry_list_.resize(n);
+  if (0 < n)
+    makeEntries(weight_list, n, work_resource, entry_list_.data());
+}
+
+} // namespace nanairo
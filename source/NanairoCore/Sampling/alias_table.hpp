@@ -0,0 +1,87 @@
+/*!
+  \file alias_table.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_ALIAS_TABLE_HPP
+#define NANAIRO_ALIAS_TABLE_HPP
+
+// Standard C++ library
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A table which samples an index of a discrete distribution in O(1)
+  \details
+  Each cell of the table has the same probability and
+  holds a part of its own index and a part of an alias index.
+  Please see "A Linear Algorithm For Generating Random Numbers With a Given
+  Distribution" for the details.
+  */
+class AliasTable
+{
+ public:
+  /*!
+    \details
+    The cell is selected if the residual of a sample is less than
+    the threshold, otherwise the alias is selected.
+    */
+  struct Entry
+  {
+    Float threshold_ = 1.0;
+    uint32 alias_ = 0;
+  };
+
+
+  //! Create an empty table
+  AliasTable(zisc::pmr::memory_resource* data_resource) noexcept;
+
+
+  //! Check if the table is empty
+  bool isEmpty() const noexcept;
+
+  //! Make the entries of the weights to the list
+  static void makeEntries(const Float* weight_list,
+                          const uint n,
+                          zisc::pmr::memory_resource* work_resource,
+                          Entry* entry_list) noexcept;
+
+  //! Sample an index and rescale the sample to [0, 1) for the reuse
+  uint sample(Float* sample) const noexcept;
+
+  //! Sample an index of the entries and rescale the sample to [0, 1)
+  static uint sampleEntries(const Entry* entry_list,
+                            const uint n,
+                            Float* sample) noexcept;
+
+  //! Make the table of the weights
+  void setWeights(const Float* weight_list,
+                  const uint n,
+                  zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Return the number of the indices
+  uint size() const noexcept;
+
+ private:
+  zisc::pmr::vector<Entry> entry_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "alias_table-inl.hpp"
+
+#endif // NANAIRO_ALIAS_TABLE_HPP
@@ -44,10 +44,42 @@ RouletteResult RussianRoulette::play(
   return (type_ == RouletteType::kMaxWeight)
       ? playWithMax(weight, sampler, path_state) :
          (type_ == RouletteType::kAverageWeight)
-      ? playWithAverage(weight, sampler, path_state)
+      ? playWithAverage(weight, sampler, path_state) :
+         (type_ == RouletteType::kEfficiency)
+      ? playWithEfficiency(weight, sampler, path_state)
       : playWithPath(path_state);
 }
 
+/*!
+  \details
+  The type is resolved at compile time, so a path tracer which is
+  specialized for the type doesn't branch on the type per vertex.
+  */
+template <RouletteType kType> inline
+RouletteResult RussianRoulette::play(
+    const SampledSpectra& weight,
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  ZISC_ASSERT(type_ == kType, "The roulette type is wrong.");
+  if constexpr (kType == RouletteType::kMaxWeight)
+    return playWithMax(weight, sampler, path_state);
+  else if constexpr (kType == RouletteType::kAverageWeight)
+    return playWithAverage(weight, sampler, path_state);
+  else if constexpr (kType == RouletteType::kEfficiency)
+    return playWithEfficiency(weight, sampler, path_state);
+  else
+    return playWithPath(path_state);
+}
+
+/*!
+  */
+inline
+RouletteType RussianRoulette::type() const noexcept
+{
+  return type_;
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_RUSSIAN_ROULETTE_INL_HPP
@@ -10,6 +10,7 @@
 #include "russian_roulette.hpp"
 // Zisc
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "sampled_spectra.hpp"
@@ -39,6 +40,7 @@ void RussianRoulette::initialize(const SettingNodeBase* settings) noexcept
   {
     type_ = method_settings->rouletteType();
     max_path_ = method_settings->roulettePathLength();
+    min_path_ = method_settings->rouletteMinPathLength();
   }
 }
 
@@ -51,12 +53,35 @@ RouletteResult RussianRoulette::playWithAverage(
     Sampler& sampler,
     const PathState& path_state) const noexcept
 {
+  if (path_state.length() < min_path_)
+    return RouletteResult{1.0};
   const Float average = weight.average();
   const Float probability = zisc::min(1.0, average);
   const bool result = sampler.draw1D(path_state) < probability;
   return (result) ? RouletteResult{probability} : RouletteResult{};
 }
 
+/*!
+  \details
+  The survival probability is the square root of the max weight,
+  which is the expected contribution of the path relative to a pixel value
+  of one. The paths of low throughput are terminated less aggressively
+  than by the max weight, so the variance of the terminated paths is
+  traded for a few more bounces.
+  */
+RouletteResult RussianRoulette::playWithEfficiency(
+    const SampledSpectra& weight,
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  if (path_state.length() < min_path_)
+    return RouletteResult{1.0};
+  const Float max = weight.max();
+  const Float probability = zisc::min(1.0, zisc::sqrt(max));
+  const bool result = sampler.draw1D(path_state) < probability;
+  return (result) ? RouletteResult{probability} : RouletteResult{};
+}
+
 /*!
   \details
   No detailed.
@@ -66,6 +91,8 @@ RouletteResult RussianRoulette::playWithMax(
     Sampler& sampler,
     const PathState& path_state) const noexcept
 {
+  if (path_state.length() < min_path_)
+    return RouletteResult{1.0};
   const Float max = weight.max();
   const Float probability = zisc::min(1.0, max);
   const bool result = sampler.draw1D(path_state) < probability;
@@ -31,10 +31,14 @@ enum class RouletteType : uint32
 {
   kMaxWeight                   = zisc::Fnv1aHash32::hash("MaxWeight"),
   kAverageWeight               = zisc::Fnv1aHash32::hash("AverageWeight"),
+  kEfficiency                  = zisc::Fnv1aHash32::hash("Efficiency"),
   kPathLength                  = zisc::Fnv1aHash32::hash("PathLength")
 };
 
 /*!
+  \details
+  The weight based roulettes don't terminate the paths
+  which are shorter than the min path length.
   */
 class RussianRoulette
 {
@@ -53,6 +57,15 @@ class RussianRoulette
                       Sampler& sampler,
                       const PathState& path_state) const noexcept;
 
+  //! Play russian roulette of the type which is fixed at compile time
+  template <RouletteType kType>
+  RouletteResult play(const SampledSpectra& weight,
+                      Sampler& sampler,
+                      const PathState& path_state) const noexcept;
+
+  //! Return the type of the roulette
+  RouletteType type() const noexcept;
+
  private:
   //! Initialize
   void initialize(const SettingNodeBase* settings) noexcept;
@@ -62,6 +75,11 @@ class RussianRoulette
                                  Sampler& sampler,
                                  const PathState& path_state) const noexcept;
 
+  //! Play russian roulette
+  RouletteResult playWithEfficiency(const SampledSpectra& weight,
+                                    Sampler& sampler,
+                                    const PathState& path_state) const noexcept;
+
   //! Play russian roulette
   RouletteResult playWithMax(const SampledSpectra& weight,
                              Sampler& sampler,
@@ -73,6 +91,7 @@ class RussianRoulette
 
   RouletteType type_;
   uint max_path_;
+  uint min_path_;
 };
 
 //! \} Core
@@ -16,23 +16,31 @@
 #include <bitset>
 #include <vector>
 // Zisc
-#include "zisc/compensated_summation.hpp"
 #include "zisc/error.hpp"
 #include "zisc/memory_resource.hpp"
-#include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
-#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Color/spectral_count_table.hpp"
+#include "NanairoCore/Color/spectral_table.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 
 namespace nanairo {
 
+/*!
+  */
+inline
+constexpr uint32 SampleStatistics::adaptiveSamplingInterval() noexcept
+{
+  return 16;
+}
+
 /*!
   */
 inline
 auto SampleStatistics::covarianceFactorTable() noexcept
-    -> zisc::pmr::vector<zisc::CompensatedSummation<Float>>&
+    -> zisc::pmr::vector<FilmFloat>&
 {
   ZISC_ASSERT(isEnabled(Type::kDenoisedExpectedValue), "The flag isn't enabled.");
   return covariance_factor_;
@@ -42,7 +50,7 @@ auto SampleStatistics::covarianceFactorTable() noexcept
   */
 inline
 auto SampleStatistics::covarianceFactorTable() const noexcept
-    -> const zisc::pmr::vector<zisc::CompensatedSummation<Float>>&
+    -> const zisc::pmr::vector<FilmFloat>&
 {
   ZISC_ASSERT(isEnabled(Type::kDenoisedExpectedValue), "The flag isn't enabled.");
   return covariance_factor_;
@@ -51,8 +59,7 @@ auto SampleStatistics::covarianceFactorTable() const noexcept
 /*!
   */
 inline
-auto SampleStatistics::denoisedSampleTable() noexcept
-    -> zisc::pmr::vector<SpectralDistributionPointer>&
+auto SampleStatistics::denoisedSampleTable() noexcept -> SpectralValueTable&
 {
   ZISC_ASSERT(isEnabled(Type::kDenoisedExpectedValue), "The flag isn't enabled.");
   return denoised_sample_;
@@ -62,31 +69,129 @@ auto SampleStatistics::denoisedSampleTable() noexcept
   */
 inline
 auto SampleStatistics::denoisedSampleTable() const noexcept
-    -> const zisc::pmr::vector<SpectralDistributionPointer>&
+    -> const SpectralValueTable&
 {
   ZISC_ASSERT(isEnabled(Type::kDenoisedExpectedValue), "The flag isn't enabled.");
   return denoised_sample_;
 }
 
+/*!
+  */
+inline
+auto SampleStatistics::firstHitAlbedoTable() noexcept
+    -> zisc::pmr::vector<FilmFloat>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_albedo_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitAlbedoTable() const noexcept
+    -> const zisc::pmr::vector<FilmFloat>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_albedo_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitCountTable() noexcept
+    -> zisc::pmr::vector<uint32>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_count_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitCountTable() const noexcept
+    -> const zisc::pmr::vector<uint32>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_count_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitDepthTable() noexcept
+    -> zisc::pmr::vector<FilmFloat>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_depth_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitDepthTable() const noexcept
+    -> const zisc::pmr::vector<FilmFloat>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_depth_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitNormalTable() noexcept
+    -> zisc::pmr::vector<FilmFloat>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_normal_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::firstHitNormalTable() const noexcept
+    -> const zisc::pmr::vector<FilmFloat>&
+{
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "The flag isn't enabled.");
+  return first_hit_normal_;
+}
+
 /*!
   */
 inline
 uint SampleStatistics::getFactorIndex(const uint i) const noexcept
 {
-  const uint size = sampleTable()[0]->size();
+  const uint size = sampleTable().numOfBins();
   const uint index = (i * (2 * size - (i + 1))) >> 1;
   return index;
 }
 
 /*!
+  \details
+  The pixels are stored in the tile-major layout,
+  so the samples of a rendering tile are written into contiguous memory.
   */
 inline
 uint SampleStatistics::getIndex(const Index2d position) const noexcept
 {
-  const uint index = position[1] * resolution()[0] + position[0];
+  const uint index = RenderingTile::getTileMajorIndex(resolution(), position);
   return index;
 }
 
+/*!
+  \details
+  All pixels are active unless adaptive sampling is enabled.
+  The cleared pixels are active.
+  */
+inline
+bool SampleStatistics::isActive(const Index2d position) const noexcept
+{
+  const uint pixel_index = getIndex(position);
+  const bool is_active = !isEnabled(Type::kSampleCount) ||
+                         isStale(pixel_index) ||
+                         (active_pixel_[pixel_index] == kTrue);
+  return is_active;
+}
+
 /*!
   */
 inline
@@ -96,11 +201,20 @@ bool SampleStatistics::isEnabled(const Type type) const noexcept
   return flag_[index];
 }
 
+/*!
+  \details
+  The XYZ table has the three bins of X, Y and Z in the layout of RGB.
+  */
+inline
+bool SampleStatistics::isXyzTable() const noexcept
+{
+  return is_xyz_table_ == kTrue;
+}
+
 /*!
   */
 inline
-auto SampleStatistics::histogramTable() noexcept
-    -> zisc::pmr::vector<SpectralDistributionPointer>&
+auto SampleStatistics::histogramTable() noexcept -> SpectralCountTable&
 {
   ZISC_ASSERT(isEnabled(Type::kDenoisedExpectedValue), "The flag isn't enabled.");
   return histogram_;
@@ -110,39 +224,78 @@ auto SampleStatistics::histogramTable() noexcept
   */
 inline
 auto SampleStatistics::histogramTable() const noexcept
-    -> const zisc::pmr::vector<SpectralDistributionPointer>&
+    -> const SpectralCountTable&
 {
   ZISC_ASSERT(isEnabled(Type::kDenoisedExpectedValue), "The flag isn't enabled.");
   return histogram_;
 }
 
+/*!
+  */
+inline
+auto SampleStatistics::meanTable() noexcept -> SpectralValueTable&
+{
+  ZISC_ASSERT(isEnabled(Type::kVariance), "The flag isn't enabled.");
+  return mean_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::meanTable() const noexcept
+    -> const SpectralValueTable&
+{
+  ZISC_ASSERT(isEnabled(Type::kVariance), "The flag isn't enabled.");
+  return mean_;
+}
+
 /*!
   */
 inline
 uint SampleStatistics::numOfCovarianceFactors() const noexcept
 {
-  const uint size = sampleTable()[0]->size();
+  const uint size = sampleTable().numOfBins();
   return getFactorIndex(size);
 }
 
 /*!
   */
 inline
-auto SampleStatistics::prevSampleTable() noexcept
-    -> zisc::pmr::vector<SpectralDistributionPointer>&
+auto SampleStatistics::pixelCostCountTable() noexcept
+    -> zisc::pmr::vector<uint32>&
 {
-  ZISC_ASSERT(isEnabled(Type::kVariance), "The flag isn't enabled.");
-  return prev_sample_;
+  ZISC_ASSERT(isEnabled(Type::kPixelCost), "The flag isn't enabled.");
+  return pixel_cost_count_;
 }
 
 /*!
   */
 inline
-auto SampleStatistics::prevSampleTable() const noexcept
-    -> const zisc::pmr::vector<SpectralDistributionPointer>&
+auto SampleStatistics::pixelCostCountTable() const noexcept
+    -> const zisc::pmr::vector<uint32>&
 {
-  ZISC_ASSERT(isEnabled(Type::kVariance), "The flag isn't enabled.");
-  return prev_sample_;
+  ZISC_ASSERT(isEnabled(Type::kPixelCost), "The flag isn't enabled.");
+  return pixel_cost_count_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::pixelCostTable() noexcept
+    -> zisc::pmr::vector<uint64>&
+{
+  ZISC_ASSERT(isEnabled(Type::kPixelCost), "The flag isn't enabled.");
+  return pixel_cost_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::pixelCostTable() const noexcept
+    -> const zisc::pmr::vector<uint64>&
+{
+  ZISC_ASSERT(isEnabled(Type::kPixelCost), "The flag isn't enabled.");
+  return pixel_cost_;
 }
 
 /*!
@@ -157,7 +310,7 @@ Index2d SampleStatistics::resolution() const noexcept
   */
 inline
 auto SampleStatistics::sampleTable() noexcept
-    -> zisc::pmr::vector<SpectralDistributionPointer>&
+    -> CompensatedSpectralValueTable&
 {
   ZISC_ASSERT(isEnabled(Type::kExpectedValue), "The flag isn't enabled.");
   return sample_;
@@ -167,7 +320,7 @@ auto SampleStatistics::sampleTable() noexcept
   */
 inline
 auto SampleStatistics::sampleTable() const noexcept
-    -> const zisc::pmr::vector<SpectralDistributionPointer>&
+    -> const CompensatedSpectralValueTable&
 {
   ZISC_ASSERT(isEnabled(Type::kExpectedValue), "The flag isn't enabled.");
   return sample_;
@@ -176,21 +329,62 @@ auto SampleStatistics::sampleTable() const noexcept
 /*!
   */
 inline
-auto SampleStatistics::sampleSquaredTable() noexcept
-    -> zisc::pmr::vector<SpectralDistributionPointer>&
+auto SampleStatistics::sampleCountTable() noexcept -> zisc::pmr::vector<uint32>&
+{
+  ZISC_ASSERT(isEnabled(Type::kSampleCount), "The flag isn't enabled.");
+  return sample_count_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::sampleCountTable() const noexcept
+    -> const zisc::pmr::vector<uint32>&
+{
+  ZISC_ASSERT(isEnabled(Type::kSampleCount), "The flag isn't enabled.");
+  return sample_count_;
+}
+
+/*!
+  */
+inline
+auto SampleStatistics::squaredDeviationTable() noexcept
+    -> CompensatedSpectralValueTable&
 {
   ZISC_ASSERT(isEnabled(Type::kVariance), "The flag isn't enabled.");
-  return sample_squared_;
+  return squared_deviation_;
 }
 
 /*!
   */
 inline
-auto SampleStatistics::sampleSquaredTable() const noexcept
-    -> const zisc::pmr::vector<SpectralDistributionPointer>&
+auto SampleStatistics::squaredDeviationTable() const noexcept
+    -> const CompensatedSpectralValueTable&
 {
   ZISC_ASSERT(isEnabled(Type::kVariance), "The flag isn't enabled.");
-  return sample_squared_;
+  return squared_deviation_;
+}
+
+/*!
+  */
+inline
+bool SampleStatistics::isStale(const std::size_t pixel_index) const noexcept
+{
+  return pixel_epoch_[pixel_index] != epoch_;
+}
+
+/*!
+  \details
+  The pixel is written only by the thread which renders it,
+  so the epoch of the pixel isn't shared by threads.
+  */
+inline
+void SampleStatistics::refreshPixel(const std::size_t pixel_index) noexcept
+{
+  if (isStale(pixel_index)) {
+    clearPixel(pixel_index);
+    pixel_epoch_[pixel_index] = epoch_;
+  }
 }
 
 } // namespace nanairo
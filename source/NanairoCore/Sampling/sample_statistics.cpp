@@ -9,121 +9,405 @@
 
 #include "sample_statistics.hpp"
 // Standard C++ library
+#include <algorithm>
 #include <bitset>
+#include <istream>
 #include <limits>
+#include <ostream>
 #include <vector>
 // Zisc
+#include "zisc/binary_data.hpp"
 #include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
-#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/thread_manager.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "sampled_spectra.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
+#include "NanairoCore/Color/spectral_count_table.hpp"
+#include "NanairoCore/Color/spectral_table.hpp"
+#include "NanairoCore/Color/xyz_color_matching_function.hpp"
 #include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 #include "NanairoCore/Data/wavelength_samples.hpp"
 #include "NanairoCore/Denoiser/bayesian_collaborative_denoiser.hpp"
 #include "NanairoCore/Denoiser/denoiser.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
+#include "NanairoCore/Utility/out_of_core_memory_resource.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
 
 namespace nanairo {
 
 /*!
   */
 SampleStatistics::SampleStatistics(System& system) noexcept :
-    sample_{&system.dataMemoryManager()},
-    prev_sample_{&system.dataMemoryManager()},
-    sample_squared_{&system.dataMemoryManager()},
-    histogram_{&system.dataMemoryManager()},
-    covariance_factor_{&system.dataMemoryManager()},
-    denoised_sample_{&system.dataMemoryManager()},
+    sample_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    mean_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    squared_deviation_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    histogram_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    covariance_factor_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    denoised_sample_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    sample_count_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    active_pixel_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    first_hit_normal_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    first_hit_albedo_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    first_hit_depth_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    first_hit_count_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    pixel_cost_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    pixel_cost_count_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    pixel_epoch_{&system.trackedMemoryResource(MemoryCategory::kFilm)},
+    film_resource_{system.isMappedFilmEnabled() ? &system.filmMemoryResource()
+                                                : nullptr},
     resolution_{system.imageResolution()},
-    flag_{system.sampleStatisticsFlag()}
+    flag_{system.sampleStatisticsFlag()},
+    histogram_bins_{0},
+    epoch_{0},
+    has_stale_pixels_{kFalse},
+    is_xyz_table_{system.isXyzFilmEnabled() ? kTrue : kFalse},
+    sample_weight_{zisc::invert(zisc::cast<Float>(system.samplesPerCycle()))}
 {
   initialize(system);
 }
 
 /*!
+  \details
+  The features are summed up with the number of them,
+  so the mean is the sum divided by the count.
+  The albedo is the mean of the sampled wavelengths.
+  The features are written by the thread which renders the pixel.
+  */
+void SampleStatistics::addFirstHitFeature(const Index2d position,
+                                          const Vector3& normal,
+                                          const SampledSpectra& albedo,
+                                          const Float depth) noexcept
+{
+  using zisc::cast;
+
+  ZISC_ASSERT(isEnabled(Type::kFirstHitFeatures), "A feature isn't able to be added.");
+  const uint pixel_index = getIndex(position);
+  refreshPixel(pixel_index);
+  for (uint i = 0; i < 3; ++i)
+    first_hit_normal_[3 * pixel_index + i] += cast<FilmFloat>(normal[i]);
+  Float albedo_mean = 0.0;
+  for (uint i = 0; i < albedo.size(); ++i)
+    albedo_mean += albedo.intensity(i);
+  albedo_mean = albedo_mean / cast<Float>(albedo.size());
+  first_hit_albedo_[pixel_index] += cast<FilmFloat>(albedo_mean);
+  first_hit_depth_[pixel_index] += cast<FilmFloat>(depth);
+  ++first_hit_count_[pixel_index];
+}
+
+/*!
+  \details
+  The costs are summed up with the number of the paths like the features.
+  The cycles are the time stamp counts, which depend on the processor.
+  */
+void SampleStatistics::addPixelCost(const Index2d position,
+                                    const uint64 num_of_visits,
+                                    const uint64 num_of_tests,
+                                    const uint64 num_of_cycles) noexcept
+{
+  ZISC_ASSERT(isEnabled(Type::kPixelCost), "A cost isn't able to be added.");
+  const uint pixel_index = getIndex(position);
+  refreshPixel(pixel_index);
+  pixel_cost_[3 * pixel_index + 0] += num_of_visits;
+  pixel_cost_[3 * pixel_index + 1] += num_of_tests;
+  pixel_cost_[3 * pixel_index + 2] += num_of_cycles;
+  ++pixel_cost_count_[pixel_index];
+}
+
+/*!
+  \details
+  A sample is weighted by the inverse of the samples per cycle,
+  so the value of a cycle is the mean of its samples and
+  the statistics are normalized by the number of cycles.
   */
 void SampleStatistics::addSample(const Index2d position,
                                  const SampledSpectra& sample) noexcept
+{
+  addSample(position, sample, sensor_response_);
+}
+
+/*!
+  \details
+  The response is the CMF of the wavelengths of the sample,
+  which is used only if the table has XYZ values.
+  */
+void SampleStatistics::addSample(
+    const Index2d position,
+    const SampledSpectra& sample,
+    const XyzColorMatchingFunction::SensorResponse& response) noexcept
 {
   ZISC_ASSERT(isEnabled(Type::kExpectedValue), "A sample isn't able to be added.");
 
+  auto& sample_table = sampleTable();
+  const uint pixel_index = getIndex(position);
+  refreshPixel(pixel_index);
+  if (isXyzTable()) {
+    // The samples are converted to XYZ by the CMF of the wavelengths
+    const auto xyz = XyzColorMatchingFunction::toXyz(response, sample);
+    for (uint color = 0; color < 3; ++color)
+      sample_table.add(pixel_index, color, sample_weight_ * xyz[color]);
+    return;
+  }
   for (uint i = 0; i < sample.size(); ++i) {
     // Expected value
-    const uint pixel_index = getIndex(position);
-    auto& sample_p = sampleTable()[pixel_index];
-
-    const uint si = sample_p->getIndex(sample.wavelength(i));
-    const Float s = sample.intensity(i);
-    sample_p->add(si, s);
+    const uint si = sample_table.getIndex(sample.wavelength(i));
+    const Float s = sample_weight_ * sample.intensity(i);
+    sample_table.add(pixel_index, si, s);
   }
 }
 
 /*!
+  \details
+  Only the epoch is incremented, and the pixels are cleared lazily.
+  When the epoch wraps around, the epochs of the pixels are reset
+  so as not to match the new epoch.
   */
 void SampleStatistics::clear() noexcept
 {
   ZISC_ASSERT(isEnabled(Type::kExpectedValue), "A sample isn't able to be added.");
+  ++epoch_;
+  if (epoch_ == 0)
+    std::fill(pixel_epoch_.begin(), pixel_epoch_.end(), ~epoch_);
+  has_stale_pixels_ = kTrue;
+}
 
+/*!
+  \details
+  The statistics have to be made with the same settings and
+  from the samples of a different seed.
+  The sums are added and the moments are combined by the parallel algorithm
+  of Chan et al. With delta = mean_b - mean_a and n = n_a + n_b,
+  mean = mean_a + delta * n_b / n,
+  M2 = M2_a + M2_b + delta^2 * n_a * n_b / n.
+  The number of samples of a pixel is the cycles
+  unless the sample count is enabled.
+  */
+void SampleStatistics::merge(System& system,
+                             const SampleStatistics& other,
+                             const uint32 cycle,
+                             const uint32 other_cycle) noexcept
+{
+  ZISC_ASSERT(flag_ == other.flag_, "The statistics have different flags.");
+  ZISC_ASSERT((resolution_[0] == other.resolution_[0]) &&
+              (resolution_[1] == other.resolution_[1]),
+              "The statistics have different resolutions.");
+  ZISC_ASSERT(other.has_stale_pixels_ == kFalse,
+              "The other statistics have the stale pixels.");
+
+  const bool count_is_enabled = isEnabled(Type::kSampleCount);
+  const bool variance_is_enabled = isEnabled(Type::kVariance);
+  const bool bc_values_are_enabled = isEnabled(Type::kBayesianCollaborativeValues);
+  const bool features_are_enabled = isEnabled(Type::kFirstHitFeatures);
+  const bool cost_is_enabled = isEnabled(Type::kPixelCost);
+
+  auto merge_info =
+  [this, &system, &other, cycle, other_cycle,
+   count_is_enabled, variance_is_enabled, bc_values_are_enabled,
+   features_are_enabled, cost_is_enabled]
+  (const uint task_id)
   {
-    // Sample
-    for (auto& sample_p : sampleTable())
-      sample_p->fill(0.0);
+    auto& sample_table = sampleTable();
+    const auto& other_sample_table = other.sampleTable();
+    const auto range = system.calcTaskRange(sample_table.numOfRows(), task_id);
+    for (auto pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
+      refreshPixel(pixel_index);
+      for (uint si = 0; si < sample_table.numOfBins(); ++si)
+        sample_table.add(pixel_index, si, other_sample_table.get(pixel_index, si));
+
+      if (variance_is_enabled) {
+        const uint32 n_a = count_is_enabled ? sample_count_[pixel_index] : cycle;
+        const uint32 n_b = count_is_enabled
+            ? other.sample_count_[pixel_index]
+            : other_cycle;
+        if (0 < (n_a + n_b)) {
+          const Float w = zisc::cast<Float>(n_b) / zisc::cast<Float>(n_a + n_b);
+          const Float k = zisc::cast<Float>(n_a) * w;
+          for (uint si = 0; si < sample_table.numOfBins(); ++si) {
+            const Float mean = mean_.get(pixel_index, si);
+            const Float delta = other.mean_.get(pixel_index, si) - mean;
+            mean_.set(pixel_index, si, mean + w * delta);
+            const Float m2 = other.squared_deviation_.get(pixel_index, si);
+            squared_deviation_.add(pixel_index, si, m2 + k * delta * delta);
+          }
+        }
+      }
+
+      if (bc_values_are_enabled) {
+        const std::size_t row = pixel_index * histogram_bins_;
+        for (std::size_t h = row; h < (row + histogram_bins_); ++h) {
+          for (uint si = 0; si < histogram_.numOfBins(); ++si)
+            histogram_.add(h, si, other.histogram_.count(h, si));
+        }
+        const std::size_t f = numOfCovarianceFactors() * pixel_index;
+        for (std::size_t i = f; i < (f + numOfCovarianceFactors()); ++i)
+          covariance_factor_[i] += other.covariance_factor_[i];
+      }
+
+      if (count_is_enabled) {
+        sample_count_[pixel_index] += other.sample_count_[pixel_index];
+        if (other.active_pixel_[pixel_index] == kTrue)
+          active_pixel_[pixel_index] = kTrue;
+      }
+
+      if (features_are_enabled) {
+        for (std::size_t i = 3 * pixel_index; i < 3 * (pixel_index + 1); ++i)
+          first_hit_normal_[i] += other.first_hit_normal_[i];
+        first_hit_albedo_[pixel_index] += other.first_hit_albedo_[pixel_index];
+        first_hit_depth_[pixel_index] += other.first_hit_depth_[pixel_index];
+        first_hit_count_[pixel_index] += other.first_hit_count_[pixel_index];
+      }
+
+      if (cost_is_enabled) {
+        for (std::size_t i = 3 * pixel_index; i < 3 * (pixel_index + 1); ++i)
+          pixel_cost_[i] += other.pixel_cost_[i];
+        pixel_cost_count_[pixel_index] += other.pixel_cost_count_[pixel_index];
+      }
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(merge_info, start, end, &work_resource);
+    result.wait();
   }
+  has_stale_pixels_ = kFalse;
+}
 
-  if (isEnabled(Type::kVariance)) {
-    // Prev sample
-    for (auto& sample_p : prevSampleTable())
-      sample_p->fill(0.0);
+/*!
+  \details
+  The statistics have to be created with the same settings as the written ones,
+  otherwise false is returned.
+  */
+bool SampleStatistics::readData(std::istream* data_stream) noexcept
+{
+  uint32 flag = 0;
+  zisc::read(&flag, data_stream);
+  uint8 is_xyz_table = kFalse;
+  zisc::read(&is_xyz_table, data_stream);
+  Index2d resolution;
+  zisc::read(&resolution[0], data_stream);
+  zisc::read(&resolution[1], data_stream);
+  bool result = data_stream->good() &&
+                (flag == zisc::cast<uint32>(flag_.to_ulong())) &&
+                (is_xyz_table == is_xyz_table_) &&
+                (resolution[0] == resolution_[0]) &&
+                (resolution[1] == resolution_[1]);
+  // All pixels are overwritten by the data
+  std::fill(pixel_epoch_.begin(), pixel_epoch_.end(), epoch_);
+  has_stale_pixels_ = kFalse;
+
+  if (result && isEnabled(Type::kExpectedValue))
+    result = sampleTable().readData(data_stream);
+
+  if (result && isEnabled(Type::kVariance)) {
+    result = meanTable().readData(data_stream) &&
+             squaredDeviationTable().readData(data_stream);
+  }
 
-    // Sample squared
-    for (auto& sample_p : sampleSquaredTable())
-      sample_p->fill(0.0);
+  if (result && isEnabled(Type::kBayesianCollaborativeValues)) {
+    uint64 num_of_factors = 0;
+    result = histogramTable().readData(data_stream);
+    zisc::read(&num_of_factors, data_stream);
+    result = result && (num_of_factors == covariance_factor_.size());
+    if (result) {
+      zisc::read(covariance_factor_.data(), data_stream,
+                 covariance_factor_.size() * sizeof(FilmFloat));
+    }
   }
 
-  if (isEnabled(Type::kBayesianCollaborativeValues)) {
-    // Histogram
-    for (auto& sample_p : histogramTable())
-      sample_p->fill(0.0);
+  if (result && isEnabled(Type::kSampleCount)) {
+    zisc::read(sample_count_.data(), data_stream,
+               sample_count_.size() * sizeof(uint32));
+    zisc::read(active_pixel_.data(), data_stream,
+               active_pixel_.size() * sizeof(uint8));
+  }
 
-    // Covariance matrix factor
-    for (auto& factor : covarianceFactorTable())
-      factor.set(0.0);
+  if (result && isEnabled(Type::kFirstHitFeatures)) {
+    zisc::read(first_hit_normal_.data(), data_stream,
+               first_hit_normal_.size() * sizeof(FilmFloat));
+    zisc::read(first_hit_albedo_.data(), data_stream,
+               first_hit_albedo_.size() * sizeof(FilmFloat));
+    zisc::read(first_hit_depth_.data(), data_stream,
+               first_hit_depth_.size() * sizeof(FilmFloat));
+    zisc::read(first_hit_count_.data(), data_stream,
+               first_hit_count_.size() * sizeof(uint32));
   }
 
-  if (isEnabled(Type::kDenoisedExpectedValue)) {
-    // Denoised sample
-    for (auto& sample_p : denoisedSampleTable())
-      sample_p->fill(0.0);
+  if (result && isEnabled(Type::kPixelCost)) {
+    zisc::read(pixel_cost_.data(), data_stream,
+               pixel_cost_.size() * sizeof(uint64));
+    zisc::read(pixel_cost_count_.data(), data_stream,
+               pixel_cost_count_.size() * sizeof(uint32));
   }
+  return result && data_stream->good();
 }
 
 /*!
+  \details
+  The value of the cycle of a pixel is the difference between the sum and
+  the previous sum, which is n - 1 times the mean of the previous cycles.
+  Every bin is updated, since the bins which aren't sampled in the cycle
+  have the value zero.
+  All statistics of a pixel are updated in one sweep of the film, and
+  the sweep is skipped when only the expected value is enabled
+  unless the pixels which have no sample since the last clear remain.
+  The per-cycle statistics can't be deferred to the cycles they are used,
+  since the value of a cycle is lost in the next cycle.
+  So only the products of the wavelength pairs are summed per cycle,
+  and the denoiser derives the covariance factors from the sums and
+  the moments when a denoise is requested.
   */
 void SampleStatistics::update(
     System& system,
     const WavelengthSamples& wavelengths,
-    const uint32 /* cycle */) noexcept
+    const uint32 cycle) noexcept
 {
-  auto update_info = [this, &system, &wavelengths](const uint task_id)
+  TraceRecorder::Scope scope{system.traceRecorder(), "Sample statistics update"};
+  const bool count_is_enabled = isEnabled(Type::kSampleCount);
+  const bool variance_is_enabled = isEnabled(Type::kVariance);
+  const bool bc_values_are_enabled = isEnabled(Type::kBayesianCollaborativeValues);
+  if (!(count_is_enabled || variance_is_enabled || bc_values_are_enabled ||
+        (has_stale_pixels_ == kTrue)))
+    return;
+
+  CycleIndices indices;
+  if (bc_values_are_enabled)
+    indices = makeCycleIndices(wavelengths);
+
+  auto update_info =
+  [this, &system, &indices, cycle,
+   count_is_enabled, variance_is_enabled, bc_values_are_enabled]
+  (const uint task_id)
   {
+    TraceRecorder::Scope task_scope{system.traceRecorder(),
+                                    "Sample statistics update task"};
     // Set the calculation range
-    const auto range = system.calcTaskRange(sampleTable().size(), task_id);
+    const auto range = system.calcTaskRange(sampleTable().numOfRows(), task_id);
     for (auto pixel_index = range[0]; pixel_index < range[1]; ++pixel_index) {
-      if (isEnabled(Type::kVariance))
-        updateSampleSquared(wavelengths, pixel_index);
+      refreshPixel(pixel_index);
+      uint32 n = cycle;
+      if (count_is_enabled) {
+        // The inactive pixels have no sample in the cycle
+        if (active_pixel_[pixel_index] != kTrue)
+          continue;
+        n = ++sample_count_[pixel_index];
+      }
 
-      if (isEnabled(Type::kBayesianCollaborativeValues)) {
-        updateHistogram(system, wavelengths, pixel_index);
-        updateCovarianceFactor(wavelengths, pixel_index);
+      if (bc_values_are_enabled) {
+        const auto values = calcCycleValues(indices, pixel_index, n);
+        updateHistogram(system, indices, values, pixel_index);
+        updateCovarianceFactor(indices, values, pixel_index);
       }
 
-      if (isEnabled(Type::kVariance))
-        updatePrevSample(wavelengths, pixel_index);
+      if (variance_is_enabled)
+        updateMoments(pixel_index, n);
     }
   };
 
@@ -135,47 +419,375 @@ void SampleStatistics::update(
     auto result = threads.enqueueLoop(update_info, start, end, &work_resource);
     result.wait();
   }
+  has_stale_pixels_ = kFalse;
 }
 
 /*!
+  \details
+  The CMF values of the wavelengths are looked up once per cycle,
+  so a sample is converted to XYZ by a few multiplications.
+  The samples of the wavelengths sampled per tile are added with
+  the response of their own wavelengths instead.
+  The sum of the bins weighted by the CMF equals the XYZ of the spectra,
+  which the HDR image calculates from the spectral table.
   */
-void SampleStatistics::initialize(System& system) noexcept
+void SampleStatistics::setWavelengths(const System& system,
+                                      const WavelengthSamples& wavelengths) noexcept
 {
-  const std::size_t size = resolution_[0] * resolution_[1];
-  auto init_distribution_table =
-  [&system](const std::size_t s,
-            const bool is_compensated,
-            zisc::pmr::vector<SpectralDistributionPointer>& table)
+  if (!isXyzTable())
+    return;
+  const auto& cmf = system.xyzColorMatchingFunction();
+  sensor_response_ = cmf.makeSensorResponse(wavelengths);
+}
+
+/*!
+  \details
+  The tables are tile-major, so the rows of the tile are contiguous
+  in each table and a touch per cluster records the whole tile.
+  The untouched tiles, e.g. the converged tiles of adaptive sampling,
+  are paged out first when the film is trimmed.
+  */
+void SampleStatistics::touch(const RenderingTile& tile) const noexcept
+{
+  if (film_resource_ == nullptr)
+    return;
+  const std::size_t num_of_pixels = zisc::cast<std::size_t>(resolution_[0]) *
+                                    zisc::cast<std::size_t>(resolution_[1]);
+  const std::size_t begin = getIndex(tile.begin());
+  const std::size_t end = begin + tile.numOfPixels();
+  auto touch_rows = [this, num_of_pixels, begin, end](const void* data,
+                                                      const std::size_t size)
   {
-    for (std::size_t i = 0; i < s; ++i) {
-      table.emplace_back(SpectralDistribution::makeDistribution(
-          system.colorMode(),
-          &system.dataMemoryManager(),
-          is_compensated));
+    if ((data == nullptr) || (size < num_of_pixels))
+      return;
+    constexpr std::size_t cluster_size = OutOfCoreMemoryResource::clusterSize();
+    const std::size_t row_size = size / num_of_pixels;
+    const auto* rows = zisc::cast<const uint8*>(data);
+    for (std::size_t offset = begin * row_size;
+         offset < end * row_size;
+         offset += cluster_size) {
+      film_resource_->touch(rows + offset);
     }
+    film_resource_->touch(rows + (end * row_size - 1));
+  };
+  auto touch_list = [&touch_rows](const auto& list)
+  {
+    touch_rows(list.data(), list.size() * sizeof(list[0]));
+  };
+  auto touch_table = [&touch_rows](const auto& table)
+  {
+    touch_rows(table.data(),
+               table.numOfRows() * table.numOfBins() * sizeof(table.data()[0]));
   };
 
-  if (isEnabled(Type::kExpectedValue)) {
-    sample_.reserve(size);
-    init_distribution_table(size, true, sample_);
+  touch_table(sample_);
+  touch_table(mean_);
+  touch_table(squared_deviation_);
+  touch_table(histogram_);
+  touch_table(denoised_sample_);
+  touch_list(covariance_factor_);
+  touch_list(sample_count_);
+  touch_list(active_pixel_);
+  touch_list(first_hit_normal_);
+  touch_list(first_hit_albedo_);
+  touch_list(first_hit_depth_);
+  touch_list(first_hit_count_);
+  touch_list(pixel_cost_);
+  touch_list(pixel_cost_count_);
+  touch_list(pixel_epoch_);
+}
+
+/*!
+  \details
+  The activity is decided per rendering tile,
+  since the rendering methods skip a whole tile at once.
+  A tile stays active while any of its pixels is above the threshold.
+  */
+void SampleStatistics::updateActivePixels(System& system) noexcept
+{
+  ZISC_ASSERT(isEnabled(Type::kSampleCount), "The sample count isn't enabled.");
+  ZISC_ASSERT(isEnabled(Type::kVariance), "The variance isn't enabled.");
+
+  constexpr uint s = CoreConfig::sizeOfRenderingTileSide();
+  const uint dx = (resolution_[0] / s) + ((resolution_[0] % s != 0) ? 1 : 0);
+  const uint dy = (resolution_[1] / s) + ((resolution_[1] % s != 0) ? 1 : 0);
+  const Float threshold = system.adaptiveSamplingThreshold();
+
+  auto update_tiles = [this, dx, dy, threshold, &system](const uint task_id)
+  {
+    const auto range = system.calcTaskRange(dx * dy, task_id);
+    for (auto tile_index = range[0]; tile_index < range[1]; ++tile_index) {
+      const uint x = tile_index % dx;
+      const uint y = tile_index / dx;
+      const Index2d begin{x * s, y * s};
+      const Index2d end{zisc::min((x + 1) * s, resolution_[0]),
+                        zisc::min((y + 1) * s, resolution_[1])};
+      // Check if the tile has converged
+      bool is_active = false;
+      for (uint py = begin[1]; !is_active && (py < end[1]); ++py) {
+        for (uint px = begin[0]; !is_active && (px < end[0]); ++px) {
+          const uint pixel_index = getIndex(Index2d{px, py});
+          is_active = threshold < calcRelativeError(pixel_index);
+        }
+      }
+      // Update the activity of the pixels
+      for (uint py = begin[1]; py < end[1]; ++py) {
+        for (uint px = begin[0]; px < end[0]; ++px) {
+          const uint pixel_index = getIndex(Index2d{px, py});
+          active_pixel_[pixel_index] = is_active ? kTrue : kFalse;
+        }
+      }
+    }
+  };
+
+  {
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(update_tiles, start, end, &work_resource);
+    result.wait();
   }
+}
+
+/*!
+  \details
+  The denoised sample isn't written, since it's made from the other statistics.
+  */
+void SampleStatistics::writeData(std::ostream* data_stream) const noexcept
+{
+  ZISC_ASSERT(has_stale_pixels_ == kFalse, "The statistics have the stale pixels.");
+  const uint32 flag = zisc::cast<uint32>(flag_.to_ulong());
+  zisc::write(&flag, data_stream);
+  zisc::write(&is_xyz_table_, data_stream);
+  zisc::write(&resolution_[0], data_stream);
+  zisc::write(&resolution_[1], data_stream);
+
+  if (isEnabled(Type::kExpectedValue))
+    sampleTable().writeData(data_stream);
 
   if (isEnabled(Type::kVariance)) {
-    prev_sample_.reserve(size);
-    init_distribution_table(size, false, prev_sample_);
+    meanTable().writeData(data_stream);
+    squaredDeviationTable().writeData(data_stream);
+  }
+
+  if (isEnabled(Type::kBayesianCollaborativeValues)) {
+    histogramTable().writeData(data_stream);
+    const uint64 num_of_factors = zisc::cast<uint64>(covariance_factor_.size());
+    zisc::write(&num_of_factors, data_stream);
+    zisc::write(covariance_factor_.data(), data_stream,
+                covariance_factor_.size() * sizeof(FilmFloat));
+  }
+
+  if (isEnabled(Type::kSampleCount)) {
+    zisc::write(sample_count_.data(), data_stream,
+                sample_count_.size() * sizeof(uint32));
+    zisc::write(active_pixel_.data(), data_stream,
+                active_pixel_.size() * sizeof(uint8));
+  }
+
+  if (isEnabled(Type::kFirstHitFeatures)) {
+    zisc::write(first_hit_normal_.data(), data_stream,
+                first_hit_normal_.size() * sizeof(FilmFloat));
+    zisc::write(first_hit_albedo_.data(), data_stream,
+                first_hit_albedo_.size() * sizeof(FilmFloat));
+    zisc::write(first_hit_depth_.data(), data_stream,
+                first_hit_depth_.size() * sizeof(FilmFloat));
+    zisc::write(first_hit_count_.data(), data_stream,
+                first_hit_count_.size() * sizeof(uint32));
+  }
+
+  if (isEnabled(Type::kPixelCost)) {
+    zisc::write(pixel_cost_.data(), data_stream,
+                pixel_cost_.size() * sizeof(uint64));
+    zisc::write(pixel_cost_count_.data(), data_stream,
+                pixel_cost_count_.size() * sizeof(uint32));
+  }
+}
+
+/*!
+  \details
+  The relative error is the standard error of the mean
+  divided by the mean, summed over the components of the pixel.
+  */
+Float SampleStatistics::calcRelativeError(const std::size_t pixel_index) const
+    noexcept
+{
+  const uint32 n = sampleCountTable()[pixel_index];
+  if (n < adaptiveSamplingInterval())
+    return std::numeric_limits<Float>::max();
+
+  const auto& mean_table = meanTable();
+  const auto& squared_deviation_table = squaredDeviationTable();
+  const Float inv_n = zisc::invert(zisc::cast<Float>(n));
+  Float mean = 0.0;
+  Float variance = 0.0;
+  for (uint i = 0; i < mean_table.numOfBins(); ++i) {
+    mean += mean_table.get(pixel_index, i);
+    variance += inv_n * squared_deviation_table.get(pixel_index, i);
+  }
+  constexpr Float e = std::numeric_limits<Float>::epsilon();
+  const Float error = zisc::sqrt(inv_n * variance) / zisc::max(mean, e);
+  return error;
+}
+
+/*!
+  */
+void SampleStatistics::clearPixel(const std::size_t pixel_index) noexcept
+{
+  const std::size_t p = pixel_index;
+  const auto zero = zisc::cast<FilmFloat>(0.0);
+
+  // Sample
+  sampleTable().fill(p, p + 1, 0.0);
 
-    sample_squared_.reserve(size);
-    init_distribution_table(size, true, sample_squared_);
+  if (isEnabled(Type::kVariance)) {
+    meanTable().fill(p, p + 1, 0.0);
+    squaredDeviationTable().fill(p, p + 1, 0.0);
   }
 
   if (isEnabled(Type::kBayesianCollaborativeValues)) {
-    const uint32 bins = (system.colorMode() == RenderingColorMode::kRgb)
-        ? zisc::cast<const RgbBcDenoiser*>(&system.denoiser())->histogramBins()
-        : zisc::cast<const SpectraBcDenoiser*>(&system.denoiser())->histogramBins();
+    // Histogram
+    histogramTable().clear(p * histogram_bins_, (p + 1) * histogram_bins_);
+
+    // Covariance matrix factor
+    const std::size_t f = numOfCovarianceFactors() * p;
+    for (std::size_t i = f; i < (f + numOfCovarianceFactors()); ++i)
+      covariance_factor_[i] = zero;
+  }
+
+  if (isEnabled(Type::kDenoisedExpectedValue)) {
+    // Denoised sample
+    denoisedSampleTable().fill(p, p + 1, 0.0);
+  }
+
+  if (isEnabled(Type::kSampleCount)) {
+    // Sample count
+    sample_count_[p] = 0;
+    active_pixel_[p] = kTrue;
+  }
+
+  if (isEnabled(Type::kFirstHitFeatures)) {
+    // First hit features
+    for (std::size_t i = 3 * p; i < 3 * (p + 1); ++i)
+      first_hit_normal_[i] = zero;
+    first_hit_albedo_[p] = zero;
+    first_hit_depth_[p] = zero;
+    first_hit_count_[p] = 0;
+  }
 
-    const std::size_t s = size * bins;
-    histogram_.reserve(s);
-    init_distribution_table(s, false, histogram_);
+  if (isEnabled(Type::kPixelCost)) {
+    for (std::size_t i = 3 * p; i < 3 * (p + 1); ++i)
+      pixel_cost_[i] = 0;
+    pixel_cost_count_[p] = 0;
+  }
+}
+
+/*!
+  \details
+  The relative errors of a pixel grid of at most 4096 pixels are averaged,
+  so the estimate is cheap enough to be reported each cycle.
+  The number of samples of a pixel is the cycles
+  unless the sample count is enabled. The estimate is zero
+  if the variance isn't enabled.
+  */
+Float SampleStatistics::estimateRelativeError(const uint32 cycle) const noexcept
+{
+  if (!isEnabled(Type::kVariance) || (cycle < 2))
+    return 0.0;
+
+  constexpr std::size_t max_num_of_pixels = 4096;
+  const std::size_t size = resolution_[0] * resolution_[1];
+  const std::size_t stride = zisc::max(size / max_num_of_pixels, std::size_t{1});
+  const bool count_is_enabled = isEnabled(Type::kSampleCount);
+  const auto& mean_table = meanTable();
+  const auto& squared_deviation_table = squaredDeviationTable();
+
+  Float error = 0.0;
+  std::size_t num_of_pixels = 0;
+  for (std::size_t pixel_index = 0; pixel_index < size; pixel_index += stride) {
+    const uint32 n = count_is_enabled ? sampleCountTable()[pixel_index] : cycle;
+    if (isStale(pixel_index) || (n < 2))
+      continue;
+    const Float inv_n = zisc::invert(zisc::cast<Float>(n));
+    Float mean = 0.0;
+    Float variance = 0.0;
+    for (uint i = 0; i < mean_table.numOfBins(); ++i) {
+      mean += mean_table.get(pixel_index, i);
+      variance += inv_n * squared_deviation_table.get(pixel_index, i);
+    }
+    // The black pixels have no relative error
+    constexpr Float e = std::numeric_limits<Float>::epsilon();
+    if (e < mean) {
+      error += zisc::sqrt(inv_n * variance) / mean;
+      ++num_of_pixels;
+    }
+  }
+  return (0 < num_of_pixels) ? error / zisc::cast<Float>(num_of_pixels) : 0.0;
+}
+
+/*!
+  */
+void SampleStatistics::fillSpectralTables(const std::size_t begin,
+                                          const std::size_t end) noexcept
+{
+  if (isEnabled(Type::kExpectedValue))
+    sampleTable().fill(begin, end, 0.0);
+
+  if (isEnabled(Type::kVariance)) {
+    meanTable().fill(begin, end, 0.0);
+    squaredDeviationTable().fill(begin, end, 0.0);
+  }
+
+  if (isEnabled(Type::kBayesianCollaborativeValues))
+    histogramTable().clear(begin * histogram_bins_, end * histogram_bins_);
+
+  if (isEnabled(Type::kDenoisedExpectedValue))
+    denoisedSampleTable().fill(begin, end, 0.0);
+}
+
+/*!
+  \details
+  The spectral tables are allocated without writing and are filled by
+  the threads in bands of the rows of the rendering tiles,
+  so the pages of a band are first touched by a thread
+  (placed on its NUMA node) instead of the main thread.
+  The small per-pixel tables are initialized on the main thread.
+  */
+void SampleStatistics::initialize(System& system) noexcept
+{
+  const std::size_t size = resolution_[0] * resolution_[1];
+  const auto color_mode = system.colorMode();
+
+  for (auto& weight : sensor_response_)
+    weight.fill(0.0);
+
+  if (isEnabled(Type::kExpectedValue)) {
+    const auto sample_mode = isXyzTable() ? RenderingColorMode::kRgb : color_mode;
+    sample_.initialize(sample_mode, size);
+  }
+
+  if (isEnabled(Type::kVariance)) {
+    mean_.initialize(color_mode, size);
+    squared_deviation_.initialize(color_mode, size);
+  }
+
+  if (isEnabled(Type::kBayesianCollaborativeValues)) {
+    // The denoiser is instantiated in either precision
+    const Denoiser* denoiser = &system.denoiser();
+    if (system.colorMode() == RenderingColorMode::kRgb) {
+      const auto d = dynamic_cast<const RgbBcDenoiser*>(denoiser);
+      histogram_bins_ = (d != nullptr)
+          ? d->histogramBins()
+          : zisc::cast<const RgbFloatBcDenoiser*>(denoiser)->histogramBins();
+    }
+    else {
+      const auto d = dynamic_cast<const SpectraBcDenoiser*>(denoiser);
+      histogram_bins_ = (d != nullptr)
+          ? d->histogramBins()
+          : zisc::cast<const SpectraFloatBcDenoiser*>(denoiser)->histogramBins();
+    }
+    histogram_.initialize(color_mode, size * histogram_bins_);
   }
 
   if (isEnabled(Type::kBayesianCollaborativeValues)) {
@@ -183,35 +795,115 @@ void SampleStatistics::initialize(System& system) noexcept
     covariance_factor_.resize(s);
   }
 
-  if (isEnabled(Type::kDenoisedExpectedValue)) {
-    denoised_sample_.reserve(size);
-    init_distribution_table(size, false, denoised_sample_);
+  if (isEnabled(Type::kDenoisedExpectedValue))
+    denoised_sample_.initialize(color_mode, size);
+
+  if (isEnabled(Type::kSampleCount)) {
+    sample_count_.resize(size, 0u);
+    active_pixel_.resize(size, kTrue);
+  }
+
+  if (isEnabled(Type::kFirstHitFeatures)) {
+    first_hit_normal_.resize(3 * size, zisc::cast<FilmFloat>(0.0));
+    first_hit_albedo_.resize(size, zisc::cast<FilmFloat>(0.0));
+    first_hit_depth_.resize(size, zisc::cast<FilmFloat>(0.0));
+    first_hit_count_.resize(size, 0u);
+  }
+
+  if (isEnabled(Type::kPixelCost)) {
+    pixel_cost_.resize(3 * size, 0u);
+    pixel_cost_count_.resize(size, 0u);
+  }
+
+  pixel_epoch_.resize(size, epoch_);
+
+  // Fill the spectral tables in parallel
+  {
+    constexpr uint band_height = CoreConfig::sizeOfRenderingTileSide();
+    const std::size_t width = zisc::cast<std::size_t>(resolution_[0]);
+    const uint num_of_bands = (resolution_[1] + band_height - 1) / band_height;
+    auto fill_bands = [this, &system, width, num_of_bands](const uint task_id)
+    {
+      const auto range = system.calcTaskRange(num_of_bands, task_id);
+      const uint height = resolution_[1];
+      const std::size_t begin = width * zisc::min(range[0] * band_height, height);
+      const std::size_t end = width * zisc::min(range[1] * band_height, height);
+      if (begin < end)
+        fillSpectralTables(begin, end);
+    };
+
+    auto& threads = system.threadManager();
+    auto& work_resource = system.globalMemoryManager();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(fill_bands, start, end, &work_resource);
+    result.wait();
+  }
+}
+
+/*!
+  \details
+  The value of the cycle is calculated from the sum and the mean
+  before the moments are updated.
+  */
+IntensitySamples SampleStatistics::calcCycleValues(
+    const CycleIndices& indices,
+    const std::size_t pixel_index,
+    const uint32 n) const noexcept
+{
+  const auto& sample_table = sampleTable();
+  const auto& mean_table = meanTable();
+  const Float k = zisc::cast<Float>(n - 1);
+
+  IntensitySamples values;
+  for (uint i = 0; i < indices.bin_list_.size(); ++i) {
+    const uint si = indices.bin_list_[i];
+    values[i] = sample_table.get(pixel_index, si) -
+                k * mean_table.get(pixel_index, si);
+  }
+  return values;
+}
+
+/*!
+  \details
+  The factor of a pair of bins i < j is at getFactorIndex(i) + (j - i - 1).
+  */
+auto SampleStatistics::makeCycleIndices(const WavelengthSamples& wavelengths) const
+    noexcept -> CycleIndices
+{
+  const auto& sample_table = sampleTable();
+  CycleIndices indices;
+  for (uint i = 0; i < wavelengths.size(); ++i)
+    indices.bin_list_[i] = sample_table.getIndex(wavelengths[i]);
+  for (uint pair = 0, i = 0; i < (wavelengths.size() - 1); ++i) {
+    const uint si_a = indices.bin_list_[i];
+    const uint base_index = getFactorIndex(si_a);
+    for (uint j = i + 1; j < wavelengths.size(); ++pair, ++j) {
+      const uint si_b = indices.bin_list_[j];
+      indices.factor_list_[pair] = base_index + ((si_b - si_a) - 1);
+    }
   }
+  return indices;
 }
 
 /*!
+  \details
+  The products are summed in the film precision without a compensation,
+  which halves the memory of the factors and their traffic in every cycle.
+  The rounding error of a sum is far below the noise which it estimates.
   */
 void SampleStatistics::updateCovarianceFactor(
-    const WavelengthSamples& wavelengths,
+    const CycleIndices& indices,
+    const IntensitySamples& values,
     const std::size_t pixel_index) noexcept
 {
-  const auto& sample_p = sampleTable()[pixel_index];
-  const auto& prev_sample_p = prevSampleTable()[pixel_index];
   auto factors = &covarianceFactorTable()[numOfCovarianceFactors() * pixel_index];
 
-  for (uint i = 0; i < wavelengths.size() - 1; ++i) {
-    const auto w_a = wavelengths[i];
-    const uint si_a = sample_p->getIndex(w_a);
-    const Float s_a = sample_p->get(si_a) - prev_sample_p->get(si_a);
-
-    const uint base_index = getFactorIndex(si_a);
-    for (uint j = i + 1; j < wavelengths.size(); ++j) {
-      const auto w_b = wavelengths[j];
-      const uint si_b = sample_p->getIndex(w_b);
-      const Float s_b = sample_p->get(si_b) - prev_sample_p->get(si_b);
-
-      const uint offset = base_index + ((si_b - si_a) - 1);
-      factors[offset].add(s_a * s_b);
+  for (uint pair = 0, i = 0; i < (values.size() - 1); ++i) {
+    const Float s_a = values[i];
+    for (uint j = i + 1; j < values.size(); ++pair, ++j) {
+      const Float s_b = values[j];
+      factors[indices.factor_list_[pair]] += zisc::cast<FilmFloat>(s_a * s_b);
     }
   }
 }
@@ -220,23 +912,19 @@ void SampleStatistics::updateCovarianceFactor(
   */
 void SampleStatistics::updateHistogram(
     const System& system,
-    const WavelengthSamples& wavelengths,
+    const CycleIndices& indices,
+    const IntensitySamples& values,
     const std::size_t pixel_index) noexcept
 {
-  const auto& sample_p = sampleTable()[pixel_index];
-  const auto& prev_sample_p = prevSampleTable()[pixel_index];
+  auto& histogram_table = histogramTable();
+  const auto& tone_map = system.toneMappingOperator();
+  const uint32 bins = histogram_bins_;
 
-  const uint32 bins = (system.colorMode() == RenderingColorMode::kRgb)
-      ? zisc::cast<const RgbBcDenoiser*>(&system.denoiser())->histogramBins()
-      : zisc::cast<const SpectraBcDenoiser*>(&system.denoiser())->histogramBins();
-
-  for (uint i = 0; i < wavelengths.size(); ++i) {
-    const auto w = wavelengths[i];
-    const uint si = sample_p->getIndex(w);
+  for (uint i = 0; i < indices.bin_list_.size(); ++i) {
+    const uint si = indices.bin_list_[i];
 
     constexpr Float e = std::numeric_limits<Float>::epsilon();
-    const auto& tone_map = system.toneMappingOperator();
-    Float s = sample_p->get(si) - prev_sample_p->get(si);
+    Float s = values[i];
     s = tone_map.tonemap(s);
     s = zisc::clamp(s, 0.0, 1.0 - e);
     s = zisc::cast<Float>(bins - 1) * s;
@@ -245,51 +933,37 @@ void SampleStatistics::updateHistogram(
     const Float a = s - zisc::cast<Float>(h_low);
     ZISC_ASSERT(zisc::isInBounds(h_low, 0u, bins - 1), "The low is out of bounds.");
     ZISC_ASSERT(zisc::isInBounds(a, 0.0, 1.0), "The a is out of bounds.");
-    // Histogram low
-    {
-      auto& histogram = histogramTable()[pixel_index * bins + h_low];
-      histogram->add(si, 1.0 - a);
-    }
-    // Histogram high
-    {
-      auto& histogram = histogramTable()[pixel_index * bins + h_low + 1];
-      histogram->add(si, a);
-    }
+    // Histogram low and high, the counts of a sample sum up to one exactly
+    const std::size_t row = pixel_index * bins + h_low;
+    const auto low_count = SpectralCountTable::toCount(1.0 - a);
+    const auto high_count = SpectralCountTable::countResolution() - low_count;
+    histogram_table.add(row, si, low_count);
+    histogram_table.add(row + 1, si, high_count);
   }
 }
 
 /*!
+  \details
+  Welford's online algorithm:
+  mean_n = mean_(n-1) + (x - mean_(n-1)) / n,
+  M2_n = M2_(n-1) + (x - mean_(n-1)) * (x - mean_n).
   */
-void SampleStatistics::updatePrevSample(
-    const WavelengthSamples& wavelengths,
-    const std::size_t pixel_index) noexcept
-{
-  const auto& sample_p = sampleTable()[pixel_index];
-  const auto& prev_sample_p = prevSampleTable()[pixel_index];
-
-  for (uint i = 0; i < wavelengths.size(); ++i) {
-    const auto w = wavelengths[i];
-    const uint si = sample_p->getIndex(w);
-    const Float s = sample_p->get(si);
-    prev_sample_p->set(si, s);
-  }
-}
-
-/*!
-  */
-void SampleStatistics::updateSampleSquared(
-    const WavelengthSamples& wavelengths,
-    const std::size_t pixel_index) noexcept
+void SampleStatistics::updateMoments(const std::size_t pixel_index,
+                                     const uint32 n) noexcept
 {
-  const auto& sample_p = sampleTable()[pixel_index];
-  const auto& prev_sample_p = prevSampleTable()[pixel_index];
-  auto& sample_squared_p = sampleSquaredTable()[pixel_index];
-
-  for (uint i = 0; i < wavelengths.size(); ++i) {
-    const auto w = wavelengths[i];
-    const uint si = sample_p->getIndex(w);
-    const Float s = sample_p->get(si) - prev_sample_p->get(si);
-    sample_squared_p->add(si, zisc::power<2>(s));
+  const auto& sample_table = sampleTable();
+  auto& mean_table = meanTable();
+  auto& squared_deviation_table = squaredDeviationTable();
+  const Float k = zisc::cast<Float>(n - 1);
+  const Float inv_n = zisc::invert(zisc::cast<Float>(n));
+
+  for (uint si = 0; si < sample_table.numOfBins(); ++si) {
+    const Float mean = mean_table.get(pixel_index, si);
+    const Float x = sample_table.get(pixel_index, si) - k * mean;
+    const Float delta = x - mean;
+    const Float next_mean = mean + inv_n * delta;
+    mean_table.set(pixel_index, si, next_mean);
+    squared_deviation_table.add(pixel_index, si, delta * (x - next_mean));
   }
 }
 
@@ -11,21 +11,28 @@
 #define NANAIRO_SAMPLE_STATISTICS_HPP
 
 // Standard C++ library
+#include <array>
 #include <bitset>
+#include <istream>
+#include <ostream>
 #include <vector>
 // Zisc
-#include "zisc/compensated_summation.hpp"
+#include "zisc/arith_array.hpp"
 #include "zisc/memory_resource.hpp"
-#include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
-#include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
+#include "NanairoCore/Color/spectral_count_table.hpp"
+#include "NanairoCore/Color/spectral_table.hpp"
+#include "NanairoCore/Color/xyz_color_matching_function.hpp"
 #include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
 
 namespace nanairo {
 
 // Forward declaration
+class OutOfCoreMemoryResource;
+class RenderingTile;
 class SampledSpectra;
 class WavelengthSamples;
 
@@ -33,6 +40,11 @@ class WavelengthSamples;
 //! \{
 
 /*!
+  \details
+  The statistics are cleared lazily. A clear increments the epoch,
+  and a pixel of an old epoch is cleared when a value is added to it
+  or at the update of the cycle, so the GUI can restart rendering
+  without filling the whole film. The tables have to be read after the update.
   */
 class SampleStatistics
 {
@@ -44,10 +56,11 @@ class SampleStatistics
     kVariance,
     kBayesianCollaborativeValues,
     kDenoisedExpectedValue,
+    kSampleCount,
+    kFirstHitFeatures,
+    kPixelCost,
   };
 
-  using SpectralDistributionPointer =
-      SpectralDistribution::SpectralDistributionPointer;
   using Flag = System::SampleStatisticsFlag;
 
 
@@ -55,27 +68,71 @@ class SampleStatistics
   SampleStatistics(System& system) noexcept;
 
 
+  //! Return the cycle interval of the adaptive sampling update
+  static constexpr uint32 adaptiveSamplingInterval() noexcept;
+
+  //! Add the features of the first hit of a camera path
+  void addFirstHitFeature(const Index2d position,
+                          const Vector3& normal,
+                          const SampledSpectra& albedo,
+                          const Float depth) noexcept;
+
+  //! Add the traversal and time cost of a camera path
+  void addPixelCost(const Index2d position,
+                    const uint64 num_of_visits,
+                    const uint64 num_of_tests,
+                    const uint64 num_of_cycles) noexcept;
+
   //! Add a sample
   void addSample(const Index2d position,
                  const SampledSpectra& sample) noexcept;
 
+  //! Add a sample of the wavelengths which aren't the wavelengths of the cycle
+  void addSample(const Index2d position,
+                 const SampledSpectra& sample,
+                 const XyzColorMatchingFunction::SensorResponse& response) noexcept;
+
   //! Clear samples
   void clear() noexcept;
 
-  //! Return the covariance factor
-  zisc::pmr::vector<zisc::CompensatedSummation<Float>>& covarianceFactorTable()
-      noexcept;
+  //! Return the sums of the products of the values of the wavelength pairs
+  zisc::pmr::vector<FilmFloat>& covarianceFactorTable() noexcept;
 
-  //! Return the covariance factor
-  const zisc::pmr::vector<zisc::CompensatedSummation<Float>>& covarianceFactorTable()
-      const noexcept;
+  //! Return the sums of the products of the values of the wavelength pairs
+  const zisc::pmr::vector<FilmFloat>& covarianceFactorTable() const noexcept;
 
   //! Return the denoised sample
-  zisc::pmr::vector<SpectralDistributionPointer>& denoisedSampleTable() noexcept;
+  SpectralValueTable& denoisedSampleTable() noexcept;
 
   //! Return the denoised sample
-  const zisc::pmr::vector<SpectralDistributionPointer>& denoisedSampleTable()
-      const noexcept;
+  const SpectralValueTable& denoisedSampleTable() const noexcept;
+
+  //! Estimate the mean relative error of the pixels from a subset of them
+  Float estimateRelativeError(const uint32 cycle) const noexcept;
+
+  //! Return the sum of the first hit albedos, the mean over the wavelengths
+  zisc::pmr::vector<FilmFloat>& firstHitAlbedoTable() noexcept;
+
+  //! Return the sum of the first hit albedos, the mean over the wavelengths
+  const zisc::pmr::vector<FilmFloat>& firstHitAlbedoTable() const noexcept;
+
+  //! Return the number of the first hit features of each pixel
+  zisc::pmr::vector<uint32>& firstHitCountTable() noexcept;
+
+  //! Return the number of the first hit features of each pixel
+  const zisc::pmr::vector<uint32>& firstHitCountTable() const noexcept;
+
+  //! Return the sum of the first hit distances from the camera
+  zisc::pmr::vector<FilmFloat>& firstHitDepthTable() noexcept;
+
+  //! Return the sum of the first hit distances from the camera
+  const zisc::pmr::vector<FilmFloat>& firstHitDepthTable() const noexcept;
+
+  //! Return the sum of the first hit normals, [pixel][xyz]
+  zisc::pmr::vector<FilmFloat>& firstHitNormalTable() noexcept;
+
+  //! Return the sum of the first hit normals, [pixel][xyz]
+  const zisc::pmr::vector<FilmFloat>& firstHitNormalTable() const noexcept;
 
   //! Return the index of covariance factor
   uint getFactorIndex(const uint i) const noexcept;
@@ -83,78 +140,173 @@ class SampleStatistics
   //! Return the index of table correspond to the given position
   uint getIndex(const Index2d position) const noexcept;
 
+  //! Check if the pixel still needs samples
+  bool isActive(const Index2d position) const noexcept;
+
   //! Check if the given sample type is enabled
   bool isEnabled(const Type type) const noexcept;
 
   //! Return the histogram
-  zisc::pmr::vector<SpectralDistributionPointer>& histogramTable() noexcept;
+  SpectralCountTable& histogramTable() noexcept;
 
   //! Return the histogram
-  const zisc::pmr::vector<SpectralDistributionPointer>& histogramTable()
-      const noexcept;
+  const SpectralCountTable& histogramTable() const noexcept;
+
+  //! Return the mean of the values of the cycles
+  SpectralValueTable& meanTable() noexcept;
+
+  //! Return the mean of the values of the cycles
+  const SpectralValueTable& meanTable() const noexcept;
+
+  //! Merge the statistics which are sampled independently
+  void merge(System& system,
+             const SampleStatistics& other,
+             const uint32 cycle,
+             const uint32 other_cycle) noexcept;
 
   //! Return the number of covariance factors
   uint numOfCovarianceFactors() const noexcept;
 
-  //! Return the sample
-  zisc::pmr::vector<SpectralDistributionPointer>& prevSampleTable() noexcept;
+  //! Check if the sample table has XYZ values instead of spectra
+  bool isXyzTable() const noexcept;
 
-  //! Return the sample
-  const zisc::pmr::vector<SpectralDistributionPointer>& prevSampleTable()
-      const noexcept;
+  //! Return the number of the camera paths of each pixel whose cost is added
+  zisc::pmr::vector<uint32>& pixelCostCountTable() noexcept;
+
+  //! Return the number of the camera paths of each pixel whose cost is added
+  const zisc::pmr::vector<uint32>& pixelCostCountTable() const noexcept;
+
+  //! Return the sum of the costs, [pixel][visits, tests, cycles]
+  zisc::pmr::vector<uint64>& pixelCostTable() noexcept;
+
+  //! Return the sum of the costs, [pixel][visits, tests, cycles]
+  const zisc::pmr::vector<uint64>& pixelCostTable() const noexcept;
+
+  //! Read the statistics from the stream
+  bool readData(std::istream* data_stream) noexcept;
 
   //! Return the resolution
   Index2d resolution() const noexcept;
 
   //! Return the sample
-  zisc::pmr::vector<SpectralDistributionPointer>& sampleTable() noexcept;
+  CompensatedSpectralValueTable& sampleTable() noexcept;
 
   //! Return the sample
-  const zisc::pmr::vector<SpectralDistributionPointer>& sampleTable()
-      const noexcept;
+  const CompensatedSpectralValueTable& sampleTable() const noexcept;
 
-  //! Return the sample
-  zisc::pmr::vector<SpectralDistributionPointer>& sampleSquaredTable() noexcept;
+  //! Return the number of samples of each pixel
+  zisc::pmr::vector<uint32>& sampleCountTable() noexcept;
 
-  //! Return the sample
-  const zisc::pmr::vector<SpectralDistributionPointer>& sampleSquaredTable()
-      const noexcept;
+  //! Return the number of samples of each pixel
+  const zisc::pmr::vector<uint32>& sampleCountTable() const noexcept;
+
+  //! Return the sum of the squared deviations of the values of the cycles (M2)
+  CompensatedSpectralValueTable& squaredDeviationTable() noexcept;
+
+  //! Return the sum of the squared deviations of the values of the cycles (M2)
+  const CompensatedSpectralValueTable& squaredDeviationTable() const noexcept;
+
+  //! Set the wavelengths of the cycle which the samples are added with
+  void setWavelengths(const System& system,
+                      const WavelengthSamples& wavelengths) noexcept;
+
+  //! Record the access of the pixels of the tile in the mapped film
+  void touch(const RenderingTile& tile) const noexcept;
 
   //! Update statistics info
   void update(System& system,
               const WavelengthSamples& wavelengths,
               const uint32 cycle) noexcept;
 
+  //! Deactivate the tiles whose relative error is below the threshold
+  void updateActivePixels(System& system) noexcept;
+
+  //! Write the statistics to the stream
+  void writeData(std::ostream* data_stream) const noexcept;
+
  private:
+  static constexpr uint kNumOfWavelengthPairs =
+      (CoreConfig::wavelengthSampleSize() *
+       (CoreConfig::wavelengthSampleSize() - 1)) / 2;
+
+  /*!
+    \brief The table indices of the wavelengths of a cycle
+    \details
+    All pixels of a cycle have the same wavelengths,
+    so the indices are found once per cycle instead of once per pixel.
+    */
+  struct CycleIndices
+  {
+    std::array<uint, CoreConfig::wavelengthSampleSize()> bin_list_;
+    std::array<uint, kNumOfWavelengthPairs> factor_list_; //!< [pair of i < j]
+  };
+
+
+  //! Calculate the values of the cycle of the sampled wavelengths
+  IntensitySamples calcCycleValues(const CycleIndices& indices,
+                                   const std::size_t pixel_index,
+                                   const uint32 n) const noexcept;
+
+  //! Calculate the relative error of the expected value of the pixel
+  Float calcRelativeError(const std::size_t pixel_index) const noexcept;
+
+  //! Clear the statistics of the pixel
+  void clearPixel(const std::size_t pixel_index) noexcept;
+
+  //! Fill the spectral tables of the pixels [begin, end) by zero
+  void fillSpectralTables(const std::size_t begin, const std::size_t end) noexcept;
+
   //! Initialize statistics
   void initialize(System& system) noexcept;
 
+  //! Check if the pixel has the statistics before the last clear
+  bool isStale(const std::size_t pixel_index) const noexcept;
+
+  //! Find the table indices of the wavelengths of a cycle
+  CycleIndices makeCycleIndices(const WavelengthSamples& wavelengths) const noexcept;
+
+  //! Clear the pixel if it has the statistics before the last clear
+  void refreshPixel(const std::size_t pixel_index) noexcept;
+
   //! Update covariance matrix factors
-  void updateCovarianceFactor(const WavelengthSamples& wavelengths,
+  void updateCovarianceFactor(const CycleIndices& indices,
+                              const IntensitySamples& values,
                               const std::size_t pixel_index) noexcept;
 
   //! Update histogram
   void updateHistogram(const System& system,
-                       const WavelengthSamples& wavelengths,
+                       const CycleIndices& indices,
+                       const IntensitySamples& values,
                        const std::size_t pixel_index) noexcept;
 
-  //! Update previous sample value
-  void updatePrevSample(const WavelengthSamples& wavelengths,
-                        const std::size_t pixel_index) noexcept;
-
-  //! Update sample squared value
-  void updateSampleSquared(const WavelengthSamples& wavelengths,
-                           const std::size_t pixel_index) noexcept;
-
-
-  zisc::pmr::vector<SpectralDistributionPointer> sample_;
-  zisc::pmr::vector<SpectralDistributionPointer> prev_sample_;
-  zisc::pmr::vector<SpectralDistributionPointer> sample_squared_;
-  zisc::pmr::vector<SpectralDistributionPointer> histogram_;
-  zisc::pmr::vector<zisc::CompensatedSummation<Float>> covariance_factor_;
-  zisc::pmr::vector<SpectralDistributionPointer> denoised_sample_;
+  //! Update the mean and the squared deviation by Welford's algorithm
+  void updateMoments(const std::size_t pixel_index, const uint32 n) noexcept;
+
+
+  CompensatedSpectralValueTable sample_;
+  SpectralValueTable mean_;
+  CompensatedSpectralValueTable squared_deviation_;
+  SpectralCountTable histogram_; //!< [pixel][histogram bin] rows
+  zisc::pmr::vector<FilmFloat> covariance_factor_;
+  SpectralValueTable denoised_sample_;
+  zisc::pmr::vector<uint32> sample_count_;
+  zisc::pmr::vector<uint8> active_pixel_;
+  zisc::pmr::vector<FilmFloat> first_hit_normal_;
+  zisc::pmr::vector<FilmFloat> first_hit_albedo_;
+  zisc::pmr::vector<FilmFloat> first_hit_depth_;
+  zisc::pmr::vector<uint32> first_hit_count_;
+  zisc::pmr::vector<uint64> pixel_cost_;
+  zisc::pmr::vector<uint32> pixel_cost_count_;
+  zisc::pmr::vector<uint32> pixel_epoch_; //!< The clear epoch of the pixels
+  XyzColorMatchingFunction::SensorResponse sensor_response_; //!< The CMF of the wavelengths
+  OutOfCoreMemoryResource* film_resource_; //!< Null unless the film is mapped
   Index2d resolution_;
   Flag flag_;
+  uint32 histogram_bins_;
+  uint32 epoch_; //!< The number of clears
+  uint8 has_stale_pixels_;
+  uint8 is_xyz_table_;
+  Float sample_weight_; //!< The inverse of the samples per cycle
 };
 
 //! \}
@@ -130,10 +130,14 @@ class SampledSpectra
   const WavelengthSamples& wavelengths() const noexcept;
 
  private:
-  IntensitySamples intensities_;
+  alignas(CoreConfig::intensitySamplesAlignment()) IntensitySamples intensities_;
   const WavelengthSamples* wavelengths_;
 };
 
+static_assert(sizeof(IntensitySamples) ==
+                  CoreConfig::wavelengthSampleSize() * sizeof(Float),
+              "The intensities aren't a fixed size array.");
+
 //! Multiply each sample with a scalar
 SampledSpectra operator*(const Float scalar,
                          const SampledSpectra& samples) noexcept;
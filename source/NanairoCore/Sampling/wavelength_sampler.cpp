@@ -93,10 +93,13 @@ SampledWavelengths WavelengthSampler::sampleRandomly(
   constexpr Float inverse_probability = cast<Float>(CoreConfig::spectraSize()) /
                                         cast<Float>(sample_size);
 
+  std::array<Float, sample_size> offset_list;
+  sampler.draw1DN(path_state, sample_size, offset_list.data());
+  path_state.setDimension(path_state.dimension() + sample_size);
+
   std::array<uint16, sample_size> wavelengths;
   for (uint i = 0; i < sample_size; ++i) {
-    const Float offset = sampler.draw1D(path_state);
-    path_state.setDimension(path_state.dimension() + 1);
+    const Float offset = offset_list[i];
     const Float position = cast<Float>(CoreConfig::spectraSize()) * offset;
     const uint index = cast<uint>(position);
     const uint16 wavelength = getWavelength(index);
@@ -149,10 +152,13 @@ SampledWavelengths WavelengthSampler::sampleStratified(
                              cast<Float>(sample_size);
   constexpr Float inverse_probability = interval;
 
+  std::array<Float, sample_size> offset_list;
+  sampler.draw1DN(path_state, sample_size, offset_list.data());
+  path_state.setDimension(path_state.dimension() + sample_size);
+
   SampledWavelengths sampled_wavelengths;
   for (uint i = 0; i < sample_size; ++i) {
-    const Float offset = sampler.draw1D(path_state);
-    path_state.setDimension(path_state.dimension() + 1);
+    const Float offset = offset_list[i];
     const Float position = interval * (cast<Float>(i) + offset);
     const uint index = cast<uint>(position);
     const uint16 wavelength = getWavelength(index);
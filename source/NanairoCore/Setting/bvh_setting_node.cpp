@@ -12,6 +12,7 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <string_view>
 // Zisc
 #include "zisc/binary_data.hpp"
 #include "zisc/error.hpp"
@@ -41,10 +42,31 @@ void AgglomerativeTreeletRestructuringParameters::writeData(
   zisc::write(&optimization_loop_, data_stream);
 }
 
+/*!
+  */
+void BinnedSahParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&num_of_bins_, data_stream);
+  zisc::read(&spatial_split_, data_stream);
+  zisc::read(&split_budget_, data_stream);
+  zisc::read(&max_num_of_leaf_objects_, data_stream);
+}
+
+/*!
+  */
+void BinnedSahParameters::writeData(std::ostream* data_stream) const noexcept
+{
+  zisc::write(&num_of_bins_, data_stream);
+  zisc::write(&spatial_split_, data_stream);
+  zisc::write(&split_budget_, data_stream);
+  zisc::write(&max_num_of_leaf_objects_, data_stream);
+}
+
 /*!
   */
 BvhSettingNode::BvhSettingNode(const SettingNodeBase* parent) noexcept :
-    SettingNodeBase(parent)
+    SettingNodeBase(parent),
+    cache_directory_{dataResource()}
 {
 }
 
@@ -72,6 +94,31 @@ BvhSettingNode::agglomerativeTreeletRestructuringParameters() const noexcept
   return *parameter;
 }
 
+/*!
+  */
+BinnedSahParameters& BvhSettingNode::binnedSahParameters() noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kBinnedSah, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<BinnedSahParameters*>(parameters_.get());
+  return *parameter;
+}
+
+/*!
+  */
+const BinnedSahParameters& BvhSettingNode::binnedSahParameters() const noexcept
+{
+  ZISC_ASSERT(bvhType() == BvhType::kBinnedSah, "Invalid BVH type is specified.");
+  auto parameter = zisc::cast<const BinnedSahParameters*>(parameters_.get());
+  return *parameter;
+}
+
+/*!
+  */
+BvhLayoutType BvhSettingNode::bvhLayoutType() const noexcept
+{
+  return bvh_layout_type_;
+}
+
 /*!
   */
 BvhType BvhSettingNode::bvhType() const noexcept
@@ -79,11 +126,51 @@ BvhType BvhSettingNode::bvhType() const noexcept
   return bvh_type_;
 }
 
+/*!
+  */
+std::string_view BvhSettingNode::cacheDirectory() const noexcept
+{
+  return std::string_view{cache_directory_};
+}
+
 /*!
   */
 void BvhSettingNode::initialize() noexcept
 {
   setBvhType(BvhType::kBinaryRadixTree);
+  setBvhLayoutType(BvhLayoutType::kBinary);
+  setInstancing(false);
+  setLargeObjectSeparation(false);
+  setExtendedMortonCode(false);
+  setProxyGeometry(false);
+}
+
+/*!
+  */
+bool BvhSettingNode::isExtendedMortonCodeEnabled() const noexcept
+{
+  return extended_morton_code_ == kTrue;
+}
+
+/*!
+  */
+bool BvhSettingNode::isInstancingEnabled() const noexcept
+{
+  return instancing_ == kTrue;
+}
+
+/*!
+  */
+bool BvhSettingNode::isLargeObjectSeparationEnabled() const noexcept
+{
+  return large_object_separation_ == kTrue;
+}
+
+/*!
+  */
+bool BvhSettingNode::isProxyGeometryEnabled() const noexcept
+{
+  return proxy_geometry_ == kTrue;
 }
 
 /*!
@@ -101,10 +188,22 @@ void BvhSettingNode::readData(std::istream* data_stream) noexcept
     zisc::read(&bvh_type_, data_stream);
     setBvhType(bvh_type_);
   }
+  zisc::read(&bvh_layout_type_, data_stream);
+  zisc::read(&instancing_, data_stream);
+  zisc::read(&large_object_separation_, data_stream);
+  zisc::read(&extended_morton_code_, data_stream);
+  zisc::read(&proxy_geometry_, data_stream);
   if (parameters_)
     parameters_->readData(data_stream);
 }
 
+/*!
+  */
+void BvhSettingNode::setBvhLayoutType(const BvhLayoutType layout_type) noexcept
+{
+  bvh_layout_type_ = layout_type;
+}
+
 /*!
   */
 void BvhSettingNode::setBvhType(const BvhType type) noexcept
@@ -118,12 +217,51 @@ void BvhSettingNode::setBvhType(const BvhType type) noexcept
         zisc::UniqueMemoryPointer<AgglomerativeTreeletRestructuringParameters>::make(dataResource());
     break;
    }
+   case BvhType::kBinnedSah: {
+    parameters_ = zisc::UniqueMemoryPointer<BinnedSahParameters>::make(dataResource());
+    break;
+   }
    case BvhType::kBinaryRadixTree:
    default:
     break;
   }
 }
 
+/*!
+  */
+void BvhSettingNode::setCacheDirectory(const std::string_view& directory) noexcept
+{
+  cache_directory_ = directory;
+}
+
+/*!
+  */
+void BvhSettingNode::setExtendedMortonCode(const bool extended) noexcept
+{
+  extended_morton_code_ = extended ? kTrue : kFalse;
+}
+
+/*!
+  */
+void BvhSettingNode::setInstancing(const bool instancing) noexcept
+{
+  instancing_ = instancing ? kTrue : kFalse;
+}
+
+/*!
+  */
+void BvhSettingNode::setLargeObjectSeparation(const bool separation) noexcept
+{
+  large_object_separation_ = separation ? kTrue : kFalse;
+}
+
+/*!
+  */
+void BvhSettingNode::setProxyGeometry(const bool proxy) noexcept
+{
+  proxy_geometry_ = proxy ? kTrue : kFalse;
+}
+
 /*!
   */
 SettingNodeType BvhSettingNode::type() const noexcept
@@ -138,6 +276,11 @@ void BvhSettingNode::writeData(std::ostream* data_stream) const noexcept
   writeType(data_stream);
   // Write properties
   zisc::write(&bvh_type_, data_stream);
+  zisc::write(&bvh_layout_type_, data_stream);
+  zisc::write(&instancing_, data_stream);
+  zisc::write(&large_object_separation_, data_stream);
+  zisc::write(&extended_morton_code_, data_stream);
+  zisc::write(&proxy_geometry_, data_stream);
   if (parameters_)
     parameters_->writeData(data_stream);
 }
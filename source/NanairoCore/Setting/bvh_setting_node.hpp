@@ -14,11 +14,14 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <string>
+#include <string_view>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "setting_node_base.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
 
 namespace nanairo {
@@ -41,6 +44,21 @@ struct AgglomerativeTreeletRestructuringParameters : public NodeParameterBase
   uint32 optimization_loop_ = 2;
 };
 
+//! BinnedSah parameters
+struct BinnedSahParameters : public NodeParameterBase
+{
+  //! Read the parameters from the setting
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the setting
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  uint32 num_of_bins_ = 16;
+  uint8 spatial_split_ = kFalse;
+  double split_budget_ = 0.5; //!< The max ratio of the references added by splits
+  uint32 max_num_of_leaf_objects_ = CoreConfig::maxNumOfNodeObjects();
+};
+
 /*!
   */
 class BvhSettingNode : public SettingNodeBase
@@ -58,21 +76,63 @@ class BvhSettingNode : public SettingNodeBase
   const AgglomerativeTreeletRestructuringParameters&
   agglomerativeTreeletRestructuringParameters() const noexcept;
 
+  //! Return the BinnedSah parameters
+  BinnedSahParameters& binnedSahParameters() noexcept;
+
+  //! Return the BinnedSah parameters
+  const BinnedSahParameters& binnedSahParameters() const noexcept;
+
+  //! Return the node layout of the bvh
+  BvhLayoutType bvhLayoutType() const noexcept;
+
   //! Return the bvh type
   BvhType bvhType() const noexcept;
 
+  //! Return the directory of the BVH cache files
+  std::string_view cacheDirectory() const noexcept;
+
   //! Initialize a bvh setting
   void initialize() noexcept override;
 
+  //! Check if the morton codes of the radix trees include the object size
+  bool isExtendedMortonCodeEnabled() const noexcept;
+
+  //! Check if duplicated objects are shared by instancing
+  bool isInstancingEnabled() const noexcept;
+
+  //! Check if the large objects are tested outside of the tree
+  bool isLargeObjectSeparationEnabled() const noexcept;
+
+  //! Check if the simplified proxy geometry is traced in the preview
+  bool isProxyGeometryEnabled() const noexcept;
+
   //! Return the node type
   static SettingNodeType nodeType() noexcept;
 
   //! Read the bvh setting data from the stream
   void readData(std::istream* data_stream) noexcept override;
 
+  //! Set the node layout of the bvh
+  void setBvhLayoutType(const BvhLayoutType layout_type) noexcept;
+
   //! Set the bvh type
   void setBvhType(const BvhType type) noexcept;
 
+  //! Set the directory of the BVH cache files. Empty disables the cache
+  void setCacheDirectory(const std::string_view& directory) noexcept;
+
+  //! Enable the morton codes which include the object size
+  void setExtendedMortonCode(const bool extended) noexcept;
+
+  //! Enable instancing of duplicated objects
+  void setInstancing(const bool instancing) noexcept;
+
+  //! Enable the separation of the large objects from the tree
+  void setLargeObjectSeparation(const bool separation) noexcept;
+
+  //! Enable the simplified proxy geometry of the preview
+  void setProxyGeometry(const bool proxy) noexcept;
+
   //! Return the node type
   SettingNodeType type() const noexcept override;
 
@@ -81,7 +141,13 @@ class BvhSettingNode : public SettingNodeBase
 
  private:
   zisc::UniqueMemoryPointer<NodeParameterBase> parameters_;
+  zisc::pmr::string cache_directory_; //!< A runtime option, which isn't saved
   BvhType bvh_type_;
+  BvhLayoutType bvh_layout_type_;
+  uint8 instancing_;
+  uint8 large_object_separation_;
+  uint8 extended_morton_code_;
+  uint8 proxy_geometry_;
 };
 
 //! \} Core
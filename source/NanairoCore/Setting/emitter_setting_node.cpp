@@ -44,6 +44,23 @@ void NonDirectionalEmitterParameters::writeData(std::ostream* data_stream)
   zisc::write(&color_index_, data_stream);
 }
 
+/*!
+  */
+void EnvironmentEmitterParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&radiance_scale_, data_stream);
+  zisc::read(&color_index_, data_stream);
+}
+
+/*!
+  */
+void EnvironmentEmitterParameters::writeData(std::ostream* data_stream)
+    const noexcept
+{
+  zisc::write(&radiance_scale_, data_stream);
+  zisc::write(&color_index_, data_stream);
+}
+
 /*!
   */
 EmitterSettingNode::EmitterSettingNode(const SettingNodeBase* parent) noexcept :
@@ -59,6 +76,28 @@ EmitterType EmitterSettingNode::emitterType() const noexcept
   return emitter_type_;
 }
 
+/*!
+  */
+EnvironmentEmitterParameters&
+EmitterSettingNode::environmentEmitterParameters() noexcept
+{
+  ZISC_ASSERT(emitterType() == EmitterType::kEnvironment,
+              "Invalid emitter type is specified.");
+  auto parameters = zisc::cast<EnvironmentEmitterParameters*>(parameters_.get());
+  return *parameters;
+}
+
+/*!
+  */
+const EnvironmentEmitterParameters&
+EmitterSettingNode::environmentEmitterParameters() const noexcept
+{
+  ZISC_ASSERT(emitterType() == EmitterType::kEnvironment,
+              "Invalid emitter type is specified.");
+  auto parameters = zisc::cast<const EnvironmentEmitterParameters*>(parameters_.get());
+  return *parameters;
+}
+
 /*!
   */
 void EmitterSettingNode::initialize() noexcept
@@ -131,6 +170,11 @@ void EmitterSettingNode::setEmitterType(const EmitterType type) noexcept
         zisc::UniqueMemoryPointer<NonDirectionalEmitterParameters>::make(dataResource());
     break;
    }
+   case EmitterType::kEnvironment: {
+    parameters_ =
+        zisc::UniqueMemoryPointer<EnvironmentEmitterParameters>::make(dataResource());
+    break;
+   }
    default:
     break;
   }
@@ -41,6 +41,19 @@ struct NonDirectionalEmitterParameters : public NodeParameterBase
   uint32 color_index_ = 0;
 };
 
+//! Environment emitter
+struct EnvironmentEmitterParameters : public NodeParameterBase
+{
+  //! Read the parameters from the stream
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the stream
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  double radiance_scale_ = 1.0;
+  uint32 color_index_ = 0; //!< The equirectangular texture
+};
+
 /*!
   */
 class EmitterSettingNode : public SettingNodeBase
@@ -53,6 +66,13 @@ class EmitterSettingNode : public SettingNodeBase
   //! Return the emitter type
   EmitterType emitterType() const noexcept;
 
+  //! Return the environment emitter parameters
+  EnvironmentEmitterParameters& environmentEmitterParameters() noexcept;
+
+  //! Return the environment emitter parameters
+  const EnvironmentEmitterParameters& environmentEmitterParameters()
+      const noexcept;
+
   //! Initialize a emitter setting
   void initialize() noexcept override;
 
@@ -32,6 +32,11 @@ namespace nanairo {
 void PathTracingParameters::readData(std::istream* data_stream) noexcept
 {
   zisc::read(&eye_path_light_sampler_type_, data_stream);
+  zisc::read(&material_sorting_, data_stream);
+  zisc::read(&path_guiding_, data_stream);
+  zisc::read(&guiding_iterations_, data_stream);
+  zisc::read(&wavelength_batches_, data_stream);
+  zisc::read(&light_solid_angle_sampling_, data_stream);
 }
 
 /*!
@@ -39,6 +44,27 @@ void PathTracingParameters::readData(std::istream* data_stream) noexcept
 void PathTracingParameters::writeData(std::ostream* data_stream) const noexcept
 {
   zisc::write(&eye_path_light_sampler_type_, data_stream);
+  zisc::write(&material_sorting_, data_stream);
+  zisc::write(&path_guiding_, data_stream);
+  zisc::write(&guiding_iterations_, data_stream);
+  zisc::write(&wavelength_batches_, data_stream);
+  zisc::write(&light_solid_angle_sampling_, data_stream);
+}
+
+/*!
+  */
+void WavefrontPathTracingParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&eye_path_light_sampler_type_, data_stream);
+  zisc::read(&ray_sorting_, data_stream);
+}
+
+/*!
+  */
+void WavefrontPathTracingParameters::writeData(std::ostream* data_stream) const noexcept
+{
+  zisc::write(&eye_path_light_sampler_type_, data_stream);
+  zisc::write(&ray_sorting_, data_stream);
 }
 
 /*!
@@ -55,6 +81,26 @@ void LightTracingParameters::writeData(std::ostream* data_stream) const noexcept
   zisc::write(&light_path_light_sampler_type_, data_stream);
 }
 
+/*!
+  */
+void LightVertexCacheBptParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&eye_path_light_sampler_type_, data_stream);
+  zisc::read(&light_path_light_sampler_type_, data_stream);
+  zisc::read(&num_of_light_paths_, data_stream);
+  zisc::read(&num_of_connections_, data_stream);
+}
+
+/*!
+  */
+void LightVertexCacheBptParameters::writeData(std::ostream* data_stream) const noexcept
+{
+  zisc::write(&eye_path_light_sampler_type_, data_stream);
+  zisc::write(&light_path_light_sampler_type_, data_stream);
+  zisc::write(&num_of_light_paths_, data_stream);
+  zisc::write(&num_of_connections_, data_stream);
+}
+
 /*!
   */
 void ProbabilisticPpmParameters::readData(std::istream* data_stream) noexcept
@@ -62,6 +108,11 @@ void ProbabilisticPpmParameters::readData(std::istream* data_stream) noexcept
   zisc::read(&num_of_photons_, data_stream);
   zisc::read(&k_nearest_neighbor_, data_stream);
   zisc::read(&light_path_light_sampler_type_, data_stream);
+  zisc::read(&photon_map_type_, data_stream);
+  zisc::read(&target_photon_time_ratio_, data_stream);
+  zisc::read(&target_cycle_time_, data_stream);
+  zisc::read(&photon_auto_tuning_, data_stream);
+  zisc::read(&visible_point_update_interval_, data_stream);
 }
 
 /*!
@@ -71,6 +122,11 @@ void ProbabilisticPpmParameters::writeData(std::ostream* data_stream) const noex
   zisc::write(&num_of_photons_, data_stream);
   zisc::write(&k_nearest_neighbor_, data_stream);
   zisc::write(&light_path_light_sampler_type_, data_stream);
+  zisc::write(&photon_map_type_, data_stream);
+  zisc::write(&target_photon_time_ratio_, data_stream);
+  zisc::write(&target_cycle_time_, data_stream);
+  zisc::write(&photon_auto_tuning_, data_stream);
+  zisc::write(&visible_point_update_interval_, data_stream);
 }
 
 /*!
@@ -89,6 +145,7 @@ void RenderingMethodSettingNode::initialize() noexcept
   setRayCastEpsilon(0.0000001);
   setRouletteType(RouletteType::kMaxWeight);
   setRoulettePathLength(3);
+  setRouletteMinPathLength(0);
 }
 
 /*!
@@ -113,6 +170,29 @@ RenderingMethodSettingNode::lightTracingParameters() const noexcept
   return *parameters;
 }
 
+/*!
+  */
+LightVertexCacheBptParameters&
+RenderingMethodSettingNode::lightVertexCacheBptParameters() noexcept
+{
+  ZISC_ASSERT(methodType() == RenderingMethodType::kLightVertexCacheBpt,
+              "Invalid method type is specified.");
+  auto parameters = zisc::cast<LightVertexCacheBptParameters*>(parameters_.get());
+  return *parameters;
+}
+
+/*!
+  */
+const LightVertexCacheBptParameters&
+RenderingMethodSettingNode::lightVertexCacheBptParameters() const noexcept
+{
+  ZISC_ASSERT(methodType() == RenderingMethodType::kLightVertexCacheBpt,
+              "Invalid method type is specified.");
+  auto parameters =
+      zisc::cast<const LightVertexCacheBptParameters*>(parameters_.get());
+  return *parameters;
+}
+
 /*!
   */
 SettingNodeType RenderingMethodSettingNode::nodeType() noexcept
@@ -171,6 +251,29 @@ double RenderingMethodSettingNode::rayCastEpsilon() const noexcept
   return ray_cast_epsilon_;
 }
 
+/*!
+  */
+WavefrontPathTracingParameters&
+RenderingMethodSettingNode::wavefrontPathTracingParameters() noexcept
+{
+  ZISC_ASSERT(methodType() == RenderingMethodType::kWavefrontPathTracing,
+              "Invalid method type is specified.");
+  auto parameters = zisc::cast<WavefrontPathTracingParameters*>(parameters_.get());
+  return *parameters;
+}
+
+/*!
+  */
+const WavefrontPathTracingParameters&
+RenderingMethodSettingNode::wavefrontPathTracingParameters() const noexcept
+{
+  ZISC_ASSERT(methodType() == RenderingMethodType::kWavefrontPathTracing,
+              "Invalid method type is specified.");
+  auto parameters =
+      zisc::cast<const WavefrontPathTracingParameters*>(parameters_.get());
+  return *parameters;
+}
+
 /*!
   */
 void RenderingMethodSettingNode::readData(std::istream* data_stream) noexcept
@@ -182,10 +285,18 @@ void RenderingMethodSettingNode::readData(std::istream* data_stream) noexcept
   zisc::read(&ray_cast_epsilon_, data_stream);
   zisc::read(&roulette_type_, data_stream);
   zisc::read(&roulette_path_length_, data_stream);
+  zisc::read(&roulette_min_path_length_, data_stream);
   if (parameters_)
     parameters_->readData(data_stream);
 }
 
+/*!
+  */
+uint32 RenderingMethodSettingNode::rouletteMinPathLength() const noexcept
+{
+  return roulette_min_path_length_;
+}
+
 /*!
   */
 uint32 RenderingMethodSettingNode::roulettePathLength() const noexcept
@@ -221,11 +332,21 @@ void RenderingMethodSettingNode::setMethodType(const RenderingMethodType method_
         zisc::UniqueMemoryPointer<PathTracingParameters>::make(dataResource());
     break;
    }
+   case RenderingMethodType::kWavefrontPathTracing: {
+    parameters_ = zisc::UniqueMemoryPointer<WavefrontPathTracingParameters>::make(
+        dataResource());
+    break;
+   }
    case RenderingMethodType::kLightTracing: {
     parameters_ =
         zisc::UniqueMemoryPointer<LightTracingParameters>::make(dataResource());
     break;
    }
+   case RenderingMethodType::kLightVertexCacheBpt: {
+    parameters_ = zisc::UniqueMemoryPointer<LightVertexCacheBptParameters>::make(
+        dataResource());
+    break;
+   }
    case RenderingMethodType::kProbabilisticPpm: {
     parameters_ = 
         zisc::UniqueMemoryPointer<ProbabilisticPpmParameters>::make(dataResource());
@@ -236,6 +357,14 @@ void RenderingMethodSettingNode::setMethodType(const RenderingMethodType method_
   }
 }
 
+/*!
+  */
+void RenderingMethodSettingNode::setRouletteMinPathLength(
+    const uint32 path_length) noexcept
+{
+  roulette_min_path_length_ = path_length;
+}
+
 /*!
   */
 void RenderingMethodSettingNode::setRoulettePathLength(const uint32 path_length) noexcept
@@ -278,6 +407,7 @@ void RenderingMethodSettingNode::writeData(std::ostream* data_stream)
   zisc::write(&ray_cast_epsilon_, data_stream);
   zisc::write(&roulette_type_, data_stream);
   zisc::write(&roulette_path_length_, data_stream);
+  zisc::write(&roulette_min_path_length_, data_stream);
   if (parameters_)
     parameters_->writeData(data_stream);
 }
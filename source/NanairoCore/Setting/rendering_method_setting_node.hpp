@@ -20,6 +20,7 @@
 // Nanairo
 #include "setting_node_base.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/DataStructure/photon_map.hpp"
 #include "NanairoCore/RenderingMethod/rendering_method.hpp"
 #include "NanairoCore/Sampling/russian_roulette.hpp"
 #include "NanairoCore/Sampling/LightSourceSampler/light_source_sampler.hpp"
@@ -40,6 +41,25 @@ struct PathTracingParameters : public NodeParameterBase
 
   LightSourceSamplerType eye_path_light_sampler_type_ =
       LightSourceSamplerType::kPowerWeighted;
+  uint8 material_sorting_ = kFalse;
+  uint8 path_guiding_ = kFalse;
+  uint32 guiding_iterations_ = 8; //!< The number of the fittings of the guiding
+  uint32 wavelength_batches_ = 1; //!< The number of the batches of a split path
+  uint8 light_solid_angle_sampling_ = kFalse; //!< Sample the triangle lights by the solid angle
+};
+
+// WavefrontPathTracing parameters
+struct WavefrontPathTracingParameters : public NodeParameterBase
+{
+  //! Read the parameters from the stream
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the stream
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  LightSourceSamplerType eye_path_light_sampler_type_ =
+      LightSourceSamplerType::kPowerWeighted;
+  uint8 ray_sorting_ = kFalse;
 };
 
 // LightTracing parameters
@@ -55,6 +75,23 @@ struct LightTracingParameters : public NodeParameterBase
       LightSourceSamplerType::kPowerWeighted;
 };
 
+// LightVertexCacheBPT parameters
+struct LightVertexCacheBptParameters : public NodeParameterBase
+{
+  //! Read the parameters from the stream
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the stream
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  LightSourceSamplerType eye_path_light_sampler_type_ =
+      LightSourceSamplerType::kPowerWeighted;
+  LightSourceSamplerType light_path_light_sampler_type_ =
+      LightSourceSamplerType::kPowerWeighted;
+  uint32 num_of_light_paths_ = 65536;
+  uint32 num_of_connections_ = 2; //!< The connections of a camera vertex
+};
+
 //! ProbabilisticPPM parameters
 struct ProbabilisticPpmParameters : public NodeParameterBase
 {
@@ -65,9 +102,14 @@ struct ProbabilisticPpmParameters : public NodeParameterBase
   void writeData(std::ostream* data_stream) const noexcept override;
 
   uint32 num_of_photons_ = 131072;
-  uint32 k_nearest_neighbor_ = 8;
+  uint32 k_nearest_neighbor_ = 8; //!< 0 gathers all photons in the radius
   LightSourceSamplerType light_path_light_sampler_type_ =
       LightSourceSamplerType::kPowerWeighted;
+  PhotonMapType photon_map_type_ = PhotonMapType::kKdTree;
+  double target_photon_time_ratio_ = 1.0; //!< (photon tracing + construction) / camera pass
+  uint32 target_cycle_time_ = 0; //!< [ms], the ratio is the target if 0
+  uint32 visible_point_update_interval_ = 0; //!< [passes], 0 traces the full paths
+  uint8 photon_auto_tuning_ = kFalse;
 };
 
 /*!
@@ -88,6 +130,12 @@ class RenderingMethodSettingNode : public SettingNodeBase
   //! Return the LightTracing parameters
   const LightTracingParameters& lightTracingParameters() const noexcept;
 
+  //! Return the LightVertexCacheBPT parameters
+  LightVertexCacheBptParameters& lightVertexCacheBptParameters() noexcept;
+
+  //! Return the LightVertexCacheBPT parameters
+  const LightVertexCacheBptParameters& lightVertexCacheBptParameters() const noexcept;
+
   //! Return the node type
   static SettingNodeType nodeType() noexcept;
 
@@ -106,9 +154,18 @@ class RenderingMethodSettingNode : public SettingNodeBase
   //! Return the ray cast epsilon
   double rayCastEpsilon() const noexcept;
 
+  //! Return the WavefrontPathTracing parameters
+  WavefrontPathTracingParameters& wavefrontPathTracingParameters() noexcept;
+
+  //! Return the WavefrontPathTracing parameters
+  const WavefrontPathTracingParameters& wavefrontPathTracingParameters() const noexcept;
+
   //! Read the setting data from the stream
   void readData(std::istream* data_stream) noexcept override;
 
+  //! Return the path length which the weight based roulettes don't terminate
+  uint32 rouletteMinPathLength() const noexcept;
+
   //! Return the roulette path length
   uint32 roulettePathLength() const noexcept;
 
@@ -121,6 +178,9 @@ class RenderingMethodSettingNode : public SettingNodeBase
   //! Set the rendering method type
   void setMethodType(const RenderingMethodType method_type) noexcept;
 
+  //! Set the path length which the weight based roulettes don't terminate
+  void setRouletteMinPathLength(const uint32 path_length) noexcept;
+
   //! Set the roulette path length
   void setRoulettePathLength(const uint32 path_length) noexcept;
 
@@ -142,6 +202,7 @@ class RenderingMethodSettingNode : public SettingNodeBase
   double ray_cast_epsilon_;
   RouletteType roulette_type_;
   uint32 roulette_path_length_;
+  uint32 roulette_min_path_length_;
 };
 
 //! \} Core
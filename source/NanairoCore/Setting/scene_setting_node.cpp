@@ -20,6 +20,7 @@
 #include "zisc/error.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "bvh_setting_node.hpp"
 #include "camera_setting_node.hpp"
@@ -182,38 +183,45 @@ void SceneSettingNode::readData(std::istream* data_stream) noexcept
 
   // Child nodes
   // System
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kSystem == t, "The stream header is wrong.");
-  systemSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kSystem, systemSettingNode(), data_stream);
   // Rendering method
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kRenderingMethod == t, "The stream header is wrong.");
-  renderingMethodSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kRenderingMethod, renderingMethodSettingNode(),
+                data_stream);
   // Texture model
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kTextureModel == t, "The stream header is wrong.");
-  textureModelSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kTextureModel, textureModelSettingNode(),
+                data_stream);
   // Surface model
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kSurfaceModel == t, "The stream header is wrong.");
-  surfaceModelSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kSurfaceModel, surfaceModelSettingNode(),
+                data_stream);
   // Emitter model
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kEmitterModel == t, "The stream header is wrong.");
-  emitterModelSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kEmitterModel, emitterModelSettingNode(),
+                data_stream);
   // Object
   // Camera
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kObjectModel == t, "The stream header is wrong.");
-  cameraSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kObjectModel, cameraSettingNode(), data_stream);
   // Objects
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kObjectModel == t, "The stream header is wrong.");
-  objectSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kObjectModel, objectSettingNode(), data_stream);
   // BVH
-  zisc::read(&t, data_stream);
-  ZISC_ASSERT(SettingNodeType::kBvh == t, "The stream header is wrong.");
-  bvhSettingNode()->readData(data_stream);
+  readChildNode(SettingNodeType::kBvh, bvhSettingNode(), data_stream);
+}
+
+/*!
+  \details
+  The system section is the first section of the scene, so the following
+  sections aren't read. The settings such as the wavelength sample size
+  are checked without parsing the meshes and the textures.
+  */
+void SceneSettingNode::readSystemData(std::istream* data_stream) noexcept
+{
+  SettingNodeType t = readType(data_stream);
+  ZISC_ASSERT(type() == t, "The stream header is wrong.");
+  static_cast<void>(t);
+
+  // Read properties
+  scene_name_ = readString(data_stream);
+
+  // System
+  readChildNode(SettingNodeType::kSystem, systemSettingNode(), data_stream);
 }
 
 /*!
@@ -311,14 +319,63 @@ void SceneSettingNode::writeData(std::ostream* data_stream) const noexcept
   writeString(sceneName(), data_stream);
 
   // Child nodes
-  systemSettingNode()->writeData(data_stream);
-  renderingMethodSettingNode()->writeData(data_stream);
-  textureModelSettingNode()->writeData(data_stream);
-  surfaceModelSettingNode()->writeData(data_stream);
-  emitterModelSettingNode()->writeData(data_stream);
-  cameraSettingNode()->writeData(data_stream);
-  objectSettingNode()->writeData(data_stream);
-  bvhSettingNode()->writeData(data_stream);
+  writeChildNode(systemSettingNode(), data_stream);
+  writeChildNode(renderingMethodSettingNode(), data_stream);
+  writeChildNode(textureModelSettingNode(), data_stream);
+  writeChildNode(surfaceModelSettingNode(), data_stream);
+  writeChildNode(emitterModelSettingNode(), data_stream);
+  writeChildNode(cameraSettingNode(), data_stream);
+  writeChildNode(objectSettingNode(), data_stream);
+  writeChildNode(bvhSettingNode(), data_stream);
+}
+
+/*!
+  \details
+  A child node is stored as a section which is prefixed by its size in bytes.
+  The stream is moved to the end of the section after reading,
+  so the following sections are found even if the node reads less data.
+  */
+void SceneSettingNode::readChildNode(const SettingNodeType node_type,
+                                     SettingNodeBase* node,
+                                     std::istream* data_stream) noexcept
+{
+  uint64 section_size = 0;
+  zisc::read(&section_size, data_stream);
+  const auto section_begin = data_stream->tellg();
+
+  const SettingNodeType t = readType(data_stream);
+  ZISC_ASSERT(node_type == t, "The stream header is wrong.");
+  static_cast<void>(node_type);
+  static_cast<void>(t);
+  node->readData(data_stream);
+
+  const auto section_end = section_begin +
+                           zisc::cast<std::istream::off_type>(section_size);
+  ZISC_ASSERT(data_stream->tellg() == section_end,
+              "The size of the section is wrong.");
+  data_stream->seekg(section_end);
+}
+
+/*!
+  \details
+  The size of the section is written after the node data is written,
+  so the stream must be seekable.
+  */
+void SceneSettingNode::writeChildNode(const SettingNodeBase* node,
+                                      std::ostream* data_stream) const noexcept
+{
+  const auto size_position = data_stream->tellp();
+  uint64 section_size = 0;
+  zisc::write(&section_size, data_stream);
+  const auto section_begin = data_stream->tellp();
+
+  node->writeData(data_stream);
+
+  const auto section_end = data_stream->tellp();
+  section_size = zisc::cast<uint64>(section_end - section_begin);
+  data_stream->seekp(size_position);
+  zisc::write(&section_size, data_stream);
+  data_stream->seekp(section_end);
 }
 
 } // namespace nanairo
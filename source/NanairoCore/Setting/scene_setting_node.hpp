@@ -77,6 +77,9 @@ class SceneSettingNode : public SettingNodeBase
   //! Read the setting data from the stream
   void readData(std::istream* data_stream) noexcept override;
 
+  //! Read only the scene name and the system settings from the stream
+  void readSystemData(std::istream* data_stream) noexcept;
+
   //! Return the rendering method setting node
   SettingNodeBase* renderingMethodSettingNode() noexcept;
 
@@ -117,6 +120,16 @@ class SceneSettingNode : public SettingNodeBase
   void writeData(std::ostream* data_stream) const noexcept override;
 
  private:
+  //! Read the section of the child node from the stream
+  void readChildNode(const SettingNodeType node_type,
+                     SettingNodeBase* node,
+                     std::istream* data_stream) noexcept;
+
+  //! Write the child node to the stream as a section
+  void writeChildNode(const SettingNodeBase* node,
+                      std::ostream* data_stream) const noexcept;
+
+
   System::MemoryManager data_resource_;
   System::MemoryManager work_resource_;
   std::mutex data_mutex_;
@@ -10,6 +10,7 @@
 #include "single_object_setting_node.hpp"
 // Standard C++ library
 #include <array>
+#include <cstddef>
 #include <istream>
 #include <memory>
 #include <ostream>
@@ -34,7 +35,8 @@ MeshParameters::MeshParameters(zisc::pmr::memory_resource* data_resource) noexce
     face_list_{data_resource},
     vertex_list_{data_resource},
     vnormal_list_{data_resource},
-    vuv_list_{data_resource}
+    vuv_list_{data_resource},
+    mesh_file_path_{data_resource}
 {
 }
 
@@ -87,6 +89,14 @@ void MeshParameters::readData(std::istream* data_stream) noexcept
       zisc::read(&vuv_list_[0], data_stream, uv_size * num_of_uv);
     }
   }
+  // Mesh file
+  {
+    uint32 path_length = 0;
+    zisc::read(&path_length, data_stream);
+    mesh_file_path_.resize(path_length);
+    if (0 < path_length)
+      zisc::read(&mesh_file_path_[0], data_stream, path_length);
+  }
 }
 
 /*!
@@ -129,6 +139,12 @@ void MeshParameters::writeData(std::ostream* data_stream) const noexcept
     if (0 < num_of_uv)
       zisc::write(&vuv_list_[0], data_stream, uv_size * num_of_uv);
   }
+  // Mesh file
+  {
+    const uint32 path_length = zisc::cast<uint32>(mesh_file_path_.size());
+    zisc::write(&path_length, data_stream);
+    zisc::write(mesh_file_path_.data(), data_stream, path_length);
+  }
 }
 
 /*!
@@ -162,6 +178,39 @@ bool SingleObjectSettingNode::isEmissiveObject() const noexcept
   return is_emissive_object_ == kTrue;
 }
 
+/*!
+  */
+bool SingleObjectSettingNode::isSameGeometry(
+    const SingleObjectSettingNode& other) const noexcept
+{
+  if (shapeType() != other.shapeType())
+    return false;
+  if (shapeType() != ShapeType::kMesh)
+    return true;
+
+  const auto& lhs = meshParameters();
+  const auto& rhs = other.meshParameters();
+  // Compare the sizes first to reject different meshes quickly
+  bool is_same = (lhs.smoothing_ == rhs.smoothing_) &&
+                 (lhs.mesh_file_path_ == rhs.mesh_file_path_) &&
+                 (lhs.face_list_.size() == rhs.face_list_.size()) &&
+                 (lhs.vertex_list_.size() == rhs.vertex_list_.size()) &&
+                 (lhs.vnormal_list_.size() == rhs.vnormal_list_.size()) &&
+                 (lhs.vuv_list_.size() == rhs.vuv_list_.size());
+  for (std::size_t i = 0; is_same && (i < lhs.face_list_.size()); ++i) {
+    const auto& f1 = lhs.face_list_[i];
+    const auto& f2 = rhs.face_list_[i];
+    is_same = (f1.quadrangleVertexIndices() == f2.quadrangleVertexIndices()) &&
+              (f1.quadrangleVnormalIndices() == f2.quadrangleVnormalIndices()) &&
+              (f1.quadrangleVuvIndices() == f2.quadrangleVuvIndices()) &&
+              (f1.smoothing() == f2.smoothing());
+  }
+  is_same = is_same && (lhs.vertex_list_ == rhs.vertex_list_) &&
+                       (lhs.vnormal_list_ == rhs.vnormal_list_) &&
+                       (lhs.vuv_list_ == rhs.vuv_list_);
+  return is_same;
+}
+
 /*!
   */
 MeshParameters& SingleObjectSettingNode::meshParameters() noexcept
@@ -16,6 +16,7 @@
 #include <limits>
 #include <memory>
 #include <ostream>
+#include <string>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -48,6 +49,7 @@ struct MeshParameters : public NodeParameterBase
   zisc::pmr::vector<std::array<double, 3>> vertex_list_;
   zisc::pmr::vector<std::array<double, 3>> vnormal_list_;
   zisc::pmr::vector<std::array<double, 2>> vuv_list_;
+  zisc::pmr::string mesh_file_path_; //!< The lists are empty if the path is set
   uint8 smoothing_ = kFalse;
 };
 
@@ -69,6 +71,9 @@ class SingleObjectSettingNode : public SettingNodeBase
   //! Check if the object is emissive
   bool isEmissiveObject() const noexcept;
 
+  //! Check if the object has the same geometry as the other
+  bool isSameGeometry(const SingleObjectSettingNode& other) const noexcept;
+
   //! Return the mesh parameters
   MeshParameters& meshParameters() noexcept;
 
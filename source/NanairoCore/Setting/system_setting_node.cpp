@@ -10,8 +10,10 @@
 #include "system_setting_node.hpp"
 // Standard C++ library
 #include <array>
+#include <cstddef>
 #include <istream>
 #include <ostream>
+#include <string_view>
 #include <utility>
 // Zisc
 #include "zisc/binary_data.hpp"
@@ -27,6 +29,23 @@
 
 namespace nanairo {
 
+/*!
+  */
+void AtrousWaveletDenoiserParameters::readData(std::istream* data_stream) noexcept
+{
+  zisc::read(&number_of_iterations_, data_stream);
+  zisc::read(&color_sigma_, data_stream);
+}
+
+/*!
+  */
+void AtrousWaveletDenoiserParameters::writeData(std::ostream* data_stream)
+    const noexcept
+{
+  zisc::write(&number_of_iterations_, data_stream);
+  zisc::write(&color_sigma_, data_stream);
+}
+
 /*!
   */
 void BayesianCollaborativeDenoiserParameters::readData(std::istream* data_stream)
@@ -37,6 +56,7 @@ void BayesianCollaborativeDenoiserParameters::readData(std::istream* data_stream
   zisc::read(&patch_radius_, data_stream);
   zisc::read(&search_window_radius_, data_stream);
   zisc::read(&number_of_scales_, data_stream);
+  zisc::read(&single_precision_, data_stream);
 }
 
 /*!
@@ -49,15 +69,51 @@ void BayesianCollaborativeDenoiserParameters::writeData(std::ostream* data_strea
   zisc::write(&patch_radius_, data_stream);
   zisc::write(&search_window_radius_, data_stream);
   zisc::write(&number_of_scales_, data_stream);
+  zisc::write(&single_precision_, data_stream);
 }
 
 /*!
   */
 SystemSettingNode::SystemSettingNode(const SettingNodeBase* parent) noexcept :
-    SettingNodeBase(parent)
+    SettingNodeBase(parent),
+    out_of_core_directory_{dataResource()},
+    out_of_core_budget_{0},
+    mapped_film_directory_{dataResource()},
+    mapped_film_budget_{0}
 {
 }
 
+/*!
+  */
+double SystemSettingNode::adaptiveSamplingThreshold() const noexcept
+{
+  return adaptive_sampling_threshold_;
+}
+
+/*!
+  */
+AtrousWaveletDenoiserParameters&
+SystemSettingNode::atrousWaveletDenoiserParameters() noexcept
+{
+  ZISC_ASSERT(denoiserType() == DenoiserType::kAtrousWavelet,
+              "Invalid denoiser type is specified.");
+  auto parameters = zisc::cast<AtrousWaveletDenoiserParameters*>(
+      denoiser_parameters_.get());
+  return *parameters;
+}
+
+/*!
+  */
+const AtrousWaveletDenoiserParameters&
+SystemSettingNode::atrousWaveletDenoiserParameters() const noexcept
+{
+  ZISC_ASSERT(denoiserType() == DenoiserType::kAtrousWavelet,
+              "Invalid denoiser type is specified.");
+  auto parameters = zisc::cast<const AtrousWaveletDenoiserParameters*>(
+      denoiser_parameters_.get());
+  return *parameters;
+}
+
 /*!
   */
 BayesianCollaborativeDenoiserParameters&
@@ -96,6 +152,13 @@ ColorSpaceType SystemSettingNode::colorSpace() const noexcept
   return color_space_;
 }
 
+/*!
+  */
+const std::array<uint32, 4>& SystemSettingNode::cropWindow() const noexcept
+{
+  return crop_window_;
+}
+
 /*!
   */
 DenoiserType SystemSettingNode::denoiserType() const noexcept
@@ -103,6 +166,20 @@ DenoiserType SystemSettingNode::denoiserType() const noexcept
   return denoiser_type_;
 }
 
+/*!
+  */
+void SystemSettingNode::enableAdaptiveSampling(const bool flag) noexcept
+{
+  is_adaptive_sampling_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableBackgroundPriority(const bool flag) noexcept
+{
+  is_background_priority_enabled_ = flag ? kTrue : kFalse;
+}
+
 /*!
   */
 void SystemSettingNode::enableDenoising(const bool flag) noexcept
@@ -110,6 +187,55 @@ void SystemSettingNode::enableDenoising(const bool flag) noexcept
   is_denoising_enabled_ = flag ? kTrue : kFalse;
 }
 
+/*!
+  */
+void SystemSettingNode::enableHdrImageOutput(const bool flag) noexcept
+{
+  is_hdr_image_output_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableHugePageAllocation(const bool flag) noexcept
+{
+  is_huge_page_allocation_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableLdrImageOutput(const bool flag) noexcept
+{
+  is_ldr_image_output_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableMemoryFirstTouch(const bool flag) noexcept
+{
+  is_memory_first_touch_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableThreadAffinity(const bool flag) noexcept
+{
+  is_thread_affinity_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableTileWavelengthSampling(const bool flag) noexcept
+{
+  is_tile_wavelength_sampling_enabled_ = flag ? kTrue : kFalse;
+}
+
+/*!
+  */
+void SystemSettingNode::enableXyzFilm(const bool flag) noexcept
+{
+  is_xyz_film_enabled_ = flag ? kTrue : kFalse;
+}
+
 /*!
   */
 double SystemSettingNode::exposure() const noexcept
@@ -158,18 +284,32 @@ uint32 SystemSettingNode::imageWidthResolution() const noexcept
 void SystemSettingNode::initialize() noexcept
 {
   setNumOfThreads(1);
+  enableThreadAffinity(false);
+  enableMemoryFirstTouch(false);
+  enableBackgroundPriority(false);
+  enableHugePageAllocation(false);
   setSamplerType(SamplerType::kCmj);
   setSamplerSeed(123456789);
+  setSamplesPerCycle(1);
   setTerminationTime(0);
   setTerminationCycle(1024);
   setImageWidthResolution(CoreConfig::imageWidthMin());
   setImageHeightResolution(CoreConfig::imageHeightMin());
+  setCropWindow({{0, 0, 0, 0}});
   setSavingIntervalTime(1 * 60 * 60 * 1000); // per hour
   setSavingIntervalCycle(0);
   setPower2CycleSaving(true);
+  enableHdrImageOutput(false);
+  enableLdrImageOutput(true);
+  // Adaptive sampling
+  enableAdaptiveSampling(false);
+  setAdaptiveSamplingThreshold(0.01);
   // Color
   setColorMode(RenderingColorMode::kRgb);
+  enableXyzFilm(false);
   setWavelengthSamplerType(WavelengthSamplerType::kRegular);
+  setWavelengthSampleSize(0);
+  enableTileWavelengthSampling(false);
   setColorSpace(ColorSpaceType::kSRgbD65);
   setGammaCorrection(2.2);
   setToneMappingType(ToneMappingType::kReinhard);
@@ -179,6 +319,20 @@ void SystemSettingNode::initialize() noexcept
   enableDenoising(false);
 }
 
+/*!
+  */
+bool SystemSettingNode::isAdaptiveSamplingEnabled() const noexcept
+{
+  return is_adaptive_sampling_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isBackgroundPriorityEnabled() const noexcept
+{
+  return is_background_priority_enabled_ == kTrue;
+}
+
 /*!
   */
 bool SystemSettingNode::isDenoisingEnabled() const noexcept
@@ -186,6 +340,69 @@ bool SystemSettingNode::isDenoisingEnabled() const noexcept
   return is_denoising_enabled_ == kTrue;
 }
 
+/*!
+  */
+bool SystemSettingNode::isHdrImageOutputEnabled() const noexcept
+{
+  return is_hdr_image_output_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isHugePageAllocationEnabled() const noexcept
+{
+  return is_huge_page_allocation_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isLdrImageOutputEnabled() const noexcept
+{
+  return is_ldr_image_output_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isMemoryFirstTouchEnabled() const noexcept
+{
+  return is_memory_first_touch_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isThreadAffinityEnabled() const noexcept
+{
+  return is_thread_affinity_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isTileWavelengthSamplingEnabled() const noexcept
+{
+  return is_tile_wavelength_sampling_enabled_ == kTrue;
+}
+
+/*!
+  */
+bool SystemSettingNode::isXyzFilmEnabled() const noexcept
+{
+  return is_xyz_film_enabled_ == kTrue;
+}
+
+/*!
+  */
+std::size_t SystemSettingNode::mappedFilmBudget() const noexcept
+{
+  return mapped_film_budget_;
+}
+
+/*!
+  */
+std::string_view SystemSettingNode::mappedFilmDirectory() const noexcept
+{
+  return std::string_view{mapped_film_directory_};
+}
+
 /*!
   */
 SettingNodeType SystemSettingNode::nodeType() noexcept
@@ -201,6 +418,20 @@ uint32 SystemSettingNode::numOfThreads() const noexcept
   return num_of_threads_;
 }
 
+/*!
+  */
+std::size_t SystemSettingNode::outOfCoreBudget() const noexcept
+{
+  return out_of_core_budget_;
+}
+
+/*!
+  */
+std::string_view SystemSettingNode::outOfCoreDirectory() const noexcept
+{
+  return std::string_view{out_of_core_directory_};
+}
+
 /*!
   */
 bool SystemSettingNode::power2CycleSaving() const noexcept
@@ -222,23 +453,45 @@ SamplerType SystemSettingNode::samplerType() const noexcept
   return sampler_type_;
 }
 
+/*!
+  */
+uint32 SystemSettingNode::samplesPerCycle() const noexcept
+{
+  ZISC_ASSERT(samples_per_cycle_ != 0, "The samples per cycle is zero.");
+  return samples_per_cycle_;
+}
+
 /*!
   */
 void SystemSettingNode::readData(std::istream* data_stream) noexcept
 {
   // Read properties
   zisc::read(&num_of_threads_, data_stream);
+  zisc::read(&is_thread_affinity_enabled_, data_stream);
+  zisc::read(&is_memory_first_touch_enabled_, data_stream);
+  zisc::read(&is_background_priority_enabled_, data_stream);
+  zisc::read(&is_huge_page_allocation_enabled_, data_stream);
   zisc::read(&sampler_type_, data_stream);
   zisc::read(&sampler_seed_, data_stream);
+  zisc::read(&samples_per_cycle_, data_stream);
   zisc::read(&termination_time_, data_stream);
   zisc::read(&termination_cycle_, data_stream);
   zisc::read(&saving_interval_time_, data_stream);
   zisc::read(&saving_interval_cycle_, data_stream);
   zisc::read(&image_resolution_, data_stream, sizeof(image_resolution_[0]) * 2);
+  zisc::read(&crop_window_, data_stream, sizeof(crop_window_[0]) * 4);
   zisc::read(&power2_cycle_saving_, data_stream);
+  zisc::read(&is_hdr_image_output_enabled_, data_stream);
+  zisc::read(&is_ldr_image_output_enabled_, data_stream);
+  // Adaptive sampling
+  zisc::read(&adaptive_sampling_threshold_, data_stream);
+  zisc::read(&is_adaptive_sampling_enabled_, data_stream);
   // Color
   zisc::read(&color_mode_, data_stream);
+  zisc::read(&is_xyz_film_enabled_, data_stream);
   zisc::read(&wavelength_sampler_type_, data_stream);
+  zisc::read(&wavelength_sample_size_, data_stream);
+  zisc::read(&is_tile_wavelength_sampling_enabled_, data_stream);
   zisc::read(&color_space_, data_stream);
   zisc::read(&gamma_correction_, data_stream);
   zisc::read(&tone_mapping_type_, data_stream);
@@ -267,6 +520,15 @@ uint32 SystemSettingNode::savingIntervalTime() const noexcept
   return saving_interval_time_;
 }
 
+/*!
+  */
+void SystemSettingNode::setAdaptiveSamplingThreshold(const double threshold)
+    noexcept
+{
+  ZISC_ASSERT(0.0 < threshold, "The threshold isn't positive.");
+  adaptive_sampling_threshold_ = threshold;
+}
+
 /*!
   */
 void SystemSettingNode::setColorMode(const RenderingColorMode mode) noexcept
@@ -281,6 +543,14 @@ void SystemSettingNode::setColorSpace(const ColorSpaceType color_space) noexcept
   color_space_ = color_space;
 }
 
+/*!
+  */
+void SystemSettingNode::setCropWindow(const std::array<uint32, 4>& crop_window)
+    noexcept
+{
+  crop_window_ = crop_window;
+}
+
 /*!
   */
 void SystemSettingNode::setDenoiserType(const DenoiserType denoiser_type) noexcept
@@ -289,6 +559,12 @@ void SystemSettingNode::setDenoiserType(const DenoiserType denoiser_type) noexce
   // Initialize parameters
   denoiser_parameters_.reset();
   switch (denoiser_type_) {
+   case DenoiserType::kAtrousWavelet: {
+    denoiser_parameters_ =
+      zisc::UniqueMemoryPointer<AtrousWaveletDenoiserParameters>::make(
+          dataResource());
+    break;
+   }
    case DenoiserType::kBayesianCollaborative: {
     denoiser_parameters_ =
       zisc::UniqueMemoryPointer<BayesianCollaborativeDenoiserParameters>::make(
@@ -341,6 +617,19 @@ void SystemSettingNode::setImageWidthResolution(const uint32 image_width) noexce
   image_resolution_[0] = image_width;
 }
 
+/*!
+  \details
+  The film is placed in a temporary file of the directory,
+  and the tiles over the budget which aren't rendered recently
+  are paged out at the end of each cycle.
+  */
+void SystemSettingNode::setMappedFilm(const std::string_view& directory,
+                                      const std::size_t budget) noexcept
+{
+  mapped_film_directory_ = directory;
+  mapped_film_budget_ = budget;
+}
+
 /*!
   */
 void SystemSettingNode::setNumOfThreads(const uint32 num_of_threads) noexcept
@@ -349,6 +638,18 @@ void SystemSettingNode::setNumOfThreads(const uint32 num_of_threads) noexcept
   num_of_threads_ = num_of_threads;
 }
 
+/*!
+  \details
+  The geometry is placed in a temporary file of the directory,
+  and the clusters over the budget are paged out at the end of each cycle.
+  */
+void SystemSettingNode::setOutOfCore(const std::string_view& directory,
+                                     const std::size_t budget) noexcept
+{
+  out_of_core_directory_ = directory;
+  out_of_core_budget_ = budget;
+}
+
 /*!
   */
 void SystemSettingNode::setPower2CycleSaving(const bool power2_cycle_saving) noexcept
@@ -370,6 +671,14 @@ void SystemSettingNode::setSamplerType(const SamplerType type) noexcept
   sampler_type_ = type;
 }
 
+/*!
+  */
+void SystemSettingNode::setSamplesPerCycle(const uint32 samples_per_cycle) noexcept
+{
+  ZISC_ASSERT(samples_per_cycle != 0, "The samples per cycle is zero.");
+  samples_per_cycle_ = samples_per_cycle;
+}
+
 /*!
   */
 void SystemSettingNode::setSavingIntervalCycle(const uint32 interval_cycle) noexcept
@@ -414,6 +723,17 @@ void SystemSettingNode::setWavelengthSamplerType(
   wavelength_sampler_type_ = sampler_type;
 }
 
+/*!
+  \details
+  The wavelength sample size is fixed when the app is built,
+  so a size which differs from the app's size is rendered by
+  the variant of the app which is built for the size.
+  */
+void SystemSettingNode::setWavelengthSampleSize(const uint32 sample_size) noexcept
+{
+  wavelength_sample_size_ = sample_size;
+}
+
 /*!
   */
 uint32 SystemSettingNode::terminationCycle() const noexcept
@@ -449,6 +769,13 @@ WavelengthSamplerType SystemSettingNode::wavelengthSamplerType() const noexcept
   return wavelength_sampler_type_;
 }
 
+/*!
+  */
+uint32 SystemSettingNode::wavelengthSampleSize() const noexcept
+{
+  return wavelength_sample_size_;
+}
+
 /*!
   */
 void SystemSettingNode::writeData(std::ostream* data_stream) const noexcept
@@ -457,17 +784,31 @@ void SystemSettingNode::writeData(std::ostream* data_stream) const noexcept
 
   // Write properties
   zisc::write(&num_of_threads_, data_stream);
+  zisc::write(&is_thread_affinity_enabled_, data_stream);
+  zisc::write(&is_memory_first_touch_enabled_, data_stream);
+  zisc::write(&is_background_priority_enabled_, data_stream);
+  zisc::write(&is_huge_page_allocation_enabled_, data_stream);
   zisc::write(&sampler_type_, data_stream);
   zisc::write(&sampler_seed_, data_stream);
+  zisc::write(&samples_per_cycle_, data_stream);
   zisc::write(&termination_time_, data_stream);
   zisc::write(&termination_cycle_, data_stream);
   zisc::write(&saving_interval_time_, data_stream);
   zisc::write(&saving_interval_cycle_, data_stream);
   zisc::write(&image_resolution_, data_stream, sizeof(image_resolution_[0]) * 2);
+  zisc::write(&crop_window_, data_stream, sizeof(crop_window_[0]) * 4);
   zisc::write(&power2_cycle_saving_, data_stream);
+  zisc::write(&is_hdr_image_output_enabled_, data_stream);
+  zisc::write(&is_ldr_image_output_enabled_, data_stream);
+  // Adaptive sampling
+  zisc::write(&adaptive_sampling_threshold_, data_stream);
+  zisc::write(&is_adaptive_sampling_enabled_, data_stream);
   // Color
   zisc::write(&color_mode_, data_stream);
+  zisc::write(&is_xyz_film_enabled_, data_stream);
   zisc::write(&wavelength_sampler_type_, data_stream);
+  zisc::write(&wavelength_sample_size_, data_stream);
+  zisc::write(&is_tile_wavelength_sampling_enabled_, data_stream);
   zisc::write(&color_space_, data_stream);
   zisc::write(&gamma_correction_, data_stream);
   zisc::write(&tone_mapping_type_, data_stream);
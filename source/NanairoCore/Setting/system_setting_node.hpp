@@ -12,8 +12,11 @@
 
 // Standard C++ library
 #include <array>
+#include <cstddef>
 #include <istream>
 #include <ostream>
+#include <string>
+#include <string_view>
 // Zisc
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
@@ -32,6 +35,19 @@ namespace nanairo {
 //! \addtogroup Core
 //! \{
 
+// A-trous wavelet denoiser
+struct AtrousWaveletDenoiserParameters : public NodeParameterBase
+{
+  //! Read the parameters from the streamm
+  void readData(std::istream* data_stream) noexcept override;
+
+  //! Write the parameters to the stream
+  void writeData(std::ostream* data_stream) const noexcept override;
+
+  uint32 number_of_iterations_ = 5;
+  double color_sigma_ = 4.0;
+};
+
 // Bayesian collaborative denoiser
 struct BayesianCollaborativeDenoiserParameters : public NodeParameterBase
 {
@@ -46,6 +62,7 @@ struct BayesianCollaborativeDenoiserParameters : public NodeParameterBase
   uint32 patch_radius_ = 1;
   uint32 search_window_radius_ = 6;
   uint32 number_of_scales_ = 2;
+  uint8 single_precision_ = kFalse; //!< Denoise in float instead of Float
 };
 
 /*!
@@ -57,6 +74,16 @@ class SystemSettingNode : public SettingNodeBase
   SystemSettingNode(const SettingNodeBase* parent) noexcept;
 
 
+  //! Return the relative error threshold of adaptive sampling
+  double adaptiveSamplingThreshold() const noexcept;
+
+  //! Return the AtrousWaveletDenoiser parameters
+  AtrousWaveletDenoiserParameters& atrousWaveletDenoiserParameters() noexcept;
+
+  //! Return the AtrousWaveletDenoiser parameters
+  const AtrousWaveletDenoiserParameters& atrousWaveletDenoiserParameters()
+      const noexcept;
+
   //! Return the BayesianCollaborativeDenoiser parameters
   BayesianCollaborativeDenoiserParameters&
   bayesianCollaborativeDenoiserParameters() noexcept;
@@ -71,12 +98,42 @@ class SystemSettingNode : public SettingNodeBase
   //! Return the color space
   ColorSpaceType colorSpace() const noexcept;
 
+  //! Return the crop window [x, y, width, height] of the image
+  const std::array<uint32, 4>& cropWindow() const noexcept;
+
   //! Return the denoiser type
   DenoiserType denoiserType() const noexcept;
 
+  //! Enable adaptive sampling
+  void enableAdaptiveSampling(const bool flag) noexcept;
+
+  //! Enable rendering at the background priority of the OS
+  void enableBackgroundPriority(const bool flag) noexcept;
+
   //! Enable denoising
   void enableDenoising(const bool flag) noexcept;
 
+  //! Enable the output of the linear HDR image
+  void enableHdrImageOutput(const bool flag) noexcept;
+
+  //! Enable placing the large data arrays on huge pages
+  void enableHugePageAllocation(const bool flag) noexcept;
+
+  //! Enable the output of the tone mapped LDR image
+  void enableLdrImageOutput(const bool flag) noexcept;
+
+  //! Enable the first touch of the thread memory pools by the threads
+  void enableMemoryFirstTouch(const bool flag) noexcept;
+
+  //! Enable binding the threads to the cpus
+  void enableThreadAffinity(const bool flag) noexcept;
+
+  //! Enable sampling the wavelengths per rendering tile instead of per cycle
+  void enableTileWavelengthSampling(const bool flag) noexcept;
+
+  //! Enable the film which accumulates XYZ values instead of spectra
+  void enableXyzFilm(const bool flag) noexcept;
+
   //! Return the exposure time in seconds
   double exposure() const noexcept;
 
@@ -95,15 +152,54 @@ class SystemSettingNode : public SettingNodeBase
   //! Initialize a systemm node
   void initialize() noexcept override;
 
+  //! Check if adaptive sampling is enabled
+  bool isAdaptiveSamplingEnabled() const noexcept;
+
+  //! Check if the rendering threads run at the background priority
+  bool isBackgroundPriorityEnabled() const noexcept;
+
   //! Check if denoising is enabled
   bool isDenoisingEnabled() const noexcept;
 
+  //! Check if the linear HDR image is output
+  bool isHdrImageOutputEnabled() const noexcept;
+
+  //! Check if the large data arrays are placed on huge pages
+  bool isHugePageAllocationEnabled() const noexcept;
+
+  //! Check if the tone mapped LDR image is output
+  bool isLdrImageOutputEnabled() const noexcept;
+
+  //! Check if the thread memory pools are first touched by the threads
+  bool isMemoryFirstTouchEnabled() const noexcept;
+
+  //! Check if the threads are bound to the cpus
+  bool isThreadAffinityEnabled() const noexcept;
+
+  //! Check if the wavelengths are sampled per rendering tile
+  bool isTileWavelengthSamplingEnabled() const noexcept;
+
+  //! Check if the film accumulates XYZ values instead of spectra
+  bool isXyzFilmEnabled() const noexcept;
+
+  //! Return the bytes of the resident mapped film, 0 is unbounded
+  std::size_t mappedFilmBudget() const noexcept;
+
+  //! Return the directory of the mapped film, empty if the film is in memory
+  std::string_view mappedFilmDirectory() const noexcept;
+
   //! Return the node type
   static SettingNodeType nodeType() noexcept;
 
   //! Return the num of threads used for rendering
   uint32 numOfThreads() const noexcept;
 
+  //! Return the bytes of the resident out-of-core geometry, 0 is unbounded
+  std::size_t outOfCoreBudget() const noexcept;
+
+  //! Return the directory of the out-of-core geometry, empty if it's disabled
+  std::string_view outOfCoreDirectory() const noexcept;
+
   //! Return the power2 cycle saving flag
   bool power2CycleSaving() const noexcept;
 
@@ -116,18 +212,27 @@ class SystemSettingNode : public SettingNodeBase
   //! Return the sampler type
   SamplerType samplerType() const noexcept;
 
+  //! Return the number of samples per pixel which are traced in a cycle
+  uint32 samplesPerCycle() const noexcept;
+
   //! Return the saving interval cycle
   uint32 savingIntervalCycle() const noexcept;
 
   //! Return the saving interval time in milliseconds
   uint32 savingIntervalTime() const noexcept;
 
+  //! Set the relative error threshold of adaptive sampling
+  void setAdaptiveSamplingThreshold(const double threshold) noexcept;
+
   //! Set the rendering color mode
   void setColorMode(const RenderingColorMode mode) noexcept;
 
   //! Set the color space
   void setColorSpace(const ColorSpaceType color_space) noexcept;
 
+  //! Set the crop window [x, y, width, height], the zero size disables it
+  void setCropWindow(const std::array<uint32, 4>& crop_window) noexcept;
+
   //! Set the denoiser type
   void setDenoiserType(const DenoiserType denoiser_type) noexcept;
 
@@ -146,9 +251,17 @@ class SystemSettingNode : public SettingNodeBase
   //! Set the image width resolution
   void setImageWidthResolution(const uint32 image_width) noexcept;
 
+  //! Set the directory and the budget of the mapped film
+  void setMappedFilm(const std::string_view& directory,
+                     const std::size_t budget) noexcept;
+
   //! Set the num of threads used for rendering
   void setNumOfThreads(const uint32 num_of_threads) noexcept;
 
+  //! Set the directory and the budget of the out-of-core geometry
+  void setOutOfCore(const std::string_view& directory,
+                    const std::size_t budget) noexcept;
+
   //! Set the power2 cycle saving flag
   void setPower2CycleSaving(const bool power2_cycle_saving) noexcept;
 
@@ -158,6 +271,9 @@ class SystemSettingNode : public SettingNodeBase
   //! Set the sampler type
   void setSamplerType(const SamplerType type) noexcept;
 
+  //! Set the number of samples per pixel which are traced in a cycle
+  void setSamplesPerCycle(const uint32 samples_per_cycle) noexcept;
+
   //! Set the saving interval cycle
   void setSavingIntervalCycle(const uint32 interval_cycle) noexcept;
 
@@ -176,6 +292,9 @@ class SystemSettingNode : public SettingNodeBase
   //! Set the wavelength sampler type
   void setWavelengthSamplerType(const WavelengthSamplerType sampler_type) noexcept;
 
+  //! Set the number of the wavelengths of a sample, 0 uses the app's size
+  void setWavelengthSampleSize(const uint32 sample_size) noexcept;
+
   //! Return the termination cycle
   uint32 terminationCycle() const noexcept;
 
@@ -191,22 +310,39 @@ class SystemSettingNode : public SettingNodeBase
   //! Return the wavelength sampler type
   WavelengthSamplerType wavelengthSamplerType() const noexcept;
 
+  //! Return the number of the wavelengths of a sample, 0 uses the app's size
+  uint32 wavelengthSampleSize() const noexcept;
+
   //! Write the setting data to the stream
   void writeData(std::ostream* data_stream) const noexcept override;
 
  private:
   uint32 num_of_threads_;
+  uint8 is_thread_affinity_enabled_;
+  uint8 is_memory_first_touch_enabled_;
+  uint8 is_background_priority_enabled_;
+  uint8 is_huge_page_allocation_enabled_;
   SamplerType sampler_type_;
   uint32 sampler_seed_;
+  uint32 samples_per_cycle_;
   uint32 termination_time_,
          termination_cycle_;
   uint32 saving_interval_time_,
          saving_interval_cycle_;
   std::array<uint32, 2> image_resolution_;
+  std::array<uint32, 4> crop_window_;
   uint8 power2_cycle_saving_;
+  uint8 is_hdr_image_output_enabled_;
+  uint8 is_ldr_image_output_enabled_;
+  // Adaptive sampling
+  double adaptive_sampling_threshold_;
+  uint8 is_adaptive_sampling_enabled_;
   // Color
   RenderingColorMode color_mode_;
+  uint8 is_xyz_film_enabled_;
   WavelengthSamplerType wavelength_sampler_type_;
+  uint32 wavelength_sample_size_;
+  uint8 is_tile_wavelength_sampling_enabled_;
   ColorSpaceType color_space_;
   double gamma_correction_;
   ToneMappingType tone_mapping_type_;
@@ -215,6 +351,12 @@ class SystemSettingNode : public SettingNodeBase
   zisc::UniqueMemoryPointer<NodeParameterBase> denoiser_parameters_;
   DenoiserType denoiser_type_;
   uint8 is_denoising_enabled_;
+  // Out-of-core geometry, the runtime options which aren't saved
+  zisc::pmr::string out_of_core_directory_;
+  std::size_t out_of_core_budget_;
+  // Mapped film, the runtime options which aren't saved
+  zisc::pmr::string mapped_film_directory_;
+  std::size_t mapped_film_budget_;
 };
 
 //! \} Core
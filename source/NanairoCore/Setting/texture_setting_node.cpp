@@ -124,7 +124,8 @@ void CheckerboardTextureParameters::writeData(std::ostream* data_stream)
   */
 ImageTextureParameters::ImageTextureParameters(
     zisc::pmr::memory_resource* data_resource) noexcept :
-        image_{1, 1, data_resource}
+        image_{1, 1, data_resource},
+        tiled_image_path_{data_resource}
 {
 }
 
@@ -141,6 +142,13 @@ void ImageTextureParameters::readData(std::istream* data_stream) noexcept
     auto& buffer = image_.data();
     zisc::read(&buffer[0], data_stream, sizeof(buffer[0]) * buffer.size());
   }
+  {
+    uint32 path_length = 0;
+    zisc::read(&path_length, data_stream);
+    tiled_image_path_.resize(path_length);
+    if (0 < path_length)
+      zisc::read(&tiled_image_path_[0], data_stream, path_length);
+  }
 }
 
 /*!
@@ -157,6 +165,11 @@ void ImageTextureParameters::writeData(std::ostream* data_stream) const noexcept
     const auto& buffer = image_.data();
     zisc::write(&buffer[0], data_stream, sizeof(buffer[0]) * buffer.size());
   }
+  {
+    const uint32 path_length = zisc::cast<uint32>(tiled_image_path_.size());
+    zisc::write(&path_length, data_stream);
+    zisc::write(tiled_image_path_.data(), data_stream, path_length);
+  }
 }
 
 /*!
@@ -356,6 +369,16 @@ void TextureSettingNode::writeData(std::ostream* data_stream) const noexcept
 {
   writeType(data_stream);
   writeString(name(), data_stream);
+  writeParameters(data_stream);
+}
+
+/*!
+  \details
+  The textures of the same parameters make the same texture model,
+  so the written data is the content of the texture.
+  */
+void TextureSettingNode::writeParameters(std::ostream* data_stream) const noexcept
+{
   zisc::write(&texture_type_, data_stream);
   if (parameters_)
     parameters_->writeData(data_stream);
@@ -86,6 +86,7 @@ struct ImageTextureParameters : public NodeParameterBase
   void writeData(std::ostream* data_stream) const noexcept;
 
   LdrImage image_;
+  zisc::pmr::string tiled_image_path_; //!< The image isn't loaded if the path is set
 };
 
 /*!
@@ -148,6 +149,9 @@ class TextureSettingNode : public SettingNodeBase
   //! Write the texture setting to the data stream
   void writeData(std::ostream* data_stream) const noexcept override;
 
+  //! Write the type and the parameters of the texture without the name
+  void writeParameters(std::ostream* data_stream) const noexcept;
+
  private:
   zisc::UniqueMemoryPointer<NodeParameterBase> parameters_;
   zisc::pmr::string name_;
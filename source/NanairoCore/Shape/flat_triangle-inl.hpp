@@ -31,27 +31,43 @@ const std::array<Vector3, 2>& FlatTriangle::edge() const noexcept
 }
 
 /*!
+  \details
+  The sampling of a tiny spherical triangle loses the precision,
+  so the triangle which subtends less than the angle is sampled by the area.
   */
 inline
-const Vector3& FlatTriangle::normal() const noexcept
+constexpr Float FlatTriangle::minSolidAngle() noexcept
 {
-  return normal_;
+  return 1.0e-5;
 }
 
 /*!
+  \details
+  The normal is computed from the edges instead of being stored,
+  the result is the same as the normal which was computed at the initialization.
   */
 inline
-const Point2& FlatTriangle::uv0() const noexcept
+Vector3 FlatTriangle::normal() const noexcept
 {
-  return uv0_;
+  return calcNormal();
 }
 
 /*!
   */
 inline
-const std::array<Vector2, 2>& FlatTriangle::uvEdge() const noexcept
+Point2 FlatTriangle::uv0() const noexcept
 {
-  return uv_edge_;
+  return Point2{zisc::cast<Float>(uv_[0]), zisc::cast<Float>(uv_[1])};
+}
+
+/*!
+  */
+inline
+std::array<Vector2, 2> FlatTriangle::uvEdge() const noexcept
+{
+  return std::array<Vector2, 2>{{
+      Vector2{zisc::cast<Float>(uv_[2]), zisc::cast<Float>(uv_[3])},
+      Vector2{zisc::cast<Float>(uv_[4]), zisc::cast<Float>(uv_[5])}}};
 }
 
 /*!
@@ -67,7 +83,7 @@ const Point3& FlatTriangle::vertex0() const noexcept
 inline
 Point2 FlatTriangle::calcUv(const Point2& st) const noexcept
 {
-  const auto& uv_edge = uvEdge();
+  const auto uv_edge = uvEdge();
   Point2 uv = uv0() + st[0] * uv_edge[0] + st[1] * uv_edge[1];
   for (uint i = 0; i < uv.size(); ++i) {
     while (!zisc::isInClosedBounds(uv[i], 0.0, 1.0))
@@ -24,6 +24,7 @@
 #include "NanairoCore/Data/intersection_test_result.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_hit.hpp"
 #include "NanairoCore/Data/shape_point.hpp"
 #include "NanairoCore/DataStructure/aabb.hpp"
 #include "NanairoCore/Geometry/point.hpp"
@@ -43,8 +44,7 @@ FlatTriangle::FlatTriangle(const Point3& vertex1,
                            const Point3& vertex3) noexcept :
     vertex0_{vertex1},
     edge_{{Vector3{vertex2 - vertex1}, Vector3{vertex3 - vertex1}}},
-    uv0_{0.0, 0.0},
-    uv_edge_{{Vector2{0.0, 0.0}, Vector2{0.0, 0.0}}}
+    uv_{{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}}
 {
   initialize();
 }
@@ -70,6 +70,23 @@ Aabb FlatTriangle::boundingBox() const noexcept
   return Aabb{Point3{min_point}, Point3{max_point}};
 }
 
+/*!
+  */
+void FlatTriangle::computeSurfacePoint(
+    const Ray& ray,
+    const RayHit& hit,
+    IntersectionInfo* intersection) const noexcept
+{
+  setIntersectionInfo(ray, hit.rayDistance(), hit.st(), intersection);
+}
+
+/*!
+  */
+Vector3 FlatTriangle::flatNormal() const noexcept
+{
+  return normal();
+}
+
 /*!
   */
 Float FlatTriangle::calcSurfaceArea(const Point3& vertex1,
@@ -94,12 +111,13 @@ ShapePoint FlatTriangle::getPoint(const Point2& st) const noexcept
   const auto point = v + st[0] * e[0] + st[1] * e[1];
   const auto uv = calcUv(st);
 
-  const auto tangents = Transformation::calcDefaultTangent(normal());
+  const auto flat_normal = normal();
+  const auto tangents = Transformation::calcDefaultTangent(flat_normal);
   const auto& tangent = std::get<0>(tangents);
   const auto& bitangent = std::get<1>(tangents);
 
   return ShapePoint{SampledPoint{point, surfaceArea()},
-                    normal(),
+                    flat_normal,
                     tangent,
                     bitangent,
                     uv,
@@ -121,8 +139,12 @@ Float FlatTriangle::getTraversalCost() const noexcept
   */
 IntersectionTestResult FlatTriangle::testIntersection(
     const Ray& ray,
-    IntersectionInfo* intersection) const noexcept
+    const Float max_distance,
+    Point2* st,
+    uint32* primitive_index) const noexcept
 {
+  ZISC_ASSERT(st != nullptr, "The st is null.");
+  ZISC_ASSERT(primitive_index != nullptr, "The primitive index is null.");
   const auto& to_canonical = toCanonicalMatrix();
 
   const Float dz = zisc::dot(to_canonical.row1_xyz_, ray.direction());
@@ -132,9 +154,45 @@ IntersectionTestResult FlatTriangle::testIntersection(
     return IntersectionTestResult{};
 
   const Float t = -oz / dz;
-  if (!zisc::isInOpenBounds(t, 0.0, intersection->rayDistance()))
+  if (!zisc::isInOpenBounds(t, 0.0, max_distance))
     return IntersectionTestResult{};
 
+  const auto point = ray.origin() + t * ray.direction();
+  const Point2 hit_st{zisc::dot(to_canonical.row2_xyz_.data(), point.data()) +
+                      to_canonical.row2_w_,
+                      zisc::dot(to_canonical.row3_xyz_.data(), point.data()) +
+                      to_canonical.row3_w_};
+  const Float u = 1.0 - (hit_st[0] + hit_st[1]);
+  const bool is_hit = (0.0 < hit_st[0]) && (0.0 < hit_st[1]) && (0.0 < u);
+  if (is_hit) {
+    *st = hit_st;
+    *primitive_index = 0;
+  }
+  return (is_hit)
+      ? IntersectionTestResult{t}
+      : IntersectionTestResult{};
+}
+
+/*!
+  \details
+  The same test as testIntersection() without computing the surface
+  attributes of the hit point.
+  */
+bool FlatTriangle::testOcclusion(const Ray& ray,
+                                 const Float max_distance) const noexcept
+{
+  const auto& to_canonical = toCanonicalMatrix();
+
+  const Float dz = zisc::dot(to_canonical.row1_xyz_, ray.direction());
+  const Float oz = zisc::dot(to_canonical.row1_xyz_.data(), ray.origin().data()) +
+                   to_canonical.row1_w_;
+  if (dz == 0.0)
+    return false;
+
+  const Float t = -oz / dz;
+  if (!zisc::isInOpenBounds(t, 0.0, max_distance))
+    return false;
+
   const auto point = ray.origin() + t * ray.direction();
   const Point2 st{zisc::dot(to_canonical.row2_xyz_.data(), point.data()) +
                   to_canonical.row2_w_,
@@ -142,27 +200,37 @@ IntersectionTestResult FlatTriangle::testIntersection(
                   to_canonical.row3_w_};
   const Float u = 1.0 - (st[0] + st[1]);
   const bool is_hit = (0.0 < st[0]) && (0.0 < st[1]) && (0.0 < u);
-  if (is_hit) {
-    const Float cos_theta = -zisc::dot(normal(), ray.direction());
-    const bool is_back_face = cos_theta < 0.0;
-
-    const auto n = (!is_back_face) ? normal() : -normal();
-    const auto tangents = Transformation::calcDefaultTangent(n);
-    const auto& tangent = std::get<0>(tangents);
-    const auto& bitangent = std::get<1>(tangents);
-
-    intersection->setPoint(point);
-    intersection->setNormal(n);
-    intersection->setTangent(tangent);
-    intersection->setBitangent(bitangent);
-    intersection->setAsBackFace(is_back_face);
-    intersection->setRayDistance(t);
-    intersection->setSt(st);
-    intersection->setUv(calcUv(st));
-  }
-  return (is_hit)
-      ? IntersectionTestResult{t}
-      : IntersectionTestResult{};
+  return is_hit;
+}
+
+/*!
+  */
+void FlatTriangle::setIntersectionInfo(const Ray& ray,
+                                       const Float t,
+                                       const Point2& st,
+                                       IntersectionInfo* intersection) const noexcept
+{
+  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  const auto point = ray.origin() + t * ray.direction();
+
+  const auto flat_normal = normal();
+  const Float cos_theta = -zisc::dot(flat_normal, ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto n = (!is_back_face) ? flat_normal : -flat_normal;
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setRayDistance(t);
+  intersection->setSt(st);
+  intersection->setUv(calcUv(st));
+  intersection->setUvFootprint(calcUvFootprint(ray, t, cos_theta));
 }
 
 /*!
@@ -184,27 +252,113 @@ ShapePoint FlatTriangle::samplePoint(Sampler& sampler,
   const auto point = v + st[0] * e[0] + st[1] * e[1];
   const auto uv = calcUv(st);
 
-  const auto tangents = Transformation::calcDefaultTangent(normal());
+  const auto flat_normal = normal();
+  const auto tangents = Transformation::calcDefaultTangent(flat_normal);
   const auto& tangent = std::get<0>(tangents);
   const auto& bitangent = std::get<1>(tangents);
 
   return ShapePoint{SampledPoint{point, surfaceArea()},
-                    normal(),
+                    flat_normal,
                     tangent,
                     bitangent,
                     uv,
                     st};
 }
 
+/*!
+  \details
+  The direction is sampled uniformly in the spherical triangle by Arvo's method
+  and the point is the hit point of the direction on the triangle.
+  The pdf is converted into the area measure,
+  so the light sampling uses the point as the uniformly sampled point.
+  */
+ShapePoint FlatTriangle::sampleSolidAnglePoint(
+    const Point3& reference,
+    Sampler& sampler,
+    const PathState& path_state) const noexcept
+{
+  const auto angles = calcSphericalAngles(reference);
+  const Float solid_angle = angles[0] + angles[1] + angles[2] - zisc::kPi<Float>;
+  if (solid_angle < minSolidAngle())
+    return samplePoint(sampler, path_state);
+
+  // The unit vectors to the vertices
+  const auto& v = vertex0();
+  const auto& e = edge();
+  const auto a = (v - reference).normalized();
+  const auto b = ((v + e[0]) - reference).normalized();
+  const auto c = ((v + e[1]) - reference).normalized();
+
+  const auto r = sampler.draw2D(path_state);
+  // Sample the sub-triangle of the area fraction of the first sample
+  const Float alpha = angles[0];
+  const Float area = r[0] * solid_angle;
+  const Float sin_alpha = zisc::sin(alpha);
+  const Float cos_alpha = zisc::cos(alpha);
+  const Float s = zisc::sin(area - alpha);
+  const Float t = zisc::cos(area - alpha);
+  const Float u = t - cos_alpha;
+  const Float w = s + sin_alpha * zisc::dot(a, b);
+  const Float q = zisc::clamp(((w * t - u * s) * cos_alpha - w) /
+                              ((w * s + u * t) * sin_alpha),
+                              -1.0, 1.0);
+  const auto c_perp = (c - zisc::dot(c, a) * a).normalized();
+  const auto c_hat = q * a + zisc::sqrt(zisc::max(1.0 - q * q, 0.0)) * c_perp;
+  // Sample the direction on the arc from the b to the c hat
+  const Float z = 1.0 - r[1] * (1.0 - zisc::dot(c_hat, b));
+  const auto c_hat_perp = (c_hat - zisc::dot(c_hat, b) * b).normalized();
+  const auto direction = z * b + zisc::sqrt(zisc::max(1.0 - z * z, 0.0)) * c_hat_perp;
+
+  // Project the direction onto the triangle
+  const auto n = normal();
+  const Float cos_theta = zisc::dot(n, direction);
+  const Float distance = zisc::dot(n, v - reference) / cos_theta;
+  auto point = getPoint(calcSt(reference + distance * direction));
+  const Float distance2 = (point.point() - reference).squareNorm();
+  point.setPdf(zisc::abs(cos_theta) / (distance2 * solid_angle));
+  return point;
+}
+
+/*!
+  \details
+  The solid angle is calculated in the same way as the sampling,
+  so the pdf matches the sampled point.
+  */
+Float FlatTriangle::solidAnglePointPdf(const Point3& reference,
+                                       const Point3& point) const noexcept
+{
+  const auto angles = calcSphericalAngles(reference);
+  const Float solid_angle = angles[0] + angles[1] + angles[2] - zisc::kPi<Float>;
+  if (solid_angle < minSolidAngle())
+    return zisc::invert(surfaceArea());
+
+  const auto diff = point - reference;
+  const Float distance2 = diff.squareNorm();
+  const Float cos_theta = zisc::abs(zisc::dot(normal(), diff)) / zisc::sqrt(distance2);
+  return cos_theta / (distance2 * solid_angle);
+}
+
+/*!
+  */
+ShapeType FlatTriangle::type() const noexcept
+{
+  return ShapeType::kMesh;
+}
+
 /*!
   */
 void FlatTriangle::setUv(const Point2& uv1,
                          const Point2& uv2,
                          const Point2& uv3) noexcept
 {
-  uv0_ = uv1;
-  uv_edge_[0] = uv2 - uv1;
-  uv_edge_[1] = uv3 - uv1;
+  // The UVs are stored in single precision, which is enough for the textures
+  const std::array<Vector2, 2> uv_edge{{uv2 - uv1, uv3 - uv1}};
+  uv_[0] = zisc::cast<float>(uv1[0]);
+  uv_[1] = zisc::cast<float>(uv1[1]);
+  for (uint i = 0; i < 2; ++i) {
+    uv_[2 + 2 * i] = zisc::cast<float>(uv_edge[i][0]);
+    uv_[3 + 2 * i] = zisc::cast<float>(uv_edge[i][1]);
+  }
 }
 
 // private member function
@@ -220,6 +374,65 @@ Vector3 FlatTriangle::calcNormal() const noexcept
   return n;
 }
 
+/*!
+  \details
+  The point is projected onto the triangle, and the st coordinates are
+  clamped into the triangle against the rounding errors.
+  */
+Point2 FlatTriangle::calcSt(const Point3& point) const noexcept
+{
+  const auto& e = edge();
+  const auto p = point - vertex0();
+  const Float d00 = zisc::dot(e[0], e[0]);
+  const Float d01 = zisc::dot(e[0], e[1]);
+  const Float d11 = zisc::dot(e[1], e[1]);
+  const Float d20 = zisc::dot(p, e[0]);
+  const Float d21 = zisc::dot(p, e[1]);
+  const Float inverse_denom = zisc::invert(d00 * d11 - d01 * d01);
+  Point2 st{zisc::max((d11 * d20 - d01 * d21) * inverse_denom, 0.0),
+            zisc::max((d00 * d21 - d01 * d20) * inverse_denom, 0.0)};
+  const Float sum = st[0] + st[1];
+  if (1.0 < sum) {
+    st[0] = st[0] / sum;
+    st[1] = st[1] / sum;
+  }
+  return st;
+}
+
+/*!
+  \details
+  The angles are the dihedral angles between the planes through
+  the reference and the edges, at the vertex 0, 1 and 2 respectively.
+  A degenerate spherical triangle has zero angles.
+  */
+std::array<Float, 3> FlatTriangle::calcSphericalAngles(
+    const Point3& reference) const noexcept
+{
+  const auto& v = vertex0();
+  const auto& e = edge();
+  const auto a = (v - reference).normalized();
+  const auto b = ((v + e[0]) - reference).normalized();
+  const auto c = ((v + e[1]) - reference).normalized();
+  const auto n_ab = zisc::cross(a, b);
+  const auto n_bc = zisc::cross(b, c);
+  const auto n_ca = zisc::cross(c, a);
+  const Float l_ab = n_ab.norm();
+  const Float l_bc = n_bc.norm();
+  const Float l_ca = n_ca.norm();
+  if ((l_ab <= 0.0) || (l_bc <= 0.0) || (l_ca <= 0.0))
+    return std::array<Float, 3>{{0.0, 0.0, 0.0}};
+
+  auto angle = [](const Vector3& n1, const Float l1,
+                  const Vector3& n2, const Float l2) noexcept
+  {
+    const Float cos_angle = -zisc::dot(n1, n2) / (l1 * l2);
+    return zisc::acos(zisc::clamp(cos_angle, -1.0, 1.0));
+  };
+  return std::array<Float, 3>{{angle(n_ab, l_ab, n_ca, l_ca),
+                               angle(n_bc, l_bc, n_ab, l_ab),
+                               angle(n_ca, l_ca, n_bc, l_bc)}};
+}
+
 /*!
   */
 Float FlatTriangle::calcSurfaceArea() const noexcept
@@ -229,6 +442,25 @@ Float FlatTriangle::calcSurfaceArea() const noexcept
   return calcSurfaceArea(vertex0(), vertex2, vertex3);
 }
 
+/*!
+  \details
+  The width is scaled isotropically by the ratio of the UV area to
+  the area of the triangle, and stretched by the incident angle.
+  */
+Float FlatTriangle::calcUvFootprint(const Ray& ray,
+                                    const Float t,
+                                    const Float cos_theta) const noexcept
+{
+  const auto uv_edge = uvEdge();
+  const Float uv_area = 0.5 * zisc::abs(uv_edge[0][0] * uv_edge[1][1] -
+                                        uv_edge[0][1] * uv_edge[1][0]);
+  const Float area = surfaceArea();
+  const Float footprint = ((0.0 < area) && (cos_theta != 0.0))
+      ? ray.footprint(t) * zisc::sqrt(uv_area / area) / zisc::abs(cos_theta)
+      : 0.0;
+  return footprint;
+}
+
 /*!
   */
 void FlatTriangle::initCanonicalMatrix() noexcept
@@ -300,7 +532,6 @@ void FlatTriangle::initCanonicalMatrix() noexcept
   */
 void FlatTriangle::initialize() noexcept
 {
-  normal_ = calcNormal();
   initCanonicalMatrix();
   setSurfaceArea(calcSurfaceArea());
 }
@@ -314,7 +545,6 @@ void FlatTriangle::transformShape(const Matrix4x4& matrix) noexcept
   Transformation::affineTransform(matrix, &vertex0_);
   Transformation::affineTransform(matrix, &edge_[0]);
   Transformation::affineTransform(matrix, &edge_[1]);
-  normal_ = calcNormal();
   initCanonicalMatrix();
 }
 
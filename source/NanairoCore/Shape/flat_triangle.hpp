@@ -29,6 +29,7 @@ class Aabb;
 class IntersectionInfo;
 class PathState;
 class Ray;
+class RayHit;
 class Sampler;
 
 //! \addtogroup Core
@@ -41,6 +42,18 @@ class Sampler;
 class FlatTriangle : public Shape
 {
  public:
+  //! The matrix to transform a world point into the canonical coordinate
+  struct CanonicalMatrix
+  {
+    Vector3 row1_xyz_;
+    Float row1_w_;
+    Vector3 row2_xyz_;
+    Float row2_w_;
+    Vector3 row3_xyz_;
+    Float row3_w_;
+  };
+
+
   //! Create a flat triangle 
   FlatTriangle(const Point3& vertex1,
                const Point3& vertex2,
@@ -50,6 +63,14 @@ class FlatTriangle : public Shape
   //! Return the bounding box
   Aabb boundingBox() const noexcept override;
 
+  //! Compute the surface attributes of the closest hit point
+  void computeSurfacePoint(const Ray& ray,
+                           const RayHit& hit,
+                           IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the normal of the triangle
+  Vector3 flatNormal() const noexcept override;
+
   //! Calculate the surface area of the front side of the triangle
   static Float calcSurfaceArea(const Point3& vertex1,
                                const Point3& vertex2,
@@ -65,61 +86,88 @@ class FlatTriangle : public Shape
   Float getTraversalCost() const noexcept override;
 
   //! Return the normal of the triangle
-  const Vector3& normal() const noexcept;
+  Vector3 normal() const noexcept;
+
+  //! Set the surface attributes of the hit point to the intersection
+  void setIntersectionInfo(const Ray& ray,
+                           const Float t,
+                           const Point2& st,
+                           IntersectionInfo* intersection) const noexcept;
 
   //! Test ray-triangle intersection
   IntersectionTestResult testIntersection(
       const Ray& ray,
-      IntersectionInfo* intersection) const noexcept override;
+      const Float max_distance,
+      Point2* st,
+      uint32* primitive_index) const noexcept override;
+
+  //! Test if the ray is occluded by the triangle
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
 
   //! Sample a point randomly on the surface of the triangle
   ShapePoint samplePoint(Sampler& sampler,
                          const PathState& path_state) const noexcept override;
 
+  //! Sample a point by the spherical triangle subtended at the reference
+  ShapePoint sampleSolidAnglePoint(const Point3& reference,
+                                   Sampler& sampler,
+                                   const PathState& path_state) const noexcept override;
+
+  //! Return the pdf (area measure) of sampling the point by the solid angle
+  Float solidAnglePointPdf(const Point3& reference,
+                           const Point3& point) const noexcept override;
+
   //! Set the UVs of the vertice
   void setUv(const Point2& uv1,
              const Point2& uv2,
              const Point2& uv3) noexcept;
 
+  //! Return the matrix to transform canonical coordinate
+  const CanonicalMatrix& toCanonicalMatrix() const noexcept;
+
+  //! Return the type of the shape
+  ShapeType type() const noexcept override;
+
   //! Return the UV of the vertex0
-  const Point2& uv0() const noexcept;
+  Point2 uv0() const noexcept;
 
   //! Return the UV edges
-  const std::array<Vector2, 2>& uvEdge() const noexcept;
+  std::array<Vector2, 2> uvEdge() const noexcept;
 
   //! Return the vertex of the triangle
   const Point3& vertex0() const noexcept;
 
  private:
-  struct CanonicalMatrix
-  {
-    Vector3 row1_xyz_;
-    Float row1_w_;
-    Vector3 row2_xyz_;
-    Float row2_w_;
-    Vector3 row3_xyz_;
-    Float row3_w_;
-  };
-
-
   //! Calculate the normal vector
   Vector3 calcNormal() const noexcept;
 
+  //! Calculate the st coordinates of the point on the triangle plane
+  Point2 calcSt(const Point3& point) const noexcept;
+
+  //! Calculate the inner angles of the spherical triangle at the reference
+  std::array<Float, 3> calcSphericalAngles(const Point3& reference) const noexcept;
+
+  //! Return the minimum solid angle which is sampled by the spherical triangle
+  static constexpr Float minSolidAngle() noexcept;
+
   //! Calculate the surface area of the front side of the triangle
   Float calcSurfaceArea() const noexcept override;
 
   //! Calculate the UV of the point
   Point2 calcUv(const Point2& st) const noexcept;
 
+  //! Calculate the width of the ray footprint in the UV
+  Float calcUvFootprint(const Ray& ray,
+                        const Float t,
+                        const Float cos_theta) const noexcept;
+
   //! Initialize the matrix to transform canonical coordinate
   void initCanonicalMatrix() noexcept;
 
   // Initialize the flat triangle
   void initialize() noexcept;
 
-  //! Return the matrix to transform canonical coordinate
-  const CanonicalMatrix& toCanonicalMatrix() const noexcept;
-
   //! Apply affine transformation
   void transformShape(const Matrix4x4& matrix) noexcept override;
 
@@ -127,9 +175,7 @@ class FlatTriangle : public Shape
   CanonicalMatrix to_canonical_;
   Point3 vertex0_; //!< The v0
   std::array<Vector3, 2> edge_; //!< Edges to v1 and v2
-  Vector3 normal_;
-  Point2 uv0_;
-  std::array<Vector2, 2> uv_edge_;
+  std::array<float, 6> uv_; //!< The UV of the v0 and the UV edges
 };
 
 //! \} Core
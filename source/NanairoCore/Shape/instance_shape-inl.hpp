@@ -0,0 +1,44 @@
+/*!
+  \file instance_shape-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_INSTANCE_SHAPE_INL_HPP
+#define NANAIRO_INSTANCE_SHAPE_INL_HPP
+
+#include "instance_shape.hpp"
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Bvh;
+
+/*!
+  */
+inline
+const Bvh& InstanceShape::bvh() const noexcept
+{
+  ZISC_ASSERT(bvh_ != nullptr, "The bvh is null.");
+  return *bvh_;
+}
+
+/*!
+  */
+inline
+const Matrix4x4& InstanceShape::toWorldMatrix() const noexcept
+{
+  return to_world_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_INSTANCE_SHAPE_INL_HPP
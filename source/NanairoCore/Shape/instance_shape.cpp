@@ -0,0 +1,238 @@
+/*!
+  \file instance_shape.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "instance_shape.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <tuple>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_hit.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+InstanceShape::InstanceShape(const Bvh* bvh,
+                             const Float local_surface_area) noexcept :
+    bvh_{bvh},
+    to_world_{Transformation::makeIdentity()},
+    to_local_{Transformation::makeIdentity()},
+    local_surface_area_{local_surface_area}
+{
+  initialize();
+  setSurfaceArea(calcSurfaceArea());
+}
+
+/*!
+  */
+Aabb InstanceShape::boundingBox() const noexcept
+{
+  return bounding_box_;
+}
+
+/*!
+  \details
+  The primitive index of the hit is the object index in the bottom-level BVH,
+  whose objects are triangles or planes of a single primitive.
+  */
+void InstanceShape::computeSurfacePoint(
+    const Ray& ray,
+    const RayHit& hit,
+    IntersectionInfo* intersection) const noexcept
+{
+  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  const auto local_ray = toLocal(ray);
+  RayHit local_hit;
+  local_hit.set(hit.rayDistance(), hit.primitiveIndex(), 0, hit.st());
+  IntersectionInfo local_intersection;
+  bvh().makeIntersectionInfo(local_ray, local_hit, &local_intersection);
+
+  const Float t = local_intersection.rayDistance();
+  const auto point = ray.origin() + t * ray.direction();
+  // The local normal faces the ray, the transformed normal too
+  const Vector3 normal = normal_matrix_ * local_intersection.normal();
+  const auto n = normal.normalized();
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+  // A mirroring transformation flips the front side of the faces
+  const bool is_back_face = (is_mirrored_ == kTrue)
+      ? !local_intersection.isBackFace()
+      : local_intersection.isBackFace();
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setRayDistance(t);
+  intersection->setSt(local_intersection.st());
+  intersection->setUv(local_intersection.uv());
+  intersection->setUvFootprint(local_intersection.uvFootprint());
+  intersection->setObject(local_intersection.object());
+}
+
+/*!
+  */
+ShapePoint InstanceShape::getPoint(const Point2& /* st */) const noexcept
+{
+  zisc::raiseError("ShapeError: The point of an instance isn't supported.");
+  return ShapePoint{};
+}
+
+/*!
+  \details
+  The cost is approximated by the depth of the bottom-level BVH.
+  */
+Float InstanceShape::getTraversalCost() const noexcept
+{
+  const Float num_of_objects = zisc::cast<Float>(bvh().objectList().size());
+  return 1.0 + std::log2(num_of_objects);
+}
+
+/*!
+  \details
+  The direction of the local ray isn't normalized,
+  so the ray distance of the local intersection equals the world one.
+  */
+IntersectionTestResult InstanceShape::testIntersection(
+    const Ray& ray,
+    const Float max_distance,
+    Point2* st,
+    uint32* primitive_index) const noexcept
+{
+  ZISC_ASSERT(st != nullptr, "The st is null.");
+  ZISC_ASSERT(primitive_index != nullptr, "The primitive index is null.");
+  const auto local_ray = toLocal(ray);
+  const auto local_hit = bvh().findClosestHit(local_ray, max_distance);
+  if (!local_hit.isHit())
+    return IntersectionTestResult{};
+
+  *st = local_hit.st();
+  *primitive_index = local_hit.objectIndex();
+  return IntersectionTestResult{local_hit.rayDistance()};
+}
+
+/*!
+  */
+bool InstanceShape::testOcclusion(const Ray& ray,
+                                  const Float max_distance) const noexcept
+{
+  const auto local_ray = toLocal(ray);
+  return bvh().testOcclusion(local_ray, max_distance);
+}
+
+/*!
+  */
+ShapePoint InstanceShape::samplePoint(Sampler& /* sampler */,
+                                      const PathState& /* path_state */) const noexcept
+{
+  zisc::raiseError("ShapeError: Sampling on an instance isn't supported.");
+  return ShapePoint{};
+}
+
+/*!
+  */
+ShapeType InstanceShape::type() const noexcept
+{
+  return ShapeType::kInstance;
+}
+
+/*!
+  \details
+  The area is exact for uniform scaling. The area of an instance is only
+  informative since emissive objects aren't instanced.
+  */
+Float InstanceShape::calcSurfaceArea() const noexcept
+{
+  return area_scale_ * local_surface_area_;
+}
+
+/*!
+  */
+void InstanceShape::initialize() noexcept
+{
+  to_local_ = Transformation::invertAffine(to_world_);
+  const auto& m = to_world_;
+  const auto& inv = to_local_;
+  normal_matrix_ = Matrix3x3{inv(0, 0), inv(1, 0), inv(2, 0),
+                             inv(0, 1), inv(1, 1), inv(2, 1),
+                             inv(0, 2), inv(1, 2), inv(2, 2)};
+  // Determinant of the linear part
+  const Float determinant =
+      m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) +
+      m(0, 1) * (m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2)) +
+      m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+  is_mirrored_ = (determinant < 0.0) ? kTrue : kFalse;
+  area_scale_ = std::cbrt(zisc::power<2>(determinant));
+
+  // Transform the corners of the local bounding box
+  const auto local_box = bvh().boundingBox();
+  const std::array<Point3, 2> corner{{local_box.minPoint(), local_box.maxPoint()}};
+  Point3 min_point = corner[0];
+  Point3 max_point = corner[0];
+  for (uint i = 0; i < 8; ++i) {
+    Point3 point{corner[(i >> 0) & 1][0],
+                 corner[(i >> 1) & 1][1],
+                 corner[(i >> 2) & 1][2]};
+    Transformation::affineTransform(to_world_, &point);
+    if (i == 0) {
+      min_point = point;
+      max_point = point;
+    }
+    else {
+      min_point = Point3{zisc::minElements(min_point.data(), point.data())};
+      max_point = Point3{zisc::maxElements(max_point.data(), point.data())};
+    }
+  }
+  bounding_box_ = Aabb{min_point, max_point};
+}
+
+/*!
+  \details
+  The ray cone is scaled to the local lengths by the uniform scale of
+  the transformation.
+  */
+Ray InstanceShape::toLocal(const Ray& ray) const noexcept
+{
+  auto origin = ray.origin();
+  auto direction = ray.direction();
+  Transformation::affineTransform(to_local_, &origin);
+  Transformation::affineTransform(to_local_, &direction);
+  auto local_ray = Ray::makeRay(origin, direction);
+  const Float scale = zisc::invert(zisc::sqrt(area_scale_));
+  local_ray.setCone(scale * ray.coneWidth(), scale * ray.coneSpread());
+  return local_ray;
+}
+
+/*!
+  */
+void InstanceShape::transformShape(const Matrix4x4& matrix) noexcept
+{
+  to_world_ = matrix * to_world_;
+  initialize();
+}
+
+} // namespace nanairo
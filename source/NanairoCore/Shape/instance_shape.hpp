@@ -0,0 +1,119 @@
+/*!
+  \file instance_shape.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_INSTANCE_SHAPE_HPP
+#define NANAIRO_INSTANCE_SHAPE_HPP
+
+// Nanairo
+#include "shape.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/intersection_test_result.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class Bvh;
+class IntersectionInfo;
+class PathState;
+class Ray;
+class RayHit;
+class Sampler;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief An instance of a shared bottom-level BVH
+  \details
+  The objects of the bottom-level BVH are built in their local coordinate.
+  A ray is transformed into the local coordinate of the instance
+  and traverses the shared BVH, so the geometry is stored only once
+  regardless of the number of the instances.
+  */
+class InstanceShape : public Shape
+{
+ public:
+  //! Create an instance of the BVH
+  InstanceShape(const Bvh* bvh, const Float local_surface_area) noexcept;
+
+
+  //! Return the bounding box
+  Aabb boundingBox() const noexcept override;
+
+  //! Compute the surface attributes of the hit point in the bottom-level BVH
+  void computeSurfacePoint(const Ray& ray,
+                           const RayHit& hit,
+                           IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the shared bottom-level BVH
+  const Bvh& bvh() const noexcept;
+
+  //! The point of the instance isn't supported
+  ShapePoint getPoint(const Point2& st) const noexcept override;
+
+  //! Return the cost of a ray-instance intersection test
+  Float getTraversalCost() const noexcept override;
+
+  //! Test ray-instance intersection
+  IntersectionTestResult testIntersection(
+      const Ray& ray,
+      const Float max_distance,
+      Point2* st,
+      uint32* primitive_index) const noexcept override;
+
+  //! Test if the ray is occluded by the instance
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
+
+  //! Sampling on the instance isn't supported
+  ShapePoint samplePoint(Sampler& sampler,
+                         const PathState& path_state) const noexcept override;
+
+  //! Return the matrix to transform the local coordinate into world
+  const Matrix4x4& toWorldMatrix() const noexcept;
+
+  //! Return the type of the shape
+  ShapeType type() const noexcept override;
+
+ private:
+  //! Calculate the surface area of the front side of the instance
+  Float calcSurfaceArea() const noexcept override;
+
+  //! Initialize the instance
+  void initialize() noexcept;
+
+  //! Transform the ray into the local coordinate
+  Ray toLocal(const Ray& ray) const noexcept;
+
+  //! Apply affine transformation
+  void transformShape(const Matrix4x4& matrix) noexcept override;
+
+
+  const Bvh* bvh_;
+  Matrix4x4 to_world_;
+  Matrix4x4 to_local_;
+  Matrix3x3 normal_matrix_; //!< The transposed inverse matrix
+  Aabb bounding_box_;
+  Float local_surface_area_;
+  Float area_scale_;
+  uint8 is_mirrored_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "instance_shape-inl.hpp"
+
+#endif // NANAIRO_INSTANCE_SHAPE_HPP
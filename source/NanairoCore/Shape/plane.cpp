@@ -23,6 +23,7 @@
 #include "NanairoCore/Data/intersection_test_result.hpp"
 #include "NanairoCore/Data/path_state.hpp"
 #include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_hit.hpp"
 #include "NanairoCore/Data/shape_point.hpp"
 #include "NanairoCore/DataStructure/aabb.hpp"
 #include "NanairoCore/Geometry/point.hpp"
@@ -63,6 +64,45 @@ Aabb Plane::boundingBox() const noexcept
   return Aabb{Point3{min_point}, Point3{max_point}};
 }
 
+/*!
+  */
+void Plane::computeSurfacePoint(const Ray& ray,
+                                const RayHit& hit,
+                                IntersectionInfo* intersection) const noexcept
+{
+  ZISC_ASSERT(intersection != nullptr, "The intersection is null.");
+  const Float t = hit.rayDistance();
+  const auto point = ray.origin() + (t * ray.direction());
+  const Float cos_theta = -zisc::dot(normal(), ray.direction());
+  const bool is_back_face = cos_theta < 0.0;
+
+  const auto n = (!is_back_face) ? normal() : -normal();
+  const auto tangents = Transformation::calcDefaultTangent(n);
+  const auto& tangent = std::get<0>(tangents);
+  const auto& bitangent = std::get<1>(tangents);
+
+  intersection->setPoint(point);
+  intersection->setNormal(n);
+  intersection->setTangent(tangent);
+  intersection->setBitangent(bitangent);
+  intersection->setAsBackFace(is_back_face);
+  intersection->setRayDistance(t);
+  intersection->setSt(hit.st());
+  intersection->setUv(hit.st());
+  // The st coordinate is normalized by the lengths of the edges
+  const auto& e = edge();
+  const Float uv_footprint = ray.footprint(t) /
+      (zisc::abs(cos_theta) * zisc::sqrt(e[0].norm() * e[1].norm()));
+  intersection->setUvFootprint(uv_footprint);
+}
+
+/*!
+  */
+Vector3 Plane::flatNormal() const noexcept
+{
+  return normal();
+}
+
 /*!
   */
 ShapePoint Plane::getPoint(const Point2& st) const noexcept
@@ -96,18 +136,32 @@ Float Plane::getTraversalCost() const noexcept
  */
 IntersectionTestResult Plane::testIntersection(
     const Ray& ray,
-    IntersectionInfo* intersection) const noexcept
+    const Float max_distance,
+    Point2* st,
+    uint32* primitive_index) const noexcept
+{
+  ZISC_ASSERT(primitive_index != nullptr, "The primitive index is null.");
+  const auto result = testIntersection(vertex0(),
+                                       edge(),
+                                       normal(),
+                                       ray,
+                                       max_distance,
+                                       st);
+  *primitive_index = 0;
+  return result;
+}
+
+/*!
+  */
+bool Plane::testOcclusion(const Ray& ray, const Float max_distance) const noexcept
 {
   const bool is_hit = testIntersection(vertex0(),
                                        edge(),
                                        normal(),
                                        ray,
-                                       intersection->rayDistance(),
-                                       nullptr,
-                                       intersection);
-  return (is_hit)
-      ? IntersectionTestResult{intersection->rayDistance()}
-      : IntersectionTestResult{};
+                                       max_distance,
+                                       nullptr).isSuccess();
+  return is_hit;
 }
 
 /*!
@@ -115,22 +169,21 @@ IntersectionTestResult Plane::testIntersection(
   Please see the details of this algorithm below RUL.
   http://www.scratchapixel.com/lessons/3d-basic-lessons/lesson-7-intersecting-simple-shapes/ray-plane-and-ray-disk-intersection/
   */
-bool Plane::testIntersection(const Point3& v,
-                             const std::array<Vector3, 2>& e,
-                             const Vector3& normal,
-                             const Ray& ray,
-                             const Float max_distance,
-                             Point2* st,
-                             IntersectionInfo* intersection) noexcept
+IntersectionTestResult Plane::testIntersection(const Point3& v,
+                                               const std::array<Vector3, 2>& e,
+                                               const Vector3& normal,
+                                               const Ray& ray,
+                                               const Float max_distance,
+                                               Point2* st) noexcept
 {
   const Float cos_theta = -zisc::dot(normal, ray.direction());
   // In the case that the ray is parallel to the normal
   if (cos_theta == 0.0)
-    return false;
+    return IntersectionTestResult{};
   // Calculate the time that ray hit plane
   const Float t = zisc::dot(normal, ray.origin() - v) / cos_theta;
   if (!zisc::isInOpenBounds(t, 0.0, max_distance))
-    return false;
+    return IntersectionTestResult{};
   // Check if the hit point is in the plane
   const auto point = ray.origin() + (t * ray.direction());
   const auto am = point - v;
@@ -138,29 +191,11 @@ bool Plane::testIntersection(const Point3& v,
   const Float y = zisc::dot(am, e[1]);
   const bool is_hit = zisc::isInClosedBounds(x, 0.0, e[0].squareNorm()) &&
                       zisc::isInClosedBounds(y, 0.0, e[1].squareNorm());
-  if (is_hit) {
-    const Point2 st_coordinate{x / e[0].squareNorm(), y / e[1].squareNorm()};
-    if (st != nullptr)
-      *st = st_coordinate;
-    if (intersection != nullptr) {
-      const bool is_back_face = cos_theta < 0.0;
-
-      const auto n = (!is_back_face) ? normal : -normal;
-      const auto tangents = Transformation::calcDefaultTangent(n);
-      const auto& tangent = std::get<0>(tangents);
-      const auto& bitangent = std::get<1>(tangents);
-
-      intersection->setPoint(point);
-      intersection->setNormal(n);
-      intersection->setTangent(tangent);
-      intersection->setBitangent(bitangent);
-      intersection->setAsBackFace(is_back_face);
-      intersection->setRayDistance(t);
-      intersection->setSt(st_coordinate);
-      intersection->setUv(st_coordinate);
-    }
-  }
-  return is_hit;
+  if (is_hit && (st != nullptr))
+    *st = Point2{x / e[0].squareNorm(), y / e[1].squareNorm()};
+  return (is_hit)
+      ? IntersectionTestResult{t}
+      : IntersectionTestResult{};
 }
 
 /*!
@@ -189,6 +224,13 @@ ShapePoint Plane::samplePoint(Sampler& sampler,
                     st};
 }
 
+/*!
+  */
+ShapeType Plane::type() const noexcept
+{
+  return ShapeType::kPlane;
+}
+
 /*!
   */
 Vector3 Plane::calcNormal() const noexcept
@@ -27,6 +27,7 @@ class Aabb;
 class IntersectionInfo;
 class PathState;
 class Ray;
+class RayHit;
 class Sampler;
 
 //! \addtogroup Core 
@@ -47,6 +48,14 @@ class Plane : public Shape
   //! Return the bounding box
   Aabb boundingBox() const noexcept override;
 
+  //! Compute the surface attributes of the closest hit point
+  void computeSurfacePoint(const Ray& ray,
+                           const RayHit& hit,
+                           IntersectionInfo* intersection) const noexcept override;
+
+  //! Return the normal of the plane
+  Vector3 flatNormal() const noexcept override;
+
   //! Return the edges of the plane
   const std::array<Vector3, 2>& edge() const noexcept;
 
@@ -61,22 +70,30 @@ class Plane : public Shape
 
   //! Test ray-plane intersection
   IntersectionTestResult testIntersection(
-      const Ray& ray, 
-      IntersectionInfo* intersection) const noexcept override;
+      const Ray& ray,
+      const Float max_distance,
+      Point2* st,
+      uint32* primitive_index) const noexcept override;
+
+  //! Test if the ray is occluded by the plane
+  bool testOcclusion(const Ray& ray,
+                     const Float max_distance) const noexcept override;
 
   //! Test ray-plane intersection
-  static bool testIntersection(const Point3& v,
-                               const std::array<Vector3, 2>& e,
-                               const Vector3& normal,
-                               const Ray& ray, 
-                               const Float max_distance,
-                               Point2* st,
-                               IntersectionInfo* intersection = nullptr) noexcept;
+  static IntersectionTestResult testIntersection(const Point3& v,
+                                                 const std::array<Vector3, 2>& e,
+                                                 const Vector3& normal,
+                                                 const Ray& ray,
+                                                 const Float max_distance,
+                                                 Point2* st) noexcept;
 
   //! Sample a point randomly on the surface of the plane 
   ShapePoint samplePoint(Sampler& sampler,
                          const PathState& path_state) const noexcept override;
 
+  //! Return the type of the shape
+  ShapeType type() const noexcept override;
+
   //! Return the vertex of the plane
   const Point3& vertex0() const noexcept;
 
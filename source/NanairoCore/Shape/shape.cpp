@@ -15,6 +15,7 @@
 // Zisc
 #include "zisc/algorithm.hpp"
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
@@ -23,6 +24,7 @@
 #include "triangle_mesh.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoCore/Setting/single_object_setting_node.hpp"
@@ -42,18 +44,46 @@ Shape::~Shape() noexcept
 {
 }
 
+/*!
+  \details
+  A curved shape has no flat normal.
+  */
+Vector3 Shape::flatNormal() const noexcept
+{
+  return Vector3{0.0, 0.0, 0.0};
+}
+
+/*!
+  \details
+  A shape which has no solid angle sampling samples the points uniformly.
+  */
+ShapePoint Shape::sampleSolidAnglePoint(const Point3& /* reference */,
+                                        Sampler& sampler,
+                                        const PathState& path_state) const noexcept
+{
+  return samplePoint(sampler, path_state);
+}
+
+/*!
+  */
+Float Shape::solidAnglePointPdf(const Point3& /* reference */,
+                                const Point3& /* point */) const noexcept
+{
+  return zisc::invert(surfaceArea());
+}
+
 /*!
   \details
   No detailed.
   */
 zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
     System& system,
-    const SettingNodeBase* settings) noexcept
+    const SettingNodeBase* settings,
+    zisc::pmr::memory_resource* data_resource,
+    zisc::pmr::memory_resource* work_resource) noexcept
 {
   const auto object_settings = castNode<SingleObjectSettingNode>(settings);
 
-  auto data_resource = &system.dataMemoryManager();
-  auto work_resource = settings->workResource();
   zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> shape_list{work_resource};
   switch (object_settings->shapeType()) {
    case ShapeType::kPlane: {
@@ -62,7 +92,8 @@ zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
     break;
    }
    case ShapeType::kMesh: {
-    shape_list = TriangleMesh::makeMeshes(system, settings);
+    shape_list = TriangleMesh::makeMeshes(system, settings,
+                                          data_resource, work_resource);
     break;
    }
    default: {
@@ -73,6 +104,29 @@ zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
   return shape_list;
 }
 
+/*!
+  \details
+  A mesh transforms its vertex buffer before the triangles are made.
+  */
+zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> Shape::makeShape(
+    System& system,
+    const SettingNodeBase* settings,
+    const Matrix4x4& matrix,
+    zisc::pmr::memory_resource* data_resource,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  const auto object_settings = castNode<SingleObjectSettingNode>(settings);
+  if (object_settings->shapeType() == ShapeType::kMesh) {
+    return TriangleMesh::makeMeshes(system, settings, matrix,
+                                    data_resource, work_resource);
+  }
+
+  auto shape_list = makeShape(system, settings, data_resource, work_resource);
+  for (auto& shape : shape_list)
+    shape->transform(matrix);
+  return shape_list;
+}
+
 /*!
   \details
   No detailed.
@@ -33,6 +33,7 @@ class Aabb;
 class IntersectionInfo;
 class PathState;
 class Ray;
+class RayHit;
 class Sampler;
 class System;
 
@@ -44,7 +45,8 @@ class System;
 enum class ShapeType : uint32
 {
   kPlane                      = zisc::Fnv1aHash32::hash("Plane"),
-  kMesh                       = zisc::Fnv1aHash32::hash("Mesh")
+  kMesh                       = zisc::Fnv1aHash32::hash("Mesh"),
+  kInstance                   = zisc::Fnv1aHash32::hash("Instance")
 };
 
 /*!
@@ -64,6 +66,15 @@ class Shape
   //! Return the bounding box
   virtual Aabb boundingBox() const noexcept = 0;
 
+  //! Compute the surface attributes of the closest hit point
+  virtual void computeSurfacePoint(
+      const Ray& ray,
+      const RayHit& hit,
+      IntersectionInfo* intersection) const noexcept = 0;
+
+  //! Return the normal of all points of a flat shape, otherwise the zero vector
+  virtual Vector3 flatNormal() const noexcept;
+
   //! Return the point and the normal by the st coordinate
   virtual ShapePoint getPoint(const Point2& st) const noexcept = 0;
 
@@ -73,26 +84,54 @@ class Shape
   //! Make geometries
   static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeShape(
       System& system,
-      const SettingNodeBase* settings) noexcept;
+      const SettingNodeBase* settings,
+      zisc::pmr::memory_resource* data_resource,
+      zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Make geometries in the world coordinate of the transformation
+  static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeShape(
+      System& system,
+      const SettingNodeBase* settings,
+      const Matrix4x4& matrix,
+      zisc::pmr::memory_resource* data_resource,
+      zisc::pmr::memory_resource* work_resource) noexcept;
 
   //! Return the surface area of the shape
   Float surfaceArea() const noexcept;
 
-  //! Test ray-shape intersection
+  //! Test ray-shape intersection without computing the surface attributes
   virtual IntersectionTestResult testIntersection(
       const Ray& ray,
-      IntersectionInfo* intersection) const noexcept = 0;
+      const Float max_distance,
+      Point2* st,
+      uint32* primitive_index) const noexcept = 0;
+
+  //! Test if the ray is occluded by the shape within the max distance
+  virtual bool testOcclusion(const Ray& ray,
+                             const Float max_distance) const noexcept = 0;
 
   //! Sample a point randomly on the surface of the shape
   virtual ShapePoint samplePoint(Sampler& sampler,
                                  const PathState& path_state) const noexcept = 0;
 
+  //! Sample a point by the solid angle which the shape subtends at the reference
+  virtual ShapePoint sampleSolidAnglePoint(const Point3& reference,
+                                           Sampler& sampler,
+                                           const PathState& path_state) const noexcept;
+
+  //! Return the pdf (area measure) of sampling the point by the solid angle
+  virtual Float solidAnglePointPdf(const Point3& reference,
+                                   const Point3& point) const noexcept;
+
   //! Set surface area of shape
   void setSurfaceArea(const Float surface_area) noexcept;
 
   //! Apply affine transformation
   void transform(const Matrix4x4& matrix) noexcept;
 
+  //! Return the type of the shape
+  virtual ShapeType type() const noexcept = 0;
+
  protected:
   //! Calculate the surface area of the front side of the shape
   virtual Float calcSurfaceArea() const noexcept = 0;
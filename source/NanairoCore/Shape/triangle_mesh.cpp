@@ -11,6 +11,8 @@
 // Standard C++ library
 #include <array>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 // Zisc
@@ -24,6 +26,7 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Data/face.hpp"
+#include "NanairoCore/Data/mesh_file.hpp"
 #include "NanairoCore/Geometry/point.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
@@ -38,21 +41,65 @@ namespace nanairo  {
   */
 zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> TriangleMesh::makeMeshes(
     System& system,
-    const SettingNodeBase* settings) noexcept
+    const SettingNodeBase* settings,
+    zisc::pmr::memory_resource* data_resource,
+    zisc::pmr::memory_resource* work_resource) noexcept
 {
-  const auto object_settings = castNode<SingleObjectSettingNode>(settings);
+  const Matrix4x4* matrix = nullptr;
+  return makeMeshes(system, settings, matrix, data_resource, work_resource);
+}
+
+/*!
+  \details
+  The shared vertices are transformed in a buffer before the triangles are
+  made, instead of transforming the triangles one by one after they are made.
+  */
+zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> TriangleMesh::makeMeshes(
+    System& system,
+    const SettingNodeBase* settings,
+    const Matrix4x4& matrix,
+    zisc::pmr::memory_resource* data_resource,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  return makeMeshes(system, settings, &matrix, data_resource, work_resource);
+}
 
-  auto data_resource = &system.dataMemoryManager();
-  auto work_resource = settings->workResource();
+/*!
+  \details
+  No detailed.
+  */
+zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> TriangleMesh::makeMeshes(
+    System& system,
+    const SettingNodeBase* settings,
+    const Matrix4x4* matrix,
+    zisc::pmr::memory_resource* data_resource,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  const auto object_settings = castNode<SingleObjectSettingNode>(settings);
 
   const auto& parameters = object_settings->meshParameters();
+  if (!parameters.mesh_file_path_.empty()) {
+    return makeMeshes(system, parameters.mesh_file_path_, matrix,
+                      data_resource, work_resource);
+  }
+
+  zisc::pmr::vector<Point3> vertex_list{work_resource};
+  vertex_list.reserve(parameters.vertex_list_.size());
+  for (const auto& vertex_data : parameters.vertex_list_) {
+    vertex_list.emplace_back(Point3{zisc::cast<Float>(vertex_data[0]),
+                                    zisc::cast<Float>(vertex_data[1]),
+                                    zisc::cast<Float>(vertex_data[2])});
+  }
+  if (matrix != nullptr)
+    Transformation::affineTransform(system, *matrix, &vertex_list);
+
   zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> mesh_list{work_resource};
   mesh_list.reserve(parameters.face_list_.size());
 
   //! \todo Add smoothed mesh
   //! \todo Add quadrangle mesh
   for (const auto& face : parameters.face_list_) {
-    const auto vertices = getVertices(parameters, face);
+    const auto vertices = getVertices(vertex_list, face);
     // Skip invisible mesh
     if (FlatTriangle::calcSurfaceArea(vertices[0], vertices[1], vertices[2]) <= 0.0)
       continue;
@@ -69,22 +116,72 @@ zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> TriangleMesh::makeMeshes(
   return mesh_list;
 }
 
+/*!
+  \details
+  The triangles are made directly from the mapped file,
+  only the vertices are copied into a buffer which is transformed.
+  */
+zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> TriangleMesh::makeMeshes(
+    System& system,
+    const std::string_view& file_path,
+    const Matrix4x4* matrix,
+    zisc::pmr::memory_resource* data_resource,
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  MeshFile mesh_file;
+  if (!mesh_file.open(std::string{file_path})) {
+    zisc::raiseError("MeshError: The mesh file '", file_path,
+                     "' open failed.");
+  }
+
+  zisc::pmr::vector<Point3> vertex_list{work_resource};
+  vertex_list.reserve(mesh_file.numOfVertices());
+  for (uint32 index = 0; index < mesh_file.numOfVertices(); ++index) {
+    const auto& vertex = mesh_file.vertex(index);
+    vertex_list.emplace_back(Point3{zisc::cast<Float>(vertex[0]),
+                                    zisc::cast<Float>(vertex[1]),
+                                    zisc::cast<Float>(vertex[2])});
+  }
+  if (matrix != nullptr)
+    Transformation::affineTransform(system, *matrix, &vertex_list);
+
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> mesh_list{work_resource};
+  mesh_list.reserve(mesh_file.numOfTriangles());
+  for (uint32 index = 0; index < mesh_file.numOfTriangles(); ++index) {
+    const auto& triangle = mesh_file.triangle(index);
+    std::array<Point3, 3> vertices;
+    for (uint i = 0; i < 3; ++i)
+      vertices[i] = vertex_list[triangle.vertex_[i]];
+    // Skip invisible mesh
+    if (FlatTriangle::calcSurfaceArea(vertices[0], vertices[1], vertices[2]) <= 0.0)
+      continue;
+    auto mesh = zisc::UniqueMemoryPointer<FlatTriangle>::make(data_resource,
+                                                              vertices[0],
+                                                              vertices[1],
+                                                              vertices[2]);
+    if (MeshFile::hasUv(triangle)) {
+      std::array<Point2, 3> uvs;
+      for (uint i = 0; i < 3; ++i) {
+        const auto& uv = mesh_file.uv(triangle.uv_[i]);
+        uvs[i] = Point2{zisc::cast<Float>(uv[0]), zisc::cast<Float>(uv[1])};
+      }
+      mesh->setUv(uvs[0], uvs[1], uvs[2]);
+    }
+    mesh_list.emplace_back(std::move(mesh));
+  }
+  return mesh_list;
+}
+
 /*!
   */
 std::array<Point3, 3> TriangleMesh::getVertices(
-    const MeshParameters& parameters,
+    const zisc::pmr::vector<Point3>& vertex_list,
     const Face& face) noexcept
 {
+  const auto& vertex_indices = face.triangleVertexIndices();
   std::array<Point3, 3> vertices;
-  {
-    const auto& vertex_indices = face.triangleVertexIndices();
-    for (uint i = 0; i < 3; ++i) {
-      auto& vertex = vertices[i];
-      const auto& vertex_data = parameters.vertex_list_[vertex_indices[i]];
-      for (uint axis = 0; axis < 3; ++axis)
-        vertex[axis] = zisc::cast<Float>(vertex_data[axis]);
-    }
-  }
+  for (uint i = 0; i < 3; ++i)
+    vertices[i] = vertex_list[vertex_indices[i]];
   return vertices;
 }
 
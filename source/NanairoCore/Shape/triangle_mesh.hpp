@@ -12,6 +12,7 @@
 
 // Standard C++ library
 #include <memory>
+#include <string_view>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -54,12 +55,39 @@ class TriangleMesh
   //! Make meshes
   static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeMeshes(
       System& system,
-      const SettingNodeBase* settings) noexcept;
+      const SettingNodeBase* settings,
+      zisc::pmr::memory_resource* data_resource,
+      zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Make meshes in the world coordinate of the transformation
+  static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeMeshes(
+      System& system,
+      const SettingNodeBase* settings,
+      const Matrix4x4& matrix,
+      zisc::pmr::memory_resource* data_resource,
+      zisc::pmr::memory_resource* work_resource) noexcept;
 
  private:
+  //! Make meshes whose vertices are transformed if the matrix isn't null
+  static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeMeshes(
+      System& system,
+      const SettingNodeBase* settings,
+      const Matrix4x4* matrix,
+      zisc::pmr::memory_resource* data_resource,
+      zisc::pmr::memory_resource* work_resource) noexcept;
+
+  //! Make meshes from the mesh file
+  static zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>> makeMeshes(
+      System& system,
+      const std::string_view& file_path,
+      const Matrix4x4* matrix,
+      zisc::pmr::memory_resource* data_resource,
+      zisc::pmr::memory_resource* work_resource) noexcept;
+
   //! Return the vertices of the face
-  static std::array<Point3, 3> getVertices(const MeshParameters& parameters,
-                                           const Face& face) noexcept;
+  static std::array<Point3, 3> getVertices(
+      const zisc::pmr::vector<Point3>& vertex_list,
+      const Face& face) noexcept;
 
   //! Return the UVs of the face
   static std::array<Point2, 3> getUvs(const MeshParameters& parameters,
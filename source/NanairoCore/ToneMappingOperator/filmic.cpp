@@ -39,4 +39,11 @@ Float Filmic::tonemap(const Float x) const noexcept
   return (x * (a * x + b)) / (x * (c * x + d) + e);
 }
 
+/*!
+  */
+ToneMappingType Filmic::type() const noexcept
+{
+  return ToneMappingType::kFilmic;
+}
+
 } // namespace nanairo
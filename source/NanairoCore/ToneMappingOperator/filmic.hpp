@@ -34,6 +34,9 @@ class Filmic : public ToneMappingOperator
   Filmic(const System& system, const SettingNodeBase* settings) noexcept;
 
 
+  //! Return the type of the tone curve
+  ToneMappingType type() const noexcept override;
+
  private:
   //! Apply a filmic tonemap curve
   Float tonemap(const Float x) const noexcept override;
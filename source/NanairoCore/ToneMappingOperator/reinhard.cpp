@@ -32,4 +32,11 @@ Float Reinhard::tonemap(const Float x) const noexcept
   return x / (1.0 + x);
 }
 
+/*!
+  */
+ToneMappingType Reinhard::type() const noexcept
+{
+  return ToneMappingType::kReinhard;
+}
+
 } // namespace nanairo
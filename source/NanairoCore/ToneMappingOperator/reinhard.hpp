@@ -33,6 +33,9 @@ class Reinhard : public ToneMappingOperator
   //! Initialize reinhard method
   Reinhard(const System& system, const SettingNodeBase* settings) noexcept;
 
+  //! Return the type of the tone curve
+  ToneMappingType type() const noexcept override;
+
  private:
   //! Apply a reinhard tonemap curve
   Float tonemap(const Float x) const noexcept override;
@@ -11,6 +11,8 @@
 #define NANAIRO_TONE_MAPPING_OPERATOR_INL_HPP
 
 #include "tone_mapping_operator.hpp"
+// Standard C++ library
+#include <algorithm>
 // Zisc
 #include "zisc/error.hpp"
 #include "zisc/utility.hpp"
@@ -37,6 +39,37 @@ Float ToneMappingOperator::inverseGamma() const noexcept
   return inverse_gamma_;
 }
 
+/*!
+  \details
+  The table is sampled uniformly in x / (1 + x) which maps the exposed
+  luminance [0, inf) to [0, 1), and the samples are interpolated linearly.
+  */
+inline
+float ToneMappingOperator::lookUpCurve(const float x) const noexcept
+{
+  const float u = x / (1.0f + x);
+  const float t = u * zisc::cast<float>(kCurveTableSize - 1);
+  const uint index = std::min(zisc::cast<uint>(t), kCurveTableSize - 2);
+  const float f = t - zisc::cast<float>(index);
+  const float l = curve_table_[index];
+  return l + f * (curve_table_[index + 1] - l);
+}
+
+/*!
+  \details
+  The level is the number of the thresholds which are less than or equal to c,
+  which is found by a binary search of fixed 8 steps without branches.
+  It is equivalent to truncating the gamma corrected component times 255.
+  */
+inline
+uint8 ToneMappingOperator::quantize(const float c) const noexcept
+{
+  uint level = 0;
+  for (uint step = 128; 0 < step; step = step >> 1)
+    level += (level_threshold_table_[level + step] <= c) ? step : 0;
+  return zisc::cast<uint8>(level);
+}
+
 } // namespace nanairo
 
 #endif // NANAIRO_TONE_MAPPING_OPERATOR_INL_HPP
@@ -9,6 +9,8 @@
 
 #include "tone_mapping_operator.hpp"
 // Standard C++ library
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <vector>
 // Zisc
@@ -24,15 +26,16 @@
 #include "reinhard.hpp"
 #include "uncharted2_filmic.hpp"
 #include "NanairoCore/system.hpp"
-#include "NanairoCore/Color/color_conversion.hpp"
 #include "NanairoCore/Color/color_space.hpp"
 #include "NanairoCore/Color/hdr_image.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
 #include "NanairoCore/Color/rgba_32.hpp"
-#include "NanairoCore/Color/yxy_color.hpp"
+#include "NanairoCore/Color/xyz_color.hpp"
+#include "NanairoCore/Data/rendering_tile.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Setting/system_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
 
 namespace nanairo {
 
@@ -56,52 +59,54 @@ ToneMappingOperator::~ToneMappingOperator() noexcept
 
 /*!
   \details
-  No detailed.
+  The tone mapping curve is local to each pixel,
+  so only the dirty tiles of the HDR image are mapped
+  and the other tiles of the LDR image are kept.
+  The pixels are written in the channel order of the LDR image,
+  so the encoders read the image without converting it.
+  The pixels of a tile are mapped in batches,
+  so the loops of a batch can be vectorized by the compiler.
   */
 void ToneMappingOperator::map(System& system,
                               const HdrImage& hdr_image,
-                              LdrImage* ldr_image) const noexcept
+                              LdrImage* ldr_image,
+                              zisc::pmr::memory_resource* work_resource) const noexcept
 {
   ZISC_ASSERT(ldr_image != nullptr, "The LDR image is null.");
   ZISC_ASSERT(hdr_image.widthResolution() == ldr_image->widthResolution(),
               "The image width is difference between HDR and LDR images.");
   ZISC_ASSERT(hdr_image.heightResolution() == ldr_image->heightResolution(),
               "The image height is difference between HDR and LDR images.");
-  auto map_luminance = [this, &system, &hdr_image, ldr_image](const uint task_id)
+  TraceRecorder::Scope scope{system.traceRecorder(), "Tone mapping"};
+  const auto order = ldr_image->channelOrder();
+  auto map_luminance = [this, &system, &hdr_image, ldr_image, order](const uint task_id)
   {
+    TraceRecorder::Scope task_scope{system.traceRecorder(), "Tone mapping task"};
     // Set the calculation range
-    const auto range = system.calcTaskRange(hdr_image.numOfPixels(), task_id);
-    // Apply tonemap to each pixel
-    for (uint index = range[0]; index < range[1]; ++index) {
-      auto rgba32 = Rgba32{};
-      if (0.0 < hdr_image[index].y()) {
-        auto xyz = hdr_image[index];
-        // Tone mapping
-        {
-          auto yxy = ColorConversion::toYxy(xyz);
-          const Float l = tonemap(exposure() * yxy.Y());
-          yxy.Y() = zisc::clamp(l, 0.0, 1.0);
-          xyz = ColorConversion::toXyz(yxy);
-        }
-        // Convert XYZ to RGB
-        {
-          const auto to_rgb_matrix = getXyzToRgbMatrix(system.colorSpace());
-          auto rgb = ColorConversion::toRgb(xyz, to_rgb_matrix);
-          rgb.clampAll(0.0, 1.0);
-          rgb.correctGamma(inverseGamma());
-          rgba32 = ColorConversion::toIntRgb(rgb);
+    const auto range = system.calcTaskRange(hdr_image.numOfTiles(), task_id);
+    // Apply tonemap to the pixels of the dirty tiles in batches
+    std::array<Index2d, kBatchSize> pixel_list;
+    for (uint tile_index = range[0]; tile_index < range[1]; ++tile_index) {
+      if (!hdr_image.isDirtyTile(tile_index))
+        continue;
+      auto tile = hdr_image.getTile(tile_index);
+      const uint num_of_pixels = tile.numOfPixels();
+      for (uint i = 0; i < num_of_pixels; i += kBatchSize) {
+        const uint n = std::min(kBatchSize, num_of_pixels - i);
+        for (uint lane = 0; lane < n; ++lane) {
+          pixel_list[lane] = tile.current();
+          tile.next();
         }
+        mapPixels(hdr_image, pixel_list, n, order, ldr_image);
       }
-      ldr_image->get(index) = rgba32;
     }
   };
 
   {
     auto& threads = system.threadManager();
-    auto& work_resource = system.globalMemoryManager();
     constexpr uint begin = 0;
     const uint end = threads.numOfThreads();
-    auto result = threads.enqueueLoop(map_luminance, begin, end, &work_resource);
+    auto result = threads.enqueueLoop(map_luminance, begin, end, work_resource);
     result.wait();
   }
 }
@@ -118,6 +123,21 @@ void ToneMappingOperator::initialize(const System& system,
   // Gamma
   {
     inverse_gamma_ = zisc::invert(system.gamma());
+    // The linear value where the gamma corrected value reaches each 8bit level
+    const Float gamma = system.gamma();
+    level_threshold_table_[0] = 0.0f;
+    for (uint level = 1; level < level_threshold_table_.size(); ++level) {
+      const Float c = zisc::cast<Float>(level) / 255.0;
+      level_threshold_table_[level] = zisc::cast<float>(zisc::pow(c, gamma));
+    }
+  }
+  // Color space
+  {
+    const auto to_rgb_matrix = getXyzToRgbMatrix(system.colorSpace());
+    for (uint row = 0; row < 3; ++row) {
+      for (uint column = 0; column < 3; ++column)
+        to_rgb_matrix_[3 * row + column] = zisc::cast<float>(to_rgb_matrix(row, column));
+    }
   }
   // Exposure
   {
@@ -160,7 +180,75 @@ zisc::UniqueMemoryPointer<ToneMappingOperator> ToneMappingOperator::makeOperator
     zisc::raiseError("ToneMappingError: Unsupprted type is specified.");
    }
   }
+  method->initCurveTable();
   return method;
 }
 
+/*!
+  \details
+  The virtual tone curve can't be evaluated in the base constructor,
+  so the table is made after the operator is made.
+  The last sample is the limit of the curve at a large luminance.
+  */
+void ToneMappingOperator::initCurveTable() noexcept
+{
+  for (uint index = 0; index < kCurveTableSize; ++index) {
+    const Float u = zisc::cast<Float>(index) / zisc::cast<Float>(kCurveTableSize - 1);
+    const Float x = (index + 1 < kCurveTableSize) ? u / (1.0 - u) : 1.0e8;
+    curve_table_[index] = zisc::cast<float>(zisc::clamp(tonemap(x), 0.0, 1.0));
+  }
+}
+
+/*!
+  \details
+  The tone curve keeps the chromaticity and replaces the luminance,
+  so the XYZ color is scaled by the ratio of the mapped luminance.
+  The batch is processed lane by lane in each step in single precision.
+  */
+void ToneMappingOperator::mapPixels(
+    const HdrImage& hdr_image,
+    const std::array<Index2d, kBatchSize>& pixel_list,
+    const uint num_of_pixels,
+    const LdrImage::ChannelOrder order,
+    LdrImage* ldr_image) const noexcept
+{
+  std::array<float, 3 * kBatchSize> xyz;
+  xyz.fill(0.0f);
+  for (uint lane = 0; lane < num_of_pixels; ++lane) {
+    const auto& color = hdr_image.get(pixel_list[lane]);
+    for (uint i = 0; i < 3; ++i)
+      xyz[i * kBatchSize + lane] = zisc::cast<float>(color[i]);
+  }
+
+  // Tone mapping
+  std::array<float, kBatchSize> scale;
+  const float e = zisc::cast<float>(exposure());
+  for (uint lane = 0; lane < kBatchSize; ++lane) {
+    const float y = xyz[kBatchSize + lane];
+    const float l = lookUpCurve(e * std::max(y, 0.0f));
+    scale[lane] = (0.0f < y) ? l / y : 0.0f;
+  }
+
+  // Convert XYZ to RGB and quantize
+  std::array<uint8, 3 * kBatchSize> rgb;
+  for (uint i = 0; i < 3; ++i) {
+    const float* m = &to_rgb_matrix_[3 * i];
+    for (uint lane = 0; lane < kBatchSize; ++lane) {
+      const float c = scale[lane] * (m[0] * xyz[lane] +
+                                     m[1] * xyz[kBatchSize + lane] +
+                                     m[2] * xyz[2 * kBatchSize + lane]);
+      rgb[i * kBatchSize + lane] = quantize(c);
+    }
+  }
+
+  for (uint lane = 0; lane < num_of_pixels; ++lane) {
+    const uint8 r = rgb[lane],
+                g = rgb[kBatchSize + lane],
+                b = rgb[2 * kBatchSize + lane];
+    ldr_image->get(pixel_list[lane]) = (order == LdrImage::ChannelOrder::kRgba)
+        ? Rgba32{b, g, r}
+        : Rgba32{r, g, b};
+  }
+}
+
 } // namespace nanairo
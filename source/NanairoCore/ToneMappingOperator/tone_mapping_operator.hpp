@@ -11,6 +11,7 @@
 #define NANAIRO_TONE_MAPPING_OPERATOR_HPP
 
 // Standard C++ library
+#include <array>
 #include <memory>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -18,14 +19,16 @@
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
 namespace nanairo {
 
 // Forward declaration
 class HdrImage;
-class LdrImage;
 class System;
+class XyzColor;
 
 //! \addtogroup Core
 //! \{
@@ -40,7 +43,9 @@ enum class ToneMappingType : uint32
 /*!
   \brief The interface of tone mapping class.
   \details
-  No detailed.
+  The tone curve of the luminance is tabulated when the operator is made,
+  and the gamma correction and the quantization are done by the thresholds
+  of the 8bit levels, so the map doesn't evaluate any curve or power.
   */
 class ToneMappingOperator
 {
@@ -66,16 +71,43 @@ class ToneMappingOperator
   //! Apply a tonemapping operator
   void map(System& system,
            const HdrImage& hdr_image,
-           LdrImage* ldr_image) const noexcept;
+           LdrImage* ldr_image,
+           zisc::pmr::memory_resource* work_resource) const noexcept;
 
   //! Apply a tonemap curve
   virtual Float tonemap(const Float x) const noexcept = 0;
 
+  //! Return the type of the tone curve
+  virtual ToneMappingType type() const noexcept = 0;
+
  private:
+  static constexpr uint kBatchSize = 8; //!< The number of the pixels mapped at once
+  static constexpr uint kCurveTableSize = 1025; //!< The samples of the tone curve
+
+
   //! Initialize
   void initialize(const System& system, const SettingNodeBase* settings) noexcept;
 
+  //! Tabulate the tone curve
+  void initCurveTable() noexcept;
+
+  //! Return the tone mapped luminance of the exposed luminance from the table
+  float lookUpCurve(const float x) const noexcept;
+
+  //! Map a batch of HDR pixels to the LDR pixels of the channel order
+  void mapPixels(const HdrImage& hdr_image,
+                 const std::array<Index2d, kBatchSize>& pixel_list,
+                 const uint num_of_pixels,
+                 const LdrImage::ChannelOrder order,
+                 LdrImage* ldr_image) const noexcept;
+
+  //! Quantize a linear color component into the gamma corrected 8bit level
+  uint8 quantize(const float c) const noexcept;
+
 
+  std::array<float, kCurveTableSize> curve_table_;
+  std::array<float, 256> level_threshold_table_;
+  std::array<float, 9> to_rgb_matrix_;
   Float inverse_gamma_;
   Float exposure_;
 };
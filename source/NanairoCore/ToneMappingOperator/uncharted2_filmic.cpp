@@ -39,4 +39,11 @@ Float Uncharted2Filmic::tonemap(const Float x) const noexcept
   return (x * (a * x + c * b) + d * e) / (x * (a * x + b) + d * f) - e / f;
 }
 
+/*!
+  */
+ToneMappingType Uncharted2Filmic::type() const noexcept
+{
+  return ToneMappingType::kUncharted2Filmic;
+}
+
 } // namespace nanairo
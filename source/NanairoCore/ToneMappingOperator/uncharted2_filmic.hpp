@@ -33,6 +33,9 @@ class Uncharted2Filmic : public ToneMappingOperator
   //! Initialize reinhard method
   Uncharted2Filmic(const System& system, const SettingNodeBase* settings) noexcept;
 
+  //! Return the type of the tone curve
+  ToneMappingType type() const noexcept override;
+
  private:
   //! Apply a uncharted2 tonemap curve
   Float tonemap(const Float x) const noexcept override;
@@ -0,0 +1,142 @@
+/*!
+  \file hardware_counter-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_HARDWARE_COUNTER_INL_HPP
+#define NANAIRO_HARDWARE_COUNTER_INL_HPP
+
+#include "hardware_counter.hpp"
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+HardwareCounts::HardwareCounts() noexcept
+{
+  count_list_.fill(0);
+  valid_list_.fill(kFalse);
+}
+
+/*!
+  */
+inline
+uint64 HardwareCounts::count(const HardwareEvent event) const noexcept
+{
+  const uint index = zisc::cast<uint>(event);
+  ZISC_ASSERT(index < numOfEvents(), "The event is out of range.");
+  return count_list_[index];
+}
+
+/*!
+  */
+inline
+double HardwareCounts::instructionsPerCycle() const noexcept
+{
+  const uint64 cycles = count(HardwareEvent::kCycles);
+  return (0 < cycles)
+      ? zisc::cast<double>(count(HardwareEvent::kInstructions)) /
+        zisc::cast<double>(cycles)
+      : 0.0;
+}
+
+/*!
+  */
+inline
+bool HardwareCounts::isValid() const noexcept
+{
+  for (const auto is_valid : valid_list_) {
+    if (is_valid)
+      return true;
+  }
+  return false;
+}
+
+/*!
+  */
+inline
+bool HardwareCounts::isValid(const HardwareEvent event) const noexcept
+{
+  const uint index = zisc::cast<uint>(event);
+  ZISC_ASSERT(index < numOfEvents(), "The event is out of range.");
+  return valid_list_[index] == kTrue;
+}
+
+/*!
+  */
+inline
+void HardwareCounts::merge(const HardwareCounts& other) noexcept
+{
+  for (uint index = 0; index < numOfEvents(); ++index) {
+    count_list_[index] += other.count_list_[index];
+    valid_list_[index] = (valid_list_[index] || other.valid_list_[index])
+        ? kTrue
+        : kFalse;
+  }
+}
+
+/*!
+  */
+inline
+constexpr uint HardwareCounts::numOfEvents() noexcept
+{
+  return 6;
+}
+
+/*!
+  */
+inline
+void HardwareCounts::setCount(const HardwareEvent event,
+                              const uint64 count) noexcept
+{
+  const uint index = zisc::cast<uint>(event);
+  ZISC_ASSERT(index < numOfEvents(), "The event is out of range.");
+  count_list_[index] = count;
+  valid_list_[index] = kTrue;
+}
+
+/*!
+  \details
+  The scaled counts of the multiplexed events can decrease slightly,
+  so the difference is clamped to zero.
+  */
+inline
+HardwareCounts HardwareCounts::since(const HardwareCounts& start) const noexcept
+{
+  HardwareCounts counts;
+  for (uint index = 0; index < numOfEvents(); ++index) {
+    const uint64 end_count = count_list_[index];
+    const uint64 start_count = start.count_list_[index];
+    counts.count_list_[index] = (start_count < end_count)
+        ? end_count - start_count
+        : 0;
+    counts.valid_list_[index] = valid_list_[index];
+  }
+  return counts;
+}
+
+/*!
+  */
+inline
+constexpr bool HardwareCounter::isSupported() noexcept
+{
+#if defined(__linux__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_HARDWARE_COUNTER_INL_HPP
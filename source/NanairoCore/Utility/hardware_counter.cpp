@@ -0,0 +1,194 @@
+/*!
+  \file hardware_counter.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "hardware_counter.hpp"
+// Standard C++ library
+#include <array>
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+namespace {
+
+#if defined(__linux__)
+
+//! Return the type and the config of the perf event of the event
+std::array<uint64, 2> getPerfEvent(const HardwareEvent event) noexcept
+{
+  constexpr uint64 read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  std::array<uint64, 2> perf_event{{PERF_TYPE_HARDWARE, 0}};
+  switch (event) {
+   case HardwareEvent::kCycles:
+    perf_event[1] = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+   case HardwareEvent::kInstructions:
+    perf_event[1] = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+   case HardwareEvent::kL1dMisses:
+    perf_event = {{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | read_miss}};
+    break;
+   case HardwareEvent::kLlcMisses:
+    perf_event[1] = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+   case HardwareEvent::kBranchMisses:
+    perf_event[1] = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+   case HardwareEvent::kTlbMisses:
+    perf_event = {{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | read_miss}};
+    break;
+   default:
+    ZISC_ASSERT(false, "The event is invalid.");
+    break;
+  }
+  return perf_event;
+}
+
+#endif // __linux__
+
+} // namespace
+
+/*!
+  */
+const char* HardwareCounts::eventName(const HardwareEvent event) noexcept
+{
+  const char* name = nullptr;
+  switch (event) {
+   case HardwareEvent::kCycles:
+    name = "cycles";
+    break;
+   case HardwareEvent::kInstructions:
+    name = "instructions";
+    break;
+   case HardwareEvent::kL1dMisses:
+    name = "l1d_misses";
+    break;
+   case HardwareEvent::kLlcMisses:
+    name = "llc_misses";
+    break;
+   case HardwareEvent::kBranchMisses:
+    name = "branch_misses";
+    break;
+   case HardwareEvent::kTlbMisses:
+    name = "dtlb_misses";
+    break;
+   default:
+    ZISC_ASSERT(false, "The event is invalid.");
+    break;
+  }
+  return name;
+}
+
+/*!
+  */
+HardwareCounter::HardwareCounter() noexcept
+{
+  fd_list_.fill(-1);
+}
+
+/*!
+  */
+HardwareCounter::~HardwareCounter() noexcept
+{
+  close();
+}
+
+/*!
+  */
+void HardwareCounter::close() noexcept
+{
+  for (auto& fd : fd_list_) {
+#if defined(__linux__)
+    if (fd != -1)
+      ::close(fd);
+#endif
+    fd = -1;
+  }
+}
+
+/*!
+  */
+bool HardwareCounter::isOpened() const noexcept
+{
+  for (const int fd : fd_list_) {
+    if (fd != -1)
+      return true;
+  }
+  return false;
+}
+
+/*!
+  \details
+  The events are opened separately instead of a group,
+  so the events which exceed the counters of the processor
+  are multiplexed and scaled instead of failing all events.
+  An event which the processor doesn't have is left closed.
+  */
+bool HardwareCounter::open() noexcept
+{
+  close();
+#if defined(__linux__)
+  for (uint index = 0; index < HardwareCounts::numOfEvents(); ++index) {
+    const auto perf_event = getPerfEvent(zisc::cast<HardwareEvent>(index));
+    perf_event_attr attribute;
+    std::memset(&attribute, 0, sizeof(attribute));
+    attribute.size = sizeof(attribute);
+    attribute.type = zisc::cast<uint32>(perf_event[0]);
+    attribute.config = perf_event[1];
+    attribute.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                            PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attribute.exclude_kernel = 1;
+    attribute.exclude_hv = 1;
+    // The counter counts the calling thread on any cpu
+    const long fd = syscall(__NR_perf_event_open, &attribute, 0, -1, -1, 0);
+    fd_list_[index] = (0 <= fd) ? zisc::cast<int>(fd) : -1;
+  }
+#endif
+  return isOpened();
+}
+
+/*!
+  \details
+  The count of a multiplexed event is scaled by the ratio of
+  the enabled time to the running time.
+  */
+HardwareCounts HardwareCounter::read() const noexcept
+{
+  HardwareCounts counts;
+#if defined(__linux__)
+  for (uint index = 0; index < HardwareCounts::numOfEvents(); ++index) {
+    const int fd = fd_list_[index];
+    if (fd == -1)
+      continue;
+    std::array<uint64, 3> value{{0, 0, 0}}; // value, enabled, running
+    const auto size = ::read(fd, value.data(), sizeof(value));
+    if (size != zisc::cast<ssize_t>(sizeof(value)))
+      continue;
+    const uint64 count = ((0 < value[2]) && (value[2] < value[1]))
+        ? zisc::cast<uint64>(zisc::cast<double>(value[0]) *
+                             (zisc::cast<double>(value[1]) /
+                              zisc::cast<double>(value[2])))
+        : value[0];
+    counts.setCount(zisc::cast<HardwareEvent>(index), count);
+  }
+#endif
+  return counts;
+}
+
+} // namespace nanairo
@@ -0,0 +1,125 @@
+/*!
+  \file hardware_counter.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_HARDWARE_COUNTER_HPP
+#define NANAIRO_HARDWARE_COUNTER_HPP
+
+// Standard C++ library
+#include <array>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! The hardware events which are counted
+enum class HardwareEvent : uint
+{
+  kCycles = 0,
+  kInstructions,
+  kL1dMisses,
+  kLlcMisses,
+  kBranchMisses,
+  kTlbMisses
+};
+
+/*!
+  \details
+  The counts of the hardware events of a measurement.
+  An event which the processor or the OS doesn't count is invalid,
+  and the counts of a measurement are the difference of two reads.
+  */
+class HardwareCounts
+{
+ public:
+  //! Create zero counts of no event
+  HardwareCounts() noexcept;
+
+
+  //! Return the count of the event
+  uint64 count(const HardwareEvent event) const noexcept;
+
+  //! Return the name of the event
+  static const char* eventName(const HardwareEvent event) noexcept;
+
+  //! Return the number of the instructions per cycle
+  double instructionsPerCycle() const noexcept;
+
+  //! Check if any event is counted
+  bool isValid() const noexcept;
+
+  //! Check if the event is counted
+  bool isValid(const HardwareEvent event) const noexcept;
+
+  //! Add the counts of the other counts
+  void merge(const HardwareCounts& other) noexcept;
+
+  //! Return the number of the events
+  static constexpr uint numOfEvents() noexcept;
+
+  //! Set the count of the event, which makes the event valid
+  void setCount(const HardwareEvent event, const uint64 count) noexcept;
+
+  //! Return the counts since the start counts
+  HardwareCounts since(const HardwareCounts& start) const noexcept;
+
+ private:
+  std::array<uint64, 6> count_list_;
+  std::array<uint8, 6> valid_list_;
+};
+
+/*!
+  \details
+  The perf_event counters of a thread. The counters count the thread
+  which opened them, but they can be read from any thread,
+  so the counters of the worker threads are read by the main thread
+  at the boundaries of the phases. The counters count only the user space.
+  The counters aren't supported on the platforms other than Linux,
+  and the open fails if the perf events are restricted by the OS.
+  */
+class HardwareCounter : public zisc::NonCopyable<HardwareCounter>
+{
+ public:
+  //! Create a closed counter
+  HardwareCounter() noexcept;
+
+  //! Close the counter
+  ~HardwareCounter() noexcept;
+
+
+  //! Close the counter
+  void close() noexcept;
+
+  //! Check if any event of the counter is opened
+  bool isOpened() const noexcept;
+
+  //! Check if the counters are supported on the platform
+  static constexpr bool isSupported() noexcept;
+
+  //! Open the counters of the calling thread, return false if no event is opened
+  bool open() noexcept;
+
+  //! Read the counts since the counter is opened
+  HardwareCounts read() const noexcept;
+
+ private:
+  std::array<int, 6> fd_list_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "hardware_counter-inl.hpp"
+
+#endif // NANAIRO_HARDWARE_COUNTER_HPP
@@ -0,0 +1,91 @@
+/*!
+  \file huge_page_memory_resource-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_HUGE_PAGE_MEMORY_RESOURCE_INL_HPP
+#define NANAIRO_HUGE_PAGE_MEMORY_RESOURCE_INL_HPP
+
+#include "huge_page_memory_resource.hpp"
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+HugePageMemoryResource::HugePageMemoryResource() noexcept :
+    upstream_{nullptr},
+    mapped_size_{0}
+{
+}
+
+/*!
+  */
+inline
+HugePageMemoryResource::HugePageMemoryResource(
+    zisc::pmr::memory_resource* upstream) noexcept :
+        upstream_{upstream},
+        mapped_size_{0}
+{
+  ZISC_ASSERT(upstream_ != nullptr, "The upstream resource is null.");
+}
+
+/*!
+  */
+inline
+constexpr std::size_t HugePageMemoryResource::giganticPageSize() noexcept
+{
+  return 1024 * 1024 * 1024;
+}
+
+/*!
+  */
+inline
+constexpr std::size_t HugePageMemoryResource::hugePageSize() noexcept
+{
+  return 2 * 1024 * 1024;
+}
+
+/*!
+  */
+inline
+std::size_t HugePageMemoryResource::mappedSize() const noexcept
+{
+  return mapped_size_.load(std::memory_order_relaxed);
+}
+
+/*!
+  \details
+  The upstream must not be changed after the resource allocates any memory.
+  */
+inline
+void HugePageMemoryResource::setUpstream(zisc::pmr::memory_resource* upstream) noexcept
+{
+  ZISC_ASSERT(upstream != nullptr, "The upstream resource is null.");
+  upstream_ = upstream;
+}
+
+/*!
+  */
+inline
+bool HugePageMemoryResource::do_is_equal(
+    const zisc::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_HUGE_PAGE_MEMORY_RESOURCE_INL_HPP
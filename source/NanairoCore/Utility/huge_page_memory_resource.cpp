@@ -0,0 +1,189 @@
+/*!
+  \file huge_page_memory_resource.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "huge_page_memory_resource.hpp"
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+namespace {
+
+//! Round the size up to the multiple of the page size
+constexpr std::size_t roundUpToPage(const std::size_t size,
+                                    const std::size_t page_size) noexcept
+{
+  return ((size + page_size - 1) / page_size) * page_size;
+}
+
+} // namespace
+
+/*!
+  */
+HugePageMemoryResource::~HugePageMemoryResource() noexcept
+{
+  for (const auto& mapping : mapping_list_)
+    unmapPages(mapping);
+  mapping_list_.clear();
+}
+
+/*!
+  \details
+  The mapping of a huge page is aligned to the page,
+  so an alignment up to the huge page size is satisfied.
+  */
+void* HugePageMemoryResource::do_allocate(std::size_t size,
+                                          std::size_t alignment) noexcept
+{
+  ZISC_ASSERT(upstream_ != nullptr, "The upstream resource is null.");
+  if ((hugePageSize() <= size) && (alignment <= hugePageSize())) {
+    const auto mapping = mapPages(size);
+    if (mapping.data_ != nullptr) {
+      {
+        std::unique_lock<std::mutex> lock{mapping_mutex_};
+        mapping_list_.emplace_back(mapping);
+      }
+      mapped_size_.fetch_add(mapping.size_, std::memory_order_relaxed);
+      return mapping.data_;
+    }
+  }
+  return upstream_->allocate(size, alignment);
+}
+
+/*!
+  \details
+  A large allocation which isn't found in the mappings
+  was allocated from the upstream when the mapping failed.
+  */
+void HugePageMemoryResource::do_deallocate(void* data,
+                                           std::size_t size,
+                                           std::size_t alignment) noexcept
+{
+  if (hugePageSize() <= size) {
+    Mapping mapping{nullptr, 0};
+    {
+      std::unique_lock<std::mutex> lock{mapping_mutex_};
+      for (auto& m : mapping_list_) {
+        if (m.data_ == data) {
+          mapping = m;
+          std::swap(m, mapping_list_.back());
+          mapping_list_.pop_back();
+          break;
+        }
+      }
+    }
+    if (mapping.data_ != nullptr) {
+      unmapPages(mapping);
+      mapped_size_.fetch_sub(mapping.size_, std::memory_order_relaxed);
+      return;
+    }
+  }
+  upstream_->deallocate(data, size, alignment);
+}
+
+/*!
+  \details
+  The explicit huge pages need the pages which are reserved by the system,
+  so the gigantic pages, the huge pages and the transparent huge pages
+  are tried in order. The transparent huge pages are mapped larger than
+  the size and trimmed to the 2 MB aligned region, since only the aligned
+  2 MB regions are backed by the huge pages.
+  */
+auto HugePageMemoryResource::mapPages(const std::size_t size) noexcept -> Mapping
+{
+#if defined(__linux__)
+  constexpr int protection = PROT_READ | PROT_WRITE;
+  constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  // Explicit huge pages
+  {
+#if defined(MAP_HUGE_1GB) && defined(MAP_HUGE_2MB)
+    const std::array<std::pair<std::size_t, int>, 2> page_list{{
+        {giganticPageSize(), MAP_HUGE_1GB},
+        {hugePageSize(), MAP_HUGE_2MB}}};
+#else
+    const std::array<std::pair<std::size_t, int>, 1> page_list{{
+        {hugePageSize(), 0}}};
+#endif
+    for (const auto& page : page_list) {
+      if (size < page.first)
+        continue;
+      const std::size_t s = roundUpToPage(size, page.first);
+      void* data = mmap(nullptr, s, protection, flags | MAP_HUGETLB | page.second,
+                        -1, 0);
+      if (data != MAP_FAILED)
+        return Mapping{data, s};
+    }
+  }
+  // Transparent huge pages
+  {
+    const std::size_t s = roundUpToPage(size, hugePageSize());
+    const std::size_t n = s + hugePageSize();
+    void* data = mmap(nullptr, n, protection, flags, -1, 0);
+    if (data != MAP_FAILED) {
+      const auto begin = reinterpret_cast<std::uintptr_t>(data);
+      const auto aligned = zisc::cast<std::uintptr_t>(
+          roundUpToPage(zisc::cast<std::size_t>(begin), hugePageSize()));
+      if (begin < aligned)
+        munmap(data, aligned - begin);
+      const std::size_t tail = (begin + n) - (aligned + s);
+      if (0 < tail)
+        munmap(reinterpret_cast<void*>(aligned + s), tail);
+      void* region = reinterpret_cast<void*>(aligned);
+      madvise(region, s, MADV_HUGEPAGE);
+      return Mapping{region, s};
+    }
+  }
+#elif defined(_WIN32)
+  // The large pages need the privilege of locking pages in memory
+  const std::size_t page_size = zisc::cast<std::size_t>(GetLargePageMinimum());
+  if (page_size != 0) {
+    const std::size_t s = roundUpToPage(size, page_size);
+    void* data = VirtualAlloc(nullptr, s,
+                              MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                              PAGE_READWRITE);
+    if (data != nullptr)
+      return Mapping{data, s};
+  }
+#else
+  static_cast<void>(size);
+#endif
+  return Mapping{nullptr, 0};
+}
+
+/*!
+  */
+void HugePageMemoryResource::unmapPages(const Mapping& mapping) noexcept
+{
+#if defined(__linux__)
+  munmap(mapping.data_, mapping.size_);
+#elif defined(_WIN32)
+  VirtualFree(mapping.data_, 0, MEM_RELEASE);
+#else
+  static_cast<void>(mapping);
+#endif
+}
+
+} // namespace nanairo
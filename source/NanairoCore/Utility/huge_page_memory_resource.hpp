@@ -0,0 +1,106 @@
+/*!
+  \file huge_page_memory_resource.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_HUGE_PAGE_MEMORY_RESOURCE_HPP
+#define NANAIRO_HUGE_PAGE_MEMORY_RESOURCE_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A memory resource which places the large arrays on huge pages
+  \details
+  An allocation of the huge page size or more is mapped from the OS directly,
+  so the traversal of a large array misses the TLB less.
+  The explicit huge pages (1 GB for the gigantic arrays, 2 MB otherwise)
+  are tried first, then the transparent huge pages of a 2 MB aligned mapping.
+  The small allocations and the allocations which can't be mapped
+  are passed through to the upstream resource.
+  The resource is thread safe as long as the upstream is thread safe.
+  */
+class HugePageMemoryResource : public zisc::pmr::memory_resource,
+                               public zisc::NonCopyable<HugePageMemoryResource>
+{
+ public:
+  //! Create a resource without the upstream
+  HugePageMemoryResource() noexcept;
+
+  //! Create a resource
+  HugePageMemoryResource(zisc::pmr::memory_resource* upstream) noexcept;
+
+  //! Unmap the remaining mappings
+  ~HugePageMemoryResource() noexcept;
+
+
+  //! Return the size of a gigantic page
+  static constexpr std::size_t giganticPageSize() noexcept;
+
+  //! Return the size of a huge page, which is the min size of a mapped allocation
+  static constexpr std::size_t hugePageSize() noexcept;
+
+  //! Return the size which is currently mapped by the resource
+  std::size_t mappedSize() const noexcept;
+
+  //! Set the upstream resource
+  void setUpstream(zisc::pmr::memory_resource* upstream) noexcept;
+
+ protected:
+  //! Allocate memory
+  void* do_allocate(std::size_t size, std::size_t alignment) noexcept override;
+
+  //! Deallocate memory
+  void do_deallocate(void* data,
+                     std::size_t size,
+                     std::size_t alignment) noexcept override;
+
+  //! Check if the resource is the same as the other
+  bool do_is_equal(const zisc::pmr::memory_resource& other) const noexcept override;
+
+ private:
+  //! A region which is mapped from the OS
+  struct Mapping
+  {
+    void* data_;
+    std::size_t size_;
+  };
+
+
+  //! Map the huge pages of the size, return null if no page is mapped
+  static Mapping mapPages(const std::size_t size) noexcept;
+
+  //! Unmap the region
+  static void unmapPages(const Mapping& mapping) noexcept;
+
+
+  zisc::pmr::memory_resource* upstream_;
+  std::vector<Mapping> mapping_list_;
+  std::mutex mapping_mutex_;
+  std::atomic<std::size_t> mapped_size_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "huge_page_memory_resource-inl.hpp"
+
+#endif // NANAIRO_HUGE_PAGE_MEMORY_RESOURCE_HPP
@@ -0,0 +1,114 @@
+/*!
+  \file inline_memory_resource-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_INLINE_MEMORY_RESOURCE_INL_HPP
+#define NANAIRO_INLINE_MEMORY_RESOURCE_INL_HPP
+
+#include "inline_memory_resource.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <cstdint>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+template <std::size_t kSize> inline
+InlineMemoryResource<kSize>::InlineMemoryResource(
+    zisc::pmr::memory_resource* upstream) noexcept :
+        upstream_{upstream},
+        used_size_{0}
+{
+  ZISC_ASSERT(upstream_ != nullptr, "The upstream resource is null.");
+}
+
+/*!
+  */
+template <std::size_t kSize> inline
+constexpr std::size_t InlineMemoryResource<kSize>::capacity() noexcept
+{
+  return kSize;
+}
+
+/*!
+  */
+template <std::size_t kSize> inline
+void InlineMemoryResource<kSize>::reset() noexcept
+{
+  used_size_ = 0;
+}
+
+/*!
+  */
+template <std::size_t kSize> inline
+std::size_t InlineMemoryResource<kSize>::usedSize() const noexcept
+{
+  return used_size_;
+}
+
+/*!
+  */
+template <std::size_t kSize> inline
+void* InlineMemoryResource<kSize>::do_allocate(std::size_t size,
+                                               std::size_t alignment) noexcept
+{
+  const auto address = reinterpret_cast<std::uintptr_t>(buffer_.data()) + used_size_;
+  const std::size_t padding = (alignment - (address % alignment)) % alignment;
+  void* data = nullptr;
+  if ((used_size_ + padding + size) <= capacity()) {
+    data = buffer_.data() + used_size_ + padding;
+    used_size_ = used_size_ + padding + size;
+  }
+  else {
+    data = upstream_->allocate(size, alignment);
+  }
+  return data;
+}
+
+/*!
+  \details
+  The memory of the buffer is released by reset().
+  */
+template <std::size_t kSize> inline
+void InlineMemoryResource<kSize>::do_deallocate(void* data,
+                                                std::size_t size,
+                                                std::size_t alignment) noexcept
+{
+  if (!isInBuffer(data))
+    upstream_->deallocate(data, size, alignment);
+}
+
+/*!
+  */
+template <std::size_t kSize> inline
+bool InlineMemoryResource<kSize>::do_is_equal(
+    const zisc::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+/*!
+  */
+template <std::size_t kSize> inline
+bool InlineMemoryResource<kSize>::isInBuffer(const void* data) const noexcept
+{
+  const auto begin = zisc::cast<const uint8*>(buffer_.data());
+  const auto p = zisc::cast<const uint8*>(data);
+  return (begin <= p) && (p < (begin + capacity()));
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_INLINE_MEMORY_RESOURCE_INL_HPP
@@ -0,0 +1,82 @@
+/*!
+  \file inline_memory_resource.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_INLINE_MEMORY_RESOURCE_HPP
+#define NANAIRO_INLINE_MEMORY_RESOURCE_HPP
+
+// Standard C++ library
+#include <array>
+#include <cstddef>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A memory resource which allocates memory from an inline buffer
+  \details
+  The buffer is a member of the resource, so the resource on the stack
+  allocates short-lived objects without touching any memory pool.
+  The memory is released only when the resource is destroyed or reset.
+  If the buffer is exhausted, the memory is allocated from
+  the upstream resource.
+  */
+template <std::size_t kSize>
+class InlineMemoryResource : public zisc::pmr::memory_resource,
+                             public zisc::NonCopyable<InlineMemoryResource<kSize>>
+{
+ public:
+  //! Create a resource
+  InlineMemoryResource(zisc::pmr::memory_resource* upstream) noexcept;
+
+
+  //! Return the size of the buffer
+  static constexpr std::size_t capacity() noexcept;
+
+  //! Release the memory of the buffer
+  void reset() noexcept;
+
+  //! Return the used size of the buffer
+  std::size_t usedSize() const noexcept;
+
+ protected:
+  //! Allocate memory
+  void* do_allocate(std::size_t size, std::size_t alignment) noexcept override;
+
+  //! Deallocate memory
+  void do_deallocate(void* data,
+                     std::size_t size,
+                     std::size_t alignment) noexcept override;
+
+  //! Check if the resource is the same as the other
+  bool do_is_equal(const zisc::pmr::memory_resource& other) const noexcept override;
+
+ private:
+  //! Check if the memory is in the buffer
+  bool isInBuffer(const void* data) const noexcept;
+
+
+  alignas(std::max_align_t) std::array<uint8, kSize> buffer_;
+  zisc::pmr::memory_resource* upstream_;
+  std::size_t used_size_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "inline_memory_resource-inl.hpp"
+
+#endif // NANAIRO_INLINE_MEMORY_RESOURCE_HPP
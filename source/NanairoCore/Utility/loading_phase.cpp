@@ -0,0 +1,62 @@
+/*!
+  \file loading_phase.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "loading_phase.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <cstdio>
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#endif
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  Return zero if the resident memory isn't available on the platform.
+  */
+std::size_t residentMemorySize() noexcept
+{
+  std::size_t size = 0;
+#if defined(__linux__)
+  std::FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm != nullptr) {
+    unsigned long total = 0,
+                  resident = 0;
+    if (std::fscanf(statm, "%lu %lu", &total, &resident) == 2)
+      size = zisc::cast<std::size_t>(resident) *
+             zisc::cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::fclose(statm);
+  }
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                zisc::treatAs<task_info_t>(&info), &count) == KERN_SUCCESS)
+    size = zisc::cast<std::size_t>(info.resident_size);
+#elif defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    size = zisc::cast<std::size_t>(counters.WorkingSetSize);
+#endif
+  return size;
+}
+
+} // namespace nanairo
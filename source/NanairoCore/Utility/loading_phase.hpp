@@ -0,0 +1,40 @@
+/*!
+  \file loading_phase.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_LOADING_PHASE_HPP
+#define NANAIRO_LOADING_PHASE_HPP
+
+// Standard C++ library
+#include <cstddef>
+// Zisc
+#include "zisc/stopwatch.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! The elapsed time and the memory growth of a phase of the scene loading
+struct LoadingPhase
+{
+  const char* name_;
+  zisc::Stopwatch::Clock::duration time_;
+  int64 memory_delta_; //!< The change of the resident memory in bytes
+};
+
+//! Return the resident memory size of the process in bytes
+std::size_t residentMemorySize() noexcept;
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_LOADING_PHASE_HPP
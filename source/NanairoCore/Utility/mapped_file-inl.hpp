@@ -0,0 +1,47 @@
+/*!
+  \file mapped_file-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_MAPPED_FILE_INL_HPP
+#define NANAIRO_MAPPED_FILE_INL_HPP
+
+#include "mapped_file.hpp"
+// Standard C++ library
+#include <cstddef>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+const uint8* MappedFile::data() const noexcept
+{
+  return data_;
+}
+
+/*!
+  */
+inline
+bool MappedFile::isOpen() const noexcept
+{
+  return data_ != nullptr;
+}
+
+/*!
+  */
+inline
+std::size_t MappedFile::size() const noexcept
+{
+  return size_;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_MAPPED_FILE_INL_HPP
@@ -0,0 +1,177 @@
+/*!
+  \file mapped_file.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "mapped_file.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <fstream>
+#include <ios>
+#include <streambuf>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+// Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+MappedFile::MappedFile() noexcept :
+    data_{nullptr},
+    size_{0},
+    handle_{nullptr}
+{
+}
+
+/*!
+  */
+MappedFile::~MappedFile() noexcept
+{
+  close();
+}
+
+/*!
+  */
+void MappedFile::close() noexcept
+{
+  if (data_ != nullptr) {
+#if defined(__unix__) || defined(__APPLE__)
+    ::munmap(const_cast<uint8*>(data_), size_);
+#elif defined(_WIN32)
+    UnmapViewOfFile(data_);
+    CloseHandle(zisc::cast<HANDLE>(handle_));
+#else
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+#endif
+  }
+  data_ = nullptr;
+  size_ = 0;
+  handle_ = nullptr;
+}
+
+/*!
+  \details
+  An empty file can't be mapped, so it's treated as an error.
+  */
+bool MappedFile::open(const std::string& file_path) noexcept
+{
+  close();
+#if defined(__unix__) || defined(__APPLE__)
+  const int file = ::open(file_path.c_str(), O_RDONLY);
+  if (file < 0)
+    return false;
+  struct stat file_status;
+  const bool has_size = (::fstat(file, &file_status) == 0) &&
+                        (0 < file_status.st_size);
+  void* address = MAP_FAILED;
+  if (has_size) {
+    size_ = zisc::cast<std::size_t>(file_status.st_size);
+    address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+  }
+  // The mapping is kept after the file is closed
+  ::close(file);
+  if (address == MAP_FAILED) {
+    size_ = 0;
+    return false;
+  }
+  data_ = zisc::cast<const uint8*>(address);
+  return true;
+#elif defined(_WIN32)
+  HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER file_size;
+  const bool has_size = GetFileSizeEx(file, &file_size) &&
+                        (0 < file_size.QuadPart);
+  HANDLE mapping = has_size
+      ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+      : nullptr;
+  CloseHandle(file);
+  if (mapping == nullptr)
+    return false;
+  const void* address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (address == nullptr) {
+    CloseHandle(mapping);
+    return false;
+  }
+  size_ = zisc::cast<std::size_t>(file_size.QuadPart);
+  data_ = zisc::cast<const uint8*>(address);
+  handle_ = mapping;
+  return true;
+#else
+  std::ifstream file{file_path, std::ios::binary | std::ios::ate};
+  if (!file.is_open())
+    return false;
+  const std::size_t file_size = zisc::cast<std::size_t>(file.tellg());
+  if (file_size == 0)
+    return false;
+  buffer_.resize(file_size);
+  file.seekg(0);
+  zisc::read(buffer_.data(), &file, file_size);
+  if (!file.good()) {
+    buffer_.clear();
+    return false;
+  }
+  size_ = file_size;
+  data_ = buffer_.data();
+  return true;
+#endif
+}
+
+/*!
+  \details
+  The get area is read only, the stream never writes it.
+  */
+MappedFileBuffer::MappedFileBuffer(const MappedFile& file) noexcept
+{
+  auto begin = zisc::cast<char*>(
+      const_cast<void*>(zisc::cast<const void*>(file.data())));
+  setg(begin, begin, begin + file.size());
+}
+
+/*!
+  */
+auto MappedFileBuffer::seekoff(off_type offset,
+                               std::ios_base::seekdir direction,
+                               std::ios_base::openmode mode) -> pos_type
+{
+  const off_type base = (direction == std::ios_base::beg) ? 0 :
+                        (direction == std::ios_base::cur) ? (gptr() - eback())
+                                                          : (egptr() - eback());
+  return seekpos(pos_type{base + offset}, mode);
+}
+
+/*!
+  */
+auto MappedFileBuffer::seekpos(pos_type position,
+                               std::ios_base::openmode mode) -> pos_type
+{
+  const off_type p = off_type{position};
+  if (((mode & std::ios_base::in) == 0) || (p < 0) || ((egptr() - eback()) < p))
+    return pos_type{off_type{-1}};
+  setg(eback(), eback() + p, egptr());
+  return position;
+}
+
+} // namespace nanairo
@@ -0,0 +1,96 @@
+/*!
+  \file mapped_file.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_MAPPED_FILE_HPP
+#define NANAIRO_MAPPED_FILE_HPP
+
+// Standard C++ library
+#include <cstddef>
+#include <ios>
+#include <streambuf>
+#include <string>
+#include <vector>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A read-only file which is mapped into memory
+  \details
+  The file is mapped by mmap on POSIX and by a file mapping on Windows.
+  The file is read into a buffer by a single bulk read
+  on the platforms which have no mapping.
+  */
+class MappedFile : public zisc::NonCopyable<MappedFile>
+{
+ public:
+  //! Create an unmapped file
+  MappedFile() noexcept;
+
+  //! Unmap the file
+  ~MappedFile() noexcept;
+
+
+  //! Unmap the file
+  void close() noexcept;
+
+  //! Return the mapped data
+  const uint8* data() const noexcept;
+
+  //! Check if the file is mapped
+  bool isOpen() const noexcept;
+
+  //! Map the file into memory
+  bool open(const std::string& file_path) noexcept;
+
+  //! Return the size of the file in bytes
+  std::size_t size() const noexcept;
+
+ private:
+  std::vector<uint8> buffer_; //!< Used if the mapping isn't supported
+  const uint8* data_;
+  std::size_t size_;
+  void* handle_; //!< The mapping object on Windows
+};
+
+/*!
+  \brief The stream buffer which reads a mapped file
+  \details
+  The get area is the whole file, so the bulk reads of a stream over
+  the buffer are plain copies from the mapped pages.
+  */
+class MappedFileBuffer : public std::streambuf
+{
+ public:
+  //! Create a stream buffer of the file
+  MappedFileBuffer(const MappedFile& file) noexcept;
+
+ protected:
+  //! Set the position relative to the beginning, the current or the end
+  pos_type seekoff(off_type offset,
+                   std::ios_base::seekdir direction,
+                   std::ios_base::openmode mode) override;
+
+  //! Set the position
+  pos_type seekpos(pos_type position, std::ios_base::openmode mode) override;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "mapped_file-inl.hpp"
+
+#endif // NANAIRO_MAPPED_FILE_HPP
@@ -0,0 +1,167 @@
+/*!
+  \file out_of_core_memory_resource-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_OUT_OF_CORE_MEMORY_RESOURCE_INL_HPP
+#define NANAIRO_OUT_OF_CORE_MEMORY_RESOURCE_INL_HPP
+
+#include "out_of_core_memory_resource.hpp"
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+OutOfCoreMemoryResource::OutOfCoreMemoryResource() noexcept :
+    upstream_{nullptr},
+    address_{nullptr},
+    epoch_{1},
+    mapped_size_{0},
+    budget_{0},
+    num_of_page_outs_{0},
+    file_{-1}
+{
+}
+
+/*!
+  */
+inline
+OutOfCoreMemoryResource::OutOfCoreMemoryResource(
+    zisc::pmr::memory_resource* upstream) noexcept :
+        OutOfCoreMemoryResource()
+{
+  ZISC_ASSERT(upstream != nullptr, "The upstream resource is null.");
+  upstream_ = upstream;
+}
+
+/*!
+  */
+inline
+std::size_t OutOfCoreMemoryResource::budget() const noexcept
+{
+  return budget_;
+}
+
+/*!
+  \details
+  Only the address range is reserved, so the capacity costs no memory.
+  */
+inline
+constexpr std::size_t OutOfCoreMemoryResource::capacity() noexcept
+{
+  return zisc::cast<std::size_t>(1) << 40;
+}
+
+/*!
+  \details
+  A cluster is a multiple of the huge page size,
+  so a page-in reads a large contiguous block of the file.
+  */
+inline
+constexpr std::size_t OutOfCoreMemoryResource::clusterSize() noexcept
+{
+  return 2 * 1024 * 1024;
+}
+
+/*!
+  */
+inline
+bool OutOfCoreMemoryResource::isOpen() const noexcept
+{
+  return address_ != nullptr;
+}
+
+/*!
+  */
+inline
+std::size_t OutOfCoreMemoryResource::mappedSize() const noexcept
+{
+  return mapped_size_.load(std::memory_order_relaxed);
+}
+
+/*!
+  */
+inline
+std::size_t OutOfCoreMemoryResource::numOfPageOuts() const noexcept
+{
+  return num_of_page_outs_;
+}
+
+/*!
+  \details
+  The upstream must not be changed after the resource allocates any memory.
+  */
+inline
+void OutOfCoreMemoryResource::setUpstream(zisc::pmr::memory_resource* upstream) noexcept
+{
+  ZISC_ASSERT(upstream != nullptr, "The upstream resource is null.");
+  upstream_ = upstream;
+}
+
+/*!
+  \details
+  The use is written only if the cluster isn't touched in the epoch yet,
+  so the threads which read the same cluster don't write its cache line.
+  The data which isn't in the mapped clusters is ignored.
+  */
+inline
+void OutOfCoreMemoryResource::touch(const void* data) noexcept
+{
+  if (isMapped(data)) {
+    auto& last_use = last_use_list_[getClusterIndex(data)];
+    const uint32 epoch = epoch_.load(std::memory_order_relaxed);
+    if (last_use.load(std::memory_order_relaxed) != epoch)
+      last_use.store(epoch, std::memory_order_relaxed);
+  }
+}
+
+/*!
+  */
+inline
+bool OutOfCoreMemoryResource::do_is_equal(
+    const zisc::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+/*!
+  */
+inline
+std::size_t OutOfCoreMemoryResource::getClusterIndex(const void* data) const noexcept
+{
+  const auto offset = reinterpret_cast<std::uintptr_t>(data) -
+                      reinterpret_cast<std::uintptr_t>(address_);
+  return zisc::cast<std::size_t>(offset) / clusterSize();
+}
+
+/*!
+  \details
+  The address below the range wraps around to a large offset,
+  so a comparison checks the both ends.
+  */
+inline
+bool OutOfCoreMemoryResource::isMapped(const void* data) const noexcept
+{
+  const auto offset = reinterpret_cast<std::uintptr_t>(data) -
+                      reinterpret_cast<std::uintptr_t>(address_);
+  return zisc::cast<std::size_t>(offset) < mappedSize();
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_OUT_OF_CORE_MEMORY_RESOURCE_INL_HPP
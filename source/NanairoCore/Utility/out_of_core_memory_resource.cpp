@@ -0,0 +1,227 @@
+/*!
+  \file out_of_core_memory_resource.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "out_of_core_memory_resource.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+namespace {
+
+//! Round the size up to the multiple of the cluster size
+constexpr std::size_t roundUpToCluster(const std::size_t size) noexcept
+{
+  constexpr std::size_t cluster_size = OutOfCoreMemoryResource::clusterSize();
+  return ((size + cluster_size - 1) / cluster_size) * cluster_size;
+}
+
+} // namespace
+
+/*!
+  */
+OutOfCoreMemoryResource::~OutOfCoreMemoryResource() noexcept
+{
+  close();
+}
+
+/*!
+  \details
+  The file has been removed from the directory when it's opened,
+  so its blocks are freed when it's closed.
+  */
+void OutOfCoreMemoryResource::close() noexcept
+{
+#if defined(__linux__)
+  if (isOpen()) {
+    ::munmap(address_, capacity());
+    ::close(file_);
+  }
+#endif
+  address_ = nullptr;
+  file_ = -1;
+  last_use_list_.clear();
+  mapped_size_.store(0, std::memory_order_relaxed);
+}
+
+/*!
+  \details
+  The file is removed from the directory as soon as it's made,
+  so no file remains even if the process is killed.
+  The whole capacity is reserved without any access,
+  so the clusters are mapped at the contiguous addresses
+  and the cluster of an address is found by a division.
+  */
+bool OutOfCoreMemoryResource::open(const std::string_view& directory,
+                                   const std::size_t budget) noexcept
+{
+  close();
+#if defined(__linux__)
+  std::string file_path{directory};
+  file_path += "/nanairo_out_of_core_XXXXXX";
+  const int file = ::mkstemp(file_path.data());
+  if (file < 0)
+    return false;
+  ::unlink(file_path.c_str());
+  void* address = ::mmap(nullptr, capacity(), PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (address == MAP_FAILED) {
+    ::close(file);
+    return false;
+  }
+  address_ = zisc::cast<uint8*>(address);
+  file_ = file;
+  last_use_list_ = std::vector<std::atomic<uint32>>(capacity() / clusterSize());
+  epoch_.store(1, std::memory_order_relaxed);
+  budget_ = budget;
+  num_of_page_outs_ = 0;
+  return true;
+#else
+  static_cast<void>(directory);
+  static_cast<void>(budget);
+  return false;
+#endif
+}
+
+/*!
+  \details
+  The clusters are sorted by the epoch of their last use,
+  and the oldest clusters over the budget are paged out.
+  Then the epoch is advanced, so the clusters which are touched after
+  the trim are newer than the clusters which aren't.
+  */
+void OutOfCoreMemoryResource::trim() noexcept
+{
+  if (!isOpen())
+    return;
+  const uint32 epoch = epoch_.load(std::memory_order_relaxed);
+  if (0 < budget_) {
+    const std::size_t max_num_of_clusters = zisc::max(budget_ / clusterSize(),
+                                                      zisc::cast<std::size_t>(1));
+    const std::size_t num_of_clusters = mappedSize() / clusterSize();
+    std::vector<std::pair<uint32, std::size_t>> resident_list;
+    for (std::size_t index = 0; index < num_of_clusters; ++index) {
+      const uint32 last_use = last_use_list_[index].load(std::memory_order_relaxed);
+      if (last_use != 0)
+        resident_list.emplace_back(last_use, index);
+    }
+    if (max_num_of_clusters < resident_list.size()) {
+      const std::size_t num_of_page_outs = resident_list.size() - max_num_of_clusters;
+      const auto last = resident_list.begin() + num_of_page_outs;
+      std::nth_element(resident_list.begin(), last, resident_list.end());
+      for (auto cluster = resident_list.begin(); cluster != last; ++cluster)
+        pageOut(cluster->second);
+    }
+  }
+  // The epoch 0 means that the cluster isn't resident
+  const uint32 next_epoch = (epoch + 1 != 0) ? epoch + 1 : 1;
+  epoch_.store(next_epoch, std::memory_order_relaxed);
+}
+
+/*!
+  \details
+  The allocation is rounded up to the clusters and mapped at the end of
+  the file, so no two allocations share a cluster.
+  The allocations which aren't mapped are allocated from the upstream.
+  */
+void* OutOfCoreMemoryResource::do_allocate(std::size_t size,
+                                           std::size_t alignment) noexcept
+{
+  ZISC_ASSERT(upstream_ != nullptr, "The upstream resource is null.");
+#if defined(__linux__)
+  if (isOpen() && (alignment <= clusterSize())) {
+    const std::size_t s = roundUpToCluster(zisc::max(size,
+                                                     zisc::cast<std::size_t>(1)));
+    std::unique_lock<std::mutex> lock{allocation_mutex_};
+    const std::size_t offset = mappedSize();
+    if ((s <= (capacity() - offset)) &&
+        (::ftruncate(file_, zisc::cast<off_t>(offset + s)) == 0)) {
+      void* data = ::mmap(address_ + offset, s, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_FIXED, file_, zisc::cast<off_t>(offset));
+      if (data != MAP_FAILED) {
+        // The new clusters are resident since the user writes them
+        const uint32 epoch = epoch_.load(std::memory_order_relaxed);
+        for (std::size_t index = offset / clusterSize();
+             index < (offset + s) / clusterSize();
+             ++index) {
+          last_use_list_[index].store(epoch, std::memory_order_relaxed);
+        }
+        mapped_size_.store(offset + s, std::memory_order_release);
+        return data;
+      }
+    }
+  }
+#endif
+  return upstream_->allocate(size, alignment);
+}
+
+/*!
+  \details
+  The address range of a deallocation isn't reused,
+  but its pages and the blocks of the file are released.
+  */
+void OutOfCoreMemoryResource::do_deallocate(void* data,
+                                            std::size_t size,
+                                            std::size_t alignment) noexcept
+{
+  if (isMapped(data)) {
+#if defined(__linux__)
+    const std::size_t s = roundUpToCluster(zisc::max(size,
+                                                     zisc::cast<std::size_t>(1)));
+    if (::madvise(data, s, MADV_REMOVE) != 0)
+      ::madvise(data, s, MADV_DONTNEED);
+    const std::size_t index = getClusterIndex(data);
+    for (std::size_t i = index; i < index + s / clusterSize(); ++i)
+      last_use_list_[i].store(0, std::memory_order_relaxed);
+#endif
+    return;
+  }
+  upstream_->deallocate(data, size, alignment);
+}
+
+/*!
+  \details
+  The dirty pages are written back to the file first,
+  so the pages can be dropped from the page cache too
+  and the cluster is read from the file when it's accessed again.
+  */
+void OutOfCoreMemoryResource::pageOut(const std::size_t index) noexcept
+{
+#if defined(__linux__)
+  const std::size_t offset = index * clusterSize();
+  void* data = address_ + offset;
+  ::msync(data, clusterSize(), MS_SYNC);
+  ::madvise(data, clusterSize(), MADV_DONTNEED);
+  ::posix_fadvise(file_, zisc::cast<off_t>(offset),
+                  zisc::cast<off_t>(clusterSize()), POSIX_FADV_DONTNEED);
+#endif
+  last_use_list_[index].store(0, std::memory_order_relaxed);
+  ++num_of_page_outs_;
+}
+
+} // namespace nanairo
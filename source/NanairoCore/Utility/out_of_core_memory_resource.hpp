@@ -0,0 +1,130 @@
+/*!
+  \file out_of_core_memory_resource.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_OUT_OF_CORE_MEMORY_RESOURCE_HPP
+#define NANAIRO_OUT_OF_CORE_MEMORY_RESOURCE_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A memory resource which pages the large geometry out to a file
+  \details
+  The allocations are placed in the page aligned clusters of a temporary file
+  which is mapped into a reserved address range, so the OS pages a cluster
+  in on demand when it's accessed. The users record the access of a cluster
+  by touch() and trim() pages out the least recently used clusters
+  which exceed the budget. A paged out cluster keeps its data in the file,
+  so touch() only steers the eviction and a missing touch costs a page-in.
+  The resource is available on Linux, otherwise the allocations are
+  passed through to the upstream resource.
+  The allocation is thread safe, but trim() must not run with the accesses.
+  */
+class OutOfCoreMemoryResource : public zisc::pmr::memory_resource,
+                                public zisc::NonCopyable<OutOfCoreMemoryResource>
+{
+ public:
+  //! Create a resource without the upstream
+  OutOfCoreMemoryResource() noexcept;
+
+  //! Create a resource
+  OutOfCoreMemoryResource(zisc::pmr::memory_resource* upstream) noexcept;
+
+  //! Unmap the file and remove it
+  ~OutOfCoreMemoryResource() noexcept;
+
+
+  //! Return the bytes which the resident clusters can use, 0 is unbounded
+  std::size_t budget() const noexcept;
+
+  //! Return the max size of the file
+  static constexpr std::size_t capacity() noexcept;
+
+  //! Close the file
+  void close() noexcept;
+
+  //! Return the size of a cluster, which is the unit of the paging
+  static constexpr std::size_t clusterSize() noexcept;
+
+  //! Check if the file is open
+  bool isOpen() const noexcept;
+
+  //! Return the size which is currently mapped from the file
+  std::size_t mappedSize() const noexcept;
+
+  //! Make a file in the directory and map it
+  bool open(const std::string_view& directory, const std::size_t budget) noexcept;
+
+  //! Return the number of the clusters which have been paged out
+  std::size_t numOfPageOuts() const noexcept;
+
+  //! Set the upstream resource
+  void setUpstream(zisc::pmr::memory_resource* upstream) noexcept;
+
+  //! Record an access of the cluster which contains the data
+  void touch(const void* data) noexcept;
+
+  //! Page out the least recently used clusters which exceed the budget
+  void trim() noexcept;
+
+ protected:
+  //! Allocate memory
+  void* do_allocate(std::size_t size, std::size_t alignment) noexcept override;
+
+  //! Deallocate memory
+  void do_deallocate(void* data,
+                     std::size_t size,
+                     std::size_t alignment) noexcept override;
+
+  //! Check if the resource is the same as the other
+  bool do_is_equal(const zisc::pmr::memory_resource& other) const noexcept override;
+
+ private:
+  //! Return the index of the cluster which contains the data
+  std::size_t getClusterIndex(const void* data) const noexcept;
+
+  //! Check if the data is in the mapped clusters
+  bool isMapped(const void* data) const noexcept;
+
+  //! Page out the cluster of the index
+  void pageOut(const std::size_t index) noexcept;
+
+
+  zisc::pmr::memory_resource* upstream_;
+  uint8* address_; //!< The reserved address range of the file
+  std::vector<std::atomic<uint32>> last_use_list_; //!< 0 means not resident
+  std::mutex allocation_mutex_;
+  std::atomic<uint32> epoch_;
+  std::atomic<std::size_t> mapped_size_;
+  std::size_t budget_;
+  std::size_t num_of_page_outs_;
+  int file_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "out_of_core_memory_resource-inl.hpp"
+
+#endif // NANAIRO_OUT_OF_CORE_MEMORY_RESOURCE_HPP
@@ -0,0 +1,49 @@
+/*!
+  \file prefetch-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PREFETCH_INL_HPP
+#define NANAIRO_PREFETCH_INL_HPP
+
+#include "prefetch.hpp"
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+constexpr bool traversalPrefetchIsEnabled() noexcept
+{
+  return 0 < CoreConfig::traversalPrefetchDepth();
+}
+
+/*!
+  \details
+  The address is only a hint, so an invalid address doesn't fault.
+  The prefetch is a no-op on a compiler which has no intrinsic.
+  */
+template <typename Type> inline
+void prefetch(const Type* address) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#else
+  static_cast<void>(address);
+#endif
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_PREFETCH_INL_HPP
@@ -0,0 +1,34 @@
+/*!
+  \file prefetch.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_PREFETCH_HPP
+#define NANAIRO_PREFETCH_HPP
+
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! Check if the traversals of the trees prefetch the nodes ahead
+constexpr bool traversalPrefetchIsEnabled() noexcept;
+
+//! Prefetch the cache line of the address for reading
+template <typename Type>
+void prefetch(const Type* address) noexcept;
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "prefetch-inl.hpp"
+
+#endif // NANAIRO_PREFETCH_HPP
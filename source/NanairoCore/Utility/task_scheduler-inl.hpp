@@ -0,0 +1,76 @@
+/*!
+  \file task_scheduler-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TASK_SCHEDULER_INL_HPP
+#define NANAIRO_TASK_SCHEDULER_INL_HPP
+
+#include "task_scheduler.hpp"
+// Standard C++ library
+#include <atomic>
+#include <utility>
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+uint TaskScheduler::forkDepth() const noexcept
+{
+  return fork_depth_;
+}
+
+/*!
+  */
+inline
+uint TaskScheduler::numOfThreads() const noexcept
+{
+  return numOfWorkers() + 1;
+}
+
+/*!
+  */
+inline
+uint TaskScheduler::numOfWorkers() const noexcept
+{
+  return zisc::cast<uint>(worker_list_.size());
+}
+
+/*!
+  */
+inline
+TaskGroup::TaskGroup(TaskScheduler& scheduler) noexcept :
+    scheduler_{&scheduler},
+    num_of_pending_tasks_{0}
+{
+}
+
+/*!
+  */
+inline
+TaskGroup::~TaskGroup() noexcept
+{
+  wait();
+}
+
+/*!
+  */
+template <typename Function> inline
+void TaskGroup::run(Function&& task) noexcept
+{
+  num_of_pending_tasks_.fetch_add(1, std::memory_order_relaxed);
+  scheduler_->push(TaskScheduler::Task{std::forward<Function>(task), this});
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TASK_SCHEDULER_INL_HPP
@@ -0,0 +1,178 @@
+/*!
+  \file task_scheduler.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "task_scheduler.hpp"
+// Standard C++ library
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "thread_affinity.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+thread_local const TaskScheduler* TaskScheduler::current_scheduler_ = nullptr;
+thread_local uint TaskScheduler::current_queue_index_ = 0;
+
+/*!
+  */
+TaskScheduler::TaskScheduler(const uint num_of_threads,
+                             const bool thread_affinity_enabled) noexcept :
+    num_of_queued_tasks_{0},
+    is_running_{true},
+    fork_depth_{0}
+{
+  initialize(num_of_threads, thread_affinity_enabled);
+}
+
+/*!
+  */
+TaskScheduler::~TaskScheduler() noexcept
+{
+  {
+    std::unique_lock<std::mutex> lock{wake_mutex_};
+    is_running_.store(false);
+  }
+  wake_condition_.notify_all();
+  for (auto& worker : worker_list_)
+    worker.join();
+}
+
+/*!
+  \details
+  The caller thread also runs tasks while it waits,
+  so the scheduler makes one less workers than the number of threads.
+  The fork depth makes about eight tasks per thread for load balancing.
+  */
+void TaskScheduler::initialize(const uint num_of_threads,
+                               const bool thread_affinity_enabled) noexcept
+{
+  const uint num_of_workers = (1 < num_of_threads) ? num_of_threads - 1 : 0;
+  queue_list_.reserve(num_of_workers + 1);
+  for (uint index = 0; index <= num_of_workers; ++index)
+    queue_list_.emplace_back(std::make_unique<TaskQueue>());
+
+  worker_list_.reserve(num_of_workers);
+  for (uint index = 0; index < num_of_workers; ++index) {
+    worker_list_.emplace_back([this, index, thread_affinity_enabled]()
+    {
+      runWorker(index, thread_affinity_enabled);
+    });
+  }
+
+  uint depth = 3;
+  for (uint n = 1; n < numOfThreads(); n = n << 1)
+    ++depth;
+  fork_depth_ = depth;
+}
+
+/*!
+  \details
+  The counter of the queued tasks is updated before the notification
+  under the lock, so a sleeping worker can't miss the task.
+  */
+void TaskScheduler::push(Task&& task) noexcept
+{
+  auto& queue = *queue_list_[queueIndex()];
+  {
+    std::unique_lock<std::mutex> lock{queue.mutex_};
+    queue.task_list_.emplace_back(std::move(task));
+  }
+  {
+    std::unique_lock<std::mutex> lock{wake_mutex_};
+    num_of_queued_tasks_.fetch_add(1);
+  }
+  wake_condition_.notify_one();
+}
+
+/*!
+  */
+uint TaskScheduler::queueIndex() const noexcept
+{
+  return (current_scheduler_ == this) ? current_queue_index_ : numOfWorkers();
+}
+
+/*!
+  */
+void TaskScheduler::runWorker(const uint index,
+                              const bool thread_affinity_enabled) noexcept
+{
+  if (thread_affinity_enabled)
+    bindCurrentThread(index);
+  current_scheduler_ = this;
+  current_queue_index_ = index;
+  while (true) {
+    if (tryRunTask(index))
+      continue;
+    std::unique_lock<std::mutex> lock{wake_mutex_};
+    wake_condition_.wait(lock, [this]()
+    {
+      return (0 < num_of_queued_tasks_.load()) || !is_running_.load();
+    });
+    if (!is_running_.load() && (num_of_queued_tasks_.load() == 0))
+      break;
+  }
+}
+
+/*!
+  \details
+  The own queue is used as a stack for the locality of the recursive tasks,
+  and the other queues are stolen from the oldest tasks,
+  which are usually the largest ones.
+  */
+bool TaskScheduler::tryRunTask(const uint index) noexcept
+{
+  Task task;
+  bool has_task = false;
+  const uint num_of_queues = zisc::cast<uint>(queue_list_.size());
+  for (uint i = 0; !has_task && (i < num_of_queues); ++i) {
+    const uint queue_index = (index + i) % num_of_queues;
+    auto& queue = *queue_list_[queue_index];
+    std::unique_lock<std::mutex> lock{queue.mutex_};
+    if (!queue.task_list_.empty()) {
+      if (i == 0) {
+        task = std::move(queue.task_list_.back());
+        queue.task_list_.pop_back();
+      }
+      else {
+        task = std::move(queue.task_list_.front());
+        queue.task_list_.pop_front();
+      }
+      has_task = true;
+    }
+  }
+
+  if (has_task) {
+    num_of_queued_tasks_.fetch_sub(1);
+    task.function_();
+    task.group_->num_of_pending_tasks_.fetch_sub(1, std::memory_order_release);
+  }
+  return has_task;
+}
+
+/*!
+  */
+void TaskGroup::wait() noexcept
+{
+  const uint index = scheduler_->queueIndex();
+  while (0 < num_of_pending_tasks_.load(std::memory_order_acquire)) {
+    if (!scheduler_->tryRunTask(index))
+      std::this_thread::yield();
+  }
+}
+
+} // namespace nanairo
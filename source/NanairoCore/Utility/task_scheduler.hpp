@@ -0,0 +1,151 @@
+/*!
+  \file task_scheduler.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TASK_SCHEDULER_HPP
+#define NANAIRO_TASK_SCHEDULER_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class TaskGroup;
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief Fork-join task scheduler with work stealing
+  \details
+  Each worker has its own task queue. A worker takes the last task of
+  its queue and steals the first task of the other queues when its queue is
+  empty. The threads which aren't workers push tasks to the shared queue.
+  A thread which waits for a task group runs the pending tasks instead of
+  blocking, so the tasks can fork and join recursively without deadlock.
+  */
+class TaskScheduler : public zisc::NonCopyable<TaskScheduler>
+{
+ public:
+  //! Create a scheduler which runs tasks on the threads including the caller
+  TaskScheduler(const uint num_of_threads,
+                const bool thread_affinity_enabled) noexcept;
+
+  //! Stop the workers
+  ~TaskScheduler() noexcept;
+
+
+  //! Return the depth of recursive forking which makes enough tasks
+  uint forkDepth() const noexcept;
+
+  //! Return the number of threads which run tasks including the caller
+  uint numOfThreads() const noexcept;
+
+ private:
+  friend TaskGroup;
+
+  /*!
+    */
+  struct Task
+  {
+    std::function<void ()> function_;
+    TaskGroup* group_;
+  };
+
+  /*!
+    */
+  struct TaskQueue
+  {
+    std::mutex mutex_;
+    std::deque<Task> task_list_;
+  };
+
+
+  //! Initialize
+  void initialize(const uint num_of_threads,
+                  const bool thread_affinity_enabled) noexcept;
+
+  //! Return the number of the worker threads
+  uint numOfWorkers() const noexcept;
+
+  //! Push a task to the queue of the current thread
+  void push(Task&& task) noexcept;
+
+  //! Return the queue index of the current thread
+  uint queueIndex() const noexcept;
+
+  //! Run the loop of a worker
+  void runWorker(const uint index,
+                 const bool thread_affinity_enabled) noexcept;
+
+  //! Run a task of the queue or a stolen task. Return false if no task found
+  bool tryRunTask(const uint index) noexcept;
+
+
+  static thread_local const TaskScheduler* current_scheduler_;
+  static thread_local uint current_queue_index_;
+
+  std::vector<std::unique_ptr<TaskQueue>> queue_list_; //!< The last is shared
+  std::vector<std::thread> worker_list_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_condition_;
+  std::atomic<uint> num_of_queued_tasks_;
+  std::atomic<bool> is_running_;
+  uint fork_depth_;
+};
+
+/*!
+  \brief A group of tasks which are joined together
+  \details
+  The destructor waits for the tasks, so a task can refer to the variables
+  of the scope of the group.
+  */
+class TaskGroup : public zisc::NonCopyable<TaskGroup>
+{
+ public:
+  //! Create a task group
+  TaskGroup(TaskScheduler& scheduler) noexcept;
+
+  //! Wait for the tasks
+  ~TaskGroup() noexcept;
+
+
+  //! Fork a task
+  template <typename Function>
+  void run(Function&& task) noexcept;
+
+  //! Run the pending tasks until all tasks of the group finish
+  void wait() noexcept;
+
+ private:
+  friend TaskScheduler;
+
+
+  TaskScheduler* scheduler_;
+  std::atomic<uint> num_of_pending_tasks_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "task_scheduler-inl.hpp"
+
+#endif // NANAIRO_TASK_SCHEDULER_HPP
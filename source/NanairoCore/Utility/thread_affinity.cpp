@@ -0,0 +1,102 @@
+/*!
+  \file thread_affinity.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "thread_affinity.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \details
+  The thread numbers are mapped to the logical cpus in order,
+  so the neighbor threads share a socket (and its memory node)
+  on the usual cpu enumeration.
+  Return false if the affinity isn't supported on the platform.
+  */
+bool bindCurrentThread(const uint thread_number) noexcept
+{
+  const uint num_of_cpus = zisc::max(std::thread::hardware_concurrency(), 1u);
+  const uint cpu = thread_number % num_of_cpus;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  const int result = pthread_setaffinity_np(pthread_self(),
+                                            sizeof(cpu_set),
+                                            &cpu_set);
+  return result == 0;
+#elif defined(_WIN32)
+  const DWORD_PTR mask = zisc::cast<DWORD_PTR>(1) << (cpu % (8 * sizeof(mask)));
+  const DWORD_PTR result = SetThreadAffinityMask(GetCurrentThread(), mask);
+  return result != 0;
+#else
+  static_cast<void>(cpu);
+  return false;
+#endif
+}
+
+/*!
+  \details
+  The niceness of Linux is per thread, so only the current thread
+  gets the lowest priority. The rendering yields the cpus to
+  the interactive processes, but it runs at full speed on an idle machine.
+  Return false if the priority isn't changed.
+  */
+bool lowerCurrentThreadPriority() noexcept
+{
+#if defined(__linux__)
+  constexpr int lowest_priority = 19;
+  const auto thread_id = zisc::cast<id_t>(syscall(SYS_gettid));
+  const int result = setpriority(PRIO_PROCESS, thread_id, lowest_priority);
+  return result == 0;
+#elif defined(_WIN32)
+  const BOOL result = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+  return result != 0;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \details
+  The pages of a pool are placed on the memory node of the thread
+  which writes them first. The memory is written by blocks,
+  so the pool can grow by its own chunks. The memory isn't deallocated,
+  the caller resets the resource.
+  */
+void touchMemory(zisc::pmr::memory_resource* memory_resource,
+                 const std::size_t size) noexcept
+{
+  constexpr std::size_t block_size = 64 * 1024;
+  constexpr std::size_t alignment = alignof(std::max_align_t);
+  for (std::size_t s = 0; (s + block_size) <= size; s += block_size) {
+    void* block = memory_resource->allocate(block_size, alignment);
+    std::memset(block, 0, block_size);
+  }
+}
+
+} // namespace nanairo
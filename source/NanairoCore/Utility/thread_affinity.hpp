@@ -0,0 +1,39 @@
+/*!
+  \file thread_affinity.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_THREAD_AFFINITY_HPP
+#define NANAIRO_THREAD_AFFINITY_HPP
+
+// Standard C++ library
+#include <cstddef>
+// Zisc
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! Bind the current thread to the logical cpu of the thread number
+bool bindCurrentThread(const uint thread_number) noexcept;
+
+//! Lower the OS scheduling priority of the current thread to the background
+bool lowerCurrentThreadPriority() noexcept;
+
+//! Write the memory of the resource from the current thread
+void touchMemory(zisc::pmr::memory_resource* memory_resource,
+                 const std::size_t size) noexcept;
+
+//! \} Core
+
+} // namespace nanairo
+
+#endif // NANAIRO_THREAD_AFFINITY_HPP
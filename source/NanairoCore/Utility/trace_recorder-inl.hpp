@@ -0,0 +1,51 @@
+/*!
+  \file trace_recorder-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRACE_RECORDER_INL_HPP
+#define NANAIRO_TRACE_RECORDER_INL_HPP
+
+#include "trace_recorder.hpp"
+// Standard C++ library
+#include <atomic>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+TraceRecorder::Scope::Scope(TraceRecorder& recorder, const char* name) noexcept :
+    recorder_{recorder.isEnabled() ? &recorder : nullptr},
+    name_{name}
+{
+  if (recorder_ != nullptr)
+    begin_ = Clock::now();
+}
+
+/*!
+  */
+inline
+TraceRecorder::Scope::~Scope() noexcept
+{
+  if (recorder_ != nullptr)
+    recorder_->addEvent(name_, begin_, Clock::now());
+}
+
+/*!
+  */
+inline
+bool TraceRecorder::isEnabled() const noexcept
+{
+  return is_enabled_.load(std::memory_order_relaxed);
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TRACE_RECORDER_INL_HPP
@@ -0,0 +1,125 @@
+/*!
+  \file trace_recorder.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "trace_recorder.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <ostream>
+#include <thread>
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+TraceRecorder::TraceRecorder() noexcept :
+    origin_{Clock::now()},
+    is_enabled_{false}
+{
+}
+
+/*!
+  */
+void TraceRecorder::addEvent(const char* name,
+                             const Clock::time_point begin,
+                             const Clock::time_point end) noexcept
+{
+  std::unique_lock<std::mutex> lock{mutex_};
+  const uint thread_index = getThreadIndex();
+  event_list_.emplace_back(TraceEvent{name, begin, end, thread_index});
+}
+
+/*!
+  */
+void TraceRecorder::clear() noexcept
+{
+  std::unique_lock<std::mutex> lock{mutex_};
+  event_list_.clear();
+  thread_list_.clear();
+}
+
+/*!
+  \details
+  The time of the events is measured from the time the recording is enabled.
+  */
+void TraceRecorder::enable(const bool flag) noexcept
+{
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (flag && !isEnabled())
+    origin_ = Clock::now();
+  is_enabled_.store(flag, std::memory_order_relaxed);
+}
+
+/*!
+  */
+std::size_t TraceRecorder::numOfEvents() const noexcept
+{
+  std::unique_lock<std::mutex> lock{mutex_};
+  return event_list_.size();
+}
+
+/*!
+  \details
+  The events are complete events ("ph": "X") of the process 0,
+  and time is in microseconds. The threads are named by
+  their indices, since a thread, such as the caller of a loop,
+  runs the phases of some components.
+  */
+void TraceRecorder::writeJson(std::ostream* output) const noexcept
+{
+  using Microsecond = std::chrono::duration<double, std::micro>;
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  // The time stamps of a long rendering need more digits than the default
+  *output << std::fixed << std::setprecision(3);
+  *output << "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [";
+  bool is_first = true;
+  for (std::size_t i = 0; i < thread_list_.size(); ++i) {
+    *output << (is_first ? "\n" : ",\n")
+            << "    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+            << "\"tid\": " << i << ", "
+            << "\"args\": {\"name\": \"Thread " << i << "\"}}";
+    is_first = false;
+  }
+  for (const auto& event : event_list_) {
+    const auto begin = std::chrono::duration_cast<Microsecond>(event.begin_ - origin_);
+    const auto time = std::chrono::duration_cast<Microsecond>(event.end_ - event.begin_);
+    *output << (is_first ? "\n" : ",\n")
+            << "    {\"name\": \"" << event.name_ << "\", "
+            << "\"cat\": \"nanairo\", \"ph\": \"X\", \"pid\": 0, "
+            << "\"tid\": " << event.thread_index_ << ", "
+            << "\"ts\": " << begin.count() << ", "
+            << "\"dur\": " << time.count() << "}";
+    is_first = false;
+  }
+  *output << "\n  ]\n}\n";
+}
+
+/*!
+  */
+uint TraceRecorder::getThreadIndex() noexcept
+{
+  const auto id = std::this_thread::get_id();
+  auto position = std::find(thread_list_.begin(), thread_list_.end(), id);
+  if (position == thread_list_.end()) {
+    thread_list_.emplace_back(id);
+    position = thread_list_.end() - 1;
+  }
+  return zisc::cast<uint>(std::distance(thread_list_.begin(), position));
+}
+
+} // namespace nanairo
@@ -0,0 +1,116 @@
+/*!
+  \file trace_recorder.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRACE_RECORDER_HPP
+#define NANAIRO_TRACE_RECORDER_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+// Zisc
+#include "zisc/non_copyable.hpp"
+#include "zisc/stopwatch.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+//! The time span of a traced scope on a thread
+struct TraceEvent
+{
+  const char* name_;
+  zisc::Stopwatch::Clock::time_point begin_;
+  zisc::Stopwatch::Clock::time_point end_;
+  uint thread_index_;
+};
+
+/*!
+  \brief Record the time spans of the phases of the rendering on the threads
+  \details
+  The events are written in the trace event format of Chrome,
+  which the trace viewers such as Perfetto load as a timeline.
+  The recorder is disabled by default, and a scope costs only a flag check then.
+  The events are added under a lock, so the scopes are placed around
+  the tasks and the phases, not around the work of a pixel.
+  The names of the events have to be string literals.
+  */
+class TraceRecorder : public zisc::NonCopyable<TraceRecorder>
+{
+ public:
+  using Clock = zisc::Stopwatch::Clock;
+
+  /*!
+    \brief Record the time of a scope as an event
+    */
+  class Scope : public zisc::NonCopyable<Scope>
+  {
+   public:
+    //! Start the event if the recorder is enabled
+    Scope(TraceRecorder& recorder, const char* name) noexcept;
+
+    //! Finish the event
+    ~Scope() noexcept;
+
+   private:
+    TraceRecorder* recorder_; //!< Null if the recorder is disabled
+    const char* name_;
+    Clock::time_point begin_;
+  };
+
+
+  //! Create a disabled recorder
+  TraceRecorder() noexcept;
+
+
+  //! Add an event of the current thread
+  void addEvent(const char* name,
+                const Clock::time_point begin,
+                const Clock::time_point end) noexcept;
+
+  //! Remove all events
+  void clear() noexcept;
+
+  //! Enable or disable the recording
+  void enable(const bool flag) noexcept;
+
+  //! Check if the recording is enabled
+  bool isEnabled() const noexcept;
+
+  //! Return the number of the events
+  std::size_t numOfEvents() const noexcept;
+
+  //! Write the events as a JSON of the trace event format
+  void writeJson(std::ostream* output) const noexcept;
+
+ private:
+  //! Return the index of the current thread. The lock has to be held
+  uint getThreadIndex() noexcept;
+
+
+  mutable std::mutex mutex_;
+  std::vector<TraceEvent> event_list_;
+  std::vector<std::thread::id> thread_list_; //!< The threads in the order they appear
+  Clock::time_point origin_;
+  std::atomic<bool> is_enabled_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "trace_recorder-inl.hpp"
+
+#endif // NANAIRO_TRACE_RECORDER_HPP
@@ -0,0 +1,117 @@
+/*!
+  \file tracked_memory_resource-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRACKED_MEMORY_RESOURCE_INL_HPP
+#define NANAIRO_TRACKED_MEMORY_RESOURCE_INL_HPP
+
+#include "tracked_memory_resource.hpp"
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+TrackedMemoryResource::TrackedMemoryResource() noexcept :
+    upstream_{nullptr},
+    used_size_{0},
+    peak_size_{0}
+{
+}
+
+/*!
+  */
+inline
+TrackedMemoryResource::TrackedMemoryResource(
+    zisc::pmr::memory_resource* upstream) noexcept :
+        upstream_{upstream},
+        used_size_{0},
+        peak_size_{0}
+{
+  ZISC_ASSERT(upstream_ != nullptr, "The upstream resource is null.");
+}
+
+/*!
+  */
+inline
+std::size_t TrackedMemoryResource::peakSize() const noexcept
+{
+  return peak_size_.load(std::memory_order_relaxed);
+}
+
+/*!
+  \details
+  The upstream must not be changed after the resource allocates any memory.
+  */
+inline
+void TrackedMemoryResource::setUpstream(zisc::pmr::memory_resource* upstream) noexcept
+{
+  ZISC_ASSERT(upstream != nullptr, "The upstream resource is null.");
+  ZISC_ASSERT(usedSize() == 0, "The resource has allocated memory.");
+  upstream_ = upstream;
+}
+
+/*!
+  */
+inline
+std::size_t TrackedMemoryResource::usedSize() const noexcept
+{
+  return used_size_.load(std::memory_order_relaxed);
+}
+
+/*!
+  */
+inline
+void* TrackedMemoryResource::do_allocate(std::size_t size,
+                                         std::size_t alignment) noexcept
+{
+  ZISC_ASSERT(upstream_ != nullptr, "The upstream resource is null.");
+  void* data = upstream_->allocate(size, alignment);
+  const std::size_t used_size =
+      used_size_.fetch_add(size, std::memory_order_relaxed) + size;
+  // Update the high-water mark
+  std::size_t peak_size = peak_size_.load(std::memory_order_relaxed);
+  while ((peak_size < used_size) &&
+         !peak_size_.compare_exchange_weak(peak_size,
+                                           used_size,
+                                           std::memory_order_relaxed)) {
+  }
+  return data;
+}
+
+/*!
+  */
+inline
+void TrackedMemoryResource::do_deallocate(void* data,
+                                          std::size_t size,
+                                          std::size_t alignment) noexcept
+{
+  upstream_->deallocate(data, size, alignment);
+  used_size_.fetch_sub(size, std::memory_order_relaxed);
+}
+
+/*!
+  */
+inline
+bool TrackedMemoryResource::do_is_equal(
+    const zisc::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TRACKED_MEMORY_RESOURCE_INL_HPP
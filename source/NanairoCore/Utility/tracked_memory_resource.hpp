@@ -0,0 +1,79 @@
+/*!
+  \file tracked_memory_resource.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TRACKED_MEMORY_RESOURCE_HPP
+#define NANAIRO_TRACKED_MEMORY_RESOURCE_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <cstddef>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A memory resource which counts the memory allocated from the upstream
+  \details
+  The resource passes the allocations through to the upstream resource
+  and accumulates the allocated size and the high-water mark.
+  The counters are atomic, so the resource is used from the worker threads
+  as long as the upstream is thread safe.
+  */
+class TrackedMemoryResource : public zisc::pmr::memory_resource,
+                              public zisc::NonCopyable<TrackedMemoryResource>
+{
+ public:
+  //! Create a resource without the upstream
+  TrackedMemoryResource() noexcept;
+
+  //! Create a resource
+  TrackedMemoryResource(zisc::pmr::memory_resource* upstream) noexcept;
+
+
+  //! Return the high-water mark of the allocated size
+  std::size_t peakSize() const noexcept;
+
+  //! Set the upstream resource
+  void setUpstream(zisc::pmr::memory_resource* upstream) noexcept;
+
+  //! Return the size currently allocated
+  std::size_t usedSize() const noexcept;
+
+ protected:
+  //! Allocate memory
+  void* do_allocate(std::size_t size, std::size_t alignment) noexcept override;
+
+  //! Deallocate memory
+  void do_deallocate(void* data,
+                     std::size_t size,
+                     std::size_t alignment) noexcept override;
+
+  //! Check if the resource is the same as the other
+  bool do_is_equal(const zisc::pmr::memory_resource& other) const noexcept override;
+
+ private:
+  zisc::pmr::memory_resource* upstream_;
+  std::atomic<std::size_t> used_size_;
+  std::atomic<std::size_t> peak_size_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "tracked_memory_resource-inl.hpp"
+
+#endif // NANAIRO_TRACKED_MEMORY_RESOURCE_HPP
@@ -46,13 +46,16 @@ constexpr uint16 getWavelength(const uint index) noexcept
 }
 
 /*!
+  \details
+  The loop doesn't exit early so that it is compiled into
+  a vector comparison and a reduction.
   */
 template <uint kN> inline
 constexpr bool hasNegative(const zisc::ArithArray<Float, kN>& array) noexcept
 {
   bool result = false;
-  for (uint index = 0; (index < kN) && !result; ++index)
-    result = zisc::isNegative(array[index]);
+  for (uint index = 0; index < kN; ++index)
+    result = result | zisc::isNegative(array[index]);
   return result;
 }
 
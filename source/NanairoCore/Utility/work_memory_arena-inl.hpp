@@ -0,0 +1,131 @@
+/*!
+  \file work_memory_arena-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WORK_MEMORY_ARENA_INL_HPP
+#define NANAIRO_WORK_MEMORY_ARENA_INL_HPP
+
+#include "work_memory_arena.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <cstdint>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+WorkMemoryArena::Scope::Scope(WorkMemoryArena* arena) noexcept :
+    arena_{arena},
+    marker_{arena->marker()}
+{
+}
+
+/*!
+  */
+inline
+WorkMemoryArena::Scope::~Scope() noexcept
+{
+  arena_->release(marker_);
+}
+
+/*!
+  */
+inline
+constexpr std::size_t WorkMemoryArena::defaultBlockSize() noexcept
+{
+  return CoreConfig::memoryPoolSize();
+}
+
+/*!
+  */
+inline
+auto WorkMemoryArena::marker() const noexcept -> Marker
+{
+  return Marker{current_block_, offset_};
+}
+
+/*!
+  \details
+  The memory allocated after the marker must not be used after the release.
+  */
+inline
+void WorkMemoryArena::release(const Marker& marker) noexcept
+{
+  ZISC_ASSERT((marker.block_ < current_block_) ||
+              ((marker.block_ == current_block_) && (marker.offset_ <= offset_)),
+              "The marker is ahead of the current position.");
+  current_block_ = marker.block_;
+  offset_ = marker.offset_;
+}
+
+/*!
+  */
+inline
+void WorkMemoryArena::reset() noexcept
+{
+  current_block_ = 0;
+  offset_ = 0;
+}
+
+/*!
+  */
+inline
+void* WorkMemoryArena::do_allocate(std::size_t size,
+                                   std::size_t alignment) noexcept
+{
+  void* data = allocateFromCurrentBlock(size, alignment);
+  if (data == nullptr)
+    data = allocateFromNextBlock(size, alignment);
+  return data;
+}
+
+/*!
+  */
+inline
+void WorkMemoryArena::do_deallocate(void*, std::size_t, std::size_t) noexcept
+{
+}
+
+/*!
+  */
+inline
+bool WorkMemoryArena::do_is_equal(
+    const zisc::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+/*!
+  */
+inline
+void* WorkMemoryArena::allocateFromCurrentBlock(
+    const std::size_t size,
+    const std::size_t alignment) noexcept
+{
+  void* data = nullptr;
+  if (current_block_ < block_list_.size()) {
+    const auto& block = block_list_[current_block_];
+    const auto address = reinterpret_cast<std::uintptr_t>(block.data_) + offset_;
+    const std::size_t padding = (alignment - (address % alignment)) % alignment;
+    if ((offset_ + padding + size) <= block.size_) {
+      data = block.data_ + offset_ + padding;
+      offset_ = offset_ + padding + size;
+    }
+  }
+  return data;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_WORK_MEMORY_ARENA_INL_HPP
@@ -0,0 +1,125 @@
+/*!
+  \file work_memory_arena.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "work_memory_arena.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+WorkMemoryArena::WorkMemoryArena() noexcept :
+    WorkMemoryArena(nullptr, defaultBlockSize())
+{
+}
+
+/*!
+  */
+WorkMemoryArena::WorkMemoryArena(const std::size_t block_size) noexcept :
+    WorkMemoryArena(nullptr, block_size)
+{
+}
+
+/*!
+  */
+WorkMemoryArena::WorkMemoryArena(zisc::pmr::memory_resource* upstream) noexcept :
+    WorkMemoryArena(upstream, defaultBlockSize())
+{
+}
+
+/*!
+  \details
+  The blocks are allocated from the system if the upstream is null.
+  The first block is allocated at the first allocation,
+  so the thread which uses the arena touches the block first.
+  */
+WorkMemoryArena::WorkMemoryArena(zisc::pmr::memory_resource* upstream,
+                                 const std::size_t block_size) noexcept :
+    upstream_{upstream},
+    block_size_{block_size},
+    current_block_{0},
+    offset_{0}
+{
+  ZISC_ASSERT(0 < block_size_, "The block size is zero.");
+}
+
+/*!
+  */
+WorkMemoryArena::~WorkMemoryArena() noexcept
+{
+  for (auto& block : block_list_)
+    deallocateBlock(block);
+  block_list_.clear();
+}
+
+/*!
+  */
+std::size_t WorkMemoryArena::totalSize() const noexcept
+{
+  std::size_t size = 0;
+  for (const auto& block : block_list_)
+    size += block.size_;
+  return size;
+}
+
+/*!
+  */
+uint8* WorkMemoryArena::allocateBlock(const std::size_t size) noexcept
+{
+  void* data = (upstream_ != nullptr)
+      ? upstream_->allocate(size, alignof(std::max_align_t))
+      : std::malloc(size);
+  ZISC_ASSERT(data != nullptr, "The block allocation failed.");
+  return zisc::cast<uint8*>(data);
+}
+
+/*!
+  \details
+  The blocks which are too small for the allocation are skipped
+  until the arena is released.
+  */
+void* WorkMemoryArena::allocateFromNextBlock(const std::size_t size,
+                                             const std::size_t alignment) noexcept
+{
+  const std::size_t required_size = size + alignment;
+  std::size_t index = (current_block_ < block_list_.size()) ? current_block_ + 1
+                                                            : current_block_;
+  while ((index < block_list_.size()) && (block_list_[index].size_ < required_size))
+    ++index;
+  if (index == block_list_.size()) {
+    const std::size_t block_size = zisc::max(block_size_, required_size);
+    auto data = allocateBlock(block_size);
+    block_list_.emplace_back(Block{data, block_size});
+  }
+  current_block_ = index;
+  offset_ = 0;
+  return allocateFromCurrentBlock(size, alignment);
+}
+
+/*!
+  */
+void WorkMemoryArena::deallocateBlock(Block& block) noexcept
+{
+  if (upstream_ != nullptr)
+    upstream_->deallocate(block.data_, block.size_, alignof(std::max_align_t));
+  else
+    std::free(block.data_);
+  block.data_ = nullptr;
+}
+
+} // namespace nanairo
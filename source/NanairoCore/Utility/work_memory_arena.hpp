@@ -0,0 +1,153 @@
+/*!
+  \file work_memory_arena.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_WORK_MEMORY_ARENA_HPP
+#define NANAIRO_WORK_MEMORY_ARENA_HPP
+
+// Standard C++ library
+#include <cstddef>
+#include <vector>
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+//! \addtogroup Core
+//! \{
+
+/*!
+  \brief A bump allocator for the memory of a thread
+  \details
+  An allocation is a pointer bump in the current block and
+  a deallocation does nothing. The memory is released at once
+  by rewinding the arena to a marker or by reset().
+  The blocks are kept after the release, so the arena stops allocating
+  from the system once it has grown to the working set of a cycle.
+  The blocks are allocated from the upstream resource if it's given,
+  so the upstream is locked once per block instead of once per allocation.
+  An arena which is never rewound holds the long-lived objects,
+  so it has to outlive the objects.
+  The arena isn't thread safe, each thread has its own arena.
+  The arena is aligned to a cache line so that the positions of
+  the arenas of the threads, which are bumped at each allocation,
+  don't share a line.
+  */
+class alignas(64) WorkMemoryArena : public zisc::pmr::memory_resource,
+                        public zisc::NonCopyable<WorkMemoryArena>
+{
+ public:
+  //! The position of the arena
+  struct Marker
+  {
+    std::size_t block_;
+    std::size_t offset_;
+  };
+
+  /*!
+    \brief Release the memory allocated in the scope at the end of the scope
+    */
+  class Scope : public zisc::NonCopyable<Scope>
+  {
+   public:
+    //! Mark the current position of the arena
+    Scope(WorkMemoryArena* arena) noexcept;
+
+    //! Rewind the arena to the marked position
+    ~Scope() noexcept;
+
+   private:
+    WorkMemoryArena* arena_;
+    Marker marker_;
+  };
+
+
+  //! Create an arena
+  WorkMemoryArena() noexcept;
+
+  //! Create an arena
+  WorkMemoryArena(const std::size_t block_size) noexcept;
+
+  //! Create an arena which allocates the blocks from the upstream
+  WorkMemoryArena(zisc::pmr::memory_resource* upstream) noexcept;
+
+  //! Create an arena which allocates the blocks from the upstream
+  WorkMemoryArena(zisc::pmr::memory_resource* upstream,
+                  const std::size_t block_size) noexcept;
+
+  //! Free the blocks
+  ~WorkMemoryArena() noexcept;
+
+
+  //! Return the default size of a block
+  static constexpr std::size_t defaultBlockSize() noexcept;
+
+  //! Return the current position
+  Marker marker() const noexcept;
+
+  //! Release the memory allocated after the marker
+  void release(const Marker& marker) noexcept;
+
+  //! Release all memory
+  void reset() noexcept;
+
+  //! Return the total size of the blocks
+  std::size_t totalSize() const noexcept;
+
+ protected:
+  //! Allocate memory
+  void* do_allocate(std::size_t size, std::size_t alignment) noexcept override;
+
+  //! Deallocation is deferred until the arena is released
+  void do_deallocate(void* data,
+                     std::size_t size,
+                     std::size_t alignment) noexcept override;
+
+  //! Check if the resource is the same as the other
+  bool do_is_equal(const zisc::pmr::memory_resource& other) const noexcept override;
+
+ private:
+  struct Block
+  {
+    uint8* data_;
+    std::size_t size_;
+  };
+
+
+  //! Allocate a block from the upstream or the system
+  uint8* allocateBlock(const std::size_t size) noexcept;
+
+  //! Allocate memory from the block at the current position
+  void* allocateFromCurrentBlock(const std::size_t size,
+                                 const std::size_t alignment) noexcept;
+
+  //! Move to the next block which has the room and allocate memory
+  void* allocateFromNextBlock(const std::size_t size,
+                              const std::size_t alignment) noexcept;
+
+  //! Free a block to the upstream or the system
+  void deallocateBlock(Block& block) noexcept;
+
+
+  zisc::pmr::memory_resource* upstream_;
+  std::vector<Block> block_list_;
+  std::size_t block_size_;
+  std::size_t current_block_;
+  std::size_t offset_;
+};
+
+//! \} Core
+
+} // namespace nanairo
+
+#include "work_memory_arena-inl.hpp"
+
+#endif // NANAIRO_WORK_MEMORY_ARENA_HPP
@@ -40,6 +40,32 @@ function(makeCoreConfigFile config_file_path config_file_inl_path)
     message(FATAL_ERROR "'NANAIRO_PATH_TRACING_EXPLICIT_CONNECTION_ONLY' and 'NANAIRO_PATH_TRACING_IMPLICIT_CONNECTION_ONLY' can not be specified together.")
   endif()
 
+  # Texture setting
+  if(NANAIRO_COMPACT_TEXTURE_SPECTRA)
+    set(NANAIRO_COMPACT_TEXTURE_SPECTRA_IS_ENABLED "true")
+  else()
+    set(NANAIRO_COMPACT_TEXTURE_SPECTRA_IS_ENABLED "false")
+  endif()
+  if(NANAIRO_DIRECT_TEXTURE_LAYOUT)
+    set(NANAIRO_DIRECT_TEXTURE_LAYOUT_IS_ENABLED "true")
+  else()
+    set(NANAIRO_DIRECT_TEXTURE_LAYOUT_IS_ENABLED "false")
+  endif()
+
+  # Geometry setting
+  if(NANAIRO_WATERTIGHT_TRIANGLE_TEST)
+    set(NANAIRO_WATERTIGHT_TRIANGLE_TEST_IS_ENABLED "true")
+  else()
+    set(NANAIRO_WATERTIGHT_TRIANGLE_TEST_IS_ENABLED "false")
+  endif()
+
+  # Debug output
+  if(NANAIRO_PIXEL_COST_HEATMAP)
+    set(NANAIRO_PIXEL_COST_HEATMAP_IS_ENABLED "true")
+  else()
+    set(NANAIRO_PIXEL_COST_HEATMAP_IS_ENABLED "false")
+  endif()
+
   configure_file(${__nanairo_core_root__}/nanairo_core_config.hpp.in
                  ${config_file_path})
   configure_file(${__nanairo_core_root__}/nanairo_core_config-inl.hpp.in
@@ -50,19 +76,36 @@ endfunction(makeCoreConfigFile)
 
 # Load nanairo core files
 function(getNanairoCore core_source_files core_definitions)
+  getNanairoCoreVariant(${NANAIRO_WAVELENGTH_SAMPLE_SIZE}
+                        ${PROJECT_BINARY_DIR}/include
+                        source_files
+                        definitions)
+
+
+  # Output variables
+  set(${core_source_files} ${source_files} PARENT_SCOPE)
+  set(${core_definitions} ${definitions} PARENT_SCOPE)
+endfunction(getNanairoCore)
+
+
+# Load nanairo core files of the wavelength sample size,
+# the config files are made in the include dir
+function(getNanairoCoreVariant sample_size include_dir core_source_files core_definitions)
+  # The config files refer to the sample size
+  set(NANAIRO_WAVELENGTH_SAMPLE_SIZE ${sample_size})
   # Source files
   findNanairoSourceFiles(${__nanairo_core_root__} source_files)
   # Definitions
   set(definitions "")
   set(parameter_file_path
-      ${PROJECT_BINARY_DIR}/include/NanairoCore/Color/SpectralTransportParameter/spectral_transport_parameters.hpp)
+      ${include_dir}/NanairoCore/Color/SpectralTransportParameter/spectral_transport_parameters.hpp)
   configureSpectralTransportParameters(${parameter_file_path})
   list(APPEND source_files ${parameter_file_path})
   # Config file
   set(config_file_path
-      ${PROJECT_BINARY_DIR}/include/NanairoCore/nanairo_core_config.hpp)
+      ${include_dir}/NanairoCore/nanairo_core_config.hpp)
   set(config_file_inl_path
-      ${PROJECT_BINARY_DIR}/include/NanairoCore/nanairo_core_config-inl.hpp)
+      ${include_dir}/NanairoCore/nanairo_core_config-inl.hpp)
   makeCoreConfigFile(${config_file_path} ${config_file_inl_path})
   list(APPEND source_files ${config_file_path})
 
@@ -73,4 +116,4 @@ function(getNanairoCore core_source_files core_definitions)
   # Output variables
   set(${core_source_files} ${source_files} PARENT_SCOPE)
   set(${core_definitions} ${definitions} PARENT_SCOPE)
-endfunction(getNanairoCore)
+endfunction(getNanairoCoreVariant)
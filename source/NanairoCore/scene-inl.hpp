@@ -60,6 +60,16 @@ const Film& Scene::film() const noexcept
   return *film_;
 }
 
+/*!
+  \details
+  No detailed.
+  */
+inline
+World& Scene::world() noexcept
+{
+  return *world_;
+}
+
 /*!
   \details
   No detailed.
@@ -25,6 +25,7 @@
 #include "Setting/object_model_setting_node.hpp"
 #include "Setting/scene_setting_node.hpp"
 #include "Setting/setting_node_base.hpp"
+#include "Utility/loading_phase.hpp"
 
 namespace nanairo {
 
@@ -45,27 +46,64 @@ void Scene::initialize(System& system, const SettingNodeBase* settings) noexcept
 {
   const auto scene_settings = castNode<SceneSettingNode>(settings);
   auto& data_resource = system.dataMemoryManager();
-
-  // Create a camera
   const auto camera_settings = scene_settings->cameraSettingNode();
-  initializeCamera(system, camera_settings);
 
-  // Create a world
-  world_ = zisc::UniqueMemoryPointer<World>::make(&data_resource, system, settings);
+  {
+    // Create a film
+    auto film_task = std::async(std::launch::async,
+    [this, &system, camera_settings]()
+    {
+      initializeFilm(system, camera_settings);
+    });
+    // Create a world
+    world_ = zisc::UniqueMemoryPointer<World>::make(&data_resource, system, settings);
+    film_task.wait();
+  }
+
+  // Create a camera
+  makeCamera(system, camera_settings);
 }
 
 /*!
+  \details
+  The film doesn't depend on the world, so it's allocated while
+  the world is made. The task runs on its own thread instead of
+  the task scheduler, since it waits for the thread manager and
+  a thread manager thread which waits for a task group could run it.
   */
-void Scene::initializeCamera(System& system, const SettingNodeBase* settings) noexcept
+void Scene::initializeFilm(System& system, const SettingNodeBase* settings) noexcept
 {
   const auto object_settings = castNode<ObjectModelSettingNode>(settings);
-  auto& data_resource = system.dataMemoryManager();
-
-  // Film
+  auto& data_resource = system.trackedMemoryResource(MemoryCategory::kFilm);
+  const auto start_time = system.stopwatch().elapsedTime();
+  const auto start_memory = residentMemorySize();
   film_ = zisc::UniqueMemoryPointer<Film>::make(&data_resource,
                                                 system,
                                                 object_settings->objectSettingNode());
-  // Camera
+  system.recordLoadingPhase("Film allocation", start_time, start_memory);
+}
+
+/*!
+  \details
+  The settings are the scene settings which the scene was loaded from.
+  The matrix is applied after the transformations of the camera settings,
+  so a camera is placed relative to the camera of the scene.
+  The film is kept, so the world and the film aren't remade.
+  */
+void Scene::resetCamera(System& system,
+                        const SettingNodeBase* settings,
+                        const Matrix4x4& matrix) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(settings);
+  makeCamera(system, scene_settings->cameraSettingNode());
+  camera_->transform(matrix);
+}
+
+/*!
+  */
+void Scene::makeCamera(System& system, const SettingNodeBase* settings) noexcept
+{
+  const auto object_settings = castNode<ObjectModelSettingNode>(settings);
   camera_ = CameraModel::makeCamera(system, object_settings->objectSettingNode());
   camera_->setFilm(film_.get());
   // Transformation
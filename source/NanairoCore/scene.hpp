@@ -16,6 +16,7 @@
 #include "zisc/non_copyable.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "Geometry/transformation.hpp"
 #include "Setting/setting_node_base.hpp"
 
 namespace nanairo {
@@ -53,6 +54,14 @@ class Scene : public zisc::NonCopyable<Scene>
   //! Returh the film
   const Film& film() const noexcept;
 
+  //! Remake the camera from the settings and apply the transformation to it
+  void resetCamera(System& system,
+                   const SettingNodeBase* settings,
+                   const Matrix4x4& matrix) noexcept;
+
+  //! Return the world data
+  World& world() noexcept;
+
   //! Return the world data
   const World& world() const noexcept;
 
@@ -60,8 +69,11 @@ class Scene : public zisc::NonCopyable<Scene>
   //! Initialize the scene
   void initialize(System& system, const SettingNodeBase* settings) noexcept;
 
-  //! Initialize the camera
-  void initializeCamera(System& system, const SettingNodeBase* settings) noexcept;
+  //! Initialize the film of the camera
+  void initializeFilm(System& system, const SettingNodeBase* settings) noexcept;
+
+  //! Make the camera of the settings and set the film to it
+  void makeCamera(System& system, const SettingNodeBase* settings) noexcept;
 
 
   zisc::UniqueMemoryPointer<CameraModel> camera_;
@@ -13,7 +13,10 @@
 #include "system.hpp"
 // Standard C++ library
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <vector>
 // Zisc
@@ -27,6 +30,9 @@
 #include "Color/color_space.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "Sampling/Sampler/sampler.hpp"
+#include "Utility/loading_phase.hpp"
+#include "Utility/tracked_memory_resource.hpp"
+#include "Utility/work_memory_arena.hpp"
 
 namespace nanairo {
 
@@ -47,6 +53,14 @@ std::array<Integer, 2> System::calcTaskRange(const Integer range,
   return calcTaskRange(range, threadManager().numOfThreads(), task_id);
 }
 
+/*!
+  */
+inline
+Float System::adaptiveSamplingThreshold() const noexcept
+{
+  return adaptive_sampling_threshold_;
+}
+
 /*!
   */
 inline
@@ -65,6 +79,14 @@ auto System::globalMemoryManager() noexcept -> MemoryManager&
   return memory_manager_list_[1];
 }
 
+/*!
+  */
+inline
+auto System::imageMemoryManager() noexcept -> MemoryManager&
+{
+  return memory_manager_list_[2];
+}
+
 /*!
   */
 inline
@@ -74,6 +96,95 @@ Sampler& System::globalSampler() noexcept
   return *global_sampler;
 }
 
+/*!
+  */
+inline
+const Index2d& System::cropOffset() const noexcept
+{
+  return crop_offset_;
+}
+
+/*!
+  */
+inline
+const char* System::memoryCategoryName(const MemoryCategory category) noexcept
+{
+  const char* name = nullptr;
+  switch (category) {
+   case MemoryCategory::kBvh:
+    name = "BVH";
+    break;
+   case MemoryCategory::kObject:
+    name = "Object";
+    break;
+   case MemoryCategory::kTexture:
+    name = "Texture";
+    break;
+   case MemoryCategory::kFilm:
+    name = "Film";
+    break;
+   case MemoryCategory::kPhotonMap:
+    name = "Photon map";
+    break;
+   case MemoryCategory::kSampler:
+    name = "Sampler";
+    break;
+   case MemoryCategory::kDenoiser:
+    name = "Denoiser";
+    break;
+  }
+  return name;
+}
+
+/*!
+  */
+inline
+constexpr uint System::numOfMemoryCategories() noexcept
+{
+  return zisc::cast<uint>(MemoryCategory::kDenoiser) + 1;
+}
+
+/*!
+  */
+inline
+OutOfCoreMemoryResource& System::filmMemoryResource() noexcept
+{
+  return film_resource_;
+}
+
+/*!
+  */
+inline
+const Index2d& System::fullImageResolution() const noexcept
+{
+  return full_image_resolution_;
+}
+
+/*!
+  */
+inline
+const zisc::pmr::vector<LoadingPhase>& System::loadingPhaseList() const noexcept
+{
+  return loading_phase_list_;
+}
+
+/*!
+  \details
+  The phases can be run in parallel, so the memory growth of a phase
+  includes the growth of the phases which overlap it.
+  */
+inline
+void System::recordLoadingPhase(const char* name,
+                                const zisc::Stopwatch::Clock::duration start_time,
+                                const std::size_t start_memory) noexcept
+{
+  const auto time = stopwatch().elapsedTime() - start_time;
+  const int64 memory_delta = zisc::cast<int64>(residentMemorySize()) -
+                             zisc::cast<int64>(start_memory);
+  std::unique_lock<std::mutex> lock{loading_phase_mutex_};
+  loading_phase_list_.emplace_back(LoadingPhase{name, time, memory_delta});
+}
+
 /*!
   */
 inline
@@ -107,12 +218,94 @@ uint System::imageWidthResolution() const noexcept
 /*!
   */
 inline
-Sampler& System::localSampler(const uint index) noexcept
+bool System::isAdaptiveSamplingEnabled() const noexcept
+{
+  return is_adaptive_sampling_enabled_ == kTrue;
+}
+
+/*!
+  */
+inline
+bool System::isHardwareCounterEnabled() const noexcept
+{
+  return !hardware_counter_list_.empty();
+}
+
+/*!
+  */
+inline
+bool System::isMappedFilmEnabled() const noexcept
 {
-  auto& sampler = sampler_list_[index];
+  return film_resource_.isOpen();
+}
+
+/*!
+  */
+inline
+bool System::isOutOfCoreEnabled() const noexcept
+{
+  return out_of_core_resource_.isOpen();
+}
+
+/*!
+  */
+inline
+Sampler& System::localSampler(const uint thread_id, const uint index) noexcept
+{
+  ZISC_ASSERT(thread_id < threadManager().numOfThreads(),
+              "The thread id is out of range.");
+  auto& sampler = sampler_list_[thread_id];
+  sampler->setStream(zisc::cast<uint32>(index));
   return *sampler;
 }
 
+/*!
+  \details
+  The pool keeps all threads, the threads over the number only wait
+  during the passes which distribute the work dynamically.
+  */
+inline
+uint System::numOfActiveThreads() const noexcept
+{
+  return num_of_active_threads_;
+}
+
+/*!
+  */
+inline
+OutOfCoreMemoryResource& System::outOfCoreMemoryResource() noexcept
+{
+  return out_of_core_resource_;
+}
+
+/*!
+  \details
+  The request only stores the number, so it can be called from
+  another thread or a signal handler while a cycle is rendered.
+  */
+inline
+void System::requestNumOfActiveThreads(const uint num_of_threads) noexcept
+{
+  const uint n = zisc::clamp(num_of_threads, 1u, threadManager().numOfThreads());
+  requested_num_of_active_threads_.store(n, std::memory_order_relaxed);
+}
+
+/*!
+  */
+inline
+uint System::requestedNumOfActiveThreads() const noexcept
+{
+  return requested_num_of_active_threads_.load(std::memory_order_relaxed);
+}
+
+/*!
+  */
+inline
+TaskScheduler& System::taskScheduler() noexcept
+{
+  return *task_scheduler_;
+}
+
 /*!
   \details
   No detailed.
@@ -138,9 +331,43 @@ const zisc::ThreadManager& System::threadManager() const noexcept
   No detailed.
   */
 inline
-auto System::threadMemoryManager(const uint thread_number) noexcept -> MemoryManager&
+WorkMemoryArena& System::threadMemoryManager(const uint thread_number) noexcept
+{
+  return thread_memory_list_[thread_number];
+}
+
+/*!
+  */
+inline
+TraceRecorder& System::traceRecorder() noexcept
+{
+  return trace_recorder_;
+}
+
+/*!
+  */
+inline
+const TraceRecorder& System::traceRecorder() const noexcept
+{
+  return trace_recorder_;
+}
+
+/*!
+  */
+inline
+TrackedMemoryResource& System::trackedMemoryResource(
+    const MemoryCategory category) noexcept
+{
+  return tracked_resource_list_[zisc::cast<uint>(category)];
+}
+
+/*!
+  */
+inline
+const TrackedMemoryResource& System::trackedMemoryResource(
+    const MemoryCategory category) const noexcept
 {
-  return memory_manager_list_[thread_number + 2];
+  return tracked_resource_list_[zisc::cast<uint>(category)];
 }
 
 // Color
@@ -217,6 +444,22 @@ bool System::isSpectraMode() const noexcept
   return colorMode() == RenderingColorMode::kSpectra;
 }
 
+/*!
+  */
+inline
+bool System::isTileWavelengthSamplingEnabled() const noexcept
+{
+  return is_tile_wavelength_sampling_enabled_ == kTrue;
+}
+
+/*!
+  */
+inline
+bool System::isXyzFilmEnabled() const noexcept
+{
+  return is_xyz_film_enabled_ == kTrue;
+}
+
 /*!
   */
 inline
@@ -233,6 +476,14 @@ uint32 System::samplerSeed() const noexcept
   return sampler_seed_;
 }
 
+/*!
+  */
+inline
+uint32 System::samplesPerCycle() const noexcept
+{
+  return samples_per_cycle_;
+}
+
 /*!
   */
 inline
@@ -9,7 +9,12 @@
 
 #include "system.hpp"
 // Standard C++ library
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 // Zisc
 #include "zisc/memory_manager.hpp"
@@ -18,16 +23,27 @@
 #include "zisc/unique_memory_pointer.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "Color/rgb_spectra_table.hpp"
 #include "Color/xyz_color_matching_function.hpp"
 #include "Denoiser/denoiser.hpp"
+#include "Material/SurfaceModel/Surface/layered_diffuse_table.hpp"
+#include "Material/TextureModel/texture_tile_cache.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "RenderingMethod/rendering_method.hpp"
 #include "Sampling/sample_statistics.hpp"
+#include "Sampling/Sampler/cmj_table.hpp"
 #include "Sampling/Sampler/sampler.hpp"
 #include "Setting/rendering_method_setting_node.hpp"
 #include "Setting/setting_node_base.hpp"
 #include "Setting/system_setting_node.hpp"
 #include "ToneMappingOperator/tone_mapping_operator.hpp"
+#include "Utility/hardware_counter.hpp"
+#include "Utility/huge_page_memory_resource.hpp"
+#include "Utility/out_of_core_memory_resource.hpp"
+#include "Utility/loading_phase.hpp"
+#include "Utility/task_scheduler.hpp"
+#include "Utility/thread_affinity.hpp"
+#include "Utility/work_memory_arena.hpp"
 
 namespace nanairo {
 
@@ -36,9 +52,45 @@ namespace nanairo {
   No detailed.
   */
 System::System(const SettingNodeBase* settings) noexcept :
-    memory_manager_list_{zisc::cast<std::size_t>(castNode<SystemSettingNode>(settings)->numOfThreads() + 2)},
-    sampler_list_{&dataMemoryManager()}
+    memory_manager_list_{3},
+    thread_memory_list_(zisc::cast<std::size_t>(castNode<SystemSettingNode>(settings)->numOfThreads())),
+    sampler_list_{&trackedMemoryResource(MemoryCategory::kSampler)},
+    loading_phase_list_{&dataMemoryManager()}
 {
+  static_assert(numOfMemoryCategories() == std::tuple_size<decltype(tracked_resource_list_)>::value,
+                "The number of the tracked resources is wrong.");
+  // The photon maps are rebuilt at each cycle in the global memory
+  // The large arrays of the traversal and the film can be placed on huge pages
+  // The film can be mapped from a file, which passes through until it's opened
+  data_huge_page_resource_.setUpstream(&dataMemoryManager());
+  global_huge_page_resource_.setUpstream(&globalMemoryManager());
+  out_of_core_resource_.setUpstream(&trackedMemoryResource(MemoryCategory::kObject));
+  const bool huge_page_allocation_enabled =
+      castNode<SystemSettingNode>(settings)->isHugePageAllocationEnabled();
+  for (uint i = 0; i < numOfMemoryCategories(); ++i) {
+    const auto category = zisc::cast<MemoryCategory>(i);
+    const bool uses_huge_pages = huge_page_allocation_enabled &&
+        ((category == MemoryCategory::kBvh) ||
+         (category == MemoryCategory::kObject) ||
+         (category == MemoryCategory::kFilm) ||
+         (category == MemoryCategory::kPhotonMap));
+    zisc::pmr::memory_resource* upstream = nullptr;
+    if (category == MemoryCategory::kPhotonMap) {
+      upstream = uses_huge_pages
+          ? zisc::cast<zisc::pmr::memory_resource*>(&global_huge_page_resource_)
+          : zisc::cast<zisc::pmr::memory_resource*>(&globalMemoryManager());
+    }
+    else {
+      upstream = uses_huge_pages
+          ? zisc::cast<zisc::pmr::memory_resource*>(&data_huge_page_resource_)
+          : zisc::cast<zisc::pmr::memory_resource*>(&dataMemoryManager());
+    }
+    if (category == MemoryCategory::kFilm) {
+      film_resource_.setUpstream(upstream);
+      upstream = &film_resource_;
+    }
+    trackedMemoryResource(category).setUpstream(upstream);
+  }
   initialize(settings);
 }
 
@@ -49,11 +101,187 @@ System::System(const SettingNodeBase* settings) noexcept :
 System::~System() noexcept
 {
   // Destroy before the memory managers are destroyed
+  hardware_counter_list_.clear();
   sampler_list_.clear();
+  loading_phase_list_.clear();
+  cmj_table_.reset();
   thread_manager_.reset();
+  task_scheduler_.reset();
   tone_mapping_operator_.reset();
   xyz_color_matching_function_.reset();
   denoiser_.reset();
+  rgb_spectra_table_.reset();
+  layered_diffuse_table_.reset();
+  texture_tile_cache_.reset();
+}
+
+/*!
+  \details
+  Each thread of the pool opens its counter in a task like the binding
+  of the threads, and the last counter is the counter of the calling thread,
+  which runs the serial parts of a cycle.
+  The counters are closed if no thread can open them.
+  */
+bool System::enableHardwareCounters() noexcept
+{
+  if (isHardwareCounterEnabled())
+    return true;
+  auto& threads = threadManager();
+  const uint num_of_threads = threads.numOfThreads();
+  std::vector<HardwareCounter> counter_list(num_of_threads + 1);
+  std::atomic<uint> num_of_started_threads{0};
+  std::atomic<uint> num_of_opened_counters{0};
+
+  auto open_counter =
+  [num_of_threads, &counter_list, &num_of_started_threads, &num_of_opened_counters]
+  (const uint thread_id, const uint) noexcept
+  {
+    if (counter_list[thread_id].open())
+      num_of_opened_counters.fetch_add(1);
+    // Wait for the other threads
+    num_of_started_threads.fetch_add(1);
+    while (num_of_started_threads.load() < num_of_threads)
+      std::this_thread::yield();
+  };
+
+  constexpr uint start = 0;
+  auto result = threads.enqueueLoop(open_counter, start, num_of_threads,
+                                    &dataMemoryManager());
+  result.wait();
+  if (counter_list[num_of_threads].open())
+    num_of_opened_counters.fetch_add(1);
+
+  const bool is_enabled = 0 < num_of_opened_counters.load();
+  if (is_enabled)
+    hardware_counter_list_ = std::move(counter_list);
+  return is_enabled;
+}
+
+/*!
+  \details
+  The table is made when the first layered diffuse surface is made,
+  and is shared by all layered diffuse surfaces.
+  */
+const LayeredDiffuseTable& System::layeredDiffuseTable() noexcept
+{
+  std::call_once(layered_diffuse_table_flag_, [this]()
+  {
+    auto& data_resource = dataMemoryManager();
+    layered_diffuse_table_ = zisc::UniqueMemoryPointer<LayeredDiffuseTable>::make(
+        &data_resource,
+        &data_resource);
+  });
+  return *layered_diffuse_table_;
+}
+
+/*!
+  \details
+  The counts are the counts since the counters are opened,
+  so a phase is measured by the difference of the reads at its boundaries.
+  */
+HardwareCounts System::readHardwareCounters() const noexcept
+{
+  HardwareCounts counts;
+  for (const auto& counter : hardware_counter_list_)
+    counts.merge(counter.read());
+  return counts;
+}
+
+/*!
+  \details
+  The table is made only when a texture needs it.
+  Textures are initialized in parallel, so the first call makes the table
+  and the other calls wait for it.
+  */
+const RgbSpectraTable& System::rgbSpectraTable(
+    zisc::pmr::memory_resource* work_resource) noexcept
+{
+  std::call_once(rgb_spectra_table_flag_, [this, work_resource]()
+  {
+    auto& data_resource = dataMemoryManager();
+    rgb_spectra_table_ = zisc::UniqueMemoryPointer<RgbSpectraTable>::make(
+        &data_resource,
+        *this,
+        &data_resource,
+        work_resource);
+  });
+  return *rgb_spectra_table_;
+}
+
+/*!
+  \details
+  The cache is made when the first tiled image texture is made,
+  and is shared by all tiled image textures.
+  */
+TextureTileCache& System::textureTileCache() noexcept
+{
+  std::call_once(texture_tile_cache_flag_, [this]()
+  {
+    auto& data_resource = trackedMemoryResource(MemoryCategory::kTexture);
+    texture_tile_cache_ = zisc::UniqueMemoryPointer<TextureTileCache>::make(
+        &data_resource,
+        CoreConfig::textureTileCacheSize());
+  });
+  return *texture_tile_cache_;
+}
+
+/*!
+  \details
+  The render loop calls this between the cycles,
+  so the passes of a cycle see the same number of the active threads.
+  Return true if the number is changed.
+  */
+bool System::updateActiveThreads() noexcept
+{
+  const uint num_of_threads = requestedNumOfActiveThreads();
+  const bool is_changed = num_of_threads != num_of_active_threads_;
+  num_of_active_threads_ = num_of_threads;
+  return is_changed;
+}
+
+/*!
+  \details
+  Each thread of the pool runs exactly one task,
+  since a task waits until all threads start their tasks.
+  A thread memory pool is touched by its thread after the binding,
+  so the pages of the pool are placed on the local memory node of the thread
+  by the first touch policy of the OS.
+  */
+void System::bindThreads(const bool thread_affinity_enabled,
+                         const bool memory_first_touch_enabled,
+                         const bool background_priority_enabled) noexcept
+{
+  auto& threads = threadManager();
+  const uint num_of_threads = threads.numOfThreads();
+  std::atomic<uint> num_of_started_threads{0};
+
+  auto bind_thread =
+  [this, thread_affinity_enabled, memory_first_touch_enabled,
+   background_priority_enabled, num_of_threads, &num_of_started_threads]
+  (const uint thread_id, const uint) noexcept
+  {
+    if (thread_affinity_enabled)
+      bindCurrentThread(thread_id);
+    if (background_priority_enabled)
+      lowerCurrentThreadPriority();
+    if (memory_first_touch_enabled) {
+      // Leave the room of the alignment in the first block
+      constexpr std::size_t block_size = WorkMemoryArena::defaultBlockSize();
+      constexpr std::size_t size = block_size - (block_size >> 4);
+      auto& memory_manager = threadMemoryManager(thread_id);
+      touchMemory(&memory_manager, size);
+      memory_manager.reset();
+    }
+    // Wait for the other threads
+    num_of_started_threads.fetch_add(1);
+    while (num_of_started_threads.load() < num_of_threads)
+      std::this_thread::yield();
+  };
+
+  constexpr uint start = 0;
+  auto result = threads.enqueueLoop(bind_thread, start, num_of_threads,
+                                    &dataMemoryManager());
+  result.wait();
 }
 
 /*!
@@ -68,27 +296,94 @@ void System::initialize(const SettingNodeBase* settings) noexcept
   auto& data_resource = dataMemoryManager();
   // Thread pool
   {
+    const auto start_time = stopwatch_.elapsedTime();
+    const auto start_memory = residentMemorySize();
     const auto num_of_threads = system_settings->numOfThreads();
     thread_manager_ = zisc::UniqueMemoryPointer<zisc::ThreadManager>::make(
         &data_resource,
         num_of_threads,
         &data_resource);
+    const bool thread_affinity_enabled =
+        system_settings->isThreadAffinityEnabled();
+    const bool memory_first_touch_enabled =
+        system_settings->isMemoryFirstTouchEnabled();
+    const bool background_priority_enabled =
+        system_settings->isBackgroundPriorityEnabled();
+    task_scheduler_ = zisc::UniqueMemoryPointer<TaskScheduler>::make(
+        &data_resource,
+        num_of_threads,
+        thread_affinity_enabled);
+    if (thread_affinity_enabled || memory_first_touch_enabled ||
+        background_priority_enabled) {
+      bindThreads(thread_affinity_enabled,
+                  memory_first_touch_enabled,
+                  background_priority_enabled);
+    }
+    // All threads are active until the number is requested
+    static_assert(std::atomic<uint>::is_always_lock_free,
+                  "The request of the active threads isn't signal safe.");
+    requested_num_of_active_threads_.store(num_of_threads);
+    num_of_active_threads_ = num_of_threads;
+    recordLoadingPhase("Thread pool", start_time, start_memory);
+  }
+  // Out-of-core geometry
+  {
+    const auto directory = system_settings->outOfCoreDirectory();
+    // The geometry is placed in memory if the file can't be made
+    if (!directory.empty())
+      out_of_core_resource_.open(directory, system_settings->outOfCoreBudget());
+  }
+  // Mapped film
+  {
+    const auto directory = system_settings->mappedFilmDirectory();
+    // The film is placed in memory if the file can't be made
+    if (!directory.empty())
+      film_resource_.open(directory, system_settings->mappedFilmBudget());
   }
   // Image resolution
   {
-    image_resolution_[0] = system_settings->imageWidthResolution();
-    image_resolution_[1] = system_settings->imageHeightResolution();
+    full_image_resolution_[0] = system_settings->imageWidthResolution();
+    full_image_resolution_[1] = system_settings->imageHeightResolution();
+    image_resolution_ = full_image_resolution_;
+    crop_offset_ = Index2d{0, 0};
+    // Only the crop window is traced and stored
+    const auto& crop = system_settings->cropWindow();
+    if ((0 < crop[2]) && (0 < crop[3])) {
+      for (uint i = 0; i < 2; ++i) {
+        crop_offset_[i] = zisc::min(crop[i], full_image_resolution_[i] - 1);
+        image_resolution_[i] = zisc::min(crop[i + 2],
+                                         full_image_resolution_[i] - crop_offset_[i]);
+      }
+    }
   }
   // Sampler
   {
+    const auto start_time = stopwatch_.elapsedTime();
+    const auto start_memory = residentMemorySize();
     sampler_type_ = system_settings->samplerType();
     sampler_seed_ = system_settings->samplerSeed();
-    const uint32 num_of_pixels = imageWidthResolution() * imageHeightResolution();
-    sampler_list_.reserve(num_of_pixels + 1);
-    for (uint32 index = 0; index <= num_of_pixels; ++index) {
-      const uint32 seed = samplerSeed() + zisc::Fnv1aHash32::hash(index);
-      sampler_list_.emplace_back(Sampler::make(samplerType(), seed, &data_resource));
+    samples_per_cycle_ = system_settings->samplesPerCycle();
+    // The samplers are counter based, so each thread has a sampler
+    // and a pixel selects its stream of the sampler
+    // The CMJ table is shared by the samplers
+    auto& sampler_resource = trackedMemoryResource(MemoryCategory::kSampler);
+    if (samplerType() == SamplerType::kTableCmj) {
+      cmj_table_ = zisc::UniqueMemoryPointer<CmjTable>::make(&sampler_resource,
+                                                             samplerSeed(),
+                                                             &sampler_resource);
+    }
+    const uint num_of_threads = threadManager().numOfThreads();
+    sampler_list_.reserve(num_of_threads + 1);
+    for (uint index = 0; index <= num_of_threads; ++index) {
+      sampler_list_.emplace_back(Sampler::make(samplerType(),
+                                               samplerSeed(),
+                                               &sampler_resource,
+                                               cmj_table_.get()));
     }
+    // The global sampler has the stream after the last pixel
+    const uint32 num_of_pixels = imageWidthResolution() * imageHeightResolution();
+    globalSampler().setStream(num_of_pixels);
+    recordLoadingPhase("Sampler allocation", start_time, start_memory);
   }
   // Rendering color mode
   {
@@ -115,10 +410,49 @@ void System::initialize(const SettingNodeBase* settings) noexcept
     const auto pos = zisc::cast<std::size_t>(SampleStatistics::Type::kExpectedValue);
     statistics_flag_.set(pos, true);
   }
+  // Pixel cost
+  if constexpr (CoreConfig::pixelCostHeatmapIsEnabled()) {
+    const auto pos = zisc::cast<std::size_t>(SampleStatistics::Type::kPixelCost);
+    statistics_flag_.set(pos, true);
+  }
+  // Adaptive sampling
+  {
+    const bool is_enabled = system_settings->isAdaptiveSamplingEnabled();
+    is_adaptive_sampling_enabled_ = is_enabled ? kTrue : kFalse;
+    adaptive_sampling_threshold_ =
+        zisc::cast<Float>(system_settings->adaptiveSamplingThreshold());
+    if (is_enabled) {
+      using Type = SampleStatistics::Type;
+      statistics_flag_.set(zisc::cast<std::size_t>(Type::kVariance), true);
+      statistics_flag_.set(zisc::cast<std::size_t>(Type::kSampleCount), true);
+    }
+  }
   // Denoiser
   {
+    const auto start_time = stopwatch_.elapsedTime();
+    const auto start_memory = residentMemorySize();
     if (system_settings->isDenoisingEnabled())
       denoiser_ = Denoiser::makeDenoiser(*this, system_settings);
+    recordLoadingPhase("Denoiser", start_time, start_memory);
+  }
+  // XYZ film
+  {
+    // The variance and the denoiser need the spectral values of the pixels
+    using Type = SampleStatistics::Type;
+    const bool is_enabled = system_settings->isXyzFilmEnabled() &&
+        isSpectraMode() &&
+        !statistics_flag_[zisc::cast<std::size_t>(Type::kVariance)] &&
+        !statistics_flag_[zisc::cast<std::size_t>(Type::kBayesianCollaborativeValues)];
+    is_xyz_film_enabled_ = is_enabled ? kTrue : kFalse;
+  }
+  // Tile wavelength sampling
+  {
+    // The histograms of the BCD values are made of the wavelengths of a cycle
+    using Type = SampleStatistics::Type;
+    const bool is_enabled = system_settings->isTileWavelengthSamplingEnabled() &&
+        isSpectraMode() &&
+        !statistics_flag_[zisc::cast<std::size_t>(Type::kBayesianCollaborativeValues)];
+    is_tile_wavelength_sampling_enabled_ = is_enabled ? kTrue : kFalse;
   }
 
   // Check type properties
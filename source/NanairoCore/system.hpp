@@ -12,7 +12,10 @@
 
 // Standard C++ library
 #include <array>
+#include <atomic>
 #include <bitset>
+#include <cstddef>
+#include <mutex>
 #include <vector>
 // Zisc
 #include "zisc/memory_manager.hpp"
@@ -29,11 +32,23 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "Sampling/Sampler/sampler.hpp"
 #include "Setting/setting_node_base.hpp"
+#include "Utility/hardware_counter.hpp"
+#include "Utility/huge_page_memory_resource.hpp"
+#include "Utility/loading_phase.hpp"
+#include "Utility/out_of_core_memory_resource.hpp"
+#include "Utility/trace_recorder.hpp"
+#include "Utility/tracked_memory_resource.hpp"
+#include "Utility/work_memory_arena.hpp"
 
 namespace nanairo {
 
 // Forward declaration
+class CmjTable;
 class Denoiser;
+class LayeredDiffuseTable;
+class RgbSpectraTable;
+class TaskScheduler;
+class TextureTileCache;
 class ToneMappingOperator;
 class XyzColorMatchingFunction;
 
@@ -46,6 +61,18 @@ enum class RenderingColorMode : uint32
   kSpectra                    = zisc::Fnv1aHash32::hash("Spectra")
 };
 
+//! The categories of the data memory which are accounted separately
+enum class MemoryCategory : uint
+{
+  kBvh = 0,
+  kObject,
+  kTexture,
+  kFilm,
+  kPhotonMap,
+  kSampler,
+  kDenoiser
+};
+
 /*!
   \details
   No detailed.
@@ -69,6 +96,9 @@ class System : public zisc::NonCopyable<System>
 
 
   // System
+  //! Return the relative error threshold of adaptive sampling
+  Float adaptiveSamplingThreshold() const noexcept;
+
   //! Calculate the range of the task id
   template <typename Integer>
   static std::array<Integer, 2> calcTaskRange(const Integer range,
@@ -89,7 +119,36 @@ class System : public zisc::NonCopyable<System>
   //! Return the global sampler
   Sampler& globalSampler() noexcept;
 
-  //! Return the image resolution 
+  //! Return the memory manager for the image output which overlaps rendering
+  MemoryManager& imageMemoryManager() noexcept;
+
+  //! Return the offset of the crop window in the full image
+  const Index2d& cropOffset() const noexcept;
+
+  //! Open the hardware counters of the threads, return false if they can't be opened
+  bool enableHardwareCounters() noexcept;
+
+  //! Return the phases of the scene loading
+  const zisc::pmr::vector<LoadingPhase>& loadingPhaseList() const noexcept;
+
+  //! Record a phase of the scene loading which started at the time and memory
+  void recordLoadingPhase(const char* name,
+                          const zisc::Stopwatch::Clock::duration start_time,
+                          const std::size_t start_memory) noexcept;
+
+  //! Return the name of the memory category
+  static const char* memoryCategoryName(const MemoryCategory category) noexcept;
+
+  //! Return the number of the memory categories
+  static constexpr uint numOfMemoryCategories() noexcept;
+
+  //! Return the memory resource of the mapped film
+  OutOfCoreMemoryResource& filmMemoryResource() noexcept;
+
+  //! Return the resolution of the full image which the camera projects
+  const Index2d& fullImageResolution() const noexcept;
+
+  //! Return the image resolution, which is the size of the crop window
   const Index2d& imageResolution() const noexcept;
 
   //! Return the image height resolution
@@ -98,8 +157,44 @@ class System : public zisc::NonCopyable<System>
   //! Return the image width resolution
   uint imageWidthResolution() const noexcept;
 
-  //! Return a sampler
-  Sampler& localSampler(const uint index) noexcept;
+  //! Check if adaptive sampling is enabled
+  bool isAdaptiveSamplingEnabled() const noexcept;
+
+  //! Check if the hardware counters of the threads are opened
+  bool isHardwareCounterEnabled() const noexcept;
+
+  //! Check if the film is placed in the mapped file
+  bool isMappedFilmEnabled() const noexcept;
+
+  //! Check if the large geometry is placed in the out-of-core memory
+  bool isOutOfCoreEnabled() const noexcept;
+
+  //! Return the reflectance table of layered diffuse, which is made at the first call
+  const LayeredDiffuseTable& layeredDiffuseTable() noexcept;
+
+  //! Return the sampler of the thread which is set to the stream of the index
+  Sampler& localSampler(const uint thread_id, const uint index) noexcept;
+
+  //! Return the number of the threads which trace the dynamic passes of a cycle
+  uint numOfActiveThreads() const noexcept;
+
+  //! Return the memory resource of the out-of-core geometry
+  OutOfCoreMemoryResource& outOfCoreMemoryResource() noexcept;
+
+  //! Read the sum of the hardware counts of the threads
+  HardwareCounts readHardwareCounters() const noexcept;
+
+  //! Request the number of the active threads, which is applied at the next cycle
+  void requestNumOfActiveThreads(const uint num_of_threads) noexcept;
+
+  //! Return the requested number of the active threads
+  uint requestedNumOfActiveThreads() const noexcept;
+
+  //! Return the fork-join task scheduler for recursive tasks
+  TaskScheduler& taskScheduler() noexcept;
+
+  //! Return the tile cache of the tiled image textures, which is made at the first call
+  TextureTileCache& textureTileCache() noexcept;
 
   //! Return the thread manager
   zisc::ThreadManager& threadManager() noexcept;
@@ -107,8 +202,24 @@ class System : public zisc::NonCopyable<System>
   //! Return the thread manager
   const zisc::ThreadManager& threadManager() const noexcept;
 
-  //! Return the thread's memory manager
-  MemoryManager& threadMemoryManager(const uint thread_number) noexcept;
+  //! Return the thread's work memory arena
+  WorkMemoryArena& threadMemoryManager(const uint thread_number) noexcept;
+
+  //! Return the recorder of the timeline of the rendering
+  TraceRecorder& traceRecorder() noexcept;
+
+  //! Return the recorder of the timeline of the rendering
+  const TraceRecorder& traceRecorder() const noexcept;
+
+  //! Return the memory resource which accounts the allocations of the category
+  TrackedMemoryResource& trackedMemoryResource(const MemoryCategory category) noexcept;
+
+  //! Return the memory resource which accounts the allocations of the category
+  const TrackedMemoryResource& trackedMemoryResource(
+      const MemoryCategory category) const noexcept;
+
+  //! Apply the requested number of the active threads at a cycle boundary
+  bool updateActiveThreads() noexcept;
 
   // Color system
   //! Return the color mode
@@ -135,12 +246,25 @@ class System : public zisc::NonCopyable<System>
   //! Check if the renderer is spectra rendering mode
   bool isSpectraMode() const noexcept;
 
+  //! Check if the rendering methods may sample the wavelengths per tile
+  bool isTileWavelengthSamplingEnabled() const noexcept;
+
+  //! Check if the film accumulates XYZ values instead of spectra
+  bool isXyzFilmEnabled() const noexcept;
+
+  //! Return the RGB to spectra table, which is made at the first call
+  const RgbSpectraTable& rgbSpectraTable(
+      zisc::pmr::memory_resource* work_resource) noexcept;
+
   //! Return the sampler seed
   uint32 samplerSeed() const noexcept;
 
   //! Return the sampler type
   SamplerType samplerType() const noexcept;
 
+  //! Return the number of samples per pixel which are traced in a cycle
+  uint32 samplesPerCycle() const noexcept;
+
   //! Return the flag of sample statistics
   SampleStatisticsFlag& sampleStatisticsFlag() noexcept;
 
@@ -160,24 +284,56 @@ class System : public zisc::NonCopyable<System>
   const XyzColorMatchingFunction& xyzColorMatchingFunction() const noexcept;
 
  private:
+  //! Bind the threads to the cpus and touch the thread memory pools
+  void bindThreads(const bool thread_affinity_enabled,
+                   const bool memory_first_touch_enabled,
+                   const bool background_priority_enabled) noexcept;
+
   //! Initialize the renderer system
   void initialize(const SettingNodeBase* settings) noexcept;
 
 
   std::vector<MemoryManager> memory_manager_list_;
+  HugePageMemoryResource data_huge_page_resource_;
+  HugePageMemoryResource global_huge_page_resource_;
+  OutOfCoreMemoryResource out_of_core_resource_;
+  OutOfCoreMemoryResource film_resource_;
+  std::vector<WorkMemoryArena> thread_memory_list_;
+  std::vector<HardwareCounter> hardware_counter_list_;
+  std::array<TrackedMemoryResource, 7> tracked_resource_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<Sampler>> sampler_list_;
+  zisc::pmr::vector<LoadingPhase> loading_phase_list_;
+  std::mutex loading_phase_mutex_; //!< The phases are recorded by the tasks
+  zisc::UniqueMemoryPointer<CmjTable> cmj_table_;
   zisc::UniqueMemoryPointer<zisc::ThreadManager> thread_manager_;
+  zisc::UniqueMemoryPointer<TaskScheduler> task_scheduler_;
   zisc::UniqueMemoryPointer<XyzColorMatchingFunction> xyz_color_matching_function_;
   zisc::UniqueMemoryPointer<ToneMappingOperator> tone_mapping_operator_;
   zisc::UniqueMemoryPointer<Denoiser> denoiser_;
+  zisc::UniqueMemoryPointer<RgbSpectraTable> rgb_spectra_table_;
+  zisc::UniqueMemoryPointer<LayeredDiffuseTable> layered_diffuse_table_;
+  zisc::UniqueMemoryPointer<TextureTileCache> texture_tile_cache_;
+  std::once_flag rgb_spectra_table_flag_;
+  std::once_flag layered_diffuse_table_flag_;
+  std::once_flag texture_tile_cache_flag_;
   zisc::Stopwatch stopwatch_;
+  TraceRecorder trace_recorder_;
+  std::atomic<uint> requested_num_of_active_threads_;
+  uint num_of_active_threads_;
   Float gamma_;
+  Float adaptive_sampling_threshold_;
   Index2d image_resolution_;
+  Index2d full_image_resolution_;
+  Index2d crop_offset_;
   SamplerType sampler_type_;
   uint32 sampler_seed_;
+  uint32 samples_per_cycle_;
   RenderingColorMode color_mode_;
   ColorSpaceType color_space_;
   SampleStatisticsFlag statistics_flag_;
+  uint8 is_adaptive_sampling_enabled_;
+  uint8 is_xyz_film_enabled_;
+  uint8 is_tile_wavelength_sampling_enabled_;
 };
 
 //! \} Core
@@ -47,6 +47,17 @@ const zisc::pmr::vector<const EmitterModel*>& World::emitterList() const noexcep
   return emitter_list_;
 }
 
+/*!
+  \details
+  The first environment emitter of the emitter models is
+  the environment of the world.
+  */
+inline
+const EnvironmentEmitter* World::environmentLight() const noexcept
+{
+  return environment_light_;
+}
+
 /*!
   \details
   No detailed.
@@ -65,6 +76,16 @@ const zisc::pmr::vector<const Material*>& World::materialList() const noexcept
   return material_list_;
 }
 
+/*!
+  \details
+  The models are indexed in the depth first order of the object tree.
+  */
+inline
+uint World::numOfObjectModels() const noexcept
+{
+  return zisc::cast<uint>(model_objects_list_.size());
+}
+
 /*!
   */
 inline
@@ -73,6 +94,25 @@ const zisc::pmr::vector<Object>& World::objectList() const noexcept
   return bvh().objectList();
 }
 
+/*!
+  */
+inline
+const Bvh* World::proxyBvh() const noexcept
+{
+  return proxy_bvh_.get();
+}
+
+/*!
+  \details
+  A few hundred cells keep the silhouettes at the resolution of the preview,
+  which is lower than the image resolution.
+  */
+inline
+constexpr uint World::proxyGridResolution() noexcept
+{
+  return 256;
+}
+
 /*!
   */
 inline
@@ -10,37 +10,59 @@
 #include "world.hpp"
 // Standard C++ library
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstddef>
 #include <future>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 // Zisc
 #include "zisc/algorithm.hpp"
 #include "zisc/compensated_summation.hpp"
 #include "zisc/error.hpp"
+#include "zisc/fnv_1a_hash_engine.hpp"
+#include "zisc/memory_resource.hpp"
 #include "zisc/thread_manager.hpp"
 #include "zisc/utility.hpp"
 #include "zisc/unit.hpp"
 // Nanairo
 #include "system.hpp"
+#include "Data/light_emission_distribution.hpp"
+#include "Data/light_source_bound.hpp"
 #include "Data/object.hpp"
+#include "DataStructure/aabb.hpp"
 #include "DataStructure/bvh.hpp"
 #include "Geometry/transformation.hpp"
 #include "Material/material.hpp"
 #include "Material/EmitterModel/emitter_model.hpp"
+#include "Material/EmitterModel/environment_emitter.hpp"
 #include "Material/SurfaceModel/surface_model.hpp"
 #include "Material/TextureModel/texture_model.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "Setting/bvh_setting_node.hpp"
 #include "Setting/group_object_setting_node.hpp"
 #include "Setting/material_setting_node.hpp"
 #include "Setting/object_model_setting_node.hpp"
 #include "Setting/scene_setting_node.hpp"
 #include "Setting/setting_node_base.hpp"
 #include "Setting/single_object_setting_node.hpp"
+#include "Setting/texture_setting_node.hpp"
+#include "Shape/flat_triangle.hpp"
+#include "Shape/instance_shape.hpp"
+#include "Shape/plane.hpp"
+#include "Shape/shape.hpp"
+#include "Utility/loading_phase.hpp"
+#include "Utility/out_of_core_memory_resource.hpp"
+#include "Utility/task_scheduler.hpp"
+#include "Utility/work_memory_arena.hpp"
 
 
 namespace nanairo {
@@ -50,15 +72,20 @@ namespace nanairo {
   No detailed.
   */
 World::World(System& system, const SettingNodeBase* settings) noexcept :
-    emitter_list_{&system.dataMemoryManager()},
-    surface_list_{&system.dataMemoryManager()},
-    texture_list_{&system.dataMemoryManager()},
-    material_list_{&system.dataMemoryManager()},
-    light_source_list_{&system.dataMemoryManager()},
-    emitter_body_list_{&system.dataMemoryManager()},
-    surface_body_list_{&system.dataMemoryManager()},
-    texture_body_list_{&system.dataMemoryManager()},
-    material_body_list_{&system.dataMemoryManager()}
+    object_arena_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    emitter_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    surface_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    texture_list_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    material_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    light_source_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    light_source_bound_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    light_emission_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    model_objects_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    emitter_body_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    surface_body_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    texture_body_list_{&system.trackedMemoryResource(MemoryCategory::kTexture)},
+    material_body_list_{&system.trackedMemoryResource(MemoryCategory::kObject)},
+    instance_bvh_list_{&system.trackedMemoryResource(MemoryCategory::kBvh)}
 {
   initialize(system, settings);
 }
@@ -73,46 +100,237 @@ World::~World() noexcept
 
 /*!
   \details
-  No detailed.
+  The topology of the BVH is kept and only the bounding boxes are refitted,
+  so a large movement degrades the BVH quality.
+  The light sources of the world keep the objects and their bounds are
+  updated, but the light samplers have to be remade
+  if the model is a light source.
+  The proxy objects of the model are transformed as well.
+
+  \return True if the model is a light source
   */
-void World::initialize(System& system, const SettingNodeBase* settings) noexcept
+bool World::transformObject(System& system,
+                            const uint index,
+                            const Matrix4x4& matrix) noexcept
+{
+  ZISC_ASSERT(index < numOfObjectModels(), "The model index is out of range.");
+  const auto& model_objects = model_objects_list_[index];
+  if (model_objects.instance_ != nullptr) {
+    model_objects.instance_->transform(matrix);
+    if (model_objects.proxy_instance_ != nullptr)
+      model_objects.proxy_instance_->transform(matrix);
+  }
+  else {
+    auto transform_model =
+    [&system, &model_objects, &matrix](zisc::pmr::vector<Object>& object_list)
+    {
+      const uint num_of_objects = zisc::cast<uint>(object_list.size());
+      auto transform_objects =
+      [&system, &object_list, &model_objects, &matrix, num_of_objects]
+      (const uint task_id)
+      {
+        const auto range = system.calcTaskRange(num_of_objects, task_id);
+        for (auto i = range[0]; i < range[1]; ++i) {
+          auto& object = object_list[i];
+          if (&object.material() == model_objects.material_)
+            object.shape().transform(matrix);
+        }
+      };
+
+      auto& threads = system.threadManager();
+      constexpr uint start = 0;
+      const uint end = threads.numOfThreads();
+      auto result = threads.enqueueLoop(transform_objects, start, end,
+                                        &system.globalMemoryManager());
+      result.wait();
+    };
+    transform_model(bvh_->objectList());
+    if (proxy_bvh_)
+      transform_model(proxy_bvh_->objectList());
+  }
+  bvh_->refit(system);
+  if (proxy_bvh_)
+    proxy_bvh_->refit(system);
+  const bool is_light_source = model_objects.material_->isLightSource();
+  if (is_light_source)
+    updateLightSourceBounds();
+  return is_light_source;
+}
+
+/*!
+  \details
+  The number of the surfaces of the settings has to be same as the world.
+  */
+void World::updateSurface(System& system,
+                          const SettingNodeBase* settings,
+                          const uint index) noexcept
 {
   const auto scene_settings = castNode<SceneSettingNode>(settings);
+  const auto surface_model_settings = castNode<SurfaceModelSettingNode>(
+      scene_settings->surfaceModelSettingNode());
+  ZISC_ASSERT(surface_model_settings->numOfMaterials() == surface_list_.size(),
+              "The number of the surfaces is changed.");
+  ZISC_ASSERT(index < surface_list_.size(), "The surface index is out of range.");
 
   auto work_resource = static_cast<System::MemoryManager*>(settings->workResource());
   std::mutex work_mutex;
   work_resource->setMutex(&work_mutex);
-  work_resource->reset();
 
-  // Initialize texture
   {
-    initializeTexture(system, scene_settings->textureModelSettingNode());
-    work_resource->reset();
+    zisc::pmr::vector<const SurfaceModel*> old_surface_list{surface_list_,
+                                                            work_resource};
+    zisc::pmr::vector<const EmitterModel*> old_emitter_list{emitter_list_,
+                                                            work_resource};
+    const auto surface_settings = surface_model_settings->materialList()[index];
+    auto surface = SurfaceModel::makeSurface(system, surface_settings, textureList());
+    surface->setIndex(index);
+    surface_list_[index] = surface.get();
+    updateMaterials(old_surface_list, old_emitter_list);
+    initializeLightEmissions();
+    // The old surface is freed after no material refers to it
+    surface_body_list_[index] = std::move(surface);
   }
 
-  // Initialize surface scattering
-  {
-    initializeSurface(system, scene_settings->surfaceModelSettingNode());
-    work_resource->reset();
-  }
+  work_resource->reset();
+  work_resource->setMutex(nullptr);
+}
+
+/*!
+  \details
+  The surfaces and the emitters can refer to any texture,
+  so all of them are remade. They are much cheaper than the textures,
+  the objects and the BVH which are kept.
+  The number of the models of the settings has to be same as the world.
+  */
+void World::updateTexture(System& system,
+                          const SettingNodeBase* settings,
+                          const uint index) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(settings);
+  const auto texture_model_settings = castNode<TextureModelSettingNode>(
+      scene_settings->textureModelSettingNode());
+  ZISC_ASSERT(texture_model_settings->numOfMaterials() == texture_list_.size(),
+              "The number of the textures is changed.");
+  ZISC_ASSERT(index < texture_list_.size(), "The texture index is out of range.");
+
+  auto work_resource = static_cast<System::MemoryManager*>(settings->workResource());
+  std::mutex work_mutex;
+  work_resource->setMutex(&work_mutex);
 
-  // Initialize emitter
   {
+    const auto texture_settings = texture_model_settings->materialList()[index];
+    auto texture = TextureModel::makeTexture(system, texture_settings);
+    texture_list_[index] = texture.get();
+
+    zisc::pmr::vector<const SurfaceModel*> old_surface_list{surface_list_,
+                                                            work_resource};
+    zisc::pmr::vector<const EmitterModel*> old_emitter_list{emitter_list_,
+                                                            work_resource};
+    // Keep the old models until the materials refer to the new models
+    decltype(surface_body_list_) old_surface_body_list{
+        surface_body_list_.get_allocator()};
+    decltype(emitter_body_list_) old_emitter_body_list{
+        emitter_body_list_.get_allocator()};
+    old_surface_body_list.swap(surface_body_list_);
+    old_emitter_body_list.swap(emitter_body_list_);
+    initializeSurface(system, scene_settings->surfaceModelSettingNode());
     initializeEmitter(system, scene_settings->emitterModelSettingNode());
-    work_resource->reset();
+    updateMaterials(old_surface_list, old_emitter_list);
+    old_surface_body_list.clear();
+    old_emitter_body_list.clear();
+    // The duplicates which share the old texture take over it
+    const TextureModel* old_texture = texture_body_list_[index].get();
+    for (uint i = 0; (old_texture != nullptr) && (i < texture_list_.size()); ++i) {
+      if (texture_list_[i] == old_texture) {
+        texture_body_list_[i] = std::move(texture_body_list_[index]);
+        old_texture = nullptr;
+      }
+    }
+    texture_body_list_[index] = std::move(texture);
   }
 
+  work_resource->reset();
+  work_resource->setMutex(nullptr);
+}
+
+/*!
+  \details
+  The loading is a task graph. The shapes don't refer to the models of
+  the materials, so the geometry is made while the textures and then
+  the surfaces and the emitters are made. The objects join them,
+  then the BVH is built. The chain of the models runs on its own thread,
+  since it waits for the thread manager and a thread manager thread which
+  waits for a task group of the task scheduler could run it.
+  The work memory is reset after the join since the tasks share it.
+  */
+void World::initialize(System& system, const SettingNodeBase* settings) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(settings);
+
+  auto work_resource = static_cast<System::MemoryManager*>(settings->workResource());
+  std::mutex work_mutex;
+  work_resource->setMutex(&work_mutex);
+  work_resource->reset();
+
   {
+    const auto object_settings = scene_settings->objectSettingNode();
+    auto bvh_settings = scene_settings->bvhSettingNode();
+    ObjectModelSet model_set{object_settings->workResource()};
+    {
+      // Initialize the models of the materials
+      auto model_task = std::async(std::launch::async,
+      [this, &system, scene_settings]()
+      {
+        initializeModels(system, scene_settings);
+      });
+      // Make the geometry
+      const auto start_time = system.stopwatch().elapsedTime();
+      const auto start_memory = residentMemorySize();
+      makeGeometry(system, object_settings, bvh_settings, &model_set);
+      system.recordLoadingPhase("Geometry creation", start_time, start_memory);
+      model_task.wait();
+    }
+
     // Initialize objects
-    auto object_list = initializeObject(system, scene_settings->objectSettingNode());
-    work_resource->reset();
+    auto start_time = system.stopwatch().elapsedTime();
+    auto start_memory = residentMemorySize();
+    auto object_list = initializeObject(system,
+                                        object_settings,
+                                        bvh_settings,
+                                        &model_set);
+    system.recordLoadingPhase("Object creation", start_time, start_memory);
+
+    // Make the proxy geometry of the preview
+    zisc::pmr::vector<Object> proxy_object_list{work_resource};
+    if (castNode<BvhSettingNode>(bvh_settings)->isProxyGeometryEnabled()) {
+      start_time = system.stopwatch().elapsedTime();
+      start_memory = residentMemorySize();
+      proxy_object_list = makeProxyObjects(system, object_list, work_resource);
+      system.recordLoadingPhase("Proxy geometry creation", start_time, start_memory);
+    }
 
     // Initialize a BVH
-    auto bvh_settings = scene_settings->bvhSettingNode();
-    bvh_ = Bvh::makeBvh(system, bvh_settings);
-    bvh_->construct(system, bvh_settings, std::move(object_list));
-    work_resource->reset();
+    start_time = system.stopwatch().elapsedTime();
+    start_memory = residentMemorySize();
+    {
+      // The proxy BVH is built in the background of the BVH
+      std::future<void> proxy_task;
+      if (!proxy_object_list.empty()) {
+        proxy_task = std::async(std::launch::async,
+        [this, &system, bvh_settings, &proxy_object_list]()
+        {
+          proxy_bvh_ = Bvh::makeBvh(system, bvh_settings);
+          proxy_bvh_->construct(system, bvh_settings, std::move(proxy_object_list));
+        });
+      }
+      bvh_ = Bvh::makeBvh(system, bvh_settings);
+      bvh_->construct(system, bvh_settings, std::move(object_list));
+      if (proxy_task.valid())
+        proxy_task.wait();
+    }
+    system.recordLoadingPhase("BVH build", start_time, start_memory);
   }
+  work_resource->reset();
 
   {
     initializeWorldLightSource();
@@ -156,47 +374,100 @@ void World::initializeEmitter(System& system,
     result.wait();
   }
   ZISC_ASSERT(0 < emitter_list_.size(), "The scene has no emitter.");
+
+  environment_light_ = nullptr;
+  for (const auto emitter : emitter_list_) {
+    if (emitter->type() == EmitterType::kEnvironment) {
+      environment_light_ = zisc::cast<const EnvironmentEmitter*>(emitter);
+      break;
+    }
+  }
 }
 
 /*!
   \details
-  No detailed.
+  The arenas are kept while the world lives and are never rewound,
+  the objects which are made later are appended to them.
+  The blocks of the out-of-core arenas are the clusters of the file,
+  so the shapes of a thread are paged in and out together.
   */
-zisc::pmr::vector<Object> World::initializeObject(
-    System& system,
-    const SettingNodeBase* settings) noexcept
+void World::initObjectArenas(System& system, const uint num_of_arenas) noexcept
 {
-  auto results = makeObjects(system, settings);
-
-  // Initialize materials
-  {
-    const std::size_t num_of_materials = results.size();
-    material_list_.reserve(num_of_materials);
-    material_body_list_.reserve(num_of_materials);
-    for (auto& result : results) {
-      auto& material = std::get<1>(result);
-      material_body_list_.emplace_back(std::move(material));
-      material_list_.emplace_back(material_body_list_.back().get());
+  auto data_resource = &system.trackedMemoryResource(MemoryCategory::kObject);
+  object_arena_list_.reserve(num_of_arenas);
+  while (object_arena_list_.size() < num_of_arenas) {
+    if (system.isOutOfCoreEnabled()) {
+      object_arena_list_.emplace_back(
+          zisc::UniqueMemoryPointer<WorkMemoryArena>::make(
+              data_resource,
+              &system.outOfCoreMemoryResource(),
+              OutOfCoreMemoryResource::clusterSize()));
+    }
+    else {
+      object_arena_list_.emplace_back(
+          zisc::UniqueMemoryPointer<WorkMemoryArena>::make(data_resource,
+                                                           data_resource));
     }
   }
+}
+
+/*!
+  \details
+  The surfaces and the emitters only refer to the textures,
+  so they are made together after the textures.
+  */
+void World::initializeModels(System& system, const SettingNodeBase* settings) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(settings);
 
-  // Initialize objects
-  std::size_t num_of_objects = 0;
-  for (const auto& result : results) {
-    const auto& objects = std::get<0>(result);
-    num_of_objects += objects.size();
+  // Initialize texture
+  {
+    const auto start_time = system.stopwatch().elapsedTime();
+    const auto start_memory = residentMemorySize();
+    initializeTexture(system, scene_settings->textureModelSettingNode());
+    system.recordLoadingPhase("Texture init", start_time, start_memory);
   }
-  ZISC_ASSERT(0 < num_of_objects, "The scene has no object.");
 
-  // Merge all lists into a list
-  auto data_resource = settings->dataResource();
-  zisc::pmr::vector<Object> object_list{data_resource};
-  object_list.reserve(num_of_objects);
-  for (auto& result : results) {
-    auto& objects = std::get<0>(result);
-    for (auto& object : objects)
-      object_list.emplace_back(std::move(object));
+  // Initialize surface scattering
+  auto surface_task = std::async(std::launch::async,
+  [this, &system, scene_settings]()
+  {
+    const auto start_time = system.stopwatch().elapsedTime();
+    const auto start_memory = residentMemorySize();
+    initializeSurface(system, scene_settings->surfaceModelSettingNode());
+    system.recordLoadingPhase("Surface init", start_time, start_memory);
+  });
+  // Initialize emitter
+  {
+    const auto start_time = system.stopwatch().elapsedTime();
+    const auto start_memory = residentMemorySize();
+    initializeEmitter(system, scene_settings->emitterModelSettingNode());
+    system.recordLoadingPhase("Emitter init", start_time, start_memory);
   }
+  surface_task.wait();
+}
+
+/*!
+  \details
+  The shapes of the model set are made, so the materials are made here.
+  */
+zisc::pmr::vector<Object> World::initializeObject(
+    System& system,
+    const SettingNodeBase* settings,
+    const SettingNodeBase* bvh_settings,
+    ObjectModelSet* model_set) noexcept
+{
+  ZISC_ASSERT(model_set != nullptr, "The model set is null.");
+  zisc::pmr::vector<Object> object_list{settings->dataResource()};
+  makeSingleObjects(system, model_set, &object_list);
+  if (0 < model_set->candidate_list_.size())
+    makeInstances(system, bvh_settings, *model_set, &object_list);
+  ZISC_ASSERT(0 < object_list.size(), "The scene has no object.");
+
+  // Initialize materials
+  material_list_.reserve(material_body_list_.size());
+  for (const auto& material : material_body_list_)
+    material_list_.emplace_back(material.get());
   return object_list;
 }
 
@@ -222,6 +493,7 @@ void World::initializeSurface(System& system,
     surface_body_list_[index] = SurfaceModel::makeSurface(system,
                                                           surface_settings,
                                                           texture_list);
+    surface_body_list_[index]->setIndex(index);
     surface_list_[index] = surface_body_list_[index].get();
   };
 
@@ -239,12 +511,13 @@ void World::initializeSurface(System& system,
 
 /*!
   \details
-  No detailed.
+  Each texture is a task of the fork-join scheduler,
+  so a large image texture can split its own tables into subtasks and
+  the threads which finish the small textures steal them.
   */
 void World::initializeTexture(System& system,
                               const SettingNodeBase* settings) noexcept
 {
-  auto work_resource = static_cast<System::MemoryManager*>(settings->workResource());
   const auto texture_model_settings = castNode<TextureModelSettingNode>(settings);
 
   const auto num_of_textures = texture_model_settings->numOfMaterials();
@@ -252,6 +525,36 @@ void World::initializeTexture(System& system,
   texture_body_list_.resize(num_of_textures);
 
   const auto& texture_setting_list = texture_model_settings->materialList();
+  // Find the textures of the same content
+  auto work_resource = settings->workResource();
+  zisc::pmr::vector<uint> source_list{work_resource};
+  source_list.resize(num_of_textures);
+  {
+    zisc::pmr::vector<std::string> content_list{work_resource};
+    content_list.reserve(num_of_textures);
+    std::unordered_multimap<uint64, uint> content_map;
+    content_map.reserve(num_of_textures);
+    for (uint index = 0; index < num_of_textures; ++index) {
+      const auto texture_settings = castNode<TextureSettingNode>(
+          texture_setting_list[index]);
+      std::ostringstream content;
+      texture_settings->writeParameters(&content);
+      content_list.emplace_back(content.str());
+      const auto& data = content_list.back();
+      const uint64 key = zisc::Fnv1aHash64::hash(std::string_view{data});
+      source_list[index] = index;
+      const auto range = content_map.equal_range(key);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (content_list[it->second] == data) {
+          source_list[index] = it->second;
+          break;
+        }
+      }
+      if (source_list[index] == index)
+        content_map.emplace(key, index);
+    }
+  }
+
   auto make_texture =
   [this, &system, &texture_setting_list](const uint index)
   {
@@ -261,20 +564,23 @@ void World::initializeTexture(System& system,
   };
 
   {
-    auto& threads = system.threadManager();
-    constexpr uint start = 0;
-    auto result = threads.enqueueLoop(make_texture,
-                                      start,
-                                      num_of_textures,
-                                      work_resource);
-    result.wait();
+    TaskGroup group{system.taskScheduler()};
+    for (uint index = 0; index < num_of_textures; ++index) {
+      if (source_list[index] == index)
+        group.run([&make_texture, index]() {make_texture(index);});
+    }
+    group.wait();
   }
+  // The duplicates share the immutable texture of the first one
+  for (uint index = 0; index < num_of_textures; ++index)
+    texture_list_[index] = texture_list_[source_list[index]];
   ZISC_ASSERT(0 < texture_list_.size(), "The scene has no texture");
 }
 
 /*!
   \details
-  No detailed.
+  The light sources are sorted by the address and
+  each light source refers to its bound in the bound list.
   */
 void World::initializeWorldLightSource() noexcept
 {
@@ -290,127 +596,592 @@ void World::initializeWorldLightSource() noexcept
       light_source_list_.emplace_back(&object);
   }
   std::sort(light_source_list_.begin(), light_source_list_.end());
+
+  light_source_bound_list_.clear();
+  light_source_bound_list_.reserve(num_of_lights);
+  for (auto& object : bvh_->objectList()) {
+    if (object.isLightSource())
+      light_source_bound_list_.emplace_back(object.shape());
+  }
+  // The object list and the bound list are in the same order
+  auto bound = light_source_bound_list_.data();
+  for (auto& object : bvh_->objectList()) {
+    if (object.isLightSource()) {
+      object.setLightSourceBound(bound);
+      ++bound;
+    }
+  }
+  initializeLightEmissions();
 }
 
 /*!
   \details
-  No detailed.
+  Only the image textures vary enough to be worth the distributions,
+  and the distribution needs the st domain of a plane or a triangle.
+  The light sources of the other emitters are sampled uniformly.
   */
-auto World::makeObjects(System& system,
-                        const SettingNodeBase* settings) const noexcept
-    -> zisc::pmr::vector<ObjectSet>
+void World::initializeLightEmissions() noexcept
 {
-  auto work_resource = settings->workResource();
-  zisc::pmr::list<std::future<ObjectSet>> results{work_resource};
+  auto is_textured = [](const Object& object)
+  {
+    const auto texture = object.material().emitter().colorTexture();
+    const auto shape_type = object.shape().type();
+    return object.isLightSource() &&
+           (texture != nullptr) && (texture->type() == TextureType::kImage) &&
+           ((shape_type == ShapeType::kPlane) || (shape_type == ShapeType::kMesh));
+  };
+
+  std::size_t num_of_emissions = 0;
+  for (const auto& object : bvh_->objectList()) {
+    if (is_textured(object))
+      ++num_of_emissions;
+  }
+  auto mem_resource = light_emission_list_.get_allocator().resource();
+  light_emission_list_.clear();
+  light_emission_list_.reserve(num_of_emissions);
+  for (auto& object : bvh_->objectList()) {
+    if (is_textured(object)) {
+      light_emission_list_.emplace_back(mem_resource);
+      auto& distribution = light_emission_list_.back();
+      distribution.set(object.shape(), *object.material().emitter().colorTexture());
+      object.setEmissionDistribution(&distribution);
+    }
+    else {
+      object.setEmissionDistribution(nullptr);
+    }
+  }
+}
+
+/*!
+  */
+void World::updateLightSourceBounds() noexcept
+{
+  auto bound = light_source_bound_list_.data();
+  for (const auto& object : objectList()) {
+    if (object.isLightSource()) {
+      bound->set(object.shape());
+      ++bound;
+    }
+  }
+}
+
+/*!
+  \details
+  The candidates which have the same geometry and surface share
+  a bottom-level BVH built in the local coordinate of the object.
+  A candidate which has no duplicate is flattened as usual.
+  */
+void World::makeInstances(
+    System& system,
+    const SettingNodeBase* bvh_settings,
+    const ObjectModelSet& model_set,
+    zisc::pmr::vector<Object>* object_list) noexcept
+{
+  ZISC_ASSERT(object_list != nullptr, "The object list is null.");
+  auto work_resource = bvh_settings->workResource();
+  const auto& candidate_list = model_set.candidate_list_;
+  const auto& prototype_list = model_set.prototype_list_;
+  const auto& group_list = model_set.group_list_;
+  const auto& group_size_list = model_set.group_size_list_;
+
+  // Make instances of the duplicated objects
+  auto data_resource = &system.trackedMemoryResource(MemoryCategory::kObject);
+  for (uint g = 0; g < prototype_list.size(); ++g) {
+    if (group_size_list[g] == 1)
+      continue;
+    const auto& prototype = candidate_list[prototype_list[g]];
+    const auto model_settings = castNode<ObjectModelSettingNode>(
+        std::get<0>(prototype));
+    const auto object_settings =
+        castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
+    // Make the material
+    const auto surface_index = object_settings->surfaceIndex();
+    auto material = zisc::UniqueMemoryPointer<Material>::make(
+        data_resource,
+        surface_list_[surface_index],
+        nullptr);
+    // Make the bottom-level BVH in the local coordinate
+    Float local_surface_area = 0.0;
+    {
+      auto shape_list = Shape::makeShape(system, object_settings,
+                                         data_resource, work_resource);
+      zisc::pmr::vector<Object> prototype_object_list{work_resource};
+      prototype_object_list.reserve(shape_list.size());
+      for (auto& shape : shape_list) {
+        local_surface_area += shape->surfaceArea();
+        prototype_object_list.emplace_back(std::move(shape), material.get());
+        prototype_object_list.back().setName(model_settings->name());
+      }
+      auto bvh = Bvh::makeBvh(system, bvh_settings);
+      bvh->construct(system, bvh_settings, std::move(prototype_object_list));
+      instance_bvh_list_.emplace_back(std::move(bvh));
+    }
+    // Make the instances
+    const Bvh* bvh = instance_bvh_list_.back().get();
+    object_list->reserve(object_list->size() + group_size_list[g]);
+    for (uint i = 0; i < candidate_list.size(); ++i) {
+      if (group_list[i] != g)
+        continue;
+      const auto& candidate = candidate_list[i];
+      auto shape = zisc::UniqueMemoryPointer<InstanceShape>::make(
+          data_resource,
+          bvh,
+          local_surface_area);
+      shape->transform(std::get<1>(candidate));
+      auto& model_objects = model_objects_list_[std::get<2>(candidate)];
+      model_objects.material_ = material.get();
+      model_objects.instance_ = shape.get();
+      object_list->emplace_back(std::move(shape), material.get());
+      const auto candidate_settings = castNode<ObjectModelSettingNode>(
+          std::get<0>(candidate));
+      object_list->back().setName(candidate_settings->name());
+    }
+    material_body_list_.emplace_back(std::move(material));
+  }
+}
+
+/*!
+  \details
+  The object models are collected first, then their shapes are made in parallel.
+  The candidates which have no duplicate are flattened into the single models.
+  */
+void World::makeGeometry(System& system,
+                         const SettingNodeBase* settings,
+                         const SettingNodeBase* bvh_settings,
+                         ObjectModelSet* model_set) noexcept
+{
+  ZISC_ASSERT(model_set != nullptr, "The model set is null.");
+  const bool instancing =
+      castNode<BvhSettingNode>(bvh_settings)->isInstancingEnabled();
   {
     const auto transformation = Transformation::makeIdentity();
-    makeObjects(system, settings, transformation, results);
+    collectObjectModels(settings, transformation, &model_set->model_list_,
+                        (instancing) ? &model_set->candidate_list_ : nullptr);
   }
-  zisc::pmr::vector<ObjectSet> object_list{work_resource};
+  model_objects_list_.resize(model_set->model_list_.size() +
+                             model_set->candidate_list_.size());
+  if (0 < model_set->candidate_list_.size())
+    groupInstances(model_set);
+  makeShapes(system, model_set);
+}
+
+/*!
+  \details
+  The candidates which have the same geometry and surface are a group.
+  */
+void World::groupInstances(ObjectModelSet* model_set) const noexcept
+{
+  ZISC_ASSERT(model_set != nullptr, "The model set is null.");
+  auto get_object_settings = [](const InstanceCandidate& candidate)
   {
-    object_list.reserve(results.size());
-    for (auto& result : results)
-      object_list.emplace_back(result.get());
+    const auto model_settings = castNode<ObjectModelSettingNode>(
+        std::get<0>(candidate));
+    return castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
+  };
+
+  // Group the candidates by the geometry
+  const auto& candidate_list = model_set->candidate_list_;
+  auto& prototype_list = model_set->prototype_list_;
+  auto& group_list = model_set->group_list_;
+  auto& group_size_list = model_set->group_size_list_;
+  group_list.resize(candidate_list.size());
+  for (uint i = 0; i < candidate_list.size(); ++i) {
+    const auto object_settings = get_object_settings(candidate_list[i]);
+    uint group = zisc::cast<uint>(prototype_list.size());
+    for (uint g = 0; g < prototype_list.size(); ++g) {
+      const auto prototype_settings =
+          get_object_settings(candidate_list[prototype_list[g]]);
+      if ((object_settings->surfaceIndex() == prototype_settings->surfaceIndex()) &&
+          object_settings->isSameGeometry(*prototype_settings)) {
+        group = g;
+        break;
+      }
+    }
+    if (group == prototype_list.size()) {
+      prototype_list.emplace_back(i);
+      group_size_list.emplace_back(0);
+    }
+    group_list[i] = group;
+    ++group_size_list[group];
+  }
+
+  // Flatten the objects which have no duplicate
+  for (uint i = 0; i < candidate_list.size(); ++i) {
+    if (group_size_list[group_list[i]] == 1)
+      model_set->model_list_.emplace_back(candidate_list[i]);
   }
-  return object_list;
 }
 
 /*!
+  \details
+  Emissive objects are always flattened since lights sample their shapes.
   */
-void World::makeObjects(
-    System& system,
+void World::collectObjectModels(
     const SettingNodeBase* settings,
     Matrix4x4 transformation,
-    zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept
+    zisc::pmr::vector<ObjectModel>* model_list,
+    zisc::pmr::vector<InstanceCandidate>* candidate_list) const noexcept
 {
   const auto object_model_settings = castNode<ObjectModelSettingNode>(settings);
-  if (object_model_settings->visibility()) {
-    // Transformation
-    const auto& transformation_list = object_model_settings->transformationList();
-    if (0 < transformation_list.size()) {
-      transformation = transformation *
-                       Transformation::makeTransformation(transformation_list);
-    }
-    // Object
-    const auto object_settings = object_model_settings->objectSettingNode();
-    if (object_settings->type() == SettingNodeType::kGroupObject)
-      makeGroupObject(system, settings, transformation, results);
-    else
-      makeSingleObject(system, settings, transformation, results);
+  if (!object_model_settings->visibility())
+    return;
+
+  // Transformation
+  const auto& transformation_list = object_model_settings->transformationList();
+  if (0 < transformation_list.size()) {
+    transformation = transformation *
+                     Transformation::makeTransformation(transformation_list);
+  }
+  // Object
+  const auto object_settings = object_model_settings->objectSettingNode();
+  if (object_settings->type() == SettingNodeType::kGroupObject) {
+    const auto group_settings = castNode<GroupObjectSettingNode>(object_settings);
+    for (const auto child_settings : group_settings->objectList())
+      collectObjectModels(child_settings, transformation, model_list, candidate_list);
+  }
+  else {
+    const auto single_settings = castNode<SingleObjectSettingNode>(object_settings);
+    const bool is_candidate = (candidate_list != nullptr) &&
+                              !single_settings->isEmissiveObject();
+    const uint index = zisc::cast<uint>(model_list->size() +
+        ((candidate_list != nullptr) ? candidate_list->size() : 0));
+    auto list = (is_candidate) ? candidate_list : model_list;
+    list->emplace_back(settings, transformation, index);
   }
 }
 
 /*!
   \details
-  No detailed.
+  The triangles of a model are simplified by the vertex clustering.
+  The vertices in a cell of a uniform grid are merged into their mean,
+  and the triangles which collapse or duplicate by the merge are removed.
+  The objects of a flattened model are contiguous and share the material,
+  so each model is clustered alone and no vertex is merged across the models.
+  The other shapes are copied as they are.
+  The light sources aren't included, since the light samplers and
+  the MIS weights find a light by its object.
   */
-void World::makeSingleObject(
+zisc::pmr::vector<Object> World::makeProxyObjects(
     System& system,
-    const SettingNodeBase* settings,
-    const Matrix4x4& transformation,
-    zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept
+    const zisc::pmr::vector<Object>& object_list,
+    zisc::pmr::memory_resource* work_resource) noexcept
 {
-  auto work_resource = settings->workResource();
-  auto make_object =
-  [this, &system, settings, transformation, work_resource]()
+  auto is_clustered = [](const Object& object)
   {
-    const auto model_settings = castNode<ObjectModelSettingNode>(settings);
-    const auto object_settings =
-        castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
-    // Make geometries
-    auto shape_list = Shape::makeShape(system, object_settings);
-    // Transform geometries
-    for (auto& shape : shape_list)
-      shape->transform(transformation);
-    // Set materials of geometries
-    // Set Surface
-    const auto surface_index = object_settings->surfaceIndex();
-    const SurfaceModel* surface_model = surface_list_[surface_index];
-    // Set Emitter
-    const EmitterModel* emitter_model = nullptr;
-    if (object_settings->isEmissiveObject()) {
-      const auto emitter_index = object_settings->emitterIndex();
-      emitter_model = emitter_list_[emitter_index];
+    return !object.isLightSource() &&
+           (object.shape().type() == ShapeType::kMesh);
+  };
+
+  // Make the grid of the clusters
+  Aabb grid_box;
+  bool is_first = true;
+  for (const auto& object : object_list) {
+    if (is_clustered(object)) {
+      const auto box = object.shape().boundingBox();
+      grid_box = is_first ? box : combine(grid_box, box);
+      is_first = false;
     }
-    // Make material
-    auto material = zisc::UniqueMemoryPointer<Material>::make(
-        &system.dataMemoryManager(),
-        surface_model,
-        emitter_model);
-    // Make objects
-    zisc::pmr::vector<Object> object_list{work_resource};
-    object_list.reserve(shape_list.size());
-    for (auto& shape : shape_list) {
-      object_list.emplace_back(std::move(shape), material.get());
-      object_list.back().setName(model_settings->name());
+  }
+  const uint longest_axis = grid_box.longestAxis();
+  const Float extent = grid_box.maxPoint()[longest_axis] -
+                       grid_box.minPoint()[longest_axis];
+  const Float inverse_cell_size = (0.0 < extent)
+      ? zisc::cast<Float>(proxyGridResolution()) / extent
+      : 0.0;
+  auto get_cell = [&grid_box, inverse_cell_size](const Point3& point)
+  {
+    constexpr uint bits = 21;
+    constexpr uint64 mask = (zisc::cast<uint64>(1) << bits) - 1;
+    uint64 cell = 0;
+    for (uint axis = 0; axis < 3; ++axis) {
+      const Float x = (point[axis] - grid_box.minPoint()[axis]) * inverse_cell_size;
+      cell = (cell << bits) | (zisc::cast<uint64>(zisc::max(x, 0.0)) & mask);
+    }
+    return cell;
+  };
+
+  auto data_resource = &system.trackedMemoryResource(MemoryCategory::kObject);
+  zisc::pmr::vector<Object> proxy_object_list{work_resource};
+  proxy_object_list.reserve(object_list.size());
+  std::unordered_map<const Shape*, Shape*> instance_map;
+  std::unordered_map<uint64, uint32> cluster_map;
+  zisc::pmr::vector<std::array<Float, 4>> cluster_list{work_resource};
+  zisc::pmr::vector<std::array<uint32, 3>> triangle_list{work_resource};
+  zisc::pmr::vector<std::array<uint32, 4>> key_list{work_resource};
+  for (std::size_t begin = 0; begin < object_list.size();) {
+    const auto& model_object = object_list[begin];
+    const auto& shape = model_object.shape();
+    const Material* material = &model_object.material();
+    // Copy the other shapes
+    if (!is_clustered(model_object)) {
+      if (!model_object.isLightSource()) {
+        if (shape.type() == ShapeType::kInstance) {
+          auto s = zisc::UniqueMemoryPointer<InstanceShape>::make(
+              data_resource,
+              static_cast<const InstanceShape&>(shape));
+          instance_map.emplace(&shape, s.get());
+          proxy_object_list.emplace_back(std::move(s), material);
+        }
+        else {
+          auto s = zisc::UniqueMemoryPointer<Plane>::make(
+              data_resource,
+              static_cast<const Plane&>(shape));
+          proxy_object_list.emplace_back(std::move(s), material);
+        }
+        proxy_object_list.back().setName(model_object.name());
+      }
+      ++begin;
+      continue;
+    }
+    std::size_t end = begin + 1;
+    while ((end < object_list.size()) && is_clustered(object_list[end]) &&
+           (&object_list[end].material() == material))
+      ++end;
+
+    // Merge the vertices in each cell
+    cluster_map.clear();
+    cluster_list.clear();
+    triangle_list.clear();
+    for (std::size_t i = begin; i < end; ++i) {
+      const auto& triangle =
+          static_cast<const FlatTriangle&>(object_list[i].shape());
+      const auto& e = triangle.edge();
+      const std::array<Point3, 3> vertices{{triangle.vertex0(),
+                                            triangle.vertex0() + e[0],
+                                            triangle.vertex0() + e[1]}};
+      std::array<uint32, 3> clusters;
+      for (uint v = 0; v < 3; ++v) {
+        const auto index = zisc::cast<uint32>(cluster_list.size());
+        const auto result = cluster_map.emplace(get_cell(vertices[v]), index);
+        if (result.second)
+          cluster_list.emplace_back(std::array<Float, 4>{{0.0, 0.0, 0.0, 0.0}});
+        auto& cluster = cluster_list[result.first->second];
+        for (uint axis = 0; axis < 3; ++axis)
+          cluster[axis] += vertices[v][axis];
+        cluster[3] += 1.0;
+        clusters[v] = result.first->second;
+      }
+      triangle_list.emplace_back(clusters);
+    }
+
+    // Remove the collapsed and the duplicated triangles
+    key_list.clear();
+    for (uint32 i = 0; i < triangle_list.size(); ++i) {
+      const auto& t = triangle_list[i];
+      if ((t[0] == t[1]) || (t[1] == t[2]) || (t[2] == t[0]))
+        continue;
+      // The rotation keeps the orientation of the triangle
+      const uint first = (t[0] < t[1])
+          ? ((t[0] < t[2]) ? 0 : 2)
+          : ((t[1] < t[2]) ? 1 : 2);
+      key_list.emplace_back(std::array<uint32, 4>{{t[first],
+                                                   t[(first + 1) % 3],
+                                                   t[(first + 2) % 3],
+                                                   i}});
+    }
+    std::sort(key_list.begin(), key_list.end());
+    const auto last = std::unique(key_list.begin(), key_list.end(),
+    [](const std::array<uint32, 4>& lhs, const std::array<uint32, 4>& rhs)
+    {
+      return (lhs[0] == rhs[0]) && (lhs[1] == rhs[1]) && (lhs[2] == rhs[2]);
+    });
+
+    // Make the simplified triangles
+    for (auto key = key_list.begin(); key != last; ++key) {
+      const uint32 i = (*key)[3];
+      std::array<Point3, 3> vertices;
+      for (uint v = 0; v < 3; ++v) {
+        const auto& cluster = cluster_list[triangle_list[i][v]];
+        vertices[v] = Point3{cluster[0] / cluster[3],
+                             cluster[1] / cluster[3],
+                             cluster[2] / cluster[3]};
+      }
+      if (FlatTriangle::calcSurfaceArea(vertices[0], vertices[1], vertices[2]) <= 0.0)
+        continue;
+      const auto& object = object_list[begin + i];
+      const auto& triangle = static_cast<const FlatTriangle&>(object.shape());
+      auto mesh = zisc::UniqueMemoryPointer<FlatTriangle>::make(data_resource,
+                                                                vertices[0],
+                                                                vertices[1],
+                                                                vertices[2]);
+      const auto uv0 = triangle.uv0();
+      const auto uv_edge = triangle.uvEdge();
+      mesh->setUv(uv0, uv0 + uv_edge[0], uv0 + uv_edge[1]);
+      proxy_object_list.emplace_back(std::move(mesh), material);
+      proxy_object_list.back().setName(object.name());
+    }
+    begin = end;
+  }
+
+  for (auto& model_objects : model_objects_list_) {
+    if (model_objects.instance_ != nullptr)
+      model_objects.proxy_instance_ = instance_map[model_objects.instance_];
+  }
+  return proxy_object_list;
+}
+
+/*!
+  \details
+  The shapes of the models are made by the threads
+  in contiguous chunks of the model list, without a task per object.
+  Each task allocates the shapes from its own object arena
+  and the temporary buffers from its own work arena,
+  so the shared memory resources are locked once per block and once per model
+  instead of once per triangle.
+  */
+void World::makeShapes(System& system, ObjectModelSet* model_set) noexcept
+{
+  ZISC_ASSERT(model_set != nullptr, "The model set is null.");
+  const auto& model_list = model_set->model_list_;
+  const uint num_of_models = zisc::cast<uint>(model_list.size());
+  auto& shape_list_set = model_set->shape_list_set_;
+  auto work_resource = shape_list_set.get_allocator().resource();
+  shape_list_set.reserve(num_of_models);
+  for (uint index = 0; index < num_of_models; ++index)
+    shape_list_set.emplace_back(work_resource);
+  if (num_of_models == 0)
+    return;
+  auto& threads = system.threadManager();
+  initObjectArenas(system, threads.numOfThreads());
+
+  auto make_shapes =
+  [this, &system, &model_list, &shape_list_set, num_of_models](const uint task_id)
+  {
+    auto data_resource = object_arena_list_[task_id].get();
+    auto& work_arena = system.threadMemoryManager(task_id);
+    const auto range = system.calcTaskRange(num_of_models, task_id);
+    for (auto index = range[0]; index < range[1]; ++index) {
+      const auto& model = model_list[index];
+      const auto model_settings = castNode<ObjectModelSettingNode>(std::get<0>(model));
+      const auto object_settings =
+          castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
+      WorkMemoryArena::Scope work_scope{&work_arena};
+      auto shape_list = Shape::makeShape(system, object_settings,
+                                         std::get<1>(model),
+                                         data_resource, &work_arena);
+      // The list is copied out of the work arena
+      shape_list_set[index] = std::move(shape_list);
     }
-    return std::make_tuple(std::move(object_list), std::move(material));
   };
 
   {
-    auto& threads = system.threadManager();
-    auto result = threads.enqueue<ObjectSet>(make_object, work_resource);
-    results.emplace_back(std::move(result));
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(make_shapes, start, end, work_resource);
+    result.wait();
   }
 }
 
 /*!
   \details
-  No detailed.
+  The materials of the models are made by the threads in the same chunks
+  as the shapes, so a material is placed in the object arena of its shapes.
+  Then the objects are constructed in place in the object list
+  which is allocated to the total number of the shapes.
   */
-void World::makeGroupObject(
+void World::makeSingleObjects(
     System& system,
-    const SettingNodeBase* settings,
-    const Matrix4x4& transformation,
-    zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept
+    ObjectModelSet* model_set,
+    zisc::pmr::vector<Object>* object_list) noexcept
 {
-  const auto model_settings = castNode<ObjectModelSettingNode>(settings);
-  const auto group_settings =
-      castNode<GroupObjectSettingNode>(model_settings->objectSettingNode());
+  ZISC_ASSERT(model_set != nullptr, "The model set is null.");
+  ZISC_ASSERT(object_list != nullptr, "The object list is null.");
+  const auto& model_list = model_set->model_list_;
+  const uint num_of_models = zisc::cast<uint>(model_list.size());
+  if (num_of_models == 0)
+    return;
+
+  // Make the materials
+  const std::size_t material_offset = material_body_list_.size();
+  material_body_list_.resize(material_offset + num_of_models);
+  auto make_materials =
+  [this, &system, &model_list, material_offset, num_of_models](const uint task_id)
+  {
+    auto data_resource = object_arena_list_[task_id].get();
+    const auto range = system.calcTaskRange(num_of_models, task_id);
+    for (auto index = range[0]; index < range[1]; ++index) {
+      const auto& model = model_list[index];
+      const auto model_settings = castNode<ObjectModelSettingNode>(std::get<0>(model));
+      const auto object_settings =
+          castNode<SingleObjectSettingNode>(model_settings->objectSettingNode());
+      const auto surface_index = object_settings->surfaceIndex();
+      const SurfaceModel* surface_model = surface_list_[surface_index];
+      const EmitterModel* emitter_model = nullptr;
+      if (object_settings->isEmissiveObject()) {
+        const auto emitter_index = object_settings->emitterIndex();
+        emitter_model = emitter_list_[emitter_index];
+      }
+      material_body_list_[material_offset + index] =
+          zisc::UniqueMemoryPointer<Material>::make(data_resource,
+                                                    surface_model,
+                                                    emitter_model);
+    }
+  };
 
-  const auto& object_list = group_settings->objectList();
-  for (const auto object_settings : object_list)
-    makeObjects(system, object_settings, transformation, results);
+  {
+    auto& threads = system.threadManager();
+    auto work_resource = model_set->shape_list_set_.get_allocator().resource();
+    constexpr uint start = 0;
+    const uint end = threads.numOfThreads();
+    auto result = threads.enqueueLoop(make_materials, start, end, work_resource);
+    result.wait();
+  }
+
+  // Make objects
+  auto& shape_list_set = model_set->shape_list_set_;
+  std::size_t num_of_objects = object_list->size();
+  for (const auto& shape_list : shape_list_set)
+    num_of_objects += shape_list.size();
+  object_list->reserve(num_of_objects);
+  for (uint index = 0; index < num_of_models; ++index) {
+    const auto model_settings =
+        castNode<ObjectModelSettingNode>(std::get<0>(model_list[index]));
+    const Material* material = material_body_list_[material_offset + index].get();
+    model_objects_list_[std::get<2>(model_list[index])].material_ = material;
+    for (auto& shape : shape_list_set[index]) {
+      object_list->emplace_back(std::move(shape), material);
+      object_list->back().setName(model_settings->name());
+    }
+  }
+}
+
+/*!
+  */
+World::ObjectModelSet::ObjectModelSet(
+    zisc::pmr::memory_resource* work_resource) noexcept :
+    model_list_{work_resource},
+    candidate_list_{work_resource},
+    prototype_list_{work_resource},
+    group_list_{work_resource},
+    group_size_list_{work_resource},
+    shape_list_set_{work_resource}
+{
+}
+
+/*!
+  \details
+  A material refers to the model of the same index in the new model lists.
+  */
+void World::updateMaterials(
+    const zisc::pmr::vector<const SurfaceModel*>& old_surface_list,
+    const zisc::pmr::vector<const EmitterModel*>& old_emitter_list) noexcept
+{
+  auto find_index = [](const auto& model_list, const auto* model)
+  {
+    const auto position = std::find(model_list.begin(), model_list.end(), model);
+    ZISC_ASSERT(position != model_list.end(), "The model isn't found.");
+    return zisc::cast<std::size_t>(std::distance(model_list.begin(), position));
+  };
+  for (auto& material : material_body_list_) {
+    const auto surface_index = find_index(old_surface_list, &material->surface());
+    const SurfaceModel* surface = surface_list_[surface_index];
+    const EmitterModel* emitter = nullptr;
+    if (material->isLightSource()) {
+      const auto emitter_index = find_index(old_emitter_list, &material->emitter());
+      emitter = emitter_list_[emitter_index];
+    }
+    *material = Material{surface, emitter};
+  }
 }
 
 } // namespace nanairo
@@ -12,8 +12,6 @@
 
 // Standard C++ library
 #include <cstddef>
-#include <future>
-#include <list>
 #include <memory>
 #include <tuple>
 #include <vector>
@@ -22,6 +20,8 @@
 #include "zisc/non_copyable.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "Data/light_emission_distribution.hpp"
+#include "Data/light_source_bound.hpp"
 #include "Data/object.hpp"
 #include "Geometry/transformation.hpp"
 #include "Material/material.hpp"
@@ -35,7 +35,10 @@ namespace nanairo {
 
 // Forward declaration
 class Bvh;
+class EnvironmentEmitter;
+class Shape;
 class System;
+class WorkMemoryArena;
 
 //! \addtogroup Core
 //! \{
@@ -61,6 +64,9 @@ class World : public zisc::NonCopyable<World>
   //! Return the texture list
   const zisc::pmr::vector<const EmitterModel*>& emitterList() const noexcept;
 
+  //! Return the environment light, null if the world has no environment
+  const EnvironmentEmitter* environmentLight() const noexcept;
+
   //! Return the light source list
   const zisc::pmr::vector<const Object*>& lightSourceList() const noexcept;
 
@@ -76,9 +82,64 @@ class World : public zisc::NonCopyable<World>
   //! Return the texture list
   const zisc::pmr::vector<const TextureModel*>& textureList() const noexcept;
 
+  //! Return the number of the visible single object models
+  uint numOfObjectModels() const noexcept;
+
+  //! Return the BVH of the simplified geometry, null if the world has no proxy
+  const Bvh* proxyBvh() const noexcept;
+
+  //! Apply an affine transformation to the objects of a single object model
+  bool transformObject(System& system,
+                       const uint index,
+                       const Matrix4x4& matrix) noexcept;
+
+  //! Remake the surface model of the index
+  void updateSurface(System& system,
+                     const SettingNodeBase* settings,
+                     const uint index) noexcept;
+
+  //! Remake the texture of the index and the models which refer to the textures
+  void updateTexture(System& system,
+                     const SettingNodeBase* settings,
+                     const uint index) noexcept;
+
  private:
-  using ObjectSet = std::tuple<zisc::pmr::vector<Object>,
-                               zisc::UniqueMemoryPointer<Material>>;
+  //! A single object model, its transformation and its index in the object tree
+  using ObjectModel = std::tuple<const SettingNodeBase*, Matrix4x4, uint>;
+  //! An object model which can be instanced and its transformation
+  using InstanceCandidate = ObjectModel;
+
+  /*!
+    \brief The objects which are made from a single object model
+    \details
+    The flattened objects of a model are found by the material of the model.
+    */
+  struct ModelObjects
+  {
+    const Material* material_ = nullptr;
+    Shape* instance_ = nullptr; //!< The shape if the model is an instance
+    Shape* proxy_instance_ = nullptr; //!< The copy of the instance in the proxy
+  };
+
+  using ShapeList = zisc::pmr::vector<zisc::UniqueMemoryPointer<Shape>>;
+
+  /*!
+    \brief The object models of the object tree and the shapes of the models
+    \details
+    The geometry of the models is made before the materials,
+    so the set keeps the shapes until the objects are made.
+    */
+  struct ObjectModelSet
+  {
+    ObjectModelSet(zisc::pmr::memory_resource* work_resource) noexcept;
+
+    zisc::pmr::vector<ObjectModel> model_list_; //!< Including the flattened ones
+    zisc::pmr::vector<InstanceCandidate> candidate_list_;
+    zisc::pmr::vector<uint> prototype_list_; //!< The first candidate of a group
+    zisc::pmr::vector<uint> group_list_; //!< The group of each candidate
+    zisc::pmr::vector<uint> group_size_list_;
+    zisc::pmr::vector<ShapeList> shape_list_set_; //!< The shapes of each model
+  };
 
 
   //! Initialize world
@@ -87,56 +148,99 @@ class World : public zisc::NonCopyable<World>
   //! Initialize emitter list
   void initializeEmitter(System& system, const SettingNodeBase* settings) noexcept;
 
-  //! Initialize Objects
+  //! Make the object arenas of the threads
+  void initObjectArenas(System& system, const uint num_of_arenas) noexcept;
+
+  //! Initialize the textures, then the surfaces and the emitters
+  void initializeModels(System& system, const SettingNodeBase* settings) noexcept;
+
+  //! Initialize the objects of the shapes of the model set
   zisc::pmr::vector<Object> initializeObject(
       System& system,
-      const SettingNodeBase* settings) noexcept;
+      const SettingNodeBase* settings,
+      const SettingNodeBase* bvh_settings,
+      ObjectModelSet* model_set) noexcept;
 
   //! Initialize the world information of light sources
   void initializeWorldLightSource() noexcept;
 
+  //! Make the emission distributions of the textured light sources
+  void initializeLightEmissions() noexcept;
+
+  //! Update the bounds of the light sources by the current shapes
+  void updateLightSourceBounds() noexcept;
+
   //! Initialize surface scattering list
   void initializeSurface(System& system, const SettingNodeBase* settings) noexcept;
 
   //! Initialize texture list
   void initializeTexture(System& system, const SettingNodeBase* settings) noexcept;
 
-  //! Make objects
-  zisc::pmr::vector<ObjectSet> makeObjects(
-      System& system,
-      const SettingNodeBase* settings) const noexcept;
+  //! Group the instance candidates of the same geometry
+  void groupInstances(ObjectModelSet* model_set) const noexcept;
 
-  //! Make objects
-  void makeObjects(
+  //! Make instances which share a bottom-level BVH for duplicated objects
+  void makeInstances(
       System& system,
+      const SettingNodeBase* bvh_settings,
+      const ObjectModelSet& model_set,
+      zisc::pmr::vector<Object>* object_list) noexcept;
+
+  //! Collect the object models and make the shapes of the single models
+  void makeGeometry(System& system,
+                    const SettingNodeBase* settings,
+                    const SettingNodeBase* bvh_settings,
+                    ObjectModelSet* model_set) noexcept;
+
+  //! Collect the single object models of the object tree
+  void collectObjectModels(
       const SettingNodeBase* settings,
       Matrix4x4 transformation,
-      zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept;
+      zisc::pmr::vector<ObjectModel>* model_list,
+      zisc::pmr::vector<InstanceCandidate>* candidate_list) const noexcept;
+
+  //! Make the shapes of the single object models
+  void makeShapes(System& system, ObjectModelSet* model_set) noexcept;
 
-  //! Make a single object
-  void makeSingleObject(
+  //! Make the simplified objects of the proxy geometry
+  zisc::pmr::vector<Object> makeProxyObjects(
       System& system,
-      const SettingNodeBase* settings,
-      const Matrix4x4& transformation,
-      zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept;
+      const zisc::pmr::vector<Object>& object_list,
+      zisc::pmr::memory_resource* work_resource) noexcept;
 
-  void makeGroupObject(
+  //! Make the objects of the shapes and the materials of the single models
+  void makeSingleObjects(
       System& system,
-      const SettingNodeBase* settings,
-      const Matrix4x4& transformation,
-      zisc::pmr::list<std::future<ObjectSet>>& results) const noexcept;
+      ObjectModelSet* model_set,
+      zisc::pmr::vector<Object>* object_list) noexcept;
+
+  //! Return the number of the grid cells along the longest axis of the proxy
+  static constexpr uint proxyGridResolution() noexcept;
+
+  //! Replace the models of the materials by the models of the same index
+  void updateMaterials(
+      const zisc::pmr::vector<const SurfaceModel*>& old_surface_list,
+      const zisc::pmr::vector<const EmitterModel*>& old_emitter_list) noexcept;
 
 
+  //! The arenas are destroyed after the objects which they hold
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<WorkMemoryArena>> object_arena_list_;
   zisc::pmr::vector<const EmitterModel*> emitter_list_;
   zisc::pmr::vector<const SurfaceModel*> surface_list_;
   zisc::pmr::vector<const TextureModel*> texture_list_;
   zisc::pmr::vector<const Material*> material_list_;
   zisc::pmr::vector<const Object*> light_source_list_;
+  zisc::pmr::vector<LightSourceBound> light_source_bound_list_;
+  zisc::pmr::vector<LightEmissionDistribution> light_emission_list_;
+  zisc::pmr::vector<ModelObjects> model_objects_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<EmitterModel>> emitter_body_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<SurfaceModel>> surface_body_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<TextureModel>> texture_body_list_;
   zisc::pmr::vector<zisc::UniqueMemoryPointer<Material>> material_body_list_;
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<Bvh>> instance_bvh_list_;
   zisc::UniqueMemoryPointer<Bvh> bvh_;
+  zisc::UniqueMemoryPointer<Bvh> proxy_bvh_;
+  const EnvironmentEmitter* environment_light_ = nullptr;
 };
 
 //! \} Core
@@ -0,0 +1,82 @@
+/*!
+  \file NToneMappingEffect.qml
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+import QtQuick 2.12
+
+/*!
+  \details
+  Decode the RGBE pixels of the source and map them as the CPU operator does.
+  The luminance is mapped by the tone curve and the color is scaled by
+  the ratio of the mapped luminance, then the gamma is corrected.
+  The source has to be sampled by the nearest filter,
+  since the bytes of RGBE can't be interpolated.
+  */
+ShaderEffect {
+  id: effect
+
+  property variant source
+  property bool hasParameters: false
+  // 0: Reinhard, 1: Filmic, 2: Uncharted2Filmic
+  property real toneCurve: 0.0
+  property real exposure: 1.0
+  property real inverseGamma: 1.0 / 2.2
+  property vector3d luminanceWeights: Qt.vector3d(0.2126, 0.7152, 0.0722)
+
+  visible: hasParameters
+
+  fragmentShader: "
+    varying highp vec2 qt_TexCoord0;
+    uniform sampler2D source;
+    uniform lowp float qt_Opacity;
+    uniform highp float toneCurve;
+    uniform highp float exposure;
+    uniform highp float inverseGamma;
+    uniform highp vec3 luminanceWeights;
+
+    highp float uncharted2(highp float x) {
+      const highp float a = 0.15;
+      const highp float b = 0.50;
+      const highp float c = 0.10;
+      const highp float d = 0.20;
+      const highp float e = 0.02;
+      const highp float f = 0.30;
+      return (x * (a * x + c * b) + d * e) / (x * (a * x + b) + d * f) - e / f;
+    }
+
+    highp float tonemap(highp float x) {
+      if (toneCurve < 0.5)
+        return x / (1.0 + x);
+      else if (toneCurve < 1.5)
+        return (x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14);
+      else
+        return uncharted2(x);
+    }
+
+    void main() {
+      highp vec4 t = floor(texture2D(source, qt_TexCoord0) * 255.0 + 0.5);
+      highp vec3 rgb = vec3(0.0);
+      if (0.0 < t.a)
+        rgb = ((t.rgb + 0.5) / 256.0) * exp2(t.a - 128.0);
+      highp float y = dot(luminanceWeights, rgb);
+      highp vec3 c = vec3(0.0);
+      if (0.0 < y) {
+        highp float l = clamp(tonemap(exposure * y), 0.0, 1.0);
+        c = clamp(rgb * (l / y), 0.0, 1.0);
+      }
+      gl_FragColor = vec4(pow(c, vec3(inverseGamma)), 1.0) * qt_Opacity;
+    }"
+
+  function setParameters(parameters) {
+    toneCurve = parameters["toneCurve"];
+    exposure = parameters["exposure"];
+    inverseGamma = parameters["inverseGamma"];
+    luminanceWeights = parameters["luminanceWeights"];
+    hasParameters = true;
+  }
+}
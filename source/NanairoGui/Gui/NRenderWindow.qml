@@ -24,12 +24,37 @@ Window {
     enabled: renderWindow.visible
     spacing: 0
 
-    NLabel {
-      id: infoLabel
+    RowLayout {
       Layout.fillWidth: true
-      font.family: nanairoManager.getDefaultFixedFontFamily()
-      font.pixelSize: 11
-      text: "000.00 fps,  0000000000 cycles,  0000 h 00 m 00.000 s"
+      spacing: 0
+
+      NLabel {
+        id: infoLabel
+        Layout.fillWidth: true
+        font.family: nanairoManager.getDefaultFixedFontFamily()
+        font.pixelSize: 11
+        text: "000.00 fps,  0000000000 cycles,  0000 h 00 m 00.000 s"
+      }
+
+      NLabel {
+        font.family: nanairoManager.getDefaultFixedFontFamily()
+        font.pixelSize: 11
+        text: "exposure "
+      }
+
+      NFloatSpinBox {
+        id: exposureSpinBox
+
+        Layout.preferredWidth: 80
+        Layout.preferredHeight: infoLabel.height
+        font.pixelSize: 11
+        enabled: toneMappingEffect.hasParameters
+        floatFrom: 0.0001
+        floatTo: realMax
+        floatValue: 1.0
+
+        onFloatValueChanged: toneMappingEffect.exposure = floatValue
+      }
     }
 
     NProgressBar {
@@ -43,34 +68,49 @@ Window {
       Layout.fillWidth: true
       Layout.fillHeight: true
 
+      // The image holds the RGBE pixels, which the effect displays
       Image {
         id: renderImage
 
         property int imageNumber
 
         anchors.fill: parent
+        visible: false
         cache: false
         fillMode: Image.PreserveAspectFit
         horizontalAlignment: Image.AlignHCenter
         verticalAlignment: Image.AlignVCenter
         smooth: false
 
-        NPreviewEventArea {
-          id: eventArea
-          enabled: renderWindow.isPreviewMode
-          anchors.fill: parent
-        }
-
         function updateRenderImage() {
           imageNumber = imageNumber + 1;
           source = "image://renderedImage/preview?" + imageNumber;
         }
       }
+
+      NToneMappingEffect {
+        id: toneMappingEffect
+
+        anchors.centerIn: renderImage
+        width: renderImage.paintedWidth
+        height: renderImage.paintedHeight
+        source: renderImage
+      }
+
+      NPreviewEventArea {
+        id: eventArea
+        enabled: renderWindow.isPreviewMode
+        anchors.fill: renderImage
+      }
     }
   }
 
   Connections {
     target: nanairoManager
+    onNotifyOfDisplayParameters: {
+      toneMappingEffect.setParameters(parameters);
+      exposureSpinBox.floatValue = toneMappingEffect.exposure;
+    }
     onNotifyOfRenderingProgress: {
       progress_bar.indeterminate = false;
       progress_bar.value = progress;
@@ -0,0 +1,114 @@
+/*!
+  \file NBinnedSahBvhItem.qml
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+import QtQuick 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.11
+import "../../Items"
+import "../../definitions.js" as Definitions
+
+NScrollView {
+  id: bvhItem
+
+  ColumnLayout {
+    spacing: Definitions.defaultItemSpace
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "bins"
+    }
+
+    NSpinBox {
+      id: numOfBinsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: bvhItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 2
+      to: 256
+    }
+
+    NCheckBox {
+      id: spatialSplitCheckBox
+
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.fillWidth: true
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "spatial split"
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "split budget"
+    }
+
+    NFloatSpinBox {
+      id: splitBudgetSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: bvhItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      enabled: spatialSplitCheckBox.checked
+      floatFrom: 0.0
+      floatTo: 4.0
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "max leaf objects"
+    }
+
+    NSpinBox {
+      id: maxNumOfLeafObjectsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: bvhItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 1
+      to: 64
+    }
+  }
+
+  function getSceneData() {
+    var sceneData = {};
+
+    sceneData[Definitions.numOfBins] = numOfBinsSpinBox.value;
+    sceneData[Definitions.spatialSplit] = spatialSplitCheckBox.checked;
+    sceneData[Definitions.splitBudget] = splitBudgetSpinBox.floatValue;
+    sceneData[Definitions.maxNumOfLeafObjects] = maxNumOfLeafObjectsSpinBox.value;
+
+    return sceneData;
+  }
+
+  function initSceneData() {
+    numOfBinsSpinBox.value = 16;
+    spatialSplitCheckBox.checked = false;
+    splitBudgetSpinBox.floatValue = 0.5;
+    maxNumOfLeafObjectsSpinBox.value = 8;
+  }
+
+  function setSceneData(sceneData) {
+    numOfBinsSpinBox.value =
+        Definitions.getProperty(sceneData, Definitions.numOfBins);
+
+    var spatialSplit = sceneData[Definitions.spatialSplit];
+    spatialSplitCheckBox.checked = (typeof(spatialSplit) == "undefined")
+        ? false
+        : spatialSplit;
+    var splitBudget = sceneData[Definitions.splitBudget];
+    splitBudgetSpinBox.floatValue = (typeof(splitBudget) == "undefined")
+        ? 0.5
+        : splitBudget;
+    var maxNumOfLeafObjects = sceneData[Definitions.maxNumOfLeafObjects];
+    maxNumOfLeafObjectsSpinBox.value = (typeof(maxNumOfLeafObjects) == "undefined")
+        ? 8
+        : maxNumOfLeafObjects;
+  }
+}
@@ -0,0 +1,74 @@
+/*!
+  \file NAtrousWaveletDenoiserItem.qml
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+import QtQuick 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.11
+import "../../Items"
+import "../../definitions.js" as Definitions
+
+NScrollView {
+  id: denoiserItem
+
+  ColumnLayout {
+    spacing: Definitions.defaultItemSpace
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "number of iterations"
+    }
+
+    NSpinBox {
+      id: numberOfIterationsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: denoiserItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 1
+      to: 16
+    }
+
+    NLabel {
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "color sigma"
+    }
+
+    NFloatSpinBox {
+      id: colorSigmaSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: denoiserItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      floatFrom: 0.0001
+      floatTo: realMax
+    }
+  }
+
+  function getSceneData() {
+    var sceneData = {};
+
+    sceneData[Definitions.numberOfIterations] = numberOfIterationsSpinBox.value;
+    sceneData[Definitions.colorSigma] = colorSigmaSpinBox.floatValue;
+
+    return sceneData;
+  }
+
+  function initSceneData() {
+    numberOfIterationsSpinBox.value = 5;
+    colorSigmaSpinBox.floatValue = 4.0;
+  }
+
+  function setSceneData(sceneData) {
+    numberOfIterationsSpinBox.value =
+        Definitions.getProperty(sceneData, Definitions.numberOfIterations);
+    colorSigmaSpinBox.floatValue =
+        Definitions.getProperty(sceneData, Definitions.colorSigma);
+  }
+}
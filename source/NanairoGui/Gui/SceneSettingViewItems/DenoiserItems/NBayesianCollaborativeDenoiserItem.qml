@@ -97,6 +97,17 @@ NScrollView {
       from: 1
       to: Definitions.intMax
     }
+
+    NCheckBox {
+      id: singlePrecisionCheckBox
+
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.fillWidth: true
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "single precision"
+    }
   }
 
   function getSceneData() {
@@ -107,6 +118,7 @@ NScrollView {
     sceneData[Definitions.patchRadius] = patchRadiusSpinBox.value;
     sceneData[Definitions.searchWindowRadius] = searchWindowRadiusSpinBox.value;
     sceneData[Definitions.numberOfScales] = numberOfScalesSpinBox.value;
+    sceneData[Definitions.singlePrecision] = singlePrecisionCheckBox.checked;
 
     return sceneData;
   }
@@ -117,6 +129,7 @@ NScrollView {
     patchRadiusSpinBox.value = 1;
     searchWindowRadiusSpinBox.value = 6;
     numberOfScalesSpinBox.value = 2;
+    singlePrecisionCheckBox.checked = false;
   }
 
   function setSceneData(sceneData) {
@@ -130,5 +143,9 @@ NScrollView {
         Definitions.getProperty(sceneData, Definitions.searchWindowRadius);
     numberOfScalesSpinBox.value =
         Definitions.getProperty(sceneData, Definitions.numberOfScales);
+    var singlePrecision = sceneData[Definitions.singlePrecision];
+    singlePrecisionCheckBox.checked = (typeof(singlePrecision) == "undefined")
+        ? false
+        : singlePrecision;
   }
 }
@@ -43,7 +43,8 @@ NScrollView {
           Layout.fillWidth: true
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
           currentIndex: find(infoSettingView.emitterType)
-          model: [Definitions.nonDirectionalEmitter]
+          model: [Definitions.nonDirectionalEmitter,
+                  Definitions.environmentEmitter]
 
           onCurrentTextChanged: infoSettingView.emitterType = currentText
         }
@@ -74,6 +75,13 @@ NScrollView {
           onColorIndexChanged: infoSettingView.setProperty(Definitions.emissiveColorIndex, colorIndex)
           onRadiantExitanceChanged: infoSettingView.setProperty(Definitions.radiantExitance, radiantExitance)
         }
+
+        NEnvironmentEmitterItem {
+          id: environmentEmitterItem
+          textureModelList: infoSettingView.textureModelList
+          onColorIndexChanged: infoSettingView.setProperty(Definitions.emissiveColorIndex, colorIndex)
+          onRadianceScaleChanged: infoSettingView.setProperty(Definitions.radianceScale, radianceScale)
+        }
       }
 
       Component.onCompleted: {
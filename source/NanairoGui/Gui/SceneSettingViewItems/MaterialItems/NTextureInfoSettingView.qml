@@ -145,6 +145,7 @@ NScrollView {
         NImageTextureItem {
           id: imageTextureItem
           onImageFilePathChanged: infoSettingView.setProperty(Definitions.imageFilePath, imageFilePath)
+          onTiledImageChanged: infoSettingView.setProperty(Definitions.tiledImage, tiledImage)
         }
       }
 
@@ -18,10 +18,22 @@ NScrollView {
   id: textureItem
 
   property string imageFilePath: ""
+  property bool tiledImage: false
 
   ColumnLayout {
     spacing: Definitions.defaultItemSpace
 
+    NCheckBox {
+      id: tiledImageCheckBox
+
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      text: "tiled"
+      checked: textureItem.tiledImage
+
+      onCheckedChanged: textureItem.tiledImage = checked
+    }
+
     NLabel {
       Layout.alignment: Qt.AlignLeft | Qt.AlignTop
       text: "image"
@@ -58,11 +70,13 @@ NScrollView {
   function initItem(item) {
     console.assert(item != null, "The item is null.");
     item[Definitions.imageFilePath] = "";
+    item[Definitions.tiledImage] = false;
   }
 
   function setValue(item) {
     console.assert(item != null, "The item is null.");
     imageFilePath = Definitions.getProperty(item, Definitions.imageFilePath);
+    tiledImage = Definitions.getProperty(item, Definitions.tiledImage);
   }
 
   function getSceneData(item) {
@@ -70,6 +84,8 @@ NScrollView {
 
     sceneData[Definitions.imageFilePath] =
         Definitions.getProperty(item, Definitions.imageFilePath);
+    sceneData[Definitions.tiledImage] =
+        Definitions.getProperty(item, Definitions.tiledImage);
 
     return sceneData;
   }
@@ -77,5 +93,9 @@ NScrollView {
   function setSceneData(sceneData, item) {
     item[Definitions.imageFilePath] =
         Definitions.getProperty(sceneData, Definitions.imageFilePath);
+    var tiledImage = sceneData[Definitions.tiledImage];
+    item[Definitions.tiledImage] = (typeof(tiledImage) == "undefined")
+        ? false
+        : tiledImage;
   }
 }
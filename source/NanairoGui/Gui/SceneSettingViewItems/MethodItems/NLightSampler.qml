@@ -34,7 +34,8 @@ NPane {
 
       Component.onCompleted: {
         var samplerList = [Definitions.uniformLightSampler,
-                           Definitions.powerWeightedLightSampler];
+                           Definitions.powerWeightedLightSampler,
+                           Definitions.lightBvhLightSampler];
         model = samplerList;
       }
     }
@@ -0,0 +1,113 @@
+/*!
+  \file NLightVertexCacheBptMethodItem.qml
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+import QtQuick 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.11
+import "../../Items"
+import "../../definitions.js" as Definitions
+
+NScrollView {
+  id: methodItem
+
+  ColumnLayout {
+    spacing: Definitions.defaultItemSpace
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "eye path light sampler"
+    }
+
+    NLightSampler {
+      id: eyePathLightSampler
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      isEyePathSampler: true
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "light path light sampler"
+    }
+
+    NLightSampler {
+      id: lightPathLightSampler
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      isEyePathSampler: false
+    }
+
+    NLabel {
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "number of light paths"
+    }
+
+    NSpinBox {
+      id: numOfLightPathsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 1024
+      to: Definitions.intMax
+      value: 65536
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "number of connections"
+    }
+
+    NSpinBox {
+      id: numOfConnectionsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 0
+      to: 16
+      value: 2
+    }
+  }
+
+  function getSceneData() {
+    var sceneData = eyePathLightSampler.getSceneData();
+    var lightPathData = lightPathLightSampler.getSceneData();
+    sceneData[Definitions.lightPathLightSampler] =
+        lightPathData[Definitions.lightPathLightSampler];
+    sceneData[Definitions.numOfLightPaths] = numOfLightPathsSpinBox.value;
+    sceneData[Definitions.numOfConnections] = numOfConnectionsSpinBox.value;
+    return sceneData;
+  }
+
+  function initSceneData() {
+    eyePathLightSampler.initSceneData();
+    lightPathLightSampler.initSceneData();
+    numOfLightPathsSpinBox.value = 65536;
+    numOfConnectionsSpinBox.value = 2;
+  }
+
+  function setSceneData(sceneData) {
+    eyePathLightSampler.setSceneData(sceneData);
+    lightPathLightSampler.setSceneData(sceneData);
+    var numOfLightPaths = sceneData[Definitions.numOfLightPaths];
+    numOfLightPathsSpinBox.value = (typeof(numOfLightPaths) == "undefined")
+        ? 65536
+        : numOfLightPaths;
+    var numOfConnections = sceneData[Definitions.numOfConnections];
+    numOfConnectionsSpinBox.value = (typeof(numOfConnections) == "undefined")
+        ? 2
+        : numOfConnections;
+  }
+}
@@ -32,18 +32,114 @@ NScrollView {
       Layout.preferredHeight: Definitions.defaultSettingItemHeight
       isEyePathSampler: true
     }
+
+    NCheckBox {
+      id: lightSolidAngleSamplingCheckBox
+
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.fillWidth: true
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "light solid angle sampling"
+    }
+
+    NCheckBox {
+      id: materialSortingCheckBox
+
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.fillWidth: true
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "material sorting"
+    }
+
+    NCheckBox {
+      id: pathGuidingCheckBox
+
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.fillWidth: true
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "path guiding"
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      enabled: pathGuidingCheckBox.checked
+      text: "guiding iterations"
+    }
+
+    NSpinBox {
+      id: guidingIterationsSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      enabled: pathGuidingCheckBox.checked
+      from: 1
+      to: 64
+      value: 8
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "wavelength batches"
+    }
+
+    NSpinBox {
+      id: wavelengthBatchesSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 1
+      to: 16
+      value: 1
+    }
   }
 
   function getSceneData() {
     var sceneData = lightSampler.getSceneData();
+    sceneData[Definitions.lightSolidAngleSampling] =
+        lightSolidAngleSamplingCheckBox.checked;
+    sceneData[Definitions.materialSorting] = materialSortingCheckBox.checked;
+    sceneData[Definitions.pathGuiding] = pathGuidingCheckBox.checked;
+    sceneData[Definitions.guidingIterations] = guidingIterationsSpinBox.value;
+    sceneData[Definitions.wavelengthBatches] = wavelengthBatchesSpinBox.value;
     return sceneData;
   }
 
   function initSceneData() {
     lightSampler.initSceneData();
+    lightSolidAngleSamplingCheckBox.checked = false;
+    materialSortingCheckBox.checked = false;
+    pathGuidingCheckBox.checked = false;
+    guidingIterationsSpinBox.value = 8;
+    wavelengthBatchesSpinBox.value = 1;
   }
 
   function setSceneData(sceneData) {
     lightSampler.setSceneData(sceneData);
+    var lightSolidAngleSampling = sceneData[Definitions.lightSolidAngleSampling];
+    lightSolidAngleSamplingCheckBox.checked =
+        (typeof(lightSolidAngleSampling) == "undefined")
+            ? false
+            : lightSolidAngleSampling;
+    var materialSorting = sceneData[Definitions.materialSorting];
+    materialSortingCheckBox.checked = (typeof(materialSorting) == "undefined")
+        ? false
+        : materialSorting;
+    var pathGuiding = sceneData[Definitions.pathGuiding];
+    pathGuidingCheckBox.checked = (typeof(pathGuiding) == "undefined")
+        ? false
+        : pathGuiding;
+    var guidingIterations = sceneData[Definitions.guidingIterations];
+    guidingIterationsSpinBox.value = (typeof(guidingIterations) == "undefined")
+        ? 8
+        : guidingIterations;
+    var wavelengthBatches = sceneData[Definitions.wavelengthBatches];
+    wavelengthBatchesSpinBox.value = (typeof(wavelengthBatches) == "undefined")
+        ? 1
+        : wavelengthBatches;
   }
 }
@@ -61,7 +61,84 @@ NScrollView {
       Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
       Layout.preferredWidth: methodItem.width
       Layout.preferredHeight: Definitions.defaultSettingItemHeight
-      from: 1
+      from: 0
+      to: Definitions.intMax
+    }
+
+    NLabel {
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "photon map"
+    }
+
+    NComboBox {
+      id: photonMapComboBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      currentIndex: 0
+      model: [Definitions.kdTreePhotonMap,
+              Definitions.hashGridPhotonMap]
+    }
+
+    NCheckBox {
+      id: photonAutoTuningCheckBox
+
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      checked: false
+      text: "photon auto tuning"
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "target photon time ratio"
+    }
+
+    NFloatSpinBox {
+      id: targetPhotonTimeRatioSpinBox
+
+      enabled: photonAutoTuningCheckBox.checked
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      floatFrom: 0.01
+      floatTo: 100.0
+      floatValue: 1.0
+    }
+
+    NLabel {
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "target cycle time [ms]"
+    }
+
+    NSpinBox {
+      id: targetCycleTimeSpinBox
+
+      enabled: photonAutoTuningCheckBox.checked
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 0
+      to: Definitions.intMax
+    }
+
+    NLabel {
+      Layout.topMargin: Definitions.defaultBlockSize
+      Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+      text: "visible point update interval"
+    }
+
+    NSpinBox {
+      id: visiblePointUpdateIntervalSpinBox
+
+      Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+      Layout.preferredWidth: methodItem.width
+      Layout.preferredHeight: Definitions.defaultSettingItemHeight
+      from: 0
       to: Definitions.intMax
     }
   }
@@ -70,12 +147,24 @@ NScrollView {
     lightSampler.initSceneData();
     numOfPhotonsSpinBox.value = 131072;
     kNearestNeighborSpinBox.value = 8;
+    photonMapComboBox.currentIndex = 0;
+    photonAutoTuningCheckBox.checked = false;
+    targetPhotonTimeRatioSpinBox.floatValue = 1.0;
+    targetCycleTimeSpinBox.value = 0;
+    visiblePointUpdateIntervalSpinBox.value = 0;
   }
 
   function getSceneData() {
     var sceneData = lightSampler.getSceneData();
     sceneData[Definitions.numOfPhotons] = numOfPhotonsSpinBox.value;
     sceneData[Definitions.kNearestNeighbor] = kNearestNeighborSpinBox.value;
+    sceneData[Definitions.photonMap] = photonMapComboBox.currentText;
+    sceneData[Definitions.photonAutoTuning] = photonAutoTuningCheckBox.checked;
+    sceneData[Definitions.targetPhotonTimeRatio] =
+        targetPhotonTimeRatioSpinBox.floatValue;
+    sceneData[Definitions.targetCycleTime] = targetCycleTimeSpinBox.value;
+    sceneData[Definitions.visiblePointUpdateInterval] =
+        visiblePointUpdateIntervalSpinBox.value;
 
     return sceneData;
   }
@@ -85,6 +174,29 @@ NScrollView {
         Definitions.getProperty(sceneData, Definitions.numOfPhotons);
     kNearestNeighborSpinBox.value =
         Definitions.getProperty(sceneData, Definitions.kNearestNeighbor);
+    var photonMap = sceneData[Definitions.photonMap];
+    photonMapComboBox.currentIndex = (typeof(photonMap) == "undefined")
+        ? 0
+        : photonMapComboBox.find(photonMap);
+    var photonAutoTuning = sceneData[Definitions.photonAutoTuning];
+    photonAutoTuningCheckBox.checked = (typeof(photonAutoTuning) == "undefined")
+        ? false
+        : photonAutoTuning;
+    var targetPhotonTimeRatio = sceneData[Definitions.targetPhotonTimeRatio];
+    targetPhotonTimeRatioSpinBox.floatValue =
+        (typeof(targetPhotonTimeRatio) == "undefined")
+            ? 1.0
+            : targetPhotonTimeRatio;
+    var targetCycleTime = sceneData[Definitions.targetCycleTime];
+    targetCycleTimeSpinBox.value = (typeof(targetCycleTime) == "undefined")
+        ? 0
+        : targetCycleTime;
+    var visiblePointUpdateInterval =
+        sceneData[Definitions.visiblePointUpdateInterval];
+    visiblePointUpdateIntervalSpinBox.value =
+        (typeof(visiblePointUpdateInterval) == "undefined")
+            ? 0
+            : visiblePointUpdateInterval;
 
     lightSampler.setSceneData(sceneData);
   }
@@ -42,7 +42,8 @@ NScrollView {
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
           currentIndex: 0
           model: [Definitions.binaryRadixTreeBvh,
-                  Definitions.agglomerativeTreeletRestructuringBvh]
+                  Definitions.agglomerativeTreeletRestructuringBvh,
+                  Definitions.binnedSahBvh]
 
           onCurrentIndexChanged: {
             if (settingView.isEditMode) {
@@ -60,6 +61,78 @@ NScrollView {
       }
     }
 
+    NGroupBox {
+      id: layoutGroup
+      title: "bvh layout"
+      color: settingView.background.color
+      Layout.preferredWidth: Definitions.defaultSettingGroupWidth
+      Layout.preferredHeight: Definitions.defaultSettingGroupHeight
+
+      ColumnLayout {
+        anchors.fill: parent
+
+        NComboBox {
+          id: bvhLayoutComboBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          currentIndex: 0
+          model: [Definitions.binaryBvhLayout,
+                  Definitions.orderedBinaryBvhLayout,
+                  Definitions.wide4BvhLayout,
+                  Definitions.wide8BvhLayout,
+                  Definitions.quantized4BvhLayout]
+        }
+
+        NCheckBox {
+          id: instancingCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "instancing"
+        }
+
+        NCheckBox {
+          id: largeObjectSeparationCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "separate large objects"
+        }
+
+        NCheckBox {
+          id: extendedMortonCodeCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "extended morton code"
+        }
+
+        NCheckBox {
+          id: proxyGeometryCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "preview proxy geometry"
+        }
+
+        NPane {
+          Layout.fillWidth: true
+          Layout.fillHeight: true
+          Component.onCompleted: background.color = layoutGroup.background.color;
+        }
+      }
+    }
+
     NGroupBox {
       title: "bvh parameters"
       color: settingView.background.color
@@ -79,6 +152,10 @@ NScrollView {
         NAgglomerativeTreeletRestructuringBvhItem {
           id: agglomerativeTreeletRestructuringBvh
         }
+
+        NBinnedSahBvhItem {
+          id: binnedSahBvh
+        }
       }
 
       Component.onCompleted: {
@@ -95,6 +172,12 @@ NScrollView {
     var sceneData = bvhView.getSceneData();
 
     sceneData[Definitions.type] = bvhTypeComboBox.currentText;
+    sceneData[Definitions.bvhLayout] = bvhLayoutComboBox.currentText;
+    sceneData[Definitions.instancing] = instancingCheckBox.checked;
+    sceneData[Definitions.largeObjectSeparation] =
+        largeObjectSeparationCheckBox.checked;
+    sceneData[Definitions.extendedMortonCode] = extendedMortonCodeCheckBox.checked;
+    sceneData[Definitions.proxyGeometry] = proxyGeometryCheckBox.checked;
 
     return sceneData;
   }
@@ -103,6 +186,31 @@ NScrollView {
     bvhTypeComboBox.currentIndex = bvhTypeComboBox.find(
         Definitions.getProperty(sceneData, Definitions.type));
 
+    var layout = sceneData[Definitions.bvhLayout];
+    bvhLayoutComboBox.currentIndex = (typeof(layout) == "undefined")
+        ? 0
+        : bvhLayoutComboBox.find(layout);
+
+    var instancing = sceneData[Definitions.instancing];
+    instancingCheckBox.checked = (typeof(instancing) == "undefined")
+        ? false
+        : instancing;
+
+    var separation = sceneData[Definitions.largeObjectSeparation];
+    largeObjectSeparationCheckBox.checked = (typeof(separation) == "undefined")
+        ? false
+        : separation;
+
+    var extended = sceneData[Definitions.extendedMortonCode];
+    extendedMortonCodeCheckBox.checked = (typeof(extended) == "undefined")
+        ? false
+        : extended;
+
+    var proxy = sceneData[Definitions.proxyGeometry];
+    proxyGeometryCheckBox.checked = (typeof(proxy) == "undefined")
+        ? false
+        : proxy;
+
     var bvhView = bvhItemLayout.children[bvhTypeComboBox.currentIndex];
     bvhView.setSceneData(sceneData);
   }
@@ -46,6 +46,17 @@ NScrollView {
                                                       : Definitions.rgb
         }
 
+        NCheckBox {
+          id: xyzFilmCheckBox
+
+          enabled: colorModeButton.text == Definitions.spectra
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "XYZ film"
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -76,6 +87,35 @@ NScrollView {
                   Definitions.stratifiedSampling]
         }
 
+        RowLayout {
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+
+          NLabel {
+            font.family: nanairoManager.getDefaultFixedFontFamily()
+            text: "size"
+          }
+
+          NSpinBox {
+            id: wavelengthSampleSizeSpinBox
+
+            Layout.fillWidth: true
+            Layout.preferredHeight: Definitions.defaultSettingItemHeight
+            from: 0
+            to: 64
+            value: 0
+          }
+        }
+
+        NCheckBox {
+          id: tileWavelengthSamplingCheckBox
+
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "per tile"
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -209,7 +249,8 @@ NScrollView {
           Layout.fillWidth: true
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
           currentIndex: 0
-          model: [Definitions.bayesianCollaborativeDenoiser]
+          model: [Definitions.bayesianCollaborativeDenoiser,
+                  Definitions.atrousWaveletDenoiser]
         }
 
         NPane {
@@ -237,6 +278,10 @@ NScrollView {
           id: bayesianCollaborativeDenoiserItem
         }
 
+        NAtrousWaveletDenoiserItem {
+          id: atrousWaveletDenoiserItem
+        }
+
         onCurrentIndexChanged: {
           if (settingView.isEditMode) {
             var denoiserView = children[currentIndex];
@@ -259,7 +304,11 @@ NScrollView {
     var sceneData = denoiserView.getSceneData();
 
     sceneData[Definitions.colorMode] = colorModeButton.text;
+    sceneData[Definitions.enableXyzFilm] = xyzFilmCheckBox.checked;
     sceneData[Definitions.wavelengthSampling] = wavelengthSamplerComboBox.currentText;
+    sceneData[Definitions.wavelengthSampleSize] = wavelengthSampleSizeSpinBox.value;
+    sceneData[Definitions.enableTileWavelengthSampling] =
+        tileWavelengthSamplingCheckBox.checked;
     sceneData[Definitions.colorSpace] = colorSpaceComboBox.currentText;
     sceneData[Definitions.gamma] = gammaSpinBox.floatValue;
     sceneData[Definitions.exposure] = exposureSpinBox.floatValue;
@@ -273,8 +322,20 @@ NScrollView {
   function setSceneData(sceneData) {
     colorModeButton.text =
         Definitions.getProperty(sceneData, Definitions.colorMode);
+    var xyzFilm = sceneData[Definitions.enableXyzFilm];
+    xyzFilmCheckBox.checked = (typeof(xyzFilm) == "undefined")
+        ? false
+        : xyzFilm;
     wavelengthSamplerComboBox.currentIndex = wavelengthSamplerComboBox.find(
         Definitions.getProperty(sceneData, Definitions.wavelengthSampling));
+    var sampleSize = sceneData[Definitions.wavelengthSampleSize];
+    wavelengthSampleSizeSpinBox.value = (typeof(sampleSize) == "undefined")
+        ? 0
+        : sampleSize;
+    var tileSampling = sceneData[Definitions.enableTileWavelengthSampling];
+    tileWavelengthSamplingCheckBox.checked = (typeof(tileSampling) == "undefined")
+        ? false
+        : tileSampling;
     colorSpaceComboBox.currentIndex = colorSpaceComboBox.find(
         Definitions.getProperty(sceneData, Definitions.colorSpace));
     gammaSpinBox.floatValue =
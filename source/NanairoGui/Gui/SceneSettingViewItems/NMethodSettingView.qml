@@ -43,7 +43,9 @@ NScrollView {
           Layout.preferredHeight: Definitions.defaultSettingItemHeight
           currentIndex: 0
           model: [Definitions.pathTracing,
+                  Definitions.wavefrontPathTracing,
                   Definitions.lightTracing,
+                  Definitions.lightVertexCacheBpt,
                   Definitions.probabilisticPpm]
         }
 
@@ -72,10 +74,18 @@ NScrollView {
           id: pathTracingMethodItem
         }
 
+        NWavefrontPathTracingMethodItem {
+          id: wavefrontPathTracingMethodItem
+        }
+
         NLightTracingMethodItem {
           id: lightTracingMethodItem
         }
 
+        NLightVertexCacheBptMethodItem {
+          id: lightVertexCacheBptMethodItem
+        }
+
         NProbabilisticPpmMethodItem {
           id: probabilisticPpmMethodItem
         }
@@ -145,11 +155,14 @@ NScrollView {
           currentIndex: 0
           model: [Definitions.rouletteMaxReflectance,
                   Definitions.rouletteAverageReflectance,
+                  Definitions.rouletteEfficiency,
                   Definitions.roulettePathLength]
 
           onCurrentIndexChanged: {
-            if (settingView.isEditMode)
+            if (settingView.isEditMode) {
               roulettePathLengthSpinBox.initItem();
+              rouletteMinPathLengthSpinBox.initItem();
+            }
           }
         }
 
@@ -177,6 +190,30 @@ NScrollView {
           }
         }
 
+        RowLayout {
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+
+          NLabel {
+            font.family: nanairoManager.getDefaultFixedFontFamily()
+            text: "min   "
+          }
+
+          NSpinBox {
+            id: rouletteMinPathLengthSpinBox
+
+            enabled: russianRouletteComboBox.currentText != Definitions.roulettePathLength
+            Layout.fillWidth: true
+            Layout.preferredHeight: Definitions.defaultSettingItemHeight
+            from: 0
+            to: Definitions.intMax
+            value: 0
+
+            function initItem() {
+              value = 0;
+            }
+          }
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -194,6 +231,7 @@ NScrollView {
     sceneData[Definitions.rayCastEpsilon] = rayCastEpsilonSpinBox.floatValue;
     sceneData[Definitions.russianRoulette] = russianRouletteComboBox.currentText;
     sceneData[Definitions.pathLength] = roulettePathLengthSpinBox.value;
+    sceneData[Definitions.minPathLength] = rouletteMinPathLengthSpinBox.value;
 
     return sceneData;
   }
@@ -207,6 +245,10 @@ NScrollView {
         Definitions.getProperty(sceneData, Definitions.russianRoulette));
     roulettePathLengthSpinBox.value =
         Definitions.getProperty(sceneData, Definitions.pathLength);
+    var minPathLength = sceneData[Definitions.minPathLength];
+    rouletteMinPathLengthSpinBox.value = (typeof(minPathLength) == "undefined")
+        ? 0
+        : minPathLength;
 
     var methodView = methodItemLayout.children[methodTypeComboBox.currentIndex];
     methodView.setSceneData(sceneData);
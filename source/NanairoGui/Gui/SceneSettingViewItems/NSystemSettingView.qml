@@ -53,6 +53,46 @@ NScrollView {
           onClicked: numOfThreadsSpinBox.value = nanairoManager.getIdealThreadCount()
         }
 
+        NCheckBox {
+          id: threadAffinityCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "affinity"
+        }
+
+        NCheckBox {
+          id: memoryFirstTouchCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "local memory"
+        }
+
+        NCheckBox {
+          id: backgroundPriorityCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "background"
+        }
+
+        NCheckBox {
+          id: hugePageAllocationCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "huge pages"
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -80,7 +120,9 @@ NScrollView {
           currentIndex: 2
           model: [Definitions.pcgSampler,
                   Definitions.xoshiroSampler,
-                  Definitions.cmjSampler]
+                  Definitions.cmjSampler,
+                  Definitions.tableCmjSampler,
+                  Definitions.owenSobolSampler]
         }
 
         RowLayout {
@@ -110,6 +152,25 @@ NScrollView {
           onClicked: samplerSeedSpinBox.value = nanairoManager.generateSeedRandomly()
         }
 
+        RowLayout {
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+
+          NLabel {
+            font.family: nanairoManager.getDefaultFixedFontFamily()
+            text: "spc "
+          }
+
+          NSpinBox {
+            id: samplesPerCycleSpinBox
+
+            Layout.fillWidth: true
+            Layout.preferredHeight: Definitions.defaultSettingItemHeight
+            from: 1
+            to: 1024
+            value: 1
+          }
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -233,6 +294,26 @@ NScrollView {
           text: "2^n cycle"
         }
 
+        NCheckBox {
+          id: ldrImageOutputCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: true
+          text: "LDR image (png)"
+        }
+
+        NCheckBox {
+          id: hdrImageOutputCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "HDR image (pfm)"
+        }
+
         NPane {
           Layout.fillWidth: true
           Layout.fillHeight: true
@@ -296,6 +377,54 @@ NScrollView {
         }
       }
     }
+
+    NGroupBox {
+      title: "adaptive sampling"
+      color: settingView.background.color
+
+      Layout.preferredWidth: Definitions.defaultSettingGroupWidth
+      Layout.preferredHeight: Definitions.defaultSettingGroupHeight
+
+      ColumnLayout {
+        anchors.fill: parent
+
+        NCheckBox {
+          id: adaptiveSamplingCheckBox
+
+          Layout.alignment: Qt.AlignLeft | Qt.AlignTop
+          Layout.fillWidth: true
+          Layout.preferredHeight: Definitions.defaultSettingItemHeight
+          checked: false
+          text: "enabled"
+        }
+
+        RowLayout {
+          Layout.alignment: Qt.AlignHCenter | Qt.AlignTop
+
+          NLabel {
+            font.family: nanairoManager.getDefaultFixedFontFamily()
+            text: "error"
+          }
+
+          NFloatSpinBox {
+            id: adaptiveSamplingThresholdSpinBox
+
+            enabled: adaptiveSamplingCheckBox.checked
+            Layout.fillWidth: true
+            Layout.preferredHeight: Definitions.defaultSettingItemHeight
+            floatFrom: 0.0001
+            floatTo: 1.0
+            floatValue: 0.01
+          }
+        }
+
+        NPane {
+          Layout.fillWidth: true
+          Layout.fillHeight: true
+          Component.onCompleted: background.color = group.background.color;
+        }
+      }
+    }
   }
 
   function getImageResolution() {
@@ -308,8 +437,16 @@ NScrollView {
     var sceneData = {};
 
     sceneData[Definitions.numOfThreads] = numOfThreadsSpinBox.value;
+    sceneData[Definitions.enableThreadAffinity] = threadAffinityCheckBox.checked;
+    sceneData[Definitions.enableMemoryFirstTouch] =
+        memoryFirstTouchCheckBox.checked;
+    sceneData[Definitions.enableBackgroundPriority] =
+        backgroundPriorityCheckBox.checked;
+    sceneData[Definitions.enableHugePageAllocation] =
+        hugePageAllocationCheckBox.checked;
     sceneData[Definitions.samplerType] = samplerTypeComboBox.currentText;
     sceneData[Definitions.samplerSeed] = samplerSeedSpinBox.value;
+    sceneData[Definitions.samplesPerCycle] = samplesPerCycleSpinBox.value;
     var imageResolution = getImageResolution();
     sceneData[Definitions.imageResolution] = imageResolution;
     sceneData[Definitions.terminationCycle] = terminationCycleSpinBox.value;
@@ -317,6 +454,11 @@ NScrollView {
     sceneData[Definitions.savingIntervalTime] = savingIntervalTimeSpinBox.value;
     sceneData[Definitions.savingIntervalCycle] = savingIntervalCycleSpinBox.value;
     sceneData[Definitions.power2CycleSaving] = power2CycleSavingCheckBox.checked;
+    sceneData[Definitions.enableLdrImageOutput] = ldrImageOutputCheckBox.checked;
+    sceneData[Definitions.enableHdrImageOutput] = hdrImageOutputCheckBox.checked;
+    sceneData[Definitions.enableAdaptiveSampling] = adaptiveSamplingCheckBox.checked;
+    sceneData[Definitions.adaptiveSamplingThreshold] =
+        adaptiveSamplingThresholdSpinBox.floatValue;
 
     return sceneData;
   }
@@ -324,10 +466,30 @@ NScrollView {
   function setSceneData(sceneData) {
     numOfThreadsSpinBox.value =
         Definitions.getProperty(sceneData, Definitions.numOfThreads);
+    var threadAffinity = sceneData[Definitions.enableThreadAffinity];
+    threadAffinityCheckBox.checked = (typeof(threadAffinity) == "undefined")
+        ? false
+        : threadAffinity;
+    var memoryFirstTouch = sceneData[Definitions.enableMemoryFirstTouch];
+    memoryFirstTouchCheckBox.checked = (typeof(memoryFirstTouch) == "undefined")
+        ? false
+        : memoryFirstTouch;
+    var backgroundPriority = sceneData[Definitions.enableBackgroundPriority];
+    backgroundPriorityCheckBox.checked = (typeof(backgroundPriority) == "undefined")
+        ? false
+        : backgroundPriority;
+    var hugePageAllocation = sceneData[Definitions.enableHugePageAllocation];
+    hugePageAllocationCheckBox.checked = (typeof(hugePageAllocation) == "undefined")
+        ? false
+        : hugePageAllocation;
     samplerTypeComboBox.currentIndex = samplerTypeComboBox.find(
         Definitions.getProperty(sceneData, Definitions.samplerType));
     samplerSeedSpinBox.value =
         Definitions.getProperty(sceneData, Definitions.samplerSeed);
+    var samplesPerCycle = sceneData[Definitions.samplesPerCycle];
+    samplesPerCycleSpinBox.value = (typeof(samplesPerCycle) == "undefined")
+        ? 1
+        : samplesPerCycle;
     var imageResolution =
         Definitions.getProperty(sceneData, Definitions.imageResolution);
     widthResolutionSpinBox.value = imageResolution[0];
@@ -342,5 +504,22 @@ NScrollView {
         Definitions.getProperty(sceneData, Definitions.savingIntervalCycle);
     power2CycleSavingCheckBox.checked =
         Definitions.getProperty(sceneData, Definitions.power2CycleSaving);
+    var ldrImageOutput = sceneData[Definitions.enableLdrImageOutput];
+    ldrImageOutputCheckBox.checked = (typeof(ldrImageOutput) == "undefined")
+        ? true
+        : ldrImageOutput;
+    var hdrImageOutput = sceneData[Definitions.enableHdrImageOutput];
+    hdrImageOutputCheckBox.checked = (typeof(hdrImageOutput) == "undefined")
+        ? false
+        : hdrImageOutput;
+    var adaptiveSampling = sceneData[Definitions.enableAdaptiveSampling];
+    adaptiveSamplingCheckBox.checked = (typeof(adaptiveSampling) == "undefined")
+        ? false
+        : adaptiveSampling;
+    var adaptiveSamplingThreshold = sceneData[Definitions.adaptiveSamplingThreshold];
+    adaptiveSamplingThresholdSpinBox.floatValue =
+        (typeof(adaptiveSamplingThreshold) == "undefined")
+            ? 0.01
+            : adaptiveSamplingThreshold;
   }
 }
@@ -187,7 +187,9 @@ NScrollView {
     id: objectFileDialog
 
     title: "Open mesh file"
-    nameFilters: ["Wavefront (*.obj)"]
+    nameFilters: ["Mesh files (*.obj *.nmesh)",
+                  "Wavefront (*.obj)",
+                  "Nanairo mesh (*.nmesh)"]
 
     onAccepted: objectSettingView.objectFilePath = nanairoManager.getRelativePath(file)
   }
@@ -35,17 +35,28 @@ var scene = "@scene@";
 // System
 var system = "@system@";
 var numOfThreads = "@numOfThreads@";
+var enableThreadAffinity = "@enableThreadAffinity@";
+var enableMemoryFirstTouch = "@enableMemoryFirstTouch@";
+var enableBackgroundPriority = "@enableBackgroundPriority@";
+var enableHugePageAllocation = "@enableHugePageAllocation@";
 var samplerType = "@samplerType@";
     var pcgSampler = "@pcgSampler@";
     var xoshiroSampler = "@xoshiroSampler@";
     var cmjSampler = "@cmjSampler@";
+    var tableCmjSampler = "@tableCmjSampler@";
+    var owenSobolSampler = "@owenSobolSampler@";
 var samplerSeed = "@samplerSeed@";
+var samplesPerCycle = "@samplesPerCycle@";
 var terminationCycle = "@terminationCycle@";
 var terminationTime = "@terminationTime@";
 var imageResolution = "@imageResolution@";
 var power2CycleSaving = "@power2CycleSaving@";
+var enableLdrImageOutput = "@enableLdrImageOutput@";
+var enableHdrImageOutput = "@enableHdrImageOutput@";
 var savingIntervalTime = "@savingIntervalTime@";
 var savingIntervalCycle = "@savingIntervalCycle@";
+var enableAdaptiveSampling = "@enableAdaptiveSampling@";
+var adaptiveSamplingThreshold = "@adaptiveSamplingThreshold@";
 
 // Color
 var color = "@color@";
@@ -54,10 +65,13 @@ var color2 = "@color2@";
 var colorMode = "@colorMode@";
     var rgb = "@rgb@";
     var spectra = "@spectra@";
+var enableXyzFilm = "@enableXyzFilm@";
 var wavelengthSampling = "@wavelengthSampling@";
     var regularSampling = "@regularSampling@";
     var randomSampling = "@randomSampling@";
     var stratifiedSampling = "@stratifiedSampling@";
+var enableTileWavelengthSampling = "@enableTileWavelengthSampling@";
+var wavelengthSampleSize = "@wavelengthSampleSize@";
 var colorSpace = "@colorSpace@";
     var sRgbD65 = "@sRgbD65@";
     var sRgbD50 = "@sRgbD50@";
@@ -72,31 +86,56 @@ var toneMapping = "@toneMapping@";
 var enableDenoising = "@enableDenoising@";
 var denoiserType = "@denoiserType@";
     var bayesianCollaborativeDenoiser = "@bayesianCollaborativeDenoiser@";
+    var atrousWaveletDenoiser = "@atrousWaveletDenoiser@";
+// A-trous wavelet denoiser
+var numberOfIterations = "@numberOfIterations@";
+var colorSigma = "@colorSigma@";
 // Bayesian collaborative denoiser
 var histogramBins = "@histogramBins@";
 var histogramDistanceThreshold = "@histogramDistanceThreshold@";
 var patchRadius = "@patchRadius@";
 var searchWindowRadius = "@searchWindowRadius@";
 var numberOfScales = "@numberOfScales@";
+var singlePrecision = "@singlePrecision@";
 
 // Rendering method
 var renderingMethod = "@renderingMethod@";
     var pathTracing = "@pathTracing@";
+        var materialSorting = "@materialSorting@";
+        var pathGuiding = "@pathGuiding@";
+        var guidingIterations = "@guidingIterations@";
+        var wavelengthBatches = "@wavelengthBatches@";
+        var lightSolidAngleSampling = "@lightSolidAngleSampling@";
+    var wavefrontPathTracing = "@wavefrontPathTracing@";
+        var raySorting = "@raySorting@";
     var lightTracing = "@lightTracing@";
+    var lightVertexCacheBpt = "@lightVertexCacheBpt@";
+        var numOfLightPaths = "@numOfLightPaths@";
+        var numOfConnections = "@numOfConnections@";
     var probabilisticPpm = "@probabilisticPpm@";
         var numOfPhotons = "@numOfPhotons@";
         var photonSearchRadius = "@photonSearchRadius@";
         var kNearestNeighbor = "@kNearestNeighbor@";
+        var photonMap = "@photonMap@";
+            var kdTreePhotonMap = "@kdTreePhotonMap@";
+            var hashGridPhotonMap = "@hashGridPhotonMap@";
+        var photonAutoTuning = "@photonAutoTuning@";
+        var targetPhotonTimeRatio = "@targetPhotonTimeRatio@";
+        var targetCycleTime = "@targetCycleTime@";
+        var visiblePointUpdateInterval = "@visiblePointUpdateInterval@";
 var rayCastEpsilon = "@rayCastEpsilon@";
 var russianRoulette = "@russianRoulette@";
     var rouletteMaxReflectance = "@rouletteMaxReflectance@";
     var rouletteAverageReflectance = "@rouletteAverageReflectance@";
+    var rouletteEfficiency = "@rouletteEfficiency@";
     var roulettePathLength = "@roulettePathLength@";
         var pathLength = "@pathLength@";
+    var minPathLength = "@minPathLength@";
 var lightPathLightSampler = "@lightPathLightSampler@";
 var eyePathLightSampler = "@eyePathLightSampler@";
     var uniformLightSampler = "@uniformLightSampler@";
     var powerWeightedLightSampler = "@powerWeightedLightSampler@";
+    var lightBvhLightSampler = "@lightBvhLightSampler@";
     var contributionWeightedLightSampler = "@contributionWeightedLightSampler@";
 
 // Texture
@@ -106,6 +145,7 @@ var textureModel = "@textureModel@";
     var checkerboardTexture = "@checkerboardTexture@";
     var imageTexture = "@imageTexture@";
         var imageFilePath = "@imageFilePath@";
+        var tiledImage = "@tiledImage@";
 
 // Surface
 var surfaceModel = "@surfaceModel@";
@@ -128,6 +168,8 @@ var emitterModel = "@emitterModel@";
     var nonDirectionalEmitter = "@nonDirectionalEmitter@";
         var emissiveColorIndex = "@emissiveColorIndex@";
         var radiantExitance = "@radiantExitance@";
+    var environmentEmitter = "@environmentEmitter@";
+        var radianceScale = "@radianceScale@";
 
 // Object
 // object type
@@ -175,6 +217,21 @@ var bvh = "@bvh@";
     var agglomerativeTreeletRestructuringBvh = "@agglomerativeTreeletRestructuringBvh@";
         var treeletSize = "@treeletSize@";
         var optimizationLoopCount = "@optimizationLoopCount@";
+    var binnedSahBvh = "@binnedSahBvh@";
+        var numOfBins = "@numOfBins@";
+        var spatialSplit = "@spatialSplit@";
+        var splitBudget = "@splitBudget@";
+        var maxNumOfLeafObjects = "@maxNumOfLeafObjects@";
+    var bvhLayout = "@bvhLayout@";
+        var binaryBvhLayout = "@binaryBvhLayout@";
+        var orderedBinaryBvhLayout = "@orderedBinaryBvhLayout@";
+        var wide4BvhLayout = "@wide4BvhLayout@";
+        var wide8BvhLayout = "@wide8BvhLayout@";
+        var quantized4BvhLayout = "@quantized4BvhLayout@";
+    var instancing = "@instancing@";
+    var largeObjectSeparation = "@largeObjectSeparation@";
+    var extendedMortonCode = "@extendedMortonCode@";
+    var proxyGeometry = "@proxyGeometry@";
 
 // Global variables
 
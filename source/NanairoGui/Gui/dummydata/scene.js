@@ -17,11 +17,13 @@ function getCornellBoxScene() {
     },
     "@color@": {
         "@colorMode@": "@spectra@",
+        "@enableXyzFilm@": false,
         "@colorSpace@": "@sRgbD50@",
         "@exposure@": 2,
         "@gamma@": 2.4,
         "@toneMapping@": "@filmic@",
         "@wavelengthSampling@": "@randomSampling@",
+        "@enableTileWavelengthSampling@": false,
         "@enableDenoising@": true,
         "@denoiserType@": "@bayesianCollaborativeDenoiser@",
         "@histogramBins@": 10,
@@ -407,14 +409,23 @@ function getCornellBoxScene() {
         }
     ],
     "@system@": {
+        "@adaptiveSamplingThreshold@": 0.01,
+        "@enableAdaptiveSampling@": false,
+        "@enableBackgroundPriority@": false,
+        "@enableHugePageAllocation@": false,
+        "@enableMemoryFirstTouch@": false,
+        "@enableThreadAffinity@": false,
         "@imageResolution@": [
             1280,
             720 
         ],
         "@numOfThreads@": 4,
         "@power2CycleSaving@": true,
+        "@enableLdrImageOutput@": true,
+        "@enableHdrImageOutput@": false,
         "@samplerType@": "@cmjSampler@",
         "@samplerSeed@": 123456789,
+        "@samplesPerCycle@": 1,
         "@savingIntervalCycle@": 1,
         "@savingIntervalTime@": 10000,
         "@terminationCycle@": 1024,
@@ -9,12 +9,11 @@
 
 #include "cui_renderer.hpp"
 // Standard C++ library
-#include <cstdint>
-#include <cstring>
 #include <string>
 #include <string_view>
 // Qt
 #include <QImage>
+#include <QString>
 // Zisc
 #include "zisc/error.hpp"
 #include "zisc/utility.hpp"
@@ -27,52 +26,48 @@ namespace nanairo {
 
 /*!
   */
-CuiRenderer::CuiRenderer() noexcept :
-    ldr_image_helper_{nullptr}
+CuiRenderer::CuiRenderer() noexcept
 {
   initialize();
 }
 
 /*!
+  \details
+  The RGB32 format of QImage is the native order of Rgba32.
   */
-QImage& CuiRenderer::ldrImageHelper() noexcept
+LdrImage::ChannelOrder CuiRenderer::ldrChannelOrder() const noexcept
 {
-  ZISC_ASSERT(ldr_image_helper_ != nullptr, "The image is null.");
-  return *ldr_image_helper_;
+  return LdrImage::ChannelOrder::kBgra;
 }
 
 /*!
+  \details
+  The buffer of the LDR image is in the layout of the RGB32 format,
+  so the QImage refers to the buffer. The QImage is valid
+  while the buffer of the LDR image isn't changed.
   */
-const QImage& CuiRenderer::ldrImageHelper() const noexcept
+QImage CuiRenderer::makeQImage(const LdrImage& ldr_image) noexcept
 {
-  ZISC_ASSERT(ldr_image_helper_ != nullptr, "The image is null.");
-  return *ldr_image_helper_;
+  const auto data = zisc::treatAs<const uchar*>(ldr_image.data().data());
+  const int width = zisc::cast<int>(ldr_image.widthResolution());
+  const int height = zisc::cast<int>(ldr_image.heightResolution());
+  const int bytes_per_line = zisc::cast<int>(sizeof(ldr_image[0])) * width;
+  return QImage{data, width, height, bytes_per_line, QImage::Format_RGB32};
 }
 
 /*!
   */
-void CuiRenderer::setImage(QImage* image) noexcept
-{
-  ldr_image_helper_ = image;
-}
-
-/*!
-  */
-void CuiRenderer::outputLdrImage(const std::string_view output_path,
+void CuiRenderer::outputLdrImage(LdrImage* ldr_image,
+                                 const std::string_view output_path,
                                  const uint32 cycle,
                                  const std::string_view suffix) noexcept
 {
-  ZISC_ASSERT(ldr_image_helper_ != nullptr, "The image is null.");
-
-  // Copy image
-  const auto& ldr_image = ldrImage();
-  auto data = const_cast<uint8*>(ldr_image_helper_->constBits());
-  const std::size_t memory_size = sizeof(ldr_image[0]) * ldr_image.size();
-  std::memcpy(data, ldr_image.data().data(), memory_size);
+  ZISC_ASSERT(ldr_image != nullptr, "The image is null.");
+  const auto image = makeQImage(*ldr_image);
 
   const auto ldr_path = makeImagePath(output_path, cycle, suffix);
 
-  const bool result = ldr_image_helper_->save(QString{ldr_path.c_str()});
+  const bool result = image.save(QString{ldr_path.c_str()});
   if (!result)
     logMessage("QImage error: saving image failed: " + ldr_path);
 }
@@ -31,28 +31,22 @@ class CuiRenderer : public SimpleRenderer
   //! Create a renderer
   CuiRenderer() noexcept;
 
+ protected:
+  //! Return the channel order of QImage
+  LdrImage::ChannelOrder ldrChannelOrder() const noexcept override;
 
-  //! Return the LDR image for Qt
-  QImage& ldrImageHelper() noexcept;
-
-  //! Return the LDR image for Qt
-  const QImage& ldrImageHelper() const noexcept;
-
-  //! Set the image body
-  void setImage(QImage* image) noexcept;
+  //! Wrap the buffer of the LDR image into a QImage without copying
+  static QImage makeQImage(const LdrImage& ldr_image) noexcept;
 
- protected:
   //! Output LDR image
-  void outputLdrImage(const std::string_view output_path,
+  void outputLdrImage(LdrImage* ldr_image,
+                      const std::string_view output_path,
                       const uint32 cycle,
                       const std::string_view suffix = "") noexcept override;
 
  private:
   //! Initialize the renderer
   void initialize() noexcept;
-
-
-  QImage* ldr_image_helper_;
 };
 
 //! \} Gui
@@ -16,9 +16,9 @@
 // Qt
 #include <QDate>
 #include <QDir>
-#include <QImage>
 #include <QJsonObject>
 #include <QString>
+#include <QStringList>
 #include <QTime>
 #include <QTextStream>
 // Zisc
@@ -27,8 +27,10 @@
 #include "cui_renderer.hpp"
 #include "scene_document.hpp"
 #include "scene_value.hpp"
+#include "scene_value_cache.hpp"
 #include "simple_progress_bar.hpp"
 #include "simple_renderer.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
 #include "NanairoCore/Setting/scene_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 #include "NanairoGui/keyword.hpp"
@@ -54,63 +56,32 @@ void CuiRendererManager::enableSavingSceneBinary(const bool is_enabled) noexcept
 
 /*!
   */
-void CuiRendererManager::invokeRendering(const QString& scene_file_path)
-    const noexcept
+void CuiRendererManager::invokeRendering(const QString& scene_file_path) noexcept
 {
-  CuiRenderer renderer;
-  std::unique_ptr<std::ofstream> log_stream;
-  QImage image;
-  QString output_dir;
-  QString error_message;
-
-  // Prepare for rendering
-  {
-    QJsonObject scene_value;
-    if (SceneDocument::loadDocument(scene_file_path, scene_value, error_message)) {
-      // Make a setting file
-      const auto scene_settings = SceneValue::toSetting(scene_value);
-
-      // Make a output directory
-      output_dir = makeOutputDir(*scene_settings);
-      if (!output_dir.isEmpty()) {
-        backupSceneFiles(scene_value, *scene_settings, output_dir, &error_message);
-
-        // Init log streams
-        log_stream = makeTextLogStream(output_dir.toStdString());
-        renderer.setLogStream(log_stream.get());
-
-        // Init a scene
-        prepareForRendering(*scene_settings, &renderer, &error_message);
-      }
-      else {
-        error_message = "making output dir failed.";
-      }
-    }
-  }
-
-  if (!error_message.isEmpty())
-    QTextStream{stderr} << "Error: " << error_message;
-
-  // Make a progress bar
-  SimpleProgressBar progress_bar;
-  auto notify_of_progress =
-  [&progress_bar](const double progress, const std::string_view status)
-  {
-    progress_bar.update(progress, status);
-  };
-  renderer.setProgressCallback(notify_of_progress);
+  renderScene(scene_file_path, false);
+}
 
-  // Start rendering
-  if (renderer.isRunnable()) {
-    {
-      const auto& ldr_image = renderer.ldrImage();
-      image = QImage{static_cast<int>(ldr_image.widthResolution()),
-                     static_cast<int>(ldr_image.heightResolution()),
-                     QImage::Format_RGB32};
-      renderer.setImage(&image);
+/*!
+  \details
+  The scenes are rendered in a process, so the meshes and the images
+  which the scenes share are loaded only once and the BVHs are
+  reused through the BVH cache in the output path.
+  */
+void CuiRendererManager::invokeRendering(const QStringList& scene_file_list)
+    noexcept
+{
+  const int num_of_jobs = scene_file_list.size();
+  const bool is_queued = 1 < num_of_jobs;
+  for (int job = 0; job < num_of_jobs; ++job) {
+    if (is_queued) {
+      QTextStream{stdout} << "Job " << (job + 1) << "/" << num_of_jobs << ": "
+                          << scene_file_list[job] << endl;
     }
-    renderer.render(output_dir.toStdString());
+    renderScene(scene_file_list[job], is_queued);
   }
+  if (is_queued)
+    QTextStream{stdout} << "Reused files: " << scene_cache_.numOfHits() << endl;
+  scene_cache_.clear();
 }
 
 /*!
@@ -211,4 +182,67 @@ void CuiRendererManager::initialize() noexcept
 {
 }
 
+/*!
+  */
+void CuiRendererManager::renderScene(const QString& scene_file_path,
+                                     const bool is_queued) noexcept
+{
+  CuiRenderer renderer;
+  std::unique_ptr<std::ofstream> log_stream;
+  QString output_dir;
+  QString error_message;
+
+  // Prepare for rendering
+  {
+    QJsonObject scene_value;
+    if (SceneDocument::loadDocument(scene_file_path, scene_value, error_message)) {
+      // Make a setting file
+      auto* cache = is_queued ? &scene_cache_ : nullptr;
+      const auto scene_settings = SceneValue::toSetting(scene_value, cache);
+      if (is_queued) {
+        // The BVHs of the same objects are shared by the scenes
+        auto settings = castNode<SceneSettingNode>(scene_settings.get());
+        auto bvh_settings = castNode<BvhSettingNode>(settings->bvhSettingNode());
+        if (bvh_settings->cacheDirectory().empty()) {
+          const auto cache_dir = outputPath() + "/" + keyword::bvhCacheDirName;
+          QDir::current().mkpath(cache_dir);
+          bvh_settings->setCacheDirectory(cache_dir.toStdString());
+        }
+      }
+
+      // Make a output directory
+      output_dir = makeOutputDir(*scene_settings);
+      if (!output_dir.isEmpty()) {
+        backupSceneFiles(scene_value, *scene_settings, output_dir, &error_message);
+
+        // Init log streams
+        log_stream = makeTextLogStream(output_dir.toStdString());
+        renderer.setLogStream(log_stream.get());
+
+        // Init a scene
+        prepareForRendering(*scene_settings, &renderer, &error_message);
+      }
+      else {
+        error_message = "making output dir failed.";
+      }
+    }
+  }
+
+  if (!error_message.isEmpty())
+    QTextStream{stderr} << "Error: " << error_message;
+
+  // Make a progress bar
+  SimpleProgressBar progress_bar;
+  auto notify_of_progress =
+  [&progress_bar](const double progress, const std::string_view status)
+  {
+    progress_bar.update(progress, status);
+  };
+  renderer.setProgressCallback(notify_of_progress);
+
+  // Start rendering
+  if (renderer.isRunnable())
+    renderer.render(output_dir.toStdString());
+}
+
 } // namespace nanairo
@@ -15,7 +15,9 @@
 #include <memory>
 // Qt
 #include <QString>
+#include <QStringList>
 // Nanairo
+#include "scene_value_cache.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
 
 // Forward declaration
@@ -44,7 +46,10 @@ class CuiRendererManager
   void enableSavingSceneBinary(const bool is_enabled) noexcept;
 
   //! Invoke rendering with the scene
-  void invokeRendering(const QString& scene_file_path) const noexcept;
+  void invokeRendering(const QString& scene_file_path) noexcept;
+
+  //! Invoke rendering with the scenes one after another
+  void invokeRendering(const QStringList& scene_file_list) noexcept;
 
   //! Check whether is saving scene binary enabled
   bool isSavingSceneBinaryEnabled() const noexcept;
@@ -77,7 +82,12 @@ class CuiRendererManager
   //! Initialize the renderer manager
   void initialize() noexcept;
 
+  //! Render the scene, the files of the previous scenes are reused
+  void renderScene(const QString& scene_file_path,
+                   const bool is_queued) noexcept;
+
 
+  SceneValueCache scene_cache_;
   QString output_path_;
   bool is_saving_scene_binary_enabled_;
 };
@@ -9,16 +9,23 @@
 
 #include "gui_renderer.hpp"
 // Standard C++ library
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
-#include <cstring>
 #include <string>
 #include <string_view>
 // Qt
+#include <QImage>
 #include <QObject>
 #include <QString>
+#include <QVariant>
+#include <QVector3D>
 // Zisc
 #include "zisc/error.hpp"
+#include "zisc/math.hpp"
 #include "zisc/stopwatch.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "camera_event.hpp"
 #include "cui_renderer.hpp"
@@ -26,50 +33,128 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/scene.hpp"
 #include "NanairoCore/system.hpp"
-#include "NanairoCore/CameraModel/camera_model.hpp"
 #include "NanairoCore/CameraModel/film.hpp"
+#include "NanairoCore/Color/color_space.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/RenderingMethod/rendering_method.hpp"
+#include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
+#include "NanairoGui/nanairo_gui_config.hpp"
+#include "NanairoGui/rendered_image_provider.hpp"
 
 namespace nanairo {
 
 /*!
   */
 GuiRenderer::GuiRenderer(const RenderingMode mode) noexcept :
-    mode_{mode}
+    image_provider_{nullptr},
+    mode_{mode},
+    display_index_{0}
 {
   initialize();
 }
 
 /*!
+  \details
+  The provider refers to the display buffers,
+  so the last image is copied before the buffers are freed.
+  */
+GuiRenderer::~GuiRenderer() noexcept
+{
+  if (image_provider_ != nullptr)
+    image_provider_->setImage(image_provider_->image().copy());
+}
+
+/*!
+  \details
+  The tone curve is the index of the curve in the shader,
+  and the luminance weights are the Y row of the RGB to XYZ matrix
+  of the color space, so the viewport maps the luminance as the CPU does.
+  */
+QVariantMap GuiRenderer::displayParameters() const noexcept
+{
+  const auto& tone_mapping = system().toneMappingOperator();
+  int tone_curve = 0;
+  switch (tone_mapping.type()) {
+   case ToneMappingType::kReinhard:
+    tone_curve = 0;
+    break;
+   case ToneMappingType::kFilmic:
+    tone_curve = 1;
+    break;
+   case ToneMappingType::kUncharted2Filmic:
+    tone_curve = 2;
+    break;
+   default:
+    zisc::raiseError("GuiRendererError: Unsupported tone mapping is specified.");
+    break;
+  }
+  const auto to_xyz_matrix = getRgbToXyzMatrix(system().colorSpace());
+  const QVector3D luminance_weights{zisc::cast<float>(to_xyz_matrix(1, 0)),
+                                    zisc::cast<float>(to_xyz_matrix(1, 1)),
+                                    zisc::cast<float>(to_xyz_matrix(1, 2))};
+
+  QVariantMap parameters;
+  parameters["toneCurve"] = tone_curve;
+  parameters["exposure"] = zisc::cast<double>(tone_mapping.exposure());
+  parameters["inverseGamma"] = zisc::cast<double>(tone_mapping.inverseGamma());
+  parameters["luminanceWeights"] = luminance_weights;
+  return parameters;
+}
+
+/*!
+  \details
+  The mantissas are truncated like the Radiance format,
+  and the shader decodes them by the centers of the levels.
+  The alpha of zero means black.
+  */
+Rgba32 GuiRenderer::encodeRgbe(const std::array<float, 3>& rgb) noexcept
+{
+  constexpr uint8 zero = 0;
+  const float m = zisc::max(rgb[0], zisc::max(rgb[1], rgb[2]));
+  // NaN is also black
+  if (!(1.0e-32f < m))
+    return Rgba32{zero, zero, zero, zero};
+
+  int e = 0;
+  const float f = std::frexp(m, &e);
+  e = zisc::min(e, 127);
+  const float k = f * 256.0f / m;
+  auto encode = [k](const float c) noexcept
+  {
+    return zisc::cast<uint8>(zisc::min(zisc::max(c, 0.0f) * k, 255.0f));
+  };
+  return Rgba32{encode(rgb[0]), encode(rgb[1]), encode(rgb[2]),
+                zisc::cast<uint8>(e + 128)};
+}
+
+/*!
+  \details
+  The events which arrive during a cycle are merged into the next cycle,
+  so the rendering restarts at most once per cycle.
+  The film is cleared lazily, so a restart doesn't touch the whole film.
   */
 void GuiRenderer::handleCameraEvent(uint32* cycle,
                                     Clock::duration* time) noexcept
 {
-  auto& camera_event = cameraEvent();
-  if (camera_event.isEventOccured()) {
-    auto& camera = scene().camera();
-    // Transform camera
-    if (camera_event.isHorizontalTranslationEventOccured()) {
-      const auto value = camera_event.flushHorizontalTranslationEvent();
-      camera.translateHorizontally(value);
-    }
-    if (camera_event.isVerticalTranslationEventOccured()) {
-      const auto value = camera_event.flushVerticalTranslationEvent();
-      camera.translateVertically(value);
-    }
-    if (camera_event.isRotationEventOccured()) {
-      const auto value = camera_event.flushRotationEvent();
-      camera.rotate(value);
+  if (transformCamera(&cameraEvent())) {
+    last_camera_event_time_ = Clock::now();
+    // Render the low resolution preview while the camera is moving
+    const bool preview_is_available =
+        (mode_ == RenderingMode::kPreviewing) &&
+        (1 < GuiConfig::previewResolutionScale()) &&
+        renderingMethod().isPreviewSupported();
+    if (preview_is_available)
+      setLowResolutionPreview(true);
+    restartRendering(cycle, time);
+  }
+  else if (isLowResolutionPreview()) {
+    constexpr std::chrono::milliseconds idle_time{GuiConfig::previewIdleTime()};
+    if (idle_time <= (Clock::now() - last_camera_event_time_)) {
+      setLowResolutionPreview(false);
+      restartRendering(cycle, time);
     }
-    // Reset rendering info
-    initForRendering();
-    ZISC_ASSERT(cycle != nullptr, "The cycle is null.");
-    ZISC_ASSERT(time != nullptr, "The time is null.");
-    auto& stopwatch = system().stopwatch();
-    stopwatch.stop();
-    stopwatch.start();
-    *cycle = 0;
-    *time = Clock::duration::zero();
   }
 }
 
@@ -77,31 +162,117 @@ void GuiRenderer::handleCameraEvent(uint32* cycle,
   */
 void GuiRenderer::initialize() noexcept
 {
+  enableLinearImageDisplay(true);
   if (mode_ == RenderingMode::kPreviewing)
-    enableSavingAtEachCycle(true);
+    enableSavingAtEachFrame(true);
 }
 
 /*!
   */
-void GuiRenderer::outputLdrImage(const std::string_view output_path,
-                                 const uint32 cycle,
-                                 const std::string_view suffix) noexcept
+bool GuiRenderer::isLowResolutionPreview() const noexcept
 {
-  const auto& ldr_image_helper = ldrImageHelper();
+  return 1 < renderingMethod().previewScale();
+}
 
-  // Copy image
-  const auto& ldr_image = ldrImage();
-  auto data = const_cast<uint8*>(ldr_image_helper.constBits());
-  const std::size_t memory_size = sizeof(ldr_image[0]) * ldr_image.size();
-  std::memcpy(data, ldr_image.data().data(), memory_size);
+/*!
+  \details
+  The bytes of the buffer are uploaded to the texture as they are,
+  since QImage doesn't convert the premultiplied format for the scene graph.
+  The color isn't premultiplied actually, the shader reads the raw bytes.
+  */
+QImage GuiRenderer::makeDisplayQImage(const LdrImage& display_image) noexcept
+{
+  const auto data = zisc::treatAs<const uchar*>(display_image.data().data());
+  const int width = zisc::cast<int>(display_image.widthResolution());
+  const int height = zisc::cast<int>(display_image.heightResolution());
+  const int bytes_per_line = zisc::cast<int>(sizeof(display_image[0])) * width;
+  return QImage{data, width, height, bytes_per_line,
+                QImage::Format_ARGB32_Premultiplied};
+}
 
-  if (mode_ == RenderingMode::kRendering) {
-    const auto ldr_path = makeImagePath(output_path, cycle, suffix);
+/*!
+  */
+void GuiRenderer::setImageProvider(RenderedImageProvider* image_provider) noexcept
+{
+  ZISC_ASSERT(image_provider != nullptr, "The image provider is null.");
+  // The display buffers are allocated from the same resource as the snapshot
+  auto& data_resource = system().dataMemoryManager();
+  const auto& resolution = ldrImage().resolution();
+  for (auto& display_image : display_image_list_) {
+    display_image = zisc::UniqueMemoryPointer<LdrImage>::make(&data_resource,
+                                                              resolution,
+                                                              &data_resource);
+    display_image->setChannelOrder(ldrChannelOrder());
+  }
+  display_index_ = 0;
+  image_provider_ = image_provider;
+  image_provider_->setImage(makeDisplayQImage(*display_image_list_[0]));
+}
+
+/*!
+  */
+void GuiRenderer::setLowResolutionPreview(const bool flag) noexcept
+{
+  constexpr uint scale = zisc::cast<uint>(GuiConfig::previewResolutionScale());
+  renderingMethod().setPreviewScale(flag ? scale : 1);
+}
 
-    const bool result = ldr_image_helper.save(QString{ldr_path.c_str()});
-    if (!result)
-      logMessage("QImage error: saving image failed: " + ldr_path);
+/*!
+  \details
+  The preview doesn't save images.
+  */
+void GuiRenderer::outputHdrImage(
+    const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+    const std::string_view output_path,
+    const uint32 cycle,
+    const std::string_view suffix) noexcept
+{
+  if (mode_ == RenderingMode::kRendering)
+    CuiRenderer::outputHdrImage(rgb_image, output_path, cycle, suffix);
+}
+
+/*!
+  \details
+  The display buffer which is displayed now is kept for the QML thread,
+  so the image is encoded into the other one.
+  The preview is upsampled by the first pixel of each block.
+  */
+void GuiRenderer::outputDisplayImage(
+    const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+    const uint32 cycle) noexcept
+{
+  static_cast<void>(cycle);
+  ZISC_ASSERT(image_provider_ != nullptr, "The image provider is null.");
+  display_index_ = (display_index_ == 0) ? 1 : 0;
+  auto& display_image = *display_image_list_[display_index_];
+
+  const uint scale = renderingMethod().previewScale();
+  const uint width = display_image.widthResolution();
+  const uint height = display_image.heightResolution();
+  ZISC_ASSERT(rgb_image.size() == (width * height),
+              "The resolutions of the images are different.");
+  for (uint y = 0; y < height; ++y) {
+    const uint src_y = y - (y % scale);
+    for (uint x = 0; x < width; ++x) {
+      const uint src_x = x - (x % scale);
+      display_image.set(x, y, encodeRgbe(rgb_image[src_x + src_y * width]));
+    }
   }
+  image_provider_->setImage(makeDisplayQImage(display_image));
+}
+
+/*!
+  \details
+  The viewport displays the linear RGB image,
+  so the LDR image is only saved. The preview doesn't save images.
+  */
+void GuiRenderer::outputLdrImage(LdrImage* ldr_image,
+                                 const std::string_view output_path,
+                                 const uint32 cycle,
+                                 const std::string_view suffix) noexcept
+{
+  if (mode_ == RenderingMode::kRendering)
+    CuiRenderer::outputLdrImage(ldr_image, output_path, cycle, suffix);
 }
 
 } // namespace nanairo
@@ -11,27 +11,49 @@
 #define NANAIRO_GUI_RENDERER_HPP
 
 // Standard C++ library
+#include <array>
 #include <string>
 #include <string_view>
 // Qt
+#include <QImage>
 #include <QObject>
+#include <QVariant>
 // Zisc
+#include "zisc/memory_resource.hpp"
 #include "zisc/stopwatch.hpp"
+#include "zisc/unique_memory_pointer.hpp"
 // Nanairo
 #include "camera_event.hpp"
 #include "cui_renderer.hpp"
 #include "simple_renderer.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+#include "NanairoGui/nanairo_gui_config.hpp"
 
 // Forward declaration
 class QString;
 
 namespace nanairo {
 
+// Forward declaration
+class RenderedImageProvider;
+
 //! \addtogroup Gui
 //! \{
 
 /*!
+  \details
+  While the camera events keep arriving, the previewing renderer renders
+  the scene in the low resolution with the direct lighting only,
+  and the image is upsampled. Rendering restarts in the full resolution
+  after the camera is idle for GuiConfig::previewIdleTime().
+  The linear RGB snapshot is displayed instead of the LDR snapshot,
+  and the viewport applies the exposure, the tone curve and the gamma
+  in a shader. The snapshot is encoded into one of the two display buffers
+  in the shared exponent format (RGBE), since the QImage of Qt 5.12 has
+  no floating point format. The other buffer is kept
+  for the QML thread which may still read the previous image.
   */
 class GuiRenderer : public QObject, public CuiRenderer
 {
@@ -49,6 +71,9 @@ class GuiRenderer : public QObject, public CuiRenderer
   //! Create a renderer
   GuiRenderer(const RenderingMode mode) noexcept;
 
+  //! Keep the last image in the image provider
+  ~GuiRenderer() noexcept override;
+
 
   //! Return the camera event of the renderer
   CameraEvent& cameraEvent() noexcept;
@@ -56,22 +81,55 @@ class GuiRenderer : public QObject, public CuiRenderer
   //! Return the camera event of the renderer
   const CameraEvent& cameraEvent() const noexcept;
 
+  //! Return the parameters of the tone mapping shader of the viewport
+  QVariantMap displayParameters() const noexcept;
+
+  //! Set the image provider which displays the rendered images
+  void setImageProvider(RenderedImageProvider* image_provider) noexcept;
+
  private:
   //! Handle camera event
   void handleCameraEvent(uint32* cycle,
                          Clock::duration* time) noexcept override;
 
+  //! Encode a linear RGB color into the shared exponent format
+  static Rgba32 encodeRgbe(const std::array<float, 3>& rgb) noexcept;
+
   //! Initialize the renderer
   void initialize() noexcept;
 
+  //! Check if the renderer is rendering the low resolution preview
+  bool isLowResolutionPreview() const noexcept;
+
+  //! Make a QImage which refers to the RGBE display buffer
+  static QImage makeDisplayQImage(const LdrImage& display_image) noexcept;
+
+  //! Enable or disable the low resolution preview
+  void setLowResolutionPreview(const bool flag) noexcept;
+
+  //! Display the linear RGB image
+  void outputDisplayImage(const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+                          const uint32 cycle) noexcept override;
+
+  //! Output HDR image
+  void outputHdrImage(const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+                      const std::string_view output_path,
+                      const uint32 cycle,
+                      const std::string_view suffix = "") noexcept override;
+
   //! Output LDR image
-  void outputLdrImage(const std::string_view output_path,
+  void outputLdrImage(LdrImage* ldr_image,
+                      const std::string_view output_path,
                       const uint32 cycle,
                       const std::string_view suffix = "") noexcept override;
 
 
   CameraEvent camera_event_;
+  std::array<zisc::UniqueMemoryPointer<LdrImage>, 2> display_image_list_;
+  Clock::time_point last_camera_event_time_;
+  RenderedImageProvider* image_provider_;
   RenderingMode mode_;
+  uint8 display_index_;
 };
 
 //! \} Gui
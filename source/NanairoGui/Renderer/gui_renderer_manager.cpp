@@ -14,12 +14,10 @@
 #include <memory>
 #include <utility>
 // Qt
-#include <QColor>
 #include <QFileInfo>
 #include <QFont>
 #include <QFontDatabase>
 #include <QDir>
-#include <QImage>
 #include <QJsonObject>
 #include <QObject>
 #include <QScopedPointer>
@@ -183,16 +181,8 @@ void GuiRendererManager::invokeRendering(const QVariant& scene_data,
     // Start rendering 
     if (renderer->isRunnable()) {
       // Init image
-      {
-        const auto& ldr_image = renderer->ldrImage();
-        auto image_provider = renderedImageProvider();
-        auto& image = image_provider->image();
-        image = QImage{static_cast<int>(ldr_image.widthResolution()),
-                       static_cast<int>(ldr_image.heightResolution()),
-                       QImage::Format_RGB32};
-        image.fill(QColor::fromRgb(0, 0, 0));
-        renderer->setImage(&image);
-      }
+      renderer->setImageProvider(renderedImageProvider());
+      emit notifyOfDisplayParameters(renderer->displayParameters());
 
       // Connect a renderer with this manager
       auto notify_of_progress =
@@ -273,6 +263,16 @@ void GuiRendererManager::connectWithRenderer(GuiRenderer* renderer) noexcept
     };
     connect(this, &GuiRendererManager::previewEvent, handle_camera_event);
   }
+  {
+    auto change_num_of_active_threads = [renderer](const int num_of_threads)
+    {
+      ZISC_ASSERT(renderer != nullptr, "The renderer is nulll.");
+      const uint n = zisc::cast<uint>(zisc::max(num_of_threads, 1));
+      renderer->requestNumOfActiveThreads(n);
+    };
+    connect(this, &GuiRendererManager::changeNumOfActiveThreads,
+            change_num_of_active_threads);
+  }
 }
 
 /*!
@@ -281,6 +281,7 @@ void GuiRendererManager::disconnectFromRenderer() noexcept
 {
   disconnect(this, &GuiRendererManager::stopRendering, nullptr, nullptr);
   disconnect(this, &GuiRendererManager::previewEvent, nullptr, nullptr);
+  disconnect(this, &GuiRendererManager::changeNumOfActiveThreads, nullptr, nullptr);
 }
 
 /*!
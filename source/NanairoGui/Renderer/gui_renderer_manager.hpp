@@ -90,6 +90,9 @@ class GuiRendererManager : public QObject, public CuiRendererManager
   void setRenderedImageProvider(RenderedImageProvider* image_provider) noexcept;
 
  signals:
+  //! Called when the number of the rendering threads is to be changed
+  void changeNumOfActiveThreads(const int num_of_threads) const;
+
   //! Notify that rendering is finished
   void finished() const;
 
@@ -104,6 +107,9 @@ class GuiRendererManager : public QObject, public CuiRendererManager
                     const int axis_event_type,
                     const int value) const;
 
+  //! Notify of the tone mapping parameters of the viewport
+  void notifyOfDisplayParameters(const QVariantMap& parameters) const;
+
   //! Notify of updating rendering progress
   void notifyOfRenderingProgress(const double progress,
                                  const QString& status) const;
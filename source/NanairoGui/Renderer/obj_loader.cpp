@@ -9,35 +9,57 @@
 
 #include "obj_loader.hpp"
 // Standard C++ library
+#include <algorithm>
 #include <array>
-#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <thread>
 #include <utility>
+#include <vector>
 // Qt
-#include <QString>
-#include <QTextStream>
 #include <QtGlobal>
 // Zisc
-#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/error.hpp"
 #include "zisc/memory_resource.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/face.hpp"
-#include "NanairoGui/keyword.hpp"
+#include "NanairoCore/Utility/mapped_file.hpp"
 
 namespace nanairo  {
 
+namespace {
+
+/*!
+  \details
+  Return the end of the line which begins at the position.
+  */
+inline
+const char* findLineEnd(const char* position, const char* end) noexcept
+{
+  auto line_end = zisc::cast<const char*>(
+      std::memchr(position, '\n', zisc::cast<std::size_t>(end - position)));
+  return (line_end != nullptr) ? line_end : end;
+}
+
+} // namespace
+
 /*!
+  \details
+  The elements are counted in the first pass, then each chunk writes
+  its elements into the lists at the offsets of the chunk directly.
   */
 void ObjLoader::parse(
-    QTextStream& obj_stream,
+    const MappedFile& obj_file,
     zisc::pmr::vector<Face>* face_list,
     zisc::pmr::vector<std::array<double, 3>>* vertex_list,
     zisc::pmr::vector<std::array<double, 3>>* vnormal_list,
     zisc::pmr::vector<std::array<double, 2>>* vuv_list) noexcept
 {
-  ZISC_ASSERT(obj_stream.device() != nullptr, "The obj_stream isn't initialized.");
+  ZISC_ASSERT(obj_file.isOpen(), "The obj_file isn't opened.");
   ZISC_ASSERT(face_list != nullptr, "The face_list is null.");
   ZISC_ASSERT(vertex_list != nullptr, "The vertex_list is null.");
   ZISC_ASSERT(vnormal_list != nullptr, "The vnormal_list is null.");
@@ -47,173 +69,260 @@ void ObjLoader::parse(
   vnormal_list->clear();
   vuv_list->clear();
 
+  const auto data = zisc::cast<const char*>(
+      zisc::cast<const void*>(obj_file.data()));
+  auto chunk_list = splitIntoChunks(data, obj_file.size());
+
   // Count elements
-  obj_stream.seek(0);
-  const auto counts = countNumOfMeshes(obj_stream);
+  runInParallel(&chunk_list, [](Chunk* chunk)
+  {
+    countNumOfMeshes(chunk);
+  });
+  std::array<uint, 4> counts{{0, 0, 0, 0}};
+  bool smoothing = false;
+  for (auto& chunk : chunk_list) {
+    chunk.offsets_ = counts;
+    for (std::size_t i = 0; i < counts.size(); ++i)
+      counts[i] += chunk.counts_[i];
+    chunk.begin_smoothing_ = smoothing;
+    if (chunk.has_smoothing_)
+      smoothing = chunk.end_smoothing_;
+  }
   if (counts[0] == 0)
     qFatal("The num of faces is 0.");
-  face_list->reserve(counts[0]);
-  vertex_list->reserve(counts[1]);
-  vnormal_list->reserve(counts[2]);
-  vuv_list->reserve(counts[3]);
+  face_list->resize(counts[0]);
+  vertex_list->resize(counts[1]);
+  vnormal_list->resize(counts[2]);
+  vuv_list->resize(counts[3]);
 
   // Make meshes
-  obj_stream.seek(0);
-  loadMesh(obj_stream, face_list, vertex_list, vnormal_list, vuv_list);
+  runInParallel(&chunk_list, [face_list, vertex_list, vnormal_list, vuv_list]
+  (Chunk* chunk)
+  {
+    loadMesh(*chunk, face_list, vertex_list, vnormal_list, vuv_list);
+  });
 }
 
 /*!
   */
-std::array<uint, 4> ObjLoader::countNumOfMeshes(QTextStream& obj_stream) noexcept
+void ObjLoader::countNumOfMeshes(Chunk* chunk) noexcept
 {
   uint num_of_faces = 0;
   uint num_of_vertices = 0;
   uint num_of_vnormals = 0; // Vertex normals
   uint num_of_vuv = 0; // Vertex texture uv
-  QString value;
-  for (QString line; obj_stream.readLineInto(&line);) {
-    // Skip a empty line
-    if (line.isEmpty())
-      continue;
-
+  const char* chunk_end = chunk->end_;
+  for (const char* line = chunk->begin_; line < chunk_end;) {
+    const char* line_end = findLineEnd(line, chunk_end);
     // Check a keyword
-    QTextStream buffer{&line, QIODevice::ReadOnly | QIODevice::Text};
-    buffer >> value;
+    const auto value = readToken(&line, line_end);
     // Count
-    switch (keyword::Fnv1aHash32::hash(value)) {
-     case zisc::Fnv1aHash32::hash("v"): {
+    if (value == "v") {
       ++num_of_vertices;
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("vn"): {
+    }
+    else if (value == "vn") {
       ++num_of_vnormals;
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("vt"): {
+    }
+    else if (value == "vt") {
       ++num_of_vuv;
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("f"): {
+    }
+    else if (value == "f") {
       ++num_of_faces;
-      break;
-     }
-     default:
-      break;
     }
+    else if (value == "s") {
+      chunk->has_smoothing_ = true;
+      chunk->end_smoothing_ = readToken(&line, line_end) == "1";
+    }
+    line = zisc::min(line_end + 1, chunk_end);
   }
-  return std::array<uint, 4>{{num_of_faces,
-                              num_of_vertices,
-                              num_of_vnormals,
-                              num_of_vuv}};
+  chunk->counts_ = std::array<uint, 4>{{num_of_faces,
+                                        num_of_vertices,
+                                        num_of_vnormals,
+                                        num_of_vuv}};
 }
 
 /*!
+  \details
+  A vertex of a face is written as "v", "v/vt", "v//vn" or "v/vt/vn".
   */
-void ObjLoader::loadFace(QTextStream& face_line,
+void ObjLoader::loadFace(const char* position,
+                         const char* end,
                          const bool has_vnormal,
                          const bool has_vuv,
                          const bool smoothing,
                          Face* face) noexcept
 {
-  char delimiter;
-  uint vertex_indices[3];
-  uint vnormal_indices[3];
-  uint vuv_indices[3];
+  std::array<uint32, 3> vertex_indices;
+  std::array<uint32, 3> vnormal_indices;
+  std::array<uint32, 3> vuv_indices;
   for (uint i = 0; i < 3; ++i) {
-    if (has_vnormal && has_vuv) {
-      face_line >> vertex_indices[i] >> delimiter
-                >> vuv_indices[i] >> delimiter
-                >> vnormal_indices[i];
-    }
-    else if (has_vnormal && !has_vuv) {
-      face_line >> vertex_indices[i] >> delimiter >> delimiter
-                >> vnormal_indices[i];
-    }
-    else if (!has_vnormal && has_vuv) {
-      face_line >> vertex_indices[i] >> delimiter >> vuv_indices[i];
-    }
-    else {
-      face_line >> vertex_indices[i];
-    }
+    auto token = readToken(&position, end);
+    const auto p0 = token.find('/');
+    vertex_indices[i] = toIndex(token.substr(0, p0));
+    token = (p0 != std::string_view::npos) ? token.substr(p0 + 1)
+                                           : std::string_view{};
+    const auto p1 = token.find('/');
+    vuv_indices[i] = toIndex(token.substr(0, p1));
+    token = (p1 != std::string_view::npos) ? token.substr(p1 + 1)
+                                           : std::string_view{};
+    vnormal_indices[i] = toIndex(token);
   }
 
-  face->setVertexIndices(zisc::cast<uint32>(vertex_indices[0] - 1),
-                         zisc::cast<uint32>(vertex_indices[1] - 1),
-                         zisc::cast<uint32>(vertex_indices[2] - 1));
+  face->setVertexIndices(vertex_indices[0], vertex_indices[1], vertex_indices[2]);
 
   face->setSmoothing(smoothing);
-  if (has_vnormal) {
-    face->setVnormalIndices(zisc::cast<uint32>(vnormal_indices[0] - 1),
-                            zisc::cast<uint32>(vnormal_indices[1] - 1),
-                            zisc::cast<uint32>(vnormal_indices[2] - 1));
-  }
-  if (has_vuv) {
-    face->setVuvIndices(zisc::cast<uint32>(vuv_indices[0] - 1),
-                        zisc::cast<uint32>(vuv_indices[1] - 1),
-                        zisc::cast<uint32>(vuv_indices[2] - 1));
-  }
+  if (has_vnormal)
+    face->setVnormalIndices(vnormal_indices[0], vnormal_indices[1], vnormal_indices[2]);
+  if (has_vuv)
+    face->setVuvIndices(vuv_indices[0], vuv_indices[1], vuv_indices[2]);
 }
 
 /*!
   */
-void ObjLoader::loadMesh(QTextStream& obj_stream,
+void ObjLoader::loadMesh(const Chunk& chunk,
                          zisc::pmr::vector<Face>* face_list,
                          zisc::pmr::vector<std::array<double, 3>>* vertex_list,
                          zisc::pmr::vector<std::array<double, 3>>* vnormal_list,
                          zisc::pmr::vector<std::array<double, 2>>* vuv_list) noexcept
 {
-  bool smoothing = false;
-  QString value;
-  for (QString line; obj_stream.readLineInto(&line);) {
-    // Skip a empty line
-    if (line.isEmpty())
-      continue;
-
+  uint face_index = chunk.offsets_[0];
+  uint vertex_index = chunk.offsets_[1];
+  uint vnormal_index = chunk.offsets_[2];
+  uint vuv_index = chunk.offsets_[3];
+  bool smoothing = chunk.begin_smoothing_;
+  const char* chunk_end = chunk.end_;
+  for (const char* line = chunk.begin_; line < chunk_end;) {
+    const char* line_end = findLineEnd(line, chunk_end);
     // Check a keyword
-    QTextStream buffer{&line, QIODevice::ReadOnly | QIODevice::Text};
-    buffer >> value;
-    // Count
-    switch (keyword::Fnv1aHash32::hash(value)) {
-     case zisc::Fnv1aHash32::hash("s"): {
-      buffer >> value;
-      smoothing = (value == "1");
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("v"): {
-      double v0 = 0.0,
-             v1 = 0.0,
-             v2 = 0.0;
-      buffer >> v0 >> v1 >> v2;
-      vertex_list->emplace_back(std::array<double, 3>{{v0, v1, v2}});
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("vn"): {
-      double n0 = 0.0,
-             n1 = 0.0,
-             n2 = 0.0;
-      buffer >> n0 >> n1 >> n2;
-      vnormal_list->emplace_back(std::array<double, 3>{{n0, n1, n2}});
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("vt"): {
-      double u = 0.0,
-             v = 0.0;
-      buffer >> u >> v;
-      vuv_list->emplace_back(std::array<double, 2>{{u, v}});
-      break;
-     }
-     case zisc::Fnv1aHash32::hash("f"): {
-      const bool has_vnormal = (0 < vnormal_list->size());
-      const bool has_vuv = (0 < vuv_list->size());
-      face_list->emplace_back();
-      auto& face = face_list->back();
-      loadFace(buffer, has_vnormal, has_vuv, smoothing, &face);
-      break;
-     }
-     default:
-      break;
+    const auto value = readToken(&line, line_end);
+    if (value == "s") {
+      smoothing = readToken(&line, line_end) == "1";
+    }
+    else if (value == "v") {
+      auto& vertex = (*vertex_list)[vertex_index++];
+      for (auto& v : vertex)
+        v = toFloat(readToken(&line, line_end));
+    }
+    else if (value == "vn") {
+      auto& vnormal = (*vnormal_list)[vnormal_index++];
+      for (auto& n : vnormal)
+        n = toFloat(readToken(&line, line_end));
     }
+    else if (value == "vt") {
+      auto& vuv = (*vuv_list)[vuv_index++];
+      for (auto& uv : vuv)
+        uv = toFloat(readToken(&line, line_end));
+    }
+    else if (value == "f") {
+      // The index of a element is the number of the elements before it
+      const bool has_vnormal = (0 < vnormal_index);
+      const bool has_vuv = (0 < vuv_index);
+      auto& face = (*face_list)[face_index++];
+      loadFace(line, line_end, has_vnormal, has_vuv, smoothing, &face);
+    }
+    line = zisc::min(line_end + 1, chunk_end);
+  }
+}
+
+/*!
+  */
+inline
+constexpr std::size_t ObjLoader::minChunkSize() noexcept
+{
+  return zisc::cast<std::size_t>(1) << 20;
+}
+
+/*!
+  */
+std::string_view ObjLoader::readToken(const char** position,
+                                      const char* end) noexcept
+{
+  auto is_space = [](const char c)
+  {
+    return (c == ' ') || (c == '\t') || (c == '\r');
+  };
+  const char* begin = *position;
+  for (; (begin < end) && is_space(*begin); ++begin);
+  const char* token_end = begin;
+  for (; (token_end < end) && !is_space(*token_end); ++token_end);
+  *position = token_end;
+  return std::string_view{begin, zisc::cast<std::size_t>(token_end - begin)};
+}
+
+/*!
+  \details
+  The first chunk is parsed on the calling thread.
+  */
+template <typename Function> inline
+void ObjLoader::runInParallel(std::vector<Chunk>* chunk_list,
+                              Function&& func) noexcept
+{
+  std::vector<std::thread> worker_list;
+  worker_list.reserve(chunk_list->size() - 1);
+  for (std::size_t i = 1; i < chunk_list->size(); ++i)
+    worker_list.emplace_back(func, &(*chunk_list)[i]);
+  func(&(*chunk_list)[0]);
+  for (auto& worker : worker_list)
+    worker.join();
+}
+
+/*!
+  */
+auto ObjLoader::splitIntoChunks(const char* data,
+                                const std::size_t size) noexcept
+    -> std::vector<Chunk>
+{
+  const std::size_t num_of_threads =
+      zisc::max(zisc::cast<std::size_t>(std::thread::hardware_concurrency()),
+                zisc::cast<std::size_t>(1));
+  const std::size_t num_of_chunks =
+      zisc::clamp(size / minChunkSize(), zisc::cast<std::size_t>(1),
+                  num_of_threads);
+  const std::size_t chunk_size = size / num_of_chunks;
+
+  std::vector<Chunk> chunk_list;
+  chunk_list.reserve(num_of_chunks);
+  const char* end = data + size;
+  for (const char* begin = data; begin < end;) {
+    // Each chunk ends at a line boundary
+    const char* chunk_end = (chunk_list.size() + 1 < num_of_chunks)
+        ? findLineEnd(zisc::min(begin + chunk_size, end), end)
+        : end;
+    chunk_end = zisc::min(chunk_end + 1, end);
+    chunk_list.emplace_back(Chunk{begin, chunk_end,
+                                  {{0, 0, 0, 0}}, {{0, 0, 0, 0}},
+                                  false, false, false});
+    begin = chunk_end;
   }
+  if (chunk_list.empty())
+    chunk_list.emplace_back(Chunk{end, end, {{0, 0, 0, 0}}, {{0, 0, 0, 0}},
+                                  false, false, false});
+  return chunk_list;
+}
+
+/*!
+  \details
+  The token is copied, since the mapped data isn't null terminated.
+  */
+double ObjLoader::toFloat(const std::string_view& token) noexcept
+{
+  std::array<char, 64> buffer;
+  const std::size_t length = zisc::min(token.size(), buffer.size() - 1);
+  std::copy_n(token.data(), length, buffer.data());
+  buffer[length] = '\0';
+  return std::strtod(buffer.data(), nullptr);
+}
+
+/*!
+  */
+uint32 ObjLoader::toIndex(const std::string_view& token) noexcept
+{
+  std::array<char, 16> buffer;
+  const std::size_t length = zisc::min(token.size(), buffer.size() - 1);
+  std::copy_n(token.data(), length, buffer.data());
+  buffer[length] = '\0';
+  const auto index = std::strtoul(buffer.data(), nullptr, 10);
+  return zisc::cast<uint32>(index - 1);
 }
 
 } // namespace nanairo
@@ -12,6 +12,8 @@
 
 // Standard C++ library
 #include <array>
+#include <cstddef>
+#include <string_view>
 #include <vector>
 // Zisc
 #include "zisc/memory_resource.hpp"
@@ -19,49 +21,91 @@
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Data/face.hpp"
 
-// Forward declaration
-class QTextStream;
-
 namespace nanairo {
 
+// Forward declaration
+class MappedFile;
+
 //! \addtogroup Gui
 //! \{
 
 /*!
+  \details
+  A obj file is split into chunks at line boundaries and
+  the chunks are parsed on worker threads.
   */
 class ObjLoader
 {
  public:
-  //! Parse a obj text and make a obj model
-  static void parse(QTextStream& obj_stream,
+  //! Parse a obj file and make a obj model
+  static void parse(const MappedFile& obj_file,
                     zisc::pmr::vector<Face>* face_list,
                     zisc::pmr::vector<std::array<double, 3>>* vertex_list,
                     zisc::pmr::vector<std::array<double, 3>>* vnormal_list,
                     zisc::pmr::vector<std::array<double, 2>>* vuv_list) noexcept;
 
  private:
+  /*!
+    \details
+    The counts are in the order of faces, vertices, vnormals and vuvs.
+    */
+  struct Chunk
+  {
+    const char* begin_;
+    const char* end_;
+    std::array<uint, 4> counts_; //!< The number of elements in the chunk
+    std::array<uint, 4> offsets_; //!< The number of elements before the chunk
+    bool has_smoothing_; //!< The chunk has a smoothing group line
+    bool begin_smoothing_; //!< The smoothing at the beginning of the chunk
+    bool end_smoothing_; //!< The smoothing at the end of the chunk
+  };
+
+
   //! Prevent from making a obj loader instance
   ObjLoader() noexcept;
   ObjLoader(const ObjLoader&) = delete;
   ObjLoader& operator=(const ObjLoader&) = delete;
 
 
-  //! Count the number of meshes
-  static std::array<uint, 4> countNumOfMeshes(QTextStream& obj_stream) noexcept;
+  //! Count the number of meshes in the chunk
+  static void countNumOfMeshes(Chunk* chunk) noexcept;
 
   //! Load the face data
-  static void loadFace(QTextStream& face_line,
+  static void loadFace(const char* position,
+                       const char* end,
                        const bool has_vnormal,
                        const bool has_vuv,
                        const bool smoothing,
                        Face* face) noexcept;
 
-  //! Load the mesh data
-  static void loadMesh(QTextStream& obj_stream,
+  //! Load the mesh data of the chunk
+  static void loadMesh(const Chunk& chunk,
                        zisc::pmr::vector<Face>* face_list,
                        zisc::pmr::vector<std::array<double, 3>>* vertex_list,
                        zisc::pmr::vector<std::array<double, 3>>* vnormal_list,
                        zisc::pmr::vector<std::array<double, 2>>* vuv_list) noexcept;
+
+  //! Return the minimum size of a chunk in bytes
+  static constexpr std::size_t minChunkSize() noexcept;
+
+  //! Read the next token of the line
+  static std::string_view readToken(const char** position,
+                                    const char* end) noexcept;
+
+  //! Run the function on each chunk in parallel
+  template <typename Function>
+  static void runInParallel(std::vector<Chunk>* chunk_list,
+                            Function&& func) noexcept;
+
+  //! Split the data into chunks at the line boundaries
+  static std::vector<Chunk> splitIntoChunks(const char* data,
+                                            const std::size_t size) noexcept;
+
+  //! Convert the token into a float
+  static double toFloat(const std::string_view& token) noexcept;
+
+  //! Convert the token into a zero based index
+  static uint32 toIndex(const std::string_view& token) noexcept;
 };
 
 //! \} Gui
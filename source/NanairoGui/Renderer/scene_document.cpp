@@ -69,7 +69,7 @@ bool SceneDocument::loadDocument(const QString& file_path,
 
   // Open a scene document
   QFile json_file{file_path};
-  const bool is_open = json_file.open(QIODevice::ReadOnly | QIODevice::Text);
+  const bool is_open = json_file.open(QIODevice::ReadOnly);
   if (!is_open) {
     error_message = QStringLiteral("File cann't open: ") + file_path;
     return false;
@@ -77,7 +77,21 @@ bool SceneDocument::loadDocument(const QString& file_path,
 
   // Parse a scene document
   QJsonParseError parse_result;
-  auto&& document = QJsonDocument::fromJson(json_file.readAll(), &parse_result);
+  QJsonDocument document;
+  {
+    // The document is parsed from the mapped pages instead of a copy of the file
+    const qint64 file_size = json_file.size();
+    auto data = (0 < file_size) ? json_file.map(0, file_size) : nullptr;
+    if (data != nullptr) {
+      const auto json = QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                                static_cast<int>(file_size));
+      document = QJsonDocument::fromJson(json, &parse_result);
+      json_file.unmap(data);
+    }
+    else {
+      document = QJsonDocument::fromJson(json_file.readAll(), &parse_result);
+    }
+  }
   const bool is_no_error = (parse_result.error == QJsonParseError::NoError);
   if (!is_no_error) {
     error_message = QStringLiteral("Scenen parse failed: ") +
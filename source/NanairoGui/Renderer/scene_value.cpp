@@ -14,6 +14,7 @@
 #include <tuple>
 #include <vector>
 // Qt
+#include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
 #include <QImage>
@@ -29,13 +30,16 @@
 #include "zisc/unit.hpp"
 // Nanairo
 #include "obj_loader.hpp"
+#include "scene_value_cache.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Color/color_space.hpp"
 #include "NanairoCore/Color/rgba_32.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/tiled_image.hpp"
 #include "NanairoCore/Color/SpectralDistribution/spectral_distribution.hpp"
 #include "NanairoCore/CameraModel/camera_model.hpp"
 #include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/DataStructure/photon_map.hpp"
 #include "NanairoCore/Denoiser/denoiser.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/Material/EmitterModel/emitter_model.hpp"
@@ -62,6 +66,7 @@
 #include "NanairoCore/Setting/transformation_setting_node.hpp"
 #include "NanairoCore/Shape/shape.hpp"
 #include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
+#include "NanairoCore/Utility/mapped_file.hpp"
 #include "NanairoGui/keyword.hpp"
 
 namespace nanairo {
@@ -69,10 +74,11 @@ namespace nanairo {
 /*!
   */
 std::unique_ptr<SettingNodeBase> SceneValue::toSetting(
-    const QJsonObject& value) noexcept
+    const QJsonObject& value,
+    SceneValueCache* cache) noexcept
 {
   std::unique_ptr<SettingNodeBase> setting = std::make_unique<SceneSettingNode>();
-  toSceneSetting(value, setting.get());
+  toSceneSetting(value, setting.get(), cache);
   return setting;
 }
 
@@ -86,11 +92,44 @@ void SceneValue::toBvhSetting(const QJsonObject& value,
   const auto bvh_value = toObject(value, keyword::bvh);
   {
     const auto bvh_type = toString(bvh_value, keyword::type);
-    const BvhType bvh = (bvh_type == keyword::binaryRadixTreeBvh)
-        ? BvhType::kBinaryRadixTree
-        : BvhType::kAgglomerativeTreeletRestructuring;
+    const BvhType bvh =
+        (bvh_type == keyword::binaryRadixTreeBvh)
+            ? BvhType::kBinaryRadixTree :
+        (bvh_type == keyword::agglomerativeTreeletRestructuringBvh)
+            ? BvhType::kAgglomerativeTreeletRestructuring
+            : BvhType::kBinnedSah;
     bvh_setting->setBvhType(bvh);
   }
+  if (bvh_value.contains(keyword::bvhLayout)) {
+    const auto layout_type = toString(bvh_value, keyword::bvhLayout);
+    const BvhLayoutType layout =
+        (layout_type == keyword::orderedBinaryBvhLayout)
+            ? BvhLayoutType::kOrderedBinary :
+        (layout_type == keyword::wide4BvhLayout)
+            ? BvhLayoutType::kWide4 :
+        (layout_type == keyword::wide8BvhLayout)
+            ? BvhLayoutType::kWide8 :
+        (layout_type == keyword::quantized4BvhLayout)
+            ? BvhLayoutType::kQuantized4
+            : BvhLayoutType::kBinary;
+    bvh_setting->setBvhLayoutType(layout);
+  }
+  if (bvh_value.contains(keyword::instancing)) {
+    const auto instancing = toBool(bvh_value, keyword::instancing);
+    bvh_setting->setInstancing(instancing);
+  }
+  if (bvh_value.contains(keyword::largeObjectSeparation)) {
+    const auto separation = toBool(bvh_value, keyword::largeObjectSeparation);
+    bvh_setting->setLargeObjectSeparation(separation);
+  }
+  if (bvh_value.contains(keyword::extendedMortonCode)) {
+    const auto extended = toBool(bvh_value, keyword::extendedMortonCode);
+    bvh_setting->setExtendedMortonCode(extended);
+  }
+  if (bvh_value.contains(keyword::proxyGeometry)) {
+    const auto proxy = toBool(bvh_value, keyword::proxyGeometry);
+    bvh_setting->setProxyGeometry(proxy);
+  }
   switch (bvh_setting->bvhType()) {
    case BvhType::kAgglomerativeTreeletRestructuring: {
     auto& parameters = bvh_setting->agglomerativeTreeletRestructuringParameters();
@@ -103,6 +142,22 @@ void SceneValue::toBvhSetting(const QJsonObject& value,
     }
     break;
    }
+   case BvhType::kBinnedSah: {
+    auto& parameters = bvh_setting->binnedSahParameters();
+    {
+      parameters.num_of_bins_ = toInt<uint32>(bvh_value, keyword::numOfBins);
+    }
+    if (bvh_value.contains(keyword::spatialSplit)) {
+      const auto spatial_split = toBool(bvh_value, keyword::spatialSplit);
+      parameters.spatial_split_ = (spatial_split) ? kTrue : kFalse;
+      parameters.split_budget_ = toFloat<double>(bvh_value, keyword::splitBudget);
+    }
+    if (bvh_value.contains(keyword::maxNumOfLeafObjects)) {
+      parameters.max_num_of_leaf_objects_ =
+          toInt<uint32>(bvh_value, keyword::maxNumOfLeafObjects);
+    }
+    break;
+   }
    case BvhType::kBinaryRadixTree:
    default:
     break;
@@ -165,7 +220,10 @@ void SceneValue::toEmitterModelSetting(const QJsonObject& value,
     const auto emitter_value = toObject(emitter_list[i]);
     {
       const auto emitter_type = toString(emitter_value, keyword::type);
-      const EmitterType type = EmitterType::kNonDirectional;
+      const EmitterType type =
+          (emitter_type == keyword::environmentEmitter)
+              ? EmitterType::kEnvironment
+              : EmitterType::kNonDirectional;
       emitter_setting->setEmitterType(type);
     }
     {
@@ -188,6 +246,20 @@ void SceneValue::toEmitterModelSetting(const QJsonObject& value,
       }
       break;
      }
+     case EmitterType::kEnvironment: {
+      auto& parameters = emitter_setting->environmentEmitterParameters();
+      {
+        const auto radiance_scale = toFloat<double>(emitter_value,
+                                                    keyword::radianceScale);
+        parameters.radiance_scale_ = radiance_scale;
+      }
+      {
+        const auto color_index = toInt<uint32>(emitter_value,
+                                               keyword::emissiveColorIndex);
+        parameters.color_index_ = color_index;
+      }
+      break;
+     }
      default: {
       zisc::raiseError("Invalid emitter type is specified.");
       break;
@@ -260,7 +332,8 @@ void SceneValue::toObjectModelSetting(const QJsonObject& object_value,
 /*!
   */
 void SceneValue::toObjectSetting(const QJsonArray& value,
-                                 SettingNodeBase* setting) noexcept
+                                 SettingNodeBase* setting,
+                                 SceneValueCache* cache) noexcept
 {
   zisc::pmr::vector<SettingNodeBase*> group_list{setting->workResource()};
   group_list.reserve(16);
@@ -302,7 +375,7 @@ void SceneValue::toObjectSetting(const QJsonArray& value,
     const auto object_type = toString(object_value, keyword::type);
     if (object_type == keyword::singleObject) {
       auto s = child_object_setting->setObject(ObjectType::kSingle);
-      toSingleObjectSetting(object_value, s);
+      toSingleObjectSetting(object_value, s, cache);
     }
     else if (object_type == keyword::groupObject) {
       auto s = child_object_setting->setObject(ObjectType::kGroup);
@@ -334,7 +407,9 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
         (roulette_type == keyword::rouletteMaxReflectance)
             ? RouletteType::kMaxWeight :
         (roulette_type == keyword::rouletteAverageReflectance)
-            ? RouletteType::kAverageWeight
+            ? RouletteType::kAverageWeight :
+        (roulette_type == keyword::rouletteEfficiency)
+            ? RouletteType::kEfficiency
             : RouletteType::kPathLength;
     method_setting->setRouletteType(roulette);
   }
@@ -342,13 +417,21 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
     const auto path_length = toInt<uint32>(method_value, keyword::pathLength);
     method_setting->setRoulettePathLength(path_length);
   }
+  if (method_value.contains(keyword::minPathLength)) {
+    const auto path_length = toInt<uint32>(method_value, keyword::minPathLength);
+    method_setting->setRouletteMinPathLength(path_length);
+  }
   {
     const auto rendering_method = toString(method_value, keyword::type);
     const RenderingMethodType method =
         (rendering_method == keyword::pathTracing)
             ? RenderingMethodType::kPathTracing :
+        (rendering_method == keyword::wavefrontPathTracing)
+            ? RenderingMethodType::kWavefrontPathTracing :
         (rendering_method == keyword::lightTracing)
-            ? RenderingMethodType::kLightTracing
+            ? RenderingMethodType::kLightTracing :
+        (rendering_method == keyword::lightVertexCacheBpt)
+            ? RenderingMethodType::kLightVertexCacheBpt
             : RenderingMethodType::kProbabilisticPpm;
     method_setting->setMethodType(method);
   }
@@ -357,7 +440,9 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
   {
     const LightSourceSamplerType sampler_type =
         (light_sampler == keyword::uniformLightSampler)
-            ? LightSourceSamplerType::kUniform
+            ? LightSourceSamplerType::kUniform :
+        (light_sampler == keyword::lightBvhLightSampler)
+            ? LightSourceSamplerType::kLightBvh
             : LightSourceSamplerType::kPowerWeighted;
     return sampler_type;
   };
@@ -370,6 +455,40 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
       const auto sampler_type = getLightSourceSamplerType(light_sampler);
       parameters.eye_path_light_sampler_type_ = sampler_type;
     }
+    if (method_value.contains(keyword::materialSorting)) {
+      const auto material_sorting = toBool(method_value, keyword::materialSorting);
+      parameters.material_sorting_ = (material_sorting) ? kTrue : kFalse;
+    }
+    if (method_value.contains(keyword::pathGuiding)) {
+      const auto path_guiding = toBool(method_value, keyword::pathGuiding);
+      parameters.path_guiding_ = (path_guiding) ? kTrue : kFalse;
+    }
+    if (method_value.contains(keyword::guidingIterations)) {
+      parameters.guiding_iterations_ = toInt<uint32>(method_value,
+                                                     keyword::guidingIterations);
+    }
+    if (method_value.contains(keyword::wavelengthBatches)) {
+      parameters.wavelength_batches_ = toInt<uint32>(method_value,
+                                                     keyword::wavelengthBatches);
+    }
+    if (method_value.contains(keyword::lightSolidAngleSampling)) {
+      const auto solid_angle_sampling = toBool(method_value,
+                                               keyword::lightSolidAngleSampling);
+      parameters.light_solid_angle_sampling_ = (solid_angle_sampling) ? kTrue : kFalse;
+    }
+    break;
+   }
+   case RenderingMethodType::kWavefrontPathTracing: {
+    auto& parameters = method_setting->wavefrontPathTracingParameters();
+    {
+      const auto light_sampler = toString(method_value, keyword::eyePathLightSampler);
+      const auto sampler_type = getLightSourceSamplerType(light_sampler);
+      parameters.eye_path_light_sampler_type_ = sampler_type;
+    }
+    if (method_value.contains(keyword::raySorting)) {
+      const auto ray_sorting = toBool(method_value, keyword::raySorting);
+      parameters.ray_sorting_ = (ray_sorting) ? kTrue : kFalse;
+    }
     break;
    }
    case RenderingMethodType::kLightTracing: {
@@ -381,6 +500,29 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
     }
     break;
    }
+   case RenderingMethodType::kLightVertexCacheBpt: {
+    auto& parameters = method_setting->lightVertexCacheBptParameters();
+    {
+      const auto light_sampler = toString(method_value, keyword::eyePathLightSampler);
+      const auto sampler_type = getLightSourceSamplerType(light_sampler);
+      parameters.eye_path_light_sampler_type_ = sampler_type;
+    }
+    {
+      const auto light_sampler = toString(method_value, keyword::lightPathLightSampler);
+      const auto sampler_type = getLightSourceSamplerType(light_sampler);
+      parameters.light_path_light_sampler_type_ = sampler_type;
+    }
+    if (method_value.contains(keyword::numOfLightPaths)) {
+      const auto num_of_paths = toInt<uint32>(method_value, keyword::numOfLightPaths);
+      parameters.num_of_light_paths_ = num_of_paths;
+    }
+    if (method_value.contains(keyword::numOfConnections)) {
+      const auto num_of_connections = toInt<uint32>(method_value,
+                                                    keyword::numOfConnections);
+      parameters.num_of_connections_ = num_of_connections;
+    }
+    break;
+   }
    case RenderingMethodType::kProbabilisticPpm: {
     auto& parameters = method_setting->probabilisticPpmParameters();
     {
@@ -398,6 +540,32 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
       const auto sampler_type = getLightSourceSamplerType(light_sampler);
       parameters.light_path_light_sampler_type_ = sampler_type;
     }
+    if (method_value.contains(keyword::photonMap)) {
+      const auto photon_map = toString(method_value, keyword::photonMap);
+      const PhotonMapType map_type =
+          (photon_map == keyword::hashGridPhotonMap)
+              ? PhotonMapType::kHashGrid
+              : PhotonMapType::kKdTree;
+      parameters.photon_map_type_ = map_type;
+    }
+    if (method_value.contains(keyword::photonAutoTuning)) {
+      const auto auto_tuning = toBool(method_value, keyword::photonAutoTuning);
+      parameters.photon_auto_tuning_ = (auto_tuning) ? kTrue : kFalse;
+    }
+    if (method_value.contains(keyword::targetPhotonTimeRatio)) {
+      const auto ratio = toFloat<double>(method_value,
+                                         keyword::targetPhotonTimeRatio);
+      parameters.target_photon_time_ratio_ = ratio;
+    }
+    if (method_value.contains(keyword::targetCycleTime)) {
+      const auto time = toInt<uint32>(method_value, keyword::targetCycleTime);
+      parameters.target_cycle_time_ = time;
+    }
+    if (method_value.contains(keyword::visiblePointUpdateInterval)) {
+      const auto interval = toInt<uint32>(method_value,
+                                          keyword::visiblePointUpdateInterval);
+      parameters.visible_point_update_interval_ = interval;
+    }
     break;
    }
    default:
@@ -408,7 +576,8 @@ void SceneValue::toRenderingMethodSetting(const QJsonObject& value,
 /*!
   */
 void SceneValue::toSceneSetting(const QJsonObject& value,
-                                SettingNodeBase* setting) noexcept
+                                SettingNodeBase* setting,
+                                SceneValueCache* cache) noexcept
 {
   auto scene_setting = castNode<SceneSettingNode>(setting);
   // Attributes
@@ -420,20 +589,21 @@ void SceneValue::toSceneSetting(const QJsonObject& value,
   // Child nodes
   toSystemSetting(value, scene_setting->systemSettingNode());
   toRenderingMethodSetting(value, scene_setting->renderingMethodSettingNode());
-  toTextureModelSetting(value, scene_setting->textureModelSettingNode());
+  toTextureModelSetting(value, scene_setting->textureModelSettingNode(), cache);
   toSurfaceModelSetting(value, scene_setting->surfaceModelSettingNode());
   toEmitterModelSetting(value, scene_setting->emitterModelSettingNode());
   toBvhSetting(value, scene_setting->bvhSettingNode());
 
   const auto object_list = toArray(value, keyword::object);
   toCameraSetting(object_list, scene_setting->cameraSettingNode());
-  toObjectSetting(object_list, scene_setting->objectSettingNode());
+  toObjectSetting(object_list, scene_setting->objectSettingNode(), cache);
 }
 
 /*!
   */
 void SceneValue::toSingleObjectSetting(const QJsonObject& object_value,
-                                       SettingNodeBase* setting) noexcept
+                                       SettingNodeBase* setting,
+                                       SceneValueCache* cache) noexcept
 {
   auto object_setting = castNode<SingleObjectSettingNode>(setting);
   // Attributes
@@ -477,12 +647,24 @@ void SceneValue::toSingleObjectSetting(const QJsonObject& object_value,
       const auto suffix = file_info.suffix();
       switch (keyword::Fnv1aHash32::hash(suffix)) {
        case zisc::Fnv1aHash32::hash("obj"): {
-        QTextStream obj_stream{&object_file};
-        ObjLoader::parse(obj_stream,
+        // The mesh which is parsed for a previous scene is reused
+        if ((cache != nullptr) && cache->findMesh(object_file_path, &parameters))
+          break;
+        MappedFile obj_file;
+        if (!obj_file.open(object_file_path.toStdString()))
+          qFatal("File '%s' mapping failed.", qUtf8Printable(object_file_path));
+        ObjLoader::parse(obj_file,
                          &parameters.face_list_,
                          &parameters.vertex_list_,
                          &parameters.vnormal_list_,
                          &parameters.vuv_list_);
+        if (cache != nullptr)
+          cache->storeMesh(object_file_path, parameters);
+        break;
+       }
+       case zisc::Fnv1aHash32::hash("nmesh"): {
+        // The mesh file is mapped by the renderer instead of being parsed here
+        parameters.mesh_file_path_ = object_file_path.toStdString();
         break;
        }
        default: {
@@ -796,6 +978,26 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
                                               keyword::numOfThreads);
     system_setting->setNumOfThreads(num_of_threads);
   }
+  if (system_value.contains(keyword::enableThreadAffinity)) {
+    const auto is_thread_affinity_enabled =
+        toBool(system_value, keyword::enableThreadAffinity);
+    system_setting->enableThreadAffinity(is_thread_affinity_enabled);
+  }
+  if (system_value.contains(keyword::enableMemoryFirstTouch)) {
+    const auto is_memory_first_touch_enabled =
+        toBool(system_value, keyword::enableMemoryFirstTouch);
+    system_setting->enableMemoryFirstTouch(is_memory_first_touch_enabled);
+  }
+  if (system_value.contains(keyword::enableBackgroundPriority)) {
+    const auto is_background_priority_enabled =
+        toBool(system_value, keyword::enableBackgroundPriority);
+    system_setting->enableBackgroundPriority(is_background_priority_enabled);
+  }
+  if (system_value.contains(keyword::enableHugePageAllocation)) {
+    const auto is_huge_page_allocation_enabled =
+        toBool(system_value, keyword::enableHugePageAllocation);
+    system_setting->enableHugePageAllocation(is_huge_page_allocation_enabled);
+  }
   {
     const auto sampler_type = toString(system_value,
                                        keyword::samplerType);
@@ -803,7 +1005,11 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
         (sampler_type == keyword::pcgSampler)
             ? SamplerType::kPcg :
         (sampler_type == keyword::xoshiroSampler)
-            ? SamplerType::kXoshiro
+            ? SamplerType::kXoshiro :
+        (sampler_type == keyword::tableCmjSampler)
+            ? SamplerType::kTableCmj :
+        (sampler_type == keyword::owenSobolSampler)
+            ? SamplerType::kOwenSobol
             : SamplerType::kCmj;
     system_setting->setSamplerType(type);
   }
@@ -812,6 +1018,11 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
                                             keyword::samplerSeed);
     system_setting->setSamplerSeed(sampler_seed);
   }
+  if (system_value.contains(keyword::samplesPerCycle)) {
+    const auto samples_per_cycle = toInt<uint32>(system_value,
+                                                 keyword::samplesPerCycle);
+    system_setting->setSamplesPerCycle(samples_per_cycle);
+  }
   {
     const uint32 termination_time = toInt<uint32>(system_value,
                                                   keyword::terminationTime);
@@ -845,6 +1056,26 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
                                             keyword::power2CycleSaving);
     system_setting->setPower2CycleSaving(power2_cycle_saving);
   }
+  if (system_value.contains(keyword::enableLdrImageOutput)) {
+    const auto is_ldr_image_output_enabled =
+        toBool(system_value, keyword::enableLdrImageOutput);
+    system_setting->enableLdrImageOutput(is_ldr_image_output_enabled);
+  }
+  if (system_value.contains(keyword::enableHdrImageOutput)) {
+    const auto is_hdr_image_output_enabled =
+        toBool(system_value, keyword::enableHdrImageOutput);
+    system_setting->enableHdrImageOutput(is_hdr_image_output_enabled);
+  }
+  if (system_value.contains(keyword::enableAdaptiveSampling)) {
+    const auto is_adaptive_sampling_enabled =
+        toBool(system_value, keyword::enableAdaptiveSampling);
+    system_setting->enableAdaptiveSampling(is_adaptive_sampling_enabled);
+  }
+  if (system_value.contains(keyword::adaptiveSamplingThreshold)) {
+    const auto threshold = toFloat<double>(system_value,
+                                           keyword::adaptiveSamplingThreshold);
+    system_setting->setAdaptiveSamplingThreshold(threshold);
+  }
 
   const auto color_value = toObject(value, keyword::color);
   {
@@ -854,6 +1085,10 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
                                      : RenderingColorMode::kSpectra;
     system_setting->setColorMode(mode);
   }
+  if (color_value.contains(keyword::enableXyzFilm)) {
+    const auto is_xyz_film_enabled = toBool(color_value, keyword::enableXyzFilm);
+    system_setting->enableXyzFilm(is_xyz_film_enabled);
+  }
   {
     const auto wavelength_sampler_type = toString(color_value,
                                                   keyword::wavelengthSampling);
@@ -865,6 +1100,16 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
             : WavelengthSamplerType::kStratified;
     system_setting->setWavelengthSamplerType(sampler_type);
   }
+  if (color_value.contains(keyword::wavelengthSampleSize)) {
+    const auto sample_size = toInt<uint32>(color_value,
+                                           keyword::wavelengthSampleSize);
+    system_setting->setWavelengthSampleSize(sample_size);
+  }
+  if (color_value.contains(keyword::enableTileWavelengthSampling)) {
+    const auto is_tile_sampling_enabled =
+        toBool(color_value, keyword::enableTileWavelengthSampling);
+    system_setting->enableTileWavelengthSampling(is_tile_sampling_enabled);
+  }
   {
     const auto color_space = toString(color_value,
                                       keyword::colorSpace);
@@ -905,11 +1150,23 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
     const auto denoiser_type = toString(color_value, keyword::denoiserType);
     const auto type =
         (denoiser_type == keyword::bayesianCollaborativeDenoiser)
-            ? DenoiserType::kBayesianCollaborative
+            ? DenoiserType::kBayesianCollaborative :
+        (denoiser_type == keyword::atrousWaveletDenoiser)
+            ? DenoiserType::kAtrousWavelet
             : DenoiserType::kBayesianCollaborative;
     system_setting->setDenoiserType(type);
   }
   switch (system_setting->denoiserType()) {
+   case DenoiserType::kAtrousWavelet: {
+    auto& parameters = system_setting->atrousWaveletDenoiserParameters();
+    {
+      parameters.number_of_iterations_ =
+          toInt<uint32>(color_value, keyword::numberOfIterations);
+      parameters.color_sigma_ =
+          toFloat<double>(color_value, keyword::colorSigma);
+    }
+    break;
+   }
    case DenoiserType::kBayesianCollaborative: {
     auto& parameters = system_setting->bayesianCollaborativeDenoiserParameters();
     {
@@ -924,6 +1181,10 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
       parameters.number_of_scales_ =
           toInt<uint32>(color_value, keyword::numberOfScales);
     }
+    if (color_value.contains(keyword::singlePrecision)) {
+      const auto single_precision = toBool(color_value, keyword::singlePrecision);
+      parameters.single_precision_ = (single_precision) ? kTrue : kFalse;
+    }
     break;
    }
    default:
@@ -934,7 +1195,8 @@ void SceneValue::toSystemSetting(const QJsonObject& value,
 /*!
   */
 void SceneValue::toTextureModelSetting(const QJsonObject& value,
-                                       SettingNodeBase* setting) noexcept
+                                       SettingNodeBase* setting,
+                                       SceneValueCache* cache) noexcept
 {
   auto material_setting = castNode<TextureModelSettingNode>(setting);
   // Attributes
@@ -1004,18 +1266,56 @@ void SceneValue::toTextureModelSetting(const QJsonObject& value,
           if (!file_info.exists())
             qFatal("File '%s' doesn't exists.", qUtf8Printable(image_file_path));
         }
-        // Load the image
-        QImage image{image_file_path};
-        if (image.isNull())
-          qFatal("File '%s' open failed.", qUtf8Printable(image_file_path));
-        // Copy the image to parameter
-        parameters.image_.setResolution(zisc::cast<uint>(image.width()),
-                                        zisc::cast<uint>(image.height()));
-        for (uint y = 0; y < parameters.image_.heightResolution(); ++y) {
-          for (uint x = 0; x < parameters.image_.widthResolution(); ++x) {
-            auto& rgba32 = parameters.image_.get(x, y);
-            rgba32.setRowData(image.pixelColor(x, y).rgba());
+        const bool is_tiled = texture_value.contains(keyword::tiledImage) &&
+                              toBool(texture_value, keyword::tiledImage);
+        const auto tiled_image_file_path =
+            image_file_path + TiledImage::fileExtension();
+        // The levels of a tiled image are averaged by the gamma of the scene
+        const auto gamma = toFloat<double>(toObject(value, keyword::color),
+                                           keyword::gamma);
+        // The tiled image is converted again only when it's out of date
+        if (is_tiled) {
+          const QFileInfo file_info{image_file_path};
+          const QFileInfo tiled_file_info{tiled_image_file_path};
+          const bool is_valid =
+              tiled_file_info.exists() &&
+              (file_info.lastModified() <= tiled_file_info.lastModified()) &&
+              TiledImage::isValidFile(tiled_image_file_path.toStdString(),
+                                      gamma,
+                                      texture_setting->workResource());
+          if (is_valid) {
+            parameters.tiled_image_path_ = tiled_image_file_path.toStdString();
+            break;
+          }
+        }
+        // Load the image unless it's decoded for a previous scene
+        const bool is_cached = (cache != nullptr) &&
+                               cache->findImage(image_file_path, &parameters.image_);
+        if (!is_cached) {
+          QImage image{image_file_path};
+          if (image.isNull())
+            qFatal("File '%s' open failed.", qUtf8Printable(image_file_path));
+          // Copy the image to parameter
+          parameters.image_.setResolution(zisc::cast<uint>(image.width()),
+                                          zisc::cast<uint>(image.height()));
+          for (uint y = 0; y < parameters.image_.heightResolution(); ++y) {
+            for (uint x = 0; x < parameters.image_.widthResolution(); ++x) {
+              auto& rgba32 = parameters.image_.get(x, y);
+              rgba32.setRowData(image.pixelColor(x, y).rgba());
+            }
           }
+          if (cache != nullptr)
+            cache->storeImage(image_file_path, parameters.image_);
+        }
+        // Convert the image to the tiled image and release the image
+        if (is_tiled) {
+          auto work_resource = texture_setting->workResource();
+          const auto path = tiled_image_file_path.toStdString();
+          if (!TiledImage::write(parameters.image_, gamma, path, work_resource))
+            qFatal("File '%s' write failed.", qUtf8Printable(tiled_image_file_path));
+          parameters.image_.setResolution(1, 1);
+          parameters.image_.data().shrink_to_fit();
+          parameters.tiled_image_path_ = path;
         }
       }
       break;
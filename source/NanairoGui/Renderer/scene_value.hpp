@@ -22,6 +22,9 @@
 
 namespace nanairo {
 
+// Forward declaration
+class SceneValueCache;
+
 //! \addtogroup Gui
 //! \{
 
@@ -69,9 +72,10 @@ class SceneValue
   //! Return a object value
   static QJsonObject toObject(const QJsonValue& value) noexcept;
 
-  //! Convert json scene to setting
+  //! Convert json scene to setting, the loaded files are shared by the cache
   static std::unique_ptr<SettingNodeBase> toSetting(
-      const QJsonObject& value) noexcept;
+      const QJsonObject& value,
+      SceneValueCache* cache = nullptr) noexcept;
 
   //! Return a string value
   static QString toString(const QJsonObject& object,
@@ -106,7 +110,8 @@ class SceneValue
 
   //! Convert json object to object setting
   static void toObjectSetting(const QJsonArray& value,
-                              SettingNodeBase* setting) noexcept;
+                              SettingNodeBase* setting,
+                              SceneValueCache* cache) noexcept;
 
   //! Convert json rendering method to rendering method setting
   static void toRenderingMethodSetting(const QJsonObject& value,
@@ -114,11 +119,13 @@ class SceneValue
 
   //! Convert json scene to scene setting
   static void toSceneSetting(const QJsonObject& value,
-                             SettingNodeBase* setting) noexcept;
+                             SettingNodeBase* setting,
+                             SceneValueCache* cache) noexcept;
 
   //! Convert json single object to single object setting
   static void toSingleObjectSetting(const QJsonObject& object_value,
-                                    SettingNodeBase* setting) noexcept;
+                                    SettingNodeBase* setting,
+                                    SceneValueCache* cache) noexcept;
 
   //! Convert json spectra object to spectra setting
   static void toSpectraSetting(const QJsonObject& spectra_value,
@@ -134,7 +141,8 @@ class SceneValue
 
   //! Convert json texture to texture setting
   static void toTextureModelSetting(const QJsonObject& value,
-                                    SettingNodeBase* setting) noexcept;
+                                    SettingNodeBase* setting,
+                                    SceneValueCache* cache) noexcept;
 };
 
 //! \}
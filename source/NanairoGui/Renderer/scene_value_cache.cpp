@@ -0,0 +1,125 @@
+/*!
+  \file scene_value_cache.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "scene_value_cache.hpp"
+// Standard C++ library
+#include <cstddef>
+#include <utility>
+#include <vector>
+// Qt
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+// Zisc
+#include "zisc/error.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Setting/single_object_setting_node.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+void SceneValueCache::clear() noexcept
+{
+  image_list_.clear();
+  mesh_list_.clear();
+  num_of_hits_ = 0;
+}
+
+/*!
+  */
+bool SceneValueCache::findImage(const QString& file_path,
+                                LdrImage* image) const noexcept
+{
+  ZISC_ASSERT(image != nullptr, "The image is null.");
+  const auto data = image_list_.constFind(makeKey(file_path));
+  const bool is_found = data != image_list_.constEnd();
+  if (is_found) {
+    image->setResolution(data->width_, data->height_);
+    auto& buffer = image->data();
+    buffer.assign(data->data_.begin(), data->data_.end());
+    ++num_of_hits_;
+  }
+  return is_found;
+}
+
+/*!
+  */
+bool SceneValueCache::findMesh(const QString& file_path,
+                               MeshParameters* parameters) const noexcept
+{
+  ZISC_ASSERT(parameters != nullptr, "The parameters is null.");
+  const auto data = mesh_list_.constFind(makeKey(file_path));
+  const bool is_found = data != mesh_list_.constEnd();
+  if (is_found) {
+    parameters->face_list_.assign(data->face_list_.begin(),
+                                  data->face_list_.end());
+    parameters->vertex_list_.assign(data->vertex_list_.begin(),
+                                    data->vertex_list_.end());
+    parameters->vnormal_list_.assign(data->vnormal_list_.begin(),
+                                     data->vnormal_list_.end());
+    parameters->vuv_list_.assign(data->vuv_list_.begin(),
+                                 data->vuv_list_.end());
+    ++num_of_hits_;
+  }
+  return is_found;
+}
+
+/*!
+  */
+std::size_t SceneValueCache::numOfHits() const noexcept
+{
+  return num_of_hits_;
+}
+
+/*!
+  */
+void SceneValueCache::storeImage(const QString& file_path,
+                                 const LdrImage& image) noexcept
+{
+  const auto& buffer = image.data();
+  ImageData data;
+  data.data_.assign(buffer.begin(), buffer.end());
+  data.width_ = image.widthResolution();
+  data.height_ = image.heightResolution();
+  image_list_.insert(makeKey(file_path), std::move(data));
+}
+
+/*!
+  */
+void SceneValueCache::storeMesh(const QString& file_path,
+                                const MeshParameters& parameters) noexcept
+{
+  MeshData data;
+  data.face_list_.assign(parameters.face_list_.begin(),
+                         parameters.face_list_.end());
+  data.vertex_list_.assign(parameters.vertex_list_.begin(),
+                           parameters.vertex_list_.end());
+  data.vnormal_list_.assign(parameters.vnormal_list_.begin(),
+                            parameters.vnormal_list_.end());
+  data.vuv_list_.assign(parameters.vuv_list_.begin(),
+                        parameters.vuv_list_.end());
+  mesh_list_.insert(makeKey(file_path), std::move(data));
+}
+
+/*!
+  */
+QString SceneValueCache::makeKey(const QString& file_path) noexcept
+{
+  const QFileInfo file_info{file_path};
+  const auto path = file_info.canonicalFilePath();
+  const auto time = file_info.lastModified().toMSecsSinceEpoch();
+  const auto size = file_info.size();
+  return path + "|" + QString::number(time) + "|" + QString::number(size);
+}
+
+} // namespace nanairo
@@ -0,0 +1,93 @@
+/*!
+  \file scene_value_cache.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_SCENE_VALUE_CACHE_HPP
+#define NANAIRO_SCENE_VALUE_CACHE_HPP
+
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <vector>
+// Qt
+#include <QHash>
+#include <QString>
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+#include "NanairoCore/Data/face.hpp"
+
+namespace nanairo {
+
+// Forward declaration
+class LdrImage;
+struct MeshParameters;
+
+//! \addtogroup Gui
+//! \{
+
+/*!
+  \brief The loaded mesh and image files which are shared by scenes
+  \details
+  A file is identified by the canonical path, the modified time and the size,
+  so a file which is changed between the scenes is loaded again.
+  The scenes of a queue reuse the parsed meshes and the decoded images
+  instead of reading the files again.
+  */
+class SceneValueCache
+{
+ public:
+  //! Clear the cached files
+  void clear() noexcept;
+
+  //! Copy the cached image of the file into the image, return false if not cached
+  bool findImage(const QString& file_path, LdrImage* image) const noexcept;
+
+  //! Copy the cached mesh of the file into the parameters, return false if not cached
+  bool findMesh(const QString& file_path, MeshParameters* parameters) const noexcept;
+
+  //! Return the number of the files which are reused from the cache
+  std::size_t numOfHits() const noexcept;
+
+  //! Add the image of the file into the cache
+  void storeImage(const QString& file_path, const LdrImage& image) noexcept;
+
+  //! Add the mesh of the file into the cache
+  void storeMesh(const QString& file_path, const MeshParameters& parameters) noexcept;
+
+ private:
+  struct ImageData
+  {
+    std::vector<Rgba32> data_;
+    uint width_;
+    uint height_;
+  };
+
+  struct MeshData
+  {
+    std::vector<Face> face_list_;
+    std::vector<std::array<double, 3>> vertex_list_;
+    std::vector<std::array<double, 3>> vnormal_list_;
+    std::vector<std::array<double, 2>> vuv_list_;
+  };
+
+
+  //! Make the key which identifies the file and its content
+  static QString makeKey(const QString& file_path) noexcept;
+
+
+  QHash<QString, ImageData> image_list_;
+  QHash<QString, MeshData> mesh_list_;
+  mutable std::size_t num_of_hits_ = 0;
+};
+
+//! \} Gui
+
+} // namespace nanairo
+
+#endif // NANAIRO_SCENE_VALUE_CACHE_HPP
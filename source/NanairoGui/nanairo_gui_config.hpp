@@ -31,6 +31,12 @@ class GuiConfig
 
   //! Get the default font family
   static std::string getDefaultFontFamily() noexcept;
+
+  //! Return the idle time (ms) of the camera until the preview goes back to the full resolution
+  static constexpr int previewIdleTime() noexcept;
+
+  //! Return the resolution scale of the preview during camera moves
+  static constexpr int previewResolutionScale() noexcept;
 };
 
 //! \} Gui
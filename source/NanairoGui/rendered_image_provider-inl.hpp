@@ -11,27 +11,29 @@
 #define NANAIRO_RENDERED_IMAGE_PROVIDER_INL_HPP
 
 #include "rendered_image_provider.hpp"
+// Standard C++ library
+#include <mutex>
 // Qt
 #include <QImage>
 
 namespace nanairo {
 
 /*!
-  \details
-  No detailed.
   */
 inline
-QImage& RenderedImageProvider::image() noexcept
+QImage RenderedImageProvider::image() const noexcept
 {
+  std::unique_lock<std::mutex> lock{image_mutex_};
   return image_;
 }
 
 /*!
   */
 inline
-const QImage& RenderedImageProvider::image() const noexcept
+void RenderedImageProvider::setImage(const QImage& image) noexcept
 {
-  return image_;
+  std::unique_lock<std::mutex> lock{image_mutex_};
+  image_ = image;
 }
 
 } // namespace nanairo
@@ -35,8 +35,9 @@ QImage RenderedImageProvider::requestImage(
     QSize* size,
     const QSize& /* requested_size */) noexcept
 {
-  *size = image_.size();
-  return image_;
+  const auto rendered_image = image();
+  *size = rendered_image.size();
+  return rendered_image;
 }
 
 } // namespace nanairo
@@ -10,6 +10,8 @@
 #ifndef NANAIRO_RENDERED_IMAGE_PROVIDER_HPP
 #define NANAIRO_RENDERED_IMAGE_PROVIDER_HPP
 
+// Standard C++ library
+#include <mutex>
 // Qt
 #include <QImage>
 #include <QPixmap>
@@ -26,7 +28,10 @@ namespace nanairo {
 
 /*!
   \details
-  No detailed.
+  The renderer publishes a QImage which refers to its LDR buffer,
+  and the QML thread takes a shallow copy of the latest one.
+  Only the handle of the image is exchanged under the lock,
+  so neither thread waits for the pixels of the other.
   */
 class RenderedImageProvider : public QQuickImageProvider
 {
@@ -40,14 +45,15 @@ class RenderedImageProvider : public QQuickImageProvider
                       QSize* size, 
                       const QSize& requested_size) noexcept override;
 
-  //! Return an image body
-  QImage& image() noexcept;
+  //! Return the latest image
+  QImage image() const noexcept;
 
-  //! Return an image body
-  const QImage& image() const noexcept;
+  //! Publish the image to be displayed
+  void setImage(const QImage& image) noexcept;
 
  private:
   QImage image_;
+  mutable std::mutex image_mutex_;
 };
 
 //! \} Gui
@@ -11,6 +11,8 @@
 #define NANAIRO_CAMERA_EVENT_INL_HPP
 
 #include "camera_event.hpp"
+// Standard C++ library
+#include <mutex>
 // Zisc
 #include "zisc/utility.hpp"
 // Nanairo
@@ -36,6 +38,7 @@ void CameraEvent::addEvent(const int transformation_event_type,
                            const int axis_event_type,
                            const int value) noexcept
 {
+  std::unique_lock<std::mutex> lock{event_mutex_};
   auto& event = event_list_[transformation_event_type];
   const auto scale = 
       (transformation_event_type == kHorizontalTranslationEvent)
@@ -54,10 +57,29 @@ void CameraEvent::addEvent(const int transformation_event_type,
 inline
 void CameraEvent::clear() noexcept
 {
+  std::unique_lock<std::mutex> lock{event_mutex_};
   for (auto& event : event_list_)
     event = Vector2{0.0, 0.0};
 }
 
+/*!
+  */
+inline
+bool CameraEvent::flushEvents(Vector2* horizontal_translation,
+                              Vector2* vertical_translation,
+                              Vector2* rotation) noexcept
+{
+  std::unique_lock<std::mutex> lock{event_mutex_};
+  *horizontal_translation = event_list_[kHorizontalTranslationEvent];
+  *vertical_translation = event_list_[kVerticalTranslationEvent];
+  *rotation = event_list_[kRotationEvent];
+  for (auto& event : event_list_)
+    event = Vector2{0.0, 0.0};
+  return hasValue(*horizontal_translation) ||
+         hasValue(*vertical_translation) ||
+         hasValue(*rotation);
+}
+
 /*!
   */
 inline
@@ -87,9 +109,10 @@ Vector2 CameraEvent::flushVerticalTranslationEvent() noexcept
 inline
 bool CameraEvent::isEventOccured() const noexcept
 {
-  return isHorizontalTranslationEventOccured() ||
-         isRotationEventOccured() ||
-         isVerticalTranslationEventOccured();
+  std::unique_lock<std::mutex> lock{event_mutex_};
+  return hasValue(event_list_[kHorizontalTranslationEvent]) ||
+         hasValue(event_list_[kRotationEvent]) ||
+         hasValue(event_list_[kVerticalTranslationEvent]);
 }
 
 /*!
@@ -99,8 +122,8 @@ bool CameraEvent::isEventOccured() const noexcept
 inline
 bool CameraEvent::isHorizontalTranslationEventOccured() const noexcept
 {
-  const auto& horizontal_translation = horizontalTranslationEvent();
-  return (horizontal_translation[0] != 0.0) || (horizontal_translation[1] != 0.0);
+  std::unique_lock<std::mutex> lock{event_mutex_};
+  return hasValue(horizontalTranslationEvent());
 }
 
 /*!
@@ -110,8 +133,8 @@ bool CameraEvent::isHorizontalTranslationEventOccured() const noexcept
 inline
 bool CameraEvent::isRotationEventOccured() const noexcept
 {
-  const auto& rotation = rotationEvent();
-  return (rotation[0] != 0.0) || (rotation[1] != 0.0);
+  std::unique_lock<std::mutex> lock{event_mutex_};
+  return hasValue(rotationEvent());
 }
 
 /*!
@@ -121,8 +144,8 @@ bool CameraEvent::isRotationEventOccured() const noexcept
 inline
 bool CameraEvent::isVerticalTranslationEventOccured() const noexcept
 {
-  const auto& vertical_translation = verticalTranslationEvent();
-  return (vertical_translation[0] != 0.0) || (vertical_translation[1] != 0.0);
+  std::unique_lock<std::mutex> lock{event_mutex_};
+  return hasValue(verticalTranslationEvent());
 }
 
 /*!
@@ -190,6 +213,7 @@ const Vector2& CameraEvent::verticalTranslationEvent() const noexcept
 template <int kTransformationType> inline
 Vector2 CameraEvent::flushTransformationEvent() noexcept
 {
+  std::unique_lock<std::mutex> lock{event_mutex_};
   auto& transformation = event_list_[kTransformationType];
   const auto event = transformation;
   transformation[0] = 0.0;
@@ -197,6 +221,14 @@ Vector2 CameraEvent::flushTransformationEvent() noexcept
   return event;
 }
 
+/*!
+  */
+inline
+bool CameraEvent::hasValue(const Vector2& event) noexcept
+{
+  return (event[0] != 0.0) || (event[1] != 0.0);
+}
+
 } // namespace nanairo
 
 #endif // _NANAIRO_CAMERA_EVENT_INL_HPP_
@@ -10,18 +10,19 @@
 #ifndef NANAIRO_CAMERA_EVENT_HPP
 #define NANAIRO_CAMERA_EVENT_HPP
 
+// Standard C++ library
+#include <mutex>
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/Geometry/vector.hpp"
 
 namespace nanairo {
 
-//! \addtogroup Gui
-//! \{
-
 /*!
   \details
-  No detailed.
+  The events are added by the GUI thread or the stream server and are
+  accumulated until the renderer flushes them, so the mouse moves of
+  a frame are coalesced into one camera transformation.
   */
 class CameraEvent
 {
@@ -50,6 +51,11 @@ class CameraEvent
   //! Check if the rotation event occured
   bool isRotationEventOccured() const noexcept;
 
+  //! Flush all events at once and return if any event occured
+  bool flushEvents(Vector2* horizontal_translation,
+                   Vector2* vertical_translation,
+                   Vector2* rotation) noexcept;
+
   //! Flush the horizontal translation event
   Vector2 flushHorizontalTranslationEvent() noexcept;
 
@@ -59,6 +65,9 @@ class CameraEvent
   //! Flush the vertical translation event
   Vector2 flushVerticalTranslationEvent() noexcept;
 
+  //! Check if the event has a value
+  static bool hasValue(const Vector2& event) noexcept;
+
   //! Return the horizontal translation event
   Vector2& horizontalTranslationEvent() noexcept;
 
@@ -94,10 +103,9 @@ class CameraEvent
 
 
   Vector2 event_list_[3];
+  mutable std::mutex event_mutex_;
 };
 
-//! \} Gui
-
 } // namespace nanairo
 
 #include "camera_event-inl.hpp"
@@ -0,0 +1,85 @@
+/*!
+  \file frame_stream_server-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_FRAME_STREAM_SERVER_INL_HPP
+#define NANAIRO_FRAME_STREAM_SERVER_INL_HPP
+
+#include "frame_stream_server.hpp"
+// Standard C++ library
+#include <atomic>
+// Nanairo
+#include "camera_event.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+CameraEvent& FrameStreamServer::cameraEvent() noexcept
+{
+  return camera_event_;
+}
+
+/*!
+  */
+inline
+const CameraEvent& FrameStreamServer::cameraEvent() const noexcept
+{
+  return camera_event_;
+}
+
+/*!
+  */
+inline
+bool FrameStreamServer::isConnected() const noexcept
+{
+  return is_connected_.load(std::memory_order_acquire);
+}
+
+/*!
+  */
+inline
+bool FrameStreamServer::isOpened() const noexcept
+{
+  return is_running_.load(std::memory_order_acquire);
+}
+
+/*!
+  \details
+  "NNST" in little endian.
+  */
+inline
+constexpr uint32 FrameStreamServer::magicNumber() noexcept
+{
+  return 0x54534e4eu;
+}
+
+/*!
+  \details
+  The tiles of the deltas are the rendering tiles,
+  which the HDR image converts as dirty.
+  */
+inline
+constexpr uint FrameStreamServer::tileSize() noexcept
+{
+  return CoreConfig::sizeOfRenderingTileSide();
+}
+
+/*!
+  */
+inline
+constexpr uint32 FrameStreamServer::version() noexcept
+{
+  return 1;
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_FRAME_STREAM_SERVER_INL_HPP
@@ -0,0 +1,450 @@
+/*!
+  \file frame_stream_server.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "frame_stream_server.hpp"
+// Standard C++ library
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+// Zisc
+#include "zisc/error.hpp"
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "camera_event.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+
+namespace nanairo {
+
+namespace {
+
+//! The socket which represents no connection
+constexpr int kInvalidSocket = -1;
+
+//! The time in milliseconds which the server waits for the viewer at a time
+constexpr int kPollingTime = 10;
+
+//! The time in milliseconds which the server waits for a new viewer at a time
+constexpr int kAcceptingTime = 100;
+
+} // namespace
+
+/*!
+  */
+FrameStreamServer::FrameStreamServer() noexcept :
+    event_buffer_{},
+    resolution_{0, 0},
+    is_running_{false},
+    is_connected_{false},
+    listen_socket_{kInvalidSocket},
+    viewer_socket_{kInvalidSocket},
+    pending_cycle_{0},
+    event_buffer_size_{0},
+    channel_order_{LdrImage::ChannelOrder::kRgba},
+    has_pending_frame_{kFalse},
+    is_key_frame_{kTrue}
+{
+}
+
+/*!
+  */
+FrameStreamServer::~FrameStreamServer() noexcept
+{
+  close();
+}
+
+/*!
+  */
+void FrameStreamServer::close() noexcept
+{
+  is_running_.store(false, std::memory_order_release);
+  if (server_thread_.joinable())
+    server_thread_.join();
+#if defined(__unix__) || defined(__APPLE__)
+  if (listen_socket_ != kInvalidSocket) {
+    ::close(listen_socket_);
+    listen_socket_ = kInvalidSocket;
+  }
+#endif
+}
+
+/*!
+  \details
+  The server listens on all addresses, since the viewer runs on
+  another machine.
+  */
+bool FrameStreamServer::open(const uint16 port,
+                             const Index2d& resolution,
+                             const LdrImage::ChannelOrder channel_order,
+                             std::string* error_message) noexcept
+{
+  ZISC_ASSERT(error_message != nullptr, "The error message is null.");
+  close();
+#if defined(__unix__) || defined(__APPLE__)
+  listen_socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_socket_ == kInvalidSocket) {
+    *error_message = "Making a socket failed: " + std::string{std::strerror(errno)};
+    return false;
+  }
+  {
+    const int reuse = 1;
+    ::setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  }
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  const bool result =
+      (::bind(listen_socket_, reinterpret_cast<sockaddr*>(&address),
+              sizeof(address)) == 0) &&
+      (::listen(listen_socket_, 1) == 0);
+  if (!result) {
+    *error_message = "Listening on the port " + std::to_string(port) +
+                     " failed: " + std::string{std::strerror(errno)};
+    ::close(listen_socket_);
+    listen_socket_ = kInvalidSocket;
+    return false;
+  }
+
+  resolution_ = resolution;
+  channel_order_ = channel_order;
+  const std::size_t num_of_pixels = resolution[0] * resolution[1];
+  pending_frame_.resize(num_of_pixels);
+  frame_.resize(num_of_pixels);
+  sent_frame_.resize(num_of_pixels);
+  message_.reserve(3 * num_of_pixels + 8 * (num_of_pixels / tileSize()) + 8);
+  has_pending_frame_ = kFalse;
+
+  is_running_.store(true, std::memory_order_release);
+  server_thread_ = std::thread{[this]() {serve();}};
+  return true;
+#else
+  static_cast<void>(port);
+  static_cast<void>(resolution);
+  static_cast<void>(channel_order);
+  *error_message = "The frame streaming isn't supported on this platform.";
+  return false;
+#endif
+}
+
+/*!
+  \details
+  Only the latest frame is kept, so the frames which the connection
+  can't send in time are dropped.
+  */
+void FrameStreamServer::submitFrame(const LdrImage& image,
+                                    const uint32 cycle) noexcept
+{
+  if (!isConnected())
+    return;
+  ZISC_ASSERT(image.size() == pending_frame_.size(),
+              "The resolution of the frame is wrong.");
+  const auto& data = image.data();
+  std::unique_lock<std::mutex> lock{frame_mutex_};
+  std::copy(data.begin(), data.end(), pending_frame_.begin());
+  pending_cycle_ = cycle;
+  has_pending_frame_ = kTrue;
+}
+
+/*!
+  */
+bool FrameStreamServer::acceptViewer() noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+  pollfd listen_fd{listen_socket_, POLLIN, 0};
+  if (::poll(&listen_fd, 1, kAcceptingTime) <= 0)
+    return false;
+  viewer_socket_ = ::accept(listen_socket_, nullptr, nullptr);
+  if (viewer_socket_ == kInvalidSocket)
+    return false;
+  {
+    // The small messages of the events and the tiles aren't delayed
+    const int no_delay = 1;
+    ::setsockopt(viewer_socket_, IPPROTO_TCP, TCP_NODELAY,
+                 &no_delay, sizeof(no_delay));
+#if defined(SO_NOSIGPIPE)
+    const int no_signal = 1;
+    ::setsockopt(viewer_socket_, SOL_SOCKET, SO_NOSIGPIPE,
+                 &no_signal, sizeof(no_signal));
+#endif
+  }
+
+  message_.clear();
+  appendUint32(magicNumber(), &message_);
+  appendUint32(version(), &message_);
+  appendUint32(resolution_[0], &message_);
+  appendUint32(resolution_[1], &message_);
+  appendUint32(tileSize(), &message_);
+  event_buffer_size_ = 0;
+  is_key_frame_ = kTrue;
+  if (!sendMessage()) {
+    ::close(viewer_socket_);
+    viewer_socket_ = kInvalidSocket;
+    return false;
+  }
+  is_connected_.store(true, std::memory_order_release);
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  */
+void FrameStreamServer::appendUint16(const uint value,
+                                     std::vector<uint8>* message) noexcept
+{
+  message->emplace_back(zisc::cast<uint8>(value & 0xffu));
+  message->emplace_back(zisc::cast<uint8>((value >> 8) & 0xffu));
+}
+
+/*!
+  */
+void FrameStreamServer::appendUint32(const uint32 value,
+                                     std::vector<uint8>* message) noexcept
+{
+  for (uint i = 0; i < 4; ++i)
+    message->emplace_back(zisc::cast<uint8>((value >> (8 * i)) & 0xffu));
+}
+
+/*!
+  \details
+  The camera events which the viewer sent are kept,
+  so the last moves are applied even if the viewer disconnects.
+  */
+void FrameStreamServer::closeViewer() noexcept
+{
+  is_connected_.store(false, std::memory_order_release);
+#if defined(__unix__) || defined(__APPLE__)
+  if (viewer_socket_ != kInvalidSocket) {
+    ::close(viewer_socket_);
+    viewer_socket_ = kInvalidSocket;
+  }
+#endif
+}
+
+/*!
+  \details
+  The sent frame is updated by the encoded tiles,
+  so the next frame is compared with what the viewer displays.
+  A frame without changed tiles isn't sent.
+  */
+void FrameStreamServer::encodeFrame(const uint32 cycle) noexcept
+{
+  message_.clear();
+  appendUint32(cycle, &message_);
+  appendUint32(0, &message_);
+  const std::size_t count_position = message_.size() - 4;
+
+  const uint width = resolution_[0];
+  const uint height = resolution_[1];
+  uint32 num_of_tiles = 0;
+  for (uint tile_y = 0; tile_y < height; tile_y += tileSize()) {
+    const uint h = zisc::min(tileSize(), height - tile_y);
+    for (uint tile_x = 0; tile_x < width; tile_x += tileSize()) {
+      const uint w = zisc::min(tileSize(), width - tile_x);
+      if ((is_key_frame_ == kFalse) && !isChangedTile(tile_x, tile_y, w, h))
+        continue;
+      appendUint16(tile_x, &message_);
+      appendUint16(tile_y, &message_);
+      appendUint16(w, &message_);
+      appendUint16(h, &message_);
+      for (uint y = tile_y; y < (tile_y + h); ++y) {
+        const std::size_t row = zisc::cast<std::size_t>(y) * width + tile_x;
+        for (uint x = 0; x < w; ++x) {
+          const auto rgb = getRgb(frame_[row + x]);
+          message_.insert(message_.end(), rgb.begin(), rgb.end());
+        }
+        std::copy_n(frame_.begin() + row, w, sent_frame_.begin() + row);
+      }
+      ++num_of_tiles;
+    }
+  }
+
+  if (num_of_tiles == 0) {
+    message_.clear();
+  }
+  else {
+    for (uint i = 0; i < 4; ++i) {
+      message_[count_position + i] =
+          zisc::cast<uint8>((num_of_tiles >> (8 * i)) & 0xffu);
+    }
+    is_key_frame_ = kFalse;
+  }
+}
+
+/*!
+  */
+std::array<uint8, 3> FrameStreamServer::getRgb(const Rgba32 pixel) const noexcept
+{
+  std::array<uint8, 4> bytes;
+  std::memcpy(bytes.data(), &pixel, sizeof(pixel));
+  return (channel_order_ == LdrImage::ChannelOrder::kBgra)
+      ? std::array<uint8, 3>{{bytes[2], bytes[1], bytes[0]}}
+      : std::array<uint8, 3>{{bytes[0], bytes[1], bytes[2]}};
+}
+
+/*!
+  */
+bool FrameStreamServer::isChangedTile(const uint x,
+                                      const uint y,
+                                      const uint width,
+                                      const uint height) const noexcept
+{
+  for (uint j = y; j < (y + height); ++j) {
+    const std::size_t row = zisc::cast<std::size_t>(j) * resolution_[0] + x;
+    const auto begin = frame_.begin() + row;
+    if (!std::equal(begin, begin + width, sent_frame_.begin() + row))
+      return true;
+  }
+  return false;
+}
+
+/*!
+  \details
+  An event may arrive in pieces, so the bytes are buffered until
+  the whole event arrives. Invalid events are ignored.
+  */
+bool FrameStreamServer::receiveEvents() noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+  const auto size = ::recv(viewer_socket_,
+                           event_buffer_.data() + event_buffer_size_,
+                           event_buffer_.size() - event_buffer_size_,
+                           0);
+  if (size < 0)
+    return (errno == EINTR) || (errno == EAGAIN);
+  if (size == 0)
+    return false;
+  event_buffer_size_ += zisc::cast<uint>(size);
+  if (event_buffer_size_ == event_buffer_.size()) {
+    std::array<int32, 3> event;
+    for (uint i = 0; i < event.size(); ++i) {
+      uint32 value = 0;
+      for (uint b = 0; b < 4; ++b)
+        value |= zisc::cast<uint32>(event_buffer_[4 * i + b]) << (8 * b);
+      event[i] = zisc::cast<int32>(value);
+    }
+    const bool is_valid = (0 <= event[0]) && (event[0] < 3) &&
+                          (0 <= event[1]) && (event[1] < 2);
+    if (is_valid)
+      camera_event_.addEvent(event[0], event[1], event[2]);
+    event_buffer_size_ = 0;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  */
+bool FrameStreamServer::sendMessage() noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+#if defined(MSG_NOSIGNAL)
+  constexpr int flags = MSG_NOSIGNAL;
+#else
+  constexpr int flags = 0;
+#endif
+  std::size_t offset = 0;
+  while (offset < message_.size()) {
+    const auto size = ::send(viewer_socket_,
+                             message_.data() + offset,
+                             message_.size() - offset,
+                             flags);
+    if (size < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    offset += zisc::cast<std::size_t>(size);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \details
+  The events and the frames are handled on the server thread,
+  so the rendering only copies the frames.
+  */
+void FrameStreamServer::serve() noexcept
+{
+  while (isOpened()) {
+    if (!isConnected()) {
+      acceptViewer();
+      continue;
+    }
+    if (!waitForViewer()) {
+      closeViewer();
+      continue;
+    }
+    // Send the latest frame
+    uint32 cycle = 0;
+    bool has_frame = false;
+    {
+      std::unique_lock<std::mutex> lock{frame_mutex_};
+      if (has_pending_frame_ == kTrue) {
+        frame_.swap(pending_frame_);
+        cycle = pending_cycle_;
+        has_pending_frame_ = kFalse;
+        has_frame = true;
+      }
+    }
+    if (has_frame) {
+      encodeFrame(cycle);
+      if (!sendMessage())
+        closeViewer();
+    }
+  }
+  closeViewer();
+}
+
+/*!
+  */
+bool FrameStreamServer::waitForViewer() noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+  pollfd viewer_fd{viewer_socket_, POLLIN, 0};
+  const int result = ::poll(&viewer_fd, 1, kPollingTime);
+  if (result < 0)
+    return errno == EINTR;
+  if (0 < result) {
+    if ((viewer_fd.revents & POLLIN) != 0)
+      return receiveEvents();
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace nanairo
@@ -0,0 +1,152 @@
+/*!
+  \file frame_stream_server.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_FRAME_STREAM_SERVER_HPP
+#define NANAIRO_FRAME_STREAM_SERVER_HPP
+
+// Standard C++ library
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// Zisc
+#include "zisc/non_copyable.hpp"
+// Nanairo
+#include "camera_event.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Color/rgba_32.hpp"
+
+namespace nanairo {
+
+/*!
+  \brief A TCP server which streams the tone mapped frames to a remote viewer
+  \details
+  A viewer is served at a time. The server sends a header on the connection,
+  then the frames are sent as the tiles which changed since
+  the last sent frame, so a progressive refinement sends little once
+  the image converges. The frame which arrives while the previous one is
+  still being sent replaces the pending one, so a slow connection drops
+  the frames instead of delaying the rendering. The viewer sends
+  the camera events which are accumulated into the camera event.
+
+  All values are little endian.
+  The header: magic, version, width, height and tile size (uint32 each).
+  A frame: cycle, the number of the tiles (uint32 each), then each tile
+  of x, y, width and height (uint16 each) and the RGB8 pixels in rows.
+  A camera event: transformation type (0: horizontal translation,
+  1: vertical translation, 2: rotation), axis (0: x, 1: y) and
+  value (int32 each), which are the arguments of CameraEvent::addEvent().
+  */
+class FrameStreamServer : public zisc::NonCopyable<FrameStreamServer>
+{
+ public:
+  //! Create a closed server
+  FrameStreamServer() noexcept;
+
+  //! Close the server
+  ~FrameStreamServer() noexcept;
+
+
+  //! Return the camera event which accumulates the events of the viewer
+  CameraEvent& cameraEvent() noexcept;
+
+  //! Return the camera event which accumulates the events of the viewer
+  const CameraEvent& cameraEvent() const noexcept;
+
+  //! Close the connection and stop the server
+  void close() noexcept;
+
+  //! Check if a viewer is connected
+  bool isConnected() const noexcept;
+
+  //! Check if the server is listening
+  bool isOpened() const noexcept;
+
+  //! Return the magic number of the stream
+  static constexpr uint32 magicNumber() noexcept;
+
+  //! Start listening on the port, return false if the port can't be opened
+  bool open(const uint16 port,
+            const Index2d& resolution,
+            const LdrImage::ChannelOrder channel_order,
+            std::string* error_message) noexcept;
+
+  //! Submit the tone mapped frame which is sent to the viewer
+  void submitFrame(const LdrImage& image, const uint32 cycle) noexcept;
+
+  //! Return the side size of the tiles of the deltas
+  static constexpr uint tileSize() noexcept;
+
+  //! Return the version of the stream format
+  static constexpr uint32 version() noexcept;
+
+ private:
+  //! Accept a viewer and send the header
+  bool acceptViewer() noexcept;
+
+  //! Append a 16 bit value in little endian
+  static void appendUint16(const uint value, std::vector<uint8>* message) noexcept;
+
+  //! Append a 32 bit value in little endian
+  static void appendUint32(const uint32 value, std::vector<uint8>* message) noexcept;
+
+  //! Close the viewer connection
+  void closeViewer() noexcept;
+
+  //! Encode the tiles of the frame which differ from the sent frame
+  void encodeFrame(const uint32 cycle) noexcept;
+
+  //! Return the RGB components of the pixel in the channel order
+  std::array<uint8, 3> getRgb(const Rgba32 pixel) const noexcept;
+
+  //! Check if the tile of the frame differs from the sent frame
+  bool isChangedTile(const uint x, const uint y,
+                     const uint width, const uint height) const noexcept;
+
+  //! Receive the camera events of the viewer, return false if it's closed
+  bool receiveEvents() noexcept;
+
+  //! Send the message to the viewer, return false if it's closed
+  bool sendMessage() noexcept;
+
+  //! Serve the viewers until the server is closed
+  void serve() noexcept;
+
+  //! Wait for the events of the viewer for a while, return false if it's closed
+  bool waitForViewer() noexcept;
+
+
+  CameraEvent camera_event_;
+  std::thread server_thread_;
+  std::mutex frame_mutex_;
+  std::vector<Rgba32> pending_frame_; //!< The frame which is submitted
+  std::vector<Rgba32> frame_; //!< The frame which is being sent
+  std::vector<Rgba32> sent_frame_; //!< The frame which the viewer has
+  std::vector<uint8> message_;
+  std::array<uint8, 12> event_buffer_;
+  Index2d resolution_;
+  std::atomic<bool> is_running_;
+  std::atomic<bool> is_connected_;
+  int listen_socket_;
+  int viewer_socket_;
+  uint32 pending_cycle_;
+  uint event_buffer_size_;
+  LdrImage::ChannelOrder channel_order_;
+  uint8 has_pending_frame_;
+  uint8 is_key_frame_; //!< The viewer has no frame yet
+};
+
+} // namespace nanairo
+
+#include "frame_stream_server-inl.hpp"
+
+#endif // NANAIRO_FRAME_STREAM_SERVER_HPP
@@ -0,0 +1,37 @@
+/*!
+  \file metrics_writer-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_METRICS_WRITER_INL_HPP
+#define NANAIRO_METRICS_WRITER_INL_HPP
+
+#include "metrics_writer.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+bool MetricsWriter::isEnabled() const noexcept
+{
+  return !metrics_path_.empty();
+}
+
+/*!
+  */
+inline
+bool MetricsWriter::isTimeToWrite(const Clock::time_point& time) const noexcept
+{
+  return isEnabled() && (interval_ <= (time - write_time_));
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_METRICS_WRITER_INL_HPP
@@ -0,0 +1,218 @@
+/*!
+  \file metrics_writer.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "metrics_writer.hpp"
+// Standard C++ library
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <string_view>
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+
+namespace nanairo {
+
+namespace {
+
+using Seconds = std::chrono::duration<double>;
+
+//! Convert the time into seconds
+double toSeconds(const MetricsWriter::Clock::duration& time) noexcept
+{
+  return std::chrono::duration_cast<Seconds>(time).count();
+}
+
+} // namespace
+
+/*!
+  */
+MetricsWriter::MetricsWriter() noexcept :
+    interval_{Clock::duration::zero()},
+    rendering_time_{Clock::duration::zero()},
+    cycle_time_{Clock::duration::zero()},
+    write_time_{Clock::now()},
+    write_cpu_time_{std::clock()},
+    num_of_samples_{0},
+    cycle_samples_{0},
+    cycle_rays_{0}
+{
+}
+
+/*!
+  */
+void MetricsWriter::addCycle(const RenderingCounter& counter,
+                             const Clock::duration& time,
+                             const uint64 num_of_samples) noexcept
+{
+  total_counter_.merge(counter);
+  rendering_time_ += time;
+  num_of_samples_ += num_of_samples;
+  cycle_time_ = time;
+  cycle_samples_ = num_of_samples;
+  cycle_rays_ = counter.totalRays();
+}
+
+/*!
+  */
+void MetricsWriter::addMetric(const std::string_view name,
+                              const std::string_view type,
+                              const std::string_view help) noexcept
+{
+  text_ += "# HELP ";
+  text_ += name;
+  text_ += ' ';
+  text_ += help;
+  text_ += "\n# TYPE ";
+  text_ += name;
+  text_ += ' ';
+  text_ += type;
+  text_ += '\n';
+}
+
+/*!
+  \details
+  The labels are written in the braces as they are,
+  e.g. "category=\"Object\"".
+  */
+void MetricsWriter::addValue(const std::string_view name,
+                             const double value,
+                             const std::string_view labels) noexcept
+{
+  text_ += name;
+  if (!labels.empty()) {
+    text_ += '{';
+    text_ += labels;
+    text_ += '}';
+  }
+  text_ += ' ';
+  text_ += std::to_string(value);
+  text_ += '\n';
+}
+
+/*!
+  \details
+  The write time is reset, so the first write follows the interval
+  from the start of the rendering.
+  */
+void MetricsWriter::setFile(const std::string& metrics_path,
+                            const Clock::duration& interval) noexcept
+{
+  metrics_path_ = metrics_path;
+  interval_ = interval;
+  write_time_ = Clock::now();
+  write_cpu_time_ = std::clock();
+}
+
+/*!
+  \details
+  The added metrics are cleared even if the write fails,
+  so the next write doesn't repeat them.
+  */
+bool MetricsWriter::write(const Clock::time_point& time,
+                          const uint num_of_threads) noexcept
+{
+  bool result = false;
+  if (isEnabled()) {
+    addCounts();
+    addThreadUtilization(time, num_of_threads);
+    const auto temp_path = metrics_path_ + ".tmp";
+    {
+      std::ofstream metrics_file{temp_path, std::ios::binary};
+      metrics_file.write(text_.data(), zisc::cast<std::streamsize>(text_.size()));
+      metrics_file.close();
+      result = !metrics_file.fail();
+    }
+#if defined(_WIN32)
+    // Rename doesn't replace the existing file on Windows
+    if (result)
+      std::remove(metrics_path_.c_str());
+#endif
+    result = result && (std::rename(temp_path.c_str(), metrics_path_.c_str()) == 0);
+  }
+  text_.clear();
+  return result;
+}
+
+/*!
+  \details
+  The rates are of the last cycle, so they follow a change of the scene load
+  instead of the average of the rendering.
+  */
+void MetricsWriter::addCounts() noexcept
+{
+  addMetric("nanairo_rays_total", "counter", "The number of the cast rays.");
+  addValue("nanairo_rays_total",
+           zisc::cast<double>(total_counter_.numOfRays(RayCastType::kPrimary)),
+           "type=\"primary\"");
+  addValue("nanairo_rays_total",
+           zisc::cast<double>(total_counter_.numOfRays(RayCastType::kSecondary)),
+           "type=\"secondary\"");
+  addValue("nanairo_rays_total",
+           zisc::cast<double>(total_counter_.numOfRays(RayCastType::kShadow)),
+           "type=\"shadow\"");
+  addMetric("nanairo_node_visits_total", "counter",
+            "The number of the visited BVH nodes.");
+  addValue("nanairo_node_visits_total",
+           zisc::cast<double>(total_counter_.numOfNodeVisits()));
+  addMetric("nanairo_primitive_tests_total", "counter",
+            "The number of the intersection tests of the primitives.");
+  addValue("nanairo_primitive_tests_total",
+           zisc::cast<double>(total_counter_.numOfPrimitiveTests()));
+  addMetric("nanairo_paths_total", "counter", "The number of the traced paths.");
+  addValue("nanairo_paths_total",
+           zisc::cast<double>(total_counter_.numOfPaths()));
+  addMetric("nanairo_path_length_average", "gauge",
+            "The average length of the traced paths.");
+  addValue("nanairo_path_length_average", total_counter_.averagePathLength());
+  addMetric("nanairo_samples_total", "counter",
+            "The number of the rendered samples.");
+  addValue("nanairo_samples_total", zisc::cast<double>(num_of_samples_));
+  addMetric("nanairo_rendering_seconds_total", "counter",
+            "The time of the rendering cycles.");
+  addValue("nanairo_rendering_seconds_total", toSeconds(rendering_time_));
+
+  const double cycle_time = toSeconds(cycle_time_);
+  const double k = (0.0 < cycle_time) ? 1.0 / cycle_time : 0.0;
+  addMetric("nanairo_samples_per_second", "gauge",
+            "The samples per second of the last cycle.");
+  addValue("nanairo_samples_per_second", k * zisc::cast<double>(cycle_samples_));
+  addMetric("nanairo_rays_per_second", "gauge",
+            "The rays per second of the last cycle.");
+  addValue("nanairo_rays_per_second", k * zisc::cast<double>(cycle_rays_));
+}
+
+/*!
+  \details
+  The utilization is the CPU time of the process over the wall time of
+  the threads, so the waits of the threads (the imbalance of the tasks
+  or the IO) lower it.
+  */
+void MetricsWriter::addThreadUtilization(const Clock::time_point& time,
+                                         const uint num_of_threads) noexcept
+{
+  const std::clock_t cpu_time = std::clock();
+  const double wall_time = toSeconds(time - write_time_) *
+                           zisc::cast<double>(num_of_threads);
+  const double used_time = zisc::cast<double>(cpu_time - write_cpu_time_) /
+                           zisc::cast<double>(CLOCKS_PER_SEC);
+  const double utilization = (0.0 < wall_time) ? used_time / wall_time : 0.0;
+  addMetric("nanairo_thread_utilization", "gauge",
+            "The CPU time over the wall time of the threads since the last write.");
+  addValue("nanairo_thread_utilization", zisc::clamp(utilization, 0.0, 1.0));
+  write_time_ = time;
+  write_cpu_time_ = cpu_time;
+}
+
+} // namespace nanairo
@@ -0,0 +1,99 @@
+/*!
+  \file metrics_writer.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_METRICS_WRITER_HPP
+#define NANAIRO_METRICS_WRITER_HPP
+
+// Standard C++ library
+#include <ctime>
+#include <string>
+#include <string_view>
+// Zisc
+#include "zisc/stopwatch.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+
+namespace nanairo {
+
+/*!
+  \brief Write the live metrics of a rendering into a text file
+  \details
+  The metrics are written in the text exposition format of Prometheus,
+  so a farm monitor can scrape the file (e.g. by the textfile collector of
+  node exporter) without parsing the log. The file is replaced by renaming
+  a temporary file, so a reader never sees a partial file.
+  The counts of the cycles are accumulated by the writer and
+  the other metrics are added by the renderer before each write.
+  */
+class MetricsWriter
+{
+ public:
+  using Clock = zisc::Stopwatch::Clock;
+
+
+  //! Create a disabled writer
+  MetricsWriter() noexcept;
+
+
+  //! Add the counts of a rendered cycle
+  void addCycle(const RenderingCounter& counter,
+                const Clock::duration& time,
+                const uint64 num_of_samples) noexcept;
+
+  //! Start a metric, the values of the metric follow it
+  void addMetric(const std::string_view name,
+                 const std::string_view type,
+                 const std::string_view help) noexcept;
+
+  //! Add a value of the last metric
+  void addValue(const std::string_view name,
+                const double value,
+                const std::string_view labels = "") noexcept;
+
+  //! Check if the metrics file is set
+  bool isEnabled() const noexcept;
+
+  //! Check if the interval has passed since the last write
+  bool isTimeToWrite(const Clock::time_point& time) const noexcept;
+
+  //! Set the file and the interval of the writes, an empty path disables them
+  void setFile(const std::string& metrics_path,
+               const Clock::duration& interval) noexcept;
+
+  //! Write the added metrics and the counts into the file
+  bool write(const Clock::time_point& time, const uint num_of_threads) noexcept;
+
+ private:
+  //! Add the accumulated counts of the cycles
+  void addCounts() noexcept;
+
+  //! Add the CPU utilization of the threads since the last write
+  void addThreadUtilization(const Clock::time_point& time,
+                            const uint num_of_threads) noexcept;
+
+
+  std::string metrics_path_;
+  std::string text_; //!< The metrics which are added since the last write
+  RenderingCounter total_counter_;
+  Clock::duration interval_;
+  Clock::duration rendering_time_;
+  Clock::duration cycle_time_; //!< The rendering time of the last cycle
+  Clock::time_point write_time_;
+  std::clock_t write_cpu_time_;
+  uint64 num_of_samples_;
+  uint64 cycle_samples_; //!< The samples of the last cycle
+  uint64 cycle_rays_; //!< The rays of the last cycle
+};
+
+} // namespace nanairo
+
+#include "metrics_writer-inl.hpp"
+
+#endif // NANAIRO_METRICS_WRITER_HPP
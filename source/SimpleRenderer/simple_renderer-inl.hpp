@@ -17,8 +17,10 @@
 #include <string>
 #include <string_view>
 // Zisc
+#include "zisc/fnv_1a_hash_engine.hpp"
 #include "zisc/stopwatch.hpp"
 // Nanairo
+#include "frame_stream_server.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/scene.hpp"
 #include "NanairoCore/system.hpp"
@@ -87,11 +89,10 @@ void SimpleRenderer::setRunnable(const bool is_runnable) noexcept
 inline
 std::string SimpleRenderer::makeImagePath(const std::string_view output_path,
                                           const uint32 cycle,
-                                          const std::string_view suffix) const noexcept
+                                          const std::string_view suffix,
+                                          const std::string_view extension) const noexcept
 {
-  using namespace std::literals;
-
-  const auto ext = ".png"sv;
+  const auto ext = extension;
 
   constexpr std::size_t cycle_digits = std::numeric_limits<uint32>::digits10;
   const std::size_t size = 2 + output_path.size() + cycle_digits + suffix.size() + ext.size();
@@ -196,6 +197,24 @@ const WavelengthSampler& SimpleRenderer::wavelengthSampler() const noexcept
   return *wavelength_sampler_;
 }
 
+/*!
+  */
+inline
+constexpr uint32 SimpleRenderer::checkpointMagicNumber() noexcept
+{
+  return zisc::Fnv1aHash32::hash("NanairoCheckpoint");
+}
+
+/*!
+  \details
+  The version 3 stores the covariance factors without the compensation.
+  */
+inline
+constexpr uint32 SimpleRenderer::checkpointVersion() noexcept
+{
+  return 3;
+}
+
 /*!
   */
 inline
@@ -215,9 +234,49 @@ uint32 SimpleRenderer::cycleToFinish() const noexcept
 /*!
   */
 inline
-bool SimpleRenderer::isSavingAtEachCycleEnabled() const noexcept
+bool SimpleRenderer::isAsyncDenoisingEnabled() const noexcept
+{
+  return denoising_statistics_.get() != nullptr;
+}
+
+/*!
+  */
+inline
+bool SimpleRenderer::isCheckpointEnabled() const noexcept
+{
+  return !checkpoint_path_.empty() && (checkpoint_interval_ != Clock::duration::max());
+}
+
+/*!
+  */
+inline
+bool SimpleRenderer::isHdrImageOutputEnabled() const noexcept
 {
-  return is_saving_each_cycle_enabled_;
+  return is_hdr_image_output_enabled_;
+}
+
+/*!
+  */
+inline
+bool SimpleRenderer::isLdrImageOutputEnabled() const noexcept
+{
+  return is_ldr_image_output_enabled_;
+}
+
+/*!
+  */
+inline
+bool SimpleRenderer::isLinearImageDisplayEnabled() const noexcept
+{
+  return is_linear_image_display_enabled_;
+}
+
+/*!
+  */
+inline
+bool SimpleRenderer::isSavingAtEachFrameEnabled() const noexcept
+{
+  return is_saving_each_frame_enabled_;
 }
 
 /*!
@@ -228,6 +287,14 @@ bool SimpleRenderer::isSavingAtPowerOf2CyclesEnabled() const noexcept
   return is_saving_at_power_of_2_cycles_enabled_;
 }
 
+/*!
+  */
+inline
+bool SimpleRenderer::isStreamingEnabled() const noexcept
+{
+  return (stream_server_.get() != nullptr) && stream_server_->isOpened();
+}
+
 /*!
   */
 inline
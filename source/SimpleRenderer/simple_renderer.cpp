@@ -9,43 +9,68 @@
 
 #include "simple_renderer.hpp"
 // Standard C++ library
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstddef>
 #include <cstdio>
 #include <fstream>
+#include <future>
+#include <ios>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <ostream>
 #include <ratio>
+#include <sstream>
 #include <string>
 #include <string_view>
+#include <vector>
 // LodePNG
 #ifdef NANAIRO_HAS_LODEPNG
 #include "lodepng.h"
 #endif // NANAIRO_HAS_LODEPNG
 // Zisc
+#include "zisc/binary_data.hpp"
+#include "zisc/compensated_summation.hpp"
 #include "zisc/error.hpp"
 #include "zisc/function_reference.hpp"
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
 #include "zisc/stopwatch.hpp"
 #include "zisc/utility.hpp"
 // Nanairo
+#include "camera_event.hpp"
+#include "frame_stream_server.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/scene.hpp"
 #include "NanairoCore/system.hpp"
+#include "NanairoCore/world.hpp"
+#include "NanairoCore/CameraModel/camera_model.hpp"
 #include "NanairoCore/CameraModel/film.hpp"
 #include "NanairoCore/Color/hdr_image.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
 #include "NanairoCore/Color/rgba_32.hpp"
 #include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/rendering_counter.hpp"
+#include "NanairoCore/Data/shading_profile.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
 #include "NanairoCore/Denoiser/denoiser.hpp"
+#include "NanairoCore/Denoiser/denoising_context.hpp"
+#include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
 #include "NanairoCore/RenderingMethod/rendering_method.hpp"
 #include "NanairoCore/Sampling/sample_statistics.hpp"
 #include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Setting/material_setting_node.hpp"
 #include "NanairoCore/Setting/scene_setting_node.hpp"
 #include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Setting/surface_setting_node.hpp"
 #include "NanairoCore/Setting/system_setting_node.hpp"
 #include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/loading_phase.hpp"
+#include "NanairoCore/Utility/out_of_core_memory_resource.hpp"
+#include "NanairoCore/Utility/trace_recorder.hpp"
 
 namespace nanairo {
 
@@ -53,7 +78,17 @@ namespace nanairo {
   */
 SimpleRenderer::SimpleRenderer() noexcept : 
   log_stream_{nullptr},
-  is_saving_each_cycle_enabled_{false},
+  checkpoint_interval_{Clock::duration::max()},
+  resumed_time_{Clock::duration::zero()},
+  deadline_{Clock::duration::zero()},
+  async_denoising_time_{Clock::duration::zero()},
+  shading_profile_start_ticks_{0},
+  denoising_cycle_{0},
+  stream_port_{0},
+  is_saving_each_frame_enabled_{false},
+  is_linear_image_display_enabled_{false},
+  is_ldr_image_output_enabled_{true},
+  is_hdr_image_output_enabled_{false},
   is_runnable_{false}
 {
   initialize();
@@ -63,12 +98,67 @@ SimpleRenderer::SimpleRenderer() noexcept :
   */
 SimpleRenderer::~SimpleRenderer() noexcept
 {
+  waitForDenoising();
+  waitForImageOutput();
+  waitForCheckpoint();
+  stream_server_.reset();
   // Destroy before the memory resources are destroyed
+  denoising_statistics_.reset();
+  denoising_memory_.reset();
+  denoising_task_scheduler_.reset();
+  denoising_thread_manager_.reset();
   scene_.reset();
   wavelength_sampler_.reset();
   rendering_method_.reset();
   hdr_image_.reset();
   ldr_image_.reset();
+  ldr_snapshot_.reset();
+  hdr_snapshot_.reset();
+  cost_snapshot_.reset();
+}
+
+/*!
+  \details
+  The phases are reported with the phases of the scene loading.
+  */
+void SimpleRenderer::addLoadingPhase(const LoadingPhase& phase) noexcept
+{
+  preloading_phase_list_.emplace_back(phase);
+}
+
+/*!
+  \details
+  The counters are measured in the phases of the cycles after they're opened,
+  and the counts of the phases are logged with the ray counts.
+  */
+bool SimpleRenderer::enableHardwareCounters() noexcept
+{
+  if (!isRunnable())
+    return false;
+  const bool is_enabled = system().enableHardwareCounters();
+  if (is_enabled)
+    logMessage("Hardware counters are enabled.");
+  else if (!HardwareCounter::isSupported())
+    logMessage("Hardware counters aren't supported on the platform.");
+  else
+    logMessage("Hardware counters can't be opened.");
+  return is_enabled;
+}
+
+/*!
+  \details
+  The time stamp counts of the profile are converted to the time
+  by the wall-clock time of the profiled interval.
+  */
+bool SimpleRenderer::enableShadingProfile() noexcept
+{
+  if (!isRunnable())
+    return false;
+  const uint num_of_surfaces = zisc::cast<uint>(surface_name_list_.size());
+  renderingMethod().enableShadingProfile(num_of_surfaces);
+  shading_profile_start_time_ = Clock::now();
+  shading_profile_start_ticks_ = RenderingCounter::readTimeStamp();
+  return true;
 }
 
 /*!
@@ -92,6 +182,16 @@ bool SimpleRenderer::loadScene(const SettingNodeBase& settings,
   const auto system_settings = 
       castNode<SystemSettingNode>(scene_settings->systemSettingNode());
   system_ = std::make_unique<System>(system_settings);
+  {
+    const uint32 sample_size = system_settings->wavelengthSampleSize();
+    if ((system_settings->colorMode() == RenderingColorMode::kSpectra) &&
+        (sample_size != 0) && (sample_size != CoreConfig::wavelengthSampleSize())) {
+      const auto message = "The app samples "s +
+          std::to_string(CoreConfig::wavelengthSampleSize()) +
+          " wavelengths instead of " + std::to_string(sample_size) + ".";
+      logMessage(message);
+    }
+  }
 
   std::mutex data_mutex;
   auto& data_resource = system_->dataMemoryManager();
@@ -101,37 +201,152 @@ bool SimpleRenderer::loadScene(const SettingNodeBase& settings,
   scene_ = zisc::UniqueMemoryPointer<Scene>::make(&data_resource,
                                                   system(),
                                                   scene_settings);
+  cacheSurfaceNames(settings);
 
   // Wavelength sampler
   {
+    const auto start_time = system().stopwatch().elapsedTime();
+    const auto start_memory = residentMemorySize();
     const auto& world = scene().world();
     wavelength_sampler_ = zisc::UniqueMemoryPointer<WavelengthSampler>::make(
         &data_resource,
         world,
         system_settings);
+    system().recordLoadingPhase("Wavelength sampler", start_time, start_memory);
   }
 
   // Rendering method
   {
+    const auto start_time = system().stopwatch().elapsedTime();
+    const auto start_memory = residentMemorySize();
     const auto method_settings = scene_settings->renderingMethodSettingNode();
     rendering_method_ = RenderingMethod::makeMethod(system(),
                                                     method_settings,
                                                     scene());
+    setTileWavelengthSampler();
+    system().recordLoadingPhase("Rendering method", start_time, start_memory);
   }
 
   // images
   {
-    const auto& image_resolution = system_settings->imageResolution();
+    const auto start_time = system().stopwatch().elapsedTime();
+    const auto start_memory = residentMemorySize();
+    // The images have only the crop window
+    const auto& image_resolution = system().imageResolution();
+    if ((image_resolution[0] != system_settings->imageWidthResolution()) ||
+        (image_resolution[1] != system_settings->imageHeightResolution())) {
+      const auto& offset = system().cropOffset();
+      const auto message = "  Crop window: ("s + std::to_string(offset[0]) + ", " +
+                           std::to_string(offset[1]) + ") " +
+                           std::to_string(image_resolution[0]) + "x" +
+                           std::to_string(image_resolution[1]) + ".";
+      logMessage(message);
+    }
+    // The pixels of the images are mapped from the file of the film too,
+    // so the kernel pages them out between the outputs
+    zisc::pmr::memory_resource* image_resource = system().isMappedFilmEnabled()
+        ? zisc::cast<zisc::pmr::memory_resource*>(&system().filmMemoryResource())
+        : zisc::cast<zisc::pmr::memory_resource*>(&data_resource);
     hdr_image_ = zisc::UniqueMemoryPointer<HdrImage>::make(&data_resource,
                                                            image_resolution[0],
                                                            image_resolution[1],
-                                                           &data_resource);
+                                                           image_resource);
     ldr_image_ = zisc::UniqueMemoryPointer<LdrImage>::make(&data_resource,
                                                            image_resolution[0],
                                                            image_resolution[1],
-                                                           &data_resource);
+                                                           image_resource);
+    ldr_snapshot_ = zisc::UniqueMemoryPointer<LdrImage>::make(&data_resource,
+                                                              image_resolution[0],
+                                                              image_resolution[1],
+                                                              image_resource);
+    ldr_image_->setChannelOrder(ldrChannelOrder());
+    ldr_snapshot_->setChannelOrder(ldrChannelOrder());
+    using RgbBuffer = zisc::pmr::vector<std::array<float, 3>>;
+    hdr_snapshot_ = zisc::UniqueMemoryPointer<RgbBuffer>::make(
+        &data_resource,
+        hdr_image_->size(),
+        RgbBuffer::allocator_type{image_resource});
+    if constexpr (CoreConfig::pixelCostHeatmapIsEnabled()) {
+      cost_snapshot_ = zisc::UniqueMemoryPointer<RgbBuffer>::make(
+          &data_resource,
+          hdr_image_->size(),
+          RgbBuffer::allocator_type{image_resource});
+    }
+    system().recordLoadingPhase("Image allocation", start_time, start_memory);
   }
 
+  // Log the time and the memory growth of the loading phases
+  for (const auto& phase : loadingPhaseList()) {
+    const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        phase.time_);
+    const double memory = cast<double>(phase.memory_delta_) / (1024.0 * 1024.0);
+    char memory_string[32];
+    std::snprintf(memory_string, sizeof(memory_string), "%+.1f", memory);
+    const auto message = "  "s + phase.name_ + ": " +
+                         std::to_string(time.count()) + " ms, " +
+                         memory_string + " MB.";
+    logMessage(message);
+  }
+  // Log the time of the BVH construction
+  for (const auto& phase : scene().world().bvh().buildPhaseList()) {
+    const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        phase.time_);
+    const auto message = "  BVH "s + phase.name_ + ": " +
+                         std::to_string(time.count()) + " ms.";
+    logMessage(message);
+  }
+  // Log the quality of the BVH
+  {
+    const auto statistics = scene().world().bvh().calcStatistics(
+        &system().globalMemoryManager());
+    char message[256];
+    std::snprintf(message, sizeof(message),
+                  "  BVH SAH cost: %.3f, nodes: %u, leafs: %u, overlap: %.3f, "
+                  "memory: %.1f MB.",
+                  cast<double>(statistics.sah_cost_),
+                  cast<uint>(statistics.num_of_nodes_),
+                  cast<uint>(statistics.num_of_leafs_),
+                  cast<double>(statistics.overlap_ratio_),
+                  cast<double>(statistics.memory_size_) / (1024.0 * 1024.0));
+    logMessage(message);
+    auto to_string = [](const zisc::pmr::vector<uint32>& histogram)
+    {
+      std::string text;
+      for (std::size_t i = 0; i < histogram.size(); ++i) {
+        if (histogram[i] != 0)
+          text += " " + std::to_string(i) + ":" + std::to_string(histogram[i]);
+      }
+      return text;
+    };
+    logMessage("  BVH leaf depths:"s + to_string(statistics.depth_histogram_));
+    logMessage("  BVH leaf sizes:"s + to_string(statistics.occupancy_histogram_));
+  }
+  // Log the geometry which is placed in the out-of-core file
+  if (!system_settings->outOfCoreDirectory().empty()) {
+    const auto& out_of_core_resource = system().outOfCoreMemoryResource();
+    if (out_of_core_resource.isOpen()) {
+      const std::size_t mapped_size = out_of_core_resource.mappedSize() / (1024 * 1024);
+      logMessage("  Out-of-core geometry: "s + std::to_string(mapped_size) + " MiB.");
+    }
+    else {
+      logMessage("  Warning: The out-of-core file can't be made, "
+                 "the geometry is placed in memory.");
+    }
+  }
+  // Log the film which is placed in the mapped file
+  if (!system_settings->mappedFilmDirectory().empty()) {
+    const auto& film_resource = system().filmMemoryResource();
+    if (film_resource.isOpen()) {
+      const std::size_t mapped_size = film_resource.mappedSize() / (1024 * 1024);
+      logMessage("  Mapped film: "s + std::to_string(mapped_size) + " MiB.");
+    }
+    else {
+      logMessage("  Warning: The film file can't be made, "
+                 "the film is placed in memory.");
+    }
+  }
+  logMemoryUsage();
+
   //
   {
     auto termination_cycle = system_settings->terminationCycle();
@@ -146,6 +361,14 @@ bool SimpleRenderer::loadScene(const SettingNodeBase& settings,
   {
     enableSavingAtPowerOf2Cycles(system_settings->power2CycleSaving());
   }
+  {
+    // The preview which is updated at each frame needs the LDR image
+    // unless the linear image is displayed
+    is_ldr_image_output_enabled_ = system_settings->isLdrImageOutputEnabled() ||
+                                   (isSavingAtEachFrameEnabled() &&
+                                    !isLinearImageDisplayEnabled());
+    is_hdr_image_output_enabled_ = system_settings->isHdrImageOutputEnabled();
+  }
   {
     const auto time = system_settings->savingIntervalTime();
     const auto saving_interval_time = std::chrono::duration_cast<Clock::duration>(
@@ -163,16 +386,162 @@ bool SimpleRenderer::loadScene(const SettingNodeBase& settings,
 }
 
 /*!
+  \details
+  The film is cleared after the warm-up, so the measured cycles render
+  the same samples as the first cycles of a rendering, with warm caches.
+  No image, checkpoint and denoising is output.
+  The samples are the samples of all pixels of the cycles,
+  including the pixels which adaptive sampling skips.
+  */
+auto SimpleRenderer::benchmark(const uint32 warmup_cycles,
+                               const uint32 num_of_cycles) noexcept
+    -> BenchmarkResult
+{
+  BenchmarkResult result;
+  for (const auto& phase : loadingPhaseList()) {
+    result.loading_time_ += phase.time_;
+    if (std::string_view{phase.name_} == "BVH build")
+      result.bvh_build_time_ = phase.time_;
+  }
+  result.num_of_threads_ = system().threadManager().numOfThreads();
+  if (!isRunnable())
+    return result;
+
+  initForRendering();
+  for (uint32 cycle = 1; cycle <= warmup_cycles; ++cycle) {
+    clearWorkMemory();
+    renderScene(cycle);
+  }
+  initForRendering();
+
+  const auto start_time = Clock::now();
+  for (uint32 cycle = 1; cycle <= num_of_cycles; ++cycle) {
+    clearWorkMemory();
+    renderScene(cycle);
+    result.num_of_rays_ += renderingMethod().cycleCounter().totalRays();
+    // The phases are summed by the name over the cycles
+    for (const auto& phase : cycle_phase_list_) {
+      auto p = std::find_if(result.phase_list_.begin(), result.phase_list_.end(),
+      [&phase](const RenderingPhase& sum)
+      {
+        return std::string_view{sum.name_} == phase.name_;
+      });
+      if (p == result.phase_list_.end()) {
+        result.phase_list_.emplace_back(phase);
+      }
+      else {
+        p->time_ += phase.time_;
+        p->counts_.merge(phase.counts_);
+      }
+    }
+  }
+  result.rendering_time_ = Clock::now() - start_time;
+
+  const auto& resolution = system().imageResolution();
+  const uint64 num_of_pixels = zisc::cast<uint64>(resolution[0]) *
+                               zisc::cast<uint64>(resolution[1]);
+  result.num_of_cycles_ = num_of_cycles;
+  result.num_of_samples_ = num_of_pixels * system().samplesPerCycle() *
+                           zisc::cast<uint64>(num_of_cycles);
+  return result;
+}
+
+/*!
+  \details
+  The BVH build phases are the sub phases of the "BVH build" phase,
+  so they have only the time. The quality of the BVH follows the phases.
+  */
+void SimpleRenderer::outputLoadingProfile(const std::string& output_path) const noexcept
+{
+  using namespace std::string_literals;
+  using Millisecond = std::chrono::duration<double, std::milli>;
+
+  const auto profile_path = output_path + "/loading_profile.json";
+  std::ofstream profile{profile_path};
+  if (!profile.is_open())
+    return;
+
+  profile << "{\n  \"phases\": [";
+  const auto phase_list = loadingPhaseList();
+  for (std::size_t i = 0; i < phase_list.size(); ++i) {
+    const auto& phase = phase_list[i];
+    const auto time = std::chrono::duration_cast<Millisecond>(phase.time_);
+    profile << ((i == 0) ? "\n" : ",\n")
+            << "    {\"name\": \"" << phase.name_ << "\", "
+            << "\"time_ms\": " << time.count() << ", "
+            << "\"memory_delta_bytes\": " << phase.memory_delta_ << "}";
+  }
+  const auto& bvh_phase_list = scene().world().bvh().buildPhaseList();
+  for (const auto& phase : bvh_phase_list) {
+    const auto time = std::chrono::duration_cast<Millisecond>(phase.time_);
+    profile << ",\n"
+            << "    {\"name\": \"BVH build/" << phase.name_ << "\", "
+            << "\"time_ms\": " << time.count() << "}";
+  }
+  profile << "\n  ],\n";
+
+  const auto statistics = scene().world().bvh().calcStatistics(
+      &system_->globalMemoryManager());
+  auto write_histogram = [&profile](const zisc::pmr::vector<uint32>& histogram)
+  {
+    profile << "[";
+    for (std::size_t i = 0; i < histogram.size(); ++i)
+      profile << ((i == 0) ? "" : ", ") << histogram[i];
+    profile << "]";
+  };
+  profile << "  \"bvh\": {\n"
+          << "    \"sah_cost\": " << statistics.sah_cost_ << ",\n"
+          << "    \"num_of_nodes\": " << statistics.num_of_nodes_ << ",\n"
+          << "    \"num_of_leafs\": " << statistics.num_of_leafs_ << ",\n"
+          << "    \"overlap_ratio\": " << statistics.overlap_ratio_ << ",\n"
+          << "    \"memory_bytes\": " << statistics.memory_size_ << ",\n"
+          << "    \"leaf_depth_histogram\": ";
+  write_histogram(statistics.depth_histogram_);
+  profile << ",\n    \"leaf_size_histogram\": ";
+  write_histogram(statistics.occupancy_histogram_);
+  profile << "\n  }\n}\n";
+}
+
+/*!
+  \details
+  The cycles are rendered back to back. The preview images are output
+  at the display rate instead of each cycle, and the output overlaps
+  the rendering of the next cycles.
   */
 void SimpleRenderer::render(const std::string& output_path) noexcept
 {
   uint32 cycle = 0;
-  uint32 cycle_to_save_image = getNextCycleToSaveImage(cycle);
-  auto previous_time = system().stopwatch().elapsedTime();
+  initForRendering();
+  if (isRunnable() && !resume_checkpoint_path_.empty() && !loadCheckpoint(&cycle)) {
+    logMessage("Checkpoint error: resuming failed: " + resume_checkpoint_path_);
+    // Discard the partially loaded statistics
+    initForRendering();
+    cycle = 0;
+  }
+  {
+    // The deadline is the wall-clock time of this process
+    const auto& statistics = scene().film().sampleStatistics();
+    time_budget_scheduler_.reset();
+    time_budget_scheduler_.setDeadline((deadline_ != Clock::duration::zero())
+        ? resumed_time_ + deadline_
+        : Clock::duration::zero());
+    time_budget_scheduler_.setDenoisingEnabled(
+        statistics.isEnabled(SampleStatistics::Type::kDenoisedExpectedValue));
+  }
+  openStreamServer();
+
+  uint32 cycle_to_save_image = getNextCycleToSaveImage(0);
+  while (isCycleToSaveImage(cycle, cycle_to_save_image))
+    cycle_to_save_image = getNextCycleToSaveImage(cycle_to_save_image);
+  auto previous_time = elapsedTime();
   auto time_to_save_image = getNextTimeToSaveImage(previous_time);
+  auto time_to_save_frame = Clock::now();
+  auto time_to_stream_frame = Clock::now();
+  auto time_to_save_checkpoint = isCheckpointEnabled()
+      ? previous_time + checkpoint_interval_
+      : Clock::duration::max();
   bool rendering_flag = true;
 
-  initForRendering();
   updateRenderingProgress(cycle, previous_time);
 
   // Main render loop
@@ -180,27 +549,62 @@ void SimpleRenderer::render(const std::string& output_path) noexcept
     ++cycle;
 
     const bool is_last_cycle = isCycleToFinish(cycle) ||
-                               isTimeToFinish(previous_time);
+                               isTimeToFinish(previous_time) ||
+                               time_budget_scheduler_.isLastCycle(previous_time);
     rendering_flag = isRunnable() && !is_last_cycle;
 
     clearWorkMemory();
     handleCameraEvent(&cycle, &previous_time);
 
     // Render
-    renderScene(cycle);
+    {
+      const auto cycle_start_time = elapsedTime();
+      renderScene(cycle);
+      time_budget_scheduler_.recordCycle(elapsedTime() - cycle_start_time);
+    }
 
     // Save image
     bool saving_image = checkImageSavingFlag(cycle,
                                              previous_time,
                                              &cycle_to_save_image,
-                                             &time_to_save_image);
+                                             &time_to_save_image,
+                                             &time_to_save_frame);
     saving_image = saving_image || !rendering_flag;
 
     // Update rendered image and and rendering progress
-    if (saving_image)
+    if (saving_image) {
+      const auto output_start_time = elapsedTime();
       outputRenderedImage(output_path, cycle);
-    auto current_time = processElapsedTime(previous_time);
+      time_budget_scheduler_.recordOutput(elapsedTime() - output_start_time);
+      logMemoryUsage();
+    }
+
+    // Stream the frame to the remote viewer at the display frame rate
+    if (!saving_image && isStreamingEnabled() && stream_server_->isConnected()) {
+      const auto now = Clock::now();
+      if (time_to_stream_frame <= now) {
+        time_to_stream_frame = now + minTimePerFrame();
+        streamRenderedImage(cycle);
+      }
+    }
+
+    // Save checkpoint. The last cycle is saved so as to extend the rendering
+    if (isCheckpointEnabled() &&
+        (isTimeToSaveImage(previous_time, time_to_save_checkpoint) ||
+         !rendering_flag)) {
+      if (!rendering_flag)
+        waitForCheckpoint();
+      saveCheckpoint(cycle, elapsedTime());
+      time_to_save_checkpoint = previous_time + checkpoint_interval_;
+    }
+
+    // Denoise the saved image while the next cycles are rendered
+    if (saving_image && !is_last_cycle && isAsyncDenoisingEnabled())
+      runAsyncDenoising(output_path, cycle);
+
+    auto current_time = elapsedTime();
     updateRenderingProgress(cycle, current_time);
+    outputMetrics(cycle, current_time, false);
 
     // Compute denoised image and update rendering progress
     if (saving_image && is_last_cycle) {
@@ -208,13 +612,272 @@ void SimpleRenderer::render(const std::string& output_path) noexcept
       if (statistics.isEnabled(SampleStatistics::Type::kDenoisedExpectedValue)) {
         clearWorkMemory();
         outputDenoisedImage(output_path, cycle);
-        current_time = processElapsedTime(previous_time);
+        current_time = elapsedTime();
         updateRenderingProgress(cycle, current_time);
       }
     }
 
     previous_time = current_time;
   }
+  waitForDenoising();
+  waitForImageOutput();
+  waitForCheckpoint();
+  outputMetrics(cycle, elapsedTime(), true);
+  if (!trace_path_.empty())
+    outputTrace();
+  if (renderingMethod().isShadingProfileEnabled())
+    outputShadingProfile(output_path);
+}
+
+/*!
+  \details
+  The settings are the scene settings which the scene was loaded from.
+  Only the camera is remade and the film is cleared, so the world, the BVH
+  and the film of the scene are reused by the jobs. The time of a job
+  is measured from the start of the job instead of the loading.
+  */
+void SimpleRenderer::renderJob(const SettingNodeBase& settings,
+                               const RenderJob& job) noexcept
+{
+  const auto start_time = Clock::now();
+  scene().resetCamera(system(), &settings, job.camera_matrix_);
+  logSceneUpdate("camera", start_time);
+
+  // The termination of the scene settings is restored after the job
+  const uint32 scene_cycle = cycleToFinish();
+  const Clock::duration scene_time = timeToFinish();
+  if (0 < job.cycle_)
+    setCycleToFinish(job.cycle_);
+  if (job.time_ != Clock::duration::zero())
+    setTimeToFinish(job.time_);
+  resume_checkpoint_path_.clear();
+
+  auto& stopwatch = system().stopwatch();
+  stopwatch.stop();
+  stopwatch.start();
+  render(job.output_path_);
+
+  cycle_to_finish_ = scene_cycle;
+  time_to_finish_ = scene_time;
+}
+
+/*!
+  \details
+  The number is applied at the start of the next cycle without
+  restarting the rendering. The request is ignored if no scene is loaded.
+  */
+void SimpleRenderer::requestNumOfActiveThreads(const uint num_of_threads) noexcept
+{
+  if (system_)
+    system_->requestNumOfActiveThreads(num_of_threads);
+}
+
+/*!
+  */
+uint SimpleRenderer::requestedNumOfActiveThreads() const noexcept
+{
+  return system_ ? system_->requestedNumOfActiveThreads() : 0;
+}
+
+/*!
+  \details
+  The times are sorted in ascending order. The cycles are rendered until
+  the rendering time reaches a time, so the methods are compared
+  at the same time instead of the same samples. The squared errors are
+  averaged over the RGB channels, and the relative one is divided by
+  the squared reference plus 0.01 so that the dark pixels don't dominate it.
+  If the reference is empty, the errors are zero.
+  The image of the last time is written into the RGB image.
+  */
+auto SimpleRenderer::measureConvergence(
+    const std::vector<Clock::duration>& time_list,
+    const zisc::pmr::vector<std::array<float, 3>>& reference,
+    zisc::pmr::vector<std::array<float, 3>>* rgb_image) noexcept
+        -> std::vector<ConvergencePoint>
+{
+  ZISC_ASSERT(rgb_image != nullptr, "The RGB image is null.");
+  std::vector<ConvergencePoint> point_list;
+  if (!isRunnable())
+    return point_list;
+  ZISC_ASSERT(reference.empty() || (reference.size() == hdrImage().numOfPixels()),
+              "The resolution of the reference is wrong.");
+
+  initForRendering();
+  rgb_image->resize(hdrImage().size());
+  uint32 cycle = 0;
+  auto rendering_time = Clock::duration::zero();
+  point_list.reserve(time_list.size());
+  for (const auto& time : time_list) {
+    while (rendering_time < time) {
+      ++cycle;
+      clearWorkMemory();
+      const auto start_time = Clock::now();
+      renderScene(cycle);
+      rendering_time += Clock::now() - start_time;
+    }
+
+    auto& image_memory = system().imageMemoryManager();
+    convertToHdr(cycle);
+    hdrImage().toRgb(system(), rgb_image, &image_memory);
+    image_memory.reset();
+
+    ConvergencePoint point;
+    point.time_ = rendering_time;
+    point.cycle_ = cycle;
+    if (!reference.empty()) {
+      zisc::CompensatedSummation<double> squared_error{0.0},
+                                         relative_error{0.0};
+      for (std::size_t i = 0; i < reference.size(); ++i) {
+        for (std::size_t c = 0; c < 3; ++c) {
+          const double r = zisc::cast<double>(reference[i][c]);
+          const double d = zisc::cast<double>((*rgb_image)[i][c]) - r;
+          squared_error.add(d * d);
+          relative_error.add((d * d) / (r * r + 0.01));
+        }
+      }
+      const double k = 1.0 / zisc::cast<double>(3 * reference.size());
+      point.rmse_ = zisc::sqrt(k * squared_error.get());
+      point.rel_mse_ = k * relative_error.get();
+    }
+    point_list.emplace_back(point);
+  }
+  return point_list;
+}
+
+/*!
+  \details
+  Each checkpoint has to be rendered from a different sampler seed,
+  so the merged statistics are the same as the statistics of one rendering
+  of the sum of the cycles. The images of the merged statistics are output,
+  and the merged checkpoint is saved so as to resume the rendering from it.
+  */
+void SimpleRenderer::mergeCheckpoints(
+    const std::vector<std::string>& checkpoint_path_list,
+    const std::string& output_path) noexcept
+{
+  using namespace std::string_literals;
+
+  initForRendering();
+  auto& sample_statistics = scene().film().sampleStatistics();
+  auto shard = zisc::UniqueMemoryPointer<SampleStatistics>::make(
+      &system().dataMemoryManager(),
+      system());
+
+  uint32 cycle = 0;
+  std::vector<uint32> seed_list;
+  for (const auto& checkpoint_path : checkpoint_path_list) {
+    Checkpoint checkpoint;
+    if (!readCheckpoint(checkpoint_path, shard.get(), &checkpoint)) {
+      logMessage("Checkpoint error: loading failed: " + checkpoint_path);
+      continue;
+    }
+    const auto seed = std::find(seed_list.begin(), seed_list.end(), checkpoint.seed_);
+    if (seed != seed_list.end()) {
+      logMessage("Checkpoint error: the seed is already merged: " + checkpoint_path);
+      continue;
+    }
+    seed_list.emplace_back(checkpoint.seed_);
+    sample_statistics.merge(system(), *shard, cycle, checkpoint.cycle_);
+    cycle += checkpoint.cycle_;
+    // The shards are rendered at the same time
+    resumed_time_ = zisc::max(resumed_time_, checkpoint.time_);
+    logMessage("Merge "s + std::to_string(checkpoint.cycle_) + " cycles of " +
+               checkpoint_path + ".");
+  }
+  shard.reset();
+  if (cycle == 0)
+    return;
+
+  clearWorkMemory();
+  outputRenderedImage(output_path, cycle);
+  if (sample_statistics.isEnabled(SampleStatistics::Type::kDenoisedExpectedValue)) {
+    clearWorkMemory();
+    outputDenoisedImage(output_path, cycle);
+  }
+  if (!checkpoint_path_.empty())
+    saveCheckpoint(cycle, resumed_time_);
+  waitForImageOutput();
+  waitForCheckpoint();
+}
+
+/*!
+  \details
+  The denoising threads are separate from the rendering threads,
+  so the number of the rendering threads should be reduced by the number.
+  The denoiser of the scene denoises a snapshot of the statistics
+  on the threads with its own work memory.
+  The asynchronous denoising is disabled if the number is zero
+  or the scene has no denoiser.
+  */
+void SimpleRenderer::setAsyncDenoising(const uint num_of_threads) noexcept
+{
+  waitForDenoising();
+  denoising_statistics_.reset();
+  denoising_memory_.reset();
+  denoising_task_scheduler_.reset();
+  denoising_thread_manager_.reset();
+
+  const auto& statistics = scene().film().sampleStatistics();
+  if ((num_of_threads == 0) ||
+      !statistics.isEnabled(SampleStatistics::Type::kDenoisedExpectedValue))
+    return;
+
+  auto& data_resource = system().dataMemoryManager();
+  denoising_thread_manager_ = zisc::UniqueMemoryPointer<zisc::ThreadManager>::make(
+      &data_resource,
+      num_of_threads,
+      &data_resource);
+  denoising_task_scheduler_ = zisc::UniqueMemoryPointer<TaskScheduler>::make(
+      &data_resource,
+      num_of_threads,
+      false);
+  denoising_memory_ = zisc::UniqueMemoryPointer<System::MemoryManager>::make(
+      &data_resource);
+  denoising_statistics_ = zisc::UniqueMemoryPointer<SampleStatistics>::make(
+      &data_resource,
+      system());
+}
+
+/*!
+  \details
+  A large image is denoised region by region under the budget.
+  The budget is unbounded if it's zero.
+  */
+void SimpleRenderer::setDenoisingMemoryBudget(const std::size_t budget) noexcept
+{
+  if (system().hasDenoiser())
+    system().denoiser().setMemoryBudget(budget);
+}
+
+/*!
+  \details
+  No checkpoint is saved if the interval is zero.
+  */
+void SimpleRenderer::setCheckpoint(const std::string& checkpoint_path,
+                                   const Clock::duration& interval) noexcept
+{
+  checkpoint_path_ = checkpoint_path;
+  checkpoint_interval_ = (interval == Clock::duration::zero())
+      ? Clock::duration::max()
+      : interval;
+}
+
+/*!
+  \details
+  The last cycle is chosen so that the final output finishes in the time,
+  which is measured from the start of the process (or the job)
+  instead of the rendering time of a checkpoint. Zero disables the deadline.
+  */
+void SimpleRenderer::setDeadline(const Clock::duration& deadline) noexcept
+{
+  deadline_ = deadline;
+}
+
+/*!
+  */
+void SimpleRenderer::setFinishingTime(const Clock::duration& time) noexcept
+{
+  time_budget_scheduler_.setFinishingTime(time);
 }
 
 /*!
@@ -224,6 +887,16 @@ void SimpleRenderer::setLogStream(std::ostream* log_stream) noexcept
   log_stream_ = log_stream;
 }
 
+/*!
+  \details
+  The metrics are written only if the metrics file is set.
+  */
+void SimpleRenderer::setMetricsFile(const std::string& metrics_path,
+                                    const Clock::duration& interval) noexcept
+{
+  metrics_writer_.setFile(metrics_path, interval);
+}
+
 /*!
   */
 void SimpleRenderer::setProgressCallback(
@@ -234,17 +907,112 @@ void SimpleRenderer::setProgressCallback(
 }
 
 /*!
+  \details
+  The scene has to be the same as the scene of the checkpoint.
+  */
+void SimpleRenderer::setResumeCheckpoint(const std::string& checkpoint_path) noexcept
+{
+  resume_checkpoint_path_ = checkpoint_path;
+}
+
+/*!
+  \details
+  The server is started when the rendering starts and a viewer can
+  connect at any time. The frames are tone mapped at the display frame rate
+  while a viewer is connected and the camera events of the viewer
+  restart the rendering.
   */
-void SimpleRenderer::enableSavingAtEachCycle(const bool flag) noexcept
+void SimpleRenderer::setStreamPort(const uint16 port) noexcept
 {
-  is_saving_each_cycle_enabled_ = flag;
+  stream_port_ = port;
 }
 
 /*!
+  \details
+  The timeline is recorded only if the trace file is set,
+  and it is written when the rendering finishes.
   */
-void SimpleRenderer::handleCameraEvent(uint32*,
-                                       Clock::duration*) noexcept
+void SimpleRenderer::setTraceFile(const std::string& trace_path) noexcept
 {
+  trace_path_ = trace_path;
+  system().traceRecorder().enable(!trace_path_.empty());
+}
+
+/*!
+  \details
+  The settings are the scene settings which the scene was loaded from.
+  Only the film is cleared, so the next rendering starts from the first cycle
+  without loading the scene. It has to be called while the scene isn't rendered.
+  */
+void SimpleRenderer::transformObject(const SettingNodeBase& settings,
+                                     const uint index,
+                                     const Matrix4x4& matrix) noexcept
+{
+  const auto start_time = Clock::now();
+  const bool is_light_source = scene().world().transformObject(system(),
+                                                               index,
+                                                               matrix);
+  if (is_light_source)
+    remakeLightSampling(settings);
+  initForRendering();
+  logSceneUpdate("object " + std::to_string(index), start_time);
+}
+
+/*!
+  \details
+  The settings are the scene settings which the scene was loaded from.
+  Only the film is cleared, so the next rendering starts from the first cycle
+  without loading the scene. It has to be called while the scene isn't rendered.
+  */
+void SimpleRenderer::updateSurface(const SettingNodeBase& settings,
+                                   const uint index) noexcept
+{
+  const auto start_time = Clock::now();
+  scene().world().updateSurface(system(), &settings, index);
+  cacheSurfaceNames(settings);
+  initForRendering();
+  logSceneUpdate("surface " + std::to_string(index), start_time);
+}
+
+/*!
+  \details
+  The settings are the scene settings which the scene was loaded from.
+  The emitters are remade with the surfaces, so the light samplers are too.
+  It has to be called while the scene isn't rendered.
+  */
+void SimpleRenderer::updateTexture(const SettingNodeBase& settings,
+                                   const uint index) noexcept
+{
+  const auto start_time = Clock::now();
+  scene().world().updateTexture(system(), &settings, index);
+  remakeLightSampling(settings);
+  initForRendering();
+  logSceneUpdate("texture " + std::to_string(index), start_time);
+}
+
+/*!
+  \details
+  The flag has to be set before the renderer is initialized.
+  */
+void SimpleRenderer::enableLinearImageDisplay(const bool flag) noexcept
+{
+  is_linear_image_display_enabled_ = flag;
+}
+
+/*!
+  */
+void SimpleRenderer::enableSavingAtEachFrame(const bool flag) noexcept
+{
+  is_saving_each_frame_enabled_ = flag;
+}
+
+/*!
+  */
+void SimpleRenderer::handleCameraEvent(uint32* cycle,
+                                       Clock::duration* time) noexcept
+{
+  if (isStreamingEnabled() && transformCamera(&stream_server_->cameraEvent()))
+    restartRendering(cycle, time);
 }
 
 /*!
@@ -254,39 +1022,232 @@ void SimpleRenderer::initForRendering() noexcept
   if (isRunnable()) {
     renderingMethod().initMethod();
     scene().film().clear();
+    hdrImage().invalidate();
+  }
+  resumed_time_ = Clock::duration::zero();
+}
+
+/*!
+  */
+void SimpleRenderer::restartRendering(uint32* cycle,
+                                      Clock::duration* time) noexcept
+{
+  // Reset rendering info
+  initForRendering();
+  ZISC_ASSERT(cycle != nullptr, "The cycle is null.");
+  ZISC_ASSERT(time != nullptr, "The time is null.");
+  auto& stopwatch = system().stopwatch();
+  stopwatch.stop();
+  stopwatch.start();
+  *cycle = 0;
+  *time = Clock::duration::zero();
+}
+
+/*!
+  \details
+  The events of the frame are flushed at once.
+  */
+bool SimpleRenderer::transformCamera(CameraEvent* camera_event) noexcept
+{
+  ZISC_ASSERT(camera_event != nullptr, "The camera event is null.");
+  Vector2 horizontal_translation,
+          vertical_translation,
+          rotation;
+  const bool is_moved = camera_event->flushEvents(&horizontal_translation,
+                                                  &vertical_translation,
+                                                  &rotation);
+  if (is_moved) {
+    auto& camera = scene().camera();
+    if (CameraEvent::hasValue(horizontal_translation))
+      camera.translateHorizontally(horizontal_translation);
+    if (CameraEvent::hasValue(vertical_translation))
+      camera.translateVertically(vertical_translation);
+    if (CameraEvent::hasValue(rotation))
+      camera.rotate(rotation);
   }
+  return is_moved;
 }
 
 /*!
   */
 void SimpleRenderer::logMessage(const std::string_view& message) noexcept
 {
+  // The image output can log from the other thread
+  std::unique_lock<std::mutex> lock{log_mutex_};
   if (log_stream_ != nullptr)
     (*log_stream_) << message << std::endl;
 }
 
 /*!
+  \details
+  The throughput is the rays of all kinds per second of the rendering time
+  of the cycle. The node visits and the primitive tests are per ray.
+  */
+void SimpleRenderer::logRenderingCounter(const RenderingCounter& counter,
+                                         const Clock::duration& time) noexcept
+{
+  using Second = std::chrono::duration<double>;
+  const double seconds = std::chrono::duration_cast<Second>(time).count();
+  const double total_rays = zisc::cast<double>(counter.totalRays());
+  const double mrays_per_second = (0.0 < seconds)
+      ? total_rays / (seconds * 1.0e6)
+      : 0.0;
+  const double inverse_rays = (0 < counter.totalRays()) ? 1.0 / total_rays : 0.0;
+  char message[256];
+  std::snprintf(
+      message, sizeof(message),
+      "  Rays: %llu primary, %llu secondary, %llu shadow, %.2f Mrays/s. "
+      "Per ray: %.1f nodes, %.1f primitives. "
+      "Paths: %.2f average length, %llu roulette terminations, %llu photons.",
+      zisc::cast<unsigned long long>(counter.numOfRays(RayCastType::kPrimary)),
+      zisc::cast<unsigned long long>(counter.numOfRays(RayCastType::kSecondary)),
+      zisc::cast<unsigned long long>(counter.numOfRays(RayCastType::kShadow)),
+      mrays_per_second,
+      zisc::cast<double>(counter.numOfNodeVisits()) * inverse_rays,
+      zisc::cast<double>(counter.numOfPrimitiveTests()) * inverse_rays,
+      counter.averagePathLength(),
+      zisc::cast<unsigned long long>(counter.numOfRouletteTerminations()),
+      zisc::cast<unsigned long long>(counter.numOfPhotons()));
+  logMessage(message);
+}
+
+/*!
+  \details
+  The misses are also logged per kilo instructions,
+  which tell a memory-bound phase from a compute-bound phase.
+  The counts which the processor doesn't count are skipped.
+  */
+void SimpleRenderer::logHardwareCounts(const std::string_view& name,
+                                       const HardwareCounts& counts) noexcept
+{
+  if (!counts.isValid())
+    return;
+  const double instructions = zisc::cast<double>(
+      counts.count(HardwareEvent::kInstructions));
+  const double inverse_kilo_instructions = (0.0 < instructions)
+      ? 1000.0 / instructions
+      : 0.0;
+  std::string message{"  "};
+  message += name;
+  message += ": ";
+  char value[64];
+  for (uint i = 0; i < HardwareCounts::numOfEvents(); ++i) {
+    const auto event = zisc::cast<HardwareEvent>(i);
+    if (!counts.isValid(event))
+      continue;
+    const uint64 count = counts.count(event);
+    const bool is_miss = (event != HardwareEvent::kCycles) &&
+                         (event != HardwareEvent::kInstructions);
+    if (is_miss && counts.isValid(HardwareEvent::kInstructions)) {
+      std::snprintf(value, sizeof(value), "%llu %s (%.2f PKI), ",
+                    zisc::cast<unsigned long long>(count),
+                    HardwareCounts::eventName(event),
+                    zisc::cast<double>(count) * inverse_kilo_instructions);
+    }
+    else {
+      std::snprintf(value, sizeof(value), "%llu %s, ",
+                    zisc::cast<unsigned long long>(count),
+                    HardwareCounts::eventName(event));
+    }
+    message += value;
+  }
+  if (counts.isValid(HardwareEvent::kCycles) &&
+      counts.isValid(HardwareEvent::kInstructions)) {
+    std::snprintf(value, sizeof(value), "%.2f IPC, ", counts.instructionsPerCycle());
+    message += value;
+  }
+  message.replace(message.size() - 2, 2, ".");
+  logMessage(message);
+}
+
+/*!
+  \details
+  The usage is the memory currently allocated in each category
+  and the peak is the high-water mark of the category.
   */
-void SimpleRenderer::outputLdrImage(const std::string_view output_path,
+void SimpleRenderer::logMemoryUsage() noexcept
+{
+  using namespace std::string_literals;
+  constexpr double to_mb = 1.0 / (1024.0 * 1024.0);
+  std::string message = "  Memory usage:";
+  for (uint i = 0; i < System::numOfMemoryCategories(); ++i) {
+    const auto category = zisc::cast<MemoryCategory>(i);
+    const auto& resource = system().trackedMemoryResource(category);
+    char usage[64];
+    std::snprintf(usage, sizeof(usage), " %.1f MB (peak %.1f MB)",
+                  zisc::cast<double>(resource.usedSize()) * to_mb,
+                  zisc::cast<double>(resource.peakSize()) * to_mb);
+    message += ((i == 0) ? " "s : ", "s) + System::memoryCategoryName(category) +
+               usage;
+  }
+  message += ".";
+  logMessage(message);
+}
+
+/*!
+  \details
+  The CUI renderer has no display.
+  */
+void SimpleRenderer::outputDisplayImage(
+    const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+    const uint32 cycle) noexcept
+{
+  static_cast<void>(rgb_image);
+  static_cast<void>(cycle);
+}
+
+/*!
+  */
+void SimpleRenderer::outputHdrImage(
+    const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+    const std::string_view output_path,
+    const uint32 cycle,
+    const std::string_view suffix) noexcept
+{
+  const auto hdr_image_path = makeImagePath(output_path, cycle, suffix,
+                                            HdrImage::pfmFileExtension());
+  const bool result = HdrImage::writePfm(rgb_image,
+                                         hdrImage().resolution(),
+                                         hdr_image_path.c_str());
+  if (!result)
+    logMessage("PFM error: saving image failed: " + hdr_image_path);
+}
+
+/*!
+  \details
+  LodePNG reads the pixels in the RGBA order.
+  */
+LdrImage::ChannelOrder SimpleRenderer::ldrChannelOrder() const noexcept
+{
+  return LdrImage::ChannelOrder::kRgba;
+}
+
+/*!
+  \details
+  The tone mapping writes the pixels in the order of LodePNG,
+  so the snapshot is encoded as it is.
+  */
+void SimpleRenderer::outputLdrImage(LdrImage* ldr_image,
+                                    const std::string_view output_path,
                                     const uint32 cycle,
                                     const std::string_view suffix) noexcept
 {
 #ifdef NANAIRO_HAS_LODEPNG
-  processLdrForLodepng();
-
+  ZISC_ASSERT(ldr_image->channelOrder() == LdrImage::ChannelOrder::kRgba,
+              "The channel order of the LDR image is wrong.");
   const auto ldr_image_path = makeImagePath(output_path, cycle, suffix);
-  const auto& ldr_image = ldrImage();
-  const auto& buffer = ldr_image.data();
+  const auto& buffer = ldr_image->data();
   auto error = lodepng::encode(ldr_image_path,
                                zisc::treatAs<const uint8*>(buffer.data()),
-                               ldr_image.widthResolution(),
-                               ldr_image.heightResolution());
+                               ldr_image->widthResolution(),
+                               ldr_image->heightResolution());
   if (error) {
     const auto message = "LodePNG error[" + std::to_string(error) + "]: " +
                          lodepng_error_text(error);
     logMessage(message);
   }
 #else // NANAIRO_HAS_LODEPNG
+  static_cast<void>(ldr_image);
   static_cast<void>(output_path);
   static_cast<void>(cycle);
   static_cast<void>(suffix);
@@ -300,10 +1261,19 @@ bool SimpleRenderer::checkImageSavingFlag(
     const uint32 cycle,
     const Clock::duration previous_time,
     uint32* cycle_to_save_image,
-    Clock::duration* time_to_save_image) const noexcept
+    Clock::duration* time_to_save_image,
+    Clock::time_point* time_to_save_frame) const noexcept
 {
   // Save image
-  bool saving_image = isSavingAtEachCycleEnabled();
+  bool saving_image = false;
+  if (isSavingAtEachFrameEnabled()) {
+    // The frames are timed by the clock, since a restart resets the time
+    const auto now = Clock::now();
+    if (*time_to_save_frame <= now) {
+      *time_to_save_frame = now + minTimePerFrame();
+      saving_image = true;
+    }
+  }
   if (isCycleToSaveImage(cycle, *cycle_to_save_image)) {
     *cycle_to_save_image = getNextCycleToSaveImage(*cycle_to_save_image);
     saving_image = true;
@@ -315,6 +1285,57 @@ bool SimpleRenderer::checkImageSavingFlag(
   return saving_image;
 }
 
+/*!
+  \details
+  The names of the surfaces are in the settings, since the surface models
+  keep their names only in the debug mode.
+  */
+void SimpleRenderer::cacheSurfaceNames(const SettingNodeBase& settings) noexcept
+{
+  auto get_type_name = [](const SurfaceType type) noexcept
+  {
+    const char* name = "Unknown";
+    switch (type) {
+     case SurfaceType::kSmoothDiffuse:
+      name = "SmoothDiffuse";
+      break;
+     case SurfaceType::kSmoothDielectric:
+      name = "SmoothDielectric";
+      break;
+     case SurfaceType::kSmoothConductor:
+      name = "SmoothConductor";
+      break;
+     case SurfaceType::kRoughDielectric:
+      name = "RoughDielectric";
+      break;
+     case SurfaceType::kRoughConductor:
+      name = "RoughConductor";
+      break;
+     case SurfaceType::kLayeredDiffuse:
+      name = "LayeredDiffuse";
+      break;
+     case SurfaceType::kCloth:
+      name = "Cloth";
+      break;
+     default:
+      break;
+    }
+    return name;
+  };
+
+  const auto scene_settings = castNode<SceneSettingNode>(&settings);
+  const auto surface_model_settings = castNode<SurfaceModelSettingNode>(
+      scene_settings->surfaceModelSettingNode());
+  const auto& surface_setting_list = surface_model_settings->materialList();
+  surface_name_list_.clear();
+  surface_type_list_.clear();
+  for (const auto material_settings : surface_setting_list) {
+    const auto surface_settings = castNode<SurfaceSettingNode>(material_settings);
+    surface_name_list_.emplace_back(surface_settings->name());
+    surface_type_list_.emplace_back(get_type_name(surface_settings->surfaceType()));
+  }
+}
+
 /*!
   */
 inline
@@ -331,6 +1352,44 @@ void SimpleRenderer::clearWorkMemory() noexcept
   }
 }
 
+/*!
+  */
+inline
+void SimpleRenderer::convertToHdr(const uint32 cycle) noexcept
+{
+  const auto& film = scene().film();
+  const auto& sample_statistics = film.sampleStatistics();
+  auto& hdr_image = hdrImage();
+  if (sample_statistics.isEnabled(SampleStatistics::Type::kSampleCount)) {
+    hdr_image.toHdr(system(),
+                    sample_statistics.sampleCountTable(),
+                    sample_statistics.sampleTable());
+  }
+  else {
+    hdr_image.toHdr(system(), cycle, sample_statistics.sampleTable());
+  }
+}
+
+/*!
+  */
+inline
+auto SimpleRenderer::elapsedTime() const noexcept -> Clock::duration
+{
+  return resumed_time_ + system().stopwatch().elapsedTime();
+}
+
+/*!
+  */
+std::vector<LoadingPhase> SimpleRenderer::loadingPhaseList() const noexcept
+{
+  std::vector<LoadingPhase> phase_list{preloading_phase_list_};
+  const auto& system_phase_list = system().loadingPhaseList();
+  phase_list.insert(phase_list.end(),
+                    system_phase_list.begin(),
+                    system_phase_list.end());
+  return phase_list;
+}
+
 /*!
   */
 double SimpleRenderer::getCurrentFps(const uint32 cycle,
@@ -384,13 +1443,111 @@ void SimpleRenderer::initialize() noexcept
 {
 }
 
+/*!
+  \details
+  The samplers generate a sample from the seed and the cycle,
+  so the statistics and the cycle are enough to resume the rendering.
+  */
+bool SimpleRenderer::loadCheckpoint(uint32* cycle) noexcept
+{
+  auto& sample_statistics = scene().film().sampleStatistics();
+  Checkpoint checkpoint;
+  const bool result = readCheckpoint(resume_checkpoint_path_,
+                                     &sample_statistics,
+                                     &checkpoint) &&
+                      (checkpoint.seed_ == system().samplerSeed());
+  if (result) {
+    *cycle = checkpoint.cycle_;
+    resumed_time_ = checkpoint.time_;
+    hdrImage().invalidate();
+    using namespace std::string_literals;
+    logMessage("Resume the rendering at "s + std::to_string(checkpoint.cycle_) +
+               " cycles.");
+  }
+  return result;
+}
+
+/*!
+  */
+void SimpleRenderer::logSceneUpdate(const std::string_view& name,
+                                    const Clock::time_point start_time) noexcept
+{
+  using namespace std::string_literals;
+  const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - start_time);
+  logMessage("Update the "s + name.data() + ": " + std::to_string(time.count()) +
+             " ms.");
+}
+
+/*!
+  \details
+  The wavelength sampler and the light samplers of the rendering method
+  weight the emitters, so they are remade after the emitters or
+  the emissive objects are changed. The preview scale is kept.
+  */
+void SimpleRenderer::remakeLightSampling(const SettingNodeBase& settings) noexcept
+{
+  const auto scene_settings = castNode<SceneSettingNode>(&settings);
+  const auto system_settings = scene_settings->systemSettingNode();
+
+  std::mutex data_mutex;
+  auto& data_resource = system().dataMemoryManager();
+  data_resource.setMutex(&data_mutex);
+
+  wavelength_sampler_ = zisc::UniqueMemoryPointer<WavelengthSampler>::make(
+      &data_resource,
+      scene().world(),
+      system_settings);
+  {
+    const uint preview_scale = renderingMethod().previewScale();
+    const auto method_settings = scene_settings->renderingMethodSettingNode();
+    rendering_method_ = RenderingMethod::makeMethod(system(),
+                                                    method_settings,
+                                                    scene());
+    rendering_method_->setPreviewScale(preview_scale);
+    setTileWavelengthSampler();
+  }
+
+  data_resource.setMutex(nullptr);
+}
+
+/*!
+  \details
+  The statistics have to be made from the system of the rendered scene,
+  since the tables of the statistics are validated against the data.
+  */
+bool SimpleRenderer::readCheckpoint(const std::string& checkpoint_path,
+                                    SampleStatistics* sample_statistics,
+                                    Checkpoint* checkpoint) noexcept
+{
+  std::ifstream checkpoint_file{checkpoint_path, std::ios::binary};
+  if (!checkpoint_file.is_open())
+    return false;
+
+  uint32 magic_number = 0;
+  zisc::read(&magic_number, &checkpoint_file);
+  uint32 version = 0;
+  zisc::read(&version, &checkpoint_file);
+  zisc::read(&checkpoint->cycle_, &checkpoint_file);
+  zisc::read(&checkpoint->seed_, &checkpoint_file);
+  uint64 time = 0;
+  zisc::read(&time, &checkpoint_file);
+  checkpoint->time_ = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::milliseconds{time});
+  const bool result = checkpoint_file.good() &&
+                      (magic_number == checkpointMagicNumber()) &&
+                      (version == checkpointVersion()) &&
+                      sample_statistics->readData(&checkpoint_file);
+  return result;
+}
+
 /*!
   */
 void SimpleRenderer::notifyOfDenoisingProgress(const double progress) const noexcept 
 {
   using namespace std::string_literals;
   if (progress_callback_) {
-    const auto elapsed_time = system().stopwatch().elapsedTime();
+    const auto elapsed_time = elapsedTime();
     const auto times = getCurrentTime(elapsed_time);
 
     auto status = "Denoising...                     0000 h 00 m 00.000 s"s;
@@ -419,7 +1576,13 @@ void SimpleRenderer::notifyOfRenderingProgress(
     const double time_progress = (0 < time_to_finish)
         ? zisc::cast<double>(time.count()) / zisc::cast<double>(time_to_finish)
         : 0.0;
-    double progress = zisc::max(cycle_progress, time_progress);
+    const double deadline = zisc::cast<double>(
+        time_budget_scheduler_.deadline().count());
+    const double deadline_progress = time_budget_scheduler_.hasDeadline()
+        ? zisc::cast<double>(time.count()) / deadline
+        : 0.0;
+    double progress = zisc::max(cycle_progress,
+                                zisc::max(time_progress, deadline_progress));
     progress = zisc::clamp(progress, 0.0, 1.0);
     progress_callback_(progress, status);
   }
@@ -432,6 +1595,10 @@ void SimpleRenderer::outputDenoisedImage(
     const std::string& output_path,
     const uint32 cycle) noexcept
 {
+  // The denoiser is used by only one denoising at a time
+  waitForDenoising();
+  waitForImageOutput();
+
   auto& sample_statistics = scene().film().sampleStatistics();
   auto& denoiser = system().denoiser();
 
@@ -443,59 +1610,368 @@ void SimpleRenderer::outputDenoisedImage(
   denoiser.setProgressCallback(notify_progress);
 
   // Start denoising
-  denoiser.denoise(system(), cycle, &sample_statistics);
+  {
+    TraceRecorder::Scope scope{system().traceRecorder(), "Denoising"};
+    const auto start_counts = system().readHardwareCounters();
+    DenoisingContext context{system()};
+    denoiser.denoise(context, cycle, &sample_statistics);
+    if (system().isHardwareCounterEnabled()) {
+      const auto counts = system().readHardwareCounters().since(start_counts);
+      logHardwareCounts("Denoising", counts);
+    }
+  }
+
+  outputDenoisedImage(sample_statistics, output_path, cycle);
+}
+
+/*!
+  */
+void SimpleRenderer::outputDenoisedImage(
+    const SampleStatistics& statistics,
+    const std::string& output_path,
+    const uint32 cycle) noexcept
+{
+  waitForImageOutput();
+  TraceRecorder::Scope scope{system().traceRecorder(), "Denoised image saving"};
 
   // Convert sampled value to HDR imave
   auto& hdr_image = hdrImage();
-  hdr_image.toHdr(system(), 1, sample_statistics.denoisedSampleTable());
+  hdr_image.toHdr(system(), 1, statistics.denoisedSampleTable());
 
-  toneMap();
-  outputLdrImage(output_path, cycle, "cycle-denoised");
+  auto& work_resource = system().globalMemoryManager();
+  if (isLdrImageOutputEnabled()) {
+    toneMap(&work_resource);
+    makeLdrSnapshot();
+    outputLdrImage(ldr_snapshot_.get(), output_path, cycle, "cycle-denoised");
+  }
+  if (isHdrImageOutputEnabled()) {
+    hdr_image.toRgb(system(), hdr_snapshot_.get(), &work_resource);
+    outputHdrImage(*hdr_snapshot_, output_path, cycle, "cycle-denoised");
+  }
 }
 
 /*!
+  \details
+  The metrics of the renderer are added to the counts which the writer
+  accumulates. A task is running if its future isn't ready.
+  The metrics are always written at the finish, so the last file shows
+  the final counts and no running task.
+  */
+void SimpleRenderer::outputMetrics(const uint32 cycle,
+                                   const Clock::duration& time,
+                                   const bool is_finished) noexcept
+{
+  const auto now = Clock::now();
+  if (!(metrics_writer_.isTimeToWrite(now) ||
+        (is_finished && metrics_writer_.isEnabled())))
+    return;
+
+  using namespace std::string_literals;
+  using Seconds = std::chrono::duration<double>;
+  auto& writer = metrics_writer_;
+  writer.addMetric("nanairo_cycles", "counter", "The number of the rendered cycles.");
+  writer.addValue("nanairo_cycles", zisc::cast<double>(cycle));
+  writer.addMetric("nanairo_cycles_to_finish", "gauge",
+                   "The cycle which the rendering finishes at, 0 is unlimited.");
+  const uint32 cycle_to_finish = cycleToFinish();
+  writer.addValue("nanairo_cycles_to_finish",
+                  (cycle_to_finish != std::numeric_limits<uint32>::max())
+                      ? zisc::cast<double>(cycle_to_finish)
+                      : 0.0);
+  writer.addMetric("nanairo_elapsed_seconds", "gauge",
+                   "The elapsed time of the rendering.");
+  writer.addValue("nanairo_elapsed_seconds",
+                  std::chrono::duration_cast<Seconds>(time).count());
+  writer.addMetric("nanairo_remaining_seconds", "gauge",
+                   "The estimated remaining time, -1 is unknown.");
+  {
+    const auto remaining_time = time_budget_scheduler_.estimateRemainingTime(
+        cycle,
+        time,
+        cycle_to_finish,
+        timeToFinish());
+    double remaining_seconds = -1.0;
+    if (is_finished)
+      remaining_seconds = 0.0;
+    else if (remaining_time != Clock::duration::max())
+      remaining_seconds = std::chrono::duration_cast<Seconds>(remaining_time).count();
+    writer.addValue("nanairo_remaining_seconds", remaining_seconds);
+  }
+  writer.addMetric("nanairo_finished", "gauge", "1 if the rendering finished.");
+  writer.addValue("nanairo_finished", is_finished ? 1.0 : 0.0);
+
+  // Threads
+  const uint num_of_threads = system().threadManager().numOfThreads();
+  writer.addMetric("nanairo_threads", "gauge", "The number of the rendering threads.");
+  writer.addValue("nanairo_threads", zisc::cast<double>(num_of_threads));
+  writer.addMetric("nanairo_active_threads", "gauge",
+                   "The number of the threads which render the cycle.");
+  writer.addValue("nanairo_active_threads",
+                  zisc::cast<double>(system().numOfActiveThreads()));
+
+  // Memory
+  writer.addMetric("nanairo_memory_bytes", "gauge",
+                   "The memory which is allocated in each category.");
+  for (uint i = 0; i < System::numOfMemoryCategories(); ++i) {
+    const auto category = zisc::cast<MemoryCategory>(i);
+    const auto& resource = system().trackedMemoryResource(category);
+    const std::string label = "category=\""s +
+                              System::memoryCategoryName(category) + "\"";
+    writer.addValue("nanairo_memory_bytes",
+                    zisc::cast<double>(resource.usedSize()),
+                    label);
+  }
+  writer.addMetric("nanairo_memory_peak_bytes", "gauge",
+                   "The peak memory which is allocated in each category.");
+  for (uint i = 0; i < System::numOfMemoryCategories(); ++i) {
+    const auto category = zisc::cast<MemoryCategory>(i);
+    const auto& resource = system().trackedMemoryResource(category);
+    const std::string label = "category=\""s +
+                              System::memoryCategoryName(category) + "\"";
+    writer.addValue("nanairo_memory_peak_bytes",
+                    zisc::cast<double>(resource.peakSize()),
+                    label);
+  }
+  writer.addMetric("nanairo_resident_memory_bytes", "gauge",
+                   "The resident memory of the process.");
+  writer.addValue("nanairo_resident_memory_bytes",
+                  zisc::cast<double>(residentMemorySize()));
+
+  // Tasks
+  auto is_running = [](const std::future<void>& task)
+  {
+    return task.valid() &&
+           (task.wait_for(std::chrono::seconds{0}) != std::future_status::ready);
+  };
+  writer.addMetric("nanairo_task_running", "gauge",
+                   "1 if the background task is running.");
+  writer.addValue("nanairo_task_running",
+                  is_running(denoising_task_) ? 1.0 : 0.0,
+                  "task=\"denoising\"");
+  writer.addValue("nanairo_task_running",
+                  is_running(image_output_task_) ? 1.0 : 0.0,
+                  "task=\"image_saving\"");
+  writer.addValue("nanairo_task_running",
+                  is_running(checkpoint_task_) ? 1.0 : 0.0,
+                  "task=\"checkpoint_saving\"");
+  writer.addMetric("nanairo_denoising_cycle", "gauge",
+                   "The cycle of the last denoised snapshot.");
+  writer.addValue("nanairo_denoising_cycle", zisc::cast<double>(denoising_cycle_));
+
+  if (!writer.write(now, num_of_threads))
+    logMessage("Metrics error: writing failed.");
+}
+
+/*!
+  \details
+  The red, green and blue channels of the heatmap are
+  the mean BVH node visits, primitive tests and processor cycles
+  of the camera paths of a pixel. The values aren't normalized,
+  so the channels are viewed separately in an image viewer.
+  */
+void SimpleRenderer::outputPixelCostImage(const std::string& output_path,
+                                          const uint32 cycle) noexcept
+{
+  const auto& sample_statistics = scene().film().sampleStatistics();
+  if (!sample_statistics.isEnabled(SampleStatistics::Type::kPixelCost))
+    return;
+
+  const auto& cost_table = sample_statistics.pixelCostTable();
+  const auto& count_table = sample_statistics.pixelCostCountTable();
+  auto& cost_image = *cost_snapshot_;
+  const uint width = sample_statistics.resolution()[0];
+  for (std::size_t index = 0; index < cost_image.size(); ++index) {
+    const uint x = zisc::cast<uint>(index % width);
+    const uint y = zisc::cast<uint>(index / width);
+    const uint t = sample_statistics.getIndex(Index2d{x, y});
+    const uint32 n = count_table[t];
+    const float k = (0 < n) ? 1.0f / zisc::cast<float>(n) : 0.0f;
+    for (uint i = 0; i < 3; ++i)
+      cost_image[index][i] = k * zisc::cast<float>(cost_table[3 * t + i]);
+  }
+  outputHdrImage(cost_image, output_path, cycle, "cycle-cost");
+}
+
+/*!
+  \details
+  The sampled values are converted to the HDR image at the cycle,
+  then the tone mapping and the LDR output run on other threads
+  so that they overlap the rendering of the next cycles.
+  The LDR image is double buffered, the tone mapping writes the next image
+  while the previous snapshot is being encoded and saved.
+  So the rendering waits only if the saving takes longer than two intervals.
+  The tone mapping is skipped if only the HDR image is output.
+  The tone mapped image is also streamed to the remote viewer.
+  The display which maps the linear RGB snapshot by itself
+  reads the snapshot of the HDR output.
   */
 inline
 void SimpleRenderer::outputRenderedImage(
     const std::string& output_path,
     const uint32 cycle) noexcept
 {
-  const auto& film = scene().film();
-  const auto& sample_statistics = film.sampleStatistics();
+  waitForToneMapping();
+  const bool is_tone_mapped = isLdrImageOutputEnabled() || isStreamingEnabled();
+  const bool is_rgb_snapshot_made = isHdrImageOutputEnabled() ||
+                                    isLinearImageDisplayEnabled();
+  if (!is_tone_mapped && !is_rgb_snapshot_made)
+    return;
 
   // Convert sampled value to HDR imave
-  auto& hdr_image = hdrImage();
-  hdr_image.toHdr(system(), cycle, sample_statistics.sampleTable());
+  convertToHdr(cycle);
 
-  toneMap();
-  outputLdrImage(output_path, cycle, "cycle");
+  auto map_image = [this, output_path, cycle, is_tone_mapped, is_rgb_snapshot_made]()
+  {
+    auto& image_memory = system().imageMemoryManager();
+    if (is_tone_mapped)
+      toneMap(&image_memory);
+    if (isStreamingEnabled())
+      stream_server_->submitFrame(ldrImage(), cycle);
+
+    // The snapshots are reused after the previous output finishes
+    if (image_output_task_.valid())
+      image_output_task_.wait();
+    if (isLdrImageOutputEnabled())
+      makeLdrSnapshot();
+    if (is_rgb_snapshot_made)
+      hdrImage().toRgb(system(), hdr_snapshot_.get(), &image_memory);
+    image_memory.reset();
+
+    auto output_image = [this, output_path, cycle]()
+    {
+      TraceRecorder::Scope scope{system().traceRecorder(), "Image saving"};
+      if (isLinearImageDisplayEnabled())
+        outputDisplayImage(*hdr_snapshot_, cycle);
+      if (isLdrImageOutputEnabled())
+        outputLdrImage(ldr_snapshot_.get(), output_path, cycle, "cycle");
+      if (isHdrImageOutputEnabled())
+        outputHdrImage(*hdr_snapshot_, output_path, cycle, "cycle");
+    };
+    image_output_task_ = std::async(std::launch::async, output_image);
+  };
+  tone_mapping_task_ = std::async(std::launch::async, map_image);
+
+  if constexpr (CoreConfig::pixelCostHeatmapIsEnabled())
+    outputPixelCostImage(output_path, cycle);
 }
 
 /*!
   */
 inline
-auto SimpleRenderer::processElapsedTime(
-    const Clock::duration& previous_time) const noexcept -> Clock::duration
+void SimpleRenderer::makeLdrSnapshot() noexcept
+{
+  const auto& source = ldrImage().data();
+  auto& snapshot = ldr_snapshot_->data();
+  std::copy(source.begin(), source.end(), snapshot.begin());
+}
+
+/*!
+  \details
+  The surfaces are sorted by their shading time. The texture fetches are
+  the image texture lookups in the shadings of the surfaces.
+  The profile is restarted, so the next rendering is profiled separately.
+  */
+void SimpleRenderer::outputShadingProfile(const std::string& output_path) noexcept
 {
-  auto elapsed_time = system().stopwatch().elapsedTime();
-  const auto elapsed_frame_time = elapsed_time - previous_time;
-  if (elapsed_frame_time < minTimePerFrame()) {
-    waitForNextFrame(minTimePerFrame() - elapsed_frame_time);
-    elapsed_time = system().stopwatch().elapsedTime();
+  using Second = std::chrono::duration<double>;
+
+  ShadingProfile profile{&system().globalMemoryManager()};
+  profile.setNumOfSurfaces(zisc::cast<uint>(surface_name_list_.size()));
+  renderingMethod().mergeShadingProfile(&profile);
+
+  // Calibrate the time stamp counter by the wall-clock time
+  const double elapsed_time = std::chrono::duration_cast<Second>(
+      Clock::now() - shading_profile_start_time_).count();
+  const uint64 elapsed_ticks = RenderingCounter::readTimeStamp() -
+                               shading_profile_start_ticks_;
+  const double seconds_per_tick = (0 < elapsed_ticks)
+      ? elapsed_time / zisc::cast<double>(elapsed_ticks)
+      : 0.0;
+
+  std::vector<uint> index_list;
+  index_list.reserve(profile.numOfSurfaces());
+  for (uint index = 0; index < profile.numOfSurfaces(); ++index)
+    index_list.emplace_back(index);
+  auto has_more_ticks = [&profile](const uint lhs, const uint rhs) noexcept
+  {
+    return profile.cost(rhs).ticks_ < profile.cost(lhs).ticks_;
+  };
+  std::sort(index_list.begin(), index_list.end(), has_more_ticks);
+
+  const auto profile_path = output_path + "/shading_profile.json";
+  std::ofstream profile_file{profile_path};
+  if (profile_file.is_open())
+    profile_file << "{\n  \"surfaces\": [";
+  logMessage("Shading profile:");
+  for (std::size_t i = 0; i < index_list.size(); ++i) {
+    const uint index = index_list[i];
+    const auto& cost = profile.cost(index);
+    const double time = zisc::cast<double>(cost.ticks_) * seconds_per_tick;
+    const double time_per_hit = (0 < cost.num_of_hits_)
+        ? 1.0e9 * time / zisc::cast<double>(cost.num_of_hits_)
+        : 0.0;
+    const std::string& name = surface_name_list_[index];
+    const std::string& type = surface_type_list_[index];
+    if (cost.num_of_hits_ != 0) {
+      char message[256];
+      std::snprintf(message, sizeof(message),
+                    "  %s (%s): %llu hits, %.3f s, %.1f ns/hit, "
+                    "%llu texture fetches.",
+                    name.c_str(), type.c_str(),
+                    zisc::cast<unsigned long long>(cost.num_of_hits_),
+                    time, time_per_hit,
+                    zisc::cast<unsigned long long>(cost.texture_fetches_));
+      logMessage(message);
+    }
+    if (profile_file.is_open()) {
+      profile_file << ((i == 0) ? "\n" : ",\n")
+                   << "    {\"index\": " << index << ", "
+                   << "\"name\": \"" << name << "\", "
+                   << "\"type\": \"" << type << "\", "
+                   << "\"hits\": " << cost.num_of_hits_ << ", "
+                   << "\"time_s\": " << time << ", "
+                   << "\"ns_per_hit\": " << time_per_hit << ", "
+                   << "\"texture_fetches\": " << cost.texture_fetches_ << "}";
+    }
   }
-  return elapsed_time;
+  if (profile_file.is_open())
+    profile_file << "\n  ]\n}\n";
+
+  // Restart the profile for the next rendering
+  enableShadingProfile();
+}
+
+/*!
+  */
+void SimpleRenderer::outputTrace() const noexcept
+{
+  std::ofstream trace{trace_path_};
+  if (trace.is_open())
+    system().traceRecorder().writeJson(&trace);
 }
 
 /*!
+  \details
+  The server keeps running across the renderings of the jobs,
+  so the viewer stays connected.
   */
-void SimpleRenderer::processLdrForLodepng() noexcept
+void SimpleRenderer::openStreamServer() noexcept
 {
-  auto& ldr_image = ldrImage();
-  auto& buffer = ldr_image.data();
-  for (auto& pixel : buffer) {
-    const auto red = pixel.red();
-    pixel.setRed(pixel.blue());
-    pixel.setBlue(red);
+  if ((stream_port_ == 0) || isStreamingEnabled())
+    return;
+  if (stream_server_.get() == nullptr)
+    stream_server_ = std::make_unique<FrameStreamServer>();
+  std::string error_message;
+  const auto& ldr_image = ldrImage();
+  if (stream_server_->open(stream_port_,
+                           ldr_image.resolution(),
+                           ldr_image.channelOrder(),
+                           &error_message)) {
+    logMessage("Streaming the frames on the port " +
+               std::to_string(stream_port_) + ".");
+  }
+  else {
+    logMessage("Stream error: " + error_message);
   }
 }
 
@@ -504,18 +1980,193 @@ void SimpleRenderer::processLdrForLodepng() noexcept
 inline
 void SimpleRenderer::renderScene(const uint32 cycle) noexcept
 {
+  TraceRecorder::Scope scope{system().traceRecorder(), "Scene rendering"};
+  if (system().updateActiveThreads()) {
+    const uint num_of_threads = system().numOfActiveThreads();
+    logMessage("  Active threads: " + std::to_string(num_of_threads) + ".");
+  }
   auto& sampler = system().globalSampler();
   PathState path_state{cycle};
   path_state.setDimension(SampleDimension::kWavelengthSample1);
 
   const auto& wavelength_sampler = wavelengthSampler();
   const auto sampled_wavelengths = wavelength_sampler(sampler, path_state);
+  auto& sample_statistics = scene().film().sampleStatistics();
+  sample_statistics.setWavelengths(system(), sampled_wavelengths.wavelengths());
 
   auto& method = renderingMethod();
-  method.render(system(), scene(), sampled_wavelengths, cycle);
+  const auto start_time = Clock::now();
+  const auto start_counts = system().readHardwareCounters();
+  method(system(), scene(), sampled_wavelengths, cycle);
+  const auto render_time = Clock::now() - start_time;
+  const auto render_counts = system().readHardwareCounters().since(start_counts);
+  logRenderingCounter(method.cycleCounter(), render_time);
+  {
+    const auto& resolution = system().imageResolution();
+    const uint64 num_of_samples = zisc::cast<uint64>(resolution[0]) *
+                                  zisc::cast<uint64>(resolution[1]) *
+                                  system().samplesPerCycle();
+    metrics_writer_.addCycle(method.cycleCounter(), render_time, num_of_samples);
+  }
+  // Log the time of the phases of the cycle
+  const auto& phase_list = method.cyclePhaseList();
+  if (!phase_list.empty()) {
+    using namespace std::string_literals;
+    auto message = "  "s;
+    for (const auto& phase : phase_list) {
+      const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+          phase.time_);
+      if (&phase != &phase_list.front())
+        message += ", ";
+      message += phase.name_ + ": "s + std::to_string(time.count()) + " ms";
+    }
+    logMessage(message + ".");
+  }
+  // No ray is traced between the cycles, so the geometry can be paged out
+  auto& out_of_core_resource = system().outOfCoreMemoryResource();
+  if (out_of_core_resource.isOpen()) {
+    const std::size_t num_of_page_outs = out_of_core_resource.numOfPageOuts();
+    out_of_core_resource.trim();
+    const std::size_t mapped_size = out_of_core_resource.mappedSize() / (1024 * 1024);
+    logMessage("  Out-of-core: " + std::to_string(mapped_size) + " MiB, " +
+               std::to_string(out_of_core_resource.numOfPageOuts() - num_of_page_outs) +
+               " clusters paged out.");
+  }
+  // The tiles which aren't rendered in the recent cycles can be paged out
+  auto& film_resource = system().filmMemoryResource();
+  if (film_resource.isOpen()) {
+    const std::size_t num_of_page_outs = film_resource.numOfPageOuts();
+    film_resource.trim();
+    const std::size_t mapped_size = film_resource.mappedSize() / (1024 * 1024);
+    logMessage("  Mapped film: " + std::to_string(mapped_size) + " MiB, " +
+               std::to_string(film_resource.numOfPageOuts() - num_of_page_outs) +
+               " clusters paged out.");
+  }
 
-  auto& sample_statistics = scene().film().sampleStatistics();
+  const auto film_start_time = Clock::now();
+  const auto film_start_counts = system().readHardwareCounters();
   sample_statistics.update(system(), sampled_wavelengths.wavelengths(), cycle);
+
+  // Stop sampling the converged tiles
+  constexpr uint32 interval = SampleStatistics::adaptiveSamplingInterval();
+  if (system().isAdaptiveSamplingEnabled() &&
+      method.isAdaptiveSamplingSupported() &&
+      ((cycle % interval) == 0)) {
+    sample_statistics.updateActivePixels(system());
+  }
+  const auto film_time = Clock::now() - film_start_time;
+  const auto film_counts = system().readHardwareCounters().since(film_start_counts);
+
+  // The phases of the method are the sub phases of the rendering
+  cycle_phase_list_.clear();
+  cycle_phase_list_.emplace_back(RenderingPhase{"Rendering", render_time, render_counts});
+  for (const auto& phase : phase_list)
+    cycle_phase_list_.emplace_back(phase);
+  cycle_phase_list_.emplace_back(RenderingPhase{"Film", film_time, film_counts});
+  if (system().isHardwareCounterEnabled()) {
+    for (const auto& phase : cycle_phase_list_)
+      logHardwareCounts(phase.name_, phase.counts_);
+  }
+}
+
+/*!
+  \details
+  A snapshot of the statistics is denoised on the denoising threads,
+  so the rendering threads continue the next cycles.
+  The denoised image is output at the first saving after it's finished.
+  The snapshot is skipped if the previous one is still being denoised.
+  */
+void SimpleRenderer::runAsyncDenoising(const std::string& output_path,
+                                       const uint32 cycle) noexcept
+{
+  if (denoising_task_.valid()) {
+    const auto status = denoising_task_.wait_for(std::chrono::seconds::zero());
+    if (status != std::future_status::ready)
+      return;
+    denoising_task_.get();
+    time_budget_scheduler_.recordDenoising(async_denoising_time_);
+    outputDenoisedImage(*denoising_statistics_, output_path, denoising_cycle_);
+  }
+
+  // The merge into the cleared statistics copies the statistics
+  const auto& statistics = scene().film().sampleStatistics();
+  denoising_statistics_->clear();
+  denoising_statistics_->merge(system(), statistics, 0, cycle);
+  denoising_cycle_ = cycle;
+
+  auto denoise = [this, cycle]()
+  {
+    // The progress of the rendering is notified meanwhile
+    TraceRecorder::Scope scope{system().traceRecorder(), "Denoising"};
+    const auto start_time = Clock::now();
+    auto ignore_progress = [](const double) {};
+    auto& denoiser = system().denoiser();
+    denoiser.setProgressCallback(ignore_progress);
+    DenoisingContext context{system(),
+                             denoising_thread_manager_.get(),
+                             denoising_task_scheduler_.get(),
+                             denoising_memory_.get()};
+    denoiser.denoise(context, cycle, denoising_statistics_.get());
+    denoising_memory_->reset();
+    async_denoising_time_ = Clock::now() - start_time;
+  };
+  denoising_task_ = std::async(std::launch::async, denoise);
+}
+
+/*!
+  \details
+  The statistics are serialized into memory before the next cycle changes them,
+  then the data is written on another thread so that it overlaps the rendering.
+  The checkpoint is skipped if the previous one is still being written.
+  The data is written into a temporary file which replaces the checkpoint,
+  so the previous checkpoint remains if the writing is interrupted.
+  */
+void SimpleRenderer::saveCheckpoint(const uint32 cycle,
+                                    const Clock::duration& time) noexcept
+{
+  if (checkpoint_task_.valid() &&
+      (checkpoint_task_.wait_for(std::chrono::seconds{0}) !=
+       std::future_status::ready)) {
+    return;
+  }
+
+  std::ostringstream checkpoint_stream{std::ios::binary};
+  {
+    const uint32 magic_number = checkpointMagicNumber();
+    zisc::write(&magic_number, &checkpoint_stream);
+    const uint32 version = checkpointVersion();
+    zisc::write(&version, &checkpoint_stream);
+    zisc::write(&cycle, &checkpoint_stream);
+    const uint32 seed = system().samplerSeed();
+    zisc::write(&seed, &checkpoint_stream);
+    const auto t = std::chrono::duration_cast<std::chrono::milliseconds>(time);
+    const uint64 time_count = zisc::cast<uint64>(t.count());
+    zisc::write(&time_count, &checkpoint_stream);
+    const auto& sample_statistics = scene().film().sampleStatistics();
+    sample_statistics.writeData(&checkpoint_stream);
+  }
+
+  auto write_checkpoint = [this, data = checkpoint_stream.str()]()
+  {
+    TraceRecorder::Scope scope{system().traceRecorder(), "Checkpoint saving"};
+    const auto temp_path = checkpoint_path_ + ".tmp";
+    bool result = false;
+    {
+      std::ofstream checkpoint_file{temp_path, std::ios::binary};
+      checkpoint_file.write(data.data(), zisc::cast<std::streamsize>(data.size()));
+      checkpoint_file.close();
+      result = !checkpoint_file.fail();
+    }
+#if defined(_WIN32)
+    // Rename doesn't replace the existing file on Windows
+    if (result)
+      std::remove(checkpoint_path_.c_str());
+#endif
+    result = result && (std::rename(temp_path.c_str(), checkpoint_path_.c_str()) == 0);
+    if (!result)
+      logMessage("Checkpoint error: saving failed: " + checkpoint_path_);
+  };
+  checkpoint_task_ = std::async(std::launch::async, write_checkpoint);
 }
 
 /*!
@@ -561,13 +2212,44 @@ void SimpleRenderer::setTimeToFinish(const Clock::duration& time) noexcept
       : time;
 }
 
+/*!
+  \details
+  The methods which don't support it keep the wavelengths of the cycle.
+  */
+void SimpleRenderer::setTileWavelengthSampler() noexcept
+{
+  auto& method = renderingMethod();
+  const bool is_enabled = system().isTileWavelengthSamplingEnabled() &&
+                          method.isTileWavelengthSamplingSupported();
+  method.setTileWavelengthSampler(is_enabled ? &wavelengthSampler() : nullptr);
+}
+
+/*!
+  \details
+  The converted tiles are only the dirty tiles of the film,
+  and the server sends only the tiles which changed.
+  */
+void SimpleRenderer::streamRenderedImage(const uint32 cycle) noexcept
+{
+  waitForToneMapping();
+  convertToHdr(cycle);
+  auto map_image = [this, cycle]()
+  {
+    auto& image_memory = system().imageMemoryManager();
+    toneMap(&image_memory);
+    image_memory.reset();
+    stream_server_->submitFrame(ldrImage(), cycle);
+  };
+  tone_mapping_task_ = std::async(std::launch::async, map_image);
+}
+
 /*!
   */
 inline
-void SimpleRenderer::toneMap() noexcept
+void SimpleRenderer::toneMap(zisc::pmr::memory_resource* work_resource) noexcept
 {
   const auto& tone_map = system().toneMappingOperator();
-  tone_map.map(system(), hdrImage(), &ldrImage());
+  tone_map.map(system(), hdrImage(), &ldrImage(), work_resource);
 }
 
 /*!
@@ -590,18 +2272,68 @@ void SimpleRenderer::updateRenderingProgress(const uint32 cycle,
                times[2],
                times[3]);
 
+  // The remaining time of the rendering and the output
+  const auto remaining_time = time_budget_scheduler_.estimateRemainingTime(
+      cycle,
+      time,
+      cycleToFinish(),
+      timeToFinish());
+  if (remaining_time != Clock::duration::max()) {
+    const auto eta = getCurrentTime(remaining_time);
+    auto eta_status = ",  ETA 0000 h 00 m 00 s"s;
+    std::sprintf(eta_status.data(),
+                 ",  ETA %04d h %02d m %02d s",
+                 eta[0],
+                 eta[1],
+                 eta[2]);
+    status += eta_status;
+  }
+
+  // The noise of the image
+  const auto& statistics = scene().film().sampleStatistics();
+  if (statistics.isEnabled(SampleStatistics::Type::kVariance) && (1 < cycle)) {
+    const double error = zisc::min(statistics.estimateRelativeError(cycle), 9.9999);
+    auto noise_status = ",  noise 0.0000"s;
+    std::sprintf(noise_status.data(), ",  noise %6.4lf", error);
+    status += noise_status;
+  }
+
   logMessage(status);
   notifyOfRenderingProgress(cycle, time, status);
 }
 
 /*!
   */
-inline
-void SimpleRenderer::waitForNextFrame(const Clock::duration& wait_time) const noexcept
+void SimpleRenderer::waitForDenoising() noexcept
+{
+  if (denoising_task_.valid())
+    denoising_task_.wait();
+}
+
+/*!
+  */
+void SimpleRenderer::waitForCheckpoint() noexcept
+{
+  if (checkpoint_task_.valid())
+    checkpoint_task_.wait();
+}
+
+/*!
+  */
+void SimpleRenderer::waitForImageOutput() noexcept
+{
+  // The tone mapping issues the output task
+  waitForToneMapping();
+  if (image_output_task_.valid())
+    image_output_task_.wait();
+}
+
+/*!
+  */
+void SimpleRenderer::waitForToneMapping() noexcept
 {
-  ZISC_ASSERT(Clock::duration::zero() < wait_time,
-              "The wait time is less or equal than zero.");
-  std::this_thread::sleep_for(wait_time);
+  if (tone_mapping_task_.valid())
+    tone_mapping_task_.wait();
 }
 
 /*!
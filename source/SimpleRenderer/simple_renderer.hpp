@@ -12,27 +12,42 @@
 
 // Standard C++ library
 #include <array>
+#include <cstddef>
 #include <fstream>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <vector>
 // Zisc
 #include "zisc/function_reference.hpp"
+#include "zisc/memory_resource.hpp"
 #include "zisc/stopwatch.hpp"
+#include "zisc/thread_manager.hpp"
 #include "zisc/unique_memory_pointer.hpp"
 // Nanairo
+#include "frame_stream_server.hpp"
+#include "metrics_writer.hpp"
+#include "time_budget_scheduler.hpp"
 #include "NanairoCore/nanairo_core_config.hpp"
 #include "NanairoCore/scene.hpp"
 #include "NanairoCore/system.hpp"
 #include "NanairoCore/Color/hdr_image.hpp"
 #include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Geometry/transformation.hpp"
 #include "NanairoCore/RenderingMethod/rendering_method.hpp"
 #include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/loading_phase.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
 
 namespace nanairo {
 
 //! Forward declaration
+class CameraEvent;
+class SampleStatistics;
 class SettingNodeBase;
 class WavelengthSamples;
 
@@ -43,6 +58,58 @@ class SimpleRenderer
  public:
   using Clock = zisc::Stopwatch::Clock;
 
+  /*!
+    \brief The measurement of a headless rendering
+    */
+  struct BenchmarkResult
+  {
+    Clock::duration loading_time_ = Clock::duration::zero();
+    Clock::duration bvh_build_time_ = Clock::duration::zero();
+    Clock::duration rendering_time_ = Clock::duration::zero();
+    uint64 num_of_samples_ = 0;
+    uint64 num_of_rays_ = 0;
+    uint32 num_of_cycles_ = 0;
+    uint num_of_threads_ = 0;
+    std::vector<RenderingPhase> phase_list_; //!< The sums of the cycle phases
+  };
+
+  /*!
+    \brief The error of the rendered image against a reference at a time
+    \details
+    The time is the rendering time of the cycles,
+    which doesn't include the conversion of the images.
+    */
+  struct ConvergencePoint
+  {
+    Clock::duration time_ = Clock::duration::zero();
+    uint32 cycle_ = 0;
+    double rmse_ = 0.0; //!< The root mean squared error
+    double rel_mse_ = 0.0; //!< The mean squared error relative to the reference
+  };
+
+  /*!
+    \brief The header of a checkpoint file
+    */
+  struct Checkpoint
+  {
+    Clock::duration time_ = Clock::duration::zero();
+    uint32 cycle_ = 0;
+    uint32 seed_ = 0;
+  };
+
+  /*!
+    \brief A rendering of the loaded scene
+    \details
+    The zero cycle and time use the termination of the scene settings.
+    */
+  struct RenderJob
+  {
+    std::string output_path_;
+    Matrix4x4 camera_matrix_ = Transformation::makeIdentity(); //!< Relative to the scene camera
+    Clock::duration time_ = Clock::duration::zero();
+    uint32 cycle_ = 0;
+  };
+
 
   //! Create a renderer
   SimpleRenderer() noexcept;
@@ -51,6 +118,19 @@ class SimpleRenderer
   virtual ~SimpleRenderer() noexcept;
 
 
+  //! Add a loading phase which is measured before the scene is loaded
+  void addLoadingPhase(const LoadingPhase& phase) noexcept;
+
+  //! Render the cycles after the warm-up cycles without output and measure them
+  BenchmarkResult benchmark(const uint32 warmup_cycles,
+                            const uint32 num_of_cycles) noexcept;
+
+  //! Open the hardware counters which are measured in the cycle phases
+  bool enableHardwareCounters() noexcept;
+
+  //! Profile the shading costs of the surfaces, which are output after the rendering
+  bool enableShadingProfile() noexcept;
+
   //! Check if the renderer is runnable
   bool isRunnable() const noexcept;
 
@@ -64,34 +144,105 @@ class SimpleRenderer
   bool loadScene(const SettingNodeBase& settings,
                  std::string* error_message) noexcept;
 
-  //! Return the max FPS
+  //! Render for the times and measure the errors of the images against the reference
+  std::vector<ConvergencePoint> measureConvergence(
+      const std::vector<Clock::duration>& time_list,
+      const zisc::pmr::vector<std::array<float, 3>>& reference,
+      zisc::pmr::vector<std::array<float, 3>>* rgb_image) noexcept;
+
+  //! Merge the checkpoints which are rendered in parallel and output the images
+  void mergeCheckpoints(const std::vector<std::string>& checkpoint_path_list,
+                        const std::string& output_path) noexcept;
+
+  //! Return the max FPS of the displayed images
   static constexpr int maxFps() noexcept;
 
-  //! Return the min time per frame
+  //! Return the min time per displayed frame
   static constexpr Clock::duration minTimePerFrame() noexcept;
 
+  //! Output the loading profile into a JSON file
+  void outputLoadingProfile(const std::string& output_path) const noexcept;
+
+  //! Read the checkpoint file into the statistics
+  static bool readCheckpoint(const std::string& checkpoint_path,
+                             SampleStatistics* sample_statistics,
+                             Checkpoint* checkpoint) noexcept;
+
   //! Render the scene image
   void render(const std::string& output_path) noexcept;
 
+  //! Render the job with the loaded scene without loading it again
+  void renderJob(const SettingNodeBase& settings, const RenderJob& job) noexcept;
+
+  //! Request the number of the threads which render the next cycles
+  void requestNumOfActiveThreads(const uint num_of_threads) noexcept;
+
+  //! Return the requested number of the threads, or 0 if no scene is loaded
+  uint requestedNumOfActiveThreads() const noexcept;
+
+  //! Set the number of threads which denoise the saved images during rendering
+  void setAsyncDenoising(const uint num_of_threads) noexcept;
+
+  //! Set the bytes of the work memory which a denoising can use
+  void setDenoisingMemoryBudget(const std::size_t budget) noexcept;
+
+  //! Set the checkpoint file which is saved at the time interval
+  void setCheckpoint(const std::string& checkpoint_path,
+                     const Clock::duration& interval) noexcept;
+
+  //! Set the wall-clock time which the rendering and the output finish in
+  void setDeadline(const Clock::duration& deadline) noexcept;
+
+  //! Set the time which is reserved for the final output, zero measures it
+  void setFinishingTime(const Clock::duration& time) noexcept;
+
   //! Set a log stream
   void setLogStream(std::ostream* log_stream) noexcept;
 
+  //! Set the file which the live metrics are written into at the time interval
+  void setMetricsFile(const std::string& metrics_path,
+                      const Clock::duration& interval) noexcept;
+
   //! Set a progress callback
   void setProgressCallback(
       const zisc::FunctionReference<void (double, std::string_view)>& callback)
           noexcept;
 
+  //! Set the checkpoint file which the rendering is resumed from
+  void setResumeCheckpoint(const std::string& checkpoint_path) noexcept;
+
+  //! Set the port which the frames are streamed on, zero disables the streaming
+  void setStreamPort(const uint16 port) noexcept;
+
+  //! Set the file which the timeline of the rendering is written into
+  void setTraceFile(const std::string& trace_path) noexcept;
+
   //! Set the renderer state manually
   void setRunnable(const bool is_runnable) noexcept;
 
+  //! Apply an affine transformation to a single object model of the scene
+  void transformObject(const SettingNodeBase& settings,
+                       const uint index,
+                       const Matrix4x4& matrix) noexcept;
+
+  //! Remake a surface model of the scene by the updated settings
+  void updateSurface(const SettingNodeBase& settings, const uint index) noexcept;
+
+  //! Remake a texture of the scene by the updated settings
+  void updateTexture(const SettingNodeBase& settings, const uint index) noexcept;
+
  protected:
-  //! Set the flag of saving image at each cycle
-  void enableSavingAtEachCycle(const bool flag) noexcept;
+  //! Set the flag of displaying the linear RGB image at each output
+  void enableLinearImageDisplay(const bool flag) noexcept;
+
+  //! Set the flag of saving image at each display frame
+  void enableSavingAtEachFrame(const bool flag) noexcept;
 
   //! Make a image path
   std::string makeImagePath(const std::string_view output_path,
                             const uint32 cycle,
-                            const std::string_view suffix = "") const noexcept;
+                            const std::string_view suffix = "",
+                            const std::string_view extension = ".png") const noexcept;
 
   //! Handle camera event
   virtual void handleCameraEvent(uint32* cycle,
@@ -106,6 +257,12 @@ class SimpleRenderer
   //! Initialize the renderer for rendering the scene
   void initForRendering() noexcept;
 
+  //! Restart rendering from the first cycle
+  void restartRendering(uint32* cycle, Clock::duration* time) noexcept;
+
+  //! Transform the camera by the events, return true if the camera moved
+  bool transformCamera(CameraEvent* camera_event) noexcept;
+
   //! Return the rendering method
   RenderingMethod& renderingMethod() noexcept;
 
@@ -133,27 +290,67 @@ class SimpleRenderer
   //! Log a message
   void logMessage(const std::string_view& messsage) noexcept;
 
-  //! Output LDR image
-  virtual void outputLdrImage(const std::string_view output_path,
+  //! Log the memory usage of the memory categories
+  void logMemoryUsage() noexcept;
+
+  //! Check if the linear RGB image is displayed at each output
+  bool isLinearImageDisplayEnabled() const noexcept;
+
+  //! Return the channel order of the LDR image which the output reads
+  virtual LdrImage::ChannelOrder ldrChannelOrder() const noexcept;
+
+  //! Display the snapshot of the linear RGB image
+  virtual void outputDisplayImage(
+      const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+      const uint32 cycle) noexcept;
+
+  //! Output the snapshot of the linear RGB image
+  virtual void outputHdrImage(const zisc::pmr::vector<std::array<float, 3>>& rgb_image,
+                              const std::string_view output_path,
+                              const uint32 cycle,
+                              const std::string_view suffix = "") noexcept;
+
+  //! Output the snapshot of the LDR image, the snapshot can be modified
+  virtual void outputLdrImage(LdrImage* ldr_image,
+                              const std::string_view output_path,
                               const uint32 cycle,
                               const std::string_view suffix = "") noexcept;
 
  private:
+  //! Return the magic number of the checkpoint file
+  static constexpr uint32 checkpointMagicNumber() noexcept;
+
+  //! Return the version of the checkpoint file format
+  static constexpr uint32 checkpointVersion() noexcept;
+
   //! Check if the rendered result should be saved
   bool checkImageSavingFlag(const uint32 cycle,
                             const Clock::duration previous_time,
                             uint32* cycle_to_save_image,
-                            Clock::duration* time_to_save_image) const noexcept;
+                            Clock::duration* time_to_save_image,
+                            Clock::time_point* time_to_save_frame) const noexcept;
+
+  //! Cache the names and the types of the surfaces for the shading profile
+  void cacheSurfaceNames(const SettingNodeBase& settings) noexcept;
 
   //! Clear work memories of system
   void clearWorkMemory() noexcept;
 
+  //! Convert the sampled values of the film to the HDR image
+  void convertToHdr(const uint32 cycle) noexcept;
+
   //! Return the cycle interval to save image
   uint32 cycleIntervalToSaveImage() const noexcept;
 
   //! Return the cycle to finish rendering
   uint32 cycleToFinish() const noexcept;
 
+  //! Return the elapsed time including the time before the rendering is resumed
+  Clock::duration elapsedTime() const noexcept;
+
+  //! Return all phases of the scene loading in the order of the measurement
+  std::vector<LoadingPhase> loadingPhaseList() const noexcept;
+
   //! Compute the current fps
   double getCurrentFps(const uint32 cycle,
                        const Clock::duration& time) const noexcept;
@@ -170,19 +367,34 @@ class SimpleRenderer
   //! Initialize the renderer
   void initialize() noexcept;
 
+  //! Check if the saved images are denoised while the rendering continues
+  bool isAsyncDenoisingEnabled() const noexcept;
+
+  //! Check if the checkpoint is saved
+  bool isCheckpointEnabled() const noexcept;
+
   //! Check if it is the cycle to finish rendering
   bool isCycleToFinish(const uint32 cycle) const noexcept;
 
+  //! Check if the linear HDR image is output
+  bool isHdrImageOutputEnabled() const noexcept;
+
+  //! Check if the tone mapped LDR image is output
+  bool isLdrImageOutputEnabled() const noexcept;
+
   //! Check if it is the cycle to save image
   bool isCycleToSaveImage(const uint32 cycle,
                           const uint32 cycle_to_save_image) const noexcept;
 
-  //! Check if the LDR image is saved at each cycle
-  bool isSavingAtEachCycleEnabled() const noexcept;
+  //! Check if the image is saved at each display frame
+  bool isSavingAtEachFrameEnabled() const noexcept;
 
   //! Check if the LDR image is saved at power of 2 cycles
   bool isSavingAtPowerOf2CyclesEnabled() const noexcept;
 
+  //! Check if the frames are streamed to a remote viewer
+  bool isStreamingEnabled() const noexcept;
+
   //! Check if it is the time to finish rendering
   bool isTimeToFinish(const Clock::duration& time) const noexcept;
 
@@ -190,9 +402,32 @@ class SimpleRenderer
   bool isTimeToSaveImage(const Clock::duration& time,
                          const Clock::duration& time_to_save_image) const noexcept;
 
+  //! Load the checkpoint and return the cycle which the rendering is resumed at
+  bool loadCheckpoint(uint32* cycle) noexcept;
+
+  //! Log the hardware counts of a phase
+  void logHardwareCounts(const std::string_view& name,
+                         const HardwareCounts& counts) noexcept;
+
+  //! Log the ray and path counts of a cycle and the ray throughput
+  void logRenderingCounter(const RenderingCounter& counter,
+                           const Clock::duration& time) noexcept;
+
+  //! Log the time of a scene update
+  void logSceneUpdate(const std::string_view& name,
+                      const Clock::time_point start_time) noexcept;
+
+  //! Remake the samplers which depend on the light sources of the world
+  void remakeLightSampling(const SettingNodeBase& settings) noexcept;
+
   //! Notify of denoising progress
   void notifyOfDenoisingProgress(const double progress) const noexcept;
 
+  //! Write the live metrics if the interval has passed or it's forced
+  void outputMetrics(const uint32 cycle,
+                     const Clock::duration& time,
+                     const bool is_finished) noexcept;
+
   //! Notify of rendering progress
   void notifyOfRenderingProgress(const uint32 cycle,
                                  const Clock::duration& time,
@@ -202,20 +437,41 @@ class SimpleRenderer
   void outputDenoisedImage(const std::string& output_path,
                            const uint32 cycle) noexcept;
 
+  //! Output the denoised image of the statistics
+  void outputDenoisedImage(const SampleStatistics& statistics,
+                           const std::string& output_path,
+                           const uint32 cycle) noexcept;
+
+  //! Output the heatmap of the costs of the camera paths
+  void outputPixelCostImage(const std::string& output_path,
+                            const uint32 cycle) noexcept;
+
   //! Output rendered image
   void outputRenderedImage(const std::string& output_path,
                            const uint32 cycle) noexcept;
 
-  //! Process elapsed time per frame
-  Clock::duration processElapsedTime(
-      const Clock::duration& previous_time) const noexcept;
+  //! Copy the LDR image into the snapshot which is output
+  void makeLdrSnapshot() noexcept;
+
+  //! Log the shading profile, output it into a JSON file and restart it
+  void outputShadingProfile(const std::string& output_path) noexcept;
+
+  //! Output the timeline of the rendering into the trace file
+  void outputTrace() const noexcept;
 
-  //! Process LDR image for LodePNG
-  void processLdrForLodepng() noexcept;
+  //! Start the stream server if the streaming is requested
+  void openStreamServer() noexcept;
 
   //! Render the scene
   void renderScene(const uint32 cycle) noexcept;
 
+  //! Output the finished denoising and denoise the snapshot of the cycle
+  void runAsyncDenoising(const std::string& output_path,
+                         const uint32 cycle) noexcept;
+
+  //! Save the checkpoint of the rendering
+  void saveCheckpoint(const uint32 cycle, const Clock::duration& time) noexcept;
+
   //! Set the cycle interval to save image
   void setCycleIntervalToSave(const uint32 cycle) noexcept;
 
@@ -231,6 +487,12 @@ class SimpleRenderer
   //! Set the time to finish rendering
   void setTimeToFinish(const Clock::duration& time) noexcept;
 
+  //! Tone map the image and stream it to the remote viewer
+  void streamRenderedImage(const uint32 cycle) noexcept;
+
+  //! Give the wavelength sampler to the method if it samples them per tile
+  void setTileWavelengthSampler() noexcept;
+
   //! Return the time interval to save image
   const Clock::duration& timeIntervalToSaveImage() const noexcept;
 
@@ -238,14 +500,23 @@ class SimpleRenderer
   const Clock::duration& timeToFinish() const noexcept;
 
   //! Apply tone mapping
-  void toneMap() noexcept;
+  void toneMap(zisc::pmr::memory_resource* work_resource) noexcept;
 
   //! Update rendering progress
   void updateRenderingProgress(const uint32 cycle,
                                const Clock::duration& time) noexcept;
 
-  //! Current thread waits for next rendering frame
-  void waitForNextFrame(const Clock::duration& wait_time) const noexcept;
+  //! Wait for the denoising which overlaps rendering
+  void waitForDenoising() noexcept;
+
+  //! Wait for the checkpoint writing which overlaps rendering
+  void waitForCheckpoint() noexcept;
+
+  //! Wait for the image output which overlaps rendering
+  void waitForImageOutput() noexcept;
+
+  //! Wait for the tone mapping which overlaps rendering
+  void waitForToneMapping() noexcept;
 
 
   std::unique_ptr<System> system_;
@@ -254,14 +525,47 @@ class SimpleRenderer
   zisc::UniqueMemoryPointer<RenderingMethod> rendering_method_;
   zisc::UniqueMemoryPointer<HdrImage> hdr_image_;
   zisc::UniqueMemoryPointer<LdrImage> ldr_image_;
+  zisc::UniqueMemoryPointer<LdrImage> ldr_snapshot_; //!< The image being saved
+  zisc::UniqueMemoryPointer<zisc::pmr::vector<std::array<float, 3>>> hdr_snapshot_;
+  zisc::UniqueMemoryPointer<zisc::pmr::vector<std::array<float, 3>>> cost_snapshot_;
+  zisc::UniqueMemoryPointer<zisc::ThreadManager> denoising_thread_manager_;
+  zisc::UniqueMemoryPointer<TaskScheduler> denoising_task_scheduler_;
+  zisc::UniqueMemoryPointer<System::MemoryManager> denoising_memory_;
+  zisc::UniqueMemoryPointer<SampleStatistics> denoising_statistics_; //!< The snapshot
+  std::unique_ptr<FrameStreamServer> stream_server_;
   zisc::FunctionReference<void (double, std::string_view)> progress_callback_;
+  TimeBudgetScheduler time_budget_scheduler_;
+  MetricsWriter metrics_writer_;
+  std::future<void> tone_mapping_task_;
+  std::future<void> denoising_task_;
+  std::future<void> image_output_task_;
+  std::future<void> checkpoint_task_;
+  std::string checkpoint_path_;
+  std::string resume_checkpoint_path_;
+  std::string trace_path_;
+  std::vector<LoadingPhase> preloading_phase_list_; //!< Before the scene loading
+  std::vector<RenderingPhase> cycle_phase_list_; //!< The phases of the last cycle
+  std::vector<std::string> surface_name_list_;
+  std::vector<std::string> surface_type_list_;
+  std::mutex log_mutex_;
   std::ostream* log_stream_;
   Clock::duration time_to_finish_;
   Clock::duration time_interval_to_save_image_;
+  Clock::duration checkpoint_interval_;
+  Clock::duration resumed_time_; //!< The rendering time before resuming
+  Clock::duration deadline_; //!< The wall-clock time of the process
+  Clock::duration async_denoising_time_; //!< The time of the last async denoising
+  Clock::time_point shading_profile_start_time_;
+  uint64 shading_profile_start_ticks_; //!< The time stamp counter at the start
   uint32 cycle_to_finish_;
+  uint32 denoising_cycle_; //!< The cycle of the snapshot being denoised
   uint32 cycle_interval_to_save_image_;
-  bool is_saving_each_cycle_enabled_;
+  uint16 stream_port_;
+  bool is_saving_each_frame_enabled_;
+  bool is_linear_image_display_enabled_;
   bool is_saving_at_power_of_2_cycles_enabled_;
+  bool is_ldr_image_output_enabled_;
+  bool is_hdr_image_output_enabled_;
   bool is_runnable_;
 };
 
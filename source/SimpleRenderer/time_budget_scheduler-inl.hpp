@@ -0,0 +1,74 @@
+/*!
+  \file time_budget_scheduler-inl.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TIME_BUDGET_SCHEDULER_INL_HPP
+#define NANAIRO_TIME_BUDGET_SCHEDULER_INL_HPP
+
+#include "time_budget_scheduler.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  */
+inline
+auto TimeBudgetScheduler::deadline() const noexcept -> Clock::duration
+{
+  return deadline_;
+}
+
+/*!
+  */
+inline
+bool TimeBudgetScheduler::hasDeadline() const noexcept
+{
+  return deadline_ != Clock::duration::max();
+}
+
+/*!
+  */
+inline
+bool TimeBudgetScheduler::isMeasured() const noexcept
+{
+  return 0 < num_of_cycles_;
+}
+
+/*!
+  */
+inline
+void TimeBudgetScheduler::setDenoisingEnabled(const bool flag) noexcept
+{
+  is_denoising_enabled_ = flag;
+}
+
+/*!
+  \details
+  The recent 8 times mostly make the average,
+  so a change of the cycle time (such as the adaptive sampling
+  or the active threads) is followed in a few cycles.
+  */
+inline
+constexpr double TimeBudgetScheduler::smoothingFactor() noexcept
+{
+  return 0.25;
+}
+
+/*!
+  */
+inline
+double TimeBudgetScheduler::smooth(const double average,
+                                   const double value) noexcept
+{
+  return average + smoothingFactor() * (value - average);
+}
+
+} // namespace nanairo
+
+#endif // NANAIRO_TIME_BUDGET_SCHEDULER_INL_HPP
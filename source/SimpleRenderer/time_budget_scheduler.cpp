@@ -0,0 +1,195 @@
+/*!
+  \file time_budget_scheduler.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "time_budget_scheduler.hpp"
+// Standard C++ library
+#include <chrono>
+#include <limits>
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+namespace {
+
+using Seconds = std::chrono::duration<double>;
+
+//! Convert the time into seconds
+double toSeconds(const TimeBudgetScheduler::Clock::duration& time) noexcept
+{
+  return std::chrono::duration_cast<Seconds>(time).count();
+}
+
+//! Convert the seconds into the time
+TimeBudgetScheduler::Clock::duration toDuration(const double seconds) noexcept
+{
+  using Duration = TimeBudgetScheduler::Clock::duration;
+  return std::chrono::duration_cast<Duration>(Seconds{seconds});
+}
+
+} // namespace
+
+/*!
+  */
+TimeBudgetScheduler::TimeBudgetScheduler() noexcept :
+    deadline_{Clock::duration::max()},
+    finishing_time_{Clock::duration::zero()},
+    cycle_time_{0.0},
+    cycle_deviation_{0.0},
+    output_time_{0.0},
+    denoising_time_{0.0},
+    num_of_cycles_{0},
+    is_denoising_enabled_{false}
+{
+}
+
+/*!
+  \details
+  The deviation is added twice, so a slower cycle rarely overruns the plan.
+  */
+auto TimeBudgetScheduler::cycleTime() const noexcept -> Clock::duration
+{
+  return toDuration(cycle_time_ + 2.0 * cycle_deviation_);
+}
+
+/*!
+  \details
+  The rendering finishes at the earliest of the termination cycle,
+  the termination time (the last cycle starts before it) and the deadline.
+  The max time is returned if the rendering has no termination.
+  */
+auto TimeBudgetScheduler::estimateRemainingTime(
+    const uint32 cycle,
+    const Clock::duration& time,
+    const uint32 cycle_to_finish,
+    const Clock::duration& time_to_finish) const noexcept -> Clock::duration
+{
+  const double t = toSeconds(time);
+  double remaining_time = std::numeric_limits<double>::max();
+  if (isMeasured() && (cycle_to_finish != std::numeric_limits<uint32>::max())) {
+    const uint32 n = (cycle < cycle_to_finish) ? cycle_to_finish - cycle : 0;
+    remaining_time = zisc::min(remaining_time, zisc::cast<double>(n) * cycle_time_);
+  }
+  if (isMeasured() && (time_to_finish != Clock::duration::max())) {
+    const double r = zisc::max(toSeconds(time_to_finish) - t, 0.0) + cycle_time_;
+    remaining_time = zisc::min(remaining_time, r);
+  }
+  const bool has_estimate = remaining_time != std::numeric_limits<double>::max();
+  if (has_estimate)
+    remaining_time += toSeconds(finishingTime());
+  if (hasDeadline())
+    remaining_time = zisc::min(remaining_time,
+                               zisc::max(toSeconds(deadline()) - t, 0.0));
+  return (has_estimate || hasDeadline())
+      ? toDuration(remaining_time)
+      : Clock::duration::max();
+}
+
+/*!
+  \details
+  The time which is specified by the user is used if it's set.
+  Otherwise the measured output and denoising are reserved with a margin
+  of 25 %. The denoising which isn't measured yet (no asynchronous
+  denoising) reserves 5 % of the deadline.
+  */
+auto TimeBudgetScheduler::finishingTime() const noexcept -> Clock::duration
+{
+  if (finishing_time_ != Clock::duration::zero())
+    return finishing_time_;
+
+  double finishing_time = output_time_;
+  if (is_denoising_enabled_) {
+    const bool is_measured = 0.0 < denoising_time_;
+    finishing_time += (is_measured || !hasDeadline())
+        ? denoising_time_
+        : 0.05 * toSeconds(deadline());
+  }
+  return toDuration(1.25 * finishing_time);
+}
+
+/*!
+  \details
+  The cycle which starts at the time is the last one if the next cycle
+  and the final output wouldn't finish before the deadline.
+  */
+bool TimeBudgetScheduler::isLastCycle(const Clock::duration& time) const noexcept
+{
+  if (!hasDeadline())
+    return false;
+  const double t = toSeconds(time);
+  const double cycle_time = toSeconds(cycleTime());
+  const double end_time = t + 2.0 * cycle_time + toSeconds(finishingTime());
+  return toSeconds(deadline()) <= end_time;
+}
+
+/*!
+  */
+void TimeBudgetScheduler::recordCycle(const Clock::duration& cycle_time) noexcept
+{
+  const double t = toSeconds(cycle_time);
+  if (num_of_cycles_ == 0) {
+    cycle_time_ = t;
+    cycle_deviation_ = 0.0;
+  }
+  else {
+    cycle_deviation_ = smooth(cycle_deviation_, zisc::abs(t - cycle_time_));
+    cycle_time_ = smooth(cycle_time_, t);
+  }
+  ++num_of_cycles_;
+}
+
+/*!
+  \details
+  The longest denoising is kept, since the denoising
+  of a later cycle isn't faster.
+  */
+void TimeBudgetScheduler::recordDenoising(const Clock::duration& denoising_time) noexcept
+{
+  denoising_time_ = zisc::max(denoising_time_, toSeconds(denoising_time));
+}
+
+/*!
+  */
+void TimeBudgetScheduler::recordOutput(const Clock::duration& output_time) noexcept
+{
+  const double t = toSeconds(output_time);
+  output_time_ = (0.0 < output_time_) ? smooth(output_time_, t) : t;
+}
+
+/*!
+  */
+void TimeBudgetScheduler::reset() noexcept
+{
+  cycle_time_ = 0.0;
+  cycle_deviation_ = 0.0;
+  output_time_ = 0.0;
+  denoising_time_ = 0.0;
+  num_of_cycles_ = 0;
+}
+
+/*!
+  */
+void TimeBudgetScheduler::setDeadline(const Clock::duration& deadline) noexcept
+{
+  deadline_ = (deadline == Clock::duration::zero())
+      ? Clock::duration::max()
+      : deadline;
+}
+
+/*!
+  */
+void TimeBudgetScheduler::setFinishingTime(const Clock::duration& time) noexcept
+{
+  finishing_time_ = time;
+}
+
+} // namespace nanairo
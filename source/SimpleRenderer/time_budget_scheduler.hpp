@@ -0,0 +1,107 @@
+/*!
+  \file time_budget_scheduler.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_TIME_BUDGET_SCHEDULER_HPP
+#define NANAIRO_TIME_BUDGET_SCHEDULER_HPP
+
+// Zisc
+#include "zisc/stopwatch.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+
+namespace nanairo {
+
+/*!
+  \brief Plan the cycles of a rendering to fit a deadline
+  \details
+  The times of the recent cycles are averaged with their deviation,
+  and the time of the final output (HDR conversion, tone mapping,
+  denoising and encoding) is reserved before the deadline,
+  so the last cycle is chosen that the output finishes in time.
+  The scheduler also estimates the remaining time of the rendering.
+  */
+class TimeBudgetScheduler
+{
+ public:
+  using Clock = zisc::Stopwatch::Clock;
+
+
+  //! Create a scheduler without a deadline
+  TimeBudgetScheduler() noexcept;
+
+
+  //! Return the predicted time of a cycle
+  Clock::duration cycleTime() const noexcept;
+
+  //! Return the deadline of the rendering
+  Clock::duration deadline() const noexcept;
+
+  //! Estimate the remaining time until the output is finished
+  Clock::duration estimateRemainingTime(const uint32 cycle,
+                                        const Clock::duration& time,
+                                        const uint32 cycle_to_finish,
+                                        const Clock::duration& time_to_finish) const
+      noexcept;
+
+  //! Return the time which is reserved for the final output
+  Clock::duration finishingTime() const noexcept;
+
+  //! Check if the deadline is set
+  bool hasDeadline() const noexcept;
+
+  //! Check if the cycle which starts at the time has to be the last one
+  bool isLastCycle(const Clock::duration& time) const noexcept;
+
+  //! Check if the time of a cycle is measured
+  bool isMeasured() const noexcept;
+
+  //! Record the time of a rendered cycle
+  void recordCycle(const Clock::duration& cycle_time) noexcept;
+
+  //! Record the time of a denoising
+  void recordDenoising(const Clock::duration& denoising_time) noexcept;
+
+  //! Record the time of an image output
+  void recordOutput(const Clock::duration& output_time) noexcept;
+
+  //! Clear the measured times
+  void reset() noexcept;
+
+  //! Set the deadline of the rendering, zero disables it
+  void setDeadline(const Clock::duration& deadline) noexcept;
+
+  //! Enable the reservation of the denoising time
+  void setDenoisingEnabled(const bool flag) noexcept;
+
+  //! Set the time which is reserved for the final output, zero measures it
+  void setFinishingTime(const Clock::duration& time) noexcept;
+
+ private:
+  //! Return the ratio of a new time in the averages
+  static constexpr double smoothingFactor() noexcept;
+
+  //! Update the average by the new value
+  static double smooth(const double average, const double value) noexcept;
+
+
+  Clock::duration deadline_;
+  Clock::duration finishing_time_; //!< The time which is specified by the user
+  double cycle_time_; //!< The average of the cycle times in seconds
+  double cycle_deviation_; //!< The average of the absolute deviations
+  double output_time_;
+  double denoising_time_;
+  uint32 num_of_cycles_;
+  bool is_denoising_enabled_;
+};
+
+} // namespace nanairo
+
+#include "time_budget_scheduler-inl.hpp"
+
+#endif // NANAIRO_TIME_BUDGET_SCHEDULER_HPP
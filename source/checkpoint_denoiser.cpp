@@ -0,0 +1,312 @@
+/*!
+  \file checkpoint_denoiser.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+// cxxopts
+#include "cxxopts.hpp"
+// LodePNG
+#include "lodepng.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/stopwatch.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "simple_progress_bar.hpp"
+#include "simple_renderer.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Color/hdr_image.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Denoiser/denoiser.hpp"
+#include "NanairoCore/Denoiser/denoising_context.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+#include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
+#include "NanairoCore/Utility/mapped_file.hpp"
+
+namespace {
+
+/*!
+  */
+struct DenoiserParameters
+{
+  std::string nanabin_file_path_ = "";
+  std::string checkpoint_path_ = "";
+  std::string output_path_ = ".";
+  std::string crop_window_ = "";
+  unsigned int threads_ = 0; //!< 0 uses the threads of the scene
+};
+
+using Clock = zisc::Stopwatch::Clock;
+
+//! Make the path of an output image
+std::string makeImagePath(const std::string& output_path,
+                          const nanairo::uint32 cycle,
+                          const std::string_view extension);
+
+//! Process command line arguments
+std::unique_ptr<DenoiserParameters> processCommandLine(int& argc,
+                                                       const char** argv);
+
+//! Write the denoised image into the output files of the scene
+bool writeImages(nanairo::System& system,
+                 const nanairo::SystemSettingNode& settings,
+                 const nanairo::SampleStatistics& statistics,
+                 const std::string& output_path,
+                 const nanairo::uint32 cycle);
+
+}
+
+int main(int argc, const char** argv)
+{
+  const auto parameters = ::processCommandLine(argc, argv);
+
+  // Only the system settings are read, so the scene isn't loaded
+  nanairo::MappedFile nanabin_file;
+  if (!nanabin_file.open(parameters->nanabin_file_path_)) {
+    std::cerr << "Error: \"" << parameters->nanabin_file_path_ << "\" not found."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  nanairo::MappedFileBuffer nanabin_buffer{nanabin_file};
+  std::istream nanabin{&nanabin_buffer};
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.readSystemData(&nanabin);
+  auto settings = nanairo::castNode<nanairo::SystemSettingNode>(
+      scene_settings.systemSettingNode());
+
+  if (!settings->isDenoisingEnabled() ||
+      (settings->denoiserType() != nanairo::DenoiserType::kBayesianCollaborative)) {
+    std::cerr << "Error: The scene doesn't use the Bayesian collaborative denoiser."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  {
+    const bool is_spectra_mode =
+        settings->colorMode() == nanairo::RenderingColorMode::kSpectra;
+    const nanairo::uint32 sample_size = settings->wavelengthSampleSize();
+    if (is_spectra_mode && (sample_size != 0) &&
+        (sample_size != nanairo::CoreConfig::wavelengthSampleSize())) {
+      std::cerr << "Error: The scene samples " << sample_size
+                << " wavelengths, but this tool samples "
+                << nanairo::CoreConfig::wavelengthSampleSize() << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  // The statistics of a cropped rendering have the resolution of the window
+  if (!parameters->crop_window_.empty()) {
+    std::array<nanairo::uint32, 4> crop_window{{0, 0, 0, 0}};
+    const int n = std::sscanf(parameters->crop_window_.c_str(), "%u,%u,%u,%u",
+                              &crop_window[0], &crop_window[1],
+                              &crop_window[2], &crop_window[3]);
+    if (n != 4) {
+      std::cerr << "Error: The crop window \"" << parameters->crop_window_
+                << "\" is invalid." << std::endl;
+      return EXIT_FAILURE;
+    }
+    settings->setCropWindow(crop_window);
+  }
+  if (0 < parameters->threads_)
+    settings->setNumOfThreads(parameters->threads_);
+  nanairo::System system{settings};
+
+  // Load the checkpoint
+  auto statistics = zisc::UniqueMemoryPointer<nanairo::SampleStatistics>::make(
+      &system.dataMemoryManager(),
+      system);
+  nanairo::SimpleRenderer::Checkpoint checkpoint;
+  if (!nanairo::SimpleRenderer::readCheckpoint(parameters->checkpoint_path_,
+                                               statistics.get(),
+                                               &checkpoint)) {
+    std::cerr << "Error: The checkpoint \"" << parameters->checkpoint_path_
+              << "\" can't be loaded for the scene." << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Denoise " << checkpoint.cycle_ << " cycles on "
+            << system.threadManager().numOfThreads() << " threads." << std::endl;
+
+  // Denoise
+  {
+    nanairo::SimpleProgressBar progress_bar;
+    auto notify_of_progress = [&progress_bar](const double progress)
+    {
+      progress_bar.update(progress, "Denoising...");
+    };
+    auto& denoiser = system.denoiser();
+    denoiser.setProgressCallback(notify_of_progress);
+    nanairo::DenoisingContext context{system};
+    const auto start_time = Clock::now();
+    denoiser.denoise(context, checkpoint.cycle_, statistics.get());
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    const auto time = std::chrono::duration_cast<Milliseconds>(Clock::now() -
+                                                               start_time);
+    std::cout << std::endl << "Denoising: " << std::fixed << std::setprecision(3)
+              << time.count() << " ms" << std::endl;
+  }
+
+  const bool result = ::writeImages(system,
+                                    *settings,
+                                    *statistics,
+                                    parameters->output_path_,
+                                    checkpoint.cycle_);
+  return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+namespace {
+
+/*!
+  \details
+  The path is the same as the path of the denoised image of SimpleNanairo.
+  */
+std::string makeImagePath(const std::string& output_path,
+                          const nanairo::uint32 cycle,
+                          const std::string_view extension)
+{
+  return output_path + "/" + std::to_string(cycle) + "cycle-denoised" +
+         std::string{extension};
+}
+
+/*!
+  */
+std::unique_ptr<DenoiserParameters> processCommandLine(int& argc,
+                                                       const char** argv)
+{
+  auto parameters = std::make_unique<DenoiserParameters>();
+
+  try {
+    cxxopts::Options options{
+        argv[0],
+        "Denoise a checkpoint of SimpleNanairo apart from the rendering."};
+    options.positional_help("[nanabin] [checkpoint]");
+
+    // Add options
+    // Help
+    {
+      options.add_options()
+          ("h,help", "Display this help.");
+    }
+    {
+      auto value = cxxopts::value(parameters->nanabin_file_path_);
+      options.add_options()
+          ("nanabin", "Specify the scene binary which rendered the checkpoint.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->checkpoint_path_);
+      options.add_options()
+          ("checkpoint", "Specify the checkpoint file.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->output_path_);
+      options.add_options()
+          ("o,outputpath", "Specify the directory of the denoised images.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->crop_window_);
+      options.add_options()
+          ("crop",
+           "Specify the crop window 'x,y,width,height' of the rendering.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->threads_);
+      options.add_options()
+          ("threads",
+           "Specify the number of the denoising threads, 0 uses the scene threads.",
+           value);
+    }
+
+    options.parse_positional({"nanabin", "checkpoint"});
+
+    // Parse command line
+    auto result = options.parse(argc, argv);
+
+    // Process command line arguments
+    if (0 < result.count("help")) {
+      std::cout << options.help({""}) << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+    if ((result.count("nanabin") == 0) || (result.count("checkpoint") == 0)) {
+      std::cerr << "Error: The scene binary and the checkpoint are required."
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  catch (const cxxopts::OptionException& error) {
+    std::cerr << "Error: " << error.what() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  return parameters;
+}
+
+/*!
+  \details
+  The images are tone mapped by the operator of the scene,
+  so they are the same as the images which the render node would output.
+  */
+bool writeImages(nanairo::System& system,
+                 const nanairo::SystemSettingNode& settings,
+                 const nanairo::SampleStatistics& statistics,
+                 const std::string& output_path,
+                 const nanairo::uint32 cycle)
+{
+  auto& data_resource = system.dataMemoryManager();
+  auto& work_resource = system.globalMemoryManager();
+  const auto& resolution = system.imageResolution();
+
+  nanairo::HdrImage hdr_image{resolution, &data_resource};
+  hdr_image.toHdr(system, 1, statistics.denoisedSampleTable());
+
+  bool result = true;
+  if (settings.isLdrImageOutputEnabled()) {
+    nanairo::LdrImage ldr_image{resolution, &data_resource};
+    ldr_image.setChannelOrder(nanairo::LdrImage::ChannelOrder::kRgba);
+    system.toneMappingOperator().map(system, hdr_image, &ldr_image, &work_resource);
+    const auto ldr_image_path = ::makeImagePath(output_path, cycle, ".png");
+    const auto& buffer = ldr_image.data();
+    const auto error = lodepng::encode(ldr_image_path,
+                                       zisc::treatAs<const nanairo::uint8*>(buffer.data()),
+                                       ldr_image.widthResolution(),
+                                       ldr_image.heightResolution());
+    if (error) {
+      std::cerr << "LodePNG error[" << error << "]: " << lodepng_error_text(error)
+                << std::endl;
+      result = false;
+    }
+  }
+  if (settings.isHdrImageOutputEnabled()) {
+    using RgbBuffer = zisc::pmr::vector<std::array<float, 3>>;
+    RgbBuffer rgb_image{hdr_image.size(), RgbBuffer::allocator_type{&data_resource}};
+    hdr_image.toRgb(system, &rgb_image, &work_resource);
+    const auto hdr_image_path = ::makeImagePath(
+        output_path,
+        cycle,
+        nanairo::HdrImage::pfmFileExtension());
+    if (!nanairo::HdrImage::writePfm(rgb_image, resolution, hdr_image_path)) {
+      std::cerr << "PFM error: saving image failed: " << hdr_image_path << std::endl;
+      result = false;
+    }
+  }
+  return result;
+}
+
+}
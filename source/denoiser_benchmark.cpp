@@ -0,0 +1,327 @@
+/*!
+  \file denoiser_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+// cxxopts
+#include "cxxopts.hpp"
+// Zisc
+#include "zisc/stopwatch.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Denoiser/denoiser.hpp"
+#include "NanairoCore/Denoiser/denoising_context.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+
+namespace {
+
+/*!
+  */
+struct BenchmarkParameters
+{
+  unsigned int width_ = 512;
+  unsigned int height_ = 512;
+  unsigned int cycles_ = 16;
+  unsigned int histogram_bins_ = 16;
+  unsigned int number_of_scales_ = 2;
+  unsigned int threads_ = 0;
+  unsigned int repetitions_ = 3;
+  unsigned int seed_ = 123456789;
+  bool is_spectral_ = false;
+  bool is_single_precision_ = false;
+  bool hardware_counters_ = false;
+};
+
+using Clock = zisc::Stopwatch::Clock;
+
+//! Fill the statistics with the synthetic samples of the cycles
+void makeSyntheticStatistics(nanairo::System& system,
+                             const BenchmarkParameters& parameters,
+                             nanairo::SampleStatistics* statistics);
+
+//! Process command line arguments
+std::unique_ptr<BenchmarkParameters> processCommandLine(int& argc,
+                                                        const char** argv);
+
+//! Print the hardware counts of a denoising
+void printHardwareCounts(const nanairo::HardwareCounts& counts);
+
+//! Print the time of the phases of a denoising
+void printPhases(const unsigned int repetition,
+                 const nanairo::DenoisingContext& context,
+                 const Clock::duration total_time);
+
+}
+
+int main(int argc, const char** argv)
+{
+  const auto parameters = ::processCommandLine(argc, argv);
+
+  // Initialize the system
+  // The setting nodes allocate their data from the root scene node
+  nanairo::SceneSettingNode scene_settings;
+  scene_settings.initialize();
+  auto settings = nanairo::castNode<nanairo::SystemSettingNode>(
+      scene_settings.systemSettingNode());
+  settings->setImageResolution(parameters->width_, parameters->height_);
+  if (0 < parameters->threads_)
+    settings->setNumOfThreads(parameters->threads_);
+  settings->setColorMode(parameters->is_spectral_
+      ? nanairo::RenderingColorMode::kSpectra
+      : nanairo::RenderingColorMode::kRgb);
+  settings->setSamplesPerCycle(1);
+  settings->enableDenoising(true);
+  settings->setDenoiserType(nanairo::DenoiserType::kBayesianCollaborative);
+  {
+    auto& bcd_parameters = settings->bayesianCollaborativeDenoiserParameters();
+    bcd_parameters.histogram_bins_ = parameters->histogram_bins_;
+    bcd_parameters.number_of_scales_ = parameters->number_of_scales_;
+    bcd_parameters.single_precision_ = parameters->is_single_precision_
+        ? nanairo::kTrue
+        : nanairo::kFalse;
+  }
+  nanairo::System system{settings};
+  if (parameters->hardware_counters_ && !system.enableHardwareCounters())
+    std::cerr << "Warning: The hardware counters can't be opened." << std::endl;
+
+  std::cout << "Resolution: " << parameters->width_ << "x" << parameters->height_
+            << ", cycles: " << parameters->cycles_
+            << ", bins: " << parameters->histogram_bins_
+            << ", scales: " << parameters->number_of_scales_
+            << ", dimension: " << (parameters->is_spectral_ ? "spectra" : "RGB")
+            << ", precision: "
+            << (parameters->is_single_precision_ ? "float" : "default")
+            << ", threads: " << system.threadManager().numOfThreads()
+            << std::endl;
+
+  auto statistics = zisc::UniqueMemoryPointer<nanairo::SampleStatistics>::make(
+      &system.dataMemoryManager(),
+      system);
+  ::makeSyntheticStatistics(system, *parameters, statistics.get());
+
+  // The first denoising selects the similar patches from scratch,
+  // and the latter ones reuse the warm start masks
+  auto& denoiser = system.denoiser();
+  for (unsigned int r = 0; r < parameters->repetitions_; ++r) {
+    nanairo::DenoisingContext context{system};
+    const auto start_time = Clock::now();
+    const auto start_counts = system.readHardwareCounters();
+    denoiser.denoise(context, parameters->cycles_, statistics.get());
+    const auto total_time = Clock::now() - start_time;
+    const auto counts = system.readHardwareCounters().since(start_counts);
+    ::printPhases(r, context, total_time);
+    ::printHardwareCounts(counts);
+  }
+
+  return 0;
+}
+
+namespace {
+
+/*!
+  \details
+  The image is a checkerboard of two spectra under a horizontal gradient,
+  so the patches have edges and flat regions like a rendered image.
+  A sample is the radiance times an exponential noise of mean 1,
+  which has the long tail of the path tracing noise.
+  */
+void makeSyntheticStatistics(nanairo::System& system,
+                             const BenchmarkParameters& parameters,
+                             nanairo::SampleStatistics* statistics)
+{
+  using nanairo::Float;
+  std::mt19937 engine{parameters.seed_};
+  std::exponential_distribution<Float> noise{1.0};
+
+  auto& sampler = system.globalSampler();
+  constexpr unsigned int checker_size = 32;
+  for (nanairo::uint32 cycle = 1; cycle <= parameters.cycles_; ++cycle) {
+    nanairo::PathState path_state{cycle};
+    path_state.setDimension(nanairo::SampleDimension::kWavelengthSample1);
+    const auto sampled_wavelengths = parameters.is_spectral_
+        ? nanairo::WavelengthSampler::sampleStratified(sampler, path_state)
+        : nanairo::WavelengthSampler::sampleRgb(sampler, path_state);
+    const auto& wavelengths = sampled_wavelengths.wavelengths();
+    statistics->setWavelengths(system, wavelengths);
+
+    nanairo::SampledSpectra sample{wavelengths};
+    for (nanairo::uint y = 0; y < parameters.height_; ++y) {
+      for (nanairo::uint x = 0; x < parameters.width_; ++x) {
+        const bool is_odd = (((x / checker_size) + (y / checker_size)) % 2) == 1;
+        const Float gradient = 0.25 + 0.75 * zisc::cast<Float>(x) /
+                                             zisc::cast<Float>(parameters.width_);
+        for (nanairo::uint i = 0; i < sample.size(); ++i) {
+          const Float t = zisc::cast<Float>(sample.wavelength(i) -
+                                            nanairo::CoreConfig::shortestWavelength()) /
+                          zisc::cast<Float>(nanairo::CoreConfig::wavelengthRange());
+          const Float radiance = is_odd ? 0.2 + 0.6 * t : 0.8 - 0.6 * t;
+          sample.setIntensity(i, gradient * radiance * noise(engine));
+        }
+        statistics->addSample(nanairo::Index2d{x, y}, sample);
+      }
+    }
+    statistics->update(system, wavelengths, cycle);
+  }
+}
+
+/*!
+  */
+std::unique_ptr<BenchmarkParameters> processCommandLine(int& argc,
+                                                        const char** argv)
+{
+  auto parameters = std::make_unique<BenchmarkParameters>();
+
+  try {
+    cxxopts::Options options{
+        argv[0],
+        "Measure the Bayesian collaborative denoiser on synthetic statistics."};
+
+    // Add options
+    // Help
+    {
+      options.add_options()
+          ("h,help", "Display this help.");
+    }
+    {
+      auto value = cxxopts::value(parameters->width_);
+      options.add_options()
+          ("width", "Specify the width of the image.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->height_);
+      options.add_options()
+          ("height", "Specify the height of the image.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->cycles_);
+      options.add_options()
+          ("cycles", "Specify the number of the sampled cycles.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->histogram_bins_);
+      options.add_options()
+          ("bins", "Specify the number of the histogram bins.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->number_of_scales_);
+      options.add_options()
+          ("scales", "Specify the number of the scales.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->is_spectral_);
+      options.add_options()
+          ("spectral", "Denoise the spectra instead of RGB.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->is_single_precision_);
+      options.add_options()
+          ("single", "Denoise in single precision.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->threads_);
+      options.add_options()
+          ("threads", "Specify the number of the threads, 0 uses all cores.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->repetitions_);
+      options.add_options()
+          ("repetitions", "Specify the number of the denoisings.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->seed_);
+      options.add_options()
+          ("seed", "Specify the seed of the synthetic noise.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->hardware_counters_);
+      options.add_options()
+          ("hwcounters",
+           "Count the hardware events of the denoisings (Linux only).", value);
+    }
+
+    // Parse command line
+    auto result = options.parse(argc, argv);
+
+    // Process command line arguments
+    if (0 < result.count("help")) {
+      std::cout << options.help({""}) << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+    if ((parameters->width_ == 0) || (parameters->height_ == 0) ||
+        (parameters->cycles_ == 0)) {
+      std::cerr << "Error: The resolution and the cycles must be positive."
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  catch (const cxxopts::OptionException& error) {
+    std::cerr << "Error: " << error.what() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  return parameters;
+}
+
+/*!
+  \details
+  The counts are the counts of the denoising threads,
+  which are printed only if the counters are opened.
+  */
+void printHardwareCounts(const nanairo::HardwareCounts& counts)
+{
+  using nanairo::HardwareCounts;
+  using nanairo::HardwareEvent;
+  if (!counts.isValid())
+    return;
+  std::cout << "  Hardware counts:";
+  for (nanairo::uint i = 0; i < HardwareCounts::numOfEvents(); ++i) {
+    const auto event = zisc::cast<HardwareEvent>(i);
+    if (counts.isValid(event))
+      std::cout << " " << HardwareCounts::eventName(event) << "=" << counts.count(event);
+  }
+  std::cout << ", IPC: " << std::setprecision(2) << counts.instructionsPerCycle()
+            << std::endl;
+}
+
+/*!
+  */
+void printPhases(const unsigned int repetition,
+                 const nanairo::DenoisingContext& context,
+                 const Clock::duration total_time)
+{
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  std::cout << "Denoising " << repetition << ": " << std::fixed
+            << std::setprecision(3)
+            << std::chrono::duration_cast<Milliseconds>(total_time).count()
+            << " ms" << std::endl;
+  for (const auto& phase : context.phaseList()) {
+    const auto time = std::chrono::duration_cast<Milliseconds>(phase.time_);
+    std::cout << "  " << phase.name_ << ": " << time.count() << " ms" << std::endl;
+  }
+}
+
+}
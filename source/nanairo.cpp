@@ -22,12 +22,15 @@
 #include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
+#include <QFile>
 #include <QFileInfo>
 #include <QFont>
 #include <QFontDatabase>
 #include <QGuiApplication>
 #include <QScopedPointer>
 #include <QString>
+#include <QStringList>
+#include <QTextStream>
 #include <QtGlobal>
 #include <QQmlApplicationEngine>
 #include <QUrl>
@@ -55,7 +58,7 @@ enum class RendererManagerType
   */
 struct NanairoParameters
 {
-  QString scene_file_path_;
+  QStringList scene_file_list_; //!< The scenes are rendered in order
   QString output_path_;
   RendererManagerType manager_type_ = RendererManagerType::kGui;
   bool is_saving_scene_binary_enabled_ = false;
@@ -176,10 +179,18 @@ std::unique_ptr<NanairoParameters> processCommandLine(
   // Scene file
   QCommandLineOption scene_file_path_option{
       {"s", "scenefile"},
-      "Specify the rendering scene for cui rendering.",
+      "Specify the rendering scene for cui rendering, "
+      "the scenes of the repeated option are rendered in order.",
       "path",
       ":/NanairoGui/scene/DefaultScene.nana"};
   parser.addOption(scene_file_path_option);
+  // Scene queue
+  QCommandLineOption scene_queue_option{
+      {"q", "scenequeue"},
+      "Specify a file which lists the rendering scenes for cui rendering, "
+      "a scene path per line. The loaded meshes, images and BVHs are shared.",
+      "path"};
+  parser.addOption(scene_queue_option);
   // Output path
   QCommandLineOption output_path_option{
       {"o", "outputfilepath"},
@@ -217,11 +228,27 @@ std::unique_ptr<NanairoParameters> processCommandLine(
   }
   // Scene file path
   {
-    const auto file_path = parser.value(scene_file_path_option);
-    QString error_message;
-    if (!nanairo::SceneDocument::isSceneDocument(file_path, error_message))
-      zisc::raiseError(error_message.toStdString());
-    parameters->scene_file_path_ = file_path;
+    auto file_list = parser.values(scene_file_path_option);
+    if (parser.isSet(scene_queue_option)) {
+      if (!parser.isSet(scene_file_path_option))
+        file_list.clear();
+      const auto queue_path = parser.value(scene_queue_option);
+      QFile queue_file{queue_path};
+      if (!queue_file.open(QIODevice::ReadOnly | QIODevice::Text))
+        zisc::raiseError("The scene queue isn't found: ", queue_path.toStdString());
+      QTextStream queue{&queue_file};
+      while (!queue.atEnd()) {
+        const auto line = queue.readLine().trimmed();
+        if (!line.isEmpty() && !line.startsWith('#'))
+          file_list.append(line);
+      }
+    }
+    for (const auto& file_path : file_list) {
+      QString error_message;
+      if (!nanairo::SceneDocument::isSceneDocument(file_path, error_message))
+        zisc::raiseError(error_message.toStdString());
+    }
+    parameters->scene_file_list_ = file_list;
   }
   // Output path
   {
@@ -269,7 +296,7 @@ std::function<int ()> makeRenderRunner(
         nanairo::CuiRendererManager manager;
         manager.enableSavingSceneBinary(parameters.is_saving_scene_binary_enabled_);
         manager.setOutputPath(parameters.output_path_);
-        manager.invokeRendering(parameters.scene_file_path_);
+        manager.invokeRendering(parameters.scene_file_list_);
         return 0;
       };
       break;
@@ -8,19 +8,45 @@
   */
 
 // Standard C++ library
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
 #include <fstream>
 #include <initializer_list>
 #include <iostream>
+#include <istream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#endif
 // cxxopts
 #include "cxxopts.hpp"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "simple_renderer.hpp"
 #include "simple_progress_bar.hpp"
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Color/hdr_image.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
 #include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+#include "NanairoCore/Utility/loading_phase.hpp"
+#include "NanairoCore/Utility/mapped_file.hpp"
 
 namespace {
 
@@ -30,40 +56,228 @@ struct NanairoParameters
 {
   std::string nanabin_file_path_ = " ";
   std::string output_path_ = ".";
+  std::string bvh_cache_path_ = "";
+  std::string resume_checkpoint_path_ = "";
+  std::string crop_window_ = "";
+  std::string trace_path_ = "";
+  std::string metrics_path_ = ""; //!< Empty disables the live metrics
+  std::string camera_track_path_ = "";
+  std::string reference_path_ = ""; //!< The reference PFM of the convergence
+  std::string out_of_core_path_ = ""; //!< Empty places the geometry in memory
+  std::string film_file_path_ = ""; //!< Empty places the film in memory
+  std::vector<std::string> merged_checkpoint_path_list_;
+  std::vector<unsigned int> benchmark_thread_list_; //!< Empty uses the scene threads
+  std::vector<unsigned int> error_time_list_{1, 2, 4, 8, 16, 32}; //!< Seconds
+  unsigned int checkpoint_interval_ = 0; //!< Minutes
+  unsigned int denoising_threads_ = 0;
+  unsigned int denoising_memory_ = 0; //!< MB
+  unsigned int out_of_core_budget_ = 0; //!< MB, 0 is unbounded
+  unsigned int film_budget_ = 0; //!< MB, 0 is unbounded
+  unsigned int seed_offset_ = 0;
+  unsigned int benchmark_cycles_ = 0; //!< 0 disables the benchmark mode
+  unsigned int benchmark_warmup_cycles_ = 4;
+  unsigned int active_threads_ = 0; //!< 0 uses all rendering threads
+  unsigned int deadline_ = 0; //!< Seconds, 0 disables it
+  unsigned int finishing_time_ = 0; //!< Seconds, 0 measures it
+  unsigned int stream_port_ = 0; //!< 0 disables the frame streaming
+  unsigned int metrics_interval_ = 1; //!< Seconds
+  bool service_mode_ = false;
+  bool is_making_reference_ = false;
+  bool hardware_counters_ = false;
+  bool shading_profile_ = false;
 };
 
 //! Process command line arguments
 std::unique_ptr<NanairoParameters> processCommandLine(int& argc, const char** argv);
 
-//! Load Nanairo binary file
-std::ifstream loadSceneBinary(const std::string& nanabin_file_path);
+//! Map Nanairo binary file into memory
+bool loadSceneBinary(const std::string& nanabin_file_path,
+                     nanairo::MappedFile* nanabin_file);
+
+//! Run the variant of the app which is built for the wavelength sample size
+void runWavelengthVariant(const nanairo::uint32 sample_size,
+                          const std::vector<std::string>& arg_list);
+
+//! Measure the headless rendering of the scene and print the result as a JSON
+void runBenchmark(const NanairoParameters& parameters,
+                  const nanairo::LoadingPhase& parse_phase,
+                  nanairo::SceneSettingNode* settings);
+
+//! Measure the errors of the rendering against a reference and print them as a JSON
+void runConvergenceBenchmark(const NanairoParameters& parameters,
+                             const nanairo::LoadingPhase& parse_phase,
+                             const nanairo::SceneSettingNode& settings);
+
+//! Parse a job line of the service mode
+bool parseRenderJob(const std::string& line,
+                    nanairo::SimpleRenderer::RenderJob* job);
+
+//! Render the jobs of the stream with the loaded scene
+void runService(const nanairo::SceneSettingNode& settings,
+                std::istream& job_stream,
+                nanairo::SimpleRenderer* renderer);
+
+//! Change the number of the active threads by the user signals
+void installThreadSignalHandlers(nanairo::SimpleRenderer* renderer);
 
 }
 
 int main(int argc, const char** argv)
 {
   std::string output_path;
+  std::vector<std::string> merged_checkpoint_path_list;
   std::unique_ptr<std::ofstream> log_stream;
   std::unique_ptr<nanairo::SimpleRenderer> renderer;
   {
+    // The command line parser consumes the arguments
+    const std::vector<std::string> arg_list{argv, argv + argc};
     // Process command line
     auto parameters = ::processCommandLine(argc, argv);
     // Load nanairo binary file
-    auto nanabin = ::loadSceneBinary(parameters->nanabin_file_path_);
+    using Clock = nanairo::SimpleRenderer::Clock;
+    const auto parse_start_time = Clock::now();
+    const auto parse_start_memory = nanairo::residentMemorySize();
+    nanairo::MappedFile nanabin_file;
+    ::loadSceneBinary(parameters->nanabin_file_path_, &nanabin_file);
+    nanairo::MappedFileBuffer nanabin_buffer{nanabin_file};
+    std::istream nanabin{&nanabin_buffer};
+    // The scene which samples the other number of wavelengths is rendered
+    // by the variant of the app, so only the system settings are read first
+    {
+      nanairo::SceneSettingNode system_data;
+      system_data.readSystemData(&nanabin);
+      auto system_settings = nanairo::castNode<nanairo::SystemSettingNode>(
+          system_data.systemSettingNode());
+      const nanairo::uint32 sample_size = system_settings->wavelengthSampleSize();
+      const bool is_spectra_mode =
+          system_settings->colorMode() == nanairo::RenderingColorMode::kSpectra;
+      if (is_spectra_mode && (sample_size != 0) &&
+          (sample_size != nanairo::CoreConfig::wavelengthSampleSize()))
+        ::runWavelengthVariant(sample_size, arg_list);
+      nanabin.seekg(0);
+    }
     // Load scene settings
     nanairo::SceneSettingNode settings;
     settings.readData(&nanabin);
+    const nanairo::LoadingPhase parse_phase{
+        "Settings parse",
+        Clock::now() - parse_start_time,
+        zisc::cast<nanairo::int64>(nanairo::residentMemorySize()) -
+            zisc::cast<nanairo::int64>(parse_start_memory)};
+    {
+      auto bvh_settings = nanairo::castNode<nanairo::BvhSettingNode>(
+          settings.bvhSettingNode());
+      bvh_settings->setCacheDirectory(parameters->bvh_cache_path_);
+    }
+    {
+      // The nodes of a distributed rendering sample from different seeds
+      auto system_settings = nanairo::castNode<nanairo::SystemSettingNode>(
+          settings.systemSettingNode());
+      const auto seed = system_settings->samplerSeed() + parameters->seed_offset_;
+      system_settings->setSamplerSeed(seed);
+      std::array<nanairo::uint32, 4> crop_window{{0, 0, 0, 0}};
+      if (!parameters->crop_window_.empty()) {
+        const int n = std::sscanf(parameters->crop_window_.c_str(), "%u,%u,%u,%u",
+                                  &crop_window[0], &crop_window[1],
+                                  &crop_window[2], &crop_window[3]);
+        if (n != 4) {
+          std::cerr << "Error: The crop window \"" << parameters->crop_window_
+                    << "\" is invalid." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+      }
+      system_settings->setCropWindow(crop_window);
+      // The denoising threads are taken from the rendering threads
+      if (0 < parameters->denoising_threads_) {
+        const nanairo::uint32 n = system_settings->numOfThreads();
+        const nanairo::uint32 num_of_threads = (parameters->denoising_threads_ < n)
+            ? n - parameters->denoising_threads_
+            : 1u;
+        system_settings->setNumOfThreads(num_of_threads);
+      }
+      system_settings->setOutOfCore(
+          parameters->out_of_core_path_,
+          zisc::cast<std::size_t>(parameters->out_of_core_budget_) * 1024 * 1024);
+      system_settings->setMappedFilm(
+          parameters->film_file_path_,
+          zisc::cast<std::size_t>(parameters->film_budget_) * 1024 * 1024);
+    }
+    // Measure the rendering instead of rendering the images
+    if (0 < parameters->benchmark_cycles_) {
+      ::runBenchmark(*parameters, parse_phase, &settings);
+      return 0;
+    }
+    if (!parameters->reference_path_.empty()) {
+      ::runConvergenceBenchmark(*parameters, parse_phase, settings);
+      return 0;
+    }
     // Initialize renderer
     renderer = std::make_unique<nanairo::SimpleRenderer>();
     log_stream = nanairo::makeTextLogStream(parameters->output_path_);
     renderer->setLogStream(log_stream.get());
+    renderer->addLoadingPhase(parse_phase);
     std::string error_message;
     const bool is_runnable = renderer->loadScene(settings, &error_message);
     if (!is_runnable) {
       std::cerr << "Scene loading error: " << error_message;
       exit(EXIT_FAILURE);
     }
+    renderer->outputLoadingProfile(parameters->output_path_);
+    if (parameters->hardware_counters_)
+      renderer->enableHardwareCounters();
+    if (parameters->shading_profile_)
+      renderer->enableShadingProfile();
+    if (0 < parameters->active_threads_)
+      renderer->requestNumOfActiveThreads(parameters->active_threads_);
+    ::installThreadSignalHandlers(renderer.get());
+    // Checkpoint
+    {
+      const std::chrono::minutes interval{parameters->checkpoint_interval_};
+      renderer->setCheckpoint(parameters->output_path_ + "/checkpoint.bin",
+                              std::chrono::duration_cast<Clock::duration>(interval));
+      renderer->setResumeCheckpoint(parameters->resume_checkpoint_path_);
+    }
+    renderer->setAsyncDenoising(parameters->denoising_threads_);
+    {
+      const std::chrono::seconds deadline{parameters->deadline_};
+      renderer->setDeadline(std::chrono::duration_cast<Clock::duration>(deadline));
+      const std::chrono::seconds finishing_time{parameters->finishing_time_};
+      renderer->setFinishingTime(
+          std::chrono::duration_cast<Clock::duration>(finishing_time));
+    }
+    renderer->setTraceFile(parameters->trace_path_);
+    {
+      const std::chrono::seconds interval{parameters->metrics_interval_};
+      renderer->setMetricsFile(parameters->metrics_path_,
+                               std::chrono::duration_cast<Clock::duration>(interval));
+    }
+    renderer->setStreamPort(zisc::cast<nanairo::uint16>(parameters->stream_port_));
+    // The scene stays loaded while the jobs are rendered
+    if (parameters->service_mode_) {
+      ::runService(settings, std::cin, renderer.get());
+      return 0;
+    }
+    // The cameras of the track are rendered with the same world
+    if (!parameters->camera_track_path_.empty()) {
+      std::ifstream camera_track{parameters->camera_track_path_};
+      if (!camera_track.is_open()) {
+        std::cerr << "Error: \"" << parameters->camera_track_path_
+                  << "\" not found." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      ::runService(settings, camera_track, renderer.get());
+      return 0;
+    }
+    renderer->setDenoisingMemoryBudget(
+        zisc::cast<std::size_t>(parameters->denoising_memory_) * 1024 * 1024);
     output_path = std::move(parameters->output_path_);
+    merged_checkpoint_path_list = std::move(parameters->merged_checkpoint_path_list_);
+  }
+
+  // Merge the checkpoints of a distributed rendering
+  if (!merged_checkpoint_path_list.empty()) {
+    renderer->mergeCheckpoints(merged_checkpoint_path_list, output_path);
+    return 0;
   }
 
   // Make a progress bar 
@@ -111,6 +325,220 @@ std::unique_ptr<NanairoParameters> processCommandLine(int& argc, const char** ar
       options.add_options()
           ("o,outputpath", "Specify the output dir in which images are saved.", value);
     }
+    {
+      auto value = cxxopts::value(parameters->bvh_cache_path_);
+      options.add_options()
+          ("bvhcache", "Specify the dir in which built BVHs are cached.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->checkpoint_interval_);
+      options.add_options()
+          ("checkpointinterval",
+           "Specify the interval in minutes to save a checkpoint, 0 disables it.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->deadline_);
+      options.add_options()
+          ("deadline",
+           "Specify the seconds which the rendering and the final output have to "
+           "finish in, the cycles are planned from the measured times.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->finishing_time_);
+      options.add_options()
+          ("finishtime",
+           "Specify the seconds which are reserved for the final output before "
+           "the deadline, 0 measures them.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->resume_checkpoint_path_);
+      options.add_options()
+          ("resume", "Resume the rendering from the checkpoint file.", value);
+    }
+    {
+      auto value = cxxopts::value(parameters->stream_port_);
+      options.add_options()
+          ("streamport",
+           "Specify the TCP port which the tone mapped frames are streamed on "
+           "to a remote viewer, which can move the camera. 0 disables it.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->seed_offset_);
+      options.add_options()
+          ("seedoffset",
+           "Specify the offset of the sampler seed of a node of a distributed rendering.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->crop_window_);
+      options.add_options()
+          ("crop",
+           "Render only the region of the image which is specified as 'x,y,width,height'.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->denoising_threads_);
+      options.add_options()
+          ("denoisethreads",
+           "Denoise the saved images on the threads while the rendering continues.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->denoising_memory_);
+      options.add_options()
+          ("denoisememory",
+           "Specify the work memory in MB of a denoising, a large image is denoised in tiles.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->out_of_core_path_);
+      options.add_options()
+          ("outofcore",
+           "Place the geometry in a temporary file of the directory, "
+           "which is paged in on demand.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->out_of_core_budget_);
+      options.add_options()
+          ("outofcorebudget",
+           "Specify the resident memory in MB of the out-of-core geometry, "
+           "the least recently used geometry over it is paged out after each cycle.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->film_file_path_);
+      options.add_options()
+          ("filmfile",
+           "Map the film and the images from a temporary file of the directory, "
+           "so a gigapixel image can be rendered.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->film_budget_);
+      options.add_options()
+          ("filmbudget",
+           "Specify the resident memory in MB of the mapped film, "
+           "the tiles which aren't rendered recently are paged out after each cycle.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->trace_path_);
+      options.add_options()
+          ("trace",
+           "Write the timeline of the rendering phases into the file as a Chrome trace JSON.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->metrics_path_);
+      options.add_options()
+          ("metrics",
+           "Write the live metrics of the rendering into the file "
+           "in the Prometheus text format, such as for a textfile collector.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->metrics_interval_);
+      options.add_options()
+          ("metricsinterval",
+           "Specify the seconds between the writes of the metrics.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->shading_profile_);
+      options.add_options()
+          ("shadingprofile",
+           "Measure the shading cost of each material and write it into "
+           "'shading_profile.json' at the end of the rendering.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->benchmark_cycles_);
+      options.add_options("Benchmark")
+          ("benchmark",
+           "Render the cycles without output and print the throughput as a JSON.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->benchmark_warmup_cycles_);
+      options.add_options("Benchmark")
+          ("warmup", "Specify the cycles which are rendered before the benchmark.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->benchmark_thread_list_);
+      options.add_options("Benchmark")
+          ("threadsweep",
+           "Benchmark with each number of threads of the list, such as '1,2,4,8'.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->hardware_counters_);
+      options.add_options("Benchmark")
+          ("hwcounters",
+           "Count the cycles, the instructions and the cache, branch and TLB "
+           "misses of the cycle phases by the perf events (Linux only).",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->reference_path_);
+      options.add_options("Benchmark")
+          ("convergence",
+           "Render for the error times and print the errors against "
+           "the reference PFM file as a JSON.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->error_time_list_);
+      options.add_options("Benchmark")
+          ("errortimes",
+           "Specify the rendering seconds which the errors are measured at, "
+           "such as '1,2,4,8'.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->is_making_reference_);
+      options.add_options("Benchmark")
+          ("makereference",
+           "Render for the last error time and write the image into "
+           "the reference PFM file instead.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->active_threads_);
+      options.add_options()
+          ("activethreads",
+           "Specify the number of the threads which render at the start, "
+           "SIGUSR1 and SIGUSR2 add and remove a thread at the next cycle.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->service_mode_);
+      options.add_options()
+          ("service",
+           "Keep the scene loaded and render the jobs of the standard input, "
+           "a job per line as '<outputpath> [cycle=N] [time=ms] [camera=m00,...,m33]'.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->camera_track_path_);
+      options.add_options()
+          ("cameratrack",
+           "Render the cameras of the file with the loaded scene, "
+           "a camera per line in the same format as the jobs of the service.",
+           value);
+    }
+    {
+      auto value = cxxopts::value(parameters->merged_checkpoint_path_list_);
+      options.add_options()
+          ("merge",
+           "Merge the checkpoints of the nodes and output the images instead of rendering.",
+           value);
+    }
 
     // Parse command line
     options.parse_positional({"binpath"});
@@ -118,7 +546,7 @@ std::unique_ptr<NanairoParameters> processCommandLine(int& argc, const char** ar
 
     // Process command line arguments
     if (0 < result.count("help")) {
-      std::cout << options.help({""}) << std::endl;
+      std::cout << options.help({"", "Benchmark"}) << std::endl;
       exit(EXIT_SUCCESS);
     }
     if (result.count("binpath") == 0) {
@@ -129,6 +557,10 @@ std::unique_ptr<NanairoParameters> processCommandLine(int& argc, const char** ar
       parameters->output_path_.clear();
       parameters->output_path_ = ".";
     }
+    if (65535 < parameters->stream_port_) {
+      std::cerr << "Error: the stream port is out of range." << std::endl;
+      exit(EXIT_FAILURE);
+    }
   }
   catch (const cxxopts::OptionException& error) {
     std::cerr << "Error: " << error.what() << std::endl;
@@ -139,13 +571,336 @@ std::unique_ptr<NanairoParameters> processCommandLine(int& argc, const char** ar
 }
 
 /*!
+  \details
+  The scene is parsed from the mapped pages directly,
+  so the large arrays are copied out of the page cache by bulk reads.
   */
-std::ifstream loadSceneBinary(const std::string& nanabin_file_path)
+bool loadSceneBinary(const std::string& nanabin_file_path,
+                     nanairo::MappedFile* nanabin_file)
 {
-  std::ifstream nanabin{nanabin_file_path, std::ios::binary};
-  if (!nanabin.is_open())
+  const bool is_opened = nanabin_file->open(nanabin_file_path);
+  if (!is_opened)
     std::cerr << "Error: \"" << nanabin_file_path << "\" not found." << std::endl;
-  return nanabin;
+  return is_opened;
+}
+
+/*!
+  \details
+  The variant is found in the directory of the app and replaces the process
+  with the same arguments. If the variant isn't found,
+  the scene is rendered with the wavelength sample size of this app.
+  */
+void runWavelengthVariant(const nanairo::uint32 sample_size,
+                          const std::vector<std::string>& arg_list)
+{
+  const std::string& app_path = arg_list[0];
+  const auto separator = app_path.find_last_of("/\\");
+  std::string variant_path = (separator != std::string::npos)
+      ? app_path.substr(0, separator + 1)
+      : std::string{};
+  variant_path += "SimpleNanairo_w" + std::to_string(sample_size);
+#if defined(_WIN32)
+  variant_path += ".exe";
+#endif
+  std::vector<char*> args;
+  args.reserve(arg_list.size() + 1);
+  for (const auto& arg : arg_list)
+    args.emplace_back(const_cast<char*>(arg.c_str()));
+  args.emplace_back(nullptr);
+#if defined(__unix__) || defined(__APPLE__)
+  ::execv(variant_path.c_str(), args.data());
+#elif defined(_WIN32)
+  const auto result = ::_spawnv(_P_WAIT, variant_path.c_str(), args.data());
+  if (result != -1)
+    exit(zisc::cast<int>(result));
+#endif
+  std::cerr << "Warning: \"" << variant_path << "\" not found, "
+            << nanairo::CoreConfig::wavelengthSampleSize()
+            << " wavelengths are sampled instead of " << sample_size << "."
+            << std::endl;
+}
+
+/*!
+  \details
+  The scene is loaded for each number of threads of the sweep,
+  so the load time and the BVH build time scale with the threads too.
+  The progress and the logs aren't output so that the standard output
+  has only the JSON. The phases of the cycles have the hardware counts
+  if the counters are enabled, the method phases are the sub phases
+  of the rendering phase.
+  */
+void runBenchmark(const NanairoParameters& parameters,
+                  const nanairo::LoadingPhase& parse_phase,
+                  nanairo::SceneSettingNode* settings)
+{
+  using Second = std::chrono::duration<double>;
+  auto system_settings = nanairo::castNode<nanairo::SystemSettingNode>(
+      settings->systemSettingNode());
+  auto thread_list = parameters.benchmark_thread_list_;
+  if (thread_list.empty())
+    thread_list.emplace_back(system_settings->numOfThreads());
+
+  std::cout << "{\n"
+            << "  \"cycles\": " << parameters.benchmark_cycles_ << ",\n"
+            << "  \"warmup_cycles\": " << parameters.benchmark_warmup_cycles_ << ",\n"
+            << "  \"runs\": [";
+  for (std::size_t i = 0; i < thread_list.size(); ++i) {
+    const nanairo::uint32 num_of_threads = (0 < thread_list[i]) ? thread_list[i] : 1u;
+    system_settings->setNumOfThreads(num_of_threads);
+    nanairo::SimpleRenderer renderer;
+    renderer.addLoadingPhase(parse_phase);
+    std::string error_message;
+    if (!renderer.loadScene(*settings, &error_message)) {
+      std::cerr << "Scene loading error: " << error_message;
+      exit(EXIT_FAILURE);
+    }
+    if (parameters.hardware_counters_ && !renderer.enableHardwareCounters())
+      std::cerr << "Warning: The hardware counters can't be opened." << std::endl;
+    const auto result = renderer.benchmark(parameters.benchmark_warmup_cycles_,
+                                           parameters.benchmark_cycles_);
+    const double load_time = std::chrono::duration_cast<Second>(
+        result.loading_time_).count();
+    const double bvh_build_time = std::chrono::duration_cast<Second>(
+        result.bvh_build_time_).count();
+    const double rendering_time = std::chrono::duration_cast<Second>(
+        result.rendering_time_).count();
+    const double k = (0.0 < rendering_time) ? 1.0 / rendering_time : 0.0;
+    std::cout << ((i == 0) ? "\n" : ",\n")
+              << "    {\"threads\": " << result.num_of_threads_ << ", "
+              << "\"load_time_s\": " << load_time << ", "
+              << "\"bvh_build_time_s\": " << bvh_build_time << ", "
+              << "\"render_time_s\": " << rendering_time << ", "
+              << "\"samples\": " << result.num_of_samples_ << ", "
+              << "\"rays\": " << result.num_of_rays_ << ", "
+              << "\"samples_per_second\": "
+              << k * zisc::cast<double>(result.num_of_samples_) << ", "
+              << "\"rays_per_second\": "
+              << k * zisc::cast<double>(result.num_of_rays_) << ",\n"
+              << "     \"phases\": [";
+    for (std::size_t j = 0; j < result.phase_list_.size(); ++j) {
+      const auto& phase = result.phase_list_[j];
+      std::cout << ((j == 0) ? "\n" : ",\n")
+                << "       {\"name\": \"" << phase.name_ << "\", "
+                << "\"time_s\": "
+                << std::chrono::duration_cast<Second>(phase.time_).count();
+      const auto& counts = phase.counts_;
+      if (counts.isValid()) {
+        std::cout << ", \"counters\": {";
+        bool is_first = true;
+        for (nanairo::uint e = 0; e < nanairo::HardwareCounts::numOfEvents(); ++e) {
+          const auto event = zisc::cast<nanairo::HardwareEvent>(e);
+          if (!counts.isValid(event))
+            continue;
+          std::cout << (is_first ? "" : ", ")
+                    << "\"" << nanairo::HardwareCounts::eventName(event) << "\": "
+                    << counts.count(event);
+          is_first = false;
+        }
+        std::cout << "}";
+      }
+      std::cout << "}";
+    }
+    std::cout << "]}";
+  }
+  std::cout << "\n  ]\n}" << std::endl;
+}
+
+/*!
+  \details
+  The scene is rendered for the same times as the reference is compared,
+  so the variance reduction of the methods is measured as the time to
+  the quality. The errors are printed as a JSON of the curve.
+  */
+void runConvergenceBenchmark(const NanairoParameters& parameters,
+                             const nanairo::LoadingPhase& parse_phase,
+                             const nanairo::SceneSettingNode& settings)
+{
+  using Clock = nanairo::SimpleRenderer::Clock;
+  using Second = std::chrono::duration<double>;
+  auto data_resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::SimpleRenderer renderer;
+  renderer.addLoadingPhase(parse_phase);
+  std::string error_message;
+  if (!renderer.loadScene(settings, &error_message)) {
+    std::cerr << "Scene loading error: " << error_message;
+    exit(EXIT_FAILURE);
+  }
+
+  if (parameters.error_time_list_.empty()) {
+    std::cerr << "Error: No error time is specified." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  auto time_list_s = parameters.error_time_list_;
+  std::sort(time_list_s.begin(), time_list_s.end());
+  if (parameters.is_making_reference_)
+    time_list_s.erase(time_list_s.begin(), time_list_s.end() - 1);
+  std::vector<Clock::duration> time_list;
+  for (const auto time : time_list_s) {
+    const std::chrono::seconds t{time};
+    time_list.emplace_back(std::chrono::duration_cast<Clock::duration>(t));
+  }
+
+  zisc::pmr::vector<std::array<float, 3>> reference{data_resource};
+  if (!parameters.is_making_reference_) {
+    nanairo::Index2d resolution{0, 0};
+    const bool result = nanairo::HdrImage::readPfm(parameters.reference_path_,
+                                                   &reference,
+                                                   &resolution);
+    const auto& image_resolution = renderer.ldrImage().resolution();
+    if (!result || (resolution[0] != image_resolution[0]) ||
+                   (resolution[1] != image_resolution[1])) {
+      std::cerr << "Error: The reference \"" << parameters.reference_path_
+                << "\" isn't found or its resolution is different." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  zisc::pmr::vector<std::array<float, 3>> rgb_image{data_resource};
+  const auto point_list = renderer.measureConvergence(time_list,
+                                                      reference,
+                                                      &rgb_image);
+  if (parameters.is_making_reference_) {
+    if (!nanairo::HdrImage::writePfm(rgb_image,
+                                     renderer.ldrImage().resolution(),
+                                     parameters.reference_path_)) {
+      std::cerr << "Error: Writing the reference \"" << parameters.reference_path_
+                << "\" failed." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    return;
+  }
+
+  std::cout << "{\n"
+            << "  \"reference\": \"" << parameters.reference_path_ << "\",\n"
+            << "  \"points\": [";
+  for (std::size_t i = 0; i < point_list.size(); ++i) {
+    const auto& point = point_list[i];
+    const double time = std::chrono::duration_cast<Second>(point.time_).count();
+    std::cout << ((i == 0) ? "\n" : ",\n")
+              << "    {\"time_s\": " << time << ", "
+              << "\"cycles\": " << point.cycle_ << ", "
+              << "\"rmse\": " << point.rmse_ << ", "
+              << "\"rel_mse\": " << point.rel_mse_ << "}";
+  }
+  std::cout << "\n  ]\n}" << std::endl;
+}
+
+/*!
+  \details
+  The tokens after the output path are the key-value pairs.
+  The camera matrix is the 16 values in the row major order, which is applied
+  after the transformations of the scene camera.
+  */
+bool parseRenderJob(const std::string& line,
+                    nanairo::SimpleRenderer::RenderJob* job)
+{
+  std::istringstream tokens{line};
+  if (!(tokens >> job->output_path_))
+    return false;
+  std::string token;
+  while (tokens >> token) {
+    const auto separator = token.find('=');
+    if (separator == std::string::npos)
+      return false;
+    const auto key = token.substr(0, separator);
+    const auto value = token.substr(separator + 1);
+    if (key == "cycle") {
+      job->cycle_ = zisc::cast<nanairo::uint32>(std::stoul(value));
+    }
+    else if (key == "time") {
+      const std::chrono::milliseconds time{std::stoull(value)};
+      job->time_ =
+          std::chrono::duration_cast<nanairo::SimpleRenderer::Clock::duration>(time);
+    }
+    else if (key == "camera") {
+      std::array<double, 16> m;
+      const int n = std::sscanf(value.c_str(),
+          "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf",
+          &m[0], &m[1], &m[2], &m[3], &m[4], &m[5], &m[6], &m[7],
+          &m[8], &m[9], &m[10], &m[11], &m[12], &m[13], &m[14], &m[15]);
+      if (n != 16)
+        return false;
+      for (std::size_t i = 0; i < m.size(); ++i)
+        job->camera_matrix_(i / 4, i % 4) = zisc::cast<nanairo::Float>(m[i]);
+    }
+    else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+  \details
+  The jobs are rendered in order until the end of the stream.
+  The empty lines and the lines which begin with '#' are ignored.
+  The result of each job is printed as a line of the standard output,
+  so a client can submit the next job after the line.
+  The output directory of a job has to exist.
+  */
+void runService(const nanairo::SceneSettingNode& settings,
+                std::istream& job_stream,
+                nanairo::SimpleRenderer* renderer)
+{
+  std::string line;
+  while (std::getline(job_stream, line)) {
+    if (line.empty() || (line[0] == '#'))
+      continue;
+    nanairo::SimpleRenderer::RenderJob job;
+    bool is_valid = false;
+    try {
+      is_valid = ::parseRenderJob(line, &job);
+    }
+    catch (const std::exception&) {
+      is_valid = false;
+    }
+    if (!is_valid) {
+      std::cout << "error: invalid job \"" << line << "\"" << std::endl;
+      continue;
+    }
+    using Second = std::chrono::duration<double>;
+    const auto start_time = nanairo::SimpleRenderer::Clock::now();
+    renderer->renderJob(settings, job);
+    const double time = std::chrono::duration_cast<Second>(
+        nanairo::SimpleRenderer::Clock::now() - start_time).count();
+    std::cout << "done: " << job.output_path_ << " " << time << " s" << std::endl;
+  }
+}
+
+/*!
+  */
+nanairo::SimpleRenderer* signal_renderer = nullptr;
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/*!
+  \details
+  The renderer only stores the requested number,
+  so the handler doesn't block the rendering threads.
+  */
+void changeNumOfActiveThreads(int signal_number)
+{
+  if (signal_renderer == nullptr)
+    return;
+  const unsigned int n = signal_renderer->requestedNumOfActiveThreads();
+  const unsigned int num_of_threads = (signal_number == SIGUSR1) ? n + 1 : n - 1;
+  signal_renderer->requestNumOfActiveThreads(num_of_threads);
+}
+
+#endif
+
+/*!
+  \details
+  The number is applied at the next cycle without restarting the rendering.
+  The signals aren't supported on Windows.
+  */
+void installThreadSignalHandlers(nanairo::SimpleRenderer* renderer)
+{
+  signal_renderer = renderer;
+#if defined(__unix__) || defined(__APPLE__)
+  std::signal(SIGUSR1, changeNumOfActiveThreads);
+  std::signal(SIGUSR2, changeNumOfActiveThreads);
+#endif
 }
 
 }
@@ -0,0 +1,182 @@
+/*!
+  \file benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#include "benchmark.hpp"
+// Standard C++ library
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string_view>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/TextureModel/texture_model.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+#include "NanairoCore/Setting/texture_setting_node.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+
+namespace {
+
+bool hardware_counter_enabled = false;
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  // The argument of the counters is removed before the benchmark parses them
+  {
+    int n = 1;
+    for (int i = 1; i < argc; ++i) {
+      if (std::string_view{argv[i]} == "--hardware_counters")
+        hardware_counter_enabled = true;
+      else
+        argv[n++] = argv[i];
+    }
+    argc = n;
+  }
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  ::benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
+
+/*!
+  */
+BenchmarkCounterScope::BenchmarkCounterScope(benchmark::State& state,
+                                             nanairo::System* system) noexcept :
+    state_{state},
+    system_{system}
+{
+  if (isHardwareCounterEnabled()) {
+    if (system_ != nullptr)
+      system_->enableHardwareCounters();
+    else
+      counter_.open();
+    start_counts_ = readCounts();
+  }
+}
+
+/*!
+  */
+BenchmarkCounterScope::~BenchmarkCounterScope() noexcept
+{
+  using nanairo::HardwareCounts;
+  using nanairo::HardwareEvent;
+  if (!isHardwareCounterEnabled())
+    return;
+  const auto counts = readCounts().since(start_counts_);
+  for (nanairo::uint i = 0; i < HardwareCounts::numOfEvents(); ++i) {
+    const auto event = zisc::cast<HardwareEvent>(i);
+    if (counts.isValid(event)) {
+      state_.counters[HardwareCounts::eventName(event)] = benchmark::Counter{
+          zisc::cast<double>(counts.count(event)),
+          benchmark::Counter::kAvgIterations};
+    }
+  }
+  if (counts.isValid(HardwareEvent::kCycles) &&
+      counts.isValid(HardwareEvent::kInstructions))
+    state_.counters["ipc"] = counts.instructionsPerCycle();
+}
+
+/*!
+  */
+nanairo::HardwareCounts BenchmarkCounterScope::readCounts() const noexcept
+{
+  return (system_ != nullptr) ? system_->readHardwareCounters() : counter_.read();
+}
+
+/*!
+  */
+bool isHardwareCounterEnabled() noexcept
+{
+  return hardware_counter_enabled;
+}
+
+/*!
+  */
+std::unique_ptr<nanairo::SceneSettingNode> makeBenchmarkSettings(
+    const nanairo::uint32 image_width,
+    const nanairo::uint32 image_height,
+    const nanairo::uint32 num_of_threads)
+{
+  auto settings = std::make_unique<nanairo::SceneSettingNode>();
+  settings->initialize();
+  auto system_settings = nanairo::castNode<nanairo::SystemSettingNode>(
+      settings->systemSettingNode());
+  system_settings->setImageResolution(image_width, image_height);
+  system_settings->setNumOfThreads(num_of_threads);
+  return settings;
+}
+
+/*!
+  */
+std::unique_ptr<nanairo::System> makeBenchmarkSystem(
+    const nanairo::SceneSettingNode& settings)
+{
+  return std::make_unique<nanairo::System>(settings.systemSettingNode());
+}
+
+/*!
+  */
+zisc::pmr::vector<zisc::UniqueMemoryPointer<nanairo::TextureModel>>
+makeBenchmarkTextures(nanairo::System& system,
+                      nanairo::SceneSettingNode& settings)
+{
+  using nanairo::TextureModel;
+  constexpr std::array<double, 4> value_list{{0.5, 1.0, 1.5, 3.0}};
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<TextureModel>> texture_list{
+      &system.dataMemoryManager()};
+  texture_list.reserve(value_list.size());
+  for (const double value : value_list) {
+    nanairo::TextureSettingNode texture_settings{&settings};
+    texture_settings.initialize();
+    texture_settings.setTextureType(nanairo::TextureType::kValue);
+    texture_settings.valueTextureParameters().value_ = value;
+    texture_list.emplace_back(TextureModel::makeTexture(system, &texture_settings));
+  }
+  return texture_list;
+}
+
+/*!
+  */
+nanairo::Point3 samplePointInCube(BenchmarkEngine& engine)
+{
+  std::uniform_real_distribution<nanairo::Float> distribution{-1.0, 1.0};
+  const nanairo::Float x = distribution(engine);
+  const nanairo::Float y = distribution(engine);
+  const nanairo::Float z = distribution(engine);
+  return nanairo::Point3{x, y, z};
+}
+
+/*!
+  */
+nanairo::Vector3 sampleDirection(BenchmarkEngine& engine)
+{
+  using nanairo::Float;
+  std::uniform_real_distribution<Float> distribution{0.0, 1.0};
+  const Float cos_theta = 1.0 - 2.0 * distribution(engine);
+  const Float sin_theta = zisc::sqrt(1.0 - cos_theta * cos_theta);
+  const Float phi = 2.0 * zisc::kPi<Float> * distribution(engine);
+  return nanairo::Vector3{sin_theta * std::cos(phi),
+                          sin_theta * std::sin(phi),
+                          cos_theta};
+}
@@ -0,0 +1,96 @@
+/*!
+  \file benchmark.hpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+#ifndef NANAIRO_BENCHMARK_HPP
+#define NANAIRO_BENCHMARK_HPP
+
+// Standard C++ library
+#include <memory>
+#include <random>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/TextureModel/texture_model.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Utility/hardware_counter.hpp"
+
+//! The random engine of the benchmark inputs
+using BenchmarkEngine = std::mt19937_64;
+
+//! Return the seed of the benchmark inputs
+constexpr BenchmarkEngine::result_type benchmarkSeed() noexcept
+{
+  return 123456789;
+}
+
+/*!
+  \details
+  The hardware counts of the benchmark loop are reported as the counters
+  per iteration if '--hardware_counters' is given. The threads of the system
+  are counted if the system is given, otherwise the calling thread is counted.
+  The paused parts of the loop are also counted.
+  */
+class BenchmarkCounterScope
+{
+ public:
+  //! Start counting the hardware events of the loop of the state
+  BenchmarkCounterScope(benchmark::State& state,
+                        nanairo::System* system = nullptr) noexcept;
+
+  //! Report the counts as the counters of the state
+  ~BenchmarkCounterScope() noexcept;
+
+ private:
+  //! Read the counts of the counter or the system
+  nanairo::HardwareCounts readCounts() const noexcept;
+
+
+  benchmark::State& state_;
+  nanairo::System* system_;
+  nanairo::HardwareCounter counter_;
+  nanairo::HardwareCounts start_counts_;
+};
+
+//! Check if the hardware counts of the benchmarks are reported
+bool isHardwareCounterEnabled() noexcept;
+
+//! Make scene settings which the benchmark systems are made from
+std::unique_ptr<nanairo::SceneSettingNode> makeBenchmarkSettings(
+    const nanairo::uint32 image_width,
+    const nanairo::uint32 image_height,
+    const nanairo::uint32 num_of_threads);
+
+//! Make a system from the scene settings
+std::unique_ptr<nanairo::System> makeBenchmarkSystem(
+    const nanairo::SceneSettingNode& settings);
+
+/*!
+  \details
+  The values are 0.5, 1.0, 1.5 and 3.0, which the surfaces of the benchmarks
+  use as the reflectance or the roughness, the outer and the inner refractive
+  indices and the extinction coefficient.
+  */
+zisc::pmr::vector<zisc::UniqueMemoryPointer<nanairo::TextureModel>>
+makeBenchmarkTextures(nanairo::System& system,
+                      nanairo::SceneSettingNode& settings);
+
+//! Sample a point in the cube [-1, 1]^3 uniformly
+nanairo::Point3 samplePointInCube(BenchmarkEngine& engine);
+
+//! Sample a direction on the unit sphere uniformly
+nanairo::Vector3 sampleDirection(BenchmarkEngine& engine);
+
+#endif // NANAIRO_BENCHMARK_HPP
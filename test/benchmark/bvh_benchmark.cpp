@@ -0,0 +1,212 @@
+/*!
+  \file bvh_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/object.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/DataStructure/bvh.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/material.hpp"
+#include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
+#include "NanairoCore/Material/TextureModel/texture_model.hpp"
+#include "NanairoCore/Setting/bvh_setting_node.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/setting_node_base.hpp"
+#include "NanairoCore/Setting/surface_setting_node.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+//! The layouts which are benchmarked, the index is the argument of a benchmark
+constexpr std::array<nanairo::BvhLayoutType, 5> kLayoutList{{
+    nanairo::BvhLayoutType::kBinary,
+    nanairo::BvhLayoutType::kOrderedBinary,
+    nanairo::BvhLayoutType::kWide4,
+    nanairo::BvhLayoutType::kWide8,
+    nanairo::BvhLayoutType::kQuantized4}};
+
+constexpr std::array<const char*, 5> kLayoutNameList{{
+    "Binary", "OrderedBinary", "Wide4", "Wide8", "Quantized4"}};
+
+/*!
+  \details
+  The scene is a soup of the small triangles in the cube [-1, 1]^3.
+  The rays are made once and replayed in every iteration,
+  so all layouts are measured on the same ray set.
+  */
+class BvhBenchmarkScene
+{
+ public:
+  //! Build the BVH of the triangles with the layout
+  BvhBenchmarkScene(const nanairo::BvhLayoutType layout_type,
+                    const std::size_t num_of_triangles) noexcept;
+
+
+  //! Return the BVH
+  const nanairo::Bvh& bvh() const noexcept
+  {
+    return *bvh_;
+  }
+
+  //! Make the rays which start on a plane and go into the cube in parallel
+  static std::vector<nanairo::Ray> makeCoherentRays(const std::size_t num_of_rays);
+
+  //! Make the rays which start in the cube and go in random directions
+  static std::vector<nanairo::Ray> makeIncoherentRays(const std::size_t num_of_rays);
+
+ private:
+  std::unique_ptr<nanairo::SceneSettingNode> settings_;
+  std::unique_ptr<nanairo::System> system_;
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<nanairo::TextureModel>> texture_list_;
+  zisc::UniqueMemoryPointer<nanairo::SurfaceModel> surface_;
+  std::unique_ptr<nanairo::Material> material_;
+  zisc::UniqueMemoryPointer<nanairo::Bvh> bvh_;
+};
+
+/*!
+  */
+BvhBenchmarkScene::BvhBenchmarkScene(const nanairo::BvhLayoutType layout_type,
+                                     const std::size_t num_of_triangles) noexcept :
+    settings_{makeBenchmarkSettings(256, 256, 1)},
+    system_{makeBenchmarkSystem(*settings_)},
+    texture_list_{makeBenchmarkTextures(*system_, *settings_)}
+{
+  using nanairo::Point3;
+  auto& system = *system_;
+  auto data_resource = &system.dataMemoryManager();
+  // Material
+  {
+    nanairo::SurfaceSettingNode surface_settings{settings_.get()};
+    surface_settings.initialize();
+    zisc::pmr::vector<const nanairo::TextureModel*> texture_list{data_resource};
+    for (const auto& texture : texture_list_)
+      texture_list.emplace_back(texture.get());
+    surface_ = nanairo::SurfaceModel::makeSurface(system,
+                                                  &surface_settings,
+                                                  texture_list);
+    material_ = std::make_unique<nanairo::Material>(surface_.get(), nullptr);
+  }
+  // Objects
+  zisc::pmr::vector<nanairo::Object> object_list{data_resource};
+  object_list.reserve(num_of_triangles);
+  BenchmarkEngine engine{benchmarkSeed()};
+  for (std::size_t i = 0; i < num_of_triangles; ++i) {
+    const auto center = samplePointInCube(engine);
+    constexpr nanairo::Float size = 0.05;
+    const Point3 v1 = center + size * sampleDirection(engine);
+    const Point3 v2 = center + size * sampleDirection(engine);
+    const Point3 v3 = center + size * sampleDirection(engine);
+    auto shape = zisc::UniqueMemoryPointer<nanairo::FlatTriangle>::make(
+        data_resource, v1, v2, v3);
+    object_list.emplace_back(std::move(shape), material_.get());
+  }
+  // BVH
+  {
+    auto bvh_settings = nanairo::castNode<nanairo::BvhSettingNode>(
+        settings_->bvhSettingNode());
+    bvh_settings->setBvhLayoutType(layout_type);
+    bvh_ = nanairo::Bvh::makeBvh(system, bvh_settings);
+    bvh_->construct(system, bvh_settings, std::move(object_list));
+  }
+}
+
+/*!
+  */
+std::vector<nanairo::Ray> BvhBenchmarkScene::makeCoherentRays(
+    const std::size_t num_of_rays)
+{
+  using nanairo::Point3;
+  BenchmarkEngine engine{benchmarkSeed()};
+  std::vector<nanairo::Ray> ray_list;
+  ray_list.reserve(num_of_rays);
+  const nanairo::Vector3 direction{0.0, 0.0, -1.0};
+  for (std::size_t i = 0; i < num_of_rays; ++i) {
+    const auto p = samplePointInCube(engine);
+    const Point3 origin{p[0], p[1], 2.0};
+    ray_list.emplace_back(nanairo::Ray::makeRay(origin, direction));
+  }
+  return ray_list;
+}
+
+/*!
+  */
+std::vector<nanairo::Ray> BvhBenchmarkScene::makeIncoherentRays(
+    const std::size_t num_of_rays)
+{
+  BenchmarkEngine engine{benchmarkSeed()};
+  std::vector<nanairo::Ray> ray_list;
+  ray_list.reserve(num_of_rays);
+  for (std::size_t i = 0; i < num_of_rays; ++i) {
+    const auto origin = samplePointInCube(engine);
+    ray_list.emplace_back(nanairo::Ray::makeRay(origin, sampleDirection(engine)));
+  }
+  return ray_list;
+}
+
+//! Cast the rays of the set repeatedly
+void castRays(benchmark::State& state, const std::vector<nanairo::Ray>& ray_list)
+{
+  const auto layout_index = zisc::cast<std::size_t>(state.range(0));
+  const auto num_of_triangles = zisc::cast<std::size_t>(state.range(1));
+  const BvhBenchmarkScene scene{kLayoutList[layout_index], num_of_triangles};
+  const auto& bvh = scene.bvh();
+
+  std::size_t index = 0;
+  BenchmarkCounterScope counter_scope{state};
+  for (auto _ : state) {
+    auto intersection = bvh.castRay(ray_list[index], 100.0);
+    benchmark::DoNotOptimize(intersection);
+    index = (index + 1) % ray_list.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(kLayoutNameList[layout_index]);
+}
+
+//! Add the arguments of the layouts and the scene sizes
+void setBvhArguments(benchmark::internal::Benchmark* benchmark)
+{
+  for (std::size_t layout = 0; layout < kLayoutList.size(); ++layout) {
+    for (const int num_of_triangles : {1 << 10, 1 << 16})
+      benchmark->Args({zisc::cast<int>(layout), num_of_triangles});
+  }
+}
+
+} // namespace
+
+static void BvhCastCoherentRay(benchmark::State& state)
+{
+  static const auto ray_list = BvhBenchmarkScene::makeCoherentRays(1 << 16);
+  ::castRays(state, ray_list);
+}
+BENCHMARK(BvhCastCoherentRay)->Apply(::setBvhArguments);
+
+static void BvhCastIncoherentRay(benchmark::State& state)
+{
+  static const auto ray_list = BvhBenchmarkScene::makeIncoherentRays(1 << 16);
+  ::castRays(state, ray_list);
+}
+BENCHMARK(BvhCastIncoherentRay)->Apply(::setBvhArguments);
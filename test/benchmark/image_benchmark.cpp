@@ -0,0 +1,164 @@
+/*!
+  \file image_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <memory>
+#include <random>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Color/hdr_image.hpp"
+#include "NanairoCore/Color/ldr_image.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/ToneMappingOperator/tone_mapping_operator.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+constexpr nanairo::uint kWidth = 1280;
+constexpr nanairo::uint kHeight = 720;
+constexpr nanairo::uint32 kNumOfCycles = 4;
+
+/*!
+  \details
+  The film is filled with the random samples of some cycles,
+  so the images are converted from the accumulated statistics.
+  */
+class ImageBenchmarkScene
+{
+ public:
+  //! Make the statistics and the images
+  ImageBenchmarkScene(const nanairo::uint num_of_threads) noexcept;
+
+
+  //! Return the HDR image
+  nanairo::HdrImage& hdrImage() noexcept
+  {
+    return *hdr_image_;
+  }
+
+  //! Return the LDR image
+  nanairo::LdrImage& ldrImage() noexcept
+  {
+    return *ldr_image_;
+  }
+
+  //! Return the statistics
+  const nanairo::SampleStatistics& statistics() const noexcept
+  {
+    return *statistics_;
+  }
+
+  //! Return the system
+  nanairo::System& system() noexcept
+  {
+    return *system_;
+  }
+
+ private:
+  std::unique_ptr<nanairo::SceneSettingNode> settings_;
+  std::unique_ptr<nanairo::System> system_;
+  zisc::UniqueMemoryPointer<nanairo::SampleStatistics> statistics_;
+  zisc::UniqueMemoryPointer<nanairo::HdrImage> hdr_image_;
+  zisc::UniqueMemoryPointer<nanairo::LdrImage> ldr_image_;
+};
+
+/*!
+  */
+ImageBenchmarkScene::ImageBenchmarkScene(const nanairo::uint num_of_threads)
+    noexcept :
+        settings_{makeBenchmarkSettings(kWidth, kHeight, num_of_threads)},
+        system_{makeBenchmarkSystem(*settings_)}
+{
+  auto& data_resource = system_->dataMemoryManager();
+  statistics_ = zisc::UniqueMemoryPointer<nanairo::SampleStatistics>::make(
+      &data_resource,
+      *system_);
+  hdr_image_ = zisc::UniqueMemoryPointer<nanairo::HdrImage>::make(
+      &data_resource,
+      kWidth,
+      kHeight,
+      &data_resource);
+  ldr_image_ = zisc::UniqueMemoryPointer<nanairo::LdrImage>::make(
+      &data_resource,
+      kWidth,
+      kHeight,
+      &data_resource);
+
+  BenchmarkEngine engine{benchmarkSeed()};
+  std::exponential_distribution<nanairo::Float> noise{1.0};
+  auto& sampler = system_->globalSampler();
+  for (nanairo::uint32 cycle = 1; cycle <= kNumOfCycles; ++cycle) {
+    nanairo::PathState path_state{cycle};
+    path_state.setDimension(nanairo::SampleDimension::kWavelengthSample1);
+    const auto sampled_wavelengths =
+        nanairo::WavelengthSampler::sampleRgb(sampler, path_state);
+    const auto& wavelengths = sampled_wavelengths.wavelengths();
+    statistics_->setWavelengths(*system_, wavelengths);
+    nanairo::SampledSpectra sample{wavelengths};
+    for (nanairo::uint y = 0; y < kHeight; ++y) {
+      for (nanairo::uint x = 0; x < kWidth; ++x) {
+        for (nanairo::uint i = 0; i < sample.size(); ++i)
+          sample.setIntensity(i, noise(engine));
+        statistics_->addSample(nanairo::Index2d{x, y}, sample);
+      }
+    }
+    statistics_->update(*system_, wavelengths, cycle);
+  }
+}
+
+} // namespace
+
+static void HdrImageConversion(benchmark::State& state)
+{
+  ::ImageBenchmarkScene scene{zisc::cast<nanairo::uint>(state.range(0))};
+  auto& hdr_image = scene.hdrImage();
+  BenchmarkCounterScope counter_scope{state, &scene.system()};
+  for (auto _ : state) {
+    hdr_image.toHdr(scene.system(),
+                    ::kNumOfCycles,
+                    scene.statistics().sampleTable());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * ::kWidth * ::kHeight);
+}
+BENCHMARK(HdrImageConversion)->RangeMultiplier(2)->Range(1, 8)->
+    Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void ToneMapping(benchmark::State& state)
+{
+  ::ImageBenchmarkScene scene{zisc::cast<nanairo::uint>(state.range(0))};
+  auto& system = scene.system();
+  auto& hdr_image = scene.hdrImage();
+  const auto& tone_map = system.toneMappingOperator();
+  for (auto _ : state) {
+    // The tone mapping updates only the dirty tiles of the HDR image
+    state.PauseTiming();
+    hdr_image.toHdr(system, ::kNumOfCycles, scene.statistics().sampleTable());
+    state.ResumeTiming();
+    tone_map.map(system, hdr_image, &scene.ldrImage(),
+                 &system.dataMemoryManager());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * ::kWidth * ::kHeight);
+}
+BENCHMARK(ToneMapping)->RangeMultiplier(2)->Range(1, 8)->
+    Unit(benchmark::kMillisecond)->UseRealTime();
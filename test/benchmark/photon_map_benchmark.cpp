@@ -0,0 +1,151 @@
+/*!
+  \file photon_map_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <cstddef>
+#include <memory>
+#include <vector>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
+#include "NanairoCore/DataStructure/knn_photon_list.hpp"
+#include "NanairoCore/DataStructure/photon_map.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+constexpr nanairo::Float kSearchRadius = 0.05;
+
+//! The photon map types, the index is the argument of a benchmark
+constexpr nanairo::PhotonMapType kMapList[] = {nanairo::PhotonMapType::kKdTree,
+                                               nanairo::PhotonMapType::kHashGrid};
+
+/*!
+  \details
+  The photons are stored in the square [-1, 1]^2 on the plane z = 0,
+  because the photons of a path tracer lie on the surfaces.
+  */
+class PhotonMapBenchmarkScene
+{
+ public:
+  //! Make the photons
+  PhotonMapBenchmarkScene(const std::size_t num_of_photons) noexcept;
+
+
+  //! Store the photons into the map
+  void storePhotons(nanairo::PhotonMap* photon_map) const noexcept;
+
+  //! Return the system
+  nanairo::System& system() noexcept
+  {
+    return *system_;
+  }
+
+ private:
+  std::unique_ptr<nanairo::SceneSettingNode> settings_;
+  std::unique_ptr<nanairo::System> system_;
+  std::vector<nanairo::Point3> point_list_;
+  nanairo::SampledSpectra energy_;
+};
+
+/*!
+  */
+PhotonMapBenchmarkScene::PhotonMapBenchmarkScene(
+    const std::size_t num_of_photons) noexcept :
+        settings_{makeBenchmarkSettings(256, 256, 1)},
+        system_{makeBenchmarkSystem(*settings_)}
+{
+  BenchmarkEngine engine{benchmarkSeed()};
+  point_list_.reserve(num_of_photons);
+  for (std::size_t i = 0; i < num_of_photons; ++i) {
+    const auto p = samplePointInCube(engine);
+    point_list_.emplace_back(nanairo::Point3{p[0], p[1], 0.0});
+  }
+  energy_ = nanairo::SampledSpectra{nanairo::WavelengthSamples{}, 1.0};
+}
+
+/*!
+  */
+void PhotonMapBenchmarkScene::storePhotons(nanairo::PhotonMap* photon_map)
+    const noexcept
+{
+  const nanairo::Vector3 vin{0.0, 0.0, -1.0};
+  for (const auto& point : point_list_)
+    photon_map->store(0, point, vin, energy_, 1.0, false);
+}
+
+} // namespace
+
+static void PhotonMapConstruction(benchmark::State& state)
+{
+  const auto map_type = ::kMapList[state.range(0)];
+  const auto num_of_photons = zisc::cast<std::size_t>(state.range(1));
+  ::PhotonMapBenchmarkScene scene{num_of_photons};
+  nanairo::PhotonMap photon_map;
+  photon_map.setMapType(map_type);
+  photon_map.initialize(scene.system(), num_of_photons);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    photon_map.reset();
+    scene.storePhotons(&photon_map);
+    state.ResumeTiming();
+    photon_map.construct(scene.system(), ::kSearchRadius);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(PhotonMapConstruction)->ArgsProduct({{0, 1}, {1 << 14, 1 << 18}})->
+    Unit(benchmark::kMillisecond);
+
+static void PhotonMapSearch(benchmark::State& state)
+{
+  const auto map_type = ::kMapList[state.range(0)];
+  constexpr std::size_t num_of_photons = 1 << 18;
+  ::PhotonMapBenchmarkScene scene{num_of_photons};
+  nanairo::PhotonMap photon_map;
+  photon_map.setMapType(map_type);
+  photon_map.initialize(scene.system(), num_of_photons);
+  scene.storePhotons(&photon_map);
+  photon_map.construct(scene.system(), ::kSearchRadius);
+
+  BenchmarkEngine engine{benchmarkSeed() + 1};
+  std::vector<nanairo::Point3> query_list;
+  constexpr std::size_t num_of_queries = 4096;
+  query_list.reserve(num_of_queries);
+  for (std::size_t i = 0; i < num_of_queries; ++i) {
+    const auto p = samplePointInCube(engine);
+    query_list.emplace_back(nanairo::Point3{p[0], p[1], 0.0});
+  }
+
+  const nanairo::Vector3 normal{0.0, 0.0, 1.0};
+  constexpr nanairo::Float radius2 = ::kSearchRadius * ::kSearchRadius;
+  nanairo::KnnPhotonList photon_list;
+  photon_list.setK(zisc::cast<nanairo::uint>(state.range(1)));
+  std::size_t index = 0;
+  BenchmarkCounterScope counter_scope{state};
+  for (auto _ : state) {
+    photon_list.clear();
+    photon_map.search(query_list[index], normal, radius2, false, true,
+                      &photon_list);
+    benchmark::DoNotOptimize(photon_list);
+    index = (index + 1) % num_of_queries;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(PhotonMapSearch)->ArgsProduct({{0, 1}, {16, 64}});
@@ -0,0 +1,105 @@
+/*!
+  \file sampled_spectra_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <random>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+//! Make a pair of spectra which have positive random intensities
+void makeSpectraPair(nanairo::SampledSpectra* lhs, nanairo::SampledSpectra* rhs)
+{
+  BenchmarkEngine engine{benchmarkSeed()};
+  std::uniform_real_distribution<nanairo::Float> distribution{0.5, 1.5};
+  for (nanairo::uint i = 0; i < lhs->size(); ++i) {
+    lhs->setIntensity(i, distribution(engine));
+    rhs->setIntensity(i, distribution(engine));
+  }
+}
+
+//! Return the wavelengths which are used in the benchmarks
+nanairo::WavelengthSamples makeWavelengths() noexcept
+{
+  nanairo::WavelengthSamples wavelengths;
+  constexpr auto n = nanairo::CoreConfig::wavelengthSampleSize();
+  constexpr auto range = nanairo::CoreConfig::wavelengthRange();
+  for (nanairo::uint i = 0; i < n; ++i) {
+    const auto w = nanairo::CoreConfig::shortestWavelength() + (i * range) / n;
+    wavelengths[i] = zisc::cast<nanairo::uint16>(w);
+  }
+  return wavelengths;
+}
+
+} // namespace
+
+static void SampledSpectraAddition(benchmark::State& state)
+{
+  const auto wavelengths = ::makeWavelengths();
+  nanairo::SampledSpectra lhs{wavelengths},
+                          rhs{wavelengths};
+  ::makeSpectraPair(&lhs, &rhs);
+  for (auto _ : state) {
+    auto result = lhs + rhs;
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(SampledSpectraAddition);
+
+static void SampledSpectraMultiplication(benchmark::State& state)
+{
+  const auto wavelengths = ::makeWavelengths();
+  nanairo::SampledSpectra lhs{wavelengths},
+                          rhs{wavelengths};
+  ::makeSpectraPair(&lhs, &rhs);
+  for (auto _ : state) {
+    auto result = lhs * rhs;
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(SampledSpectraMultiplication);
+
+static void SampledSpectraDivision(benchmark::State& state)
+{
+  const auto wavelengths = ::makeWavelengths();
+  nanairo::SampledSpectra lhs{wavelengths},
+                          rhs{wavelengths};
+  ::makeSpectraPair(&lhs, &rhs);
+  for (auto _ : state) {
+    auto result = lhs / rhs;
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(SampledSpectraDivision);
+
+static void SampledSpectraAccumulation(benchmark::State& state)
+{
+  const auto wavelengths = ::makeWavelengths();
+  nanairo::SampledSpectra lhs{wavelengths},
+                          rhs{wavelengths};
+  ::makeSpectraPair(&lhs, &rhs);
+  for (auto _ : state) {
+    lhs += rhs;
+    benchmark::DoNotOptimize(lhs);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(SampledSpectraAccumulation);
@@ -0,0 +1,94 @@
+/*!
+  \file sampler_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Sampling/Sampler/cmj_table.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+//! The sampler types, the index is the argument of a benchmark
+constexpr std::array<nanairo::SamplerType, 5> kSamplerList{{
+    nanairo::SamplerType::kPcg,
+    nanairo::SamplerType::kXoshiro,
+    nanairo::SamplerType::kCmj,
+    nanairo::SamplerType::kTableCmj,
+    nanairo::SamplerType::kOwenSobol}};
+
+constexpr std::array<const char*, 5> kSamplerNameList{{
+    "PCG", "Xoshiro", "CMJ", "TableCMJ", "OwenSobol"}};
+
+/*!
+  \details
+  A path draws the samples of the successive dimensions,
+  and the next path moves to the next pixel stream.
+  */
+template <bool k2d>
+void drawSamples(benchmark::State& state)
+{
+  using nanairo::PathState;
+  using nanairo::SampleDimension;
+  using nanairo::uint32;
+
+  const auto sampler_index = zisc::cast<std::size_t>(state.range(0));
+  const auto seed = zisc::cast<uint32>(benchmarkSeed());
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  const nanairo::CmjTable table{seed, work_resource};
+  auto sampler = nanairo::Sampler::make(kSamplerList[sampler_index],
+                                        seed,
+                                        work_resource,
+                                        &table);
+
+  constexpr uint32 path_length = 16;
+  uint32 stream = 0;
+  PathState path_state{1};
+  for (auto _ : state) {
+    sampler->setStream(stream++);
+    for (uint32 length = 1; length <= path_length; ++length) {
+      path_state.setLength(length);
+      path_state.setDimension(SampleDimension::kBxdfSample1);
+      if constexpr (k2d) {
+        const auto sample = sampler->draw2D(path_state);
+        benchmark::DoNotOptimize(sample);
+      }
+      else {
+        const auto sample = sampler->draw1D(path_state);
+        benchmark::DoNotOptimize(sample);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * path_length);
+  state.SetLabel(kSamplerNameList[sampler_index]);
+}
+
+} // namespace
+
+static void SamplerDraw1D(benchmark::State& state)
+{
+  ::drawSamples<false>(state);
+}
+BENCHMARK(SamplerDraw1D)->DenseRange(0, zisc::cast<int>(kSamplerList.size()) - 1);
+
+static void SamplerDraw2D(benchmark::State& state)
+{
+  ::drawSamples<true>(state);
+}
+BENCHMARK(SamplerDraw2D)->DenseRange(0, zisc::cast<int>(kSamplerList.size()) - 1);
@@ -0,0 +1,271 @@
+/*!
+  \file shader_model_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/unique_memory_pointer.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/intersection_info.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Material/shader_model.hpp"
+#include "NanairoCore/Material/SurfaceModel/surface_model.hpp"
+#include "NanairoCore/Material/TextureModel/texture_model.hpp"
+#include "NanairoCore/Sampling/sampled_direction.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Sampling/sampled_wavelengths.hpp"
+#include "NanairoCore/Sampling/wavelength_sampler.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+#include "NanairoCore/Setting/scene_setting_node.hpp"
+#include "NanairoCore/Setting/surface_setting_node.hpp"
+#include "NanairoCore/Utility/work_memory_arena.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+//! The surface types, the index is the argument of a benchmark
+constexpr std::array<nanairo::SurfaceType, 6> kSurfaceList{{
+    nanairo::SurfaceType::kSmoothDiffuse,
+    nanairo::SurfaceType::kSmoothDielectric,
+    nanairo::SurfaceType::kSmoothConductor,
+    nanairo::SurfaceType::kRoughDielectric,
+    nanairo::SurfaceType::kRoughConductor,
+    nanairo::SurfaceType::kLayeredDiffuse}};
+
+constexpr std::array<const char*, 6> kSurfaceNameList{{
+    "SmoothDiffuse", "SmoothDielectric", "SmoothConductor",
+    "RoughDielectric", "RoughConductor", "LayeredDiffuse"}};
+
+/*!
+  \details
+  The textures are indexed as makeBenchmarkTextures() makes them.
+  */
+void setSurfaceParameters(const nanairo::SurfaceType type,
+                          nanairo::SurfaceSettingNode* settings)
+{
+  using nanairo::SurfaceType;
+  constexpr nanairo::uint32 value = 0,
+                            outer_index = 1,
+                            inner_index = 2,
+                            extinction = 3;
+  settings->setSurfaceType(type);
+  switch (type) {
+   case SurfaceType::kSmoothDiffuse: {
+    settings->smoothDiffuseParameters().reflectance_index_ = value;
+    break;
+   }
+   case SurfaceType::kSmoothDielectric: {
+    auto& parameters = settings->smoothDielectricParameters();
+    parameters.outer_refractive_index_ = outer_index;
+    parameters.inner_refractive_index_ = inner_index;
+    break;
+   }
+   case SurfaceType::kSmoothConductor: {
+    auto& parameters = settings->smoothConductorParameters();
+    parameters.outer_refractive_index_ = outer_index;
+    parameters.inner_refractive_index_ = inner_index;
+    parameters.inner_extinction_index_ = extinction;
+    break;
+   }
+   case SurfaceType::kRoughDielectric: {
+    auto& parameters = settings->roughDielectricParameters();
+    parameters.outer_refractive_index_ = outer_index;
+    parameters.inner_refractive_index_ = inner_index;
+    parameters.roughness_x_index_ = value;
+    parameters.roughness_y_index_ = value;
+    break;
+   }
+   case SurfaceType::kRoughConductor: {
+    auto& parameters = settings->roughConductorParameters();
+    parameters.outer_refractive_index_ = outer_index;
+    parameters.inner_refractive_index_ = inner_index;
+    parameters.inner_extinction_index_ = extinction;
+    parameters.roughness_x_index_ = value;
+    parameters.roughness_y_index_ = value;
+    break;
+   }
+   case SurfaceType::kLayeredDiffuse: {
+    auto& parameters = settings->layeredDiffuseParameters();
+    parameters.outer_refractive_index_ = outer_index;
+    parameters.inner_refractive_index_ = inner_index;
+    parameters.reflectance_index_ = value;
+    parameters.roughness_x_index_ = value;
+    parameters.roughness_y_index_ = value;
+    break;
+   }
+   default:
+    break;
+  }
+}
+
+/*!
+  \details
+  The BxDFs are made at a fixed point on the plane z = 0,
+  and the incident directions are sampled on the upper hemisphere.
+  */
+class ShaderBenchmarkScene
+{
+ public:
+  //! Make the surface of the type
+  ShaderBenchmarkScene(const nanairo::SurfaceType type) noexcept;
+
+
+  //! Return the directions which go to the surface
+  const std::vector<nanairo::Vector3>& incidentDirectionList() const noexcept
+  {
+    return vin_list_;
+  }
+
+  //! Return the intersection
+  const nanairo::IntersectionInfo& intersection() const noexcept
+  {
+    return intersection_;
+  }
+
+  //! Return the directions which leave the surface
+  const std::vector<nanairo::Vector3>& outgoingDirectionList() const noexcept
+  {
+    return vout_list_;
+  }
+
+  //! Return the surface
+  const nanairo::SurfaceModel& surface() const noexcept
+  {
+    return *surface_;
+  }
+
+  //! Return the system
+  nanairo::System& system() noexcept
+  {
+    return *system_;
+  }
+
+ private:
+  std::unique_ptr<nanairo::SceneSettingNode> settings_;
+  std::unique_ptr<nanairo::System> system_;
+  zisc::pmr::vector<zisc::UniqueMemoryPointer<nanairo::TextureModel>> texture_list_;
+  zisc::UniqueMemoryPointer<nanairo::SurfaceModel> surface_;
+  nanairo::IntersectionInfo intersection_;
+  std::vector<nanairo::Vector3> vin_list_;
+  std::vector<nanairo::Vector3> vout_list_;
+};
+
+/*!
+  */
+ShaderBenchmarkScene::ShaderBenchmarkScene(const nanairo::SurfaceType type)
+    noexcept :
+        settings_{makeBenchmarkSettings(256, 256, 1)},
+        system_{makeBenchmarkSystem(*settings_)},
+        texture_list_{makeBenchmarkTextures(*system_, *settings_)}
+{
+  using nanairo::Vector3;
+  {
+    nanairo::SurfaceSettingNode surface_settings{settings_.get()};
+    surface_settings.initialize();
+    setSurfaceParameters(type, &surface_settings);
+    zisc::pmr::vector<const nanairo::TextureModel*> texture_list{
+        &system_->dataMemoryManager()};
+    for (const auto& texture : texture_list_)
+      texture_list.emplace_back(texture.get());
+    surface_ = nanairo::SurfaceModel::makeSurface(*system_,
+                                                  &surface_settings,
+                                                  texture_list);
+  }
+  intersection_.setPoint(nanairo::Point3{0.0, 0.0, 0.0});
+  intersection_.setNormal(Vector3{0.0, 0.0, 1.0});
+  intersection_.setTangent(Vector3{1.0, 0.0, 0.0});
+  intersection_.setBitangent(Vector3{0.0, 1.0, 0.0});
+  intersection_.setUv(nanairo::Point2{0.5, 0.5});
+
+  constexpr std::size_t num_of_directions = 1024;
+  BenchmarkEngine engine{benchmarkSeed()};
+  vin_list_.reserve(num_of_directions);
+  vout_list_.reserve(num_of_directions);
+  for (std::size_t i = 0; i < num_of_directions; ++i) {
+    auto vin = sampleDirection(engine);
+    vin[2] = -zisc::abs(vin[2]);
+    vin_list_.emplace_back(vin);
+    auto vout = sampleDirection(engine);
+    vout[2] = zisc::abs(vout[2]);
+    vout_list_.emplace_back(vout);
+  }
+}
+
+//! Make a BxDF and sample or evaluate it in an iteration
+template <bool kSample>
+void runShader(benchmark::State& state)
+{
+  using nanairo::PathState;
+  using nanairo::SampleDimension;
+
+  const auto surface_index = zisc::cast<std::size_t>(state.range(0));
+  ShaderBenchmarkScene scene{kSurfaceList[surface_index]};
+  auto& sampler = scene.system().globalSampler();
+  const auto& intersection = scene.intersection();
+  const auto& vin_list = scene.incidentDirectionList();
+  const auto& vout_list = scene.outgoingDirectionList();
+
+  nanairo::WorkMemoryArena arena;
+  nanairo::uint32 sample_index = 1;
+  std::size_t index = 0;
+  BenchmarkCounterScope counter_scope{state};
+  for (auto _ : state) {
+    nanairo::WorkMemoryArena::Scope scope{&arena};
+    PathState path_state{sample_index++};
+    path_state.setDimension(SampleDimension::kWavelengthSample1);
+    const auto sampled_wavelengths =
+        nanairo::WavelengthSampler::sampleRgb(sampler, path_state);
+    const auto& wavelengths = sampled_wavelengths.wavelengths();
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    auto bxdf = scene.surface().makeBxdf(intersection, wavelengths,
+                                         sampler, path_state, &arena);
+    const auto& vin = vin_list[index];
+    if constexpr (kSample) {
+      auto result = bxdf->sample(&vin, wavelengths, sampler, path_state,
+                                 &intersection);
+      benchmark::DoNotOptimize(result);
+    }
+    else {
+      const auto& vout = vout_list[index];
+      auto result = bxdf->evalRadianceAndPdf(&vin, &vout, wavelengths,
+                                             &intersection);
+      benchmark::DoNotOptimize(result);
+    }
+    index = (index + 1) % vin_list.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(kSurfaceNameList[surface_index]);
+}
+
+} // namespace
+
+static void ShaderModelSample(benchmark::State& state)
+{
+  ::runShader<true>(state);
+}
+BENCHMARK(ShaderModelSample)->DenseRange(0, zisc::cast<int>(kSurfaceList.size()) - 1);
+
+static void ShaderModelEval(benchmark::State& state)
+{
+  ::runShader<false>(state);
+}
+BENCHMARK(ShaderModelEval)->DenseRange(0, zisc::cast<int>(kSurfaceList.size()) - 1);
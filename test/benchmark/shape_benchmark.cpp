@@ -0,0 +1,93 @@
+/*!
+  \file shape_benchmark.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <cstddef>
+#include <limits>
+#include <vector>
+// Google Benchmark
+#include "benchmark/benchmark.h"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+#include "NanairoCore/Shape/flat_triangle.hpp"
+// Benchmark
+#include "benchmark.hpp"
+
+namespace {
+
+/*!
+  \details
+  The rays are shot from above the triangle to the square around it,
+  so about the half of the rays hit the triangle.
+  */
+std::vector<nanairo::Ray> makeTriangleRays(const std::size_t num_of_rays)
+{
+  using nanairo::Point3;
+  BenchmarkEngine engine{benchmarkSeed()};
+  std::vector<nanairo::Ray> ray_list;
+  ray_list.reserve(num_of_rays);
+  for (std::size_t i = 0; i < num_of_rays; ++i) {
+    const auto o = samplePointInCube(engine);
+    const Point3 origin{o[0], o[1], o[2] + 3.0};
+    const auto t = samplePointInCube(engine);
+    const Point3 target{1.5 * t[0], 1.5 * t[1], 0.0};
+    ray_list.emplace_back(nanairo::Ray::makeRay(origin,
+                                                (target - origin).normalized()));
+  }
+  return ray_list;
+}
+
+} // namespace
+
+static void FlatTriangleIntersection(benchmark::State& state)
+{
+  using nanairo::Point3;
+  const nanairo::FlatTriangle triangle{Point3{-1.0, -1.0, 0.0},
+                                       Point3{1.0, -1.0, 0.0},
+                                       Point3{0.0, 1.0, 0.0}};
+  const auto ray_list = ::makeTriangleRays(4096);
+
+  std::size_t index = 0;
+  for (auto _ : state) {
+    const auto& ray = ray_list[index];
+    nanairo::Point2 st;
+    nanairo::uint32 primitive_index;
+    auto result = triangle.testIntersection(ray,
+                                            std::numeric_limits<nanairo::Float>::max(),
+                                            &st,
+                                            &primitive_index);
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(st);
+    index = (index + 1) % ray_list.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(FlatTriangleIntersection);
+
+static void FlatTriangleOcclusion(benchmark::State& state)
+{
+  using nanairo::Point3;
+  const nanairo::FlatTriangle triangle{Point3{-1.0, -1.0, 0.0},
+                                       Point3{1.0, -1.0, 0.0},
+                                       Point3{0.0, 1.0, 0.0}};
+  const auto ray_list = ::makeTriangleRays(4096);
+
+  std::size_t index = 0;
+  for (auto _ : state) {
+    const auto& ray = ray_list[index];
+    const bool result = triangle.testOcclusion(ray, 10.0);
+    benchmark::DoNotOptimize(result);
+    index = (index + 1) % ray_list.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(FlatTriangleOcclusion);
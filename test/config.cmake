@@ -80,3 +80,56 @@ function(buildUnitTest)
                                               ${environment_definitions})
   setStaticAnalyzer(UnitTest)
 endfunction(buildUnitTest)
+
+
+# Build micro benchmarks
+function(buildBenchmark)
+  # Load Google Benchmark
+  find_package(benchmark REQUIRED)
+
+  # Build benchmarks
+  file(GLOB benchmark_source_files ${__test_root__}/benchmark/*.cpp
+                                   ${__test_root__}/benchmark/*.hpp)
+  add_executable(Benchmark ${benchmark_source_files}
+                           ${core_source_files}
+                           ${zisc_header_files})
+  source_group(Benchmark FILES ${benchmark_source_files})
+  # Set benchmark properties
+  set_target_properties(Benchmark PROPERTIES CXX_STANDARD 17
+                                             CXX_STANDARD_REQUIRED ON)
+  getCxxWarningOption(cxx_warning_flags)
+  getTestWarningOption(test_warning_flags)
+  target_compile_options(Benchmark PRIVATE ${cxx_compiler_flags}
+                                           ${zisc_compile_flags}
+                                           ${cxx_warning_flags}
+                                           ${test_warning_flags})
+  target_include_directories(Benchmark PRIVATE ${PROJECT_SOURCE_DIR}/source
+                                               ${PROJECT_BINARY_DIR}/include)
+  includeZisc(Benchmark)
+  target_link_libraries(Benchmark ${CMAKE_THREAD_LIBS_INIT}
+                                  ${cxx_linker_flags}
+                                  ${zisc_linker_flags}
+                                  benchmark::benchmark
+                                  ${core_library})
+  target_compile_definitions(Benchmark PRIVATE ${cxx_definitions}
+                                               ${core_definitions}
+                                               ${zisc_definitions}
+                                               ${environment_definitions})
+  setStaticAnalyzer(Benchmark)
+endfunction(buildBenchmark)
+
+
+# Measure the equal-time convergence of the scenes against the references
+function(buildConvergenceBenchmark)
+  set(scene_dir ${__test_root__}/resources/convergence)
+  add_custom_target(ConvergenceBenchmark
+                    COMMAND ${CMAKE_COMMAND}
+                        -DSIMPLE_NANAIRO=$<TARGET_FILE:SimpleNanairo>
+                        -DSCENE_LIST=${scene_dir}/scenes.txt
+                        -DSCENE_DIR=${scene_dir}
+                        -DOUTPUT_DIR=${PROJECT_BINARY_DIR}/convergence
+                        -P ${__test_root__}/convergence_benchmark.cmake
+                    DEPENDS SimpleNanairo
+                    COMMENT "Measuring the equal-time convergence of the test scenes"
+                    VERBATIM)
+endfunction(buildConvergenceBenchmark)
@@ -0,0 +1,58 @@
+# file: convergence_benchmark.cmake
+# author: Sho Ikeda
+#
+# Copyright (c) 2015-2018 Sho Ikeda
+# This software is released under the MIT License.
+# http://opensource.org/licenses/mit-license.php
+#
+# Render the scenes of the list for the error times and write the error curves
+# against the references into the output dir as JSON files.
+# Variables: SIMPLE_NANAIRO, SCENE_LIST, SCENE_DIR, OUTPUT_DIR
+#
+
+file(STRINGS ${SCENE_LIST} scene_line_list)
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+foreach(scene_line IN LISTS scene_line_list)
+  if(scene_line MATCHES "^#" OR scene_line STREQUAL "")
+    continue()
+  endif()
+  separate_arguments(scene_args UNIX_COMMAND ${scene_line})
+  list(GET scene_args 0 scene_name)
+  list(GET scene_args 1 error_times)
+  list(GET scene_args 2 reference_time)
+  set(nanabin_path ${SCENE_DIR}/${scene_name}.nanabin)
+  set(reference_path ${SCENE_DIR}/${scene_name}.pfm)
+  if(NOT EXISTS ${nanabin_path})
+    message(STATUS "Skip ${scene_name}: ${nanabin_path} not found.")
+    continue()
+  endif()
+  set(scene_output_dir ${OUTPUT_DIR}/${scene_name})
+  file(MAKE_DIRECTORY ${scene_output_dir})
+
+  # Make the reference
+  if(NOT EXISTS ${reference_path})
+    message(STATUS "Render the reference of ${scene_name} for ${reference_time} s.")
+    execute_process(COMMAND ${SIMPLE_NANAIRO} ${nanabin_path}
+                            -o ${scene_output_dir}
+                            --convergence ${reference_path}
+                            --errortimes ${reference_time}
+                            --makereference
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+      message(WARNING "Rendering the reference of ${scene_name} failed.")
+      continue()
+    endif()
+  endif()
+
+  # Measure the errors
+  message(STATUS "Measure the convergence of ${scene_name}.")
+  execute_process(COMMAND ${SIMPLE_NANAIRO} ${nanabin_path}
+                          -o ${scene_output_dir}
+                          --convergence ${reference_path}
+                          --errortimes ${error_times}
+                  OUTPUT_FILE ${OUTPUT_DIR}/${scene_name}.json
+                  RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(WARNING "Measuring the convergence of ${scene_name} failed.")
+  endif()
+endforeach(scene_line)
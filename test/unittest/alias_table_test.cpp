@@ -0,0 +1,106 @@
+/*!
+  \file alias_table_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <vector>
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Sampling/alias_table.hpp"
+
+namespace {
+
+//! Make the histogram of the indices of stratified samples
+std::vector<nanairo::uint> makeHistogram(const nanairo::AliasTable& table,
+                                         const nanairo::uint num_of_samples)
+{
+  using nanairo::Float;
+  using nanairo::uint;
+
+  std::vector<uint> histogram;
+  histogram.resize(table.size(), 0);
+  for (uint i = 0; i < num_of_samples; ++i) {
+    Float sample = (zisc::cast<Float>(i) + 0.5) /
+                   zisc::cast<Float>(num_of_samples);
+    const uint index = table.sample(&sample);
+    EXPECT_GT(table.size(), index) << "The sampled index is out of range.";
+    EXPECT_LE(0.0, sample) << "The rescaled sample is out of [0, 1).";
+    EXPECT_GT(1.0, sample) << "The rescaled sample is out of [0, 1).";
+    if (index < table.size())
+      ++histogram[index];
+  }
+  return histogram;
+}
+
+} // namespace
+
+TEST(AliasTableTest, SkewedWeightHistogramTest)
+{
+  using nanairo::Float;
+  using nanairo::uint;
+
+  // Skewed weights with zero weights, as the powers of the light sources
+  const std::array<Float, 8> weight_list{{
+      1000.0, 0.0, 1.0, 0.5, 0.0, 30.0, 0.001, 200.0}};
+  Float total_weight = 0.0;
+  for (const Float weight : weight_list)
+    total_weight += weight;
+
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::AliasTable table{work_resource};
+  table.setWeights(weight_list.data(), zisc::cast<uint>(weight_list.size()),
+                   work_resource);
+  ASSERT_EQ(weight_list.size(), table.size());
+
+  constexpr uint num_of_samples = 1 << 20;
+  const auto histogram = makeHistogram(table, num_of_samples);
+  for (uint i = 0; i < weight_list.size(); ++i) {
+    const Float probability = weight_list[i] / total_weight;
+    if (weight_list[i] == 0.0) {
+      EXPECT_EQ(0u, histogram[i])
+          << "The light " << i << " of zero weight is selected.";
+    }
+    else {
+      // The stratified samples hit each part of a cell almost exactly
+      const Float frequency = zisc::cast<Float>(histogram[i]) /
+                              zisc::cast<Float>(num_of_samples);
+      EXPECT_NEAR(probability, frequency, 1.0e-4 + 1.0e-3 * probability)
+          << "The frequency of the light " << i << " is wrong.";
+    }
+  }
+}
+
+TEST(AliasTableTest, SingleWeightTest)
+{
+  using nanairo::Float;
+  using nanairo::uint;
+
+  const std::array<Float, 1> weight_list{{5.0}};
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  nanairo::AliasTable table{work_resource};
+  table.setWeights(weight_list.data(), 1, work_resource);
+  ASSERT_EQ(1u, table.size());
+
+  constexpr uint num_of_samples = 1024;
+  for (uint i = 0; i < num_of_samples; ++i) {
+    const Float s = (zisc::cast<Float>(i) + 0.5) /
+                    zisc::cast<Float>(num_of_samples);
+    Float sample = s;
+    ASSERT_EQ(0u, table.sample(&sample))
+        << "The single light isn't selected.";
+    // The only cell is full, so the sample is kept for the reuse
+    ASSERT_DOUBLE_EQ(s, sample) << "The rescaled sample is wrong.";
+  }
+}
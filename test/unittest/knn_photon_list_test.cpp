@@ -0,0 +1,54 @@
+/*!
+  \file knn_photon_list_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <algorithm>
+#include <array>
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/photon_cache.hpp"
+#include "NanairoCore/DataStructure/knn_photon_list.hpp"
+
+TEST(KnnPhotonListTest, NearestPhotonTest)
+{
+  using nanairo::Float;
+  using nanairo::uint;
+
+  constexpr uint n = 16;
+  constexpr uint k = 5;
+  const std::array<Float, n> distance2_list{{
+      0.9, 0.1, 0.75, 0.3, 0.05, 0.6, 0.45, 0.2,
+      0.85, 0.15, 0.5, 0.7, 0.35, 0.95, 0.25, 0.4}};
+  std::array<nanairo::PhotonCache, n> cache_list;
+
+  nanairo::KnnPhotonList photon_list;
+  photon_list.setK(k);
+  for (uint i = 0; i < n; ++i)
+    photon_list.insert(distance2_list[i], &cache_list[i]);
+  ASSERT_EQ(k, photon_list.size()) << "The size of the list is wrong.";
+
+  auto sorted_list = distance2_list;
+  std::sort(sorted_list.begin(), sorted_list.end());
+  ASSERT_EQ(sorted_list[k - 1], photon_list.longestDistance2())
+      << "The longest distance of the list is wrong.";
+  for (uint i = 0; i < photon_list.size(); ++i) {
+    const Float d2 = photon_list.distance2(i);
+    ASSERT_LE(d2, sorted_list[k - 1]) << "The photon isn't the k nearest.";
+    const auto index = zisc::cast<uint>(photon_list.photon(i) - cache_list.data());
+    ASSERT_EQ(distance2_list[index], d2)
+        << "The photon and the distance don't match.";
+  }
+
+  photon_list.clear();
+  ASSERT_EQ(0, photon_list.size()) << "The list isn't cleared.";
+}
@@ -0,0 +1,48 @@
+/*!
+  \file layered_diffuse_table_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Material/SurfaceModel/Surface/layered_diffuse.hpp"
+#include "NanairoCore/Material/SurfaceModel/Surface/layered_diffuse_table.hpp"
+
+TEST(LayeredDiffuseTableTest, ExternalReflectanceTest)
+{
+  using nanairo::Float;
+  using nanairo::uint;
+  using nanairo::LayeredDiffuse;
+  using nanairo::LayeredDiffuseTable;
+
+  auto data_resource = zisc::SimpleMemoryResource::sharedResource();
+  const LayeredDiffuseTable table{data_resource};
+
+  constexpr uint num_of_samples = 1000;
+  constexpr Float n_min = 1.01;
+  constexpr Float n_max = 3.99;
+  constexpr Float error = 1.0e-4;
+  for (uint i = 0; i < num_of_samples; ++i) {
+    const Float t = zisc::cast<Float>(i) / zisc::cast<Float>(num_of_samples - 1);
+    const Float n = n_min + t * (n_max - n_min);
+    const Float expected = LayeredDiffuse::calcRe(n);
+    const Float re = table.externalReflectance(n);
+    ASSERT_NEAR(expected, re, error)
+        << "The table reflectance at n=" << n << " is wrong.";
+  }
+  {
+    const Float n = 4.5;
+    ASSERT_EQ(LayeredDiffuse::calcRe(n), table.externalReflectance(n))
+        << "The reflectance out of the table isn't calculated directly.";
+  }
+}
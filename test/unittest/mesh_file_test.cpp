@@ -0,0 +1,73 @@
+/*!
+  \file mesh_file_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <cstdio>
+#include <string>
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/face.hpp"
+#include "NanairoCore/Data/mesh_file.hpp"
+#include "NanairoCore/Setting/single_object_setting_node.hpp"
+
+TEST(MeshFileTest, WriteReadTest)
+{
+  using nanairo::Face;
+  using nanairo::MeshFile;
+  using nanairo::MeshParameters;
+  using nanairo::uint32;
+
+  auto data_resource = zisc::SimpleMemoryResource::sharedResource();
+  MeshParameters parameters{data_resource};
+  parameters.vertex_list_ = {{{0.0, 0.0, 0.0}},
+                             {{1.0, 0.0, 0.0}},
+                             {{0.0, 1.0, 0.0}},
+                             {{1.0, 1.0, 0.5}}};
+  parameters.vuv_list_ = {{{0.0, 0.0}}, {{1.0, 0.0}}, {{0.0, 1.0}}};
+  parameters.face_list_.emplace_back(0, 1, 2);
+  parameters.face_list_.back().setVuvIndices(0, 1, 2);
+  parameters.face_list_.emplace_back(1, 3, 2);
+
+  const std::string file_path{"mesh_file_test" +
+                              std::string{MeshFile::fileExtension()}};
+  ASSERT_TRUE(MeshFile::write(parameters, file_path))
+      << "Writing the mesh file failed.";
+  {
+    MeshFile mesh_file;
+    ASSERT_TRUE(mesh_file.open(file_path)) << "Opening the mesh file failed.";
+    ASSERT_EQ(4u, mesh_file.numOfVertices());
+    ASSERT_EQ(3u, mesh_file.numOfUvs());
+    ASSERT_EQ(2u, mesh_file.numOfTriangles());
+    for (uint32 i = 0; i < mesh_file.numOfVertices(); ++i) {
+      for (uint32 axis = 0; axis < 3; ++axis) {
+        ASSERT_FLOAT_EQ(static_cast<float>(parameters.vertex_list_[i][axis]),
+                        mesh_file.vertex(i)[axis])
+            << "The vertex " << i << " is wrong.";
+      }
+    }
+    const auto& t0 = mesh_file.triangle(0);
+    const auto& t1 = mesh_file.triangle(1);
+    ASSERT_TRUE(MeshFile::hasUv(t0));
+    ASSERT_FALSE(MeshFile::hasUv(t1));
+    ASSERT_EQ(parameters.face_list_[1].triangleVertexIndices(), t1.vertex_);
+    ASSERT_FLOAT_EQ(1.0f, mesh_file.uv(t0.uv_[2])[1]);
+  }
+  std::remove(file_path.c_str());
+
+  // A missing file is rejected
+  {
+    MeshFile mesh_file;
+    ASSERT_FALSE(mesh_file.open(file_path));
+  }
+}
@@ -0,0 +1,48 @@
+/*!
+  \file quantized_bvh_node_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+// GoogleTest
+#include "gtest/gtest.h"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/DataStructure/quantized_bvh_node.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+
+TEST(QuantizedBvhNodeTest, ConservativeBoundingBoxTest)
+{
+  using nanairo::Aabb;
+  using nanairo::Point3;
+  using nanairo::QuantizedBvhNode;
+  using nanairo::uint;
+
+  const std::array<Aabb, 4> bounding_box_list{{
+      Aabb{Point3{-1.0e3, 0.125, 3.0}, Point3{-999.9, 0.2, 3.0}},
+      Aabb{Point3{0.1, 0.3, -7.3}, Point3{0.7, 0.31, 1.1}},
+      Aabb{Point3{5.5, 0.1, 2.9}, Point3{1.0e3, 0.11, 3.1}},
+      Aabb{Point3{12.3, 0.25, -0.1}, Point3{12.3, 0.25, 0.1}}}};
+
+  ASSERT_EQ(64, sizeof(QuantizedBvhNode))
+      << "The node doesn't fit in a cache line.";
+
+  QuantizedBvhNode node;
+  node.setChildBoundingBoxes(bounding_box_list.data(), 4);
+  for (uint child = 0; child < 4; ++child) {
+    const auto& box = bounding_box_list[child];
+    const auto quantized_box = node.childBoundingBox(child);
+    for (uint axis = 0; axis < 3; ++axis) {
+      ASSERT_LE(quantized_box.minPoint()[axis], box.minPoint()[axis])
+          << "The quantized box of child " << child << " isn't conservative.";
+      ASSERT_GE(quantized_box.maxPoint()[axis], box.maxPoint()[axis])
+          << "The quantized box of child " << child << " isn't conservative.";
+    }
+  }
+}
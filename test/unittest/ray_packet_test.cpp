@@ -0,0 +1,73 @@
+/*!
+  \file ray_packet_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <limits>
+// GoogleTest
+#include "gtest/gtest.h"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/Data/ray_packet.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+TEST(RayPacketTest, IntersectionTest)
+{
+  using nanairo::Aabb;
+  using nanairo::Float;
+  using nanairo::Point3;
+  using nanairo::Ray;
+  using nanairo::RayPacket;
+  using nanairo::Vector3;
+  using nanairo::uint;
+  using nanairo::uint32;
+
+  constexpr uint packet_size = 16;
+  RayPacket<packet_size> packet;
+  for (uint i = 0; i < packet_size; ++i) {
+    const Float x = -0.75 + 0.1 * static_cast<Float>(i % 4);
+    const Float y = -0.75 + 0.1 * static_cast<Float>(i / 4);
+    const auto direction = (Vector3{x, y, 1.0}).normalized();
+    packet.setRay(i, Ray::makeRay(Point3{0.0, 0.0, 0.0}, direction));
+  }
+  ASSERT_TRUE(packet.isCoherent()) << "The packet isn't coherent.";
+  ASSERT_EQ(0xffffu, packet.activeMask()) << "The active mask is wrong.";
+
+  const std::array<Aabb, 4> bounding_box_list{{
+      Aabb{Point3{-1.0, -1.0, 2.0}, Point3{1.0, 1.0, 3.0}},
+      Aabb{Point3{-1.6, -1.6, 2.0}, Point3{-1.4, -1.4, 2.1}},
+      Aabb{Point3{3.0, 3.0, 1.0}, Point3{4.0, 4.0, 2.0}},
+      Aabb{Point3{-1.0, -1.0, -3.0}, Point3{1.0, 1.0, -2.0}}}};
+  typename RayPacket<packet_size>::DistanceList max_distance_list;
+  max_distance_list.fill(std::numeric_limits<Float>::max());
+  for (uint b = 0; b < bounding_box_list.size(); ++b) {
+    const auto& box = bounding_box_list[b];
+    uint32 expected_mask = 0;
+    for (uint i = 0; i < packet_size; ++i) {
+      const auto result = box.testIntersection(packet.ray(i));
+      if (result.isSuccess())
+        expected_mask = expected_mask | (static_cast<uint32>(1) << i);
+    }
+    const uint32 hit_mask = packet.testIntersection(box, max_distance_list);
+    ASSERT_EQ(expected_mask, hit_mask)
+        << "The hit mask of box " << b << " is wrong.";
+    // The frustum test is conservative
+    if (expected_mask != 0) {
+      ASSERT_TRUE(packet.testFrustum(box, std::numeric_limits<Float>::max()))
+          << "The box " << b << " is culled by mistake.";
+    }
+  }
+  // The box behind the rays is culled by the frustum
+  ASSERT_FALSE(packet.testFrustum(bounding_box_list[3],
+                                  std::numeric_limits<Float>::max()))
+      << "The box behind the packet isn't culled.";
+}
@@ -0,0 +1,63 @@
+/*!
+  \file ray_sorter_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/ray.hpp"
+#include "NanairoCore/DataStructure/aabb.hpp"
+#include "NanairoCore/DataStructure/ray_sorter.hpp"
+#include "NanairoCore/Geometry/point.hpp"
+#include "NanairoCore/Geometry/vector.hpp"
+
+TEST(RaySorterTest, SortTest)
+{
+  using nanairo::Aabb;
+  using nanairo::Point3;
+  using nanairo::Ray;
+  using nanairo::RaySorter;
+  using nanairo::Vector3;
+  using nanairo::uint32;
+
+  const std::array<Ray, 6> ray_list{{
+      Ray::makeRay(Point3{0.9, 0.9, 0.9}, Vector3{0.0, 0.0, 1.0}),
+      Ray::makeRay(Point3{0.1, 0.1, 0.1}, Vector3{0.0, 0.0, -1.0}),
+      Ray::makeRay(Point3{0.1, 0.1, 0.1}, Vector3{0.0, 0.0, 1.0}),
+      Ray::makeRay(Point3{0.9, 0.9, 0.9}, Vector3{0.0, 0.0, -1.0}),
+      Ray::makeRay(Point3{0.2, 0.1, 0.1}, Vector3{0.0, 0.0, 1.0}),
+      Ray::makeRay(Point3{0.2, 0.1, 0.1}, Vector3{0.0, 0.0, -1.0})}};
+  const Aabb scene_box{Point3{0.0, 0.0, 0.0}, Point3{1.0, 1.0, 1.0}};
+
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  RaySorter sorter{work_resource};
+  for (uint32 i = 0; i < ray_list.size(); ++i) {
+    const uint32 slot_index = sorter.add(ray_list[i]);
+    ASSERT_EQ(i, slot_index) << "The slot index is wrong.";
+  }
+  sorter.sort(scene_box);
+  ASSERT_EQ(ray_list.size(), sorter.numOfRays());
+
+  // The rays are grouped by the direction octant and ordered by the origin
+  const std::array<uint32, 6> expected_list{{2, 4, 0, 1, 5, 3}};
+  for (uint32 i = 0; i < expected_list.size(); ++i) {
+    ASSERT_EQ(expected_list[i], sorter.slotIndex(i))
+        << "The ray " << i << " isn't sorted.";
+  }
+  for (uint32 i = 1; i < sorter.numOfRays(); ++i) {
+    ASSERT_LE(RaySorter::calcKey(scene_box, sorter.ray(i - 1)),
+              RaySorter::calcKey(scene_box, sorter.ray(i)))
+        << "The keys aren't sorted.";
+  }
+}
@@ -0,0 +1,142 @@
+/*!
+  \file sample_statistics_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <cmath>
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/math.hpp"
+#include "zisc/utility.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/system.hpp"
+#include "NanairoCore/Data/wavelength_samples.hpp"
+#include "NanairoCore/Sampling/sample_statistics.hpp"
+#include "NanairoCore/Sampling/sampled_spectra.hpp"
+#include "NanairoCore/Setting/system_setting_node.hpp"
+
+namespace {
+
+//! Return a deterministic value of the sample of the cycle
+nanairo::Float makeTestValue(const nanairo::uint32 cycle,
+                             const nanairo::uint pixel_index,
+                             const nanairo::uint i) noexcept
+{
+  using nanairo::Float;
+  const Float x = 1.3 * zisc::cast<Float>(cycle) +
+                  0.7 * zisc::cast<Float>(pixel_index) +
+                  zisc::cast<Float>(i);
+  // A few cycles have large values like fireflies
+  const Float outlier = (((cycle + pixel_index) % 7) == 0) ? 4.0 : 0.0;
+  return 1.0 + 0.5 * std::sin(x) + outlier;
+}
+
+//! Add the samples of the cycle to the pixels of the statistics
+void addTestCycle(nanairo::System& system,
+                  const nanairo::WavelengthSamples& wavelengths,
+                  const nanairo::uint32 cycle,
+                  const nanairo::uint32 local_cycle,
+                  nanairo::SampleStatistics* statistics) noexcept
+{
+  using nanairo::uint;
+  using nanairo::uint32;
+  const auto resolution = statistics->resolution();
+  for (uint32 y = 0; y < resolution[1]; ++y) {
+    for (uint32 x = 0; x < resolution[0]; ++x) {
+      const nanairo::Index2d position{x, y};
+      const uint pixel_index = statistics->getIndex(position);
+      nanairo::SampledSpectra sample{wavelengths};
+      for (uint i = 0; i < sample.size(); ++i)
+        sample.setIntensity(i, makeTestValue(cycle, pixel_index, i));
+      statistics->addSample(position, sample);
+    }
+  }
+  statistics->update(system, wavelengths, local_cycle);
+}
+
+} // namespace
+
+TEST(SampleStatisticsTest, MergeTest)
+{
+  using nanairo::Float;
+  using nanairo::uint;
+  using nanairo::uint32;
+
+  nanairo::SystemSettingNode settings{nullptr};
+  settings.initialize();
+  settings.setNumOfThreads(2);
+  settings.setSamplerType(nanairo::SamplerType::kPcg);
+  // The adaptive sampling enables the variance and the sample count
+  settings.enableAdaptiveSampling(true);
+  nanairo::System system{&settings};
+
+  // The RGB wavelengths
+  nanairo::WavelengthSamples wavelengths;
+  {
+    const std::array<nanairo::uint16, 3> rgb{{
+        nanairo::CoreConfig::blueWavelength(),
+        nanairo::CoreConfig::greenWavelength(),
+        nanairo::CoreConfig::redWavelength()}};
+    for (uint i = 0; i < wavelengths.size(); ++i)
+      wavelengths[i] = rgb[i % rgb.size()];
+    wavelengths.setPrimaryWavelength(0);
+  }
+
+  nanairo::SampleStatistics single{system};
+  nanairo::SampleStatistics part_a{system};
+  nanairo::SampleStatistics part_b{system};
+  ASSERT_TRUE(single.isEnabled(nanairo::SampleStatistics::Type::kVariance));
+
+  // The first cycles are sampled to the part A and the rest to the part B
+  constexpr uint32 num_of_cycles = 24;
+  constexpr uint32 num_of_cycles_a = 9;
+  for (uint32 cycle = 1; cycle <= num_of_cycles; ++cycle) {
+    addTestCycle(system, wavelengths, cycle, cycle, &single);
+    if (cycle <= num_of_cycles_a)
+      addTestCycle(system, wavelengths, cycle, cycle, &part_a);
+    else
+      addTestCycle(system, wavelengths, cycle, cycle - num_of_cycles_a, &part_b);
+  }
+  constexpr uint32 num_of_cycles_b = num_of_cycles - num_of_cycles_a;
+  part_a.merge(system, part_b, num_of_cycles_a, num_of_cycles_b);
+
+  // The film values can be single precision
+  auto tolerance = [](const Float expected)
+  {
+    return 1.0e-4 * zisc::max(zisc::cast<Float>(1.0), std::abs(expected));
+  };
+
+  const auto& sample_table = single.sampleTable();
+  for (std::size_t pixel = 0; pixel < sample_table.numOfRows(); ++pixel) {
+    ASSERT_EQ(single.sampleCountTable()[pixel], part_a.sampleCountTable()[pixel])
+        << "The merged sample count of the pixel " << pixel << " is wrong.";
+    for (uint si = 0; si < sample_table.numOfBins(); ++si) {
+      {
+        const Float expected = sample_table.get(pixel, si);
+        ASSERT_NEAR(expected, part_a.sampleTable().get(pixel, si),
+                    tolerance(expected))
+            << "The merged sum of the pixel " << pixel << " is wrong.";
+      }
+      {
+        const Float expected = single.meanTable().get(pixel, si);
+        ASSERT_NEAR(expected, part_a.meanTable().get(pixel, si),
+                    tolerance(expected))
+            << "The merged mean of the pixel " << pixel << " is wrong.";
+      }
+      {
+        const Float expected = single.squaredDeviationTable().get(pixel, si);
+        ASSERT_NEAR(expected, part_a.squaredDeviationTable().get(pixel, si),
+                    tolerance(expected))
+            << "The merged variance of the pixel " << pixel << " is wrong.";
+      }
+    }
+  }
+}
@@ -0,0 +1,89 @@
+/*!
+  \file sampler_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+// GoogleTest
+#include "gtest/gtest.h"
+// Zisc
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Sampling/Sampler/cmj_table.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
+
+void testCounterBasedSampler(const nanairo::SamplerType type,
+                             const nanairo::CmjTable* table = nullptr)
+{
+  using nanairo::Float;
+  using nanairo::PathState;
+  using nanairo::SampleDimension;
+  using nanairo::Sampler;
+  using nanairo::uint32;
+
+  constexpr uint32 seed = 123456789;
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  auto sampler1 = Sampler::make(type, seed, work_resource, table);
+  auto sampler2 = Sampler::make(type, seed, work_resource, table);
+
+  constexpr uint32 num_of_streams = 16;
+  constexpr uint32 num_of_samples = 16;
+  for (uint32 sample = 1; sample <= num_of_samples; ++sample) {
+    PathState path_state{sample};
+    path_state.setDimension(SampleDimension::kBxdfSample1);
+    std::array<Float, num_of_streams> value_list;
+    // The second sampler visits the streams in the reverse order
+    for (uint32 stream = 0; stream < num_of_streams; ++stream) {
+      sampler1->setStream(stream);
+      value_list[stream] = sampler1->draw1D(path_state);
+      ASSERT_LE(0.0, value_list[stream]) << "The sample is out of [0, 1).";
+      ASSERT_GT(1.0, value_list[stream]) << "The sample is out of [0, 1).";
+    }
+    for (uint32 i = 0; i < num_of_streams; ++i) {
+      const uint32 stream = (num_of_streams - 1) - i;
+      sampler2->setStream(stream);
+      ASSERT_EQ(value_list[stream], sampler2->draw1D(path_state))
+          << "The sample of the stream " << stream << " isn't deterministic.";
+    }
+    // Different streams have different samples
+    for (uint32 stream = 1; stream < num_of_streams; ++stream) {
+      ASSERT_NE(value_list[0], value_list[stream])
+          << "The streams 0 and " << stream << " are correlated.";
+    }
+  }
+}
+
+TEST(SamplerTest, PcgCounterBasedTest)
+{
+  testCounterBasedSampler(nanairo::SamplerType::kPcg);
+}
+
+TEST(SamplerTest, XoshiroCounterBasedTest)
+{
+  testCounterBasedSampler(nanairo::SamplerType::kXoshiro);
+}
+
+TEST(SamplerTest, CmjCounterBasedTest)
+{
+  testCounterBasedSampler(nanairo::SamplerType::kCmj);
+}
+
+TEST(SamplerTest, TableCmjCounterBasedTest)
+{
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  const nanairo::CmjTable table{123456789, work_resource};
+  testCounterBasedSampler(nanairo::SamplerType::kTableCmj, &table);
+}
+
+TEST(SamplerTest, OwenSobolCounterBasedTest)
+{
+  testCounterBasedSampler(nanairo::SamplerType::kOwenSobol);
+}
@@ -14,10 +14,17 @@
 #include <cmath>
 #include <memory>
 // Zisc
+#include "zisc/math.hpp"
+#include "zisc/memory_resource.hpp"
+#include "zisc/simple_memory_resource.hpp"
 #include "zisc/unit.hpp"
+#include "zisc/utility.hpp"
 // Nanairo
 #include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Data/path_state.hpp"
+#include "NanairoCore/Data/shape_point.hpp"
 #include "NanairoCore/Geometry/transformation.hpp"
+#include "NanairoCore/Sampling/Sampler/sampler.hpp"
 #include "NanairoCore/Shape/plane.hpp"
 #include "NanairoCore/Shape/flat_triangle.hpp"
 
@@ -253,3 +260,84 @@ TEST(ShapeTest, FlatTriangleTransformationTest)
         << "The translation of the triangle is failed.";
   }
 }
+
+TEST(ShapeTest, FlatTriangleSolidAngleSamplingTest)
+{
+  using nanairo::uint32;
+  using nanairo::Float;
+  using nanairo::PathState;
+  using nanairo::Point3;
+  using nanairo::SampleDimension;
+  using nanairo::Sampler;
+  using nanairo::SamplerType;
+
+  const Point3 p0{-0.5, -0.5, 0.0};
+  const Point3 p1{0.5, -0.5, 0.0};
+  const Point3 p2{-0.5, 0.5, 0.0};
+  const nanairo::FlatTriangle triangle{p0, p1, p2};
+  const Point3 reference{0.1, 0.2, 1.0};
+
+  // The solid angle by the formula of Van Oosterom and Strackee
+  Float solid_angle = 0.0;
+  {
+    const auto a = p0 - reference;
+    const auto b = p1 - reference;
+    const auto c = p2 - reference;
+    const Float la = a.norm();
+    const Float lb = b.norm();
+    const Float lc = c.norm();
+    const Float numerator = std::abs(zisc::dot(a, zisc::cross(b, c)));
+    const Float denominator = la * lb * lc + zisc::dot(a, b) * lc +
+                              zisc::dot(a, c) * lb + zisc::dot(b, c) * la;
+    solid_angle = 2.0 * std::atan2(numerator, denominator);
+  }
+
+  constexpr uint32 seed = 123456789;
+  auto work_resource = zisc::SimpleMemoryResource::sharedResource();
+  auto sampler = Sampler::make(SamplerType::kPcg, seed, work_resource);
+  sampler->setStream(0);
+
+  constexpr uint32 num_of_samples = 100000;
+  Float solid_angle_estimate = 0.0;
+  Float area_estimate = 0.0;
+  for (uint32 sample = 1; sample <= num_of_samples; ++sample) {
+    PathState path_state{sample};
+    path_state.setDimension(SampleDimension::kLightPointSample);
+    const auto point = triangle.sampleSolidAnglePoint(reference,
+                                                      *sampler,
+                                                      path_state);
+    const auto& x = point.point();
+    // The sampled point lies on the triangle
+    {
+      constexpr Float error = 1.0e-9;
+      const Float s = x[0] - p0[0];
+      const Float t = x[1] - p0[1];
+      ASSERT_NEAR(0.0, x[2], error) << "The sample isn't on the triangle.";
+      ASSERT_LE(-error, s) << "The sample isn't on the triangle.";
+      ASSERT_LE(-error, t) << "The sample isn't on the triangle.";
+      ASSERT_GE(1.0 + error, s + t) << "The sample isn't on the triangle.";
+    }
+    // The pdf of the sample matches the pdf of the point
+    const Float pdf = point.pdf();
+    ASSERT_LT(0.0, pdf) << "The pdf of the sample isn't positive.";
+    {
+      const Float expected = triangle.solidAnglePointPdf(reference, x);
+      ASSERT_NEAR(expected, pdf, 1.0e-6 * expected)
+          << "The sampling pdf and the point pdf are mismatched.";
+    }
+    const auto diff = x - reference;
+    const Float distance2 = diff.squareNorm();
+    const Float cos_theta = std::abs(diff[2]) / std::sqrt(distance2);
+    solid_angle_estimate += (cos_theta / distance2) / pdf;
+    area_estimate += 1.0 / pdf;
+  }
+  solid_angle_estimate /= zisc::cast<Float>(num_of_samples);
+  area_estimate /= zisc::cast<Float>(num_of_samples);
+
+  EXPECT_NEAR(solid_angle, solid_angle_estimate, 1.0e-3 * solid_angle)
+      << "The estimate of the solid angle doesn't converge.";
+  // The surface area converges only if the samples follow the pdf
+  constexpr Float area = 0.5;
+  EXPECT_NEAR(area, area_estimate, 1.0e-2 * area)
+      << "The samples don't follow the pdf of the solid angle sampling.";
+}
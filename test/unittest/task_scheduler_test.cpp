@@ -0,0 +1,128 @@
+/*!
+  \file task_scheduler_test.cpp
+  \author Sho Ikeda
+
+  Copyright (c) 2015-2018 Sho Ikeda
+  This software is released under the MIT License.
+  http://opensource.org/licenses/mit-license.php
+  */
+
+// Standard C++ library
+#include <array>
+#include <atomic>
+#include <numeric>
+#include <vector>
+// GoogleTest
+#include "gtest/gtest.h"
+// Nanairo
+#include "NanairoCore/nanairo_core_config.hpp"
+#include "NanairoCore/Utility/task_scheduler.hpp"
+
+namespace {
+
+//! Sum the values of the range by recursive fork and join
+nanairo::uint64 sumRecursively(nanairo::TaskScheduler& scheduler,
+                               const std::vector<nanairo::uint64>& value_list,
+                               const std::size_t begin,
+                               const std::size_t end) noexcept
+{
+  constexpr std::size_t kGrainSize = 64;
+  if ((end - begin) <= kGrainSize) {
+    nanairo::uint64 sum = 0;
+    for (std::size_t i = begin; i < end; ++i)
+      sum += value_list[i];
+    return sum;
+  }
+
+  const std::size_t middle = begin + (end - begin) / 2;
+  nanairo::uint64 left_sum = 0;
+  nanairo::uint64 right_sum = 0;
+  {
+    nanairo::TaskGroup group{scheduler};
+    group.run([&scheduler, &value_list, &left_sum, begin, middle]()
+    {
+      left_sum = sumRecursively(scheduler, value_list, begin, middle);
+    });
+    right_sum = sumRecursively(scheduler, value_list, middle, end);
+    group.wait();
+  }
+  return left_sum + right_sum;
+}
+
+//! Make the values of the test
+std::vector<nanairo::uint64> makeValueList() noexcept
+{
+  std::vector<nanairo::uint64> value_list;
+  value_list.resize(100003);
+  for (std::size_t i = 0; i < value_list.size(); ++i)
+    value_list[i] = (i * 7919) % 1009;
+  return value_list;
+}
+
+//! Check the recursive sum against the serial sum
+void testRecursiveSum(const nanairo::uint num_of_threads) noexcept
+{
+  const auto value_list = makeValueList();
+  const nanairo::uint64 expected = std::accumulate(value_list.begin(),
+                                                   value_list.end(),
+                                                   nanairo::uint64{0});
+
+  nanairo::TaskScheduler scheduler{num_of_threads, false};
+  ASSERT_EQ(num_of_threads, scheduler.numOfThreads());
+  const auto sum = sumRecursively(scheduler, value_list, 0, value_list.size());
+  EXPECT_EQ(expected, sum)
+      << "The recursive fork-join sum with " << num_of_threads
+      << " threads is wrong.";
+}
+
+} // namespace
+
+TEST(TaskSchedulerTest, RecursiveForkJoinTest)
+{
+  testRecursiveSum(4);
+}
+
+TEST(TaskSchedulerTest, SingleThreadTest)
+{
+  testRecursiveSum(1);
+}
+
+TEST(TaskSchedulerTest, NestedWaitTest)
+{
+  constexpr nanairo::uint kNumOfOuterTasks = 32;
+  constexpr nanairo::uint kNumOfInnerTasks = 64;
+
+  for (const nanairo::uint num_of_threads : {1u, 2u, 4u}) {
+    nanairo::TaskScheduler scheduler{num_of_threads, false};
+    std::array<std::atomic<nanairo::uint>, kNumOfOuterTasks> count_list;
+    for (auto& count : count_list)
+      count.store(0);
+
+    {
+      nanairo::TaskGroup outer_group{scheduler};
+      for (nanairo::uint i = 0; i < kNumOfOuterTasks; ++i) {
+        outer_group.run([&scheduler, &count_list, i]()
+        {
+          // The task waits for its own tasks while it runs on a worker
+          nanairo::TaskGroup inner_group{scheduler};
+          for (nanairo::uint j = 0; j < kNumOfInnerTasks; ++j) {
+            inner_group.run([&count_list, i]()
+            {
+              count_list[i].fetch_add(1);
+            });
+          }
+          inner_group.wait();
+          ASSERT_EQ(kNumOfInnerTasks, count_list[i].load())
+              << "The nested wait returned before the inner tasks finished.";
+        });
+      }
+      outer_group.wait();
+    }
+
+    for (nanairo::uint i = 0; i < kNumOfOuterTasks; ++i) {
+      EXPECT_EQ(kNumOfInnerTasks, count_list[i].load())
+          << "The outer task " << i << " with " << num_of_threads
+          << " threads didn't run all the inner tasks.";
+    }
+  }
+}
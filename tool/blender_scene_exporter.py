@@ -15,6 +15,7 @@ import multiprocessing
 import concurrent.futures
 import json
 import os
+import struct
 
 def clamp(x, minval, maxval):
   result = min(max(x, minval), maxval)
@@ -64,6 +65,11 @@ def makeArgParser():
       action='store_true',
       help="Prevent to export resources.")
 
+  parser.add_argument(
+      '--nanaobjmesh',
+      action='store_true',
+      help="Export meshes as OBJ files instead of the binary mesh files.")
+
 
   parser.add_argument(
       '--nanathreads',
@@ -85,6 +91,7 @@ class NanairoSettings:
     self.scene_name_ = args.nanascene
     self.separate_transformation_ = not args.nananotransformation
     self.export_resources_ = not args.nananoresource
+    self.binary_mesh_ = not args.nanaobjmesh
     self.resource_dir_ = os.path.join(args.nanaresourcedir, getBlendFileName())
     # Scene data
     self.scene_data_ = dict()
@@ -533,7 +540,8 @@ def parseSceneObjectSettings(settings, scene, material_info_list, object_list, o
       printInfo(InfoType.kWarning, 
                 "Object '{0}' doesn't have material.".format(obj.obj_.name))
 
-    obj_file_name = obj.obj_.name + ".obj"
+    mesh_extension = ".nmesh" if settings.binary_mesh_ else ".obj"
+    obj_file_name = obj.obj_.name + mesh_extension
     obj_file_path = os.path.join(settings.resource_dir_, "objects", obj_file_name)
     if obj.is_instance_:
       printInfo(InfoType.kWarning,
@@ -635,6 +643,71 @@ def exportObject(obj, object_dir):
 
   obj.select_set(False)
 
+def calcFnv1aHash32(text):
+  h = 0x811c9dc5
+  for c in text.encode('utf-8'):
+    h = ((h ^ c) * 0x01000193) & 0xffffffff
+  return h
+
+class MeshData:
+  def __init__(self):
+    self.vertex_list_ = list()
+    self.uv_list_ = list()
+    self.triangle_list_ = list()
+
+# Take the triangles of the object with the modifiers and the world transformation
+# as the OBJ exporter does. It has to run on the main thread since bpy isn't thread safe
+def takeMeshData(obj):
+  mesh = obj.to_mesh(bpy.context.depsgraph, True)
+  mesh.transform(obj.matrix_world)
+  mesh.calc_loop_triangles()
+
+  mesh_data = MeshData()
+  for v in mesh.vertices:
+    mesh_data.vertex_list_.extend((v.co[0], v.co[1], v.co[2]))
+  # The UVs are per loop in blender, so the same UVs are merged
+  uv_layer = mesh.uv_layers.active
+  uv_index_list = dict()
+  null_index = 0xffffffff
+  for triangle in mesh.loop_triangles:
+    mesh_data.triangle_list_.extend(triangle.vertices)
+    if uv_layer:
+      for loop_index in triangle.loops:
+        uv = uv_layer.data[loop_index].uv
+        key = (uv[0], uv[1])
+        if key not in uv_index_list:
+          uv_index_list[key] = len(uv_index_list)
+          mesh_data.uv_list_.extend(key)
+        mesh_data.triangle_list_.append(uv_index_list[key])
+    else:
+      mesh_data.triangle_list_.extend((null_index, null_index, null_index))
+
+  bpy.data.meshes.remove(mesh)
+  return mesh_data
+
+# Write the mesh in the binary mesh file format of Nanairo (MeshFile),
+# which is the header, the vertices, the UVs and the triangles in little endian
+def writeMeshFile(mesh_data, file_path):
+  num_of_vertices = len(mesh_data.vertex_list_) // 3
+  num_of_uvs = len(mesh_data.uv_list_) // 2
+  num_of_triangles = len(mesh_data.triangle_list_) // 6
+  magic_number = calcFnv1aHash32("NanairoMesh")
+  version = 1
+  with open(file_path, 'wb') as mesh_file:
+    mesh_file.write(struct.pack('<6I', magic_number, version,
+                                num_of_vertices, num_of_uvs, num_of_triangles, 0))
+    mesh_file.write(struct.pack('<{0}f'.format(len(mesh_data.vertex_list_)),
+                                *mesh_data.vertex_list_))
+    mesh_file.write(struct.pack('<{0}f'.format(len(mesh_data.uv_list_)),
+                                *mesh_data.uv_list_))
+    mesh_file.write(struct.pack('<{0}I'.format(len(mesh_data.triangle_list_)),
+                                *mesh_data.triangle_list_))
+
+def exportMesh(obj, object_dir, executor):
+  mesh_data = takeMeshData(obj)
+  file_path = os.path.join(object_dir, obj.name + ".nmesh")
+  return executor.submit(writeMeshFile, mesh_data, file_path)
+
 def exportImage(scene, image, resource_dir):
   if image.is_float:
     # \todo Save a float image
@@ -657,8 +730,17 @@ def exportResources(settings, executor):
   object_dir = os.path.join(resource_dir, "objects")
   os.makedirs(object_dir, exist_ok=True)
   printInfo(InfoType.kStatus, "Object dir: '{0}'.".format(object_dir))
-  for obj in settings.object_list_:
-    exportObject(obj, object_dir)
+  if settings.binary_mesh_:
+    # The meshes are taken in order and written in parallel
+    bpy.context.view_layer.update()
+    future_list = list()
+    for obj in settings.object_list_:
+      future_list.append(exportMesh(obj, object_dir, executor))
+    for future in concurrent.futures.as_completed(future_list):
+      future.result()
+  else:
+    for obj in settings.object_list_:
+      exportObject(obj, object_dir)
   # Image
   image_dir = os.path.join(resource_dir, "images")
   os.makedirs(image_dir, exist_ok=True)